@@ -0,0 +1,154 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using benchmark::State;
+using benchmark::Registration;
+
+namespace {
+
+struct Benchmark {
+    std::string                  name;
+    std::function<void(State &)> function;
+};
+
+}
+
+/*
+ * Registrations run during static initialization, in any order with other
+ * globals, so the list is created on first use.
+ */
+static std::vector<Benchmark> &
+Benchmarks()
+{
+    static std::vector<Benchmark> *benchmarks = new std::vector<Benchmark>();
+    return *benchmarks;
+}
+
+State::
+State(uint64_t iterations) :
+    _iterations(iterations),
+    _remaining (iterations),
+    _started   (false),
+    _elapsed   (std::chrono::steady_clock::duration::zero()),
+    _bytes     (0)
+{
+}
+
+void State::
+finish()
+{
+    if (_started) {
+        _elapsed = std::chrono::steady_clock::now() - _start;
+        _started = false;
+    }
+}
+
+void benchmark::
+DoNotOptimize(void const *value)
+{
+    /* The value's address escapes into code the compiler can't see into. */
+    asm volatile("" : : "r"(value) : "memory");
+}
+
+Registration::
+Registration(std::string const &name, std::function<void(State &)> const &function)
+{
+    Benchmarks().push_back(Benchmark { name, function });
+}
+
+static double
+Seconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+}
+
+/*
+ * Run a benchmark for enough iterations to take at least the minimum time,
+ * then repeat it and report the median time per iteration.
+ */
+static void
+Run(Benchmark const &benchmark, double minimumTime, size_t repetitions)
+{
+    uint64_t iterations = 1;
+    while (true) {
+        State state = State(iterations);
+        benchmark.function(state);
+
+        double elapsed = Seconds(state.elapsed());
+        if (elapsed >= minimumTime || iterations >= (1ull << 40)) {
+            break;
+        }
+
+        /* Aim a little past the minimum, but don't grow too fast from noise. */
+        double scale = (elapsed > 0 ? minimumTime * 1.4 / elapsed : 100.0);
+        iterations = std::max<uint64_t>(iterations + 1, static_cast<uint64_t>(iterations * std::min(scale, 100.0)));
+    }
+
+    std::vector<double> perIteration;
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < repetitions; ++i) {
+        State state = State(iterations);
+        benchmark.function(state);
+        perIteration.push_back(Seconds(state.elapsed()) / static_cast<double>(iterations));
+        bytes = state.bytesPerIteration();
+    }
+
+    std::sort(perIteration.begin(), perIteration.end());
+    double median = perIteration[perIteration.size() / 2];
+
+    std::string throughput;
+    if (bytes > 0 && median > 0) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%10.1f MB/s", static_cast<double>(bytes) / median / 1000000.0);
+        throughput = buffer;
+    }
+
+    printf("%-48s %12llu %14.1f ns %s\n", benchmark.name.c_str(), static_cast<unsigned long long>(iterations), median * 1000000000.0, throughput.c_str());
+    fflush(stdout);
+}
+
+int
+main(int argc, char **argv)
+{
+    std::string filter;
+    double minimumTime = 0.5;
+    size_t repetitions = 3;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument.compare(0, 9, "--filter=") == 0) {
+            filter = argument.substr(9);
+        } else if (argument.compare(0, 11, "--min-time=") == 0) {
+            minimumTime = atof(argument.c_str() + 11);
+        } else if (argument.compare(0, 14, "--repetitions=") == 0) {
+            repetitions = std::max(atoi(argument.c_str() + 14), 1);
+        } else {
+            fprintf(stderr, "usage: %s [--filter=SUBSTRING] [--min-time=SECONDS] [--repetitions=N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-48s %12s %17s\n", "Benchmark", "Iterations", "Time");
+    for (Benchmark const &benchmark : Benchmarks()) {
+        if (filter.empty() || benchmark.name.find(filter) != std::string::npos) {
+            Run(benchmark, minimumTime, repetitions);
+        }
+    }
+
+    return 0;
+}
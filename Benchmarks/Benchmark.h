@@ -0,0 +1,111 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __benchmark_Benchmark_h
+#define __benchmark_Benchmark_h
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include <cstdint>
+
+namespace benchmark {
+
+/*
+ * Runs the timed loop of a benchmark. Anything before the loop is setup and
+ * isn't timed; the loop runs as many times as the runner asks:
+ *
+ *     BENCHMARK(Example)
+ *     {
+ *         Input input = CreateInput();
+ *         while (state.keepRunning()) {
+ *             benchmark::DoNotOptimize(Process(input));
+ *         }
+ *     }
+ */
+class State {
+private:
+    uint64_t                              _iterations;
+    uint64_t                              _remaining;
+    bool                                  _started;
+    std::chrono::steady_clock::time_point _start;
+    std::chrono::steady_clock::duration   _elapsed;
+    uint64_t                              _bytes;
+
+public:
+    explicit State(uint64_t iterations);
+
+public:
+    /*
+     * If the loop should run again. Starts timing on the first call and
+     * stops once all iterations have run.
+     */
+    bool keepRunning()
+    {
+        if (_remaining > 0) {
+            if (!_started) {
+                _started = true;
+                _start = std::chrono::steady_clock::now();
+            }
+            _remaining--;
+            return true;
+        }
+
+        finish();
+        return false;
+    }
+
+public:
+    /*
+     * Bytes processed by each iteration, to report throughput.
+     */
+    void setBytesPerIteration(uint64_t bytes)
+    { _bytes = bytes; }
+
+public:
+    uint64_t iterations() const
+    { return _iterations; }
+    std::chrono::steady_clock::duration elapsed() const
+    { return _elapsed; }
+    uint64_t bytesPerIteration() const
+    { return _bytes; }
+
+private:
+    void finish();
+};
+
+/*
+ * Keeps the compiler from removing the computation of a value that is
+ * otherwise unused.
+ */
+void DoNotOptimize(void const *value);
+
+template<typename T>
+void DoNotOptimize(T const &value)
+{
+    DoNotOptimize(static_cast<void const *>(&value));
+}
+
+/*
+ * Adds a benchmark to those run by the benchmark program's main().
+ */
+class Registration {
+public:
+    Registration(std::string const &name, std::function<void(State &)> const &function);
+};
+
+}
+
+#define BENCHMARK(name) \
+    static void name(benchmark::State &state); \
+    static benchmark::Registration name##_registration = benchmark::Registration(#name, name); \
+    static void name(benchmark::State &state)
+
+#endif  // !__benchmark_Benchmark_h
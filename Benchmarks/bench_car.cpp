@@ -0,0 +1,58 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include "Benchmark.h"
+
+#include <bom/bom.h>
+#include <car/car_format.h>
+#include <car/AttributeList.h>
+#include <car/Facet.h>
+#include <car/Rendition.h>
+#include <car/Writer.h>
+
+#include <string>
+#include <vector>
+
+BENCHMARK(car_Writer_write)
+{
+    /* An asset catalog of 32 images, each 64x64 at 2x. */
+    int width = 64;
+    int height = 64;
+    std::vector<uint8_t> pixels = std::vector<uint8_t>(width * height * 4);
+    for (size_t index = 0; index < pixels.size(); ++index) {
+        pixels[index] = static_cast<uint8_t>(index * 7);
+    }
+
+    while (state.keepRunning()) {
+        auto bom = car::Writer::unique_ptr_bom(bom_alloc_empty(bom_context_memory(NULL, 0)), bom_free);
+        auto writer = car::Writer::Create(std::move(bom));
+
+        for (int index = 0; index < 32; ++index) {
+            car::AttributeList attributes = car::AttributeList({
+                { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_universal },
+                { car_attribute_identifier_scale, 2 },
+                { car_attribute_identifier_identifier, static_cast<uint16_t>(index + 1) },
+            });
+
+            std::string name = "image" + std::to_string(index);
+            writer->addFacet(car::Facet::Create(name, attributes));
+
+            car::Rendition rendition = car::Rendition::Create(attributes, car::Rendition::Data(pixels, car::Rendition::Data::Format::PremultipliedBGRA8));
+            rendition.width() = width;
+            rendition.height() = height;
+            rendition.scale() = 2;
+            rendition.fileName() = name + ".png";
+            rendition.layout() = car_rendition_value_layout_one_part_scale;
+            writer->addRendition(rendition);
+        }
+
+        writer->write();
+        benchmark::DoNotOptimize(bom_memory(writer->bom())->data);
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include "Benchmark.h"
+
+#include <graphics/PixelFormat.h>
+
+#include <vector>
+
+using graphics::PixelFormat;
+
+static std::vector<uint8_t>
+CreatePixels(PixelFormat const &format)
+{
+    /* A 512x512 image with some variation in every channel. */
+    std::vector<uint8_t> pixels = std::vector<uint8_t>(512 * 512 * format.bytesPerPixel());
+    for (size_t index = 0; index < pixels.size(); ++index) {
+        pixels[index] = static_cast<uint8_t>((index * 31) ^ (index >> 9));
+    }
+    return pixels;
+}
+
+static void
+Convert(benchmark::State &state, PixelFormat const &from, PixelFormat const &to)
+{
+    std::vector<uint8_t> pixels = CreatePixels(from);
+    state.setBytesPerIteration(pixels.size());
+
+    while (state.keepRunning()) {
+        std::vector<uint8_t> converted = PixelFormat::Convert(pixels, from, to);
+        benchmark::DoNotOptimize(converted.data());
+    }
+}
+
+BENCHMARK(graphics_PixelFormat_Convert_RGBA_BGRAPremul)
+{
+    Convert(state,
+        PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last),
+        PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Reversed, PixelFormat::Alpha::PremultipliedFirst));
+}
+
+BENCHMARK(graphics_PixelFormat_Convert_RGB_RGBA)
+{
+    Convert(state,
+        PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::None),
+        PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last));
+}
+
+BENCHMARK(graphics_PixelFormat_Convert_GrayscaleAlpha_RGBA)
+{
+    Convert(state,
+        PixelFormat(PixelFormat::Color::Grayscale, PixelFormat::Order::Forward, PixelFormat::Alpha::Last),
+        PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last));
+}
@@ -0,0 +1,87 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include "Benchmark.h"
+
+#include <pbxbuild/DirectedGraph.h>
+#include <pbxbuild/FileTypeResolver.h>
+#include <pbxbuild/HeaderMap.h>
+#include <pbxspec/Manager.h>
+#include <libutil/DefaultFilesystem.h>
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using pbxbuild::DirectedGraph;
+using pbxbuild::FileTypeResolver;
+using pbxbuild::HeaderMap;
+using libutil::DefaultFilesystem;
+
+BENCHMARK(pbxbuild_FileTypeResolver_Resolve)
+{
+    DefaultFilesystem filesystem;
+    pbxspec::Manager::shared_ptr specManager = pbxspec::Manager::Create();
+    specManager->registerDomains(&filesystem, { { "default", SPECIFICATIONS_DIR } });
+
+    /* Paths that don't exist, so only the name decides the type. */
+    std::vector<std::string> paths = {
+        "/nonexistent/Sources/main.c",
+        "/nonexistent/Sources/View.mm",
+        "/nonexistent/Sources/Model.swift",
+        "/nonexistent/Headers/View.h",
+        "/nonexistent/Resources/Info.plist",
+        "/nonexistent/Resources/Main.storyboard",
+        "/nonexistent/Resources/Images.xcassets",
+        "/nonexistent/Resources/icon.png",
+    };
+
+    while (state.keepRunning()) {
+        for (std::string const &path : paths) {
+            auto fileType = FileTypeResolver::Resolve(&filesystem, specManager, { "default" }, path);
+            benchmark::DoNotOptimize(fileType.get());
+        }
+    }
+}
+
+BENCHMARK(pbxbuild_DirectedGraph_ordered)
+{
+    /* A layered graph, like targets depending on a few lower targets each. */
+    DirectedGraph<int> graph;
+    for (int node = 0; node < 1000; ++node) {
+        std::unordered_set<int> adjacent;
+        for (int edge = 1; edge <= 4 && node - edge * 7 >= 0; ++edge) {
+            adjacent.insert(node - edge * 7);
+        }
+        graph.insert(node, adjacent);
+    }
+
+    while (state.keepRunning()) {
+        ext::optional<std::vector<int>> ordered = graph.ordered();
+        benchmark::DoNotOptimize(ordered);
+    }
+}
+
+BENCHMARK(pbxbuild_HeaderMap_write)
+{
+    std::vector<std::string> names;
+    for (int index = 0; index < 2000; ++index) {
+        names.push_back("Module" + std::to_string(index / 32) + "/Header" + std::to_string(index) + ".h");
+    }
+
+    while (state.keepRunning()) {
+        HeaderMap headerMap;
+        for (std::string const &name : names) {
+            headerMap.add(name, "/path/to/project/Sources/", name);
+        }
+
+        std::vector<uint8_t> contents = headerMap.write();
+        benchmark::DoNotOptimize(contents.data());
+    }
+}
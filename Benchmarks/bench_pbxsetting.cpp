@@ -0,0 +1,116 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include "Benchmark.h"
+
+#include <pbxsetting/Environment.h>
+#include <pbxsetting/Level.h>
+#include <pbxsetting/Setting.h>
+#include <pbxsetting/Value.h>
+
+#include <string>
+#include <vector>
+
+using pbxsetting::Environment;
+using pbxsetting::Level;
+using pbxsetting::Setting;
+using pbxsetting::Value;
+
+/*
+ * Levels shaped like a target's: each level overrides some settings, refers
+ * to settings in lower levels, and inherits its own with $(inherited).
+ */
+static std::vector<Level>
+CreateLevels()
+{
+    std::vector<Level> levels;
+
+    for (int level = 0; level < 8; ++level) {
+        std::vector<Setting> settings;
+        for (int index = 0; index < 64; ++index) {
+            std::string name = "SETTING_" + std::to_string(index);
+            std::string value;
+            if (level == 7) {
+                value = "base_" + std::to_string(index);
+            } else if (index % 4 == 0) {
+                value = "$(inherited) level_" + std::to_string(level);
+            } else if (index % 4 == 1) {
+                value = "$(SETTING_" + std::to_string(index - 1) + ")/$(TARGET_NAME:rfc1034identifier)";
+            } else if (index % 4 == 2 && level % 2 == 0) {
+                value = "$(SETTING_" + std::to_string(index + 1) + ":lower)_$(CONFIGURATION)";
+            } else {
+                continue;
+            }
+            settings.push_back(Setting::Parse(name, value));
+        }
+
+        if (level == 7) {
+            settings.push_back(Setting::Parse("TARGET_NAME", "Bench Target"));
+            settings.push_back(Setting::Parse("CONFIGURATION", "Release"));
+        }
+
+        levels.push_back(Level(settings));
+    }
+
+    return levels;
+}
+
+static Environment
+CreateEnvironment(std::vector<Level> const &levels)
+{
+    Environment environment;
+    for (Level const &level : levels) {
+        environment.insertBack(level, false);
+    }
+    return environment;
+}
+
+BENCHMARK(pbxsetting_Value_Parse)
+{
+    std::string value = "$(inherited) -I$(SRCROOT)/include -DNAME=$(PRODUCT_NAME:c99extidentifier) ${BUILT_PRODUCTS_DIR}/$(FULL_PRODUCT_NAME)";
+    state.setBytesPerIteration(value.size());
+
+    while (state.keepRunning()) {
+        Value parsed = Value::Parse(value);
+        benchmark::DoNotOptimize(parsed);
+    }
+}
+
+BENCHMARK(pbxsetting_Environment_resolve_cold)
+{
+    std::vector<Level> levels = CreateLevels();
+
+    /* A new environment each time, so nothing has been resolved before. */
+    while (state.keepRunning()) {
+        Environment environment = CreateEnvironment(levels);
+        for (int index = 0; index < 64; ++index) {
+            std::string resolved = environment.resolve("SETTING_" + std::to_string(index));
+            benchmark::DoNotOptimize(resolved);
+        }
+    }
+}
+
+BENCHMARK(pbxsetting_Environment_resolve_warm)
+{
+    std::vector<Level> levels = CreateLevels();
+    Environment environment = CreateEnvironment(levels);
+
+    std::vector<std::string> names;
+    for (int index = 0; index < 64; ++index) {
+        names.push_back("SETTING_" + std::to_string(index));
+        environment.resolve(names.back());
+    }
+
+    while (state.keepRunning()) {
+        for (std::string const &name : names) {
+            std::string resolved = environment.resolve(name);
+            benchmark::DoNotOptimize(resolved);
+        }
+    }
+}
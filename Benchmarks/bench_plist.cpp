@@ -0,0 +1,120 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include "Benchmark.h"
+
+#include <plist/Array.h>
+#include <plist/Boolean.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/ASCII.h>
+#include <plist/Format/Binary.h>
+#include <plist/Format/XML.h>
+
+#include <string>
+#include <vector>
+
+using plist::Array;
+using plist::Boolean;
+using plist::Dictionary;
+using plist::Integer;
+using plist::Object;
+using plist::String;
+using plist::Format::ASCII;
+using plist::Format::Binary;
+using plist::Format::Encoding;
+using plist::Format::XML;
+
+/*
+ * A dictionary about the size and shape of a project file's objects.
+ */
+static std::unique_ptr<Dictionary>
+CreateDictionary()
+{
+    std::unique_ptr<Dictionary> root = Dictionary::New();
+
+    for (int index = 0; index < 2000; ++index) {
+        std::unique_ptr<Dictionary> object = Dictionary::New();
+        object->set("isa", String::New(index % 2 == 0 ? "PBXFileReference" : "PBXBuildFile"));
+        object->set("path", String::New("Sources/Module" + std::to_string(index / 16) + "/File" + std::to_string(index) + ".cpp"));
+        object->set("sourceTree", String::New("<group>"));
+        object->set("fileEncoding", Integer::New(4));
+        object->set("includeInIndex", Boolean::New(index % 3 == 0));
+
+        std::unique_ptr<Array> settings = Array::New();
+        for (int flag = 0; flag < 4; ++flag) {
+            settings->append(String::New("-DFLAG_" + std::to_string(flag)));
+        }
+        object->set("settings", std::move(settings));
+
+        char identifier[32];
+        snprintf(identifier, sizeof(identifier), "%024X", index);
+        root->set(identifier, std::move(object));
+    }
+
+    return root;
+}
+
+template<typename T>
+static void
+Serialize(benchmark::State &state, T const &format)
+{
+    std::unique_ptr<Dictionary> dictionary = CreateDictionary();
+    state.setBytesPerIteration(plist::Format::Format<T>::Serialize(dictionary.get(), format).first->size());
+
+    while (state.keepRunning()) {
+        auto serialized = plist::Format::Format<T>::Serialize(dictionary.get(), format);
+        benchmark::DoNotOptimize(serialized.first->data());
+    }
+}
+
+template<typename T>
+static void
+Deserialize(benchmark::State &state, T const &format)
+{
+    std::unique_ptr<Dictionary> dictionary = CreateDictionary();
+    std::vector<uint8_t> contents = *plist::Format::Format<T>::Serialize(dictionary.get(), format).first;
+    state.setBytesPerIteration(contents.size());
+
+    while (state.keepRunning()) {
+        auto deserialized = plist::Format::Format<T>::Deserialize(contents, format);
+        benchmark::DoNotOptimize(deserialized.first.get());
+    }
+}
+
+BENCHMARK(plist_ASCII_Serialize)
+{
+    Serialize(state, ASCII::Create(false, Encoding::UTF8));
+}
+
+BENCHMARK(plist_ASCII_Deserialize)
+{
+    Deserialize(state, ASCII::Create(false, Encoding::UTF8));
+}
+
+BENCHMARK(plist_XML_Serialize)
+{
+    Serialize(state, XML::Create(Encoding::UTF8));
+}
+
+BENCHMARK(plist_XML_Deserialize)
+{
+    Deserialize(state, XML::Create(Encoding::UTF8));
+}
+
+BENCHMARK(plist_Binary_Serialize)
+{
+    Serialize(state, Binary::Create());
+}
+
+BENCHMARK(plist_Binary_Deserialize)
+{
+    Deserialize(state, Binary::Create());
+}
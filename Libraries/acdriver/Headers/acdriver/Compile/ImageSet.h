@@ -14,6 +14,8 @@
 #include <xcassets/Asset/ImageSet.h>
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace libutil { class Filesystem; }
 
@@ -43,6 +45,17 @@ public:
         libutil::Filesystem *filesystem,
         Output *compileOutput,
         Result *result);
+
+    /*
+     * Add an encoded image rendition to the archive, under the facet for
+     * a name. Facets are shared by every rendition with the same name.
+     */
+    static void AddRendition(
+        std::string const &name,
+        double scale,
+        uint16_t idiom,
+        std::vector<uint8_t> &&value,
+        Output *compileOutput);
 };
 
 }
@@ -13,6 +13,7 @@
 #include <plist/Dictionary.h>
 #include <car/Writer.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -51,6 +52,8 @@ private:
 
 private:
     ext::optional<car::Writer>         _car;
+    ext::optional<std::string>         _cacheDirectory;
+    ext::optional<size_t>              _fastCompressionThreshold;
     std::vector<std::pair<std::string, std::string>> _copies;
     std::unique_ptr<plist::Dictionary> _additionalInfo;
 
@@ -58,6 +61,17 @@ private:
     std::vector<std::string>           _inputs;
     std::vector<std::string>           _outputs;
 
+public:
+    /*
+     * Work deferred until the rest of a catalog is compiled. The first
+     * function runs in parallel with the others' and must not modify the
+     * output. The second function then runs in order, after all of them.
+     */
+    typedef std::pair<std::function<void()>, std::function<void()>> Deferred;
+
+private:
+    std::vector<Deferred>              _deferred;
+
 public:
     Output(
         std::string const &root,
@@ -100,6 +114,23 @@ public:
     ext::optional<car::Writer> &car()
     { return _car; }
 
+    /*
+     * If set, the directory holding encoded renditions from earlier runs.
+     */
+    ext::optional<std::string> const &cacheDirectory() const
+    { return _cacheDirectory; }
+    ext::optional<std::string> &cacheDirectory()
+    { return _cacheDirectory; }
+
+    /*
+     * If set, images with at least this many pixels are compressed at
+     * the fastest level.
+     */
+    ext::optional<size_t> const &fastCompressionThreshold() const
+    { return _fastCompressionThreshold; }
+    ext::optional<size_t> &fastCompressionThreshold()
+    { return _fastCompressionThreshold; }
+
     /*
      * Files to copy into the output.
      */
@@ -133,6 +164,15 @@ public:
     std::vector<std::string> &outputs()
     { return _outputs; }
 
+public:
+    /*
+     * Work to finish once the rest of the catalog is compiled.
+     */
+    std::vector<Deferred> const &deferred() const
+    { return _deferred; }
+    std::vector<Deferred> &deferred()
+    { return _deferred; }
+
 public:
     /*
      * The identifier of an asset for use in results.
@@ -42,6 +42,19 @@ private:
      */
     ext::optional<std::string> _compileOutputFilename;
 
+    /*
+     * extension: directory to keep encoded renditions in between runs, so
+     * unchanged images are not decoded and compressed again.
+     */
+    ext::optional<std::string> _compileCacheDirectory;
+
+    /*
+     * extension: images with at least this many pixels are compressed at
+     * the fastest level, trading some size for compile time. Zero turns
+     * this off.
+     */
+    ext::optional<int> _fastCompressionThreshold;
+
     ext::optional<std::string> _exportDependencyInfo;
 
 private:
@@ -85,6 +98,10 @@ public:
     { return _compile; }
     ext::optional<std::string> const &compileOutputFilename() const
     { return _compileOutputFilename; }
+    ext::optional<std::string> const &compileCacheDirectory() const
+    { return _compileCacheDirectory; }
+    ext::optional<int> const &fastCompressionThreshold() const
+    { return _fastCompressionThreshold; }
 public:
     ext::optional<std::string> const &outputFormat() const
     { return _outputFormat; }
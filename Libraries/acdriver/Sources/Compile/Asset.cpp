@@ -35,6 +35,10 @@
 #include <xcassets/Asset/Stickers.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <functional>
 
 using acdriver::Compile::Asset;
 using acdriver::Compile::AppIconSet;
@@ -62,6 +66,21 @@ using acdriver::Result;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
+static void
+RunDeferred(Output *compileOutput)
+{
+    std::vector<Output::Deferred> deferred = std::move(compileOutput->deferred());
+    compileOutput->deferred().clear();
+
+    libutil::Parallel::For(deferred.size(), [&](size_t index) {
+        deferred[index].first();
+    });
+
+    for (Output::Deferred const &entry : deferred) {
+        entry.second();
+    }
+}
+
 template<typename T>
 static bool
 CompileChildren(
@@ -92,6 +111,17 @@ Compile(
     std::string filename = FSUtil::GetBaseName(asset->path());
     std::string name = FSUtil::GetBaseNameWithoutExtension(filename);
 
+    /*
+     * The asset's directory changes when files are added or removed, and
+     * its contents decide which files are used. Any other file it holds
+     * is only an input if the asset type reads it.
+     */
+    compileOutput->inputs().push_back(asset->path());
+    std::string contents = asset->path() + "/Contents.json";
+    if (filesystem->exists(contents)) {
+        compileOutput->inputs().push_back(contents);
+    }
+
     switch (asset->type()) {
         case xcassets::Asset::AssetType::AppIconSet: {
             auto appIconSet = static_cast<xcassets::Asset::AppIconSet const *>(asset);
@@ -109,6 +139,9 @@ Compile(
         case xcassets::Asset::AssetType::Catalog: {
             auto catalog = static_cast<xcassets::Asset::Catalog const *>(asset);
             CompileChildren(catalog->children(), asset, filesystem, compileOutput, result);
+
+            /* Finish while the catalog's assets are still loaded. */
+            RunDeferred(compileOutput);
             break;
         }
         case xcassets::Asset::AssetType::ComplicationSet: {
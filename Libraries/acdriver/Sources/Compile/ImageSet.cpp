@@ -11,6 +11,7 @@
 #include <acdriver/Compile/Convert.h>
 #include <acdriver/Compile/Output.h>
 #include <acdriver/Result.h>
+#include <acdriver/Version.h>
 #include <graphics/PixelFormat.h>
 #include <graphics/Format/PNG.h>
 #include <xcassets/Asset/ImageSet.h>
@@ -20,6 +21,7 @@
 #include <car/Writer.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Hash.h>
 
 #include <algorithm>
 #include <map>
@@ -29,8 +31,10 @@ using acdriver::Compile::ImageSet;
 using acdriver::Compile::Convert;
 using acdriver::Compile::Output;
 using acdriver::Result;
+using acdriver::Version;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Hash;
 
 bool ImageSet::
 Compile(
@@ -59,105 +63,221 @@ GenerateIdentifier(void) {
     return last;
 }
 
-bool ImageSet::
-CompileAsset(
-    xcassets::Asset::ImageSet const *imageSet,
-    xcassets::Asset::ImageSet::Image const &image,
-    Filesystem *filesystem,
-    Output *compileOutput,
-    Result *result)
-{
-    static std::map<std::string, uint16_t> idMap = {};
-
-    /* Skip any entry that is not attached to a file, or is explicitly unassigned. */
-    if (!image.fileName() || image.unassigned()) {
-        return true;
-    }
-
-    /* An image without an idiom is considered unassigned. */
-    if (!image.idiom()) {
-        return false;
-    }
+namespace {
 
-    std::string filename = FSUtil::ResolveRelativePath(*image.fileName(), imageSet->path());
-
-    std::string name = imageSet->name().string();
+/*
+ * An image read and converted to the archive format.
+ */
+struct LoadedImage {
+    std::vector<uint8_t>               pixels;
+    size_t                             width;
+    size_t                             height;
+    car::Rendition::Data::Format       format;
+    ext::optional<std::string>         error;
+};
 
-    /* The default (0) is any scale. */
-    double scale = 0;
-    if (image.scale()) {
-        scale = image.scale()->value();
-    }
+/*
+ * A rendition serialized for the archive, from the cache or just encoded.
+ */
+struct EncodedRendition {
+    std::vector<uint8_t>               value;
+    ext::optional<std::string>         error;
+};
 
-    // TODO: filter by target-device / device-model / os-version
-    uint16_t idiom = Convert::IdiomAttribute(*image.idiom());
+}
 
-    std::vector<uint8_t> pixels;
-    size_t width = 0;
-    size_t height = 0;
-    car::Rendition::Data::Format format = car::Rendition::Data::Format::Data;
+static void
+LoadImage(Filesystem const *filesystem, std::string const &filename, LoadedImage *loaded)
+{
+    loaded->width = 0;
+    loaded->height = 0;
+    loaded->format = car::Rendition::Data::Format::Data;
 
     if (FSUtil::IsFileExtension(filename, "png", true)) {
-        std::vector<uint8_t> contents;
-        if (!filesystem->read(&contents, filename)) {
-            result->normal(
-                Result::Severity::Error,
-                "unable to read PNG file",
-                filename);
-            return false;
+        std::unique_ptr<Filesystem::Mapping> contents = filesystem->readMapped(filename);
+        if (contents == nullptr) {
+            loaded->error = std::string("unable to read PNG file");
+            return;
         }
 
-        auto png = graphics::Format::PNG::Read(contents);
+        /* Convert the image to the archive format while it is decoded. */
+        auto png = graphics::Format::PNG::Read(contents->data(), contents->size(), [](graphics::PixelFormat const &decoded) {
+            return graphics::PixelFormat(
+                decoded.color(),
+                graphics::PixelFormat::Order::Reversed,
+                graphics::PixelFormat::Alpha::PremultipliedFirst);
+        });
         if (!png.first) {
-            result->normal(Result::Severity::Error, png.second, filename);
-            return false;
+            loaded->error = png.second;
+            return;
         }
 
-        graphics::Image const &image = *png.first;
-        width = image.width();
-        height = image.height();
+        graphics::Image &image = *png.first;
+        loaded->width = image.width();
+        loaded->height = image.height();
+        loaded->pixels = std::move(image.data());
 
-        /* Convert the image to the archive format. */
         switch (image.format().color()) {
             case graphics::PixelFormat::Color::RGB:
-                format = car::Rendition::Data::Format::PremultipliedBGRA8;
-                pixels = graphics::PixelFormat::Convert(
-                    image.data(),
-                    image.format(),
-                    graphics::PixelFormat(
-                        graphics::PixelFormat::Color::RGB,
-                        graphics::PixelFormat::Order::Reversed,
-                        graphics::PixelFormat::Alpha::PremultipliedFirst));
+                loaded->format = car::Rendition::Data::Format::PremultipliedBGRA8;
                 break;
             case graphics::PixelFormat::Color::Grayscale:
-                format = car::Rendition::Data::Format::PremultipliedGA8;
-                pixels = graphics::PixelFormat::Convert(
-                    image.data(),
-                    image.format(),
-                    graphics::PixelFormat(
-                        graphics::PixelFormat::Color::Grayscale,
-                        graphics::PixelFormat::Order::Reversed,
-                        graphics::PixelFormat::Alpha::PremultipliedFirst));
+                loaded->format = car::Rendition::Data::Format::PremultipliedGA8;
                 break;
         }
     } else if (FSUtil::IsFileExtension(filename, "jpg", true) || FSUtil::IsFileExtension(filename, "jpeg", true)) {
-        if (!filesystem->read(&pixels, filename)) {
-            result->normal(
-                Result::Severity::Error,
-                "unable to read JPEG file",
-                filename);
-            return false;
+        if (!filesystem->read(&loaded->pixels, filename)) {
+            loaded->error = std::string("unable to read JPEG file");
+            return;
         }
 
-        format = car::Rendition::Data::Format::JPEG;
+        loaded->format = car::Rendition::Data::Format::JPEG;
     } else {
-        result->normal(
-            Result::Severity::Error,
-            "unknown file type",
-            filename);
-        return false;
+        loaded->error = std::string("unknown file type");
+    }
+}
+
+static car::Rendition::Compression
+RenditionCompression(size_t pixels, ext::optional<size_t> const &fastCompressionThreshold)
+{
+    /* LZFSE decodes faster on device, but is only available with libcompression. */
+    if (car::Rendition::CompressionSupported(car::Rendition::Compression::LZFSE)) {
+        return car::Rendition::Compression::LZFSE;
+    } else if (fastCompressionThreshold && pixels >= *fastCompressionThreshold) {
+        return car::Rendition::Compression::ZlibFast;
+    } else {
+        return car::Rendition::Compression::Zlib;
+    }
+}
+
+static std::vector<uint8_t>
+EncodeRendition(
+    xcassets::Asset::ImageSet::Image const &image,
+    double scale,
+    ext::optional<size_t> const &fastCompressionThreshold,
+    LoadedImage &&loaded)
+{
+    size_t pixels = loaded.width * loaded.height;
+
+    /* Attributes are not part of the encoded rendition; they're added with it. */
+    auto attributes = car::AttributeList(std::unordered_map<car_attribute_identifier, uint16_t>());
+    auto data = ext::optional<car::Rendition::Data>(car::Rendition::Data(std::move(loaded.pixels), loaded.format));
+
+    car::Rendition rendition = car::Rendition::Create(attributes, std::move(data));
+    rendition.width() = loaded.width;
+    rendition.height() = loaded.height;
+    rendition.scale() = scale;
+    rendition.fileName() = *image.fileName();
+    rendition.compression() = RenditionCompression(pixels, fastCompressionThreshold);
+    rendition.layout() = car_rendition_value_layout_one_part_scale;
+
+    if (image.resizing()) {
+        xcassets::Resizing const &resizing = *image.resizing();
+
+        xcassets::Resizing::Center::Mode centerMode = xcassets::Resizing::Center::Mode::Tile;
+        if (resizing.center()) {
+            xcassets::Resizing::Center const &center = *resizing.center();
+            if (center.mode()) {
+                centerMode = *center.mode();
+            }
+
+            /* TODO: center size is currently ingnored */
+        }
+
+        if (resizing.mode()) {
+            xcassets::Resizing::Mode resizingMode = *resizing.mode();
+            rendition.layout() = Convert::LayoutForResizingAndCenterMode(resizingMode, centerMode);
+            rendition.slices() = Convert::SlicesForResizingModeAndCapInsets(loaded.width, loaded.height, resizingMode, resizing.capInsets());
+        }
+    }
+
+    return rendition.write();
+}
+
+/*
+ * The cache key for an image's rendition. Everything that goes into the
+ * rendition comes from the image set's contents and the image itself.
+ */
+static ext::optional<std::string>
+RenditionCacheKey(
+    Filesystem const *filesystem,
+    xcassets::Asset::ImageSet const *imageSet,
+    xcassets::Asset::ImageSet::Image const &image,
+    std::string const &filename,
+    ext::optional<size_t> const &fastCompressionThreshold)
+{
+    std::unique_ptr<Filesystem::Mapping> contents = filesystem->readMapped(imageSet->path() + "/Contents.json");
+    std::unique_ptr<Filesystem::Mapping> pixels = filesystem->readMapped(filename);
+    if (contents == nullptr || pixels == nullptr) {
+        return ext::nullopt;
+    }
+
+    Hash hash = Hash(Version::BuildVersion());
+    hash.update(*image.fileName());
+    hash.update(contents->data(), contents->size());
+    hash.update(pixels->data(), pixels->size());
+
+    /* The image size isn't known until decoding, so key on the policy instead. */
+    uint8_t compression = static_cast<uint8_t>(RenditionCompression(0, ext::nullopt));
+    hash.update(&compression, sizeof(compression));
+    uint64_t threshold = fastCompressionThreshold.value_or(0);
+    hash.update(&threshold, sizeof(threshold));
+
+    return hash.hex();
+}
+
+static void
+LoadRendition(
+    Filesystem *filesystem,
+    ext::optional<std::string> const &cacheDirectory,
+    ext::optional<size_t> const &fastCompressionThreshold,
+    xcassets::Asset::ImageSet const *imageSet,
+    xcassets::Asset::ImageSet::Image const &image,
+    std::string const &filename,
+    double scale,
+    EncodedRendition *encoded)
+{
+    ext::optional<std::string> cachePath;
+    if (cacheDirectory) {
+        if (ext::optional<std::string> key = RenditionCacheKey(filesystem, imageSet, image, filename, fastCompressionThreshold)) {
+            cachePath = *cacheDirectory + "/" + *key + ".rendition";
+
+            /* Entries are written atomically, so any that exists is complete. */
+            if (filesystem->isReadable(*cachePath) && filesystem->read(&encoded->value, *cachePath)) {
+                return;
+            }
+        }
+    }
+
+    LoadedImage loaded;
+    LoadImage(filesystem, filename, &loaded);
+    if (loaded.error) {
+        encoded->error = loaded.error;
+        return;
+    }
+
+    encoded->value = EncodeRendition(image, scale, fastCompressionThreshold, std::move(loaded));
+    if (encoded->value.empty()) {
+        encoded->error = std::string("unable to encode image");
+        return;
     }
 
+    /* Failing to cache only makes the next compile slower. */
+    if (cachePath) {
+        (void)filesystem->writeAtomic(encoded->value, *cachePath);
+    }
+}
+
+void ImageSet::
+AddRendition(
+    std::string const &name,
+    double scale,
+    uint16_t idiom,
+    std::vector<uint8_t> &&value,
+    Output *compileOutput)
+{
+    static std::map<std::string, uint16_t> idMap = {};
+
     bool createFacet = false;
     uint16_t facetIdentifier = 0;
     auto it = idMap.find(name);
@@ -178,7 +298,7 @@ CompileAsset(
     }
 
     /*
-     * Create rendition for the image.
+     * Add the rendition for the image.
      */
     car::AttributeList attributes = car::AttributeList({
         { car_attribute_identifier_idiom, idiom },
@@ -186,34 +306,63 @@ CompileAsset(
         { car_attribute_identifier_identifier, facetIdentifier },
     });
 
-    auto data = ext::optional<car::Rendition::Data>(car::Rendition::Data(std::move(pixels), format));
+    compileOutput->car()->addRendition(attributes, std::move(value));
+}
 
-    car::Rendition rendition = car::Rendition::Create(attributes, std::move(data));
-    rendition.width() = width;
-    rendition.height() = height;
-    rendition.scale() = scale;
-    rendition.fileName() = *image.fileName();
+bool ImageSet::
+CompileAsset(
+    xcassets::Asset::ImageSet const *imageSet,
+    xcassets::Asset::ImageSet::Image const &image,
+    Filesystem *filesystem,
+    Output *compileOutput,
+    Result *result)
+{
+    /* Skip any entry that is not attached to a file, or is explicitly unassigned. */
+    if (!image.fileName() || image.unassigned()) {
+        return true;
+    }
 
-    if (image.resizing()) {
-        xcassets::Resizing const &resizing = *image.resizing();
+    /* An image without an idiom is considered unassigned. */
+    if (!image.idiom()) {
+        return false;
+    }
 
-        xcassets::Resizing::Center::Mode centerMode = xcassets::Resizing::Center::Mode::Tile;
-        if (resizing.center()) {
-            xcassets::Resizing::Center const &center = *resizing.center();
-            if (center.mode()) {
-                centerMode = *center.mode();
-            }
+    std::string filename = FSUtil::ResolveRelativePath(*image.fileName(), imageSet->path());
 
-            /* TODO: center size is currently ingnored */
-        }
+    /* An input even if it fails to load, so fixing it compiles again. */
+    compileOutput->inputs().push_back(filename);
 
-        if (resizing.mode()) {
-            xcassets::Resizing::Mode resizingMode = *resizing.mode();
-            rendition.layout() = Convert::LayoutForResizingAndCenterMode(resizingMode, centerMode);
-            rendition.slices() = Convert::SlicesForResizingModeAndCapInsets(width, height, resizingMode, resizing.capInsets());
-        }
+    std::string name = imageSet->name().string();
+
+    /* The default (0) is any scale. */
+    double scale = 0;
+    if (image.scale()) {
+        scale = image.scale()->value();
     }
 
-    compileOutput->car()->addRendition(std::move(rendition));
+    // TODO: filter by target-device / device-model / os-version
+    uint16_t idiom = Convert::IdiomAttribute(*image.idiom());
+
+    /*
+     * Reading, converting and encoding the image is slow and independent of
+     * other images, so it's deferred to run in parallel. Adding it to the
+     * archive then happens in order.
+     */
+    auto encoded = std::make_shared<EncodedRendition>();
+    ext::optional<std::string> cacheDirectory = compileOutput->cacheDirectory();
+    ext::optional<size_t> fastCompressionThreshold = compileOutput->fastCompressionThreshold();
+    auto load = [filesystem, cacheDirectory, fastCompressionThreshold, imageSet, &image, filename, scale, encoded]() {
+        LoadRendition(filesystem, cacheDirectory, fastCompressionThreshold, imageSet, image, filename, scale, encoded.get());
+    };
+    auto add = [filename, name, scale, idiom, encoded, compileOutput, result]() {
+        if (encoded->error) {
+            result->normal(Result::Severity::Error, *encoded->error, filename);
+            return;
+        }
+
+        AddRendition(name, scale, idiom, std::move(encoded->value), compileOutput);
+    };
+    compileOutput->deferred().push_back({ load, add });
+
     return true;
 }
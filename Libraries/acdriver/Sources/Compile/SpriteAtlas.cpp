@@ -8,14 +8,270 @@
  */
 
 #include <acdriver/Compile/SpriteAtlas.h>
+#include <acdriver/Compile/Convert.h>
+#include <acdriver/Compile/ImageSet.h>
 #include <acdriver/Compile/Output.h>
 #include <acdriver/Result.h>
+#include <acdriver/Version.h>
+#include <graphics/Atlas.h>
+#include <graphics/PixelFormat.h>
+#include <graphics/Format/PNG.h>
+#include <xcassets/Asset/ImageSet.h>
+#include <car/Rendition.h>
 #include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Hash.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <map>
+#include <cstring>
 
 using acdriver::Compile::SpriteAtlas;
+using acdriver::Compile::Convert;
+using acdriver::Compile::ImageSet;
 using acdriver::Compile::Output;
 using acdriver::Result;
+using acdriver::Version;
 using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::Hash;
+
+/* The largest page; larger textures aren't supported by every device. */
+static graphics::Atlas::Options const PageOptions = { 2048, 2048, 2, true };
+
+/* Every sprite is converted to this, so they can share a page. */
+static graphics::PixelFormat const PageFormat = graphics::PixelFormat(
+    graphics::PixelFormat::Color::RGB,
+    graphics::PixelFormat::Order::Reversed,
+    graphics::PixelFormat::Alpha::PremultipliedFirst);
+
+namespace {
+
+/*
+ * An image to pack into the atlas.
+ */
+struct Sprite {
+    xcassets::Asset::ImageSet const *imageSet;
+    std::string                      filename;
+};
+
+/*
+ * The pages for sprites of one idiom and scale.
+ */
+struct Pages {
+    std::vector<std::vector<uint8_t>> values;
+    ext::optional<std::string>        error;
+};
+
+}
+
+/*
+ * The cache key for an atlas's pages. Pages depend on every sprite in the
+ * atlas, so any sprite changing packs the whole atlas again.
+ */
+static ext::optional<std::string>
+PagesCacheKey(Filesystem const *filesystem, std::string const &name, double scale, std::vector<Sprite> const &sprites)
+{
+    Hash hash = Hash(Version::BuildVersion());
+    hash.update(name);
+    hash.update(&scale, sizeof(scale));
+    uint64_t options[] = { PageOptions.pageWidth, PageOptions.pageHeight, PageOptions.padding, PageOptions.rotation };
+    hash.update(options, sizeof(options));
+
+    for (Sprite const &sprite : sprites) {
+        std::unique_ptr<Filesystem::Mapping> contents = filesystem->readMapped(sprite.imageSet->path() + "/Contents.json");
+        std::unique_ptr<Filesystem::Mapping> pixels = filesystem->readMapped(sprite.filename);
+        if (contents == nullptr || pixels == nullptr) {
+            return ext::nullopt;
+        }
+
+        hash.update(sprite.filename);
+        hash.update(contents->data(), contents->size());
+        hash.update(pixels->data(), pixels->size());
+    }
+
+    return hash.hex();
+}
+
+/*
+ * Cached pages are stored one after another, each after its length.
+ */
+static std::vector<uint8_t>
+SerializePages(std::vector<std::vector<uint8_t>> const &values)
+{
+    std::vector<uint8_t> contents;
+    for (std::vector<uint8_t> const &value : values) {
+        uint64_t size = value.size();
+        uint8_t const *bytes = reinterpret_cast<uint8_t const *>(&size);
+        contents.insert(contents.end(), bytes, bytes + sizeof(size));
+        contents.insert(contents.end(), value.begin(), value.end());
+    }
+    return contents;
+}
+
+static bool
+DeserializePages(std::vector<uint8_t> const &contents, std::vector<std::vector<uint8_t>> *values)
+{
+    size_t offset = 0;
+    while (offset < contents.size()) {
+        uint64_t size;
+        if (contents.size() - offset < sizeof(size)) {
+            return false;
+        }
+        memcpy(&size, contents.data() + offset, sizeof(size));
+        offset += sizeof(size);
+
+        if (contents.size() - offset < size) {
+            return false;
+        }
+        values->emplace_back(contents.begin() + offset, contents.begin() + offset + size);
+        offset += size;
+    }
+    return true;
+}
+
+static void
+PackPages(Filesystem const *filesystem, std::string const &name, double scale, std::vector<Sprite> const &sprites, Pages *pages)
+{
+    /*
+     * Decode and trim every sprite. Each is independent, so in parallel.
+     */
+    std::vector<ext::optional<graphics::Image>> images = std::vector<ext::optional<graphics::Image>>(sprites.size());
+    std::vector<graphics::Atlas::Rect> regions = std::vector<graphics::Atlas::Rect>(sprites.size());
+    std::vector<std::string> errors = std::vector<std::string>(sprites.size());
+
+    libutil::Parallel::For(sprites.size(), [&](size_t index) {
+        std::unique_ptr<Filesystem::Mapping> contents = filesystem->readMapped(sprites[index].filename);
+        if (contents == nullptr) {
+            errors[index] = "unable to read PNG file: " + sprites[index].filename;
+            return;
+        }
+
+        auto png = graphics::Format::PNG::Read(contents->data(), contents->size(), [](graphics::PixelFormat const &) {
+            return PageFormat;
+        });
+        if (!png.first) {
+            errors[index] = png.second + ": " + sprites[index].filename;
+            return;
+        }
+
+        regions[index] = graphics::Atlas::Trim(*png.first);
+        images[index] = std::move(png.first);
+    });
+
+    for (std::string const &error : errors) {
+        if (!error.empty()) {
+            pages->error = error;
+            return;
+        }
+    }
+
+    /*
+     * Pack the visible part of each sprite.
+     */
+    std::vector<std::pair<size_t, size_t>> sizes;
+    sizes.reserve(regions.size());
+    for (graphics::Atlas::Rect const &region : regions) {
+        sizes.push_back({ region.width, region.height });
+    }
+
+    ext::optional<std::vector<graphics::Atlas::Placement>> placements = graphics::Atlas::Pack(sizes, PageOptions);
+    if (!placements) {
+        pages->error = std::string("sprite is larger than an atlas page");
+        return;
+    }
+
+    /*
+     * Size each page to what's on it, then copy the sprites in. Sprites
+     * don't overlap, so they're copied in parallel.
+     */
+    std::vector<std::pair<size_t, size_t>> extents;
+    for (size_t i = 0; i < placements->size(); i++) {
+        graphics::Atlas::Placement const &placement = (*placements)[i];
+        if (sizes[i].first == 0 || sizes[i].second == 0) {
+            continue;
+        }
+
+        if (placement.page >= extents.size()) {
+            extents.resize(placement.page + 1, { 0, 0 });
+        }
+
+        size_t width = (placement.rotated ? sizes[i].second : sizes[i].first);
+        size_t height = (placement.rotated ? sizes[i].first : sizes[i].second);
+        extents[placement.page].first = std::max(extents[placement.page].first, placement.x + width);
+        extents[placement.page].second = std::max(extents[placement.page].second, placement.y + height);
+    }
+
+    std::vector<graphics::Image> pageImages = std::vector<graphics::Image>();
+    pageImages.reserve(extents.size());
+    for (std::pair<size_t, size_t> const &extent : extents) {
+        std::vector<uint8_t> pixels = std::vector<uint8_t>(extent.first * extent.second * PageFormat.bytesPerPixel(), 0);
+        pageImages.push_back(graphics::Image(extent.first, extent.second, PageFormat, std::move(pixels)));
+    }
+
+    libutil::Parallel::For(placements->size(), [&](size_t index) {
+        graphics::Atlas::Placement const &placement = (*placements)[index];
+        if (sizes[index].first != 0 && sizes[index].second != 0) {
+            graphics::Atlas::Blit(&pageImages[placement.page], placement.x, placement.y, placement.rotated, *images[index], regions[index]);
+        }
+    });
+
+    /*
+     * Encode the pages as renditions.
+     */
+    pages->values.resize(pageImages.size());
+    libutil::Parallel::For(pageImages.size(), [&](size_t index) {
+        graphics::Image &image = pageImages[index];
+        size_t width = image.width();
+        size_t height = image.height();
+
+        auto attributes = car::AttributeList(std::unordered_map<car_attribute_identifier, uint16_t>());
+        auto data = ext::optional<car::Rendition::Data>(car::Rendition::Data(std::move(image.data()), car::Rendition::Data::Format::PremultipliedBGRA8));
+
+        car::Rendition rendition = car::Rendition::Create(attributes, std::move(data));
+        rendition.width() = width;
+        rendition.height() = height;
+        rendition.scale() = scale;
+        rendition.fileName() = name + "-" + std::to_string(index) + ".png";
+        rendition.layout() = car_rendition_value_layout_one_part_scale;
+        pages->values[index] = rendition.write();
+    });
+}
+
+static void
+LoadPages(
+    Filesystem *filesystem,
+    ext::optional<std::string> const &cacheDirectory,
+    std::string const &name,
+    double scale,
+    std::vector<Sprite> const &sprites,
+    Pages *pages)
+{
+    ext::optional<std::string> cachePath;
+    if (cacheDirectory) {
+        if (ext::optional<std::string> key = PagesCacheKey(filesystem, name, scale, sprites)) {
+            cachePath = *cacheDirectory + "/" + *key + ".atlas";
+
+            /* Entries are written atomically, so any that exists is complete. */
+            std::vector<uint8_t> contents;
+            if (filesystem->isReadable(*cachePath) && filesystem->read(&contents, *cachePath) && DeserializePages(contents, &pages->values)) {
+                return;
+            }
+            pages->values.clear();
+        }
+    }
+
+    PackPages(filesystem, name, scale, sprites, pages);
+    if (pages->error) {
+        return;
+    }
+
+    /* Failing to cache only makes the next compile slower. */
+    if (cachePath) {
+        (void)filesystem->writeAtomic(SerializePages(pages->values), *cachePath);
+    }
+}
 
 bool SpriteAtlas::
 Compile(
@@ -24,12 +280,71 @@ Compile(
     Output *compileOutput,
     Result *result)
 {
-    result->document(
-        Result::Severity::Warning,
-        spriteAtlas->path(),
-        { Output::AssetReference(spriteAtlas) },
-        "Not Implemented",
-        "sprite atlas not yet supported");
-
-    return false;
+    /*
+     * Sprites are the images in the atlas's image sets. Only sprites for
+     * the same device and scale can share a page.
+     */
+    std::map<std::pair<uint16_t, double>, std::vector<Sprite>> groups;
+    for (std::unique_ptr<xcassets::Asset::Asset> const &child : spriteAtlas->children()) {
+        if (child->type() != xcassets::Asset::AssetType::ImageSet) {
+            continue;
+        }
+
+        auto imageSet = static_cast<xcassets::Asset::ImageSet const *>(child.get());
+        if (!imageSet->images()) {
+            continue;
+        }
+
+        for (xcassets::Asset::ImageSet::Image const &image : *imageSet->images()) {
+            if (!image.fileName() || image.unassigned() || !image.idiom()) {
+                continue;
+            }
+
+            /* Other formats are stored as is, and can't be packed. */
+            if (!FSUtil::IsFileExtension(*image.fileName(), "png", true)) {
+                continue;
+            }
+
+            uint16_t idiom = Convert::IdiomAttribute(*image.idiom());
+            double scale = (image.scale() ? image.scale()->value() : 0);
+            std::string filename = FSUtil::ResolveRelativePath(*image.fileName(), imageSet->path());
+            groups[{ idiom, scale }].push_back({ imageSet, filename });
+        }
+    }
+
+    std::string name = spriteAtlas->name().string();
+    ext::optional<std::string> cacheDirectory = compileOutput->cacheDirectory();
+
+    /*
+     * Packing is deferred, like other images, to run in parallel with the
+     * rest of the catalog. Adding the pages then happens in order.
+     */
+    for (auto const &entry : groups) {
+        uint16_t idiom = entry.first.first;
+        double scale = entry.first.second;
+        std::vector<Sprite> const &sprites = entry.second;
+
+        auto pages = std::make_shared<Pages>();
+        auto load = [filesystem, cacheDirectory, name, scale, sprites, pages]() {
+            LoadPages(filesystem, cacheDirectory, name, scale, sprites, pages.get());
+        };
+        auto add = [spriteAtlas, name, scale, idiom, pages, compileOutput, result]() {
+            if (pages->error) {
+                result->document(
+                    Result::Severity::Error,
+                    spriteAtlas->path(),
+                    { Output::AssetReference(spriteAtlas) },
+                    "Sprite Atlas",
+                    *pages->error);
+                return;
+            }
+
+            for (size_t index = 0; index < pages->values.size(); index++) {
+                ImageSet::AddRendition(name + "-" + std::to_string(index), scale, idiom, std::move(pages->values[index]), compileOutput);
+            }
+        };
+        compileOutput->deferred().push_back({ load, add });
+    }
+
+    return true;
 }
@@ -38,6 +38,9 @@ using acdriver::Result;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
+/* Four megapixels, such as a 2048x2048 image. */
+static int const DefaultFastCompressionThreshold = 2048 * 2048;
+
 CompileAction::
 CompileAction()
 {
@@ -83,6 +86,9 @@ WriteOutput(Filesystem *filesystem, Options const &options, Compile::Output cons
             success = false;
             continue;
         }
+
+        /* Note input file. */
+        info.inputs().push_back(copy.first);
     }
 
     /*
@@ -279,6 +285,26 @@ run(Filesystem *filesystem, Options const &options, Output *output, Result *resu
         compileOutput.car() = std::move(writer);
         // TODO: should only be an output if ultimately non-empty
         compileOutput.outputs().push_back(path);
+
+        /*
+         * Without a cache, everything is just compiled from scratch.
+         */
+        if (options.compileCacheDirectory()) {
+            if (filesystem->createDirectory(*options.compileCacheDirectory())) {
+                compileOutput.cacheDirectory() = options.compileCacheDirectory();
+            } else {
+                result->normal(Result::Severity::Warning, "unable to create compile cache directory");
+            }
+        }
+
+        /*
+         * Compressing very large images is most of the compile time, and
+         * they gain little from the slower levels.
+         */
+        int fastCompressionThreshold = options.fastCompressionThreshold().value_or(DefaultFastCompressionThreshold);
+        if (fastCompressionThreshold > 0) {
+            compileOutput.fastCompressionThreshold() = static_cast<size_t>(fastCompressionThreshold);
+        }
     }
 
     /*
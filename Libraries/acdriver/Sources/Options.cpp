@@ -34,6 +34,10 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Next<std::string>(&_compile, args, it);
     } else if (arg == "--compile-output-filename") {
         return libutil::Options::Next<std::string>(&_compileOutputFilename, args, it);
+    } else if (arg == "--compile-cache-directory") {
+        return libutil::Options::Next<std::string>(&_compileCacheDirectory, args, it);
+    } else if (arg == "--fast-compression-threshold") {
+        return libutil::Options::Next<int>(&_fastCompressionThreshold, args, it);
     } else if (arg == "--output-format") {
         return libutil::Options::Next<std::string>(&_outputFormat, args, it);
     } else if (arg == "--warnings") {
@@ -0,0 +1,99 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __builtin_Server_h
+#define __builtin_Server_h
+
+#include <builtin/Registry.h>
+
+#include <string>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+namespace process { class Context; }
+
+namespace builtin {
+
+/*
+ * Runs builtin drivers for clients connecting over a Unix domain socket. This
+ * lets build systems like Ninja run builtins without executing a new process
+ * for each one. Each request runs in a process forked from the server, so
+ * requests run at the same time, and a builtin that crashes only fails its
+ * own request.
+ *
+ * The client sends its arguments, environment, and working directory along
+ * with its standard output and standard error, so the driver's output goes
+ * to the same place it would if the client ran the builtin itself.
+ *
+ * The socket is in a directory only this user can access, and only clients
+ * of the same user are served. Clients find it through a file at a known
+ * path, which holds the path to the socket.
+ */
+class Server {
+private:
+    Registry    _registry;
+    std::string _path;
+
+private:
+    std::string _directory;
+    std::string _socketPath;
+    int         _socket;
+    int         _stop[2];
+
+public:
+    Server(Registry const &registry, std::string const &path);
+    ~Server();
+
+public:
+    /*
+     * The path to the file holding the path to the socket.
+     */
+    std::string const &path() const
+    { return _path; }
+
+    /*
+     * The path to the socket, once listening.
+     */
+    std::string const &socketPath() const
+    { return _socketPath; }
+
+public:
+    /*
+     * Start listening on a new socket, and point the file at the path to it.
+     */
+    bool listen();
+
+    /*
+     * Handle requests until stopped, then wait for those still running. The
+     * process context provides the user and group for the drivers run.
+     */
+    void serve(process::Context const *processContext, libutil::Filesystem *filesystem);
+
+    /*
+     * Stop serving. Safe to call from any thread.
+     */
+    void stop();
+
+private:
+    void unlisten();
+
+public:
+    /*
+     * Ask the server named by the file at a path to run a builtin, using the
+     * arguments, environment, and working directory of a context. Returns
+     * the exit code of the builtin, or nothing if no server of this user
+     * could be reached and it's safe to run the builtin some other way.
+     */
+    static ext::optional<int>
+    Run(std::string const &path, std::string const &name, process::Context const *context);
+};
+
+}
+
+#endif // !__builtin_Server_h
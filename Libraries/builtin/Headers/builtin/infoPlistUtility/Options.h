@@ -29,6 +29,12 @@ private:
     ext::optional<std::string> _format;
     ext::optional<bool>        _expandBuildSettings;
 
+private:
+    ext::optional<bool>        _preprocess;
+    ext::optional<std::string> _prefixHeader;
+    std::vector<std::string>   _definitions;
+    ext::optional<std::string> _dependencyFile;
+
 private:
     ext::optional<std::string> _platform;
     std::vector<std::string>   _requiredArchitectures;
@@ -59,6 +65,16 @@ public:
     bool expandBuildSettings() const
     { return _expandBuildSettings.value_or(false); }
 
+public:
+    bool preprocess() const
+    { return _preprocess.value_or(false); }
+    ext::optional<std::string> const &prefixHeader() const
+    { return _prefixHeader; }
+    std::vector<std::string> const &definitions() const
+    { return _definitions; }
+    ext::optional<std::string> const &dependencyFile() const
+    { return _dependencyFile; }
+
 public:
     ext::optional<std::string> const &platform() const
     { return _platform; }
@@ -0,0 +1,98 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __builtin_infoPlistUtility_Preprocessor_h
+#define __builtin_infoPlistUtility_Preprocessor_h
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+
+namespace builtin {
+namespace infoPlistUtility {
+
+/*
+ * Preprocesses Info.plist files in memory, like the C preprocessor. Handles
+ * object-like and function-like macros, `#include "file"`, `#undef`, and
+ * conditionals with integer expressions. Stringizing, token pasting, and
+ * variadic macros are not supported.
+ */
+class Preprocessor {
+private:
+    struct Macro {
+        ext::optional<std::vector<std::string>> parameters;
+        std::string                             body;
+    };
+
+private:
+    libutil::Filesystem const              *_filesystem;
+    std::unordered_map<std::string, Macro>  _macros;
+    size_t                                  _depth;
+    std::vector<std::string>                _includes;
+
+public:
+    explicit Preprocessor(libutil::Filesystem const *filesystem);
+
+public:
+    /*
+     * Define a macro as on the command line: `NAME` defines it as 1, and
+     * `NAME=VALUE` as the value.
+     */
+    void define(std::string const &definition);
+
+    /*
+     * If a macro is defined.
+     */
+    bool defined(std::string const &name) const
+    { return _macros.find(name) != _macros.end(); }
+
+    /*
+     * The headers read so far, in the order first read.
+     */
+    std::vector<std::string> const &includes() const
+    { return _includes; }
+
+public:
+    /*
+     * Preprocess the contents of a file, appending what's left to the output,
+     * if any. Line comments are only removed from headers and directives,
+     * since plists often hold URLs.
+     */
+    std::pair<bool, std::string>
+    process(std::string const &path, std::string const &contents, bool header, std::string *output);
+
+    /*
+     * Read and preprocess a header.
+     */
+    std::pair<bool, std::string>
+    include(std::string const &path, std::string *output);
+
+private:
+    std::pair<bool, std::string>
+    directive(std::string const &path, std::string const &line, std::string *output);
+
+    bool
+    defineDirective(std::string const &text);
+
+    std::pair<bool, std::string>
+    evaluate(std::string const &expression, bool *result) const;
+
+    std::string
+    expand(std::string const &text, std::unordered_set<std::string> const &disabled) const;
+};
+
+}
+}
+
+#endif // !__builtin_infoPlistUtility_Preprocessor_h
@@ -0,0 +1,111 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __builtin_swiftStdLibTool_Options_h
+#define __builtin_swiftStdLibTool_Options_h
+
+#include <libutil/Options.h>
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace builtin {
+namespace swiftStdLibTool {
+
+/*
+ * The options of swift-stdlib-tool. Those for signing are parsed so the
+ * tool can say they aren't supported.
+ */
+class Options {
+private:
+    ext::optional<bool>        _print;
+    ext::optional<bool>        _copy;
+    ext::optional<bool>        _verbose;
+
+private:
+    std::vector<std::string>   _scanExecutables;
+    std::vector<std::string>   _scanFolders;
+    ext::optional<std::string> _platform;
+    ext::optional<std::string> _sourceLibraries;
+    std::vector<std::string>   _toolchains;
+
+private:
+    ext::optional<std::string> _destination;
+    ext::optional<std::string> _unsignedDestination;
+    ext::optional<std::string> _resourceDestination;
+    std::vector<std::string>   _resourceLibraries;
+
+private:
+    ext::optional<bool>        _stripBitcode;
+    ext::optional<std::string> _stripBitcodeTool;
+
+private:
+    ext::optional<std::string> _sign;
+    ext::optional<std::string> _keychain;
+    std::vector<std::string>   _codesignArguments;
+
+public:
+    Options();
+    ~Options();
+
+public:
+    bool print() const
+    { return _print.value_or(false); }
+    bool copy() const
+    { return _copy.value_or(false); }
+    bool verbose() const
+    { return _verbose.value_or(false); }
+
+public:
+    std::vector<std::string> const &scanExecutables() const
+    { return _scanExecutables; }
+    std::vector<std::string> const &scanFolders() const
+    { return _scanFolders; }
+    ext::optional<std::string> const &platform() const
+    { return _platform; }
+    ext::optional<std::string> const &sourceLibraries() const
+    { return _sourceLibraries; }
+    std::vector<std::string> const &toolchains() const
+    { return _toolchains; }
+
+public:
+    ext::optional<std::string> const &destination() const
+    { return _destination; }
+    ext::optional<std::string> const &unsignedDestination() const
+    { return _unsignedDestination; }
+    ext::optional<std::string> const &resourceDestination() const
+    { return _resourceDestination; }
+    std::vector<std::string> const &resourceLibraries() const
+    { return _resourceLibraries; }
+
+public:
+    bool stripBitcode() const
+    { return _stripBitcode.value_or(false); }
+    ext::optional<std::string> const &stripBitcodeTool() const
+    { return _stripBitcodeTool; }
+
+public:
+    ext::optional<std::string> const &sign() const
+    { return _sign; }
+    ext::optional<std::string> const &keychain() const
+    { return _keychain; }
+    std::vector<std::string> const &codesignArguments() const
+    { return _codesignArguments; }
+
+private:
+    friend class libutil::Options;
+    std::pair<bool, std::string>
+    parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it);
+};
+
+}
+}
+
+#endif // !__builtin_swiftStdLibTool_Options_h
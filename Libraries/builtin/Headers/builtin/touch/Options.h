@@ -0,0 +1,46 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __builtin_touch_Options_h
+#define __builtin_touch_Options_h
+
+#include <libutil/Options.h>
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace builtin {
+namespace touch {
+
+class Options {
+private:
+    ext::optional<bool>      _noCreate;
+    std::vector<std::string> _paths;
+
+public:
+    Options();
+    ~Options();
+
+public:
+    bool noCreate() const
+    { return _noCreate.value_or(false); }
+    std::vector<std::string> const &paths() const
+    { return _paths; }
+
+private:
+    friend class libutil::Options;
+    std::pair<bool, std::string>
+    parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it);
+};
+
+}
+}
+
+#endif // !__builtin_touch_Options_h
@@ -17,6 +17,10 @@
 #include <builtin/productPackagingUtility/Driver.h>
 #include <builtin/validationUtility/Driver.h>
 #include <builtin/embeddedBinaryValidationUtility/Driver.h>
+#include <builtin/swiftStdLibTool/Driver.h>
+#include <builtin/mkdir/Driver.h>
+#include <builtin/touch/Driver.h>
+#include <builtin/symlink/Driver.h>
 
 using builtin::Registry;
 using builtin::Driver;
@@ -66,5 +70,9 @@ Default()
         std::make_shared<builtin::productPackagingUtility::Driver>(),
         std::make_shared<builtin::validationUtility::Driver>(),
         std::make_shared<builtin::embeddedBinaryValidationUtility::Driver>(),
+        std::make_shared<builtin::swiftStdLibTool::Driver>(),
+        std::make_shared<builtin::mkdir::Driver>(),
+        std::make_shared<builtin::touch::Driver>(),
+        std::make_shared<builtin::symlink::Driver>(),
     });
 }
@@ -0,0 +1,604 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <builtin/Server.h>
+#include <builtin/Driver.h>
+#include <process/Context.h>
+#include <process/MemoryContext.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using builtin::Server;
+using builtin::Registry;
+using builtin::Driver;
+using libutil::Filesystem;
+
+/*
+ * Protocol: the client sends a single byte carrying its standard output and
+ * standard error as rights, then the request: the builtin name, working
+ * directory, arguments, and environment. Strings are a 32-bit length then
+ * the contents; lists are a 32-bit count then the items. The server answers
+ * with the 32-bit exit code of the builtin.
+ */
+
+/*
+ * Avoid being killed by SIGPIPE if the other end of the socket goes away.
+ */
+#if defined(MSG_NOSIGNAL)
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+static void
+DisableSignalPipe(int fd)
+{
+#if defined(SO_NOSIGPIPE)
+    int value = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &value, sizeof(value));
+#else
+    (void)fd;
+#endif
+}
+
+static bool
+WriteAll(int fd, void const *data, size_t size)
+{
+    uint8_t const *bytes = static_cast<uint8_t const *>(data);
+    while (size > 0) {
+        ssize_t written = ::send(fd, bytes, size, SEND_FLAGS);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        bytes += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+static bool
+ReadAll(int fd, void *data, size_t size)
+{
+    uint8_t *bytes = static_cast<uint8_t *>(data);
+    while (size > 0) {
+        ssize_t read = ::read(fd, bytes, size);
+        if (read <= 0) {
+            if (read < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        bytes += read;
+        size -= read;
+    }
+
+    return true;
+}
+
+static bool
+WriteInteger(int fd, uint32_t value)
+{
+    return WriteAll(fd, &value, sizeof(value));
+}
+
+static bool
+ReadInteger(int fd, uint32_t *value)
+{
+    return ReadAll(fd, value, sizeof(*value));
+}
+
+static bool
+WriteString(int fd, std::string const &value)
+{
+    return WriteInteger(fd, static_cast<uint32_t>(value.size())) && WriteAll(fd, value.data(), value.size());
+}
+
+static bool
+ReadString(int fd, std::string *value)
+{
+    uint32_t size;
+    if (!ReadInteger(fd, &size)) {
+        return false;
+    }
+
+    value->resize(size);
+    return size == 0 || ReadAll(fd, &(*value)[0], size);
+}
+
+static bool
+SocketAddress(std::string const &path, struct sockaddr_un *address)
+{
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address->sun_path)) {
+        return false;
+    }
+
+    memcpy(address->sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+/*
+ * If the other end of a connection is a process of this user.
+ */
+static bool
+PeerIsUser(int fd)
+{
+#if defined(SO_PEERCRED)
+    struct ucred credentials;
+    socklen_t size = sizeof(credentials);
+    if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &size) != 0) {
+        return false;
+    }
+    return credentials.uid == ::geteuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    if (::getpeereid(fd, &uid, &gid) != 0) {
+        return false;
+    }
+    return uid == ::geteuid();
+#endif
+}
+
+/*
+ * The contents of the file pointing to a server's socket.
+ */
+static ext::optional<std::string>
+ReadSocketPath(std::string const &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return ext::nullopt;
+    }
+
+    std::string contents;
+    char buffer[256];
+    ssize_t read;
+    while ((read = ::read(fd, buffer, sizeof(buffer))) != 0) {
+        if (read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ::close(fd);
+            return ext::nullopt;
+        }
+
+        contents.append(buffer, read);
+    }
+
+    ::close(fd);
+    return contents;
+}
+
+Server::
+Server(Registry const &registry, std::string const &path) :
+    _registry(registry),
+    _path    (path),
+    _socket  (-1),
+    _stop    { -1, -1 }
+{
+}
+
+Server::
+~Server()
+{
+    unlisten();
+
+    if (_stop[0] != -1) {
+        ::close(_stop[0]);
+        ::close(_stop[1]);
+    }
+}
+
+bool Server::
+listen()
+{
+    if (::pipe(_stop) != 0) {
+        _stop[0] = _stop[1] = -1;
+        return false;
+    }
+
+    /*
+     * Socket paths are limited to around 100 characters, so the socket can't
+     * be next to the file pointing to it. Create it in a new directory only
+     * this user can access, so no other user can connect to or replace it.
+     */
+    char directory[] = "/tmp/xcbuild-builtin.XXXXXX";
+    if (::mkdtemp(directory) == nullptr) {
+        return false;
+    }
+    _directory = directory;
+    _socketPath = _directory + "/socket";
+
+    struct sockaddr_un address;
+    if (!SocketAddress(_socketPath, &address)) {
+        unlisten();
+        return false;
+    }
+
+    _socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_socket == -1) {
+        unlisten();
+        return false;
+    }
+    ::fcntl(_socket, F_SETFD, FD_CLOEXEC);
+
+    if (::bind(_socket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 || ::listen(_socket, SOMAXCONN) != 0) {
+        unlisten();
+        return false;
+    }
+
+    /*
+     * Point the file at the socket. Replace it in one step, so clients never
+     * read part of the path.
+     */
+    std::string temporary = _path + ".XXXXXX";
+    int fd = ::mkstemp(&temporary[0]);
+    if (fd == -1) {
+        unlisten();
+        return false;
+    }
+
+    bool written = (::write(fd, _socketPath.data(), _socketPath.size()) == static_cast<ssize_t>(_socketPath.size()));
+    ::close(fd);
+    if (!written || ::rename(temporary.c_str(), _path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        unlisten();
+        return false;
+    }
+
+    return true;
+}
+
+void Server::
+unlisten()
+{
+    if (_socket != -1) {
+        ::close(_socket);
+        _socket = -1;
+
+        /* Another server could be using the file now; if so, leave it. */
+        if (ReadSocketPath(_path) == _socketPath) {
+            ::unlink(_path.c_str());
+        }
+    }
+
+    if (!_directory.empty()) {
+        ::unlink(_socketPath.c_str());
+        ::rmdir(_directory.c_str());
+        _directory.clear();
+    }
+}
+
+static int
+HandleRequest(Registry *registry, process::Context const *processContext, Filesystem *filesystem, int connection)
+{
+    /*
+     * Receive the client's standard output and standard error.
+     */
+    char byte;
+    struct iovec iov = { &byte, sizeof(byte) };
+
+    union {
+        struct cmsghdr header;
+        char buffer[CMSG_SPACE(sizeof(int) * 2)];
+    } control;
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    if (::recvmsg(connection, &message, 0) != 1) {
+        return -1;
+    }
+
+    struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+    if (header == nullptr || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS || header->cmsg_len != CMSG_LEN(sizeof(int) * 2)) {
+        return -1;
+    }
+
+    int fds[2];
+    memcpy(fds, CMSG_DATA(header), sizeof(fds));
+
+    /*
+     * Receive the request.
+     */
+    std::string name;
+    std::string directory;
+    std::vector<std::string> arguments;
+    std::unordered_map<std::string, std::string> environment;
+
+    bool valid = ReadString(connection, &name) && ReadString(connection, &directory);
+
+    uint32_t count = 0;
+    valid = valid && ReadInteger(connection, &count);
+    for (uint32_t i = 0; valid && i < count; ++i) {
+        std::string argument;
+        valid = ReadString(connection, &argument);
+        arguments.push_back(argument);
+    }
+
+    valid = valid && ReadInteger(connection, &count);
+    for (uint32_t i = 0; valid && i < count; ++i) {
+        std::string key;
+        std::string value;
+        valid = ReadString(connection, &key) && ReadString(connection, &value);
+        environment.insert({ key, value });
+    }
+
+    int exitCode = -1;
+    if (valid) {
+        /*
+         * Run the driver with the client's output. This is a process of its
+         * own, so its output doesn't affect other requests.
+         */
+        ::dup2(fds[0], STDOUT_FILENO);
+        ::dup2(fds[1], STDERR_FILENO);
+
+        if (std::shared_ptr<Driver> driver = registry->driver(name)) {
+            process::MemoryContext context = process::MemoryContext(
+                name,
+                directory,
+                arguments,
+                environment,
+                processContext->userID(),
+                processContext->groupID(),
+                processContext->userName(),
+                processContext->groupName());
+            exitCode = driver->run(&context, filesystem);
+        } else {
+            fprintf(stderr, "error: unknown builtin %s\n", name.c_str());
+            exitCode = 1;
+        }
+
+        fflush(stdout);
+        fflush(stderr);
+    }
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return exitCode;
+}
+
+namespace {
+
+/*
+ * A request running in its own process. The server keeps the connection to
+ * answer for the request if the process dies before it does.
+ */
+struct Request {
+    pid_t pid;
+    int   connection;
+};
+
+}
+
+/*
+ * How often to check for requests that finished, in milliseconds.
+ */
+static int const ReapInterval = 50;
+
+/*
+ * Reap finished requests. A request killed by a signal is answered here,
+ * with the exit code a shell would report for it.
+ */
+static void
+ReapRequests(std::vector<Request> *requests, bool block)
+{
+    for (auto it = requests->begin(); it != requests->end();) {
+        int status;
+        pid_t pid;
+        do {
+            pid = ::waitpid(it->pid, &status, block ? 0 : WNOHANG);
+        } while (pid < 0 && errno == EINTR);
+
+        if (pid == 0) {
+            ++it;
+            continue;
+        }
+
+        if (pid == it->pid && WIFSIGNALED(status)) {
+            WriteInteger(it->connection, static_cast<uint32_t>(128 + WTERMSIG(status)));
+        }
+
+        ::close(it->connection);
+        it = requests->erase(it);
+    }
+}
+
+void Server::
+serve(process::Context const *processContext, Filesystem *filesystem)
+{
+    std::vector<Request> requests;
+
+    while (true) {
+        struct pollfd pollfds[2] = {
+            { _socket, POLLIN, 0 },
+            { _stop[0], POLLIN, 0 },
+        };
+
+        int result = ::poll(pollfds, 2, requests.empty() ? -1 : ReapInterval);
+        ReapRequests(&requests, false);
+
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        if (pollfds[1].revents != 0) {
+            /* Stopped; refuse further clients so they fall back. */
+            unlisten();
+            break;
+        }
+
+        if (pollfds[0].revents == 0) {
+            continue;
+        }
+
+        int connection = ::accept(_socket, nullptr, nullptr);
+        if (connection == -1) {
+            continue;
+        }
+        ::fcntl(connection, F_SETFD, FD_CLOEXEC);
+
+        /* Builtins run as this user, so only serve this user. */
+        if (!PeerIsUser(connection)) {
+            ::close(connection);
+            continue;
+        }
+        DisableSignalPipe(connection);
+
+        /*
+         * Run each request in a process forked from this one, so requests
+         * run at the same time, each writing to its own client's output, and
+         * one that crashes only fails itself.
+         */
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            ::close(_socket);
+            ::close(_stop[0]);
+            ::close(_stop[1]);
+
+            int exitCode = HandleRequest(&_registry, processContext, filesystem, connection);
+            if (exitCode != -1) {
+                WriteInteger(connection, static_cast<uint32_t>(exitCode));
+            }
+
+            /* Skip the server's own cleanup, which isn't this process's to do. */
+            ::_exit(0);
+        } else if (pid < 0) {
+            fprintf(stderr, "warning: unable to start builtin: %s\n", strerror(errno));
+            ::close(connection);
+            continue;
+        }
+
+        requests.push_back({ pid, connection });
+    }
+
+    /* Requests already started still finish. */
+    ReapRequests(&requests, true);
+}
+
+void Server::
+stop()
+{
+    char byte = 0;
+    while (::write(_stop[1], &byte, sizeof(byte)) < 0 && errno == EINTR) { }
+}
+
+ext::optional<int> Server::
+Run(std::string const &path, std::string const &name, process::Context const *context)
+{
+    ext::optional<std::string> socketPath = ReadSocketPath(path);
+    if (!socketPath) {
+        return ext::nullopt;
+    }
+
+    struct sockaddr_un address;
+    if (!SocketAddress(*socketPath, &address)) {
+        return ext::nullopt;
+    }
+
+    int connection = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection == -1) {
+        return ext::nullopt;
+    }
+
+    /* Output is only handed to a server of this user. */
+    if (::connect(connection, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 || !PeerIsUser(connection)) {
+        ::close(connection);
+        return ext::nullopt;
+    }
+    DisableSignalPipe(connection);
+
+    /*
+     * Send standard output and standard error for the builtin to use.
+     */
+    char byte = 0;
+    struct iovec iov = { &byte, sizeof(byte) };
+
+    union {
+        struct cmsghdr header;
+        char buffer[CMSG_SPACE(sizeof(int) * 2)];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int) * 2);
+
+    int fds[2] = { STDOUT_FILENO, STDERR_FILENO };
+    memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+    bool valid = (::sendmsg(connection, &message, SEND_FLAGS) == 1);
+
+    /*
+     * Send the request.
+     */
+    valid = valid && WriteString(connection, name) && WriteString(connection, context->currentDirectory());
+
+    valid = valid && WriteInteger(connection, static_cast<uint32_t>(context->commandLineArguments().size()));
+    for (std::string const &argument : context->commandLineArguments()) {
+        valid = valid && WriteString(connection, argument);
+    }
+
+    valid = valid && WriteInteger(connection, static_cast<uint32_t>(context->environmentVariables().size()));
+    for (auto const &entry : context->environmentVariables()) {
+        valid = valid && WriteString(connection, entry.first) && WriteString(connection, entry.second);
+    }
+
+    /*
+     * Wait for the builtin to finish.
+     */
+    uint32_t exitCode;
+    valid = valid && ReadInteger(connection, &exitCode);
+
+    ::close(connection);
+
+    if (!valid) {
+        /* The server could have run part of the builtin, so don't retry. */
+        fprintf(stderr, "error: lost connection to builtin server\n");
+        return 1;
+    }
+
+    return static_cast<int>(exitCode);
+}
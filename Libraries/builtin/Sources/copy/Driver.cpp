@@ -11,10 +11,12 @@
 #include <builtin/copy/Options.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 #include <process/Context.h>
-#include <process/MemoryContext.h>
-#include <process/Launcher.h>
 
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
 #include <unordered_set>
 
 using builtin::copy::Driver;
@@ -38,41 +40,41 @@ name()
     return "builtin-copy";
 }
 
+/*
+ * If a file was already copied: the output has the same contents and is as
+ * executable as the input. It's left alone, so it keeps its modification
+ * time and whatever uses it isn't rebuilt.
+ */
 static bool
-CopyPath(Filesystem *filesystem, std::string const &inputPath, std::string const &outputPath)
+CopyUnchanged(Filesystem const *filesystem, std::string const &inputPath, std::string const &outputPath)
 {
-    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(outputPath))) {
+    if (filesystem->isSymbolicLink(inputPath) || filesystem->isDirectory(inputPath)) {
+        return false;
+    }
+
+    if (filesystem->isSymbolicLink(outputPath) || filesystem->isDirectory(outputPath) || !filesystem->exists(outputPath)) {
         return false;
     }
 
-    // TODO: This shouldn't use external tools to copy.
-    process::Context const *context = process::Context::GetDefaultUNSAFE();
-    process::Launcher *launcher = process::Launcher::GetDefaultUNSAFE();
-
-    process::MemoryContext cp = process::MemoryContext(
-        "/bin/cp",
-        context->currentDirectory(),
-        { "-R", inputPath, outputPath },
-        context->environmentVariables(),
-        context->userID(),
-        context->groupID(),
-        context->userName(),
-        context->groupName());
-    if (launcher->launch(filesystem, &cp).value_or(-1) != 0) {
+    if (filesystem->isExecutable(inputPath) != filesystem->isExecutable(outputPath)) {
         return false;
     }
 
-    /* Should preserve permissions but make writable. */
-    process::MemoryContext chmod = process::MemoryContext(
-        "/bin/chmod",
-        context->currentDirectory(),
-        { "-R", "+w", outputPath },
-        context->environmentVariables(),
-        context->userID(),
-        context->groupID(),
-        context->userName(),
-        context->groupName());
-    if (launcher->launch(filesystem, &chmod).value_or(-1) != 0) {
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    return (filesystem->read(&input, inputPath) && filesystem->read(&output, outputPath) && input == output);
+}
+
+static bool
+CopyPath(Filesystem *filesystem, std::string const &inputPath, std::string const &outputPath)
+{
+    if (CopyUnchanged(filesystem, inputPath, outputPath)) {
+        return true;
+    }
+
+    /* Copies keep their permissions, but are made writable. */
+    if (!filesystem->copyRecursive(inputPath, outputPath)) {
+        fprintf(stderr, "error: unable to copy %s to %s\n", inputPath.c_str(), outputPath.c_str());
         return false;
     }
 
@@ -101,6 +103,7 @@ Run(Filesystem *filesystem, Options const &options, std::string const &workingDi
     std::string const &output = FSUtil::ResolveRelativePath(*options.output(), workingDirectory);
     auto excludes = std::unordered_set<std::string>(options.excludes().begin(), options.excludes().end());
 
+    std::vector<std::string> inputs;
     for (std::string input : options.inputs()) {
         input = FSUtil::ResolveRelativePath(input, workingDirectory);
 
@@ -121,13 +124,40 @@ Run(Filesystem *filesystem, Options const &options, std::string const &workingDi
             printf("verbose: copying %s -> %s\n", input.c_str(), output.c_str());
         }
 
-        std::string outputPath = output + "/" + FSUtil::GetBaseName(input);
-        if (!CopyPath(filesystem, input, outputPath)) {
-            return 1;
-        }
+        inputs.push_back(input);
+    }
+
+    if (inputs.empty()) {
+        return 0;
     }
 
-    return 0;
+    if (!filesystem->createDirectory(output)) {
+        fprintf(stderr, "error: unable to create directory %s\n", output.c_str());
+        return 1;
+    }
+
+    /*
+     * Inputs with the same name copy to the same output, where the last one
+     * wins. Only copy that one, so copies don't overlap.
+     */
+    std::unordered_map<std::string, size_t> last;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        last[FSUtil::GetBaseName(inputs[i])] = i;
+    }
+
+    /*
+     * Copies are independent, and there can be thousands of them, such as for
+     * a framework's headers, so copy in parallel.
+     */
+    std::vector<char> copied = std::vector<char>(inputs.size(), true);
+    libutil::Parallel::For(inputs.size(), [&](size_t index) {
+        std::string name = FSUtil::GetBaseName(inputs[index]);
+        if (last.at(name) == index) {
+            copied[index] = CopyPath(filesystem, inputs[index], output + "/" + name);
+        }
+    });
+
+    return (std::all_of(copied.begin(), copied.end(), [](char success) { return success; }) ? 0 : 1);
 }
 
 int Driver::
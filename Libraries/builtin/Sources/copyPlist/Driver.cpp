@@ -14,6 +14,10 @@
 #include <libutil/Filesystem.h>
 #include <process/Context.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <functional>
 
 using builtin::copyPlist::Driver;
 using builtin::copyPlist::Options;
@@ -36,6 +40,63 @@ name()
     return "builtin-copyPlist";
 }
 
+namespace {
+
+struct Conversion {
+    std::vector<uint8_t> contents;
+    std::string          error;
+};
+
+}
+
+static Conversion
+Convert(Options const &options, process::Context const *processContext, libutil::Filesystem const *filesystem, std::string const &inputPath, plist::Format::Any const *convertFormat)
+{
+    Conversion conversion;
+
+    /* Read in the input. */
+    std::vector<uint8_t> inputContents;
+    if (!filesystem->read(&inputContents, FSUtil::ResolveRelativePath(inputPath, processContext->currentDirectory()))) {
+        conversion.error = "unable to read input " + inputPath;
+        return conversion;
+    }
+
+    if (convertFormat == nullptr && !options.validate()) {
+        /*
+         * If we aren't converting or validating, don't even bother parsing as a plist.
+         */
+        conversion.contents = std::move(inputContents);
+        return conversion;
+    }
+
+    /* Determine the input format. */
+    std::unique_ptr<plist::Format::Any> inputFormat = plist::Format::Any::Identify(inputContents);
+    if (inputFormat == nullptr) {
+        conversion.error = "input " + inputPath + " is not a plist";
+        return conversion;
+    }
+
+    /* Deserialize the input. */
+    auto deserialize = plist::Format::Any::Deserialize(inputContents, *inputFormat);
+    if (!deserialize.first) {
+        conversion.error = inputPath + ": " + deserialize.second;
+        return conversion;
+    }
+
+    /* Use the conversion format if specified, otherwise use the same as the input. */
+    plist::Format::Any outputFormat = (convertFormat != nullptr ? *convertFormat : *inputFormat);
+
+    /* Serialize the output. */
+    auto serialize = plist::Format::Any::Serialize(deserialize.first.get(), outputFormat);
+    if (serialize.first == nullptr) {
+        conversion.error = inputPath + ": " + serialize.second;
+        return conversion;
+    }
+
+    conversion.contents = std::move(*serialize.first);
+    return conversion;
+}
+
 int Driver::
 run(process::Context const *processContext, libutil::Filesystem *filesystem)
 {
@@ -87,56 +148,27 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
     }
 
     /*
-     * Process each input.
+     * Convert each input. Inputs don't depend on each other, so all of them
+     * are converted in parallel. Outputs are written afterwards, in order,
+     * stopping at the first input that failed.
      */
-    for (std::string const &inputPath : options.inputs()) {
-        /* Read in the input. */
-        std::vector<uint8_t> inputContents;
-        if (!filesystem->read(&inputContents, FSUtil::ResolveRelativePath(inputPath, processContext->currentDirectory()))) {
-            fprintf(stderr, "error: unable to read input %s\n", inputPath.c_str());
+    std::vector<Conversion> conversions = std::vector<Conversion>(options.inputs().size());
+    libutil::Parallel::For(options.inputs().size(), [&](size_t index) {
+        conversions[index] = Convert(options, processContext, filesystem, options.inputs()[index], convertFormat.get());
+    });
+
+    for (size_t i = 0; i < options.inputs().size(); ++i) {
+        Conversion const &conversion = conversions[i];
+        if (!conversion.error.empty()) {
+            fprintf(stderr, "error: %s\n", conversion.error.c_str());
             return 1;
         }
 
-        std::vector<uint8_t> outputContents;
-
-        if (convertFormat == nullptr && !options.validate()) {
-            /*
-             * If we aren't converting or validating, don't even bother parsing as a plist.
-             */
-            outputContents = inputContents;
-        } else {
-            /* Determine the input format. */
-            std::unique_ptr<plist::Format::Any> inputFormat = plist::Format::Any::Identify(inputContents);
-            if (inputFormat == nullptr) {
-                fprintf(stderr, "error: input %s is not a plist\n", inputPath.c_str());
-                return 1;
-            }
-
-            /* Deserialize the input. */
-            auto deserialize = plist::Format::Any::Deserialize(inputContents, *inputFormat);
-            if (!deserialize.first) {
-                fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), deserialize.second.c_str());
-                return 1;
-            }
-
-            /* Use the conversion format if specified, otherwise use the same as the input. */
-            plist::Format::Any outputFormat = (convertFormat != nullptr ? *convertFormat : *inputFormat);
-
-            /* Serialize the output. */
-            auto serialize = plist::Format::Any::Serialize(deserialize.first.get(), outputFormat);
-            if (serialize.first == nullptr) {
-                fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), serialize.second.c_str());
-                return 1;
-            }
-
-            outputContents = *serialize.first;
-        }
-
         /* Output to the same name as the input, but in the output directory. */
-        std::string outputPath = FSUtil::ResolveRelativePath(*options.outputDirectory(), processContext->currentDirectory()) + "/" + FSUtil::GetBaseName(inputPath);
+        std::string outputPath = FSUtil::ResolveRelativePath(*options.outputDirectory(), processContext->currentDirectory()) + "/" + FSUtil::GetBaseName(options.inputs()[i]);
 
         /* Write out the output. */
-        if (!filesystem->write(outputContents, outputPath)) {
+        if (!filesystem->writeIfChanged(conversion.contents, outputPath)) {
             fprintf(stderr, "error: could not open output path %s to write\n", outputPath.c_str());
             return 1;
         }
@@ -18,8 +18,12 @@
 #include <plist/Format/Encoding.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 #include <process/Context.h>
 
+#include <algorithm>
+#include <functional>
+
 #include <strings.h>
 
 using builtin::copyStrings::Driver;
@@ -111,6 +115,65 @@ ValidateOptions(Options const &options)
     return true;
 }
 
+namespace {
+
+struct Conversion {
+    std::vector<uint8_t> contents;
+    std::string          error;
+};
+
+}
+
+static Conversion
+Convert(Options const &options, process::Context const *processContext, libutil::Filesystem const *filesystem, std::string const &inputPath, plist::Format::Any const *inputEncodingFormat, plist::Format::Any const &outputFormat)
+{
+    Conversion conversion;
+
+    /* Read in the input. */
+    std::string resolvedInputPath = FSUtil::ResolveRelativePath(inputPath, processContext->currentDirectory());
+    std::vector<uint8_t> inputContents;
+    if (!filesystem->read(&inputContents, resolvedInputPath)) {
+        conversion.error = "unable to read input " + inputPath;
+        return conversion;
+    }
+
+    /* Determine the input format. */
+    std::unique_ptr<plist::Format::Any> inputFormat = plist::Format::Any::Identify(inputContents);
+    if (inputFormat == nullptr) {
+        conversion.error = "input " + inputPath + " is not a plist";
+        return conversion;
+    }
+
+    /* If no input format was specified, use the detected strings encoding. */
+    plist::Format::Any resolvedInputFormat = (inputEncodingFormat != nullptr ? *inputEncodingFormat : *inputFormat);
+
+    /* Deserialize the input. */
+    auto deserialize = plist::Format::Any::Deserialize(inputContents, resolvedInputFormat);
+    if (!deserialize.first) {
+        conversion.error = inputPath + ": " + deserialize.second;
+        return conversion;
+    }
+
+    /* If requested, validate the strings file is valid. */
+    if (options.validate()) {
+        auto validation = ValidateStrings(deserialize.first.get());
+        if (!validation.first) {
+            conversion.error = inputPath + ": " + validation.second;
+            return conversion;
+        }
+    }
+
+    /* Serialize the output. */
+    auto serialize = plist::Format::Any::Serialize(deserialize.first.get(), outputFormat);
+    if (serialize.first == nullptr) {
+        conversion.error = inputPath + ": " + serialize.second;
+        return conversion;
+    }
+
+    conversion.contents = std::move(*serialize.first);
+    return conversion;
+}
+
 int Driver::
 run(process::Context const *processContext, libutil::Filesystem *filesystem)
 {
@@ -138,58 +201,41 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
     }
 
     /*
-     * Process each input.
+     * Determine input encoding, if specified. Otherwise, each input's detected encoding is used.
      */
-    for (std::string const &inputPath : options.inputs()) {
-        /* Read in the input. */
-        std::string resolvedInputPath = FSUtil::ResolveRelativePath(inputPath, processContext->currentDirectory());
-        std::vector<uint8_t> inputContents;
-        if (!filesystem->read(&inputContents, resolvedInputPath)) {
-            fprintf(stderr, "error: unable to read input %s\n", inputPath.c_str());
-            return 1;
-        }
-
-        /* Determine the input format. */
-        std::unique_ptr<plist::Format::Any> inputFormat = plist::Format::Any::Identify(inputContents);
-        if (inputFormat == nullptr) {
-            fprintf(stderr, "error: input %s is not a plist\n", inputPath.c_str());
-            return 1;
-        }
-
-        /* If no input format was specified, use the detected strings encoding. */
-        plist::Format::Any resolvedInputFormat = *inputFormat;
-        if (options.inputEncoding() && !ParseStringsEncoding(*options.inputEncoding(), &resolvedInputFormat)) {
+    std::unique_ptr<plist::Format::Any> inputEncodingFormat = nullptr;
+    if (options.inputEncoding()) {
+        plist::Format::Any format = outputFormat;
+        if (!ParseStringsEncoding(*options.inputEncoding(), &format)) {
             fprintf(stderr, "error: invalid input encoding '%s'\n", options.inputEncoding()->c_str());
             return -1;
         }
+        inputEncodingFormat = std::unique_ptr<plist::Format::Any>(new plist::Format::Any(format));
+    }
 
-        /* Deserialize the input. */
-        auto deserialize = plist::Format::Any::Deserialize(inputContents, resolvedInputFormat);
-        if (!deserialize.first) {
-            fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), deserialize.second.c_str());
+    /*
+     * Convert each input. Inputs don't depend on each other, so all of them
+     * are converted in parallel. Outputs are written afterwards, in order,
+     * stopping at the first input that failed.
+     */
+    std::vector<Conversion> conversions = std::vector<Conversion>(options.inputs().size());
+    libutil::Parallel::For(options.inputs().size(), [&](size_t index) {
+        conversions[index] = Convert(options, processContext, filesystem, options.inputs()[index], inputEncodingFormat.get(), outputFormat);
+    });
+
+    for (size_t i = 0; i < options.inputs().size(); ++i) {
+        std::string const &inputPath = options.inputs()[i];
+        Conversion const &conversion = conversions[i];
+        if (!conversion.error.empty()) {
+            fprintf(stderr, "error: %s\n", conversion.error.c_str());
             return 1;
         }
 
-        /* If requested, validate the strings file is valid. */
-        if (options.validate()) {
-            auto validation = ValidateStrings(deserialize.first.get());
-            if (!validation.first) {
-                fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), validation.second.c_str());
-                return 1;
-            }
-        }
-
         /* Output to the same name as the input, but in the output directory. */
         std::string outputPath = FSUtil::ResolveRelativePath(*options.outputDirectory(), processContext->currentDirectory()) + "/" + FSUtil::GetBaseName(inputPath);
 
         /* Write out the output. */
-        auto serialize = plist::Format::Any::Serialize(deserialize.first.get(), outputFormat);
-        if (serialize.first == nullptr) {
-            fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), serialize.second.c_str());
-            return 1;
-        }
-
-        if (!filesystem->write(*serialize.first, outputPath)) {
+        if (!filesystem->writeIfChanged(conversion.contents, outputPath)) {
             fprintf(stderr, "error: %s: could not write output\n", inputPath.c_str());
             return 1;
         }
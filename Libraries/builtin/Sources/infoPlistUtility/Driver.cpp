@@ -9,6 +9,9 @@
 
 #include <builtin/infoPlistUtility/Driver.h>
 #include <builtin/infoPlistUtility/Options.h>
+#include <builtin/infoPlistUtility/Preprocessor.h>
+#include <dependency/DependencyInfo.h>
+#include <dependency/MakefileDependencyInfo.h>
 #include <pbxsetting/Environment.h>
 #include <pbxsetting/Setting.h>
 #include <pbxsetting/Type.h>
@@ -24,10 +27,16 @@
 #include <plist/Format/XML.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 #include <process/Context.h>
 
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
 using builtin::infoPlistUtility::Driver;
 using builtin::infoPlistUtility::Options;
+using builtin::infoPlistUtility::Preprocessor;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
@@ -67,7 +76,7 @@ WritePkgInfo(Filesystem *filesystem, plist::Dictionary const *root, std::string
     }
 
     auto pkgInfoContents = std::vector<uint8_t>(pkgInfo.begin(), pkgInfo.end());
-    if (!filesystem->write(pkgInfoContents, path)) {
+    if (!filesystem->writeIfChanged(pkgInfoContents, path)) {
         return std::make_pair(false, "could write to " + path);
     }
 
@@ -75,22 +84,32 @@ WritePkgInfo(Filesystem *filesystem, plist::Dictionary const *root, std::string
 }
 
 static void
-ExpandBuildSettings(plist::Object *value, pbxsetting::Environment const &environment)
+ExpandBuildSettings(plist::Object *value, pbxsetting::Environment const &environment, std::unordered_map<std::string, std::string> *expanded)
 {
     /*
      * Recursively expand any strings in the plist. Dictionary keys are not expanded.
      */
     if (auto dictionary = plist::CastTo<plist::Dictionary>(value)) {
         for (size_t n = 0; n < dictionary->count(); n++) {
-            ExpandBuildSettings(dictionary->value(n), environment);
+            ExpandBuildSettings(dictionary->value(n), environment, expanded);
         }
     } else if (auto array = plist::CastTo<plist::Array>(value)) {
         for (size_t n = 0; n < array->count(); n++) {
-            ExpandBuildSettings(array->value(n), environment);
+            ExpandBuildSettings(array->value(n), environment, expanded);
         }
     } else if (auto string = plist::CastTo<plist::String>(value)) {
-        pbxsetting::Value parsed = pbxsetting::Value::Parse(string->value());
-        string->setValue(environment.expand(parsed));
+        /* Only strings referencing a setting change; most don't. */
+        if (string->value().find('$') == std::string::npos) {
+            return;
+        }
+
+        /* The same references, like `$(PRODUCT_NAME)`, are repeated often. */
+        auto it = expanded->find(string->value());
+        if (it == expanded->end()) {
+            pbxsetting::Value parsed = pbxsetting::Value::Parse(string->value());
+            it = expanded->insert({ string->value(), environment.expand(parsed) }).first;
+        }
+        string->setValue(it->second);
     }
 }
 
@@ -138,6 +157,36 @@ AddBuildEnvironment(plist::Dictionary *root, pbxsetting::Environment const &envi
     }
 }
 
+namespace {
+
+struct AdditionalContent {
+    std::unique_ptr<plist::Object> contents;
+    std::string                    error;
+};
+
+}
+
+static AdditionalContent
+ReadAdditionalContent(Filesystem const *filesystem, std::string const &path, std::string const &additionalContentFile)
+{
+    AdditionalContent additionalContent;
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        additionalContent.error = "unable to read additional content file: " + additionalContentFile;
+        return additionalContent;
+    }
+
+    auto deserialize = plist::Format::Any::Deserialize(contents);
+    if (deserialize.first == nullptr) {
+        additionalContent.error = "unable to parse additional content file " + additionalContentFile + ": " + deserialize.second;
+        return additionalContent;
+    }
+
+    additionalContent.contents = std::move(deserialize.first);
+    return additionalContent;
+}
+
 static pbxsetting::Environment
 CreateBuildEnvironment(std::unordered_map<std::string, std::string> const &environment)
 {
@@ -178,12 +227,43 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
     pbxsetting::Environment settingsEnvironment = CreateBuildEnvironment(processContext->environmentVariables());
 
     /* Read in the input. */
+    std::string inputPath = FSUtil::ResolveRelativePath(*options.input(), processContext->currentDirectory());
     std::vector<uint8_t> inputContents;
-    if (!filesystem->read(&inputContents, FSUtil::ResolveRelativePath(*options.input(), processContext->currentDirectory()))) {
+    if (!filesystem->read(&inputContents, inputPath)) {
         fprintf(stderr, "error: unable to read input %s\n", options.input()->c_str());
         return 1;
     }
 
+    /*
+     * Preprocess the input in memory, rather than running the C preprocessor
+     * in a separate process. Only the macros from the prefix header are kept.
+     */
+    std::vector<std::string> includes;
+    if (options.preprocess()) {
+        Preprocessor preprocessor = Preprocessor(filesystem);
+        for (std::string const &definition : options.definitions()) {
+            preprocessor.define(definition);
+        }
+
+        if (options.prefixHeader()) {
+            auto result = preprocessor.include(FSUtil::ResolveRelativePath(*options.prefixHeader(), processContext->currentDirectory()), nullptr);
+            if (!result.first) {
+                fprintf(stderr, "error: %s\n", result.second.c_str());
+                return 1;
+            }
+        }
+
+        std::string output;
+        auto result = preprocessor.process(inputPath, std::string(inputContents.begin(), inputContents.end()), false, &output);
+        if (!result.first) {
+            fprintf(stderr, "error: %s\n", result.second.c_str());
+            return 1;
+        }
+
+        inputContents = std::vector<uint8_t>(output.begin(), output.end());
+        includes = preprocessor.includes();
+    }
+
     /* Determine the input format. */
     std::unique_ptr<plist::Format::Any> inputFormat = plist::Format::Any::Identify(inputContents);
     if (inputFormat == nullptr) {
@@ -209,27 +289,28 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
      * and strings. The resolved build setting values are passed through the environment.
      */
     if (options.expandBuildSettings()) {
-        ExpandBuildSettings(root, settingsEnvironment);
+        std::unordered_map<std::string, std::string> expanded;
+        ExpandBuildSettings(root, settingsEnvironment, &expanded);
     }
 
     /*
      * Process additional content files. These are plists that get merged with the
      * main Info.plist at the top level.
      */
-    for (std::string const &additionalContentFile : options.additionalContentFiles()) {
-        std::vector<uint8_t> contents;
-        if (!filesystem->read(&contents, FSUtil::ResolveRelativePath(additionalContentFile, processContext->currentDirectory()))) {
-            fprintf(stderr, "error: unable to read additional content file: %s\n", additionalContentFile.c_str());
+    std::vector<std::string> const &additionalContentFiles = options.additionalContentFiles();
+    std::vector<AdditionalContent> additionalContents = std::vector<AdditionalContent>(additionalContentFiles.size());
+    libutil::Parallel::For(additionalContentFiles.size(), [&](size_t index) {
+        additionalContents[index] = ReadAdditionalContent(filesystem, FSUtil::ResolveRelativePath(additionalContentFiles[index], processContext->currentDirectory()), additionalContentFiles[index]);
+    });
+
+    /* Merged in order, as later files replace the entries of earlier ones. */
+    for (AdditionalContent const &additionalContent : additionalContents) {
+        if (additionalContent.contents == nullptr) {
+            fprintf(stderr, "error: %s\n", additionalContent.error.c_str());
             return 1;
         }
 
-        auto additionalContent = plist::Format::Any::Deserialize(contents);
-        if (additionalContent.first == nullptr) {
-            fprintf(stderr, "error: unable to parse additional content file %s: %s\n", additionalContentFile.c_str(), additionalContent.second.c_str());
-            return 1;
-        }
-
-        if (plist::Dictionary *dictionary = plist::CastTo<plist::Dictionary>(additionalContent.first.get())) {
+        if (plist::Dictionary *dictionary = plist::CastTo<plist::Dictionary>(additionalContent.contents.get())) {
             /* Pass true to replace existing entries. */
             root->merge(dictionary, true);
         }
@@ -281,7 +362,7 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
                 return 1;
             }
 
-            if (!filesystem->write(contents, FSUtil::ResolveRelativePath(*options.resourceRulesFile(), processContext->currentDirectory()))) {
+            if (!filesystem->writeIfChanged(contents, FSUtil::ResolveRelativePath(*options.resourceRulesFile(), processContext->currentDirectory()))) {
                 fprintf(stderr, "error: could not open output path %s to write\n", options.resourceRulesFile()->c_str());
                 return 1;
             }
@@ -313,10 +394,27 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
     }
 
     /* Write out the output. */
-    if (!filesystem->write(*serialize.first, FSUtil::ResolveRelativePath(*options.output(), processContext->currentDirectory()))) {
+    std::string outputPath = FSUtil::ResolveRelativePath(*options.output(), processContext->currentDirectory());
+    if (!filesystem->writeIfChanged(*serialize.first, outputPath)) {
         fprintf(stderr, "error: could not open output path %s to write\n", options.output()->c_str());
         return 1;
     }
 
+    /* Record the headers read while preprocessing, so changes to them rebuild. */
+    if (options.dependencyFile()) {
+        std::vector<std::string> inputs = { inputPath };
+        inputs.insert(inputs.end(), includes.begin(), includes.end());
+
+        dependency::MakefileDependencyInfo dependencyInfo;
+        dependencyInfo.dependencyInfo().push_back(dependency::DependencyInfo(inputs, { outputPath }));
+
+        std::string serialized = dependencyInfo.serialize();
+        std::string dependencyFilePath = FSUtil::ResolveRelativePath(*options.dependencyFile(), processContext->currentDirectory());
+        if (!filesystem->createDirectory(FSUtil::GetDirectoryName(dependencyFilePath)) || !filesystem->writeIfChanged(std::vector<uint8_t>(serialized.begin(), serialized.end()), dependencyFilePath)) {
+            fprintf(stderr, "error: could not open dependency file %s to write\n", options.dependencyFile()->c_str());
+            return 1;
+        }
+    }
+
     return 0;
 }
@@ -32,6 +32,15 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Next<std::string>(&_resourceRulesFile, args, it);
     } else if (arg == "-expandbuildsettings") {
         return libutil::Options::Current<bool>(&_expandBuildSettings, arg, it);
+    } else if (arg == "-preprocess") {
+        return libutil::Options::Current<bool>(&_preprocess, arg, it);
+    } else if (arg == "-prefixheader") {
+        return libutil::Options::Next<std::string>(&_prefixHeader, args, it);
+    } else if (arg == "-dependencyfile") {
+        return libutil::Options::Next<std::string>(&_dependencyFile, args, it);
+    } else if (arg.compare(0, 2, "-D") == 0 && arg.size() > 2) {
+        _definitions.push_back(arg.substr(2));
+        return std::make_pair(true, std::string());
     } else if (arg == "-format") {
         return libutil::Options::Next<std::string>(&_format, args, it);
     } else if (arg == "-platform") {
@@ -0,0 +1,830 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <builtin/infoPlistUtility/Preprocessor.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+using builtin::infoPlistUtility::Preprocessor;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+/* Deeper includes are assumed to be a cycle. */
+static size_t const MaximumIncludeDepth = 200;
+
+Preprocessor::
+Preprocessor(Filesystem const *filesystem) :
+    _filesystem(filesystem),
+    _depth     (0)
+{
+}
+
+static bool
+IsIdentifierStart(char c)
+{
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+static bool
+IsIdentifier(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+static std::string
+Trim(std::string const &string)
+{
+    std::string::size_type start = string.find_first_not_of(" \t\r");
+    if (start == std::string::npos) {
+        return std::string();
+    }
+
+    std::string::size_type end = string.find_last_not_of(" \t\r");
+    return string.substr(start, end - start + 1);
+}
+
+/*
+ * Skip a string literal starting at `i`, returning the index after it. An
+ * unterminated string ends at the end of the line.
+ */
+static size_t
+SkipString(std::string const &text, size_t i)
+{
+    for (i++; i < text.size() && text[i] != '"' && text[i] != '\n'; i++) {
+        if (text[i] == '\\' && i + 1 < text.size() && text[i + 1] != '\n') {
+            i++;
+        }
+    }
+
+    return (i < text.size() && text[i] == '"' ? i + 1 : i);
+}
+
+/*
+ * Join continued lines, and replace comments with a space. Newlines in
+ * block comments are kept, and the newlines of continued lines are added
+ * after the line they join, so lines stay where they were.
+ */
+static std::string
+StripComments(std::string const &text, bool lineComments)
+{
+    std::string result;
+    result.reserve(text.size());
+
+    size_t continued = 0;
+    auto newline = [&]() {
+        result.append(1 + continued, '\n');
+        continued = 0;
+    };
+
+    for (size_t i = 0; i < text.size();) {
+        if (text[i] == '\\' && i + 1 < text.size() && text[i + 1] == '\n') {
+            continued++;
+            i += 2;
+        } else if (text[i] == '"') {
+            size_t end = SkipString(text, i);
+            result.append(text, i, end - i);
+            i = end;
+        } else if (text.compare(i, 2, "/*") == 0) {
+            std::string::size_type end = text.find("*/", i + 2);
+            end = (end == std::string::npos ? text.size() : end + 2);
+
+            result += ' ';
+            for (size_t j = i; j < end; j++) {
+                if (text[j] == '\n') {
+                    newline();
+                }
+            }
+            i = end;
+        } else if (lineComments && text.compare(i, 2, "//") == 0) {
+            std::string::size_type end = text.find('\n', i);
+            i = (end == std::string::npos ? text.size() : end);
+        } else if (text[i] == '\n') {
+            newline();
+            i++;
+        } else {
+            result += text[i++];
+        }
+    }
+
+    if (continued > 0) {
+        result.append(continued, '\n');
+    }
+
+    return result;
+}
+
+/*
+ * Split macro arguments at top-level commas. Returns the index after the
+ * closing parenthesis, or nothing if the arguments aren't closed.
+ */
+static ext::optional<size_t>
+ParseArguments(std::string const &text, size_t open, std::vector<std::string> *arguments)
+{
+    size_t depth = 0;
+    std::string argument;
+
+    for (size_t i = open + 1; i < text.size();) {
+        char c = text[i];
+        if (c == '"') {
+            size_t end = SkipString(text, i);
+            argument.append(text, i, end - i);
+            i = end;
+            continue;
+        }
+
+        if (c == '(') {
+            depth++;
+        } else if (c == ')' && depth > 0) {
+            depth--;
+        } else if (c == ')') {
+            arguments->push_back(Trim(argument));
+            return i + 1;
+        } else if (c == ',' && depth == 0) {
+            arguments->push_back(Trim(argument));
+            argument.clear();
+            i++;
+            continue;
+        }
+
+        argument += c;
+        i++;
+    }
+
+    return ext::nullopt;
+}
+
+std::string Preprocessor::
+expand(std::string const &text, std::unordered_set<std::string> const &disabled) const
+{
+    std::string result;
+    result.reserve(text.size());
+
+    for (size_t i = 0; i < text.size();) {
+        char c = text[i];
+
+        if (c == '"') {
+            /* Macros aren't expanded in strings. */
+            size_t end = SkipString(text, i);
+            result.append(text, i, end - i);
+            i = end;
+        } else if (std::isdigit(static_cast<unsigned char>(c))) {
+            /* Nor in numbers, like the `e5` in `1.0e5`. */
+            size_t end = i;
+            while (end < text.size() && (IsIdentifier(text[end]) || text[end] == '.')) {
+                end++;
+            }
+            result.append(text, i, end - i);
+            i = end;
+        } else if (IsIdentifierStart(c)) {
+            size_t end = i;
+            while (end < text.size() && IsIdentifier(text[end])) {
+                end++;
+            }
+            std::string name = text.substr(i, end - i);
+
+            auto it = _macros.find(name);
+            if (it == _macros.end() || disabled.find(name) != disabled.end()) {
+                result += name;
+                i = end;
+                continue;
+            }
+
+            /* A macro isn't expanded again inside its own expansion. */
+            std::unordered_set<std::string> inner = disabled;
+            inner.insert(name);
+
+            Macro const &macro = it->second;
+            if (!macro.parameters) {
+                result += expand(macro.body, inner);
+                i = end;
+                continue;
+            }
+
+            /* Function-like macros without arguments are left alone. */
+            size_t open = end;
+            while (open < text.size() && (text[open] == ' ' || text[open] == '\t')) {
+                open++;
+            }
+
+            std::vector<std::string> arguments;
+            ext::optional<size_t> close;
+            if (open < text.size() && text[open] == '(') {
+                close = ParseArguments(text, open, &arguments);
+            }
+            if (!close) {
+                result += name;
+                i = end;
+                continue;
+            }
+
+            /* `F()` has one empty argument, but no arguments for no parameters. */
+            if (macro.parameters->empty() && arguments.size() == 1 && arguments.front().empty()) {
+                arguments.clear();
+            }
+
+            if (arguments.size() != macro.parameters->size()) {
+                result.append(text, i, *close - i);
+                i = *close;
+                continue;
+            }
+
+            /* Arguments are expanded before they're substituted. */
+            std::string substituted;
+            std::string const &body = macro.body;
+            for (size_t j = 0; j < body.size();) {
+                if (body[j] == '"') {
+                    size_t stringEnd = SkipString(body, j);
+                    substituted.append(body, j, stringEnd - j);
+                    j = stringEnd;
+                } else if (IsIdentifierStart(body[j])) {
+                    size_t identifierEnd = j;
+                    while (identifierEnd < body.size() && IsIdentifier(body[identifierEnd])) {
+                        identifierEnd++;
+                    }
+                    std::string identifier = body.substr(j, identifierEnd - j);
+
+                    auto parameter = std::find(macro.parameters->begin(), macro.parameters->end(), identifier);
+                    if (parameter != macro.parameters->end()) {
+                        substituted += expand(arguments[parameter - macro.parameters->begin()], disabled);
+                    } else {
+                        substituted += identifier;
+                    }
+                    j = identifierEnd;
+                } else {
+                    substituted += body[j++];
+                }
+            }
+
+            result += expand(substituted, inner);
+            i = *close;
+        } else {
+            result += c;
+            i++;
+        }
+    }
+
+    return result;
+}
+
+bool Preprocessor::
+defineDirective(std::string const &text)
+{
+    size_t end = 0;
+    while (end < text.size() && IsIdentifier(text[end])) {
+        end++;
+    }
+    if (end == 0 || !IsIdentifierStart(text[0])) {
+        return false;
+    }
+
+    Macro macro;
+    std::string name = text.substr(0, end);
+
+    /* Only a parenthesis right after the name makes a function-like macro. */
+    if (end < text.size() && text[end] == '(') {
+        std::string::size_type close = text.find(')', end);
+        if (close == std::string::npos) {
+            return false;
+        }
+
+        std::vector<std::string> parameters;
+        std::string list = Trim(text.substr(end + 1, close - end - 1));
+        if (!list.empty()) {
+            std::string::size_type start = 0;
+            while (true) {
+                std::string::size_type comma = list.find(',', start);
+                std::string parameter = Trim(list.substr(start, comma == std::string::npos ? std::string::npos : comma - start));
+                if (parameter.empty() || !IsIdentifierStart(parameter[0])) {
+                    return false;
+                }
+                parameters.push_back(parameter);
+
+                if (comma == std::string::npos) {
+                    break;
+                }
+                start = comma + 1;
+            }
+        }
+
+        macro.parameters = parameters;
+        end = close + 1;
+    }
+
+    macro.body = Trim(text.substr(end));
+    _macros[name] = macro;
+    return true;
+}
+
+void Preprocessor::
+define(std::string const &definition)
+{
+    std::string::size_type equals = definition.find('=');
+    if (equals == std::string::npos) {
+        defineDirective(definition + " 1");
+    } else {
+        defineDirective(definition.substr(0, equals) + " " + definition.substr(equals + 1));
+    }
+}
+
+namespace {
+
+/*
+ * Evaluates the integer expressions of conditionals, after macros and
+ * `defined` are replaced. Identifiers left over are zero.
+ */
+class Expression {
+private:
+    std::string const &_text;
+    size_t             _offset;
+    std::string        _error;
+
+public:
+    explicit Expression(std::string const &text) :
+        _text  (text),
+        _offset(0)
+    {
+    }
+
+public:
+    std::string const &error() const
+    { return _error; }
+
+public:
+    int64_t parse()
+    {
+        int64_t value = conditional();
+        skip();
+        if (_error.empty() && _offset != _text.size()) {
+            _error = "unexpected '" + _text.substr(_offset) + "' in expression";
+        }
+        return value;
+    }
+
+private:
+    void skip()
+    {
+        while (_offset < _text.size() && std::isspace(static_cast<unsigned char>(_text[_offset]))) {
+            _offset++;
+        }
+    }
+
+    bool consume(char const *token)
+    {
+        skip();
+        size_t length = strlen(token);
+        if (_text.compare(_offset, length, token) != 0) {
+            return false;
+        }
+
+        /* Don't take the start of a longer operator, like `<` from `<<`. */
+        if (length == 1 && _offset + 1 < _text.size()) {
+            char next = _text[_offset + 1];
+            if ((token[0] == '<' || token[0] == '>') && (next == token[0] || next == '=')) {
+                return false;
+            }
+            if ((token[0] == '&' || token[0] == '|') && next == token[0]) {
+                return false;
+            }
+            if ((token[0] == '!' || token[0] == '=') && next == '=') {
+                return false;
+            }
+        }
+
+        _offset += length;
+        return true;
+    }
+
+    int64_t conditional()
+    {
+        int64_t condition = logicalOr();
+        if (consume("?")) {
+            int64_t whenTrue = conditional();
+            if (!consume(":")) {
+                _error = "expected ':' in expression";
+                return 0;
+            }
+            int64_t whenFalse = conditional();
+            return (condition ? whenTrue : whenFalse);
+        }
+        return condition;
+    }
+
+    int64_t logicalOr()
+    {
+        int64_t value = logicalAnd();
+        while (consume("||")) {
+            int64_t right = logicalAnd();
+            value = (value || right);
+        }
+        return value;
+    }
+
+    int64_t logicalAnd()
+    {
+        int64_t value = bitwiseOr();
+        while (consume("&&")) {
+            int64_t right = bitwiseOr();
+            value = (value && right);
+        }
+        return value;
+    }
+
+    int64_t bitwiseOr()
+    {
+        int64_t value = bitwiseXor();
+        while (consume("|")) {
+            value |= bitwiseXor();
+        }
+        return value;
+    }
+
+    int64_t bitwiseXor()
+    {
+        int64_t value = bitwiseAnd();
+        while (consume("^")) {
+            value ^= bitwiseAnd();
+        }
+        return value;
+    }
+
+    int64_t bitwiseAnd()
+    {
+        int64_t value = equality();
+        while (consume("&")) {
+            value &= equality();
+        }
+        return value;
+    }
+
+    int64_t equality()
+    {
+        int64_t value = relational();
+        while (true) {
+            if (consume("==")) {
+                value = (value == relational());
+            } else if (consume("!=")) {
+                value = (value != relational());
+            } else {
+                return value;
+            }
+        }
+    }
+
+    int64_t relational()
+    {
+        int64_t value = shift();
+        while (true) {
+            if (consume("<=")) {
+                value = (value <= shift());
+            } else if (consume(">=")) {
+                value = (value >= shift());
+            } else if (consume("<")) {
+                value = (value < shift());
+            } else if (consume(">")) {
+                value = (value > shift());
+            } else {
+                return value;
+            }
+        }
+    }
+
+    int64_t shift()
+    {
+        int64_t value = additive();
+        while (true) {
+            if (consume("<<")) {
+                value = static_cast<int64_t>(static_cast<uint64_t>(value) << (additive() & 63));
+            } else if (consume(">>")) {
+                value >>= (additive() & 63);
+            } else {
+                return value;
+            }
+        }
+    }
+
+    int64_t additive()
+    {
+        int64_t value = multiplicative();
+        while (true) {
+            if (consume("+")) {
+                value += multiplicative();
+            } else if (consume("-")) {
+                value -= multiplicative();
+            } else {
+                return value;
+            }
+        }
+    }
+
+    int64_t multiplicative()
+    {
+        int64_t value = unary();
+        while (true) {
+            if (consume("*")) {
+                value *= unary();
+            } else if (consume("/") || consume("%")) {
+                bool divide = (_text[_offset - 1] == '/');
+                int64_t right = unary();
+                if (right == 0) {
+                    if (_error.empty()) {
+                        _error = "division by zero in expression";
+                    }
+                    return 0;
+                }
+                value = (divide ? value / right : value % right);
+            } else {
+                return value;
+            }
+        }
+    }
+
+    int64_t unary()
+    {
+        if (consume("!")) {
+            return !unary();
+        } else if (consume("~")) {
+            return ~unary();
+        } else if (consume("-")) {
+            return -unary();
+        } else if (consume("+")) {
+            return unary();
+        }
+        return primary();
+    }
+
+    int64_t primary()
+    {
+        skip();
+
+        if (consume("(")) {
+            int64_t value = conditional();
+            if (!consume(")")) {
+                _error = "expected ')' in expression";
+            }
+            return value;
+        }
+
+        if (_offset < _text.size() && std::isdigit(static_cast<unsigned char>(_text[_offset]))) {
+            char const *start = _text.c_str() + _offset;
+            char *end = nullptr;
+            int64_t value = static_cast<int64_t>(strtoull(start, &end, 0));
+            _offset += (end - start);
+
+            /* Integer suffixes don't change the value here. */
+            while (_offset < _text.size() && (_text[_offset] == 'u' || _text[_offset] == 'U' || _text[_offset] == 'l' || _text[_offset] == 'L')) {
+                _offset++;
+            }
+            return value;
+        }
+
+        if (_offset < _text.size() && IsIdentifierStart(_text[_offset])) {
+            while (_offset < _text.size() && IsIdentifier(_text[_offset])) {
+                _offset++;
+            }
+            return 0;
+        }
+
+        if (_error.empty()) {
+            _error = (_offset < _text.size() ? "unexpected '" + _text.substr(_offset) + "' in expression" : "missing value in expression");
+        }
+        _offset = _text.size();
+        return 0;
+    }
+};
+
+}
+
+std::pair<bool, std::string> Preprocessor::
+evaluate(std::string const &expression, bool *result) const
+{
+    /* Replace `defined NAME` and `defined(NAME)` first, so they aren't expanded. */
+    std::string replaced;
+    for (size_t i = 0; i < expression.size();) {
+        if (!IsIdentifierStart(expression[i])) {
+            replaced += expression[i++];
+            continue;
+        }
+
+        size_t end = i;
+        while (end < expression.size() && IsIdentifier(expression[end])) {
+            end++;
+        }
+        std::string identifier = expression.substr(i, end - i);
+        if (identifier != "defined") {
+            replaced += identifier;
+            i = end;
+            continue;
+        }
+
+        size_t j = end;
+        while (j < expression.size() && (expression[j] == ' ' || expression[j] == '\t')) {
+            j++;
+        }
+        bool parenthesized = (j < expression.size() && expression[j] == '(');
+        if (parenthesized) {
+            j++;
+            while (j < expression.size() && (expression[j] == ' ' || expression[j] == '\t')) {
+                j++;
+            }
+        }
+
+        size_t nameEnd = j;
+        while (nameEnd < expression.size() && IsIdentifier(expression[nameEnd])) {
+            nameEnd++;
+        }
+        if (nameEnd == j) {
+            return std::make_pair(false, "expected macro name after defined");
+        }
+        std::string name = expression.substr(j, nameEnd - j);
+
+        if (parenthesized) {
+            while (nameEnd < expression.size() && (expression[nameEnd] == ' ' || expression[nameEnd] == '\t')) {
+                nameEnd++;
+            }
+            if (nameEnd >= expression.size() || expression[nameEnd] != ')') {
+                return std::make_pair(false, "expected ')' after defined(" + name);
+            }
+            nameEnd++;
+        }
+
+        replaced += (defined(name) ? " 1 " : " 0 ");
+        i = nameEnd;
+    }
+
+    std::string expanded = expand(replaced, std::unordered_set<std::string>());
+    Expression parser = Expression(expanded);
+    int64_t value = parser.parse();
+    if (!parser.error().empty()) {
+        return std::make_pair(false, parser.error());
+    }
+
+    *result = (value != 0);
+    return std::make_pair(true, std::string());
+}
+
+std::pair<bool, std::string> Preprocessor::
+directive(std::string const &path, std::string const &line, std::string *output)
+{
+    size_t end = 0;
+    while (end < line.size() && IsIdentifier(line[end])) {
+        end++;
+    }
+    std::string name = line.substr(0, end);
+    std::string rest = Trim(line.substr(end));
+
+    if (name.empty() || name == "pragma" || name == "ident" || name == "line") {
+        /* Nothing to do for these here. */
+        return std::make_pair(true, std::string());
+    } else if (name == "define") {
+        if (!defineDirective(rest)) {
+            return std::make_pair(false, "invalid macro definition: " + rest);
+        }
+        return std::make_pair(true, std::string());
+    } else if (name == "undef") {
+        _macros.erase(rest);
+        return std::make_pair(true, std::string());
+    } else if (name == "include" || name == "import") {
+        std::string target = expand(rest, std::unordered_set<std::string>());
+        if (target.size() < 2 || target.front() != '"' || target.back() != '"') {
+            return std::make_pair(false, "only quoted includes are supported: " + rest);
+        }
+
+        std::string included = FSUtil::ResolveRelativePath(target.substr(1, target.size() - 2), FSUtil::GetDirectoryName(path));
+        return include(included, output);
+    } else if (name == "error") {
+        return std::make_pair(false, "#error " + rest);
+    } else if (name == "warning") {
+        fprintf(stderr, "%s: warning: %s\n", path.c_str(), rest.c_str());
+        return std::make_pair(true, std::string());
+    }
+
+    return std::make_pair(false, "unknown directive #" + name);
+}
+
+std::pair<bool, std::string> Preprocessor::
+process(std::string const &path, std::string const &contents, bool header, std::string *output)
+{
+    /*
+     * Each open conditional: if its lines are kept, if an earlier branch
+     * already was, and if the lines around it are kept.
+     */
+    struct Conditional {
+        bool active;
+        bool taken;
+        bool parent;
+        bool sawElse;
+    };
+    std::vector<Conditional> conditionals;
+
+    std::string text = StripComments(contents, header);
+    size_t lineNumber = 0;
+
+    for (size_t start = 0; start < text.size();) {
+        std::string::size_type newline = text.find('\n', start);
+        std::string line = text.substr(start, (newline == std::string::npos ? std::string::npos : newline - start));
+        start = (newline == std::string::npos ? text.size() : newline + 1);
+        lineNumber++;
+
+        bool active = (conditionals.empty() || conditionals.back().active);
+        std::string trimmed = Trim(line);
+
+        if (trimmed.empty() || trimmed[0] != '#') {
+            if (active && output != nullptr) {
+                *output += expand(line, std::unordered_set<std::string>());
+                *output += '\n';
+            }
+            continue;
+        }
+
+        std::string directiveLine = Trim(StripComments(trimmed.substr(1), true));
+        size_t nameEnd = 0;
+        while (nameEnd < directiveLine.size() && IsIdentifier(directiveLine[nameEnd])) {
+            nameEnd++;
+        }
+        std::string name = directiveLine.substr(0, nameEnd);
+        std::string rest = Trim(directiveLine.substr(nameEnd));
+
+        std::string location = path + ":" + std::to_string(lineNumber);
+
+        if (name == "if" || name == "ifdef" || name == "ifndef") {
+            bool condition = false;
+            if (active) {
+                if (name == "if") {
+                    auto result = evaluate(rest, &condition);
+                    if (!result.first) {
+                        return std::make_pair(false, location + ": " + result.second);
+                    }
+                } else {
+                    condition = (defined(rest) == (name == "ifdef"));
+                }
+            }
+            conditionals.push_back({ active && condition, condition, active, false });
+        } else if (name == "elif" || name == "else") {
+            if (conditionals.empty() || conditionals.back().sawElse) {
+                return std::make_pair(false, location + ": #" + name + " without #if");
+            }
+
+            Conditional &conditional = conditionals.back();
+            bool condition = true;
+            if (name == "elif" && conditional.parent && !conditional.taken) {
+                auto result = evaluate(rest, &condition);
+                if (!result.first) {
+                    return std::make_pair(false, location + ": " + result.second);
+                }
+            }
+
+            conditional.active = (conditional.parent && !conditional.taken && condition);
+            conditional.taken = (conditional.taken || conditional.active);
+            conditional.sawElse = (name == "else");
+        } else if (name == "endif") {
+            if (conditionals.empty()) {
+                return std::make_pair(false, location + ": #endif without #if");
+            }
+            conditionals.pop_back();
+        } else if (active) {
+            auto result = directive(path, directiveLine, output);
+            if (!result.first) {
+                return std::make_pair(false, location + ": " + result.second);
+            }
+        }
+    }
+
+    if (!conditionals.empty()) {
+        return std::make_pair(false, path + ": unterminated conditional");
+    }
+
+    return std::make_pair(true, std::string());
+}
+
+std::pair<bool, std::string> Preprocessor::
+include(std::string const &path, std::string *output)
+{
+    if (_depth >= MaximumIncludeDepth) {
+        return std::make_pair(false, "too many nested includes at " + path);
+    }
+
+    std::vector<uint8_t> contents;
+    if (!_filesystem->read(&contents, path)) {
+        return std::make_pair(false, "unable to read " + path);
+    }
+
+    if (std::find(_includes.begin(), _includes.end(), path) == _includes.end()) {
+        _includes.push_back(path);
+    }
+
+    _depth++;
+    auto result = process(path, std::string(contents.begin(), contents.end()), true, output);
+    _depth--;
+    return result;
+}
@@ -0,0 +1,68 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <builtin/mkdir/Driver.h>
+#include <builtin/mkdir/Options.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <process/Context.h>
+
+using builtin::mkdir::Driver;
+using builtin::mkdir::Options;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+Driver::
+Driver()
+{
+}
+
+Driver::
+~Driver()
+{
+}
+
+std::string Driver::
+name()
+{
+    return "builtin-mkdir";
+}
+
+int Driver::
+run(process::Context const *processContext, libutil::Filesystem *filesystem)
+{
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
+    if (!result.first) {
+        fprintf(stderr, "error: %s\n", result.second.c_str());
+        return 1;
+    }
+
+    if (options.paths().empty()) {
+        fprintf(stderr, "error: no directories specified\n");
+        return 1;
+    }
+
+    for (std::string const &path : options.paths()) {
+        std::string directory = FSUtil::ResolveRelativePath(path, processContext->currentDirectory());
+
+        /* Without -p, only the last component is created. */
+        if (!options.parents() && !filesystem->isDirectory(FSUtil::GetDirectoryName(directory))) {
+            fprintf(stderr, "error: %s: parent directory does not exist\n", path.c_str());
+            return 1;
+        }
+
+        if (!filesystem->createDirectory(directory)) {
+            fprintf(stderr, "error: %s: unable to create directory\n", path.c_str());
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,377 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <builtin/swiftStdLibTool/Driver.h>
+#include <builtin/swiftStdLibTool/Options.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <process/Context.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+using builtin::swiftStdLibTool::Driver;
+using builtin::swiftStdLibTool::Options;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+Driver::
+Driver()
+{
+}
+
+Driver::
+~Driver()
+{
+}
+
+std::string Driver::
+name()
+{
+    return "builtin-swiftStdLibTool";
+}
+
+static uint32_t
+ReadUInt32(uint8_t const *data, bool bigEndian)
+{
+    if (bigEndian) {
+        return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) | data[3];
+    } else {
+        return (static_cast<uint32_t>(data[3]) << 24) | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[1]) << 8) | data[0];
+    }
+}
+
+static uint64_t
+ReadUInt64(uint8_t const *data, bool bigEndian)
+{
+    uint64_t first = ReadUInt32(data, bigEndian);
+    uint64_t second = ReadUInt32(data + 4, bigEndian);
+    return (bigEndian ? (first << 32) | second : (second << 32) | first);
+}
+
+/*
+ * Add the Swift libraries linked by the load commands of one architecture
+ * of a Mach-O file. Returns false if it's not a Mach-O file.
+ */
+static bool
+ScanArchitecture(uint8_t const *data, size_t size, std::set<std::string> *libraries)
+{
+    if (size < 28) {
+        return false;
+    }
+
+    bool bigEndian;
+    size_t headerSize;
+    switch (ReadUInt32(data, false)) {
+        case 0xfeedface: bigEndian = false; headerSize = 28; break;
+        case 0xfeedfacf: bigEndian = false; headerSize = 32; break;
+        case 0xcefaedfe: bigEndian = true;  headerSize = 28; break;
+        case 0xcffaedfe: bigEndian = true;  headerSize = 32; break;
+        default: return false;
+    }
+
+    uint32_t commands = ReadUInt32(data + 16, bigEndian);
+    size_t offset = headerSize;
+    for (uint32_t i = 0; i < commands; ++i) {
+        if (offset + 8 > size) {
+            return false;
+        }
+
+        uint32_t command = ReadUInt32(data + offset, bigEndian);
+        uint32_t commandSize = ReadUInt32(data + offset + 4, bigEndian);
+        if (commandSize < 8 || commandSize > size - offset) {
+            return false;
+        }
+
+        /* LC_LOAD_DYLIB, LC_LOAD_WEAK_DYLIB, LC_REEXPORT_DYLIB, LC_LAZY_LOAD_DYLIB, LC_LOAD_UPWARD_DYLIB */
+        if ((command == 0xc || command == 0x80000018 || command == 0x8000001f || command == 0x20 || command == 0x80000023) && commandSize >= 12) {
+            uint32_t nameOffset = ReadUInt32(data + offset + 8, bigEndian);
+            if (nameOffset < commandSize) {
+                char const *name = reinterpret_cast<char const *>(data + offset + nameOffset);
+                std::string path = std::string(name, strnlen(name, commandSize - nameOffset));
+
+                std::string const prefix = "@rpath/";
+                if (path.compare(0, prefix.size() + 8, prefix + "libswift") == 0 && FSUtil::GetFileExtension(path) == "dylib") {
+                    libraries->insert(path.substr(prefix.size()));
+                }
+            }
+        }
+
+        offset += commandSize;
+    }
+
+    return true;
+}
+
+/*
+ * The Swift libraries a Mach-O file links, from all of its architectures.
+ * Nothing if it's not a Mach-O file.
+ */
+static ext::optional<std::set<std::string>>
+ScanMachO(uint8_t const *data, size_t size)
+{
+    std::set<std::string> libraries;
+
+    uint32_t magic = (size >= 8 ? ReadUInt32(data, true) : 0);
+    if (magic == 0xcafebabe || magic == 0xcafebabf) {
+        /* Universal file. Java class files share the magic, but have many more "architectures". */
+        bool wide = (magic == 0xcafebabf);
+        size_t entrySize = (wide ? 32 : 20);
+        uint32_t count = ReadUInt32(data + 4, true);
+        if (count == 0 || count > 32 || 8 + count * entrySize > size) {
+            return ext::nullopt;
+        }
+
+        for (uint32_t i = 0; i < count; ++i) {
+            uint8_t const *entry = data + 8 + i * entrySize;
+            uint64_t offset = (wide ? ReadUInt64(entry + 8, true) : ReadUInt32(entry + 8, true));
+            uint64_t length = (wide ? ReadUInt64(entry + 16, true) : ReadUInt32(entry + 12, true));
+            if (offset > size || length > size - offset || !ScanArchitecture(data + offset, length, &libraries)) {
+                return ext::nullopt;
+            }
+        }
+    } else if (!ScanArchitecture(data, size, &libraries)) {
+        return ext::nullopt;
+    }
+
+    return libraries;
+}
+
+namespace {
+
+struct Scan {
+    uint64_t                              size;
+    uint64_t                              modificationTime;
+    ext::optional<std::set<std::string>>  libraries;
+};
+
+}
+
+/*
+ * The Swift libraries a file links, scanned once per process unless the
+ * file changes. Builtins run in the build's process, so the app and each
+ * product it embeds share the scans of the binaries and libraries they
+ * have in common.
+ */
+static ext::optional<std::set<std::string>>
+SharedScan(Filesystem const *filesystem, std::string const &path)
+{
+    static std::mutex *mutex = new std::mutex();
+    static std::unordered_map<std::string, Scan> *scans = new std::unordered_map<std::string, Scan>();
+
+    ext::optional<Filesystem::Metadata> metadata = filesystem->metadata(path);
+    if (!metadata || metadata->directory) {
+        return ext::nullopt;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(*mutex);
+        auto it = scans->find(path);
+        if (it != scans->end() && it->second.size == metadata->size && it->second.modificationTime == metadata->modificationTime) {
+            return it->second.libraries;
+        }
+    }
+
+    /* Most files in the scanned folders aren't binaries; check the magic before reading them. */
+    ext::optional<std::set<std::string>> libraries;
+    std::vector<uint8_t> magic;
+    if (filesystem->read(&magic, path, 0, std::min<size_t>(4, metadata->size)) && magic.size() == 4) {
+        uint32_t value = ReadUInt32(magic.data(), true);
+        if (value == 0xcafebabe || value == 0xcafebabf || value == 0xfeedface || value == 0xfeedfacf || value == 0xcefaedfe || value == 0xcffaedfe) {
+            if (std::unique_ptr<Filesystem::Mapping> mapping = filesystem->readMapped(path)) {
+                libraries = ScanMachO(mapping->data(), mapping->size());
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(*mutex);
+    (*scans)[path] = { metadata->size, metadata->modificationTime, libraries };
+    return libraries;
+}
+
+/*
+ * Copy a library unless an identical copy is already there, so products
+ * embedding it aren't re-signed or repackaged for nothing.
+ */
+static bool
+CopyLibrary(Filesystem *filesystem, std::string const &source, std::string const &directory, bool verbose)
+{
+    std::string destination = directory + "/" + FSUtil::GetBaseName(source);
+
+    ext::optional<Filesystem::Metadata> sourceMetadata = filesystem->metadata(source);
+    ext::optional<Filesystem::Metadata> destinationMetadata = filesystem->metadata(destination);
+    if (sourceMetadata && destinationMetadata && sourceMetadata->size == destinationMetadata->size) {
+        std::vector<uint8_t> sourceContents;
+        std::vector<uint8_t> destinationContents;
+        if (filesystem->read(&sourceContents, source) && filesystem->read(&destinationContents, destination) && sourceContents == destinationContents) {
+            return true;
+        }
+    }
+
+    if (verbose) {
+        printf("verbose: copying %s -> %s\n", source.c_str(), destination.c_str());
+    }
+
+    if (!filesystem->createDirectory(directory) || !filesystem->copyFile(source, destination)) {
+        fprintf(stderr, "error: unable to copy %s to %s\n", source.c_str(), destination.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+static int
+Run(Filesystem *filesystem, Options const &options, std::string const &workingDirectory)
+{
+    if (options.sign()) {
+        fprintf(stderr, "error: signing Swift libraries is not supported\n");
+        return 1;
+    }
+
+    /*
+     * Find where the libraries are: given explicitly, or in each toolchain.
+     */
+    std::vector<std::string> sourceDirectories;
+    if (options.sourceLibraries()) {
+        sourceDirectories.push_back(FSUtil::ResolveRelativePath(*options.sourceLibraries(), workingDirectory));
+    } else if (options.platform()) {
+        for (std::string const &toolchain : options.toolchains()) {
+            sourceDirectories.push_back(FSUtil::ResolveRelativePath(toolchain, workingDirectory) + "/usr/lib/swift/" + *options.platform());
+        }
+    }
+
+    if (sourceDirectories.empty()) {
+        fprintf(stderr, "error: no Swift libraries to copy from; pass --source-libraries, or --platform and --toolchain\n");
+        return 1;
+    }
+
+    /*
+     * Scan the executables and the folders of the product.
+     */
+    std::set<std::string> needed;
+    for (std::string const &executable : options.scanExecutables()) {
+        std::string path = FSUtil::ResolveRelativePath(executable, workingDirectory);
+        if (!filesystem->exists(path)) {
+            fprintf(stderr, "error: executable to scan %s does not exist\n", path.c_str());
+            return 1;
+        }
+
+        if (ext::optional<std::set<std::string>> libraries = SharedScan(filesystem, path)) {
+            needed.insert(libraries->begin(), libraries->end());
+        }
+    }
+
+    for (std::string const &folder : options.scanFolders()) {
+        std::string path = FSUtil::ResolveRelativePath(folder, workingDirectory);
+        if (!filesystem->isDirectory(path)) {
+            continue;
+        }
+
+        filesystem->enumerateRecursive(path, [&](std::string const &file, bool directory) -> bool {
+            if (!directory && !filesystem->isSymbolicLink(file)) {
+                if (ext::optional<std::set<std::string>> libraries = SharedScan(filesystem, file)) {
+                    needed.insert(libraries->begin(), libraries->end());
+                }
+            }
+            return true;
+        });
+    }
+
+    /*
+     * Add the libraries the needed libraries link, until there are no more.
+     */
+    std::map<std::string, std::string> sources;
+    std::vector<std::string> pending = std::vector<std::string>(needed.begin(), needed.end());
+    while (!pending.empty()) {
+        std::string name = pending.back();
+        pending.pop_back();
+        if (sources.find(name) != sources.end()) {
+            continue;
+        }
+
+        std::string source;
+        for (std::string const &directory : sourceDirectories) {
+            if (filesystem->exists(directory + "/" + name)) {
+                source = directory + "/" + name;
+                break;
+            }
+        }
+
+        if (source.empty()) {
+            fprintf(stderr, "error: unable to find Swift library %s\n", name.c_str());
+            return 1;
+        }
+
+        sources.insert({ name, source });
+        if (ext::optional<std::set<std::string>> libraries = SharedScan(filesystem, source)) {
+            pending.insert(pending.end(), libraries->begin(), libraries->end());
+        }
+    }
+
+    if (options.print()) {
+        for (auto const &entry : sources) {
+            printf("%s\n", entry.second.c_str());
+        }
+    }
+
+    if (options.copy()) {
+        // TODO: Implement --strip-bitcode when copying.
+        std::vector<std::string> destinations;
+        if (options.destination()) {
+            destinations.push_back(FSUtil::ResolveRelativePath(*options.destination(), workingDirectory));
+        }
+        if (options.unsignedDestination()) {
+            destinations.push_back(FSUtil::ResolveRelativePath(*options.unsignedDestination(), workingDirectory));
+        }
+
+        for (std::string const &destination : destinations) {
+            for (auto const &entry : sources) {
+                if (!CopyLibrary(filesystem, entry.second, destination, options.verbose())) {
+                    return 1;
+                }
+            }
+        }
+
+        /*
+         * Resource libraries are only copied if the toolchain has them.
+         */
+        if (options.resourceDestination()) {
+            std::string destination = FSUtil::ResolveRelativePath(*options.resourceDestination(), workingDirectory);
+            for (std::string const &name : options.resourceLibraries()) {
+                for (std::string const &directory : sourceDirectories) {
+                    if (filesystem->exists(directory + "/" + name)) {
+                        if (!CopyLibrary(filesystem, directory + "/" + name, destination, options.verbose())) {
+                            return 1;
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+int Driver::
+run(process::Context const *processContext, libutil::Filesystem *filesystem)
+{
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
+    if (!result.first) {
+        fprintf(stderr, "error: %s\n", result.second.c_str());
+        return 1;
+    }
+
+    return Run(filesystem, options, processContext->currentDirectory());
+}
@@ -0,0 +1,66 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <builtin/swiftStdLibTool/Options.h>
+
+using builtin::swiftStdLibTool::Options;
+
+Options::
+Options()
+{
+}
+
+Options::
+~Options()
+{
+}
+
+std::pair<bool, std::string> Options::
+parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it)
+{
+    std::string const &arg = **it;
+
+    if (arg == "--print") {
+        return libutil::Options::Current<bool>(&_print, arg);
+    } else if (arg == "--copy") {
+        return libutil::Options::Current<bool>(&_copy, arg);
+    } else if (arg == "--verbose") {
+        return libutil::Options::Current<bool>(&_verbose, arg, true);
+    } else if (arg == "--scan-executable") {
+        return libutil::Options::AppendNext<std::string>(&_scanExecutables, args, it);
+    } else if (arg == "--scan-folder") {
+        return libutil::Options::AppendNext<std::string>(&_scanFolders, args, it);
+    } else if (arg == "--platform") {
+        return libutil::Options::Next<std::string>(&_platform, args, it);
+    } else if (arg == "--source-libraries") {
+        return libutil::Options::Next<std::string>(&_sourceLibraries, args, it);
+    } else if (arg == "--toolchain") {
+        return libutil::Options::AppendNext<std::string>(&_toolchains, args, it);
+    } else if (arg == "--destination") {
+        return libutil::Options::Next<std::string>(&_destination, args, it);
+    } else if (arg == "--unsigned-destination") {
+        return libutil::Options::Next<std::string>(&_unsignedDestination, args, it);
+    } else if (arg == "--resource-destination") {
+        return libutil::Options::Next<std::string>(&_resourceDestination, args, it);
+    } else if (arg == "--resource-library") {
+        return libutil::Options::AppendNext<std::string>(&_resourceLibraries, args, it);
+    } else if (arg == "--strip-bitcode") {
+        return libutil::Options::Current<bool>(&_stripBitcode, arg);
+    } else if (arg == "--strip-bitcode-tool") {
+        return libutil::Options::Next<std::string>(&_stripBitcodeTool, args, it);
+    } else if (arg == "--sign") {
+        return libutil::Options::Next<std::string>(&_sign, args, it);
+    } else if (arg == "--keychain") {
+        return libutil::Options::Next<std::string>(&_keychain, args, it);
+    } else if (arg == "--Xcodesign") {
+        return libutil::Options::AppendNext<std::string>(&_codesignArguments, args, it);
+    } else {
+        return std::make_pair(false, "unknown argument " + arg);
+    }
+}
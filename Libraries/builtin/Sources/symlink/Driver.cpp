@@ -0,0 +1,78 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <builtin/symlink/Driver.h>
+#include <builtin/symlink/Options.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <process/Context.h>
+
+using builtin::symlink::Driver;
+using builtin::symlink::Options;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+Driver::
+Driver()
+{
+}
+
+Driver::
+~Driver()
+{
+}
+
+std::string Driver::
+name()
+{
+    return "builtin-symlink";
+}
+
+int Driver::
+run(process::Context const *processContext, libutil::Filesystem *filesystem)
+{
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
+    if (!result.first) {
+        fprintf(stderr, "error: %s\n", result.second.c_str());
+        return 1;
+    }
+
+    if (!options.target() || !options.link()) {
+        fprintf(stderr, "error: target and link path required\n");
+        return 1;
+    }
+
+    /*
+     * Like `ln -sfh`: an existing link (even one to a directory) or file is
+     * replaced, but a link into a real directory is created inside it. The
+     * target is written as given, relative to the link.
+     */
+    std::string link = FSUtil::ResolveRelativePath(*options.link(), processContext->currentDirectory());
+    if (filesystem->isSymbolicLink(link)) {
+        if (filesystem->readSymbolicLink(link) == *options.target()) {
+            /* Already correct; leave it alone. */
+            return 0;
+        }
+    } else if (filesystem->isDirectory(link)) {
+        link += "/" + FSUtil::GetBaseName(*options.target());
+    }
+
+    if ((filesystem->isSymbolicLink(link) || filesystem->exists(link)) && !filesystem->removeFile(link)) {
+        fprintf(stderr, "error: %s: unable to remove existing file\n", link.c_str());
+        return 1;
+    }
+
+    if (!filesystem->writeSymbolicLink(*options.target(), link)) {
+        fprintf(stderr, "error: %s: unable to create symbolic link\n", link.c_str());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,38 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <builtin/symlink/Options.h>
+
+using builtin::symlink::Options;
+
+Options::
+Options()
+{
+}
+
+Options::
+~Options()
+{
+}
+
+std::pair<bool, std::string> Options::
+parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it)
+{
+    std::string const &arg = **it;
+
+    if (!arg.empty() && arg[0] != '-') {
+        if (!_target) {
+            return libutil::Options::Current<std::string>(&_target, arg);
+        } else {
+            return libutil::Options::Current<std::string>(&_link, arg);
+        }
+    } else {
+        return std::make_pair(false, "unknown argument " + arg);
+    }
+}
@@ -0,0 +1,74 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <builtin/touch/Driver.h>
+#include <builtin/touch/Options.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <process/Context.h>
+
+using builtin::touch::Driver;
+using builtin::touch::Options;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+Driver::
+Driver()
+{
+}
+
+Driver::
+~Driver()
+{
+}
+
+std::string Driver::
+name()
+{
+    return "builtin-touch";
+}
+
+int Driver::
+run(process::Context const *processContext, libutil::Filesystem *filesystem)
+{
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
+    if (!result.first) {
+        fprintf(stderr, "error: %s\n", result.second.c_str());
+        return 1;
+    }
+
+    if (options.paths().empty()) {
+        fprintf(stderr, "error: no files specified\n");
+        return 1;
+    }
+
+    for (std::string const &path : options.paths()) {
+        std::string file = FSUtil::ResolveRelativePath(path, processContext->currentDirectory());
+
+        if (!filesystem->exists(file)) {
+            /* With -c, missing files are skipped rather than created. */
+            if (options.noCreate()) {
+                continue;
+            }
+
+            if (!filesystem->createFile(file)) {
+                fprintf(stderr, "error: %s: unable to create file\n", path.c_str());
+                return 1;
+            }
+        }
+
+        if (!filesystem->touch(file)) {
+            fprintf(stderr, "error: %s: unable to set modification time\n", path.c_str());
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,324 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <builtin/Server.h>
+#include <builtin/Driver.h>
+#include <libutil/DefaultFilesystem.h>
+#include <process/MemoryContext.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using builtin::Server;
+using builtin::Registry;
+using libutil::DefaultFilesystem;
+
+namespace {
+
+/*
+ * Writes to its output and exits with the number in its first argument.
+ */
+class OutputDriver : public builtin::Driver {
+public:
+    virtual std::string name()
+    { return "builtin-output"; }
+
+    virtual int run(process::Context const *processContext, libutil::Filesystem *filesystem)
+    {
+        fprintf(stdout, "output %s\n", processContext->currentDirectory().c_str());
+        fprintf(stderr, "error\n");
+        return std::atoi(processContext->commandLineArguments().front().c_str());
+    }
+};
+
+/*
+ * Waits for a file to exist, failing if it takes too long.
+ */
+class WaitDriver : public builtin::Driver {
+public:
+    virtual std::string name()
+    { return "builtin-wait"; }
+
+    virtual int run(process::Context const *processContext, libutil::Filesystem *filesystem)
+    {
+        for (int n = 0; n < 200; ++n) {
+            if (::access(processContext->commandLineArguments().front().c_str(), F_OK) == 0) {
+                return 0;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(25));
+        }
+        return 1;
+    }
+};
+
+/*
+ * Creates a file.
+ */
+class CreateDriver : public builtin::Driver {
+public:
+    virtual std::string name()
+    { return "builtin-create"; }
+
+    virtual int run(process::Context const *processContext, libutil::Filesystem *filesystem)
+    {
+        int fd = ::open(processContext->commandLineArguments().front().c_str(), O_CREAT | O_WRONLY, 0644);
+        if (fd < 0) {
+            return 1;
+        }
+        ::close(fd);
+        return 0;
+    }
+};
+
+/*
+ * Crashes the process running it.
+ */
+class CrashDriver : public builtin::Driver {
+public:
+    virtual std::string name()
+    { return "builtin-crash"; }
+
+    virtual int run(process::Context const *processContext, libutil::Filesystem *filesystem)
+    {
+        ::abort();
+    }
+};
+
+/*
+ * A server for the drivers above, serving from another thread.
+ */
+class ServerTest : public ::testing::Test {
+protected:
+    std::string                 _directory;
+    DefaultFilesystem           _filesystem;
+    process::MemoryContext      _context;
+    std::unique_ptr<Server>     _server;
+    std::thread                 _thread;
+
+protected:
+    ServerTest() :
+        _context("xcbuild", "/", { }, { }, ::getuid(), ::getgid(), "user", "group")
+    {
+    }
+
+    virtual void SetUp()
+    {
+        char directory[] = "/tmp/builtin-server.XXXXXX";
+        ASSERT_NE(nullptr, ::mkdtemp(directory));
+        _directory = directory;
+
+        Registry registry = Registry::Create({
+            std::make_shared<OutputDriver>(),
+            std::make_shared<WaitDriver>(),
+            std::make_shared<CreateDriver>(),
+            std::make_shared<CrashDriver>(),
+        });
+
+        _server = std::unique_ptr<Server>(new Server(registry, _directory + "/server"));
+        ASSERT_TRUE(_server->listen());
+        _thread = std::thread([this] {
+            _server->serve(&_context, &_filesystem);
+        });
+    }
+
+    virtual void TearDown()
+    {
+        if (_thread.joinable()) {
+            _server->stop();
+            _thread.join();
+        }
+        _server.reset();
+
+        ::unlink((_directory + "/ready").c_str());
+        ::unlink((_directory + "/server").c_str());
+        ::rmdir(_directory.c_str());
+    }
+
+    ext::optional<int> run(std::string const &name, std::vector<std::string> const &arguments, std::string const &directory = "/")
+    {
+        process::MemoryContext context = process::MemoryContext(name, directory, arguments, { }, ::getuid(), ::getgid(), "user", "group");
+        return Server::Run(_directory + "/server", name, &context);
+    }
+
+    void stop()
+    {
+        _server->stop();
+        _thread.join();
+    }
+};
+
+}
+
+/*
+ * The contents of a file, or nothing if it can't be read.
+ */
+static ext::optional<std::string>
+ReadFile(std::string const &path)
+{
+    DefaultFilesystem filesystem;
+    std::vector<uint8_t> contents;
+    if (!filesystem.read(&contents, path)) {
+        return ext::nullopt;
+    }
+
+    return std::string(contents.begin(), contents.end());
+}
+
+/*
+ * Read what a function writes to standard output and standard error.
+ */
+static std::string
+CaptureOutput(std::function<void()> const &function)
+{
+    FILE *file = ::tmpfile();
+
+    fflush(stdout);
+    fflush(stderr);
+    int savedOutput = ::dup(STDOUT_FILENO);
+    int savedError = ::dup(STDERR_FILENO);
+    ::dup2(::fileno(file), STDOUT_FILENO);
+    ::dup2(::fileno(file), STDERR_FILENO);
+
+    function();
+
+    fflush(stdout);
+    fflush(stderr);
+    ::dup2(savedOutput, STDOUT_FILENO);
+    ::dup2(savedError, STDERR_FILENO);
+    ::close(savedOutput);
+    ::close(savedError);
+
+    std::string output;
+    ::rewind(file);
+    for (int c; (c = ::fgetc(file)) != EOF;) {
+        output.push_back(static_cast<char>(c));
+    }
+    ::fclose(file);
+
+    return output;
+}
+
+TEST_F(ServerTest, Output)
+{
+    ext::optional<int> exitCode;
+    std::string output = CaptureOutput([&] {
+        exitCode = run("builtin-output", { "3" }, "/tmp");
+    });
+
+    ASSERT_TRUE(exitCode);
+    EXPECT_EQ(3, *exitCode);
+    EXPECT_NE(std::string::npos, output.find("output /tmp\n"));
+    EXPECT_NE(std::string::npos, output.find("error\n"));
+
+    /* The server's own output is left as it was. */
+    EXPECT_EQ(0, *run("builtin-output", { "0" }));
+}
+
+TEST_F(ServerTest, Concurrent)
+{
+    /* The first request only finishes once the second one has run. */
+    std::string ready = _directory + "/ready";
+    ext::optional<int> waited;
+    std::thread waiter([&] {
+        waited = run("builtin-wait", { ready });
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(0, *run("builtin-create", { ready }));
+
+    waiter.join();
+    ASSERT_TRUE(waited);
+    EXPECT_EQ(0, *waited);
+}
+
+TEST_F(ServerTest, Crash)
+{
+    ext::optional<int> exitCode = run("builtin-crash", { });
+    ASSERT_TRUE(exitCode);
+    EXPECT_EQ(128 + SIGABRT, *exitCode);
+
+    /* Only the request that crashed fails. */
+    EXPECT_EQ(0, *run("builtin-output", { "0" }));
+}
+
+TEST_F(ServerTest, Unknown)
+{
+    EXPECT_EQ(1, *run("builtin-missing", { }));
+}
+
+TEST_F(ServerTest, Stopped)
+{
+    stop();
+
+    /* Without a server, the builtin can run another way. */
+    EXPECT_FALSE(run("builtin-output", { "0" }));
+    EXPECT_FALSE(ReadFile(_directory + "/server"));
+}
+
+TEST_F(ServerTest, Socket)
+{
+    /* The file points to a socket in a directory only this user can use. */
+    std::string socketPath = _server->socketPath();
+    EXPECT_EQ(socketPath, ReadFile(_directory + "/server"));
+
+    std::string socketDirectory = socketPath.substr(0, socketPath.rfind('/'));
+    struct stat status;
+    ASSERT_EQ(0, ::stat(socketDirectory.c_str(), &status));
+    EXPECT_EQ(static_cast<mode_t>(0700), status.st_mode & 0777);
+    EXPECT_EQ(::geteuid(), status.st_uid);
+
+    /* Everything created is removed once stopped. */
+    stop();
+    _server.reset();
+    EXPECT_NE(0, ::access(socketPath.c_str(), F_OK));
+    EXPECT_NE(0, ::access(socketDirectory.c_str(), F_OK));
+}
+
+TEST_F(ServerTest, Stale)
+{
+    stop();
+
+    /* A file pointing to a socket that's gone is ignored. */
+    std::string socketPath = _server->socketPath();
+    _server.reset();
+
+    DefaultFilesystem filesystem;
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>(socketPath.begin(), socketPath.end()), _directory + "/server"));
+    EXPECT_FALSE(run("builtin-output", { "0" }));
+}
+
+TEST_F(ServerTest, Replaced)
+{
+    /* A second server with the same file takes it over. */
+    Server other(Registry::Create({ std::make_shared<OutputDriver>() }), _directory + "/server");
+    ASSERT_TRUE(other.listen());
+    EXPECT_NE(_server->socketPath(), other.socketPath());
+    EXPECT_EQ(other.socketPath(), ReadFile(_directory + "/server"));
+
+    std::thread thread([&] {
+        other.serve(&_context, &_filesystem);
+    });
+
+    /* Stopping the first server leaves the second one's file. */
+    stop();
+    _server.reset();
+    EXPECT_EQ(other.socketPath(), ReadFile(_directory + "/server"));
+    EXPECT_EQ(0, *run("builtin-output", { "0" }));
+
+    other.stop();
+    thread.join();
+}
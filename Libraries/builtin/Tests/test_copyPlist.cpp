@@ -85,3 +85,70 @@ TEST(copyPlist, CopyMultiple)
     EXPECT_EQ(contents, Contents("{\n\tin3 = three;\n}\n"));
 }
 
+TEST(copyPlist, UnchangedOutputUntouched)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("in.plist", Contents("{ in = \"value\"; }")),
+        MemoryFilesystem::Entry::Directory("output", { }),
+    });
+
+    Driver driver;
+    process::MemoryContext processContext = process::MemoryContext(
+        driver.name(),
+        "/",
+        {
+            "in.plist",
+            "--outdir", "output",
+            "--convert", "ascii1",
+        },
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "root",
+        "wheel");
+    EXPECT_EQ(0, driver.run(&processContext, &filesystem));
+
+    ext::optional<uint64_t> before = filesystem.modificationTime("/output/in.plist");
+    ASSERT_TRUE(before);
+
+    /* Copying the same contents again leaves the output alone. */
+    EXPECT_EQ(0, driver.run(&processContext, &filesystem));
+
+    ext::optional<uint64_t> after = filesystem.modificationTime("/output/in.plist");
+    ASSERT_TRUE(after);
+    EXPECT_EQ(*before, *after);
+}
+
+
+TEST(copyPlist, StopAtInvalid)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("in1.plist", Contents("{ in1 = \"one\"; }")),
+        MemoryFilesystem::Entry::File("in2.plist", Contents("{ in2 = ")),
+        MemoryFilesystem::Entry::File("in3.plist", Contents("{ in3 = \"three\"; }")),
+        MemoryFilesystem::Entry::Directory("output", { }),
+    });
+
+    Driver driver;
+    process::MemoryContext processContext = process::MemoryContext(
+        driver.name(),
+        "/",
+        {
+            "in1.plist",
+            "in2.plist",
+            "in3.plist",
+            "--outdir", "output",
+            "--validate",
+        },
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "root",
+        "wheel");
+    EXPECT_EQ(1, driver.run(&processContext, &filesystem));
+
+    /* Inputs before the invalid one are still copied, in order. */
+    EXPECT_TRUE(filesystem.isReadable("/output/in1.plist"));
+    EXPECT_FALSE(filesystem.isReadable("/output/in2.plist"));
+    EXPECT_FALSE(filesystem.isReadable("/output/in3.plist"));
+}
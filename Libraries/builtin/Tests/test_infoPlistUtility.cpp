@@ -0,0 +1,191 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <builtin/infoPlistUtility/Driver.h>
+#include <builtin/infoPlistUtility/Preprocessor.h>
+#include <dependency/MakefileDependencyInfo.h>
+#include <libutil/MemoryFilesystem.h>
+#include <process/MemoryContext.h>
+#include <plist/Dictionary.h>
+#include <plist/String.h>
+#include <plist/Format/Any.h>
+
+using builtin::infoPlistUtility::Driver;
+using builtin::infoPlistUtility::Preprocessor;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static std::string
+Preprocess(Preprocessor *preprocessor, std::string const &contents)
+{
+    std::string output;
+    auto result = preprocessor->process("/Info.plist", contents, false, &output);
+    EXPECT_TRUE(result.first) << result.second;
+    return output;
+}
+
+TEST(infoPlistUtility, PreprocessMacros)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    Preprocessor preprocessor = Preprocessor(&filesystem);
+    preprocessor.define("VERSION=1.2");
+    preprocessor.define("ENABLED");
+
+    EXPECT_EQ("1.2 1\n", Preprocess(&preprocessor, "VERSION ENABLED\n"));
+
+    /* Function-like macros, nested macros, and macros expanding to themselves. */
+    EXPECT_EQ("<string>com.example.app</string>\n", Preprocess(&preprocessor,
+        "#define STRING(x) <string>x</string>\n"
+        "#define PREFIX com.example\n"
+        "#define SELF SELF\n"
+        "STRING(PREFIX.app)\n"));
+    EXPECT_EQ("SELF\n", Preprocess(&preprocessor, "SELF\n"));
+
+    /* Not in strings, numbers, or URLs, which aren't comments. */
+    EXPECT_EQ("\"VERSION\" 10e5 http://example.com/1.2\n", Preprocess(&preprocessor, "\"VERSION\" 10e5 http://example.com/VERSION\n"));
+    EXPECT_EQ("a   b\n", Preprocess(&preprocessor, "a /* VERSION */ b\n"));
+}
+
+TEST(infoPlistUtility, PreprocessConditionals)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    Preprocessor preprocessor = Preprocessor(&filesystem);
+    preprocessor.define("LEVEL=3");
+    preprocessor.define("DEBUG");
+
+    EXPECT_EQ("three\ndebug\n", Preprocess(&preprocessor,
+        "#if LEVEL > 4 || !defined(DEBUG)\n"
+        "high\n"
+        "#elif LEVEL == (1 + 2) * 1 && (LEVEL << 1) == 6\n"
+        "three\n"
+        "#else\n"
+        "other\n"
+        "#endif\n"
+        "#ifdef DEBUG\n"
+        "#ifndef RELEASE\n"
+        "debug\n"
+        "#endif\n"
+        "#else\n"
+        "release\n"
+        "#endif\n"));
+
+    /* Undefined names are zero, and skipped branches aren't evaluated. */
+    EXPECT_EQ("missing\n", Preprocess(&preprocessor,
+        "#if MISSING\n"
+        "#if 1 / 0\n"
+        "#endif\n"
+        "#else\n"
+        "missing\n"
+        "#endif\n"));
+
+    std::string output;
+    EXPECT_FALSE(preprocessor.process("/Info.plist", "#if 1\n", false, &output).first);
+    EXPECT_FALSE(preprocessor.process("/Info.plist", "#endif\n", false, &output).first);
+    EXPECT_FALSE(preprocessor.process("/Info.plist", "#if 1 / 0\n#endif\n", false, &output).first);
+    EXPECT_FALSE(preprocessor.process("/Info.plist", "#error failed\n", false, &output).first);
+}
+
+TEST(infoPlistUtility, PreprocessLines)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+    Preprocessor preprocessor = Preprocessor(&filesystem);
+
+    /* Continued lines are joined, keeping a blank line for each one joined. */
+    EXPECT_EQ("\n1 + 2\n", Preprocess(&preprocessor,
+        "#define SUM 1 \\\n"
+        "+ 2\n"
+        "SUM\n"));
+    EXPECT_EQ("a b\n\nc\n", Preprocess(&preprocessor, "a \\\nb\nc\n"));
+
+    /* Errors report the line they're on in the file. */
+    std::string output;
+    auto result = preprocessor.process("/Info.plist",
+        "#define VALUE 1 \\\n"
+        "    + 2 \\\n"
+        "    + 3\n"
+        "/* block\n"
+        "   comment */\n"
+        "#error failed\n", false, &output);
+    EXPECT_FALSE(result.first);
+    EXPECT_EQ(0, result.second.find("/Info.plist:6: ")) << result.second;
+}
+
+TEST(infoPlistUtility, PreprocessInfoPlist)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("project", {
+            MemoryFilesystem::Entry::File("Info.plist", Contents(
+                "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<plist version=\"1.0\">\n"
+                "<dict>\n"
+                "    <key>CFBundleShortVersionString</key>\n"
+                "    <string>VERSION</string>\n"
+                "    <key>CFBundleIdentifier</key>\n"
+                "    <string>IDENTIFIER</string>\n"
+                "#if BETA\n"
+                "    <key>Beta</key>\n"
+                "    <string>yes</string>\n"
+                "#endif\n"
+                "</dict>\n"
+                "</plist>\n")),
+            MemoryFilesystem::Entry::File("Prefix.h", Contents(
+                "// Shared settings.\n"
+                "#include \"Identifier.h\"\n"
+                "#define BETA 0\n")),
+            MemoryFilesystem::Entry::File("Identifier.h", Contents(
+                "#define IDENTIFIER com.example.app\n")),
+        }),
+    });
+
+    Driver driver;
+    process::MemoryContext processContext = process::MemoryContext(
+        driver.name(),
+        "/project",
+        {
+            "-preprocess",
+            "-prefixheader", "Prefix.h",
+            "-DVERSION=1.2",
+            "Info.plist",
+            "-o", "/Info.plist",
+            "-dependencyfile", "/Info.plist.d",
+        },
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "root",
+        "wheel");
+    EXPECT_EQ(0, driver.run(&processContext, &filesystem));
+
+    std::vector<uint8_t> contents;
+    ASSERT_TRUE(filesystem.read(&contents, "/Info.plist"));
+
+    auto deserialize = plist::Format::Any::Deserialize(contents);
+    ASSERT_NE(nullptr, deserialize.first);
+    plist::Dictionary const *root = plist::CastTo<plist::Dictionary>(deserialize.first.get());
+    ASSERT_NE(nullptr, root);
+
+    EXPECT_EQ("1.2", root->value<plist::String>("CFBundleShortVersionString")->value());
+    EXPECT_EQ("com.example.app", root->value<plist::String>("CFBundleIdentifier")->value());
+    EXPECT_EQ(nullptr, root->value("Beta"));
+
+    /* Headers included by the prefix header are dependencies too. */
+    std::vector<uint8_t> dependencyContents;
+    ASSERT_TRUE(filesystem.read(&dependencyContents, "/Info.plist.d"));
+    ext::optional<dependency::MakefileDependencyInfo> dependencyInfo = dependency::MakefileDependencyInfo::Deserialize(std::string(dependencyContents.begin(), dependencyContents.end()));
+    ASSERT_TRUE(dependencyInfo);
+    ASSERT_EQ(1, dependencyInfo->dependencyInfo().size());
+    EXPECT_EQ(std::vector<std::string>({ "/Info.plist" }), dependencyInfo->dependencyInfo().front().outputs());
+    EXPECT_EQ(std::vector<std::string>({ "/project/Info.plist", "/project/Prefix.h", "/project/Identifier.h" }), dependencyInfo->dependencyInfo().front().inputs());
+}
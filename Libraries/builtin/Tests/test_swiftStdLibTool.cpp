@@ -0,0 +1,157 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <builtin/swiftStdLibTool/Driver.h>
+#include <libutil/MemoryFilesystem.h>
+#include <process/MemoryContext.h>
+
+using builtin::swiftStdLibTool::Driver;
+using libutil::MemoryFilesystem;
+
+static void
+AppendUInt32(std::vector<uint8_t> *contents, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i) {
+        contents->push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+/*
+ * A 64-bit Mach-O file that only links the given libraries.
+ */
+static std::vector<uint8_t>
+MachO(std::vector<std::string> const &libraries)
+{
+    std::vector<uint8_t> commands;
+    for (std::string const &library : libraries) {
+        uint32_t size = static_cast<uint32_t>((24 + library.size() + 1 + 7) & ~7);
+        AppendUInt32(&commands, 0xc); /* LC_LOAD_DYLIB */
+        AppendUInt32(&commands, size);
+        AppendUInt32(&commands, 24);
+        AppendUInt32(&commands, 0);
+        AppendUInt32(&commands, 0);
+        AppendUInt32(&commands, 0);
+        commands.insert(commands.end(), library.begin(), library.end());
+        commands.resize(commands.size() + (size - 24 - library.size()), 0);
+    }
+
+    std::vector<uint8_t> contents;
+    AppendUInt32(&contents, 0xfeedfacf);
+    AppendUInt32(&contents, 0x01000007);
+    AppendUInt32(&contents, 3);
+    AppendUInt32(&contents, 2);
+    AppendUInt32(&contents, static_cast<uint32_t>(libraries.size()));
+    AppendUInt32(&contents, static_cast<uint32_t>(commands.size()));
+    AppendUInt32(&contents, 0);
+    AppendUInt32(&contents, 0);
+    contents.insert(contents.end(), commands.begin(), commands.end());
+    return contents;
+}
+
+static int
+RunDriver(MemoryFilesystem *filesystem, std::vector<std::string> const &arguments)
+{
+    Driver driver;
+    process::MemoryContext processContext = process::MemoryContext(
+        driver.name(),
+        "/",
+        arguments,
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "root",
+        "wheel");
+    return driver.run(&processContext, filesystem);
+}
+
+TEST(swiftStdLibTool, Name)
+{
+    Driver driver;
+    EXPECT_EQ(driver.name(), "builtin-swiftStdLibTool");
+}
+
+TEST(swiftStdLibTool, CopyLinkedLibraries)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("toolchain", {
+            MemoryFilesystem::Entry::Directory("usr", {
+                MemoryFilesystem::Entry::Directory("lib", {
+                    MemoryFilesystem::Entry::Directory("swift", {
+                        MemoryFilesystem::Entry::Directory("iphoneos", {
+                            MemoryFilesystem::Entry::File("libswiftCore.dylib", MachO({ "/usr/lib/libSystem.B.dylib" })),
+                            MemoryFilesystem::Entry::File("libswiftDarwin.dylib", MachO({ "@rpath/libswiftCore.dylib" })),
+                            MemoryFilesystem::Entry::File("libswiftFoundation.dylib", MachO({ "@rpath/libswiftCore.dylib", "@rpath/libswiftDarwin.dylib" })),
+                            MemoryFilesystem::Entry::File("libswiftUIKit.dylib", MachO({ "@rpath/libswiftCore.dylib" })),
+                        }),
+                    }),
+                }),
+            }),
+        }),
+        MemoryFilesystem::Entry::Directory("App.app", {
+            MemoryFilesystem::Entry::File("App", MachO({ "/usr/lib/libSystem.B.dylib", "@rpath/libswiftCore.dylib" })),
+            MemoryFilesystem::Entry::Directory("Frameworks", {
+                MemoryFilesystem::Entry::Directory("Framework.framework", {
+                    MemoryFilesystem::Entry::File("Framework", MachO({ "@rpath/libswiftFoundation.dylib" })),
+                    MemoryFilesystem::Entry::File("Info.plist", std::vector<uint8_t>(16, 'x')),
+                }),
+            }),
+        }),
+    });
+
+    EXPECT_EQ(0, RunDriver(&filesystem, {
+        "--copy",
+        "--scan-executable", "App.app/App",
+        "--scan-folder", "App.app/Frameworks",
+        "--platform", "iphoneos",
+        "--toolchain", "/toolchain",
+        "--destination", "App.app/Frameworks",
+    }));
+
+    EXPECT_TRUE(filesystem.exists("/App.app/Frameworks/libswiftCore.dylib"));
+    EXPECT_TRUE(filesystem.exists("/App.app/Frameworks/libswiftDarwin.dylib"));
+    EXPECT_TRUE(filesystem.exists("/App.app/Frameworks/libswiftFoundation.dylib"));
+    EXPECT_FALSE(filesystem.exists("/App.app/Frameworks/libswiftUIKit.dylib"));
+
+    std::vector<uint8_t> contents;
+    EXPECT_TRUE(filesystem.read(&contents, "/App.app/Frameworks/libswiftDarwin.dylib"));
+    EXPECT_EQ(MachO({ "@rpath/libswiftCore.dylib" }), contents);
+}
+
+TEST(swiftStdLibTool, MissingLibrary)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("libraries", { }),
+        MemoryFilesystem::Entry::File("Missing", MachO({ "@rpath/libswiftCore.dylib" })),
+    });
+
+    EXPECT_NE(0, RunDriver(&filesystem, {
+        "--copy",
+        "--scan-executable", "Missing",
+        "--source-libraries", "libraries",
+        "--destination", "Frameworks",
+    }));
+    EXPECT_FALSE(filesystem.exists("/Frameworks"));
+}
+
+TEST(swiftStdLibTool, SigningUnsupported)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("libraries", { }),
+        MemoryFilesystem::Entry::File("Signed", MachO({ })),
+    });
+
+    EXPECT_NE(0, RunDriver(&filesystem, {
+        "--copy",
+        "--scan-executable", "Signed",
+        "--source-libraries", "libraries",
+        "--destination", "Frameworks",
+        "--sign", "-",
+    }));
+}
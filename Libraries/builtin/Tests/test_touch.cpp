@@ -0,0 +1,72 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <builtin/touch/Driver.h>
+#include <libutil/MemoryFilesystem.h>
+#include <process/MemoryContext.h>
+
+using builtin::touch::Driver;
+using libutil::MemoryFilesystem;
+
+static int
+RunDriver(MemoryFilesystem *filesystem, std::vector<std::string> const &arguments)
+{
+    Driver driver;
+    process::MemoryContext processContext = process::MemoryContext(
+        driver.name(),
+        "/",
+        arguments,
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "root",
+        "wheel");
+    return driver.run(&processContext, filesystem);
+}
+
+TEST(touch, Name)
+{
+    Driver driver;
+    EXPECT_EQ(driver.name(), "builtin-touch");
+}
+
+TEST(touch, UpdatesModificationTime)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("file", std::vector<uint8_t>({ 'a' })),
+    });
+
+    ext::optional<uint64_t> before = filesystem.modificationTime("/file");
+    ASSERT_TRUE(before);
+
+    EXPECT_EQ(0, RunDriver(&filesystem, { "-c", "file" }));
+
+    ext::optional<uint64_t> after = filesystem.modificationTime("/file");
+    ASSERT_TRUE(after);
+    EXPECT_GT(*after, *before);
+
+    /* Contents are unchanged. */
+    std::vector<uint8_t> contents;
+    EXPECT_TRUE(filesystem.read(&contents, "/file"));
+    EXPECT_EQ(std::vector<uint8_t>({ 'a' }), contents);
+}
+
+TEST(touch, MissingFile)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({ });
+
+    /* Not created with -c. */
+    EXPECT_EQ(0, RunDriver(&filesystem, { "-c", "missing" }));
+    EXPECT_FALSE(filesystem.exists("/missing"));
+
+    /* Created otherwise. */
+    EXPECT_EQ(0, RunDriver(&filesystem, { "missing" }));
+    EXPECT_TRUE(filesystem.exists("/missing"));
+}
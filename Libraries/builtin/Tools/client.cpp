@@ -0,0 +1,58 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <builtin/Server.h>
+#include <libutil/FSUtil.h>
+#include <process/DefaultContext.h>
+#include <process/MemoryContext.h>
+
+#include <cstdio>
+
+#include <unistd.h>
+
+using libutil::FSUtil;
+
+/*
+ * Runs a builtin in the builtin server named by a file, or if no server is
+ * running, runs the builtin's own executable from the same directory as this
+ * one.
+ *
+ * Usage: builtin-client server builtin [arguments...]
+ */
+int
+main(int argc, char **argv, char **envp)
+{
+    process::DefaultContext processContext = process::DefaultContext();
+
+    std::vector<std::string> const &arguments = processContext.commandLineArguments();
+    if (arguments.size() < 2) {
+        fprintf(stderr, "usage: builtin-client server builtin [arguments...]\n");
+        return 1;
+    }
+
+    std::string const &path = arguments[0];
+    std::string const &name = arguments[1];
+
+    process::MemoryContext context = process::MemoryContext(&processContext);
+    context.commandLineArguments() = std::vector<std::string>(arguments.begin() + 2, arguments.end());
+
+    if (ext::optional<int> exitCode = builtin::Server::Run(path, name, &context)) {
+        return *exitCode;
+    }
+
+    /*
+     * No server, so run the builtin directly. The remaining arguments
+     * start with the builtin name, which becomes its first argument.
+     */
+    std::string executable = FSUtil::GetDirectoryName(processContext.executablePath()) + "/" + name;
+    ::execv(executable.c_str(), &argv[2]);
+
+    ::perror("execv");
+    return 1;
+}
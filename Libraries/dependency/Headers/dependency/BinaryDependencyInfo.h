@@ -13,6 +13,7 @@
 #include <dependency/DependencyInfo.h>
 #include <dependency/DependencyInfoFormat.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -24,6 +25,17 @@ namespace dependency {
  * The binary dependency info format used by actool and ld64.
  */
 class BinaryDependencyInfo {
+public:
+    /*
+     * The kind of an entry in binary dependency info.
+     */
+    enum class Entry {
+        Version,
+        Input,
+        Missing,
+        Output,
+    };
+
 private:
     std::string              _version;
     std::vector<std::string> _missing;
@@ -73,6 +85,14 @@ public:
     static ext::optional<BinaryDependencyInfo>
     Deserialize(std::vector<uint8_t> const &contents);
 
+    /*
+     * Read binary data in place, calling back with each entry's kind and
+     * string without copying it. Returns false if the data is invalid,
+     * possibly after calling back with entries before the invalid one.
+     */
+    static bool
+    Scan(uint8_t const *contents, size_t size, std::function<void(Entry, char const *, size_t)> const &entry);
+
 public:
     /*
      * The dependency info format.
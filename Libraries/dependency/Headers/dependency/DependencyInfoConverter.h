@@ -0,0 +1,69 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __dependency_DependencyInfoConverter_h
+#define __dependency_DependencyInfoConverter_h
+
+#include <dependency/DependencyInfo.h>
+#include <dependency/DependencyInfoFormat.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+
+namespace dependency {
+
+/*
+ * Converts dependency info from any format to the Makefile format used by
+ * Ninja for depfiles.
+ */
+class DependencyInfoConverter {
+private:
+    DependencyInfoConverter();
+    ~DependencyInfoConverter();
+
+public:
+    /*
+     * Load dependency info of a format from a path.
+     */
+    static ext::optional<std::vector<DependencyInfo>>
+    Load(libutil::Filesystem const *filesystem, DependencyInfoFormat format, std::string const &path);
+
+public:
+    /*
+     * Serialize the inputs of dependency info as a Makefile rule for a single
+     * output. Relative inputs are resolved against the current directory, as
+     * Ninja requires paths to match exactly.
+     */
+    static std::string
+    Serialize(std::string const &currentDirectory, std::string const &output, std::vector<DependencyInfo> const &dependencyInfo);
+
+    /*
+     * Load dependency info of any format from each path and serialize all
+     * of their inputs together, like `Serialize()`. Binary and Makefile
+     * dependency info is read in place and written straight to the result.
+     */
+    static ext::optional<std::string>
+    Merge(libutil::Filesystem const *filesystem, std::string const &currentDirectory, std::string const &output, std::vector<std::pair<DependencyInfoFormat, std::string>> const &inputs);
+
+    /*
+     * Load dependency info of any format from each path and call a function
+     * with each of their inputs, resolved as in `Serialize()`.
+     */
+    static bool
+    Inputs(libutil::Filesystem const *filesystem, std::string const &currentDirectory, std::vector<std::pair<DependencyInfoFormat, std::string>> const &inputs, std::function<void(std::string const &)> const &input);
+};
+
+}
+
+#endif /* __dependency_DependencyInfoConverter_h */
@@ -13,6 +13,7 @@
 #include <dependency/DependencyInfo.h>
 #include <dependency/DependencyInfoFormat.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -53,6 +54,14 @@ public:
     static ext::optional<MakefileDependencyInfo>
     Deserialize(std::string const &contents);
 
+    /*
+     * Read Makefile contents in place, calling back with each rule's output
+     * and then each of its inputs, unescaped. Returns false if the contents
+     * are invalid, possibly after calling back for the rules before that.
+     */
+    static bool
+    Scan(char const *contents, size_t size, std::function<void(std::string const &)> const &output, std::function<void(std::string const &)> const &input);
+
 public:
     /*
      * The dependency info format.
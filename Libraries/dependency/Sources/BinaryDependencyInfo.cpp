@@ -10,7 +10,7 @@
 #include <dependency/BinaryDependencyInfo.h>
 #include <dependency/DependencyInfo.h>
 
-#include <algorithm>
+#include <cstring>
 
 using dependency::BinaryDependencyInfo;
 using dependency::DependencyInfo;
@@ -66,59 +66,80 @@ serialize() const
     return result;
 }
 
-ext::optional<BinaryDependencyInfo> BinaryDependencyInfo::
-Deserialize(std::vector<uint8_t> const &contents)
+bool BinaryDependencyInfo::
+Scan(uint8_t const *contents, size_t size, std::function<void(Entry, char const *, size_t)> const &entry)
 {
-    std::string version;
-    std::vector<std::string> inputs;
-    std::vector<std::string> outputs;
-    std::vector<std::string> missing;
+    bool version = false;
 
-    for (auto it = contents.begin(); it != contents.end(); ++it) {
+    uint8_t const *end = contents + size;
+    for (uint8_t const *it = contents; it != end; ++it) {
         /* Read command. */
         BinaryDependencyCommand command = static_cast<BinaryDependencyCommand>(*it);
-        if (++it == contents.end()) {
+        if (++it == end) {
             /* No string after command. */
-            return ext::nullopt;
+            return false;
         }
 
         /* Find end of string. */
-        auto end = std::find(it, contents.end(), '\0');
-        if (end == contents.end()) {
+        uint8_t const *terminator = static_cast<uint8_t const *>(::memchr(it, '\0', end - it));
+        if (terminator == nullptr) {
             /* Unterminated string. */
-            return ext::nullopt;
+            return false;
         }
 
-        /* Read string. */
-        std::string string = std::string(it, end);
+        char const *string = reinterpret_cast<char const *>(it);
+        size_t length = terminator - it;
 
         if (command == BinaryDependencyCommand::Version) {
-            if (!version.empty()) {
+            if (version) {
                 /* Multiple version commands. */
-                return ext::nullopt;
+                return false;
             }
 
-            version = string;
+            version = true;
+            entry(Entry::Version, string, length);
         } else if (command == BinaryDependencyCommand::Input) {
-            inputs.push_back(string);
+            entry(Entry::Input, string, length);
         } else if (command == BinaryDependencyCommand::Output) {
-            outputs.push_back(string);
+            entry(Entry::Output, string, length);
         } else if (command == BinaryDependencyCommand::Missing) {
-            missing.push_back(string);
+            entry(Entry::Missing, string, length);
         } else {
             /* Unknown command. */
-            return ext::nullopt;
+            return false;
         }
 
         /* Move onto the next entry. */
-        it = end;
+        it = terminator;
     }
 
-    /* Create dependency info. */
+    return true;
+}
+
+ext::optional<BinaryDependencyInfo> BinaryDependencyInfo::
+Deserialize(std::vector<uint8_t> const &contents)
+{
     BinaryDependencyInfo binaryInfo;
-    binaryInfo.version() = version;
-    binaryInfo.missing() = missing;
-    binaryInfo.dependencyInfo().inputs() = inputs;
-    binaryInfo.dependencyInfo().outputs() = outputs;
-    return BinaryDependencyInfo(binaryInfo);
+
+    bool valid = Scan(contents.data(), contents.size(), [&](Entry entry, char const *string, size_t length) {
+        switch (entry) {
+            case Entry::Version:
+                binaryInfo.version().assign(string, length);
+                break;
+            case Entry::Input:
+                binaryInfo.dependencyInfo().inputs().emplace_back(string, length);
+                break;
+            case Entry::Output:
+                binaryInfo.dependencyInfo().outputs().emplace_back(string, length);
+                break;
+            case Entry::Missing:
+                binaryInfo.missing().emplace_back(string, length);
+                break;
+        }
+    });
+    if (!valid) {
+        return ext::nullopt;
+    }
+
+    return binaryInfo;
 }
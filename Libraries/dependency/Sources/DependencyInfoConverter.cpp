@@ -0,0 +1,164 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <dependency/DependencyInfoConverter.h>
+#include <dependency/BinaryDependencyInfo.h>
+#include <dependency/DirectoryDependencyInfo.h>
+#include <dependency/MakefileDependencyInfo.h>
+#include <libutil/Escape.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <cassert>
+#include <cstdio>
+
+using dependency::DependencyInfoConverter;
+using dependency::DependencyInfo;
+using dependency::DependencyInfoFormat;
+using libutil::Escape;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+ext::optional<std::vector<DependencyInfo>> DependencyInfoConverter::
+Load(Filesystem const *filesystem, DependencyInfoFormat format, std::string const &path)
+{
+    if (format == DependencyInfoFormat::Binary) {
+        std::vector<uint8_t> contents;
+        if (!filesystem->read(&contents, path)) {
+            fprintf(stderr, "error: failed to open %s\n", path.c_str());
+            return ext::nullopt;
+        }
+
+        auto binaryInfo = dependency::BinaryDependencyInfo::Deserialize(contents);
+        if (!binaryInfo) {
+            fprintf(stderr, "error: invalid binary dependency info\n");
+            return ext::nullopt;
+        }
+
+        return std::vector<DependencyInfo>({ binaryInfo->dependencyInfo() });
+    } else if (format == DependencyInfoFormat::Directory) {
+        auto directoryInfo = dependency::DirectoryDependencyInfo::Deserialize(filesystem, path);
+        if (!directoryInfo) {
+            fprintf(stderr, "error: invalid directory\n");
+            return ext::nullopt;
+        }
+
+        return std::vector<DependencyInfo>({ directoryInfo->dependencyInfo() });
+    } else if (format == DependencyInfoFormat::Makefile) {
+        std::vector<uint8_t> contents;
+        if (!filesystem->read(&contents, path)) {
+            fprintf(stderr, "error: failed to open %s\n", path.c_str());
+            return ext::nullopt;
+        }
+
+        std::string makefileContents = std::string(contents.begin(), contents.end());
+        auto makefileInfo = dependency::MakefileDependencyInfo::Deserialize(makefileContents);
+        if (!makefileInfo) {
+            fprintf(stderr, "error: invalid makefile dependency info\n");
+            return ext::nullopt;
+        }
+
+        return makefileInfo->dependencyInfo();
+    } else {
+        assert(false);
+        return ext::nullopt;
+    }
+}
+
+std::string DependencyInfoConverter::
+Serialize(std::string const &currentDirectory, std::string const &output, std::vector<DependencyInfo> const &dependencyInfo)
+{
+    DependencyInfo combined;
+    combined.outputs() = { output };
+
+    /* Normalize path as Ninja requires matching paths. */
+    for (DependencyInfo const &info : dependencyInfo) {
+        for (std::string const &input : info.inputs()) {
+            std::string path = FSUtil::ResolveRelativePath(input, currentDirectory);
+            combined.inputs().push_back(path);
+        }
+    }
+
+    /* Serialize dependency info. */
+    dependency::MakefileDependencyInfo makefileInfo;
+    makefileInfo.dependencyInfo() = { combined };
+    return makefileInfo.serialize();
+}
+
+bool DependencyInfoConverter::
+Inputs(Filesystem const *filesystem, std::string const &currentDirectory, std::vector<std::pair<DependencyInfoFormat, std::string>> const &inputs, std::function<void(std::string const &)> const &input)
+{
+    std::string path;
+    auto resolved = [&](std::string const &value) {
+        input(FSUtil::ResolveRelativePath(value, currentDirectory));
+    };
+
+    for (std::pair<DependencyInfoFormat, std::string> const &entry : inputs) {
+        DependencyInfoFormat format = entry.first;
+
+        if (format == DependencyInfoFormat::Binary || format == DependencyInfoFormat::Makefile) {
+            std::unique_ptr<Filesystem::Mapping> contents = filesystem->readMapped(entry.second);
+            if (contents == nullptr) {
+                fprintf(stderr, "error: failed to open %s\n", entry.second.c_str());
+                return false;
+            }
+
+            if (format == DependencyInfoFormat::Binary) {
+                bool valid = dependency::BinaryDependencyInfo::Scan(contents->data(), contents->size(), [&](dependency::BinaryDependencyInfo::Entry kind, char const *string, size_t length) {
+                    if (kind == dependency::BinaryDependencyInfo::Entry::Input) {
+                        path.assign(string, length);
+                        resolved(path);
+                    }
+                });
+                if (!valid) {
+                    fprintf(stderr, "error: invalid binary dependency info\n");
+                    return false;
+                }
+            } else {
+                bool valid = dependency::MakefileDependencyInfo::Scan(reinterpret_cast<char const *>(contents->data()), contents->size(), [](std::string const &) {
+                }, resolved);
+                if (!valid) {
+                    fprintf(stderr, "error: invalid makefile dependency info\n");
+                    return false;
+                }
+            }
+        } else {
+            ext::optional<std::vector<DependencyInfo>> info = Load(filesystem, format, entry.second);
+            if (!info) {
+                return false;
+            }
+
+            for (DependencyInfo const &dependencyInfo : *info) {
+                for (std::string const &value : dependencyInfo.inputs()) {
+                    resolved(value);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+ext::optional<std::string> DependencyInfoConverter::
+Merge(Filesystem const *filesystem, std::string const &currentDirectory, std::string const &output, std::vector<std::pair<DependencyInfoFormat, std::string>> const &inputs)
+{
+    std::string result = Escape::Makefile(output);
+    result += ":";
+
+    bool valid = Inputs(filesystem, currentDirectory, inputs, [&](std::string const &input) {
+        result += " \\\n";
+        result += "  ";
+        Escape::Makefile(input, &result);
+    });
+    if (!valid) {
+        return ext::nullopt;
+    }
+
+    return result;
+}
@@ -33,7 +33,7 @@ Deserialize(Filesystem const *filesystem, std::string const &directory)
     }
 
     /* Recursively add all paths under this directory. */
-    filesystem->enumerateRecursive(directory, [&](std::string const &path) -> bool {
+    filesystem->enumerateRecursive(directory, [&](std::string const &path, bool) -> bool {
         inputs.push_back(path);
         return true;
     });
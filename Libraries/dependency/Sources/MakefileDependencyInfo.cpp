@@ -59,11 +59,9 @@ serialize() const
     return result;
 }
 
-ext::optional<MakefileDependencyInfo> MakefileDependencyInfo::
-Deserialize(std::string const &contents)
+bool MakefileDependencyInfo::
+Scan(char const *contents, size_t size, std::function<void(std::string const &)> const &output, std::function<void(std::string const &)> const &input)
 {
-    std::vector<DependencyInfo> dependencyInfo;
-
     enum class State {
         Begin,
         Comment,
@@ -73,11 +71,15 @@ Deserialize(std::string const &contents)
 
     State state = State::Begin;
 
+    /* Reused between paths, so most don't allocate. */
     std::string current;
-    DependencyInfo currentDependencyInfo;
 
-    for (auto it = contents.begin(), prev = contents.end(); it != contents.end(); prev = it, ++it) {
-        bool escaped = (prev != contents.end() && *prev == '\\');
+    /* If the current line has an output; comments can end a line without. */
+    bool rule = false;
+
+    char const *end = contents + size;
+    for (char const *it = contents, *prev = nullptr; it != end; prev = it, ++it) {
+        bool escaped = (prev != nullptr && *prev == '\\');
 
         if (!escaped && *it == '#') {
             /* Begin comment. */
@@ -88,23 +90,18 @@ Deserialize(std::string const &contents)
                     break;
                 case State::Output:
                     /* Output without inputs. */
-                    return ext::nullopt;
+                    return false;
                 case State::Comment:
                 case State::Inputs:
                     /* Current input. */
                     if (!current.empty()) {
-                        currentDependencyInfo.inputs().push_back(current);
-                        current = std::string();
-                    }
-
-                    /* Store this output and inputs. */
-                    if (!currentDependencyInfo.outputs().empty()) {
-                        dependencyInfo.push_back(currentDependencyInfo);
-
-                        /* Reset for next entry. */
-                        currentDependencyInfo = DependencyInfo();
+                        if (rule) {
+                            input(current);
+                        }
+                        current.clear();
                     }
 
+                    rule = false;
                     state = State::Begin;
                     break;
             }
@@ -122,8 +119,8 @@ Deserialize(std::string const &contents)
 
                     /* Next input. */
                     if (!current.empty()) {
-                        currentDependencyInfo.inputs().push_back(current);
-                        current = std::string();
+                        input(current);
+                        current.clear();
                     }
                     break;
             }
@@ -131,26 +128,27 @@ Deserialize(std::string const &contents)
             switch (state) {
                 case State::Begin:
                     /* Invalid character. */
-                    return ext::nullopt;
+                    return false;
                 case State::Comment:
                     break;
                 case State::Output:
                     assert(!current.empty());
 
                     /* Wait for inputs. */
-                    currentDependencyInfo.outputs().push_back(current);
-                    current = std::string();
+                    output(current);
+                    current.clear();
+                    rule = true;
                     state = State::Inputs;
                     break;
                 case State::Inputs:
                     /* Invalid character. */
-                    return ext::nullopt;
+                    return false;
             }
         } else if (*it == '#' || *it == '%' || (escaped && isspace(*it))) {
             switch (state) {
                 case State::Begin:
                     /* Invalid character. */
-                    return ext::nullopt;
+                    return false;
                 case State::Comment:
                     break;
                 case State::Output:
@@ -161,7 +159,7 @@ Deserialize(std::string const &contents)
                         break;
                     } else {
                         /* Invalid character. */
-                        return ext::nullopt;
+                        return false;
                     }
             }
         } else {
@@ -189,23 +187,35 @@ Deserialize(std::string const &contents)
             break;
         case State::Output:
             /* Output without inputs. */
-            return ext::nullopt;
+            return false;
         case State::Comment:
         case State::Inputs:
             /* Current input. */
-            if (!current.empty()) {
-                currentDependencyInfo.inputs().push_back(current);
-            }
-
-            /* Store this output and inputs. */
-            if (!currentDependencyInfo.outputs().empty()) {
-                dependencyInfo.push_back(currentDependencyInfo);
+            if (rule && !current.empty()) {
+                input(current);
             }
             break;
     }
 
-    /* Create dependency info. */
+    return true;
+}
+
+ext::optional<MakefileDependencyInfo> MakefileDependencyInfo::
+Deserialize(std::string const &contents)
+{
     MakefileDependencyInfo makefileInfo;
-    makefileInfo.dependencyInfo() = dependencyInfo;
+    std::vector<DependencyInfo> *dependencyInfo = &makefileInfo.dependencyInfo();
+
+    /* Each rule has one output, which starts it. */
+    bool valid = Scan(contents.data(), contents.size(), [&](std::string const &output) {
+        dependencyInfo->push_back(DependencyInfo());
+        dependencyInfo->back().outputs().push_back(output);
+    }, [&](std::string const &input) {
+        dependencyInfo->back().inputs().push_back(input);
+    });
+    if (!valid) {
+        return ext::nullopt;
+    }
+
     return makefileInfo;
 }
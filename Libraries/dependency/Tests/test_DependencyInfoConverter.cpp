@@ -0,0 +1,59 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <dependency/DependencyInfoConverter.h>
+#include <libutil/MemoryFilesystem.h>
+
+using dependency::DependencyInfoConverter;
+using dependency::DependencyInfoFormat;
+using dependency::DependencyInfo;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+TEST(DependencyInfoConverter, Merge)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("binary", { 0x40, 'o', '\0', 0x10, 'i', 'n', '1', '\0', 0x11, 'm', '\0', 0x10, '/', 'i', 'n', ' ', '2', '\0' }),
+        MemoryFilesystem::Entry::File("makefile", Contents("out: in3 \\\n  /dir/in\\ 4\n")),
+    });
+
+    std::vector<std::pair<DependencyInfoFormat, std::string>> inputs = {
+        { DependencyInfoFormat::Binary, "/binary" },
+        { DependencyInfoFormat::Makefile, "/makefile" },
+    };
+
+    /* Same as loading each and serializing them together. */
+    std::vector<DependencyInfo> info;
+    for (auto const &input : inputs) {
+        auto loaded = DependencyInfoConverter::Load(&filesystem, input.first, input.second);
+        ASSERT_NE(ext::nullopt, loaded);
+        info.insert(info.end(), loaded->begin(), loaded->end());
+    }
+
+    ext::optional<std::string> merged = DependencyInfoConverter::Merge(&filesystem, "/root", "out:put", inputs);
+    ASSERT_NE(ext::nullopt, merged);
+    EXPECT_EQ(DependencyInfoConverter::Serialize("/root", "out:put", info), *merged);
+    EXPECT_EQ("out\\:put: \\\n  /root/in1 \\\n  /in\\ 2 \\\n  /root/in3 \\\n  /dir/in\\ 4", *merged);
+}
+
+TEST(DependencyInfoConverter, MergeInvalid)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("binary", { 0x10, 'i', 'n' }),
+    });
+
+    EXPECT_EQ(ext::nullopt, DependencyInfoConverter::Merge(&filesystem, "/", "out", { { DependencyInfoFormat::Binary, "/binary" } }));
+    EXPECT_EQ(ext::nullopt, DependencyInfoConverter::Merge(&filesystem, "/", "out", { { DependencyInfoFormat::Makefile, "/missing" } }));
+}
@@ -16,11 +16,7 @@
 #include <process/Context.h>
 
 #include <dependency/DependencyInfo.h>
-#include <dependency/BinaryDependencyInfo.h>
-#include <dependency/DirectoryDependencyInfo.h>
-#include <dependency/MakefileDependencyInfo.h>
-
-#include <cassert>
+#include <dependency/DependencyInfoConverter.h>
 
 using libutil::Escape;
 using libutil::DefaultFilesystem;
@@ -143,73 +139,6 @@ Version()
     return 0;
 }
 
-static bool
-LoadDependencyInfo(Filesystem const *filesystem, std::string const &path, dependency::DependencyInfoFormat format, std::vector<dependency::DependencyInfo> *dependencyInfo)
-{
-    if (format == dependency::DependencyInfoFormat::Binary) {
-        std::vector<uint8_t> contents;
-        if (!filesystem->read(&contents, path)) {
-            fprintf(stderr, "error: failed to open %s\n", path.c_str());
-            return false;
-        }
-
-        auto binaryInfo = dependency::BinaryDependencyInfo::Deserialize(contents);
-        if (!binaryInfo) {
-            fprintf(stderr, "error: invalid binary dependency info\n");
-            return false;
-        }
-
-        dependencyInfo->push_back(binaryInfo->dependencyInfo());
-        return true;
-    } else if (format == dependency::DependencyInfoFormat::Directory) {
-        auto directoryInfo = dependency::DirectoryDependencyInfo::Deserialize(filesystem, path);
-        if (!directoryInfo) {
-            fprintf(stderr, "error: invalid directory\n");
-            return false;
-        }
-
-        dependencyInfo->push_back(directoryInfo->dependencyInfo());
-        return true;
-    } else if (format == dependency::DependencyInfoFormat::Makefile) {
-        std::vector<uint8_t> contents;
-        if (!filesystem->read(&contents, path)) {
-            fprintf(stderr, "error: failed to open %s\n", path.c_str());
-            return false;
-        }
-
-        std::string makefileContents = std::string(contents.begin(), contents.end());
-        auto makefileInfo = dependency::MakefileDependencyInfo::Deserialize(makefileContents);
-        if (!makefileInfo) {
-            fprintf(stderr, "error: invalid makefile dependency info\n");
-            return false;
-        }
-
-        dependencyInfo->insert(dependencyInfo->end(), makefileInfo->dependencyInfo().begin(), makefileInfo->dependencyInfo().end());
-        return true;
-    } else {
-        assert(false);
-        return false;
-    }
-}
-
-static std::string
-SerializeMakefileDependencyInfo(std::string const &currentDirectory, std::string const &output, std::vector<std::string> const &inputs)
-{
-    dependency::DependencyInfo dependencyInfo;
-    dependencyInfo.outputs() = { output };
-
-    /* Normalize path as Ninja requires matching paths. */
-    for (std::string const &input : inputs) {
-        std::string path = FSUtil::ResolveRelativePath(input, currentDirectory);
-        dependencyInfo.inputs().push_back(path);
-    }
-
-    /* Serialize dependency info. */
-    dependency::MakefileDependencyInfo makefileInfo;
-    makefileInfo.dependencyInfo() = { dependencyInfo };
-    return makefileInfo.serialize();
-}
-
 int
 main(int argc, char **argv)
 {
@@ -241,30 +170,18 @@ main(int argc, char **argv)
         return Help("missing option(s)");
     }
 
-    std::vector<std::string> inputs;
-    for (std::pair<dependency::DependencyInfoFormat, std::string> const &input : options.inputs()) {
-        /*
-         * Load the dependency info.
-         */
-        std::vector<dependency::DependencyInfo> info;
-        if (!LoadDependencyInfo(&filesystem, input.second, input.first, &info)) {
-            return -1;
-        }
-
-        for (dependency::DependencyInfo const &dependencyInfo : info) {
-            inputs.insert(inputs.end(), dependencyInfo.inputs().begin(), dependencyInfo.inputs().end());
-        }
-    }
-
     /*
-     * Serialize the output.
+     * Load the dependency info and serialize the output.
      */
-    std::string contents = SerializeMakefileDependencyInfo(processContext.currentDirectory(), *options.name(), inputs);
+    ext::optional<std::string> contents = dependency::DependencyInfoConverter::Merge(&filesystem, processContext.currentDirectory(), *options.name(), options.inputs());
+    if (!contents) {
+        return -1;
+    }
 
     /*
      * Write out the output.
      */
-    std::vector<uint8_t> makefileContents = std::vector<uint8_t>(contents.begin(), contents.end());
+    std::vector<uint8_t> makefileContents = std::vector<uint8_t>(contents->begin(), contents->end());
     if (!filesystem.write(makefileContents, *options.output())) {
         return false;
     }
@@ -0,0 +1,95 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __graphics_Atlas_h
+#define __graphics_Atlas_h
+
+#include <graphics/Image.h>
+
+#include <vector>
+#include <ext/optional>
+
+namespace graphics {
+
+/*
+ * Packing of many small images into a few large pages. Rectangles are
+ * placed with the maximal rectangles algorithm, choosing the free space
+ * that leaves the shortest side over, and can be rotated to fit better.
+ */
+class Atlas {
+public:
+    /*
+     * A region of an image, in pixels.
+     */
+    struct Rect {
+        size_t x;
+        size_t y;
+        size_t width;
+        size_t height;
+    };
+
+    /*
+     * Where a rectangle was placed. If rotated, it's turned a quarter
+     * clockwise, so its width runs down the page.
+     */
+    struct Placement {
+        size_t page;
+        size_t x;
+        size_t y;
+        bool   rotated;
+    };
+
+    /*
+     * How rectangles are packed.
+     */
+    struct Options {
+        size_t pageWidth;
+        size_t pageHeight;
+        /*
+         * Empty pixels kept between rectangles, so filtering doesn't
+         * bleed neighbors into each other.
+         */
+        size_t padding;
+        bool   rotation;
+    };
+
+private:
+    Atlas();
+    ~Atlas();
+
+public:
+    /*
+     * The smallest region containing every visible pixel. An image with
+     * no alpha is entirely visible; an entirely transparent image has an
+     * empty region.
+     */
+    static Rect
+    Trim(Image const &image);
+
+    /*
+     * Pack rectangles of the given sizes, with rectangle widths and
+     * heights in the first and second of each pair. Placements are in
+     * the same order as the sizes. Returns nothing if a rectangle can't
+     * fit on a page even alone.
+     */
+    static ext::optional<std::vector<Placement>>
+    Pack(std::vector<std::pair<size_t, size_t>> const &sizes, Options const &options);
+
+    /*
+     * Copy a region of an image into a page at a position, rotating it
+     * if requested. Both images must have the same pixel format and the
+     * region must fit in the page.
+     */
+    static void
+    Blit(Image *page, size_t x, size_t y, bool rotated, Image const &image, Rect const &region);
+};
+
+}
+
+#endif  // !__graphics_Atlas_h
@@ -13,6 +13,7 @@
 #include <graphics/Image.h>
 #include <graphics/PixelFormat.h>
 
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -34,14 +35,47 @@ public:
      * Read a PNG image.
      */
     static std::pair<ext::optional<Image>, std::string>
-    Read(std::vector<uint8_t> const &contents);
+    Read(uint8_t const *contents, size_t size)
+    { return Read(contents, size, nullptr); }
+
+    static std::pair<ext::optional<Image>, std::string>
+    Read(std::vector<uint8_t> const &contents)
+    { return Read(contents.data(), contents.size()); }
+
+    /*
+     * Read a PNG image, converting it to the pixel format returned for the
+     * decoded format. Rows are converted as they are decoded, so the image
+     * is never held in both formats at once.
+     */
+    static std::pair<ext::optional<Image>, std::string>
+    Read(uint8_t const *contents, size_t size, std::function<PixelFormat(PixelFormat const &)> const &convert);
 
 public:
     /*
-     * Write a PNG image.
+     * How to trade off writing speed against size.
+     */
+    enum class Compression {
+        /*
+         * Write quickly, for images that are soon read back or replaced.
+         */
+        Fast,
+        /*
+         * Balance speed and size.
+         */
+        Default,
+        /*
+         * Write the smallest images, taking longer.
+         */
+        Small,
+    };
+
+    /*
+     * Write a PNG image. Each row is filtered with whichever PNG filter is
+     * estimated to compress it best, and large images are compressed in
+     * blocks in parallel.
      */
     static std::pair<ext::optional<std::vector<uint8_t>>, std::string>
-    Write(Image const &image);
+    Write(Image const &image, Compression compression = Compression::Default);
 };
 
 }
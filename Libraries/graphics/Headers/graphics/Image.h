@@ -31,6 +31,7 @@ private:
 
 public:
     Image(size_t width, size_t height, PixelFormat format, std::vector<uint8_t> const &data);
+    Image(size_t width, size_t height, PixelFormat format, std::vector<uint8_t> &&data);
 
 public:
     /*
@@ -57,6 +58,8 @@ public:
      */
     std::vector<uint8_t> const &data() const
     { return _data; }
+    std::vector<uint8_t> &data()
+    { return _data; }
 };
 
 }
@@ -142,6 +142,17 @@ public:
         std::vector<uint8_t> const &pixels,
         PixelFormat const &from,
         PixelFormat const &to);
+
+    /*
+     * Convert a number of pixels into an existing buffer, such as one row
+     * of a larger image. The result must have room for them all.
+     */
+    static void Convert(
+        uint8_t const *pixels,
+        size_t count,
+        PixelFormat const &from,
+        uint8_t *result,
+        PixelFormat const &to);
 };
 
 }
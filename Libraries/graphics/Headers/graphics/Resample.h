@@ -0,0 +1,70 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __graphics_Resample_h
+#define __graphics_Resample_h
+
+#include <graphics/Image.h>
+
+#include <vector>
+#include <ext/optional>
+
+namespace graphics {
+
+/*
+ * Cropping and scaling of images. Scaling filters horizontally and then
+ * vertically, with fixed-point weights computed once per image, and large
+ * images are split across threads. Images with straight alpha are filtered
+ * premultiplied, so transparent pixels don't bleed into their neighbors.
+ */
+class Resample {
+public:
+    /*
+     * The filter used to compute each scaled pixel.
+     */
+    enum class Filter {
+        /*
+         * Average of the covered pixels. Exact for halving.
+         */
+        Box,
+        /*
+         * Three-lobed Lanczos. Sharper, for arbitrary sizes.
+         */
+        Lanczos,
+    };
+
+private:
+    Resample();
+    ~Resample();
+
+public:
+    /*
+     * Copy a region of an image. Returns nothing if the region is empty
+     * or extends past the image.
+     */
+    static ext::optional<Image>
+    Crop(Image const &image, size_t x, size_t y, size_t width, size_t height);
+
+    /*
+     * Scale an image to a new size. Returns nothing if the size is empty.
+     */
+    static ext::optional<Image>
+    Scale(Image const &image, size_t width, size_t height, Filter filter);
+
+    /*
+     * The mipmap chain below an image: each level is half the size of
+     * the one before it, rounded down, until the last is one pixel.
+     */
+    static std::vector<Image>
+    Mipmaps(Image const &image, Filter filter);
+};
+
+}
+
+#endif  // !__graphics_Resample_h
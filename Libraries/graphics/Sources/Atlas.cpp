@@ -0,0 +1,326 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <graphics/Atlas.h>
+
+#include <algorithm>
+
+#include <cassert>
+#include <cstring>
+
+using graphics::Atlas;
+using graphics::Image;
+using graphics::PixelFormat;
+
+/*
+ * The byte offset of alpha within a pixel, if the format has alpha.
+ */
+static ext::optional<size_t>
+AlphaOffset(PixelFormat const &format)
+{
+    bool first;
+    switch (format.alpha()) {
+        case PixelFormat::Alpha::First:
+        case PixelFormat::Alpha::PremultipliedFirst:
+            first = true;
+            break;
+        case PixelFormat::Alpha::Last:
+        case PixelFormat::Alpha::PremultipliedLast:
+            first = false;
+            break;
+        default:
+            return ext::nullopt;
+    }
+
+    /* Reversing the channels moves alpha to the other end. */
+    if (format.order() == PixelFormat::Order::Reversed) {
+        first = !first;
+    }
+
+    return (first ? 0 : format.bytesPerPixel() - 1);
+}
+
+Atlas::Rect Atlas::
+Trim(Image const &image)
+{
+    ext::optional<size_t> alpha = AlphaOffset(image.format());
+    if (!alpha) {
+        return { 0, 0, image.width(), image.height() };
+    }
+
+    size_t bytesPerPixel = image.format().bytesPerPixel();
+    size_t stride = image.width() * bytesPerPixel;
+    uint8_t const *data = image.data().data();
+
+    size_t left = image.width();
+    size_t right = 0;
+    size_t top = image.height();
+    size_t bottom = 0;
+
+    for (size_t y = 0; y < image.height(); y++) {
+        uint8_t const *row = data + y * stride + *alpha;
+
+        size_t x = 0;
+        while (x < image.width() && row[x * bytesPerPixel] == 0) {
+            x++;
+        }
+        if (x == image.width()) {
+            continue;
+        }
+
+        /* Only columns right of the current bounds can extend them. */
+        size_t last = image.width() - 1;
+        while (last > x && last >= right && row[last * bytesPerPixel] == 0) {
+            last--;
+        }
+
+        left = std::min(left, x);
+        right = std::max(right, last + 1);
+        top = std::min(top, y);
+        bottom = y + 1;
+    }
+
+    if (top == image.height()) {
+        return { 0, 0, 0, 0 };
+    }
+
+    return { left, top, right - left, bottom - top };
+}
+
+namespace {
+
+/*
+ * The free space remaining on a page, as possibly overlapping maximal
+ * rectangles.
+ */
+class Page {
+private:
+    std::vector<Atlas::Rect> _free;
+    bool                     _empty;
+
+public:
+    Page(size_t width, size_t height) :
+        _free({ { 0, 0, width, height } }),
+        _empty(true)
+    {
+    }
+
+public:
+    /*
+     * If nothing has been placed on the page.
+     */
+    bool empty() const
+    { return _empty; }
+
+public:
+    /*
+     * Find the free rectangle that fits a size with the least left over
+     * on its shorter side. Returns the score, lower being better.
+     */
+    ext::optional<std::pair<size_t, size_t>>
+    find(size_t width, size_t height, Atlas::Rect *found) const
+    {
+        ext::optional<std::pair<size_t, size_t>> best;
+
+        for (size_t i = 0; i < _free.size(); i++) {
+            Atlas::Rect const &rect = _free[i];
+            if (rect.width < width || rect.height < height) {
+                continue;
+            }
+
+            size_t dx = rect.width - width;
+            size_t dy = rect.height - height;
+            auto score = std::make_pair(std::min(dx, dy), std::max(dx, dy));
+            if (!best || score < *best) {
+                best = score;
+                *found = rect;
+            }
+        }
+
+        return best;
+    }
+
+    /*
+     * Take a rectangle from the free space.
+     */
+    void
+    place(Atlas::Rect const &used)
+    {
+        _empty = false;
+
+        std::vector<Atlas::Rect> split;
+        split.reserve(_free.size() + 4);
+
+        for (Atlas::Rect const &rect : _free) {
+            if (used.x >= rect.x + rect.width || used.x + used.width <= rect.x ||
+                used.y >= rect.y + rect.height || used.y + used.height <= rect.y) {
+                split.push_back(rect);
+                continue;
+            }
+
+            /* Keep the maximal free rectangles on each side of the used one. */
+            if (used.x > rect.x) {
+                split.push_back({ rect.x, rect.y, used.x - rect.x, rect.height });
+            }
+            if (used.x + used.width < rect.x + rect.width) {
+                size_t x = used.x + used.width;
+                split.push_back({ x, rect.y, rect.x + rect.width - x, rect.height });
+            }
+            if (used.y > rect.y) {
+                split.push_back({ rect.x, rect.y, rect.width, used.y - rect.y });
+            }
+            if (used.y + used.height < rect.y + rect.height) {
+                size_t y = used.y + used.height;
+                split.push_back({ rect.x, y, rect.width, rect.y + rect.height - y });
+            }
+        }
+
+        /* Drop rectangles contained by others; they can never fit more. */
+        _free.clear();
+        for (size_t i = 0; i < split.size(); i++) {
+            Atlas::Rect const &a = split[i];
+
+            bool contained = false;
+            for (size_t j = 0; j < split.size() && !contained; j++) {
+                if (i == j) {
+                    continue;
+                }
+
+                Atlas::Rect const &b = split[j];
+                bool inside = (a.x >= b.x && a.y >= b.y &&
+                    a.x + a.width <= b.x + b.width && a.y + a.height <= b.y + b.height);
+
+                /* Of identical rectangles, keep only the first. */
+                bool same = (a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height);
+                contained = inside && (!same || j < i);
+            }
+
+            if (!contained) {
+                _free.push_back(a);
+            }
+        }
+    }
+};
+
+}
+
+ext::optional<std::vector<Atlas::Placement>> Atlas::
+Pack(std::vector<std::pair<size_t, size_t>> const &sizes, Options const &options)
+{
+    /*
+     * Padding is added to the right and bottom of each rectangle. The page
+     * is grown by the same amount, so rectangles can touch its far edges.
+     */
+    size_t pageWidth = options.pageWidth + options.padding;
+    size_t pageHeight = options.pageHeight + options.padding;
+
+    /* Placing large rectangles first leaves the small ones for the gaps. */
+    std::vector<size_t> order = std::vector<size_t>(sizes.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        size_t sa = std::max(sizes[a].first, sizes[a].second);
+        size_t sb = std::max(sizes[b].first, sizes[b].second);
+        if (sa != sb) {
+            return sa > sb;
+        }
+
+        return sizes[a].first * sizes[a].second > sizes[b].first * sizes[b].second;
+    });
+
+    std::vector<Page> pages;
+    std::vector<Placement> placements = std::vector<Placement>(sizes.size());
+
+    for (size_t i : order) {
+        size_t width = sizes[i].first;
+        size_t height = sizes[i].second;
+
+        /* Empty rectangles take no space. */
+        if (width == 0 || height == 0) {
+            placements[i] = { 0, 0, 0, false };
+            continue;
+        }
+
+        width += options.padding;
+        height += options.padding;
+
+        bool placed = false;
+        for (size_t p = 0; p <= pages.size() && !placed; p++) {
+            if (p == pages.size()) {
+                pages.push_back(Page(pageWidth, pageHeight));
+            }
+            Page &page = pages[p];
+
+            Rect chosen;
+            ext::optional<std::pair<size_t, size_t>> score = page.find(width, height, &chosen);
+            bool rotated = false;
+
+            if (options.rotation && width != height) {
+                Rect rotatedChosen;
+                ext::optional<std::pair<size_t, size_t>> rotatedScore = page.find(height, width, &rotatedChosen);
+                if (rotatedScore && (!score || *rotatedScore < *score)) {
+                    score = rotatedScore;
+                    chosen = rotatedChosen;
+                    rotated = true;
+                }
+            }
+
+            if (!score) {
+                /* A new page that can't fit the rectangle never will. */
+                if (p == pages.size() - 1 && page.empty()) {
+                    return ext::nullopt;
+                }
+                continue;
+            }
+
+            /* Place in the corner of the chosen free rectangle. */
+            page.place({ chosen.x, chosen.y, (rotated ? height : width), (rotated ? width : height) });
+            placements[i] = { p, chosen.x, chosen.y, rotated };
+            placed = true;
+        }
+    }
+
+    return placements;
+}
+
+void Atlas::
+Blit(Image *page, size_t x, size_t y, bool rotated, Image const &image, Rect const &region)
+{
+    size_t bytesPerPixel = image.format().bytesPerPixel();
+    assert(page->format().bytesPerPixel() == bytesPerPixel);
+    assert(region.x + region.width <= image.width() && region.y + region.height <= image.height());
+    assert((rotated ? x + region.height : x + region.width) <= page->width());
+    assert((rotated ? y + region.width : y + region.height) <= page->height());
+
+    size_t sourceStride = image.width() * bytesPerPixel;
+    size_t pageStride = page->width() * bytesPerPixel;
+    uint8_t const *source = image.data().data() + region.y * sourceStride + region.x * bytesPerPixel;
+    uint8_t *destination = page->data().data() + y * pageStride + x * bytesPerPixel;
+
+    if (!rotated) {
+        /* Rows are contiguous in both images, so copy them whole. */
+        size_t bytes = region.width * bytesPerPixel;
+        for (size_t row = 0; row < region.height; row++) {
+            memcpy(destination + row * pageStride, source + row * sourceStride, bytes);
+        }
+    } else {
+        /*
+         * Turning clockwise, each source row becomes a page column, with
+         * the last source row on the left.
+         */
+        for (size_t row = 0; row < region.height; row++) {
+            uint8_t const *from = source + row * sourceStride;
+            uint8_t *to = destination + (region.height - 1 - row) * bytesPerPixel;
+            for (size_t column = 0; column < region.width; column++) {
+                memcpy(to + column * pageStride, from + column * bytesPerPixel, bytesPerPixel);
+            }
+        }
+    }
+}
@@ -16,6 +16,12 @@ using graphics::Format::PNG;
 using graphics::Image;
 using graphics::PixelFormat;
 
+static bool
+SamePixelFormat(PixelFormat const &a, PixelFormat const &b)
+{
+    return a.color() == b.color() && a.order() == b.order() && a.alpha() == b.alpha();
+}
+
 #if defined(__APPLE__)
 
 #include <CoreFoundation/CoreFoundation.h>
@@ -108,13 +114,13 @@ PixelFormatFromCGColorSpaceAndCGBitmapInfo(CGColorSpaceRef colorSpace, CGBitmapI
     return PixelFormat(color, order, alpha);
 }
 
-std::pair<ext::optional<Image>, std::string> PNG::
-Read(std::vector<uint8_t> const &contents)
+static std::pair<ext::optional<Image>, std::string>
+ReadImage(uint8_t const *contents, size_t size)
 {
     /*
      * Load the image.
      */
-    auto data = CFHandle<CFDataRef>(CFDataCreateWithBytesNoCopy(kCFAllocatorDefault, contents.data(), contents.size(), kCFAllocatorNull));
+    auto data = CFHandle<CFDataRef>(CFDataCreateWithBytesNoCopy(kCFAllocatorDefault, contents, size, kCFAllocatorNull));
     if (data == NULL) {
         return std::make_pair(ext::nullopt, "unable to create data");
     }
@@ -167,7 +173,7 @@ Read(std::vector<uint8_t> const &contents)
         CFRange range = CFRangeMake(0, CFDataGetLength(data.get()));
         CFDataGetBytes(data.get(), range, pixels.data());
 
-        Image image = Image(width, height, *format, pixels);
+        Image image = Image(width, height, *format, std::move(pixels));
         return std::make_pair(image, std::string());
     } else {
         /*
@@ -202,38 +208,67 @@ Read(std::vector<uint8_t> const &contents)
             auto intermediateFormat = *PixelFormatFromCGColorSpaceAndCGBitmapInfo(colorSpace.get(), bitmapInfo);
             auto format = PixelFormat(PixelFormat::Color::Grayscale, intermediateFormat.order(), intermediateFormat.alpha());
             std::vector<uint8_t> pixels = PixelFormat::Convert(backing, intermediateFormat, format);
-            Image image = Image(width, height, format, pixels);
+            Image image = Image(width, height, format, std::move(pixels));
             return std::make_pair(image, std::string());
         } else {
             /* Not grayscale, return it as-is. */
             PixelFormat format = *PixelFormatFromCGColorSpaceAndCGBitmapInfo(colorSpace.get(), bitmapInfo);
-            Image image = Image(width, height, format, backing);
+            Image image = Image(width, height, format, std::move(backing));
             return std::make_pair(image, std::string());
         }
     }
 }
 
+std::pair<ext::optional<Image>, std::string> PNG::
+Read(uint8_t const *contents, size_t size, std::function<PixelFormat(PixelFormat const &)> const &convert)
+{
+    auto result = ReadImage(contents, size);
+    if (!result.first || convert == nullptr) {
+        return result;
+    }
+
+    /* CoreGraphics decodes the whole image, so convert it afterwards. */
+    Image &image = *result.first;
+    PixelFormat format = convert(image.format());
+    if (!SamePixelFormat(format, image.format())) {
+        std::vector<uint8_t> pixels = PixelFormat::Convert(image.data(), image.format(), format);
+        result.first = Image(image.width(), image.height(), format, std::move(pixels));
+    }
+
+    return result;
+}
+
 #else
 
 #include <png.h>
 #include <string.h>
 
+struct png_user_read_state {
+    unsigned char const *next;
+    unsigned char const *end;
+};
+
 static void
 png_user_read_data(png_structp png_ptr, png_bytep data, png_size_t length)
 {
-    unsigned char **contents_ptr = (unsigned char **)png_get_io_ptr(png_ptr);
-    if (contents_ptr == NULL) {
+    struct png_user_read_state *state = (struct png_user_read_state *)png_get_io_ptr(png_ptr);
+    if (state == NULL) {
         return;
     }
 
-    memcpy(data, *contents_ptr, length);
-    *contents_ptr += length;
+    /* The contents may be mapped; never read past the end. */
+    if (length > (png_size_t)(state->end - state->next)) {
+        png_error(png_ptr, "unexpected end of PNG");
+    }
+
+    memcpy(data, state->next, length);
+    state->next += length;
 }
 
 std::pair<ext::optional<Image>, std::string> PNG::
-Read(std::vector<uint8_t> const &contents)
+Read(uint8_t const *contents, size_t size, std::function<PixelFormat(PixelFormat const &)> const &convert)
 {
-    if (contents.size() < 8 || png_sig_cmp(const_cast<png_bytep>(static_cast<png_byte const *>(contents.data())), 0, 8)) {
+    if (size < 8 || png_sig_cmp(const_cast<png_bytep>(static_cast<png_byte const *>(contents)), 0, 8)) {
         return std::make_pair(ext::nullopt, "contents is not a PNG");
     }
 
@@ -253,8 +288,8 @@ Read(std::vector<uint8_t> const &contents)
         return std::make_pair(ext::nullopt, "setjmp/png_jmpbuf returned error");
     }
 
-    unsigned char const *contents_ptr = static_cast<unsigned char const *>(contents.data());
-    png_set_read_fn(png_struct_ptr, &contents_ptr, png_user_read_data);
+    struct png_user_read_state state = { contents, contents + size };
+    png_set_read_fn(png_struct_ptr, &state, png_user_read_data);
 
     png_read_info(png_struct_ptr, info_struct_ptr);
 
@@ -336,35 +371,224 @@ Read(std::vector<uint8_t> const &contents)
         return std::make_pair(ext::nullopt, "unable to transform PNG pixel data");
     }
 
-    png_byte **row_pointers = (png_byte **)malloc(height * sizeof(png_bytep));
-    if (row_pointers == NULL) {
-        png_destroy_read_struct(&png_struct_ptr, &info_struct_ptr, NULL);
-        return std::make_pair(ext::nullopt, "could not allocate memory");
-    }
+    PixelFormat target = (convert != nullptr ? convert(format) : format);
+    size_t target_row_bytes = width * target.bytesPerPixel();
+    auto pixels = std::vector<uint8_t>(height * target_row_bytes);
 
-    auto pixels = std::vector<uint8_t>(width * height * format.bytesPerPixel());
-    unsigned char *bytes = static_cast<unsigned char *>(pixels.data());
-    for (int row = 0; row < height; row++) {
-        row_pointers[row] = bytes + (row * row_bytes);
+    if (interlace_method == PNG_INTERLACE_NONE) {
+        /*
+         * Decode one row at a time. Rows that need converting go through a
+         * single row buffer instead of a copy of the whole image.
+         */
+        bool same = SamePixelFormat(format, target);
+        auto row_buffer = std::vector<uint8_t>(same ? 0 : row_bytes);
+        for (png_uint_32 row = 0; row < height; row++) {
+            png_byte *output = pixels.data() + (row * target_row_bytes);
+            if (same) {
+                png_read_row(png_struct_ptr, output, NULL);
+            } else {
+                png_read_row(png_struct_ptr, row_buffer.data(), NULL);
+                PixelFormat::Convert(row_buffer.data(), width, format, output, target);
+            }
+        }
+    } else {
+        /* Interlaced passes revisit every row, so decode the whole image first. */
+        png_byte **row_pointers = (png_byte **)malloc(height * sizeof(png_bytep));
+        if (row_pointers == NULL) {
+            png_destroy_read_struct(&png_struct_ptr, &info_struct_ptr, NULL);
+            return std::make_pair(ext::nullopt, "could not allocate memory");
+        }
+
+        auto decoded = std::vector<uint8_t>(height * row_bytes);
+        unsigned char *bytes = static_cast<unsigned char *>(decoded.data());
+        for (png_uint_32 row = 0; row < height; row++) {
+            row_pointers[row] = bytes + (row * row_bytes);
+        }
+        png_read_image(png_struct_ptr, row_pointers);
+        free(row_pointers);
+
+        PixelFormat::Convert(decoded.data(), width * height, format, pixels.data(), target);
     }
-    png_read_image(png_struct_ptr, row_pointers);
 
     /* Clean up. */
     png_read_end(png_struct_ptr, info_struct_ptr);
     png_destroy_read_struct(&png_struct_ptr, &info_struct_ptr, (png_infopp)NULL);
-    free(row_pointers);
 
-    Image image = Image(width, height, format, pixels);
-    return std::make_pair(image, std::string());
+    Image image = Image(width, height, target, std::move(pixels));
+    return std::make_pair(std::move(image), std::string());
 }
 
 #endif
 
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
 #include <arpa/inet.h>
 #include <zlib.h>
 
+/*
+ * Filter one row of pixel data into `out`, which has room for the filter
+ * type byte followed by the filtered row. `previous` is the unfiltered row
+ * above, or null for the first row.
+ */
+static void
+FilterRow(uint8_t type, uint8_t const *row, uint8_t const *previous, size_t size, size_t bpp, uint8_t *out)
+{
+    out[0] = type;
+    out++;
+
+    for (size_t i = 0; i < size; i++) {
+        int left = (i >= bpp ? row[i - bpp] : 0);
+        int up = (previous != NULL ? previous[i] : 0);
+        int upLeft = (previous != NULL && i >= bpp ? previous[i - bpp] : 0);
+
+        int predicted;
+        switch (type) {
+            case 0:
+                predicted = 0;
+                break;
+            case 1:
+                predicted = left;
+                break;
+            case 2:
+                predicted = up;
+                break;
+            case 3:
+                predicted = (left + up) / 2;
+                break;
+            case 4: {
+                int p = left + up - upLeft;
+                int pa = std::abs(p - left);
+                int pb = std::abs(p - up);
+                int pc = std::abs(p - upLeft);
+                predicted = (pa <= pb && pa <= pc ? left : pb <= pc ? up : upLeft);
+                break;
+            }
+            default: abort();
+        }
+
+        out[i] = static_cast<uint8_t>(row[i] - predicted);
+    }
+}
+
+/*
+ * Filter one row with the filter most likely to compress well: the one
+ * whose output bytes, read as signed, have the smallest sum of absolute
+ * values. Ties go to the simpler filter.
+ */
+static void
+FilterRowAdaptive(uint8_t const *row, uint8_t const *previous, size_t size, size_t bpp, uint8_t *out, std::vector<uint8_t> *scratch)
+{
+    uint64_t best = UINT64_MAX;
+    for (uint8_t type = 0; type <= 4; type++) {
+        FilterRow(type, row, previous, size, bpp, scratch->data());
+
+        uint64_t sum = 0;
+        for (size_t i = 1; i <= size; i++) {
+            sum += std::abs(static_cast<int>(static_cast<int8_t>((*scratch)[i])));
+        }
+
+        if (sum < best) {
+            best = sum;
+            memcpy(out, scratch->data(), size + 1);
+        }
+    }
+}
+
+/*
+ * Input per block when compressing in parallel. Blocks after the first are
+ * primed with the end of the block before, so little is lost by splitting.
+ */
+static size_t const CompressBlockSize = 128 * 1024;
+static size_t const CompressDictionarySize = 32 * 1024;
+
+/*
+ * Compress data into a zlib stream. Blocks of the data are compressed in
+ * parallel into raw DEFLATE streams that are flushed to a byte boundary
+ * without ending, so they join into one stream.
+ */
+static ext::optional<std::vector<uint8_t>>
+Compress(std::vector<uint8_t> const &data, int level, int strategy)
+{
+    size_t blocks = std::max<size_t>(1, (data.size() + CompressBlockSize - 1) / CompressBlockSize);
+    std::vector<std::vector<uint8_t>> compressed = std::vector<std::vector<uint8_t>>(blocks);
+    std::vector<uLong> checksums = std::vector<uLong>(blocks);
+    std::vector<uint8_t> failed = std::vector<uint8_t>(blocks, false);
+
+    libutil::Parallel::For(blocks, [&](size_t block) {
+        size_t start = block * CompressBlockSize;
+        size_t size = std::min(CompressBlockSize, data.size() - start);
+        bool last = (block + 1 == blocks);
+
+        z_stream strm;
+        strm.zalloc = Z_NULL;
+        strm.zfree = Z_NULL;
+        strm.opaque = Z_NULL;
+        if (deflateInit2(&strm, level, Z_DEFLATED, -15, 8, strategy) != Z_OK) {
+            failed[block] = true;
+            return;
+        }
+
+        if (block > 0) {
+            size_t dictionary = std::min(CompressDictionarySize, start);
+            deflateSetDictionary(&strm, data.data() + start - dictionary, dictionary);
+        }
+
+        /* Room for the worst case plus the flush marker. */
+        std::vector<uint8_t> &out = compressed[block];
+        out.resize(deflateBound(&strm, size) + 16);
+
+        strm.next_in = const_cast<Bytef *>(data.data() + start);
+        strm.avail_in = size;
+        strm.next_out = out.data();
+        strm.avail_out = out.size();
+
+        int ret = deflate(&strm, last ? Z_FINISH : Z_SYNC_FLUSH);
+        if ((last && ret != Z_STREAM_END) || (!last && (ret != Z_OK || strm.avail_in != 0))) {
+            failed[block] = true;
+        }
+
+        out.resize(strm.total_out);
+        deflateEnd(&strm);
+
+        checksums[block] = adler32(adler32(0, NULL, 0), data.data() + start, size);
+    });
+
+    if (std::find(failed.begin(), failed.end(), true) != failed.end()) {
+        return ext::nullopt;
+    }
+
+    /*
+     * The zlib header records the compression level, and the trailer the
+     * checksum of all the data.
+     */
+    uint8_t flags = (level == 0 || level == 1 ? 0x01 : level >= 2 && level <= 5 ? 0x5E : level == 6 || level == Z_DEFAULT_COMPRESSION ? 0x9C : 0xDA);
+    std::vector<uint8_t> stream = { 0x78, flags };
+
+    uLong checksum = adler32(0, NULL, 0);
+    for (size_t block = 0; block < blocks; block++) {
+        stream.insert(stream.end(), compressed[block].begin(), compressed[block].end());
+
+        size_t size = std::min(CompressBlockSize, data.size() - block * CompressBlockSize);
+        checksum = adler32_combine(checksum, checksums[block], size);
+    }
+
+    uint8_t const trailer[] = {
+        static_cast<uint8_t>(checksum >> 24),
+        static_cast<uint8_t>(checksum >> 16),
+        static_cast<uint8_t>(checksum >> 8),
+        static_cast<uint8_t>(checksum),
+    };
+    stream.insert(stream.end(), std::begin(trailer), std::end(trailer));
+
+    return stream;
+}
+
 std::pair<ext::optional<std::vector<uint8_t>>, std::string> PNG::
-Write(Image const &image)
+Write(Image const &image, Compression compression)
 {
     std::vector<uint8_t> png;
 
@@ -422,7 +646,9 @@ Write(Image const &image)
         image.format().color(),
         PixelFormat::Order::Forward,
         (alpha ? PixelFormat::Alpha::Last : PixelFormat::Alpha::None));
-    std::vector<uint8_t> data = PixelFormat::Convert(image.data(), image.format(), format);
+    bool same = SamePixelFormat(format, image.format());
+    std::vector<uint8_t> converted = (same ? std::vector<uint8_t>() : PixelFormat::Convert(image.data(), image.format(), format));
+    std::vector<uint8_t> const &data = (same ? image.data() : converted);
 
     /*
      * Write out the PNG header.
@@ -452,58 +678,51 @@ Write(Image const &image)
     png.insert(png.end(), std::begin(ihdr_crc32), std::end(ihdr_crc32));
 
     /*
-     * Compress the pixel data with DEFLATE.
+     * Filter each row, adding the filter type byte before it. Rows only
+     * depend on the unfiltered row above, so they're filtered in parallel.
      */
-    z_stream strm;
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
-
-    int ret = deflateInit2(&strm, Z_DEFAULT_COMPRESSION, 8, 15, 8, Z_DEFAULT_STRATEGY);
-    if (ret != Z_OK) {
-        return std::make_pair(ext::nullopt, "deflate init failed");
-    }
-
-    /* Add filter bytes between rows in the image. */
-    uint32_t filter_stride = image.width() * format.bytesPerPixel();
-    size_t filter_size = (data.size() / filter_stride);
-    std::vector<uint8_t> buffer = std::vector<uint8_t>(data.size() + filter_size);
-    for (size_t i = 0; i < image.height(); i++) {
-        size_t offset = (i * filter_stride);
-        size_t filter_offset = i;
-
-        *(buffer.data() + offset + filter_offset) = 0; // filter format
-        memcpy(buffer.data() + offset + filter_offset + 1, data.data() + offset, filter_stride);
-    }
-
-    strm.avail_in = buffer.size();
-    strm.next_in = buffer.data();
-
-    /* Maximum compressed size is x1.01 + 12 the uncompressed size. */
-    std::vector<uint8_t> compressed = std::vector<uint8_t>(buffer.size() * 1.01 + 12);
-
-    do {
-        strm.avail_out = compressed.size() - strm.total_out;
-        strm.next_out = (Bytef *)(compressed.data() + strm.total_out);
-
-        ret = deflate(&strm, Z_FINISH);
-        if (ret != Z_OK && ret != Z_STREAM_END) {
-            return std::make_pair(ext::nullopt, "deflate failed");
+    size_t stride = image.width() * format.bytesPerPixel();
+    std::vector<uint8_t> filtered = std::vector<uint8_t>((stride + 1) * image.height());
+
+    size_t rowsPerGroup = std::max<size_t>(1, CompressBlockSize / (stride + 1));
+    size_t groups = (image.height() + rowsPerGroup - 1) / rowsPerGroup;
+    libutil::Parallel::For(groups, [&](size_t group) {
+        std::vector<uint8_t> scratch = std::vector<uint8_t>(stride + 1);
+
+        size_t end = std::min<size_t>(image.height(), (group + 1) * rowsPerGroup);
+        for (size_t i = group * rowsPerGroup; i < end; i++) {
+            uint8_t const *row = data.data() + i * stride;
+            uint8_t const *previous = (i > 0 ? row - stride : NULL);
+            FilterRowAdaptive(row, previous, stride, format.bytesPerPixel(), filtered.data() + i * (stride + 1), &scratch);
         }
-    } while (ret != Z_STREAM_END);
+    });
 
-    /* Shrink down to compressed size. */
-    compressed.resize(strm.total_out);
+    /*
+     * Compress the filtered data with DEFLATE.
+     */
+    int level;
+    switch (compression) {
+        case Compression::Fast:
+            level = 1;
+            break;
+        case Compression::Default:
+            level = Z_DEFAULT_COMPRESSION;
+            break;
+        case Compression::Small:
+            level = 9;
+            break;
+        default: abort();
+    }
 
-    ret = deflateEnd(&strm);
-    if (ret != Z_OK) {
-        return std::make_pair(ext::nullopt, "deflate end failed");
+    ext::optional<std::vector<uint8_t>> compressed = Compress(filtered, level, Z_DEFAULT_STRATEGY);
+    if (!compressed) {
+        return std::make_pair(ext::nullopt, "deflate failed");
     }
 
     /*
      * Write out IDAT chunk with the image data.
      */
-    uint32_t size_big = htonl(compressed.size());
+    uint32_t size_big = htonl(compressed->size());
     uint8_t *size_buf = reinterpret_cast<uint8_t *>(&size_big);
 
     uint8_t const idat[] = {
@@ -511,10 +730,10 @@ Write(Image const &image)
         'I', 'D', 'A', 'T', // chunk type
     };
     png.insert(png.end(), std::begin(idat), std::end(idat));
-    png.insert(png.end(), compressed.begin(), compressed.end());
+    png.insert(png.end(), compressed->begin(), compressed->end());
 
     crc32_big = crc32(crc32_initial, idat + 4, sizeof(idat) - 4);
-    crc32_big = crc32(crc32_big, compressed.data(), compressed.size());
+    crc32_big = crc32(crc32_big, compressed->data(), compressed->size());
     crc32_big = htonl(crc32_big);
     uint8_t const idat_crc32[] = { crc32p[0], crc32p[1], crc32p[2], crc32p[3] };
     png.insert(png.end(), std::begin(idat_crc32), std::end(idat_crc32));
@@ -172,16 +172,114 @@ ColorChannels(size_t *red, size_t *green, size_t *blue, PixelFormat::Color color
     }
 }
 
+namespace {
+
+/*
+ * Where each channel is in a pixel, for converting between two formats.
+ */
+struct ChannelMap {
+    size_t fromRed, fromGreen, fromBlue;
+    size_t toRed, toGreen, toBlue;
+    ext::optional<size_t> fromAlpha;
+    ext::optional<size_t> toAlpha;
+};
+
+}
+
+/*
+ * Multiplies in alpha, rounding to nearest. Matches `Premultiply()` exactly:
+ * a product of bytes divided by 255 is never exactly halfway between two
+ * integers, so rounding in floating point and here can't disagree.
+ */
+static inline uint8_t
+PremultiplyInteger(uint32_t value, uint32_t alpha)
+{
+    return static_cast<uint8_t>((value * alpha + 127) / 255);
+}
+
+/*
+ * Converts from a straight or missing alpha to premultiplied or no alpha,
+ * the conversion done for every compiled image. Without floating point or
+ * branches in the loop, and with the pixel sizes known, compilers can
+ * unroll and vectorize it.
+ */
+template<size_t FromBytes, size_t ToBytes>
+static void
+PremultiplyPixels(uint8_t const *from, uint8_t *to, size_t count, ChannelMap const &map)
+{
+    size_t fromRed = map.fromRed, fromGreen = map.fromGreen, fromBlue = map.fromBlue;
+    size_t toRed = map.toRed, toGreen = map.toGreen, toBlue = map.toBlue;
+
+    if (map.fromAlpha && map.toAlpha) {
+        size_t fromAlpha = *map.fromAlpha, toAlpha = *map.toAlpha;
+        for (size_t i = 0; i < count; ++i, from += FromBytes, to += ToBytes) {
+            uint32_t alpha = from[fromAlpha];
+            to[toAlpha] = alpha;
+            to[toRed] = PremultiplyInteger(from[fromRed], alpha);
+            to[toGreen] = PremultiplyInteger(from[fromGreen], alpha);
+            to[toBlue] = PremultiplyInteger(from[fromBlue], alpha);
+        }
+    } else if (map.fromAlpha) {
+        size_t fromAlpha = *map.fromAlpha;
+        for (size_t i = 0; i < count; ++i, from += FromBytes, to += ToBytes) {
+            uint32_t alpha = from[fromAlpha];
+            to[toRed] = PremultiplyInteger(from[fromRed], alpha);
+            to[toGreen] = PremultiplyInteger(from[fromGreen], alpha);
+            to[toBlue] = PremultiplyInteger(from[fromBlue], alpha);
+        }
+    } else {
+        /* Opaque, so nothing to multiply. */
+        for (size_t i = 0; i < count; ++i, from += FromBytes, to += ToBytes) {
+            if (map.toAlpha) {
+                to[*map.toAlpha] = 0xFF;
+            }
+            to[toRed] = from[fromRed];
+            to[toGreen] = from[fromGreen];
+            to[toBlue] = from[fromBlue];
+        }
+    }
+}
+
+/*
+ * Runs `PremultiplyPixels()` specialized for the pixel sizes, if they're
+ * ones used for images. Returns false for any others.
+ */
+static bool
+DispatchPremultiplyPixels(uint8_t const *from, size_t fromBytes, uint8_t *to, size_t toBytes, size_t count, ChannelMap const &map)
+{
+    typedef void (*Kernel)(uint8_t const *, uint8_t *, size_t, ChannelMap const &);
+    static Kernel const kernels[4][4] = {
+        { &PremultiplyPixels<1, 1>, &PremultiplyPixels<1, 2>, &PremultiplyPixels<1, 3>, &PremultiplyPixels<1, 4> },
+        { &PremultiplyPixels<2, 1>, &PremultiplyPixels<2, 2>, &PremultiplyPixels<2, 3>, &PremultiplyPixels<2, 4> },
+        { &PremultiplyPixels<3, 1>, &PremultiplyPixels<3, 2>, &PremultiplyPixels<3, 3>, &PremultiplyPixels<3, 4> },
+        { &PremultiplyPixels<4, 1>, &PremultiplyPixels<4, 2>, &PremultiplyPixels<4, 3>, &PremultiplyPixels<4, 4> },
+    };
+
+    if (fromBytes < 1 || fromBytes > 4 || toBytes < 1 || toBytes > 4) {
+        return false;
+    }
+
+    kernels[fromBytes - 1][toBytes - 1](from, to, count, map);
+    return true;
+}
+
 std::vector<uint8_t> PixelFormat::
 Convert(std::vector<uint8_t> const &pixels, PixelFormat const &from, PixelFormat const &to)
 {
     /* Determine number of pixels. */
-    size_t fromBytesPerPixel = from.bytesPerPixel();
-    size_t pixelCount = pixels.size() / fromBytesPerPixel;
+    size_t pixelCount = pixels.size() / from.bytesPerPixel();
 
     /* Allocate output. */
+    std::vector<uint8_t> result = std::vector<uint8_t>(pixelCount * to.bytesPerPixel());
+    Convert(pixels.data(), pixelCount, from, result.data(), to);
+    return result;
+}
+
+void PixelFormat::
+Convert(uint8_t const *pixels, size_t pixelCount, PixelFormat const &from, uint8_t *result, PixelFormat const &to)
+{
+    size_t fromBytesPerPixel = from.bytesPerPixel();
     size_t toBytesPerPixel = to.bytesPerPixel();
-    std::vector<uint8_t> result = std::vector<uint8_t>(pixelCount * toBytesPerPixel);
 
     /* Find alpha channels. */
     ext::optional<size_t> fromAlphaChannel = AlphaChannel(from.alpha(), from.order(), from.channels());
@@ -224,6 +322,15 @@ Convert(std::vector<uint8_t> const &pixels, PixelFormat const &from, PixelFormat
          * Slow path: have to modify pixel data, either to convert color formats or adjust alpha.
          */
         bool convertingToGrayscale = (from.color() == Color::RGB && to.color() == Color::Grayscale);
+
+        /* Only multiplying in alpha is common enough to specialize. */
+        if (!convertingToGrayscale && !fromAlphaPremultiplied && toPremultiplied) {
+            ChannelMap map = { fromRed, fromGreen, fromBlue, toRed, toGreen, toBlue, fromAlphaChannel, toAlphaChannel };
+            if (DispatchPremultiplyPixels(pixels, fromBytesPerPixel, result, toBytesPerPixel, pixelCount, map)) {
+                return;
+            }
+        }
+
         for (size_t i = 0; i < pixelCount; ++i) {
             uint8_t const *fromPixel = &pixels[i * fromBytesPerPixel];
             uint8_t *toPixel = &result[i * toBytesPerPixel];
@@ -253,7 +360,5 @@ Convert(std::vector<uint8_t> const &pixels, PixelFormat const &from, PixelFormat
             toPixel[toBlue] = Premultiply(blue, fromAlphaPremultiplied, toPremultiplied, alpha);
         }
     }
-
-    return result;
 }
 
@@ -0,0 +1,334 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <graphics/Resample.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <functional>
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+using graphics::Resample;
+using graphics::Image;
+using graphics::PixelFormat;
+
+/* Bits of fraction in the fixed-point weights. */
+static int const Precision = 14;
+
+/* Below this many output bytes, threads cost more than they save. */
+static size_t const ParallelBytes = 1024 * 1024;
+
+/* Rows given to a thread at a time. */
+static size_t const RowsPerTask = 16;
+
+/*
+ * Runs a function over ranges of rows, in parallel if there's enough work.
+ */
+static void
+ForRows(size_t rows, size_t bytes, std::function<void(size_t, size_t)> const &function)
+{
+    if (bytes < ParallelBytes) {
+        function(0, rows);
+        return;
+    }
+
+    libutil::Parallel::For((rows + RowsPerTask - 1) / RowsPerTask, [&](size_t index) {
+        size_t start = index * RowsPerTask;
+        function(start, std::min(start + RowsPerTask, rows));
+    });
+}
+
+static double
+Sinc(double x)
+{
+    if (x == 0.0) {
+        return 1.0;
+    }
+
+    x *= M_PI;
+    return std::sin(x) / x;
+}
+
+static double
+FilterSupport(Resample::Filter filter)
+{
+    switch (filter) {
+        case Resample::Filter::Box:
+            return 0.5;
+        case Resample::Filter::Lanczos:
+            return 3.0;
+    }
+
+    abort();
+}
+
+static double
+FilterValue(Resample::Filter filter, double x)
+{
+    switch (filter) {
+        case Resample::Filter::Box:
+            return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+        case Resample::Filter::Lanczos:
+            return (x > -3.0 && x < 3.0) ? Sinc(x) * Sinc(x / 3.0) : 0.0;
+    }
+
+    abort();
+}
+
+namespace {
+
+/*
+ * The input pixels that contribute to each output pixel along one axis,
+ * and how much. Weights for an output are padded with zeros to the same
+ * count, so every output uses the same stride.
+ */
+struct Weights {
+    size_t               count;
+    std::vector<size_t>  start;
+    std::vector<int32_t> values;
+};
+
+}
+
+static Weights
+ComputeWeights(size_t in, size_t out, Resample::Filter filter)
+{
+    /* When shrinking, the filter widens to cover every input pixel. */
+    double scale = static_cast<double>(in) / static_cast<double>(out);
+    double filterScale = std::max(scale, 1.0);
+    double support = FilterSupport(filter) * filterScale;
+
+    Weights weights;
+    weights.count = std::min<size_t>(static_cast<size_t>(std::ceil(support)) * 2 + 1, in);
+    weights.start.resize(out);
+    weights.values.resize(out * weights.count);
+
+    std::vector<double> values = std::vector<double>(weights.count);
+    for (size_t i = 0; i < out; ++i) {
+        double center = (static_cast<double>(i) + 0.5) * scale;
+        size_t min = static_cast<size_t>(std::max(center - support + 0.5, 0.0));
+        size_t max = std::min(static_cast<size_t>(std::max(center + support + 0.5, 0.0)), in);
+        max = std::min(max, min + weights.count);
+
+        /* Keep the window inside the input, so reads never need a check. */
+        size_t start = std::min(min, in - weights.count);
+        weights.start[i] = start;
+
+        double total = 0.0;
+        std::fill(values.begin(), values.end(), 0.0);
+        for (size_t x = min; x < max; ++x) {
+            double value = FilterValue(filter, (static_cast<double>(x) + 0.5 - center) / filterScale);
+            values[x - start] = value;
+            total += value;
+        }
+
+        int32_t *fixed = &weights.values[i * weights.count];
+        for (size_t k = 0; k < weights.count; ++k) {
+            double value = (total != 0.0 ? values[k] / total : 0.0);
+            fixed[k] = static_cast<int32_t>(std::lround(value * (1 << Precision)));
+        }
+    }
+
+    return weights;
+}
+
+static inline uint8_t
+Clamp(int32_t value)
+{
+    value >>= Precision;
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 0xFF ? 0xFF : value));
+}
+
+template<size_t Bytes>
+static void
+HorizontalRows(uint8_t const *in, size_t inWidth, uint8_t *out, size_t outWidth, Weights const &weights, size_t start, size_t end)
+{
+    for (size_t y = start; y < end; ++y) {
+        uint8_t const *inRow = in + y * inWidth * Bytes;
+        uint8_t *outRow = out + y * outWidth * Bytes;
+
+        for (size_t x = 0; x < outWidth; ++x) {
+            uint8_t const *pixel = inRow + weights.start[x] * Bytes;
+            int32_t const *weight = &weights.values[x * weights.count];
+
+            int32_t sum[Bytes];
+            for (size_t c = 0; c < Bytes; ++c) {
+                sum[c] = 1 << (Precision - 1);
+            }
+
+            for (size_t k = 0; k < weights.count; ++k) {
+                for (size_t c = 0; c < Bytes; ++c) {
+                    sum[c] += weight[k] * pixel[k * Bytes + c];
+                }
+            }
+
+            for (size_t c = 0; c < Bytes; ++c) {
+                outRow[x * Bytes + c] = Clamp(sum[c]);
+            }
+        }
+    }
+}
+
+static void
+Horizontal(uint8_t const *in, size_t inWidth, uint8_t *out, size_t outWidth, size_t height, size_t bytesPerPixel, Resample::Filter filter)
+{
+    Weights weights = ComputeWeights(inWidth, outWidth, filter);
+
+    ForRows(height, outWidth * height * bytesPerPixel, [&](size_t start, size_t end) {
+        switch (bytesPerPixel) {
+            case 1: HorizontalRows<1>(in, inWidth, out, outWidth, weights, start, end); break;
+            case 2: HorizontalRows<2>(in, inWidth, out, outWidth, weights, start, end); break;
+            case 3: HorizontalRows<3>(in, inWidth, out, outWidth, weights, start, end); break;
+            case 4: HorizontalRows<4>(in, inWidth, out, outWidth, weights, start, end); break;
+            default: abort();
+        }
+    });
+}
+
+static void
+Vertical(uint8_t const *in, size_t inHeight, uint8_t *out, size_t outHeight, size_t rowBytes, Resample::Filter filter)
+{
+    Weights weights = ComputeWeights(inHeight, outHeight, filter);
+
+    ForRows(outHeight, outHeight * rowBytes, [&](size_t start, size_t end) {
+        /* Whole rows at once: the inner loop is contiguous. */
+        std::vector<int32_t> sum = std::vector<int32_t>(rowBytes);
+
+        for (size_t y = start; y < end; ++y) {
+            std::fill(sum.begin(), sum.end(), 1 << (Precision - 1));
+
+            int32_t const *weight = &weights.values[y * weights.count];
+            for (size_t k = 0; k < weights.count; ++k) {
+                if (weight[k] == 0) {
+                    continue;
+                }
+
+                int32_t w = weight[k];
+                uint8_t const *inRow = in + (weights.start[y] + k) * rowBytes;
+                for (size_t i = 0; i < rowBytes; ++i) {
+                    sum[i] += w * inRow[i];
+                }
+            }
+
+            uint8_t *outRow = out + y * rowBytes;
+            for (size_t i = 0; i < rowBytes; ++i) {
+                outRow[i] = Clamp(sum[i]);
+            }
+        }
+    });
+}
+
+/*
+ * The premultiplied form of a format with straight alpha, if it has any.
+ */
+static ext::optional<PixelFormat>
+PremultipliedFormat(PixelFormat const &format)
+{
+    switch (format.alpha()) {
+        case PixelFormat::Alpha::First:
+            return PixelFormat(format.color(), format.order(), PixelFormat::Alpha::PremultipliedFirst);
+        case PixelFormat::Alpha::Last:
+            return PixelFormat(format.color(), format.order(), PixelFormat::Alpha::PremultipliedLast);
+        default:
+            return ext::nullopt;
+    }
+}
+
+ext::optional<Image> Resample::
+Crop(Image const &image, size_t x, size_t y, size_t width, size_t height)
+{
+    if (width == 0 || height == 0 || x > image.width() || width > image.width() - x || y > image.height() || height > image.height() - y) {
+        return ext::nullopt;
+    }
+
+    size_t bytesPerPixel = image.format().bytesPerPixel();
+    size_t rowBytes = width * bytesPerPixel;
+
+    std::vector<uint8_t> data = std::vector<uint8_t>(rowBytes * height);
+    for (size_t row = 0; row < height; ++row) {
+        uint8_t const *in = image.data().data() + ((y + row) * image.width() + x) * bytesPerPixel;
+        ::memcpy(data.data() + row * rowBytes, in, rowBytes);
+    }
+
+    return Image(width, height, image.format(), std::move(data));
+}
+
+ext::optional<Image> Resample::
+Scale(Image const &image, size_t width, size_t height, Filter filter)
+{
+    if (width == 0 || height == 0 || image.width() == 0 || image.height() == 0) {
+        return ext::nullopt;
+    }
+
+    PixelFormat format = image.format();
+    size_t bytesPerPixel = format.bytesPerPixel();
+
+    /*
+     * Filter straight alpha premultiplied; otherwise, the color of fully
+     * transparent pixels would show up around the edges of opaque ones.
+     */
+    ext::optional<PixelFormat> premultiplied = PremultipliedFormat(format);
+    std::vector<uint8_t> pixels;
+    uint8_t const *in = image.data().data();
+    if (premultiplied) {
+        pixels = PixelFormat::Convert(image.data(), format, *premultiplied);
+        in = pixels.data();
+    }
+
+    /* Each pass is skipped if it wouldn't change that dimension. */
+    std::vector<uint8_t> horizontal;
+    if (width != image.width()) {
+        horizontal.resize(width * image.height() * bytesPerPixel);
+        Horizontal(in, image.width(), horizontal.data(), width, image.height(), bytesPerPixel, filter);
+        in = horizontal.data();
+    }
+
+    std::vector<uint8_t> data;
+    if (height != image.height()) {
+        data.resize(width * height * bytesPerPixel);
+        Vertical(in, image.height(), data.data(), height, width * bytesPerPixel, filter);
+    } else {
+        data.assign(in, in + width * height * bytesPerPixel);
+    }
+
+    if (premultiplied) {
+        data = PixelFormat::Convert(data, *premultiplied, format);
+    }
+
+    return Image(width, height, format, std::move(data));
+}
+
+std::vector<Image> Resample::
+Mipmaps(Image const &image, Filter filter)
+{
+    std::vector<Image> levels;
+
+    /* Each level is made from the last, which is far cheaper than the base. */
+    while (true) {
+        Image const &previous = (levels.empty() ? image : levels.back());
+        if (previous.width() <= 1 && previous.height() <= 1) {
+            break;
+        }
+
+        size_t width = std::max<size_t>(previous.width() / 2, 1);
+        size_t height = std::max<size_t>(previous.height() / 2, 1);
+
+        ext::optional<Image> level = Scale(previous, width, height, filter);
+        if (!level) {
+            break;
+        }
+
+        levels.push_back(std::move(*level));
+    }
+
+    return levels;
+}
@@ -0,0 +1,161 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <graphics/Atlas.h>
+
+#include <random>
+
+using graphics::Atlas;
+using graphics::Image;
+using graphics::PixelFormat;
+
+static PixelFormat const Gray = PixelFormat(PixelFormat::Color::Grayscale, PixelFormat::Order::Forward, PixelFormat::Alpha::None);
+static PixelFormat const GrayAlpha = PixelFormat(PixelFormat::Color::Grayscale, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+static PixelFormat const BGRA = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Reversed, PixelFormat::Alpha::PremultipliedFirst);
+
+TEST(Atlas, Trim)
+{
+    Image image = Image(4, 3, GrayAlpha, {
+        9, 0,  9, 0,  9, 0,  9, 0,
+        9, 0,  9, 1,  9, 0,  9, 0,
+        9, 0,  9, 0,  9, 1,  9, 0,
+    });
+
+    Atlas::Rect rect = Atlas::Trim(image);
+    EXPECT_EQ(1, rect.x);
+    EXPECT_EQ(1, rect.y);
+    EXPECT_EQ(2, rect.width);
+    EXPECT_EQ(2, rect.height);
+
+    /* Alpha is last in memory for reversed alpha first. */
+    Image bgra = Image(2, 1, BGRA, { 1, 2, 3, 0,  1, 2, 3, 255 });
+    rect = Atlas::Trim(bgra);
+    EXPECT_EQ(1, rect.x);
+    EXPECT_EQ(1, rect.width);
+
+    /* Without alpha, everything is visible. */
+    rect = Atlas::Trim(Image(3, 2, Gray, std::vector<uint8_t>(6, 0)));
+    EXPECT_EQ(3, rect.width);
+    EXPECT_EQ(2, rect.height);
+
+    /* Fully transparent images are empty. */
+    rect = Atlas::Trim(Image(2, 2, GrayAlpha, std::vector<uint8_t>(8, 0)));
+    EXPECT_EQ(0, rect.width);
+    EXPECT_EQ(0, rect.height);
+}
+
+static bool
+Overlaps(
+    Atlas::Placement const &a, std::pair<size_t, size_t> const &sa,
+    Atlas::Placement const &b, std::pair<size_t, size_t> const &sb,
+    size_t padding)
+{
+    if (a.page != b.page) {
+        return false;
+    }
+
+    size_t aw = (a.rotated ? sa.second : sa.first) + padding;
+    size_t ah = (a.rotated ? sa.first : sa.second) + padding;
+    size_t bw = (b.rotated ? sb.second : sb.first) + padding;
+    size_t bh = (b.rotated ? sb.first : sb.second) + padding;
+    return !(a.x + aw <= b.x || b.x + bw <= a.x || a.y + ah <= b.y || b.y + bh <= a.y);
+}
+
+TEST(Atlas, PackExact)
+{
+    /* Four squares exactly fill a page. */
+    std::vector<std::pair<size_t, size_t>> sizes = { { 8, 8 }, { 8, 8 }, { 8, 8 }, { 8, 8 } };
+    auto placements = Atlas::Pack(sizes, { 16, 16, 0, false });
+    ASSERT_NE(ext::nullopt, placements);
+
+    for (size_t i = 0; i < sizes.size(); i++) {
+        EXPECT_EQ(0, (*placements)[i].page);
+        for (size_t j = 0; j < i; j++) {
+            EXPECT_FALSE(Overlaps((*placements)[i], sizes[i], (*placements)[j], sizes[j], 0));
+        }
+    }
+
+    /* One more needs another page. */
+    sizes.push_back({ 8, 8 });
+    placements = Atlas::Pack(sizes, { 16, 16, 0, false });
+    ASSERT_NE(ext::nullopt, placements);
+    EXPECT_EQ(1, (*placements)[4].page);
+}
+
+TEST(Atlas, PackRotation)
+{
+    /* A tall rectangle only fits a wide page on its side. */
+    std::vector<std::pair<size_t, size_t>> sizes = { { 4, 16 } };
+    EXPECT_EQ(ext::nullopt, Atlas::Pack(sizes, { 16, 4, 0, false }));
+
+    auto placements = Atlas::Pack(sizes, { 16, 4, 0, true });
+    ASSERT_NE(ext::nullopt, placements);
+    EXPECT_TRUE((*placements)[0].rotated);
+}
+
+TEST(Atlas, PackRandom)
+{
+    std::mt19937 random = std::mt19937(1);
+    std::uniform_int_distribution<size_t> side = std::uniform_int_distribution<size_t>(1, 64);
+
+    std::vector<std::pair<size_t, size_t>> sizes;
+    for (size_t i = 0; i < 1000; i++) {
+        sizes.push_back({ side(random), side(random) });
+    }
+
+    Atlas::Options options = { 512, 512, 2, true };
+    auto placements = Atlas::Pack(sizes, options);
+    ASSERT_NE(ext::nullopt, placements);
+
+    size_t pages = 0;
+    for (size_t i = 0; i < sizes.size(); i++) {
+        Atlas::Placement const &placement = (*placements)[i];
+        size_t width = (placement.rotated ? sizes[i].second : sizes[i].first);
+        size_t height = (placement.rotated ? sizes[i].first : sizes[i].second);
+        EXPECT_LE(placement.x + width, options.pageWidth);
+        EXPECT_LE(placement.y + height, options.pageHeight);
+        pages = std::max(pages, placement.page + 1);
+    }
+
+    for (size_t i = 0; i < sizes.size(); i++) {
+        for (size_t j = 0; j < i; j++) {
+            EXPECT_FALSE(Overlaps((*placements)[i], sizes[i], (*placements)[j], sizes[j], options.padding));
+        }
+    }
+
+    /* The padded sprites cover about 4.5 pages; packing should waste little. */
+    EXPECT_LE(pages, 6);
+}
+
+TEST(Atlas, Blit)
+{
+    Image image = Image(3, 2, Gray, {
+        1, 2, 3,
+        4, 5, 6,
+    });
+
+    Image page = Image(4, 4, Gray, std::vector<uint8_t>(16, 0));
+    Atlas::Blit(&page, 1, 1, false, image, { 1, 0, 2, 2 });
+    EXPECT_EQ(std::vector<uint8_t>({
+        0, 0, 0, 0,
+        0, 2, 3, 0,
+        0, 5, 6, 0,
+        0, 0, 0, 0,
+    }), page.data());
+
+    /* Rotated clockwise, the bottom row becomes the left column. */
+    Image rotated = Image(2, 3, Gray, std::vector<uint8_t>(6, 0));
+    Atlas::Blit(&rotated, 0, 0, true, image, { 0, 0, 3, 2 });
+    EXPECT_EQ(std::vector<uint8_t>({
+        4, 1,
+        5, 2,
+        6, 3,
+    }), rotated.data());
+}
@@ -137,6 +137,30 @@ TEST(PNG, Read)
     }
 }
 
+TEST(PNG, ReadConvert)
+{
+    for (size_t i = 0; i < sizeof(PNGTests) / sizeof(*PNGTests); i++) {
+        /* Load test data. */
+        auto const &test = PNGTests[i];
+        std::vector<uint8_t> png;
+        std::vector<uint8_t> pixels;
+        PixelFormat format = PixelFormat(PixelFormat::Color::Grayscale, PixelFormat::Order::Forward, PixelFormat::Alpha::None);
+        test(&png, &pixels, &format);
+
+        /* Should be able to read PNG directly into the specified format. */
+        auto result = PNG::Read(png.data(), png.size(), [&format](PixelFormat const &decoded) {
+            return format;
+        });
+        ASSERT_NE(result.first, ext::nullopt);
+        Image const &image = *result.first;
+
+        /* Should have expected pixels without a separate conversion. */
+        EXPECT_EQ(image.format().color(), format.color());
+        EXPECT_EQ(image.format().alpha(), format.alpha());
+        EXPECT_EQ(image.data(), pixels);
+    }
+}
+
 TEST(PNG, Write)
 {
     for (size_t i = 0; i < sizeof(PNGTests) / sizeof(*PNGTests); i++) {
@@ -156,3 +180,43 @@ TEST(PNG, Write)
         EXPECT_EQ(*result.first, png);
     }
 }
+
+TEST(PNG, WriteCompression)
+{
+    /* Large enough to compress in several blocks, with rows that differ. */
+    size_t width = 300;
+    size_t height = 300;
+    std::vector<uint8_t> pixels;
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            pixels.push_back(static_cast<uint8_t>(x));
+            pixels.push_back(static_cast<uint8_t>(y));
+            pixels.push_back(static_cast<uint8_t>((x * y) >> 4));
+            pixels.push_back(static_cast<uint8_t>(x ^ y));
+        }
+    }
+
+    PixelFormat format = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+    auto image = Image(width, height, format, pixels);
+
+    std::vector<size_t> sizes;
+    for (PNG::Compression compression : { PNG::Compression::Fast, PNG::Compression::Default, PNG::Compression::Small }) {
+        auto result = PNG::Write(image, compression);
+        ASSERT_NE(ext::nullopt, result.first);
+        sizes.push_back(result.first->size());
+
+        /* Should read back the same pixels. */
+        auto read = PNG::Read(result.first->data(), result.first->size(), [&](PixelFormat const &) { return format; });
+        ASSERT_NE(ext::nullopt, read.first);
+        EXPECT_EQ(width, read.first->width());
+        EXPECT_EQ(height, read.first->height());
+        EXPECT_EQ(pixels, read.first->data());
+    }
+
+    /* Slower profiles shouldn't be larger. */
+    EXPECT_GE(sizes[0], sizes[1]);
+    EXPECT_GE(sizes[1], sizes[2]);
+
+    /* Writing is deterministic. */
+    EXPECT_EQ(PNG::Write(image).first, PNG::Write(image).first);
+}
@@ -10,6 +10,8 @@
 #include <gtest/gtest.h>
 #include <graphics/PixelFormat.h>
 
+#include <cmath>
+
 using graphics::PixelFormat;
 
 TEST(PixelFormat, Properties)
@@ -98,3 +100,28 @@ TEST(PixelFormat, ConvertRearrange)
     EXPECT_EQ(PixelFormat::Convert({ 0x6A, 0x6C, 0x6E }, forward, reversed), Expected({ 0x6E, 0x6C, 0x6A }));
     EXPECT_EQ(PixelFormat::Convert({ 0x6E, 0x6C, 0x6A }, reversed, forward), Expected({ 0x6A, 0x6C, 0x6E }));
 }
+
+TEST(PixelFormat, ConvertPremultiplyExact)
+{
+    PixelFormat straight = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+    PixelFormat premultiplied = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Reversed, PixelFormat::Alpha::PremultipliedFirst);
+
+    /* The same rounding as multiplying in floating point. */
+    auto multiply = [](int value, int alpha) -> uint8_t {
+        float v = (value / 255.0);
+        float a = (alpha / 255.0);
+        return std::round((v * a) * 255.0);
+    };
+
+    /* Every value and alpha, as RGBA in and BGRA out. */
+    std::vector<uint8_t> pixels;
+    std::vector<uint8_t> expected;
+    for (int value = 0; value < 256; ++value) {
+        for (int alpha = 0; alpha < 256; ++alpha) {
+            pixels.insert(pixels.end(), { (uint8_t)value, (uint8_t)(255 - value), 0, (uint8_t)alpha });
+            expected.insert(expected.end(), { 0, multiply(255 - value, alpha), multiply(value, alpha), (uint8_t)alpha });
+        }
+    }
+
+    EXPECT_EQ(PixelFormat::Convert(pixels, straight, premultiplied), expected);
+}
@@ -0,0 +1,94 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <graphics/Resample.h>
+
+using graphics::Image;
+using graphics::PixelFormat;
+using graphics::Resample;
+
+static PixelFormat const Gray = PixelFormat(PixelFormat::Color::Grayscale, PixelFormat::Order::Forward, PixelFormat::Alpha::None);
+static PixelFormat const RGBA = PixelFormat(PixelFormat::Color::RGB, PixelFormat::Order::Forward, PixelFormat::Alpha::Last);
+
+TEST(Resample, Crop)
+{
+    Image image = Image(3, 2, Gray, { 1, 2, 3, 4, 5, 6 });
+
+    ext::optional<Image> crop = Resample::Crop(image, 1, 0, 2, 2);
+    ASSERT_NE(ext::nullopt, crop);
+    EXPECT_EQ(2, crop->width());
+    EXPECT_EQ(2, crop->height());
+    EXPECT_EQ(std::vector<uint8_t>({ 2, 3, 5, 6 }), crop->data());
+
+    /* Regions past the edge are rejected. */
+    EXPECT_EQ(ext::nullopt, Resample::Crop(image, 2, 0, 2, 1));
+    EXPECT_EQ(ext::nullopt, Resample::Crop(image, 0, 0, 0, 1));
+}
+
+TEST(Resample, BoxHalves)
+{
+    Image image = Image(4, 2, Gray, {
+        0,   100, 10, 20,
+        200, 100, 30, 40,
+    });
+
+    ext::optional<Image> scaled = Resample::Scale(image, 2, 1, Resample::Filter::Box);
+    ASSERT_NE(ext::nullopt, scaled);
+    EXPECT_EQ(std::vector<uint8_t>({ 100, 25 }), scaled->data());
+}
+
+TEST(Resample, SameSize)
+{
+    Image image = Image(2, 2, Gray, { 1, 2, 3, 4 });
+
+    ext::optional<Image> scaled = Resample::Scale(image, 2, 2, Resample::Filter::Lanczos);
+    ASSERT_NE(ext::nullopt, scaled);
+    EXPECT_EQ(image.data(), scaled->data());
+}
+
+TEST(Resample, LanczosKeepsFlatColor)
+{
+    Image image = Image(37, 23, Gray, std::vector<uint8_t>(37 * 23, 77));
+
+    /* Both smaller and larger. */
+    for (auto size : { std::make_pair(10, 7), std::make_pair(90, 50) }) {
+        ext::optional<Image> scaled = Resample::Scale(image, size.first, size.second, Resample::Filter::Lanczos);
+        ASSERT_NE(ext::nullopt, scaled);
+        EXPECT_EQ(std::vector<uint8_t>(size.first * size.second, 77), scaled->data());
+    }
+}
+
+TEST(Resample, StraightAlpha)
+{
+    /* Opaque red next to transparent green. */
+    Image image = Image(2, 1, RGBA, {
+        255, 0, 0,   255,
+        0,   255, 0, 0,
+    });
+
+    /* The transparent pixel's color must not show up. */
+    ext::optional<Image> scaled = Resample::Scale(image, 1, 1, Resample::Filter::Box);
+    ASSERT_NE(ext::nullopt, scaled);
+    EXPECT_EQ(std::vector<uint8_t>({ 255, 0, 0, 128 }), scaled->data());
+}
+
+TEST(Resample, Mipmaps)
+{
+    Image image = Image(8, 3, Gray, std::vector<uint8_t>(8 * 3, 9));
+
+    std::vector<Image> levels = Resample::Mipmaps(image, Resample::Filter::Box);
+    ASSERT_EQ(3, levels.size());
+    EXPECT_EQ(4, levels[0].width());
+    EXPECT_EQ(1, levels[0].height());
+    EXPECT_EQ(2, levels[1].width());
+    EXPECT_EQ(1, levels[2].width());
+    EXPECT_EQ(1, levels[2].height());
+    EXPECT_EQ(std::vector<uint8_t>({ 9 }), levels[2].data());
+}
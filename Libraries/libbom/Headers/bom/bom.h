@@ -115,6 +115,22 @@ bom_tree_reserve(struct bom_tree_context *tree, size_t count);
 void
 bom_tree_add(struct bom_tree_context *tree, const void *key, size_t key_len, const void *value, size_t value_len);
 
+struct bom_tree_item {
+    const void *key;
+    size_t key_len;
+    const void *value;
+    size_t value_len;
+};
+
+/*
+ * Adds all entries to an empty tree at once. The items are sorted by key
+ * in place, and the tree is built bottom-up from full leaves. Items whose
+ * values point to the same memory share a single stored value. Nothing can
+ * be added to the tree afterwards.
+ */
+void
+bom_tree_add_sorted(struct bom_tree_context *tree, struct bom_tree_item *items, size_t count);
+
 
 #ifdef __cplusplus
 }
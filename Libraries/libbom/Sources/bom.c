@@ -175,7 +175,10 @@ _bom_address_update_all(struct bom_context *context, uint32_t point, ptrdiff_t d
 static void
 _bom_address_resize(struct bom_context *context, uint32_t point, ptrdiff_t delta)
 {
-    _bom_address_update_all(context, point, delta);
+    /* Nothing is stored past the end, so appending there moves nothing. */
+    if (point < context->memory.size) {
+        _bom_address_update_all(context, point, delta);
+    }
 
     context->memory.resize(&context->memory, context->memory.size + delta);
     memmove(context->memory.data + point + delta, context->memory.data + point, context->memory.size - point - delta);
@@ -241,6 +244,16 @@ bom_index_reserve(struct bom_context *context, size_t count)
     assert(context != NULL);
     assert(context->iteration_count == 0 && "cannot mutate while iterating");
     struct bom_header *header = (struct bom_header *)context->memory.data;
+    struct bom_index_header *index_header = (struct bom_index_header *)((void *)header + ntohl(header->index_offset));
+
+    /* Only make room for indexes beyond those already free. Matches the check in `bom_index_add()`. */
+    size_t used_length = sizeof(struct bom_index_header) + sizeof(struct bom_index) * ntohl(index_header->count);
+    size_t limit_length = ntohl(header->index_length) - (sizeof(struct bom_index) * 2);
+    size_t available = (limit_length > used_length ? (limit_length - used_length) / sizeof(struct bom_index) : 0);
+    if (count <= available) {
+        return;
+    }
+    count -= available;
 
     /* Insert space for extra indexes at the end of the currently allocated space. */
     uint32_t index_point = ntohl(header->index_offset) + ntohl(header->index_length);
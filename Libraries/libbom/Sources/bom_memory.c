@@ -7,8 +7,12 @@
  of patent rights can be found in the PATENTS file in the same directory.
  */
 
-/* Enable access to ftruncate(). */
+/* Enable access to ftruncate(), and on Linux to fallocate() and mremap(). */
+#if defined(__linux__)
+#define _GNU_SOURCE
+#else
 #define _POSIX_C_SOURCE 200809L
+#endif
 
 #include <bom/bom.h>
 
@@ -20,17 +24,38 @@
 #include <unistd.h>
 #include <assert.h>
 
+struct _bom_context_memory_malloc_context {
+    size_t capacity;
+};
+
+/*
+ * Blocks are added one at a time, each growing the memory. Grow the
+ * backing store geometrically so that stays linear overall.
+ */
+static size_t
+_bom_context_memory_capacity(size_t capacity, size_t size)
+{
+    return (size > capacity * 2 ? size : capacity * 2);
+}
+
 static void
 _bom_context_memory_realloc(struct bom_context_memory *memory, size_t size)
 {
+    struct _bom_context_memory_malloc_context *context = memory->ctx;
+
+    if (size > context->capacity) {
+        context->capacity = _bom_context_memory_capacity(context->capacity, size);
+        memory->data = realloc(memory->data, context->capacity);
+    }
+
     memory->size = size;
-    memory->data = realloc(memory->data, memory->size);
 }
 
 static void
 _bom_context_memory_free(struct bom_context_memory *memory)
 {
     free(memory->data);
+    free(memory->ctx);
 }
 
 struct bom_context_memory
@@ -38,6 +63,9 @@ bom_context_memory(void const *data, size_t size)
 {
     void *new = malloc(size);
 
+    struct _bom_context_memory_malloc_context *context = malloc(sizeof(*context));
+    context->capacity = size;
+
     if (data != NULL) {
         memcpy(new, data, size);
     } else {
@@ -49,32 +77,81 @@ bom_context_memory(void const *data, size_t size)
         .size = size,
         .resize = _bom_context_memory_realloc,
         .free = _bom_context_memory_free,
-        .ctx = NULL,
+        .ctx = context,
     };
 }
 
 struct _bom_context_memory_mmap_context {
     int fd;
     bool writeable;
+    size_t capacity;
 };
 
+/*
+ * Files start small but often grow large, such as an archive gaining
+ * many renditions. Grow by at least this much, so that takes few steps.
+ */
+static size_t const _bom_context_memory_file_minimum_growth = 1024 * 1024;
+
+/*
+ * Extend a file to a size. Where supported, the new blocks are reserved
+ * up front without being written, so the file stays mostly contiguous
+ * and writes through the mapping can't fail for lack of space.
+ */
+static bool
+_bom_context_memory_file_extend(int fd, size_t size)
+{
+#if defined(__linux__)
+    if (fallocate(fd, 0, 0, size) == 0) {
+        return true;
+    }
+#endif
+
+    /* Otherwise, the extended part of the file is sparse until written. */
+    return ftruncate(fd, size) == 0;
+}
+
+/*
+ * Map a file again after extending it to its capacity.
+ */
+static void *
+_bom_context_memory_file_remap(struct _bom_context_memory_mmap_context *context, void *data, size_t previous)
+{
+#if defined(__linux__)
+    /* Grow the existing mapping, moving it only if there's no room. */
+    if (previous != 0) {
+        return mremap(data, previous, context->capacity, MREMAP_MAYMOVE);
+    }
+#endif
+
+    munmap(data, previous);
+
+    int prot = context->writeable ? PROT_READ | PROT_WRITE : PROT_READ;
+    return mmap(NULL, context->capacity, prot, MAP_SHARED, context->fd, 0);
+}
+
 static void
 _bom_context_memory_mremap(struct bom_context_memory *memory, size_t size)
 {
     struct _bom_context_memory_mmap_context *context = memory->ctx;
 
-    munmap(memory->data, memory->size);
-    if (size > memory->size) {
-        int ret = ftruncate(context->fd, size);
-        assert(ret == 0);
-        (void)ret;
+    /* The file is cut back to the used size once it's unmapped. */
+    if (size > context->capacity) {
+        size_t previous = context->capacity;
+        context->capacity = _bom_context_memory_capacity(context->capacity, size);
+        if (context->capacity - previous < _bom_context_memory_file_minimum_growth) {
+            context->capacity = previous + _bom_context_memory_file_minimum_growth;
+        }
+
+        bool extended = _bom_context_memory_file_extend(context->fd, context->capacity);
+        assert(extended);
+        (void)extended;
+
+        memory->data = _bom_context_memory_file_remap(context, memory->data, previous);
+        assert(memory->data != MAP_FAILED);
     }
 
     memory->size = size;
-
-    int prot = context->writeable ? PROT_READ | PROT_WRITE : PROT_READ;
-    memory->data = mmap(NULL, size, prot, MAP_SHARED, context->fd, 0);
-    assert((intptr_t)memory->data != -1);
 }
 
 static void
@@ -82,7 +159,13 @@ _bom_context_memory_munmap(struct bom_context_memory *memory)
 {
     struct _bom_context_memory_mmap_context *context = memory->ctx;
 
-    munmap(memory->data, memory->size);
+    munmap(memory->data, context->capacity);
+    if (context->writeable && context->capacity != memory->size) {
+        int ret = ftruncate(context->fd, memory->size);
+        assert(ret == 0);
+        (void)ret;
+    }
+
     close(context->fd);
     free(context);
 }
@@ -107,8 +190,7 @@ bom_context_memory_file(const char *fn, bool writeable, size_t minimum_size)
 
     // Expand file to minimum_size
     if (st.st_size < (off_t)minimum_size) {
-        int result = ftruncate(fd, minimum_size);
-        if (result != 0) {
+        if (!_bom_context_memory_file_extend(fd, minimum_size)) {
             close(fd);
             return (struct bom_context_memory) {
                 .data = NULL,
@@ -126,6 +208,7 @@ bom_context_memory_file(const char *fn, bool writeable, size_t minimum_size)
 
     int prot = context->writeable ? PROT_READ | PROT_WRITE : PROT_READ;
     size_t size = st.st_size < (off_t)minimum_size ? minimum_size : st.st_size;
+    context->capacity = size;
     void *data = mmap(NULL, size, prot, (writeable ? MAP_SHARED : MAP_PRIVATE), context->fd, 0);
 
     return (struct bom_context_memory) {
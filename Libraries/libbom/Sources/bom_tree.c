@@ -154,7 +154,7 @@ bom_tree_iterate(struct bom_tree_context *tree_context, bom_tree_iterator iterat
 
     struct bom_tree_entry *paths = (struct bom_tree_entry *)bom_index_get(tree_context->context, ntohl(tree->child), NULL);
     if (paths != NULL) {
-        if (!paths->is_leaf) {
+        while (paths != NULL && !paths->is_leaf) {
             struct bom_tree_entry_indexes *indexes = &paths->indexes[0];
             paths = (struct bom_tree_entry *)bom_index_get(tree_context->context, ntohl(indexes->value_index), NULL);
         }
@@ -236,3 +236,166 @@ bom_tree_add(struct bom_tree_context *tree_context, const void *key, size_t key_
     paths->count = htons(ntohs(paths->count) + 1);
 }
 
+
+static int
+_bom_tree_item_compare(const void *a, const void *b)
+{
+    const struct bom_tree_item *item_a = a;
+    const struct bom_tree_item *item_b = b;
+
+    size_t len = (item_a->key_len < item_b->key_len ? item_a->key_len : item_b->key_len);
+    int result = memcmp(item_a->key, item_b->key, len);
+    if (result != 0) {
+        return result;
+    }
+
+    return (item_a->key_len > item_b->key_len) - (item_a->key_len < item_b->key_len);
+}
+
+struct _bom_tree_value_ref {
+    const void *value;
+    size_t value_len;
+    size_t item;
+};
+
+static int
+_bom_tree_value_compare(const void *a, const void *b)
+{
+    const struct _bom_tree_value_ref *ref_a = a;
+    const struct _bom_tree_value_ref *ref_b = b;
+
+    if (ref_a->value != ref_b->value) {
+        return ((uintptr_t)ref_a->value > (uintptr_t)ref_b->value) - ((uintptr_t)ref_a->value < (uintptr_t)ref_b->value);
+    }
+    if (ref_a->value_len != ref_b->value_len) {
+        return (ref_a->value_len > ref_b->value_len) - (ref_a->value_len < ref_b->value_len);
+    }
+    return (ref_a->item > ref_b->item) - (ref_a->item < ref_b->item);
+}
+
+/*
+ * Adds one level of nodes over the given children, linked in order. Each
+ * child is described by its index and the index of its last key.
+ */
+static size_t
+_bom_tree_add_level(struct bom_tree_context *tree_context, int is_leaf, size_t per_node, uint32_t *value_indexes, uint32_t *key_indexes, size_t count, struct bom_tree_entry *node)
+{
+    size_t node_count = (count + per_node - 1) / per_node;
+
+    for (size_t n = 0; n < node_count; n++) {
+        size_t start = n * per_node;
+        size_t entries = (count - start < per_node ? count - start : per_node);
+
+        node->is_leaf = htons(is_leaf);
+        /* Branch nodes count the keys between their children. */
+        node->count = htons(is_leaf ? entries : entries - 1);
+        node->forward = htonl(0);
+        node->backward = htonl(0);
+        for (size_t i = 0; i < entries; i++) {
+            node->indexes[i].value_index = htonl(value_indexes[start + i]);
+            node->indexes[i].key_index = htonl(key_indexes[start + i]);
+        }
+
+        uint32_t node_index = bom_index_add(tree_context->context, node, sizeof(struct bom_tree_entry) + entries * sizeof(struct bom_tree_entry_indexes));
+
+        /* Nodes are described for the next level in place; it is read first. */
+        value_indexes[n] = node_index;
+        key_indexes[n] = key_indexes[start + entries - 1];
+    }
+
+    /* Link siblings once all of their indexes are known. */
+    for (size_t n = 0; n + 1 < node_count; n++) {
+        struct bom_tree_entry *current = (struct bom_tree_entry *)bom_index_get(tree_context->context, value_indexes[n], NULL);
+        struct bom_tree_entry *next = (struct bom_tree_entry *)bom_index_get(tree_context->context, value_indexes[n + 1], NULL);
+        current->forward = htonl(value_indexes[n + 1]);
+        next->backward = htonl(value_indexes[n]);
+    }
+
+    return node_count;
+}
+
+void
+bom_tree_add_sorted(struct bom_tree_context *tree_context, struct bom_tree_item *items, size_t count)
+{
+    assert(tree_context != NULL);
+    assert(items != NULL || count == 0);
+    assert(tree_context->tree_iterating == 0);
+
+    if (count == 0) {
+        return;
+    }
+
+    qsort(items, count, sizeof(*items), _bom_tree_item_compare);
+
+    uint32_t tree_index = bom_variable_get(tree_context->context, tree_context->variable_name);
+    struct bom_tree *tree = (struct bom_tree *)bom_index_get(tree_context->context, tree_index, NULL);
+    assert(ntohl(tree->path_count) == 0);
+
+    size_t node_size = ntohl(tree->node_size);
+    size_t per_node = (node_size - sizeof(struct bom_tree_entry)) / sizeof(struct bom_tree_entry_indexes);
+
+    /* Reserve indexes for every entry and node up front. */
+    size_t node_total = 0;
+    for (size_t level = count; ; ) {
+        level = (level + per_node - 1) / per_node;
+        node_total += level;
+        if (level == 1) {
+            break;
+        }
+    }
+    bom_index_reserve(tree_context->context, count * 2 + node_total);
+
+    uint32_t *value_indexes = malloc(sizeof(uint32_t) * count);
+    uint32_t *key_indexes = malloc(sizeof(uint32_t) * count);
+    struct bom_tree_entry *node = malloc(node_size);
+    assert(value_indexes != NULL && key_indexes != NULL && node != NULL);
+
+    /*
+     * Find items that share their value's memory. Each of those is stored
+     * once, by the first item in key order, and the rest refer to it.
+     */
+    struct _bom_tree_value_ref *refs = malloc(sizeof(struct _bom_tree_value_ref) * count);
+    size_t *shared = malloc(sizeof(size_t) * count);
+    assert(refs != NULL && shared != NULL);
+
+    for (size_t i = 0; i < count; i++) {
+        refs[i].value = items[i].value;
+        refs[i].value_len = items[i].value_len;
+        refs[i].item = i;
+    }
+    qsort(refs, count, sizeof(*refs), _bom_tree_value_compare);
+
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0 && refs[i].value == refs[i - 1].value && refs[i].value_len == refs[i - 1].value_len) {
+            shared[refs[i].item] = shared[refs[i - 1].item];
+        } else {
+            shared[refs[i].item] = refs[i].item;
+        }
+    }
+    free(refs);
+
+    for (size_t i = 0; i < count; i++) {
+        key_indexes[i] = bom_index_add(tree_context->context, items[i].key, items[i].key_len);
+        if (shared[i] == i) {
+            value_indexes[i] = bom_index_add(tree_context->context, items[i].value, items[i].value_len);
+        } else {
+            value_indexes[i] = value_indexes[shared[i]];
+        }
+    }
+    free(shared);
+
+    /* Build leaves, then each level of branches above them, up to a single root. */
+    size_t level_count = _bom_tree_add_level(tree_context, 1, per_node, value_indexes, key_indexes, count, node);
+    while (level_count > 1) {
+        level_count = _bom_tree_add_level(tree_context, 0, per_node, value_indexes, key_indexes, level_count, node);
+    }
+
+    /* Re-fetch, invalidated by adding. */
+    tree = (struct bom_tree *)bom_index_get(tree_context->context, tree_index, NULL);
+    tree->child = htonl(value_indexes[0]);
+    tree->path_count = htonl(count);
+
+    free(node);
+    free(key_indexes);
+    free(value_indexes);
+}
@@ -13,8 +13,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
-#include <sstream>
-#include <iomanip>
+#include <vector>
 
 #include <arpa/inet.h>
 
@@ -272,6 +271,50 @@ extern "C" {
     } __attribute__((packed));
 }
 
+/*
+ * A file's name and parent, for computing its full path. Full paths are
+ * built once per file, the first time the file or a child needs it, so
+ * each entry's path is one lookup rather than a walk to the root.
+ */
+struct file_info {
+    uint32_t parent;
+    std::string name;
+    std::string path;
+    bool resolved;
+};
+
+/*
+ * The full path of a file, resolving and storing its parents' paths too.
+ */
+static std::string const &
+ResolvePath(std::unordered_map<uint32_t, struct file_info> *files, uint32_t id)
+{
+    /* Find the nearest file whose path is already known. */
+    std::vector<struct file_info *> unresolved;
+    for (auto it = files->find(id); it != files->end() && !it->second.resolved; it = files->find(it->second.parent)) {
+        unresolved.push_back(&it->second);
+
+        /* A cycle would never reach the root. */
+        if (unresolved.size() > files->size()) {
+            break;
+        }
+    }
+
+    /* Then resolve down from there. */
+    for (auto it = unresolved.rbegin(); it != unresolved.rend(); ++it) {
+        struct file_info *file = *it;
+        auto parent = files->find(file->parent);
+        if (parent != files->end() && parent->second.resolved) {
+            file->path = parent->second.path + "/" + file->name;
+        } else {
+            file->path = file->name;
+        }
+        file->resolved = true;
+    }
+
+    return files->at(id).path;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -335,10 +378,6 @@ main(int argc, char **argv)
      */
 
     /* Store file pointers to their parent information. */
-    struct file_info {
-        uint32_t parent;
-        std::string name;
-    };
     std::unordered_map<uint32_t, struct file_info> files;
 
     /* Store data needed inside the iteration. */
@@ -367,9 +406,9 @@ main(int argc, char **argv)
         /*
          * Store file information for computing full path.
          */
-        struct file_info info = { file_key->parent, std::string(file_key->name) };
+        struct file_info info = { file_key->parent, std::string(file_key->name), std::string(), false };
         uint32_t path_info_1_value_id = path_info_1_value->id;
-        context->files->insert({ path_info_1_value_id, info });
+        context->files->insert({ path_info_1_value_id, std::move(info) });
 
         /*
          * Extract the secondary information for the file. This information is structured differently
@@ -417,12 +456,7 @@ main(int argc, char **argv)
         /*
          * Load full file path.
          */
-        std::string path = std::string(file_key->name);
-        uint32_t next_index = file_key->parent;
-        for (auto it = context->files->find(next_index); it != context->files->end(); it = context->files->find(next_index)) {
-            path = it->second.name + "/" + path;
-            next_index = it->second.parent;
-        }
+        std::string const &path = ResolvePath(context->files, path_info_1_value_id);
 
         /*
          * Print out requested details.
@@ -431,19 +465,12 @@ main(int argc, char **argv)
             printf("%s\n", path.c_str());
         } else {
             // TODO: Respect options about what to print.
-            std::stringstream stream;
-            stream << std::oct << ntohs(path_info_2_value->mode);
-            std::string mode = stream.str();
-            std::string UID = std::to_string(ntohl(path_info_2_value->user));
-            std::string GID = std::to_string(ntohl(path_info_2_value->group));
-            printf("%s\t%s\t%s/%s", path.c_str(), mode.c_str(), UID.c_str(), GID.c_str());
-            
+            printf("%s\t%o\t%u/%u", path.c_str(), ntohs(path_info_2_value->mode), ntohl(path_info_2_value->user), ntohl(path_info_2_value->group));
+
             if (path_info_2_value->type == bom_path_type_file) {
-                std::string size = std::to_string(ntohl(path_info_2_value->size));
-                std::string checksum = std::to_string(ntohl(path_info_2_value->checksum));
-                printf("\t%s\t%s", size.c_str(), checksum.c_str());
+                printf("\t%u\t%u", ntohl(path_info_2_value->size), ntohl(path_info_2_value->checksum));
             }
-            
+
             printf("\n");
         }
     }, reinterpret_cast<void *>(&context));
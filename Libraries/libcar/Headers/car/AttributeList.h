@@ -31,12 +31,24 @@ namespace car {
 /*
  * Stores a list of attribute identifiers and values. Used as a key for
  * renditions, which are uniquely identified by their attribute list.
+ *
+ * There are only a few identifiers, so values are stored in a fixed array
+ * indexed by identifier, with a bit set in a mask for each one present.
+ * Identifiers past the end of the array are not stored.
  */
 class AttributeList {
+public:
+    /*
+     * The number of identifiers that can be stored; one per bit of the mask.
+     */
+    static size_t const Capacity = 32;
+
 private:
-    std::unordered_map<enum car_attribute_identifier, uint16_t> _values;
+    uint32_t _mask;
+    uint16_t _values[Capacity];
 
 public:
+    AttributeList();
     AttributeList(std::unordered_map<enum car_attribute_identifier, uint16_t> const &values);
 
 public:
@@ -51,13 +63,14 @@ public:
     void set(enum car_attribute_identifier identifier, uint16_t value);
 
     /*
-     * Iterate over the contents of the attribute list. Unordered.
+     * Iterate over the contents of the attribute list, by identifier.
      */
     template<typename T>
     void iterate(T iterator) const
     {
-        for (auto const &entry : _values) {
-            iterator(entry.first, entry.second);
+        for (uint32_t mask = _mask; mask != 0; mask &= mask - 1) {
+            size_t identifier = __builtin_ctz(mask);
+            iterator(static_cast<enum car_attribute_identifier>(identifier), _values[identifier]);
         }
     }
 
@@ -66,6 +79,12 @@ public:
      */
     size_t count() const;
 
+    /*
+     * The identifiers in the list, as a mask of (1 << identifier).
+     */
+    uint32_t mask() const
+    { return _mask; }
+
 public:
     /*
      * Write an attribute list into an a vector of bytes using the identifier
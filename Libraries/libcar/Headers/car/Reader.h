@@ -34,22 +34,40 @@ public:
     typedef std::unique_ptr<struct bom_tree_context, decltype(&bom_tree_free)> unique_ptr_bom_tree;
 
 private:
+    /*
+     * Offsets of a tree entry into the BOM memory. Entries point straight
+     * into the (usually memory mapped) archive; nothing is copied or
+     * decoded until a facet or rendition is asked for.
+     */
     typedef struct {
-        void *key;
-        size_t key_len;
-        void *value;
-        size_t value_len;
+        uint32_t key;
+        uint32_t key_len;
+        uint32_t value;
+        uint32_t value_len;
     } KeyValuePair;
 
+    /*
+     * Renditions are indexed by their facet identifier, idiom, and scale,
+     * packed in that order into one integer. Sorted by that, so renditions
+     * of a facet (and of an idiom of it) are next to each other.
+     */
+    typedef std::pair<uint64_t, KeyValuePair> IndexedRendition;
+
 private:
-    unique_ptr_bom                                  _bom;
-    ext::optional<struct car_key_format *>          _keyfmt;
-    std::unordered_map<std::string, void *>         _facetValues;
-    std::unordered_multimap<uint16_t, KeyValuePair> _renditionValues;
+    unique_ptr_bom                            _bom;
+    ext::optional<struct car_key_format *>    _keyfmt;
+    std::unordered_map<std::string, uint32_t> _facetValues;
+    std::vector<IndexedRendition>             _renditionValues;
 
 private:
     Reader(unique_ptr_bom bom);
 
+private:
+    uint32_t offset(void const *pointer) const;
+    void *pointer(uint32_t offset) const;
+    Rendition rendition(KeyValuePair const &kv) const;
+    uint16_t keyValue(KeyValuePair const &kv, enum car_attribute_identifier identifier) const;
+
 public:
     void facetFastIterate(std::function<void(void *key, size_t key_len, void *value, size_t value_len)> const &facet) const;
     void renditionFastIterate(std::function<void(void *key, size_t key_len, void *value, size_t value_len)> const &iterator) const;
@@ -101,6 +119,13 @@ public:
      */
     std::vector<car::Rendition> lookupRenditions(Facet const &) const;
 
+    /*
+     * Lookup the renditions for a Facet that match all of the attributes.
+     * Attributes not in the key format match only zero. Logarithmic in the
+     * number of renditions when matching the idiom (and scale), only.
+     */
+    std::vector<car::Rendition> lookupRenditions(Facet const &facet, AttributeList const &attributes) const;
+
 public:
     /*
      * Print debug information about the archive.
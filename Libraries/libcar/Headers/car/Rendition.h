@@ -57,6 +57,7 @@ public:
 
     public:
         Data(std::vector<uint8_t> const &data, Format format);
+        Data(std::vector<uint8_t> &&data, Format format);
 
     public:
         /*
@@ -86,6 +87,24 @@ public:
         HorizontalScaleVerticalUniform,
     };
 
+public:
+    enum class Compression {
+        Zlib,
+        /*
+         * zlib at its fastest level. The output is somewhat larger but is
+         * written several times faster, and it reads back as plain zlib.
+         */
+        ZlibFast,
+        LZVN,
+        LZFSE,
+    };
+
+    /*
+     * If a compression algorithm can be used on this platform. Only zlib
+     * is available everywhere; LZVN and LZFSE need libcompression.
+     */
+    static bool CompressionSupported(Compression compression);
+
 public:
     struct Slice {
         uint32_t x;
@@ -113,10 +132,12 @@ private:
     std::vector<Slice>              _slices;
     enum car_rendition_value_layout _layout;
     ext::optional<std::string>      _UTI;
+    Compression                     _compression;
 
 private:
     Rendition(AttributeList const &attributes, std::function<ext::optional<Data>(Rendition const *)> const &data);
     Rendition(AttributeList const &attributes, ext::optional<Data> const &data);
+    Rendition(AttributeList const &attributes, ext::optional<Data> &&data);
 
 public:
     /*
@@ -192,6 +213,14 @@ public:
     enum car_rendition_value_layout &layout()
     { return _layout; }
 
+    /*
+     * Compression used when writing bitmap data.
+     */
+    Compression compression() const
+    { return _compression; }
+    Compression &compression()
+    { return _compression; }
+
 public:
     /*
      * If the rendition is resizable at all.
@@ -219,7 +248,8 @@ public:
 
 public:
     /*
-     * The rendition pixel data. May incur expensive decoding.
+     * The rendition pixel data. May incur expensive decoding, and copies
+     * data the rendition holds; see `write()` to serialize without either.
      */
     ext::optional<Data> data() const;
 
@@ -254,6 +284,14 @@ public:
     static Rendition Create(
         AttributeList const &attributes,
         ext::optional<Data> const &data);
+
+    /*
+     * Create a new rendition taking over the given pixel data, so large
+     * images aren't copied on their way into an archive.
+     */
+    static Rendition Create(
+        AttributeList const &attributes,
+        ext::optional<Data> &&data);
 };
 
 }
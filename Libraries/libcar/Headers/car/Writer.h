@@ -18,9 +18,11 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 #include <ext/optional>
+#include <car/AttributeList.h>
 
 namespace car {
 
@@ -45,6 +47,7 @@ private:
     std::unordered_map<std::string, Facet> _facets;
     std::unordered_multimap<uint16_t, Rendition> _renditions;
     std::vector<KeyValuePair> _rawRenditions;
+    std::vector<std::pair<AttributeList, std::vector<uint8_t>>> _encodedRenditions;
 
 private:
     Writer(unique_ptr_bom bom);
@@ -66,12 +69,19 @@ public:
      * Add a rendition for a facet, allow lazy loading of data.
      */
     void addRendition(Rendition const &rendition);
+    void addRendition(Rendition &&rendition);
 
     /*
      * Add a rendition for a facet, optimized for fast editing of CAR files
      */
     void addRendition(void *key, size_t keyLength, void *value, size_t valueLength);
 
+    /*
+     * Add a rendition already serialized by `Rendition::write()`, such as
+     * one kept from an earlier compilation.
+     */
+    void addRendition(AttributeList const &attributes, std::vector<uint8_t> &&value);
+
     /*
      * The key format, optional and determined automatically if omitted.
      */
@@ -11,18 +11,28 @@
 
 using car::AttributeList;
 
+AttributeList::
+AttributeList() :
+    _mask(0),
+    _values()
+{
+}
+
 AttributeList::
 AttributeList(std::unordered_map<enum car_attribute_identifier, uint16_t> const &values) :
-    _values(values)
+    _mask(0),
+    _values()
 {
+    for (auto const &entry : values) {
+        set(entry.first, entry.second);
+    }
 }
 
 ext::optional<uint16_t> AttributeList::
 get(enum car_attribute_identifier identifier) const
 {
-    auto it = _values.find(identifier);
-    if (it != _values.end()) {
-        return it->second;
+    if (static_cast<size_t>(identifier) < Capacity && (_mask & (1u << identifier)) != 0) {
+        return _values[identifier];
     }
 
     return ext::nullopt;
@@ -31,49 +41,49 @@ get(enum car_attribute_identifier identifier) const
 void AttributeList::
 set(enum car_attribute_identifier identifier, uint16_t value)
 {
-    _values[identifier] = value;
+    if (static_cast<size_t>(identifier) < Capacity) {
+        _mask |= (1u << identifier);
+        _values[identifier] = value;
+    }
 }
 
 size_t AttributeList::
 count() const
 {
-    return _values.size();
+    return __builtin_popcount(_mask);
 }
 
 void AttributeList::
 dump() const
 {
-    for (auto const &entry : _values) {
-        enum car_attribute_identifier identifier = entry.first;
-        uint16_t value = entry.second;
-
+    iterate([](enum car_attribute_identifier identifier, uint16_t value) {
         if (identifier < sizeof(car_attribute_identifier_names) / sizeof(*car_attribute_identifier_names)) {
             printf("[%02d] %-24s = %-6d | %-4x\n", identifier, car_attribute_identifier_names[identifier] ?: "(unknown)", value, value);
         } else {
             printf("[%02d] %-24s = %-6d | %-4x\n", identifier, "(unknown)", value, value);
         }
-    }
+    });
 }
 
 AttributeList AttributeList::
 Load(size_t count, uint32_t const *identifiers, uint16_t const *values)
 {
-    std::unordered_map<enum car_attribute_identifier, uint16_t> attributes;
+    AttributeList attributes;
     for (size_t i = 0; i < count; ++i) {
-        attributes.insert({ (enum car_attribute_identifier)identifiers[i], values[i] });
+        attributes.set((enum car_attribute_identifier)identifiers[i], values[i]);
     }
-    return AttributeList(attributes);
+    return attributes;
 }
 
 AttributeList AttributeList::
 Load(size_t count, struct car_attribute_pair const *pairs)
 {
-    std::unordered_map<enum car_attribute_identifier, uint16_t> attributes;
+    AttributeList attributes;
     for (size_t i = 0; i < count; ++i) {
         uint16_t value = pairs[i].value;
-        attributes.insert({ (enum car_attribute_identifier)pairs[i].identifier, value });
+        attributes.set((enum car_attribute_identifier)pairs[i].identifier, value);
     }
-    return AttributeList(attributes);
+    return attributes;
 }
 
 std::vector<uint8_t> AttributeList::
@@ -81,16 +91,13 @@ write(size_t count, uint32_t const *identifiers) const
 {
     std::vector<uint8_t> output = std::vector<uint8_t>(sizeof(uint16_t) * count);
     uint16_t *values = reinterpret_cast<uint16_t *>(output.data());
-    std::unordered_map<enum car_attribute_identifier, uint16_t> attributes;
     for (size_t i = 0; i < count; ++i) {
-        enum car_attribute_identifier identifier = (enum car_attribute_identifier) identifiers[i];
-        auto result = _values.find(identifier);
-        if (result != _values.end()) {
-            values[i] = result->second;
+        uint32_t identifier = identifiers[i];
+        if (identifier < Capacity && (_mask & (1u << identifier)) != 0) {
+            values[i] = _values[identifier];
         } else {
             values[i] = 0;
         }
     }
     return output;
 }
-
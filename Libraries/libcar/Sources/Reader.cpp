@@ -12,6 +12,8 @@
 #include <car/Rendition.h>
 #include <car/car_format.h>
 
+#include <algorithm>
+#include <iterator>
 #include <limits>
 #include <random>
 
@@ -32,6 +34,52 @@ Reader(unique_ptr_bom bom) :
 {
 }
 
+uint32_t Reader::
+offset(void const *pointer) const
+{
+    struct bom_context_memory const *memory = bom_memory(_bom.get());
+    return (uint32_t)((uintptr_t)pointer - (uintptr_t)memory->data);
+}
+
+void *Reader::
+pointer(uint32_t offset) const
+{
+    struct bom_context_memory const *memory = bom_memory(_bom.get());
+    return (void *)((uintptr_t)memory->data + offset);
+}
+
+Rendition Reader::
+rendition(KeyValuePair const &kv) const
+{
+    auto keyfmt = *_keyfmt;
+    car_rendition_key *rendition_key = (car_rendition_key *)pointer(kv.key);
+    struct car_rendition_value *rendition_value = (struct car_rendition_value *)pointer(kv.value);
+    AttributeList attributes = AttributeList::Load(keyfmt->num_identifiers, keyfmt->identifier_list, rendition_key);
+
+    /* Pixel data is only decoded if it is requested from the rendition. */
+    return Rendition::Load(attributes, rendition_value);
+}
+
+uint16_t Reader::
+keyValue(KeyValuePair const &kv, enum car_attribute_identifier identifier) const
+{
+    auto keyfmt = *_keyfmt;
+    car_rendition_key *rendition_key = (car_rendition_key *)pointer(kv.key);
+    for (size_t i = 0; i < keyfmt->num_identifiers; i++) {
+        if (keyfmt->identifier_list[i] == static_cast<uint32_t>(identifier)) {
+            return rendition_key[i];
+        }
+    }
+
+    return 0;
+}
+
+static uint64_t
+IndexKey(uint16_t identifier, uint16_t idiom, uint16_t scale)
+{
+    return (static_cast<uint64_t>(identifier) << 32) | (static_cast<uint64_t>(idiom) << 16) | static_cast<uint64_t>(scale);
+}
+
 struct _car_iterator_ctx {
     Reader const *reader;
     void *iterator;
@@ -60,7 +108,7 @@ void Reader::
 facetIterate(std::function<void(Facet const &)> const &iterator) const
 {
     for (const auto &item : _facetValues) {
-        Facet facet = Facet::Load(item.first, (struct car_facet_value *)item.second);
+        Facet facet = Facet::Load(item.first, (struct car_facet_value *)pointer(item.second));
         iterator(facet);
     }
 }
@@ -81,14 +129,8 @@ facetFastIterate(std::function<void(void *key, size_t key_len, void *value, size
 void Reader::
 renditionIterate(std::function<void(Rendition const &)> const &iterator) const
 {
-    auto keyfmt = *_keyfmt;
     for (const auto &it : _renditionValues) {
-        KeyValuePair kv = (KeyValuePair)it.second;
-        car_rendition_key *rendition_key = (car_rendition_key *)kv.key;
-        struct car_rendition_value *rendition_value = (struct car_rendition_value *)kv.value;
-        AttributeList attributes = AttributeList::Load(keyfmt->num_identifiers, keyfmt->identifier_list, rendition_key);
-        Rendition rendition = Rendition::Load(attributes, rendition_value);
-        iterator(rendition);
+        iterator(rendition(it.second));
     }
 }
 
@@ -189,7 +231,7 @@ Load(unique_ptr_bom bom)
      */
     reader.facetFastIterate([&reader](void *key, size_t key_len, void *value, size_t value_len) {
         auto name = std::string(static_cast<char *>(key), key_len);
-        reader._facetValues.insert({ name, value });
+        reader._facetValues.insert({ name, reader.offset(value) });
     });
 
     /* Load the key format from the BOM. */
@@ -202,28 +244,47 @@ Load(unique_ptr_bom bom)
     reader._keyfmt = ext::optional<struct car_key_format*>(keyfmt);
 
     /*
-     * The index into the attribute list for the identifer for the matching facet.
-     * The attribute list is a list of uint16_t in the key portion of the entry for the rendition.
+     * The indexes into the attribute list for the identifer for the matching facet,
+     * and for the idiom and scale. The attribute list is a list of uint16_t in the
+     * key portion of the entry for the rendition.
      */
-    size_t identifier_index = 0;
+    int identifier_index = -1;
+    int idiom_index = -1;
+    int scale_index = -1;
 
-    /* Scan the key format for the facet identifier index. */
+    /* Scan the key format for the indexes. */
     for (size_t i = 0; i < keyfmt->num_identifiers; i++) {
-        if (keyfmt->identifier_list[i] == car_attribute_identifier_identifier) {
-            identifier_index = i;
-            break;
+        switch (keyfmt->identifier_list[i]) {
+            case car_attribute_identifier_identifier:
+                identifier_index = i;
+                break;
+            case car_attribute_identifier_idiom:
+                idiom_index = i;
+                break;
+            case car_attribute_identifier_scale:
+                scale_index = i;
+                break;
         }
     }
 
-    /* Iterate through the renditions as fast as possible. Save the key and value pointers, indexed by the Facet identifier. */
-    reader.renditionFastIterate([identifier_index,&reader](void *key, size_t key_len, void *value, size_t value_len) {
+    /* Iterate through the renditions as fast as possible. Save the key and value pointers, indexed by the Facet identifier, idiom, and scale. */
+    reader.renditionFastIterate([identifier_index, idiom_index, scale_index, &reader](void *key, size_t key_len, void *value, size_t value_len) {
         KeyValuePair kv;
-        kv.key = key;
+        kv.key = reader.offset(key);
         kv.key_len = key_len;
-        kv.value = value;
+        kv.value = reader.offset(value);
         kv.value_len = value_len;
         car_rendition_key *rendition_key = (car_rendition_key *)key;
-        reader._renditionValues.insert({ rendition_key[identifier_index], kv });
+        uint64_t index = IndexKey(
+            identifier_index != -1 ? rendition_key[identifier_index] : 0,
+            idiom_index != -1 ? rendition_key[idiom_index] : 0,
+            scale_index != -1 ? rendition_key[scale_index] : 0);
+        reader._renditionValues.push_back({ index, kv });
+    });
+
+    /* Keep renditions with the same index in archive order. */
+    std::stable_sort(reader._renditionValues.begin(), reader._renditionValues.end(), [](IndexedRendition const &lhs, IndexedRendition const &rhs) {
+        return lhs.first < rhs.first;
     });
 
     return std::move(reader);
@@ -240,7 +301,7 @@ Reader::lookupFacet(std::string name) const
         return result;
     }
 
-    struct car_facet_value *facet_value = (struct car_facet_value *)lookup->second;
+    struct car_facet_value *facet_value = (struct car_facet_value *)pointer(lookup->second);
     AttributeList attributes = AttributeList::Load(facet_value->attributes_count, facet_value->attributes);
     result = Facet::Create(name, attributes);
 
@@ -262,15 +323,65 @@ lookupRenditions(Facet const &facet) const
         return result;
     }
 
-    auto keyfmt = *_keyfmt;
-    auto lookupRendition = _renditionValues.equal_range(*facet_identifier);
-    for (auto it = lookupRendition.first; it != lookupRendition.second; ++it) {
-        KeyValuePair value = (KeyValuePair)it->second;
-        car_rendition_key *rendition_key = (car_rendition_key *)value.key;
-        struct car_rendition_value *rendition_value = (struct car_rendition_value *)value.value;
-        AttributeList attributes = AttributeList::Load(keyfmt->num_identifiers, keyfmt->identifier_list, rendition_key);
-        Rendition rendition = Rendition::Load(attributes, rendition_value);
-        result.push_back(rendition);
+    return lookupRenditions(facet, AttributeList());
+}
+
+std::vector<Rendition> Reader::
+lookupRenditions(Facet const &facet, AttributeList const &attributes) const
+{
+    std::vector<Rendition> result;
+    ext::optional<uint16_t> facet_identifier = facet.attributes().get(car_attribute_identifier_identifier);
+
+    if (!facet_identifier) {
+        return result;
+    }
+
+    if (!_keyfmt) {
+        // Expected to be ready
+        return result;
+    }
+
+    /*
+     * Narrow down to the range of the index matching the facet, and then
+     * its idiom and scale if those are given. Other attributes are checked
+     * against the keys of the renditions in that range.
+     */
+    ext::optional<uint16_t> idiom = attributes.get(car_attribute_identifier_idiom);
+    ext::optional<uint16_t> scale = attributes.get(car_attribute_identifier_scale);
+
+    uint64_t first = IndexKey(*facet_identifier, 0, 0);
+    uint64_t last = IndexKey(*facet_identifier, UINT16_MAX, UINT16_MAX);
+    uint32_t indexed = (1u << car_attribute_identifier_identifier);
+    if (idiom) {
+        first = IndexKey(*facet_identifier, *idiom, 0);
+        last = IndexKey(*facet_identifier, *idiom, UINT16_MAX);
+        indexed |= (1u << car_attribute_identifier_idiom);
+
+        if (scale) {
+            first = last = IndexKey(*facet_identifier, *idiom, *scale);
+            indexed |= (1u << car_attribute_identifier_scale);
+        }
+    }
+
+    auto begin = std::lower_bound(_renditionValues.begin(), _renditionValues.end(), first, [](IndexedRendition const &lhs, uint64_t rhs) {
+        return lhs.first < rhs;
+    });
+    auto end = std::upper_bound(begin, _renditionValues.end(), last, [](uint64_t lhs, IndexedRendition const &rhs) {
+        return lhs < rhs.first;
+    });
+
+    result.reserve(std::distance(begin, end));
+    for (auto it = begin; it != end; ++it) {
+        bool matches = true;
+        attributes.iterate([&](enum car_attribute_identifier identifier, uint16_t value) {
+            if (matches && (indexed & (1u << identifier)) == 0 && keyValue(it->second, identifier) != value) {
+                matches = false;
+            }
+        });
+
+        if (matches) {
+            result.push_back(rendition(it->second));
+        }
     }
     return result;
 }
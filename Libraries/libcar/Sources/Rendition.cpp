@@ -10,7 +10,9 @@
 #include <car/Rendition.h>
 #include <car/Reader.h>
 #include <car/car_format.h>
+#include <libutil/Parallel.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <cstdio>
@@ -39,6 +41,13 @@ Data(std::vector<uint8_t> const &data, Format format) :
 {
 }
 
+Rendition::Data::
+Data(std::vector<uint8_t> &&data, Format format) :
+    _data  (std::move(data)),
+    _format(format)
+{
+}
+
 size_t Rendition::Data::
 FormatSize(Rendition::Data::Format format)
 {
@@ -55,6 +64,25 @@ FormatSize(Rendition::Data::Format format)
     abort();
 }
 
+bool Rendition::
+CompressionSupported(Compression compression)
+{
+    switch (compression) {
+        case Compression::Zlib:
+        case Compression::ZlibFast:
+            return true;
+        case Compression::LZVN:
+        case Compression::LZFSE:
+#if HAVE_LIBCOMPRESSION
+            return true;
+#else
+            return false;
+#endif
+    }
+
+    abort();
+}
+
 Rendition::
 Rendition(AttributeList const &attributes, std::function<ext::optional<Data>(Rendition const *)> const &data) :
     _attributes  (attributes),
@@ -64,7 +92,8 @@ Rendition(AttributeList const &attributes, std::function<ext::optional<Data>(Ren
     _scale       (1.0),
     _isVector    (false),
     _isOpaque    (false),
-    _isResizable (false)
+    _isResizable (false),
+    _compression (Compression::Zlib)
 {
 }
 
@@ -77,7 +106,22 @@ Rendition(AttributeList const &attributes, ext::optional<Data> const &data) :
     _scale      (1.0),
     _isVector   (false),
     _isOpaque   (false),
-    _isResizable(false)
+    _isResizable(false),
+    _compression(Compression::Zlib)
+{
+}
+
+Rendition::
+Rendition(AttributeList const &attributes, ext::optional<Data> &&data) :
+    _attributes (attributes),
+    _data       (std::move(data)),
+    _width      (0),
+    _height     (0),
+    _scale      (1.0),
+    _isVector   (false),
+    _isOpaque   (false),
+    _isResizable(false),
+    _compression(Compression::Zlib)
 {
 }
 
@@ -124,7 +168,7 @@ dump() const
 }
 
 static ext::optional<Rendition::Data> Decode(struct car_rendition_value *value);
-static ext::optional<std::vector<uint8_t>> Encode(Rendition const *rendition, ext::optional<Rendition::Data> data);
+static ext::optional<std::vector<uint8_t>> Encode(Rendition const *rendition, Rendition::Data const *data);
 
 
 static Rendition::ResizeMode
@@ -355,12 +399,13 @@ Decode(struct car_rendition_value *value)
                return ext::nullopt;
             }
 
-            strm.avail_out = uncompressed_length;
-            strm.next_out = (Bytef *)uncompressed_data;
+            strm.avail_out = uncompressed_length - offset;
+            strm.next_out = (Bytef *)uncompressed_data + offset;
 
             ret = inflate(&strm, Z_NO_FLUSH);
             if (ret != Z_OK && ret != Z_STREAM_END) {
                 printf("error: decompression failure: %x.\n", ret);
+                inflateEnd(&strm);
                 return ext::nullopt;
             }
 
@@ -369,7 +414,14 @@ Decode(struct car_rendition_value *value)
                 return ext::nullopt;
             }
 
-            offset += (uncompressed_length - strm.avail_out);
+            size_t decoded = (uncompressed_length - offset) - strm.avail_out;
+            if (decoded == 0) {
+                fprintf(stderr, "error: decompression made no progress\n");
+                return ext::nullopt;
+            }
+
+            offset += decoded;
+            compressed_data = (void *)((uintptr_t)compressed_data + compressed_length);
         } else if (header1->compression == car_rendition_data_compression_magic_rle) {
             fprintf(stderr, "error: unable to handle RLE\n");
             return ext::nullopt;
@@ -413,10 +465,83 @@ Decode(struct car_rendition_value *value)
     return data;
 }
 
+static bool
+CompressZlib(int deflateLevel, uint8_t const *uncompressed_data, size_t uncompressed_length, std::vector<uint8_t> *compressed_vector)
+{
+    int windowSize = 16+MAX_WBITS;
+    z_stream zlibStream;
+    memset(&zlibStream, 0, sizeof(zlibStream));
+    zlibStream.next_in = (Bytef*)uncompressed_data;
+    zlibStream.avail_in = (uInt)uncompressed_length;
+    int err = deflateInit2(&zlibStream, deflateLevel, Z_DEFLATED, windowSize, 8, Z_DEFAULT_STRATEGY);
+    if (err != Z_OK) {
+        return false;
+    }
+
+    /* The bound is enough to finish in a single call. */
+    compressed_vector->resize(deflateBound(&zlibStream, uncompressed_length));
+    zlibStream.next_out = (Bytef*)compressed_vector->data();
+    zlibStream.avail_out = (uInt)compressed_vector->size();
+    err = deflate(&zlibStream, Z_FINISH);
+    if (err != Z_STREAM_END) {
+        deflateEnd(&zlibStream);
+        fprintf(stderr, "Zlib error %d", err);
+        return false;
+    }
+
+    compressed_vector->resize(compressed_vector->size() - zlibStream.avail_out);
+    deflateEnd(&zlibStream);
+    return true;
+}
+
+#if HAVE_LIBCOMPRESSION
+static bool
+CompressLibcompression(compression_algorithm algorithm, uint8_t const *uncompressed_data, size_t uncompressed_length, std::vector<uint8_t> *compressed_vector)
+{
+    /* Leave room for data that does not compress. */
+    compressed_vector->resize(uncompressed_length + uncompressed_length / 8 + 4096);
+
+    size_t compressed_length = compression_encode_buffer(compressed_vector->data(), compressed_vector->size(), uncompressed_data, uncompressed_length, NULL, algorithm);
+    if (compressed_length == 0) {
+        fprintf(stderr, "error: compression failure\n");
+        return false;
+    }
+
+    compressed_vector->resize(compressed_length);
+    return true;
+}
+#endif
+
+static bool
+Compress(Rendition::Compression compression, uint8_t const *uncompressed_data, size_t uncompressed_length, std::vector<uint8_t> *compressed_vector)
+{
+    switch (compression) {
+        case Rendition::Compression::Zlib:
+            return CompressZlib(Z_DEFAULT_COMPRESSION, uncompressed_data, uncompressed_length, compressed_vector);
+        case Rendition::Compression::ZlibFast:
+            return CompressZlib(Z_BEST_SPEED, uncompressed_data, uncompressed_length, compressed_vector);
+#if HAVE_LIBCOMPRESSION
+        case Rendition::Compression::LZVN:
+            return CompressLibcompression((compression_algorithm)_COMPRESSION_LZVN, uncompressed_data, uncompressed_length, compressed_vector);
+        case Rendition::Compression::LZFSE:
+            return CompressLibcompression(COMPRESSION_LZFSE, uncompressed_data, uncompressed_length, compressed_vector);
+#endif
+        default:
+            return false;
+    }
+}
+
+/*
+ * Bitmaps larger than this are split into chunks of whole rows, each
+ * compressed separately. The chunks are compressed in parallel and can
+ * be decompressed independently.
+ */
+static size_t const ChunkLength = 1024 * 1024;
+
 static ext::optional<std::vector<uint8_t>>
-Encode(Rendition const *rendition, ext::optional<Rendition::Data> data)
+Encode(Rendition const *rendition, Rendition::Data const *data)
 {
-    if (!data || data->data().size() == 0) {
+    if (data == nullptr || data->data().size() == 0) {
         return ext::nullopt;
     }
 
@@ -427,52 +552,75 @@ Encode(Rendition const *rendition, ext::optional<Rendition::Data> data)
         return data->data();
     }
 
-    // The selected algorithm, only zlib for now
-    enum car_rendition_data_compression_magic compression_magic = car_rendition_data_compression_magic_zlib;
+    enum car_rendition_data_compression_magic compression_magic;
+    switch (rendition->compression()) {
+        case Rendition::Compression::Zlib:
+        case Rendition::Compression::ZlibFast:
+            compression_magic = car_rendition_data_compression_magic_zlib;
+            break;
+        case Rendition::Compression::LZVN:
+            compression_magic = car_rendition_data_compression_magic_lzvn;
+            break;
+        case Rendition::Compression::LZFSE:
+            compression_magic = car_rendition_data_compression_magic_jpeg_lzfse;
+            break;
+        default:
+            abort();
+    }
+
+    if (!Rendition::CompressionSupported(rendition->compression())) {
+        fprintf(stderr, "error: compression algorithm is not supported\n");
+        return ext::nullopt;
+    }
+
     size_t bytes_per_pixel = Rendition::Data::FormatSize(data->format());
+    size_t row_length = rendition->width() * bytes_per_pixel;
+    size_t uncompressed_length = rendition->height() * row_length;
+    uint8_t const *uncompressed_data = data->data().data();
+    if (row_length == 0 || data->data().size() < uncompressed_length) {
+        return ext::nullopt;
+    }
 
-    size_t uncompressed_length = rendition->width() * rendition->height() * bytes_per_pixel;
-    void *uncompressed_data = static_cast<void *>(data->data().data());
-
-    std::vector<uint8_t> compressed_vector;
-    if (compression_magic == car_rendition_data_compression_magic_zlib) {
-        int deflateLevel = Z_DEFAULT_COMPRESSION;
-        int windowSize = 16+MAX_WBITS;
-        z_stream zlibStream;
-        memset(&zlibStream, 0, sizeof(zlibStream));
-        zlibStream.next_in = (Bytef*)uncompressed_data;
-        zlibStream.avail_in = (uInt)uncompressed_length;
-        int err = deflateInit2(&zlibStream, deflateLevel, Z_DEFLATED, windowSize, 8, Z_DEFAULT_STRATEGY);
-        if (err != Z_OK) {
-            return ext::nullopt;
-        }
-        while (true) {
-            uint8_t tmp[4096];
-            zlibStream.next_out = (Bytef*)&tmp;
-            zlibStream.avail_out = (uInt)sizeof(tmp);
-            err = deflate(&zlibStream, Z_FINISH);
-            size_t block_size = sizeof(tmp) - zlibStream.avail_out;
-            compressed_vector.resize(compressed_vector.size() + block_size);
-            memcpy(&compressed_vector[compressed_vector.size() - block_size], &tmp[0], block_size);
-            if (err == Z_STREAM_END) {  /* Done */
-                break;
-            }
-            if (err != Z_OK) {  /* Z_OK -> Made progress, else err */
-                deflateEnd(&zlibStream);
-                fprintf(stderr, "Zlib error %d", err);
-                return ext::nullopt;
-            }
-        }
-        deflateEnd(&zlibStream);
+    /*
+     * Split into chunks of whole rows.
+     */
+    size_t chunk_rows = std::max<size_t>(ChunkLength / row_length, 1);
+    size_t chunk_count = (rendition->height() + chunk_rows - 1) / chunk_rows;
+
+    std::vector<std::vector<uint8_t>> chunks = std::vector<std::vector<uint8_t>>(chunk_count);
+    std::vector<uint8_t> succeeded = std::vector<uint8_t>(chunk_count);
+    libutil::Parallel::For(chunk_count, [&](size_t index) {
+        size_t start = index * chunk_rows * row_length;
+        size_t length = std::min(chunk_rows * row_length, uncompressed_length - start);
+        succeeded[index] = Compress(rendition->compression(), uncompressed_data + start, length, &chunks[index]);
+    });
+
+    if (std::find(succeeded.begin(), succeeded.end(), 0) != succeeded.end()) {
+        return ext::nullopt;
     }
 
     std::vector<uint8_t> output = std::vector<uint8_t>(sizeof(struct car_rendition_data_header1));
 
+    if (chunk_count == 1) {
+        /* A single chunk is stored directly after the first header. */
+        output.insert(output.end(), chunks[0].begin(), chunks[0].end());
+    } else {
+        /* Each chunk has its own header with its length. Other fields are unknown. */
+        for (std::vector<uint8_t> const &chunk : chunks) {
+            size_t offset = output.size();
+            output.resize(offset + sizeof(struct car_rendition_data_header2));
+
+            struct car_rendition_data_header2 *header2 = reinterpret_cast<struct car_rendition_data_header2 *>(&output[offset]);
+            memcpy(header2->magic, "KCBC", sizeof(header2->magic));
+            header2->length = chunk.size();
+            output.insert(output.end(), chunk.begin(), chunk.end());
+        }
+    }
+
     struct car_rendition_data_header1 *header1 = reinterpret_cast<struct car_rendition_data_header1 *>(output.data());
     memcpy(header1->magic, "MLEC", sizeof(header1->magic));
-    header1->length = compressed_vector.size();
+    header1->length = output.size() - sizeof(struct car_rendition_data_header1);
     header1->compression = compression_magic;
-    output.insert(output.end(), compressed_vector.begin(), compressed_vector.end());
 
     return output;
 }
@@ -493,6 +641,14 @@ Create(
     return Rendition(attributes, data);
 }
 
+Rendition Rendition::
+Create(
+    AttributeList const &attributes,
+    ext::optional<Data> &&data)
+{
+    return Rendition(attributes, std::move(data));
+}
+
 std::vector<uint8_t> Rendition::
 write() const
 {
@@ -568,9 +724,20 @@ write() const
     info_bitmap_info.header.length = sizeof(struct car_rendition_info_bitmap_info) - sizeof(struct car_rendition_info_header);
     info_bitmap_info.exif_orientation = 1; // XXX FIXME
 
+    /* Use held data in place; only deferred data needs loading. */
+    ext::optional<Data> deferredData;
+    Data const *renditionData = nullptr;
+    if (_data) {
+        renditionData = &*_data;
+    } else if (_deferredData) {
+        deferredData = _deferredData(this);
+        if (deferredData) {
+            renditionData = &*deferredData;
+        }
+    }
+
     size_t bytes_per_pixel = 0;
-    auto renditionData = this->data();
-    switch (renditionData->format()) {
+    switch (renditionData != nullptr ? renditionData->format() : Rendition::Data::Format::Data) {
         case Rendition::Data::Format::PremultipliedBGRA8:
             bytes_per_pixel = 4;
             header.pixel_format = car_rendition_value_pixel_format_argb;
@@ -9,10 +9,12 @@
 
 #include <car/Writer.h>
 #include <car/car_format.h>
+#include <libutil/Parallel.h>
 
+#include <algorithm>
+#include <functional>
 #include <random>
-#include <set>
-#include <unordered_set>
+#include <unordered_map>
 #include <vector>
 
 #include <string.h>
@@ -20,6 +22,7 @@
 using car::Writer;
 using car::Facet;
 using car::Rendition;
+using car::AttributeList;
 
 Writer::
 Writer(unique_ptr_bom bom) :
@@ -48,6 +51,15 @@ addRendition(Rendition const &rendition)
     }
 }
 
+void Writer::
+addRendition(Rendition &&rendition)
+{
+    auto identifier = rendition.attributes().get(car_attribute_identifier_identifier);
+    if (identifier != ext::nullopt) {
+        _renditions.insert({ *identifier, std::move(rendition) });
+    }
+}
+
 void Writer::
 addRendition(void *key, size_t key_len, void *value, size_t value_len)
 {
@@ -55,27 +67,85 @@ addRendition(void *key, size_t key_len, void *value, size_t value_len)
     _rawRenditions.emplace_back(kv);
 }
 
+void Writer::
+addRendition(AttributeList const &attributes, std::vector<uint8_t> &&value)
+{
+    _encodedRenditions.push_back({ attributes, std::move(value) });
+}
+
 static std::vector<enum car_attribute_identifier>
 DetermineKeyFormat(
     std::unordered_map<std::string, Facet> const &facets,
-    std::unordered_multimap<uint16_t, Rendition> const &renditions)
+    std::unordered_multimap<uint16_t, Rendition> const &renditions,
+    std::vector<std::pair<AttributeList, std::vector<uint8_t>>> const &encodedRenditions)
 {
-    std::unordered_set<enum car_attribute_identifier> format;
-    auto insert = [&format](enum car_attribute_identifier identifier, uint16_t value) {
-        format.insert(identifier);
-    };
+    uint32_t mask = 0;
 
     for (auto const &item : facets) {
-        item.second.attributes().iterate(insert);
+        mask |= item.second.attributes().mask();
     }
 
     for (auto const &item : renditions) {
-        item.second.attributes().iterate(insert);
+        mask |= item.second.attributes().mask();
+    }
+
+    for (auto const &item : encodedRenditions) {
+        mask |= item.first.mask();
+    }
+
+    /* Identifiers are in ascending order, to preserve ordering. */
+    std::vector<enum car_attribute_identifier> format;
+    for (; mask != 0; mask &= mask - 1) {
+        format.push_back(static_cast<enum car_attribute_identifier>(__builtin_ctz(mask)));
     }
+    return format;
+}
 
-    /* Sort attributes to preserve ordering. */
-    auto ordered = std::set<enum car_attribute_identifier>(format.begin(), format.end());
-    return std::vector<enum car_attribute_identifier>(ordered.begin(), ordered.end());
+static uint64_t
+HashValue(void const *value, size_t length)
+{
+    /* FNV-1a. */
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint8_t const *bytes = static_cast<uint8_t const *>(value);
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/*
+ * Points items with identical values at the first of them, so that the
+ * value is only stored once and shared by each key. The same image is
+ * often used for several idioms.
+ */
+static void
+ShareIdenticalValues(std::vector<struct bom_tree_item> *items)
+{
+    std::vector<uint64_t> hashes = std::vector<uint64_t>(items->size());
+    libutil::Parallel::For(items->size(), [&](size_t index) {
+        hashes[index] = HashValue((*items)[index].value, (*items)[index].value_len);
+    });
+
+    std::unordered_multimap<uint64_t, size_t> seen;
+    seen.reserve(items->size());
+    for (size_t i = 0; i < items->size(); ++i) {
+        struct bom_tree_item *item = &(*items)[i];
+
+        bool found = false;
+        auto range = seen.equal_range(hashes[i]);
+        for (auto it = range.first; it != range.second; ++it) {
+            struct bom_tree_item const *other = &(*items)[it->second];
+            if (other->value_len == item->value_len && memcmp(other->value, item->value, item->value_len) == 0) {
+                item->value = other->value;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            seen.insert({ hashes[i], i });
+        }
+    }
 }
 
 void Writer::
@@ -87,7 +157,7 @@ write() const
      * Each tree entry (facet or rendition) requires 2: one key index, one value index.
      */
     uint32_t facet_count = _facets.size();
-    uint32_t rendition_count = _renditions.size() + _rawRenditions.size();
+    uint32_t rendition_count = _renditions.size() + _rawRenditions.size() + _encodedRenditions.size();
     uint32_t bom_index_count = 6 + facet_count * 2 + rendition_count * 2;
     bom_index_reserve(_bom.get(), bom_index_count);
 
@@ -124,7 +194,7 @@ write() const
     struct car_key_format *keyfmt;
     size_t keyfmt_size;
     if (_keyfmt == ext::nullopt) {
-      std::vector<enum car_attribute_identifier> format = DetermineKeyFormat(_facets, _renditions);
+      std::vector<enum car_attribute_identifier> format = DetermineKeyFormat(_facets, _renditions, _encodedRenditions);
       keyfmt_size = sizeof(struct car_key_format) + (format.size() * sizeof(uint32_t));
       keyfmt = (struct car_key_format *)malloc(keyfmt_size);
       strncpy(keyfmt->magic, "tmfk", 4);
@@ -141,44 +211,86 @@ write() const
     int key_format_index = bom_index_add(_bom.get(), keyfmt, keyfmt_size);
     bom_variable_add(_bom.get(), car_key_format_variable, key_format_index);
 
-    /* Write facets. */
+    /*
+     * Write facets. Trees are built all at once from sorted keys, rather
+     * than by adding entries one at a time.
+     */
     struct bom_tree_context *facets_tree_context = bom_tree_alloc_empty(_bom.get(), car_facet_keys_variable);
-    bom_tree_reserve(facets_tree_context, facet_count);
     if (facets_tree_context != NULL) {
+        std::vector<std::vector<uint8_t>> facet_values;
+        facet_values.reserve(_facets.size());
+        std::vector<struct bom_tree_item> items;
+        items.reserve(_facets.size());
+
         for (auto const &item : _facets) {
-            auto facet_value = item.second.write();
-            bom_tree_add(
-                facets_tree_context,
+            facet_values.push_back(item.second.write());
+            items.push_back({
                 reinterpret_cast<void const *>(item.first.c_str()),
                 item.first.size(),
-                reinterpret_cast<void const *>(facet_value.data()),
-                facet_value.size());
+                reinterpret_cast<void const *>(facet_values.back().data()),
+                facet_values.back().size(),
+            });
         }
+
+        bom_tree_add_sorted(facets_tree_context, items.data(), items.size());
         bom_tree_free(facets_tree_context);
     }
 
     /* Write renditions. */
     struct bom_tree_context *renditions_tree_context = bom_tree_alloc_empty(_bom.get(), car_renditions_variable);
-    bom_tree_reserve(renditions_tree_context, rendition_count);
     if (renditions_tree_context != NULL) {
+        /*
+         * Encoding and compressing each rendition is independent, so do that
+         * in parallel. Only adding them to the tree has to be in order.
+         */
+        std::vector<Rendition const *> renditions;
+        renditions.reserve(_renditions.size());
         for (auto const &item : _renditions) {
-            auto attributes_value = item.second.attributes().write(keyfmt->num_identifiers, keyfmt->identifier_list);
-            auto rendition_value = item.second.write();
-            bom_tree_add(
-                renditions_tree_context,
-                reinterpret_cast<void const *>(attributes_value.data()),
-                attributes_value.size(),
-                reinterpret_cast<void const *>(rendition_value.data()),
-                rendition_value.size());
+            renditions.push_back(&item.second);
+        }
+
+        std::vector<std::vector<uint8_t>> attributes_values = std::vector<std::vector<uint8_t>>(renditions.size());
+        std::vector<std::vector<uint8_t>> rendition_values = std::vector<std::vector<uint8_t>>(renditions.size());
+        libutil::Parallel::For(renditions.size(), [&](size_t index) {
+            attributes_values[index] = renditions[index]->attributes().write(keyfmt->num_identifiers, keyfmt->identifier_list);
+            rendition_values[index] = renditions[index]->write();
+        });
+
+        std::vector<std::vector<uint8_t>> encoded_attributes_values;
+        encoded_attributes_values.reserve(_encodedRenditions.size());
+        for (auto const &item : _encodedRenditions) {
+            encoded_attributes_values.push_back(item.first.write(keyfmt->num_identifiers, keyfmt->identifier_list));
+        }
+
+        std::vector<struct bom_tree_item> items;
+        items.reserve(rendition_count);
+        for (size_t i = 0; i < renditions.size(); ++i) {
+            items.push_back({
+                reinterpret_cast<void const *>(attributes_values[i].data()),
+                attributes_values[i].size(),
+                reinterpret_cast<void const *>(rendition_values[i].data()),
+                rendition_values[i].size(),
+            });
+        }
+        for (size_t i = 0; i < _encodedRenditions.size(); ++i) {
+            items.push_back({
+                reinterpret_cast<void const *>(encoded_attributes_values[i].data()),
+                encoded_attributes_values[i].size(),
+                reinterpret_cast<void const *>(_encodedRenditions[i].second.data()),
+                _encodedRenditions[i].second.size(),
+            });
         }
         for (auto const &item : _rawRenditions) {
-            bom_tree_add(
-                renditions_tree_context,
+            items.push_back({
                 item.key,
                 item.keyLength,
                 item.value,
-                item.valueLength);
+                item.valueLength,
+            });
         }
+
+        ShareIdenticalValues(&items);
+        bom_tree_add_sorted(renditions_tree_context, items.data(), items.size());
         bom_tree_free(renditions_tree_context);
     }
 
@@ -75,3 +75,29 @@ TEST(AttributeList, DeserializeAndSerialize)
     EXPECT_TRUE(0 == memcmp(rendition_key, attributes_out, sizeof(uint16_t) * KeyFormatCount));
 }
 
+
+TEST(AttributeList, SetAndIterate)
+{
+    car::AttributeList attributes = car::AttributeList({
+        { car_attribute_identifier_scale, 2 },
+        { car_attribute_identifier_element, 85 },
+    });
+    attributes.set(car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_phone);
+    attributes.set(car_attribute_identifier_scale, 3);
+
+    EXPECT_EQ(3, attributes.count());
+    EXPECT_FALSE(attributes.get(car_attribute_identifier_part));
+    EXPECT_EQ((1u << car_attribute_identifier_element) | (1u << car_attribute_identifier_scale) | (1u << car_attribute_identifier_idiom), attributes.mask());
+
+    /* Attributes are iterated in identifier order. */
+    std::vector<std::pair<enum car_attribute_identifier, uint16_t>> values;
+    attributes.iterate([&](enum car_attribute_identifier identifier, uint16_t value) {
+        values.push_back({ identifier, value });
+    });
+    std::vector<std::pair<enum car_attribute_identifier, uint16_t>> expected = {
+        { car_attribute_identifier_element, 85 },
+        { car_attribute_identifier_scale, 3 },
+        { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_phone },
+    };
+    EXPECT_EQ(expected, values);
+}
@@ -204,6 +204,36 @@ TEST(Rendition, SerializeJPEG)
     EXPECT_EQ(deserialized_data->data(), jpeg);
 }
 
+TEST(Rendition, SerializeMoved)
+{
+    auto format = car::Rendition::Data::Format::JPEG;
+    auto jpeg = std::vector<uint8_t>(10000);
+    for (size_t i = 0; i < jpeg.size(); i++) {
+        jpeg[i] = i & 0xFF;
+    }
+
+    /* Moving the data in should not copy the buffer. */
+    std::vector<uint8_t> expected = jpeg;
+    uint8_t const *buffer = jpeg.data();
+    auto data = car::Rendition::Data(std::move(jpeg), format);
+    EXPECT_EQ(buffer, data.data().data());
+
+    car::Rendition rendition = car::Rendition::Create(EmptyAttributeList(), std::move(data));
+    rendition.width() = 100;
+    rendition.height() = 100;
+    rendition.scale() = 1.0;
+    rendition.fileName() = "test.png";
+    rendition.layout() = car_rendition_value_layout_one_part_scale;
+
+    /* Serialize and deserialize rendition. */
+    std::vector<uint8_t> rendition_value = rendition.write();
+    car::Rendition deserialized_rendition = car::Rendition::Load(EmptyAttributeList(), reinterpret_cast<struct car_rendition_value *>(rendition_value.data()));
+
+    auto deserialized_data = deserialized_rendition.data();
+    EXPECT_EQ(deserialized_data->format(), format);
+    EXPECT_EQ(deserialized_data->data(), expected);
+}
+
 TEST(Rendition, SerializeSlices)
 {
     size_t width = 100;
@@ -246,3 +276,41 @@ TEST(Rendition, SerializeSlices)
     }
 }
 
+
+TEST(Rendition, SerializeChunked)
+{
+    /* Large enough to be split into several chunks. */
+    size_t width = 1000;
+    size_t height = 700;
+
+    auto format = car::Rendition::Data::Format::PremultipliedBGRA8;
+    auto bitmap = std::vector<uint8_t>(width * height * 4);
+    for (size_t i = 0; i < bitmap.size(); i++) {
+        bitmap[i] = (i * 7 + i / 4096) & 0xFF;
+    }
+
+    for (Rendition::Compression compression : { Rendition::Compression::Zlib, Rendition::Compression::ZlibFast, Rendition::Compression::LZVN, Rendition::Compression::LZFSE }) {
+        if (!Rendition::CompressionSupported(compression)) {
+            continue;
+        }
+
+        /* Construct a rendition. */
+        auto data = car::Rendition::Data(bitmap, format);
+        car::Rendition rendition = car::Rendition::Create(EmptyAttributeList(), data);
+        rendition.width() = width;
+        rendition.height() = height;
+        rendition.scale() = 1.0;
+        rendition.fileName() = "test.png";
+        rendition.layout() = car_rendition_value_layout_one_part_scale;
+        rendition.compression() = compression;
+
+        /* Serialize and deserialize rendition. */
+        std::vector<uint8_t> rendition_value = rendition.write();
+        car::Rendition deserialized_rendition = car::Rendition::Load(EmptyAttributeList(), reinterpret_cast<struct car_rendition_value *>(rendition_value.data()));
+
+        /* Verify every chunk was decoded in place. */
+        auto deserialized_data = deserialized_rendition.data();
+        ASSERT_NE(deserialized_data, ext::nullopt);
+        EXPECT_EQ(deserialized_data->data(), bitmap);
+    }
+}
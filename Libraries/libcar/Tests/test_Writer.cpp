@@ -19,6 +19,7 @@
 #include <car/Reader.h>
 
 #include <cstdio>
+#include <set>
 #include <string>
 
 #include <vector>
@@ -254,3 +255,164 @@ TEST(Writer, TestWriter100Optimal)
     EXPECT_EQ(rendition_count, create_rendition_count);
 }
 
+
+TEST(Writer, TestWriterMultipleLeaves)
+{
+    int width = 8;
+    int height = 8;
+    /* Enough that neither tree fits in a single leaf. */
+    int create_facet_count = 1000;
+    int create_scales_count = 3;
+    int create_rendition_count = create_facet_count * create_scales_count;
+
+    /* Write out. */
+    auto writer_bom = car::Writer::unique_ptr_bom(bom_alloc_empty(bom_context_memory(NULL, 0)), bom_free);
+    EXPECT_NE(writer_bom, nullptr);
+
+    auto writer = car::Writer::Create(std::move(writer_bom));
+    EXPECT_NE(writer, ext::nullopt);
+
+    for (int facet_identifier = 1; facet_identifier <= create_facet_count; facet_identifier++) {
+      car::AttributeList attributes = car::AttributeList({
+          { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_universal },
+          { car_attribute_identifier_scale, 2 },
+          { car_attribute_identifier_identifier, facet_identifier },
+      });
+
+      car::Facet facet = car::Facet::Create("testpattern_" + std::to_string(facet_identifier), attributes);
+      writer->addFacet(facet);
+
+      for (int scale = 1; scale <= create_scales_count; scale++) {
+        car::AttributeList rendition_attributes = car::AttributeList({
+            { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_universal },
+            { car_attribute_identifier_scale, scale },
+            { car_attribute_identifier_identifier, facet_identifier },
+        });
+
+        auto data = car::Rendition::Data(test_pixels, car::Rendition::Data::Format::PremultipliedBGRA8);
+        car::Rendition rendition = car::Rendition::Create(rendition_attributes, data);
+        rendition.width() = width;
+        rendition.height() = height;
+        rendition.scale() = scale;
+        rendition.fileName() = "testpattern_" + std::to_string(facet_identifier) + "@" + std::to_string(scale) + "x.png";
+        rendition.layout() = car_rendition_value_layout_one_part_scale;
+        writer->addRendition(rendition);
+      }
+    }
+
+    writer->write();
+
+    /* Read back. */
+    struct bom_context_memory const *writer_memory = bom_memory(writer->bom());
+    struct bom_context_memory reader_memory = bom_context_memory(writer_memory->data, writer_memory->size);
+    auto reader_bom = std::unique_ptr<struct bom_context, decltype(&bom_free)>(bom_alloc_load(reader_memory), bom_free);
+    EXPECT_NE(reader_bom, nullptr);
+
+    ext::optional<car::Reader> reader = car::Reader::Load(std::move(reader_bom));
+    EXPECT_NE(reader, ext::nullopt);
+
+    int facet_count = 0;
+    int rendition_count = 0;
+
+    reader->facetIterate([&reader, &facet_count, &rendition_count](car::Facet const &facet) {
+        facet_count++;
+
+        ext::optional<uint16_t> facet_identifier = facet.attributes().get(car_attribute_identifier_identifier);
+        EXPECT_FALSE(facet_identifier == ext::nullopt);
+        EXPECT_EQ(facet.name(), "testpattern_" + std::to_string(*facet_identifier));
+
+        auto renditions = reader->lookupRenditions(facet);
+        for (auto const &rendition : renditions) {
+            rendition_count++;
+
+            auto data = rendition.data()->data();
+            EXPECT_EQ(data, test_pixels);
+        }
+    });
+
+    EXPECT_EQ(facet_count, create_facet_count);
+    EXPECT_EQ(rendition_count, create_rendition_count);
+}
+
+TEST(Writer, TestWriterSharesIdenticalRenditions)
+{
+    auto writer_bom = car::Writer::unique_ptr_bom(bom_alloc_empty(bom_context_memory(NULL, 0)), bom_free);
+    auto writer = car::Writer::Create(std::move(writer_bom));
+    EXPECT_NE(writer, ext::nullopt);
+
+    car::Facet facet = car::Facet::Create("shared", car::AttributeList({
+        { car_attribute_identifier_identifier, 1 },
+    }));
+    writer->addFacet(facet);
+
+    /* The same image for two idioms, and a different one for a third. */
+    std::vector<uint16_t> idioms = {
+        car_attribute_identifier_idiom_value_phone,
+        car_attribute_identifier_idiom_value_pad,
+        car_attribute_identifier_idiom_value_tv,
+    };
+    for (uint16_t idiom : idioms) {
+        std::vector<uint8_t> pixels = test_pixels;
+        if (idiom == car_attribute_identifier_idiom_value_tv) {
+            pixels[0] ^= 0xFF;
+        }
+
+        car::AttributeList attributes = car::AttributeList({
+            { car_attribute_identifier_idiom, idiom },
+            { car_attribute_identifier_scale, 1 },
+            { car_attribute_identifier_identifier, 1 },
+        });
+        car::Rendition rendition = car::Rendition::Create(attributes, car::Rendition::Data(pixels, car::Rendition::Data::Format::PremultipliedBGRA8));
+        rendition.width() = 8;
+        rendition.height() = 8;
+        rendition.fileName() = "shared.png";
+        rendition.layout() = car_rendition_value_layout_one_part_scale;
+        writer->addRendition(rendition);
+    }
+
+    writer->write();
+
+    struct bom_context_memory const *writer_memory = bom_memory(writer->bom());
+    struct bom_context_memory reader_memory = bom_context_memory(writer_memory->data, writer_memory->size);
+    auto reader_bom = std::unique_ptr<struct bom_context, decltype(&bom_free)>(bom_alloc_load(reader_memory), bom_free);
+    ext::optional<car::Reader> reader = car::Reader::Load(std::move(reader_bom));
+    EXPECT_NE(reader, ext::nullopt);
+
+    /* Three keys, but only two stored values. */
+    std::set<void *> values;
+    reader->renditionFastIterate([&values](void *key, size_t key_len, void *value, size_t value_len) {
+        values.insert(value);
+    });
+    EXPECT_EQ(2, values.size());
+
+    int rendition_count = 0;
+    for (car::Rendition const &rendition : reader->lookupRenditions(facet)) {
+        rendition_count++;
+
+        std::vector<uint8_t> pixels = test_pixels;
+        if (rendition.attributes().get(car_attribute_identifier_idiom) == static_cast<uint16_t>(car_attribute_identifier_idiom_value_tv)) {
+            pixels[0] ^= 0xFF;
+        }
+        EXPECT_EQ(pixels, rendition.data()->data());
+    }
+    EXPECT_EQ(3, rendition_count);
+
+    /* Renditions can be looked up by their attributes. */
+    std::vector<car::Rendition> pad = reader->lookupRenditions(facet, car::AttributeList({
+        { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_pad },
+        { car_attribute_identifier_scale, 1 },
+    }));
+    ASSERT_EQ(1, pad.size());
+    EXPECT_EQ(car_attribute_identifier_idiom_value_pad, *pad[0].attributes().get(car_attribute_identifier_idiom));
+
+    std::vector<car::Rendition> tv = reader->lookupRenditions(facet, car::AttributeList({
+        { car_attribute_identifier_idiom, car_attribute_identifier_idiom_value_tv },
+    }));
+    ASSERT_EQ(1, tv.size());
+    EXPECT_EQ(car_attribute_identifier_idiom_value_tv, *tv[0].attributes().get(car_attribute_identifier_idiom));
+
+    std::vector<car::Rendition> scale = reader->lookupRenditions(facet, car::AttributeList({
+        { car_attribute_identifier_scale, 2 },
+    }));
+    EXPECT_TRUE(scale.empty());
+}
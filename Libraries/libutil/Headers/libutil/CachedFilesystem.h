@@ -0,0 +1,98 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_CachedFilesystem_h
+#define __libutil_CachedFilesystem_h
+
+#include <libutil/Filesystem.h>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace libutil {
+
+/*
+ * Remembers path metadata from another filesystem, so repeated tests of
+ * the same path only look it up once. Changes made through this filesystem
+ * forget what they affect, but changes made any other way are not seen;
+ * only use it while nothing else is changing the files it looks at.
+ */
+class CachedFilesystem : public Filesystem {
+private:
+    Filesystem *_filesystem;
+
+private:
+    mutable std::mutex _mutex;
+    mutable std::unordered_map<std::string, ext::optional<Metadata>> _metadata;
+
+public:
+    explicit CachedFilesystem(Filesystem *filesystem);
+
+public:
+    /*
+     * Forget everything looked up so far.
+     */
+    void invalidate();
+
+private:
+    void invalidate(std::string const &path);
+
+public:
+    virtual bool exists(std::string const &path) const;
+
+public:
+    virtual bool isDirectory(std::string const &path) const;
+    virtual bool isSymbolicLink(std::string const &path) const;
+
+public:
+    virtual bool isReadable(std::string const &path) const;
+    virtual bool isWritable(std::string const &path) const;
+    virtual bool isExecutable(std::string const &path) const;
+
+public:
+    virtual ext::optional<uint64_t> modificationTime(std::string const &path) const;
+    virtual ext::optional<Metadata> metadata(std::string const &path) const;
+
+public:
+    virtual bool createFile(std::string const &path);
+    virtual bool createDirectory(std::string const &path);
+    virtual bool touch(std::string const &path);
+
+public:
+    virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const;
+    virtual std::unique_ptr<Mapping> readMapped(std::string const &path) const;
+    virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual bool writeAtomic(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual std::vector<bool> readBatch(std::vector<std::vector<uint8_t>> *contents, std::vector<std::string> const &paths) const;
+    virtual std::vector<bool> writeAtomicBatch(std::vector<std::vector<uint8_t>> const &contents, std::vector<std::string> const &paths);
+    virtual ext::optional<std::string> readSymbolicLink(std::string const &path) const;
+    virtual bool writeSymbolicLink(std::string const &target, std::string const &path);
+
+public:
+    virtual bool removeFile(std::string const &path);
+
+public:
+    virtual bool copyFile(std::string const &from, std::string const &to);
+    virtual bool cloneFile(std::string const &from, std::string const &to);
+
+public:
+    virtual std::string resolvePath(std::string const &path) const;
+
+public:
+    virtual bool enumerateDirectory(
+        std::string const &path,
+        std::function<void(std::string const &)> const &cb) const;
+    virtual bool enumerateDirectoryEntries(
+        std::string const &path,
+        std::function<void(std::string const &, bool)> const &cb) const;
+};
+
+}
+
+#endif  // !__libutil_CachedFilesystem_h
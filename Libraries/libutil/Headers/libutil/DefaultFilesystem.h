@@ -27,19 +27,32 @@ public:
     virtual bool isWritable(std::string const &path) const;
     virtual bool isExecutable(std::string const &path) const;
 
+public:
+    virtual ext::optional<uint64_t> modificationTime(std::string const &path) const;
+    virtual ext::optional<Metadata> metadata(std::string const &path) const;
+
 public:
     virtual bool createFile(std::string const &path);
     virtual bool createDirectory(std::string const &path);
+    virtual bool touch(std::string const &path);
 
 public:
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const;
+    virtual std::unique_ptr<Mapping> readMapped(std::string const &path) const;
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual bool writeAtomic(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual std::vector<bool> readBatch(std::vector<std::vector<uint8_t>> *contents, std::vector<std::string> const &paths) const;
+    virtual std::vector<bool> writeAtomicBatch(std::vector<std::vector<uint8_t>> const &contents, std::vector<std::string> const &paths);
     virtual ext::optional<std::string> readSymbolicLink(std::string const &path) const;
     virtual bool writeSymbolicLink(std::string const &target, std::string const &path);
 
 public:
     virtual bool removeFile(std::string const &path);
 
+public:
+    virtual bool copyFile(std::string const &from, std::string const &to);
+    virtual bool cloneFile(std::string const &from, std::string const &to);
+
 public:
     virtual std::string resolvePath(std::string const &path) const;
 
@@ -47,6 +60,9 @@ public:
     virtual bool enumerateDirectory(
         std::string const &path,
         std::function<void(std::string const &)> const &cb) const;
+    virtual bool enumerateDirectoryEntries(
+        std::string const &path,
+        std::function<void(std::string const &, bool)> const &cb) const;
 };
 
 }
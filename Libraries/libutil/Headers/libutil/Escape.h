@@ -26,11 +26,23 @@ public:
     static std::string
     Shell(std::string const &value);
 
+    /*
+     * Shell-escapes a string, appending it to another.
+     */
+    static void
+    Shell(std::string const &value, std::string *result);
+
     /*
      * Escape a file path for a Makefile.
      */
     static std::string
     Makefile(std::string const &value);
+
+    /*
+     * Escape a file path for a Makefile, appending it to another string.
+     */
+    static void
+    Makefile(std::string const &value, std::string *result);
 };
 
 }
@@ -11,6 +11,7 @@
 #define __libutil_Filesystem_h
 
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <ext/optional>
@@ -18,6 +19,50 @@
 namespace libutil {
 
 class Filesystem {
+public:
+    /*
+     * Everything a single lookup finds out about a path. Symbolic links
+     * are followed, except to say whether the path itself is one.
+     */
+    struct Metadata {
+        bool     directory;
+        bool     symbolicLink;
+        bool     readable;
+        bool     writable;
+        bool     executable;
+        uint64_t size;
+        uint64_t modificationTime;
+        uint64_t inode;
+    };
+
+    /*
+     * Read-only contents of a file, valid until destroyed. The contents
+     * may be mapped from the file rather than copied, so they must not
+     * be used after the file is modified.
+     */
+    class Mapping {
+    private:
+        uint8_t const         *_data;
+        size_t                 _size;
+        std::function<void()>  _release;
+        std::vector<uint8_t>   _contents;
+
+    public:
+        Mapping(uint8_t const *data, size_t size, std::function<void()> const &release);
+        explicit Mapping(std::vector<uint8_t> &&contents);
+        ~Mapping();
+
+    private:
+        Mapping(Mapping const &) = delete;
+        Mapping &operator=(Mapping const &) = delete;
+
+    public:
+        uint8_t const *data() const
+        { return _data; }
+        size_t size() const
+        { return _size; }
+    };
+
 public:
     /*
      * Test if a file exists.
@@ -51,6 +96,18 @@ public:
      */
     virtual bool isExecutable(std::string const &path) const = 0;
 
+public:
+    /*
+     * When a path was last modified, in nanoseconds since the epoch.
+     */
+    virtual ext::optional<uint64_t> modificationTime(std::string const &path) const = 0;
+
+    /*
+     * Look up everything about a path at once, or nothing if it doesn't
+     * exist. Prefer this to several of the tests above.
+     */
+    virtual ext::optional<Metadata> metadata(std::string const &path) const = 0;
+
 public:
     /*
      * Create a file. Succeeds if created or already exists.
@@ -62,17 +119,61 @@ public:
      */
     virtual bool createDirectory(std::string const &path) = 0;
 
+    /*
+     * Set the modification time of an existing path to now.
+     */
+    virtual bool touch(std::string const &path) = 0;
+
 public:
     /*
      * Read from a file.
      */
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const = 0;
 
+    /*
+     * Read a whole file without copying it where possible. By default,
+     * reads the file into memory. Returns null if it can't be read.
+     */
+    virtual std::unique_ptr<Mapping> readMapped(std::string const &path) const;
+
     /*
      * Write to a file.
      */
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path) = 0;
 
+    /*
+     * Write to a file such that readers see either the old or the new
+     * contents, never a partial write. By default, writes in place.
+     */
+    virtual bool writeAtomic(std::vector<uint8_t> const &contents, std::string const &path);
+
+    /*
+     * Write to a file atomically, unless it already has these contents.
+     * An unchanged file keeps its modification time, so nothing using it
+     * goes out of date.
+     */
+    bool writeIfChanged(std::vector<uint8_t> const &contents, std::string const &path);
+
+    /*
+     * Read many whole files, returning if each was read. By default, reads
+     * them in turn; filesystems can override this to read them all at once.
+     */
+    virtual std::vector<bool> readBatch(std::vector<std::vector<uint8_t>> *contents, std::vector<std::string> const &paths) const;
+
+    /*
+     * Write many files atomically, returning if each was written. By
+     * default, writes them in turn; filesystems can override this to write
+     * them all at once.
+     */
+    virtual std::vector<bool> writeAtomicBatch(std::vector<std::vector<uint8_t>> const &contents, std::vector<std::string> const &paths);
+
+    /*
+     * Write many files as with `writeIfChanged`, returning if each is now
+     * up to date. Files that could be unchanged are read in one batch, and
+     * changed files are written in another.
+     */
+    std::vector<bool> writeIfChangedBatch(std::vector<std::vector<uint8_t>> const &contents, std::vector<std::string> const &paths);
+
     /*
      * Read the destination of the symbolic link, relative to its containing directory.
      */
@@ -104,11 +205,45 @@ public:
         std::function<void(std::string const &)> const &cb) const = 0;
 
     /*
-     * Enumerate the contents of a directory recursively.
+     * Enumerate contents of a directory, with whether each is a directory.
+     * Symbolic links are not followed. By default, looks up each entry;
+     * filesystems can override this to use the type from the listing.
+     */
+    virtual bool enumerateDirectoryEntries(
+        std::string const &path,
+        std::function<void(std::string const &, bool)> const &cb) const;
+
+    /*
+     * Enumerate the contents of a directory recursively, with whether each
+     * is a directory. Each directory's entries come before the contents
+     * of its subdirectories. Directories are listed in parallel, but the
+     * callback is called in order on this thread. The path passed to the
+     * callback is only valid during the call. Stops if it returns false.
      */
     bool enumerateRecursive(
         std::string const &path,
-        std::function<bool(std::string const &)> const &cb) const;
+        std::function<bool(std::string const &, bool)> const &cb) const;
+
+public:
+    /*
+     * Copies a file's contents and permissions, leaving the copy writable.
+     * By default, reads and writes the whole file; filesystems can override
+     * this to copy more efficiently.
+     */
+    virtual bool copyFile(std::string const &from, std::string const &to);
+
+    /*
+     * Makes a copy-on-write clone of a file, sharing its storage until
+     * either is modified. Fails if the filesystem can't clone; by default,
+     * nothing can be cloned. Copying a file tries this first.
+     */
+    virtual bool cloneFile(std::string const &from, std::string const &to);
+
+    /*
+     * Copies a file, symbolic link, or directory and everything in it.
+     * Symbolic links are copied, not followed. Existing files are replaced.
+     */
+    bool copyRecursive(std::string const &from, std::string const &to);
 
 public:
     /*
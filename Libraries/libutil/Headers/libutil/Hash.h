@@ -0,0 +1,74 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_Hash_h
+#define __libutil_Hash_h
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <ext/optional>
+
+namespace libutil {
+
+class Filesystem;
+
+/*
+ * Fast non-cryptographic 64-bit hash (XXH64) for cache keys and content
+ * fingerprints. Input can be added in any number of pieces; the digest only
+ * depends on the bytes added, not on how they were split.
+ */
+class Hash {
+private:
+    uint64_t _accumulators[4];
+    uint64_t _seed;
+    uint64_t _length;
+    uint8_t  _buffer[32];
+    size_t   _buffered;
+
+public:
+    explicit Hash(uint64_t seed = 0);
+
+public:
+    /*
+     * Adds bytes to the hash.
+     */
+    void update(void const *data, size_t size);
+    void update(std::string const &value)
+    { update(value.data(), value.size()); }
+
+public:
+    /*
+     * The hash of everything added so far. More can be added afterwards.
+     */
+    uint64_t digest() const;
+
+    /*
+     * The digest as sixteen lowercase hex digits.
+     */
+    std::string hex() const;
+
+public:
+    /*
+     * Hashes a string in one step.
+     */
+    static uint64_t
+    String(std::string const &value, uint64_t seed = 0);
+
+    /*
+     * Hashes the contents of a file, mapped rather than copied where the
+     * filesystem supports it. Returns nothing if the file can't be read.
+     */
+    static ext::optional<uint64_t>
+    File(Filesystem const *filesystem, std::string const &path, uint64_t seed = 0);
+};
+
+}
+
+#endif  // !__libutil_Hash_h
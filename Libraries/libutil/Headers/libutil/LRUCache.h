@@ -0,0 +1,102 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_LRUCache_h
+#define __libutil_LRUCache_h
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace libutil {
+
+/*
+ * Values by key, most recently used first. With a capacity, the least
+ * recently used values are dropped once there are more than that. Not
+ * safe to use from multiple threads.
+ */
+template<typename Key, typename Value, typename KeyHash = std::hash<Key>>
+class LRUCache {
+private:
+    typedef std::list<std::pair<Key, Value>> List;
+
+private:
+    size_t                                                    _capacity;
+    List                                                      _entries;
+    std::unordered_map<Key, typename List::iterator, KeyHash> _index;
+    size_t                                                    _evictions;
+
+public:
+    /*
+     * A cache keeping at most `capacity` values. Zero keeps all of them.
+     */
+    explicit LRUCache(size_t capacity) :
+        _capacity (capacity),
+        _evictions(0)
+    {
+    }
+
+public:
+    /*
+     * The value for a key, or null if there is none. Marks it as used.
+     */
+    Value const *find(Key const &key)
+    {
+        auto it = _index.find(key);
+        if (it == _index.end()) {
+            return nullptr;
+        }
+
+        _entries.splice(_entries.begin(), _entries, it->second);
+        return &it->second->second;
+    }
+
+    /*
+     * Cache a value, unless one was added for the key first, and mark it
+     * as used. Returns the cached value.
+     */
+    Value const &insert(Key const &key, Value const &value)
+    {
+        auto it = _index.find(key);
+        if (it != _index.end()) {
+            _entries.splice(_entries.begin(), _entries, it->second);
+            return it->second->second;
+        }
+
+        _entries.push_front(std::make_pair(key, value));
+        _index.insert({ key, _entries.begin() });
+
+        while (_capacity != 0 && _entries.size() > _capacity) {
+            _index.erase(_entries.back().first);
+            _entries.pop_back();
+            _evictions++;
+        }
+
+        return _entries.front().second;
+    }
+
+public:
+    /*
+     * How many values are cached.
+     */
+    size_t size() const
+    { return _entries.size(); }
+
+    /*
+     * How many values were dropped to stay within the capacity.
+     */
+    size_t evictions() const
+    { return _evictions; }
+};
+
+}
+
+#endif  // !__libutil_LRUCache_h
@@ -12,6 +12,9 @@
 
 #include <libutil/Filesystem.h>
 
+#include <memory>
+#include <unordered_map>
+
 namespace libutil {
 
 class MemoryFilesystem : public Filesystem {
@@ -23,50 +26,82 @@ public:
             Directory,
         };
 
-    public:
-        std::string          _name;
+    private:
+        std::string                                  _name;
 
-    public:
-        Type                 _type;
-        std::vector<uint8_t> _contents;
-        std::vector<Entry>   _children;
+    private:
+        Type                                         _type;
+        std::shared_ptr<std::vector<uint8_t> const>  _contents;
+        std::vector<Entry>                           _children;
+        std::unordered_map<std::string, size_t>      _childIndexes;
+        uint64_t                                     _modificationTime;
 
     private:
         Entry(std::string const &name, Type type);
 
     public:
-        std::string &name()
-        { return _name; }
         std::string const &name() const
         { return _name; }
 
     public:
         Type type() const
         { return _type; }
-        std::vector<uint8_t> &contents()
-        { return _contents; }
         std::vector<uint8_t> const &contents() const
-        { return _contents; }
-        std::vector<Entry> &children()
-        { return _children; }
+        { return *_contents; }
         std::vector<Entry> const &children() const
         { return _children; }
+        uint64_t &modificationTime()
+        { return _modificationTime; }
+        uint64_t modificationTime() const
+        { return _modificationTime; }
 
     public:
+        /*
+         * The contents are immutable and shared between copies of the
+         * entry; replacing them doesn't change existing copies.
+         */
+        std::shared_ptr<std::vector<uint8_t> const> const &sharedContents() const
+        { return _contents; }
+        void setContents(std::vector<uint8_t> const &contents);
+
+    public:
+        /*
+         * Children are found by name without searching.
+         */
         MemoryFilesystem::Entry *child(std::string const &name);
         MemoryFilesystem::Entry const *child(std::string const &name) const;
 
+        /*
+         * Adds a child, returning it. The entry must not already have a
+         * child with the same name.
+         */
+        MemoryFilesystem::Entry *addChild(Entry &&entry);
+
+        /*
+         * Removes a child by name, if it exists.
+         */
+        void removeChild(std::string const &name);
+
     public:
         static Entry File(std::string const &name, std::vector<uint8_t> const &contents);
         static Entry Directory(std::string const &name, std::vector<Entry> const &children);
     };
 
 private:
-    Entry _root;
+    Entry    _root;
+    uint64_t _time;
 
 public:
     MemoryFilesystem(std::vector<Entry> const &entries);
 
+private:
+    /*
+     * Entries are modified at increasing times, starting after the
+     * entries the filesystem was created with.
+     */
+    uint64_t tick()
+    { return ++_time; }
+
 public:
     Entry &root()
     { return _root; }
@@ -85,12 +120,18 @@ public:
     virtual bool isWritable(std::string const &path) const;
     virtual bool isExecutable(std::string const &path) const;
 
+public:
+    virtual ext::optional<uint64_t> modificationTime(std::string const &path) const;
+    virtual ext::optional<Metadata> metadata(std::string const &path) const;
+
 public:
     virtual bool createFile(std::string const &path);
     virtual bool createDirectory(std::string const &path);
+    virtual bool touch(std::string const &path);
 
 public:
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const;
+    virtual std::unique_ptr<Mapping> readMapped(std::string const &path) const;
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
     virtual ext::optional<std::string> readSymbolicLink(std::string const &path) const;
     virtual bool writeSymbolicLink(std::string const &target, std::string const &path);
@@ -105,6 +146,9 @@ public:
     virtual bool enumerateDirectory(
         std::string const &path,
         std::function<void(std::string const &)> const &cb) const;
+    virtual bool enumerateDirectoryEntries(
+        std::string const &path,
+        std::function<void(std::string const &, bool)> const &cb) const;
 };
 
 }
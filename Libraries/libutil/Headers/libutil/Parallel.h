@@ -0,0 +1,102 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_Parallel_h
+#define __libutil_Parallel_h
+
+#include <functional>
+#include <vector>
+
+#include <cstddef>
+
+namespace libutil {
+
+/*
+ * Runs independent work across a pool of threads shared by the whole
+ * process. Threads waiting on their own work help run any other queued
+ * work, so parallel loops can nest without deadlocking or starting more
+ * threads than the concurrency allows.
+ */
+class Parallel {
+public:
+    /*
+     * Work added one piece at a time, then run together.
+     */
+    class Group {
+    private:
+        std::vector<std::function<void()>> _tasks;
+
+    public:
+        Group();
+        ~Group();
+
+    public:
+        Group(Group const &) = delete;
+        Group &operator=(Group const &) = delete;
+
+    public:
+        /*
+         * Add work to the group. Nothing runs until waited on.
+         */
+        void add(std::function<void()> const &task);
+
+        /*
+         * Run all the work added, returning when it has all finished.
+         */
+        void wait();
+    };
+
+public:
+    /*
+     * How many threads, including the calling thread, run work at once.
+     * Defaults to the number of processors.
+     */
+    static size_t Concurrency();
+
+    /*
+     * Change how many threads run work at once, such as from the number
+     * of jobs requested. At least one, the calling thread, is always used.
+     */
+    static void SetConcurrency(size_t concurrency);
+
+public:
+    /*
+     * Run a function for each index, returning when all have finished.
+     * Indexes can run in any order and on any thread, including this one.
+     */
+    static void For(size_t count, std::function<void(size_t)> const &function);
+
+    /*
+     * Compute a value for each index in parallel, then combine them in
+     * index order starting from an initial value. The result is the same
+     * no matter how the work was spread across threads.
+     */
+    template<typename T>
+    static T Reduce(
+        size_t count,
+        T const &initial,
+        std::function<T(size_t)> const &map,
+        std::function<T(T const &, T const &)> const &combine)
+    {
+        std::vector<T> values = std::vector<T>(count);
+        For(count, [&](size_t index) {
+            values[index] = map(index);
+        });
+
+        T result = initial;
+        for (T const &value : values) {
+            result = combine(result, value);
+        }
+        return result;
+    }
+};
+
+}
+
+#endif // !__libutil_Parallel_h
@@ -0,0 +1,138 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __libutil_Statistic_h
+#define __libutil_Statistic_h
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace libutil {
+
+/*
+ * Counts how often some of the tool's own work is done, and for timed work,
+ * how long it took in total. Statistics are static objects defined next to
+ * the work they measure. Nothing is collected until statistics are enabled,
+ * so they are close to free otherwise. Can be updated from any thread.
+ *
+ * Timed work also records the memory allocated while it ran, and the peak
+ * resident size of the process when it finished. Allocations are only seen
+ * in programs that install the allocation hooks, and are counted from every
+ * thread, so work timed on several threads at once shares its allocations.
+ */
+class Statistic {
+public:
+    /*
+     * Counts the statistic and adds the time and allocations from creation
+     * to destruction.
+     */
+    class Timer {
+    private:
+        Statistic                            *_statistic;
+        std::chrono::steady_clock::time_point _start;
+        uint64_t                              _allocations;
+        uint64_t                              _allocatedBytes;
+
+    public:
+        explicit Timer(Statistic *statistic);
+        ~Timer();
+
+    public:
+        Timer(Timer const &) = delete;
+        Timer &operator=(Timer const &) = delete;
+    };
+
+private:
+    char const            *_group;
+    char const            *_name;
+    Statistic const       *_total;
+    std::atomic<uint64_t>  _count;
+    std::atomic<uint64_t>  _nanoseconds;
+    std::atomic<uint64_t>  _allocations;
+    std::atomic<uint64_t>  _allocatedBytes;
+    std::atomic<uint64_t>  _peakResidentBytes;
+    std::atomic<bool>      _timed;
+
+public:
+    /*
+     * A statistic in a group, usually the library it's in. If a total is
+     * given, the summary also shows this statistic as a share of it, such
+     * as cache hits out of lookups.
+     */
+    Statistic(char const *group, char const *name, Statistic const *total = nullptr);
+    ~Statistic();
+
+public:
+    Statistic(Statistic const &) = delete;
+    Statistic &operator=(Statistic const &) = delete;
+
+public:
+    /*
+     * Count the statistic once.
+     */
+    void increment()
+    {
+        if (Enabled()) {
+            _count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    uint64_t count() const
+    { return _count.load(std::memory_order_relaxed); }
+    uint64_t nanoseconds() const
+    { return _nanoseconds.load(std::memory_order_relaxed); }
+    uint64_t allocations() const
+    { return _allocations.load(std::memory_order_relaxed); }
+    uint64_t allocatedBytes() const
+    { return _allocatedBytes.load(std::memory_order_relaxed); }
+    uint64_t peakResidentBytes() const
+    { return _peakResidentBytes.load(std::memory_order_relaxed); }
+
+public:
+    /*
+     * Start collecting statistics.
+     */
+    static void
+    Enable();
+
+    /*
+     * If statistics are being collected.
+     */
+    static bool
+    Enabled();
+
+public:
+    /*
+     * Count an allocation. Called by the allocation hooks for every
+     * allocation, so this does nothing unless statistics are enabled.
+     */
+    static void
+    Allocated(size_t bytes);
+
+    /*
+     * The largest the process has been resident in memory, in bytes.
+     */
+    static uint64_t
+    PeakResidentBytes();
+
+    /*
+     * A table of every statistic counted so far, by group and name.
+     */
+    static std::string
+    Summary();
+};
+
+}
+
+#endif  // !__libutil_Statistic_h
@@ -11,11 +11,79 @@
 #define __libutil_Wildcard_h
 
 #include <string>
+#include <unordered_map>
+#include <vector>
+#include <ext/optional>
 
 namespace libutil {
 
 struct Wildcard {
     static bool Match(std::string const &pattern, std::string const &string);
+
+    /*
+     * A pattern parsed once to match many strings. Matches exactly what
+     * `Match()` does: a star skips to the first occurrence of the character
+     * after it, rather than trying every position.
+     */
+    class Pattern {
+    public:
+        struct Token {
+            enum class Type {
+                Literal,
+                Set,
+                Star,
+                StarEnd,
+            };
+
+            Type        type;
+            std::string text;
+        };
+
+    private:
+        std::string        _pattern;
+        std::vector<Token> _tokens;
+        bool               _literal;
+
+    public:
+        explicit Pattern(std::string const &pattern);
+
+    public:
+        std::string const &pattern() const
+        { return _pattern; }
+        std::vector<Token> const &tokens() const
+        { return _tokens; }
+
+    public:
+        bool match(std::string const &string) const;
+    };
+
+    /*
+     * Many patterns, matched together to find the first matching one.
+     * Literal patterns and patterns like `*.ext` are found by lookup, so
+     * only the other patterns are tried one at a time.
+     */
+    class PatternSet {
+    private:
+        std::vector<Pattern>                                                 _patterns;
+        std::unordered_map<std::string, size_t>                              _literals;
+        std::unordered_map<char, std::unordered_map<std::string, size_t>>   _suffixes;
+        ext::optional<size_t>                                                _firstStar;
+        std::vector<size_t>                                                  _others;
+
+    public:
+        PatternSet();
+        explicit PatternSet(std::vector<std::string> const &patterns);
+
+    public:
+        bool empty() const
+        { return _patterns.empty(); }
+
+    public:
+        /*
+         * The index of the first pattern matching the string, if any.
+         */
+        ext::optional<size_t> match(std::string const &string) const;
+    };
 };
 
 }
@@ -0,0 +1,93 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/Statistic.h>
+
+#include <new>
+
+#include <cstdlib>
+
+using libutil::Statistic;
+
+/*
+ * Replaces the global allocation functions to count allocations for
+ * statistics. Replacements only take effect when linked into the program
+ * itself, so this is built on its own for programs to include.
+ */
+
+static void *
+Allocate(size_t size)
+{
+    Statistic::Allocated(size);
+
+    /* Zero-sized allocations must still return a unique pointer. */
+    size = (size != 0 ? size : 1);
+
+    void *pointer;
+    while ((pointer = ::malloc(size)) == nullptr) {
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            /* Can't throw std::bad_alloc without exceptions. */
+            std::abort();
+        }
+        handler();
+    }
+
+    return pointer;
+}
+
+void *
+operator new(size_t size)
+{
+    return Allocate(size);
+}
+
+void *
+operator new[](size_t size)
+{
+    return Allocate(size);
+}
+
+void *
+operator new(size_t size, std::nothrow_t const &) noexcept
+{
+    Statistic::Allocated(size);
+    return ::malloc(size != 0 ? size : 1);
+}
+
+void *
+operator new[](size_t size, std::nothrow_t const &) noexcept
+{
+    Statistic::Allocated(size);
+    return ::malloc(size != 0 ? size : 1);
+}
+
+void
+operator delete(void *pointer) noexcept
+{
+    ::free(pointer);
+}
+
+void
+operator delete[](void *pointer) noexcept
+{
+    ::free(pointer);
+}
+
+void
+operator delete(void *pointer, std::nothrow_t const &) noexcept
+{
+    ::free(pointer);
+}
+
+void
+operator delete[](void *pointer, std::nothrow_t const &) noexcept
+{
+    ::free(pointer);
+}
@@ -0,0 +1,255 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/CachedFilesystem.h>
+#include <libutil/FSUtil.h>
+
+using libutil::CachedFilesystem;
+using libutil::FSUtil;
+
+CachedFilesystem::
+CachedFilesystem(Filesystem *filesystem) :
+    _filesystem(filesystem)
+{
+}
+
+void CachedFilesystem::
+invalidate()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _metadata.clear();
+}
+
+void CachedFilesystem::
+invalidate(std::string const &path)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    /*
+     * Creating a path can also create its parent directories. Links that
+     * point at the path aren't known, so forget all of them.
+     */
+    for (std::string current = path; !current.empty(); ) {
+        _metadata.erase(current);
+
+        std::string parent = FSUtil::GetDirectoryName(current);
+        if (parent == current) {
+            break;
+        }
+        current = parent;
+    }
+
+    for (auto it = _metadata.begin(); it != _metadata.end();) {
+        if (it->second && it->second->symbolicLink) {
+            it = _metadata.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+ext::optional<CachedFilesystem::Metadata> CachedFilesystem::
+metadata(std::string const &path) const
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _metadata.find(path);
+        if (it != _metadata.end()) {
+            return it->second;
+        }
+    }
+
+    /* Look up outside the lock; another thread finding the same is fine. */
+    ext::optional<Metadata> metadata = _filesystem->metadata(path);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _metadata.insert({ path, metadata });
+    return metadata;
+}
+
+bool CachedFilesystem::
+exists(std::string const &path) const
+{
+    return static_cast<bool>(this->metadata(path));
+}
+
+bool CachedFilesystem::
+isDirectory(std::string const &path) const
+{
+    ext::optional<Metadata> metadata = this->metadata(path);
+    return (metadata && metadata->directory);
+}
+
+bool CachedFilesystem::
+isSymbolicLink(std::string const &path) const
+{
+    /* Broken links have no metadata, since it follows links. */
+    ext::optional<Metadata> metadata = this->metadata(path);
+    return (metadata ? metadata->symbolicLink : _filesystem->isSymbolicLink(path));
+}
+
+bool CachedFilesystem::
+isReadable(std::string const &path) const
+{
+    ext::optional<Metadata> metadata = this->metadata(path);
+    return (metadata && metadata->readable);
+}
+
+bool CachedFilesystem::
+isWritable(std::string const &path) const
+{
+    ext::optional<Metadata> metadata = this->metadata(path);
+    return (metadata && metadata->writable);
+}
+
+bool CachedFilesystem::
+isExecutable(std::string const &path) const
+{
+    ext::optional<Metadata> metadata = this->metadata(path);
+    return (metadata && metadata->executable);
+}
+
+ext::optional<uint64_t> CachedFilesystem::
+modificationTime(std::string const &path) const
+{
+    ext::optional<Metadata> metadata = this->metadata(path);
+    if (!metadata) {
+        return ext::nullopt;
+    }
+
+    return metadata->modificationTime;
+}
+
+bool CachedFilesystem::
+createFile(std::string const &path)
+{
+    bool result = _filesystem->createFile(path);
+    invalidate(path);
+    return result;
+}
+
+bool CachedFilesystem::
+createDirectory(std::string const &path)
+{
+    bool result = _filesystem->createDirectory(path);
+    invalidate(path);
+    return result;
+}
+
+bool CachedFilesystem::
+touch(std::string const &path)
+{
+    bool result = _filesystem->touch(path);
+    invalidate(path);
+    return result;
+}
+
+bool CachedFilesystem::
+read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext::optional<size_t> length) const
+{
+    return _filesystem->read(contents, path, offset, length);
+}
+
+std::unique_ptr<libutil::Filesystem::Mapping> CachedFilesystem::
+readMapped(std::string const &path) const
+{
+    return _filesystem->readMapped(path);
+}
+
+bool CachedFilesystem::
+write(std::vector<uint8_t> const &contents, std::string const &path)
+{
+    bool result = _filesystem->write(contents, path);
+    invalidate(path);
+    return result;
+}
+
+bool CachedFilesystem::
+writeAtomic(std::vector<uint8_t> const &contents, std::string const &path)
+{
+    bool result = _filesystem->writeAtomic(contents, path);
+    invalidate(path);
+    return result;
+}
+
+std::vector<bool> CachedFilesystem::
+readBatch(std::vector<std::vector<uint8_t>> *contents, std::vector<std::string> const &paths) const
+{
+    return _filesystem->readBatch(contents, paths);
+}
+
+std::vector<bool> CachedFilesystem::
+writeAtomicBatch(std::vector<std::vector<uint8_t>> const &contents, std::vector<std::string> const &paths)
+{
+    std::vector<bool> results = _filesystem->writeAtomicBatch(contents, paths);
+    for (std::string const &path : paths) {
+        invalidate(path);
+    }
+    return results;
+}
+
+ext::optional<std::string> CachedFilesystem::
+readSymbolicLink(std::string const &path) const
+{
+    return _filesystem->readSymbolicLink(path);
+}
+
+bool CachedFilesystem::
+writeSymbolicLink(std::string const &target, std::string const &path)
+{
+    bool result = _filesystem->writeSymbolicLink(target, path);
+    invalidate(path);
+    return result;
+}
+
+bool CachedFilesystem::
+removeFile(std::string const &path)
+{
+    bool result = _filesystem->removeFile(path);
+    invalidate(path);
+    return result;
+}
+
+bool CachedFilesystem::
+copyFile(std::string const &from, std::string const &to)
+{
+    bool result = _filesystem->copyFile(from, to);
+    invalidate(to);
+    return result;
+}
+
+bool CachedFilesystem::
+cloneFile(std::string const &from, std::string const &to)
+{
+    bool result = _filesystem->cloneFile(from, to);
+    invalidate(to);
+    return result;
+}
+
+std::string CachedFilesystem::
+resolvePath(std::string const &path) const
+{
+    return _filesystem->resolvePath(path);
+}
+
+bool CachedFilesystem::
+enumerateDirectory(
+    std::string const &path,
+    std::function<void(std::string const &)> const &cb) const
+{
+    return _filesystem->enumerateDirectory(path, cb);
+}
+
+bool CachedFilesystem::
+enumerateDirectoryEntries(
+    std::string const &path,
+    std::function<void(std::string const &, bool)> const &cb) const
+{
+    return _filesystem->enumerateDirectoryEntries(path, cb);
+}
@@ -9,7 +9,10 @@
 
 #include <libutil/DefaultFilesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 
+#include <algorithm>
+#include <atomic>
 #include <climits>
 #include <cstdlib>
 #include <cstdio>
@@ -17,9 +20,27 @@
 #include <cerrno>
 
 #include <unistd.h>
+#include <fcntl.h>
 #include <libgen.h>
 #include <dirent.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+
+#if defined(__APPLE__)
+#include <copyfile.h>
+#include <sys/clonefile.h>
+#elif defined(__linux__)
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define LIBUTIL_IO_URING 1
+#endif
+#endif
+#endif
 
 using libutil::DefaultFilesystem;
 
@@ -67,6 +88,71 @@ isExecutable(std::string const &path) const
     return ::access(path.c_str(), X_OK) == 0;
 }
 
+ext::optional<uint64_t> DefaultFilesystem::
+modificationTime(std::string const &path) const
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) < 0) {
+        return ext::nullopt;
+    }
+
+#if defined(__APPLE__)
+    struct timespec time = st.st_mtimespec;
+#else
+    struct timespec time = st.st_mtim;
+#endif
+    return static_cast<uint64_t>(time.tv_sec) * 1000000000 + static_cast<uint64_t>(time.tv_nsec);
+}
+
+ext::optional<DefaultFilesystem::Metadata> DefaultFilesystem::
+metadata(std::string const &path) const
+{
+    struct stat st;
+    if (::lstat(path.c_str(), &st) < 0) {
+        return ext::nullopt;
+    }
+
+    Metadata metadata;
+    metadata.symbolicLink = S_ISLNK(st.st_mode);
+    if (metadata.symbolicLink && ::stat(path.c_str(), &st) < 0) {
+        return ext::nullopt;
+    }
+
+#if defined(__APPLE__)
+    struct timespec time = st.st_mtimespec;
+#else
+    struct timespec time = st.st_mtim;
+#endif
+
+    metadata.directory = S_ISDIR(st.st_mode);
+    metadata.size = static_cast<uint64_t>(st.st_size);
+    metadata.modificationTime = static_cast<uint64_t>(time.tv_sec) * 1000000000 + static_cast<uint64_t>(time.tv_nsec);
+    metadata.inode = static_cast<uint64_t>(st.st_ino);
+
+    /* Check the permission bits that apply to this process, as access() would. */
+    uid_t uid = ::geteuid();
+    if (uid == 0) {
+        metadata.readable = true;
+        metadata.writable = true;
+        metadata.executable = (st.st_mode & (S_IXUSR | S_IXGRP | S_IXOTH)) != 0;
+    } else {
+        mode_t mode;
+        if (st.st_uid == uid) {
+            mode = (st.st_mode & S_IRWXU) >> 6;
+        } else if (st.st_gid == ::getegid()) {
+            mode = (st.st_mode & S_IRWXG) >> 3;
+        } else {
+            mode = (st.st_mode & S_IRWXO);
+        }
+
+        metadata.readable = (mode & S_IROTH) != 0;
+        metadata.writable = (mode & S_IWOTH) != 0;
+        metadata.executable = (mode & S_IXOTH) != 0;
+    }
+
+    return metadata;
+}
+
 bool DefaultFilesystem::
 createFile(std::string const &path)
 {
@@ -86,29 +172,31 @@ createFile(std::string const &path)
 bool DefaultFilesystem::
 createDirectory(std::string const &path)
 {
-    std::vector<std::string> components;
+    mode_t mode = S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
 
-    std::string current = path;
-    while (current != FSUtil::GetDirectoryName(current)) {
-        std::string component = FSUtil::GetBaseName(current);
-        components.push_back(component);
-
-        current = FSUtil::GetDirectoryName(current);
+    /*
+     * Directories are usually created where most of the path exists, so try
+     * the directory itself first. Only if its parent is missing, create that
+     * the same way and try again.
+     */
+    if (::mkdir(path.c_str(), mode) == 0 || errno == EEXIST) {
+        return true;
+    } else if (errno != ENOENT) {
+        return false;
     }
 
-    for (auto it = components.rbegin(); it != components.rend(); ++it) {
-        std::string const &component = *it;
-        if (it != components.rbegin()) {
-            current += "/";
-        }
-        current += component;
-
-        if (::mkdir(current.c_str(), S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) != 0 && errno != EEXIST) {
-            return false;
-        }
+    std::string parent = FSUtil::GetDirectoryName(path);
+    if (parent.empty() || parent == path || !createDirectory(parent)) {
+        return false;
     }
 
-    return true;
+    return (::mkdir(path.c_str(), mode) == 0 || errno == EEXIST);
+}
+
+bool DefaultFilesystem::
+touch(std::string const &path)
+{
+    return ::utimes(path.c_str(), NULL) == 0;
 }
 
 bool DefaultFilesystem::
@@ -157,6 +245,39 @@ read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext
     return true;
 }
 
+std::unique_ptr<libutil::Filesystem::Mapping> DefaultFilesystem::
+readMapped(std::string const &path) const
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    /* Only regular files can be mapped; empty ones have nothing to map. */
+    if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+        ::close(fd);
+        return Filesystem::readMapped(path);
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void *data = ::mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED) {
+        return Filesystem::readMapped(path);
+    }
+
+    return std::unique_ptr<Mapping>(new Mapping(static_cast<uint8_t const *>(data), size, [data, size] {
+        ::munmap(data, size);
+    }));
+}
+
 bool DefaultFilesystem::
 write(std::vector<uint8_t> const &contents, std::string const &path)
 {
@@ -178,6 +299,508 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
     return true;
 }
 
+/*
+ * A new path next to a file, to write it atomically. The temporary file
+ * must be on the same filesystem to rename it.
+ */
+static std::string
+TemporaryPath(std::string const &path)
+{
+    static std::atomic<unsigned int> counter(0);
+    return path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter++);
+}
+
+bool DefaultFilesystem::
+writeAtomic(std::vector<uint8_t> const &contents, std::string const &path)
+{
+    std::string temporary = TemporaryPath(path);
+
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (fd < 0) {
+        return false;
+    }
+
+    /* Replacing a file shouldn't change its permissions. */
+    struct stat st;
+    if (::stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+        ::fchmod(fd, st.st_mode & 07777);
+    }
+
+    size_t offset = 0;
+    while (offset < contents.size()) {
+        ssize_t written = ::write(fd, contents.data() + offset, contents.size() - offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            ::close(fd);
+            ::unlink(temporary.c_str());
+            return false;
+        }
+
+        offset += written;
+    }
+
+    if (::close(fd) != 0 || ::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+#if LIBUTIL_IO_URING
+
+namespace {
+
+/*
+ * Runs independent system calls together through an io_uring, so many
+ * small file operations don't each wait on the kernel in turn. Each result
+ * is what the system call returns, or a negative error number.
+ */
+class Ring {
+private:
+    int           _fd;
+    unsigned      _entries;
+    unsigned      _completions;
+    void         *_rings;
+    size_t        _ringsSize;
+    io_uring_sqe *_sqes;
+    size_t        _sqesSize;
+
+private:
+    unsigned     *_sqHead;
+    unsigned     *_sqTail;
+    unsigned      _sqMask;
+    unsigned     *_sqArray;
+    unsigned     *_cqHead;
+    unsigned     *_cqTail;
+    unsigned      _cqMask;
+    io_uring_cqe *_cqes;
+
+private:
+    Ring(int fd, io_uring_params const &params, void *rings, size_t ringsSize, io_uring_sqe *sqes, size_t sqesSize);
+
+public:
+    ~Ring();
+
+public:
+    /*
+     * Run operations, in any order, until all have finished.
+     */
+    void run(std::vector<io_uring_sqe> const &operations, std::vector<int32_t> *results);
+
+public:
+    /*
+     * Create a ring, or null if the kernel can't run the file operations
+     * used here through one.
+     */
+    static std::unique_ptr<Ring> Create();
+};
+
+}
+
+/* Operations queued at once; a batch of files uses two per file. */
+static unsigned const RingEntries = 256;
+
+/* Files handled at once, to bound how many are open. */
+static size_t const RingFiles = RingEntries / 2;
+
+/* The most read or written by one operation; longer files take several. */
+static size_t const RingTransfer = 1 << 30;
+
+Ring::
+Ring(int fd, io_uring_params const &params, void *rings, size_t ringsSize, io_uring_sqe *sqes, size_t sqesSize) :
+    _fd         (fd),
+    _entries    (params.sq_entries),
+    _completions(params.cq_entries),
+    _rings      (rings),
+    _ringsSize  (ringsSize),
+    _sqes       (sqes),
+    _sqesSize   (sqesSize)
+{
+    uint8_t *base = static_cast<uint8_t *>(rings);
+    _sqHead  = reinterpret_cast<unsigned *>(base + params.sq_off.head);
+    _sqTail  = reinterpret_cast<unsigned *>(base + params.sq_off.tail);
+    _sqMask  = *reinterpret_cast<unsigned *>(base + params.sq_off.ring_mask);
+    _sqArray = reinterpret_cast<unsigned *>(base + params.sq_off.array);
+    _cqHead  = reinterpret_cast<unsigned *>(base + params.cq_off.head);
+    _cqTail  = reinterpret_cast<unsigned *>(base + params.cq_off.tail);
+    _cqMask  = *reinterpret_cast<unsigned *>(base + params.cq_off.ring_mask);
+    _cqes    = reinterpret_cast<io_uring_cqe *>(base + params.cq_off.cqes);
+}
+
+Ring::
+~Ring()
+{
+    ::munmap(_sqes, _sqesSize);
+    ::munmap(_rings, _ringsSize);
+    ::close(_fd);
+}
+
+std::unique_ptr<Ring> Ring::
+Create()
+{
+    /* Once unavailable, don't keep asking the kernel. */
+    static std::atomic<bool> unavailable(false);
+    if (unavailable) {
+        return nullptr;
+    }
+
+    io_uring_params params;
+    ::memset(&params, 0, sizeof(params));
+
+    int fd = static_cast<int>(::syscall(__NR_io_uring_setup, RingEntries, &params));
+    if (fd < 0) {
+        unavailable = true;
+        return nullptr;
+    }
+
+    /* Every operation used must be supported; the newest is renaming. */
+    std::vector<uint8_t> probeBuffer = std::vector<uint8_t>(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+    io_uring_probe *probe = reinterpret_cast<io_uring_probe *>(probeBuffer.data());
+    bool supported = (params.features & IORING_FEAT_SINGLE_MMAP) != 0 &&
+        ::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+    for (uint8_t opcode : { IORING_OP_OPENAT, IORING_OP_CLOSE, IORING_OP_STATX, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_RENAMEAT }) {
+        if (supported && (opcode > probe->last_op || (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) == 0)) {
+            supported = false;
+        }
+    }
+    if (!supported) {
+        ::close(fd);
+        unavailable = true;
+        return nullptr;
+    }
+
+    /* Both rings share one mapping. */
+    size_t ringsSize = std::max<size_t>(
+        params.sq_off.array + params.sq_entries * sizeof(unsigned),
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    void *rings = ::mmap(NULL, ringsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (rings == MAP_FAILED) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    size_t sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = ::mmap(NULL, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        ::munmap(rings, ringsSize);
+        ::close(fd);
+        return nullptr;
+    }
+
+    return std::unique_ptr<Ring>(new Ring(fd, params, rings, ringsSize, static_cast<io_uring_sqe *>(sqes), sqesSize));
+}
+
+void Ring::
+run(std::vector<io_uring_sqe> const &operations, std::vector<int32_t> *results)
+{
+    results->assign(operations.size(), 0);
+
+    size_t next = 0;
+    size_t queued = 0;
+    size_t running = 0;
+    size_t finished = 0;
+
+    while (finished < operations.size()) {
+        /* Queue what fits, without more running than there's room to complete. */
+        unsigned tail = *_sqTail;
+        unsigned head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+        while (next < operations.size() && tail - head < _entries && running + queued < _completions) {
+            unsigned index = tail & _sqMask;
+            _sqes[index] = operations[next];
+            _sqes[index].user_data = next;
+            _sqArray[index] = index;
+
+            tail++;
+            next++;
+            queued++;
+        }
+        __atomic_store_n(_sqTail, tail, __ATOMIC_RELEASE);
+
+        int entered = static_cast<int>(::syscall(__NR_io_uring_enter, _fd, static_cast<unsigned>(queued), 1, IORING_ENTER_GETEVENTS, NULL, 0));
+        if (entered >= 0) {
+            queued -= entered;
+            running += entered;
+        } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            /* Fail what wasn't submitted, taking it back out of the queue. */
+            int error = errno;
+            __atomic_store_n(_sqTail, tail - static_cast<unsigned>(queued), __ATOMIC_RELEASE);
+            for (size_t i = next - queued; i < operations.size(); i++) {
+                (*results)[i] = -error;
+            }
+            finished += (operations.size() - (next - queued));
+            queued = 0;
+            next = operations.size();
+            if (running == 0) {
+                break;
+            }
+        }
+
+        unsigned cqHead = *_cqHead;
+        unsigned cqTail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+        for (; cqHead != cqTail; cqHead++) {
+            io_uring_cqe const &completion = _cqes[cqHead & _cqMask];
+            (*results)[completion.user_data] = completion.res;
+            running--;
+            finished++;
+        }
+        __atomic_store_n(_cqHead, cqHead, __ATOMIC_RELEASE);
+    }
+}
+
+static io_uring_sqe
+RingOperation(uint8_t opcode, int fd, void const *address, uint32_t length, uint64_t offset)
+{
+    io_uring_sqe operation;
+    ::memset(&operation, 0, sizeof(operation));
+    operation.opcode = opcode;
+    operation.fd     = fd;
+    operation.addr   = reinterpret_cast<uintptr_t>(address);
+    operation.len    = length;
+    operation.off    = offset;
+    return operation;
+}
+
+static io_uring_sqe
+RingOpen(std::string const &path, int flags)
+{
+    io_uring_sqe operation = RingOperation(IORING_OP_OPENAT, AT_FDCWD, path.c_str(), 0666, 0);
+    operation.open_flags = flags | O_CLOEXEC;
+    return operation;
+}
+
+static io_uring_sqe
+RingStat(std::string const &path, struct statx *stat)
+{
+    return RingOperation(IORING_OP_STATX, AT_FDCWD, path.c_str(), STATX_TYPE | STATX_MODE | STATX_SIZE, reinterpret_cast<uintptr_t>(stat));
+}
+
+/*
+ * Close the files opened for a batch, returning if each closed cleanly.
+ */
+static std::vector<int32_t>
+RingClose(Ring *ring, std::vector<int> const &fds)
+{
+    std::vector<io_uring_sqe> operations;
+    std::vector<size_t> indexes;
+    for (size_t i = 0; i < fds.size(); i++) {
+        if (fds[i] >= 0) {
+            operations.push_back(RingOperation(IORING_OP_CLOSE, fds[i], NULL, 0, 0));
+            indexes.push_back(i);
+        }
+    }
+
+    std::vector<int32_t> results;
+    ring->run(operations, &results);
+
+    std::vector<int32_t> closed = std::vector<int32_t>(fds.size(), -EBADF);
+    for (size_t n = 0; n < indexes.size(); n++) {
+        closed[indexes[n]] = results[n];
+    }
+    return closed;
+}
+
+/*
+ * Read or write the rest of each file, continuing after partial transfers.
+ * Transfers stop for a file on an error, or at its end when reading.
+ */
+static void
+RingTransferAll(Ring *ring, uint8_t opcode, std::vector<int> const &fds, std::vector<uint8_t *> const &buffers, std::vector<size_t> *sizes, std::vector<bool> *success)
+{
+    std::vector<size_t> offsets = std::vector<size_t>(fds.size(), 0);
+
+    while (true) {
+        std::vector<io_uring_sqe> operations;
+        std::vector<size_t> indexes;
+        for (size_t i = 0; i < fds.size(); i++) {
+            if ((*success)[i] && offsets[i] < (*sizes)[i]) {
+                uint32_t length = static_cast<uint32_t>(std::min((*sizes)[i] - offsets[i], RingTransfer));
+                operations.push_back(RingOperation(opcode, fds[i], buffers[i] + offsets[i], length, offsets[i]));
+                indexes.push_back(i);
+            }
+        }
+        if (operations.empty()) {
+            break;
+        }
+
+        std::vector<int32_t> results;
+        ring->run(operations, &results);
+
+        for (size_t n = 0; n < indexes.size(); n++) {
+            size_t i = indexes[n];
+            if (results[n] > 0) {
+                offsets[i] += results[n];
+            } else if (results[n] == 0 && opcode == IORING_OP_READ) {
+                /* The file got shorter since its size was found. */
+                (*sizes)[i] = offsets[i];
+            } else {
+                (*success)[i] = false;
+            }
+        }
+    }
+}
+
+static void
+RingReadBatch(Ring *ring, std::vector<std::vector<uint8_t>> *contents, std::vector<std::string> const &paths, size_t start, size_t count, std::vector<bool> *results)
+{
+    std::vector<struct statx> stats = std::vector<struct statx>(count);
+
+    std::vector<io_uring_sqe> operations;
+    for (size_t i = 0; i < count; i++) {
+        operations.push_back(RingOpen(paths[start + i], O_RDONLY));
+        operations.push_back(RingStat(paths[start + i], &stats[i]));
+    }
+
+    std::vector<int32_t> opened;
+    ring->run(operations, &opened);
+
+    std::vector<int> fds = std::vector<int>(count);
+    std::vector<uint8_t *> buffers = std::vector<uint8_t *>(count);
+    std::vector<size_t> sizes = std::vector<size_t>(count);
+    std::vector<bool> success = std::vector<bool>(count);
+    for (size_t i = 0; i < count; i++) {
+        fds[i] = opened[i * 2];
+        success[i] = (fds[i] >= 0 && opened[i * 2 + 1] == 0 && S_ISREG(stats[i].stx_mode));
+
+        std::vector<uint8_t> *data = &(*contents)[start + i];
+        data->resize(success[i] ? stats[i].stx_size : 0);
+        buffers[i] = data->data();
+        sizes[i] = data->size();
+    }
+
+    RingTransferAll(ring, IORING_OP_READ, fds, buffers, &sizes, &success);
+    RingClose(ring, fds);
+
+    for (size_t i = 0; i < count; i++) {
+        (*contents)[start + i].resize(sizes[i]);
+        (*results)[start + i] = success[i];
+    }
+}
+
+static void
+RingWriteAtomicBatch(Ring *ring, std::vector<std::vector<uint8_t>> const &contents, std::vector<std::string> const &paths, size_t start, size_t count, std::vector<bool> *results)
+{
+    std::vector<std::string> temporaries;
+    for (size_t i = 0; i < count; i++) {
+        temporaries.push_back(TemporaryPath(paths[start + i]));
+    }
+
+    std::vector<struct statx> stats = std::vector<struct statx>(count);
+
+    std::vector<io_uring_sqe> operations;
+    for (size_t i = 0; i < count; i++) {
+        operations.push_back(RingOpen(temporaries[i], O_WRONLY | O_CREAT | O_EXCL));
+        operations.push_back(RingStat(paths[start + i], &stats[i]));
+    }
+
+    std::vector<int32_t> opened;
+    ring->run(operations, &opened);
+
+    std::vector<int> fds = std::vector<int>(count);
+    std::vector<uint8_t *> buffers = std::vector<uint8_t *>(count);
+    std::vector<size_t> sizes = std::vector<size_t>(count);
+    std::vector<bool> success = std::vector<bool>(count);
+    for (size_t i = 0; i < count; i++) {
+        fds[i] = opened[i * 2];
+        success[i] = (fds[i] >= 0);
+
+        /* Replacing a file shouldn't change its permissions. */
+        if (success[i] && opened[i * 2 + 1] == 0 && S_ISREG(stats[i].stx_mode)) {
+            ::fchmod(fds[i], stats[i].stx_mode & 07777);
+        }
+
+        std::vector<uint8_t> const &data = contents[start + i];
+        buffers[i] = const_cast<uint8_t *>(data.data());
+        sizes[i] = data.size();
+    }
+
+    RingTransferAll(ring, IORING_OP_WRITE, fds, buffers, &sizes, &success);
+
+    std::vector<int32_t> closed = RingClose(ring, fds);
+
+    operations.clear();
+    std::vector<size_t> indexes;
+    for (size_t i = 0; i < count; i++) {
+        if (success[i] && closed[i] == 0) {
+            io_uring_sqe operation = RingOperation(IORING_OP_RENAMEAT, AT_FDCWD, temporaries[i].c_str(), static_cast<uint32_t>(AT_FDCWD), reinterpret_cast<uintptr_t>(paths[start + i].c_str()));
+            operations.push_back(operation);
+            indexes.push_back(i);
+        } else {
+            success[i] = false;
+        }
+    }
+
+    std::vector<int32_t> renamed;
+    ring->run(operations, &renamed);
+    for (size_t n = 0; n < indexes.size(); n++) {
+        success[indexes[n]] = (renamed[n] == 0);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!success[i] && fds[i] >= 0) {
+            ::unlink(temporaries[i].c_str());
+        }
+        (*results)[start + i] = success[i];
+    }
+}
+
+#endif
+
+std::vector<bool> DefaultFilesystem::
+readBatch(std::vector<std::vector<uint8_t>> *contents, std::vector<std::string> const &paths) const
+{
+    contents->assign(paths.size(), std::vector<uint8_t>());
+    std::vector<bool> results = std::vector<bool>(paths.size(), false);
+
+#if LIBUTIL_IO_URING
+    if (paths.size() > 1) {
+        if (std::unique_ptr<Ring> ring = Ring::Create()) {
+            for (size_t start = 0; start < paths.size(); start += RingFiles) {
+                RingReadBatch(ring.get(), contents, paths, start, std::min(RingFiles, paths.size() - start), &results);
+            }
+            return results;
+        }
+    }
+#endif
+
+    /* Without batched I/O, spread the files across the shared threads. */
+    std::vector<char> read = std::vector<char>(paths.size(), false);
+    Parallel::For(paths.size(), [&](size_t index) {
+        read[index] = this->read(&(*contents)[index], paths[index]);
+    });
+
+    std::copy(read.begin(), read.end(), results.begin());
+    return results;
+}
+
+std::vector<bool> DefaultFilesystem::
+writeAtomicBatch(std::vector<std::vector<uint8_t>> const &contents, std::vector<std::string> const &paths)
+{
+    std::vector<bool> results = std::vector<bool>(paths.size(), false);
+
+#if LIBUTIL_IO_URING
+    if (paths.size() > 1) {
+        if (std::unique_ptr<Ring> ring = Ring::Create()) {
+            for (size_t start = 0; start < paths.size(); start += RingFiles) {
+                RingWriteAtomicBatch(ring.get(), contents, paths, start, std::min(RingFiles, paths.size() - start), &results);
+            }
+            return results;
+        }
+    }
+#endif
+
+    std::vector<char> written = std::vector<char>(paths.size(), false);
+    Parallel::For(paths.size(), [&](size_t index) {
+        written[index] = this->writeAtomic(contents[index], paths[index]);
+    });
+
+    std::copy(written.begin(), written.end(), results.begin());
+    return results;
+}
+
 ext::optional<std::string> DefaultFilesystem::
 readSymbolicLink(std::string const &path) const
 {
@@ -212,6 +835,146 @@ removeFile(std::string const &path)
     return true;
 }
 
+/*
+ * Copies the rest of one open file into another through a buffer.
+ */
+static bool
+CopyContents(int in, int out)
+{
+    std::vector<uint8_t> buffer = std::vector<uint8_t>(64 * 1024);
+    while (true) {
+        ssize_t size = ::read(in, buffer.data(), buffer.size());
+        if (size < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        } else if (size == 0) {
+            return true;
+        }
+
+        for (ssize_t offset = 0; offset < size;) {
+            ssize_t written = ::write(out, buffer.data() + offset, size - offset);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            offset += written;
+        }
+    }
+}
+
+bool DefaultFilesystem::
+cloneFile(std::string const &from, std::string const &to)
+{
+#if defined(__APPLE__)
+    /* Clones are always new files. */
+    if ((this->isSymbolicLink(to) || this->exists(to)) && !this->removeFile(to)) {
+        return false;
+    }
+
+    return (::clonefile(from.c_str(), to.c_str(), 0) == 0);
+#elif defined(__linux__) && defined(FICLONE)
+    int in = ::open(from.c_str(), O_RDONLY);
+    if (in < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(in, &st) < 0 || !S_ISREG(st.st_mode)) {
+        ::close(in);
+        return false;
+    }
+
+    int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, st.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO));
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    bool success = (::ioctl(out, FICLONE, in) == 0);
+    ::close(in);
+    if (::close(out) != 0) {
+        success = false;
+    }
+
+    /* Don't leave an empty file behind if the copy falls back. */
+    if (!success) {
+        ::unlink(to.c_str());
+    }
+    return success;
+#else
+    return false;
+#endif
+}
+
+bool DefaultFilesystem::
+copyFile(std::string const &from, std::string const &to)
+{
+    struct stat st;
+    if (::stat(from.c_str(), &st) < 0) {
+        return false;
+    }
+
+    /* Keep the permissions, but make the copy writable. */
+    mode_t mode = (st.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO)) | S_IWUSR;
+
+    if (this->cloneFile(from, to)) {
+        return (::chmod(to.c_str(), mode) == 0);
+    }
+
+    int in = ::open(from.c_str(), O_RDONLY);
+    if (in < 0) {
+        return false;
+    }
+
+    int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, mode);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    bool success = false;
+#if defined(__APPLE__)
+    success = (::fcopyfile(in, out, nullptr, COPYFILE_DATA) == 0);
+    if (!success && (::lseek(in, 0, SEEK_SET) != 0 || ::lseek(out, 0, SEEK_SET) != 0 || ::ftruncate(out, 0) != 0)) {
+        ::close(in);
+        ::close(out);
+        return false;
+    }
+#elif defined(__linux__) && defined(SYS_copy_file_range)
+    /*
+     * Copy in the kernel where the filesystem supports it. Anything not
+     * copied is left for the loop below, which continues from there.
+     */
+    for (off_t remaining = st.st_size; remaining > 0;) {
+        long size = ::syscall(SYS_copy_file_range, in, nullptr, out, nullptr, static_cast<size_t>(remaining), 0u);
+        if (size < 0 && errno == EINTR) {
+            continue;
+        } else if (size <= 0) {
+            break;
+        }
+        remaining -= size;
+    }
+#endif
+    if (!success) {
+        success = CopyContents(in, out);
+    }
+
+    /* An existing file keeps its mode when opened, so set it here. */
+    if (success && ::fchmod(out, mode) != 0) {
+        success = false;
+    }
+
+    ::close(in);
+    if (::close(out) != 0) {
+        success = false;
+    }
+    return success;
+}
+
 std::string DefaultFilesystem::
 resolvePath(std::string const &path) const
 {
@@ -244,3 +1007,37 @@ enumerateDirectory(
     return true;
 }
 
+bool DefaultFilesystem::
+enumerateDirectoryEntries(
+    std::string const &path,
+    std::function<void(std::string const &, bool)> const &cb) const
+{
+    DIR *dp = opendir(path.c_str());
+    if (dp == NULL) {
+        return false;
+    }
+
+    std::string name;
+    while (struct dirent *entry = readdir(dp)) {
+        if (::strcmp(entry->d_name, ".") == 0 || ::strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        name = entry->d_name;
+
+        /* Most filesystems report the type in the listing; otherwise, look. */
+        bool directory;
+        if (entry->d_type != DT_UNKNOWN) {
+            directory = (entry->d_type == DT_DIR);
+        } else {
+            struct stat st;
+            directory = (::fstatat(dirfd(dp), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode));
+        }
+
+        cb(name, directory);
+    }
+
+    closedir(dp);
+    return true;
+}
+
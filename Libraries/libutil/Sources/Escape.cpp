@@ -9,39 +9,68 @@
 
 #include <libutil/Escape.h>
 
+#include <algorithm>
+#include <iterator>
+
 using libutil::Escape;
 
+namespace {
+
+/*
+ * Characters that can appear in a shell word without quoting.
+ */
+class ShellSafe {
+private:
+    bool _safe[256];
+
+public:
+    ShellSafe()
+    {
+        std::fill(std::begin(_safe), std::end(_safe), false);
+        for (unsigned char c : std::string("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789@%_-+=:,./")) {
+            _safe[c] = true;
+        }
+    }
+
+public:
+    bool operator()(char c) const
+    { return _safe[static_cast<unsigned char>(c)]; }
+};
+
+}
+
 std::string Escape::
 Shell(std::string const &value)
 {
-    static std::string const *escaped = nullptr;
-    if (escaped == nullptr) {
-        std::string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
-        std::string digits = "0123456789";
-        escaped = new std::string(alphabet + digits + "@%_-+=:,./");
+    std::string result;
+    Shell(value, &result);
+    return result;
+}
+
+void Escape::
+Shell(std::string const &value, std::string *result)
+{
+    static ShellSafe const safe;
+
+    if (std::all_of(value.begin(), value.end(), safe)) {
+        result->append(value);
+        return;
     }
 
-    if (value.find_first_not_of(*escaped) == std::string::npos) {
-        return value;
-    } else {
-        std::string result;
-        result.reserve(value.size() + 4);
-        result += "'";
-
-        std::string::size_type offset = 0;
-        std::string::size_type previous = 0;
-        while ((offset = value.find("'", offset)) != std::string::npos) {
-            result.append(value.data() + previous, offset - previous);
-            result += "'\\''";
-
-            offset += 1;
-            previous = offset;
-        }
-        result.append(value.data() + previous, value.size() - previous);
+    result->push_back('\'');
+
+    std::string::size_type offset = 0;
+    std::string::size_type previous = 0;
+    while ((offset = value.find('\'', offset)) != std::string::npos) {
+        result->append(value.data() + previous, offset - previous);
+        result->append("'\\''");
 
-        result += "'";
-        return result;
+        offset += 1;
+        previous = offset;
     }
+    result->append(value.data() + previous, value.size() - previous);
+
+    result->push_back('\'');
 }
 
 std::string Escape::
@@ -49,14 +78,18 @@ Makefile(std::string const &value)
 {
     std::string result;
     result.reserve(value.size());
+    Makefile(value, &result);
+    return result;
+}
 
+void Escape::
+Makefile(std::string const &value, std::string *result)
+{
     for (char c : value) {
         if (isspace(c) || c == '#' || c == '$' || c == '%' || c == ':') {
-            result += '\\';
+            result->push_back('\\');
         }
 
-        result += c;
+        result->push_back(c);
     }
-
-    return result;
 }
@@ -13,45 +13,112 @@
 
 #include <strings.h>
 #include <unistd.h>
-#include <libgen.h>
 
 using libutil::FSUtil;
 
+/*
+ * These follow dirname() and basename(), but work on the string in place
+ * rather than on a copy for each call.
+ */
+
 std::string FSUtil::
 GetDirectoryName(std::string const &path)
 {
-    if (path.find('/') == std::string::npos) {
+    size_t last = path.rfind('/');
+    if (last == std::string::npos) {
         // dirname() returns '.' for empty
         return std::string();
     }
 
-    std::string copy(path);
-    return ::dirname(&copy[0]);
+    /* Skip trailing slashes to find the separator before the last component. */
+    if (last != 0 && last == path.size() - 1) {
+        size_t run = last;
+        while (run != 0 && path[run - 1] == '/') {
+            run--;
+        }
+
+        if (run != 0) {
+            last = path.rfind('/', run - 1);
+        }
+    }
+
+    if (last == std::string::npos) {
+        return ".";
+    }
+
+    size_t run = last;
+    while (run != 0 && path[run - 1] == '/') {
+        run--;
+    }
+
+    if (run == 0) {
+        /* Only the root is left. Exactly two leading slashes are kept. */
+        return path.substr(0, last == 1 ? 2 : 1);
+    }
+
+    return path.substr(0, run);
 }
 
-std::string FSUtil::
-GetBaseName(std::string const &path)
+/*
+ * Finds the last component of a path, ignoring trailing slashes.
+ */
+static void
+BaseNameRange(std::string const &path, size_t *start, size_t *end)
 {
-    if (path.empty()) {
-        // basename() returns '.' for empty
-        return std::string();
+    *end = path.size();
+    while (*end > 1 && path[*end - 1] == '/') {
+        (*end)--;
     }
 
-    std::string copy(path);
-    return ::basename(&copy[0]);
+    if (*end == 1 && path[0] == '/') {
+        *start = 0;
+        return;
+    }
+
+    size_t slash = (*end == 0 ? std::string::npos : path.rfind('/', *end - 1));
+    *start = (slash == std::string::npos ? 0 : slash + 1);
+}
+
+/*
+ * Finds the extension in the last component of a path, after the last dot.
+ */
+static bool
+ExtensionRange(std::string const &path, size_t *start, size_t *end)
+{
+    size_t base;
+    BaseNameRange(path, &base, end);
+
+    for (size_t i = *end; i > base; i--) {
+        if (path[i - 1] == '.') {
+            *start = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string FSUtil::
+GetBaseName(std::string const &path)
+{
+    size_t start, end;
+    BaseNameRange(path, &start, &end);
+    return path.substr(start, end - start);
 }
 
 std::string FSUtil::
 GetBaseNameWithoutExtension(std::string const &path)
 {
-    std::string base = GetBaseName(path);
+    size_t start, end;
+    BaseNameRange(path, &start, &end);
 
-    size_t pos = base.rfind('.');
-    if (pos == std::string::npos) {
-        return base;
+    for (size_t i = end; i > start; i--) {
+        if (path[i - 1] == '.') {
+            return path.substr(start, i - 1 - start);
+        }
     }
 
-    return base.substr(0, pos);
+    return path.substr(start, end - start);
 }
 
 std::string FSUtil::
@@ -67,10 +134,10 @@ GetRelativePath(std::string const &path, std::string const &to)
         std::string::size_type npo = path.find('/', po);
         std::string::size_type noo = to.find('/', oo);
 
-        std::string spo = path.substr(po, (npo == std::string::npos ? path.size() : npo) - po);
-        std::string soo = to.substr(oo, (noo == std::string::npos ? to.size() : noo) - oo);
+        std::string::size_type lpo = (npo == std::string::npos ? path.size() : npo) - po;
+        std::string::size_type loo = (noo == std::string::npos ? to.size() : noo) - oo;
 
-        if (spo == soo) {
+        if (path.compare(po, lpo, to, oo, loo) == 0) {
             po = (npo == std::string::npos ? std::string::npos : npo + 1);
             oo = (noo == std::string::npos ? std::string::npos : noo + 1);
         } else {
@@ -88,7 +155,7 @@ GetRelativePath(std::string const &path, std::string const &to)
     }
 
     if (po != std::string::npos && po != path.size()) {
-        result += path.substr(po);
+        result.append(path, po, std::string::npos);
     }
 
     return result;
@@ -97,48 +164,54 @@ GetRelativePath(std::string const &path, std::string const &to)
 std::string FSUtil::
 GetFileExtension(std::string const &path)
 {
-    std::string base = GetBaseName(path);
-
-    size_t pos = base.rfind('.');
-    if (pos == std::string::npos) {
+    size_t start, end;
+    if (!ExtensionRange(path, &start, &end)) {
         return std::string();
     }
 
-    return base.substr(pos + 1);
+    return path.substr(start, end - start);
 }
 
-bool FSUtil::
-IsFileExtension(std::string const &path, std::string const &extension, bool insensitive)
+/*
+ * Compares the extension in a path to an extension, without copying either.
+ */
+static bool
+ExtensionEqual(std::string const &path, size_t start, size_t end, std::string const &extension, bool insensitive)
 {
-    std::string pathExtension = GetFileExtension(path);
-    if (pathExtension.empty()) {
-        return extension.empty();
+    if (end - start != extension.size()) {
+        return false;
     }
 
     if (insensitive) {
-        return ::strcasecmp(pathExtension.c_str(), extension.c_str()) == 0;
+        return ::strncasecmp(path.data() + start, extension.data(), extension.size()) == 0;
     } else {
-        return pathExtension == extension;
+        return path.compare(start, end - start, extension) == 0;
     }
 }
 
+bool FSUtil::
+IsFileExtension(std::string const &path, std::string const &extension, bool insensitive)
+{
+    size_t start, end;
+    if (!ExtensionRange(path, &start, &end) || start == end) {
+        return extension.empty();
+    }
+
+    return ExtensionEqual(path, start, end, extension, insensitive);
+}
+
 bool FSUtil::
 IsFileExtension(std::string const &path, std::initializer_list<std::string> const &extensions, bool insensitive)
 {
-    std::string pathExtension = GetFileExtension(path);
-    if (pathExtension.empty()) {
+    size_t start, end;
+    if (!ExtensionRange(path, &start, &end) || start == end) {
         return false;
     }
 
     for (auto const &extension : extensions) {
-        bool match = false;
-        if (insensitive) {
-            match = ::strcasecmp(pathExtension.c_str(), extension.c_str()) == 0;
-        } else {
-            match = pathExtension == extension;
-        }
-        if (match)
+        if (ExtensionEqual(path, start, end, extension, insensitive)) {
             return true;
+        }
     }
 
     return false;
@@ -9,33 +9,298 @@
 
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 
+#include <algorithm>
+#include <cstring>
 #include <unordered_set>
 #include <sstream>
 
 using libutil::Filesystem;
 using libutil::FSUtil;
 
+Filesystem::Mapping::
+Mapping(uint8_t const *data, size_t size, std::function<void()> const &release) :
+    _data   (data),
+    _size   (size),
+    _release(release)
+{
+}
+
+Filesystem::Mapping::
+Mapping(std::vector<uint8_t> &&contents) :
+    _contents(std::move(contents))
+{
+    _data = _contents.data();
+    _size = _contents.size();
+}
+
+Filesystem::Mapping::
+~Mapping()
+{
+    if (_release) {
+        _release();
+    }
+}
+
+std::unique_ptr<Filesystem::Mapping> Filesystem::
+readMapped(std::string const &path) const
+{
+    std::vector<uint8_t> contents;
+    if (!this->read(&contents, path)) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<Mapping>(new Mapping(std::move(contents)));
+}
+
 bool Filesystem::
-enumerateRecursive(
+writeAtomic(std::vector<uint8_t> const &contents, std::string const &path)
+{
+    return this->write(contents, path);
+}
+
+bool Filesystem::
+writeIfChanged(std::vector<uint8_t> const &contents, std::string const &path)
+{
+    /* Only read the existing file if the size says it could be the same. */
+    ext::optional<Metadata> metadata = this->metadata(path);
+    if (metadata && !metadata->directory && metadata->size == contents.size()) {
+        std::unique_ptr<Mapping> existing = this->readMapped(path);
+        if (existing != nullptr && existing->size() == contents.size() &&
+            (contents.empty() || ::memcmp(existing->data(), contents.data(), contents.size()) == 0)) {
+            return true;
+        }
+    }
+
+    return this->writeAtomic(contents, path);
+}
+
+std::vector<bool> Filesystem::
+readBatch(std::vector<std::vector<uint8_t>> *contents, std::vector<std::string> const &paths) const
+{
+    contents->assign(paths.size(), std::vector<uint8_t>());
+
+    std::vector<bool> results = std::vector<bool>(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        results[i] = this->read(&(*contents)[i], paths[i]);
+    }
+    return results;
+}
+
+std::vector<bool> Filesystem::
+writeAtomicBatch(std::vector<std::vector<uint8_t>> const &contents, std::vector<std::string> const &paths)
+{
+    std::vector<bool> results = std::vector<bool>(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        results[i] = this->writeAtomic(contents[i], paths[i]);
+    }
+    return results;
+}
+
+std::vector<bool> Filesystem::
+writeIfChangedBatch(std::vector<std::vector<uint8_t>> const &contents, std::vector<std::string> const &paths)
+{
+    /* As for one file, only read existing files the size says could be the same. */
+    std::vector<size_t> candidates;
+    std::vector<std::string> candidatePaths;
+    for (size_t i = 0; i < paths.size(); i++) {
+        ext::optional<Metadata> metadata = this->metadata(paths[i]);
+        if (metadata && !metadata->directory && metadata->size == contents[i].size()) {
+            candidates.push_back(i);
+            candidatePaths.push_back(paths[i]);
+        }
+    }
+
+    std::vector<bool> unchanged = std::vector<bool>(paths.size(), false);
+    if (!candidates.empty()) {
+        std::vector<std::vector<uint8_t>> existing;
+        std::vector<bool> read = this->readBatch(&existing, candidatePaths);
+        for (size_t n = 0; n < candidates.size(); n++) {
+            unchanged[candidates[n]] = (read[n] && existing[n] == contents[candidates[n]]);
+        }
+    }
+
+    std::vector<size_t> changed;
+    std::vector<std::vector<uint8_t>> changedContents;
+    std::vector<std::string> changedPaths;
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (!unchanged[i]) {
+            changed.push_back(i);
+            changedContents.push_back(contents[i]);
+            changedPaths.push_back(paths[i]);
+        }
+    }
+
+    std::vector<bool> results = std::vector<bool>(paths.size(), true);
+    if (!changed.empty()) {
+        std::vector<bool> written = this->writeAtomicBatch(changedContents, changedPaths);
+        for (size_t n = 0; n < changed.size(); n++) {
+            results[changed[n]] = written[n];
+        }
+    }
+    return results;
+}
+
+bool Filesystem::
+enumerateDirectoryEntries(
     std::string const &path,
-    std::function<bool(std::string const &)> const &cb) const
+    std::function<void(std::string const &, bool)> const &cb) const
 {
-    this->enumerateDirectory(path, [&](std::string const &filename) -> void {
-        std::string full = path + "/" + filename;
-        cb(full);
+    return this->enumerateDirectory(path, [&](std::string const &name) {
+        std::string full = path + "/" + name;
+        cb(name, this->isDirectory(full) && !this->isSymbolicLink(full));
     });
+}
+
+namespace {
+
+/*
+ * A listed directory. Each subdirectory in the entries has a listing
+ * in the children, in the same order.
+ */
+struct DirectoryListing {
+    std::vector<std::pair<std::string, bool>>         entries;
+    std::vector<std::unique_ptr<DirectoryListing>>    children;
+};
 
-    this->enumerateDirectory(path, [&](std::string const &filename) -> void {
-        std::string full = path + "/" + filename;
-        if (this->isDirectory(full) && !this->isSymbolicLink(full)) {
-            this->enumerateRecursive(full, cb);
+}
+
+static bool
+EnumerateListing(DirectoryListing const &listing, std::string *path, std::function<bool(std::string const &, bool)> const &cb)
+{
+    size_t length = path->size();
+
+    for (std::pair<std::string, bool> const &entry : listing.entries) {
+        path->append("/").append(entry.first);
+        bool result = cb(*path, entry.second);
+        path->resize(length);
+
+        if (!result) {
+            return false;
         }
-    });
+    }
+
+    size_t child = 0;
+    for (std::pair<std::string, bool> const &entry : listing.entries) {
+        if (entry.second) {
+            path->append("/").append(entry.first);
+            bool result = EnumerateListing(*listing.children[child++], path, cb);
+            path->resize(length);
+
+            if (!result) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool Filesystem::
+enumerateRecursive(
+    std::string const &path,
+    std::function<bool(std::string const &, bool)> const &cb) const
+{
+    DirectoryListing root;
+    if (!this->enumerateDirectoryEntries(path, [&](std::string const &name, bool directory) {
+        root.entries.push_back({ name, directory });
+    })) {
+        return false;
+    }
+
+    /*
+     * List the tree one level at a time, with each level's directories
+     * listed in parallel. The callback isn't thread safe, so it is only
+     * called once everything has been listed.
+     */
+    std::string base = path;
+    while (!base.empty() && base.back() == '/') {
+        base.pop_back();
+    }
+
+    std::vector<std::pair<DirectoryListing *, std::string>> level = { { &root, base } };
+    while (!level.empty()) {
+        std::vector<std::pair<DirectoryListing *, std::string>> next;
+        for (std::pair<DirectoryListing *, std::string> const &directory : level) {
+            for (std::pair<std::string, bool> const &entry : directory.first->entries) {
+                if (entry.second) {
+                    directory.first->children.emplace_back(new DirectoryListing());
+                    next.push_back({ directory.first->children.back().get(), directory.second + "/" + entry.first });
+                }
+            }
+        }
+
+        libutil::Parallel::For(next.size(), [&](size_t index) {
+            DirectoryListing *listing = next[index].first;
+            this->enumerateDirectoryEntries(next[index].second, [&](std::string const &name, bool directory) {
+                listing->entries.push_back({ name, directory });
+            });
+        });
+
+        level = std::move(next);
+    }
 
+    EnumerateListing(root, &base, cb);
     return true;
 }
 
+bool Filesystem::
+copyFile(std::string const &from, std::string const &to)
+{
+    if (this->cloneFile(from, to)) {
+        return true;
+    }
+
+    std::vector<uint8_t> contents;
+    if (!this->read(&contents, from)) {
+        return false;
+    }
+
+    return this->write(contents, to);
+}
+
+bool Filesystem::
+cloneFile(std::string const &from, std::string const &to)
+{
+    return false;
+}
+
+bool Filesystem::
+copyRecursive(std::string const &from, std::string const &to)
+{
+    if (this->isSymbolicLink(from)) {
+        ext::optional<std::string> target = this->readSymbolicLink(from);
+        if (!target) {
+            return false;
+        }
+
+        /* Links can't be written over. */
+        if (this->isSymbolicLink(to) || this->exists(to)) {
+            if (!this->removeFile(to)) {
+                return false;
+            }
+        }
+
+        return this->writeSymbolicLink(*target, to);
+    } else if (this->isDirectory(from)) {
+        if (!this->createDirectory(to)) {
+            return false;
+        }
+
+        bool success = true;
+        bool enumerated = this->enumerateDirectory(from, [&](std::string const &filename) -> void {
+            if (success && !this->copyRecursive(from + "/" + filename, to + "/" + filename)) {
+                success = false;
+            }
+        });
+
+        return (enumerated && success);
+    } else {
+        return this->copyFile(from, to);
+    }
+}
+
 ext::optional<std::string> Filesystem::
 findFile(std::string const &name, std::vector<std::string> const &paths) const
 {
@@ -62,7 +327,8 @@ findExecutable(std::string const &name, std::vector<std::string> const &paths) c
         return ext::nullopt;
     }
 
-    if (this->isExecutable(*exePath)) {
+    ext::optional<Metadata> metadata = this->metadata(*exePath);
+    if (metadata && metadata->executable) {
         return FSUtil::NormalizePath(*exePath);
     }
 
@@ -74,10 +340,7 @@ findExecutable(std::string const &name, std::vector<std::string> const &paths) c
 Filesystem *Filesystem::
 GetDefaultUNSAFE()
 {
-    static DefaultFilesystem *filesystem = nullptr;
-    if (filesystem == nullptr) {
-        filesystem = new DefaultFilesystem();
-    }
-
+    /* Static initialization is thread safe; targets resolve in parallel. */
+    static DefaultFilesystem *filesystem = new DefaultFilesystem();
     return filesystem;
 }
@@ -0,0 +1,204 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/Hash.h>
+#include <libutil/Filesystem.h>
+
+#include <algorithm>
+#include <cstring>
+
+using libutil::Hash;
+using libutil::Filesystem;
+
+static uint64_t const Prime1 = 0x9E3779B185EBCA87ULL;
+static uint64_t const Prime2 = 0xC2B2AE3D27D4EB4FULL;
+static uint64_t const Prime3 = 0x165667B19E3779F9ULL;
+static uint64_t const Prime4 = 0x85EBCA77C2B2AE63ULL;
+static uint64_t const Prime5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t
+Rotate(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/* Input is little endian on every host; compilers turn these into loads. */
+static inline uint64_t
+Read64(uint8_t const *data)
+{
+    uint64_t value = 0;
+    for (int n = 7; n >= 0; n--) {
+        value = (value << 8) | data[n];
+    }
+    return value;
+}
+
+static inline uint32_t
+Read32(uint8_t const *data)
+{
+    uint32_t value = 0;
+    for (int n = 3; n >= 0; n--) {
+        value = (value << 8) | data[n];
+    }
+    return value;
+}
+
+static inline uint64_t
+Round(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * Prime2;
+    accumulator = Rotate(accumulator, 31);
+    return accumulator * Prime1;
+}
+
+static inline uint64_t
+MergeRound(uint64_t hash, uint64_t accumulator)
+{
+    hash ^= Round(0, accumulator);
+    return hash * Prime1 + Prime4;
+}
+
+static inline void
+Stripe(uint64_t *accumulators, uint8_t const *data)
+{
+    accumulators[0] = Round(accumulators[0], Read64(data + 0));
+    accumulators[1] = Round(accumulators[1], Read64(data + 8));
+    accumulators[2] = Round(accumulators[2], Read64(data + 16));
+    accumulators[3] = Round(accumulators[3], Read64(data + 24));
+}
+
+Hash::
+Hash(uint64_t seed) :
+    _seed    (seed),
+    _length  (0),
+    _buffered(0)
+{
+    _accumulators[0] = seed + Prime1 + Prime2;
+    _accumulators[1] = seed + Prime2;
+    _accumulators[2] = seed;
+    _accumulators[3] = seed - Prime1;
+}
+
+void Hash::
+update(void const *data, size_t size)
+{
+    uint8_t const *bytes = static_cast<uint8_t const *>(data);
+    _length += size;
+
+    /* Finish a stripe started by an earlier update. */
+    if (_buffered > 0) {
+        size_t fill = std::min(size, sizeof(_buffer) - _buffered);
+        ::memcpy(_buffer + _buffered, bytes, fill);
+        _buffered += fill;
+        bytes += fill;
+        size -= fill;
+
+        if (_buffered < sizeof(_buffer)) {
+            return;
+        }
+
+        Stripe(_accumulators, _buffer);
+        _buffered = 0;
+    }
+
+    while (size >= sizeof(_buffer)) {
+        Stripe(_accumulators, bytes);
+        bytes += sizeof(_buffer);
+        size -= sizeof(_buffer);
+    }
+
+    if (size > 0) {
+        ::memcpy(_buffer, bytes, size);
+        _buffered = size;
+    }
+}
+
+uint64_t Hash::
+digest() const
+{
+    uint64_t hash;
+
+    if (_length >= sizeof(_buffer)) {
+        hash = Rotate(_accumulators[0], 1) + Rotate(_accumulators[1], 7) + Rotate(_accumulators[2], 12) + Rotate(_accumulators[3], 18);
+        hash = MergeRound(hash, _accumulators[0]);
+        hash = MergeRound(hash, _accumulators[1]);
+        hash = MergeRound(hash, _accumulators[2]);
+        hash = MergeRound(hash, _accumulators[3]);
+    } else {
+        hash = _seed + Prime5;
+    }
+
+    hash += _length;
+
+    uint8_t const *bytes = _buffer;
+    size_t size = _buffered;
+
+    while (size >= 8) {
+        hash ^= Round(0, Read64(bytes));
+        hash = Rotate(hash, 27) * Prime1 + Prime4;
+        bytes += 8;
+        size -= 8;
+    }
+
+    if (size >= 4) {
+        hash ^= static_cast<uint64_t>(Read32(bytes)) * Prime1;
+        hash = Rotate(hash, 23) * Prime2 + Prime3;
+        bytes += 4;
+        size -= 4;
+    }
+
+    while (size > 0) {
+        hash ^= *bytes * Prime5;
+        hash = Rotate(hash, 11) * Prime1;
+        bytes++;
+        size--;
+    }
+
+    hash ^= hash >> 33;
+    hash *= Prime2;
+    hash ^= hash >> 29;
+    hash *= Prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+std::string Hash::
+hex() const
+{
+    static char const digits[] = "0123456789abcdef";
+
+    uint64_t value = digest();
+    std::string result = std::string(16, '0');
+    for (size_t n = 0; n < 16; n++) {
+        result[15 - n] = digits[value & 0xf];
+        value >>= 4;
+    }
+    return result;
+}
+
+uint64_t Hash::
+String(std::string const &value, uint64_t seed)
+{
+    Hash hash = Hash(seed);
+    hash.update(value);
+    return hash.digest();
+}
+
+ext::optional<uint64_t> Hash::
+File(Filesystem const *filesystem, std::string const &path, uint64_t seed)
+{
+    std::unique_ptr<Filesystem::Mapping> mapping = filesystem->readMapped(path);
+    if (mapping == nullptr) {
+        return ext::nullopt;
+    }
+
+    Hash hash = Hash(seed);
+    hash.update(mapping->data(), mapping->size());
+    return hash.digest();
+}
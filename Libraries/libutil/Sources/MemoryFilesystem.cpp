@@ -19,23 +19,30 @@ using libutil::FSUtil;
 
 MemoryFilesystem::Entry::
 Entry(std::string const &name, Type type) :
-    _name(name),
-    _type(type)
+    _name            (name),
+    _type            (type),
+    _contents        (std::make_shared<std::vector<uint8_t> const>()),
+    _modificationTime(0)
 {
 }
 
+void MemoryFilesystem::Entry::
+setContents(std::vector<uint8_t> const &contents)
+{
+    _contents = std::make_shared<std::vector<uint8_t> const>(contents);
+}
+
 MemoryFilesystem::Entry *MemoryFilesystem::Entry::
 child(std::string const &name)
 {
     assert(_type == MemoryFilesystem::Entry::Type::Directory);
 
-    for (MemoryFilesystem::Entry &entry : _children) {
-        if (entry.name() == name) {
-            return &entry;
-        }
+    auto it = _childIndexes.find(name);
+    if (it == _childIndexes.end()) {
+        return nullptr;
     }
 
-    return nullptr;
+    return &_children[it->second];
 }
 
 MemoryFilesystem::Entry const *MemoryFilesystem::Entry::
@@ -43,20 +50,50 @@ child(std::string const &name) const
 {
     assert(_type == MemoryFilesystem::Entry::Type::Directory);
 
-    for (MemoryFilesystem::Entry const &entry : _children) {
-        if (entry.name() == name) {
-            return &entry;
-        }
+    auto it = _childIndexes.find(name);
+    if (it == _childIndexes.end()) {
+        return nullptr;
     }
 
-    return nullptr;
+    return &_children[it->second];
+}
+
+MemoryFilesystem::Entry *MemoryFilesystem::Entry::
+addChild(Entry &&entry)
+{
+    assert(_type == MemoryFilesystem::Entry::Type::Directory);
+    assert(_childIndexes.find(entry.name()) == _childIndexes.end());
+
+    _childIndexes.insert({ entry.name(), _children.size() });
+    _children.emplace_back(std::move(entry));
+    return &_children.back();
+}
+
+void MemoryFilesystem::Entry::
+removeChild(std::string const &name)
+{
+    auto it = _childIndexes.find(name);
+    if (it == _childIndexes.end()) {
+        return;
+    }
+
+    /* Keep the order of the remaining children. */
+    size_t index = it->second;
+    _childIndexes.erase(it);
+    _children.erase(_children.begin() + index);
+
+    for (auto &entry : _childIndexes) {
+        if (entry.second > index) {
+            entry.second--;
+        }
+    }
 }
 
 MemoryFilesystem::Entry MemoryFilesystem::Entry::
 File(std::string const &name, std::vector<uint8_t> const &contents)
 {
     MemoryFilesystem::Entry entry = MemoryFilesystem::Entry(name, MemoryFilesystem::Entry::Type::File);
-    entry.contents() = contents;
+    entry.setContents(contents);
     return entry;
 }
 
@@ -64,13 +101,16 @@ MemoryFilesystem::Entry MemoryFilesystem::Entry::
 Directory(std::string const &name, std::vector<Entry> const &children)
 {
     MemoryFilesystem::Entry entry = MemoryFilesystem::Entry(name, MemoryFilesystem::Entry::Type::Directory);
-    entry.children() = children;
+    for (Entry const &child : children) {
+        entry.addChild(Entry(child));
+    }
     return entry;
 }
 
 MemoryFilesystem::
 MemoryFilesystem(std::vector<MemoryFilesystem::Entry> const &entries) :
-    _root(MemoryFilesystem::Entry::Directory("/", entries))
+    _root(MemoryFilesystem::Entry::Directory("/", entries)),
+    _time(0)
 {
 }
 
@@ -95,6 +135,7 @@ WalkPath(
     T *current = &filesystem->root();
     assert(current->type() == MemoryFilesystem::Entry::Type::Directory);
 
+    std::string name;
     std::string::size_type start = 0;
     std::string::size_type end = normalized.find('/', start);
 
@@ -102,7 +143,7 @@ WalkPath(
         bool final = (end == std::string::npos);
 
         T *next = current;
-        std::string name = normalized.substr(start, end - start);
+        name.assign(normalized, start, end == std::string::npos ? std::string::npos : end - start);
         if (!name.empty()) {
             /* Get the next path component. */
             next = current->child(name);
@@ -176,10 +217,45 @@ isExecutable(std::string const &path) const
     return this->exists(path);
 }
 
+ext::optional<uint64_t> MemoryFilesystem::
+modificationTime(std::string const &path) const
+{
+    ext::optional<uint64_t> time;
+    WalkPath<MemoryFilesystem::Entry const>(this, path, false, [&](MemoryFilesystem::Entry const *parent, std::string const &name, MemoryFilesystem::Entry const *entry) {
+        if (entry != nullptr) {
+            time = entry->modificationTime();
+        }
+        return entry;
+    });
+    return time;
+}
+
+ext::optional<MemoryFilesystem::Metadata> MemoryFilesystem::
+metadata(std::string const &path) const
+{
+    ext::optional<Metadata> metadata;
+    WalkPath<MemoryFilesystem::Entry const>(this, path, false, [&](MemoryFilesystem::Entry const *parent, std::string const &name, MemoryFilesystem::Entry const *entry) {
+        if (entry != nullptr) {
+            Metadata result;
+            result.directory = (entry->type() == MemoryFilesystem::Entry::Type::Directory);
+            result.symbolicLink = false;
+            result.readable = true;
+            result.writable = true;
+            result.executable = true;
+            result.size = entry->contents().size();
+            result.modificationTime = entry->modificationTime();
+            result.inode = 0;
+            metadata = result;
+        }
+        return entry;
+    });
+    return metadata;
+}
+
 bool MemoryFilesystem::
 createFile(std::string const &path)
 {
-    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
+    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [this](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr) {
             if (entry->type() == MemoryFilesystem::Entry::Type::File) {
                 /* Exists as a file. */
@@ -191,9 +267,8 @@ createFile(std::string const &path)
         } else {
             /* Add empty file. */
             MemoryFilesystem::Entry file = MemoryFilesystem::Entry::File(name, std::vector<uint8_t>());
-            std::vector<MemoryFilesystem::Entry> *children = &parent->children();
-            children->emplace_back(std::move(file));
-            return &children->back();
+            file.modificationTime() = tick();
+            return parent->addChild(std::move(file));
         }
     });
 }
@@ -201,7 +276,7 @@ createFile(std::string const &path)
 bool MemoryFilesystem::
 createDirectory(std::string const &path)
 {
-    return WalkPath<MemoryFilesystem::Entry>(this, path, true, [](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
+    return WalkPath<MemoryFilesystem::Entry>(this, path, true, [this](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr) {
             if (entry->type() == MemoryFilesystem::Entry::Type::Directory) {
                 /* Intermediate directory already exists. */
@@ -213,13 +288,23 @@ createDirectory(std::string const &path)
         } else {
             /* Add intermediate directory. */
             MemoryFilesystem::Entry directory = MemoryFilesystem::Entry::Directory(name, { });
-            std::vector<MemoryFilesystem::Entry> *children = &parent->children();
-            children->emplace_back(std::move(directory));
-            return &children->back();
+            directory.modificationTime() = tick();
+            return parent->addChild(std::move(directory));
         }
     });
 }
 
+bool MemoryFilesystem::
+touch(std::string const &path)
+{
+    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [this](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
+        if (entry != nullptr) {
+            entry->modificationTime() = tick();
+        }
+        return entry;
+    });
+}
+
 bool MemoryFilesystem::
 read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext::optional<size_t> length) const
 {
@@ -240,6 +325,25 @@ read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext
     });
 }
 
+std::unique_ptr<libutil::Filesystem::Mapping> MemoryFilesystem::
+readMapped(std::string const &path) const
+{
+    std::unique_ptr<Mapping> mapping;
+
+    WalkPath<MemoryFilesystem::Entry const>(this, path, false, [&](MemoryFilesystem::Entry const *parent, std::string const &name, MemoryFilesystem::Entry const *entry) -> MemoryFilesystem::Entry const * {
+        if (entry == nullptr || entry->type() != MemoryFilesystem::Entry::Type::File) {
+            return nullptr;
+        }
+
+        /* Contents are immutable, so holding them keeps the view valid. */
+        std::shared_ptr<std::vector<uint8_t> const> contents = entry->sharedContents();
+        mapping.reset(new Mapping(contents->data(), contents->size(), [contents] { }));
+        return entry;
+    });
+
+    return mapping;
+}
+
 bool MemoryFilesystem::
 write(std::vector<uint8_t> const &contents, std::string const &path)
 {
@@ -247,7 +351,8 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
         if (entry != nullptr) {
             if (entry->type() == MemoryFilesystem::Entry::Type::File) {
                 /* Exists as a file, replace contents. */
-                entry->contents() = contents;
+                entry->setContents(contents);
+                entry->modificationTime() = tick();
                 return entry;
             } else {
                 /* Exists already, but not as a file. */
@@ -256,9 +361,8 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
         } else {
             /* Add file. */
             MemoryFilesystem::Entry file = MemoryFilesystem::Entry::File(name, contents);
-            std::vector<MemoryFilesystem::Entry> *children = &parent->children();
-            children->emplace_back(std::move(file));
-            return &children->back();
+            file.modificationTime() = tick();
+            return parent->addChild(std::move(file));
         }
     });
 }
@@ -282,10 +386,7 @@ removeFile(std::string const &path)
         if (entry != nullptr) {
             if (entry->type() == MemoryFilesystem::Entry::Type::File) {
                 /* Found, remove it. */
-                std::vector<MemoryFilesystem::Entry> *children = &parent->children();
-                children->erase(std::remove_if(children->begin(), children->end(), [&](MemoryFilesystem::Entry const &entry) {
-                    return (entry.name() == name);
-                }), children->end());
+                parent->removeChild(name);
                 return parent;
             } else {
                 /* Can't remove directories. */
@@ -332,3 +433,20 @@ enumerateDirectory(
     });
 }
 
+bool MemoryFilesystem::
+enumerateDirectoryEntries(
+    std::string const &path,
+    std::function<void(std::string const &, bool)> const &cb) const
+{
+    return WalkPath<MemoryFilesystem::Entry const>(this, path, false, [&](MemoryFilesystem::Entry const *parent, std::string const &name, MemoryFilesystem::Entry const *entry) -> MemoryFilesystem::Entry const * {
+        if (entry == nullptr || entry->type() != MemoryFilesystem::Entry::Type::Directory) {
+            return nullptr;
+        }
+
+        for (MemoryFilesystem::Entry const &child : entry->children()) {
+            cb(child.name(), child.type() == MemoryFilesystem::Entry::Type::Directory);
+        }
+        return entry;
+    });
+}
+
@@ -0,0 +1,245 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <pthread.h>
+
+using libutil::Parallel;
+
+namespace {
+
+/*
+ * A parallel loop being run. Threads join it to claim and run indexes
+ * until none are left, and the thread that started it waits for all of
+ * them to leave before it returns.
+ */
+struct Job {
+    std::function<void(size_t)> const *function;
+    size_t                              count;
+    std::atomic<size_t>                 next;
+    size_t                              participants;
+
+    Job(std::function<void(size_t)> const *function, size_t count) :
+        function    (function),
+        count       (count),
+        next        (0),
+        participants(1)
+    {
+    }
+
+    bool exhausted() const
+    { return next.load() >= count; }
+
+    void run()
+    {
+        for (size_t index = next++; index < count; index = next++) {
+            (*function)(index);
+        }
+    }
+};
+
+/*
+ * The threads and queued jobs shared by the process. Worker threads are
+ * started as they're first needed, and never stopped.
+ */
+struct Pool {
+    std::mutex               mutex;
+    std::condition_variable  changed;
+    std::vector<Job *>       jobs;
+    size_t                   threads;
+    size_t                   working;
+    size_t                   concurrency;
+
+    explicit Pool(size_t concurrency) :
+        threads    (0),
+        working    (0),
+        concurrency(concurrency)
+    {
+    }
+
+    /*
+     * Join the most recently queued job with indexes left, if any. The
+     * newest job is likely the one others are waiting on. Requires the lock.
+     */
+    Job *join()
+    {
+        for (auto it = jobs.rbegin(); it != jobs.rend(); ++it) {
+            if (!(*it)->exhausted()) {
+                (*it)->participants++;
+                return *it;
+            }
+        }
+        return nullptr;
+    }
+
+    /*
+     * Leave a joined job once it's out of indexes. Requires the lock.
+     */
+    void leave(Job *job)
+    {
+        job->participants--;
+        changed.notify_all();
+    }
+
+    /*
+     * Start enough worker threads to reach the concurrency, counting the
+     * calling thread. Requires the lock.
+     */
+    void start()
+    {
+        while (threads + 1 < concurrency) {
+            std::thread(&Pool::work, this).detach();
+            threads++;
+        }
+    }
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            /* Fewer workers run at once if the concurrency was lowered. */
+            Job *job = (working + 1 < concurrency ? join() : nullptr);
+            if (job == nullptr) {
+                changed.wait(lock);
+                continue;
+            }
+
+            working++;
+            lock.unlock();
+            job->run();
+            lock.lock();
+            working--;
+
+            leave(job);
+        }
+    }
+};
+
+}
+
+static Pool *SharedPool = nullptr;
+
+/*
+ * A forked child has only the thread that forked, and the pool's lock may
+ * have been held by another. Give it a pool of its own.
+ */
+static void
+ResetAfterFork()
+{
+    SharedPool = new Pool(SharedPool->concurrency);
+}
+
+static Pool &
+Shared()
+{
+    static std::once_flag once;
+    std::call_once(once, []() {
+        SharedPool = new Pool(std::max(std::thread::hardware_concurrency(), 1u));
+        ::pthread_atfork(nullptr, nullptr, &ResetAfterFork);
+    });
+    return *SharedPool;
+}
+
+Parallel::Group::
+Group()
+{
+}
+
+Parallel::Group::
+~Group()
+{
+}
+
+void Parallel::Group::
+add(std::function<void()> const &task)
+{
+    _tasks.push_back(task);
+}
+
+void Parallel::Group::
+wait()
+{
+    std::vector<std::function<void()>> tasks;
+    tasks.swap(_tasks);
+
+    Parallel::For(tasks.size(), [&](size_t index) {
+        tasks[index]();
+    });
+}
+
+size_t Parallel::
+Concurrency()
+{
+    Pool &pool = Shared();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return pool.concurrency;
+}
+
+void Parallel::
+SetConcurrency(size_t concurrency)
+{
+    Pool &pool = Shared();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.concurrency = std::max<size_t>(concurrency, 1);
+}
+
+void Parallel::
+For(size_t count, std::function<void(size_t)> const &function)
+{
+    Pool &pool = Shared();
+
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    if (count <= 1 || pool.concurrency <= 1) {
+        lock.unlock();
+        for (size_t index = 0; index < count; ++index) {
+            function(index);
+        }
+        return;
+    }
+
+    /*
+     * Queue the loop for other threads to join, then run it here too.
+     */
+    Job job(&function, count);
+    pool.start();
+    pool.jobs.push_back(&job);
+    pool.changed.notify_all();
+
+    lock.unlock();
+    job.run();
+    lock.lock();
+
+    pool.jobs.erase(std::find(pool.jobs.begin(), pool.jobs.end(), &job));
+    job.participants--;
+
+    /*
+     * Help run other queued work until the threads still running
+     * indexes of this loop are done with them.
+     */
+    while (job.participants > 0) {
+        Job *other = pool.join();
+        if (other == nullptr) {
+            pool.changed.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        other->run();
+        lock.lock();
+
+        pool.leave(other);
+    }
+}
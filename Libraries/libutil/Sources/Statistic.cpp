@@ -0,0 +1,200 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/Statistic.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include <cstdio>
+#include <cstring>
+
+#include <sys/resource.h>
+
+using libutil::Statistic;
+
+static std::atomic<bool> StatisticsEnabled(false);
+static std::atomic<uint64_t> Allocations(0);
+static std::atomic<uint64_t> AllocatedBytes(0);
+
+/*
+ * Statistics register themselves during static initialization, possibly
+ * before any other global here is constructed, so these are created on use.
+ */
+static std::mutex &
+RegisteredMutex()
+{
+    static std::mutex *mutex = new std::mutex();
+    return *mutex;
+}
+
+static std::vector<Statistic const *> &
+Registered()
+{
+    static std::vector<Statistic const *> *registered = new std::vector<Statistic const *>();
+    return *registered;
+}
+
+Statistic::Timer::
+Timer(Statistic *statistic) :
+    _statistic     (Statistic::Enabled() ? statistic : nullptr),
+    _allocations   (0),
+    _allocatedBytes(0)
+{
+    if (_statistic != nullptr) {
+        _allocations = Allocations.load(std::memory_order_relaxed);
+        _allocatedBytes = AllocatedBytes.load(std::memory_order_relaxed);
+        _start = std::chrono::steady_clock::now();
+    }
+}
+
+Statistic::Timer::
+~Timer()
+{
+    if (_statistic != nullptr) {
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start);
+        _statistic->_count.fetch_add(1, std::memory_order_relaxed);
+        _statistic->_nanoseconds.fetch_add(static_cast<uint64_t>(duration.count()), std::memory_order_relaxed);
+        _statistic->_allocations.fetch_add(Allocations.load(std::memory_order_relaxed) - _allocations, std::memory_order_relaxed);
+        _statistic->_allocatedBytes.fetch_add(AllocatedBytes.load(std::memory_order_relaxed) - _allocatedBytes, std::memory_order_relaxed);
+        _statistic->_timed.store(true, std::memory_order_relaxed);
+
+        /* The peak only grows, so the latest is the largest. */
+        uint64_t peak = Statistic::PeakResidentBytes();
+        uint64_t previous = _statistic->_peakResidentBytes.load(std::memory_order_relaxed);
+        while (previous < peak && !_statistic->_peakResidentBytes.compare_exchange_weak(previous, peak, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+Statistic::
+Statistic(char const *group, char const *name, Statistic const *total) :
+    _group            (group),
+    _name             (name),
+    _total            (total),
+    _count            (0),
+    _nanoseconds      (0),
+    _allocations      (0),
+    _allocatedBytes   (0),
+    _peakResidentBytes(0),
+    _timed            (false)
+{
+    std::lock_guard<std::mutex> lock(RegisteredMutex());
+    Registered().push_back(this);
+}
+
+Statistic::
+~Statistic()
+{
+    std::lock_guard<std::mutex> lock(RegisteredMutex());
+    std::vector<Statistic const *> &registered = Registered();
+    registered.erase(std::remove(registered.begin(), registered.end(), this), registered.end());
+}
+
+void Statistic::
+Enable()
+{
+    StatisticsEnabled.store(true, std::memory_order_relaxed);
+}
+
+bool Statistic::
+Enabled()
+{
+    return StatisticsEnabled.load(std::memory_order_relaxed);
+}
+
+void Statistic::
+Allocated(size_t bytes)
+{
+    if (StatisticsEnabled.load(std::memory_order_relaxed)) {
+        Allocations.fetch_add(1, std::memory_order_relaxed);
+        AllocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+uint64_t Statistic::
+PeakResidentBytes()
+{
+    struct rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+
+#if defined(__APPLE__)
+    /* Reported in bytes. */
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    /* Reported in kilobytes. */
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+static std::string
+Megabytes(uint64_t bytes)
+{
+    char megabytes[32];
+    ::snprintf(megabytes, sizeof(megabytes), "%.1f MB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+    return megabytes;
+}
+
+std::string Statistic::
+Summary()
+{
+    std::vector<Statistic const *> statistics;
+    {
+        std::lock_guard<std::mutex> lock(RegisteredMutex());
+        for (Statistic const *statistic : Registered()) {
+            if (statistic->count() > 0) {
+                statistics.push_back(statistic);
+            }
+        }
+    }
+
+    std::sort(statistics.begin(), statistics.end(), [](Statistic const *a, Statistic const *b) {
+        int group = ::strcmp(a->_group, b->_group);
+        return (group != 0 ? group < 0 : ::strcmp(a->_name, b->_name) < 0);
+    });
+
+    std::string summary;
+    char line[256];
+
+    /* Without the allocation hooks, there are no allocations to show. */
+    bool allocations = (Allocations.load(std::memory_order_relaxed) > 0);
+
+    ::snprintf(line, sizeof(line), "%-14s %-44s %10s %12s %10s %12s %12s\n", "Group", "Statistic", "Count", "Time/Rate", "Allocs", "Allocated", "Peak RSS");
+    summary += line;
+
+    for (Statistic const *statistic : statistics) {
+        std::string time;
+        std::string count;
+        std::string allocated;
+        std::string peak;
+        if (statistic->_timed.load(std::memory_order_relaxed)) {
+            char milliseconds[32];
+            ::snprintf(milliseconds, sizeof(milliseconds), "%.1f ms", static_cast<double>(statistic->nanoseconds()) / 1000000.0);
+            time = milliseconds;
+
+            if (allocations) {
+                count = std::to_string(statistic->allocations());
+                allocated = Megabytes(statistic->allocatedBytes());
+            }
+            peak = Megabytes(statistic->peakResidentBytes());
+        } else if (statistic->_total != nullptr && statistic->_total->count() > 0) {
+            char percent[32];
+            ::snprintf(percent, sizeof(percent), "%.1f%%", 100.0 * static_cast<double>(statistic->count()) / static_cast<double>(statistic->_total->count()));
+            time = percent;
+        }
+
+        ::snprintf(line, sizeof(line), "%-14s %-44s %10llu %12s %10s %12s %12s\n", statistic->_group, statistic->_name, static_cast<unsigned long long>(statistic->count()), time.c_str(), count.c_str(), allocated.c_str(), peak.c_str());
+        summary += line;
+    }
+
+    return summary;
+}
@@ -43,3 +43,156 @@ Match(std::string const &pattern, std::string const &string)
     return (sit == string.end());
 }
 
+Wildcard::Pattern::
+Pattern(std::string const &pattern) :
+    _pattern(pattern),
+    _literal(true)
+{
+    for (std::string::const_iterator fit = pattern.begin(); fit != pattern.end(); ++fit) {
+        std::string::const_iterator fend;
+        if (*fit == '*') {
+            _literal = false;
+
+            /* The character after the star is always literal. */
+            if (++fit == pattern.end()) {
+                _tokens.push_back({ Token::Type::StarEnd, std::string() });
+                break;
+            }
+
+            _tokens.push_back({ Token::Type::Star, std::string(1, *fit) });
+        } else if (*fit == '[' && (fend = std::find(fit, pattern.end(), ']')) != pattern.end()) {
+            _literal = false;
+            _tokens.push_back({ Token::Type::Set, std::string(std::next(fit), fend) });
+            fit = fend;
+        } else if (!_tokens.empty() && _tokens.back().type == Token::Type::Literal) {
+            _tokens.back().text.push_back(*fit);
+        } else {
+            _tokens.push_back({ Token::Type::Literal, std::string(1, *fit) });
+        }
+    }
+}
+
+bool Wildcard::Pattern::
+match(std::string const &string) const
+{
+    if (_literal) {
+        return string == _pattern;
+    }
+
+    size_t position = 0;
+    for (Token const &token : _tokens) {
+        switch (token.type) {
+            case Token::Type::Literal:
+                if (string.size() - position < token.text.size() || string.compare(position, token.text.size(), token.text) != 0) {
+                    return false;
+                }
+                position += token.text.size();
+                break;
+            case Token::Type::Set:
+                if (position == string.size() || token.text.find(string[position]) == std::string::npos) {
+                    return false;
+                }
+                position++;
+                break;
+            case Token::Type::Star: {
+                if (position == string.size()) {
+                    return true;
+                }
+
+                size_t found = string.find(token.text[0], position);
+                if (found == std::string::npos) {
+                    return false;
+                }
+                position = found + 1;
+                break;
+            }
+            case Token::Type::StarEnd:
+                return true;
+        }
+    }
+
+    return (position == string.size());
+}
+
+Wildcard::PatternSet::
+PatternSet()
+{
+}
+
+Wildcard::PatternSet::
+PatternSet(std::vector<std::string> const &patterns)
+{
+    _patterns.reserve(patterns.size());
+
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        _patterns.emplace_back(patterns[i]);
+        std::vector<Pattern::Token> const &tokens = _patterns.back().tokens();
+
+        /* Earlier patterns take precedence, so only keep the first of each. */
+        if (tokens.empty() || (tokens.size() == 1 && tokens[0].type == Pattern::Token::Type::Literal)) {
+            _literals.insert({ patterns[i], i });
+        } else if (tokens[0].type == Pattern::Token::Type::Star || tokens[0].type == Pattern::Token::Type::StarEnd) {
+            /* A leading star matches an empty string, whatever follows. */
+            if (!_firstStar) {
+                _firstStar = i;
+            }
+
+            if (tokens[0].type == Pattern::Token::Type::StarEnd) {
+                _others.push_back(i);
+            } else if (tokens.size() == 1) {
+                _suffixes[tokens[0].text[0]].insert({ std::string(), i });
+            } else if (tokens.size() == 2 && tokens[1].type == Pattern::Token::Type::Literal) {
+                _suffixes[tokens[0].text[0]].insert({ tokens[1].text, i });
+            } else {
+                _others.push_back(i);
+            }
+        } else {
+            _others.push_back(i);
+        }
+    }
+}
+
+ext::optional<size_t> Wildcard::PatternSet::
+match(std::string const &string) const
+{
+    size_t index = _patterns.size();
+
+    auto LI = _literals.find(string);
+    if (LI != _literals.end()) {
+        index = LI->second;
+    }
+
+    if (string.empty()) {
+        if (_firstStar) {
+            index = std::min(index, *_firstStar);
+        }
+    } else {
+        /* A leading star skips to the first occurrence of its character. */
+        for (auto const &entry : _suffixes) {
+            std::string::size_type found = string.find(entry.first);
+            if (found != std::string::npos) {
+                auto SI = entry.second.find(string.substr(found + 1));
+                if (SI != entry.second.end()) {
+                    index = std::min(index, SI->second);
+                }
+            }
+        }
+    }
+
+    for (size_t other : _others) {
+        if (other >= index) {
+            break;
+        }
+
+        if (_patterns[other].match(string)) {
+            index = other;
+            break;
+        }
+    }
+
+    if (index == _patterns.size()) {
+        return ext::nullopt;
+    }
+
+    return index;
+}
@@ -0,0 +1,69 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/CachedFilesystem.h>
+#include <libutil/MemoryFilesystem.h>
+
+using libutil::CachedFilesystem;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+TEST(CachedFilesystem, Metadata)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("file", Contents("contents")),
+        MemoryFilesystem::Entry::Directory("dir", { }),
+    });
+    CachedFilesystem cached(&filesystem);
+
+    ext::optional<CachedFilesystem::Metadata> file = cached.metadata("/file");
+    ASSERT_TRUE(file);
+    EXPECT_FALSE(file->directory);
+    EXPECT_EQ(8u, file->size);
+    EXPECT_EQ(filesystem.modificationTime("/file"), cached.modificationTime("/file"));
+
+    EXPECT_TRUE(cached.isDirectory("/dir"));
+    EXPECT_FALSE(cached.exists("/missing"));
+}
+
+TEST(CachedFilesystem, Invalidate)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("file", Contents("contents")),
+    });
+    CachedFilesystem cached(&filesystem);
+
+    /* Changes made elsewhere aren't seen. */
+    EXPECT_FALSE(cached.exists("/new"));
+    ASSERT_TRUE(filesystem.write(Contents("new"), "/new"));
+    EXPECT_FALSE(cached.exists("/new"));
+
+    /* Until the cache is cleared. */
+    cached.invalidate();
+    EXPECT_TRUE(cached.exists("/new"));
+
+    /* Changes made through the cache are. */
+    EXPECT_FALSE(cached.exists("/dir/nested"));
+    EXPECT_FALSE(cached.exists("/dir"));
+    ASSERT_TRUE(cached.createDirectory("/dir/nested"));
+    EXPECT_TRUE(cached.isDirectory("/dir/nested"));
+    EXPECT_TRUE(cached.isDirectory("/dir"));
+
+    ASSERT_TRUE(cached.write(Contents("longer contents"), "/file"));
+    EXPECT_EQ(15u, cached.metadata("/file")->size);
+
+    ASSERT_TRUE(cached.removeFile("/file"));
+    EXPECT_FALSE(cached.exists("/file"));
+}
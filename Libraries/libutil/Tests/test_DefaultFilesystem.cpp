@@ -0,0 +1,127 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/DefaultFilesystem.h>
+
+#include <cstdlib>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+using libutil::DefaultFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+/*
+ * A directory for the test's files, removed when the test finishes.
+ */
+class TemporaryDirectory {
+private:
+    std::string _path;
+
+public:
+    TemporaryDirectory()
+    {
+        char path[] = "/tmp/test_DefaultFilesystem.XXXXXX";
+        _path = ::mkdtemp(path);
+    }
+
+    ~TemporaryDirectory()
+    {
+        std::string command = "rm -rf '" + _path + "'";
+        EXPECT_EQ(0, ::system(command.c_str()));
+    }
+
+public:
+    std::string const &path() const
+    { return _path; }
+};
+
+TEST(DefaultFilesystem, Batch)
+{
+    TemporaryDirectory directory;
+    DefaultFilesystem filesystem;
+
+    /* More files than are handled at once, of several sizes. */
+    std::vector<std::vector<uint8_t>> contents;
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < 300; i++) {
+        contents.push_back(std::vector<uint8_t>(i * 97, static_cast<uint8_t>(i)));
+        paths.push_back(directory.path() + "/file" + std::to_string(i));
+    }
+
+    std::vector<bool> written = filesystem.writeAtomicBatch(contents, paths);
+    EXPECT_EQ(std::vector<bool>(paths.size(), true), written);
+
+    /* Missing files fail without failing the others. */
+    std::vector<std::string> readPaths = { paths[0], directory.path() + "/missing", paths[299], directory.path() };
+    std::vector<std::vector<uint8_t>> read;
+    EXPECT_EQ(std::vector<bool>({ true, false, true, false }), filesystem.readBatch(&read, readPaths));
+    ASSERT_EQ(4u, read.size());
+    EXPECT_EQ(contents[0], read[0]);
+    EXPECT_EQ(contents[299], read[2]);
+
+    read.clear();
+    EXPECT_EQ(std::vector<bool>(paths.size(), true), filesystem.readBatch(&read, paths));
+    EXPECT_EQ(contents, read);
+
+    /* Nothing is left behind from writing atomically. */
+    size_t count = 0;
+    EXPECT_TRUE(filesystem.enumerateDirectory(directory.path(), [&](std::string const &name) {
+        count++;
+    }));
+    EXPECT_EQ(paths.size(), count);
+}
+
+TEST(DefaultFilesystem, WriteIfChangedBatch)
+{
+    TemporaryDirectory directory;
+    DefaultFilesystem filesystem;
+
+    std::string same = directory.path() + "/same";
+    std::string changed = directory.path() + "/changed";
+    std::string created = directory.path() + "/created";
+    ASSERT_TRUE(filesystem.write(Contents("same"), same));
+    ASSERT_TRUE(filesystem.write(Contents("before"), changed));
+
+    /* Replacing a file keeps its permissions. */
+    ASSERT_EQ(0, ::chmod(changed.c_str(), 0755));
+
+    /* Compare by inode: only changed files are replaced. */
+    struct stat sameBefore;
+    ASSERT_EQ(0, ::stat(same.c_str(), &sameBefore));
+
+    std::vector<bool> written = filesystem.writeIfChangedBatch(
+        { Contents("same"), Contents("after!"), Contents("new") },
+        { same, changed, created });
+    EXPECT_EQ(std::vector<bool>({ true, true, true }), written);
+
+    struct stat sameAfter;
+    ASSERT_EQ(0, ::stat(same.c_str(), &sameAfter));
+    EXPECT_EQ(sameBefore.st_ino, sameAfter.st_ino);
+
+    std::vector<uint8_t> contents;
+    ASSERT_TRUE(filesystem.read(&contents, changed));
+    EXPECT_EQ(Contents("after!"), contents);
+    ASSERT_TRUE(filesystem.read(&contents, created));
+    EXPECT_EQ(Contents("new"), contents);
+
+    struct stat changedAfter;
+    ASSERT_EQ(0, ::stat(changed.c_str(), &changedAfter));
+    EXPECT_EQ(0755, changedAfter.st_mode & 07777);
+
+    /* Files in missing directories fail. */
+    written = filesystem.writeAtomicBatch({ Contents("a"), Contents("b") }, { directory.path() + "/missing/a", directory.path() + "/b" });
+    EXPECT_EQ(std::vector<bool>({ false, true }), written);
+}
@@ -26,6 +26,15 @@ TEST(Escape, Shell)
     EXPECT_EQ(Escape::Shell("'"), "''\\'''");
 }
 
+TEST(Escape, ShellAppend)
+{
+    std::string result = "exec";
+    Escape::Shell("plain", &result);
+    Escape::Shell("sp ace", &result);
+    Escape::Shell("", &result);
+    EXPECT_EQ(result, "execplain'sp ace'");
+}
+
 TEST(Escape, Makefile)
 {
     EXPECT_EQ(Escape::Makefile(""), "");
@@ -18,6 +18,10 @@ TEST(FSUtil, GetDirectoryName)
     EXPECT_EQ("", FSUtil::GetDirectoryName("a"));
     EXPECT_EQ("/a", FSUtil::GetDirectoryName("/a/b"));
     EXPECT_EQ("/a/b", FSUtil::GetDirectoryName("/a/b/c"));
+    EXPECT_EQ("/a", FSUtil::GetDirectoryName("/a/b/"));
+    EXPECT_EQ("/", FSUtil::GetDirectoryName("/a"));
+    EXPECT_EQ("/", FSUtil::GetDirectoryName("/"));
+    EXPECT_EQ(".", FSUtil::GetDirectoryName("a/"));
 }
 
 TEST(FSUtil, GetBaseName)
@@ -28,6 +32,8 @@ TEST(FSUtil, GetBaseName)
     EXPECT_EQ("b", FSUtil::GetBaseName("/a/b"));
     EXPECT_EQ("c", FSUtil::GetBaseName("/a/b/c"));
     EXPECT_EQ("c.ext", FSUtil::GetBaseName("/a/b/c.ext"));
+    EXPECT_EQ("b", FSUtil::GetBaseName("/a/b/"));
+    EXPECT_EQ("/", FSUtil::GetBaseName("/"));
 }
 
 TEST(FSUtil, GetBaseNameWithoutExtension)
@@ -0,0 +1,58 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/Hash.h>
+#include <libutil/MemoryFilesystem.h>
+
+using libutil::Hash;
+using libutil::MemoryFilesystem;
+
+TEST(Hash, Known)
+{
+    EXPECT_EQ(0xEF46DB3751D8E999ULL, Hash::String(""));
+    EXPECT_EQ(0xD24EC4F1A98C6E5BULL, Hash::String("a"));
+    EXPECT_EQ(0x44BC2CF5AD770999ULL, Hash::String("abc"));
+
+    Hash hash;
+    EXPECT_EQ("ef46db3751d8e999", hash.hex());
+}
+
+TEST(Hash, Pieces)
+{
+    std::string input;
+    for (size_t n = 0; n < 200; n++) {
+        input.push_back(static_cast<char>(n * 7 + 3));
+    }
+
+    for (size_t size = 0; size <= input.size(); size += 13) {
+        std::string prefix = input.substr(0, size);
+        uint64_t expected = Hash::String(prefix, 42);
+
+        for (size_t split = 1; split < 40; split += 5) {
+            Hash hash = Hash(42);
+            for (size_t offset = 0; offset < prefix.size(); offset += split) {
+                hash.update(prefix.substr(offset, split));
+            }
+            EXPECT_EQ(expected, hash.digest());
+        }
+    }
+
+    EXPECT_NE(Hash::String(input, 0), Hash::String(input, 1));
+}
+
+TEST(Hash, File)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("file", std::vector<uint8_t>({ 'a', 'b', 'c' })),
+    });
+
+    EXPECT_EQ(Hash::String("abc"), *Hash::File(&filesystem, "/file"));
+    EXPECT_FALSE(Hash::File(&filesystem, "/missing"));
+}
@@ -0,0 +1,100 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/LRUCache.h>
+
+#include <string>
+
+using libutil::LRUCache;
+
+TEST(LRUCache, Lookup)
+{
+    LRUCache<std::string, int> cache = LRUCache<std::string, int>(0);
+    EXPECT_EQ(nullptr, cache.find("a"));
+
+    EXPECT_EQ(1, cache.insert("a", 1));
+    EXPECT_EQ(2, cache.insert("b", 2));
+    ASSERT_NE(nullptr, cache.find("a"));
+    EXPECT_EQ(1, *cache.find("a"));
+    EXPECT_EQ(2, *cache.find("b"));
+    EXPECT_EQ(nullptr, cache.find("c"));
+
+    /* The first value added for a key is kept. */
+    EXPECT_EQ(1, cache.insert("a", 3));
+    EXPECT_EQ(1, *cache.find("a"));
+    EXPECT_EQ(2, cache.size());
+}
+
+TEST(LRUCache, Unbounded)
+{
+    LRUCache<int, int> cache = LRUCache<int, int>(0);
+    for (int n = 0; n < 1000; ++n) {
+        cache.insert(n, n * 2);
+    }
+
+    EXPECT_EQ(1000, cache.size());
+    EXPECT_EQ(0, cache.evictions());
+    EXPECT_EQ(0, *cache.find(0));
+    EXPECT_EQ(1998, *cache.find(999));
+}
+
+TEST(LRUCache, Eviction)
+{
+    LRUCache<std::string, int> cache = LRUCache<std::string, int>(2);
+    cache.insert("a", 1);
+    cache.insert("b", 2);
+
+    /* Past the capacity, the least recently added is dropped. */
+    EXPECT_EQ(3, cache.insert("c", 3));
+    EXPECT_EQ(2, cache.size());
+    EXPECT_EQ(1, cache.evictions());
+    EXPECT_EQ(nullptr, cache.find("a"));
+    EXPECT_NE(nullptr, cache.find("b"));
+    EXPECT_NE(nullptr, cache.find("c"));
+}
+
+TEST(LRUCache, EvictionOrder)
+{
+    LRUCache<std::string, int> cache = LRUCache<std::string, int>(2);
+    cache.insert("a", 1);
+    cache.insert("b", 2);
+
+    /* Finding a value marks it as used, so the other is dropped. */
+    ASSERT_NE(nullptr, cache.find("a"));
+    cache.insert("c", 3);
+    EXPECT_EQ(nullptr, cache.find("b"));
+    EXPECT_NE(nullptr, cache.find("a"));
+
+    /* So does adding it again. */
+    cache.insert("c", 4);
+    cache.insert("d", 5);
+    EXPECT_EQ(nullptr, cache.find("a"));
+    EXPECT_EQ(3, *cache.find("c"));
+    EXPECT_EQ(5, *cache.find("d"));
+    EXPECT_EQ(2, cache.evictions());
+
+    /* A dropped value can be added again. */
+    EXPECT_EQ(6, cache.insert("a", 6));
+    EXPECT_EQ(6, *cache.find("a"));
+    EXPECT_EQ(2, cache.size());
+}
+
+TEST(LRUCache, One)
+{
+    LRUCache<int, std::string> cache = LRUCache<int, std::string>(1);
+    for (int n = 0; n < 10; ++n) {
+        EXPECT_EQ(std::to_string(n), cache.insert(n, std::to_string(n)));
+        EXPECT_EQ(1, cache.size());
+    }
+
+    EXPECT_EQ(9, cache.evictions());
+    EXPECT_EQ(nullptr, cache.find(8));
+    EXPECT_EQ("9", *cache.find(9));
+}
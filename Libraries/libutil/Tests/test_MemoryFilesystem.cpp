@@ -219,6 +219,27 @@ TEST(MemoryFilesystem, Read)
     EXPECT_EQ(contents, Contents(""));
 }
 
+TEST(MemoryFilesystem, ReadMapped)
+{
+    auto filesystem = BasicFilesystem();
+
+    /* Map file in subdirectory. */
+    std::unique_ptr<MemoryFilesystem::Mapping> mapping = filesystem.readMapped("/dir1/file2");
+    ASSERT_NE(nullptr, mapping);
+    EXPECT_EQ(std::vector<uint8_t>(mapping->data(), mapping->data() + mapping->size()), Contents("two1"));
+
+    /* Mapped contents don't change when the file is replaced. */
+    EXPECT_TRUE(filesystem.write(Contents("new"), "/dir1/file2"));
+    EXPECT_TRUE(filesystem.removeFile("/dir1/file2"));
+    EXPECT_EQ(std::vector<uint8_t>(mapping->data(), mapping->data() + mapping->size()), Contents("two1"));
+
+    /* Can't map directory. */
+    EXPECT_EQ(nullptr, filesystem.readMapped("/dir1"));
+
+    /* Can't map nonexistent file. */
+    EXPECT_EQ(nullptr, filesystem.readMapped("/invalid"));
+}
+
 TEST(MemoryFilesystem, Write)
 {
     auto filesystem = BasicFilesystem();
@@ -251,6 +272,53 @@ TEST(MemoryFilesystem, Write)
     EXPECT_FALSE(filesystem.exists("/invalid/new"));
 }
 
+TEST(MemoryFilesystem, ModificationTime)
+{
+    auto filesystem = BasicFilesystem();
+
+    /* Initial entries are the oldest. */
+    ASSERT_TRUE(filesystem.modificationTime("/file1"));
+    ASSERT_TRUE(filesystem.modificationTime("/dir1"));
+    EXPECT_EQ(*filesystem.modificationTime("/file1"), *filesystem.modificationTime("/dir1/file2"));
+    EXPECT_FALSE(filesystem.modificationTime("/invalid"));
+
+    /* Writing updates the time. */
+    uint64_t original = *filesystem.modificationTime("/file1");
+    EXPECT_TRUE(filesystem.write(Contents("new"), "/file1"));
+    ASSERT_TRUE(filesystem.modificationTime("/file1"));
+    EXPECT_GT(*filesystem.modificationTime("/file1"), original);
+
+    /* Later writes are newer. */
+    EXPECT_TRUE(filesystem.write(Contents("new"), "/new"));
+    ASSERT_TRUE(filesystem.modificationTime("/new"));
+    EXPECT_GT(*filesystem.modificationTime("/new"), *filesystem.modificationTime("/file1"));
+
+    EXPECT_TRUE(filesystem.createFile("/created"));
+    ASSERT_TRUE(filesystem.modificationTime("/created"));
+    EXPECT_GT(*filesystem.modificationTime("/created"), *filesystem.modificationTime("/new"));
+}
+
+TEST(MemoryFilesystem, WriteIfChanged)
+{
+    auto filesystem = BasicFilesystem();
+    std::vector<uint8_t> contents;
+
+    /* Same contents leave the file alone. */
+    uint64_t original = *filesystem.modificationTime("/file1");
+    EXPECT_TRUE(filesystem.writeIfChanged(Contents("one"), "/file1"));
+    EXPECT_EQ(*filesystem.modificationTime("/file1"), original);
+
+    /* Same size but different contents are written. */
+    EXPECT_TRUE(filesystem.writeIfChanged(Contents("two"), "/file1"));
+    EXPECT_GT(*filesystem.modificationTime("/file1"), original);
+    EXPECT_TRUE(filesystem.read(&contents, "/file1"));
+    EXPECT_EQ(contents, Contents("two"));
+
+    /* New files are written. */
+    EXPECT_TRUE(filesystem.writeIfChanged(Contents(""), "/new"));
+    EXPECT_TRUE(filesystem.exists("/new"));
+}
+
 TEST(MemoryFilesystem, ResolvePath)
 {
     auto filesystem = BasicFilesystem();
@@ -305,3 +373,65 @@ TEST(MemoryFilesystem, EnumerateDirectory)
     EXPECT_EQ(files, std::vector<std::string>({ }));
 }
 
+TEST(MemoryFilesystem, EnumerateRecursive)
+{
+    auto filesystem = BasicFilesystem();
+
+    std::vector<std::pair<std::string, bool>> files;
+    auto accumulate = [&files](std::string const &path, bool directory) -> bool {
+        files.push_back({ path, directory });
+        return true;
+    };
+
+    /* Each directory's entries come before its subdirectories' contents. */
+    EXPECT_TRUE(filesystem.enumerateRecursive("/", accumulate));
+    EXPECT_EQ(files, (std::vector<std::pair<std::string, bool>>({
+        { "/file1", false },
+        { "/dir1", true },
+        { "/dir2", true },
+        { "/dir1/file2", false },
+        { "/dir2/file2", false },
+        { "/dir2/dir3", true },
+    })));
+
+    /* Stops when asked to. */
+    files.clear();
+    EXPECT_TRUE(filesystem.enumerateRecursive("/dir2", [&files](std::string const &path, bool directory) -> bool {
+        files.push_back({ path, directory });
+        return false;
+    }));
+    EXPECT_EQ(files, (std::vector<std::pair<std::string, bool>>({ { "/dir2/file2", false } })));
+
+    /* Can't list nonexistent directory. */
+    files.clear();
+    EXPECT_FALSE(filesystem.enumerateRecursive("/invalid", accumulate));
+    EXPECT_TRUE(files.empty());
+}
+
+TEST(MemoryFilesystem, CopyRecursive)
+{
+    auto filesystem = BasicFilesystem();
+    std::vector<uint8_t> contents;
+
+    /* Copy a file. */
+    EXPECT_TRUE(filesystem.copyRecursive("/file1", "/copy1"));
+    EXPECT_TRUE(filesystem.read(&contents, "/copy1"));
+    EXPECT_EQ(contents, Contents("one"));
+
+    /* Copy a directory and its contents. */
+    EXPECT_TRUE(filesystem.copyRecursive("/dir2", "/copy2"));
+    EXPECT_TRUE(filesystem.isDirectory("/copy2/dir3"));
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/copy2/file2"));
+    EXPECT_EQ(contents, Contents("two2"));
+
+    /* Copy over existing files. */
+    EXPECT_TRUE(filesystem.copyRecursive("/dir1", "/copy2"));
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, "/copy2/file2"));
+    EXPECT_EQ(contents, Contents("two1"));
+
+    /* Can't copy nonexistent file. */
+    EXPECT_FALSE(filesystem.copyRecursive("/invalid", "/copy3"));
+    EXPECT_FALSE(filesystem.exists("/copy3"));
+}
@@ -0,0 +1,102 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/Parallel.h>
+
+#include <atomic>
+#include <string>
+
+using libutil::Parallel;
+
+TEST(Parallel, ForEachIndex)
+{
+    std::vector<int> counts = std::vector<int>(1000, 0);
+    Parallel::For(counts.size(), [&](size_t index) {
+        counts[index]++;
+    });
+
+    for (int count : counts) {
+        EXPECT_EQ(1, count);
+    }
+
+    /* Nothing to run is fine. */
+    Parallel::For(0, [&](size_t index) {
+        ADD_FAILURE();
+    });
+}
+
+TEST(Parallel, Nested)
+{
+    std::atomic<size_t> total(0);
+    Parallel::For(16, [&](size_t outer) {
+        Parallel::For(16, [&](size_t inner) {
+            Parallel::For(4, [&](size_t) {
+                total++;
+            });
+        });
+    });
+
+    EXPECT_EQ(16 * 16 * 4, total.load());
+}
+
+TEST(Parallel, ReduceInOrder)
+{
+    std::string result = Parallel::Reduce<std::string>(
+        26,
+        ">",
+        [](size_t index) {
+            return std::string(1, static_cast<char>('a' + index));
+        },
+        [](std::string const &left, std::string const &right) {
+            return left + right;
+        });
+
+    EXPECT_EQ(">abcdefghijklmnopqrstuvwxyz", result);
+}
+
+TEST(Parallel, Group)
+{
+    std::atomic<int> first(0);
+    std::atomic<int> second(0);
+
+    Parallel::Group group;
+    group.add([&]() { first++; });
+    group.add([&]() { second += 2; });
+
+    /* Nothing runs until waited on. */
+    EXPECT_EQ(0, first.load());
+
+    group.wait();
+    EXPECT_EQ(1, first.load());
+    EXPECT_EQ(2, second.load());
+
+    /* Waiting again doesn't rerun finished work. */
+    group.wait();
+    EXPECT_EQ(1, first.load());
+}
+
+TEST(Parallel, Concurrency)
+{
+    size_t original = Parallel::Concurrency();
+    EXPECT_GE(original, 1u);
+
+    /* At least the calling thread is always used. */
+    Parallel::SetConcurrency(0);
+    EXPECT_EQ(1u, Parallel::Concurrency());
+
+    std::vector<int> counts = std::vector<int>(100, 0);
+    Parallel::For(counts.size(), [&](size_t index) {
+        counts[index]++;
+    });
+    EXPECT_EQ(std::vector<int>(100, 1), counts);
+
+    Parallel::SetConcurrency(original);
+    EXPECT_EQ(original, Parallel::Concurrency());
+}
@@ -0,0 +1,53 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/Statistic.h>
+
+using libutil::Statistic;
+
+static Statistic Lookups("test", "Lookups");
+static Statistic Hits("test", "Hits", &Lookups);
+static Statistic Work("test", "Work");
+
+TEST(Statistic, CountAndSummary)
+{
+    /* Nothing is counted until enabled. */
+    Lookups.increment();
+    EXPECT_EQ(0, Lookups.count());
+
+    Statistic::Enable();
+    ASSERT_TRUE(Statistic::Enabled());
+
+    for (int i = 0; i < 4; ++i) {
+        Lookups.increment();
+    }
+    Hits.increment();
+
+    {
+        Statistic::Timer timer(&Work);
+
+        /* As the allocation hooks would. */
+        Statistic::Allocated(1024 * 1024);
+        Statistic::Allocated(1024 * 1024);
+    }
+
+    EXPECT_EQ(4, Lookups.count());
+    EXPECT_EQ(1, Hits.count());
+    EXPECT_EQ(1, Work.count());
+    EXPECT_EQ(2, Work.allocations());
+    EXPECT_EQ(2 * 1024 * 1024, Work.allocatedBytes());
+    EXPECT_GT(Work.peakResidentBytes(), 0);
+
+    std::string summary = Statistic::Summary();
+    EXPECT_NE(std::string::npos, summary.find("Lookups"));
+    EXPECT_NE(std::string::npos, summary.find("25.0%"));
+    EXPECT_NE(std::string::npos, summary.find(" ms"));
+    EXPECT_NE(std::string::npos, summary.find("2.0 MB"));
+}
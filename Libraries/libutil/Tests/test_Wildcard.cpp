@@ -49,3 +49,32 @@ TEST(Wildcard, One)
     EXPECT_FALSE(Wildcard::Match("[aA]", "b"));
 }
 
+
+TEST(Wildcard, Pattern)
+{
+    std::vector<std::string> patterns = { "", "a", "abcd", "*", "a*", "*a", "*a*", "a*de", "a*d", "[", "[a]", "b[aA]d", "b[aei][dn]", "*.c", "*.tar.gz", "*[", "**" };
+    std::vector<std::string> strings = { "", "a", "b", "abcd", "abcde", "bad", "bid", "x.c", "x.y.c", "x.tar.gz", "[", "a[", "*" };
+
+    for (std::string const &pattern : patterns) {
+        Wildcard::Pattern compiled = Wildcard::Pattern(pattern);
+        for (std::string const &string : strings) {
+            EXPECT_EQ(Wildcard::Match(pattern, string), compiled.match(string)) << pattern << " " << string;
+        }
+    }
+}
+
+TEST(Wildcard, PatternSet)
+{
+    Wildcard::PatternSet set = Wildcard::PatternSet({ "Makefile", "*.c", "b[aA]d", "*.tar.gz", "*.c", "*" });
+
+    EXPECT_EQ(0, *set.match("Makefile"));
+    EXPECT_EQ(1, *set.match("main.c"));
+    EXPECT_EQ(2, *set.match("bAd"));
+    EXPECT_EQ(3, *set.match("a.tar.gz"));
+    EXPECT_EQ(5, *set.match("a.b.c"));
+    EXPECT_EQ(1, *set.match(""));
+
+    Wildcard::PatternSet extensions = Wildcard::PatternSet({ "*.c", "*.h" });
+    EXPECT_FALSE(extensions.match("main.m"));
+    EXPECT_FALSE(Wildcard::PatternSet().match(""));
+}
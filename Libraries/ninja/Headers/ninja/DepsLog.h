@@ -0,0 +1,76 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __ninja_DepsLog_h
+#define __ninja_DepsLog_h
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cstdint>
+
+namespace ninja {
+
+/*
+ * Reads and appends to Ninja's binary dependency log, `.ninja_deps`. Ninja
+ * loads the dependencies of edges using `deps` from the log instead of
+ * parsing a depfile. The log must not be changed while Ninja is running,
+ * as Ninja keeps it open to append its own records.
+ */
+class DepsLog {
+private:
+    struct Deps {
+        uint64_t             mtime;
+        std::vector<int32_t> inputs;
+    };
+
+private:
+    std::vector<uint8_t>                     _contents;
+    int32_t                                  _version;
+    std::unordered_map<std::string, int32_t> _ids;
+    std::unordered_map<int32_t, Deps>        _deps;
+
+public:
+    /*
+     * An empty log in the newest format.
+     */
+    DepsLog();
+    ~DepsLog();
+
+public:
+    /*
+     * The log contents, including any records added.
+     */
+    std::vector<uint8_t> const &contents() const
+    { return _contents; }
+
+public:
+    /*
+     * Load an existing log. Fails if the log is not in a format this can
+     * write; like Ninja, a truncated record at the end is dropped.
+     */
+    bool load(std::vector<uint8_t> const &contents);
+
+    /*
+     * Record the inputs of an output last modified at a time, in
+     * nanoseconds. Paths must already be normalized, as Ninja would.
+     * Returns if a record was added: nothing is added if the log already
+     * has the same dependencies, or if the record is too large for Ninja.
+     */
+    bool record(std::string const &output, uint64_t mtime, std::vector<std::string> const &inputs);
+
+private:
+    bool id(std::string const &path, int32_t *id);
+    void append(uint32_t value);
+};
+
+}
+
+#endif  // !__ninja_DepsLog_h
@@ -80,6 +80,11 @@ public:
      */
     std::string resolve(EscapeMode mode) const;
 
+    /*
+     * Append the value to put in the Ninja file to a string.
+     */
+    void resolve(EscapeMode mode, std::string *result) const;
+
 public:
     /*
      * Create an empty Ninja value.
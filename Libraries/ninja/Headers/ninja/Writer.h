@@ -13,18 +13,21 @@
 #include <ninja/Value.h>
 
 #include <string>
-#include <sstream>
 #include <vector>
 
+#include <cstdint>
+
 namespace ninja {
 
 /*
  * Writes a Ninja file. Attempts to be reasonably type-safe to avoid the
  * most common escaping and syntax errors, but remains quite low-level.
+ * Output is appended directly to a byte buffer that can be written out
+ * without copying.
  */
 class Writer {
 private:
-    std::ostringstream _buffer;
+    std::vector<uint8_t> _contents;
 
 public:
     Writer();
@@ -84,10 +87,20 @@ public:
     void pool(std::string const &name, int depth);
 
 public:
+    /*
+     * The bytes written so far.
+     */
+    std::vector<uint8_t> const &contents() const
+    { return _contents; }
+
     /*
      * Serialize what's been written so far.
      */
     std::string serialize() const;
+
+private:
+    void append(std::string const &text);
+    void append(char c);
 };
 
 }
@@ -0,0 +1,211 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <ninja/DepsLog.h>
+
+#include <cstring>
+
+using ninja::DepsLog;
+
+static char const Signature[] = "# ninjadeps\n";
+static size_t const SignatureSize = sizeof(Signature) - 1;
+
+/* Version 3 stores times in seconds; version 4 in nanoseconds. */
+static int32_t const OldestVersion = 3;
+static int32_t const CurrentVersion = 4;
+
+/* Ninja refuses to read or write any larger record. */
+static uint32_t const MaxRecordSize = (1 << 19) - 1;
+
+/* Set in the size of records with dependencies, rather than a path. */
+static uint32_t const DepsRecordFlag = 0x80000000;
+
+template<typename T>
+static T
+Read(uint8_t const *data)
+{
+    T value;
+    ::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+static size_t
+TimeSize(int32_t version)
+{
+    return (version >= 4 ? sizeof(uint64_t) : sizeof(uint32_t));
+}
+
+DepsLog::
+DepsLog() :
+    _version(CurrentVersion)
+{
+    _contents.insert(_contents.end(), Signature, Signature + SignatureSize);
+    append(static_cast<uint32_t>(_version));
+}
+
+DepsLog::
+~DepsLog()
+{
+}
+
+void DepsLog::
+append(uint32_t value)
+{
+    uint8_t bytes[sizeof(value)];
+    ::memcpy(bytes, &value, sizeof(value));
+    _contents.insert(_contents.end(), bytes, bytes + sizeof(value));
+}
+
+bool DepsLog::
+load(std::vector<uint8_t> const &contents)
+{
+    size_t offset = SignatureSize + sizeof(int32_t);
+    if (contents.size() < offset || ::memcmp(contents.data(), Signature, SignatureSize) != 0) {
+        return false;
+    }
+
+    int32_t version = Read<int32_t>(contents.data() + SignatureSize);
+    if (version < OldestVersion || version > CurrentVersion) {
+        return false;
+    }
+
+    _version = version;
+    _ids.clear();
+    _deps.clear();
+
+    while (contents.size() - offset >= sizeof(uint32_t)) {
+        uint32_t size = Read<uint32_t>(contents.data() + offset);
+        bool deps = (size & DepsRecordFlag) != 0;
+        size &= ~DepsRecordFlag;
+
+        uint8_t const *record = contents.data() + offset + sizeof(uint32_t);
+        if (size > MaxRecordSize || size > contents.size() - offset - sizeof(uint32_t)) {
+            break;
+        }
+
+        if (deps) {
+            size_t header = sizeof(int32_t) + TimeSize(_version);
+            if (size < header || (size - header) % sizeof(int32_t) != 0) {
+                break;
+            }
+
+            int32_t output = Read<int32_t>(record);
+            if (output < 0 || static_cast<size_t>(output) >= _ids.size()) {
+                break;
+            }
+
+            Deps entry;
+            if (_version >= 4) {
+                uint64_t low = Read<uint32_t>(record + sizeof(int32_t));
+                uint64_t high = Read<uint32_t>(record + sizeof(int32_t) + sizeof(uint32_t));
+                entry.mtime = low | (high << 32);
+            } else {
+                entry.mtime = Read<uint32_t>(record + sizeof(int32_t));
+            }
+            for (size_t i = header; i < size; i += sizeof(int32_t)) {
+                entry.inputs.push_back(Read<int32_t>(record + i));
+            }
+
+            _deps[output] = std::move(entry);
+        } else {
+            if (size <= sizeof(uint32_t)) {
+                break;
+            }
+
+            /* Each path is padded to four bytes and checked by its inverted ID. */
+            size_t length = size - sizeof(uint32_t);
+            while (length > 0 && record[length - 1] == '\0') {
+                length--;
+            }
+
+            int32_t id = static_cast<int32_t>(_ids.size());
+            if (Read<uint32_t>(record + size - sizeof(uint32_t)) != ~static_cast<uint32_t>(id)) {
+                break;
+            }
+
+            _ids[std::string(reinterpret_cast<char const *>(record), length)] = id;
+        }
+
+        offset += sizeof(uint32_t) + size;
+    }
+
+    _contents.assign(contents.begin(), contents.begin() + offset);
+    return true;
+}
+
+bool DepsLog::
+id(std::string const &path, int32_t *id)
+{
+    auto it = _ids.find(path);
+    if (it != _ids.end()) {
+        *id = it->second;
+        return true;
+    }
+
+    size_t padding = (4 - path.size() % 4) % 4;
+    size_t size = path.size() + padding + sizeof(uint32_t);
+    if (path.empty() || size > MaxRecordSize) {
+        return false;
+    }
+
+    *id = static_cast<int32_t>(_ids.size());
+    _ids[path] = *id;
+
+    append(static_cast<uint32_t>(size));
+    _contents.insert(_contents.end(), path.begin(), path.end());
+    _contents.insert(_contents.end(), padding, '\0');
+    append(~static_cast<uint32_t>(*id));
+    return true;
+}
+
+bool DepsLog::
+record(std::string const &output, uint64_t mtime, std::vector<std::string> const &inputs)
+{
+    size_t size = sizeof(int32_t) + TimeSize(_version) + inputs.size() * sizeof(int32_t);
+    if (size > MaxRecordSize) {
+        return false;
+    }
+
+    Deps entry;
+    entry.mtime = (_version >= 4 ? mtime : mtime / 1000000000);
+
+    int32_t outputId;
+    if (!id(output, &outputId)) {
+        return false;
+    }
+
+    for (std::string const &input : inputs) {
+        int32_t inputId;
+        if (!id(input, &inputId)) {
+            return false;
+        }
+
+        entry.inputs.push_back(inputId);
+    }
+
+    auto it = _deps.find(outputId);
+    if (it != _deps.end() && it->second.mtime == entry.mtime && it->second.inputs == entry.inputs) {
+        return false;
+    }
+
+    append(static_cast<uint32_t>(size) | DepsRecordFlag);
+    append(static_cast<uint32_t>(outputId));
+    if (_version >= 4) {
+        append(static_cast<uint32_t>(entry.mtime & 0xffffffff));
+        append(static_cast<uint32_t>(entry.mtime >> 32));
+    } else {
+        append(static_cast<uint32_t>(entry.mtime));
+    }
+    for (int32_t input : entry.inputs) {
+        append(static_cast<uint32_t>(input));
+    }
+
+    _deps[outputId] = std::move(entry);
+    return true;
+}
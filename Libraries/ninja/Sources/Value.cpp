@@ -9,7 +9,7 @@
 
 #include <ninja/Value.h>
 
-#include <sstream>
+#include <cstdlib>
 
 using ninja::Value;
 
@@ -40,62 +40,75 @@ operator+(Value const &rhs) const
     return Value(chunks);
 }
 
-static std::string
-Replace(std::string string, std::string const &search, std::string const &replace)
+/*
+ * Characters that need escaping in each mode, for the scan that lets most
+ * chunks be appended without looking at each character.
+ */
+static char const *
+Special(bool string, Value::EscapeMode mode)
 {
-    size_t pos = 0;
-
-    while ((pos = string.find(search, pos)) != std::string::npos) {
-         string.replace(pos, search.length(), replace);
-         pos += replace.length();
+    switch (mode) {
+        case Value::EscapeMode::Value:
+            return (string ? "$" : "");
+        case Value::EscapeMode::PathList:
+            return (string ? "$ " : " ");
+        case Value::EscapeMode::BuildPathList:
+            return (string ? "$ :" : " :");
     }
 
-    return string;
+    abort();
 }
 
-std::string Value::
-resolve(Value::EscapeMode mode) const
+/*
+ * Escapes a chunk in one pass. Strings escape variables, spaces (in path
+ * lists), and colons (in build path lists). Expressions keep variables, but
+ * still escape spaces and colons; where one follows a `$` that was meant to
+ * escape it, the `$` is escaped as well.
+ */
+static void
+Escape(std::string const &value, bool string, Value::EscapeMode mode, std::string *result)
 {
-    std::ostringstream result;
+    char const *special = Special(string, mode);
+    if (*special == '\0' || value.find_first_of(special) == std::string::npos) {
+        result->append(value);
+        return;
+    }
 
-    for (Value::Chunk const &chunk : _chunks) {
-        switch (chunk.type()) {
-            case Value::Chunk::Type::String:
-                switch (mode) {
-                    case Value::EscapeMode::Value:
-                        /* String, value: just escape variables. Spaces are allowed. */
-                        result << Replace(chunk.value(), "$", "$$");
-                        break;
-                    case Value::EscapeMode::PathList:
-                        /* String, path list: escape variables and spaces, not colons. */
-                        result << Replace(Replace(chunk.value(), "$", "$$"), " ", "$ ");
-                        break;
-                    case Value::EscapeMode::BuildPathList:
-                        /* String, build path list: escape variables, spaces, and, colons. */
-                        result << Replace(Replace(Replace(chunk.value(), "$", "$$"), " ", "$ "), ":", "$:");
-                        break;
-                }
-                break;
-            case Value::Chunk::Type::Expression:
-                switch (mode) {
-                    case Value::EscapeMode::Value:
-                        /* Expression, value: no need to escape. Allow variables. */
-                        result << chunk.value();
-                        break;
-                    case Value::EscapeMode::PathList:
-                        /* Expression, path list: just escape spaces. */
-                        result << Replace(Replace(chunk.value(), "$ ", "$$ "), " ", "$ ");
-                        break;
-                    case Value::EscapeMode::BuildPathList:
-                        /* Expression, path list: escape spaces and colons. */
-                        result << Replace(Replace(Replace(Replace(chunk.value(), "$ ", "$$ "), " ", "$ "), "$:", "$$:"), ":", "$:");
-                        break;
-                }
-                break;
+    bool spaces = (mode != Value::EscapeMode::Value);
+    bool colons = (mode == Value::EscapeMode::BuildPathList);
+
+    char previous = '\0';
+    for (char c : value) {
+        if (string && c == '$') {
+            result->append("$$");
+        } else if ((spaces && c == ' ') || (colons && c == ':')) {
+            if (!string && previous == '$') {
+                result->push_back('$');
+            }
+            result->push_back('$');
+            result->push_back(c);
+        } else {
+            result->push_back(c);
         }
+
+        previous = c;
     }
+}
 
-    return result.str();
+void Value::
+resolve(Value::EscapeMode mode, std::string *result) const
+{
+    for (Value::Chunk const &chunk : _chunks) {
+        Escape(chunk.value(), chunk.type() == Value::Chunk::Type::String, mode, result);
+    }
+}
+
+std::string Value::
+resolve(Value::EscapeMode mode) const
+{
+    std::string result;
+    resolve(mode, &result);
+    return result;
 }
 
 Value Value::
@@ -12,9 +12,13 @@
 
 using ninja::Writer;
 
+/* Most lines are short; avoid regrowing the buffer for each of the first. */
+static size_t const InitialCapacity = 64 * 1024;
+
 Writer::
 Writer()
 {
+    _contents.reserve(InitialCapacity);
 }
 
 Writer::
@@ -22,42 +26,60 @@ Writer::
 {
 }
 
+void Writer::
+append(std::string const &text)
+{
+    _contents.insert(_contents.end(), text.begin(), text.end());
+}
+
+void Writer::
+append(char c)
+{
+    _contents.push_back(static_cast<uint8_t>(c));
+}
+
 void Writer::
 newline()
 {
-    _buffer << std::endl;
+    append('\n');
 }
 
 void Writer::
 binding(Binding const &binding, int indent)
 {
     for (int i = 0; i < indent; i++) {
-        _buffer << "  ";
+        append("  ");
     }
 
-    _buffer << binding.first << " = " << binding.second.resolve(Value::EscapeMode::Value) << std::endl;
+    append(binding.first);
+    append(" = ");
+    append(binding.second.resolve(Value::EscapeMode::Value));
+    append('\n');
 }
 
 void Writer::
 command(std::string const &command, std::string const &remaining, std::vector<Binding> const &bindings)
 {
-    _buffer << command;
+    append(command);
     if (!remaining.empty()) {
-        _buffer << " " << remaining;
+        append(' ');
+        append(remaining);
     }
-    _buffer << std::endl;
+    append('\n');
 
     for (Binding const &binding : bindings) {
         this->binding(binding, 1);
     }
 
-    _buffer << std::endl;
+    append('\n');
 }
 
 void Writer::
 comment(std::string const &text)
 {
-    _buffer << "#" << " " << text << std::endl;
+    append("# ");
+    append(text);
+    append('\n');
 }
 
 void Writer::
@@ -80,7 +102,7 @@ default_(std::vector<Value> const &paths)
         if (&path != &paths[0]) {
             remaining += " ";
         }
-        remaining += path.resolve(Value::EscapeMode::PathList);
+        path.resolve(Value::EscapeMode::PathList, &remaining);
     }
 
     command("default", remaining);
@@ -106,41 +128,44 @@ rule(std::string const &name, Value const &command, std::vector<Binding> const &
 void Writer::
 build(std::vector<Value> const &outputs, std::string const &rule, std::vector<Value> const &inputs, std::vector<Binding> const &bindings, std::vector<Value> const &dependencies, std::vector<Value> const &orders)
 {
-    std::ostringstream remaining;
+    std::string remaining;
 
     for (Value const &output : outputs) {
         if (&output != &outputs[0]) {
-            remaining << " ";
+            remaining += " ";
         }
-        remaining << output.resolve(Value::EscapeMode::BuildPathList);
+        output.resolve(Value::EscapeMode::BuildPathList, &remaining);
     }
 
-    remaining << ":" << " " << rule;
+    remaining += ": " + rule;
 
     for (Value const &input : inputs) {
-        remaining << " " << input.resolve(Value::EscapeMode::BuildPathList);
+        remaining += " ";
+        input.resolve(Value::EscapeMode::BuildPathList, &remaining);
     }
 
     if (!dependencies.empty()) {
-        remaining << " " << "|";
+        remaining += " |";
         for (Value const &dependency : dependencies) {
-            remaining << " " << dependency.resolve(Value::EscapeMode::BuildPathList);
+            remaining += " ";
+            dependency.resolve(Value::EscapeMode::BuildPathList, &remaining);
         }
     }
 
     if (!orders.empty()) {
-        remaining << " " << "||";
+        remaining += " ||";
         for (Value const &order : orders) {
-            remaining << " " << order.resolve(Value::EscapeMode::BuildPathList);
+            remaining += " ";
+            order.resolve(Value::EscapeMode::BuildPathList, &remaining);
         }
     }
 
-    command("build", remaining.str(), bindings);
+    command("build", remaining, bindings);
 }
 
 std::string Writer::
 serialize() const
 {
-    return _buffer.str();
+    return std::string(_contents.begin(), _contents.end());
 }
 
@@ -0,0 +1,73 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <ninja/DepsLog.h>
+
+using ninja::DepsLog;
+
+static std::vector<uint8_t>
+Words(std::string const &header, std::vector<uint32_t> const &words)
+{
+    std::vector<uint8_t> result = std::vector<uint8_t>(header.begin(), header.end());
+    for (uint32_t word : words) {
+        for (size_t i = 0; i < sizeof(word); ++i) {
+            result.push_back(static_cast<uint8_t>(word >> (i * 8)));
+        }
+    }
+    return result;
+}
+
+TEST(DepsLog, Record)
+{
+    DepsLog log;
+    EXPECT_TRUE(log.record("out.o", 0x100000002, { "in.c", "in.h" }));
+
+    std::vector<uint8_t> expected = Words("# ninjadeps\n", {
+        4,
+        /* Paths, padded, then the inverted ID. */
+        12, 0x2e74756f, 0x0000006f, ~0u,
+        8, 0x632e6e69, ~1u,
+        8, 0x682e6e69, ~2u,
+        /* Output, time, then inputs. */
+        0x80000014, 0, 2, 1, 1, 2,
+    });
+    EXPECT_EQ(expected, log.contents());
+}
+
+TEST(DepsLog, Load)
+{
+    DepsLog first;
+    first.record("out.o", 10, { "in.c" });
+
+    /* A partial record at the end is dropped. */
+    std::vector<uint8_t> contents = first.contents();
+    contents.push_back(0x20);
+
+    DepsLog second;
+    ASSERT_TRUE(second.load(contents));
+    EXPECT_EQ(first.contents(), second.contents());
+
+    /* Same dependencies aren't recorded again; changes reuse paths. */
+    EXPECT_FALSE(second.record("out.o", 10, { "in.c" }));
+    EXPECT_TRUE(second.record("out.o", 11, { "in.c" }));
+    EXPECT_EQ(first.contents().size() + 20, second.contents().size());
+}
+
+TEST(DepsLog, Version)
+{
+    DepsLog log;
+    EXPECT_FALSE(log.load(Words("# ninjadeps\n", { 2 })));
+    EXPECT_FALSE(log.load(Words("# notninja\n", { 4 })));
+
+    /* Older logs store seconds. */
+    ASSERT_TRUE(log.load(Words("# ninjadeps\n", { 3 })));
+    EXPECT_TRUE(log.record("a", 3000000000, { }));
+    EXPECT_EQ(Words("# ninjadeps\n", { 3, 8, 0x61, ~0u, 0x80000008, 0, 3 }), log.contents());
+}
@@ -87,6 +87,13 @@ TEST(Value, EscapeBuildPathList)
     EXPECT_EQ(Value::Expression("two $$").resolve(mode), "two$ $$");
 }
 
+TEST(Value, ResolveAppend)
+{
+    std::string result = "build ";
+    (Value::String("a b:$") + Value::Expression("$in:")).resolve(Value::EscapeMode::BuildPathList, &result);
+    EXPECT_EQ(result, "build a$ b$:$$$in$:");
+}
+
 TEST(Value, String)
 {
     Value::EscapeMode mode = Value::EscapeMode::Value;
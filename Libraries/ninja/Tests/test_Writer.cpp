@@ -160,3 +160,13 @@ TEST(Writer, Pool)
     EXPECT_EQ(writer.serialize(), "pool name\n  depth = 4\n\n");
 }
 
+
+TEST(Writer, Contents)
+{
+    Writer writer;
+    writer.comment("comment");
+    writer.pool("name", 4);
+
+    std::string expected = "# comment\npool name\n  depth = 4\n\n";
+    EXPECT_EQ(writer.contents(), std::vector<uint8_t>(expected.begin(), expected.end()));
+}
@@ -14,7 +14,11 @@
 #include <pbxbuild/WorkspaceContext.h>
 #include <pbxbuild/Build/Environment.h>
 #include <pbxbuild/Target/Environment.h>
+#include <pbxbuild/Tool/SearchPaths.h>
+#include <pbxbuild/Tool/ProjectHeaders.h>
+#include <libutil/LRUCache.h>
 
+#include <mutex>
 #include <ext/optional>
 
 namespace pbxbuild {
@@ -26,6 +30,51 @@ namespace Build {
  * to custom options that can be passed into certain builds.
  */
 class Context {
+public:
+    /*
+     * Target environments already created, most recently used first. Each
+     * holds a target's full settings, so in huge workspaces keeping every
+     * one alive takes a lot of memory; with a capacity, the least recently
+     * used are dropped and created again if needed. Safe to use from
+     * multiple threads.
+     */
+    class TargetEnvironmentCache {
+    private:
+        std::mutex                                                               _mutex;
+        libutil::LRUCache<pbxproj::PBX::Target::shared_ptr, Target::Environment> _cache;
+
+    public:
+        explicit TargetEnvironmentCache(size_t capacity);
+
+    public:
+        /*
+         * The environment for a target, if cached. Marks it as used.
+         */
+        ext::optional<Target::Environment>
+        find(pbxproj::PBX::Target::shared_ptr const &target);
+
+        /*
+         * Cache a target's environment, unless another was added first.
+         * Returns the cached environment.
+         */
+        Target::Environment
+        insert(pbxproj::PBX::Target::shared_ptr const &target, Target::Environment const &targetEnvironment);
+
+    public:
+        /*
+         * How many environments are cached.
+         */
+        size_t size();
+
+    public:
+        /*
+         * The most environments kept by caches created from now on. Zero,
+         * the default, keeps all of them.
+         */
+        static size_t DefaultCapacity();
+        static void SetDefaultCapacity(size_t capacity);
+    };
+
 private:
     WorkspaceContext                  _workspaceContext;
     xcscheme::XC::Scheme::shared_ptr  _scheme;
@@ -36,7 +85,11 @@ private:
     std::vector<pbxsetting::Level>    _overrideLevels;
 
 private:
-    std::shared_ptr<std::unordered_map<pbxproj::PBX::Target::shared_ptr, Target::Environment>> _targetEnvironments;
+    std::shared_ptr<TargetEnvironmentCache> _targetEnvironments;
+
+private:
+    std::shared_ptr<Tool::SearchPaths::RecursiveCache> _recursiveSearchPaths;
+    std::shared_ptr<Tool::ProjectHeaders::Cache>       _projectHeaders;
 
 public:
     Context(
@@ -107,11 +160,27 @@ public:
 
 public:
     /*
-     * Create or fetch a target's computed environment.
+     * Create or fetch a target's computed environment. Safe to call from
+     * multiple threads.
      */
     ext::optional<Target::Environment>
     targetEnvironment(Build::Environment const &buildEnvironment, pbxproj::PBX::Target::shared_ptr const &target) const;
 
+public:
+    /*
+     * Directories found below recursive search paths, shared between all
+     * targets in the build.
+     */
+    std::shared_ptr<Tool::SearchPaths::RecursiveCache> const &recursiveSearchPaths() const
+    { return _recursiveSearchPaths; }
+
+    /*
+     * Headers of each project for header maps, shared between all targets
+     * in the build.
+     */
+    std::shared_ptr<Tool::ProjectHeaders::Cache> const &projectHeaders() const
+    { return _projectHeaders; }
+
 public:
     /*
      * Finds a target by identifier within a project.
@@ -15,6 +15,8 @@
 #include <pbxbuild/Build/Context.h>
 #include <pbxbuild/DirectedGraph.h>
 
+#include <functional>
+
 namespace pbxbuild {
 namespace Build {
 
@@ -23,20 +25,30 @@ namespace Build {
  * in a scheme for a build action.
  */
 class DependencyResolver {
+public:
+    /*
+     * If a target's product is already built. Prebuilt dependencies are left
+     * out of the graph, along with everything they depend on.
+     */
+    using Prebuilt = std::function<bool(pbxproj::PBX::Target::shared_ptr const &target)>;
+
 private:
     Build::Environment _buildEnvironment;
+    Prebuilt           _prebuilt;
 
 public:
-    DependencyResolver(Build::Environment const &buildEnviroment);
+    DependencyResolver(Build::Environment const &buildEnviroment, Prebuilt const &prebuilt = nullptr);
     ~DependencyResolver();
 
 public:
     /*
      * Resolves dependencies within a scheme. The scheme used is as specified
-     * by the `Build::Context`, as well as the build action.
+     * by the `Build::Context`, as well as the build action. If `targets` is
+     * specified, include only the scheme's targets with those target or
+     * product names.
      */
     DirectedGraph<pbxproj::PBX::Target::shared_ptr>
-    resolveSchemeDependencies(Build::Context const &context) const;
+    resolveSchemeDependencies(Build::Context const &context, ext::optional<std::vector<std::string>> const &targets = ext::nullopt) const;
 
 public:
     /*
@@ -14,6 +14,10 @@
 #include <pbxsetting/Environment.h>
 #include <xcsdk/SDK/Manager.h>
 
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <ext/optional>
 
 namespace libutil { class Filesystem; }
@@ -27,11 +31,41 @@ namespace Build {
  * are not tied to the build but are used across the build.
  */
 class Environment {
+public:
+    /*
+     * Settings levels made from specifications, shared by every target
+     * that would make the same one. Levels share their settings when
+     * copied, so targets of the same product type all use one level.
+     * Safe to use from multiple threads.
+     */
+    class LevelCache {
+    private:
+        std::mutex                                         _mutex;
+        std::unordered_map<std::string, pbxsetting::Level> _levels;
+
+    public:
+        /*
+         * The level for a key, made with `create` the first time. The key
+         * must cover everything the level is made from.
+         */
+        pbxsetting::Level
+        level(std::string const &key, std::function<pbxsetting::Level()> const &create);
+
+    public:
+        /*
+         * How many levels are cached.
+         */
+        size_t size();
+    };
+
 private:
     pbxspec::Manager::shared_ptr         _specManager;
     std::shared_ptr<xcsdk::SDK::Manager> _sdkManager;
     pbxsetting::Environment              _baseEnvironment;
 
+private:
+    std::shared_ptr<LevelCache>          _levels;
+
 public:
     Environment(
         pbxspec::Manager::shared_ptr const &specManager,
@@ -58,6 +92,12 @@ public:
     pbxsetting::Environment const &baseEnvironment() const
     { return _baseEnvironment; }
 
+    /*
+     * Settings levels made from specifications, for the targets to share.
+     */
+    LevelCache *levels() const
+    { return _levels.get(); }
+
 public:
     /*
      * Creates a build environment from the default configuration
@@ -12,23 +12,28 @@
 
 #include <pbxbuild/Base.h>
 
-#include <list>
 #include <ext/optional>
 
 namespace pbxbuild {
 
 /*
- * A generic directed graph as an external adjacency list. Generally
- * intended for topological sorting (see `ordered()`) but can also be
- * used to just pass graphs of objects around.
+ * A generic directed graph. Nodes are numbered densely in the order they
+ * are first inserted, and edges are stored as vectors of those indexes.
+ * Generally intended for topological sorting (see `ordered()`) but can
+ * also be used to just pass graphs of objects around.
+ *
+ * An edge from a node to an adjacent node means the node comes after the
+ * adjacent node when sorted: adjacent nodes are dependencies.
  *
  * Note: Specializations are realized in the implementation file.
  */
 template<typename T>
 class DirectedGraph {
 private:
-    std::unordered_set<T>                        _nodes;
-    std::unordered_map<T, std::unordered_set<T>> _adjacency;
+    std::vector<T>                   _nodes;
+    std::unordered_map<T, size_t>    _indexes;
+    std::vector<std::vector<size_t>> _adjacency;
+    std::unordered_set<uint64_t>     _edges;
 
 public:
     /*
@@ -38,15 +43,36 @@ public:
 
 public:
     /*
-     * Returns all of the nodes in the graph.
+     * Returns all of the nodes in the graph, in insertion order. A node's
+     * position is its index.
+     */
+    std::vector<T> const &nodes() const
+    { return _nodes; }
+
+    /*
+     * Returns the index of a node, if it is in the graph.
      */
-    std::unordered_set<T> const &nodes() const;
+    ext::optional<size_t> index(T const &node) const;
+
+    /*
+     * Returns the indexes of the nodes adjacent to a node index.
+     */
+    std::vector<size_t> const &adjacentIndexes(size_t index) const
+    { return _adjacency[index]; }
 
     /*
      * Returns the nodes adjacent to a node. Empty if node is not
      * present in the graph or has no adjacent nodes.
      */
-    std::unordered_set<T> adjacent(T const &node) const;
+    std::vector<T> adjacent(T const &node) const;
+
+public:
+    /*
+     * Returns the subgraph of some node indexes and every node that depends
+     * on them, directly or not, with the edges between those nodes. Nodes
+     * keep their relative order.
+     */
+    DirectedGraph<T> dependents(std::vector<size_t> const &indexes) const;
 
 public:
     /*
@@ -54,6 +80,17 @@ public:
      * has a cycle.
      */
     ext::optional<std::vector<T>> ordered() const;
+
+    /*
+     * Groups the node indexes into levels: each node's adjacent nodes are
+     * all in earlier levels, so every node in a level can be processed as
+     * soon as the levels before it are done. Fails if the graph has a
+     * cycle.
+     */
+    ext::optional<std::vector<std::vector<size_t>>> levels() const;
+
+private:
+    size_t insertNode(T const &node);
 };
 
 }
@@ -19,36 +19,58 @@
 
 namespace pbxbuild {
 
+/*
+ * Builds and reads header maps. Entries are collected as they are added and
+ * only laid out into the hash table by `write()`, which sizes the table
+ * once for the final number of entries. Strings are shared between entries
+ * in the string pool.
+ */
 class HeaderMap {
 private:
-    HMapHeader              _header;
-    std::vector<HMapBucket> _buckets;
-    std::vector<char>       _strings;
+    struct Entry {
+        unsigned   hash;
+        HMapBucket bucket;
+    };
+
+private:
+    std::vector<Entry>                      _entries;
+    std::vector<char>                       _strings;
     std::unordered_set<std::string>         _keys;
     std::unordered_map<std::string, size_t> _offsets;
-    bool                    _modified;
+    uint32_t                                _maxValueLength;
 
 public:
     HeaderMap();
 
 public:
+    /*
+     * Replaces the contents with a serialized header map. The contents are
+     * read in place, so they can come directly from a mapped file.
+     */
+    bool read(uint8_t const *contents, size_t size);
     bool read(std::vector<uint8_t> const &buffer);
-    std::vector<uint8_t> write();
+
+    /*
+     * Serializes the header map into a single buffer.
+     */
+    std::vector<uint8_t> write() const;
 
 public:
     void invalidate();
 
 public:
+    /*
+     * Adds an entry. Fails if a key differing only in case was already
+     * added, since lookups are case insensitive.
+     */
     bool add(std::string const &key, std::string const &prefix, std::string const &suffix);
 
 public:
-    void dump();
+    void dump() const;
 
 private:
-    void grow();
-    void rehash(uint32_t newNumBuckets);
-    void set(unsigned hash, uint32_t koff, uint32_t poff, uint32_t soff, bool growing);
-    std::unordered_map<std::string, size_t>::iterator add(std::string const &string, bool key);
+    std::vector<HMapBucket> buckets() const;
+    uint32_t string(std::string const &string);
 };
 
 }
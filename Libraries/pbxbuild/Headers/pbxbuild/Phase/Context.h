@@ -22,6 +22,7 @@ namespace pbxbuild {
 namespace Tool {
     class AssetCatalogResolver;
     class ClangResolver;
+    class CodeSignResolver;
     class CopyResolver;
     class DittoResolver;
     class InfoPlistResolver;
@@ -37,6 +38,12 @@ namespace Phase {
 
 class Environment;
 
+/*
+ * State for resolving the phases of one target. Not shared between threads:
+ * resolve targets in parallel with a context each. Tool resolvers are
+ * created on first use; parallel work within a target fetches the ones it
+ * needs first, and then only calls their const preparation methods.
+ */
 class Context {
 private:
     Tool::Context                                       _toolContext;
@@ -44,6 +51,7 @@ private:
 private:
     std::unique_ptr<Tool::AssetCatalogResolver>         _assetCatalogResolver;
     std::unique_ptr<Tool::ClangResolver>                _clangResolver;
+    std::unique_ptr<Tool::CodeSignResolver>             _codeSignResolver;
     std::unique_ptr<Tool::CopyResolver>                 _copyResolver;
     std::unique_ptr<Tool::DittoResolver>                _dittoResolver;
     std::unique_ptr<Tool::InfoPlistResolver>            _infoPlistResolver;
@@ -71,6 +79,7 @@ public:
 public:
     Tool::AssetCatalogResolver const     *assetCatalogResolver(Phase::Environment const &phaseEnvironment);
     Tool::ClangResolver const            *clangResolver(Phase::Environment const &phaseEnvironment);
+    Tool::CodeSignResolver const         *codeSignResolver(Phase::Environment const &phaseEnvironment);
     Tool::CopyResolver const             *copyResolver(Phase::Environment const &phaseEnvironment);
     Tool::DittoResolver const            *dittoResolver(Phase::Environment const &phaseEnvironment);
     Tool::InfoPlistResolver const        *infoPlistResolver(Phase::Environment const &phaseEnvironment);
@@ -85,9 +94,10 @@ public:
 
 public:
     /*
-     * Groups the files according to the tools used to build them.
+     * Groups the files according to the tools used to build them. The files
+     * are moved into their groups.
      */
-    static std::vector<std::vector<Phase::File>> Group(std::vector<Phase::File> const &files);
+    static std::vector<std::vector<Phase::File>> Group(std::vector<Phase::File> files);
 
 public:
     bool resolveBuildFiles(
@@ -23,7 +23,8 @@ private:
     std::vector<Tool::Invocation> _invocations;
 
 public:
-    PhaseInvocations(std::vector<Tool::Invocation> const &invocations);
+    PhaseInvocations(std::vector<Tool::Invocation> &&invocations);
+    PhaseInvocations(PhaseInvocations &&) = default;
     ~PhaseInvocations();
 
 public:
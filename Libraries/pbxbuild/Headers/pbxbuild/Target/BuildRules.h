@@ -11,6 +11,7 @@
 #define __pbxbuild_Target_BuildRules_h
 
 #include <pbxbuild/Base.h>
+#include <libutil/Wildcard.h>
 
 namespace pbxbuild {
 namespace Target {
@@ -55,6 +56,16 @@ public:
 private:
     BuildRule::vector _buildRules;
 
+private:
+    /*
+     * Lookup tables for `resolve()`, holding the index of the first rule
+     * for each file type, and the file patterns of the other rules compiled
+     * together, along with the rule each pattern came from.
+     */
+    std::unordered_map<pbxspec::PBX::FileType const *, size_t> _fileTypeRules;
+    libutil::Wildcard::PatternSet                              _patterns;
+    std::vector<size_t>                                        _patternRules;
+
 private:
     BuildRules(BuildRule::vector const &buildRules);
 
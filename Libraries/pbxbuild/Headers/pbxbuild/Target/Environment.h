@@ -17,8 +17,11 @@
 #include <xcsdk/SDK/Target.h>
 #include <xcsdk/SDK/Toolchain.h>
 
+#include <mutex>
 #include <ext/optional>
 
+namespace libutil { class Filesystem; }
+
 namespace pbxbuild {
 
 namespace Build { class Context; }
@@ -35,6 +38,14 @@ private:
     std::vector<xcsdk::SDK::Toolchain::shared_ptr> _toolchains;
     std::vector<std::string>                       _executablePaths;
 
+private:
+    std::shared_ptr<std::unordered_map<std::string, ext::optional<std::string>>> _executables;
+    std::shared_ptr<std::mutex>                    _executablesMutex;
+
+private:
+    std::shared_ptr<std::unordered_map<pbxproj::PBX::GroupItem const *, std::string>> _groupPaths;
+    std::shared_ptr<std::mutex>                    _groupPathsMutex;
+
 private:
     Target::BuildRules                             _buildRules;
     std::vector<std::string>                       _specDomains;
@@ -91,6 +102,24 @@ public:
     std::vector<std::string> const &executablePaths() const
     { return _executablePaths; }
 
+    /*
+     * Find a tool in the executable paths. The result for each tool is
+     * remembered and shared between copies of this environment, so the
+     * paths are only searched once per tool.
+     */
+    ext::optional<std::string> executable(libutil::Filesystem const *filesystem, std::string const &name) const;
+
+public:
+    /*
+     * The path to a group item, expanded in this environment. The paths of
+     * the groups it's in are remembered and shared between copies of this
+     * environment, so each group's path is only expanded once.
+     */
+    std::string path(pbxproj::PBX::GroupItem const *item) const;
+
+private:
+    std::string groupPath(pbxproj::PBX::GroupItem const *group) const;
+
 public:
     /*
      * The build rules applicable to this target.
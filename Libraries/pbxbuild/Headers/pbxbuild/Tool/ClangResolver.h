@@ -14,6 +14,10 @@
 #include <pbxbuild/Tool/Invocation.h>
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/File.h>
+#include <pbxbuild/Tool/OptionsResult.h>
+
+#include <mutex>
+#include <unordered_set>
 
 namespace pbxbuild {
 namespace Tool {
@@ -23,9 +27,48 @@ class Context;
 class PrecompiledHeaderInfo;
 
 class ClangResolver {
+public:
+    /*
+     * A compiled source file, resolved without modifying the tool context.
+     * Sources can be prepared in parallel, then added to the context in
+     * order; see `prepareSource()` and `addSource()`.
+     */
+    struct Source {
+        Tool::Invocation                                       invocation;
+        std::unordered_map<std::string, std::string>           environment;
+        std::shared_ptr<PrecompiledHeaderInfo>                 precompiledHeaderInfo;
+        std::vector<std::string>                               linkerArguments;
+        bool                                                   cPlusPlus;
+        std::shared_ptr<Tool::Invocation::AuxiliaryFile const> responseFile;
+    };
+
+private:
+    /*
+     * Arguments that don't depend on the input file, shared by every file
+     * compiled with the same dialect, variant and architecture.
+     */
+    struct TargetArguments {
+        std::vector<std::string> searchPathsAndCustomFlags;
+        std::vector<std::string> notUsedInPrecompsFlags;
+
+        /*
+         * If enabled, the search paths and custom flags are written to
+         * this file and passed as a single `@path` argument.
+         */
+        std::shared_ptr<Tool::Invocation::AuxiliaryFile const> responseFile;
+    };
+
 private:
     pbxspec::PBX::Compiler::shared_ptr _compiler;
 
+private:
+    mutable std::mutex                                                        _targetArgumentsMutex;
+    mutable std::unordered_map<std::string, std::shared_ptr<TargetArguments>> _targetArguments;
+    mutable std::unordered_set<std::string>                                   _responseFiles;
+
+private:
+    mutable Tool::OptionsResult::Cache                                        _optionsCache;
+
 public:
     ClangResolver(pbxspec::PBX::Compiler::shared_ptr const &compiler);
     ~ClangResolver();
@@ -36,11 +79,26 @@ public:
         pbxsetting::Environment const &environment,
         Phase::File const &input,
         std::string const &outputDirectory) const;
+    Source prepareSource(
+        Tool::Context const *toolContext,
+        pbxsetting::Environment const &environment,
+        Phase::File const &input,
+        std::string const &outputDirectory) const;
+    void addSource(
+        Tool::Context *toolContext,
+        pbxsetting::Environment const &environment,
+        Source const &source) const;
     void resolvePrecompiledHeader(
         Tool::Context *toolContext,
         pbxsetting::Environment const &environment,
         PrecompiledHeaderInfo const &precompiledHeaderInfo) const;
 
+private:
+    std::shared_ptr<TargetArguments> targetArguments(
+        Tool::Context const *toolContext,
+        pbxsetting::Environment const &environment,
+        ext::optional<std::string> const &dialect) const;
+
 public:
     pbxspec::PBX::Compiler::shared_ptr const &compiler() const
     { return _compiler; }
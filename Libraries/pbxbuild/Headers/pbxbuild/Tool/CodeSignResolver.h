@@ -0,0 +1,82 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxbuild_Tool_CodeSignResolver_h
+#define __pbxbuild_Tool_CodeSignResolver_h
+
+#include <pbxbuild/Base.h>
+#include <pbxbuild/Phase/Environment.h>
+
+namespace pbxbuild {
+namespace Tool {
+
+class Context;
+
+/*
+ * Signs bundles with codesign. Each bundle is signed by its own invocation,
+ * after what's in it, including the bundles nested in it. Bundles that
+ * don't contain each other are signed in parallel, inner ones first.
+ */
+class CodeSignResolver {
+private:
+    std::string _executable;
+
+public:
+    explicit CodeSignResolver(std::string const &executable);
+    ~CodeSignResolver();
+
+public:
+    /*
+     * The path to codesign.
+     */
+    std::string const &executable() const
+    { return _executable; }
+
+public:
+    /*
+     * Sign a bundle once it's built. `contents` is where in the bundle the
+     * signature goes, and `dependencies` what must be built before signing.
+     * Nested bundles signed when they're copied keep the identifier and
+     * entitlements they have.
+     */
+    void resolve(
+        Tool::Context *toolContext,
+        pbxsetting::Environment const &environment,
+        std::string const &bundle,
+        std::string const &contents,
+        std::vector<std::string> const &dependencies,
+        bool nested) const;
+
+public:
+    /*
+     * If products built with an environment are signed.
+     */
+    static bool ShouldSign(pbxsetting::Environment const &environment);
+
+    /*
+     * The file signing writes, in the bundle's `contents`.
+     */
+    static std::string SignaturePath(std::string const &contents);
+
+    /*
+     * Where the signature of a nested bundle goes, like CONTENTS_FOLDER_PATH
+     * for the product itself. `shallowBundle` is the bundle's own
+     * SHALLOW_BUNDLE, which can differ from the product's.
+     */
+    static std::string NestedContentsPath(std::string const &bundle, bool shallowBundle);
+
+public:
+    static std::unique_ptr<CodeSignResolver>
+    Create(Phase::Environment const &phaseEnvironment);
+};
+
+}
+}
+
+#endif // !__pbxbuild_Tool_CodeSignResolver_h
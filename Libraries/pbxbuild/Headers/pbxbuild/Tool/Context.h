@@ -40,6 +40,10 @@ private:
     std::vector<SwiftModuleInfo>   _swiftModuleInfo;
     std::vector<std::string>       _additionalInfoPlistContents;
 
+private:
+    std::unordered_multimap<size_t, std::shared_ptr<std::unordered_map<std::string, std::string> const>> _environments;
+    std::unordered_set<std::string> _sharedAuxiliaryFiles;
+
 private:
     std::vector<Tool::Invocation> _invocations;
     std::map<std::pair<std::string, std::string>, std::vector<Tool::Invocation>> _variantArchitectureInvocations;
@@ -88,6 +92,22 @@ public:
     std::vector<std::string> &additionalInfoPlistContents()
     { return _additionalInfoPlistContents; }
 
+public:
+    /*
+     * An invocation environment with the given variables. Invocations with
+     * the same variables, like every compile in a target, share one map.
+     */
+    std::shared_ptr<std::unordered_map<std::string, std::string> const>
+    environment(std::unordered_map<std::string, std::string> const &environment);
+
+    /*
+     * Marks an auxiliary file as used by the target's invocations, such as a
+     * file several invocations read. Returns if it's the first use; only
+     * the first invocation to use it should write it.
+     */
+    bool sharedAuxiliaryFile(std::string const &path)
+    { return _sharedAuxiliaryFiles.insert(path).second; }
+
 public:
     std::vector<Tool::Invocation> const &invocations() const
     { return _invocations; }
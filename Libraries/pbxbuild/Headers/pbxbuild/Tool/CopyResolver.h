@@ -13,6 +13,7 @@
 #include <pbxbuild/Base.h>
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/File.h>
+#include <pbxbuild/Tool/Invocation.h>
 
 namespace pbxbuild {
 namespace Tool {
@@ -20,6 +21,17 @@ namespace Tool {
 class Context;
 
 class CopyResolver {
+public:
+    /*
+     * A copy, resolved without modifying the tool context. Copies can be
+     * prepared in parallel, then added to the context in order; see
+     * `prepareCopy()` and `addCopy()`.
+     */
+    struct Copy {
+        Tool::Invocation                             invocation;
+        std::unordered_map<std::string, std::string> environment;
+    };
+
 private:
     pbxspec::PBX::Tool::shared_ptr _tool;
 
@@ -41,6 +53,17 @@ public:
         std::string const &outputDirectory,
         std::string const &logMessageTitle) const;
 
+public:
+    Copy prepareCopy(
+        Tool::Context const *toolContext,
+        pbxsetting::Environment const &environment,
+        std::vector<Phase::File> const &input,
+        std::string const &outputDirectory,
+        std::string const &logMessageTitle) const;
+    void addCopy(
+        Tool::Context *toolContext,
+        Copy const &copy) const;
+
 public:
     static std::string ToolIdentifier()
     { return "com.apple.compilers.pbxcp"; }
@@ -65,6 +65,14 @@ public:
         std::string const &workingDirectory,
         std::vector<std::string> const &inputs,
         std::vector<std::string> const &outputs = { });
+
+public:
+    /*
+     * If a setting is one that differs for each input or output of a tool,
+     * rather than being the same for every use of the tool in a target.
+     */
+    static bool
+    IsFileSetting(std::string const &setting);
 };
 
 }
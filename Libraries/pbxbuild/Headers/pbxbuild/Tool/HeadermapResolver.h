@@ -13,6 +13,7 @@
 #include <pbxbuild/Base.h>
 #include <pbxbuild/Tool/Invocation.h>
 #include <pbxbuild/Phase/Environment.h>
+#include <pbxbuild/Tool/ProjectHeaders.h>
 
 namespace pbxbuild {
 namespace Tool {
@@ -22,12 +23,13 @@ class Context;
 
 class HeadermapResolver {
 private:
-    pbxspec::PBX::Tool::shared_ptr     _tool;
-    pbxspec::PBX::Compiler::shared_ptr _compiler;
-    pbxspec::Manager::shared_ptr       _specManager;
+    pbxspec::PBX::Tool::shared_ptr               _tool;
+    pbxspec::PBX::Compiler::shared_ptr           _compiler;
+    pbxspec::Manager::shared_ptr                 _specManager;
+    std::shared_ptr<Tool::ProjectHeaders::Cache> _projectHeaders;
 
 public:
-    HeadermapResolver(pbxspec::PBX::Tool::shared_ptr const &tool, pbxspec::PBX::Compiler::shared_ptr const &compiler, pbxspec::Manager::shared_ptr const &specManager);
+    HeadermapResolver(pbxspec::PBX::Tool::shared_ptr const &tool, pbxspec::PBX::Compiler::shared_ptr const &compiler, pbxspec::Manager::shared_ptr const &specManager, std::shared_ptr<Tool::ProjectHeaders::Cache> const &projectHeaders);
 
 public:
     void resolve(
@@ -27,10 +27,13 @@ private:
     explicit InterfaceBuilderResolver(pbxspec::PBX::Compiler::shared_ptr const &tool);
 
 public:
+    /*
+     * Compile groups of files, batching groups that can share a run.
+     */
     void resolve(
         Tool::Context *toolContext,
         pbxsetting::Environment const &environment,
-        std::vector<Phase::File> const &input) const;
+        std::vector<std::vector<Phase::File>> const &groups) const;
 
 public:
     static std::string CompilerToolIdentifier()
@@ -74,6 +74,13 @@ public:
     public:
         static AuxiliaryFile Data(std::string const &path, std::vector<uint8_t> const &data, bool executable = false);
         static AuxiliaryFile File(std::string const &path, std::string const &file, bool executable = false);
+
+    public:
+        /*
+         * A response file holding arguments, to be passed as `@path`. Each
+         * argument is quoted on its own line.
+         */
+        static AuxiliaryFile ResponseFile(std::string const &path, std::vector<std::string> const &arguments);
     };
 
 public:
@@ -140,10 +147,43 @@ public:
         Determine(std::string const &executable);
     };
 
+public:
+    /*
+     * Where the invocation falls in the build of its target, relative to the
+     * targets it depends on and the targets that depend on it.
+     */
+    enum class Stage {
+        /*
+         * Needs its target's dependencies to have finished building.
+         */
+        Default,
+        /*
+         * Compiles sources, which only needs the headers, module maps and
+         * Swift modules of its target's dependencies.
+         */
+        Compile,
+        /*
+         * Compiles sources like above, but also creates modules that the
+         * dependents of its target compile against.
+         */
+        CompileInterface,
+        /*
+         * Creates the target's product from what was compiled. Dependents of
+         * its target only need the product once they link.
+         */
+        Link,
+        /*
+         * Creates debug symbols from the target's product. Nothing in the
+         * build reads them, so dependents of its target don't wait for it.
+         */
+        Debug,
+    };
+
 private:
+    std::string                                  _toolIdentifier;
     ext::optional<Executable>                    _executable;
     std::vector<std::string>                     _arguments;
-    std::unordered_map<std::string, std::string> _environment;
+    std::shared_ptr<std::unordered_map<std::string, std::string> const> _environment;
     std::string                                  _workingDirectory;
 
 private:
@@ -165,18 +205,40 @@ private:
 
 private:
     bool                                         _createsProductStructure;
+    Stage                                        _stage;
+    bool                                         _alwaysOutOfDate;
+    bool                                         _keepsUnchangedOutputs;
+
+private:
+    ext::optional<std::string>                   _actionCacheCommand;
 
 public:
     Invocation();
+    Invocation(Invocation const &) = default;
+    Invocation(Invocation &&) = default;
     ~Invocation();
 
+public:
+    Invocation &operator=(Invocation const &) = default;
+    Invocation &operator=(Invocation &&) = default;
+
+public:
+    /*
+     * The specification identifier of the tool the invocation runs, if it
+     * came from one. Executors can treat tools differently by it.
+     */
+    std::string const &toolIdentifier() const
+    { return _toolIdentifier; }
+    std::string &toolIdentifier()
+    { return _toolIdentifier; }
+
 public:
     ext::optional<Executable> const &executable() const
     { return _executable; }
     std::vector<std::string> const &arguments() const
     { return _arguments; }
     std::unordered_map<std::string, std::string> const &environment() const
-    { return _environment; }
+    { return *_environment; }
     std::string const &workingDirectory() const
     { return _workingDirectory; }
 
@@ -185,11 +247,20 @@ public:
     { return _executable; }
     std::vector<std::string> &arguments()
     { return _arguments; }
-    std::unordered_map<std::string, std::string> &environment()
-    { return _environment; }
     std::string &workingDirectory()
     { return _workingDirectory; }
 
+public:
+    /*
+     * The environment is shared with other invocations using the same
+     * variables (see `Tool::Context::environment()`), so it is replaced
+     * rather than modified.
+     */
+    std::shared_ptr<std::unordered_map<std::string, std::string> const> const &sharedEnvironment() const
+    { return _environment; }
+    std::shared_ptr<std::unordered_map<std::string, std::string> const> &sharedEnvironment()
+    { return _environment; }
+
 public:
     std::vector<std::string> const &inputs() const
     { return _inputs; }
@@ -254,6 +325,58 @@ public:
 public:
     bool &createsProductStructure()
     { return _createsProductStructure; }
+
+public:
+    Stage stage() const
+    { return _stage; }
+    Stage &stage()
+    { return _stage; }
+
+public:
+    /*
+     * If the invocation runs on every build, even when its outputs are
+     * newer than its inputs.
+     */
+    bool alwaysOutOfDate() const
+    { return _alwaysOutOfDate; }
+    bool &alwaysOutOfDate()
+    { return _alwaysOutOfDate; }
+
+    /*
+     * If the invocation leaves outputs whose contents didn't change as they
+     * were. What reads those outputs doesn't need to run again after it.
+     */
+    bool keepsUnchangedOutputs() const
+    { return _keepsUnchangedOutputs; }
+    bool &keepsUnchangedOutputs()
+    { return _keepsUnchangedOutputs; }
+
+public:
+    /*
+     * Identifies the command in the action cache in place of its full
+     * command line, for invocations whose outputs depend on only part of it.
+     * Outputs cached this way are shared between invocations with the same
+     * identity, and restored wherever each one writes them.
+     */
+    ext::optional<std::string> const &actionCacheCommand() const
+    { return _actionCacheCommand; }
+    ext::optional<std::string> &actionCacheCommand()
+    { return _actionCacheCommand; }
+
+public:
+    /*
+     * A digest of the command the invocation runs: its executable, ordered
+     * arguments, environment (in any order), and working directory. The
+     * digest is stable across runs.
+     */
+    std::string commandFingerprint() const;
+
+    /*
+     * A digest of the command as above, plus the paths the invocation reads
+     * and writes: its inputs, input dependencies, and outputs, each in any
+     * order. Identifies what the invocation builds, not just how.
+     */
+    std::string fingerprint() const;
 };
 
 }
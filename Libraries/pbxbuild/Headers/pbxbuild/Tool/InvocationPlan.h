@@ -0,0 +1,64 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxbuild_Tool_InvocationPlan_h
+#define __pbxbuild_Tool_InvocationPlan_h
+
+#include <pbxbuild/Base.h>
+#include <pbxbuild/Tool/Invocation.h>
+
+namespace libutil { class Filesystem; }
+
+namespace pbxbuild {
+namespace Tool {
+
+/*
+ * The invocations planned for a target, saved in a compact binary form so
+ * a later build can load them instead of planning the target again. A plan
+ * records a fingerprint of everything planning used; it's only loaded by a
+ * build with the same fingerprint.
+ */
+class InvocationPlan {
+private:
+    InvocationPlan();
+    ~InvocationPlan();
+
+public:
+    /*
+     * Serialize invocations along with the fingerprint they were planned for.
+     * Invocations sharing an environment still share it once loaded.
+     */
+    static std::vector<uint8_t>
+    Serialize(std::string const &fingerprint, std::vector<Tool::Invocation> const &invocations);
+
+    /*
+     * Load serialized invocations. Fails if the data is invalid, was written
+     * by a different version, or was planned for a different fingerprint.
+     */
+    static ext::optional<std::vector<Tool::Invocation>>
+    Deserialize(std::string const &fingerprint, uint8_t const *data, size_t size);
+
+public:
+    /*
+     * Write a plan to a path. The directory must already exist.
+     */
+    static bool
+    Save(libutil::Filesystem *filesystem, std::string const &path, std::string const &fingerprint, std::vector<Tool::Invocation> const &invocations);
+
+    /*
+     * Read a plan from a path, mapping it rather than copying it in.
+     */
+    static ext::optional<std::vector<Tool::Invocation>>
+    Load(libutil::Filesystem const *filesystem, std::string const &path, std::string const &fingerprint);
+};
+
+}
+}
+
+#endif // !__pbxbuild_Tool_InvocationPlan_h
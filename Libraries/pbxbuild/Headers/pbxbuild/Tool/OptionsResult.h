@@ -11,7 +11,10 @@
 #define __pbxbuild_Tool_OptionsResult_h
 
 #include <pbxbuild/Base.h>
+#include <pbxbuild/Tool/SearchPaths.h>
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -24,6 +27,30 @@ namespace Tool {
 class Environment;
 
 class OptionsResult {
+public:
+    /*
+     * Options evaluated for earlier files, kept for later files using the
+     * same tool. Most options are the same for every file in a target, so
+     * only options referring to a file's input or output settings are
+     * evaluated again for each file. A cache is for one tool in one target;
+     * within it, options are kept by file type, variant and architecture.
+     */
+    class Cache {
+    private:
+        struct Option;
+
+    private:
+        std::mutex                                                                   _mutex;
+        std::unordered_map<std::string, std::shared_ptr<std::vector<Option> const>> _options;
+
+    public:
+        Cache();
+        ~Cache();
+
+    private:
+        friend class OptionsResult;
+    };
+
 private:
     std::vector<std::string>                     _arguments;
     std::unordered_map<std::string, std::string> _environment;
@@ -47,12 +74,16 @@ public:
         std::string const &workingDirectory,
         std::vector<pbxspec::PBX::PropertyOption::shared_ptr> const &options,
         pbxspec::PBX::FileType::shared_ptr const &fileType,
-        std::unordered_set<std::string> const &deletedSettings = std::unordered_set<std::string>());
+        std::unordered_set<std::string> const &deletedSettings = std::unordered_set<std::string>(),
+        Tool::SearchPaths::RecursiveCache *recursiveCache = nullptr,
+        Cache *cache = nullptr);
 
     static OptionsResult Create(
         Tool::Environment const &toolEnvironment,
         std::string const &workingDirectory,
-        pbxspec::PBX::FileType::shared_ptr const &fileType);
+        pbxspec::PBX::FileType::shared_ptr const &fileType,
+        Tool::SearchPaths::RecursiveCache *recursiveCache = nullptr,
+        Cache *cache = nullptr);
 };
 
 }
@@ -0,0 +1,121 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxbuild_Tool_ProjectHeaders_h
+#define __pbxbuild_Tool_ProjectHeaders_h
+
+#include <pbxbuild/Base.h>
+
+#include <mutex>
+
+namespace pbxsetting { class Environment; }
+
+namespace pbxbuild {
+namespace Tool {
+
+/*
+ * The headers in a project that go into the header maps of its targets:
+ * every header file referenced by the project, and the headers built by
+ * each of its targets. The header maps that are the same for every target
+ * in the project are written once here, too.
+ */
+class ProjectHeaders {
+public:
+    /*
+     * A header in the headers phase of a target.
+     */
+    struct TargetHeader {
+        std::string fileName;
+        std::string fileDirectory;
+        std::string frameworkName;
+        bool        isPublicOrPrivate;
+        bool        isNonFramework;
+    };
+
+    /*
+     * Project headers for each project and set of source tree paths, found
+     * once and shared by every target in the build. Safe to use from
+     * multiple threads.
+     */
+    class Cache {
+    private:
+        std::mutex                                                             _mutex;
+        std::unordered_map<std::string, std::shared_ptr<ProjectHeaders const>> _projectHeaders;
+
+    public:
+        Cache();
+
+    public:
+        /*
+         * The headers of a project, with paths expanded in an environment.
+         */
+        std::shared_ptr<ProjectHeaders const>
+        projectHeaders(pbxspec::Manager::shared_ptr const &specManager, pbxsetting::Environment const &environment, pbxproj::PBX::Project::shared_ptr const &project);
+    };
+
+private:
+    std::vector<std::pair<std::string, std::string>>                                 _projectFiles;
+    std::unordered_map<pbxproj::PBX::Target::shared_ptr, std::vector<TargetHeader>> _targetHeaders;
+    std::vector<TargetHeader>                                                        _frameworkHeaders;
+
+private:
+    std::vector<uint8_t> _projectHeadermap;
+    std::vector<uint8_t> _allTargetHeadermap;
+    std::vector<uint8_t> _allNonFrameworkTargetHeadermap;
+
+public:
+    ProjectHeaders();
+
+public:
+    /*
+     * Every header file in the project, as file name and directory.
+     */
+    std::vector<std::pair<std::string, std::string>> const &projectFiles() const
+    { return _projectFiles; }
+
+    /*
+     * The headers built by a target.
+     */
+    std::vector<TargetHeader> const &targetHeaders(pbxproj::PBX::Target::shared_ptr const &target) const;
+
+    /*
+     * The public and private headers of all targets.
+     */
+    std::vector<TargetHeader> const &frameworkHeaders() const
+    { return _frameworkHeaders; }
+
+public:
+    /*
+     * Serialized header map of every header file in the project.
+     */
+    std::vector<uint8_t> const &projectHeadermap() const
+    { return _projectHeadermap; }
+
+    /*
+     * Serialized header map of the public and private headers of all
+     * targets, by framework name.
+     */
+    std::vector<uint8_t> const &allTargetHeadermap() const
+    { return _allTargetHeadermap; }
+
+    /*
+     * As above, but only for targets that aren't frameworks.
+     */
+    std::vector<uint8_t> const &allNonFrameworkTargetHeadermap() const
+    { return _allNonFrameworkTargetHeadermap; }
+
+public:
+    static ProjectHeaders
+    Create(pbxspec::Manager::shared_ptr const &specManager, pbxsetting::Environment const &environment, pbxproj::PBX::Project::shared_ptr const &project);
+};
+
+}
+}
+
+#endif // !__pbxbuild_Tool_ProjectHeaders_h
@@ -16,6 +16,8 @@
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/File.h>
 
+namespace libutil { class Filesystem; }
+
 namespace pbxbuild {
 namespace Tool {
 
@@ -35,6 +37,7 @@ public:
         pbxproj::PBX::LegacyTarget::shared_ptr const &legacyTarget) const;
     void resolve(
         Tool::Context *toolContext,
+        libutil::Filesystem const *filesystem,
         pbxsetting::Environment const &environment,
         pbxproj::PBX::ShellScriptBuildPhase::shared_ptr const &buildPhase) const;
     void resolve(
@@ -46,6 +49,19 @@ public:
     pbxspec::PBX::Tool::shared_ptr const &tool() const
     { return _tool; }
 
+public:
+    /*
+     * The paths listed in a file list, one per line, with build settings
+     * expanded and relative paths resolved. Blank lines and lines starting
+     * with `#` are skipped. Nothing if the file list can't be read.
+     */
+    static ext::optional<std::vector<std::string>>
+    FileListPaths(
+        libutil::Filesystem const *filesystem,
+        pbxsetting::Environment const &environment,
+        std::string const &workingDirectory,
+        std::string const &path);
+
 public:
     static std::string ToolIdentifier()
     { return "com.apple.commands.shell-script"; }
@@ -12,6 +12,9 @@
 
 #include <pbxbuild/Base.h>
 
+#include <mutex>
+
+namespace libutil { class Filesystem; }
 namespace pbxsetting { class Environment; }
 
 namespace pbxbuild {
@@ -20,18 +23,44 @@ namespace Tool {
 class Context;
 
 class SearchPaths {
+public:
+    /*
+     * Directories found below the roots of recursive search paths. Each
+     * root is only walked once, then shared by every target in the build
+     * that searches it. Safe to use from multiple threads.
+     */
+    class RecursiveCache {
+    private:
+        std::mutex                                                                       _mutex;
+        std::unordered_map<std::string, std::shared_ptr<std::vector<std::string> const>> _subdirectories;
+
+    public:
+        RecursiveCache();
+
+    public:
+        /*
+         * The directories below an absolute root, relative to the root.
+         */
+        std::shared_ptr<std::vector<std::string> const>
+        subdirectories(libutil::Filesystem const *filesystem, std::string const &root);
+    };
+
 private:
-    std::vector<std::string> _headerSearchPaths;
-    std::vector<std::string> _userHeaderSearchPaths;
-    std::vector<std::string> _frameworkSearchPaths;
-    std::vector<std::string> _librarySearchPaths;
+    std::vector<std::string>        _headerSearchPaths;
+    std::vector<std::string>        _userHeaderSearchPaths;
+    std::vector<std::string>        _frameworkSearchPaths;
+    std::vector<std::string>        _librarySearchPaths;
+
+private:
+    std::shared_ptr<RecursiveCache> _recursiveCache;
 
 public:
     SearchPaths(
         std::vector<std::string> const &headerSearchPaths,
         std::vector<std::string> const &userHeaderSearchPaths,
         std::vector<std::string> const &frameworkSearchPaths,
-        std::vector<std::string> const &librarySearchPaths);
+        std::vector<std::string> const &librarySearchPaths,
+        std::shared_ptr<RecursiveCache> const &recursiveCache = nullptr);
 
 public:
     std::vector<std::string> const &headerSearchPaths(void) const
@@ -43,13 +72,20 @@ public:
     std::vector<std::string> const &librarySearchPaths(void) const
     { return _librarySearchPaths; }
 
+public:
+    /*
+     * The cache used to expand these search paths, if any.
+     */
+    std::shared_ptr<RecursiveCache> const &recursiveCache(void) const
+    { return _recursiveCache; }
+
 public:
     static Tool::SearchPaths
-    Create(pbxsetting::Environment const &environment, std::string const &workingDirectory);
+    Create(pbxsetting::Environment const &environment, std::string const &workingDirectory, std::shared_ptr<RecursiveCache> const &recursiveCache = nullptr);
 
 public:
     static std::vector<std::string>
-    ExpandRecursive(std::vector<std::string> const &paths, pbxsetting::Environment const &environment, std::string const &workingDirectory);
+    ExpandRecursive(std::vector<std::string> const &paths, pbxsetting::Environment const &environment, std::string const &workingDirectory, RecursiveCache *recursiveCache = nullptr);
 };
 
 }
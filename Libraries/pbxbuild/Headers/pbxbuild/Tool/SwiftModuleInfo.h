@@ -13,6 +13,8 @@
 #include <pbxbuild/Base.h>
 #include <pbxbuild/Tool/PrecompiledHeaderInfo.h>
 
+#include <ext/optional>
+
 namespace pbxbuild {
 namespace Tool {
 
@@ -27,9 +29,10 @@ private:
     std::string _moduleName;
 
 private:
-    std::string _modulePath;
-    std::string _docPath;
-    std::string _headerPath;
+    std::string                _modulePath;
+    std::string                _docPath;
+    ext::optional<std::string> _interfacePath;
+    std::string                _headerPath;
 
 private:
     bool        _installHeader;
@@ -40,6 +43,7 @@ public:
         std::string const &moduleName,
         std::string const &modulePath,
         std::string const &docPath,
+        ext::optional<std::string> const &interfacePath,
         std::string const &headerPath,
         bool installHeader);
 
@@ -70,6 +74,12 @@ public:
     std::string const &docPath() const
     { return _docPath; }
 
+    /*
+     * The path to the textual Swift module interface, if one is output.
+     */
+    ext::optional<std::string> const &interfacePath() const
+    { return _interfacePath; }
+
     /*
      * The path to the Objective-C header output by Swift.
      */
@@ -31,10 +31,16 @@ public:
     { return _tool; }
 
 public:
+    /*
+     * Touch `input` once its `dependencies` are built. The `refreshed` files
+     * are touched first, for outputs of other invocations that should stay
+     * newer than files changed after them.
+     */
     void resolve(
         Tool::Context *toolContext,
         std::string const &input,
-        std::vector<std::string> const &dependencies) const;
+        std::vector<std::string> const &dependencies,
+        std::vector<std::string> const &refreshed) const;
 
 public:
     static std::string ToolIdentifier()
@@ -27,26 +27,30 @@ namespace pbxbuild {
  *  - All of the available projects (including nested projects).
  *  - The build root, where workspace-relative paths are based.
  *  - Where outputs go in derived data (i.e. OBJROOT).
+ *
+ * Projects are loaded the first time they are looked up, along with their
+ * configuration files and schemes. Copies of a context share what it loads.
  */
 class WorkspaceContext {
+private:
+    struct Loader;
+
 private:
     std::string                                    _basePath;
     DerivedDataHash                                _derivedDataHash;
     xcworkspace::XC::Workspace::shared_ptr         _workspace;
     pbxproj::PBX::Project::shared_ptr              _project;
-    std::vector<xcscheme::SchemeGroup::shared_ptr> _schemeGroups;
-    std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> _projects;
-    std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> _configs;
+    std::shared_ptr<Loader>                        _loader;
 
-public:
+private:
     WorkspaceContext(
         std::string const &basePath,
         DerivedDataHash const &derivedDataHash,
         xcworkspace::XC::Workspace::shared_ptr const &workspace,
         pbxproj::PBX::Project::shared_ptr const &project,
-        std::vector<xcscheme::SchemeGroup::shared_ptr> const &schemeGroups,
-        std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> const &projects,
-        std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> const &configs);
+        std::shared_ptr<Loader> const &loader);
+
+public:
     ~WorkspaceContext();
 
 public:
@@ -78,27 +82,27 @@ public:
 public:
     /*
      * All scheme groups for the workspace itself and any projects in the workspace.
+     * Loads every project in the workspace, including nested projects.
      */
-    std::vector<xcscheme::SchemeGroup::shared_ptr> const &schemeGroups() const
-    { return _schemeGroups; }
+    std::vector<xcscheme::SchemeGroup::shared_ptr> const &schemeGroups() const;
 
     /*
      * All projects, including the root project, workspace projects, and nested projects.
+     * Loads every project in the workspace, including nested projects.
      */
-    std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> const &projects() const
-    { return _projects; }
+    std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> const &projects() const;
 
     /*
-     * All configuration files, including for all loaded projects and targets.
+     * The configuration file for a build configuration in a loaded project, if any.
      */
-    std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> const &configs() const
-    { return _configs; }
+    ext::optional<pbxsetting::XC::Config>
+    config(pbxproj::XC::BuildConfiguration::shared_ptr const &buildConfiguration) const;
 
 public:
     /*
      * Find a project in the workspace. Could be the root project (for a legacy build), a project
      * referenced by the workspace (with a real workspace), or a nested project in any of those.
-     * project referenced by the workspace.
+     * Loads the project if it has not been loaded yet.
      */
     pbxproj::PBX::Project::shared_ptr
     project(std::string const &projectPath) const;
@@ -106,14 +110,15 @@ public:
     /*
      * Find a scheme from inside the workspace. For real workspaces, schemes
      * are searched in the workspace itself as well as projects in the workspace.
+     * Nested projects are only loaded if the scheme is not found otherwise.
      */
     xcscheme::XC::Scheme::shared_ptr
-    scheme(std::string const &name) const;
+    scheme(std::string const &name, xcscheme::SchemeGroup::shared_ptr *schemeGroup = nullptr) const;
 
 public:
     /*
      * All loaded files in the workspace. Includes files loaded for the workspace itself, any
-     * projects inside the workspace, and all schemes in the workspace or projects inside it.
+     * projects loaded so far, and all schemes in the workspace or those projects.
      */
     std::vector<std::string> loadedFilePaths() const;
 
@@ -8,9 +8,71 @@
  */
 
 #include <pbxbuild/Build/Context.h>
+#include <libutil/Statistic.h>
+
+#include <atomic>
 
 namespace Build = pbxbuild::Build;
 namespace Target = pbxbuild::Target;
+using libutil::Statistic;
+
+static Statistic TargetEnvironmentLookups("pbxbuild", "Target environment lookups");
+static Statistic TargetEnvironmentHits("pbxbuild", "Target environment cache hits", &TargetEnvironmentLookups);
+static Statistic TargetEnvironmentEvictions("pbxbuild", "Target environment evictions", &TargetEnvironmentLookups);
+static Statistic TargetEnvironmentTime("pbxbuild", "Create target environment");
+
+static std::atomic<size_t> TargetEnvironmentCapacity(0);
+
+Build::Context::TargetEnvironmentCache::
+TargetEnvironmentCache(size_t capacity) :
+    _cache(capacity)
+{
+}
+
+ext::optional<Target::Environment> Build::Context::TargetEnvironmentCache::
+find(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (Target::Environment const *targetEnvironment = _cache.find(target)) {
+        return *targetEnvironment;
+    }
+
+    return ext::nullopt;
+}
+
+Target::Environment Build::Context::TargetEnvironmentCache::
+insert(pbxproj::PBX::Target::shared_ptr const &target, Target::Environment const &targetEnvironment)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t evictions = _cache.evictions();
+    Target::Environment const &cached = _cache.insert(target, targetEnvironment);
+    for (size_t n = evictions; n < _cache.evictions(); ++n) {
+        TargetEnvironmentEvictions.increment();
+    }
+
+    return cached;
+}
+
+size_t Build::Context::TargetEnvironmentCache::
+size()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _cache.size();
+}
+
+size_t Build::Context::TargetEnvironmentCache::
+DefaultCapacity()
+{
+    return TargetEnvironmentCapacity.load();
+}
+
+void Build::Context::TargetEnvironmentCache::
+SetDefaultCapacity(size_t capacity)
+{
+    TargetEnvironmentCapacity.store(capacity);
+}
 
 Build::Context::
 Context(
@@ -22,30 +84,42 @@ Context(
     bool defaultConfiguration,
     std::vector<pbxsetting::Level> const &overrideLevels
 ) :
-    _workspaceContext    (workspaceContext),
-    _scheme              (scheme),
-    _schemeGroup         (schemeGroup),
-    _action              (action),
-    _configuration       (configuration),
-    _defaultConfiguration(defaultConfiguration),
-    _overrideLevels      (overrideLevels),
-    _targetEnvironments  (std::make_shared<std::unordered_map<pbxproj::PBX::Target::shared_ptr, Target::Environment>>())
+    _workspaceContext       (workspaceContext),
+    _scheme                 (scheme),
+    _schemeGroup            (schemeGroup),
+    _action                 (action),
+    _configuration          (configuration),
+    _defaultConfiguration   (defaultConfiguration),
+    _overrideLevels         (overrideLevels),
+    _targetEnvironments     (std::make_shared<TargetEnvironmentCache>(TargetEnvironmentCache::DefaultCapacity())),
+    _recursiveSearchPaths   (std::make_shared<Tool::SearchPaths::RecursiveCache>()),
+    _projectHeaders         (std::make_shared<Tool::ProjectHeaders::Cache>())
 {
 }
 
 ext::optional<pbxbuild::Target::Environment> Build::Context::
 targetEnvironment(Build::Environment const &buildEnvironment, pbxproj::PBX::Target::shared_ptr const &target) const
 {
-    auto TEI = _targetEnvironments->find(target);
-    if (TEI != _targetEnvironments->end()) {
-        return TEI->second;
-    } else {
-        ext::optional<Target::Environment> targetEnvironment = Target::Environment::Create(buildEnvironment, *this, target);
-        if (targetEnvironment) {
-            _targetEnvironments->insert(std::make_pair(target, *targetEnvironment));
-        }
-        return targetEnvironment;
+    TargetEnvironmentLookups.increment();
+
+    if (ext::optional<Target::Environment> cached = _targetEnvironments->find(target)) {
+        TargetEnvironmentHits.increment();
+        return cached;
+    }
+
+    /*
+     * Create the environment without holding the lock, so targets can be
+     * resolved in parallel. If another thread got there first, use its.
+     */
+    ext::optional<Target::Environment> targetEnvironment;
+    {
+        Statistic::Timer timer(&TargetEnvironmentTime);
+        targetEnvironment = Target::Environment::Create(buildEnvironment, *this, target);
+    }
+    if (targetEnvironment) {
+        return _targetEnvironments->insert(target, *targetEnvironment);
     }
+    return targetEnvironment;
 }
 
 pbxproj::PBX::Target::shared_ptr Build::Context::
@@ -55,14 +129,7 @@ resolveTargetIdentifier(pbxproj::PBX::Project::shared_ptr const &project, std::s
         return nullptr;
     }
 
-    pbxproj::PBX::Target::shared_ptr foundTarget = nullptr;
-    for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
-        if (target->blueprintIdentifier() == identifier) {
-            return target;
-        }
-    }
-
-    return nullptr;
+    return project->target(identifier);
 }
 
 ext::optional<std::pair<pbxproj::PBX::Target::shared_ptr, pbxproj::PBX::FileReference::shared_ptr>> Build::Context::
@@ -72,17 +139,13 @@ resolveProductIdentifier(pbxproj::PBX::Project::shared_ptr const &project, std::
         return ext::nullopt;
     }
 
-    pbxproj::PBX::Target::shared_ptr foundTarget = nullptr;
-    for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
-        if (target->type() == pbxproj::PBX::Target::Type::Native) {
-            pbxproj::PBX::NativeTarget::shared_ptr nativeTarget = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target);
-            if (nativeTarget->productReference() != nullptr && nativeTarget->productReference()->blueprintIdentifier() == identifier) {
-                return std::make_pair(target, nativeTarget->productReference());
-            }
-        }
+    pbxproj::PBX::Target::shared_ptr target = project->productTarget(identifier);
+    if (target == nullptr) {
+        return ext::nullopt;
     }
 
-    return ext::nullopt;
+    pbxproj::PBX::NativeTarget::shared_ptr nativeTarget = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target);
+    return std::make_pair(target, nativeTarget->productReference());
 }
 
 pbxsetting::Level Build::Context::
@@ -10,6 +10,8 @@
 #include <pbxbuild/Build/DependencyResolver.h>
 #include <pbxbuild/Target/Environment.h>
 
+#include <algorithm>
+
 #define DEPENDENCY_RESOLVER_LOGGING 0
 
 namespace Build = pbxbuild::Build;
@@ -21,8 +23,9 @@ using xcscheme::XC::BuildAction;
 using xcscheme::XC::BuildActionEntry;
 
 Build::DependencyResolver::
-DependencyResolver(Build::Environment const &buildEnvironment) :
-    _buildEnvironment(buildEnvironment)
+DependencyResolver(Build::Environment const &buildEnvironment, Prebuilt const &prebuilt) :
+    _buildEnvironment(buildEnvironment),
+    _prebuilt        (prebuilt)
 {
 }
 
@@ -46,7 +49,7 @@ ResolveContainerItemProxy(Build::Environment const &buildEnvironment, Build::Con
         return nullptr;
     }
 
-    std::string path = targetEnvironment->environment().expand(fileReference->resolve());
+    std::string path = targetEnvironment->path(fileReference.get());
 
     pbxproj::PBX::Project::shared_ptr project = context.workspaceContext().project(path);
     if (productReference) {
@@ -62,15 +65,92 @@ ResolveContainerItemProxy(Build::Environment const &buildEnvironment, Build::Con
     }
 }
 
+static std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr>
+BuildProductPathsToTargets(WorkspaceContext const &workspaceContext)
+{
+    std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr> productNameToTarget;
+
+    /*
+     * Build a mapping of product path -> target, in order to look up implicit dependencies
+     * where the product paths match, but the dependency is not through a container portal.
+     */
+    for (auto const &pair : workspaceContext.projects()) {
+        for (pbxproj::PBX::Target::shared_ptr const &target : pair.second->targets()) {
+            if (target->type() != pbxproj::PBX::Target::Type::Native) {
+                /* Only native targets have products. */
+                continue;
+            }
+
+            pbxproj::PBX::NativeTarget::shared_ptr nativeTarget = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target);
+            pbxproj::PBX::FileReference::shared_ptr const &productReference = nativeTarget->productReference();
+
+            if (productReference != nullptr) {
+                /* Use the product name because we can't resolve the path yet. */
+                std::string productName = productReference->name();
+#if DEPENDENCY_RESOLVER_LOGGING
+                fprintf(stderr, "debug: product output: %s %s => %s\n", target->blueprintIdentifier().c_str(), target->name().c_str(), productName.c_str());
+#endif
+                productNameToTarget.insert({ productName, nativeTarget });
+            }
+        }
+    }
+
+    return productNameToTarget;
+}
+
 struct DependenciesContext {
     Build::Environment const *buildEnvironment;
     Build::Context     const *buildContext;
     DirectedGraph<pbxproj::PBX::Target::shared_ptr> *graph;
     BuildAction::shared_ptr buildAction;
     std::unordered_set<pbxproj::PBX::Target::shared_ptr> *positional;
-    std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr> *productNameToTarget;
+    ext::optional<std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr>> *productNameToTarget;
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> *visited;
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> const *requested;
+    Build::DependencyResolver::Prebuilt const *prebuilt;
 };
 
+/*
+ * If a dependency can use the product of a previous build instead. The
+ * requested targets are always built, even when others depend on them.
+ */
+static bool
+DependencyPrebuilt(DependenciesContext const &context, pbxproj::PBX::Target::shared_ptr const &target)
+{
+    if (*context.prebuilt == nullptr || context.requested->find(target) != context.requested->end()) {
+        return false;
+    }
+
+    if ((*context.prebuilt)(target)) {
+#if DEPENDENCY_RESOLVER_LOGGING
+        fprintf(stderr, "debug: prebuilt dependency: %s %s\n", target->blueprintIdentifier().c_str(), target->name().c_str());
+#endif
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * If a target was requested by its target or product name.
+ */
+static bool
+TargetNamed(pbxproj::PBX::Target::shared_ptr const &target, std::vector<std::string> const &names)
+{
+    if (std::find(names.begin(), names.end(), target->name()) != names.end()) {
+        return true;
+    }
+
+    if (target->type() == pbxproj::PBX::Target::Type::Native) {
+        pbxproj::PBX::NativeTarget::shared_ptr nativeTarget = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target);
+        if (nativeTarget->productReference() != nullptr) {
+            return std::find(names.begin(), names.end(), nativeTarget->productReference()->name()) != names.end();
+        }
+    }
+
+    return false;
+}
+
 static void
 AddDependencies(DependenciesContext const &context, pbxproj::PBX::Target::shared_ptr const &target);
 
@@ -94,6 +174,10 @@ AddImplicitDependencies(DependenciesContext const &context, pbxproj::PBX::Target
 
                     pbxproj::PBX::Target::shared_ptr proxiedTarget = ResolveContainerItemProxy(*context.buildEnvironment, *context.buildContext, target, proxy->remoteRef(), true);
                     if (proxiedTarget != nullptr) {
+                        if (DependencyPrebuilt(context, proxiedTarget)) {
+                            break;
+                        }
+
                         dependencies.insert(proxiedTarget);
 
 #if DEPENDENCY_RESOLVER_LOGGING
@@ -112,9 +196,18 @@ AddImplicitDependencies(DependenciesContext const &context, pbxproj::PBX::Target
                     pbxproj::PBX::FileReference::shared_ptr fileReference = std::static_pointer_cast<pbxproj::PBX::FileReference>(file->fileRef());
                     std::string name = fileReference->name();
 
-                    auto it = context.productNameToTarget->find(name);
-                    if (it != context.productNameToTarget->end()) {
+                    /* Only create the product path mapping once it's used: it needs every project loaded. */
+                    if (!*context.productNameToTarget) {
+                        *context.productNameToTarget = BuildProductPathsToTargets(context.buildContext->workspaceContext());
+                    }
+
+                    auto it = (*context.productNameToTarget)->find(name);
+                    if (it != (*context.productNameToTarget)->end()) {
                         pbxproj::PBX::Target::shared_ptr dependentTarget = it->second;
+                        if (DependencyPrebuilt(context, dependentTarget)) {
+                            break;
+                        }
+
                         dependencies.insert(dependentTarget);
 
 #if DEPENDENCY_RESOLVER_LOGGING
@@ -149,6 +242,10 @@ AddExplicitDependencies(DependenciesContext const &context, pbxproj::PBX::Target
     for (pbxproj::PBX::TargetDependency::shared_ptr const &dependency : target->dependencies()) {
         if (dependency->target() != nullptr) {
             /* A dependency for another target in the same project. */
+            if (DependencyPrebuilt(context, dependency->target())) {
+                continue;
+            }
+
             dependencies.insert(dependency->target());
 
 #if DEPENDENCY_RESOLVER_LOGGING
@@ -161,6 +258,10 @@ AddExplicitDependencies(DependenciesContext const &context, pbxproj::PBX::Target
             /* A dependency referencing a target in another project. Get that target. */
             pbxproj::PBX::Target::shared_ptr proxiedTarget = ResolveContainerItemProxy(*context.buildEnvironment, *context.buildContext, target, dependency->targetProxy(), false);
             if (proxiedTarget != nullptr) {
+                if (DependencyPrebuilt(context, proxiedTarget)) {
+                    continue;
+                }
+
                 dependencies.insert(proxiedTarget);
 
 #if DEPENDENCY_RESOLVER_LOGGING
@@ -185,6 +286,11 @@ AddExplicitDependencies(DependenciesContext const &context, pbxproj::PBX::Target
 static void
 AddDependencies(DependenciesContext const &context, pbxproj::PBX::Target::shared_ptr const &target)
 {
+    /* Targets reached along several paths only need their dependencies added once. */
+    if (!context.visited->insert(target).second) {
+        return;
+    }
+
     /* If there's no build action, this is a legacy context which always have implicit dependencies. */
     if (context.buildAction == nullptr || context.buildAction->buildImplicitDependencies()) {
         AddImplicitDependencies(context, target);
@@ -211,41 +317,8 @@ AddDependencies(DependenciesContext const &context, pbxproj::PBX::Target::shared
     }
 }
 
-static std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr>
-BuildProductPathsToTargets(WorkspaceContext const &workspaceContext)
-{
-    std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr> productNameToTarget;
-
-    /*
-     * Build a mapping of product path -> target, in order to look up implicit dependencies
-     * where the product paths match, but the dependency is not through a container portal.
-     */
-    for (auto const &pair : workspaceContext.projects()) {
-        for (pbxproj::PBX::Target::shared_ptr const &target : pair.second->targets()) {
-            if (target->type() != pbxproj::PBX::Target::Type::Native) {
-                /* Only native targets have products. */
-                continue;
-            }
-
-            pbxproj::PBX::NativeTarget::shared_ptr nativeTarget = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target);
-            pbxproj::PBX::FileReference::shared_ptr const &productReference = nativeTarget->productReference();
-
-            if (productReference != nullptr) {
-                /* Use the product name because we can't resolve the path yet. */
-                std::string productName = productReference->name();
-#if DEPENDENCY_RESOLVER_LOGGING
-                fprintf(stderr, "debug: product output: %s %s => %s\n", target->blueprintIdentifier().c_str(), target->name().c_str(), productName.c_str());
-#endif
-                productNameToTarget.insert({ productName, nativeTarget });
-            }
-        }
-    }
-
-    return productNameToTarget;
-}
-
 DirectedGraph<pbxproj::PBX::Target::shared_ptr> Build::DependencyResolver::
-resolveSchemeDependencies(Build::Context const &context) const
+resolveSchemeDependencies(Build::Context const &context, ext::optional<std::vector<std::string>> const &targetNames) const
 {
     DirectedGraph<pbxproj::PBX::Target::shared_ptr> graph;
 
@@ -261,20 +334,33 @@ resolveSchemeDependencies(Build::Context const &context) const
         return graph;
     }
 
-    /* Only create the product path mapping if we have implicit dependencies on to use it. */
-    std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr> productNameToTarget;
-    if (buildAction->buildImplicitDependencies()) {
-        productNameToTarget = BuildProductPathsToTargets(context.workspaceContext());
-    }
+    /*
+     * Testing builds the entries marked for testing and the test bundles
+     * themselves; other actions build the entries marked for running.
+     */
+    bool testing = (context.action() == "build-for-testing" || context.action() == "test");
 
-    std::unordered_set<pbxproj::PBX::Target::shared_ptr> positional;
+    std::vector<xcscheme::XC::BuildableReference::shared_ptr> references;
     for (BuildActionEntry::shared_ptr const &entry : buildAction->buildActionEntries()) {
-        // TODO(grp): Check the buildFor* flags against the Build::Context.
-        if (!entry->buildForRunning()) {
+        if (testing ? !entry->buildForTesting() : !entry->buildForRunning()) {
             continue;
         }
 
-        xcscheme::XC::BuildableReference::shared_ptr const &reference = entry->buildableReference();
+        references.push_back(entry->buildableReference());
+    }
+
+    if (testing && scheme->testAction() != nullptr) {
+        for (xcscheme::XC::TestableReference::shared_ptr const &testable : scheme->testAction()->testables()) {
+            if (!testable->skipped()) {
+                references.push_back(testable->buildableReference());
+            }
+        }
+    }
+
+    /* Find the requested targets first, so none is left out as a prebuilt dependency of another. */
+    std::vector<pbxproj::PBX::Target::shared_ptr> targets;
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> requested;
+    for (xcscheme::XC::BuildableReference::shared_ptr const &reference : references) {
         if (reference == nullptr) {
             fprintf(stderr, "warning: couldn't find buildable reference in scheme\n");
             continue;
@@ -306,6 +392,30 @@ resolveSchemeDependencies(Build::Context const &context) const
             }
         }
 
+        if (targetNames && !TargetNamed(target, *targetNames)) {
+            /* Building specific targets, and not this one. */
+            continue;
+        }
+
+        if (requested.insert(target).second) {
+            targets.push_back(target);
+        }
+    }
+
+    if (targetNames) {
+        for (std::string const &name : *targetNames) {
+            if (std::none_of(targets.begin(), targets.end(), [&](pbxproj::PBX::Target::shared_ptr const &target) { return TargetNamed(target, { name }); })) {
+                fprintf(stderr, "warning: couldn't find target '%s' in scheme\n", name.c_str());
+            }
+        }
+    }
+
+    /* The product path mapping is created when an implicit dependency first needs it. */
+    ext::optional<std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr>> productNameToTarget;
+
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> positional;
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> visited;
+    for (pbxproj::PBX::Target::shared_ptr const &target : targets) {
         DependenciesContext dependenciesContext = {
             .buildEnvironment = &_buildEnvironment,
             .buildContext     = &context,
@@ -313,6 +423,9 @@ resolveSchemeDependencies(Build::Context const &context) const
             .buildAction = buildAction,
             .positional = &positional,
             .productNameToTarget = &productNameToTarget,
+            .visited = &visited,
+            .requested = &requested,
+            .prebuilt = &_prebuilt,
         };
         AddDependencies(dependenciesContext, target);
     }
@@ -341,12 +454,10 @@ resolveLegacyDependencies(Build::Context const &context, bool allTargets, ext::o
         return graph;
     }
 
-    auto productNameToTarget = BuildProductPathsToTargets(context.workspaceContext());
-
-    std::unordered_set<pbxproj::PBX::Target::shared_ptr> positional;
+    std::vector<pbxproj::PBX::Target::shared_ptr> targets;
     for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
         if (!allTargets) {
-            if (targetNames && std::find(targetNames->begin(), targetNames->end(), target->name()) == targetNames->end()) {
+            if (targetNames && !TargetNamed(target, *targetNames)) {
                 /* Building specific targets, and not this one. */
                 continue;
             } else if (!targetNames && target != project->targets().front()) {
@@ -355,6 +466,15 @@ resolveLegacyDependencies(Build::Context const &context, bool allTargets, ext::o
             }
         }
 
+        targets.push_back(target);
+    }
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> requested = std::unordered_set<pbxproj::PBX::Target::shared_ptr>(targets.begin(), targets.end());
+
+    ext::optional<std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr>> productNameToTarget;
+
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> positional;
+    std::unordered_set<pbxproj::PBX::Target::shared_ptr> visited;
+    for (pbxproj::PBX::Target::shared_ptr const &target : targets) {
         DependenciesContext dependenciesContext = {
             .buildEnvironment = &_buildEnvironment,
             .buildContext     = &context,
@@ -362,6 +482,9 @@ resolveLegacyDependencies(Build::Context const &context, bool allTargets, ext::o
             .buildAction = nullptr,
             .positional = &positional,
             .productNameToTarget = &productNameToTarget,
+            .visited = &visited,
+            .requested = &requested,
+            .prebuilt = &_prebuilt,
         };
         AddDependencies(dependenciesContext, target);
     }
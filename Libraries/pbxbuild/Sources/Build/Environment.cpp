@@ -13,15 +13,49 @@
 #include <pbxsetting/DefaultSettings.h>
 #include <pbxsetting/Environment.h>
 #include <libutil/Filesystem.h>
+#include <libutil/Statistic.h>
 
 namespace Build = pbxbuild::Build;
 using libutil::Filesystem;
+using libutil::Statistic;
+
+static Statistic LevelLookups("pbxbuild", "Specification level lookups");
+static Statistic LevelHits("pbxbuild", "Specification level cache hits", &LevelLookups);
+
+pbxsetting::Level Build::Environment::LevelCache::
+level(std::string const &key, std::function<pbxsetting::Level()> const &create)
+{
+    LevelLookups.increment();
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _levels.find(key);
+        if (it != _levels.end()) {
+            LevelHits.increment();
+            return it->second;
+        }
+    }
+
+    /* Made outside the lock; if another thread made it first, use theirs. */
+    pbxsetting::Level level = create();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _levels.insert({ key, level }).first->second;
+}
+
+size_t Build::Environment::LevelCache::
+size()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _levels.size();
+}
 
 Build::Environment::
 Environment(pbxspec::Manager::shared_ptr const &specManager, std::shared_ptr<xcsdk::SDK::Manager> const &sdkManager, pbxsetting::Environment const &baseEnvironment) :
     _specManager(specManager),
     _sdkManager(sdkManager),
-    _baseEnvironment(baseEnvironment)
+    _baseEnvironment(baseEnvironment),
+    _levels(std::make_shared<LevelCache>())
 {
 }
 
@@ -10,92 +10,198 @@
 #include <pbxbuild/DirectedGraph.h>
 #include <pbxbuild/Tool/Invocation.h>
 
-#include <algorithm>
-#include <cassert>
-
 using pbxbuild::DirectedGraph;
 
+template<class T>
+size_t DirectedGraph<T>::
+insertNode(T const &node)
+{
+    auto result = _indexes.insert({ node, _nodes.size() });
+    if (result.second) {
+        _nodes.push_back(node);
+        _adjacency.emplace_back();
+    }
+
+    return result.first->second;
+}
+
 template<class T>
 void DirectedGraph<T>::
 insert(T const &node, std::unordered_set<T> const &adjacent)
 {
-    _nodes.insert(node);
-    _nodes.insert(adjacent.begin(), adjacent.end());
+    size_t index = insertNode(node);
 
-    auto it = _adjacency.find(node);
-    if (it == _adjacency.end()) {
-        _adjacency.insert(std::make_pair(node, adjacent));
+    for (T const &other : adjacent) {
+        size_t otherIndex = insertNode(other);
+
+        /* Each edge is only stored once. */
+        uint64_t edge = (static_cast<uint64_t>(index) << 32) | static_cast<uint64_t>(otherIndex);
+        if (_edges.insert(edge).second) {
+            _adjacency[index].push_back(otherIndex);
+        }
+    }
+}
+
+template<class T>
+ext::optional<size_t> DirectedGraph<T>::
+index(T const &node) const
+{
+    auto it = _indexes.find(node);
+    if (it != _indexes.end()) {
+        return it->second;
     } else {
-        it->second.insert(adjacent.begin(), adjacent.end());
+        return ext::nullopt;
     }
 }
 
 template<class T>
-std::unordered_set<T> const &DirectedGraph<T>::
-nodes() const
+DirectedGraph<T> DirectedGraph<T>::
+dependents(std::vector<size_t> const &indexes) const
 {
-    return _nodes;
+    /* Reverse the edges to walk from each node to what depends on it. */
+    std::vector<std::vector<size_t>> dependents = std::vector<std::vector<size_t>>(_nodes.size());
+    for (size_t index = 0; index < _nodes.size(); ++index) {
+        for (size_t adjacentIndex : _adjacency[index]) {
+            dependents[adjacentIndex].push_back(index);
+        }
+    }
+
+    std::vector<bool> selected = std::vector<bool>(_nodes.size(), false);
+    std::vector<size_t> pending = indexes;
+    while (!pending.empty()) {
+        size_t index = pending.back();
+        pending.pop_back();
+
+        if (!selected[index]) {
+            selected[index] = true;
+            pending.insert(pending.end(), dependents[index].begin(), dependents[index].end());
+        }
+    }
+
+    /* Insert the nodes first, so adjacent nodes don't change their order. */
+    DirectedGraph<T> graph;
+    for (size_t index = 0; index < _nodes.size(); ++index) {
+        if (selected[index]) {
+            graph.insertNode(_nodes[index]);
+        }
+    }
+
+    for (size_t index = 0; index < _nodes.size(); ++index) {
+        if (selected[index]) {
+            std::unordered_set<T> adjacent;
+            for (size_t adjacentIndex : _adjacency[index]) {
+                if (selected[adjacentIndex]) {
+                    adjacent.insert(_nodes[adjacentIndex]);
+                }
+            }
+            graph.insert(_nodes[index], adjacent);
+        }
+    }
+
+    return graph;
 }
 
 template<class T>
-std::unordered_set<T> DirectedGraph<T>::
+std::vector<T> DirectedGraph<T>::
 adjacent(T const &node) const
 {
-    auto it = _adjacency.find(node);
-    if (it != _adjacency.end()) {
-        return it->second;
-    } else {
-        return std::unordered_set<T>();
+    std::vector<T> result;
+
+    auto it = _indexes.find(node);
+    if (it != _indexes.end()) {
+        result.reserve(_adjacency[it->second].size());
+        for (size_t index : _adjacency[it->second]) {
+            result.push_back(_nodes[index]);
+        }
     }
+
+    return result;
 }
 
 template<class T>
 ext::optional<std::vector<T>> DirectedGraph<T>::
 ordered(void) const
 {
+    ext::optional<std::vector<std::vector<size_t>>> levels = this->levels();
+    if (!levels) {
+        return ext::nullopt;
+    }
+
     std::vector<T> result;
+    result.reserve(_nodes.size());
+
+    for (std::vector<size_t> const &level : *levels) {
+        for (size_t index : level) {
+            result.push_back(_nodes[index]);
+        }
+    }
 
-    std::list<T> toExplore;
-    std::transform(_adjacency.begin(), _adjacency.end(), std::back_inserter(toExplore), [](std::pair<T, std::unordered_set<T>> const &pair) {
-        return pair.first;
-    });
+    return result;
+}
 
-    std::unordered_set<T> inProgress;
-    std::unordered_set<T> explored;
+template<class T>
+ext::optional<std::vector<std::vector<size_t>>> DirectedGraph<T>::
+levels(void) const
+{
+    size_t count = _nodes.size();
+
+    /*
+     * Invert the edges into a compact table: the nodes that depend on
+     * node `i` are `dependents[offsets[i]]` through `dependents[offsets[i + 1]]`.
+     */
+    std::vector<size_t> offsets = std::vector<size_t>(count + 1, 0);
+    for (std::vector<size_t> const &adjacency : _adjacency) {
+        for (size_t index : adjacency) {
+            offsets[index + 1]++;
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
 
-    while (!toExplore.empty()) {
-        T node = toExplore.front();
-        if (explored.find(node) != explored.end()) {
-            toExplore.pop_front();
-            continue;
+    std::vector<size_t> dependents = std::vector<size_t>(offsets[count]);
+    std::vector<size_t> next = std::vector<size_t>(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t index : _adjacency[i]) {
+            dependents[next[index]++] = i;
         }
+    }
 
-        size_t stack = toExplore.size();
-        inProgress.insert(node);
+    /*
+     * Remove nodes with nothing left to wait for, one level at a time.
+     */
+    std::vector<size_t> remaining = std::vector<size_t>(count);
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < count; ++i) {
+        remaining[i] = _adjacency[i].size();
+        if (remaining[i] == 0) {
+            ready.push_back(i);
+        }
+    }
 
-        auto it = _adjacency.find(node);
-        if (it != _adjacency.end()) {
-            for (T const &child : it->second) {
-                if (inProgress.find(child) != inProgress.end()) {
-                    return ext::nullopt;
-                }
+    std::vector<std::vector<size_t>> result;
+    size_t sorted = 0;
 
-                if (explored.find(child) == explored.end()) {
-                    toExplore.push_front(child);
-                    break;
+    while (!ready.empty()) {
+        std::vector<size_t> level;
+        for (size_t index : ready) {
+            for (size_t j = offsets[index]; j < offsets[index + 1]; ++j) {
+                if (--remaining[dependents[j]] == 0) {
+                    level.push_back(dependents[j]);
                 }
             }
         }
 
-        if (stack == toExplore.size()) {
-            toExplore.pop_front();
-            inProgress.erase(node);
-            explored.insert(node);
-            result.push_back(node);
-        }
+        sorted += ready.size();
+        result.push_back(std::move(ready));
+        ready = std::move(level);
+    }
+
+    /* Any nodes never ready are in a cycle. */
+    if (sorted != count) {
+        return ext::nullopt;
     }
 
-    assert(inProgress.empty());
     return result;
 }
 
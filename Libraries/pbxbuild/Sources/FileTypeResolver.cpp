@@ -13,8 +13,11 @@
 #include <libutil/FSUtil.h>
 #include <libutil/Wildcard.h>
 
+#include <algorithm>
 #include <cassert>
-#include <strings.h>
+#include <iterator>
+#include <map>
+#include <mutex>
 
 using pbxbuild::FileTypeResolver;
 using pbxbuild::DirectedGraph;
@@ -38,27 +41,141 @@ SortedFileTypes(std::vector<pbxspec::PBX::FileType::shared_ptr> const &fileTypes
     return graph.ordered();
 }
 
+static std::string
+LowercaseExtension(std::string const &extension)
+{
+    // TODO(grp): Is this correct? Needed for handling ".S" as ".s", but might be over-broad.
+    std::string lowercase = extension;
+    std::transform(lowercase.begin(), lowercase.end(), lowercase.begin(), [](char c) {
+        return static_cast<char>(::tolower(static_cast<unsigned char>(c)));
+    });
+    return lowercase;
+}
+
+namespace {
+
+/*
+ * The file types in a set of domains, sorted so more specific file types are
+ * first, and indexed by extension so only the file types that could match a
+ * path's extension are checked. Each file type's filename patterns are
+ * compiled once, in the same order as the file types.
+ */
+struct Matcher {
+    std::vector<pbxspec::PBX::FileType::shared_ptr>          fileTypes;
+    std::vector<Wildcard::PatternSet>                        filenamePatterns;
+    std::unordered_map<std::string, std::vector<size_t>>     extensions;
+    std::vector<size_t>                                      unextended;
+};
+
+}
+
+static std::shared_ptr<Matcher const>
+CreateMatcher(std::vector<pbxspec::PBX::FileType::shared_ptr> const &fileTypes)
+{
+    ext::optional<std::vector<pbxspec::PBX::FileType::shared_ptr>> sortedFileTypes = SortedFileTypes(fileTypes);
+    if (!sortedFileTypes) {
+        return nullptr;
+    }
+
+    auto matcher = std::make_shared<Matcher>();
+    matcher->fileTypes = std::move(*sortedFileTypes);
+    matcher->filenamePatterns.reserve(matcher->fileTypes.size());
+
+    for (size_t i = 0; i < matcher->fileTypes.size(); ++i) {
+        pbxspec::PBX::FileType::shared_ptr const &fileType = matcher->fileTypes[i];
+        if (fileType->filenamePatterns()) {
+            matcher->filenamePatterns.emplace_back(*fileType->filenamePatterns());
+        } else {
+            matcher->filenamePatterns.emplace_back();
+        }
+
+        if (!fileType->extensions()) {
+            matcher->unextended.push_back(i);
+            continue;
+        }
+
+        for (std::string const &extension : *fileType->extensions()) {
+            std::vector<size_t> &indexes = matcher->extensions[LowercaseExtension(extension)];
+            if (indexes.empty() || indexes.back() != i) {
+                indexes.push_back(i);
+            }
+        }
+    }
+
+    return matcher;
+}
+
+/*
+ * Sorting the file types is slow and they don't change once specifications are
+ * loaded, so the matcher for each manager and set of domains is shared.
+ */
+static std::shared_ptr<Matcher const>
+SharedMatcher(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains)
+{
+    struct Entry {
+        std::weak_ptr<pbxspec::Manager> manager;
+        std::shared_ptr<Matcher const>  matcher;
+    };
+
+    /* Never freed, so the cache is usable until exit. */
+    static std::mutex *mutex = new std::mutex();
+    static auto *matchers = new std::map<std::pair<pbxspec::Manager const *, std::vector<std::string>>, Entry>();
+
+    auto key = std::make_pair(specManager.get(), domains);
+
+    {
+        std::lock_guard<std::mutex> lock(*mutex);
+
+        /* A different manager could be at the same address once the first is freed. */
+        auto it = matchers->find(key);
+        if (it != matchers->end() && it->second.manager.lock() == specManager) {
+            return it->second.matcher;
+        }
+    }
+
+    std::shared_ptr<Matcher const> matcher = CreateMatcher(specManager->fileTypes(domains));
+    if (matcher == nullptr) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(*mutex);
+    (*matchers)[key] = { specManager, matcher };
+    return matcher;
+}
+
 pbxspec::PBX::FileType::shared_ptr FileTypeResolver::
 Resolve(Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &domains, std::string const &filePath)
 {
-    bool isReadable = filesystem->isReadable(filePath);
-    bool isFolder = isReadable && filesystem->isDirectory(filePath);
+    /* Everything checked about the file comes from one lookup. */
+    ext::optional<Filesystem::Metadata> metadata = filesystem->metadata(filePath);
+    bool isReadable = (metadata && metadata->readable);
+    bool isFolder = isReadable && metadata->directory;
 
-    std::string fileExtension = FSUtil::GetFileExtension(filePath);
+    std::string fileExtension = LowercaseExtension(FSUtil::GetFileExtension(filePath));
     std::string fileName = FSUtil::GetBaseName(filePath);
 
     std::vector<uint8_t> fileContents;
 
-    /* Reverse first so more specific file types are processed first. */
-    std::vector<pbxspec::PBX::FileType::shared_ptr> const &fileTypes = specManager->fileTypes(domains);
-    ext::optional<std::vector<pbxspec::PBX::FileType::shared_ptr>> result = SortedFileTypes(fileTypes);
-    if (!result) {
+    std::shared_ptr<Matcher const> matcher = SharedMatcher(specManager, domains);
+    if (matcher == nullptr) {
         fprintf(stderr, "error: cycle creating file type graph\n");
         return nullptr;
     }
 
-    std::vector<pbxspec::PBX::FileType::shared_ptr> const &sortedFileTypes = *result;
-    for (pbxspec::PBX::FileType::shared_ptr const &fileType : sortedFileTypes) {
+    /*
+     * Only file types with the path's extension or without any extensions can
+     * match. Merge the two so file types are still checked most specific first.
+     */
+    static std::vector<size_t> const noIndexes;
+    auto EI = matcher->extensions.find(fileExtension);
+    std::vector<size_t> const &extended = (EI != matcher->extensions.end() ? EI->second : noIndexes);
+
+    std::vector<size_t> candidates;
+    candidates.reserve(extended.size() + matcher->unextended.size());
+    std::merge(extended.begin(), extended.end(), matcher->unextended.begin(), matcher->unextended.end(), std::back_inserter(candidates));
+
+    for (size_t index : candidates) {
+        pbxspec::PBX::FileType::shared_ptr const &fileType = matcher->fileTypes[index];
         if (isReadable && fileType->isFolder() != isFolder) {
             continue;
         }
@@ -66,19 +183,8 @@ Resolve(Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specMa
         bool empty = true;
 
         if (fileType->extensions()) {
+            /* Only candidates with a matching extension have extensions. */
             empty = false;
-            bool matched = false;
-
-            for (std::string const &extension : *fileType->extensions()) {
-                // TODO(grp): Is this correct? Needed for handling ".S" as ".s", but might be over-broad.
-                if (strcasecmp(extension.c_str(), fileExtension.c_str()) == 0) {
-                    matched = true;
-                }
-            }
-
-            if (!matched) {
-                continue;
-            }
         }
 
 
@@ -99,15 +205,8 @@ Resolve(Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specMa
 
         if (fileType->filenamePatterns()) {
             empty = false;
-            bool matched = false;
 
-            for (std::string const &pattern : *fileType->filenamePatterns()) {
-                if (Wildcard::Match(pattern, fileName)) {
-                    matched = true;
-                }
-            }
-
-            if (!matched) {
+            if (!matcher->filenamePatterns[index].match(fileName)) {
                 continue;
             }
         }
@@ -120,9 +219,9 @@ Resolve(Filesystem const *filesystem, pbxspec::Manager::shared_ptr const &specMa
             if (permissions == "read") {
                 matched = isReadable;
             } else if (permissions == "write") {
-                matched = filesystem->isWritable(filePath);
+                matched = metadata->writable;
             } else if (permissions == "executable") {
-                matched = filesystem->isExecutable(filePath);
+                matched = metadata->executable;
             } else {
                 fprintf(stderr, "warning: unhandled permission %s\n", permissions.c_str());
             }
@@ -11,7 +11,6 @@
 
 #include <algorithm>
 #include <cstring>
-#include <map>
 
 using pbxbuild::HeaderMap;
 
@@ -27,111 +26,136 @@ CanonicalizeKey(std::string const &key)
 }
 
 HeaderMap::HeaderMap() :
-    _modified(false)
+    _maxValueLength(0)
 {
-    ::memset(&_header, 0, sizeof(_header));
-
-    //
-    // Initially we set to 8 buckets.
-    //
-    _header.NumBuckets = 8;
-    _buckets.resize(_header.NumBuckets);
 }
 
 bool HeaderMap::
-read(std::vector<uint8_t> const &buffer)
+read(uint8_t const *contents, size_t size)
 {
-    if (buffer.size() < sizeof(HMapHeader)) {
+    invalidate();
+
+    if (size < sizeof(HMapHeader)) {
         return false;
     }
 
-    memcpy((void *)&_header, (void *)buffer.data(), sizeof(HMapHeader));
+    HMapHeader header;
+    memcpy((void *)&header, (void const *)contents, sizeof(HMapHeader));
 
     //
     // TODO Reverse endian
     //
-    if (_header.Magic != HMAP_HeaderMagicNumber ||
-        _header.Version != HMAP_HeaderVersion ||
-        _header.Reserved != 0 ||
-        _header.StringsOffset > static_cast <uint32_t> (buffer.size())) {
-        invalidate();
+    if (header.Magic != HMAP_HeaderMagicNumber ||
+        header.Version != HMAP_HeaderVersion ||
+        header.Reserved != 0 ||
+        header.StringsOffset > size) {
         return false;
     }
 
-    //
-    // Reset
-    //
-    _offsets.clear();
-    _keys.clear();
+    if ((size - sizeof(HMapHeader)) / sizeof(HMapBucket) < header.NumBuckets) {
+        return false;
+    }
 
     //
-    // Read buckets and strings
+    // Add each bucket's strings straight from the contents, so only the
+    // strings that are used are copied into the pool.
     //
-    _buckets.resize(_header.NumBuckets);
+    char const *strings = reinterpret_cast<char const *>(contents + header.StringsOffset);
+    size_t stringsSize = size - header.StringsOffset;
 
-    if (buffer.size() - sizeof(HMapHeader) < sizeof(HMapBucket) * _header.NumBuckets) {
-        invalidate();
-        return false;
-    }
-    memcpy((void *)_buckets.data(), (void *)(buffer.data() + sizeof(HMapHeader)), sizeof(HMapBucket) * _header.NumBuckets);
+    auto stringAt = [&](uint32_t offset, std::string *string) -> bool {
+        if (offset >= stringsSize) {
+            return false;
+        }
 
-    size_t stringSize = buffer.size() - _header.StringsOffset;
-    _strings.resize(stringSize);
+        size_t length = ::strnlen(strings + offset, stringsSize - offset);
+        if (length == stringsSize - offset) {
+            return false;
+        }
 
-    memcpy((void *)_strings.data(), (void *)(buffer.data() + _header.StringsOffset), stringSize);
+        string->assign(strings + offset, length);
+        return true;
+    };
+
+    std::string key;
+    std::string prefix;
+    std::string suffix;
+    for (uint32_t n = 0; n < header.NumBuckets; n++) {
+        HMapBucket bucket;
+        memcpy((void *)&bucket, (void const *)(contents + sizeof(HMapHeader) + n * sizeof(HMapBucket)), sizeof(HMapBucket));
 
-    //
-    // Now fill _keys and _offsets so that we can manipulate this hmap.
-    //
-    for (auto const &bucket : _buckets) {
         if (bucket.Key == HMAP_EmptyBucketKey)
             continue;
 
-        if (bucket.Key >= _strings.size() ||
-            bucket.Suffix >= _strings.size() ||
-            bucket.Prefix >= _strings.size())
+        if (!stringAt(bucket.Key, &key) ||
+            !stringAt(bucket.Prefix, &prefix) ||
+            !stringAt(bucket.Suffix, &suffix))
             continue;
 
-        _keys.insert(CanonicalizeKey(&_strings[bucket.Key]));
-
-        _offsets.insert(std::make_pair(
-                    &_strings[bucket.Key],
-                    bucket.Key));
-        _offsets.insert(std::make_pair(
-                    &_strings[bucket.Prefix],
-                    bucket.Prefix));
-        _offsets.insert(std::make_pair(
-                    &_strings[bucket.Suffix],
-                    bucket.Suffix));
+        add(key, prefix, suffix);
     }
 
-    _modified = false;
-
     return true;
 }
 
-std::vector<uint8_t> HeaderMap::
-write()
+bool HeaderMap::
+read(std::vector<uint8_t> const &buffer)
 {
-    std::vector<uint8_t> buffer;
+    return read(buffer.data(), buffer.size());
+}
 
-    if (_modified) {
-        rehash(_header.NumBuckets);
+std::vector<HMapBucket> HeaderMap::
+buckets() const
+{
+    //
+    // Size the table once, keeping it under 3/4 full.
+    //
+    uint32_t numBuckets = 8;
+    while (_entries.size() >= (numBuckets * 3) / 4) {
+        numBuckets <<= 1;
     }
 
-    _header.Magic         = HMAP_HeaderMagicNumber;
-    _header.Version       = HMAP_HeaderVersion;
-    _header.Reserved      = 0;
-    _header.StringsOffset = sizeof(_header) + _header.NumBuckets * sizeof(HMapBucket);
+    std::vector<HMapBucket> buckets;
+    buckets.resize(numBuckets);
 
-    buffer.resize(sizeof(HMapHeader) + _header.NumBuckets * sizeof(HMapBucket) + _strings.size());
+    //
+    // Place entries by linear probing; the bucket count is a power of 2.
+    //
+    for (Entry const &entry : _entries) {
+        uint32_t n = entry.hash & (numBuckets - 1);
+        while (buckets[n].Key != HMAP_EmptyBucketKey) {
+            n = (n + 1) & (numBuckets - 1);
+        }
+        buckets[n] = entry.bucket;
+    }
+
+    return buckets;
+}
+
+std::vector<uint8_t> HeaderMap::
+write() const
+{
+    std::vector<HMapBucket> buckets = this->buckets();
+
+    HMapHeader header;
+    ::memset(&header, 0, sizeof(header));
+    header.Magic          = HMAP_HeaderMagicNumber;
+    header.Version        = HMAP_HeaderVersion;
+    header.Reserved       = 0;
+    header.StringsOffset  = sizeof(header) + buckets.size() * sizeof(HMapBucket);
+    header.NumEntries     = _entries.size();
+    header.NumBuckets     = buckets.size();
+    header.MaxValueLength = _maxValueLength;
+
+    std::vector<uint8_t> buffer;
+    buffer.resize(header.StringsOffset + _strings.size());
 
     //
-    // Write buckets and strings
+    // Write header, buckets and strings
     //
-    memcpy((void *)(buffer.data()), (void *)&_header, sizeof(HMapHeader));
-    memcpy((void *)(buffer.data() + sizeof(HMapHeader)), (void *)_buckets.data(), _header.NumBuckets * sizeof(HMapBucket));
-    memcpy((void *)(buffer.data() + _header.StringsOffset), (void *)_strings.data(), _strings.size());
+    memcpy((void *)(buffer.data()), (void const *)&header, sizeof(HMapHeader));
+    memcpy((void *)(buffer.data() + sizeof(HMapHeader)), (void const *)buckets.data(), buckets.size() * sizeof(HMapBucket));
+    memcpy((void *)(buffer.data() + header.StringsOffset), (void const *)_strings.data(), _strings.size());
 
     return buffer;
 }
@@ -139,12 +163,11 @@ write()
 void HeaderMap::
 invalidate()
 {
-    ::memset(&_header, 0, sizeof(_header));
-    _buckets.clear();
+    _entries.clear();
     _strings.clear();
     _offsets.clear();
     _keys.clear();
-    _modified = false;
+    _maxValueLength = 0;
 }
 
 bool HeaderMap::
@@ -154,88 +177,27 @@ add(std::string const &key, std::string const &prefix, std::string const &suffix
         return false; // invalid argument
     }
 
-    if (_keys.find(CanonicalizeKey(key)) != _keys.end()) {
+    if (!_keys.insert(CanonicalizeKey(key)).second) {
         // already exists
         return false;
     }
 
-    //
-    // Lookup key offset, if none, add one.
-    //
-    auto KI = add(key, true);
-
-    //
-    // Lookup prefix offset, if none, add one.
-    //
-    auto PI = add(prefix, false);
+    Entry entry;
+    entry.hash          = HashHMapKey(key);
+    entry.bucket.Key    = string(key);
+    entry.bucket.Prefix = string(prefix);
+    entry.bucket.Suffix = string(suffix);
+    _entries.push_back(entry);
 
-    //
-    // Lookup suffix offset, if none, add one.
-    //
-    auto SI = add(suffix, false);
-
-    //
-    // Now let the table grow by one item, if needed.
-    //
-    grow();
-
-    //
-    // Find the bucket for this key.
-    //
-    unsigned hash = HashHMapKey(key) % _header.NumBuckets;
-    set(hash, KI->second, PI->second, SI->second, false);
-    if (key.length() > _header.MaxValueLength) {
-        _header.MaxValueLength = key.length();
+    if (key.length() > _maxValueLength) {
+        _maxValueLength = key.length();
     }
 
-    _modified = true;
-
     return true;
 }
 
-void HeaderMap::
-grow()
-{
-    //
-    // Grow at 3/4 of buckets
-    //
-    if (_header.NumEntries + 1 >= (_header.NumBuckets * 3) / 4) {
-        //
-        // Resize and rehash
-        //
-        rehash(_header.NumBuckets << 1);
-    }
-}
-
-void HeaderMap::
-rehash(uint32_t newNumBuckets)
-{
-    std::vector <HMapBucket> buckets;
-
-    buckets.resize(newNumBuckets);
-    _buckets.swap(buckets);
-
-    std::multimap <uint32_t, HMapBucket *> rehashed;
-
-    for (size_t n = 0; n < _header.NumBuckets; n++) {
-        if (buckets[n].Key == HMAP_EmptyBucketKey)
-            continue;
-
-        unsigned hash = HashHMapKey(&_strings[buckets[n].Key]) % newNumBuckets;
-        rehashed.insert(std::make_pair(hash, &buckets[n]));
-    }
-
-    for (auto BI : rehashed) {
-        set(BI.first, BI.second->Key, BI.second->Prefix, BI.second->Suffix, true);
-    }
-
-    _header.NumBuckets = newNumBuckets;
-
-    _modified = false;
-}
-
-std::unordered_map<std::string, size_t>::iterator HeaderMap::
-add(std::string const &string, bool key)
+uint32_t HeaderMap::
+string(std::string const &string)
 {
     auto I = _offsets.find(string);
     if (I == _offsets.end()) {
@@ -248,57 +210,29 @@ add(std::string const &string, bool key)
         }
 
         size_t offset = _strings.size();
-        _strings.resize(offset + string.length() + 1);
-        ::memcpy(&_strings[offset], &string[0], string.length() + 1);
+        _strings.insert(_strings.end(), string.c_str(), string.c_str() + string.length() + 1);
 
         I = _offsets.insert(std::make_pair(string, offset)).first;
-
-        if (key) {
-            //
-            // store key
-            //
-            _keys.insert(CanonicalizeKey(string));
-        }
     }
-    return I;
+    return I->second;
 }
 
 void HeaderMap::
-set(unsigned hash, uint32_t koff, uint32_t poff, uint32_t soff, bool growing)
+dump() const
 {
-    for (size_t n = hash; n != (hash - 1); n = (n + 1) % _header.NumBuckets) {
-        if (_buckets[n].Key == HMAP_EmptyBucketKey) {
-            _buckets[n].Key    = koff;
-            _buckets[n].Prefix = poff;
-            _buckets[n].Suffix = soff;
-            if (!growing) {
-                _header.NumEntries++;
-            }
-            break;
-        }
-    }
-}
+    std::vector<HMapBucket> buckets = this->buckets();
 
-void HeaderMap::
-dump()
-{
-    fprintf(stderr, "Num Entries = %u Num Buckets = %u Strings Offset = %#x\n",
-            _header.NumEntries, _header.NumBuckets, _header.StringsOffset);
+    fprintf(stderr, "Num Entries = %zu Num Buckets = %zu Strings Offset = %#zx\n",
+            _entries.size(), buckets.size(), sizeof(HMapHeader) + buckets.size() * sizeof(HMapBucket));
 
-    for (size_t n = 0; n < _buckets.size(); n++) {
-        if (_buckets[n].Key == HMAP_EmptyBucketKey)
+    for (size_t n = 0; n < buckets.size(); n++) {
+        if (buckets[n].Key == HMAP_EmptyBucketKey)
             continue;
 
-        if (_buckets[n].Key >= _strings.size() ||
-            _buckets[n].Suffix >= _strings.size() ||
-            _buckets[n].Prefix >= _strings.size()) {
-            fprintf(stderr, "Bucket #%zu: broken\n", n);
-        } else {
-            fprintf(stderr,
-                    "Bucket #%zu: [%u] Key = '%s' Prefix = '%s' Suffix = '%s'\n",
-                    n, HashHMapKey(&_strings[_buckets[n].Key]) % _header.NumBuckets,
-                    &_strings[_buckets[n].Key], &_strings[_buckets[n].Prefix],
-                    &_strings[_buckets[n].Suffix]);
-        }
+        fprintf(stderr,
+                "Bucket #%zu: [%zu] Key = '%s' Prefix = '%s' Suffix = '%s'\n",
+                n, HashHMapKey(&_strings[buckets[n].Key]) % buckets.size(),
+                &_strings[buckets[n].Key], &_strings[buckets[n].Prefix],
+                &_strings[buckets[n].Suffix]);
     }
 }
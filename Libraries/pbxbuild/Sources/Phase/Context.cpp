@@ -11,6 +11,7 @@
 #include <pbxbuild/Tool/Context.h>
 #include <pbxbuild/Tool/AssetCatalogResolver.h>
 #include <pbxbuild/Tool/ClangResolver.h>
+#include <pbxbuild/Tool/CodeSignResolver.h>
 #include <pbxbuild/Tool/CopyResolver.h>
 #include <pbxbuild/Tool/DittoResolver.h>
 #include <pbxbuild/Tool/InfoPlistResolver.h>
@@ -24,8 +25,12 @@
 #include <pbxbuild/Target/Environment.h>
 #include <pbxbuild/Target/BuildRules.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 
+#include <algorithm>
 #include <cassert>
+#include <functional>
+#include <unordered_map>
 
 namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
@@ -63,6 +68,16 @@ clangResolver(Phase::Environment const &phaseEnvironment)
     return _clangResolver.get();
 }
 
+Tool::CodeSignResolver const *Phase::Context::
+codeSignResolver(Phase::Environment const &phaseEnvironment)
+{
+    if (_codeSignResolver == nullptr) {
+        _codeSignResolver = Tool::CodeSignResolver::Create(phaseEnvironment);
+    }
+
+    return _codeSignResolver.get();
+}
+
 Tool::CopyResolver const *Phase::Context::
 copyResolver(Phase::Environment const &phaseEnvironment)
 {
@@ -179,54 +194,74 @@ toolResolver(Phase::Environment const &phaseEnvironment, std::string const &iden
 }
 
 std::vector<std::vector<Phase::File>> Phase::Context::
-Group(std::vector<Phase::File> const &files)
+Group(std::vector<Phase::File> files)
 {
-    std::vector<Phase::File> ungrouped;
-    std::unordered_map<std::string, std::vector<Phase::File>> groupedTool;
-    std::unordered_map<std::string, std::unordered_map<std::string, std::vector<Phase::File>>> groupedCommonBase;
-    std::vector<Phase::File> groupedBaseRegion;
+    /*
+     * Files are grouped by their index, and only moved into their groups
+     * at the end. Keyed groups are kept in the order of their first file.
+     */
+    std::vector<size_t> ungrouped;
+    std::vector<std::vector<size_t>> groupedTool;
+    std::unordered_map<std::string, size_t> groupedToolKeys;
+    std::vector<std::vector<size_t>> groupedCommonBase;
+    std::unordered_map<std::string, size_t> groupedCommonBaseKeys;
+    std::vector<size_t> groupedOutputDirectory;
+    std::vector<size_t> groupedBaseRegion;
+
+    auto addKeyed = [](std::vector<std::vector<size_t>> *groups, std::unordered_map<std::string, size_t> *keys, std::string const &key, size_t index) {
+        auto result = keys->insert({ key, groups->size() });
+        if (result.second) {
+            groups->push_back(std::vector<size_t>());
+        }
+        (*groups)[result.first->second].push_back(index);
+    };
 
     /*
      * Determine which grouping method to use for each file.
      */
-    for (Phase::File const &file : files) {
+    for (size_t index = 0; index < files.size(); ++index) {
+        Phase::File const &file = files[index];
+
         /* Get the tool used for the file. If null, then no grouping possible. */
         Target::BuildRules::BuildRule::shared_ptr const &buildRule = file.buildRule();
         if (buildRule == nullptr || buildRule->tool() == nullptr || buildRule->tool()->type() != pbxspec::PBX::Compiler::Type()) {
-            ungrouped.push_back(file);
+            ungrouped.push_back(index);
             continue;
         }
         pbxspec::PBX::Compiler::shared_ptr const &compiler = std::static_pointer_cast<pbxspec::PBX::Compiler>(buildRule->tool());
 
         /* Determine the grouping. Only a single grouping per file is supported. */
-        std::vector<std::string> const &groupings = compiler->inputFileGroupings().value_or(std::vector<std::string>());
-        if (groupings.size() != 1) {
-            if (!groupings.empty()) {
+        ext::optional<std::vector<std::string>> const &groupings = compiler->inputFileGroupings();
+        if (!groupings || groupings->size() != 1) {
+            if (groupings && !groupings->empty()) {
                 fprintf(stderr, "error: more than one input file grouping is not supported\n");
             }
-            ungrouped.push_back(file);
+            ungrouped.push_back(index);
             continue;
         }
 
-        std::string const &grouping = groupings.front();
+        std::string const &grouping = groupings->front();
 
         if (grouping == "tool") {
             /* Tool groupings are keyed on just the tool. */
-            groupedTool[compiler->identifier()].push_back(file);
+            addKeyed(&groupedTool, &groupedToolKeys, compiler->identifier(), index);
         } else if (grouping == "common-file-base") {
             /* Keyed on both the file name and tool. */
             std::string base = FSUtil::GetBaseNameWithoutExtension(file.path());
-            groupedCommonBase[compiler->identifier()][base].push_back(file);
+            addKeyed(&groupedCommonBase, &groupedCommonBaseKeys, compiler->identifier() + '\0' + base, index);
+        } else if (grouping == "output-directory") {
+            /* Keyed below, as base region groupings can take some of these. */
+            groupedOutputDirectory.push_back(index);
         } else if (grouping == "ib-base-region-and-strings") {
             /* Only "Base" region files. See below for finding additional grouped files. */
             if (file.localization() == "Base") {
-                groupedBaseRegion.push_back(file);
+                groupedBaseRegion.push_back(index);
             } else {
-                ungrouped.push_back(file);
+                ungrouped.push_back(index);
             }
         } else {
             fprintf(stderr, "error: unknown grouping '%s'\n", grouping.c_str());
-            ungrouped.push_back(file);
+            ungrouped.push_back(index);
         }
     }
 
@@ -234,59 +269,139 @@ Group(std::vector<Phase::File> const &files)
      * Build up the result, a list of each set of grouped inputs.
      */
     std::vector<std::vector<Phase::File>> result;
+    result.reserve(groupedTool.size() + groupedCommonBase.size() + groupedBaseRegion.size() + groupedOutputDirectory.size() + ungrouped.size());
+
+    auto addGroup = [&](std::vector<size_t> const &indexes) {
+        std::vector<Phase::File> group;
+        group.reserve(indexes.size());
+        for (size_t index : indexes) {
+            group.push_back(std::move(files[index]));
+        }
+        result.push_back(std::move(group));
+    };
 
     /*
      * Add tool groupings to the result.
      */
-    for (auto const &entry : groupedTool) {
-        result.push_back(entry.second);
+    for (std::vector<size_t> const &group : groupedTool) {
+        addGroup(group);
     }
 
     /*
      * Add common base name groupings to the result.
      */
-    for (auto const &entry1 : groupedCommonBase) {
-        for (auto const &entry2 : entry1.second) {
-            result.push_back(entry2.second);
-        }
+    for (std::vector<size_t> const &group : groupedCommonBase) {
+        addGroup(group);
     }
 
     /*
-     * Add base region groupings to the result.
+     * Add base region groupings to the result. Each takes the .strings files
+     * from the same build file (i.e. same variant group) as the base, so they
+     * don't get added again to the result below.
      */
-    for (Phase::File const &file : groupedBaseRegion) {
-        std::vector<Phase::File> inputs = { file };
-
-        /*
-         * Find all .strings files from the same build file (i.e. same variant group)
-         * as the base. Add them to the inputs for this group, and remove them from
-         * the ungrouped  inputs so they don't get added again to the result.
-         */
-        ungrouped.erase(std::remove_if(ungrouped.begin(), ungrouped.end(), [&](Phase::File const &ungroupedFile) {
-            if (ungroupedFile.fileType()->identifier() == "text.plist.strings") {
-                if (ungroupedFile.buildFile() == file.buildFile()) {
-                    inputs.push_back(ungroupedFile);
-                    return true;
+    std::vector<bool> taken = std::vector<bool>(files.size(), false);
+    if (!groupedBaseRegion.empty()) {
+        std::unordered_map<pbxproj::PBX::BuildFile const *, std::vector<size_t>> stringsFiles;
+        for (std::vector<size_t> const *candidates : { &ungrouped, &groupedOutputDirectory }) {
+            for (size_t index : *candidates) {
+                if (files[index].fileType()->identifier() == "text.plist.strings") {
+                    stringsFiles[files[index].buildFile().get()].push_back(index);
                 }
             }
+        }
 
-            return false;
-        }), ungrouped.end());
+        for (size_t index : groupedBaseRegion) {
+            std::vector<size_t> inputs = { index };
 
-        result.push_back(inputs);
+            auto it = stringsFiles.find(files[index].buildFile().get());
+            if (it != stringsFiles.end()) {
+                for (size_t stringsIndex : it->second) {
+                    if (!taken[stringsIndex]) {
+                        taken[stringsIndex] = true;
+                        inputs.push_back(stringsIndex);
+                    }
+                }
+            }
+
+            addGroup(inputs);
+        }
+    }
+
+    /*
+     * Add output directory groupings to the result, keyed on the tool and the
+     * localization, which picks the output directory. Files are kept in order.
+     */
+    std::vector<std::vector<size_t>> outputDirectoryGroups;
+    std::unordered_map<std::string, size_t> outputDirectoryKeys;
+    for (size_t index : groupedOutputDirectory) {
+        if (!taken[index]) {
+            Phase::File const &file = files[index];
+            addKeyed(&outputDirectoryGroups, &outputDirectoryKeys, file.buildRule()->tool()->identifier() + '\0' + file.localization(), index);
+        }
+    }
+
+    for (std::vector<size_t> const &group : outputDirectoryGroups) {
+        addGroup(group);
     }
 
     /*
      * Add ungrouped files to the result, one grouping per file. Note this must come
-     * after the base region grouping above as the base region modifies the ungrouped.
+     * after the base region grouping above as the base region takes from the ungrouped.
      */
-    for (Phase::File const &file : ungrouped) {
-        result.push_back({ file });
+    for (size_t index : ungrouped) {
+        if (!taken[index]) {
+            addGroup({ index });
+        }
     }
 
     return result;
 }
 
+static std::string
+GroupOutputDirectory(Phase::File const &first, std::string const &outputDirectory)
+{
+    std::string fileOutputDirectory = outputDirectory;
+    if (!first.localization().empty()) {
+        fileOutputDirectory += "/" + first.localization() + ".lproj";
+    }
+    return fileOutputDirectory;
+}
+
+static std::string
+ToolIdentifier(Phase::File const &first, std::string const &fallbackToolIdentifier)
+{
+    std::string toolIdentifier = fallbackToolIdentifier;
+
+    if (Target::BuildRules::BuildRule::shared_ptr const &buildRule = first.buildRule()) {
+        if (pbxspec::PBX::Tool::shared_ptr const &tool = buildRule->tool()) {
+            // Some tools additionally limit their file types beyond what their build rule allows.
+            // For example, the default compiler limits itself to just source files, despite its
+            // default build rule specifying that it accepts all C-family inputs, including headers.
+            // TODO(grp): Is this the right way to make .h files not get compiled as resources?
+            if (tool->fileTypes() || tool->inputFileTypes()) {
+                std::vector<std::string> toolFileTypes;
+                if (tool->fileTypes()) {
+                    toolFileTypes.insert(toolFileTypes.end(), tool->fileTypes()->begin(), tool->fileTypes()->end());
+                }
+                if (tool->inputFileTypes()) {
+                    toolFileTypes.insert(toolFileTypes.end(), tool->inputFileTypes()->begin(), tool->inputFileTypes()->end());
+                }
+
+                std::string inputFileType = first.fileType()->identifier();
+                bool toolAcceptsInputFileType = (toolFileTypes.empty() || std::find(toolFileTypes.begin(), toolFileTypes.end(), inputFileType) != toolFileTypes.end());
+
+                if (toolAcceptsInputFileType) {
+                    toolIdentifier = tool->identifier();
+                }
+            } else {
+                toolIdentifier = tool->identifier();
+            }
+        }
+    }
+
+    return toolIdentifier;
+}
+
 bool Phase::Context::
 resolveBuildFiles(
     Phase::Environment const &phaseEnvironment,
@@ -296,14 +411,77 @@ resolveBuildFiles(
     std::string const &outputDirectory,
     std::string const &fallbackToolIdentifier)
 {
-    for (std::vector<Phase::File> const &files : groups) {
+    std::string copyLogMessageTitle;
+    switch (buildPhase->type()) {
+        case pbxproj::PBX::BuildPhase::Type::Headers:
+            copyLogMessageTitle = "CpHeader";
+        case pbxproj::PBX::BuildPhase::Type::Resources:
+            copyLogMessageTitle = "CpResource";
+        default:
+            copyLogMessageTitle = "PBXCp";
+    }
+
+    /*
+     * The tool and output directory of each group only depend on its files,
+     * so find them for all groups in parallel.
+     */
+    std::vector<std::string> toolIdentifiers = std::vector<std::string>(groups.size());
+    std::vector<std::string> outputDirectories = std::vector<std::string>(groups.size());
+    libutil::Parallel::For(groups.size(), [&](size_t index) {
+        Phase::File const &first = groups[index].front();
+        if ((first.buildRule() != nullptr || !fallbackToolIdentifier.empty()) &&
+            (first.buildRule() == nullptr || first.buildRule()->script().empty())) {
+            toolIdentifiers[index] = ToolIdentifier(first, fallbackToolIdentifier);
+        }
+        outputDirectories[index] = GroupOutputDirectory(first, outputDirectory);
+    });
+
+    /*
+     * Compiling a source file or copying a resource doesn't depend on the
+     * other files, so prepare all of those in parallel. They're added in
+     * order below.
+     */
+    std::vector<size_t> sourceGroups;
+    std::vector<size_t> copyGroups;
+    for (size_t i = 0; i < groups.size(); ++i) {
+        if (toolIdentifiers[i] == Tool::ClangResolver::ToolIdentifier()) {
+            sourceGroups.push_back(i);
+        } else if (toolIdentifiers[i] == Tool::CopyResolver::ToolIdentifier()) {
+            copyGroups.push_back(i);
+        }
+    }
+
+    Tool::ClangResolver const *clangResolver = (!sourceGroups.empty() ? this->clangResolver(phaseEnvironment) : nullptr);
+    Tool::CopyResolver const *copyResolver = (!copyGroups.empty() ? this->copyResolver(phaseEnvironment) : nullptr);
+
+    std::vector<std::unique_ptr<Tool::ClangResolver::Source>> sources = std::vector<std::unique_ptr<Tool::ClangResolver::Source>>(groups.size());
+    std::vector<std::unique_ptr<Tool::CopyResolver::Copy>> copies = std::vector<std::unique_ptr<Tool::CopyResolver::Copy>>(groups.size());
+    libutil::Parallel::For(sourceGroups.size() + copyGroups.size(), [&](size_t index) {
+        if (index < sourceGroups.size()) {
+            size_t group = sourceGroups[index];
+            if (clangResolver != nullptr) {
+                sources[group] = std::unique_ptr<Tool::ClangResolver::Source>(new Tool::ClangResolver::Source(
+                    clangResolver->prepareSource(&_toolContext, environment, groups[group].front(), outputDirectories[group])));
+            }
+        } else {
+            size_t group = copyGroups[index - sourceGroups.size()];
+            if (copyResolver != nullptr) {
+                copies[group] = std::unique_ptr<Tool::CopyResolver::Copy>(new Tool::CopyResolver::Copy(
+                    copyResolver->prepareCopy(&_toolContext, environment, groups[group], outputDirectories[group], copyLogMessageTitle)));
+            }
+        }
+    });
+
+    /* Interface Builder files are compiled together after the other groups. */
+    std::vector<std::vector<Phase::File>> interfaceBuilderGroups;
+    std::vector<std::vector<Phase::File>> interfaceBuilderStoryboardGroups;
+
+    for (size_t i = 0; i < groups.size(); ++i) {
+        std::vector<Phase::File> const &files = groups[i];
         assert(!files.empty());
         Phase::File const &first = files.front();
 
-        std::string fileOutputDirectory = outputDirectory;
-        if (!first.localization().empty()) {
-            fileOutputDirectory += "/" + first.localization() + ".lproj";
-        }
+        std::string const &fileOutputDirectory = outputDirectories[i];
 
         Target::BuildRules::BuildRule::shared_ptr const &buildRule = first.buildRule();
         if (buildRule == nullptr && fallbackToolIdentifier.empty()) {
@@ -319,34 +497,7 @@ resolveBuildFiles(
                 return false;
             }
         } else {
-            std::string toolIdentifier = fallbackToolIdentifier;
-
-            if (buildRule != nullptr) {
-                if (pbxspec::PBX::Tool::shared_ptr const &tool = buildRule->tool()) {
-                    // Some tools additionally limit their file types beyond what their build rule allows.
-                    // For example, the default compiler limits itself to just source files, despite its
-                    // default build rule specifying that it accepts all C-family inputs, including headers.
-                    // TODO(grp): Is this the right way to make .h files not get compiled as resources?
-                    if (tool->fileTypes() || tool->inputFileTypes()) {
-                        std::vector<std::string> toolFileTypes;
-                        if (tool->fileTypes()) {
-                            toolFileTypes.insert(toolFileTypes.end(), tool->fileTypes()->begin(), tool->fileTypes()->end());
-                        }
-                        if (tool->inputFileTypes()) {
-                            toolFileTypes.insert(toolFileTypes.end(), tool->inputFileTypes()->begin(), tool->inputFileTypes()->end());
-                        }
-
-                        std::string inputFileType = first.fileType()->identifier();
-                        bool toolAcceptsInputFileType = (toolFileTypes.empty() || std::find(toolFileTypes.begin(), toolFileTypes.end(), inputFileType) != toolFileTypes.end());
-
-                        if (toolAcceptsInputFileType) {
-                            toolIdentifier = tool->identifier();
-                        }
-                    } else {
-                        toolIdentifier = tool->identifier();
-                    }
-                }
-            }
+            std::string const &toolIdentifier = toolIdentifiers[i];
 
             if (toolIdentifier.empty()) {
                 fprintf(stderr, "warning: no tool available for build rule\n");
@@ -360,37 +511,27 @@ resolveBuildFiles(
                     return false;
                 }
             } else if (toolIdentifier == Tool::ClangResolver::ToolIdentifier()) {
-                if (Tool::ClangResolver const *clangResolver = this->clangResolver(phaseEnvironment)) {
+                if (clangResolver != nullptr) {
                     assert(files.size() == 1); // TODO(grp): Is this a valid assertion?
-                    clangResolver->resolveSource(&_toolContext, environment, first, fileOutputDirectory);
+                    clangResolver->addSource(&_toolContext, environment, *sources[i]);
                 } else {
                     return false;
                 }
             } else if (toolIdentifier == Tool::CopyResolver::ToolIdentifier()) {
-                std::string logMessageTitle;
-                switch (buildPhase->type()) {
-                    case pbxproj::PBX::BuildPhase::Type::Headers:
-                        logMessageTitle = "CpHeader";
-                    case pbxproj::PBX::BuildPhase::Type::Resources:
-                        logMessageTitle = "CpResource";
-                    default:
-                        logMessageTitle = "PBXCp";
-                }
-
-                if (Tool::CopyResolver const *copyResolver = this->copyResolver(phaseEnvironment)) {
-                    copyResolver->resolve(&_toolContext, environment, files, fileOutputDirectory, logMessageTitle);
+                if (copyResolver != nullptr) {
+                    copyResolver->addCopy(&_toolContext, *copies[i]);
                 } else {
                     return false;
                 }
             } else if (toolIdentifier == Tool::InterfaceBuilderResolver::CompilerToolIdentifier()) {
-                if (Tool::InterfaceBuilderResolver const *interfaceBuilderCompilerResolver = this->interfaceBuilderCompilerResolver(phaseEnvironment)) {
-                    interfaceBuilderCompilerResolver->resolve(&_toolContext, environment, files);
+                if (this->interfaceBuilderCompilerResolver(phaseEnvironment) != nullptr) {
+                    interfaceBuilderGroups.push_back(files);
                 } else {
                     return false;
                 }
             } else if (toolIdentifier == Tool::InterfaceBuilderResolver::StoryboardCompilerToolIdentifier()) {
-                if (Tool::InterfaceBuilderResolver const *interfaceBuilderStoryboardCompilerResolver = this->interfaceBuilderStoryboardCompilerResolver(phaseEnvironment)) {
-                    interfaceBuilderStoryboardCompilerResolver->resolve(&_toolContext, environment, files);
+                if (this->interfaceBuilderStoryboardCompilerResolver(phaseEnvironment) != nullptr) {
+                    interfaceBuilderStoryboardGroups.push_back(files);
                 } else {
                     return false;
                 }
@@ -410,6 +551,13 @@ resolveBuildFiles(
         }
     }
 
+    if (!interfaceBuilderGroups.empty()) {
+        this->interfaceBuilderCompilerResolver(phaseEnvironment)->resolve(&_toolContext, environment, interfaceBuilderGroups);
+    }
+    if (!interfaceBuilderStoryboardGroups.empty()) {
+        this->interfaceBuilderStoryboardCompilerResolver(phaseEnvironment)->resolve(&_toolContext, environment, interfaceBuilderStoryboardGroups);
+    }
+
     return true;
 }
 
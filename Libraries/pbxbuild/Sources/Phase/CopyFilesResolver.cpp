@@ -11,15 +11,27 @@
 #include <pbxbuild/Phase/Context.h>
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/File.h>
+#include <pbxbuild/Build/Context.h>
+#include <pbxbuild/Target/Environment.h>
+#include <pbxbuild/Tool/CodeSignResolver.h>
 #include <pbxbuild/Tool/CopyResolver.h>
 #include <pbxsetting/Environment.h>
 #include <pbxsetting/Type.h>
 #include <pbxsetting/Value.h>
 #include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
 
 namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
+namespace Build = pbxbuild::Build;
+namespace Target = pbxbuild::Target;
 using libutil::Filesystem;
+using libutil::FSUtil;
 
 Phase::CopyFilesResolver::
 CopyFilesResolver(pbxproj::PBX::CopyFilesBuildPhase::shared_ptr const &buildPhase) :
@@ -70,6 +82,57 @@ DestinationOutputPath(pbxproj::PBX::CopyFilesBuildPhase::Destination destination
     }
 }
 
+/*
+ * The target in the workspace that builds a file, if any.
+ */
+static pbxproj::PBX::Target::shared_ptr
+ProducingTarget(Phase::Environment const &phaseEnvironment, Phase::File const &file)
+{
+    Build::Context const &buildContext = phaseEnvironment.buildContext();
+    pbxproj::PBX::GroupItem::shared_ptr const &fileRef = file.buildFile()->fileRef();
+
+    if (fileRef->type() == pbxproj::PBX::GroupItem::Type::ReferenceProxy) {
+        pbxproj::PBX::ContainerItemProxy::shared_ptr const &proxy = std::static_pointer_cast<pbxproj::PBX::ReferenceProxy>(fileRef)->remoteRef();
+        std::string containerPath = phaseEnvironment.targetEnvironment().path(proxy->containerPortal().get());
+
+        auto remote = buildContext.resolveProductIdentifier(buildContext.workspaceContext().project(containerPath), proxy->remoteGlobalIDString());
+        return (remote ? remote->first : nullptr);
+    }
+
+    if (std::shared_ptr<pbxproj::PBX::Project> project = phaseEnvironment.target()->project()) {
+        for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
+            if (target->type() == pbxproj::PBX::Target::Type::Native && std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target)->productReference() == fileRef) {
+                return target;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+/*
+ * If a copied bundle keeps its contents at its top level. That's its own
+ * SHALLOW_BUNDLE when it's built in the workspace, which can differ from the
+ * product's. Other bundles are checked on disk, or assumed to match.
+ */
+static bool
+ShallowBundle(Phase::Environment const &phaseEnvironment, pbxsetting::Environment const &environment, Phase::File const &file)
+{
+    if (pbxproj::PBX::Target::shared_ptr target = ProducingTarget(phaseEnvironment, file)) {
+        ext::optional<Target::Environment> targetEnvironment = phaseEnvironment.buildContext().targetEnvironment(phaseEnvironment.buildEnvironment(), target);
+        if (targetEnvironment) {
+            return pbxsetting::Type::ParseBoolean(targetEnvironment->environment().resolve("SHALLOW_BUNDLE"));
+        }
+    }
+
+    Filesystem const *filesystem = Filesystem::GetDefaultUNSAFE();
+    if (filesystem->isDirectory(file.path())) {
+        return !filesystem->isDirectory(file.path() + "/Contents") && !filesystem->isDirectory(file.path() + "/Versions");
+    }
+
+    return pbxsetting::Type::ParseBoolean(environment.resolve("SHALLOW_BUNDLE"));
+}
+
 bool Phase::CopyFilesResolver::
 resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext)
 {
@@ -85,16 +148,54 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
     std::string path = environment.expand(_buildPhase->dstPath());
     std::string outputDirectory = root + "/" + path;
 
-    std::vector<Phase::File> files = Phase::File::ResolveBuildFiles(Filesystem::GetDefaultUNSAFE(), phaseEnvironment, environment, _buildPhase->files());
-    std::vector<std::vector<Phase::File>> groups = Phase::Context::Group(files);
+    std::vector<Phase::File> files = Phase::File::ResolveBuildFiles(Filesystem::GetDefaultUNSAFE(), phaseEnvironment, _buildPhase->files());
+
+    /*
+     * Find the bundles to sign once they're copied.
+     */
+    std::vector<std::pair<std::string, bool>> signedBundles;
+    if (Tool::CodeSignResolver::ShouldSign(environment)) {
+        for (Phase::File const &file : files) {
+            std::vector<std::string> const &attributes = file.buildFile()->attributes();
+            if (std::find(attributes.begin(), attributes.end(), "CodeSignOnCopy") == attributes.end()) {
+                continue;
+            }
+
+            pbxspec::PBX::FileType::shared_ptr const &fileType = file.fileType();
+            if (fileType != nullptr && (fileType->isBundle() || fileType->isFrameworkWrapper() || fileType->isApplication())) {
+                signedBundles.push_back({ outputDirectory + "/" + FSUtil::GetBaseName(file.path()), ShallowBundle(phaseEnvironment, environment, file) });
+            }
+        }
+    }
 
     if (pbxsetting::Type::ParseBoolean(environment.resolve("APPLY_RULES_IN_COPY_FILES"))) {
+        std::vector<std::vector<Phase::File>> groups = Phase::Context::Group(std::move(files));
         if (!phaseContext->resolveBuildFiles(phaseEnvironment, environment, _buildPhase, groups, outputDirectory, Tool::CopyResolver::ToolIdentifier())) {
             return false;
         }
     } else {
-        for (Phase::File const &file : files) {
-            copyResolver->resolve(&phaseContext->toolContext(), environment, { file }, outputDirectory, "PBXCp");
+        /* Prepare the copies in parallel, but add them in order. */
+        std::vector<std::unique_ptr<Tool::CopyResolver::Copy>> copies = std::vector<std::unique_ptr<Tool::CopyResolver::Copy>>(files.size());
+        libutil::Parallel::For(files.size(), [&](size_t index) {
+            copies[index] = std::unique_ptr<Tool::CopyResolver::Copy>(new Tool::CopyResolver::Copy(
+                copyResolver->prepareCopy(&phaseContext->toolContext(), environment, { files[index] }, outputDirectory, "PBXCp")));
+        });
+
+        for (std::unique_ptr<Tool::CopyResolver::Copy> const &copy : copies) {
+            copyResolver->addCopy(&phaseContext->toolContext(), *copy);
+        }
+    }
+
+    /*
+     * Each bundle is signed on its own after it's copied, so they're signed
+     * in parallel. The product containing them is signed after them.
+     */
+    if (!signedBundles.empty()) {
+        if (Tool::CodeSignResolver const *codeSignResolver = phaseContext->codeSignResolver(phaseEnvironment)) {
+            for (std::pair<std::string, bool> const &bundle : signedBundles) {
+                std::string contents = Tool::CodeSignResolver::NestedContentsPath(bundle.first, bundle.second);
+                codeSignResolver->resolve(&phaseContext->toolContext(), environment, bundle.first, contents, { }, true);
+            }
         }
     }
 
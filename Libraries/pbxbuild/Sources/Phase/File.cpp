@@ -14,6 +14,11 @@
 #include <pbxbuild/Build/Environment.h>
 #include <pbxbuild/FileTypeResolver.h>
 #include <libutil/Filesystem.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
 
 namespace Phase = pbxbuild::Phase;
 namespace Target = pbxbuild::Target;
@@ -44,19 +49,25 @@ Phase::File::
 }
 
 std::vector<Phase::File> Phase::File::
-ResolveBuildFiles(Filesystem const *filesystem, Phase::Environment const &phaseEnvironment, pbxsetting::Environment const &environment, std::vector<pbxproj::PBX::BuildFile::shared_ptr> const &buildFiles)
+ResolveBuildFiles(Filesystem const *filesystem, Phase::Environment const &phaseEnvironment, std::vector<pbxproj::PBX::BuildFile::shared_ptr> const &buildFiles)
 {
     Target::Environment const &targetEnvironment = phaseEnvironment.targetEnvironment();
     Target::BuildRules const &buildRules = targetEnvironment.buildRules();
     Build::Environment const &buildEnvironment = phaseEnvironment.buildEnvironment();
     Build::Context const &buildContext = phaseEnvironment.buildContext();
 
-    std::vector<Phase::File> result;
+    /*
+     * Resolving file types can check the filesystem, so resolve each build
+     * file in parallel. The results are combined in order.
+     */
+    std::vector<std::vector<Phase::File>> resolved = std::vector<std::vector<Phase::File>>(buildFiles.size());
+    libutil::Parallel::For(buildFiles.size(), [&](size_t index) {
+        pbxproj::PBX::BuildFile::shared_ptr const &buildFile = buildFiles[index];
+        std::vector<Phase::File> *result = &resolved[index];
 
-    for (pbxproj::PBX::BuildFile::shared_ptr const &buildFile : buildFiles) {
         if (buildFile->fileRef() == nullptr) {
             fprintf(stderr, "warning: build phase input does not reference a file\n");
-            continue;
+            return;
         }
 
         std::string fileNameDisambiguator;
@@ -69,12 +80,12 @@ ResolveBuildFiles(Filesystem const *filesystem, Phase::Environment const &phaseE
             case pbxproj::PBX::GroupItem::Type::FileReference: {
                 pbxproj::PBX::FileReference::shared_ptr const &fileReference = std::static_pointer_cast <pbxproj::PBX::FileReference> (buildFile->fileRef());
 
-                std::string path = environment.expand(fileReference->resolve());
+                std::string path = targetEnvironment.path(fileReference.get());
                 pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(filesystem, buildEnvironment.specManager(), { pbxspec::Manager::AnyDomain() }, fileReference, path);
 
                 Target::BuildRules::BuildRule::shared_ptr buildRule = buildRules.resolve(fileType, path);
                 Phase::File file = Phase::File(buildFile, buildRule, fileType, path, std::string(), fileNameDisambiguator);
-                result.push_back(file);
+                result->push_back(file);
                 break;
             }
             case pbxproj::PBX::GroupItem::Type::ReferenceProxy: {
@@ -82,57 +93,57 @@ ResolveBuildFiles(Filesystem const *filesystem, Phase::Environment const &phaseE
 
                 pbxproj::PBX::ContainerItemProxy::shared_ptr const &proxy = referenceProxy->remoteRef();
                 pbxproj::PBX::FileReference::shared_ptr const &containerReference = proxy->containerPortal();
-                std::string containerPath = environment.expand(containerReference->resolve());
+                std::string containerPath = targetEnvironment.path(containerReference.get());
 
                 auto remote = buildContext.resolveProductIdentifier(buildContext.workspaceContext().project(containerPath), proxy->remoteGlobalIDString());
                 if (!remote) {
                     fprintf(stderr, "error: unable to find remote target product from proxied reference\n");
-                    continue;
+                    return;
                 }
 
                 ext::optional<Target::Environment> remoteEnvironment = buildContext.targetEnvironment(buildEnvironment, remote->first);
                 if (!remoteEnvironment) {
                     fprintf(stderr, "error: unable to create target environment for remote target\n");
-                    continue;
+                    return;
                 }
 
                 pbxproj::PBX::FileReference::shared_ptr const &fileReference = remote->second;
-                std::string path = remoteEnvironment->environment().expand(fileReference->resolve());
+                std::string path = remoteEnvironment->path(fileReference.get());
                 pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(filesystem, buildEnvironment.specManager(), { pbxspec::Manager::AnyDomain() }, fileReference, path);
 
                 Target::BuildRules::BuildRule::shared_ptr buildRule = buildRules.resolve(fileType, path);
                 Phase::File file = Phase::File(buildFile, buildRule, fileType, path, std::string(), std::string());
-                result.push_back(file);
+                result->push_back(file);
                 break;
             }
             case pbxproj::PBX::GroupItem::Type::VariantGroup: {
                 pbxproj::PBX::VariantGroup::shared_ptr const &variantGroup = std::static_pointer_cast <pbxproj::PBX::VariantGroup> (buildFile->fileRef());
                 for (pbxproj::PBX::GroupItem::shared_ptr const &child : variantGroup->children()) {
                     if (child->type() != pbxproj::PBX::GroupItem::Type::FileReference) {
-                        continue;
+                        return;
                     }
 
                     pbxproj::PBX::FileReference::shared_ptr const &fileReference = std::static_pointer_cast <pbxproj::PBX::FileReference> (child);
                     std::string const &localization = fileReference->name();
 
-                    std::string path = environment.expand(fileReference->resolve());
+                    std::string path = targetEnvironment.path(fileReference.get());
                     pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(filesystem, buildEnvironment.specManager(), { pbxspec::Manager::AnyDomain() }, fileReference, path);
 
                     Target::BuildRules::BuildRule::shared_ptr buildRule = buildRules.resolve(fileType, path);
                     Phase::File file = Phase::File(buildFile, buildRule, fileType, path, localization, fileNameDisambiguator);
-                    result.push_back(file);
+                    result->push_back(file);
                 }
                 break;
             }
             case pbxproj::PBX::GroupItem::Type::VersionGroup: {
                 pbxproj::XC::VersionGroup::shared_ptr const &versionGroup = std::static_pointer_cast <pbxproj::XC::VersionGroup> (buildFile->fileRef());
 
-                std::string path = environment.expand(versionGroup->resolve());
+                std::string path = targetEnvironment.path(versionGroup.get());
                 pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(filesystem, buildEnvironment.specManager(), { pbxspec::Manager::AnyDomain() }, versionGroup, path);
 
                 Target::BuildRules::BuildRule::shared_ptr buildRule = buildRules.resolve(fileType, path);
                 Phase::File file = Phase::File(buildFile, buildRule, fileType, path, std::string(), fileNameDisambiguator);
-                result.push_back(file);
+                result->push_back(file);
                 break;
 
             }
@@ -141,6 +152,11 @@ ResolveBuildFiles(Filesystem const *filesystem, Phase::Environment const &phaseE
                 break;
             }
         }
+    });
+
+    std::vector<Phase::File> result;
+    for (std::vector<Phase::File> &files : resolved) {
+        result.insert(result.end(), std::make_move_iterator(files.begin()), std::make_move_iterator(files.end()));
     }
 
     return result;
@@ -44,19 +44,32 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
     std::string publicOutputDirectory = targetBuildDirectory + "/" + environment.resolve("PUBLIC_HEADERS_FOLDER_PATH");
     std::string privateOutputDirectory = targetBuildDirectory + "/" + environment.resolve("PRIVATE_HEADERS_FOLDER_PATH");
 
-    std::vector<Phase::File> files = Phase::File::ResolveBuildFiles(Filesystem::GetDefaultUNSAFE(), phaseEnvironment, environment, _buildPhase->files());
+    std::vector<Phase::File> files = Phase::File::ResolveBuildFiles(Filesystem::GetDefaultUNSAFE(), phaseEnvironment, _buildPhase->files());
 
-    for (Phase::File const &file : files) {
+    std::vector<Phase::File> publicFiles;
+    std::vector<Phase::File> privateFiles;
+    for (Phase::File &file : files) {
         std::vector<std::string> const &attributes = file.buildFile()->attributes();
         bool isPublic  = std::find(attributes.begin(), attributes.end(), "Public") != attributes.end();
         bool isPrivate = std::find(attributes.begin(), attributes.end(), "Private") != attributes.end();
 
-        std::string const &outputDirectory = (isPublic ? publicOutputDirectory : privateOutputDirectory);
-
-        if (isPublic || isPrivate) {
-            copyResolver->resolve(&phaseContext->toolContext(), environment, { file }, outputDirectory, "CpHeader");
+        if (isPublic) {
+            publicFiles.push_back(std::move(file));
+        } else if (isPrivate) {
+            privateFiles.push_back(std::move(file));
         }
     }
 
+    /*
+     * Copy each directory's headers together. The copy leaves headers that
+     * haven't changed alone, so anything including them isn't rebuilt.
+     */
+    if (!publicFiles.empty()) {
+        copyResolver->resolve(&phaseContext->toolContext(), environment, publicFiles, publicOutputDirectory, "CpHeader");
+    }
+    if (!privateFiles.empty()) {
+        copyResolver->resolve(&phaseContext->toolContext(), environment, privateFiles, privateOutputDirectory, "CpHeader");
+    }
+
     return true;
 }
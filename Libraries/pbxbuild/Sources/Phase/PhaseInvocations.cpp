@@ -23,14 +23,18 @@
 #include <pbxbuild/Tool/Context.h>
 #include <pbxsetting/Environment.h>
 #include <pbxsetting/Type.h>
+#include <libutil/Statistic.h>
 
 namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
 namespace Target = pbxbuild::Target;
+using libutil::Statistic;
+
+static Statistic CreateTime("pbxbuild", "Resolve phase invocations");
 
 Phase::PhaseInvocations::
-PhaseInvocations(std::vector<Tool::Invocation> const &invocations) :
-    _invocations(invocations)
+PhaseInvocations(std::vector<Tool::Invocation> &&invocations) :
+    _invocations(std::move(invocations))
 {
 }
 
@@ -42,13 +46,16 @@ Phase::PhaseInvocations::
 Phase::PhaseInvocations Phase::PhaseInvocations::
 Create(Phase::Environment const &phaseEnvironment, pbxproj::PBX::Target::shared_ptr const &target)
 {
+    Statistic::Timer timer(&CreateTime);
+
     Target::Environment const &targetEnvironment = phaseEnvironment.targetEnvironment();
     pbxsetting::Environment const &environment = targetEnvironment.environment();
 
     /* Create the tool context for building. */
     Tool::SearchPaths searchPaths = Tool::SearchPaths::Create(
         targetEnvironment.environment(),
-        targetEnvironment.workingDirectory());
+        targetEnvironment.workingDirectory(),
+        phaseEnvironment.buildContext().recursiveSearchPaths());
     Tool::Context toolContext = Tool::Context(
         targetEnvironment.sdk(),
         targetEnvironment.toolchains(),
@@ -208,6 +215,6 @@ Create(Phase::Environment const &phaseEnvironment, pbxproj::PBX::Target::shared_
             break;
     }
 
-    return Phase::PhaseInvocations(phaseContext.toolContext().invocations());
+    return Phase::PhaseInvocations(std::move(phaseContext.toolContext().invocations()));
 }
 
@@ -11,6 +11,7 @@
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/Context.h>
 #include <pbxbuild/Target/Environment.h>
+#include <pbxbuild/Tool/CodeSignResolver.h>
 #include <pbxbuild/Tool/CopyResolver.h>
 #include <pbxbuild/Tool/InfoPlistResolver.h>
 #include <pbxbuild/Tool/MakeDirectoryResolver.h>
@@ -22,6 +23,9 @@
 #include <pbxsetting/Value.h>
 #include <libutil/FSUtil.h>
 
+#include <algorithm>
+#include <iterator>
+
 namespace Target = pbxbuild::Target;
 namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
@@ -368,8 +372,35 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
             }
         }
 
+        /*
+         * Sign the product after everything in it, including the nested
+         * bundles signed when they were copied. The wrapper itself is left
+         * out, since the touch below changes it after signing.
+         */
+        std::vector<std::string> refreshed;
+        if (Tool::CodeSignResolver::ShouldSign(environment)) {
+            if (Tool::CodeSignResolver const *codeSignResolver = phaseContext->codeSignResolver(phaseEnvironment)) {
+                std::vector<std::string> contents;
+                std::copy_if(outputs.begin(), outputs.end(), std::back_inserter(contents), [&](std::string const &output) {
+                    return output != wrapperPath;
+                });
+
+                std::string contentsPath = environment.resolve("TARGET_BUILD_DIR") + "/" + environment.resolve("CONTENTS_FOLDER_PATH");
+                codeSignResolver->resolve(&phaseContext->toolContext(), environment, wrapperPath, contentsPath, contents, false);
+
+                /*
+                 * Signing rewrites the executable in place, after the
+                 * signature. The touch waits for the signature and makes it
+                 * newer again, so neither runs again when nothing changed.
+                 */
+                std::string signature = Tool::CodeSignResolver::SignaturePath(contentsPath);
+                outputs.push_back(signature);
+                refreshed.push_back(signature);
+            }
+        }
+
         if (Tool::TouchResolver const *touchResolver = phaseContext->touchResolver(phaseEnvironment)) {
-            touchResolver->resolve(&phaseContext->toolContext(), wrapperPath, outputs);
+            touchResolver->resolve(&phaseContext->toolContext(), wrapperPath, outputs, refreshed);
         } else {
             fprintf(stderr, "warning: could not find touch tool\n");
         }
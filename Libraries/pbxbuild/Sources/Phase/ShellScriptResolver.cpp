@@ -11,9 +11,11 @@
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/Context.h>
 #include <pbxbuild/Tool/ScriptResolver.h>
+#include <libutil/Filesystem.h>
 
 namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
+using libutil::Filesystem;
 
 Phase::ShellScriptResolver::
 ShellScriptResolver(pbxproj::PBX::ShellScriptBuildPhase::shared_ptr const &buildPhase) :
@@ -36,6 +38,6 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
 
     pbxsetting::Environment const &environment = phaseEnvironment.targetEnvironment().environment();
 
-    scriptResolver->resolve(&phaseContext->toolContext(), environment, _buildPhase);
+    scriptResolver->resolve(&phaseContext->toolContext(), Filesystem::GetDefaultUNSAFE(), environment, _buildPhase);
     return true;
 }
@@ -87,6 +87,12 @@ CopySwiftModules(Phase::Environment const &phaseEnvironment, Phase::Context *pha
         std::string docOutputPath = outputBase + "/" + outputName + ".swiftdoc";
         dittoResolver->resolve(toolContext, moduleInfo.docPath(), docOutputPath);
 
+        /* Copy the module interface, if there is one. */
+        if (moduleInfo.interfacePath()) {
+            std::string interfaceOutputPath = outputBase + "/" + outputName + ".swiftinterface";
+            dittoResolver->resolve(toolContext, *moduleInfo.interfacePath(), interfaceOutputPath);
+        }
+
         /* Copy the generated header, if requested. */
         if (moduleInfo.installHeader()) {
             std::string headerName = FSUtil::GetBaseName(moduleInfo.headerPath());
@@ -124,25 +130,25 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
         fprintf(stderr, "error: unable to resolve module map\n");
     }
 
-    std::vector<Phase::File> files = Phase::File::ResolveBuildFiles(Filesystem::GetDefaultUNSAFE(), phaseEnvironment, targetEnvironment.environment(), _buildPhase->files());
+    std::vector<Phase::File> files = Phase::File::ResolveBuildFiles(Filesystem::GetDefaultUNSAFE(), phaseEnvironment, _buildPhase->files());
 
     /*
      * Split files based on whether their tool is architecture-neutral.
      */
     std::vector<Phase::File> neutralFiles;
     std::vector<Phase::File> architectureFiles;
-    for (Phase::File const &file : files) {
+    for (Phase::File &file : files) {
         if (file.buildRule() != nullptr && file.buildRule()->tool() != nullptr && file.buildRule()->tool()->isArchitectureNeutral() == false) {
-            architectureFiles.push_back(file);
+            architectureFiles.push_back(std::move(file));
         } else {
-            neutralFiles.push_back(file);
+            neutralFiles.push_back(std::move(file));
         }
     }
 
     /*
      * Resolve non-architecture-specific files. These are resolved just once.
      */
-    std::vector<std::vector<Phase::File>> neutralGroups = Phase::Context::Group(neutralFiles);
+    std::vector<std::vector<Phase::File>> neutralGroups = Phase::Context::Group(std::move(neutralFiles));
     std::string neutralOutputDirectory = targetEnvironment.environment().resolve("OBJECT_FILE_DIR");
     if (!phaseContext->resolveBuildFiles(phaseEnvironment, targetEnvironment.environment(), _buildPhase, neutralGroups, neutralOutputDirectory)) {
         return false;
@@ -151,7 +157,7 @@ resolve(Phase::Environment const &phaseEnvironment, Phase::Context *phaseContext
     /*
      * Resolve architecture-specific files.
      */
-    std::vector<std::vector<Phase::File>> architectureGroups = Phase::Context::Group(architectureFiles);
+    std::vector<std::vector<Phase::File>> architectureGroups = Phase::Context::Group(std::move(architectureFiles));
     for (std::string const &variant : targetEnvironment.variants()) {
         for (std::string const &arch : targetEnvironment.architectures()) {
             pbxsetting::Environment currentEnvironment = pbxsetting::Environment(targetEnvironment.environment());
@@ -11,6 +11,8 @@
 #include <libutil/FSUtil.h>
 #include <libutil/Wildcard.h>
 
+#include <algorithm>
+
 namespace Target = pbxbuild::Target;
 using libutil::FSUtil;
 using libutil::Wildcard;
@@ -29,27 +31,44 @@ Target::BuildRules::
 BuildRules(Target::BuildRules::BuildRule::vector const &buildRules) :
     _buildRules(buildRules)
 {
+    std::vector<std::string> patterns;
+
+    for (size_t i = 0; i < _buildRules.size(); ++i) {
+        BuildRule::shared_ptr const &buildRule = _buildRules[i];
+        std::string const &filePatterns = buildRule->filePatterns();
+
+        if (filePatterns.empty()) {
+            /* Earlier rules take precedence, so only keep the first. */
+            for (pbxspec::PBX::FileType::shared_ptr const &fileType : buildRule->fileTypes()) {
+                _fileTypeRules.insert({ fileType.get(), i });
+            }
+        } else {
+            patterns.push_back(filePatterns);
+            _patternRules.push_back(i);
+        }
+    }
+
+    _patterns = Wildcard::PatternSet(patterns);
 }
 
 Target::BuildRules::BuildRule::shared_ptr Target::BuildRules::
 resolve(pbxspec::PBX::FileType::shared_ptr const &fileType, std::string const &filePath) const
 {
-    for (BuildRule::shared_ptr const &buildRule : _buildRules) {
-        if (!buildRule->filePatterns().empty()) {
-            if (Wildcard::Match(buildRule->filePatterns(), FSUtil::GetBaseName(filePath))) {
-                return buildRule;
-            }
-        } else {
-            pbxspec::PBX::FileType::vector const &fileTypes = buildRule->fileTypes();
-            for (pbxspec::PBX::FileType::shared_ptr FT = fileType; FT != nullptr; FT = FT->base()) {
-                if (std::find(fileTypes.begin(), fileTypes.end(), FT) != fileTypes.end()) {
-                    return buildRule;
-                }
-            }
+    size_t index = _buildRules.size();
+
+    for (pbxspec::PBX::FileType::shared_ptr FT = fileType; FT != nullptr; FT = FT->base()) {
+        auto it = _fileTypeRules.find(FT.get());
+        if (it != _fileTypeRules.end()) {
+            index = std::min(index, it->second);
         }
     }
 
-    return nullptr;
+    ext::optional<size_t> pattern = _patterns.match(FSUtil::GetBaseName(filePath));
+    if (pattern) {
+        index = std::min(index, _patternRules[*pattern]);
+    }
+
+    return (index < _buildRules.size() ? _buildRules[index] : nullptr);
 }
 
 static Target::BuildRules::BuildRule::shared_ptr
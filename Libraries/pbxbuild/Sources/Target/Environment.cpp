@@ -16,6 +16,7 @@
 #include <pbxsetting/XC/Config.h>
 #include <libutil/FSUtil.h>
 #include <libutil/Filesystem.h>
+#include <libutil/Hash.h>
 
 #include <algorithm>
 #include <set>
@@ -25,6 +26,7 @@ namespace Target = pbxbuild::Target;
 using pbxbuild::WorkspaceContext;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Hash;
 
 Target::Environment::
 Environment(
@@ -44,6 +46,10 @@ Environment(
     _sdk                     (sdk),
     _toolchains              (toolchains),
     _executablePaths         (executablePaths),
+    _executables             (std::make_shared<std::unordered_map<std::string, ext::optional<std::string>>>()),
+    _executablesMutex        (std::make_shared<std::mutex>()),
+    _groupPaths              (std::make_shared<std::unordered_map<pbxproj::PBX::GroupItem const *, std::string>>()),
+    _groupPathsMutex         (std::make_shared<std::mutex>()),
     _buildRules              (buildRules),
     _specDomains             (specDomains),
     _buildSystem             (buildSystem),
@@ -57,11 +63,74 @@ Environment(
 {
 }
 
+ext::optional<std::string> Target::Environment::
+executable(Filesystem const *filesystem, std::string const &name) const
+{
+    {
+        std::lock_guard<std::mutex> lock(*_executablesMutex);
+
+        auto it = _executables->find(name);
+        if (it != _executables->end()) {
+            return it->second;
+        }
+    }
+
+    ext::optional<std::string> path = filesystem->findExecutable(name, _executablePaths);
+
+    std::lock_guard<std::mutex> lock(*_executablesMutex);
+    return _executables->insert({ name, path }).first->second;
+}
+
+std::string Target::Environment::
+path(pbxproj::PBX::GroupItem const *item) const
+{
+    if (item->sourceTree() == "<group>" && item->parent() != nullptr) {
+        std::lock_guard<std::mutex> lock(*_groupPathsMutex);
+        return groupPath(item->parent()) + item->resolvePathComponent();
+    } else {
+        return _environment.expand(item->resolve());
+    }
+}
+
+std::string Target::Environment::
+groupPath(pbxproj::PBX::GroupItem const *group) const
+{
+    auto it = _groupPaths->find(group);
+    if (it != _groupPaths->end()) {
+        return it->second;
+    }
+
+    /* Parent groups are expanded first, so every group is expanded once. */
+    std::string path;
+    if (group->sourceTree() == "<group>" && group->parent() != nullptr) {
+        path = groupPath(group->parent()) + group->resolvePathComponent();
+    } else {
+        path = _environment.expand(group->resolve());
+    }
+
+    return _groupPaths->insert({ group, path }).first->second;
+}
+
 static std::unordered_map<pbxproj::PBX::BuildFile::shared_ptr, std::string>
 BuildFileDisambiguation(pbxproj::PBX::Target::shared_ptr const &target)
 {
-    std::unordered_multimap<std::string, pbxproj::PBX::BuildFile::shared_ptr> buildFileUnambiguous;
-    std::unordered_map<pbxproj::PBX::BuildFile::shared_ptr, std::string> buildFileDisambiguation;
+    size_t count = 0;
+    for (pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase : target->buildPhases()) {
+        if (buildPhase->type() == pbxproj::PBX::BuildPhase::Type::Sources) {
+            count += buildPhase->files().size();
+        }
+    }
+
+    /*
+     * The first file with each case-insensitive name. Conflicts are rare, so
+     * only files found to conflict are marked.
+     */
+    std::vector<std::pair<pbxproj::PBX::BuildFile::shared_ptr, std::string>> buildFiles;
+    buildFiles.reserve(count);
+    std::unordered_map<std::string, size_t> firstBuildFile;
+    firstBuildFile.reserve(count);
+    std::vector<bool> conflicting;
+    conflicting.reserve(count);
 
     for (pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase : target->buildPhases()) {
         if (buildPhase->type() != pbxproj::PBX::BuildPhase::Type::Sources) {
@@ -76,22 +145,28 @@ BuildFileDisambiguation(pbxproj::PBX::Target::shared_ptr const &target)
             std::string name = FSUtil::GetBaseNameWithoutExtension(buildFile->fileRef()->name());
 
             /* Use a case-insensitive key to detect conflicts. */
-            std::string lower;
-            std::transform(name.begin(), name.end(), std::back_inserter(lower), ::tolower);
-
-            auto range = buildFileUnambiguous.equal_range(lower);
-            if (range.first != buildFileUnambiguous.end()) {
-                /* Conflicts with at least one other file, add a disambiguation. */
-                buildFileDisambiguation.insert({ buildFile, name + "-" + buildFile->blueprintIdentifier() });
-
-                /* Add disambiguations for all the conflicting files. */
-                for (auto it = range.first; it != range.second; ++it) {
-                    pbxproj::PBX::BuildFile::shared_ptr const &otherBuildFile = it->second;
-                    std::string otherName = FSUtil::GetBaseNameWithoutExtension(otherBuildFile->fileRef()->name());
-                    buildFileDisambiguation.insert({ otherBuildFile, otherName + "-" + otherBuildFile->blueprintIdentifier() });
+            std::string folded = name;
+            for (char &c : folded) {
+                if (c >= 'A' && c <= 'Z') {
+                    c += 'a' - 'A';
                 }
             }
-            buildFileUnambiguous.insert({ lower, buildFile });
+
+            auto result = firstBuildFile.insert({ std::move(folded), buildFiles.size() });
+            conflicting.push_back(!result.second);
+            if (!result.second) {
+                conflicting[result.first->second] = true;
+            }
+
+            buildFiles.push_back({ buildFile, std::move(name) });
+        }
+    }
+
+    std::unordered_map<pbxproj::PBX::BuildFile::shared_ptr, std::string> buildFileDisambiguation;
+    for (size_t n = 0; n < buildFiles.size(); ++n) {
+        if (conflicting[n]) {
+            std::pair<pbxproj::PBX::BuildFile::shared_ptr, std::string> const &entry = buildFiles[n];
+            buildFileDisambiguation.insert({ entry.first, entry.second + "-" + entry.first->blueprintIdentifier() });
         }
     }
 
@@ -114,17 +189,6 @@ ConfigurationNamed(pbxproj::XC::ConfigurationList::shared_ptr const &configurati
     return nullptr;
 }
 
-static ext::optional<pbxsetting::XC::Config>
-ConfigurationFile(WorkspaceContext const &workspaceContext, pbxproj::XC::BuildConfiguration::shared_ptr const &buildConfiguration)
-{
-    auto it = workspaceContext.configs().find(buildConfiguration);
-    if (it != workspaceContext.configs().end()) {
-        return it->second;
-    }
-
-    return ext::nullopt;
-}
-
 static std::vector<std::string>
 SDKSpecificationDomains(xcsdk::SDK::Target::shared_ptr const &sdk)
 {
@@ -201,6 +265,20 @@ ProductTypeLevel(pbxspec::PBX::ProductType::shared_ptr const &productType)
     return pbxsetting::Level(settings);
 }
 
+/*
+ * Identifies a level made from a specification. Specifications are found
+ * through the domains, so the same identifier and domains is the same one.
+ */
+static std::string
+SpecificationLevelKey(std::string const &kind, std::string const &identifier, std::vector<std::string> const &specDomains)
+{
+    std::string key = kind + "\n" + identifier;
+    for (std::string const &domain : specDomains) {
+        key += "\n" + domain;
+    }
+    return key;
+}
+
 static pbxspec::PBX::BuildSystem::shared_ptr
 TargetBuildSystem(pbxspec::Manager::shared_ptr const &specManager, std::vector<std::string> const &specDomains, pbxproj::PBX::Target::shared_ptr const &target)
 {
@@ -264,6 +342,25 @@ ArchitecturesVariantsLevel(std::vector<std::string> const &architectures, std::v
     return pbxsetting::Level(settings);
 }
 
+/*
+ * Spreads target intermediates across directories, so no one directory holds
+ * those of every target. The shard depends only on the project and target,
+ * so each target keeps its intermediates between builds.
+ */
+static pbxsetting::Level
+IntermediatesShardLevel(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    uint64_t hash = Hash::String(target->project()->projectFile() + '\0' + target->name());
+
+    char shard[3];
+    snprintf(shard, sizeof(shard), "%02x", static_cast<unsigned int>(hash & 0xFF));
+
+    return pbxsetting::Level({
+        pbxsetting::Setting::Create("TARGET_TEMP_SHARD", shard),
+        pbxsetting::Setting::Parse("TARGET_TEMP_DIR", "$(CONFIGURATION_TEMP_DIR)/$(TARGET_TEMP_SHARD)/$(TARGET_NAME).build"),
+    });
+}
+
 ext::optional<Target::Environment> Target::Environment::
 Create(Build::Environment const &buildEnvironment, Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target)
 {
@@ -276,6 +373,7 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
     pbxproj::XC::BuildConfiguration::shared_ptr targetConfiguration;
     ext::optional<pbxsetting::XC::Config> projectConfigurationFile;
     ext::optional<pbxsetting::XC::Config> targetConfigurationFile;
+    bool shardIntermediates;
 
     {
         /*
@@ -301,7 +399,7 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
             return ext::nullopt;
         }
 
-        projectConfigurationFile = ConfigurationFile(buildContext.workspaceContext(), projectConfiguration);
+        projectConfigurationFile = buildContext.workspaceContext().config(projectConfiguration);
         if (projectConfigurationFile) {
             determinationEnvironment.insertFront(projectConfigurationFile->level(), false);
         }
@@ -319,7 +417,7 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
             return ext::nullopt;
         }
 
-        targetConfigurationFile = ConfigurationFile(buildContext.workspaceContext(), targetConfiguration);
+        targetConfigurationFile = buildContext.workspaceContext().config(targetConfiguration);
         if (targetConfigurationFile) {
             determinationEnvironment.insertFront(targetConfigurationFile->level(), false);
         }
@@ -345,6 +443,8 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
         }
 
         specDomains = SDKSpecificationDomains(sdk);
+
+        shardIntermediates = pbxsetting::Type::ParseBoolean(determinationEnvironment.resolve("XCBUILD_SHARD_INTERMEDIATES"));
     }
 
     pbxspec::PBX::BuildSystem::shared_ptr buildSystem = TargetBuildSystem(buildEnvironment.specManager(), specDomains, target);
@@ -375,11 +475,20 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
     }
 
     /*
-     * Now we have $(SDKROOT), and can make the real levels.
+     * Now we have $(SDKROOT), and can make the real levels. Levels made from
+     * specifications are the same for many targets, so they're shared.
      */
+    Build::Environment::LevelCache *levels = buildEnvironment.levels();
+    pbxspec::Manager::shared_ptr const &specManager = buildEnvironment.specManager();
+
     pbxsetting::Environment environment = pbxsetting::Environment(buildEnvironment.baseEnvironment());
-    environment.insertFront(buildSystem->defaultSettings(), true);
+    environment.insertFront(levels->level(SpecificationLevelKey("build-system", buildSystem->identifier(), specDomains), [&buildSystem] {
+        return buildSystem->defaultSettings();
+    }), true);
     environment.insertFront(buildContext.baseSettings(), false);
+    if (shardIntermediates) {
+        environment.insertFront(IntermediatesShardLevel(target), false);
+    }
     environment.insertFront(pbxsetting::Level({
         pbxsetting::Setting::Parse("GCC_VERSION", "$(DEFAULT_COMPILER)"),
     }), false);
@@ -387,7 +496,9 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
     if (sdk->platform()->defaultProperties()) {
         environment.insertFront(*sdk->platform()->defaultProperties(), false);
     }
-    environment.insertFront(PlatformArchitecturesLevel(buildEnvironment.specManager(), specDomains), false);
+    environment.insertFront(levels->level(SpecificationLevelKey("architectures", std::string(), specDomains), [&specManager, &specDomains] {
+        return PlatformArchitecturesLevel(specManager, specDomains);
+    }), false);
     if (sdk->defaultProperties()) {
         environment.insertFront(*sdk->defaultProperties(), false);
     }
@@ -401,10 +512,14 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
     }
 
     if (packageType != nullptr) {
-        environment.insertFront(PackageTypeLevel(packageType), false);
+        environment.insertFront(levels->level(SpecificationLevelKey("package-type", packageType->identifier(), specDomains), [&packageType] {
+            return PackageTypeLevel(packageType);
+        }), false);
     }
     if (productType != nullptr) {
-        environment.insertFront(ProductTypeLevel(productType), false);
+        environment.insertFront(levels->level(SpecificationLevelKey("product-type", productType->identifier(), specDomains), [&productType] {
+            return ProductTypeLevel(productType);
+        }), false);
     }
 
     /*
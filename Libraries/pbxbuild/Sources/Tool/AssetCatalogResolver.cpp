@@ -84,12 +84,23 @@ resolve(
 
     // TODO(grp): This should be handled generically for all tools.
     std::vector<Tool::Invocation::DependencyInfo> dependencyInfo;
+    bool preciseDependencyInfo = false;
     if (_tool->dependencyInfoFile()) {
-        dependencyInfo.push_back(Tool::Invocation::DependencyInfo(
-            dependency::DependencyInfoFormat::Binary,
-            environment.expand(*_tool->dependencyInfoFile())));
+        std::string dependencyInfoFile = environment.expand(*_tool->dependencyInfoFile());
+        if (!dependencyInfoFile.empty()) {
+            dependencyInfo.push_back(Tool::Invocation::DependencyInfo(
+                dependency::DependencyInfoFormat::Binary,
+                dependencyInfoFile));
+            preciseDependencyInfo = true;
+        }
     }
-    if (_tool->deeplyStatInputDirectories()) {
+
+    /*
+     * The compiler's dependency info lists each asset directory and each
+     * file it reads, so unrelated files in the catalog don't need to cause
+     * a rebuild. Only fall back to every file in the catalog without it.
+     */
+    if (_tool->deeplyStatInputDirectories() && !preciseDependencyInfo) {
         for (Phase::File const &input : inputs) {
             /* Create a dependency info file to track the input directory contents. */
             auto info = Tool::Invocation::DependencyInfo(dependency::DependencyInfoFormat::Directory, input.path());
@@ -102,8 +113,9 @@ resolve(
      */
     Tool::Invocation invocation;
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.arguments() = arguments;
-    invocation.environment() = environmentVariables;
+    invocation.sharedEnvironment() = toolContext->environment(environmentVariables);
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
     invocation.outputs() = outputs;
@@ -161,7 +161,7 @@ resolvePrecompiledHeader(
     pbxspec::PBX::Tool::shared_ptr tool = std::static_pointer_cast <pbxspec::PBX::Tool> (_compiler);
     Tool::Environment toolEnvironment = Tool::Environment::Create(tool, environment, toolContext->workingDirectory(), { input }, { output });
     pbxsetting::Environment const &env = toolEnvironment.environment();
-    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), fileType);
+    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), fileType, nullptr, &_optionsCache);
     Tool::Tokens::ToolExpansions tokens = Tool::Tokens::ExpandTool(toolEnvironment, options);
 
     std::vector<std::string> arguments = precompiledHeaderInfo.arguments();
@@ -185,23 +185,75 @@ resolvePrecompiledHeader(
 
     Tool::Invocation invocation;
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
+    invocation.toolIdentifier() = _compiler->identifier();
     invocation.arguments() = arguments;
-    invocation.environment() = options.environment();
+    invocation.sharedEnvironment() = toolContext->environment(options.environment());
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
     invocation.outputs() = toolEnvironment.outputs(toolContext->workingDirectory());
     invocation.dependencyInfo() = dependencyInfo;
     invocation.auxiliaryFiles().push_back(serializedFile);
     invocation.logMessage() = logMessage;
+    invocation.stage() = Tool::Invocation::Stage::Compile;
+
+    /*
+     * Flags that don't affect the precompiled header are left out of its
+     * hash, so targets differing only in those can share it from the cache.
+     */
+    invocation.actionCacheCommand() = "pch\n" + tokens.executable() + "\n" + toolContext->workingDirectory() + "\n" + precompiledHeaderInfo.hash();
     toolContext->invocations().push_back(invocation);
 }
 
+std::shared_ptr<Tool::ClangResolver::TargetArguments> Tool::ClangResolver::
+targetArguments(
+    Tool::Context const *toolContext,
+    pbxsetting::Environment const &environment,
+    ext::optional<std::string> const &dialect) const
+{
+    /*
+     * Search paths and custom flags only vary by dialect, variant and
+     * architecture, so they are expanded once for each combination.
+     */
+    std::string key = dialect.value_or("") + '\0' + environment.resolve("CURRENT_VARIANT") + '\0' + environment.resolve("CURRENT_ARCH");
+
+    std::lock_guard<std::mutex> lock(_targetArgumentsMutex);
+
+    auto it = _targetArguments.find(key);
+    if (it != _targetArguments.end()) {
+        return it->second;
+    }
+
+    auto targetArguments = std::make_shared<TargetArguments>();
+    Tool::CompilerCommon::AppendIncludePathFlags(&targetArguments->searchPathsAndCustomFlags, environment, toolContext->searchPaths(), toolContext->headermapInfo());
+    AppendFrameworkPathFlags(&targetArguments->searchPathsAndCustomFlags, environment, toolContext->searchPaths());
+    AppendCustomFlags(&targetArguments->searchPathsAndCustomFlags, environment, dialect);
+    AppendNotUsedInPrecompsFlags(&targetArguments->notUsedInPrecompsFlags, environment);
+
+    if (pbxsetting::Type::ParseBoolean(environment.resolve("CLANG_USE_RESPONSE_FILE"))) {
+        std::string path = environment.expand(pbxsetting::Value::Parse("$(OBJECT_FILE_DIR_$(variant))/$(arch)")) + "/" + dialect.value_or("clang") + ".resp";
+        targetArguments->responseFile = std::make_shared<Tool::Invocation::AuxiliaryFile>(Tool::Invocation::AuxiliaryFile::ResponseFile(path, targetArguments->searchPathsAndCustomFlags));
+    }
+
+    _targetArguments.insert({ key, targetArguments });
+    return targetArguments;
+}
+
 void Tool::ClangResolver::
 resolveSource(
     Tool::Context *toolContext,
     pbxsetting::Environment const &environment,
     Phase::File const &input,
     std::string const &outputDirectory) const
+{
+    addSource(toolContext, environment, prepareSource(toolContext, environment, input, outputDirectory));
+}
+
+Tool::ClangResolver::Source Tool::ClangResolver::
+prepareSource(
+    Tool::Context const *toolContext,
+    pbxsetting::Environment const &environment,
+    Phase::File const &input,
+    std::string const &outputDirectory) const
 {
     Tool::HeadermapInfo const &headermapInfo = toolContext->headermapInfo();
 
@@ -227,7 +279,7 @@ resolveSource(
     Tool::Environment toolEnvironment = Tool::Environment::Create(tool, environment, toolContext->workingDirectory(), { input }, { output });
     pbxsetting::Environment const &env = toolEnvironment.environment();
 
-    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), fileType);
+    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), fileType, nullptr, &_optionsCache);
     Tool::Tokens::ToolExpansions tokens = Tool::Tokens::ExpandTool(toolEnvironment, options);
 
     std::vector<std::string> inputDependencies;
@@ -238,10 +290,15 @@ resolveSource(
     AppendDialectFlags(&arguments, fileType->GCCDialectName());
     size_t dialectOffset = arguments.size();
 
+    std::shared_ptr<TargetArguments> targetArguments = this->targetArguments(toolContext, env, fileType->GCCDialectName());
+
     arguments.insert(arguments.end(), tokens.arguments().begin(), tokens.arguments().end());
-    Tool::CompilerCommon::AppendIncludePathFlags(&arguments, env, toolContext->searchPaths(), headermapInfo);
-    AppendFrameworkPathFlags(&arguments, env, toolContext->searchPaths());
-    AppendCustomFlags(&arguments, env, fileType->GCCDialectName());
+    if (targetArguments->responseFile != nullptr) {
+        arguments.push_back("@" + targetArguments->responseFile->path());
+        inputDependencies.push_back(targetArguments->responseFile->path());
+    } else {
+        arguments.insert(arguments.end(), targetArguments->searchPathsAndCustomFlags.begin(), targetArguments->searchPathsAndCustomFlags.end());
+    }
 
     bool precompilePrefixHeader = pbxsetting::Type::ParseBoolean(env.resolve("GCC_PRECOMPILE_PREFIX_HEADER"));
     std::string prefixHeader = env.resolve("GCC_PREFIX_HEADER");
@@ -266,7 +323,7 @@ resolveSource(
         }
     }
 
-    AppendNotUsedInPrecompsFlags(&arguments, env);
+    arguments.insert(arguments.end(), targetArguments->notUsedInPrecompsFlags.begin(), targetArguments->notUsedInPrecompsFlags.end());
     // After all of the configurable settings, so they can override.
     arguments.insert(arguments.end(), inputArguments.begin(), inputArguments.end());
     AppendDependencyInfoFlags(&arguments, _compiler, env);
@@ -281,16 +338,40 @@ resolveSource(
             env.expand(*_compiler->dependencyInfoFile())));
     }
 
-    Tool::Invocation invocation;
-    invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
-    invocation.arguments() = arguments;
-    invocation.environment() = options.environment();
-    invocation.workingDirectory() = toolContext->workingDirectory();
-    invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
-    invocation.outputs() = toolEnvironment.outputs(toolContext->workingDirectory());
-    invocation.inputDependencies() = inputDependencies;
-    invocation.dependencyInfo() = dependencyInfo;
-    invocation.logMessage() = logMessage;
+    Source source;
+    source.invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
+    source.invocation.toolIdentifier() = _compiler->identifier();
+    source.invocation.arguments() = arguments;
+    source.invocation.workingDirectory() = toolContext->workingDirectory();
+    source.invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
+    source.invocation.outputs() = toolEnvironment.outputs(toolContext->workingDirectory());
+    source.invocation.inputDependencies() = inputDependencies;
+    source.invocation.dependencyInfo() = dependencyInfo;
+    source.invocation.logMessage() = logMessage;
+    source.invocation.stage() = Tool::Invocation::Stage::Compile;
+    source.environment = options.environment();
+    source.precompiledHeaderInfo = precompiledHeaderInfo;
+    source.linkerArguments = options.linkerArgs();
+    source.cPlusPlus = DialectIsCPlusPlus(fileType->GCCDialectName());
+    source.responseFile = targetArguments->responseFile;
+    return source;
+}
+
+void Tool::ClangResolver::
+addSource(
+    Tool::Context *toolContext,
+    pbxsetting::Environment const &environment,
+    Source const &source) const
+{
+    /* Write each shared response file once, before any compile uses it. */
+    if (source.responseFile != nullptr && _responseFiles.insert(source.responseFile->path()).second) {
+        Tool::Invocation responseFileInvocation;
+        responseFileInvocation.auxiliaryFiles().push_back(*source.responseFile);
+        toolContext->invocations().push_back(responseFileInvocation);
+    }
+
+    Tool::Invocation invocation = source.invocation;
+    invocation.sharedEnvironment() = toolContext->environment(source.environment);
 
     /* Add the compilation invocation to the context. */
     toolContext->invocations().push_back(invocation);
@@ -300,23 +381,23 @@ resolveSource(
     Tool::CompilationInfo *compilationInfo = &toolContext->compilationInfo();
 
     /* If we have precompiled header info, create an invocation for the precompiled header. */
-    if (precompiledHeaderInfo != nullptr) {
-        std::string hash = precompiledHeaderInfo->hash();
+    if (source.precompiledHeaderInfo != nullptr) {
+        std::string hash = source.precompiledHeaderInfo->hash();
 
         auto precompiledHeaderInfoMap = &compilationInfo->precompiledHeaderInfo();
         if (precompiledHeaderInfoMap->find(hash) == precompiledHeaderInfoMap->end()) {
             /* This precompiled header wasn't already created, create it now. */
-            precompiledHeaderInfoMap->insert({ hash, *precompiledHeaderInfo });
+            precompiledHeaderInfoMap->insert({ hash, *source.precompiledHeaderInfo });
 
             resolvePrecompiledHeader(
                 toolContext,
                 environment,
-                *precompiledHeaderInfo
+                *source.precompiledHeaderInfo
             );
         }
     }
 
-    if (DialectIsCPlusPlus(fileType->GCCDialectName()) && _compiler->execCPlusPlusLinkerPath()) {
+    if (source.cPlusPlus && _compiler->execCPlusPlusLinkerPath()) {
         /* If a single C++ file is seen, use the C++ linker driver. */
         compilationInfo->linkerDriver() = *_compiler->execCPlusPlusLinkerPath();
     } else if (compilationInfo->linkerDriver().empty() && _compiler->execPath()) {
@@ -324,7 +405,7 @@ resolveSource(
         compilationInfo->linkerDriver() = _compiler->execPath()->raw();
     }
 
-    for (std::string const &linkerArg : options.linkerArgs()) {
+    for (std::string const &linkerArg : source.linkerArguments) {
         std::vector<std::string> *linkerArguments = &compilationInfo->linkerArguments();
 
         /* Avoid duplicating arguments for multiple compiler invocations. */
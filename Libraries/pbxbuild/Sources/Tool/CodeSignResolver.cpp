@@ -0,0 +1,133 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxbuild/Tool/CodeSignResolver.h>
+#include <pbxbuild/Tool/Context.h>
+#include <pbxbuild/Phase/Environment.h>
+#include <pbxbuild/Target/Environment.h>
+#include <pbxsetting/Environment.h>
+#include <pbxsetting/Type.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <sstream>
+
+namespace Tool = pbxbuild::Tool;
+namespace Target = pbxbuild::Target;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+Tool::CodeSignResolver::
+CodeSignResolver(std::string const &executable) :
+    _executable(executable)
+{
+}
+
+Tool::CodeSignResolver::
+~CodeSignResolver()
+{
+}
+
+void Tool::CodeSignResolver::
+resolve(
+    Tool::Context *toolContext,
+    pbxsetting::Environment const &environment,
+    std::string const &bundle,
+    std::string const &contents,
+    std::vector<std::string> const &dependencies,
+    bool nested) const
+{
+    std::string const &workingDirectory = toolContext->workingDirectory();
+
+    std::vector<std::string> arguments = { "--force", "--sign", environment.resolve("CODE_SIGN_IDENTITY") };
+    std::vector<std::string> inputs;
+
+    std::vector<std::string> inputDependencies;
+    for (std::string const &dependency : dependencies) {
+        inputDependencies.push_back(FSUtil::ResolveRelativePath(dependency, workingDirectory));
+    }
+
+    if (nested) {
+        /* The bundle is the output of its copy. */
+        inputs.push_back(FSUtil::ResolveRelativePath(bundle, workingDirectory));
+        arguments.push_back("--preserve-metadata=identifier,entitlements");
+    } else {
+        std::string entitlements = environment.resolve("CODE_SIGN_ENTITLEMENTS");
+        if (!entitlements.empty()) {
+            arguments.push_back("--entitlements");
+            arguments.push_back(entitlements);
+            inputs.push_back(FSUtil::ResolveRelativePath(entitlements, workingDirectory));
+        }
+    }
+
+    std::vector<std::string> flags = pbxsetting::Type::ParseList(environment.resolve("OTHER_CODE_SIGN_FLAGS"));
+    arguments.insert(arguments.end(), flags.begin(), flags.end());
+    arguments.push_back(bundle);
+
+    /* Signing changes the bundle in place; the signature is the new file. */
+    std::string signature = FSUtil::ResolveRelativePath(SignaturePath(contents), workingDirectory);
+
+    Tool::Invocation invocation;
+    invocation.executable() = Tool::Invocation::Executable::External(_executable);
+    invocation.arguments() = arguments;
+    invocation.workingDirectory() = workingDirectory;
+    invocation.inputs() = inputs;
+    invocation.outputs() = { signature };
+    invocation.inputDependencies() = inputDependencies;
+    invocation.logMessage() = "CodeSign " + bundle;
+    toolContext->invocations().push_back(invocation);
+}
+
+bool Tool::CodeSignResolver::
+ShouldSign(pbxsetting::Environment const &environment)
+{
+    return pbxsetting::Type::ParseBoolean(environment.resolve("CODE_SIGNING_ALLOWED")) && !environment.resolve("CODE_SIGN_IDENTITY").empty();
+}
+
+std::string Tool::CodeSignResolver::
+SignaturePath(std::string const &contents)
+{
+    return contents + "/_CodeSignature/CodeResources";
+}
+
+std::string Tool::CodeSignResolver::
+NestedContentsPath(std::string const &bundle, bool shallowBundle)
+{
+    if (shallowBundle) {
+        return bundle;
+    } else if (FSUtil::GetFileExtension(bundle) == "framework") {
+        return bundle + "/Versions/Current";
+    } else {
+        return bundle + "/Contents";
+    }
+}
+
+std::unique_ptr<Tool::CodeSignResolver> Tool::CodeSignResolver::
+Create(Phase::Environment const &phaseEnvironment)
+{
+    Target::Environment const &targetEnvironment = phaseEnvironment.targetEnvironment();
+
+    /*
+     * Look in the tool search paths first, like for the other tools, then in
+     * PATH, since codesign is usually part of the system.
+     */
+    std::vector<std::string> executablePaths = targetEnvironment.executablePaths();
+    std::istringstream is(targetEnvironment.environment().resolve("PATH"));
+    for (std::string path; std::getline(is, path, ':');) {
+        executablePaths.push_back(path);
+    }
+
+    ext::optional<std::string> executable = Filesystem::GetDefaultUNSAFE()->findExecutable("codesign", executablePaths);
+    if (!executable) {
+        fprintf(stderr, "warning: could not find codesign\n");
+        return nullptr;
+    }
+
+    return std::unique_ptr<Tool::CodeSignResolver>(new Tool::CodeSignResolver(*executable));
+}
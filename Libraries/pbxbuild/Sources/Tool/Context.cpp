@@ -28,3 +28,24 @@ Tool::Context::
 ~Context()
 {
 }
+
+std::shared_ptr<std::unordered_map<std::string, std::string> const> Tool::Context::
+environment(std::unordered_map<std::string, std::string> const &environment)
+{
+    /* Combine entry hashes so the hash doesn't depend on iteration order. */
+    size_t hash = environment.size();
+    for (auto const &entry : environment) {
+        hash += std::hash<std::string>()(entry.first) * 31 ^ std::hash<std::string>()(entry.second);
+    }
+
+    auto range = _environments.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (*it->second == environment) {
+            return it->second;
+        }
+    }
+
+    auto shared = std::make_shared<std::unordered_map<std::string, std::string> const>(environment);
+    _environments.insert({ hash, shared });
+    return shared;
+}
@@ -28,10 +28,10 @@ CopyResolver(pbxspec::PBX::Tool::shared_ptr const &tool) :
 {
 }
 
-static void
-ResolveInternal(
+static Tool::CopyResolver::Copy
+PrepareInternal(
     pbxspec::PBX::Tool::shared_ptr const &tool,
-    Tool::Context *toolContext,
+    Tool::Context const *toolContext,
     pbxsetting::Environment const &baseEnvironment,
     std::vector<std::string> const &inputPaths,
     ext::optional<std::vector<Phase::File>> const &inputs,
@@ -90,16 +90,18 @@ ResolveInternal(
     /*
      * Create the copy invocation.
      */
-    Tool::Invocation invocation;
+    Tool::CopyResolver::Copy copy;
+    Tool::Invocation &invocation = copy.invocation;
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
+    invocation.toolIdentifier() = tool->identifier();
     invocation.arguments() = tokens.arguments();
-    invocation.environment() = options.environment();
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
     invocation.outputs() = toolEnvironment.outputs(toolContext->workingDirectory());
     invocation.dependencyInfo() = dependencyInfo;
     invocation.logMessage() = tokens.logMessage();
-    toolContext->invocations().push_back(invocation);
+    copy.environment = options.environment();
+    return copy;
 }
 
 void Tool::CopyResolver::
@@ -110,14 +112,14 @@ resolve(
     std::string const &outputDirectory,
     std::string const &logMessageTitle) const
 {
-    return ResolveInternal(
+    addCopy(toolContext, PrepareInternal(
         _tool,
         toolContext,
         baseEnvironment,
         inputs,
         ext::nullopt,
         outputDirectory,
-        logMessageTitle);
+        logMessageTitle));
 }
 
 void Tool::CopyResolver::
@@ -127,13 +129,24 @@ resolve(
     std::vector<Phase::File> const &inputs,
     std::string const &outputDirectory,
     std::string const &logMessageTitle) const
+{
+    addCopy(toolContext, prepareCopy(toolContext, baseEnvironment, inputs, outputDirectory, logMessageTitle));
+}
+
+Tool::CopyResolver::Copy Tool::CopyResolver::
+prepareCopy(
+    Tool::Context const *toolContext,
+    pbxsetting::Environment const &baseEnvironment,
+    std::vector<Phase::File> const &inputs,
+    std::string const &outputDirectory,
+    std::string const &logMessageTitle) const
 {
     std::vector<std::string> inputPaths;
     std::transform(inputs.begin(), inputs.end(), std::back_inserter(inputPaths), [&](Phase::File const &input) -> std::string {
         return input.path();
     });
 
-    ResolveInternal(
+    return PrepareInternal(
         _tool,
         toolContext,
         baseEnvironment,
@@ -143,6 +156,16 @@ resolve(
         logMessageTitle);
 }
 
+void Tool::CopyResolver::
+addCopy(
+    Tool::Context *toolContext,
+    Copy const &copy) const
+{
+    Tool::Invocation invocation = copy.invocation;
+    invocation.sharedEnvironment() = toolContext->environment(copy.environment);
+    toolContext->invocations().push_back(invocation);
+}
+
 std::unique_ptr<Tool::CopyResolver> Tool::CopyResolver::
 Create(Phase::Environment const &phaseEnvironment)
 {
@@ -11,6 +11,7 @@
 #include <libutil/FSUtil.h>
 
 #include <sstream>
+#include <unordered_set>
 
 namespace Tool = pbxbuild::Tool;
 using libutil::FSUtil;
@@ -263,3 +264,31 @@ Create(
 
     return CreateInternal(tool, environment, workingDirectory, toolInputs, outputs);
 }
+
+bool Tool::Environment::
+IsFileSetting(std::string const &setting)
+{
+    /* The settings in the input and output levels, and those set from them. */
+    static std::unordered_set<std::string> const settings = {
+        "Input",
+        "InputPath",
+        "InputFile",
+        "InputFileName",
+        "InputFileBase",
+        "InputFileSuffix",
+        "InputFileRelativePath",
+        "InputFileBaseUniquefier",
+        "InputFileTextEncoding",
+        "Output",
+        "OutputPath",
+        "OutputFile",
+        "OutputDir",
+        "OutputFileName",
+        "OutputFileBase",
+        "ProductResourcesDir",
+        "TempResourcesDir",
+        "DependencyInfoFile",
+    };
+
+    return (settings.find(setting) != settings.end());
+}
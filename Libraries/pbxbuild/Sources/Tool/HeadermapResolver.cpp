@@ -11,7 +11,6 @@
 #include <pbxbuild/Tool/HeadermapInfo.h>
 #include <pbxbuild/Tool/SearchPaths.h>
 #include <pbxbuild/Tool/Context.h>
-#include <pbxbuild/FileTypeResolver.h>
 #include <pbxbuild/HeaderMap.h>
 #include <pbxsetting/Type.h>
 #include <libutil/Filesystem.h>
@@ -20,15 +19,15 @@
 namespace Tool = pbxbuild::Tool;
 using AuxiliaryFile = pbxbuild::Tool::Invocation::AuxiliaryFile;
 using pbxbuild::HeaderMap;
-using pbxbuild::FileTypeResolver;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
 Tool::HeadermapResolver::
-HeadermapResolver(pbxspec::PBX::Tool::shared_ptr const &tool, pbxspec::PBX::Compiler::shared_ptr const &compiler, pbxspec::Manager::shared_ptr const &specManager) :
-    _tool       (tool),
-    _compiler   (compiler),
-    _specManager(specManager)
+HeadermapResolver(pbxspec::PBX::Tool::shared_ptr const &tool, pbxspec::PBX::Compiler::shared_ptr const &compiler, pbxspec::Manager::shared_ptr const &specManager, std::shared_ptr<Tool::ProjectHeaders::Cache> const &projectHeaders) :
+    _tool          (tool),
+    _compiler      (compiler),
+    _specManager   (specManager),
+    _projectHeaders(projectHeaders)
 {
 }
 
@@ -93,9 +92,6 @@ resolve(
 
     HeaderMap targetName;
     HeaderMap ownTargetHeaders;
-    HeaderMap projectHeaders;
-    HeaderMap allTargetHeaders;
-    HeaderMap allNonFrameworkTargetHeaders;
 
     bool includeFlatEntriesForTargetBeingBuilt     = pbxsetting::Type::ParseBoolean(compilerEnvironment.resolve("HEADERMAP_INCLUDES_FLAT_ENTRIES_FOR_TARGET_BEING_BUILT"));
     bool includeFrameworkEntriesForAllProductTypes = pbxsetting::Type::ParseBoolean(compilerEnvironment.resolve("HEADERMAP_INCLUDES_FRAMEWORK_ENTRIES_FOR_ALL_PRODUCT_TYPES"));
@@ -104,7 +100,12 @@ resolve(
     // TODO(grp): Populate generated headers.
     HeaderMap generatedFiles;
 
+    /*
+     * The project's headers, and the header maps that are the same for all
+     * of its targets, are only found once for the whole build.
+     */
     pbxproj::PBX::Project::shared_ptr project = target->project();
+    std::shared_ptr<Tool::ProjectHeaders const> projectHeaders = _projectHeaders->projectHeaders(_specManager, compilerEnvironment, project);
 
     std::vector<std::string> headermapSearchPaths = HeadermapSearchPaths(_specManager, compilerEnvironment, target, toolContext->searchPaths(), toolContext->workingDirectory());
     for (std::string const &path : headermapSearchPaths) {
@@ -120,74 +121,26 @@ resolve(
         });
     }
 
-    for (pbxproj::PBX::FileReference::shared_ptr const &fileReference : project->fileReferences()) {
-        std::string filePath = compilerEnvironment.expand(fileReference->resolve());
-        pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(Filesystem::GetDefaultUNSAFE(), _specManager, { pbxspec::Manager::AnyDomain() }, fileReference, filePath);
-        if (fileType == nullptr || (fileType->identifier() != "sourcecode.c.h" && fileType->identifier() != "sourcecode.cpp.h")) {
-            continue;
+    if (includeProjectHeaders) {
+        for (std::pair<std::string, std::string> const &file : projectHeaders->projectFiles()) {
+            targetName.add(file.first, file.second, file.first);
         }
+    }
 
-        std::string fileName = FSUtil::GetBaseName(filePath);
-        std::string fileDirectory = FSUtil::GetDirectoryName(filePath) + "/";
+    for (Tool::ProjectHeaders::TargetHeader const &header : projectHeaders->targetHeaders(target)) {
+        ownTargetHeaders.add(header.fileName, header.fileDirectory, header.fileName);
 
-        projectHeaders.add(fileName, fileDirectory, fileName);
-        if (includeProjectHeaders) {
-            targetName.add(fileName, fileDirectory, fileName);
+        if (!header.isPublicOrPrivate) {
+            ownTargetHeaders.add(header.frameworkName, header.fileDirectory, header.fileName);
+            if (includeFlatEntriesForTargetBeingBuilt) {
+                targetName.add(header.frameworkName, header.fileDirectory, header.fileName);
+            }
         }
     }
 
-    for (pbxproj::PBX::Target::shared_ptr const &projectTarget : project->targets()) {
-       for (pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase : projectTarget->buildPhases()) {
-            if (buildPhase->type() != pbxproj::PBX::BuildPhase::Type::Headers) {
-                continue;
-            }
-
-            for (pbxproj::PBX::BuildFile::shared_ptr const &buildFile : buildPhase->files()) {
-                if (buildFile->fileRef() == nullptr || buildFile->fileRef()->type() != pbxproj::PBX::GroupItem::Type::FileReference) {
-                    continue;
-                }
-
-                pbxproj::PBX::FileReference::shared_ptr const &fileReference = std::static_pointer_cast <pbxproj::PBX::FileReference> (buildFile->fileRef());
-                std::string filePath = compilerEnvironment.expand(fileReference->resolve());
-                pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(Filesystem::GetDefaultUNSAFE(), _specManager, { pbxspec::Manager::AnyDomain() }, fileReference, filePath);
-                if (fileType == nullptr || (fileType->identifier() != "sourcecode.c.h" && fileType->identifier() != "sourcecode.cpp.h")) {
-                    continue;
-                }
-
-                std::string fileName = FSUtil::GetBaseName(filePath);
-                std::string fileDirectory = FSUtil::GetDirectoryName(filePath) + "/";
-                std::string frameworkName = projectTarget->productName() + "/" + fileName;
-
-                std::vector<std::string> const &attributes = buildFile->attributes();
-                bool isPublic  = std::find(attributes.begin(), attributes.end(), "Public") != attributes.end();
-                bool isPrivate = std::find(attributes.begin(), attributes.end(), "Private") != attributes.end();
-
-                if (projectTarget == target) {
-                    ownTargetHeaders.add(fileName, fileDirectory, fileName);
-
-                    if (!isPublic && !isPrivate) {
-                        ownTargetHeaders.add(frameworkName, fileDirectory, fileName);
-                        if (includeFlatEntriesForTargetBeingBuilt) {
-                            targetName.add(frameworkName, fileDirectory, fileName);
-                        }
-                    }
-                }
-
-                if (isPublic || isPrivate) {
-                    allTargetHeaders.add(frameworkName, fileDirectory, fileName);
-                    if (includeFrameworkEntriesForAllProductTypes) {
-                        targetName.add(frameworkName, fileDirectory, fileName);
-                    }
-
-                    // TODO(grp): This is a little messy. Maybe check the product type specification, or the product reference's file type?
-                    if (projectTarget->type() == pbxproj::PBX::Target::Type::Native && std::static_pointer_cast<pbxproj::PBX::NativeTarget>(projectTarget)->productType().find("framework") == std::string::npos) {
-                        allNonFrameworkTargetHeaders.add(frameworkName, fileDirectory, fileName);
-                        if (!includeFrameworkEntriesForAllProductTypes) {
-                            targetName.add(frameworkName, fileDirectory, fileName);
-                        }
-                    }
-                }
-            }
+    for (Tool::ProjectHeaders::TargetHeader const &header : projectHeaders->frameworkHeaders()) {
+        if (includeFrameworkEntriesForAllProductTypes || header.isNonFramework) {
+            targetName.add(header.frameworkName, header.fileDirectory, header.fileName);
         }
     }
 
@@ -201,10 +154,10 @@ resolve(
     std::vector<AuxiliaryFile> auxiliaryFiles = {
         AuxiliaryFile::Data(headermapFile, targetName.write()),
         AuxiliaryFile::Data(headermapFileForOwnTargetHeaders, ownTargetHeaders.write()),
-        AuxiliaryFile::Data(headermapFileForAllTargetHeaders, allTargetHeaders.write()),
-        AuxiliaryFile::Data(headermapFileForAllNonFrameworkTargetHeaders, allNonFrameworkTargetHeaders.write()),
+        AuxiliaryFile::Data(headermapFileForAllTargetHeaders, projectHeaders->allTargetHeadermap()),
+        AuxiliaryFile::Data(headermapFileForAllNonFrameworkTargetHeaders, projectHeaders->allNonFrameworkTargetHeadermap()),
         AuxiliaryFile::Data(headermapFileForGeneratedFiles, generatedFiles.write()),
-        AuxiliaryFile::Data(headermapFileForProjectFiles, projectHeaders.write()),
+        AuxiliaryFile::Data(headermapFileForProjectFiles, projectHeaders->projectHeadermap()),
     };
 
     Tool::Invocation invocation;
@@ -250,5 +203,5 @@ Create(Phase::Environment const &phaseEnvironment, pbxspec::PBX::Compiler::share
         return nullptr;
     }
 
-    return std::unique_ptr<Tool::HeadermapResolver>(new Tool::HeadermapResolver(headermapTool, compiler, buildEnvironment.specManager()));
+    return std::unique_ptr<Tool::HeadermapResolver>(new Tool::HeadermapResolver(headermapTool, compiler, buildEnvironment.specManager(), phaseEnvironment.buildContext().projectHeaders()));
 }
@@ -16,8 +16,10 @@
 #include <pbxsetting/Level.h>
 #include <pbxsetting/Setting.h>
 #include <pbxsetting/Type.h>
+#include <libutil/FSUtil.h>
 
 namespace Tool = pbxbuild::Tool;
+using libutil::FSUtil;
 
 Tool::InfoPlistResolver::
 InfoPlistResolver(pbxspec::PBX::Tool::shared_ptr const &tool) :
@@ -64,12 +66,30 @@ resolve(
 
     Tool::Invocation invocation;
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.arguments() = tokens.arguments();
-    invocation.environment() = environmentVariables;
+    invocation.sharedEnvironment() = toolContext->environment(environmentVariables);
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
     invocation.outputs() = toolEnvironment.outputs(toolContext->workingDirectory());
     invocation.inputDependencies() = toolContext->additionalInfoPlistContents();
+
+    /*
+     * Headers are read while preprocessing, so changes to them rebuild: the
+     * prefix header is known up front, and the headers it and the input
+     * include are recorded in a dependency file.
+     */
+    if (pbxsetting::Type::ParseBoolean(environment.resolve("INFOPLIST_PREPROCESS"))) {
+        std::string prefixHeader = environment.resolve("INFOPLIST_PREFIX_HEADER");
+        if (!prefixHeader.empty()) {
+            invocation.inputDependencies().push_back(FSUtil::ResolveRelativePath(prefixHeader, toolContext->workingDirectory()));
+        }
+
+        std::string dependencyFile = environment.resolve("TARGET_TEMP_DIR") + "/Preprocessed-Info.plist.d";
+        invocation.arguments().push_back("-dependencyfile");
+        invocation.arguments().push_back(dependencyFile);
+        invocation.dependencyInfo().push_back(Tool::Invocation::DependencyInfo(dependency::DependencyInfoFormat::Makefile, dependencyFile));
+    }
     invocation.logMessage() = tokens.logMessage();
     invocation.showEnvironmentInLog() = false; /* Hide build settings from log. */
     toolContext->invocations().push_back(invocation);
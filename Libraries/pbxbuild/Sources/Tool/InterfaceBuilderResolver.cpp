@@ -18,6 +18,12 @@
 #include <pbxsetting/Setting.h>
 #include <pbxsetting/Type.h>
 
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <unordered_map>
+
+namespace Phase = pbxbuild::Phase;
 namespace Tool = pbxbuild::Tool;
 
 Tool::InterfaceBuilderResolver::
@@ -26,11 +32,30 @@ InterfaceBuilderResolver(pbxspec::PBX::Compiler::shared_ptr const &tool) :
 {
 }
 
-void Tool::InterfaceBuilderResolver::
-resolve(
+namespace {
+
+/*
+ * An ibtool run for one group of files, before it's batched with others.
+ */
+struct Compile {
+    std::string                                  executable;
+    std::vector<std::string>                     arguments;
+    std::vector<std::string>                     inputPaths;
+    std::vector<std::string>                     inputs;
+    std::vector<std::string>                     outputs;
+    std::unordered_map<std::string, std::string> environmentVariables;
+    ext::optional<std::string>                   infoPlistContent;
+    std::string                                  logMessage;
+};
+
+}
+
+static Compile
+PrepareCompile(
+    pbxspec::PBX::Compiler::shared_ptr const &tool,
     Tool::Context *toolContext,
     pbxsetting::Environment const &baseEnvironment,
-    std::vector<Phase::File> const &inputs) const
+    std::vector<Phase::File> const &inputs)
 {
     /*
      * Filter arguments as either a real input or a localization-specific strings file.
@@ -50,7 +75,7 @@ resolve(
      * Create the custom environment with the needed options.
      */
     pbxsetting::Level level = pbxsetting::Level({
-        InterfaceBuilderCommon::TargetedDeviceSetting(baseEnvironment),
+        Tool::InterfaceBuilderCommon::TargetedDeviceSetting(baseEnvironment),
         pbxsetting::Setting::Create("IBC_REGIONS_AND_STRINGS_FILES", pbxsetting::Type::FormatList(localizationStringsFiles)),
     });
     pbxsetting::Environment interfaceBuilderEnvironment = pbxsetting::Environment(baseEnvironment);
@@ -59,53 +84,159 @@ resolve(
     /*
      * Resolve the tool options.
      */
-    Tool::Environment toolEnvironment = Tool::Environment::Create(_tool, interfaceBuilderEnvironment, toolContext->workingDirectory(), primaryInputs);
+    Tool::Environment toolEnvironment = Tool::Environment::Create(tool, interfaceBuilderEnvironment, toolContext->workingDirectory(), primaryInputs);
     Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), nullptr);
     Tool::Tokens::ToolExpansions tokens = Tool::Tokens::ExpandTool(toolEnvironment, options);
 
     pbxsetting::Environment const &environment = toolEnvironment.environment();
 
+    Compile compile;
+    compile.executable = tokens.executable();
+    compile.inputPaths = toolEnvironment.inputs();
+    compile.inputs = toolEnvironment.inputs(toolContext->workingDirectory());
+    compile.logMessage = tokens.logMessage();
+
     /*
      * Add custom arguments to the end.
      */
-    std::vector<std::string> arguments = tokens.arguments();
-    std::vector<std::string> deploymentTargetArguments = InterfaceBuilderCommon::DeploymentTargetArguments(environment);
-    arguments.insert(arguments.end(), deploymentTargetArguments.begin(), deploymentTargetArguments.end());
+    compile.arguments = tokens.arguments();
+    std::vector<std::string> deploymentTargetArguments = Tool::InterfaceBuilderCommon::DeploymentTargetArguments(environment);
+    compile.arguments.insert(compile.arguments.end(), deploymentTargetArguments.begin(), deploymentTargetArguments.end());
 
     // TODO(grp): Invocations must emit all their outputs for now, but ibtool can emit both general
     // and device-specific (e.g. ~iphone, ~ipad) variants. For now, assume all files are not variant.
-    std::vector<std::string> outputs = toolEnvironment.outputs();
-    if (_tool->mightNotEmitAllOutputs() && !outputs.empty()) {
-        outputs = { outputs.front() };
+    compile.outputs = toolEnvironment.outputs();
+    if (tool->mightNotEmitAllOutputs() && !compile.outputs.empty()) {
+        compile.outputs = { compile.outputs.front() };
     }
 
     // TODO(grp): These should be handled generically for all tools.
-    std::unordered_map<std::string, std::string> environmentVariables = options.environment();
-    if (_tool->environmentVariables()) {
-        for (auto const &variable : *_tool->environmentVariables()) {
-            environmentVariables.insert({ variable.first, environment.expand(variable.second) });
+    compile.environmentVariables = options.environment();
+    if (tool->environmentVariables()) {
+        for (auto const &variable : *tool->environmentVariables()) {
+            compile.environmentVariables.insert({ variable.first, environment.expand(variable.second) });
         }
     }
 
     // TODO(grp): This should be handled generically for all tools.
-    if (_tool->generatedInfoPlistContentFilePath()) {
-        std::string infoPlistContent = environment.expand(*_tool->generatedInfoPlistContentFilePath());
-        toolContext->additionalInfoPlistContents().push_back(infoPlistContent);
-        outputs.push_back(infoPlistContent);
+    if (tool->generatedInfoPlistContentFilePath()) {
+        compile.infoPlistContent = environment.expand(*tool->generatedInfoPlistContentFilePath());
+    }
+
+    return compile;
+}
+
+/*
+ * Calls a function for each argument of a compile, and once for each run of
+ * its input files instead of those files.
+ */
+static void
+ForEachArgument(
+    Compile const &compile,
+    std::function<void(std::string const &)> const &argument,
+    std::function<void()> const &inputs)
+{
+    bool previousInput = false;
+    for (std::string const &value : compile.arguments) {
+        bool input = (std::find(compile.inputPaths.begin(), compile.inputPaths.end(), value) != compile.inputPaths.end());
+        if (!input) {
+            argument(value);
+        } else if (!previousInput) {
+            inputs();
+        }
+        previousInput = input;
     }
+}
 
+/*
+ * What compiles must have in common to share a run: everything but the
+ * input files themselves and where the partial Info.plist is written.
+ */
+static std::string
+BatchKey(Compile const &compile)
+{
+    std::string key = compile.executable;
+    ForEachArgument(compile, [&](std::string const &argument) {
+        if (compile.infoPlistContent && argument == *compile.infoPlistContent) {
+            key += std::string("\0\x02", 2);
+        } else {
+            key += '\0' + argument;
+        }
+    }, [&]() {
+        key += std::string("\0\x01", 2);
+    });
+
+    std::map<std::string, std::string> environmentVariables = std::map<std::string, std::string>(
+        compile.environmentVariables.begin(),
+        compile.environmentVariables.end());
+    for (auto const &variable : environmentVariables) {
+        key += '\0' + variable.first + '=' + variable.second;
+    }
+
+    return key;
+}
+
+void Tool::InterfaceBuilderResolver::
+resolve(
+    Tool::Context *toolContext,
+    pbxsetting::Environment const &baseEnvironment,
+    std::vector<std::vector<Phase::File>> const &groups) const
+{
     /*
-     * Create the invocation.
+     * ibtool is slow to start, and takes any number of files to compile.
+     * Files whose runs would only differ in the files themselves, such as
+     * those compiled into the same directory, share one.
      */
-    Tool::Invocation invocation;
-    invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
-    invocation.arguments() = arguments;
-    invocation.environment() = environmentVariables;
-    invocation.workingDirectory() = toolContext->workingDirectory();
-    invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
-    invocation.outputs() = outputs;
-    invocation.logMessage() = tokens.logMessage();
-    toolContext->invocations().push_back(invocation);
+    std::vector<std::vector<Compile>> batches;
+    std::unordered_map<std::string, size_t> batchIndexes;
+    for (std::vector<Phase::File> const &group : groups) {
+        Compile compile = PrepareCompile(_tool, toolContext, baseEnvironment, group);
+
+        auto it = batchIndexes.insert({ BatchKey(compile), batches.size() }).first;
+        if (it->second == batches.size()) {
+            batches.push_back({ });
+        }
+        batches[it->second].push_back(std::move(compile));
+    }
+
+    for (std::vector<Compile> const &batch : batches) {
+        Compile const &first = batch.front();
+
+        std::vector<std::string> inputPaths;
+        std::vector<std::string> inputs;
+        std::vector<std::string> outputs;
+        for (Compile const &compile : batch) {
+            inputPaths.insert(inputPaths.end(), compile.inputPaths.begin(), compile.inputPaths.end());
+            inputs.insert(inputs.end(), compile.inputs.begin(), compile.inputs.end());
+            outputs.insert(outputs.end(), compile.outputs.begin(), compile.outputs.end());
+        }
+
+        std::vector<std::string> arguments;
+        ForEachArgument(first, [&](std::string const &argument) {
+            arguments.push_back(argument);
+        }, [&]() {
+            arguments.insert(arguments.end(), inputPaths.begin(), inputPaths.end());
+        });
+
+        /* The files of one run share its partial Info.plist. */
+        if (first.infoPlistContent) {
+            toolContext->additionalInfoPlistContents().push_back(*first.infoPlistContent);
+            outputs.push_back(*first.infoPlistContent);
+        }
+
+        /*
+         * Create the invocation.
+         */
+        Tool::Invocation invocation;
+        invocation.executable() = Tool::Invocation::Executable::Determine(first.executable);
+        invocation.arguments() = arguments;
+        invocation.sharedEnvironment() = toolContext->environment(first.environmentVariables);
+        invocation.workingDirectory() = toolContext->workingDirectory();
+        invocation.inputs() = inputs;
+        invocation.outputs() = outputs;
+        invocation.logMessage() = first.logMessage;
+        toolContext->invocations().push_back(invocation);
+    }
 }
 
 std::unique_ptr<Tool::InterfaceBuilderResolver> Tool::InterfaceBuilderResolver::
@@ -81,8 +81,9 @@ resolve(
      */
     Tool::Invocation invocation;
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.arguments() = arguments;
-    invocation.environment() = environmentVariables;
+    invocation.sharedEnvironment() = toolContext->environment(environmentVariables);
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
     invocation.outputs() = outputs;
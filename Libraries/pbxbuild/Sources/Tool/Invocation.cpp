@@ -10,14 +10,19 @@
 #include <pbxbuild/Tool/Invocation.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Hash.h>
 #include <process/Context.h>
 
+#include <algorithm>
+#include <map>
+
 namespace Tool = pbxbuild::Tool;
 using AuxiliaryFile = Tool::Invocation::AuxiliaryFile;
 using DependencyInfo = Tool::Invocation::DependencyInfo;
 using Executable = Tool::Invocation::Executable;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Hash;
 
 AuxiliaryFile::Chunk::
 Chunk(Type type, ext::optional<std::vector<uint8_t>> const &data, ext::optional<std::string> const &file) :
@@ -59,6 +64,25 @@ File(std::string const &path, std::string const &file, bool executable)
     return AuxiliaryFile(path, { Chunk::File(file) }, executable);
 }
 
+AuxiliaryFile AuxiliaryFile::
+ResponseFile(std::string const &path, std::vector<std::string> const &arguments)
+{
+    std::vector<uint8_t> contents;
+    for (std::string const &argument : arguments) {
+        contents.push_back('"');
+        for (char c : argument) {
+            if (c == '"' || c == '\\') {
+                contents.push_back('\\');
+            }
+            contents.push_back(c);
+        }
+        contents.push_back('"');
+        contents.push_back('\n');
+    }
+
+    return AuxiliaryFile::Data(path, contents);
+}
+
 DependencyInfo::
 DependencyInfo(dependency::DependencyInfoFormat format, std::string const &path) :
     _format(format),
@@ -104,10 +128,22 @@ Determine(std::string const &executable)
     }
 }
 
+/* Invocations without environment variables all share one empty map. */
+static std::shared_ptr<std::unordered_map<std::string, std::string> const> const &
+EmptyEnvironment()
+{
+    static std::shared_ptr<std::unordered_map<std::string, std::string> const> const empty = std::make_shared<std::unordered_map<std::string, std::string> const>();
+    return empty;
+}
+
 Tool::Invocation::
 Invocation() :
+    _environment            (EmptyEnvironment()),
     _showEnvironmentInLog   (true),
-    _createsProductStructure(false)
+    _createsProductStructure(false),
+    _stage                  (Stage::Default),
+    _alwaysOutOfDate        (false),
+    _keepsUnchangedOutputs  (false)
 {
 }
 
@@ -116,3 +152,97 @@ Tool::Invocation::
 {
 }
 
+namespace {
+
+/*
+ * Digests the parts of an invocation. Each part is followed by a separator
+ * so adjacent parts can't run together.
+ */
+class FingerprintHash {
+private:
+    Hash _hash;
+
+public:
+    void append(std::string const &value)
+    {
+        _hash.update(value);
+        _hash.update("", 1);
+    }
+
+    void append(std::vector<std::string> const &values, bool ordered)
+    {
+        if (ordered) {
+            for (std::string const &value : values) {
+                append(value);
+            }
+        } else {
+            std::vector<std::string> sorted = values;
+            std::sort(sorted.begin(), sorted.end());
+            for (std::string const &value : sorted) {
+                append(value);
+            }
+        }
+
+        end();
+    }
+
+    /*
+     * End a list, so items can't move between adjacent lists.
+     */
+    void end()
+    {
+        _hash.update("\x02", 1);
+    }
+
+public:
+    std::string hex() const
+    { return _hash.hex(); }
+};
+
+}
+
+static void
+AppendCommand(FingerprintHash *hash, Tool::Invocation const &invocation)
+{
+    if (ext::optional<Executable> const &executable = invocation.executable()) {
+        if (ext::optional<std::string> const &builtin = executable->builtin()) {
+            hash->append("builtin");
+            hash->append(*builtin);
+        } else if (ext::optional<std::string> const &external = executable->external()) {
+            hash->append("external");
+            hash->append(*external);
+        }
+    } else {
+        hash->append("none");
+    }
+
+    hash->append(invocation.arguments(), true);
+
+    std::map<std::string, std::string> environment = std::map<std::string, std::string>(invocation.environment().begin(), invocation.environment().end());
+    for (auto const &variable : environment) {
+        hash->append(variable.first);
+        hash->append(variable.second);
+    }
+    hash->end();
+
+    hash->append(invocation.workingDirectory());
+}
+
+std::string Tool::Invocation::
+commandFingerprint() const
+{
+    FingerprintHash hash;
+    AppendCommand(&hash, *this);
+    return hash.hex();
+}
+
+std::string Tool::Invocation::
+fingerprint() const
+{
+    FingerprintHash hash;
+    AppendCommand(&hash, *this);
+    hash.append(_inputs, false);
+    hash.append(_inputDependencies, false);
+    hash.append(_outputs, false);
+    return hash.hex();
+}
@@ -0,0 +1,417 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxbuild/Tool/InvocationPlan.h>
+#include <libutil/Filesystem.h>
+
+#include <algorithm>
+#include <map>
+
+#include <cstring>
+
+namespace Tool = pbxbuild::Tool;
+using AuxiliaryFile = Tool::Invocation::AuxiliaryFile;
+using DependencyInfo = Tool::Invocation::DependencyInfo;
+using Executable = Tool::Invocation::Executable;
+using libutil::Filesystem;
+
+/*
+ * A plan is this header, the fingerprint, a table of the environments used,
+ * then each invocation. Numbers are variable length, strings and data are
+ * a length then their bytes, and lists are a count then their items.
+ */
+static char const PlanHeader[] = "xcbuild plan 2";
+
+namespace {
+
+class PlanWriter {
+private:
+    std::vector<uint8_t> _data;
+
+public:
+    void number(uint64_t value)
+    {
+        while (value >= 0x80) {
+            _data.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        _data.push_back(static_cast<uint8_t>(value));
+    }
+
+    void boolean(bool value)
+    {
+        number(value ? 1 : 0);
+    }
+
+    void string(std::string const &value)
+    {
+        number(value.size());
+        _data.insert(_data.end(), value.begin(), value.end());
+    }
+
+    void data(std::vector<uint8_t> const &value)
+    {
+        number(value.size());
+        _data.insert(_data.end(), value.begin(), value.end());
+    }
+
+    void strings(std::vector<std::string> const &values)
+    {
+        number(values.size());
+        for (std::string const &value : values) {
+            string(value);
+        }
+    }
+
+    void optionalString(ext::optional<std::string> const &value)
+    {
+        boolean(static_cast<bool>(value));
+        if (value) {
+            string(*value);
+        }
+    }
+
+public:
+    std::vector<uint8_t> &contents()
+    { return _data; }
+};
+
+/*
+ * Reads what a `PlanWriter` wrote. Once anything fails to read, the reader
+ * stays failed and everything read after is empty.
+ */
+class PlanReader {
+private:
+    uint8_t const *_data;
+    uint8_t const *_end;
+    bool           _valid;
+
+public:
+    PlanReader(uint8_t const *data, size_t size) :
+        _data (data),
+        _end  (data + size),
+        _valid(true)
+    {
+    }
+
+public:
+    bool valid() const
+    { return _valid; }
+
+    bool finished() const
+    { return _valid && _data == _end; }
+
+public:
+    uint64_t number()
+    {
+        uint64_t value = 0;
+        for (unsigned int shift = 0; _valid; shift += 7) {
+            if (_data == _end || shift >= 64) {
+                _valid = false;
+                break;
+            }
+
+            uint8_t byte = *_data++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        return 0;
+    }
+
+    bool boolean()
+    {
+        return number() != 0;
+    }
+
+    /*
+     * A count of items each taking at least a byte, so a corrupt count
+     * fails before anything is allocated for it.
+     */
+    size_t count()
+    {
+        uint64_t value = number();
+        if (value > static_cast<uint64_t>(_end - _data)) {
+            _valid = false;
+            return 0;
+        }
+        return static_cast<size_t>(value);
+    }
+
+    std::string string()
+    {
+        size_t size = count();
+        if (!_valid) {
+            return std::string();
+        }
+
+        std::string value = std::string(reinterpret_cast<char const *>(_data), size);
+        _data += size;
+        return value;
+    }
+
+    std::vector<uint8_t> data()
+    {
+        size_t size = count();
+        if (!_valid) {
+            return std::vector<uint8_t>();
+        }
+
+        std::vector<uint8_t> value = std::vector<uint8_t>(_data, _data + size);
+        _data += size;
+        return value;
+    }
+
+    std::vector<std::string> strings()
+    {
+        std::vector<std::string> values = std::vector<std::string>(count());
+        for (std::string &value : values) {
+            value = string();
+        }
+        return values;
+    }
+
+    ext::optional<std::string> optionalString()
+    {
+        if (!boolean()) {
+            return ext::nullopt;
+        }
+        return string();
+    }
+};
+
+}
+
+typedef std::shared_ptr<std::unordered_map<std::string, std::string> const> SharedEnvironment;
+
+Tool::InvocationPlan::
+InvocationPlan()
+{
+}
+
+Tool::InvocationPlan::
+~InvocationPlan()
+{
+}
+
+std::vector<uint8_t> Tool::InvocationPlan::
+Serialize(std::string const &fingerprint, std::vector<Tool::Invocation> const &invocations)
+{
+    PlanWriter writer;
+    writer.string(PlanHeader);
+    writer.string(fingerprint);
+
+    /*
+     * Environments are shared between most invocations, so each is written
+     * once. Variables are sorted so the same plan always serializes the same.
+     */
+    std::vector<SharedEnvironment> environments;
+    std::unordered_map<std::unordered_map<std::string, std::string> const *, size_t> environmentIndexes;
+    for (Tool::Invocation const &invocation : invocations) {
+        auto result = environmentIndexes.insert({ invocation.sharedEnvironment().get(), environments.size() });
+        if (result.second) {
+            environments.push_back(invocation.sharedEnvironment());
+        }
+    }
+
+    writer.number(environments.size());
+    for (SharedEnvironment const &environment : environments) {
+        std::map<std::string, std::string> variables = std::map<std::string, std::string>(environment->begin(), environment->end());
+        writer.number(variables.size());
+        for (auto const &variable : variables) {
+            writer.string(variable.first);
+            writer.string(variable.second);
+        }
+    }
+
+    writer.number(invocations.size());
+    for (Tool::Invocation const &invocation : invocations) {
+        writer.string(invocation.toolIdentifier());
+
+        if (ext::optional<Executable> const &executable = invocation.executable()) {
+            if (executable->builtin()) {
+                writer.number(2);
+                writer.string(*executable->builtin());
+            } else {
+                writer.number(1);
+                writer.string(*executable->external());
+            }
+        } else {
+            writer.number(0);
+        }
+
+        writer.strings(invocation.arguments());
+        writer.number(environmentIndexes.at(invocation.sharedEnvironment().get()));
+        writer.string(invocation.workingDirectory());
+
+        writer.strings(invocation.inputs());
+        writer.strings(invocation.outputs());
+        writer.strings(invocation.phonyInputs());
+        writer.strings(invocation.inputDependencies());
+        writer.strings(invocation.orderDependencies());
+
+        writer.number(invocation.dependencyInfo().size());
+        for (DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+            writer.number(static_cast<uint64_t>(dependencyInfo.format()));
+            writer.string(dependencyInfo.path());
+        }
+
+        writer.number(invocation.auxiliaryFiles().size());
+        for (AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
+            writer.string(auxiliaryFile.path());
+            writer.boolean(auxiliaryFile.executable());
+            writer.number(auxiliaryFile.chunks().size());
+            for (AuxiliaryFile::Chunk const &chunk : auxiliaryFile.chunks()) {
+                writer.number(static_cast<uint64_t>(chunk.type()));
+                switch (chunk.type()) {
+                    case AuxiliaryFile::Chunk::Type::Data:
+                        writer.data(*chunk.data());
+                        break;
+                    case AuxiliaryFile::Chunk::Type::File:
+                        writer.string(*chunk.file());
+                        break;
+                }
+            }
+        }
+
+        writer.string(invocation.logMessage());
+        writer.boolean(invocation.showEnvironmentInLog());
+        writer.boolean(invocation.createsProductStructure());
+        writer.number(static_cast<uint64_t>(invocation.stage()));
+        writer.boolean(invocation.alwaysOutOfDate());
+        writer.boolean(invocation.keepsUnchangedOutputs());
+        writer.optionalString(invocation.actionCacheCommand());
+    }
+
+    return std::move(writer.contents());
+}
+
+ext::optional<std::vector<Tool::Invocation>> Tool::InvocationPlan::
+Deserialize(std::string const &fingerprint, uint8_t const *data, size_t size)
+{
+    PlanReader reader = PlanReader(data, size);
+    if (reader.string() != PlanHeader || reader.string() != fingerprint) {
+        return ext::nullopt;
+    }
+
+    std::vector<SharedEnvironment> environments = std::vector<SharedEnvironment>(reader.count());
+    for (SharedEnvironment &environment : environments) {
+        std::unordered_map<std::string, std::string> variables;
+        size_t count = reader.count();
+        for (size_t i = 0; i < count; ++i) {
+            std::string name = reader.string();
+            variables.insert({ name, reader.string() });
+        }
+        environment = std::make_shared<std::unordered_map<std::string, std::string> const>(std::move(variables));
+    }
+
+    std::vector<Tool::Invocation> invocations = std::vector<Tool::Invocation>(reader.count());
+    for (Tool::Invocation &invocation : invocations) {
+        invocation.toolIdentifier() = reader.string();
+
+        switch (reader.number()) {
+            case 0:
+                break;
+            case 1:
+                invocation.executable() = Executable::External(reader.string());
+                break;
+            case 2:
+                invocation.executable() = Executable::Builtin(reader.string());
+                break;
+            default:
+                return ext::nullopt;
+        }
+
+        invocation.arguments() = reader.strings();
+        uint64_t environment = reader.number();
+        if (environment >= environments.size()) {
+            return ext::nullopt;
+        }
+        invocation.sharedEnvironment() = environments[environment];
+        invocation.workingDirectory() = reader.string();
+
+        invocation.inputs() = reader.strings();
+        invocation.outputs() = reader.strings();
+        invocation.phonyInputs() = reader.strings();
+        invocation.inputDependencies() = reader.strings();
+        invocation.orderDependencies() = reader.strings();
+
+        size_t dependencyInfoCount = reader.count();
+        for (size_t i = 0; i < dependencyInfoCount; ++i) {
+            uint64_t format = reader.number();
+            if (format > static_cast<uint64_t>(dependency::DependencyInfoFormat::Makefile)) {
+                return ext::nullopt;
+            }
+            invocation.dependencyInfo().push_back(DependencyInfo(static_cast<dependency::DependencyInfoFormat>(format), reader.string()));
+        }
+
+        size_t auxiliaryFileCount = reader.count();
+        for (size_t i = 0; i < auxiliaryFileCount; ++i) {
+            std::string path = reader.string();
+            bool executable = reader.boolean();
+
+            std::vector<AuxiliaryFile::Chunk> chunks;
+            size_t chunkCount = reader.count();
+            for (size_t j = 0; j < chunkCount; ++j) {
+                switch (static_cast<AuxiliaryFile::Chunk::Type>(reader.number())) {
+                    case AuxiliaryFile::Chunk::Type::Data:
+                        chunks.push_back(AuxiliaryFile::Chunk::Data(reader.data()));
+                        break;
+                    case AuxiliaryFile::Chunk::Type::File:
+                        chunks.push_back(AuxiliaryFile::Chunk::File(reader.string()));
+                        break;
+                    default:
+                        return ext::nullopt;
+                }
+            }
+
+            invocation.auxiliaryFiles().push_back(AuxiliaryFile(path, chunks, executable));
+        }
+
+        invocation.logMessage() = reader.string();
+        invocation.showEnvironmentInLog() = reader.boolean();
+        invocation.createsProductStructure() = reader.boolean();
+        uint64_t stage = reader.number();
+        if (stage > static_cast<uint64_t>(Tool::Invocation::Stage::Debug)) {
+            return ext::nullopt;
+        }
+        invocation.stage() = static_cast<Tool::Invocation::Stage>(stage);
+        invocation.alwaysOutOfDate() = reader.boolean();
+        invocation.keepsUnchangedOutputs() = reader.boolean();
+        invocation.actionCacheCommand() = reader.optionalString();
+
+        if (!reader.valid()) {
+            return ext::nullopt;
+        }
+    }
+
+    if (!reader.finished()) {
+        return ext::nullopt;
+    }
+
+    return invocations;
+}
+
+bool Tool::InvocationPlan::
+Save(Filesystem *filesystem, std::string const &path, std::string const &fingerprint, std::vector<Tool::Invocation> const &invocations)
+{
+    return filesystem->writeIfChanged(Serialize(fingerprint, invocations), path);
+}
+
+ext::optional<std::vector<Tool::Invocation>> Tool::InvocationPlan::
+Load(Filesystem const *filesystem, std::string const &path, std::string const &fingerprint)
+{
+    std::unique_ptr<Filesystem::Mapping> mapping = filesystem->readMapped(path);
+    if (mapping == nullptr) {
+        return ext::nullopt;
+    }
+
+    return Deserialize(fingerprint, mapping->data(), mapping->size());
+}
@@ -12,6 +12,7 @@
 #include <pbxbuild/Tool/Context.h>
 #include <pbxbuild/Tool/OptionsResult.h>
 #include <pbxbuild/Tool/Tokens.h>
+#include <pbxsetting/Type.h>
 #include <libutil/FSUtil.h>
 
 namespace Tool = pbxbuild::Tool;
@@ -40,17 +41,26 @@ resolve(
 {
     std::vector<std::string> special;
     std::vector<Tool::Invocation::AuxiliaryFile> auxiliaries;
+    std::vector<std::string> inputDependencies;
 
     special.insert(special.end(), additionalArguments.begin(), additionalArguments.end());
 
-    if (_linker->supportsInputFileList() || _linker->identifier() == Tool::LinkerResolver::LibtoolToolIdentifier()) {
-        std::string path = environment.expand(pbxsetting::Value::Parse("$(LINK_FILE_LIST_$(variant)_$(arch))"));
+    bool useInputFileList = (_linker->supportsInputFileList() || _linker->identifier() == Tool::LinkerResolver::LibtoolToolIdentifier());
+    std::string fileListPath = environment.expand(pbxsetting::Value::Parse("$(LINK_FILE_LIST_$(variant)_$(arch))"));
+
+    if (useInputFileList) {
         std::string contents;
         for (std::string const &input : inputFiles) {
             contents += input + "\n";
         }
-        auto fileList = Tool::Invocation::AuxiliaryFile::Data(path, std::vector<uint8_t>(contents.begin(), contents.end()));
+        auto fileList = Tool::Invocation::AuxiliaryFile::Data(fileListPath, std::vector<uint8_t>(contents.begin(), contents.end()));
         auxiliaries.push_back(fileList);
+
+        /*
+         * The file list is only rewritten when it changes, so it tracks which
+         * objects are linked: removing one relinks even with the rest unchanged.
+         */
+        inputDependencies.push_back(fileListPath);
     }
 
     /*
@@ -90,8 +100,13 @@ resolve(
         }
     }
 
+    /*
+     * The libraries and frameworks linked are found through the search paths,
+     * so only the linker knows which files it used. It reports them in its
+     * dependency info, as does libtool.
+     */
     std::vector<Tool::Invocation::DependencyInfo> dependencyInfo;
-    if (_linker->identifier() == Tool::LinkerResolver::LinkerToolIdentifier()) {
+    if (_linker->identifier() == Tool::LinkerResolver::LinkerToolIdentifier() || _linker->identifier() == Tool::LinkerResolver::LibtoolToolIdentifier()) {
         if (_linker->dependencyInfoFile()) {
             auto dependencyInfoFile = environment.expand(*_linker->dependencyInfoFile());
             if (!dependencyInfoFile.empty()) {
@@ -100,17 +115,22 @@ resolve(
                     dependencyInfoFile);
                 dependencyInfo.push_back(info);
 
-                special.push_back("-Xlinker");
-                special.push_back("-dependency_info");
-                special.push_back("-Xlinker");
-                special.push_back(info.path());
+                if (_linker->identifier() == Tool::LinkerResolver::LinkerToolIdentifier()) {
+                    special.push_back("-Xlinker");
+                    special.push_back("-dependency_info");
+                    special.push_back("-Xlinker");
+                    special.push_back(info.path());
+                } else {
+                    special.push_back("-dependency_info");
+                    special.push_back(info.path());
+                }
             }
         }
     }
 
     pbxspec::PBX::Tool::shared_ptr tool = std::static_pointer_cast <pbxspec::PBX::Tool> (_linker);
     Tool::Environment toolEnvironment = Tool::Environment::Create(tool, environment, toolContext->workingDirectory(), inputFiles, { output });
-    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), nullptr);
+    Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), nullptr, toolContext->searchPaths().recursiveCache().get());
     Tool::Tokens::ToolExpansions tokens = Tool::Tokens::ExpandTool(toolEnvironment, options, executable, special);
 
     std::vector<std::string> arguments = tokens.arguments();
@@ -119,16 +139,27 @@ resolve(
         arguments.erase(std::remove(arguments.begin(), arguments.end(), "-arch_only"), arguments.end());
     }
 
+    /* Pass long command lines through a response file next to the file list. */
+    if (useInputFileList && pbxsetting::Type::ParseBoolean(environment.resolve("LD_USE_RESPONSE_FILE"))) {
+        std::string path = FSUtil::GetDirectoryName(fileListPath) + "/" + FSUtil::GetBaseName(output) + ".resp";
+        auxiliaries.push_back(Tool::Invocation::AuxiliaryFile::ResponseFile(path, arguments));
+        inputDependencies.push_back(path);
+        arguments = { "@" + path };
+    }
+
     Tool::Invocation invocation;
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
+    invocation.toolIdentifier() = _linker->identifier();
     invocation.arguments() = arguments;
-    invocation.environment() = options.environment();
+    invocation.sharedEnvironment() = toolContext->environment(options.environment());
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
     invocation.outputs() = toolEnvironment.outputs(toolContext->workingDirectory());
+    invocation.inputDependencies() = inputDependencies;
     invocation.auxiliaryFiles() = auxiliaries;
     invocation.dependencyInfo() = dependencyInfo;
     invocation.logMessage() = tokens.logMessage();
+    invocation.stage() = Tool::Invocation::Stage::Link;
     toolContext->invocations().push_back(invocation);
 }
 
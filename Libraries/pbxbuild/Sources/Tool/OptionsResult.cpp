@@ -18,6 +18,27 @@
 
 namespace Tool = pbxbuild::Tool;
 
+/*
+ * What one option adds to the result.
+ */
+struct Tool::OptionsResult::Cache::Option {
+    pbxspec::PBX::PropertyOption::shared_ptr         option;
+    bool                                             file;
+    std::vector<std::string>                         arguments;
+    std::vector<std::pair<std::string, std::string>> environmentVariables;
+    std::vector<std::string>                         linkerArgs;
+};
+
+Tool::OptionsResult::Cache::
+Cache()
+{
+}
+
+Tool::OptionsResult::Cache::
+~Cache()
+{
+}
+
 Tool::OptionsResult::
 OptionsResult(std::vector<std::string> const &arguments, std::unordered_map<std::string, std::string> const &environment, std::vector<std::string> const &linkerArgs) :
     _arguments  (arguments),
@@ -80,13 +101,13 @@ AddOptionArgumentValue(std::vector<std::string> *arguments, pbxsetting::Environm
 }
 
 static void
-AddOptionArgumentValues(std::vector<std::string> *arguments, pbxsetting::Environment const &environment, std::string const &workingDirectory, std::vector<pbxsetting::Value> const &args, pbxspec::PBX::PropertyOption::shared_ptr const &option)
+AddOptionArgumentValues(std::vector<std::string> *arguments, pbxsetting::Environment const &environment, std::string const &workingDirectory, Tool::SearchPaths::RecursiveCache *recursiveCache, std::vector<pbxsetting::Value> const &args, pbxspec::PBX::PropertyOption::shared_ptr const &option)
 {
     if ((option->type() == "StringList" || option->type() == "stringlist") ||
         (option->type() == "PathList" || option->type() == "pathlist")) {
         std::vector<std::string> values = pbxsetting::Type::ParseList(environment.resolve(option->name()));
         if (option->flattenRecursiveSearchPathsInValue()) {
-            values = Tool::SearchPaths::ExpandRecursive(values, environment, workingDirectory);
+            values = Tool::SearchPaths::ExpandRecursive(values, environment, workingDirectory, recursiveCache);
         }
 
         for (std::string const &value : values) {
@@ -111,7 +132,7 @@ ArgumentValuesFromArray(plist::Array const *args)
 }
 
 static void
-AddOptionValuesArguments(std::vector<std::string> *arguments, pbxsetting::Environment const &environment, std::string const &workingDirectory, plist::Array const *values, std::string const &value, pbxspec::PBX::PropertyOption::shared_ptr const &option)
+AddOptionValuesArguments(std::vector<std::string> *arguments, pbxsetting::Environment const &environment, std::string const &workingDirectory, Tool::SearchPaths::RecursiveCache *recursiveCache, plist::Array const *values, std::string const &value, pbxspec::PBX::PropertyOption::shared_ptr const &option)
 {
     if (values == nullptr) {
         return;
@@ -128,10 +149,10 @@ AddOptionValuesArguments(std::vector<std::string> *arguments, pbxsetting::Enviro
                 if (entryValue->value() == value) {
                     if (auto entryFlag = entry->value <plist::String> ("CommandLineFlag")) {
                         std::vector<pbxsetting::Value> argsValues = { pbxsetting::Value::Parse(entryFlag->value()) };
-                        AddOptionArgumentValues(arguments, environment, workingDirectory, argsValues, option);
+                        AddOptionArgumentValues(arguments, environment, workingDirectory, recursiveCache, argsValues, option);
                     } else if (auto entryArgs = entry->value <plist::Array> ("CommandLineArgs")) {
                         std::vector<pbxsetting::Value> argsValues = ArgumentValuesFromArray(entryArgs);
-                        AddOptionArgumentValues(arguments, environment, workingDirectory, argsValues, option);
+                        AddOptionArgumentValues(arguments, environment, workingDirectory, recursiveCache, argsValues, option);
                     }
                 }
             }
@@ -140,7 +161,7 @@ AddOptionValuesArguments(std::vector<std::string> *arguments, pbxsetting::Enviro
 }
 
 static void
-AddOptionArgsArguments(std::vector<std::string> *arguments, pbxsetting::Environment const &environment, std::string const &workingDirectory, plist::Object const *argsValue, std::string const &value, pbxspec::PBX::PropertyOption::shared_ptr const &option)
+AddOptionArgsArguments(std::vector<std::string> *arguments, pbxsetting::Environment const &environment, std::string const &workingDirectory, Tool::SearchPaths::RecursiveCache *recursiveCache, plist::Object const *argsValue, std::string const &value, pbxspec::PBX::PropertyOption::shared_ptr const &option)
 {
     /*
      * `CommandLineArgs` and `AdditionalLinkerArgs` are either arrays of arguments or dictionaries
@@ -149,114 +170,259 @@ AddOptionArgsArguments(std::vector<std::string> *arguments, pbxsetting::Environm
 
     if (auto args = plist::CastTo <plist::Array> (argsValue)) {
         std::vector<pbxsetting::Value> argsValues = ArgumentValuesFromArray(args);
-        AddOptionArgumentValues(arguments, environment, workingDirectory, argsValues, option);
+        AddOptionArgumentValues(arguments, environment, workingDirectory, recursiveCache, argsValues, option);
     } else if (auto argsValues = plist::CastTo <plist::Dictionary> (argsValue)) {
         if (auto args = argsValues->value <plist::Array> (value)) {
             std::vector<pbxsetting::Value> argsValues = ArgumentValuesFromArray(args);
-            AddOptionArgumentValues(arguments, environment, workingDirectory, argsValues, option);
+            AddOptionArgumentValues(arguments, environment, workingDirectory, recursiveCache, argsValues, option);
         } else if (auto args = argsValues->value <plist::Array> ("<<otherwise>>")) {
             std::vector<pbxsetting::Value> argsValues = ArgumentValuesFromArray(args);
-            AddOptionArgumentValues(arguments, environment, workingDirectory, argsValues, option);
+            AddOptionArgumentValues(arguments, environment, workingDirectory, recursiveCache, argsValues, option);
         }
     }
 }
 
-Tool::OptionsResult Tool::OptionsResult::
-Create(
+static void
+AddOption(
+    std::vector<std::string> *arguments,
+    std::vector<std::pair<std::string, std::string>> *environmentVariables,
+    std::vector<std::string> *linkerArgs,
     pbxsetting::Environment const &environment,
     std::string const &workingDirectory,
-    std::vector<pbxspec::PBX::PropertyOption::shared_ptr> const &options,
+    Tool::SearchPaths::RecursiveCache *recursiveCache,
+    std::string const &architecture,
     pbxspec::PBX::FileType::shared_ptr const &fileType,
-    std::unordered_set<std::string> const &deletedSettings)
+    pbxspec::PBX::PropertyOption::shared_ptr const &option)
 {
-    std::vector<std::string> arguments;
-    std::unordered_map<std::string, std::string> environmentVariables;
-    std::vector<std::string> linkerArgs;
+    if (option->condition() && !EvaluateCondition(*option->condition(), environment)) {
+        return;
+    }
+    if (option->commandLineCondition() && !EvaluateCondition(*option->commandLineCondition(), environment)) {
+        return;
+    }
 
-    std::string architecture = environment.resolve("arch");
+    if (option->architectures() && std::find(option->architectures()->begin(), option->architectures()->end(), architecture) == option->architectures()->end()) {
+        return;
+    }
 
-    for (pbxspec::PBX::PropertyOption::shared_ptr const &option : options) {
-        if (deletedSettings.find(option->name()) != deletedSettings.end()) {
-            continue;
-        }
+    if (option->fileTypes() && fileType != nullptr && std::find(option->fileTypes()->begin(), option->fileTypes()->end(), fileType->identifier()) == option->fileTypes()->end()) {
+        return;
+    }
 
-        if (option->condition() && !EvaluateCondition(*option->condition(), environment)) {
-            continue;
-        }
-        if (option->commandLineCondition() && !EvaluateCondition(*option->commandLineCondition(), environment)) {
-            continue;
+    // TODO(grp): Use PropertyOption::conditionFlavors().
+    std::string value = environment.resolve(option->name());
+
+    if (option->type() == "Boolean" || option->type() == "bool") {
+        bool booleanValue = pbxsetting::Type::ParseBoolean(value);
+        ext::optional<pbxsetting::Value> const &flag = (booleanValue ? option->commandLineFlag() : option->commandLineFlagIfFalse());
+
+        if (flag) {
+            /* Boolean flags don't get the flag value after, since that would be just YES or NO. */
+            arguments->push_back(environment.expand(*flag));
         }
+    } else {
+        if (!value.empty()) {
+            if (option->commandLineFlag()) {
+                pbxsetting::Value const &flag = *option->commandLineFlag();
 
-        if (option->architectures() && std::find(option->architectures()->begin(), option->architectures()->end(), architecture) == option->architectures()->end()) {
-            continue;
+                /* Pass both the command line flag and the option value itself. */
+                std::vector<pbxsetting::Value> values = { flag, pbxsetting::Value::Variable("value") };
+                AddOptionArgumentValues(arguments, environment, workingDirectory, recursiveCache, values, option);
+            }
         }
+    }
+
+    AddOptionValuesArguments(arguments, environment, workingDirectory, recursiveCache, plist::CastTo<plist::Array>(option->values()), value, option);
+    AddOptionValuesArguments(arguments, environment, workingDirectory, recursiveCache, plist::CastTo<plist::Array>(option->allowedValues()), value, option);
 
-        if (option->fileTypes() && fileType != nullptr && std::find(option->fileTypes()->begin(), option->fileTypes()->end(), fileType->identifier()) == option->fileTypes()->end()) {
-            continue;
+    if (!value.empty()) {
+        /* Pass the prefix then the option value in the same argument. */
+        if (option->commandLinePrefixFlag()) {
+            pbxsetting::Value const &prefix = *option->commandLinePrefixFlag();
+            pbxsetting::Value prefixValue = prefix + pbxsetting::Value::Variable("value");
+            AddOptionArgumentValues(arguments, environment, workingDirectory, recursiveCache, { prefixValue }, option);
         }
+    }
 
-        // TODO(grp): Use PropertyOption::conditionFlavors().
-        std::string value = environment.resolve(option->name());
+    AddOptionArgsArguments(arguments, environment, workingDirectory, recursiveCache, option->commandLineArgs(), value, option);
+    AddOptionArgsArguments(linkerArgs, environment, workingDirectory, recursiveCache, option->additionalLinkerArgs(), value, option);
 
-        if (option->type() == "Boolean" || option->type() == "bool") {
-            bool booleanValue = pbxsetting::Type::ParseBoolean(value);
-            ext::optional<pbxsetting::Value> const &flag = (booleanValue ? option->commandLineFlag() : option->commandLineFlagIfFalse());
+    if (option->setValueInEnvironmentVariable()) {
+        std::string const &variable = environment.expand(*option->setValueInEnvironmentVariable());
+        environmentVariables->push_back({ variable, value });
+    }
 
-            if (flag) {
-                /* Boolean flags don't get the flag value after, since that would be just YES or NO. */
-                arguments.push_back(environment.expand(*flag));
-            }
-        } else {
-            if (!value.empty()) {
-                if (option->commandLineFlag()) {
-                    pbxsetting::Value const &flag = *option->commandLineFlag();
-
-                    /* Pass both the command line flag and the option value itself. */
-                    std::vector<pbxsetting::Value> values = { flag, pbxsetting::Value::Variable("value") };
-                    AddOptionArgumentValues(&arguments, environment, workingDirectory, values, option);
+    // TODO(grp): Use PropertyOption::conditionFlavors().
+    // TODO(grp): Use PropertyOption::isCommand{Input,Output}().
+    // TODO(grp): Use PropertyOption::isInputDependency(), PropertyOption::outputDependencies().
+    // TODO(grp): Use PropertyOption::outputsAreSourceFiles().
+}
+
+/*
+ * If a value refers to a setting that differs for each file. Settings it
+ * refers to are not followed into what they refer to in turn.
+ */
+static bool
+ReferencesFileSetting(pbxsetting::Value const &value)
+{
+    for (pbxsetting::Value::Entry const &entry : value.entries()) {
+        if (entry.type() == pbxsetting::Value::Entry::Type::Value) {
+            std::vector<pbxsetting::Value::Entry> name = entry.value()->entries();
+            if (name.size() == 1 && name.front().type() == pbxsetting::Value::Entry::Type::String) {
+                /* Operations on the setting follow its name. */
+                std::string const &string = *name.front().string();
+                if (Tool::Environment::IsFileSetting(string.substr(0, string.find(':')))) {
+                    return true;
                 }
+            } else if (ReferencesFileSetting(*entry.value())) {
+                return true;
             }
         }
+    }
 
-        AddOptionValuesArguments(&arguments, environment, workingDirectory, plist::CastTo<plist::Array>(option->values()), value, option);
-        AddOptionValuesArguments(&arguments, environment, workingDirectory, plist::CastTo<plist::Array>(option->allowedValues()), value, option);
+    return false;
+}
 
-        if (!value.empty()) {
-            /* Pass the prefix then the option value in the same argument. */
-            if (option->commandLinePrefixFlag()) {
-                pbxsetting::Value const &prefix = *option->commandLinePrefixFlag();
-                pbxsetting::Value prefixValue = prefix + pbxsetting::Value::Variable("value");
-                AddOptionArgumentValues(&arguments, environment, workingDirectory, { prefixValue }, option);
+static bool
+ReferencesFileSetting(plist::Object const *object)
+{
+    if (auto string = plist::CastTo<plist::String>(object)) {
+        return ReferencesFileSetting(pbxsetting::Value::Parse(string->value()));
+    } else if (auto array = plist::CastTo<plist::Array>(object)) {
+        for (size_t n = 0; n < array->count(); n++) {
+            if (ReferencesFileSetting(array->value(n))) {
+                return true;
+            }
+        }
+    } else if (auto dictionary = plist::CastTo<plist::Dictionary>(object)) {
+        for (size_t n = 0; n < dictionary->count(); n++) {
+            if (ReferencesFileSetting(dictionary->value(n))) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static bool
+ReferencesFileSetting(pbxspec::PBX::PropertyOption::shared_ptr const &option)
+{
+    auto value = [](ext::optional<pbxsetting::Value> const &value) {
+        return (value && ReferencesFileSetting(*value));
+    };
+    auto condition = [](ext::optional<std::string> const &condition) {
+        return (condition && ReferencesFileSetting(pbxsetting::Value::Parse(*condition)));
+    };
+
+    return Tool::Environment::IsFileSetting(option->name()) ||
+        value(option->defaultValue()) ||
+        condition(option->condition()) ||
+        condition(option->commandLineCondition()) ||
+        value(option->commandLineFlag()) ||
+        value(option->commandLineFlagIfFalse()) ||
+        value(option->commandLinePrefixFlag()) ||
+        ReferencesFileSetting(option->commandLineArgs()) ||
+        ReferencesFileSetting(option->additionalLinkerArgs()) ||
+        ReferencesFileSetting(option->values()) ||
+        ReferencesFileSetting(option->allowedValues()) ||
+        value(option->setValueInEnvironmentVariable());
+}
+
+Tool::OptionsResult Tool::OptionsResult::
+Create(
+    pbxsetting::Environment const &environment,
+    std::string const &workingDirectory,
+    std::vector<pbxspec::PBX::PropertyOption::shared_ptr> const &options,
+    pbxspec::PBX::FileType::shared_ptr const &fileType,
+    std::unordered_set<std::string> const &deletedSettings,
+    Tool::SearchPaths::RecursiveCache *recursiveCache,
+    Cache *cache)
+{
+    std::vector<std::string> arguments;
+    std::vector<std::pair<std::string, std::string>> environmentVariables;
+    std::vector<std::string> linkerArgs;
+
+    std::string architecture = environment.resolve("arch");
+
+    std::string key;
+    std::shared_ptr<std::vector<Cache::Option> const> cached;
+    if (cache != nullptr) {
+        key = (fileType != nullptr ? fileType->identifier() : std::string()) + '\0' + environment.resolve("variant") + '\0' + architecture;
+
+        std::lock_guard<std::mutex> lock(cache->_mutex);
+        auto it = cache->_options.find(key);
+        if (it != cache->_options.end()) {
+            cached = it->second;
+        }
+    }
+
+    if (cache == nullptr) {
+        for (pbxspec::PBX::PropertyOption::shared_ptr const &option : options) {
+            if (deletedSettings.find(option->name()) != deletedSettings.end()) {
+                continue;
             }
+
+            AddOption(&arguments, &environmentVariables, &linkerArgs, environment, workingDirectory, recursiveCache, architecture, fileType, option);
         }
+    } else if (cached == nullptr) {
+        /*
+         * Evaluate every option for this file, keeping what each added so
+         * the options that don't refer to the file can be used again.
+         */
+        auto evaluated = std::make_shared<std::vector<Cache::Option>>();
+        for (pbxspec::PBX::PropertyOption::shared_ptr const &option : options) {
+            if (deletedSettings.find(option->name()) != deletedSettings.end()) {
+                continue;
+            }
 
-        AddOptionArgsArguments(&arguments, environment, workingDirectory, option->commandLineArgs(), value, option);
-        AddOptionArgsArguments(&linkerArgs, environment, workingDirectory, option->additionalLinkerArgs(), value, option);
+            Cache::Option entry;
+            entry.option = option;
+            entry.file = ReferencesFileSetting(option);
+            AddOption(&entry.arguments, &entry.environmentVariables, &entry.linkerArgs, environment, workingDirectory, recursiveCache, architecture, fileType, option);
+            evaluated->push_back(std::move(entry));
+        }
 
-        if (option->setValueInEnvironmentVariable()) {
-            std::string const &variable = environment.expand(*option->setValueInEnvironmentVariable());
-            environmentVariables.insert({ variable, value });
+        for (Cache::Option const &entry : *evaluated) {
+            arguments.insert(arguments.end(), entry.arguments.begin(), entry.arguments.end());
+            environmentVariables.insert(environmentVariables.end(), entry.environmentVariables.begin(), entry.environmentVariables.end());
+            linkerArgs.insert(linkerArgs.end(), entry.linkerArgs.begin(), entry.linkerArgs.end());
         }
 
-        // TODO(grp): Use PropertyOption::conditionFlavors().
-        // TODO(grp): Use PropertyOption::isCommand{Input,Output}().
-        // TODO(grp): Use PropertyOption::isInputDependency(), PropertyOption::outputDependencies().
-        // TODO(grp): Use PropertyOption::outputsAreSourceFiles().
+        std::lock_guard<std::mutex> lock(cache->_mutex);
+        cache->_options.insert({ key, std::move(evaluated) });
+    } else {
+        for (Cache::Option const &entry : *cached) {
+            if (entry.file) {
+                AddOption(&arguments, &environmentVariables, &linkerArgs, environment, workingDirectory, recursiveCache, architecture, fileType, entry.option);
+            } else {
+                arguments.insert(arguments.end(), entry.arguments.begin(), entry.arguments.end());
+                environmentVariables.insert(environmentVariables.end(), entry.environmentVariables.begin(), entry.environmentVariables.end());
+                linkerArgs.insert(linkerArgs.end(), entry.linkerArgs.begin(), entry.linkerArgs.end());
+            }
+        }
     }
 
-    return Tool::OptionsResult(arguments, environmentVariables, linkerArgs);
+    return Tool::OptionsResult(arguments, std::unordered_map<std::string, std::string>(environmentVariables.begin(), environmentVariables.end()), linkerArgs);
 }
 
 Tool::OptionsResult Tool::OptionsResult::
 Create(
     Tool::Environment const &toolEnvironment,
     std::string const &workingDirectory,
-    pbxspec::PBX::FileType::shared_ptr const &fileType)
+    pbxspec::PBX::FileType::shared_ptr const &fileType,
+    Tool::SearchPaths::RecursiveCache *recursiveCache,
+    Cache *cache)
 {
+    pbxspec::PBX::PropertyOption::vector noOptions;
+    std::shared_ptr<pbxspec::PBX::PropertyOption::vector const> const &options = toolEnvironment.tool()->options();
+
     return Create(
         toolEnvironment.environment(),
         workingDirectory,
-        toolEnvironment.tool()->options().value_or(pbxspec::PBX::PropertyOption::vector()),
+        (options != nullptr ? *options : noOptions),
         fileType,
-        toolEnvironment.tool()->deletedProperties().value_or(std::unordered_set<std::string>()));
+        toolEnvironment.tool()->deletedProperties().value_or(std::unordered_set<std::string>()),
+        recursiveCache,
+        cache);
 }
@@ -75,7 +75,10 @@ hash() const
 std::vector<uint8_t> Tool::PrecompiledHeaderInfo::
 serialize() const
 {
-    std::string result;
+    /* The header itself, so the hash alone identifies the output. */
+    std::string result = _prefixHeader + "\n";
+    result += _fileType->identifier() + "\n";
+
     for (std::string const &argument : _relevantArguments) {
         result += argument + "\n";
     }
@@ -0,0 +1,154 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxbuild/Tool/ProjectHeaders.h>
+#include <pbxbuild/FileTypeResolver.h>
+#include <pbxbuild/HeaderMap.h>
+#include <pbxsetting/Environment.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <algorithm>
+
+namespace Tool = pbxbuild::Tool;
+using pbxbuild::HeaderMap;
+using pbxbuild::FileTypeResolver;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+Tool::ProjectHeaders::
+ProjectHeaders()
+{
+}
+
+std::vector<Tool::ProjectHeaders::TargetHeader> const &Tool::ProjectHeaders::
+targetHeaders(pbxproj::PBX::Target::shared_ptr const &target) const
+{
+    static std::vector<TargetHeader> const *empty = new std::vector<TargetHeader>();
+
+    auto it = _targetHeaders.find(target);
+    return (it != _targetHeaders.end() ? it->second : *empty);
+}
+
+static bool
+IsHeader(pbxspec::Manager::shared_ptr const &specManager, pbxproj::PBX::FileReference::shared_ptr const &fileReference, std::string const &filePath)
+{
+    pbxspec::PBX::FileType::shared_ptr fileType = FileTypeResolver::Resolve(Filesystem::GetDefaultUNSAFE(), specManager, { pbxspec::Manager::AnyDomain() }, fileReference, filePath);
+    return (fileType != nullptr && (fileType->identifier() == "sourcecode.c.h" || fileType->identifier() == "sourcecode.cpp.h"));
+}
+
+Tool::ProjectHeaders Tool::ProjectHeaders::
+Create(pbxspec::Manager::shared_ptr const &specManager, pbxsetting::Environment const &environment, pbxproj::PBX::Project::shared_ptr const &project)
+{
+    Tool::ProjectHeaders projectHeaders;
+
+    HeaderMap projectHeadermap;
+    HeaderMap allTargetHeadermap;
+    HeaderMap allNonFrameworkTargetHeadermap;
+
+    for (pbxproj::PBX::FileReference::shared_ptr const &fileReference : project->fileReferences()) {
+        std::string filePath = environment.expand(fileReference->resolve());
+        if (!IsHeader(specManager, fileReference, filePath)) {
+            continue;
+        }
+
+        std::string fileName = FSUtil::GetBaseName(filePath);
+        std::string fileDirectory = FSUtil::GetDirectoryName(filePath) + "/";
+
+        projectHeaders._projectFiles.push_back({ fileName, fileDirectory });
+        projectHeadermap.add(fileName, fileDirectory, fileName);
+    }
+
+    for (pbxproj::PBX::Target::shared_ptr const &projectTarget : project->targets()) {
+        // TODO(grp): This is a little messy. Maybe check the product type specification, or the product reference's file type?
+        bool isNonFramework = (projectTarget->type() == pbxproj::PBX::Target::Type::Native && std::static_pointer_cast<pbxproj::PBX::NativeTarget>(projectTarget)->productType().find("framework") == std::string::npos);
+
+        for (pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase : projectTarget->buildPhases()) {
+            if (buildPhase->type() != pbxproj::PBX::BuildPhase::Type::Headers) {
+                continue;
+            }
+
+            for (pbxproj::PBX::BuildFile::shared_ptr const &buildFile : buildPhase->files()) {
+                if (buildFile->fileRef() == nullptr || buildFile->fileRef()->type() != pbxproj::PBX::GroupItem::Type::FileReference) {
+                    continue;
+                }
+
+                pbxproj::PBX::FileReference::shared_ptr const &fileReference = std::static_pointer_cast <pbxproj::PBX::FileReference> (buildFile->fileRef());
+                std::string filePath = environment.expand(fileReference->resolve());
+                if (!IsHeader(specManager, fileReference, filePath)) {
+                    continue;
+                }
+
+                std::vector<std::string> const &attributes = buildFile->attributes();
+                bool isPublic  = std::find(attributes.begin(), attributes.end(), "Public") != attributes.end();
+                bool isPrivate = std::find(attributes.begin(), attributes.end(), "Private") != attributes.end();
+
+                TargetHeader header;
+                header.fileName          = FSUtil::GetBaseName(filePath);
+                header.fileDirectory     = FSUtil::GetDirectoryName(filePath) + "/";
+                header.frameworkName     = projectTarget->productName() + "/" + header.fileName;
+                header.isPublicOrPrivate = (isPublic || isPrivate);
+                header.isNonFramework    = isNonFramework;
+
+                if (header.isPublicOrPrivate) {
+                    allTargetHeadermap.add(header.frameworkName, header.fileDirectory, header.fileName);
+                    if (header.isNonFramework) {
+                        allNonFrameworkTargetHeadermap.add(header.frameworkName, header.fileDirectory, header.fileName);
+                    }
+
+                    projectHeaders._frameworkHeaders.push_back(header);
+                }
+
+                projectHeaders._targetHeaders[projectTarget].push_back(header);
+            }
+        }
+    }
+
+    projectHeaders._projectHeadermap = projectHeadermap.write();
+    projectHeaders._allTargetHeadermap = allTargetHeadermap.write();
+    projectHeaders._allNonFrameworkTargetHeadermap = allNonFrameworkTargetHeadermap.write();
+
+    return projectHeaders;
+}
+
+Tool::ProjectHeaders::Cache::
+Cache()
+{
+}
+
+std::shared_ptr<Tool::ProjectHeaders const> Tool::ProjectHeaders::Cache::
+projectHeaders(pbxspec::Manager::shared_ptr const &specManager, pbxsetting::Environment const &environment, pbxproj::PBX::Project::shared_ptr const &project)
+{
+    /*
+     * Header paths are relative to source trees, which can differ between
+     * targets in a project (such as the SDK), so those are part of the key.
+     */
+    std::string key = project->projectFile();
+    for (char const *sourceTree : { "SOURCE_ROOT", "SDKROOT", "BUILT_PRODUCTS_DIR", "DEVELOPER_DIR" }) {
+        key += '\0' + environment.resolve(sourceTree);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _projectHeaders.find(key);
+        if (it != _projectHeaders.end()) {
+            return it->second;
+        }
+    }
+
+    /*
+     * Find the headers without holding the lock, so different projects can
+     * be looked at in parallel. If another thread got there first, use its.
+     */
+    auto projectHeaders = std::make_shared<Tool::ProjectHeaders const>(Tool::ProjectHeaders::Create(specManager, environment, project));
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _projectHeaders.insert({ key, projectHeaders }).first->second;
+}
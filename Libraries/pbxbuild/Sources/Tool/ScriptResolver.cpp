@@ -13,13 +13,21 @@
 #include <pbxsetting/Setting.h>
 #include <pbxsetting/Type.h>
 #include <libutil/Escape.h>
+#include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Hash.h>
 
 #include <algorithm>
+#include <map>
+#include <unordered_set>
+
+#include <cctype>
 
 namespace Tool = pbxbuild::Tool;
 using libutil::Escape;
+using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Hash;
 
 Tool::ScriptResolver::
 ScriptResolver(pbxspec::PBX::Tool::shared_ptr const &tool) :
@@ -51,6 +59,103 @@ ScriptInputOutputLevel(std::vector<std::string> const &inputFiles, std::vector<s
     return pbxsetting::Level(settings);
 }
 
+static pbxsetting::Level
+ScriptFileListLevel(std::vector<std::string> const &inputFileLists, std::vector<std::string> const &outputFileLists)
+{
+    std::vector<pbxsetting::Setting> settings;
+
+    settings.push_back(pbxsetting::Setting::Create("SCRIPT_INPUT_FILE_LIST_COUNT", pbxsetting::Type::FormatInteger(inputFileLists.size())));
+    for (auto it = inputFileLists.begin(); it < inputFileLists.end(); ++it) {
+        size_t index = (it - inputFileLists.begin());
+        settings.push_back(pbxsetting::Setting::Create("SCRIPT_INPUT_FILE_LIST_" + pbxsetting::Type::FormatInteger(index), *it));
+    }
+
+    settings.push_back(pbxsetting::Setting::Create("SCRIPT_OUTPUT_FILE_LIST_COUNT", pbxsetting::Type::FormatInteger(outputFileLists.size())));
+    for (auto it = outputFileLists.begin(); it < outputFileLists.end(); ++it) {
+        size_t index = (it - outputFileLists.begin());
+        settings.push_back(pbxsetting::Setting::Create("SCRIPT_OUTPUT_FILE_LIST_" + pbxsetting::Type::FormatInteger(index), *it));
+    }
+
+    return pbxsetting::Level(settings);
+}
+
+/*
+ * If a variable can be exported from a sourced file. Bash doesn't allow
+ * assigning some variables, even when it runs as /bin/sh.
+ */
+static bool
+ScriptSourceableVariable(std::string const &name)
+{
+    static std::unordered_set<std::string> const readOnly = { "BASHOPTS", "BASH_VERSINFO", "EUID", "PPID", "SHELLOPTS", "UID" };
+
+    if (name.empty() || isdigit(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+
+    for (char c : name) {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '_') {
+            return false;
+        }
+    }
+
+    return (readOnly.find(name) == readOnly.end());
+}
+
+/*
+ * The arguments to /bin/sh to run a script command in its environment: every
+ * setting in the environment, plus the settings in the levels added for just
+ * that script. The settings in the environment are the same for each of the
+ * target's scripts, so they're written once to a file that's sourced before
+ * running the command, rather than passed to every script. The rest are set
+ * for the command with `env`. The file is added to the auxiliary files when
+ * it's first used in the target.
+ */
+static std::vector<std::string>
+ScriptArguments(
+    Tool::Context *toolContext,
+    pbxsetting::Environment const &environment,
+    pbxsetting::Environment const &scriptEnvironment,
+    std::vector<pbxsetting::Level> const &scriptLevels,
+    std::vector<std::string> const &command,
+    std::vector<Tool::Invocation::AuxiliaryFile> *auxiliaryFiles,
+    std::string *environmentFilePath)
+{
+    /* Sorted so the file only changes when the settings do. */
+    std::map<std::string, std::string> shared;
+    std::map<std::string, std::string> variables;
+    for (auto const &value : environment.computeValues(pbxsetting::Condition::Empty())) {
+        (ScriptSourceableVariable(value.first) ? shared : variables).insert(value);
+    }
+
+    for (pbxsetting::Level const &level : scriptLevels) {
+        for (pbxsetting::Setting const &setting : level.settings()) {
+            variables[setting.name()] = scriptEnvironment.resolve(setting.name());
+        }
+    }
+
+    std::string contents;
+    for (auto const &variable : shared) {
+        contents += "export " + variable.first + "=";
+        Escape::Shell(variable.second, &contents);
+        contents += "\n";
+    }
+
+    Hash hash;
+    hash.update(contents);
+    *environmentFilePath = environment.resolve("TEMP_FILES_DIR") + "/Script-Environment-" + hash.hex() + ".sh";
+    if (toolContext->sharedAuxiliaryFile(*environmentFilePath)) {
+        auxiliaryFiles->push_back(Tool::Invocation::AuxiliaryFile::Data(*environmentFilePath, std::vector<uint8_t>(contents.begin(), contents.end())));
+    }
+
+    std::vector<std::string> arguments = { "-c", ". \"$1\" && shift && exec /usr/bin/env \"$@\"", "sh", *environmentFilePath };
+    for (auto const &variable : variables) {
+        arguments.push_back(variable.first + "=" + variable.second);
+    }
+    arguments.insert(arguments.end(), command.begin(), command.end());
+
+    return arguments;
+}
+
 void Tool::ScriptResolver::
 resolve(
     Tool::Context *toolContext,
@@ -71,7 +176,7 @@ resolve(
     Tool::Invocation invocation;
     invocation.executable() = Tool::Invocation::Executable::Determine(legacyTarget->buildToolPath());
     invocation.arguments() = pbxsetting::Type::ParseList(script);
-    invocation.environment() = environmentVariables;
+    invocation.sharedEnvironment() = toolContext->environment(environmentVariables);
     invocation.workingDirectory() = fullWorkingDirectory;
     invocation.logMessage() = logMessage;
     toolContext->invocations().push_back(invocation);
@@ -80,6 +185,7 @@ resolve(
 void Tool::ScriptResolver::
 resolve(
     Tool::Context *toolContext,
+    Filesystem const *filesystem,
     pbxsetting::Environment const &environment,
     pbxproj::PBX::ShellScriptBuildPhase::shared_ptr const &buildPhase) const
 {
@@ -91,9 +197,6 @@ resolve(
     pbxsetting::Environment phaseEnvironment = pbxsetting::Environment(environment);
     phaseEnvironment.insertFront(level, false);
 
-    pbxsetting::Value scriptPath = pbxsetting::Value::Parse("$(TEMP_FILES_DIR)/Script-$(BuildPhaseIdentifier).sh");
-    pbxsetting::Value logMessage = pbxsetting::Value::Parse("PhaseScriptExecution $(BuildPhaseName:quote) ") + scriptPath;
-
     std::vector<std::string> inputFiles;
     std::transform(buildPhase->inputPaths().begin(), buildPhase->inputPaths().end(), std::back_inserter(inputFiles), [&](pbxsetting::Value const &input) -> std::string {
         std::string path = environment.expand(input);
@@ -106,24 +209,86 @@ resolve(
         return FSUtil::ResolveRelativePath(path, toolContext->workingDirectory());
     });
 
-    std::string scriptFilePath = phaseEnvironment.expand(scriptPath);
+    /*
+     * Scripts are named by their contents, so phases running the same script
+     * share one file.
+     */
     std::string contents = (!buildPhase->shellPath().empty() ? "#!" + buildPhase->shellPath() + "\n" : "") + buildPhase->shellScript();
-    auto scriptFile = Tool::Invocation::AuxiliaryFile::Data(scriptFilePath, std::vector<uint8_t>(contents.begin(), contents.end()), true);
+    Hash hash;
+    hash.update(contents);
+    std::string scriptFilePath = environment.resolve("TEMP_FILES_DIR") + "/Script-" + hash.hex() + ".sh";
+    pbxsetting::Value logMessage = pbxsetting::Value::Parse("PhaseScriptExecution $(BuildPhaseName:quote) ") + pbxsetting::Value::String(scriptFilePath);
+
+    std::vector<Tool::Invocation::AuxiliaryFile> auxiliaryFiles;
+    if (toolContext->sharedAuxiliaryFile(scriptFilePath)) {
+        auxiliaryFiles.push_back(Tool::Invocation::AuxiliaryFile::Data(scriptFilePath, std::vector<uint8_t>(contents.begin(), contents.end()), true));
+    }
+
+    /*
+     * File lists add to the inputs and outputs. The script is passed a copy
+     * of each with the paths in it resolved.
+     */
+    std::vector<std::string> phonyInputs = inputFiles;
+    std::vector<std::string> outputs = outputFiles;
+
+    auto resolveFileLists = [&](std::vector<pbxsetting::Value> const &fileListPaths, std::string const &kind, std::vector<std::string> *paths, std::vector<std::string> *resolvedFileLists) {
+        for (size_t n = 0; n < fileListPaths.size(); ++n) {
+            std::string fileListPath = FSUtil::ResolveRelativePath(environment.expand(fileListPaths[n]), toolContext->workingDirectory());
+            phonyInputs.push_back(fileListPath); /* User-specified, may not exist. */
+
+            ext::optional<std::vector<std::string>> listed = FileListPaths(filesystem, environment, toolContext->workingDirectory(), fileListPath);
+            if (!listed) {
+                fprintf(stderr, "warning: could not read file list %s\n", fileListPath.c_str());
+                listed = std::vector<std::string>();
+            }
+            paths->insert(paths->end(), listed->begin(), listed->end());
+
+            std::string resolvedFileList;
+            for (std::string const &path : *listed) {
+                resolvedFileList += path + "\n";
+            }
+
+            std::string resolvedFileListPath = phaseEnvironment.expand(pbxsetting::Value::Parse("$(TEMP_FILES_DIR)/" + kind + "FileList-$(BuildPhaseIdentifier)-"));
+            resolvedFileListPath += std::to_string(n) + "-" + FSUtil::GetBaseNameWithoutExtension(fileListPath) + "-resolved.xcfilelist";
+            auxiliaryFiles.push_back(Tool::Invocation::AuxiliaryFile::Data(resolvedFileListPath, std::vector<uint8_t>(resolvedFileList.begin(), resolvedFileList.end())));
+            resolvedFileLists->push_back(resolvedFileListPath);
+        }
+    };
+
+    std::vector<std::string> inputFileLists;
+    std::vector<std::string> outputFileLists;
+    resolveFileLists(buildPhase->inputFileListPaths(), "Input", &phonyInputs, &inputFileLists);
+    resolveFileLists(buildPhase->outputFileListPaths(), "Output", &outputs, &outputFileLists);
 
+    pbxsetting::Level scriptLevel = ScriptInputOutputLevel(inputFiles, outputFiles, true);
+    pbxsetting::Level fileListLevel = ScriptFileListLevel(inputFileLists, outputFileLists);
     pbxsetting::Environment scriptEnvironment = pbxsetting::Environment(environment);
-    scriptEnvironment.insertFront(ScriptInputOutputLevel(inputFiles, outputFiles, true), false);
-    std::unordered_map<std::string, std::string> environmentVariables = scriptEnvironment.computeValues(pbxsetting::Condition::Empty());
+    scriptEnvironment.insertFront(scriptLevel, false);
+    scriptEnvironment.insertFront(fileListLevel, false);
+    std::string environmentFilePath;
+    std::vector<std::string> arguments = ScriptArguments(toolContext, environment, scriptEnvironment, { scriptLevel, fileListLevel }, { "/bin/sh", "-c", Escape::Shell(scriptFilePath) }, &auxiliaryFiles, &environmentFilePath);
+
+    /*
+     * The script, its environment and resolved file lists are written before
+     * it runs, and only change when they're different, so they're inputs like
+     * any other.
+     */
+    std::vector<std::string> inputs = { scriptFilePath, environmentFilePath };
+    inputs.insert(inputs.end(), inputFileLists.begin(), inputFileLists.end());
+    inputs.insert(inputs.end(), outputFileLists.begin(), outputFileLists.end());
 
     Tool::Invocation invocation;
     invocation.executable() = Tool::Invocation::Executable::External("/bin/sh");
-    invocation.arguments() = { "-c", Escape::Shell(scriptFilePath) };
-    invocation.environment() = environmentVariables;
+    invocation.arguments() = arguments;
     invocation.workingDirectory() = toolContext->workingDirectory();
-    invocation.phonyInputs() = inputFiles; /* User-specified, may not exist. */
-    invocation.outputs() = outputFiles;
-    invocation.auxiliaryFiles() = { scriptFile };
+    invocation.inputs() = inputs;
+    invocation.phonyInputs() = phonyInputs; /* User-specified, may not exist. */
+    invocation.outputs() = outputs;
+    invocation.auxiliaryFiles() = auxiliaryFiles;
     invocation.logMessage() = phaseEnvironment.expand(logMessage);
     invocation.showEnvironmentInLog() = buildPhase->showEnvVarsInLog();
+    /* Without outputs, there's nothing to tell if the script needs to run. */
+    invocation.alwaysOutOfDate() = (buildPhase->alwaysOutOfDate() || outputs.empty());
     toolContext->invocations().push_back(invocation);
 }
 
@@ -173,21 +338,62 @@ resolve(
     /*
      * Compute the final environment by adding the standard script levels.
      */
-    ruleEnvironment.insertFront(ScriptInputOutputLevel({ inputAbsolutePath }, outputFiles, false), false);
-    std::unordered_map<std::string, std::string> environmentVariables = ruleEnvironment.computeValues(pbxsetting::Condition::Empty());
+    pbxsetting::Level scriptLevel = ScriptInputOutputLevel({ inputAbsolutePath }, outputFiles, false);
+    ruleEnvironment.insertFront(scriptLevel, false);
+    std::vector<Tool::Invocation::AuxiliaryFile> auxiliaryFiles;
+    std::string environmentFilePath;
+    std::vector<std::string> arguments = ScriptArguments(toolContext, environment, ruleEnvironment, { level, scriptLevel }, { "/bin/sh", "-c", buildRule->script() }, &auxiliaryFiles, &environmentFilePath);
 
     Tool::Invocation invocation;
     invocation.executable() = Tool::Invocation::Executable::External("/bin/sh");
-    invocation.arguments() = { "-c", buildRule->script() };
-    invocation.environment() = environmentVariables;
+    invocation.arguments() = arguments;
     invocation.workingDirectory() = toolContext->workingDirectory();
-    invocation.inputs() = { inputAbsolutePath };
+    invocation.inputs() = { inputAbsolutePath, environmentFilePath };
     invocation.outputs() = outputFiles;
+    invocation.auxiliaryFiles() = auxiliaryFiles;
     invocation.logMessage() = ruleEnvironment.expand(logMessage);
     invocation.showEnvironmentInLog() = true;
     toolContext->invocations().push_back(invocation);
 }
 
+ext::optional<std::vector<std::string>> Tool::ScriptResolver::
+FileListPaths(
+    Filesystem const *filesystem,
+    pbxsetting::Environment const &environment,
+    std::string const &workingDirectory,
+    std::string const &path)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return ext::nullopt;
+    }
+
+    std::vector<std::string> paths;
+
+    std::string text = std::string(contents.begin(), contents.end());
+    for (std::string::size_type start = 0; start < text.size(); ) {
+        std::string::size_type end = text.find('\n', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+
+        std::string line = text.substr(start, end - start);
+        start = end + 1;
+
+        /* Surrounding whitespace includes the carriage return of CRLF lines. */
+        std::string::size_type first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        std::string::size_type last = line.find_last_not_of(" \t\r");
+
+        std::string expanded = environment.expand(pbxsetting::Value::Parse(line.substr(first, last - first + 1)));
+        paths.push_back(FSUtil::ResolveRelativePath(expanded, workingDirectory));
+    }
+
+    return paths;
+}
+
 std::unique_ptr<Tool::ScriptResolver> Tool::ScriptResolver::
 Create(Phase::Environment const &phaseEnvironment)
 {
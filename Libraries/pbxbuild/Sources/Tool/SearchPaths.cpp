@@ -23,16 +23,63 @@ SearchPaths(
     std::vector<std::string> const &headerSearchPaths,
     std::vector<std::string> const &userHeaderSearchPaths,
     std::vector<std::string> const &frameworkSearchPaths,
-    std::vector<std::string> const &librarySearchPaths) :
+    std::vector<std::string> const &librarySearchPaths,
+    std::shared_ptr<RecursiveCache> const &recursiveCache) :
     _headerSearchPaths    (headerSearchPaths),
     _userHeaderSearchPaths(userHeaderSearchPaths),
     _frameworkSearchPaths (frameworkSearchPaths),
-    _librarySearchPaths   (librarySearchPaths)
+    _librarySearchPaths   (librarySearchPaths),
+    _recursiveCache       (recursiveCache)
 {
 }
 
+Tool::SearchPaths::RecursiveCache::
+RecursiveCache()
+{
+}
+
+static std::vector<std::string>
+FindSubdirectories(Filesystem const *filesystem, std::string const &root)
+{
+    std::vector<std::string> subdirectories;
+    filesystem->enumerateRecursive(root, [&](std::string const &path, bool directory) -> bool {
+        // TODO(grp): Use build settings for included and excluded recursive paths.
+        // Included: INCLUDED_RECURSIVE_SEARCH_PATH_SUBDIRECTORIES
+        // Excluded: EXCLUDED_RECURSIVE_SEARCH_PATH_SUBDIRECTORIES
+        // Follow: RECURSIVE_SEARCH_PATHS_FOLLOW_SYMLINKS
+
+        if (directory) {
+            subdirectories.push_back(path.substr(root.size() + 1));
+        }
+        return true;
+    });
+    return subdirectories;
+}
+
+std::shared_ptr<std::vector<std::string> const> Tool::SearchPaths::RecursiveCache::
+subdirectories(Filesystem const *filesystem, std::string const &root)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _subdirectories.find(root);
+        if (it != _subdirectories.end()) {
+            return it->second;
+        }
+    }
+
+    /*
+     * Walk the root without holding the lock, so different roots can be
+     * walked in parallel. If another thread got there first, use its.
+     */
+    auto subdirectories = std::make_shared<std::vector<std::string> const>(FindSubdirectories(filesystem, root));
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _subdirectories.insert({ root, subdirectories }).first->second;
+}
+
 static void
-AppendPaths(std::vector<std::string> *args, pbxsetting::Environment const &environment, std::string const &workingDirectory, std::vector<std::string> const &paths)
+AppendPaths(std::vector<std::string> *args, pbxsetting::Environment const &environment, std::string const &workingDirectory, Tool::SearchPaths::RecursiveCache *recursiveCache, std::vector<std::string> const &paths)
 {
     Filesystem const *filesystem = Filesystem::GetDefaultUNSAFE();
 
@@ -56,18 +103,12 @@ AppendPaths(std::vector<std::string> *args, pbxsetting::Environment const &envir
             args->push_back(root);
 
             std::string absoluteRoot = FSUtil::ResolveRelativePath(root, workingDirectory);
-            filesystem->enumerateRecursive(absoluteRoot, [&](std::string const &path) -> bool {
-                // TODO(grp): Use build settings for included and excluded recursive paths.
-                // Included: INCLUDED_RECURSIVE_SEARCH_PATH_SUBDIRECTORIES
-                // Excluded: EXCLUDED_RECURSIVE_SEARCH_PATH_SUBDIRECTORIES
-                // Follow: RECURSIVE_SEARCH_PATHS_FOLLOW_SYMLINKS
-
-                if (filesystem->isDirectory(path)) {
-                    std::string relativePath = root + "/" + path.substr(absoluteRoot.size() + 1);
-                    args->push_back(relativePath);
-                }
-                return true;
-            });
+            std::shared_ptr<std::vector<std::string> const> subdirectories = (recursiveCache != nullptr ?
+                recursiveCache->subdirectories(filesystem, absoluteRoot) :
+                std::make_shared<std::vector<std::string> const>(FindSubdirectories(filesystem, absoluteRoot)));
+            for (std::string const &subdirectory : *subdirectories) {
+                args->push_back(root + "/" + subdirectory);
+            }
         } else {
             args->push_back(path);
         }
@@ -75,29 +116,29 @@ AppendPaths(std::vector<std::string> *args, pbxsetting::Environment const &envir
 }
 
 std::vector<std::string> Tool::SearchPaths::
-ExpandRecursive(std::vector<std::string> const &paths, pbxsetting::Environment const &environment, std::string const &workingDirectory)
+ExpandRecursive(std::vector<std::string> const &paths, pbxsetting::Environment const &environment, std::string const &workingDirectory, RecursiveCache *recursiveCache)
 {
     std::vector<std::string> result;
-    AppendPaths(&result, environment, workingDirectory, paths);
+    AppendPaths(&result, environment, workingDirectory, recursiveCache, paths);
     return result;
 }
 
 Tool::SearchPaths Tool::SearchPaths::
-Create(pbxsetting::Environment const &environment, std::string const &workingDirectory)
+Create(pbxsetting::Environment const &environment, std::string const &workingDirectory, std::shared_ptr<RecursiveCache> const &recursiveCache)
 {
     std::vector<std::string> headerSearchPaths;
-    AppendPaths(&headerSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("PRODUCT_TYPE_HEADER_SEARCH_PATHS")));
-    AppendPaths(&headerSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("HEADER_SEARCH_PATHS")));
+    AppendPaths(&headerSearchPaths, environment, workingDirectory, recursiveCache.get(), pbxsetting::Type::ParseList(environment.resolve("PRODUCT_TYPE_HEADER_SEARCH_PATHS")));
+    AppendPaths(&headerSearchPaths, environment, workingDirectory, recursiveCache.get(), pbxsetting::Type::ParseList(environment.resolve("HEADER_SEARCH_PATHS")));
 
     std::vector<std::string> userHeaderSearchPaths;
-    AppendPaths(&userHeaderSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("USER_HEADER_SEARCH_PATHS")));
+    AppendPaths(&userHeaderSearchPaths, environment, workingDirectory, recursiveCache.get(), pbxsetting::Type::ParseList(environment.resolve("USER_HEADER_SEARCH_PATHS")));
 
     std::vector<std::string> frameworkSearchPaths;
-    AppendPaths(&frameworkSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("FRAMEWORK_SEARCH_PATHS")));
-    AppendPaths(&frameworkSearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("PRODUCT_TYPE_FRAMEWORK_SEARCH_PATHS")));
+    AppendPaths(&frameworkSearchPaths, environment, workingDirectory, recursiveCache.get(), pbxsetting::Type::ParseList(environment.resolve("FRAMEWORK_SEARCH_PATHS")));
+    AppendPaths(&frameworkSearchPaths, environment, workingDirectory, recursiveCache.get(), pbxsetting::Type::ParseList(environment.resolve("PRODUCT_TYPE_FRAMEWORK_SEARCH_PATHS")));
 
     std::vector<std::string> librarySearchPaths;
-    AppendPaths(&librarySearchPaths, environment, workingDirectory, pbxsetting::Type::ParseList(environment.resolve("LIBRARY_SEARCH_PATHS")));
+    AppendPaths(&librarySearchPaths, environment, workingDirectory, recursiveCache.get(), pbxsetting::Type::ParseList(environment.resolve("LIBRARY_SEARCH_PATHS")));
 
-    return Tool::SearchPaths(headerSearchPaths, userHeaderSearchPaths, frameworkSearchPaths, librarySearchPaths);
+    return Tool::SearchPaths(headerSearchPaths, userHeaderSearchPaths, frameworkSearchPaths, librarySearchPaths, recursiveCache);
 }
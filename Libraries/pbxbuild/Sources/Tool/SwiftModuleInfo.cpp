@@ -17,12 +17,14 @@ SwiftModuleInfo(
     std::string const &moduleName,
     std::string const &modulePath,
     std::string const &docPath,
+    ext::optional<std::string> const &interfacePath,
     std::string const &headerPath,
     bool installHeader) :
     _architecture (architecture),
     _moduleName   (moduleName),
     _modulePath   (modulePath),
     _docPath      (docPath),
+    _interfacePath(interfacePath),
     _headerPath   (headerPath),
     _installHeader(installHeader)
 {
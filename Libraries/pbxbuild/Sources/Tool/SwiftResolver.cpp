@@ -21,6 +21,9 @@
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 
+#include <algorithm>
+#include <unordered_map>
+
 namespace Tool = pbxbuild::Tool;
 namespace Phase = pbxbuild::Phase;
 using libutil::Filesystem;
@@ -78,6 +81,76 @@ SwiftDocPath(std::string const &moduleName, std::string const &modulePath)
     return FSUtil::GetDirectoryName(modulePath) + "/" + moduleName + ".swiftdoc";
 }
 
+/*
+ * Parallel jobs for the Swift driver. Defaults to 8.
+ */
+static size_t
+SwiftJobs(pbxsetting::Environment const &environment)
+{
+    // TODO(grp): Get the number of parallel build tasks here.
+    int64_t jobs = pbxsetting::Type::ParseInteger(environment.resolve("SWIFT_PARALLEL_JOBS"));
+    return (jobs > 0 ? static_cast<size_t>(jobs) : 8);
+}
+
+/*
+ * How many batches to split the files into in batch mode: one per job, or
+ * enough that none holds more than SWIFT_BATCH_SIZE files, whichever is
+ * more. Never more than the number of files.
+ */
+static size_t
+SwiftBatchCount(pbxsetting::Environment const &environment, size_t files, size_t jobs)
+{
+    size_t count = jobs;
+
+    int64_t size = pbxsetting::Type::ParseInteger(environment.resolve("SWIFT_BATCH_SIZE"));
+    if (size > 0) {
+        count = std::max(count, (files + static_cast<size_t>(size) - 1) / static_cast<size_t>(size));
+    }
+
+    return std::max<size_t>(std::min(count, files), 1);
+}
+
+/*
+ * If the Swift driver should only recompile the files affected by what
+ * changed. Whole module builds always compile everything.
+ */
+static bool
+SwiftIncremental(pbxsetting::Environment const &environment, bool wholeModuleOptimization)
+{
+    if (wholeModuleOptimization) {
+        return false;
+    }
+
+    /* On unless turned off. */
+    std::string incremental = environment.resolve("SWIFT_ENABLE_INCREMENTAL_COMPILATION");
+    return (incremental.empty() || pbxsetting::Type::ParseBoolean(incremental));
+}
+
+/*
+ * The name of each input's outputs. Inputs with the same name in different
+ * directories get a number after the name, in the order of the inputs, so
+ * the names stay the same from build to build.
+ */
+static std::vector<std::string>
+OutputNames(std::vector<Phase::File> const &inputs)
+{
+    std::vector<std::string> names;
+    std::unordered_map<std::string, size_t> counts;
+
+    for (Phase::File const &input : inputs) {
+        std::string name = FSUtil::GetBaseNameWithoutExtension(input.path());
+
+        size_t count = counts[name]++;
+        if (count != 0) {
+            name += "-" + std::to_string(count);
+        }
+
+        names.push_back(name);
+    }
+
+    return names;
+}
+
 static void
 AppendOutputs(
     std::vector<std::string> *args,
@@ -88,19 +161,29 @@ AppendOutputs(
     std::string const &moduleName,
     std::string const &modulePath,
     std::vector<Phase::File> const &inputs,
-    bool includeBitcode)
+    bool includeBitcode,
+    bool incremental)
 {
     std::unique_ptr<plist::Dictionary> outputInfo = plist::Dictionary::New();
 
-    /* Top-level outputs for the entire module. */
+    /*
+     * Top-level outputs for the entire module. When building incrementally,
+     * the driver records what it built here, and reads it back next time to
+     * find the files that need compiling again.
+     */
     std::string moduleDependencies = outputDirectory + "/" + moduleName + "-master.swiftdeps";
+    if (incremental) {
+        outputs->push_back(moduleDependencies);
+    }
 
     std::unique_ptr<plist::Dictionary> module = plist::Dictionary::New();
     module->set("swift-dependencies", plist::String::New(moduleDependencies));
     outputInfo->set("", std::move(module));
 
-    for (Phase::File const &input : inputs) {
-        std::string name = FSUtil::GetBaseNameWithoutExtension(input.path());
+    std::vector<std::string> names = OutputNames(inputs);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        Phase::File const &input = inputs[i];
+        std::string const &name = names[i];
 
         /* Add input argument. */
         args->push_back(input.path());
@@ -143,7 +226,11 @@ AppendOutputs(
         outputInfo->set(input.path(), std::move(dict));
     }
 
-    /* Serialize output map as JSON. */
+    /*
+     * Serialize output map as JSON. It's the same for the same inputs, so
+     * it's only written again when they change; the driver compares it with
+     * the last build to find what's out of date.
+     */
     auto serialized = plist::Format::JSON::Serialize(outputInfo.get(), plist::Format::JSON::Create());
     if (!serialized.first) {
         fprintf(stderr, "error: %s\n", serialized.second.c_str());
@@ -349,14 +436,39 @@ resolve(
     arguments.push_back("-c");
 
     /* Enable parallelization. */
+    size_t jobs = SwiftJobs(environment);
     bool wholeModuleOptimization = (pbxsetting::Type::ParseBoolean(environment.resolve("SWIFT_WHOLE_MODULE_OPTIMIZATION")) || environment.resolve("SWIFT_OPTIMIZATION_LEVEL") == "-Owholemodule");
     if (!wholeModuleOptimization || !pbxsetting::Type::ParseBoolean(environment.resolve("SWIFT_USE_PARALLEL_WHOLE_MODULE_OPTIMIZATION"))) {
-        // TODO(grp): Get the number of parallel build tasks here.
-        arguments.push_back("-j8");
+        arguments.push_back("-j" + std::to_string(jobs));
+
+        /*
+         * Batch mode compiles several files in each frontend process, so
+         * large modules don't pay for one process per file. The batches are
+         * planned here so they stay the same from build to build.
+         */
+        if (!wholeModuleOptimization && pbxsetting::Type::ParseBoolean(environment.resolve("SWIFT_ENABLE_BATCH_MODE"))) {
+            arguments.push_back("-enable-batch-mode");
+            arguments.push_back("-driver-batch-count");
+            arguments.push_back(std::to_string(SwiftBatchCount(environment, inputs.size(), jobs)));
+
+            std::string threads = environment.resolve("SWIFT_BATCH_NUM_THREADS");
+            if (!threads.empty()) {
+                arguments.push_back("-num-threads");
+                arguments.push_back(threads);
+            }
+        }
     } else {
-        // TODO(grp): Get the number of parallel build tasks here.
         arguments.push_back("-num-threads");
-        arguments.push_back("8");
+        arguments.push_back(std::to_string(jobs));
+    }
+
+    /*
+     * Compile only the files that changed and the files that depend on them.
+     * The specification can pass this flag already.
+     */
+    bool incremental = SwiftIncremental(environment, wholeModuleOptimization);
+    if (incremental && std::find(arguments.begin(), arguments.end(), "-incremental") == arguments.end()) {
+        arguments.push_back("-incremental");
     }
 
     /*
@@ -365,7 +477,19 @@ resolve(
     std::string moduleName = environment.resolve("SWIFT_MODULE_NAME");
     std::string modulePath = outputDirectory + "/" + moduleName + ".swiftmodule";
     bool includeBitcode = pbxsetting::Type::ParseBoolean(environment.resolve("ENABLE_BITCODE"));
-    AppendOutputs(&arguments, &outputs, &dependencyInfo, &auxiliaryFiles, outputDirectory, moduleName, modulePath, inputs, includeBitcode);
+    AppendOutputs(&arguments, &outputs, &dependencyInfo, &auxiliaryFiles, outputDirectory, moduleName, modulePath, inputs, includeBitcode, incremental);
+
+    /*
+     * Emit a textual interface for the module, for libraries built to be
+     * used by later compilers.
+     */
+    ext::optional<std::string> interfacePath;
+    if (pbxsetting::Type::ParseBoolean(environment.resolve("SWIFT_EMIT_MODULE_INTERFACE")) || pbxsetting::Type::ParseBoolean(environment.resolve("BUILD_LIBRARY_FOR_DISTRIBUTION"))) {
+        interfacePath = outputDirectory + "/" + moduleName + ".swiftinterface";
+        arguments.push_back("-emit-module-interface-path");
+        arguments.push_back(*interfacePath);
+        outputs.push_back(*interfacePath);
+    }
 
     /*
      * Add flags for interacting with Objective-C code.
@@ -396,14 +520,22 @@ resolve(
      */
     Tool::Invocation invocation;
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
+    invocation.toolIdentifier() = _compiler->identifier();
     invocation.arguments() = arguments;
-    invocation.environment() = options.environment();
+    invocation.sharedEnvironment() = toolContext->environment(options.environment());
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
     invocation.outputs() = outputs;
     invocation.dependencyInfo() = dependencyInfo;
     invocation.auxiliaryFiles() = auxiliaryFiles;
     invocation.logMessage() = logMessage;
+    invocation.stage() = Tool::Invocation::Stage::CompileInterface;
+
+    /*
+     * The driver leaves the module and its interface alone when they would
+     * be the same, so dependents only compile again when the module changes.
+     */
+    invocation.keepsUnchangedOutputs() = true;
     toolContext->invocations().push_back(invocation);
 
     auto variantArchitectureKey = std::make_pair(environment.resolve("variant"), environment.resolve("arch"));
@@ -417,6 +549,7 @@ resolve(
         moduleName,
         modulePath,
         SwiftDocPath(moduleName, modulePath),
+        interfacePath,
         headerPath,
         pbxsetting::Type::ParseBoolean(environment.resolve("SWIFT_INSTALL_OBJC_HEADER")));
     toolContext->swiftModuleInfo().push_back(swiftModuleInfo);
@@ -16,6 +16,9 @@
 #include <pbxsetting/Level.h>
 #include <pbxsetting/Setting.h>
 #include <pbxsetting/Type.h>
+#include <xcsdk/SDK/Toolchain.h>
+
+#include <algorithm>
 
 namespace Tool = pbxbuild::Tool;
 
@@ -44,10 +47,30 @@ resolve(
     Tool::OptionsResult options = Tool::OptionsResult::Create(toolEnvironment, toolContext->workingDirectory(), nullptr);
     Tool::Tokens::ToolExpansions tokens = Tool::Tokens::ExpandTool(toolEnvironment, options);
 
+    /*
+     * Copy the libraries with the builtin tool, unless they need signing.
+     * The builtin runs in the build's process, so each product embedding
+     * Swift shares the scans of the binaries and libraries it has in common
+     * with the others. It finds the libraries in the build's toolchains.
+     */
+    std::string toolExecutable = tokens.executable();
+    std::vector<std::string> arguments = tokens.arguments();
+    if (std::find(arguments.begin(), arguments.end(), "--sign") == arguments.end()) {
+        toolExecutable = "builtin-swiftStdLibTool";
+
+        if (std::find(arguments.begin(), arguments.end(), "--toolchain") == arguments.end() && std::find(arguments.begin(), arguments.end(), "--source-libraries") == arguments.end()) {
+            for (xcsdk::SDK::Toolchain::shared_ptr const &toolchain : toolContext->toolchains()) {
+                arguments.push_back("--toolchain");
+                arguments.push_back(toolchain->path());
+            }
+        }
+    }
+
     Tool::Invocation invocation;
-    invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
-    invocation.arguments() = tokens.arguments();
-    invocation.environment() = options.environment();
+    invocation.executable() = Tool::Invocation::Executable::Determine(toolExecutable);
+    invocation.toolIdentifier() = _tool->identifier();
+    invocation.arguments() = arguments;
+    invocation.sharedEnvironment() = toolContext->environment(options.environment());
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
     invocation.outputs() = { }; // TODO(grp): Outputs are not known at build time.
@@ -31,8 +31,8 @@ resolve(
     std::string logMessage = "SymLink " + targetPath + " " + symlinkPath;
 
     Tool::Invocation invocation;
-    invocation.executable() = Tool::Invocation::Executable::External("/bin/ln");
-    invocation.arguments() = { "-sfh", targetPath, symlinkPath };
+    invocation.executable() = Tool::Invocation::Executable::Builtin("builtin-symlink");
+    invocation.arguments() = { targetPath, symlinkPath };
     invocation.workingDirectory() = workingDirectory;
     invocation.phonyInputs() = { FSUtil::ResolveRelativePath(targetPath, workingDirectory) };
     invocation.outputs() = { FSUtil::ResolveRelativePath(symlinkPath, workingDirectory) };
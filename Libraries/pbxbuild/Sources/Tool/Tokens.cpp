@@ -13,19 +13,63 @@
 
 #include <algorithm>
 #include <iterator>
+#include <mutex>
 #include <sstream>
 
 namespace Tool = pbxbuild::Tool;
 
-std::vector<std::string> Tool::Tokens::
-Expand(
-    std::string const &tokenized,
-    std::string const &executable,
-    std::vector<std::string> const &options,
-    std::vector<std::string> const &specialArgs,
-    std::vector<std::string> const &inputs,
-    std::vector<std::string> const &outputs)
+namespace {
+
+/*
+ * A template split into the tokens and literal arguments it's made of.
+ */
+struct Template {
+    enum class Type {
+        Literal,
+        Input,
+        Output,
+        Inputs,
+        Outputs,
+        Options,
+        ExecPath,
+        SpecialArgs,
+    };
+
+    struct Instruction {
+        Type              type;
+        std::string       literal;
+        pbxsetting::Value value;
+    };
+
+    std::vector<Instruction> instructions;
+};
+
+/*
+ * The arguments to instantiate a template with.
+ */
+struct TemplateValues {
+    std::string const              &executable;
+    std::vector<std::string> const &options;
+    std::vector<std::string> const &specialArgs;
+    std::vector<std::string> const &inputs;
+    std::vector<std::string> const &outputs;
+};
+
+}
+
+static Template
+CompileTemplate(std::string const &tokenized)
 {
+    static std::unordered_map<std::string, Template::Type> const types = {
+        { "input", Template::Type::Input },
+        { "output", Template::Type::Output },
+        { "inputs", Template::Type::Inputs },
+        { "outputs", Template::Type::Outputs },
+        { "options", Template::Type::Options },
+        { "exec-path", Template::Type::ExecPath },
+        { "special-args", Template::Type::SpecialArgs },
+    };
+
     /*
      * Split the tokens on spaces.
      */
@@ -33,38 +77,122 @@ Expand(
     std::stringstream sstream(tokenized);
     std::copy(std::istream_iterator<std::string>(sstream), std::istream_iterator<std::string>(), std::back_inserter(tokens));
 
-    /*
-     * The tokens that are supported for expansion.
-     */
-    std::string const &input = (!inputs.empty() ? inputs.front() : "");
-    std::string const &output = (!outputs.empty() ? outputs.front() : "");
-    std::unordered_map<std::string, std::vector<std::string>> tokenValues = {
-        { "input", { input } },
-        { "output", { output } },
-        { "inputs", inputs },
-        { "outputs", outputs },
-        { "options", options },
-        { "exec-path", { executable } },
-        { "special-args", specialArgs },
-    };
+    Template result;
 
-    std::vector<std::string> result;
     for (std::string const &entry : tokens) {
-        /* If the entry is a token, replace it with the token's value. */
+        /* If the entry is a token, it's replaced with the token's value. */
         if (entry.find('[') == 0 && entry.find(']') == entry.size() - 1) {
-            std::string token = entry.substr(1, entry.size() - 2);
-            auto it = tokenValues.find(token);
-            if (it != tokenValues.end()) {
-                /* A token can have multiple values; append them all. */
-                result.insert(result.end(), it->second.begin(), it->second.end());
+            auto it = types.find(entry.substr(1, entry.size() - 2));
+            if (it != types.end()) {
+                result.instructions.push_back({ it->second, std::string(), pbxsetting::Value::Empty() });
                 continue;
             }
         }
 
-        /* If not, just add the value literally. */
-        result.push_back(entry);
+        /* If not, the value is added literally. */
+        result.instructions.push_back({ Template::Type::Literal, entry, pbxsetting::Value::Parse(entry) });
+    }
+
+    return result;
+}
+
+/*
+ * Command line templates come from tool specifications, so there are only
+ * a few, each used for many invocations. Split each one once, and share it.
+ */
+static std::shared_ptr<Template const>
+SharedTemplate(std::string const &tokenized)
+{
+    /* Never freed, so the cache is usable until exit. */
+    static std::mutex *mutex = new std::mutex();
+    static auto *templates = new std::unordered_map<std::string, std::shared_ptr<Template const>>();
+
+    {
+        std::lock_guard<std::mutex> lock(*mutex);
+
+        auto it = templates->find(tokenized);
+        if (it != templates->end()) {
+            return it->second;
+        }
+    }
+
+    auto compiled = std::make_shared<Template const>(CompileTemplate(tokenized));
+
+    std::lock_guard<std::mutex> lock(*mutex);
+    return templates->insert({ tokenized, compiled }).first->second;
+}
+
+/*
+ * Appends the arguments of a template with its tokens replaced. Arguments
+ * are expanded in the environment, if there is one: literal arguments with
+ * their settings parsed ahead of time, and token values as they're used.
+ */
+static void
+InstantiateTemplate(std::vector<std::string> *result, Template const &compiled, TemplateValues const &values, pbxsetting::Environment const *environment)
+{
+    auto append = [&](std::string const &value) {
+        /* Only a value with a setting reference can expand to anything else. */
+        if (environment != nullptr && value.find('$') != std::string::npos) {
+            result->push_back(environment->expand(pbxsetting::Value::Parse(value)));
+        } else {
+            result->push_back(value);
+        }
+    };
+    auto appendAll = [&](std::vector<std::string> const &values) {
+        /* A token can have multiple values; append them all. */
+        for (std::string const &value : values) {
+            append(value);
+        }
+    };
+
+    /* Every token but one of the lists is a single argument. */
+    result->reserve(result->size() + compiled.instructions.size() + values.options.size() + values.specialArgs.size() + values.inputs.size() + values.outputs.size());
+
+    for (Template::Instruction const &instruction : compiled.instructions) {
+        switch (instruction.type) {
+            case Template::Type::Literal:
+                if (environment != nullptr) {
+                    result->push_back(environment->expand(instruction.value));
+                } else {
+                    result->push_back(instruction.literal);
+                }
+                break;
+            case Template::Type::Input:
+                append(!values.inputs.empty() ? values.inputs.front() : std::string());
+                break;
+            case Template::Type::Output:
+                append(!values.outputs.empty() ? values.outputs.front() : std::string());
+                break;
+            case Template::Type::Inputs:
+                appendAll(values.inputs);
+                break;
+            case Template::Type::Outputs:
+                appendAll(values.outputs);
+                break;
+            case Template::Type::Options:
+                appendAll(values.options);
+                break;
+            case Template::Type::ExecPath:
+                append(values.executable);
+                break;
+            case Template::Type::SpecialArgs:
+                appendAll(values.specialArgs);
+                break;
+        }
     }
+}
 
+std::vector<std::string> Tool::Tokens::
+Expand(
+    std::string const &tokenized,
+    std::string const &executable,
+    std::vector<std::string> const &options,
+    std::vector<std::string> const &specialArgs,
+    std::vector<std::string> const &inputs,
+    std::vector<std::string> const &outputs)
+{
+    std::vector<std::string> result;
+    InstantiateTemplate(&result, CompileTemplate(tokenized), { executable, options, specialArgs, inputs, outputs }, nullptr);
     return result;
 }
 
@@ -113,16 +241,17 @@ ExpandTool(
      * Expand the command line, then expand the settings within it. Can't expand the command
      * line's settings first or, if the values contain spaces, they would be split incorrectly.
      */
-    std::vector<std::string> expandedCommandLine = Expand(resolvedCommandLine, resolvedExecutable, arguments, specialArguments, inputs, outputs);
-    for (auto &it : expandedCommandLine) {
-        it = environment.expand(pbxsetting::Value::Parse(it));
-    }
+    std::vector<std::string> expandedArguments;
+    InstantiateTemplate(&expandedArguments, *SharedTemplate(resolvedCommandLine), { resolvedExecutable, arguments, specialArguments, inputs, outputs }, &environment);
 
     /*
      * Extract the executable / arguments.
      */
-    std::string const &expandedExecutable = (!expandedCommandLine.empty() ? expandedCommandLine.front() : "");
-    std::vector<std::string> expandedArguments = std::vector<std::string>(expandedCommandLine.begin() + (!expandedCommandLine.empty() ? 1 : 0), expandedCommandLine.end());
+    std::string expandedExecutable;
+    if (!expandedArguments.empty()) {
+        expandedExecutable = std::move(expandedArguments.front());
+        expandedArguments.erase(expandedArguments.begin());
+    }
 
     /*
      * Determine the input for the log message.
@@ -14,6 +14,8 @@
 #include <pbxbuild/Tool/Context.h>
 #include <libutil/FSUtil.h>
 
+#include <algorithm>
+
 namespace Tool = pbxbuild::Tool;
 using libutil::FSUtil;
 
@@ -28,6 +30,18 @@ Tool::ToolResolver::
 {
 }
 
+static bool
+GroupsByOutputDirectory(pbxspec::PBX::Tool::shared_ptr const &tool)
+{
+    if (tool->type() != pbxspec::PBX::Compiler::Type()) {
+        return false;
+    }
+
+    pbxspec::PBX::Compiler::shared_ptr const &compiler = std::static_pointer_cast<pbxspec::PBX::Compiler>(tool);
+    std::vector<std::string> const &groupings = compiler->inputFileGroupings().value_or(std::vector<std::string>());
+    return (std::find(groupings.begin(), groupings.end(), "output-directory") != groupings.end());
+}
+
 void Tool::ToolResolver::
 resolve(
     Tool::Context *toolContext,
@@ -52,11 +66,27 @@ resolve(
 
     Tool::Invocation invocation;
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.arguments() = tokens.arguments();
-    invocation.environment() = options.environment();
+    invocation.sharedEnvironment() = toolContext->environment(options.environment());
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
     invocation.outputs() = toolEnvironment.outputs(toolContext->workingDirectory());
+
+    if (inputs.size() > 1 && GroupsByOutputDirectory(_tool)) {
+        /*
+         * The command line and outputs are expanded for the first input. The
+         * tool takes its inputs last, so add the rest after, with their outputs.
+         */
+        for (auto it = std::next(inputs.begin()); it != inputs.end(); ++it) {
+            Tool::Environment inputEnvironment = Tool::Environment::Create(_tool, environment, toolContext->workingDirectory(), { *it });
+            invocation.arguments().push_back(inputEnvironment.environment().resolve("InputFileRelativePath"));
+
+            std::vector<std::string> outputs = inputEnvironment.outputs(toolContext->workingDirectory());
+            invocation.outputs().insert(invocation.outputs().end(), outputs.begin(), outputs.end());
+        }
+    }
+
     invocation.dependencyInfo() = dependencyInfo;
     invocation.logMessage() = resolvedLogMessage;
     toolContext->invocations().push_back(invocation);
@@ -77,8 +107,9 @@ resolve(
 
     Tool::Invocation invocation;
     invocation.executable() = Tool::Invocation::Executable::Determine(tokens.executable());
+    invocation.toolIdentifier() = _tool->identifier();
     invocation.arguments() = tokens.arguments();
-    invocation.environment() = options.environment();
+    invocation.sharedEnvironment() = toolContext->environment(options.environment());
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.inputs() = toolEnvironment.inputs(toolContext->workingDirectory());
     invocation.outputs() = toolEnvironment.outputs(toolContext->workingDirectory());
@@ -29,7 +29,8 @@ void Tool::TouchResolver::
 resolve(
     Tool::Context *toolContext,
     std::string const &input,
-    std::vector<std::string> const &dependencies) const
+    std::vector<std::string> const &dependencies,
+    std::vector<std::string> const &refreshed) const
 {
     std::string logMessage = "Touch " + input;
 
@@ -42,8 +43,10 @@ resolve(
     }
 
     Tool::Invocation invocation;
-    invocation.executable() = Tool::Invocation::Executable::External("/usr/bin/touch");
-    invocation.arguments() = { "-c", input };
+    invocation.executable() = Tool::Invocation::Executable::Builtin("builtin-touch");
+    invocation.arguments() = { "-c" };
+    invocation.arguments().insert(invocation.arguments().end(), refreshed.begin(), refreshed.end());
+    invocation.arguments().push_back(input);
     invocation.workingDirectory() = toolContext->workingDirectory();
     invocation.outputs() = { output };
     invocation.inputDependencies() = inputDependencies;
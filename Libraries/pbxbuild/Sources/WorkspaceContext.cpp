@@ -11,103 +11,19 @@
 #include <pbxsetting/Environment.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
 
 using pbxbuild::WorkspaceContext;
 using pbxbuild::DerivedDataHash;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
-WorkspaceContext::
-WorkspaceContext(
-    std::string const &basePath,
-    DerivedDataHash const &derivedDataHash,
-    xcworkspace::XC::Workspace::shared_ptr const &workspace,
-    pbxproj::PBX::Project::shared_ptr const &project,
-    std::vector<xcscheme::SchemeGroup::shared_ptr> const &schemeGroups,
-    std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> const &projects,
-    std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> const &configs) :
-    _basePath       (basePath),
-    _derivedDataHash(derivedDataHash),
-    _workspace      (workspace),
-    _project        (project),
-    _schemeGroups   (schemeGroups),
-    _projects       (projects),
-    _configs        (configs)
-{
-}
-
-WorkspaceContext::
-~WorkspaceContext()
-{
-}
-
-pbxproj::PBX::Project::shared_ptr WorkspaceContext::
-project(std::string const &projectPath) const
-{
-    /* Normalize the path in case it has relative components. */
-    std::string resolvedProjectPath = FSUtil::NormalizePath(projectPath);
-
-    auto PI = _projects.find(resolvedProjectPath);
-    if (PI != _projects.end()) {
-        return PI->second;
-    } else {
-        return nullptr;
-    }
-}
-
-xcscheme::XC::Scheme::shared_ptr WorkspaceContext::
-scheme(std::string const &name) const
-{
-    for (xcscheme::SchemeGroup::shared_ptr const &schemeGroup : _schemeGroups) {
-        if (xcscheme::XC::Scheme::shared_ptr const &scheme = schemeGroup->scheme(name)) {
-            return scheme;
-        }
-    }
-
-    return nullptr;
-}
-
-std::vector<std::string> WorkspaceContext::
-loadedFilePaths() const
-{
-    std::vector<std::string> loadedFilePaths;
-
-    /* Estimate all files; assume two schemes per scheme group. */
-    loadedFilePaths.reserve(_projects.size() + _schemeGroups.size() * 2 + 1);
-
-    /*
-     * Add workspace data path.
-     */
-    if (_workspace != nullptr) {
-        loadedFilePaths.push_back(_workspace->dataFile());
-    }
-
-    /*
-     * Add all projects' data paths.
-     */
-    for (auto const &entry : _projects) {
-        loadedFilePaths.push_back(entry.second->dataFile());
-    }
-
-    /*
-     * Add all schemes' data paths.
-     */
-    for (xcscheme::SchemeGroup::shared_ptr const &schemeGroup : _schemeGroups) {
-        for (xcscheme::XC::Scheme::shared_ptr const &scheme : schemeGroup->schemes()) {
-            loadedFilePaths.push_back(scheme->path());
-        }
-    }
-
-    /*
-     * Add all config file paths.
-     */
-    for (auto const &entry : _configs) {
-        loadedFilePaths.push_back(entry.second.path());
-    }
-
-    return loadedFilePaths;
-}
-
 static void
 IterateWorkspaceItem(xcworkspace::XC::GroupItem::shared_ptr const &item, std::function<void(xcworkspace::XC::FileRef::shared_ptr const &)> const &cb)
 {
@@ -135,26 +51,11 @@ IterateWorkspaceFiles(xcworkspace::XC::Workspace::shared_ptr const &workspace, s
     }
 }
 
-static void
-LoadWorkspaceProjects(Filesystem const *filesystem, std::vector<pbxproj::PBX::Project::shared_ptr> *projects, xcworkspace::XC::Workspace::shared_ptr const &workspace)
-{
-    /*
-     * Load all the projects in the workspace.
-     */
-    IterateWorkspaceFiles(workspace, [&](xcworkspace::XC::FileRef::shared_ptr const &ref) {
-        std::string path = ref->resolve(workspace);
-
-        pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, path);
-        if (project != nullptr) {
-            projects->push_back(project);
-        }
-    });
-}
-
 static void
 LoadConfigurationFiles(
     Filesystem const *filesystem,
     std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> *configs,
+    pbxsetting::XC::Config::Cache *configCache,
     pbxsetting::Environment const &environment,
     pbxproj::XC::ConfigurationList::shared_ptr const &configurationList)
 {
@@ -170,27 +71,104 @@ LoadConfigurationFiles(
             std::string configurationPath = environment.expand(configurationReference->resolve());
 
             /* Load the configuration file. */
-            if (ext::optional<pbxsetting::XC::Config> configuration = pbxsetting::XC::Config::Load(filesystem, environment, configurationPath)) {
+            if (ext::optional<pbxsetting::XC::Config> configuration = pbxsetting::XC::Config::Load(filesystem, environment, configurationPath, configCache)) {
                 configs->insert({ buildConfiguration, *configuration });
             }
         }
     }
 }
 
-static void
-LoadNestedProjects(
-    Filesystem const *filesystem,
-    std::vector<pbxproj::PBX::Project::shared_ptr> *projects,
-    std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> *configs,
-    pbxsetting::Environment const &baseEnvironment,
-    std::vector<pbxproj::PBX::Project::shared_ptr> const &rootProjects)
-{
-    std::vector<pbxproj::PBX::Project::shared_ptr> nestedProjects;
+/*
+ * Loads projects, and their configuration files and schemes, as they are
+ * first needed. Shared between copies of a workspace context.
+ */
+struct WorkspaceContext::Loader {
+    Filesystem const                              *filesystem;
+    std::string                                    userName;
+    pbxsetting::Environment                        baseEnvironment;
+    pbxsetting::XC::Config::Cache                  configCache;
 
     /*
-     * Load all nested projects recursively.
+     * Projects found in the workspace or referenced from loaded projects,
+     * but not yet loaded. Keyed by normalized path.
      */
-    for (pbxproj::PBX::Project::shared_ptr const &project : rootProjects) {
+    std::deque<std::string>                        unloadedPaths;
+    std::unordered_set<std::string>                knownPaths;
+
+    std::vector<xcscheme::SchemeGroup::shared_ptr> schemeGroups;
+    std::unordered_set<std::string>                schemeGroupPaths;
+    std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> projects;
+    std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> configs;
+
+    std::mutex                                     mutex;
+
+    Loader(Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment) :
+        filesystem     (filesystem),
+        userName       (userName),
+        baseEnvironment(baseEnvironment)
+    {
+    }
+
+    void addProjectPath(std::string const &projectPath)
+    {
+        std::string normalizedPath = FSUtil::NormalizePath(projectPath);
+        if (knownPaths.insert(normalizedPath).second) {
+            unloadedPaths.push_back(normalizedPath);
+        }
+    }
+
+    bool hasSchemeGroup(std::string const &projectFile) const
+    {
+        return schemeGroupPaths.find(FSUtil::NormalizePath(projectFile)) != schemeGroupPaths.end();
+    }
+
+    void insertSchemeGroup(std::string const &projectFile, xcscheme::SchemeGroup::shared_ptr const &group)
+    {
+        if (schemeGroupPaths.insert(FSUtil::NormalizePath(projectFile)).second && group != nullptr) {
+            schemeGroups.push_back(group);
+        }
+    }
+
+    void openSchemeGroup(std::string const &basePath, std::string const &projectFile, std::string const &name)
+    {
+        if (!hasSchemeGroup(projectFile)) {
+            insertSchemeGroup(projectFile, xcscheme::SchemeGroup::Open(filesystem, userName, basePath, projectFile, name));
+        }
+    }
+
+    void openProjectSchemeGroups(std::vector<std::string> const &projectPaths)
+    {
+        /*
+         * Match the paths the projects themselves would have once loaded. Each
+         * scheme group is independent, so open them in parallel.
+         */
+        std::vector<std::string> projectFiles = std::vector<std::string>(projectPaths.size());
+        std::vector<xcscheme::SchemeGroup::shared_ptr> groups = std::vector<xcscheme::SchemeGroup::shared_ptr>(projectPaths.size());
+        libutil::Parallel::For(projectPaths.size(), [&](size_t index) {
+            projectFiles[index] = filesystem->resolvePath(projectPaths[index]);
+            if (!projectFiles[index].empty() && !hasSchemeGroup(projectFiles[index])) {
+                std::string const &projectFile = projectFiles[index];
+                groups[index] = xcscheme::SchemeGroup::Open(filesystem, userName, FSUtil::GetDirectoryName(projectFile), projectFile, FSUtil::GetBaseNameWithoutExtension(projectFile));
+            }
+        });
+
+        /* Insert in path order, so the result doesn't depend on timing. */
+        for (size_t index = 0; index < projectPaths.size(); ++index) {
+            if (!projectFiles[index].empty()) {
+                insertSchemeGroup(projectFiles[index], groups[index]);
+            }
+        }
+    }
+
+    void insertProject(pbxproj::PBX::Project::shared_ptr const &project)
+    {
+        /* Normalize path so it can be found on lookup. */
+        std::string normalizedPath = FSUtil::NormalizePath(project->projectFile());
+        knownPaths.insert(normalizedPath);
+        if (!projects.insert({ normalizedPath, project }).second) {
+            return;
+        }
+
         /*
          * Determine the settings environment to find the project paths. This may not be complete,
          * but it's unclear exactly what settings are available here. Notably, we don't yet know what
@@ -200,135 +178,254 @@ LoadNestedProjects(
         environment.insertFront(project->settings(), false);
 
         /*
-         * Load project and target configurations.
+         * Load project and target configurations. Configuration files
+         * shared between projects are only parsed once.
          */
-        LoadConfigurationFiles(filesystem, configs, environment, project->buildConfigurationList());
+        LoadConfigurationFiles(filesystem, &configs, &configCache, environment, project->buildConfigurationList());
         for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
-            LoadConfigurationFiles(filesystem, configs, environment, target->buildConfigurationList());
+            LoadConfigurationFiles(filesystem, &configs, &configCache, environment, target->buildConfigurationList());
         }
 
         /*
-         * Find the nested projects.
+         * Note the nested projects, to load when they are needed.
          */
         for (pbxproj::PBX::Project::ProjectReference const &projectReference : project->projectReferences()) {
             pbxproj::PBX::FileReference::shared_ptr const &projectFileReference = projectReference.projectReference();
-            std::string projectPath = environment.expand(projectFileReference->resolve());
+            addProjectPath(environment.expand(projectFileReference->resolve()));
+        }
+
+        openSchemeGroup(project->basePath(), project->projectFile(), project->name());
+    }
+
+    pbxproj::PBX::Project::shared_ptr loadProject(std::string const &normalizedPath)
+    {
+        auto PI = projects.find(normalizedPath);
+        if (PI != projects.end()) {
+            return PI->second;
+        }
+
+        auto UI = std::find(unloadedPaths.begin(), unloadedPaths.end(), normalizedPath);
+        if (UI == unloadedPaths.end()) {
+            return nullptr;
+        }
+        unloadedPaths.erase(UI);
+
+        pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, normalizedPath);
+        if (project != nullptr) {
+            insertProject(project);
+        }
+
+        return project;
+    }
+
+    void loadAllProjects()
+    {
+        /* Loading a project can find more nested projects. */
+        while (!unloadedPaths.empty()) {
+            std::vector<std::string> paths = std::vector<std::string>(unloadedPaths.begin(), unloadedPaths.end());
+            unloadedPaths.clear();
 
             /*
-             * Load the project.
+             * Each project and its schemes are independent files, so open them in
+             * parallel. Configuration files share a cache, so those are loaded after.
              */
-            pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, projectPath);
-            if (project != nullptr) {
-                nestedProjects.push_back(project);
+            std::vector<pbxproj::PBX::Project::shared_ptr> loaded = std::vector<pbxproj::PBX::Project::shared_ptr>(paths.size());
+            std::vector<xcscheme::SchemeGroup::shared_ptr> groups = std::vector<xcscheme::SchemeGroup::shared_ptr>(paths.size());
+            libutil::Parallel::For(paths.size(), [&](size_t index) {
+                pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, paths[index]);
+                if (project != nullptr && !hasSchemeGroup(project->projectFile())) {
+                    groups[index] = xcscheme::SchemeGroup::Open(filesystem, userName, project->basePath(), project->projectFile(), project->name());
+                }
+                loaded[index] = project;
+            });
+
+            /* Insert in path order, so the result doesn't depend on timing. */
+            for (size_t index = 0; index < paths.size(); ++index) {
+                if (loaded[index] != nullptr) {
+                    insertSchemeGroup(loaded[index]->projectFile(), groups[index]);
+                    insertProject(loaded[index]);
+                }
             }
         }
     }
+};
 
-    /*
-     * Append the nested projects. This has to be after the loop as `rootProjects` might alias `projects`.
-     */
-    projects->insert(projects->end(), nestedProjects.begin(), nestedProjects.end());
+WorkspaceContext::
+WorkspaceContext(
+    std::string const &basePath,
+    DerivedDataHash const &derivedDataHash,
+    xcworkspace::XC::Workspace::shared_ptr const &workspace,
+    pbxproj::PBX::Project::shared_ptr const &project,
+    std::shared_ptr<Loader> const &loader) :
+    _basePath       (basePath),
+    _derivedDataHash(derivedDataHash),
+    _workspace      (workspace),
+    _project        (project),
+    _loader         (loader)
+{
+}
 
-    if (!nestedProjects.empty()) {
-        /*
-         * Load nested projects of the nested projects.
-         */
-        LoadNestedProjects(filesystem, projects, configs, baseEnvironment, nestedProjects);
-    }
+WorkspaceContext::
+~WorkspaceContext()
+{
 }
 
-static void
-LoadProjectSchemes(Filesystem const *filesystem, std::string const &userName, std::vector<xcscheme::SchemeGroup::shared_ptr> *schemeGroups, std::vector<pbxproj::PBX::Project::shared_ptr> const &projects)
+std::vector<xcscheme::SchemeGroup::shared_ptr> const &WorkspaceContext::
+schemeGroups() const
 {
-    /*
-     * Load the schemes inside the projects.
-     */
-    for (pbxproj::PBX::Project::shared_ptr const &project : projects) {
-        xcscheme::SchemeGroup::shared_ptr projectGroup = xcscheme::SchemeGroup::Open(filesystem, userName, project->basePath(), project->projectFile(), project->name());
-        if (projectGroup != nullptr) {
-            schemeGroups->push_back(projectGroup);
-        }
-    }
+    std::lock_guard<std::mutex> lock(_loader->mutex);
+    _loader->loadAllProjects();
+    return _loader->schemeGroups;
 }
 
-static std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr>
-CreateProjectMap(std::vector<pbxproj::PBX::Project::shared_ptr> const &projects)
+std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> const &WorkspaceContext::
+projects() const
 {
-    std::unordered_map<std::string, pbxproj::PBX::Project::shared_ptr> projectsMap;
+    std::lock_guard<std::mutex> lock(_loader->mutex);
+    _loader->loadAllProjects();
+    return _loader->projects;
+}
 
-    for (pbxproj::PBX::Project::shared_ptr const &project : projects) {
-        /* Normalize path so it can be found on lookup. */
-        std::string normalizedPath = FSUtil::NormalizePath(project->projectFile());
-        projectsMap.insert({ normalizedPath, project });
+ext::optional<pbxsetting::XC::Config> WorkspaceContext::
+config(pbxproj::XC::BuildConfiguration::shared_ptr const &buildConfiguration) const
+{
+    std::lock_guard<std::mutex> lock(_loader->mutex);
+
+    auto it = _loader->configs.find(buildConfiguration);
+    if (it != _loader->configs.end()) {
+        return it->second;
     }
 
-    return projectsMap;
+    return ext::nullopt;
 }
 
-WorkspaceContext WorkspaceContext::
-Workspace(Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, xcworkspace::XC::Workspace::shared_ptr const &workspace)
+pbxproj::PBX::Project::shared_ptr WorkspaceContext::
+project(std::string const &projectPath) const
 {
-    std::vector<pbxproj::PBX::Project::shared_ptr> projects;
-    std::vector<xcscheme::SchemeGroup::shared_ptr> schemeGroups;
-    std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> configs;
+    std::lock_guard<std::mutex> lock(_loader->mutex);
+
+    /* Normalize the path in case it has relative components. */
+    std::string resolvedProjectPath = FSUtil::NormalizePath(projectPath);
+
+    return _loader->loadProject(resolvedProjectPath);
+}
+
+xcscheme::XC::Scheme::shared_ptr WorkspaceContext::
+scheme(std::string const &name, xcscheme::SchemeGroup::shared_ptr *schemeGroup) const
+{
+    std::lock_guard<std::mutex> lock(_loader->mutex);
 
     /*
-     * Add the schemes from the workspace itself.
+     * Search the schemes already available first; only load the remaining
+     * projects for their schemes if that fails.
      */
-    xcscheme::SchemeGroup::shared_ptr workspaceGroup = xcscheme::SchemeGroup::Open(filesystem, userName, workspace->basePath(), workspace->projectFile(), workspace->name());
-    if (workspaceGroup != nullptr) {
-        schemeGroups.push_back(workspaceGroup);
+    for (bool loaded : { false, true }) {
+        if (loaded) {
+            _loader->loadAllProjects();
+        }
+
+        for (xcscheme::SchemeGroup::shared_ptr const &group : _loader->schemeGroups) {
+            if (xcscheme::XC::Scheme::shared_ptr const &scheme = group->scheme(name)) {
+                if (schemeGroup != nullptr) {
+                    *schemeGroup = group;
+                }
+                return scheme;
+            }
+        }
     }
 
+    return nullptr;
+}
+
+std::vector<std::string> WorkspaceContext::
+loadedFilePaths() const
+{
+    std::lock_guard<std::mutex> lock(_loader->mutex);
+
+    std::vector<std::string> loadedFilePaths;
+
+    /* Estimate all files; assume two schemes per scheme group. */
+    loadedFilePaths.reserve(_loader->projects.size() + _loader->schemeGroups.size() * 2 + 1);
+
     /*
-     * Load projects within the workspace.
+     * Add workspace data path.
      */
-    LoadWorkspaceProjects(filesystem, &projects, workspace);
+    if (_workspace != nullptr) {
+        loadedFilePaths.push_back(_workspace->dataFile());
+    }
 
     /*
-     * Recursively load nested projects within those projects.
+     * Add all loaded projects' data paths.
      */
-    LoadNestedProjects(filesystem, &projects, &configs, baseEnvironment, projects);
+    for (auto const &entry : _loader->projects) {
+        loadedFilePaths.push_back(entry.second->dataFile());
+    }
 
     /*
-     * Load schemes for all projects, including nested projects.
+     * Add all schemes' data paths.
      */
-    LoadProjectSchemes(filesystem, userName, &schemeGroups, projects);
+    for (xcscheme::SchemeGroup::shared_ptr const &schemeGroup : _loader->schemeGroups) {
+        for (std::string const &path : schemeGroup->schemePaths()) {
+            loadedFilePaths.push_back(path);
+        }
+    }
 
     /*
-     * Determine the DerivedData path for the workspace.
+     * Add all config file paths.
      */
-    DerivedDataHash derivedDataHash = DerivedDataHash::Create(workspace->projectFile());
+    for (auto const &entry : _loader->configs) {
+        loadedFilePaths.push_back(entry.second.path());
+    }
 
-    return WorkspaceContext(workspace->basePath(), derivedDataHash, workspace, nullptr, schemeGroups, CreateProjectMap(projects), configs);
+    return loadedFilePaths;
 }
 
 WorkspaceContext WorkspaceContext::
-Project(Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, pbxproj::PBX::Project::shared_ptr const &project)
+Workspace(Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, xcworkspace::XC::Workspace::shared_ptr const &workspace)
 {
-    std::vector<pbxproj::PBX::Project::shared_ptr> projects;
-    std::vector<xcscheme::SchemeGroup::shared_ptr> schemeGroups;
-    std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> configs;
+    auto loader = std::make_shared<Loader>(filesystem, userName, baseEnvironment);
+
+    /*
+     * Add the schemes from the workspace itself.
+     */
+    loader->openSchemeGroup(workspace->basePath(), workspace->projectFile(), workspace->name());
 
     /*
-     * The root is a project, so it should be in the projects list.
+     * Note the projects within the workspace, to load when they are needed. Their
+     * schemes only depend on their paths, so those can be found without loading them.
      */
-    projects.push_back(project);
+    std::vector<std::string> projectPaths;
+    IterateWorkspaceFiles(workspace, [&](xcworkspace::XC::FileRef::shared_ptr const &ref) {
+        std::string path = ref->resolve(workspace);
+
+        loader->addProjectPath(path);
+        projectPaths.push_back(path);
+    });
+    loader->openProjectSchemeGroups(projectPaths);
 
     /*
-     * Recursively load nested projects within the project.
+     * Determine the DerivedData path for the workspace.
      */
-    LoadNestedProjects(filesystem, &projects, &configs, baseEnvironment, projects);
+    DerivedDataHash derivedDataHash = DerivedDataHash::Create(workspace->projectFile());
+
+    return WorkspaceContext(workspace->basePath(), derivedDataHash, workspace, nullptr, loader);
+}
+
+WorkspaceContext WorkspaceContext::
+Project(Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, pbxproj::PBX::Project::shared_ptr const &project)
+{
+    auto loader = std::make_shared<Loader>(filesystem, userName, baseEnvironment);
 
     /*
-     * Load schemes for all projects, including the root and nested projects.
+     * The root is a project, so it is always loaded. Nested projects within it
+     * are loaded when they are needed.
      */
-    LoadProjectSchemes(filesystem, userName, &schemeGroups, projects);
+    loader->insertProject(project);
 
     /*
      * Determine the DerivedData path for the root project.
      */
     DerivedDataHash derivedDataHash = DerivedDataHash::Create(project->projectFile());
 
-    return WorkspaceContext(project->basePath(), derivedDataHash, nullptr, project, schemeGroups, CreateProjectMap(projects), configs);
+    return WorkspaceContext(project->basePath(), derivedDataHash, nullptr, project, loader);
 }
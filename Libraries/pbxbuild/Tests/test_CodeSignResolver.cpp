@@ -0,0 +1,112 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/Tool/CodeSignResolver.h>
+#include <pbxbuild/Tool/Context.h>
+#include <pbxbuild/Tool/TouchResolver.h>
+#include <pbxsetting/Environment.h>
+#include <pbxsetting/Level.h>
+#include <pbxsetting/Setting.h>
+
+namespace Tool = pbxbuild::Tool;
+
+static pbxsetting::Environment
+Environment(std::vector<pbxsetting::Setting> const &settings)
+{
+    pbxsetting::Environment environment;
+    environment.insertBack(pbxsetting::Level(settings), false);
+    return environment;
+}
+
+static Tool::Context
+Context()
+{
+    return Tool::Context(nullptr, { }, "/build", Tool::SearchPaths({ }, { }, { }, { }));
+}
+
+TEST(CodeSignResolver, Product)
+{
+    Tool::Context context = Context();
+    pbxsetting::Environment environment = Environment({
+        pbxsetting::Setting::Create("CODE_SIGN_IDENTITY", "-"),
+        pbxsetting::Setting::Create("CODE_SIGN_ENTITLEMENTS", "App.entitlements"),
+        pbxsetting::Setting::Create("OTHER_CODE_SIGN_FLAGS", "--deep"),
+    });
+
+    Tool::CodeSignResolver resolver = Tool::CodeSignResolver("/usr/bin/codesign");
+    resolver.resolve(&context, environment, "/build/App.app", "/build/App.app/Contents", { "/build/App.app/Contents/MacOS/App", "Info.plist" }, false);
+    ASSERT_EQ(1, context.invocations().size());
+
+    Tool::Invocation const &invocation = context.invocations().front();
+    ASSERT_TRUE(invocation.executable());
+    EXPECT_EQ("/usr/bin/codesign", *invocation.executable()->external());
+
+    EXPECT_EQ(std::vector<std::string>({ "--force", "--sign", "-", "--entitlements", "App.entitlements", "--deep", "/build/App.app" }), invocation.arguments());
+    EXPECT_EQ(std::vector<std::string>({ "/build/App.entitlements" }), invocation.inputs());
+    EXPECT_EQ(std::vector<std::string>({ "/build/App.app/Contents/MacOS/App", "/build/Info.plist" }), invocation.inputDependencies());
+    EXPECT_EQ(std::vector<std::string>({ "/build/App.app/Contents/_CodeSignature/CodeResources" }), invocation.outputs());
+}
+
+TEST(CodeSignResolver, Nested)
+{
+    Tool::Context context = Context();
+    pbxsetting::Environment environment = Environment({
+        pbxsetting::Setting::Create("CODE_SIGN_IDENTITY", "-"),
+        pbxsetting::Setting::Create("CODE_SIGN_ENTITLEMENTS", "App.entitlements"),
+    });
+
+    Tool::CodeSignResolver resolver = Tool::CodeSignResolver("/usr/bin/codesign");
+    resolver.resolve(&context, environment, "/build/App.app/Frameworks/A.framework", "/build/App.app/Frameworks/A.framework", { }, true);
+    ASSERT_EQ(1, context.invocations().size());
+
+    /* Nested bundles keep their entitlements, and wait for their copy. */
+    Tool::Invocation const &invocation = context.invocations().front();
+    EXPECT_EQ(std::vector<std::string>({ "--force", "--sign", "-", "--preserve-metadata=identifier,entitlements", "/build/App.app/Frameworks/A.framework" }), invocation.arguments());
+    EXPECT_EQ(std::vector<std::string>({ "/build/App.app/Frameworks/A.framework" }), invocation.inputs());
+    EXPECT_TRUE(invocation.inputDependencies().empty());
+    EXPECT_EQ(std::vector<std::string>({ "/build/App.app/Frameworks/A.framework/_CodeSignature/CodeResources" }), invocation.outputs());
+}
+
+TEST(CodeSignResolver, NestedContentsPath)
+{
+    EXPECT_EQ("/App.app/Frameworks/A.framework", Tool::CodeSignResolver::NestedContentsPath("/App.app/Frameworks/A.framework", true));
+    EXPECT_EQ("/App.app/Contents/Frameworks/A.framework/Versions/Current", Tool::CodeSignResolver::NestedContentsPath("/App.app/Contents/Frameworks/A.framework", false));
+    EXPECT_EQ("/App.app/Contents/PlugIns/B.bundle/Contents", Tool::CodeSignResolver::NestedContentsPath("/App.app/Contents/PlugIns/B.bundle", false));
+}
+
+TEST(CodeSignResolver, ShouldSign)
+{
+    EXPECT_TRUE(Tool::CodeSignResolver::ShouldSign(Environment({
+        pbxsetting::Setting::Create("CODE_SIGNING_ALLOWED", "YES"),
+        pbxsetting::Setting::Create("CODE_SIGN_IDENTITY", "-"),
+    })));
+    EXPECT_FALSE(Tool::CodeSignResolver::ShouldSign(Environment({
+        pbxsetting::Setting::Create("CODE_SIGNING_ALLOWED", "NO"),
+        pbxsetting::Setting::Create("CODE_SIGN_IDENTITY", "-"),
+    })));
+    EXPECT_FALSE(Tool::CodeSignResolver::ShouldSign(Environment({
+        pbxsetting::Setting::Create("CODE_SIGNING_ALLOWED", "YES"),
+    })));
+}
+
+TEST(TouchResolver, Refreshed)
+{
+    Tool::Context context = Context();
+
+    /* The signature is touched before the wrapper, but isn't an output. */
+    Tool::TouchResolver resolver = Tool::TouchResolver(nullptr);
+    resolver.resolve(&context, "/build/App.app", { "/build/App.app/Contents/_CodeSignature/CodeResources" }, { "/build/App.app/Contents/_CodeSignature/CodeResources" });
+    ASSERT_EQ(1, context.invocations().size());
+
+    Tool::Invocation const &invocation = context.invocations().front();
+    EXPECT_EQ(std::vector<std::string>({ "-c", "/build/App.app/Contents/_CodeSignature/CodeResources", "/build/App.app" }), invocation.arguments());
+    EXPECT_EQ(std::vector<std::string>({ "/build/App.app" }), invocation.outputs());
+    EXPECT_EQ(std::vector<std::string>({ "/build/App.app/Contents/_CodeSignature/CodeResources" }), invocation.inputDependencies());
+}
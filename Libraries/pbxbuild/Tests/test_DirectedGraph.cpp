@@ -10,6 +10,8 @@
 #include <gtest/gtest.h>
 #include <pbxbuild/DirectedGraph.h>
 
+#include <algorithm>
+
 using pbxbuild::DirectedGraph;
 
 TEST(DirectedGraph, Nodes)
@@ -19,7 +21,11 @@ TEST(DirectedGraph, Nodes)
     graph.insert(2, std::unordered_set<int>({ 5, 6, 1 }));
     graph.insert(7, std::unordered_set<int>({ }));
 
-    EXPECT_EQ(graph.nodes(), std::unordered_set<int>({ 1, 2, 3, 4, 5, 6, 7 }));
+    std::unordered_set<int> nodes = std::unordered_set<int>(graph.nodes().begin(), graph.nodes().end());
+    EXPECT_EQ(nodes, std::unordered_set<int>({ 1, 2, 3, 4, 5, 6, 7 }));
+    EXPECT_EQ(7, graph.nodes().size());
+    EXPECT_EQ(4, graph.nodes()[*graph.index(4)]);
+    EXPECT_FALSE(graph.index(8));
 }
 
 TEST(DirectedGraph, Adjacent)
@@ -29,10 +35,15 @@ TEST(DirectedGraph, Adjacent)
     graph.insert(2, std::unordered_set<int>({ 5, 6, 1 }));
     graph.insert(7, std::unordered_set<int>({ }));
 
-    EXPECT_EQ(graph.adjacent(1), std::unordered_set<int>({ }));
-    EXPECT_EQ(graph.adjacent(4), std::unordered_set<int>({ 2, 3, 5 }));
-    EXPECT_EQ(graph.adjacent(7), std::unordered_set<int>({ }));
-    EXPECT_EQ(graph.adjacent(8), std::unordered_set<int>({ }));
+    graph.insert(4, std::unordered_set<int>({ 2 }));
+
+    std::vector<int> adjacent = graph.adjacent(4);
+    EXPECT_EQ(std::unordered_set<int>(adjacent.begin(), adjacent.end()), std::unordered_set<int>({ 2, 3, 5 }));
+    EXPECT_EQ(3, adjacent.size());
+    EXPECT_EQ(3, graph.adjacentIndexes(*graph.index(4)).size());
+    EXPECT_TRUE(graph.adjacent(1).empty());
+    EXPECT_TRUE(graph.adjacent(7).empty());
+    EXPECT_TRUE(graph.adjacent(8).empty());
 }
 
 TEST(DirectedGraph, Ordered)
@@ -44,7 +55,15 @@ TEST(DirectedGraph, Ordered)
 
     ext::optional<std::vector<int>> acyclicResult = acyclic.ordered();
     ASSERT_TRUE(acyclicResult);
-    EXPECT_EQ(*acyclicResult, std::vector<int>({ 1, 5, 2, 3, 4 }));
+    ASSERT_EQ(5, acyclicResult->size());
+
+    /* Each node comes after the nodes it's adjacent to. */
+    for (size_t i = 0; i < acyclicResult->size(); ++i) {
+        for (int adjacent : acyclic.adjacent((*acyclicResult)[i])) {
+            auto it = std::find(acyclicResult->begin(), acyclicResult->end(), adjacent);
+            EXPECT_LT(it - acyclicResult->begin(), i);
+        }
+    }
 
     DirectedGraph<int> cyclic;
     cyclic.insert(4, std::unordered_set<int>({ 2, 3, 5 }));
@@ -56,3 +75,49 @@ TEST(DirectedGraph, Ordered)
     EXPECT_FALSE(cyclicResult);
 }
 
+
+TEST(DirectedGraph, Levels)
+{
+    DirectedGraph<int> acyclic;
+    acyclic.insert(4, std::unordered_set<int>({ 2, 3, 5 }));
+    acyclic.insert(2, std::unordered_set<int>({ 5, 1 }));
+    acyclic.insert(5, std::unordered_set<int>({ 1 }));
+
+    ext::optional<std::vector<std::vector<size_t>>> acyclicLevels = acyclic.levels();
+    ASSERT_TRUE(acyclicLevels);
+
+    std::vector<std::unordered_set<int>> levels;
+    for (std::vector<size_t> const &level : *acyclicLevels) {
+        levels.emplace_back();
+        for (size_t index : level) {
+            levels.back().insert(acyclic.nodes()[index]);
+        }
+    }
+    EXPECT_EQ(levels, std::vector<std::unordered_set<int>>({ { 1, 3 }, { 5 }, { 2 }, { 4 } }));
+
+    DirectedGraph<int> cyclic;
+    cyclic.insert(1, std::unordered_set<int>({ 1 }));
+    EXPECT_FALSE(cyclic.levels());
+}
+
+TEST(DirectedGraph, Dependents)
+{
+    /* 4 depends on 2 and 3; 2 and 3 depend on 1; 6 depends on 5. */
+    DirectedGraph<int> graph;
+    graph.insert(4, std::unordered_set<int>({ 2, 3 }));
+    graph.insert(2, std::unordered_set<int>({ 1 }));
+    graph.insert(3, std::unordered_set<int>({ 1 }));
+    graph.insert(6, std::unordered_set<int>({ 5 }));
+
+    DirectedGraph<int> dependents = graph.dependents({ *graph.index(2) });
+    EXPECT_EQ(std::vector<int>({ 4, 2 }), dependents.nodes());
+    EXPECT_EQ(std::vector<int>({ 2 }), dependents.adjacent(4));
+    EXPECT_TRUE(dependents.adjacent(2).empty());
+
+    dependents = graph.dependents({ *graph.index(1), *graph.index(5) });
+    std::unordered_set<int> nodes = std::unordered_set<int>(dependents.nodes().begin(), dependents.nodes().end());
+    EXPECT_EQ(std::unordered_set<int>({ 1, 2, 3, 4, 5, 6 }), nodes);
+    EXPECT_EQ(2, dependents.adjacent(4).size());
+
+    EXPECT_TRUE(graph.dependents({ }).nodes().empty());
+}
@@ -0,0 +1,74 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/HeaderMap.h>
+
+#include <cstring>
+
+using pbxbuild::HeaderMap;
+
+static HMapHeader
+ReadHeader(std::vector<uint8_t> const &contents)
+{
+    HMapHeader header;
+    memcpy(&header, contents.data(), sizeof(header));
+    return header;
+}
+
+TEST(HeaderMap, Empty)
+{
+    HeaderMap hmap;
+    std::vector<uint8_t> contents = hmap.write();
+
+    HMapHeader header = ReadHeader(contents);
+    EXPECT_EQ(HMAP_HeaderMagicNumber, header.Magic);
+    EXPECT_EQ(0u, header.NumEntries);
+    EXPECT_EQ(8u, header.NumBuckets);
+    EXPECT_EQ(contents.size(), header.StringsOffset);
+}
+
+TEST(HeaderMap, DuplicateKeys)
+{
+    HeaderMap hmap;
+    EXPECT_TRUE(hmap.add("Header.h", "/path/", "Header.h"));
+    EXPECT_FALSE(hmap.add("Header.h", "/other/", "Header.h"));
+    EXPECT_FALSE(hmap.add("header.H", "/other/", "header.H"));
+    EXPECT_FALSE(hmap.add("", "/path/", "Header.h"));
+
+    EXPECT_EQ(1u, ReadHeader(hmap.write()).NumEntries);
+}
+
+TEST(HeaderMap, RoundTrip)
+{
+    HeaderMap hmap;
+    for (int n = 0; n < 100; n++) {
+        std::string name = "Header" + std::to_string(n) + ".h";
+        EXPECT_TRUE(hmap.add(name, "/path/", name));
+        EXPECT_TRUE(hmap.add("Framework/" + name, "/path/", name));
+    }
+
+    std::vector<uint8_t> contents = hmap.write();
+    HMapHeader header = ReadHeader(contents);
+    EXPECT_EQ(200u, header.NumEntries);
+    EXPECT_EQ(512u, header.NumBuckets);
+
+    /* Shared prefixes and suffixes are only stored once. */
+    size_t strings = contents.size() - header.StringsOffset;
+    EXPECT_LT(strings, 200u * (sizeof("Framework/Header00.h") + sizeof("/path/")));
+
+    HeaderMap read;
+    ASSERT_TRUE(read.read(contents.data(), contents.size()));
+    std::vector<uint8_t> rewritten = read.write();
+    EXPECT_EQ(contents.size(), rewritten.size());
+    EXPECT_EQ(200u, ReadHeader(rewritten).NumEntries);
+    EXPECT_EQ(512u, ReadHeader(rewritten).NumBuckets);
+
+    EXPECT_FALSE(read.read(contents.data(), sizeof(HMapHeader) - 1));
+}
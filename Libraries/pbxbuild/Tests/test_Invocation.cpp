@@ -0,0 +1,85 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/Tool/Invocation.h>
+
+namespace Tool = pbxbuild::Tool;
+
+static Tool::Invocation
+CreateInvocation(std::string const &root)
+{
+    Tool::Invocation invocation;
+    invocation.executable() = Tool::Invocation::Executable::External("/usr/bin/cc");
+    invocation.arguments() = { "-c", root + "/a.c", "-I" + root + "/include", "-o", root + "/build/a.o" };
+    invocation.sharedEnvironment() = std::make_shared<std::unordered_map<std::string, std::string> const>(std::unordered_map<std::string, std::string>({
+        { "A", "1" },
+        { "B", "2" },
+    }));
+    invocation.workingDirectory() = root;
+    invocation.inputs() = { root + "/a.c", root + "/b.h" };
+    invocation.outputs() = { root + "/build/a.o" };
+    return invocation;
+}
+
+TEST(Invocation, CommandFingerprint)
+{
+    Tool::Invocation invocation = CreateInvocation("/src");
+    std::string fingerprint = invocation.commandFingerprint();
+    EXPECT_EQ(fingerprint, invocation.commandFingerprint());
+
+    /* Arguments can't run together. */
+    Tool::Invocation joined = invocation;
+    joined.arguments() = { "-c/src/a.c", "-I/src/include", "-o", "/src/build/a.o" };
+    EXPECT_NE(fingerprint, joined.commandFingerprint());
+
+    /* Argument order matters. */
+    Tool::Invocation reordered = invocation;
+    std::swap(reordered.arguments()[0], reordered.arguments()[1]);
+    EXPECT_NE(fingerprint, reordered.commandFingerprint());
+
+    Tool::Invocation environment = invocation;
+    environment.sharedEnvironment() = std::make_shared<std::unordered_map<std::string, std::string> const>(std::unordered_map<std::string, std::string>({ { "A", "1" }, { "B", "3" } }));
+    EXPECT_NE(fingerprint, environment.commandFingerprint());
+
+    Tool::Invocation directory = invocation;
+    directory.workingDirectory() = "/other";
+    EXPECT_NE(fingerprint, directory.commandFingerprint());
+
+    Tool::Invocation builtin = invocation;
+    builtin.executable() = Tool::Invocation::Executable::Builtin("/usr/bin/cc");
+    EXPECT_NE(fingerprint, builtin.commandFingerprint());
+
+    /* Inputs and outputs aren't part of the command. */
+    Tool::Invocation outputs = invocation;
+    outputs.outputs() = { "/src/build/b.o" };
+    EXPECT_EQ(fingerprint, outputs.commandFingerprint());
+}
+
+TEST(Invocation, Fingerprint)
+{
+    Tool::Invocation invocation = CreateInvocation("/src");
+    std::string fingerprint = invocation.fingerprint();
+    EXPECT_NE(invocation.commandFingerprint(), fingerprint);
+
+    /* Input order doesn't matter. */
+    Tool::Invocation reordered = invocation;
+    reordered.inputs() = { "/src/b.h", "/src/a.c" };
+    EXPECT_EQ(fingerprint, reordered.fingerprint());
+
+    /* Paths can't move between inputs and outputs. */
+    Tool::Invocation moved = invocation;
+    moved.inputs() = { "/src/a.c" };
+    moved.outputs() = { "/src/b.h", "/src/build/a.o" };
+    EXPECT_NE(fingerprint, moved.fingerprint());
+
+    Tool::Invocation dependencies = invocation;
+    dependencies.inputDependencies() = { "/src/c.h" };
+    EXPECT_NE(fingerprint, dependencies.fingerprint());
+}
@@ -0,0 +1,147 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/Tool/InvocationPlan.h>
+#include <libutil/MemoryFilesystem.h>
+
+namespace Tool = pbxbuild::Tool;
+using libutil::MemoryFilesystem;
+
+static std::vector<Tool::Invocation>
+CreateInvocations()
+{
+    auto environment = std::make_shared<std::unordered_map<std::string, std::string> const>(std::unordered_map<std::string, std::string>({
+        { "PATH", "/usr/bin" },
+        { "LANG", "C" },
+    }));
+
+    Tool::Invocation compile;
+    compile.toolIdentifier() = "com.apple.compilers.llvm.clang.1_0";
+    compile.executable() = Tool::Invocation::Executable::External("/usr/bin/clang");
+    compile.arguments() = { "-c", "main.c", "-o", "main.o" };
+    compile.sharedEnvironment() = environment;
+    compile.workingDirectory() = "/project";
+    compile.inputs() = { "/project/main.c" };
+    compile.outputs() = { "/project/main.o" };
+    compile.inputDependencies() = { "/project/header.h" };
+    compile.dependencyInfo() = { Tool::Invocation::DependencyInfo(dependency::DependencyInfoFormat::Makefile, "/project/main.d") };
+    compile.auxiliaryFiles() = {
+        Tool::Invocation::AuxiliaryFile("/project/main.resp", {
+            Tool::Invocation::AuxiliaryFile::Chunk::Data({ 'a', '\0', 'b' }),
+            Tool::Invocation::AuxiliaryFile::Chunk::File("/project/more.resp"),
+        }, true),
+    };
+    compile.logMessage() = "CompileC main.o main.c";
+    compile.stage() = Tool::Invocation::Stage::Compile;
+    compile.keepsUnchangedOutputs() = true;
+    compile.actionCacheCommand() = std::string("clang main.c");
+
+    Tool::Invocation copy;
+    copy.executable() = Tool::Invocation::Executable::Builtin("copy");
+    copy.sharedEnvironment() = environment;
+    copy.orderDependencies() = { "/project/build" };
+    copy.showEnvironmentInLog() = false;
+    copy.createsProductStructure() = true;
+    copy.alwaysOutOfDate() = true;
+
+    return { compile, copy, Tool::Invocation() };
+}
+
+TEST(InvocationPlan, RoundTrip)
+{
+    std::vector<Tool::Invocation> invocations = CreateInvocations();
+    std::vector<uint8_t> contents = Tool::InvocationPlan::Serialize("fingerprint", invocations);
+
+    ext::optional<std::vector<Tool::Invocation>> loaded = Tool::InvocationPlan::Deserialize("fingerprint", contents.data(), contents.size());
+    ASSERT_TRUE(loaded);
+    ASSERT_EQ(3u, loaded->size());
+
+    Tool::Invocation const &compile = (*loaded)[0];
+    EXPECT_EQ("com.apple.compilers.llvm.clang.1_0", compile.toolIdentifier());
+    ASSERT_TRUE(compile.executable());
+    EXPECT_EQ("/usr/bin/clang", *compile.executable()->external());
+    EXPECT_EQ(invocations[0].arguments(), compile.arguments());
+    EXPECT_EQ(invocations[0].environment(), compile.environment());
+    EXPECT_EQ("/project", compile.workingDirectory());
+    EXPECT_EQ(invocations[0].inputs(), compile.inputs());
+    EXPECT_EQ(invocations[0].outputs(), compile.outputs());
+    EXPECT_EQ(invocations[0].inputDependencies(), compile.inputDependencies());
+    ASSERT_EQ(1u, compile.dependencyInfo().size());
+    EXPECT_EQ(dependency::DependencyInfoFormat::Makefile, compile.dependencyInfo()[0].format());
+    EXPECT_EQ("/project/main.d", compile.dependencyInfo()[0].path());
+    ASSERT_EQ(1u, compile.auxiliaryFiles().size());
+    EXPECT_EQ("/project/main.resp", compile.auxiliaryFiles()[0].path());
+    EXPECT_TRUE(compile.auxiliaryFiles()[0].executable());
+    ASSERT_EQ(2u, compile.auxiliaryFiles()[0].chunks().size());
+    EXPECT_EQ(std::vector<uint8_t>({ 'a', '\0', 'b' }), *compile.auxiliaryFiles()[0].chunks()[0].data());
+    EXPECT_EQ("/project/more.resp", *compile.auxiliaryFiles()[0].chunks()[1].file());
+    EXPECT_EQ("CompileC main.o main.c", compile.logMessage());
+    EXPECT_EQ(Tool::Invocation::Stage::Compile, compile.stage());
+    EXPECT_TRUE(compile.keepsUnchangedOutputs());
+    EXPECT_EQ(ext::optional<std::string>("clang main.c"), compile.actionCacheCommand());
+
+    Tool::Invocation const &copy = (*loaded)[1];
+    ASSERT_TRUE(copy.executable());
+    EXPECT_EQ("copy", *copy.executable()->builtin());
+    EXPECT_EQ(invocations[1].orderDependencies(), copy.orderDependencies());
+    EXPECT_FALSE(copy.showEnvironmentInLog());
+    EXPECT_TRUE(copy.createsProductStructure());
+    EXPECT_TRUE(copy.alwaysOutOfDate());
+    EXPECT_FALSE(copy.keepsUnchangedOutputs());
+    EXPECT_FALSE(copy.actionCacheCommand());
+
+    /* Invocations sharing an environment still share it. */
+    EXPECT_EQ(compile.sharedEnvironment(), copy.sharedEnvironment());
+    EXPECT_FALSE((*loaded)[2].executable());
+    EXPECT_TRUE((*loaded)[2].environment().empty());
+}
+
+TEST(InvocationPlan, Stable)
+{
+    std::vector<Tool::Invocation> invocations = CreateInvocations();
+    std::vector<uint8_t> contents = Tool::InvocationPlan::Serialize("fingerprint", invocations);
+
+    ext::optional<std::vector<Tool::Invocation>> loaded = Tool::InvocationPlan::Deserialize("fingerprint", contents.data(), contents.size());
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(contents, Tool::InvocationPlan::Serialize("fingerprint", *loaded));
+}
+
+TEST(InvocationPlan, Invalid)
+{
+    std::vector<uint8_t> contents = Tool::InvocationPlan::Serialize("fingerprint", CreateInvocations());
+
+    /* Planned for something else. */
+    EXPECT_FALSE(Tool::InvocationPlan::Deserialize("other", contents.data(), contents.size()));
+
+    /* Truncated anywhere. */
+    for (size_t size = 0; size < contents.size(); ++size) {
+        EXPECT_FALSE(Tool::InvocationPlan::Deserialize("fingerprint", contents.data(), size));
+    }
+
+    /* Trailing data. */
+    contents.push_back(0);
+    EXPECT_FALSE(Tool::InvocationPlan::Deserialize("fingerprint", contents.data(), contents.size()));
+}
+
+TEST(InvocationPlan, SaveLoad)
+{
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("build", { }),
+    });
+
+    EXPECT_FALSE(Tool::InvocationPlan::Load(&filesystem, "/build/plan", "fingerprint"));
+
+    EXPECT_TRUE(Tool::InvocationPlan::Save(&filesystem, "/build/plan", "fingerprint", CreateInvocations()));
+    ext::optional<std::vector<Tool::Invocation>> loaded = Tool::InvocationPlan::Load(&filesystem, "/build/plan", "fingerprint");
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(3u, loaded->size());
+
+    EXPECT_FALSE(Tool::InvocationPlan::Load(&filesystem, "/build/plan", "other"));
+}
@@ -632,6 +632,79 @@ TEST(OptionsResolver, Architectures)
     }));
 }
 
+/*
+ * Test options are kept between files, except those referring to the file.
+ */
+TEST(OptionsResolver, Cache)
+{
+    std::vector<pbxspec::PBX::PropertyOption::shared_ptr> options = {
+        OPTION({
+            Name = SHARED;
+            Type = Boolean;
+            CommandLineFlag = "shared";
+        }),
+        OPTION({
+            Name = DEPENDENCIES;
+            Type = Boolean;
+            CommandLineArgs = {
+                YES = ( "-MF", "$(OutputDir)/$(InputFileBase).d" );
+            };
+        }),
+        OPTION({
+            Name = PATH;
+            Type = String;
+            DefaultValue = "$(InputFile:file)";
+            CommandLinePrefixFlag = "-path=";
+        }),
+    };
+
+    Tool::OptionsResult::Cache cache;
+
+    auto first = Environment({
+        pbxsetting::Setting::Create("SHARED", "YES"),
+        pbxsetting::Setting::Create("DEPENDENCIES", "YES"),
+        pbxsetting::Setting::Parse("PATH", "$(InputFile:file)"),
+
+        pbxsetting::Setting::Create("InputFile", "/source/first.c"),
+        pbxsetting::Setting::Create("InputFileBase", "first"),
+        pbxsetting::Setting::Create("OutputDir", "/objects"),
+    });
+
+    auto firstResult = Tool::OptionsResult::Create(first, WorkingDirectory, options, FileType, { }, nullptr, &cache);
+    EXPECT_EQ(firstResult.arguments(), std::vector<std::string>({
+        "shared",
+        "-MF",
+        "/objects/first.d",
+        "-path=first.c",
+    }));
+
+    /* Settings that aren't for the file are assumed not to change. */
+    auto second = Environment({
+        pbxsetting::Setting::Create("SHARED", "NO"),
+        pbxsetting::Setting::Create("DEPENDENCIES", "YES"),
+        pbxsetting::Setting::Parse("PATH", "$(InputFile:file)"),
+
+        pbxsetting::Setting::Create("InputFile", "/source/second.c"),
+        pbxsetting::Setting::Create("InputFileBase", "second"),
+        pbxsetting::Setting::Create("OutputDir", "/objects"),
+    });
+
+    auto secondResult = Tool::OptionsResult::Create(second, WorkingDirectory, options, FileType, { }, nullptr, &cache);
+    EXPECT_EQ(secondResult.arguments(), std::vector<std::string>({
+        "shared",
+        "-MF",
+        "/objects/second.d",
+        "-path=second.c",
+    }));
+
+    auto uncachedResult = Tool::OptionsResult::Create(second, WorkingDirectory, options, FileType);
+    EXPECT_EQ(uncachedResult.arguments(), std::vector<std::string>({
+        "-MF",
+        "/objects/second.d",
+        "-path=second.c",
+    }));
+}
+
 /*
 
 To test:
@@ -0,0 +1,250 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxproj_ObjectTable_h
+#define __pbxproj_ObjectTable_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pbxproj {
+
+/*
+ * The 96 bits of an object identifier, as Xcode writes them: 24 uppercase
+ * hex digits. Identifiers written otherwise don't decode.
+ */
+class ObjectIdentifier {
+private:
+    uint64_t _high;
+    uint32_t _low;
+
+public:
+    ObjectIdentifier() :
+        _high(0),
+        _low (0)
+    {
+    }
+
+public:
+    inline bool operator==(ObjectIdentifier const &other) const
+    { return _high == other._high && _low == other._low; }
+
+    inline size_t hash() const
+    {
+        uint64_t hash = (_high ^ (static_cast<uint64_t>(_low) * 0x9E3779B97F4A7C15ULL)) * 0xBF58476D1CE4E5B9ULL;
+        return static_cast<size_t>(hash ^ (hash >> 31));
+    }
+
+public:
+    static bool
+    Decode(std::string const &string, ObjectIdentifier *identifier);
+};
+
+/*
+ * Values keyed by object identifier, in insertion order. Identifiers that
+ * decode are found by their bits in an open addressing index, so lookups
+ * don't hash or compare strings; any others are kept in a string map.
+ */
+template<typename T>
+class ObjectTable {
+private:
+    struct Entry {
+        ObjectIdentifier identifier;
+        bool             decoded;
+        bool             present;
+        T                value;
+    };
+
+private:
+    std::vector<Entry>                      _entries;
+    std::vector<uint32_t>                   _index;
+    std::unordered_map<std::string, size_t> _other;
+    size_t                                  _count;
+
+public:
+    class const_iterator {
+    private:
+        typename std::vector<Entry>::const_iterator _it;
+        typename std::vector<Entry>::const_iterator _end;
+
+    public:
+        const_iterator(typename std::vector<Entry>::const_iterator it, typename std::vector<Entry>::const_iterator end) :
+            _it (it),
+            _end(end)
+        {
+            skip();
+        }
+
+    private:
+        inline void skip()
+        {
+            while (_it != _end && !_it->present) {
+                ++_it;
+            }
+        }
+
+    public:
+        inline T const &operator*() const
+        { return _it->value; }
+        inline T const *operator->() const
+        { return &_it->value; }
+
+        inline const_iterator &operator++()
+        { ++_it; skip(); return *this; }
+
+        inline bool operator==(const_iterator const &other) const
+        { return _it == other._it; }
+        inline bool operator!=(const_iterator const &other) const
+        { return _it != other._it; }
+    };
+
+public:
+    ObjectTable() :
+        _count(0)
+    {
+    }
+
+public:
+    inline size_t size() const
+    { return _count; }
+    inline bool empty() const
+    { return _count == 0; }
+
+    inline const_iterator begin() const
+    { return const_iterator(_entries.begin(), _entries.end()); }
+    inline const_iterator end() const
+    { return const_iterator(_entries.end(), _entries.end()); }
+
+public:
+    /*
+     * The value for an identifier, or null if there is none.
+     */
+    inline T const *find(std::string const &identifier) const
+    {
+        size_t entry = lookup(identifier);
+        return (entry != npos && _entries[entry].present ? &_entries[entry].value : nullptr);
+    }
+
+    inline T *find(std::string const &identifier)
+    {
+        size_t entry = lookup(identifier);
+        return (entry != npos && _entries[entry].present ? &_entries[entry].value : nullptr);
+    }
+
+    /*
+     * The value for an identifier, added if there is none.
+     */
+    T &operator[](std::string const &identifier)
+    {
+        ObjectIdentifier decoded;
+        size_t entry;
+
+        if (ObjectIdentifier::Decode(identifier, &decoded)) {
+            if (_index.empty() || (_entries.size() + 1) * 4 > _index.size() * 3) {
+                rehash(_index.empty() ? 16 : _index.size() * 2);
+            }
+
+            size_t mask = _index.size() - 1;
+            size_t slot = decoded.hash() & mask;
+            while (_index[slot] != 0 && !(_entries[_index[slot] - 1].identifier == decoded)) {
+                slot = (slot + 1) & mask;
+            }
+
+            if (_index[slot] == 0) {
+                _entries.push_back({ decoded, true, false, T() });
+                _index[slot] = static_cast<uint32_t>(_entries.size());
+            }
+            entry = _index[slot] - 1;
+        } else {
+            auto it = _other.find(identifier);
+            if (it == _other.end()) {
+                _entries.push_back({ ObjectIdentifier(), false, false, T() });
+                it = _other.insert({ identifier, _entries.size() - 1 }).first;
+            }
+            entry = it->second;
+        }
+
+        if (!_entries[entry].present) {
+            _entries[entry].present = true;
+            _count++;
+        }
+
+        return _entries[entry].value;
+    }
+
+    /*
+     * Remove the value for an identifier. Its place in the order is kept
+     * in case it's added again.
+     */
+    void erase(std::string const &identifier)
+    {
+        size_t entry = lookup(identifier);
+        if (entry != npos && _entries[entry].present) {
+            _entries[entry].present = false;
+            _entries[entry].value = T();
+            _count--;
+        }
+    }
+
+    void clear()
+    {
+        _entries.clear();
+        _index.clear();
+        _other.clear();
+        _count = 0;
+    }
+
+private:
+    static size_t const npos = static_cast<size_t>(-1);
+
+    size_t lookup(std::string const &identifier) const
+    {
+        ObjectIdentifier decoded;
+        if (ObjectIdentifier::Decode(identifier, &decoded)) {
+            if (_index.empty()) {
+                return npos;
+            }
+
+            size_t mask = _index.size() - 1;
+            for (size_t slot = decoded.hash() & mask; _index[slot] != 0; slot = (slot + 1) & mask) {
+                if (_entries[_index[slot] - 1].identifier == decoded) {
+                    return _index[slot] - 1;
+                }
+            }
+
+            return npos;
+        } else {
+            auto it = _other.find(identifier);
+            return (it != _other.end() ? it->second : npos);
+        }
+    }
+
+    void rehash(size_t size)
+    {
+        _index.assign(size, 0);
+
+        size_t mask = size - 1;
+        for (size_t i = 0; i < _entries.size(); ++i) {
+            if (_entries[i].decoded) {
+                size_t slot = _entries[i].identifier.hash() & mask;
+                while (_index[slot] != 0) {
+                    slot = (slot + 1) & mask;
+                }
+                _index[slot] = static_cast<uint32_t>(i + 1);
+            }
+        }
+    }
+};
+
+}
+
+#endif  // !__pbxproj_ObjectTable_h
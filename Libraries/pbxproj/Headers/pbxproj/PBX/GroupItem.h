@@ -46,6 +46,10 @@ public:
     inline Type type() const
     { return _type; }
 
+public:
+    inline GroupItem const *parent() const
+    { return _parent; }
+
 public:
     inline std::string const &name() const
     { return _name.empty() ? _path : _name; }
@@ -61,6 +65,12 @@ public:
 public:
     pbxsetting::Value resolve(void) const;
 
+    /*
+     * The part of the resolved path this item adds to its source tree,
+     * with a leading slash, or empty if it adds nothing.
+     */
+    std::string resolvePathComponent(void) const;
+
 protected:
     bool parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::string> *seen, bool check) override;
 };
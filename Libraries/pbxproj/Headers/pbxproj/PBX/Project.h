@@ -1,6 +1,7 @@
 #ifndef __pbxproj_PBX_Project_h
 #define __pbxproj_PBX_Project_h
 
+#include <pbxproj/ObjectTable.h>
 #include <pbxproj/PBX/Object.h>
 #include <pbxproj/PBX/Group.h>
 #include <pbxproj/PBX/Target.h>
@@ -40,7 +41,7 @@ private:
     std::string                        _dataFile;
     std::string                        _basePath;
     std::string                        _name;
-    std::unordered_map<std::string, Object::shared_ptr> _blueprints;
+    ObjectTable<Object::shared_ptr>    _blueprints;
 
 private:
     XC::ConfigurationList::shared_ptr  _buildConfigurationList;
@@ -56,6 +57,10 @@ private:
     Target::vector                     _targets;
     FileReference::vector              _fileReferences;
 
+private:
+    ObjectTable<Target::shared_ptr>    _targetsByIdentifier;
+    ObjectTable<Target::shared_ptr>    _targetsByProductIdentifier;
+
 public:
     Project();
 
@@ -104,6 +109,13 @@ public:
     inline Target::vector const &targets() const
     { return _targets; }
 
+    /*
+     * The target with an identifier, or the native target whose product
+     * reference has that identifier. Null if there is none.
+     */
+    Target::shared_ptr target(std::string const &identifier) const;
+    Target::shared_ptr productTarget(std::string const &identifier) const;
+
 public:
     inline std::string const &name() const
     { return _name; }
@@ -132,11 +144,11 @@ public:
         if (blueprintIdentifier.empty())
             return Object::shared_ptr();
 
-        auto I = _blueprints.find(blueprintIdentifier);
-        if (I == _blueprints.end())
+        Object::shared_ptr const *object = _blueprints.find(blueprintIdentifier);
+        if (object == nullptr)
             return Object::shared_ptr();
         else
-            return I->second;
+            return *object;
     }
 
 public:
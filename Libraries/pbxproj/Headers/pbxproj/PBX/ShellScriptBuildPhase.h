@@ -25,6 +25,9 @@ private:
     std::string                    _shellScript;
     std::vector<pbxsetting::Value> _inputPaths;
     std::vector<pbxsetting::Value> _outputPaths;
+    std::vector<pbxsetting::Value> _inputFileListPaths;
+    std::vector<pbxsetting::Value> _outputFileListPaths;
+    bool                           _alwaysOutOfDate;
     bool                           _showEnvVarsInLog;
 
 public:
@@ -46,6 +49,23 @@ public:
     inline std::vector<pbxsetting::Value> const &outputPaths() const
     { return _outputPaths; }
 
+public:
+    /*
+     * Files listing more input and output paths, one per line.
+     */
+    inline std::vector<pbxsetting::Value> const &inputFileListPaths() const
+    { return _inputFileListPaths; }
+    inline std::vector<pbxsetting::Value> const &outputFileListPaths() const
+    { return _outputFileListPaths; }
+
+public:
+    /*
+     * If the script runs on every build, rather than only when its outputs
+     * are older than its inputs.
+     */
+    inline bool alwaysOutOfDate() const
+    { return _alwaysOutOfDate; }
+
 public:
     inline bool showEnvVarsInLog() const
     { return _showEnvVarsInLog; }
@@ -0,0 +1,92 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxproj_Summary_h
+#define __pbxproj_Summary_h
+
+#include <string>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+
+namespace pbxproj {
+
+/*
+ * The names in a project, read straight from the project file as it's
+ * parsed, without creating its objects. For listing what a project has,
+ * where opening the whole project is too slow.
+ */
+class Summary {
+private:
+    std::string              _projectFile;
+    std::string              _name;
+    std::vector<std::string> _targets;
+    std::vector<std::string> _buildConfigurations;
+    std::string              _defaultConfigurationName;
+    bool                     _hasBuildConfigurationList;
+
+private:
+    std::vector<std::string> _projectReferences;
+    bool                     _projectReferencesResolved;
+
+public:
+    Summary();
+
+public:
+    /*
+     * The path to the project, and its name.
+     */
+    inline std::string const &projectFile() const
+    { return _projectFile; }
+    inline std::string const &name() const
+    { return _name; }
+
+public:
+    /*
+     * The names of the targets, in order.
+     */
+    inline std::vector<std::string> const &targets() const
+    { return _targets; }
+
+    /*
+     * The project's build configuration names, and the default one. Both
+     * are empty without a configuration list.
+     */
+    inline bool hasBuildConfigurationList() const
+    { return _hasBuildConfigurationList; }
+    inline std::vector<std::string> const &buildConfigurations() const
+    { return _buildConfigurations; }
+    inline std::string const &defaultConfigurationName() const
+    { return _defaultConfigurationName; }
+
+public:
+    /*
+     * The paths of nested projects. Only references relative to the
+     * project or absolute can be found without build settings; if any
+     * other couldn't be found, the paths are incomplete.
+     */
+    inline std::vector<std::string> const &projectReferences() const
+    { return _projectReferences; }
+    inline bool projectReferencesResolved() const
+    { return _projectReferencesResolved; }
+
+public:
+    /*
+     * Read the summary of a project. Fails, without printing an error, if
+     * the project file isn't in the usual text format or isn't a project;
+     * open the project itself in that case.
+     */
+    static ext::optional<Summary>
+    Open(libutil::Filesystem const *filesystem, std::string const &path);
+};
+
+}
+
+#endif  // !__pbxproj_Summary_h
@@ -11,6 +11,7 @@
 #define __pbxproj_Context_h
 
 #include <pbxproj/PlistHelpers.h>
+#include <pbxproj/ObjectTable.h>
 #include <pbxproj/ISA.h>
 #include <plist/Dictionary.h>
 #include <plist/Object.h>
@@ -19,7 +20,6 @@
 
 #include <memory>
 #include <string>
-#include <unordered_map>
 
 namespace pbxproj {
 
@@ -66,6 +66,7 @@ public:
     // Parsing context
     //
     plist::Dictionary const *objects;
+    ObjectTable <plist::Dictionary const *> objectTable;
 
     //
     // The main project
@@ -75,37 +76,59 @@ public:
     //
     // Cached values
     //
-    std::unordered_map <std::string, std::shared_ptr <PBX::Project>>               projects;
-    std::unordered_map <std::string, std::shared_ptr <PBX::FileReference>>         fileReferences;
-    std::unordered_map <std::string, std::shared_ptr <PBX::ReferenceProxy>>        referenceProxies;
-    std::unordered_map <std::string, std::shared_ptr <PBX::Group>>                 groups;
-    std::unordered_map <std::string, std::shared_ptr <PBX::VariantGroup>>          variantGroups;
-    std::unordered_map <std::string, std::shared_ptr <PBX::NativeTarget>>          nativeTargets;
-    std::unordered_map <std::string, std::shared_ptr <PBX::AggregateTarget>>       aggregateTargets;
-    std::unordered_map <std::string, std::shared_ptr <PBX::LegacyTarget>>          legacyTargets;
-    std::unordered_map <std::string, std::shared_ptr <PBX::TargetDependency>>      targetDependencies;
-    std::unordered_map <std::string, std::shared_ptr <PBX::ContainerItemProxy>>    containerItemProxies;
-    std::unordered_map <std::string, std::shared_ptr <PBX::BuildFile>>             buildFiles;
-    std::unordered_map <std::string, std::shared_ptr <PBX::BuildRule>>             buildRules;
-    std::unordered_map <std::string, std::shared_ptr <PBX::HeadersBuildPhase>>     headersBuildPhases;
-    std::unordered_map <std::string, std::shared_ptr <PBX::SourcesBuildPhase>>     sourcesBuildPhases;
-    std::unordered_map <std::string, std::shared_ptr <PBX::ResourcesBuildPhase>>   resourcesBuildPhases;
-    std::unordered_map <std::string, std::shared_ptr <PBX::FrameworksBuildPhase>>  frameworksBuildPhases;
-    std::unordered_map <std::string, std::shared_ptr <PBX::CopyFilesBuildPhase>>   copyFilesBuildPhases;
-    std::unordered_map <std::string, std::shared_ptr <PBX::ShellScriptBuildPhase>> shellScriptBuildPhases;
-    std::unordered_map <std::string, std::shared_ptr <PBX::AppleScriptBuildPhase>> appleScriptBuildPhases;
-    std::unordered_map <std::string, std::shared_ptr <PBX::RezBuildPhase>>         rezBuildPhases;
-
-    std::unordered_map <std::string, std::shared_ptr <XC::BuildConfiguration>>     buildConfigurations;
-    std::unordered_map <std::string, std::shared_ptr <XC::ConfigurationList>>      configurationLists;
-    std::unordered_map <std::string, std::shared_ptr <XC::VersionGroup>>           versionGroups;
+    ObjectTable <std::shared_ptr <PBX::Project>>               projects;
+    ObjectTable <std::shared_ptr <PBX::FileReference>>         fileReferences;
+    ObjectTable <std::shared_ptr <PBX::ReferenceProxy>>        referenceProxies;
+    ObjectTable <std::shared_ptr <PBX::Group>>                 groups;
+    ObjectTable <std::shared_ptr <PBX::VariantGroup>>          variantGroups;
+    ObjectTable <std::shared_ptr <PBX::NativeTarget>>          nativeTargets;
+    ObjectTable <std::shared_ptr <PBX::AggregateTarget>>       aggregateTargets;
+    ObjectTable <std::shared_ptr <PBX::LegacyTarget>>          legacyTargets;
+    ObjectTable <std::shared_ptr <PBX::TargetDependency>>      targetDependencies;
+    ObjectTable <std::shared_ptr <PBX::ContainerItemProxy>>    containerItemProxies;
+    ObjectTable <std::shared_ptr <PBX::BuildFile>>             buildFiles;
+    ObjectTable <std::shared_ptr <PBX::BuildRule>>             buildRules;
+    ObjectTable <std::shared_ptr <PBX::HeadersBuildPhase>>     headersBuildPhases;
+    ObjectTable <std::shared_ptr <PBX::SourcesBuildPhase>>     sourcesBuildPhases;
+    ObjectTable <std::shared_ptr <PBX::ResourcesBuildPhase>>   resourcesBuildPhases;
+    ObjectTable <std::shared_ptr <PBX::FrameworksBuildPhase>>  frameworksBuildPhases;
+    ObjectTable <std::shared_ptr <PBX::CopyFilesBuildPhase>>   copyFilesBuildPhases;
+    ObjectTable <std::shared_ptr <PBX::ShellScriptBuildPhase>> shellScriptBuildPhases;
+    ObjectTable <std::shared_ptr <PBX::AppleScriptBuildPhase>> appleScriptBuildPhases;
+    ObjectTable <std::shared_ptr <PBX::RezBuildPhase>>         rezBuildPhases;
+
+    ObjectTable <std::shared_ptr <XC::BuildConfiguration>>     buildConfigurations;
+    ObjectTable <std::shared_ptr <XC::ConfigurationList>>      configurationLists;
+    ObjectTable <std::shared_ptr <XC::VersionGroup>>           versionGroups;
 
 public:
     Context()
     {
+        objects = nullptr;
         project = nullptr;
     }
 
+    inline void setObjects(plist::Dictionary const *objects)
+    {
+        this->objects = objects;
+
+        objectTable.clear();
+        for (size_t n = 0; n < objects->count(); n++) {
+            if (auto object = objects->value <plist::Dictionary> (n)) {
+                objectTable[objects->key(n)] = object;
+            }
+        }
+    }
+
+    //
+    // The object with an identifier, or null if there is none.
+    //
+    inline plist::Dictionary const *object(std::string const &id) const
+    {
+        plist::Dictionary const * const *object = objectTable.find(id);
+        return (object != nullptr ? *object : nullptr);
+    }
+
     inline void clear()
     {
         project = nullptr;
@@ -144,7 +167,7 @@ private:
         if (id != nullptr) {
             *id = key;
         }
-        return PlistDictionaryGetPBXObject(objects, key, isa);
+        return object(key, isa);
     }
 
 public:
@@ -165,7 +188,7 @@ private:
         if (id != nullptr) {
             *id = key->value();
         }
-        return PlistDictionaryGetPBXObject(objects, key->value(), isa);
+        return object(key->value(), isa);
     }
 
 public:
@@ -180,7 +203,14 @@ private:
                                              std::string const &isa,
                                              std::string *id = nullptr) const
     {
-        return PlistDictionaryGetIndirectPBXObject(objects, unpack, key, isa, id);
+        auto ID = unpack->cast <plist::String> (key);
+        if (ID == nullptr)
+            return nullptr;
+
+        if (id != nullptr) {
+            *id = ID->value();
+        }
+        return object(ID->value(), isa);
     }
 
 public:
@@ -202,8 +232,7 @@ private:
         if (key == nullptr)
             return nullptr;
         else
-            return PlistDictionaryGetIndirectPBXObject(objects, unpack,
-                    key->value(), isa, id);
+            return indirect(unpack, key->value(), isa, id);
     }
 
 public:
@@ -217,13 +246,12 @@ public:
 
 public:
     template <typename T>
-    inline std::shared_ptr <T> parseObject(std::unordered_map <std::string, std::shared_ptr <T>> &cache,
+    inline std::shared_ptr <T> parseObject(ObjectTable <std::shared_ptr <T>> &cache,
                                            std::string const &id,
                                            plist::Dictionary const *dict)
     {
-        auto I = cache.find(id);
-        if (I != cache.end())
-            return I->second;
+        if (std::shared_ptr <T> const *cached = cache.find(id))
+            return *cached;
 
         auto O = std::make_shared <T> ();
         cacheObject(O, id); // cache inside the project
@@ -238,7 +266,7 @@ public:
     }
 
     template <typename T>
-    inline std::shared_ptr <T> parseObject(std::unordered_map <std::string, std::shared_ptr <T>> &cache,
+    inline std::shared_ptr <T> parseObject(ObjectTable <std::shared_ptr <T>> &cache,
                                            plist::Object const *objectId,
                                            plist::Dictionary const *dict)
     {
@@ -249,6 +277,23 @@ public:
         return parseObject(cache, id->value(), dict);
     }
 
+private:
+    inline plist::Dictionary const *object(std::string const &id, std::string const &isa) const
+    {
+        if (isa.empty())
+            return nullptr;
+
+        plist::Dictionary const *dict = object(id);
+        if (dict == nullptr)
+            return nullptr;
+
+        plist::String const *isaObject = dict->value <plist::String> ("isa");
+        if (isaObject != nullptr && isaObject->value() == isa)
+            return dict;
+        else
+            return nullptr;
+    }
+
 private:
     void cacheObject(std::shared_ptr <PBX::Object> const &O, std::string const &id);
 };
@@ -0,0 +1,42 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxproj/ObjectTable.h>
+
+using pbxproj::ObjectIdentifier;
+
+bool ObjectIdentifier::
+Decode(std::string const &string, ObjectIdentifier *identifier)
+{
+    if (string.size() != 24) {
+        return false;
+    }
+
+    uint64_t words[2] = { 0, 0 };
+    for (size_t n = 0; n < 24; n++) {
+        char c = string[n];
+
+        uint64_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            /* Lowercase digits would decode the same as uppercase ones. */
+            return false;
+        }
+
+        uint64_t &word = words[n < 16 ? 0 : 1];
+        word = (word << 4) | digit;
+    }
+
+    identifier->_high = words[0];
+    identifier->_low = static_cast<uint32_t>(words[1]);
+    return true;
+}
@@ -89,7 +89,7 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
                 O->_parent = this;
                 _children.push_back(O);
-            } else if (context.objects->value(ID->value()) != nullptr) {
+            } else if (context.object(ID->value()) != nullptr) {
                 fprintf(stderr, "warning: group '%s' contains unsupported child reference to '%s'\n",
                         _name.c_str(), ID->value().c_str());
             }
@@ -22,14 +22,20 @@ GroupItem(std::string const &isa, Type type) :
 {
 }
 
-pbxsetting::Value GroupItem::
-resolve(void) const
+std::string GroupItem::
+resolvePathComponent(void) const
 {
     std::string path = _path;
     if (_type != Type::Group && _type != Type::VariantGroup) {
         path = path.empty() ? _name : path;
     }
-    path = path.empty() ? path : "/" + path;
+    return path.empty() ? path : "/" + path;
+}
+
+pbxsetting::Value GroupItem::
+resolve(void) const
+{
+    std::string path = resolvePathComponent();
 
     if (_sourceTree.empty() || _sourceTree == "<absolute>") {
         return pbxsetting::Value::String(path);
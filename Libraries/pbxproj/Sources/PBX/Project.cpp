@@ -180,9 +180,40 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
         }
     }
 
+    /* Targets are looked up by identifier for every dependency. */
+    for (Target::shared_ptr const &target : _targets) {
+        if (_targetsByIdentifier.find(target->blueprintIdentifier()) == nullptr) {
+            _targetsByIdentifier[target->blueprintIdentifier()] = target;
+        }
+
+        if (target->type() == Target::Type::Native) {
+            NativeTarget::shared_ptr nativeTarget = std::static_pointer_cast<NativeTarget>(target);
+            if (nativeTarget->productReference() != nullptr) {
+                std::string const &productIdentifier = nativeTarget->productReference()->blueprintIdentifier();
+                if (_targetsByProductIdentifier.find(productIdentifier) == nullptr) {
+                    _targetsByProductIdentifier[productIdentifier] = target;
+                }
+            }
+        }
+    }
+
     return true;
 }
 
+pbxproj::PBX::Target::shared_ptr Project::
+target(std::string const &identifier) const
+{
+    Target::shared_ptr const *target = _targetsByIdentifier.find(identifier);
+    return (target != nullptr ? *target : nullptr);
+}
+
+pbxproj::PBX::Target::shared_ptr Project::
+productTarget(std::string const &identifier) const
+{
+    Target::shared_ptr const *target = _targetsByProductIdentifier.find(identifier);
+    return (target != nullptr ? *target : nullptr);
+}
+
 Project::shared_ptr Project::
 Open(Filesystem const *filesystem, std::string const &path)
 {
@@ -203,16 +234,21 @@ Open(Filesystem const *filesystem, std::string const &path)
         return nullptr;
     }
 
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, realPath)) {
-        fprintf(stderr, "error: project file %s is not readable\n", projectFileName.c_str());
-        return nullptr;
-    }
-
     //
-    // Parse property list
+    // Parse property list. The file contents are released before building
+    // the project objects, so they are not in memory alongside both.
     //
-    auto result = plist::Format::Any::Deserialize(contents);
+    std::pair<std::unique_ptr<plist::Object>, std::string> result;
+    {
+        std::vector<uint8_t> contents;
+        if (!filesystem->read(&contents, realPath)) {
+            fprintf(stderr, "error: project file %s is not readable\n", projectFileName.c_str());
+            return nullptr;
+        }
+
+        result = plist::Format::Any::Deserialize(contents);
+    }
+
     if (result.first == nullptr) {
         fprintf(stderr, "error: project file %s is not parseable: %s\n", projectFileName.c_str(), result.second.c_str());
         return nullptr;
@@ -270,7 +306,7 @@ Open(Filesystem const *filesystem, std::string const &path)
     // Initialize context
     //
     Context context;
-    context.objects = Os;
+    context.setObjects(Os);
 
     //
     // Fetch the project dictionary (root object)
@@ -305,8 +341,8 @@ Open(Filesystem const *filesystem, std::string const &path)
     //
     // Transfer all file references from cache.
     //
-    for (auto const &I : context.fileReferences) {
-        project->_fileReferences.push_back(I.second);
+    for (FileReference::shared_ptr const &fileReference : context.fileReferences) {
+        project->_fileReferences.push_back(fileReference);
     }
 
     return project;
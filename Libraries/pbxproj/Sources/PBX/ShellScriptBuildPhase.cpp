@@ -19,6 +19,7 @@ using pbxproj::PBX::ShellScriptBuildPhase;
 ShellScriptBuildPhase::
 ShellScriptBuildPhase() :
     BuildPhase       (Isa(), Type::ShellScript),
+    _alwaysOutOfDate (false),
     _showEnvVarsInLog(true)
 {
 }
@@ -37,6 +38,9 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
     auto SS = unpack.cast <plist::String> ("shellScript");
     auto IP = unpack.cast <plist::Array> ("inputPaths");
     auto OP = unpack.cast <plist::Array> ("outputPaths");
+    auto IF = unpack.cast <plist::Array> ("inputFileListPaths");
+    auto OF = unpack.cast <plist::Array> ("outputFileListPaths");
+    auto AO = unpack.coerce <plist::Boolean> ("alwaysOutOfDate");
     auto SE = unpack.coerce <plist::Boolean> ("showEnvVarsInLog");
 
     if (!unpack.complete(check)) {
@@ -75,6 +79,30 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
         }
     }
 
+    if (IF != nullptr) {
+        for (size_t n = 0; n < IF->count(); n++) {
+            auto P = IF->value <plist::String> (n);
+            if (P != nullptr) {
+                pbxsetting::Value V = pbxsetting::Value::Parse(P->value());
+                _inputFileListPaths.push_back(V);
+            }
+        }
+    }
+
+    if (OF != nullptr) {
+        for (size_t n = 0; n < OF->count(); n++) {
+            auto P = OF->value <plist::String> (n);
+            if (P != nullptr) {
+                pbxsetting::Value V = pbxsetting::Value::Parse(P->value());
+                _outputFileListPaths.push_back(V);
+            }
+        }
+    }
+
+    if (AO != nullptr) {
+        _alwaysOutOfDate = AO->value();
+    }
+
     if (SE != nullptr) {
         _showEnvVarsInLog = SE->value();
     }
@@ -0,0 +1,283 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxproj/Summary.h>
+#include <plist/Format/ASCII.h>
+#include <plist/Format/Handler.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <unordered_map>
+
+using pbxproj::Summary;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+Summary::
+Summary() :
+    _hasBuildConfigurationList(false),
+    _projectReferencesResolved(true)
+{
+}
+
+namespace {
+
+/*
+ * The fields of a project object needed for a summary.
+ */
+struct SummaryObject {
+    std::string              isa;
+    std::string              name;
+    std::string              path;
+    std::string              sourceTree;
+    std::string              projectDirPath;
+    std::string              buildConfigurationList;
+    std::string              defaultConfigurationName;
+    std::vector<std::string> targets;
+    std::vector<std::string> buildConfigurations;
+    std::vector<std::string> children;
+    std::vector<std::string> projectReferences;
+};
+
+/*
+ * Keeps the few fields used from each object, skipping everything else in
+ * the project file as it's parsed. Levels are the root dictionary, the
+ * objects dictionary, each object, the lists in an object, and the
+ * dictionaries in the project references list.
+ */
+class SummaryHandler : public plist::Format::Handler {
+private:
+    std::vector<bool>        _dictionaries;
+    std::vector<std::string> _keys;
+    SummaryObject           *_object;
+
+public:
+    std::string                                    rootObject;
+    std::unordered_map<std::string, SummaryObject> objects;
+
+public:
+    SummaryHandler() :
+        _object(nullptr)
+    {
+    }
+
+private:
+    bool inObjects() const
+    { return _keys.size() > 1 && _keys[0] == "objects"; }
+
+    bool begin(bool dictionary)
+    {
+        /* Values with levels are containers within their parent. */
+        if (_dictionaries.size() == 2 && dictionary && inObjects()) {
+            _object = &objects[_keys[1]];
+        }
+
+        _dictionaries.push_back(dictionary);
+        _keys.push_back(std::string());
+        return true;
+    }
+
+    bool end()
+    {
+        _dictionaries.pop_back();
+        _keys.pop_back();
+
+        if (_dictionaries.size() == 2) {
+            _object = nullptr;
+        }
+        return true;
+    }
+
+public:
+    virtual bool beginDictionary()
+    { return begin(true); }
+    virtual bool endDictionary()
+    { return end(); }
+    virtual bool beginArray()
+    { return begin(false); }
+    virtual bool endArray()
+    { return end(); }
+
+    virtual bool key(std::string const &key)
+    {
+        _keys.back() = key;
+        return true;
+    }
+
+    virtual bool string(std::string const &value)
+    {
+        size_t level = _dictionaries.size();
+
+        if (level == 1 && _keys[0] == "rootObject") {
+            rootObject = value;
+        } else if (level == 3 && _object != nullptr) {
+            std::string const &field = _keys[2];
+            if (field == "isa") {
+                _object->isa = value;
+            } else if (field == "name") {
+                _object->name = value;
+            } else if (field == "path") {
+                _object->path = value;
+            } else if (field == "sourceTree") {
+                _object->sourceTree = value;
+            } else if (field == "projectDirPath") {
+                _object->projectDirPath = value;
+            } else if (field == "buildConfigurationList") {
+                _object->buildConfigurationList = value;
+            } else if (field == "defaultConfigurationName") {
+                _object->defaultConfigurationName = value;
+            }
+        } else if (level == 4 && _object != nullptr && !_dictionaries[3]) {
+            std::string const &field = _keys[2];
+            if (field == "targets") {
+                _object->targets.push_back(value);
+            } else if (field == "buildConfigurations") {
+                _object->buildConfigurations.push_back(value);
+            } else if (field == "children") {
+                _object->children.push_back(value);
+            }
+        } else if (level == 5 && _object != nullptr && _keys[2] == "projectReferences" && _keys[4] == "ProjectRef") {
+            _object->projectReferences.push_back(value);
+        }
+
+        return true;
+    }
+
+    virtual bool data(std::vector<uint8_t> const &value)
+    { return true; }
+    virtual bool integer(int64_t value)
+    { return true; }
+    virtual bool real(double value)
+    { return true; }
+    virtual bool boolean(bool value)
+    { return true; }
+    virtual bool null()
+    { return true; }
+};
+
+}
+
+/*
+ * Resolve the path of a group item as the project would, for the source
+ * trees that don't need build settings.
+ */
+static ext::optional<std::string>
+ResolveItem(
+    std::unordered_map<std::string, SummaryObject> const &objects,
+    std::unordered_map<std::string, std::string> const &parents,
+    std::string const &identifier,
+    std::string const &sourceRoot,
+    size_t depth)
+{
+    auto it = objects.find(identifier);
+    if (it == objects.end() || depth > objects.size()) {
+        return ext::nullopt;
+    }
+
+    SummaryObject const &item = it->second;
+    bool group = (item.isa == "PBXGroup" || item.isa == "PBXVariantGroup" || item.isa == "XCVersionGroup");
+    std::string path = (group || !item.path.empty() ? item.path : item.name);
+    std::string component = (path.empty() ? path : "/" + path);
+
+    if (item.sourceTree.empty() || item.sourceTree == "<absolute>") {
+        return component;
+    } else if (item.sourceTree == "<group>") {
+        auto parent = parents.find(identifier);
+        if (parent == parents.end()) {
+            return sourceRoot + component;
+        }
+
+        ext::optional<std::string> parentPath = ResolveItem(objects, parents, parent->second, sourceRoot, depth + 1);
+        return (parentPath ? ext::optional<std::string>(*parentPath + component) : ext::nullopt);
+    } else if (item.sourceTree == "SOURCE_ROOT" || item.sourceTree == "SRCROOT" || item.sourceTree == "PROJECT_DIR") {
+        return sourceRoot + component;
+    }
+
+    return ext::nullopt;
+}
+
+ext::optional<Summary> Summary::
+Open(Filesystem const *filesystem, std::string const &path)
+{
+    std::string projectFile = filesystem->resolvePath(path);
+    if (projectFile.empty()) {
+        return ext::nullopt;
+    }
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, projectFile + "/project.pbxproj")) {
+        return ext::nullopt;
+    }
+
+    std::unique_ptr<plist::Format::ASCII> format = plist::Format::ASCII::Identify(contents);
+    if (format == nullptr) {
+        return ext::nullopt;
+    }
+
+    SummaryHandler handler;
+    if (!plist::Format::ASCII::Parse(contents, *format, &handler).first) {
+        return ext::nullopt;
+    }
+
+    auto root = handler.objects.find(handler.rootObject);
+    if (root == handler.objects.end() || root->second.isa != "PBXProject") {
+        return ext::nullopt;
+    }
+    SummaryObject const &project = root->second;
+
+    Summary summary;
+    summary._projectFile = projectFile;
+    summary._name = FSUtil::GetBaseNameWithoutExtension(projectFile);
+
+    for (std::string const &identifier : project.targets) {
+        auto target = handler.objects.find(identifier);
+        if (target != handler.objects.end()) {
+            summary._targets.push_back(target->second.name);
+        }
+    }
+
+    auto configurationList = handler.objects.find(project.buildConfigurationList);
+    if (configurationList != handler.objects.end()) {
+        summary._hasBuildConfigurationList = true;
+        summary._defaultConfigurationName = configurationList->second.defaultConfigurationName;
+
+        for (std::string const &identifier : configurationList->second.buildConfigurations) {
+            auto configuration = handler.objects.find(identifier);
+            if (configuration != handler.objects.end()) {
+                summary._buildConfigurations.push_back(configuration->second.name);
+            }
+        }
+    }
+
+    if (!project.projectReferences.empty()) {
+        std::string sourceRoot = FSUtil::GetDirectoryName(projectFile);
+        if (!project.projectDirPath.empty()) {
+            sourceRoot += "/" + project.projectDirPath;
+        }
+        sourceRoot = FSUtil::NormalizePath(sourceRoot);
+
+        std::unordered_map<std::string, std::string> parents;
+        for (auto const &entry : handler.objects) {
+            for (std::string const &child : entry.second.children) {
+                parents.insert({ child, entry.first });
+            }
+        }
+
+        for (std::string const &identifier : project.projectReferences) {
+            ext::optional<std::string> reference = ResolveItem(handler.objects, parents, identifier, sourceRoot, 0);
+            if (reference) {
+                summary._projectReferences.push_back(FSUtil::NormalizePath(*reference));
+            } else {
+                summary._projectReferencesResolved = false;
+            }
+        }
+    }
+
+    return summary;
+}
@@ -0,0 +1,159 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxproj/ObjectTable.h>
+
+#include <cstdio>
+
+using pbxproj::ObjectIdentifier;
+using pbxproj::ObjectTable;
+
+/*
+ * An identifier as Xcode writes it, from its high 64 and low 32 bits.
+ */
+static std::string
+Identifier(uint64_t high, uint32_t low)
+{
+    char buffer[25];
+    snprintf(buffer, sizeof(buffer), "%016llX%08X", static_cast<unsigned long long>(high), static_cast<unsigned int>(low));
+    return buffer;
+}
+
+static std::vector<int>
+Values(ObjectTable<int> const &table)
+{
+    std::vector<int> values;
+    for (int value : table) {
+        values.push_back(value);
+    }
+    return values;
+}
+
+TEST(ObjectTable, Decode)
+{
+    ObjectIdentifier first;
+    ObjectIdentifier second;
+    ASSERT_TRUE(ObjectIdentifier::Decode("0123456789ABCDEF01234567", &first));
+    ASSERT_TRUE(ObjectIdentifier::Decode("0123456789ABCDEF01234567", &second));
+    EXPECT_TRUE(first == second);
+    EXPECT_EQ(first.hash(), second.hash());
+
+    /* Bits in the high and low words are told apart. */
+    ObjectIdentifier high;
+    ObjectIdentifier low;
+    ASSERT_TRUE(ObjectIdentifier::Decode(Identifier(1, 0), &high));
+    ASSERT_TRUE(ObjectIdentifier::Decode(Identifier(0, 1), &low));
+    EXPECT_FALSE(high == low);
+
+    ObjectIdentifier identifier;
+    EXPECT_FALSE(ObjectIdentifier::Decode("0123456789abcdef01234567", &identifier));
+    EXPECT_FALSE(ObjectIdentifier::Decode("0123456789ABCDEF0123456", &identifier));
+    EXPECT_FALSE(ObjectIdentifier::Decode("0123456789ABCDEF012345678", &identifier));
+    EXPECT_FALSE(ObjectIdentifier::Decode("0123456789ABCDEF0123456G", &identifier));
+    EXPECT_FALSE(ObjectIdentifier::Decode("", &identifier));
+}
+
+TEST(ObjectTable, RoundTrip)
+{
+    ObjectTable<int> table;
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(nullptr, table.find(Identifier(0, 1)));
+
+    /* Enough identifiers to grow the index several times. */
+    std::vector<int> expected;
+    for (int n = 0; n < 1000; ++n) {
+        table[Identifier(0x1000 + n, 0xA0000000 + n)] = n;
+        expected.push_back(n);
+    }
+
+    EXPECT_EQ(1000, table.size());
+    for (int n = 0; n < 1000; ++n) {
+        int const *value = table.find(Identifier(0x1000 + n, 0xA0000000 + n));
+        ASSERT_NE(nullptr, value);
+        EXPECT_EQ(n, *value);
+    }
+    EXPECT_EQ(expected, Values(table));
+
+    /* Adding an identifier again keeps its value and place. */
+    EXPECT_EQ(0, table[Identifier(0x1000, 0xA0000000)]);
+    EXPECT_EQ(1000, table.size());
+    EXPECT_EQ(expected, Values(table));
+}
+
+TEST(ObjectTable, Collisions)
+{
+    ObjectTable<int> table;
+
+    /* Identifiers sharing either word, or moving bits between them. */
+    table[Identifier(7, 1)] = 1;
+    table[Identifier(7, 2)] = 2;
+    table[Identifier(8, 1)] = 3;
+    table[Identifier(1, 0)] = 4;
+    table[Identifier(0, 1)] = 5;
+
+    for (uint32_t n = 0; n < 100; ++n) {
+        table[Identifier(42, n)] = 100 + n;
+    }
+
+    EXPECT_EQ(105, table.size());
+    EXPECT_EQ(1, *table.find(Identifier(7, 1)));
+    EXPECT_EQ(2, *table.find(Identifier(7, 2)));
+    EXPECT_EQ(3, *table.find(Identifier(8, 1)));
+    EXPECT_EQ(4, *table.find(Identifier(1, 0)));
+    EXPECT_EQ(5, *table.find(Identifier(0, 1)));
+    for (uint32_t n = 0; n < 100; ++n) {
+        EXPECT_EQ(100 + n, *table.find(Identifier(42, n)));
+    }
+    EXPECT_EQ(nullptr, table.find(Identifier(42, 100)));
+    EXPECT_EQ(nullptr, table.find(Identifier(8, 2)));
+}
+
+TEST(ObjectTable, Other)
+{
+    ObjectTable<int> table;
+
+    /* Identifiers that don't decode are kept in order with the rest. */
+    table["0123456789ABCDEF01234567"] = 1;
+    table["main"] = 2;
+    table["0123456789abcdef01234567"] = 3;
+
+    EXPECT_EQ(3, table.size());
+    EXPECT_EQ(1, *table.find("0123456789ABCDEF01234567"));
+    EXPECT_EQ(2, *table.find("main"));
+    EXPECT_EQ(3, *table.find("0123456789abcdef01234567"));
+    EXPECT_EQ(nullptr, table.find("other"));
+    EXPECT_EQ(std::vector<int>({ 1, 2, 3 }), Values(table));
+}
+
+TEST(ObjectTable, Erase)
+{
+    ObjectTable<int> table;
+    table[Identifier(0, 1)] = 1;
+    table["main"] = 2;
+    table[Identifier(0, 3)] = 3;
+
+    table.erase(Identifier(0, 1));
+    table.erase("main");
+    table.erase(Identifier(0, 4));
+    EXPECT_EQ(1, table.size());
+    EXPECT_EQ(nullptr, table.find(Identifier(0, 1)));
+    EXPECT_EQ(nullptr, table.find("main"));
+    EXPECT_EQ(std::vector<int>({ 3 }), Values(table));
+
+    /* Added again, an identifier takes its earlier place. */
+    table[Identifier(0, 1)] = 4;
+    EXPECT_EQ(2, table.size());
+    EXPECT_EQ(std::vector<int>({ 4, 3 }), Values(table));
+
+    table.clear();
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(nullptr, table.find(Identifier(0, 3)));
+    EXPECT_TRUE(Values(table).empty());
+}
@@ -0,0 +1,102 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxproj/Summary.h>
+#include <libutil/MemoryFilesystem.h>
+
+using pbxproj::Summary;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static std::string const ProjectContents =
+    "// !$*UTF8*$!\n"
+    "{\n"
+    "    archiveVersion = 1;\n"
+    "    classes = {\n"
+    "    };\n"
+    "    objectVersion = 46;\n"
+    "    objects = {\n"
+    "        000000000000000000000001 /* Project object */ = {\n"
+    "            isa = PBXProject;\n"
+    "            buildConfigurationList = 000000000000000000000002;\n"
+    "            mainGroup = 000000000000000000000010;\n"
+    "            projectDirPath = \"\";\n"
+    "            projectReferences = (\n"
+    "                {\n"
+    "                    ProductGroup = 000000000000000000000013;\n"
+    "                    ProjectRef = 000000000000000000000012;\n"
+    "                },\n"
+    "                {\n"
+    "                    ProductGroup = 000000000000000000000013;\n"
+    "                    ProjectRef = 000000000000000000000014;\n"
+    "                },\n"
+    "            );\n"
+    "            targets = (\n"
+    "                000000000000000000000006 /* App */,\n"
+    "                000000000000000000000005 /* Tests */,\n"
+    "            );\n"
+    "        };\n"
+    "        000000000000000000000002 = {\n"
+    "            isa = XCConfigurationList;\n"
+    "            buildConfigurations = (\n"
+    "                000000000000000000000003,\n"
+    "                000000000000000000000004,\n"
+    "            );\n"
+    "            defaultConfigurationIsVisible = 0;\n"
+    "            defaultConfigurationName = Release;\n"
+    "        };\n"
+    "        000000000000000000000003 = { isa = XCBuildConfiguration; buildSettings = { }; name = Debug; };\n"
+    "        000000000000000000000004 = { isa = XCBuildConfiguration; buildSettings = { PRODUCT_NAME = Other; }; name = Release; };\n"
+    "        000000000000000000000005 = { isa = PBXNativeTarget; name = Tests; productName = Other; };\n"
+    "        000000000000000000000006 = { isa = PBXNativeTarget; name = App; };\n"
+    "        000000000000000000000010 = { isa = PBXGroup; children = ( 000000000000000000000011 ); sourceTree = \"<group>\"; };\n"
+    "        000000000000000000000011 = { isa = PBXGroup; children = ( 000000000000000000000012 ); path = Nested; sourceTree = \"<group>\"; };\n"
+    "        000000000000000000000012 = { isa = PBXFileReference; path = Library.xcodeproj; sourceTree = \"<group>\"; };\n"
+    "        000000000000000000000014 = { isa = PBXFileReference; path = Built.xcodeproj; sourceTree = BUILT_PRODUCTS_DIR; };\n"
+    "    };\n"
+    "    rootObject = 000000000000000000000001 /* Project object */;\n"
+    "}\n";
+
+TEST(Summary, Open)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("App.xcodeproj", {
+            MemoryFilesystem::Entry::File("project.pbxproj", Contents(ProjectContents)),
+        }),
+        MemoryFilesystem::Entry::Directory("XML.xcodeproj", {
+            MemoryFilesystem::Entry::File("project.pbxproj", Contents("<?xml version=\"1.0\"?><plist><dict/></plist>")),
+        }),
+    });
+
+    ext::optional<Summary> summary = Summary::Open(&filesystem, "/App.xcodeproj");
+    ASSERT_TRUE(summary);
+    EXPECT_EQ("App", summary->name());
+    EXPECT_EQ("/App.xcodeproj", summary->projectFile());
+
+    /* In the order of the project, not of the objects. */
+    EXPECT_EQ(std::vector<std::string>({ "App", "Tests" }), summary->targets());
+
+    EXPECT_TRUE(summary->hasBuildConfigurationList());
+    EXPECT_EQ(std::vector<std::string>({ "Debug", "Release" }), summary->buildConfigurations());
+    EXPECT_EQ("Release", summary->defaultConfigurationName());
+
+    /* Paths relative to groups resolve; ones needing settings don't. */
+    EXPECT_EQ(std::vector<std::string>({ "/Nested/Library.xcodeproj" }), summary->projectReferences());
+    EXPECT_FALSE(summary->projectReferencesResolved());
+
+    /* Other formats need the project opened. */
+    EXPECT_FALSE(Summary::Open(&filesystem, "/XML.xcodeproj"));
+    EXPECT_FALSE(Summary::Open(&filesystem, "/Missing.xcodeproj"));
+}
@@ -0,0 +1,652 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <libutil/Options.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/String.h>
+#include <plist/Format/ASCII.h>
+#include <process/DefaultContext.h>
+#include <process/Context.h>
+
+#include <string>
+#include <vector>
+
+#include <cstdio>
+
+using libutil::DefaultFilesystem;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+class Options {
+private:
+    ext::optional<bool>        _help;
+
+private:
+    ext::optional<int>         _projects;
+    ext::optional<int>         _targets;
+    ext::optional<int>         _sources;
+    ext::optional<int>         _configDepth;
+    ext::optional<int>         _dependencies;
+    ext::optional<int>         _assets;
+    ext::optional<std::string> _output;
+
+public:
+    Options();
+    ~Options();
+
+public:
+    bool help() const
+    { return _help.value_or(false); }
+
+public:
+    int projects() const
+    { return _projects.value_or(1); }
+    int targets() const
+    { return _targets.value_or(10); }
+    int sources() const
+    { return _sources.value_or(20); }
+    int configDepth() const
+    { return _configDepth.value_or(4); }
+    int dependencies() const
+    { return _dependencies.value_or(3); }
+    int assets() const
+    { return _assets.value_or(4); }
+    ext::optional<std::string> const &output() const
+    { return _output; }
+
+private:
+    friend class libutil::Options;
+    std::pair<bool, std::string>
+    parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it);
+};
+
+Options::
+Options()
+{
+}
+
+Options::
+~Options()
+{
+}
+
+std::pair<bool, std::string> Options::
+parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it)
+{
+    std::string const &arg = **it;
+
+    if (arg == "-h" || arg == "--help") {
+        return libutil::Options::Current<bool>(&_help, arg);
+    } else if (arg == "--projects") {
+        return libutil::Options::Next<int>(&_projects, args, it);
+    } else if (arg == "--targets") {
+        return libutil::Options::Next<int>(&_targets, args, it);
+    } else if (arg == "--sources") {
+        return libutil::Options::Next<int>(&_sources, args, it);
+    } else if (arg == "--config-depth") {
+        return libutil::Options::Next<int>(&_configDepth, args, it);
+    } else if (arg == "--dependencies") {
+        return libutil::Options::Next<int>(&_dependencies, args, it);
+    } else if (arg == "--assets") {
+        return libutil::Options::Next<int>(&_assets, args, it);
+    } else if (!arg.empty() && arg[0] != '-') {
+        if (_output) {
+            return std::make_pair(false, "multiple outputs " + arg);
+        }
+        _output = arg;
+        return std::make_pair(true, std::string());
+    } else {
+        return std::make_pair(false, "unknown argument " + arg);
+    }
+}
+
+static int
+Help(std::string const &error = std::string())
+{
+    if (!error.empty()) {
+        fprintf(stderr, "error: %s\n", error.c_str());
+        fprintf(stderr, "\n");
+    }
+
+    fprintf(stderr, "Usage: generate_xcodeproj [options] <output>\n\n");
+    fprintf(stderr, "Generates a synthetic workspace of projects for measuring build planning.\n");
+    fprintf(stderr, "The same options always generate the same workspace.\n\n");
+
+#define INDENT "  "
+    fprintf(stderr, "Information:\n");
+    fprintf(stderr, INDENT "-h, --help\n");
+    fprintf(stderr, "\n");
+
+    fprintf(stderr, "Generation Options:\n");
+    fprintf(stderr, INDENT "--projects <count> (default 1)\n");
+    fprintf(stderr, INDENT "--targets <count> (per project, default 10)\n");
+    fprintf(stderr, INDENT "--sources <count> (per target, default 20)\n");
+    fprintf(stderr, INDENT "--config-depth <count> (xcconfig include chain, default 4)\n");
+    fprintf(stderr, INDENT "--dependencies <count> (per target, default 3)\n");
+    fprintf(stderr, INDENT "--assets <count> (per asset catalog, default 4; 0 for none)\n");
+    fprintf(stderr, "\n");
+#undef INDENT
+
+    return (error.empty() ? 0 : -1);
+}
+
+namespace {
+
+/*
+ * Writes a generated workspace into a filesystem. Identifiers are handed out
+ * in order, so generation is deterministic.
+ */
+class Generator {
+private:
+    Filesystem    *_filesystem;
+    Options const &_options;
+    uint64_t       _nextIdentifier;
+
+public:
+    size_t         files;
+
+public:
+    Generator(Filesystem *filesystem, Options const &options) :
+        _filesystem    (filesystem),
+        _options       (options),
+        _nextIdentifier(1),
+        files          (0)
+    {
+    }
+
+public:
+    bool workspace(std::string const &root);
+
+private:
+    std::string identifier();
+    bool write(std::string const &path, std::string const &contents);
+
+private:
+    bool project(std::string const &root, int project, std::vector<std::pair<std::string, std::string>> *targets);
+    bool configs(std::string const &directory);
+    bool target(std::string const &directory, std::string const &name, int target);
+};
+
+}
+
+std::string Generator::
+identifier()
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%024llX", static_cast<unsigned long long>(_nextIdentifier++));
+    return buffer;
+}
+
+bool Generator::
+write(std::string const &path, std::string const &contents)
+{
+    if (!_filesystem->createDirectory(FSUtil::GetDirectoryName(path))) {
+        fprintf(stderr, "error: unable to create directory for %s\n", path.c_str());
+        return false;
+    }
+
+    if (!_filesystem->write(std::vector<uint8_t>(contents.begin(), contents.end()), path)) {
+        fprintf(stderr, "error: unable to write %s\n", path.c_str());
+        return false;
+    }
+
+    files++;
+    return true;
+}
+
+/*
+ * A chain of configuration files, each including the next, with settings
+ * that refer to settings from further down the chain.
+ */
+bool Generator::
+configs(std::string const &directory)
+{
+    for (int level = 0; level < _options.configDepth(); ++level) {
+        std::string contents;
+        if (level + 1 < _options.configDepth()) {
+            contents += "#include \"Level" + std::to_string(level + 1) + ".xcconfig\"\n\n";
+        } else {
+            contents += "SDKROOT = macosx\n";
+            contents += "CONFIGURATION_LEVEL = base\n";
+        }
+
+        contents += "LEVEL" + std::to_string(level) + "_FLAGS = -DLEVEL" + std::to_string(level) + "=$(CONFIGURATION_LEVEL)\n";
+        contents += "OTHER_CFLAGS = $(inherited) $(LEVEL" + std::to_string(level) + "_FLAGS)\n";
+        contents += "GCC_PREPROCESSOR_DEFINITIONS = $(inherited) CONFIG_LEVEL_" + std::to_string(level) + "=1\n";
+        contents += "CONFIGURATION_LEVEL = $(CONFIGURATION_LEVEL)_" + std::to_string(level) + "\n";
+
+        if (!write(directory + "/Level" + std::to_string(level) + ".xcconfig", contents)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * The files of one target: sources, a header, an information property
+ * list and an asset catalog of color sets.
+ */
+bool Generator::
+target(std::string const &directory, std::string const &name, int target)
+{
+    std::string header = "#pragma once\n\n";
+    for (int source = 0; source < _options.sources(); ++source) {
+        std::string function = name + "_File" + std::to_string(source);
+        header += "int " + function + "(int value);\n";
+
+        std::string contents;
+        contents += "#include \"" + name + ".h\"\n\n";
+        contents += "int\n" + function + "(int value)\n{\n";
+        contents += "    return value + " + std::to_string(source + target) + ";\n";
+        contents += "}\n";
+        if (!write(directory + "/File" + std::to_string(source) + ".c", contents)) {
+            return false;
+        }
+    }
+
+    if (!write(directory + "/" + name + ".h", header)) {
+        return false;
+    }
+
+    std::string info;
+    info += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    info += "<!DOCTYPE plist PUBLIC \"-//Apple//DTD PLIST 1.0//EN\" \"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n";
+    info += "<plist version=\"1.0\">\n<dict>\n";
+    info += "\t<key>CFBundleExecutable</key>\n\t<string>$(EXECUTABLE_NAME)</string>\n";
+    info += "\t<key>CFBundleIdentifier</key>\n\t<string>$(PRODUCT_BUNDLE_IDENTIFIER)</string>\n";
+    info += "\t<key>CFBundlePackageType</key>\n\t<string>FMWK</string>\n";
+    info += "</dict>\n</plist>\n";
+    if (!write(directory + "/Info.plist", info)) {
+        return false;
+    }
+
+    if (_options.assets() > 0) {
+        std::string catalog = directory + "/Assets.xcassets";
+        if (!write(catalog + "/Contents.json", "{\n  \"info\" : {\n    \"version\" : 1,\n    \"author\" : \"xcode\"\n  }\n}\n")) {
+            return false;
+        }
+
+        for (int asset = 0; asset < _options.assets(); ++asset) {
+            std::string contents;
+            contents += "{\n  \"info\" : {\n    \"version\" : 1,\n    \"author\" : \"xcode\"\n  },\n";
+            contents += "  \"colors\" : [\n    {\n      \"idiom\" : \"universal\",\n";
+            contents += "      \"color\" : {\n        \"color-space\" : \"srgb\",\n        \"components\" : {\n";
+            contents += "          \"red\" : \"" + std::to_string((asset * 37) % 256) + "\",\n";
+            contents += "          \"green\" : \"" + std::to_string((target * 53) % 256) + "\",\n";
+            contents += "          \"blue\" : \"128\",\n          \"alpha\" : \"1.000\"\n";
+            contents += "        }\n      }\n    }\n  ]\n}\n";
+            if (!write(catalog + "/Color" + std::to_string(asset) + ".colorset/Contents.json", contents)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static std::unique_ptr<plist::Array>
+Strings(std::vector<std::string> const &values)
+{
+    std::unique_ptr<plist::Array> array = plist::Array::New();
+    for (std::string const &value : values) {
+        array->append(plist::String::New(value));
+    }
+    return array;
+}
+
+static std::unique_ptr<plist::Dictionary>
+Object(std::string const &isa)
+{
+    std::unique_ptr<plist::Dictionary> object = plist::Dictionary::New();
+    object->set("isa", plist::String::New(isa));
+    return object;
+}
+
+static std::unique_ptr<plist::Dictionary>
+FileReference(std::string const &path, std::string const &sourceTree, std::string const &fileTypeKey, std::string const &fileType)
+{
+    std::unique_ptr<plist::Dictionary> object = Object("PBXFileReference");
+    object->set(fileTypeKey, plist::String::New(fileType));
+    object->set("path", plist::String::New(path));
+    object->set("sourceTree", plist::String::New(sourceTree));
+    return object;
+}
+
+static std::unique_ptr<plist::Dictionary>
+Group(std::string const &name, std::string const &path, std::vector<std::string> const &children)
+{
+    std::unique_ptr<plist::Dictionary> object = Object("PBXGroup");
+    object->set("children", Strings(children));
+    if (!name.empty()) {
+        object->set("name", plist::String::New(name));
+    }
+    if (!path.empty()) {
+        object->set("path", plist::String::New(path));
+    }
+    object->set("sourceTree", plist::String::New("<group>"));
+    return object;
+}
+
+/*
+ * The targets of a project depend on a few earlier targets each, at
+ * doubling distances, so the dependency graph is both deep and wide.
+ */
+bool Generator::
+project(std::string const &root, int projectIndex, std::vector<std::pair<std::string, std::string>> *targets)
+{
+    std::string projectName = "Project" + std::to_string(projectIndex);
+    std::string directory = root + "/" + projectName;
+
+    std::unique_ptr<plist::Dictionary> objects = plist::Dictionary::New();
+    std::string projectIdentifier = identifier();
+
+    /* Configuration files, shared by the project's configurations. */
+    std::vector<std::string> configReferences;
+    if (!configs(directory + "/Configs")) {
+        return false;
+    }
+    for (int level = 0; level < _options.configDepth(); ++level) {
+        std::string reference = identifier();
+        objects->set(reference, FileReference("Level" + std::to_string(level) + ".xcconfig", "<group>", "lastKnownFileType", "text.xcconfig"));
+        configReferences.push_back(reference);
+    }
+
+    std::vector<std::string> mainChildren;
+    std::string configsGroup = identifier();
+    objects->set(configsGroup, Group(std::string(), "Configs", configReferences));
+    mainChildren.push_back(configsGroup);
+
+    auto configurationList = [&](std::vector<std::pair<std::string, std::string>> const &settings, bool project) -> std::string {
+        std::vector<std::string> configurations;
+        for (char const *name : { "Debug", "Release" }) {
+            std::unique_ptr<plist::Dictionary> buildSettings = plist::Dictionary::New();
+            for (std::pair<std::string, std::string> const &setting : settings) {
+                buildSettings->set(setting.first, plist::String::New(setting.second));
+            }
+
+            std::unique_ptr<plist::Dictionary> configuration = Object("XCBuildConfiguration");
+            if (project && !configReferences.empty()) {
+                configuration->set("baseConfigurationReference", plist::String::New(configReferences.front()));
+            }
+            configuration->set("buildSettings", std::move(buildSettings));
+            configuration->set("name", plist::String::New(name));
+
+            std::string configurationIdentifier = identifier();
+            objects->set(configurationIdentifier, std::move(configuration));
+            configurations.push_back(configurationIdentifier);
+        }
+
+        std::unique_ptr<plist::Dictionary> list = Object("XCConfigurationList");
+        list->set("buildConfigurations", Strings(configurations));
+        list->set("defaultConfigurationIsVisible", plist::String::New("0"));
+        list->set("defaultConfigurationName", plist::String::New("Release"));
+
+        std::string listIdentifier = identifier();
+        objects->set(listIdentifier, std::move(list));
+        return listIdentifier;
+    };
+
+    std::vector<std::string> targetIdentifiers;
+    std::vector<std::string> productReferences;
+
+    for (int targetIndex = 0; targetIndex < _options.targets(); ++targetIndex) {
+        std::string name = projectName + "Target" + std::to_string(targetIndex);
+        std::string targetDirectory = directory + "/" + name;
+        if (!target(targetDirectory, name, targetIndex)) {
+            return false;
+        }
+
+        std::string targetIdentifier = identifier();
+
+        std::vector<std::string> groupChildren;
+        std::vector<std::string> sourceFiles;
+        std::vector<std::string> resourceFiles;
+        std::vector<std::string> frameworkFiles;
+
+        for (int source = 0; source < _options.sources(); ++source) {
+            std::string reference = identifier();
+            objects->set(reference, FileReference("File" + std::to_string(source) + ".c", "<group>", "lastKnownFileType", "sourcecode.c.c"));
+            groupChildren.push_back(reference);
+
+            std::unique_ptr<plist::Dictionary> buildFile = Object("PBXBuildFile");
+            buildFile->set("fileRef", plist::String::New(reference));
+            std::string buildFileIdentifier = identifier();
+            objects->set(buildFileIdentifier, std::move(buildFile));
+            sourceFiles.push_back(buildFileIdentifier);
+        }
+
+        std::string headerReference = identifier();
+        objects->set(headerReference, FileReference(name + ".h", "<group>", "lastKnownFileType", "sourcecode.c.h"));
+        groupChildren.push_back(headerReference);
+
+        std::string infoReference = identifier();
+        objects->set(infoReference, FileReference("Info.plist", "<group>", "lastKnownFileType", "text.plist.xml"));
+        groupChildren.push_back(infoReference);
+
+        if (_options.assets() > 0) {
+            std::string reference = identifier();
+            objects->set(reference, FileReference("Assets.xcassets", "<group>", "lastKnownFileType", "folder.assetcatalog"));
+            groupChildren.push_back(reference);
+
+            std::unique_ptr<plist::Dictionary> buildFile = Object("PBXBuildFile");
+            buildFile->set("fileRef", plist::String::New(reference));
+            std::string buildFileIdentifier = identifier();
+            objects->set(buildFileIdentifier, std::move(buildFile));
+            resourceFiles.push_back(buildFileIdentifier);
+        }
+
+        std::string group = identifier();
+        objects->set(group, Group(std::string(), name, groupChildren));
+        mainChildren.push_back(group);
+
+        std::string productReference = identifier();
+        objects->set(productReference, FileReference(name + ".framework", "BUILT_PRODUCTS_DIR", "explicitFileType", "wrapper.framework"));
+
+        /* Depend on, and link against, a few earlier targets. */
+        std::vector<std::string> dependencies;
+        for (int distance = 1, count = 0; distance <= targetIndex && count < _options.dependencies(); distance *= 2, ++count) {
+            int dependencyIndex = targetIndex - distance;
+
+            std::unique_ptr<plist::Dictionary> proxy = Object("PBXContainerItemProxy");
+            proxy->set("containerPortal", plist::String::New(projectIdentifier));
+            proxy->set("proxyType", plist::String::New("1"));
+            proxy->set("remoteGlobalIDString", plist::String::New(targetIdentifiers[dependencyIndex]));
+            proxy->set("remoteInfo", plist::String::New(projectName + "Target" + std::to_string(dependencyIndex)));
+            std::string proxyIdentifier = identifier();
+            objects->set(proxyIdentifier, std::move(proxy));
+
+            std::unique_ptr<plist::Dictionary> dependency = Object("PBXTargetDependency");
+            dependency->set("target", plist::String::New(targetIdentifiers[dependencyIndex]));
+            dependency->set("targetProxy", plist::String::New(proxyIdentifier));
+            std::string dependencyIdentifier = identifier();
+            objects->set(dependencyIdentifier, std::move(dependency));
+            dependencies.push_back(dependencyIdentifier);
+
+            std::unique_ptr<plist::Dictionary> buildFile = Object("PBXBuildFile");
+            buildFile->set("fileRef", plist::String::New(productReferences[dependencyIndex]));
+            std::string buildFileIdentifier = identifier();
+            objects->set(buildFileIdentifier, std::move(buildFile));
+            frameworkFiles.push_back(buildFileIdentifier);
+        }
+
+        std::vector<std::string> phases;
+        for (auto const &phase : std::vector<std::pair<std::string, std::vector<std::string>>>({
+            { "PBXSourcesBuildPhase", sourceFiles },
+            { "PBXFrameworksBuildPhase", frameworkFiles },
+            { "PBXResourcesBuildPhase", resourceFiles },
+        })) {
+            std::unique_ptr<plist::Dictionary> object = Object(phase.first);
+            object->set("buildActionMask", plist::String::New("2147483647"));
+            object->set("files", Strings(phase.second));
+            object->set("runOnlyForDeploymentPostprocessing", plist::String::New("0"));
+
+            std::string phaseIdentifier = identifier();
+            objects->set(phaseIdentifier, std::move(object));
+            phases.push_back(phaseIdentifier);
+        }
+
+        std::string targetConfigurationList = configurationList({
+            { "PRODUCT_NAME", "$(TARGET_NAME)" },
+            { "PRODUCT_BUNDLE_IDENTIFIER", "com.example." + name },
+            { "INFOPLIST_FILE", name + "/Info.plist" },
+        }, false);
+
+        std::unique_ptr<plist::Dictionary> nativeTarget = Object("PBXNativeTarget");
+        nativeTarget->set("buildConfigurationList", plist::String::New(targetConfigurationList));
+        nativeTarget->set("buildPhases", Strings(phases));
+        nativeTarget->set("buildRules", plist::Array::New());
+        nativeTarget->set("dependencies", Strings(dependencies));
+        nativeTarget->set("name", plist::String::New(name));
+        nativeTarget->set("productName", plist::String::New(name));
+        nativeTarget->set("productReference", plist::String::New(productReference));
+        nativeTarget->set("productType", plist::String::New("com.apple.product-type.framework"));
+        objects->set(targetIdentifier, std::move(nativeTarget));
+
+        targetIdentifiers.push_back(targetIdentifier);
+        productReferences.push_back(productReference);
+        targets->push_back({ targetIdentifier, name });
+    }
+
+    std::string productsGroup = identifier();
+    objects->set(productsGroup, Group("Products", std::string(), productReferences));
+    mainChildren.push_back(productsGroup);
+
+    std::string mainGroup = identifier();
+    objects->set(mainGroup, Group(std::string(), std::string(), mainChildren));
+
+    std::string projectConfigurationList = configurationList({
+        { "ONLY_ACTIVE_ARCH", "YES" },
+    }, true);
+
+    std::unique_ptr<plist::Dictionary> projectObject = Object("PBXProject");
+    projectObject->set("attributes", plist::Dictionary::New());
+    projectObject->set("buildConfigurationList", plist::String::New(projectConfigurationList));
+    projectObject->set("compatibilityVersion", plist::String::New("Xcode 3.2"));
+    projectObject->set("developmentRegion", plist::String::New("English"));
+    projectObject->set("hasScannedForEncodings", plist::String::New("0"));
+    projectObject->set("knownRegions", Strings({ "en" }));
+    projectObject->set("mainGroup", plist::String::New(mainGroup));
+    projectObject->set("productRefGroup", plist::String::New(productsGroup));
+    projectObject->set("projectDirPath", plist::String::New(""));
+    projectObject->set("projectRoot", plist::String::New(""));
+    projectObject->set("targets", Strings(targetIdentifiers));
+    objects->set(projectIdentifier, std::move(projectObject));
+
+    std::unique_ptr<plist::Dictionary> contents = plist::Dictionary::New();
+    contents->set("archiveVersion", plist::String::New("1"));
+    contents->set("classes", plist::Dictionary::New());
+    contents->set("objectVersion", plist::String::New("46"));
+    contents->set("objects", std::move(objects));
+    contents->set("rootObject", plist::String::New(projectIdentifier));
+
+    auto serialized = plist::Format::ASCII::Serialize(contents.get(), plist::Format::ASCII::Create(false, plist::Format::Encoding::UTF8));
+    if (serialized.first == nullptr) {
+        fprintf(stderr, "error: %s\n", serialized.second.c_str());
+        return false;
+    }
+
+    std::string file = "// !$*UTF8*$!\n" + std::string(serialized.first->begin(), serialized.first->end());
+    return write(directory + "/" + projectName + ".xcodeproj/project.pbxproj", file);
+}
+
+bool Generator::
+workspace(std::string const &root)
+{
+    std::string contents;
+    contents += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    contents += "<Workspace\n   version = \"1.0\">\n";
+
+    std::string entries;
+    for (int projectIndex = 0; projectIndex < _options.projects(); ++projectIndex) {
+        std::string container = "Project" + std::to_string(projectIndex) + "/Project" + std::to_string(projectIndex) + ".xcodeproj";
+
+        std::vector<std::pair<std::string, std::string>> targets;
+        if (!project(root, projectIndex, &targets)) {
+            return false;
+        }
+
+        contents += "   <FileRef\n      location = \"group:" + container + "\">\n   </FileRef>\n";
+
+        for (std::pair<std::string, std::string> const &target : targets) {
+            entries += "         <BuildActionEntry\n";
+            entries += "            buildForTesting = \"YES\"\n";
+            entries += "            buildForRunning = \"YES\"\n";
+            entries += "            buildForProfiling = \"YES\"\n";
+            entries += "            buildForArchiving = \"YES\"\n";
+            entries += "            buildForAnalyzing = \"YES\">\n";
+            entries += "            <BuildableReference\n";
+            entries += "               BuildableIdentifier = \"primary\"\n";
+            entries += "               BlueprintIdentifier = \"" + target.first + "\"\n";
+            entries += "               BuildableName = \"" + target.second + ".framework\"\n";
+            entries += "               BlueprintName = \"" + target.second + "\"\n";
+            entries += "               ReferencedContainer = \"container:" + container + "\">\n";
+            entries += "            </BuildableReference>\n";
+            entries += "         </BuildActionEntry>\n";
+        }
+    }
+
+    contents += "</Workspace>\n";
+    if (!write(root + "/Generated.xcworkspace/contents.xcworkspacedata", contents)) {
+        return false;
+    }
+
+    /* A scheme that builds every target, for building the whole workspace. */
+    std::string scheme;
+    scheme += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    scheme += "<Scheme\n   LastUpgradeVersion = \"0700\"\n   version = \"1.3\">\n";
+    scheme += "   <BuildAction\n      parallelizeBuildables = \"YES\"\n      buildImplicitDependencies = \"YES\">\n";
+    scheme += "      <BuildActionEntries>\n" + entries + "      </BuildActionEntries>\n";
+    scheme += "   </BuildAction>\n";
+    scheme += "</Scheme>\n";
+    return write(root + "/Generated.xcworkspace/xcshareddata/xcschemes/All.xcscheme", scheme);
+}
+
+int
+main(int argc, char **argv)
+{
+    DefaultFilesystem filesystem = DefaultFilesystem();
+    process::DefaultContext processContext = process::DefaultContext();
+
+    /*
+     * Parse out the options, or print help & exit.
+     */
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext.commandLineArguments());
+    if (!result.first) {
+        return Help(result.second);
+    }
+
+    if (options.help()) {
+        return Help();
+    }
+
+    if (!options.output()) {
+        return Help("missing output");
+    }
+
+    if (options.projects() < 1 || options.targets() < 1 || options.sources() < 0 || options.configDepth() < 0 || options.dependencies() < 0 || options.assets() < 0) {
+        return Help("counts must not be negative, and there must be at least one project and target");
+    }
+
+    std::string root = FSUtil::ResolveRelativePath(*options.output(), processContext.currentDirectory());
+
+    Generator generator = Generator(&filesystem, options);
+    if (!generator.workspace(root)) {
+        return 1;
+    }
+
+    printf("Generated %d project(s) with %d target(s) each, %zu files, in %s\n",
+        options.projects(), options.targets(), generator.files, root.c_str());
+    return 0;
+}
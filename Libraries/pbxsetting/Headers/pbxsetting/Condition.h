@@ -10,15 +10,37 @@
 #ifndef __pbxsetting_Condition_h
 #define __pbxsetting_Condition_h
 
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace pbxsetting {
 
 class Condition {
 public:
 private:
-    std::unordered_map<std::string, std::string> _values;
+    /*
+     * A condition value, with its name and value interned so matching can
+     * compare them by address. Values with wildcards still need matching.
+     */
+    struct Key {
+        std::string const *name;
+        std::string const *value;
+        bool               wildcard;
+    };
+
+    struct Values {
+        std::unordered_map<std::string, std::string> values;
+        std::vector<Key>                             keys;
+    };
+
+private:
+    /*
+     * Shared between copies, since nearly every setting is copied with the
+     * same, usually empty, condition.
+     */
+    std::shared_ptr<Values const> _values;
 
 public:
     Condition(std::unordered_map<std::string, std::string> const &values);
@@ -29,12 +51,18 @@ public:
 
 public:
     std::unordered_map<std::string, std::string> const &
-    values() const { return _values; }
+    values() const { return _values->values; }
 
 public:
     bool
     match(Condition const &condition) const;
 
+public:
+    bool operator==(Condition const &rhs) const
+    { return _values == rhs._values || _values->values == rhs._values->values; }
+    bool operator!=(Condition const &rhs) const
+    { return !(*this == rhs); }
+
 public:
     static Condition const &
     Empty(void);
@@ -47,7 +75,7 @@ template<>
 struct hash<pbxsetting::Condition> {
     size_t operator()(pbxsetting::Condition const &condition) const {
         size_t hash = 0;
-        for (auto pair : condition._values) {
+        for (auto const &pair : condition._values->values) {
             hash ^= std::hash<std::string>()(pair.first);
             hash ^= std::hash<std::string>()(pair.second);
         }
@@ -13,20 +13,45 @@
 #include <pbxsetting/Condition.h>
 #include <pbxsetting/Level.h>
 
-#include <list>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace pbxsetting {
 
 /*
  * Represents a hierarchical list of build settings (an ordered list of build
  * setting levels). Can use those levels to evaluate build setting values.
+ *
+ * Resolving, expanding and computing values don't change an environment,
+ * so those can be called from any number of threads at once, including on
+ * copies sharing the same levels. Inserting a level changes only that copy,
+ * and must not race with other use of the same object.
  */
 class Environment {
 private:
-    std::list<Level> _levels;
-    size_t           _offset;
+    /*
+     * The levels, shared between copies. Inserting a level replaces them,
+     * so deriving an environment from another only copies them if the
+     * derived environment adds its own levels.
+     */
+    std::shared_ptr<std::vector<Level> const> _levels;
+    size_t                                    _offset;
+
+private:
+    /*
+     * Resolved settings for each condition. Shared between copies, since they
+     * resolve the same way until a level is inserted, which replaces it.
+     */
+    struct Cache {
+        std::mutex mutex;
+        std::unordered_map<Condition, std::unordered_map<std::string, std::string>> values;
+        std::unordered_map<Condition, std::unordered_map<std::string, std::string>> computed;
+    };
+    std::shared_ptr<Cache> _cache;
 
 public:
     explicit Environment();
@@ -55,11 +80,28 @@ public:
 
 public:
     /*
-     * Computes all values for all settings present in the environment.
+     * Computes all values for all settings present in the environment. The
+     * result is kept, so copies of the environment share it.
      */
     std::unordered_map<std::string, std::string>
     computeValues(Condition const &condition) const;
 
+    /*
+     * Computes the values for only the settings present in the environment
+     * accepted by a filter.
+     */
+    std::unordered_map<std::string, std::string>
+    computeValues(Condition const &condition, std::function<bool(std::string const &)> const &filter) const;
+
+public:
+    /*
+     * Identifies the levels in the environment, and so every value it can
+     * resolve to. Environments with the same levels have the same
+     * fingerprint, without having to resolve any of their settings.
+     */
+    std::string
+    fingerprint() const;
+
 public:
     /*
      * Adds a level to the environment, at the front (will override any existing
@@ -75,6 +117,9 @@ public:
      */
     void insertBack(Level const &level, bool isDefault);
 
+private:
+    void insert(size_t index, Level const &level);
+
 public:
     /*
      * For debugging: print out the contents of all levels.
@@ -85,10 +130,11 @@ private:
     struct InheritanceContext {
         bool valid;
         std::string setting;
-        std::list<Level>::const_iterator it;
+        std::vector<Level>::const_iterator it;
     };
     std::string resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context) const;
-    std::string resolveInheritance(Condition const &condition, InheritanceContext const &context) const;
+    void resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context, std::string *result) const;
+    void resolveInheritance(Condition const &condition, InheritanceContext const &context, std::string *result) const;
     std::string resolveAssignment(Condition const &condition, std::string const &setting) const;
 };
 
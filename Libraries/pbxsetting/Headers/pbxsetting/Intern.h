@@ -0,0 +1,33 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __pbxsetting_Intern_h
+#define __pbxsetting_Intern_h
+
+#include <string>
+
+namespace pbxsetting {
+
+/*
+ * Stores one copy of strings repeated throughout many levels, like setting
+ * names. Interned strings are never freed, so they can be compared by their
+ * address and kept by pointer.
+ */
+class Intern {
+public:
+    /*
+     * The interned copy of a string. Safe to call from multiple threads.
+     */
+    static std::string const *
+    String(std::string const &string);
+};
+
+}
+
+#endif  // !__pbxsetting_Intern_h
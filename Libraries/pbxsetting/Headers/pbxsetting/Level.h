@@ -14,6 +14,8 @@
 #include <pbxsetting/Setting.h>
 #include <pbxsetting/Value.h>
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 #include <memory>
@@ -29,6 +31,12 @@ class Level {
 private:
     std::shared_ptr<std::vector<Setting>> _settings;
 
+private:
+    /*
+     * For each setting name, the indexes of its bindings, last first.
+     */
+    std::shared_ptr<std::unordered_map<std::string, std::vector<size_t>>> _index;
+
 public:
     /*
      * Creates a level with the given settings.
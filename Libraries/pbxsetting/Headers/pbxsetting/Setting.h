@@ -23,9 +23,9 @@ namespace pbxsetting {
  */
 class Setting {
 private:
-    std::string _name;
-    Condition   _condition;
-    Value       _value;
+    std::string const *_name;
+    Condition          _condition;
+    Value              _value;
 
 public:
     Setting(std::string const &name, Condition const &condition, Value const &value);
@@ -36,7 +36,7 @@ public:
      * The name of the setting being set.
      */
     std::string const &name() const
-    { return _name; }
+    { return *_name; }
 
     /*
      * The conditional options set on this build setting binding.
@@ -65,8 +65,93 @@ public:
         { return _value; }
     };
 
+    /*
+     * A token in the flat form of the value: a literal string, or the
+     * start or end of a setting reference. The tokens between the start
+     * and end of a reference make up the name of the referenced setting.
+     *
+     * When a reference's name is a literal, operations on the referenced
+     * value, as in `$(NAME:operation)`, are parsed ahead of time into
+     * operation tokens after the name.
+     */
+    class Token {
+    public:
+        enum class Type {
+            String,
+            Begin,
+            End,
+            Operation,
+        };
+
+        enum class Operation {
+            Unknown,
+            Identifier,
+            C99ExtIdentifier,
+            RFC1034Identifier,
+            Quote,
+            Lower,
+            Upper,
+            StandardizePath,
+            Base,
+            Dir,
+            File,
+            Suffix,
+        };
+
+    private:
+        Type      _type;
+        Operation _operation;
+        size_t    _offset;
+        size_t    _length;
+
+    public:
+        Token(Type type, size_t offset, size_t length);
+        Token(Operation operation, size_t offset, size_t length);
+
+    public:
+        Type type() const
+        { return _type; }
+
+        /*
+         * The operation an operation token applies.
+         */
+        Operation operation() const
+        { return _operation; }
+
+        /*
+         * The range of a string token, or of the name of an operation, in
+         * the value's text.
+         */
+        size_t offset() const
+        { return _offset; }
+        size_t length() const
+        { return _length; }
+
+    public:
+        /*
+         * Finds the operation for its name in a setting reference.
+         */
+        static Operation
+        ParseOperation(std::string const &name);
+    };
+
+private:
+    /*
+     * The tokens and the text of their strings. Never modified once
+     * created, so copies, and references within the value, share it.
+     */
+    struct Storage {
+        std::string        text;
+        std::vector<Token> tokens;
+    };
+
 private:
-    std::vector<Entry> _entries;
+    std::shared_ptr<Storage const> _storage;
+    size_t                         _begin;
+    size_t                         _end;
+
+private:
+    Value(std::shared_ptr<Storage const> const &storage, size_t begin, size_t end);
 
 public:
     Value(std::vector<Entry> const &entries);
@@ -79,10 +164,26 @@ public:
 
 public:
     /*
-     * The top level of the AST that makes up this value.
+     * The top level of the AST that makes up this value. Built from the
+     * tokens when called; evaluating the value should use the tokens.
+     */
+    std::vector<Entry>
+    entries() const;
+
+public:
+    /*
+     * The tokens that make up this value, in order.
+     */
+    Token const *begin() const
+    { return _storage->tokens.data() + _begin; }
+    Token const *end() const
+    { return _storage->tokens.data() + _end; }
+
+    /*
+     * The text string tokens refer to.
      */
-    std::vector<Entry> const &entries() const
-    { return _entries; }
+    std::string const &text() const
+    { return _storage->text; }
 
 public:
     /*
@@ -16,6 +16,8 @@
 #include <pbxsetting/Value.h>
 
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <ext/optional>
 
@@ -83,6 +85,31 @@ public:
         { return _config; }
     };
 
+public:
+    /*
+     * Parsed config files, so a file loaded many times, like a base config
+     * included by many others, is only read and parsed once. A file is parsed
+     * again if it changed. Includes are loaded each time, since their paths
+     * can depend on the environment. Not safe to use from multiple threads.
+     */
+    class Cache {
+    private:
+        struct File {
+            uint64_t           modificationTime;
+            std::vector<Entry> contents;
+        };
+
+    private:
+        std::unordered_map<std::string, File> _files;
+
+    public:
+        Cache();
+        ~Cache();
+
+    private:
+        friend class Config;
+    };
+
 private:
     std::string        _path;
     std::vector<Entry> _contents;
@@ -112,10 +139,11 @@ public:
 
 public:
     /*
-     * Load a config from a file in a filesystem.
+     * Load a config from a file in a filesystem. If there's a cache, files
+     * already parsed into it, including included files, aren't parsed again.
      */
     static ext::optional<Config>
-    Load(libutil::Filesystem const *filesystem, Environment const &environment, std::string const &path);
+    Load(libutil::Filesystem const *filesystem, Environment const &environment, std::string const &path, Cache *cache = nullptr);
 };
 
 } }
@@ -8,15 +8,31 @@
  */
 
 #include <pbxsetting/Condition.h>
+#include <pbxsetting/Intern.h>
 #include <libutil/Wildcard.h>
 
+#include <algorithm>
+
 using pbxsetting::Condition;
+using pbxsetting::Intern;
 using libutil::Wildcard;
 
 Condition::
-Condition(std::unordered_map<std::string, std::string> const &values) :
-    _values(values)
+Condition(std::unordered_map<std::string, std::string> const &values)
 {
+    if (values.empty()) {
+        /* Never destroyed, so empty conditions can always share it. */
+        static std::shared_ptr<Values const> *empty = new std::shared_ptr<Values const>(std::make_shared<Values>());
+        _values = *empty;
+    } else {
+        std::shared_ptr<Values> shared = std::make_shared<Values>();
+        shared->values = values;
+        for (auto const &entry : values) {
+            bool wildcard = (entry.second.find_first_of("*[") != std::string::npos);
+            shared->keys.push_back({ Intern::String(entry.first), Intern::String(entry.second), wildcard });
+        }
+        _values = shared;
+    }
 }
 
 Condition::
@@ -27,14 +43,16 @@ Condition::
 bool Condition::
 match(Condition const &condition) const
 {
-    auto OV = condition._values;
-    for (auto const &TE : _values) {
-        auto OE = OV.find(TE.first);
-        if (OE == OV.end()) {
+    for (Key const &key : _values->keys) {
+        /* There are only ever a few keys, so search them in order. */
+        auto it = std::find_if(condition._values->keys.begin(), condition._values->keys.end(), [&key](Key const &other) {
+            return other.name == key.name;
+        });
+        if (it == condition._values->keys.end()) {
             return false;
         }
 
-        if (!Wildcard::Match(TE.second, OE->second)) {
+        if (key.wildcard ? !Wildcard::Match(*key.value, *it->value) : key.value != it->value) {
             return false;
         }
     }
@@ -9,9 +9,11 @@
 
 #include <pbxsetting/Environment.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Hash.h>
+#include <libutil/Statistic.h>
 
 #include <algorithm>
-#include <sstream>
+#include <map>
 
 using pbxsetting::Environment;
 using pbxsetting::Level;
@@ -19,175 +21,263 @@ using pbxsetting::Condition;
 using pbxsetting::Setting;
 using pbxsetting::Value;
 using libutil::FSUtil;
+using libutil::Hash;
+using libutil::Statistic;
+
+static Statistic ResolveCount("pbxsetting", "Resolve setting");
+static Statistic ResolveLookups("pbxsetting", "Resolve setting cache lookups");
+static Statistic ResolveHits("pbxsetting", "Resolve setting cache hits", &ResolveLookups);
 
 Environment::
 Environment() :
-    _offset(0)
+    _levels(std::make_shared<std::vector<Level>>()),
+    _offset(0),
+    _cache (std::make_shared<Cache>())
 {
 }
 
-static std::string
-ProcessOperation(std::string const &value, std::string const &operation)
+static void
+ProcessOperation(std::string *value, Value::Token::Operation operation, std::string const &name)
 {
     const std::string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
     const std::string digits = "0123456789";
 
-    if (operation == "identifier" || operation == "c99extidentifier") {
-        // TODO(grp): Support c99extidentifier correctly. Requires Unicode handling.
+    switch (operation) {
+        case Value::Token::Operation::Identifier:
+        case Value::Token::Operation::C99ExtIdentifier: {
+            // TODO(grp): Support c99extidentifier correctly. Requires Unicode handling.
 
-        const std::string begin = alphabet + "_";
-        const std::string subsequent = begin + digits;
+            const std::string begin = alphabet + "_";
+            const std::string subsequent = begin + digits;
 
-        std::string result = value;
-        std::string::size_type offset = result.find_first_not_of(begin);
-        while (offset != std::string::npos) {
-            result[offset] = '_';
-            offset = result.find_first_not_of(subsequent, offset);
+            std::string::size_type offset = value->find_first_not_of(begin);
+            while (offset != std::string::npos) {
+                (*value)[offset] = '_';
+                offset = value->find_first_not_of(subsequent, offset);
+            }
+            break;
         }
-
-        return result;
-    } else if (operation == "rfc1034identifier") {
-        const std::string begin = alphabet;
-        const std::string subsequent = alphabet + digits + "-";
-        const std::string end = alphabet + digits;
-
-        std::string result = value;
-        for (std::string::iterator it = result.begin(), prev = result.end(), next = (it == result.end() ? it : std::next(it)); it != result.end(); prev = it, ++it, next = (it == result.end() ? it : std::next(it))) {
-            // Cannot start or end with a dot.
-            if (prev == result.end() || next == result.end()) {
-                if (*it == '.') {
-                    *it = '-';
+        case Value::Token::Operation::RFC1034Identifier: {
+            const std::string begin = alphabet;
+            const std::string subsequent = alphabet + digits + "-";
+            const std::string end = alphabet + digits;
+
+            std::string &result = *value;
+            for (std::string::iterator it = result.begin(), prev = result.end(), next = (it == result.end() ? it : std::next(it)); it != result.end(); prev = it, ++it, next = (it == result.end() ? it : std::next(it))) {
+                // Cannot start or end with a dot.
+                if (prev == result.end() || next == result.end()) {
+                    if (*it == '.') {
+                        *it = '-';
+                    }
                 }
-            }
 
-            // Cannot have digit or hyphen after dot, or hyphen before dot.
-            if (prev == result.end() || *prev == '.') {
-                if (begin.find(*it) == std::string::npos) {
-                    *it = '-';
-                }
-            } else if (next != result.end() && *next == '.') {
-                if (subsequent.find(*it) == std::string::npos) {
-                    *it = '-';
-                }
-            } else {
-                if (end.find(*it) == std::string::npos) {
-                    *it = '-';
+                // Cannot have digit or hyphen after dot, or hyphen before dot.
+                if (prev == result.end() || *prev == '.') {
+                    if (begin.find(*it) == std::string::npos) {
+                        *it = '-';
+                    }
+                } else if (next != result.end() && *next == '.') {
+                    if (subsequent.find(*it) == std::string::npos) {
+                        *it = '-';
+                    }
+                } else {
+                    if (end.find(*it) == std::string::npos) {
+                        *it = '-';
+                    }
                 }
             }
+            break;
         }
-
-        return result;
-    } else if (operation == "quote") {
-        // FIXME(grp): This is (probably) valid, but not necessarily compatible. Algorithm from Python's shlex.quote().
-        if (value.find_first_not_of(alphabet + digits + "@%_-+=:,./") == std::string::npos) {
-            return value;
-        } else {
-            std::string result = value;
-            std::string::size_type offset = 0;
-            while ((offset = result.find("'", offset)) != std::string::npos) {
-                result.replace(offset, 1, "'\"'\"'");
-                offset += 5;
+        case Value::Token::Operation::Quote: {
+            // FIXME(grp): This is (probably) valid, but not necessarily compatible. Algorithm from Python's shlex.quote().
+            if (value->find_first_not_of(alphabet + digits + "@%_-+=:,./") != std::string::npos) {
+                std::string::size_type offset = 0;
+                while ((offset = value->find("'", offset)) != std::string::npos) {
+                    value->replace(offset, 1, "'\"'\"'");
+                    offset += 5;
+                }
+                *value = "'" + *value + "'";
             }
-            return "'" + result + "'";
+            break;
+        }
+        case Value::Token::Operation::Lower: {
+            std::transform(value->begin(), value->end(), value->begin(), ::tolower);
+            break;
+        }
+        case Value::Token::Operation::Upper: {
+            std::transform(value->begin(), value->end(), value->begin(), ::toupper);
+            break;
+        }
+        case Value::Token::Operation::StandardizePath: {
+            *value = FSUtil::NormalizePath(*value);
+            break;
+        }
+        case Value::Token::Operation::Base: {
+            *value = FSUtil::GetBaseNameWithoutExtension(*value);
+            break;
+        }
+        case Value::Token::Operation::Dir: {
+            *value = FSUtil::GetDirectoryName(*value);
+            break;
+        }
+        case Value::Token::Operation::File: {
+            *value = FSUtil::GetBaseName(*value);
+            break;
+        }
+        case Value::Token::Operation::Suffix: {
+            *value = "." + FSUtil::GetFileExtension(*value);
+            break;
+        }
+        case Value::Token::Operation::Unknown: {
+            fprintf(stderr, "warning: unknown build setting operation '%s'\n", name.c_str());
+            break;
         }
-    } else if (operation == "lower") {
-        std::string result = value;
-        std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-        return result;
-    } else if (operation == "upper") {
-        std::string result = value;
-        std::transform(result.begin(), result.end(), result.begin(), ::toupper);
-        return result;
-    } else if (operation == "standardizepath") {
-        return FSUtil::NormalizePath(value);
-    } else if (operation == "base") {
-        return FSUtil::GetBaseNameWithoutExtension(value);
-    } else if (operation == "dir") {
-        return FSUtil::GetDirectoryName(value);
-    } else if (operation == "file") {
-        return FSUtil::GetBaseName(value);
-    } else if (operation == "suffix") {
-        return "." + FSUtil::GetFileExtension(value);
-    } else {
-        fprintf(stderr, "warning: unknown build setting operation '%s'\n", operation.c_str());
-        return value;
     }
 }
 
+/*
+ * A setting reference being evaluated: its name so far, and the operations
+ * parsed out of it ahead of time, if any.
+ */
+namespace {
+
+struct Reference {
+    std::string                       name;
+    std::vector<Value::Token const *> operations;
+};
+
+}
+
 std::string Environment::
 resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context) const
 {
     std::string result;
-    for (auto const &entry : value.entries()) {
-        switch (entry.type()) {
-            case Value::Entry::Type::String: {
-                result += *entry.string();
+    resolveValue(condition, value, context, &result);
+    return result;
+}
+
+void Environment::
+resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context, std::string *result) const
+{
+    /*
+     * Walk the tokens in order. Each reference collects its name until it
+     * ends, then is replaced by the value of that setting. Everything else
+     * is appended directly to the result.
+     */
+    std::vector<Reference> references;
+    for (Value::Token const &token : value) {
+        std::string *output = (references.empty() ? result : &references.back().name);
+
+        switch (token.type()) {
+            case Value::Token::Type::String: {
+                output->append(value.text(), token.offset(), token.length());
                 break;
             }
-            case Value::Entry::Type::Value: {
-                std::string resolved = resolveValue(condition, *entry.value(), context);
-                if (context.valid && (resolved == context.setting || resolved == "inherited")) {
-                    result += resolveInheritance(condition, context);
+            case Value::Token::Type::Operation: {
+                references.back().operations.push_back(&token);
+                break;
+            }
+            case Value::Token::Type::Begin: {
+                references.push_back(Reference());
+                break;
+            }
+            case Value::Token::Type::End: {
+                Reference reference = std::move(references.back());
+                references.pop_back();
+
+                output = (references.empty() ? result : &references.back().name);
+                if (context.valid && reference.operations.empty() && (reference.name == context.setting || reference.name == "inherited")) {
+                    resolveInheritance(condition, context, output);
+                } else if (!reference.operations.empty()) {
+                    std::string assignment = resolveAssignment(condition, reference.name);
+                    for (Value::Token const *operation : reference.operations) {
+                        /* The name is only needed to warn about it. */
+                        std::string name = (operation->operation() == Value::Token::Operation::Unknown ? value.text().substr(operation->offset(), operation->length()) : std::string());
+                        ProcessOperation(&assignment, operation->operation(), name);
+                    }
+                    output->append(assignment);
                 } else {
-                    std::string setting = resolved;
-
-                    std::string::size_type colon = resolved.find(':');
-                    if (colon != std::string::npos) {
-                        setting = resolved.substr(0, colon);
+                    /* Names only known once resolved can still have operations. */
+                    std::string::size_type colon = reference.name.find(':');
+                    if (colon == std::string::npos) {
+                        output->append(resolveAssignment(condition, reference.name));
+                        break;
                     }
 
-                    std::string value = resolveAssignment(condition, setting);
+                    std::string assignment = resolveAssignment(condition, reference.name.substr(0, colon));
 
                     while (colon != std::string::npos) {
-                        std::string::size_type next = resolved.find(':', colon + 1);
+                        std::string::size_type next = reference.name.find(':', colon + 1);
 
-                        std::string operation = resolved.substr(colon + 1, next == std::string::npos ? next : next - colon - 1);
-                        value = ProcessOperation(value, operation);
+                        std::string operation = reference.name.substr(colon + 1, next == std::string::npos ? next : next - colon - 1);
+                        ProcessOperation(&assignment, Value::Token::ParseOperation(operation), operation);
 
                         colon = next;
                     }
 
-                    result += value;
+                    output->append(assignment);
                 }
                 break;
             }
         }
     }
-    return result;
 }
 
-std::string Environment::
-resolveInheritance(Condition const &condition, InheritanceContext const &context) const
+void Environment::
+resolveInheritance(Condition const &condition, InheritanceContext const &context, std::string *result) const
 {
     InheritanceContext ctx = context;
-    for (++ctx.it; ctx.it != _levels.end(); ++ctx.it) {
-        auto result = ctx.it->get(ctx.setting, condition);
-        if (result.first) {
-            return resolveValue(condition, result.second, ctx);
+    for (++ctx.it; ctx.it != _levels->end(); ++ctx.it) {
+        auto value = ctx.it->get(ctx.setting, condition);
+        if (value.first) {
+            resolveValue(condition, value.second, ctx, result);
+            return;
         }
     }
-
-    return "";
 }
 
 std::string Environment::
 resolveAssignment(Condition const &condition, std::string const &setting) const
 {
-    InheritanceContext context = { .valid = true, .setting = setting };
+    if (_cache != nullptr) {
+        ResolveLookups.increment();
+        std::lock_guard<std::mutex> lock(_cache->mutex);
+
+        auto values = _cache->values.find(condition);
+        if (values != _cache->values.end()) {
+            auto value = values->second.find(setting);
+            if (value != values->second.end()) {
+                ResolveHits.increment();
+                return value->second;
+            }
+        }
+    }
+
+    std::string value;
+    bool found = false;
 
-    for (context.it = _levels.begin(); context.it != _levels.end(); ++context.it) {
+    InheritanceContext context = { .valid = true, .setting = setting };
+    for (context.it = _levels->begin(); context.it != _levels->end(); ++context.it) {
         Level const &level = *context.it;
         auto result = level.get(setting, condition);
         if (result.first) {
-            return resolveValue(condition, result.second, context);
+            resolveValue(condition, result.second, context, &value);
+            found = true;
+            break;
         }
     }
 
-    if (condition.values().empty()) {
-        return "";
-    } else {
-        return resolveAssignment(Condition::Empty(), setting);
+    if (!found && !condition.values().empty()) {
+        value = resolveAssignment(Condition::Empty(), setting);
     }
+
+    /* Not locked while resolving, since resolving can resolve other settings. */
+    if (_cache != nullptr) {
+        std::lock_guard<std::mutex> lock(_cache->mutex);
+        _cache->values[condition][setting] = value;
+    }
+
+    return value;
 }
 
 std::string Environment::
@@ -205,6 +295,7 @@ expand(Value const &value) const
 std::string Environment::
 resolve(std::string const &setting, Condition const &condition) const
 {
+    ResolveCount.increment();
     return resolveAssignment(condition, setting);
 }
 
@@ -216,12 +307,36 @@ resolve(std::string const &setting) const
 
 std::unordered_map<std::string, std::string> Environment::
 computeValues(Condition const &condition) const
+{
+    if (_cache != nullptr) {
+        std::lock_guard<std::mutex> lock(_cache->mutex);
+
+        auto computed = _cache->computed.find(condition);
+        if (computed != _cache->computed.end()) {
+            return computed->second;
+        }
+    }
+
+    std::unordered_map<std::string, std::string> values = computeValues(condition, [](std::string const &name) {
+        return true;
+    });
+
+    if (_cache != nullptr) {
+        std::lock_guard<std::mutex> lock(_cache->mutex);
+        _cache->computed.insert({ condition, values });
+    }
+
+    return values;
+}
+
+std::unordered_map<std::string, std::string> Environment::
+computeValues(Condition const &condition, std::function<bool(std::string const &)> const &filter) const
 {
     std::unordered_map<std::string, std::string> values;
 
-    for (Level const &level : _levels) {
+    for (Level const &level : *_levels) {
         for (Setting const &setting : level.settings()) {
-            if (values.find(setting.name()) == values.end()) {
+            if (values.find(setting.name()) == values.end() && filter(setting.name())) {
                 values[setting.name()] = resolve(setting.name(), condition);
             }
         }
@@ -230,14 +345,59 @@ computeValues(Condition const &condition) const
     return values;
 }
 
+std::string Environment::
+fingerprint() const
+{
+    Hash hash;
+
+    /* Separate each part so adjacent parts can't run together. */
+    auto append = [&hash](std::string const &value) {
+        hash.update(value.data(), value.size() + 1);
+    };
+
+    for (Level const &level : *_levels) {
+        append("<level>");
+
+        for (Setting const &setting : level.settings()) {
+            append(setting.name());
+
+            /* Condition order doesn't matter. */
+            std::map<std::string, std::string> condition = std::map<std::string, std::string>(setting.condition().values().begin(), setting.condition().values().end());
+            for (auto const &entry : condition) {
+                append(entry.first);
+                append(entry.second);
+            }
+            append("=");
+
+            append(setting.value().raw());
+        }
+    }
+
+    return hash.hex();
+}
+
+void Environment::
+insert(size_t index, Level const &level)
+{
+    /* Other copies still use the existing levels and values. */
+    std::shared_ptr<std::vector<Level>> levels = std::make_shared<std::vector<Level>>();
+    levels->reserve(_levels->size() + 1);
+    levels->insert(levels->end(), _levels->begin(), std::next(_levels->begin(), index));
+    levels->push_back(level);
+    levels->insert(levels->end(), std::next(_levels->begin(), index), _levels->end());
+
+    _levels = levels;
+    _cache = std::make_shared<Cache>();
+}
+
 void Environment::
 insertFront(Level const &level, bool isDefault)
 {
     if (!isDefault) {
-        _levels.push_front(level);
+        insert(0, level);
         ++_offset;
     } else {
-        _levels.insert(std::next(_levels.begin(), _offset), level);
+        insert(_offset, level);
     }
 }
 
@@ -245,10 +405,10 @@ void Environment::
 insertBack(Level const &level, bool isDefault)
 {
     if (!isDefault) {
-        _levels.insert(std::next(_levels.begin(), _offset), level);
+        insert(_offset, level);
         ++_offset;
     } else {
-        _levels.push_back(level);
+        insert(_levels->size(), level);
     }
 }
 
@@ -257,7 +417,7 @@ dump() const
 {
     size_t offset = 0;
 
-    for (Level const &level : _levels) {
+    for (Level const &level : *_levels) {
         if (offset == _offset) {
             printf("=== Default Levels ===\n");
         } else if (offset == 0) {
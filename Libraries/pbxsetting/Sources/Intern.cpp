@@ -0,0 +1,27 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <pbxsetting/Intern.h>
+
+#include <mutex>
+#include <unordered_set>
+
+using pbxsetting::Intern;
+
+std::string const *Intern::
+String(std::string const &string)
+{
+    /* Never destroyed, so interned strings outlive everything using them. */
+    static std::mutex *mutex = new std::mutex();
+    static std::unordered_set<std::string> *strings = new std::unordered_set<std::string>();
+
+    /* Elements in a set don't move, even when it grows. */
+    std::lock_guard<std::mutex> lock(*mutex);
+    return &*strings->insert(string).first;
+}
@@ -16,8 +16,12 @@ using pbxsetting::Value;
 
 Level::
 Level(std::vector<Setting> const &settings) :
-    _settings(std::make_shared<std::vector<Setting>>(settings))
+    _settings(std::make_shared<std::vector<Setting>>(settings)),
+    _index   (std::make_shared<std::unordered_map<std::string, std::vector<size_t>>>())
 {
+    for (size_t i = _settings->size(); i > 0; --i) {
+        (*_index)[(*_settings)[i - 1].name()].push_back(i - 1);
+    }
 }
 
 Level::
@@ -28,9 +32,14 @@ Level::
 std::pair<bool, Value> Level::
 get(std::string const &setting, Condition const &condition) const
 {
-    for (auto it = _settings->rbegin(); it != _settings->rend(); ++it) {
-        if (it->match(setting, condition)) {
-            return std::make_pair(true, it->value());
+    /* Later bindings override earlier ones, so the index is last first. */
+    auto it = _index->find(setting);
+    if (it != _index->end()) {
+        for (size_t index : it->second) {
+            Setting const &binding = (*_settings)[index];
+            if (binding.condition().match(condition)) {
+                return std::make_pair(true, binding.value());
+            }
         }
     }
 
@@ -9,16 +9,18 @@
 
 #include <pbxsetting/Setting.h>
 #include <pbxsetting/Condition.h>
+#include <pbxsetting/Intern.h>
 #include <libutil/Base.h>
 
 using pbxsetting::Setting;
 using pbxsetting::Condition;
+using pbxsetting::Intern;
 
 Setting::
 Setting(std::string const &name, Condition const &condition, Value const &value) :
-    _name(name),
+    _name     (Intern::String(name)),
     _condition(condition),
-    _value(value)
+    _value    (value)
 {
 }
 
@@ -30,7 +32,7 @@ Setting::
 bool Setting::
 match(std::string const &name, Condition const &condition) const
 {
-    return _name == name && _condition.match(condition);
+    return *_name == name && _condition.match(condition);
 }
 
 Setting Setting::
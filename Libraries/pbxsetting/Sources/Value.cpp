@@ -54,29 +54,228 @@ operator!=(Entry const &entry) const
     return !(*this == entry);
 }
 
+Value::Token::
+Token(Type type, size_t offset, size_t length) :
+    _type     (type),
+    _operation(Operation::Unknown),
+    _offset   (offset),
+    _length   (length)
+{
+}
+
+Value::Token::
+Token(Operation operation, size_t offset, size_t length) :
+    _type     (Type::Operation),
+    _operation(operation),
+    _offset   (offset),
+    _length   (length)
+{
+}
+
+Value::Token::Operation Value::Token::
+ParseOperation(std::string const &name)
+{
+    if (name == "identifier") {
+        return Operation::Identifier;
+    } else if (name == "c99extidentifier") {
+        return Operation::C99ExtIdentifier;
+    } else if (name == "rfc1034identifier") {
+        return Operation::RFC1034Identifier;
+    } else if (name == "quote") {
+        return Operation::Quote;
+    } else if (name == "lower") {
+        return Operation::Lower;
+    } else if (name == "upper") {
+        return Operation::Upper;
+    } else if (name == "standardizepath") {
+        return Operation::StandardizePath;
+    } else if (name == "base") {
+        return Operation::Base;
+    } else if (name == "dir") {
+        return Operation::Dir;
+    } else if (name == "file") {
+        return Operation::File;
+    } else if (name == "suffix") {
+        return Operation::Suffix;
+    } else {
+        return Operation::Unknown;
+    }
+}
+
+/*
+ * Adds a string token. If merging, a string directly after another string
+ * extends it instead, since its text is the last text added.
+ */
+static void
+AppendString(std::string *text, std::vector<Value::Token> *tokens, std::string const &source, size_t offset, size_t length, bool merge)
+{
+    if (merge && !tokens->empty() && tokens->back().type() == Value::Token::Type::String) {
+        Value::Token const &last = tokens->back();
+        tokens->back() = Value::Token(Value::Token::Type::String, last.offset(), last.length() + length);
+    } else {
+        tokens->push_back(Value::Token(Value::Token::Type::String, text->size(), length));
+    }
+
+    text->append(source, offset, length);
+}
+
+static void
+AppendMarker(std::string *text, std::vector<Value::Token> *tokens, Value::Token::Type type)
+{
+    tokens->push_back(Value::Token(type, text->size(), 0));
+}
+
+/*
+ * Splits the operations out of a reference's name, if the name is only a
+ * literal string. Other names can only be split once they're resolved.
+ */
+static void
+SplitOperations(std::string const *text, std::vector<Value::Token> *tokens, size_t begin)
+{
+    if (tokens->size() != begin + 2 || tokens->back().type() != Value::Token::Type::String) {
+        return;
+    }
+
+    Value::Token name = tokens->back();
+    size_t end = name.offset() + name.length();
+    size_t colon = text->find(':', name.offset());
+    if (colon == std::string::npos || colon >= end) {
+        return;
+    }
+
+    tokens->back() = Value::Token(Value::Token::Type::String, name.offset(), colon - name.offset());
+
+    while (colon < end) {
+        size_t next = text->find(':', colon + 1);
+        if (next == std::string::npos || next > end) {
+            next = end;
+        }
+
+        size_t offset = colon + 1;
+        Value::Token::Operation operation = Value::Token::ParseOperation(text->substr(offset, next - offset));
+        tokens->push_back(Value::Token(operation, offset, next - offset));
+
+        colon = next;
+    }
+}
+
+static void
+AppendTokens(std::string *text, std::vector<Value::Token> *tokens, Value const &value, bool merge)
+{
+    for (Value::Token const &token : value) {
+        if (token.type() == Value::Token::Type::String) {
+            AppendString(text, tokens, value.text(), token.offset(), token.length(), merge);
+        } else if (token.type() == Value::Token::Type::Operation) {
+            tokens->push_back(Value::Token(token.operation(), text->size(), token.length()));
+            text->append(value.text(), token.offset(), token.length());
+        } else {
+            AppendMarker(text, tokens, token.type());
+        }
+
+        /* Only the first token can continue what's already there. */
+        merge = false;
+    }
+}
+
+static void
+AppendEntries(std::string *text, std::vector<Value::Token> *tokens, std::vector<Value::Entry> const &entries)
+{
+    for (Value::Entry const &entry : entries) {
+        switch (entry.type()) {
+            case Value::Entry::Type::String: {
+                AppendString(text, tokens, *entry.string(), 0, entry.string()->size(), false);
+                break;
+            }
+            case Value::Entry::Type::Value: {
+                size_t begin = tokens->size();
+                AppendMarker(text, tokens, Value::Token::Type::Begin);
+                AppendTokens(text, tokens, *entry.value(), false);
+                SplitOperations(text, tokens, begin);
+                AppendMarker(text, tokens, Value::Token::Type::End);
+                break;
+            }
+        }
+    }
+}
+
 Value::
-Value(std::vector<Entry> const &entries) :
-    _entries(entries)
+Value(std::shared_ptr<Storage const> const &storage, size_t begin, size_t end) :
+    _storage(storage),
+    _begin  (begin),
+    _end    (end)
 {
 }
 
+Value::
+Value(std::vector<Entry> const &entries)
+{
+    std::shared_ptr<Storage> storage = std::make_shared<Storage>();
+    AppendEntries(&storage->text, &storage->tokens, entries);
+
+    _storage = storage;
+    _begin = 0;
+    _end = storage->tokens.size();
+}
+
 Value::
 ~Value()
 {
 }
 
+std::vector<Value::Entry> Value::
+entries() const
+{
+    std::vector<Entry> entries;
+
+    for (size_t i = _begin; i < _end; ++i) {
+        Token const &token = _storage->tokens[i];
+        if (token.type() == Token::Type::String) {
+            entries.push_back(Entry(_storage->text.substr(token.offset(), token.length())));
+        } else if (token.type() == Token::Type::Operation) {
+            /* Operations always follow the name they apply to. */
+            std::string name = *entries.back().string() + ":" + _storage->text.substr(token.offset(), token.length());
+            entries.back() = Entry(name);
+        } else if (token.type() == Token::Type::Begin) {
+            /* Find the matching end; the reference shares the tokens. */
+            size_t depth = 1;
+            size_t j = i + 1;
+            for (; j < _end; ++j) {
+                if (_storage->tokens[j].type() == Token::Type::Begin) {
+                    ++depth;
+                } else if (_storage->tokens[j].type() == Token::Type::End && --depth == 0) {
+                    break;
+                }
+            }
+
+            entries.push_back(Entry(std::make_shared<Value>(Value(_storage, i + 1, j))));
+            i = j;
+        }
+    }
+
+    return entries;
+}
+
 std::string Value::
 raw() const
 {
     std::string out;
-    for (Value::Entry const &entry : _entries) {
-        switch (entry.type()) {
-            case Value::Entry::Type::String: {
-                out += *entry.string();
+    for (Token const &token : *this) {
+        switch (token.type()) {
+            case Token::Type::String: {
+                out.append(_storage->text, token.offset(), token.length());
                 break;
             }
-            case Value::Entry::Type::Value: {
-                out += "$(" + entry.value()->raw() + ")";
+            case Token::Type::Begin: {
+                out += "$(";
+                break;
+            }
+            case Token::Type::End: {
+                out += ")";
+                break;
+            }
+            case Token::Type::Operation: {
+                out += ":";
+                out.append(_storage->text, token.offset(), token.length());
                 break;
             }
         }
@@ -87,7 +286,27 @@ raw() const
 bool Value::
 operator==(Value const &rhs) const
 {
-    return _entries == rhs._entries;
+    if (_storage == rhs._storage && _begin == rhs._begin && _end == rhs._end) {
+        return true;
+    }
+
+    if (_end - _begin != rhs._end - rhs._begin) {
+        return false;
+    }
+
+    for (Token const *it = begin(), *rit = rhs.begin(); it != end(); ++it, ++rit) {
+        if (it->type() != rit->type()) {
+            return false;
+        }
+
+        if (it->type() == Token::Type::String || it->type() == Token::Type::Operation) {
+            if (_storage->text.compare(it->offset(), it->length(), rhs._storage->text, rit->offset(), rit->length()) != 0) {
+                return false;
+            }
+        }
+    }
+
+    return true;
 }
 
 bool Value::
@@ -99,26 +318,15 @@ operator!=(Value const &rhs) const
 Value Value::
 operator+(Value const &rhs) const
 {
-    std::vector<Value::Entry> entries;
-    entries.insert(entries.end(), _entries.begin(), _entries.end());
-
-    auto it = rhs.entries().begin();
-    if (!entries.empty() && !rhs.entries().empty()) {
-        if (entries.back().type() == Value::Entry::Type::String && it->type() == Value::Entry::Type::String) {
-            entries.back() = Entry(*entries.back().string() + *it->string());
-            ++it;
-        }
-    }
+    std::shared_ptr<Storage> storage = std::make_shared<Storage>();
+    storage->tokens.reserve((_end - _begin) + (rhs._end - rhs._begin));
 
-    entries.insert(entries.end(), it, rhs.entries().end());
-    return Value(entries);
-}
+    /* Strings where the values meet become one string. */
+    AppendTokens(&storage->text, &storage->tokens, *this, false);
+    AppendTokens(&storage->text, &storage->tokens, rhs, true);
 
-struct ParseResult {
-    bool found;
-    size_t end;
-    Value value;
-};
+    return Value(storage, 0, storage->tokens.size());
+}
 
 enum ValueDelimiter {
     kDelimiterNone,
@@ -127,11 +335,13 @@ enum ValueDelimiter {
     kDelimiterIdentifier,
 };
 
-static ParseResult
-ParseValue(std::string const &value, size_t from, ValueDelimiter end = kDelimiterNone)
+/*
+ * Parses a value into tokens, up to the delimiter. If the delimiter isn't
+ * found, nothing is added and the text is treated as a literal instead.
+ */
+static bool
+ParseValue(std::string const &value, size_t from, ValueDelimiter end, std::string *text, std::vector<Value::Token> *tokens, size_t *parsed)
 {
-    std::vector<Value::Entry> entries;
-
     size_t length;
     size_t search_offset = from;
     size_t append_offset = from;
@@ -164,7 +374,7 @@ ParseValue(std::string const &value, size_t from, ValueDelimiter end = kDelimite
             }
         }
         if (to == std::string::npos) {
-            return { .found = false, .end = from, .value = Value(entries) };
+            return false;
         }
 
         size_t pno = value.find("$(", search_offset);
@@ -195,24 +405,36 @@ ParseValue(std::string const &value, size_t from, ValueDelimiter end = kDelimite
         if (open == std::string::npos || start == kDelimiterNone || open >= to) {
             length = to - append_offset;
             if (length > 0) {
-                entries.push_back(Value::Entry(value.substr(append_offset, length)));
+                AppendString(text, tokens, value, append_offset, length, false);
             }
 
-            return { .found = true, .end = to, .value = Value(entries) };
+            *parsed = to;
+            return true;
         }
 
-        ParseResult result = ParseValue(value, open + openlen, start);
-        if (result.found) {
-            length = open - append_offset;
-            if (length > 0) {
-                entries.push_back(Value::Entry(value.substr(append_offset, length)));
-            }
+        /* Undone if the reference turns out not to be closed. */
+        size_t textSize = text->size();
+        size_t tokenCount = tokens->size();
 
-            entries.push_back(Value::Entry(std::make_shared<Value>(result.value)));
+        length = open - append_offset;
+        if (length > 0) {
+            AppendString(text, tokens, value, append_offset, length, false);
+        }
+
+        size_t begin = tokens->size();
+        AppendMarker(text, tokens, Value::Token::Type::Begin);
+
+        size_t result;
+        if (ParseValue(value, open + openlen, start, text, tokens, &result)) {
+            SplitOperations(text, tokens, begin);
+            AppendMarker(text, tokens, Value::Token::Type::End);
 
-            append_offset = result.end + closelen;
-            search_offset = result.end + closelen;
+            append_offset = result + closelen;
+            search_offset = result + closelen;
         } else {
+            text->resize(textSize);
+            tokens->erase(tokens->begin() + tokenCount, tokens->end());
+
             search_offset += openlen;
         }
     } while (true);
@@ -221,7 +443,12 @@ ParseValue(std::string const &value, size_t from, ValueDelimiter end = kDelimite
 Value Value::
 Parse(std::string const &value)
 {
-    return ParseValue(value, 0).value;
+    std::shared_ptr<Storage> storage = std::make_shared<Storage>();
+
+    size_t parsed;
+    ParseValue(value, 0, kDelimiterNone, &storage->text, &storage->tokens, &parsed);
+
+    return Value(storage, 0, storage->tokens.size());
 }
 
 Value Value::
@@ -231,19 +458,20 @@ String(std::string const &value)
         return Empty();
     }
 
-    return Value({
-        Entry(value),
-    });
+    std::shared_ptr<Storage> storage = std::make_shared<Storage>();
+    AppendString(&storage->text, &storage->tokens, value, 0, value.size(), false);
+    return Value(storage, 0, storage->tokens.size());
 }
 
 Value Value::
 Variable(std::string const &value)
 {
-    return Value({
-        Entry(std::make_shared<Value>(Value({
-            Entry(value),
-        }))),
-    });
+    std::shared_ptr<Storage> storage = std::make_shared<Storage>();
+    AppendMarker(&storage->text, &storage->tokens, Token::Type::Begin);
+    AppendString(&storage->text, &storage->tokens, value, 0, value.size(), false);
+    SplitOperations(&storage->text, &storage->tokens, 0);
+    AppendMarker(&storage->text, &storage->tokens, Token::Type::End);
+    return Value(storage, 0, storage->tokens.size());
 }
 
 Value Value::
@@ -99,24 +99,14 @@ ParseInclude(std::string const &value)
 }
 
 static ext::optional<Config::Entry>
-ParseDirective(Filesystem const *filesystem, Environment const &environment, std::string const &directory, std::string const &line)
+ParseDirective(std::string const &line)
 {
     std::string include = "include";
     if (line.compare(1, 1 + include.size(), include)) {
-        /* Handle include directive. */
+        /* Handle include directive. The included config is loaded later. */
         std::string value = line.substr(1 + include.size());
         if (ext::optional<Value> parsed = ParseInclude(value)) {
-            /* Determine the path on disk. */
-            std::string path = environment.expand(*parsed);
-            path = FSUtil::ResolveRelativePath(path, directory);
-
-            /* Load included config. */
-            if (ext::optional<Config> config = Config::Load(filesystem, environment, path)) {
-                return Config::Entry(*parsed, std::make_shared<Config>(*config));
-            } else {
-                /* Failed to load included config. */
-                return ext::nullopt;
-            }
+            return Config::Entry(*parsed, nullptr);
         } else {
             /* Failed to parse include. */
             return ext::nullopt;
@@ -127,23 +117,18 @@ ParseDirective(Filesystem const *filesystem, Environment const &environment, std
     }
 }
 
-ext::optional<Config> Config::
-Load(Filesystem const *filesystem, Environment const &environment, std::string const &path)
+/*
+ * Parses the contents of a config file. Included configs aren't loaded.
+ */
+static ext::optional<std::vector<Config::Entry>>
+Parse(std::vector<uint8_t> contents)
 {
-    std::string directory = FSUtil::GetDirectoryName(path);
-
-    /* Read in input. */
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, path)) {
-        return ext::nullopt;
-    }
-
     /* Add trailing newline if missing. */
     if (contents.empty() || contents.back() != '\n') {
         contents.push_back('\n');
     }
 
-    std::vector<Entry> entries;
+    std::vector<Config::Entry> entries;
 
     bool slash = false;
     bool comment = false;
@@ -171,7 +156,7 @@ Load(Filesystem const *filesystem, Environment const &environment, std::string c
             if (!line.empty()) {
                 if (line.front() == '#') {
                     /* Parse directive. */
-                    if (ext::optional<Entry> entry = ParseDirective(filesystem, environment, directory, line)) {
+                    if (ext::optional<Config::Entry> entry = ParseDirective(line)) {
                         entries.push_back(*entry);
                     } else {
                         /* Failed to parse directive. */
@@ -189,7 +174,7 @@ Load(Filesystem const *filesystem, Environment const &environment, std::string c
 
                         /* Parse setting value. */
                         if (ext::optional<Setting> setting = Setting::Parse(line)) {
-                            Entry entry = Config::Entry(*setting);
+                            Config::Entry entry = Config::Entry(*setting);
                             entries.push_back(entry);
                         } else {
                             /* Failed to parse setting. */
@@ -207,6 +192,78 @@ Load(Filesystem const *filesystem, Environment const &environment, std::string c
         }
     }
 
-    return Config(path, entries);
+    return entries;
+}
+
+Config::Cache::
+Cache()
+{
 }
 
+Config::Cache::
+~Cache()
+{
+}
+
+ext::optional<Config> Config::
+Load(Filesystem const *filesystem, Environment const &environment, std::string const &path, Cache *cache)
+{
+    std::string directory = FSUtil::GetDirectoryName(path);
+
+    ext::optional<std::vector<Entry>> parsed;
+
+    /* Use the cached contents if the file hasn't changed since. */
+    ext::optional<uint64_t> modificationTime;
+    if (cache != nullptr) {
+        modificationTime = filesystem->modificationTime(path);
+    }
+    if (modificationTime) {
+        auto it = cache->_files.find(path);
+        if (it != cache->_files.end() && it->second.modificationTime == *modificationTime) {
+            parsed = it->second.contents;
+        }
+    }
+
+    if (!parsed) {
+        /* Read in input. */
+        std::vector<uint8_t> contents;
+        if (!filesystem->read(&contents, path)) {
+            return ext::nullopt;
+        }
+
+        parsed = Parse(contents);
+        if (!parsed) {
+            return ext::nullopt;
+        }
+
+        if (modificationTime) {
+            cache->_files[path] = { *modificationTime, *parsed };
+        }
+    }
+
+    std::vector<Entry> entries;
+    for (Entry const &entry : *parsed) {
+        switch (entry.type()) {
+            case Entry::Type::Setting: {
+                entries.push_back(entry);
+                break;
+            }
+            case Entry::Type::Include: {
+                /* Determine the path on disk. */
+                std::string includePath = environment.expand(*entry.path());
+                includePath = FSUtil::ResolveRelativePath(includePath, directory);
+
+                /* Load included config. */
+                if (ext::optional<Config> config = Config::Load(filesystem, environment, includePath, cache)) {
+                    entries.push_back(Config::Entry(*entry.path(), std::make_shared<Config>(*config)));
+                } else {
+                    /* Failed to load included config. */
+                    return ext::nullopt;
+                }
+                break;
+            }
+        }
+    }
+
+    return Config(path, entries);
+}
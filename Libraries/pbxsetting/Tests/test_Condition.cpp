@@ -62,3 +62,17 @@ TEST(Condition, MatchMultiple)
     EXPECT_FALSE(arch_sdk.match(arch));
 }
 
+
+TEST(Condition, MatchEmpty)
+{
+    Condition arch = Condition(std::unordered_map<std::string, std::string>({ { "arch", "armv7" } }));
+    EXPECT_TRUE(Condition::Empty().match(arch));
+    EXPECT_TRUE(Condition::Empty().match(Condition::Empty()));
+    EXPECT_FALSE(arch.match(Condition::Empty()));
+
+    /* Values that differ only in a prefix don't match without a wildcard. */
+    Condition sdk = Condition(std::unordered_map<std::string, std::string>({ { "sdk", "iphoneos" } }));
+    Condition sdk_version = Condition(std::unordered_map<std::string, std::string>({ { "sdk", "iphoneos10.0" } }));
+    EXPECT_FALSE(sdk.match(sdk_version));
+    EXPECT_TRUE(sdk.match(sdk));
+}
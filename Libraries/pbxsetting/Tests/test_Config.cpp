@@ -95,3 +95,28 @@ TEST(Config, Include)
     EXPECT_EQ(config->contents().at(0).config()->contents().at(0).setting()->value(), Value::String("VALUE"));
 }
 
+
+TEST(Config, Cache)
+{
+    Environment environment = Environment();
+    MemoryFilesystem filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("common.xcconfig", Contents("NAME = VALUE")),
+        MemoryFilesystem::Entry::File("first.xcconfig", Contents("#include \"common.xcconfig\"")),
+        MemoryFilesystem::Entry::File("second.xcconfig", Contents("#include \"common.xcconfig\"\nOTHER = OTHER")),
+    });
+
+    Config::Cache cache;
+    auto first = Config::Load(&filesystem, environment, "/first.xcconfig", &cache);
+    ASSERT_NE(first, ext::nullopt);
+    auto second = Config::Load(&filesystem, environment, "/second.xcconfig", &cache);
+    ASSERT_NE(second, ext::nullopt);
+    ASSERT_EQ(second->level().settings().size(), 2);
+    EXPECT_EQ(second->level().settings().at(0).value(), Value::String("VALUE"));
+
+    /* Changed files are parsed again. */
+    ASSERT_TRUE(filesystem.write(Contents("NAME = CHANGED"), "/common.xcconfig"));
+    auto changed = Config::Load(&filesystem, environment, "/first.xcconfig", &cache);
+    ASSERT_NE(changed, ext::nullopt);
+    ASSERT_EQ(changed->level().settings().size(), 1);
+    EXPECT_EQ(changed->level().settings().at(0).value(), Value::String("CHANGED"));
+}
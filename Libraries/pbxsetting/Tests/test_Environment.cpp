@@ -1,6 +1,7 @@
 
 #include <gtest/gtest.h>
 #include <pbxsetting/Environment.h>
+#include <libutil/Parallel.h>
 
 using pbxsetting::Environment;
 using pbxsetting::Level;
@@ -139,6 +140,20 @@ TEST(Environment, Operations)
     EXPECT_EQ(environment.resolve("MULTIPLE"), "___HELLO__");
 }
 
+TEST(Environment, ResolvedOperations)
+{
+    Environment environment;
+    environment.insertBack(Level({
+        Setting::Parse("NAME", "PATH"),
+        Setting::Parse("OPERATION", "file"),
+        Setting::Parse("RESOLVED_NAME", "$($(NAME):base)"),
+        Setting::Parse("RESOLVED_OPERATION", "$(PATH:$(OPERATION))"),
+        Setting::Parse("PATH", "/path/to/file.ext"),
+    }), false);
+    EXPECT_EQ(environment.resolve("RESOLVED_NAME"), "file");
+    EXPECT_EQ(environment.resolve("RESOLVED_OPERATION"), "file.ext");
+}
+
 TEST(Environment, Value)
 {
     Environment env;
@@ -172,3 +187,119 @@ TEST(Environment, Default)
     EXPECT_EQ(env.resolve("THREE"), "3");
 }
 
+
+TEST(Environment, InsertAfterResolve)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("ONE", "one"),
+        Setting::Parse("BOTH", "$(ONE)-$(TWO)"),
+    }), false);
+    EXPECT_EQ(env.resolve("BOTH"), "one-");
+
+    Environment copy = Environment(env);
+    EXPECT_EQ(copy.resolve("BOTH"), "one-");
+
+    /* Inserting a level changes what later resolves return. */
+    env.insertFront(Level({
+        Setting::Parse("ONE", "1"),
+    }), false);
+    env.insertBack(Level({
+        Setting::Parse("TWO", "two"),
+    }), false);
+    EXPECT_EQ(env.resolve("BOTH"), "1-two");
+
+    /* But not what copies made before resolve. */
+    EXPECT_EQ(copy.resolve("BOTH"), "one-");
+}
+
+TEST(Environment, ComputeValues)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("ONE", "one"),
+        Setting::Parse("TWO", "$(ONE)-two"),
+    }), false);
+    env.insertBack(Level({
+        Setting::Parse("ONE", "1"),
+        Setting::Parse("THREE", "three"),
+    }), false);
+
+    std::unordered_map<std::string, std::string> all = env.computeValues(pbxsetting::Condition::Empty());
+    EXPECT_EQ(3, all.size());
+    EXPECT_EQ("one", all["ONE"]);
+    EXPECT_EQ("one-two", all["TWO"]);
+    EXPECT_EQ("three", all["THREE"]);
+
+    std::unordered_map<std::string, std::string> filtered = env.computeValues(pbxsetting::Condition::Empty(), [](std::string const &name) {
+        return name != "ONE";
+    });
+    EXPECT_EQ(2, filtered.size());
+    EXPECT_EQ("one-two", filtered["TWO"]);
+
+    /* Computed values are recomputed once a level is added. */
+    env.insertFront(Level({
+        Setting::Parse("FOUR", "four"),
+    }), false);
+    EXPECT_EQ(4, env.computeValues(pbxsetting::Condition::Empty()).size());
+}
+
+TEST(Environment, Fingerprint)
+{
+    Environment first;
+    first.insertBack(Level({
+        Setting::Parse("ONE", "one"),
+        *Setting::Parse("TWO[arch=arm64] = two"),
+    }), false);
+
+    Environment second;
+    second.insertBack(Level({
+        Setting::Parse("ONE", "one"),
+        *Setting::Parse("TWO[arch=arm64] = two"),
+    }), false);
+    EXPECT_EQ(first.fingerprint(), second.fingerprint());
+
+    /* Changing a value, condition, or level changes it. */
+    Environment value = Environment(second);
+    value.insertBack(Level({ Setting::Parse("THREE", "three") }), false);
+    EXPECT_NE(first.fingerprint(), value.fingerprint());
+
+    Environment condition;
+    condition.insertBack(Level({
+        Setting::Parse("ONE", "one"),
+        *Setting::Parse("TWO[arch=x86_64] = two"),
+    }), false);
+    EXPECT_NE(first.fingerprint(), condition.fingerprint());
+
+    Environment split;
+    split.insertBack(Level({ Setting::Parse("ONE", "one") }), false);
+    split.insertBack(Level({ *Setting::Parse("TWO[arch=arm64] = two") }), false);
+    EXPECT_NE(first.fingerprint(), split.fingerprint());
+}
+
+TEST(Environment, ResolveConcurrently)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("ONE", "one"),
+        Setting::Parse("TWO", "$(ONE)-two"),
+        Setting::Parse("THREE", "$(TWO)-three"),
+    }), false);
+
+    /* Copies share the resolved values; each thread derives its own. */
+    std::vector<std::string> shared = std::vector<std::string>(64);
+    std::vector<std::string> derived = std::vector<std::string>(64);
+    libutil::Parallel::For(shared.size(), [&](size_t index) {
+        Environment copy = Environment(env);
+        shared[index] = copy.resolve("THREE");
+
+        copy.insertFront(Level({ Setting::Parse("ONE", std::to_string(index)) }), false);
+        derived[index] = copy.resolve("THREE");
+    });
+
+    for (size_t i = 0; i < shared.size(); ++i) {
+        EXPECT_EQ("one-two-three", shared[i]);
+        EXPECT_EQ(std::to_string(i) + "-two-three", derived[i]);
+    }
+    EXPECT_EQ("one-two-three", env.resolve("THREE"));
+}
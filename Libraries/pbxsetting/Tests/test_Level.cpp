@@ -0,0 +1,56 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxsetting/Level.h>
+
+using pbxsetting::Level;
+using pbxsetting::Condition;
+using pbxsetting::Setting;
+using pbxsetting::Value;
+
+TEST(Level, Get)
+{
+    Level level = Level({
+        Setting::Create("A", "first"),
+        Setting::Create("B", "other"),
+        Setting::Create("A", "second"),
+    });
+
+    /* Later bindings win. */
+    std::pair<bool, Value> a = level.get("A", Condition::Empty());
+    EXPECT_TRUE(a.first);
+    EXPECT_EQ(Value::String("second"), a.second);
+
+    std::pair<bool, Value> b = level.get("B", Condition::Empty());
+    EXPECT_TRUE(b.first);
+    EXPECT_EQ(Value::String("other"), b.second);
+
+    EXPECT_FALSE(level.get("C", Condition::Empty()).first);
+}
+
+TEST(Level, GetCondition)
+{
+    Level level = Level({
+        Setting::Create("A", "unconditional"),
+        *Setting::Parse("A[arch=arm64] = arm64"),
+        *Setting::Parse("B[arch=arm64] = arm64"),
+    });
+
+    /* A later conditional binding applies only when it matches. */
+    std::pair<bool, Value> arm64 = level.get("A", Condition(std::unordered_map<std::string, std::string>({ { "arch", "arm64" } })));
+    EXPECT_TRUE(arm64.first);
+    EXPECT_EQ(Value::String("arm64"), arm64.second);
+
+    std::pair<bool, Value> x86_64 = level.get("A", Condition(std::unordered_map<std::string, std::string>({ { "arch", "x86_64" } })));
+    EXPECT_TRUE(x86_64.first);
+    EXPECT_EQ(Value::String("unconditional"), x86_64.second);
+
+    EXPECT_FALSE(level.get("B", Condition(std::unordered_map<std::string, std::string>({ { "arch", "x86_64" } }))).first);
+}
@@ -10,6 +10,7 @@
 #include <gtest/gtest.h>
 #include <pbxsetting/Setting.h>
 
+using pbxsetting::Condition;
 using pbxsetting::Setting;
 using pbxsetting::Value;
 
@@ -91,3 +92,15 @@ TEST(Setting, Parse)
     ASSERT_NE(altcond2->condition().values().find("sdk"), altcond2->condition().values().end());
     EXPECT_EQ(altcond2->condition().values().find("sdk")->second, "ansdk*");
 }
+
+TEST(Setting, Name)
+{
+    Setting first = Setting::Create("NAME", "first");
+    Setting second = *Setting::Parse("NAME[arch=*] = second");
+
+    /* Settings with the same name share it. */
+    EXPECT_EQ(first.name(), "NAME");
+    EXPECT_EQ(&first.name(), &second.name());
+    EXPECT_TRUE(second.match("NAME", Condition(std::unordered_map<std::string, std::string>({ { "arch", "arm64" } }))));
+    EXPECT_FALSE(second.match("OTHER", Condition(std::unordered_map<std::string, std::string>({ { "arch", "arm64" } }))));
+}
@@ -209,3 +209,59 @@ TEST(Value, Add)
     ASSERT_EQ(string_string.entries().at(0).type(), Value::Entry::Type::String);
     EXPECT_EQ(*string_string.entries().at(0).string(), "teststring");
 }
+
+TEST(Value, Tokens)
+{
+    Value value = Value::Parse("A_$(B_$(C))_D");
+    std::vector<Value::Token::Type> types;
+    std::vector<std::string> strings;
+    for (Value::Token const &token : value) {
+        types.push_back(token.type());
+        if (token.type() == Value::Token::Type::String) {
+            strings.push_back(value.text().substr(token.offset(), token.length()));
+        }
+    }
+
+    EXPECT_EQ(std::vector<Value::Token::Type>({
+        Value::Token::Type::String,
+        Value::Token::Type::Begin,
+        Value::Token::Type::String,
+        Value::Token::Type::Begin,
+        Value::Token::Type::String,
+        Value::Token::Type::End,
+        Value::Token::Type::End,
+        Value::Token::Type::String,
+    }), types);
+    EXPECT_EQ(std::vector<std::string>({ "A_", "B_", "C", "_D" }), strings);
+    EXPECT_EQ("A_$(B_$(C))_D", value.raw());
+
+    /* References share the tokens of the value they're in. */
+    Value nested = *value.entries().at(1).value();
+    EXPECT_EQ(Value::Parse("B_$(C)"), nested);
+    EXPECT_EQ("B_$(C)", nested.raw());
+
+    /* Only strings where two values meet are joined. */
+    Value joined = Value::Parse("$(A)B") + Value::Parse("C$(D)E");
+    EXPECT_EQ(Value::Parse("$(A)BC$(D)E"), joined);
+    EXPECT_EQ(4, joined.entries().size());
+}
+
+TEST(Value, Operations)
+{
+    Value value = Value::Parse("$(NAME:identifier:upper)");
+    std::vector<Value::Token> tokens = std::vector<Value::Token>(value.begin(), value.end());
+    ASSERT_EQ(5, tokens.size());
+    EXPECT_EQ(Value::Token::Type::Begin, tokens[0].type());
+    EXPECT_EQ(Value::Token::Type::String, tokens[1].type());
+    EXPECT_EQ("NAME", value.text().substr(tokens[1].offset(), tokens[1].length()));
+    EXPECT_EQ(Value::Token::Type::Operation, tokens[2].type());
+    EXPECT_EQ(Value::Token::Operation::Identifier, tokens[2].operation());
+    EXPECT_EQ(Value::Token::Type::Operation, tokens[3].type());
+    EXPECT_EQ(Value::Token::Operation::Upper, tokens[3].operation());
+    EXPECT_EQ(Value::Token::Type::End, tokens[4].type());
+
+    /* Operations are still part of the name in the entries. */
+    EXPECT_EQ("NAME:identifier:upper", *value.entries().at(0).value()->entries().at(0).string());
+    EXPECT_EQ("$(NAME:identifier:upper)", value.raw());
+    EXPECT_EQ(Value::Variable("NAME:identifier:upper"), value);
+}
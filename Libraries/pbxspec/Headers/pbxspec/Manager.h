@@ -28,6 +28,7 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 
@@ -35,6 +36,11 @@ namespace libutil { class Filesystem; }
 
 namespace pbxspec {
 
+/*
+ * Specifications from the registered domains. Domains and build rules are
+ * registered before the manager is shared; after that, it isn't changed,
+ * and lookups are safe from any thread.
+ */
 class Manager {
 public:
     typedef std::shared_ptr <Manager> shared_ptr;
@@ -42,6 +48,7 @@ public:
 private:
     std::unordered_set<std::string>                                           _domains;
     std::map<std::string, std::map<char const *, PBX::Specification::vector>> _specifications;
+    std::map<std::string, std::map<char const *, std::unordered_map<std::string, PBX::Specification::shared_ptr>>> _identifiers;
     PBX::BuildRule::vector                                                    _buildRules;
 
 public:
@@ -23,8 +23,8 @@ public:
     typedef std::vector <shared_ptr> vector;
 
 protected:
-    ext::optional<PropertyOption::vector> _options;
-    PropertyOption::used_map              _optionsUsed;
+    std::shared_ptr<PropertyOption::vector const>   _options;
+    std::shared_ptr<PropertyOption::used_map const> _optionsUsed;
 
 protected:
     BuildSettings();
@@ -41,7 +41,7 @@ public:
     { return std::static_pointer_cast<BuildSettings>(Specification::base()); }
 
 public:
-    inline ext::optional<PropertyOption::vector> const &options() const
+    inline std::shared_ptr<PropertyOption::vector const> const &options() const
     { return _options; }
 
 protected:
@@ -29,10 +29,10 @@ public:
     typedef std::vector <shared_ptr> vector;
 
 protected:
-    ext::optional<PropertyOption::vector>          _options;
-    PropertyOption::used_map                       _optionsUsed;
-    ext::optional<PropertyOption::vector>          _properties;
-    PropertyOption::used_map                       _propertiesUsed;
+    std::shared_ptr<PropertyOption::vector const>   _options;
+    std::shared_ptr<PropertyOption::used_map const> _optionsUsed;
+    std::shared_ptr<PropertyOption::vector const>   _properties;
+    std::shared_ptr<PropertyOption::used_map const> _propertiesUsed;
     ext::optional<std::unordered_set<std::string>> _deletedProperties;
 
 protected:
@@ -50,11 +50,11 @@ public:
     { return std::static_pointer_cast<BuildSystem>(Specification::base()); }
 
 public:
-    inline ext::optional<PropertyOption::vector> const &options() const
+    inline std::shared_ptr<PropertyOption::vector const> const &options() const
     { return _options; }
 
 public:
-    inline ext::optional<PropertyOption::vector> const &properties() const
+    inline std::shared_ptr<PropertyOption::vector const> const &properties() const
     { return _properties; }
 
 public:
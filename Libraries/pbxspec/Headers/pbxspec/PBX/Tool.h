@@ -65,8 +65,8 @@ protected:
     ext::optional<bool>                            _deeplyStatInputDirectories;
     ext::optional<bool>                            _isUnsafeToInterrupt;
     ext::optional<int>                             _messageLimit;
-    ext::optional<PropertyOption::vector>          _options;
-    PropertyOption::used_map                       _optionsUsed;
+    std::shared_ptr<PropertyOption::vector const>   _options;
+    std::shared_ptr<PropertyOption::used_map const> _optionsUsed;
 
 protected:
     Tool();
@@ -205,7 +205,11 @@ public:
     { return _messageLimit; }
 
 public:
-    inline ext::optional<PropertyOption::vector> const &options() const
+    /*
+     * The tool's options, if any. Shared with the specification it's based
+     * on, unless it has options of its own.
+     */
+    inline std::shared_ptr<PropertyOption::vector const> const &options() const
     { return _options; }
 
 public:
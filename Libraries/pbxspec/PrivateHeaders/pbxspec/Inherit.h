@@ -14,6 +14,7 @@
 #include <pbxsetting/Setting.h>
 #include <pbxspec/PBX/PropertyOption.h>
 
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -119,25 +120,32 @@ public:
     }
 
     /*
-     * Merge two options lists.
+     * Merge two options lists. The lists are shared, not copied, if only
+     * one of them has any options: most specifications based on another
+     * only change its other values, and option lists can be long.
      */
-    static ext::optional<PBX::PropertyOption::vector>
-    Combine(ext::optional<PBX::PropertyOption::vector> const &current, ext::optional<PBX::PropertyOption::vector> const &base, PBX::PropertyOption::used_map *currentUsedMap, PBX::PropertyOption::used_map *baseUsedMap)
+    static std::shared_ptr<PBX::PropertyOption::vector const>
+    Combine(
+        std::shared_ptr<PBX::PropertyOption::vector const> const &current,
+        std::shared_ptr<PBX::PropertyOption::vector const> const &base,
+        std::shared_ptr<PBX::PropertyOption::used_map const> *currentUsedMap,
+        std::shared_ptr<PBX::PropertyOption::used_map const> const &baseUsedMap)
     {
-        if (base || current) {
-            PBX::PropertyOption::vector options = base.value_or(PBX::PropertyOption::vector());
-            *currentUsedMap = *baseUsedMap;
-
-            if (current) {
-                for (PBX::PropertyOption::shared_ptr const &option : *current) {
-                    PBX::PropertyOption::Insert(&options, currentUsedMap, option);
-                }
-            }
+        if (current == nullptr) {
+            *currentUsedMap = baseUsedMap;
+            return base;
+        } else if (base == nullptr) {
+            return current;
+        }
 
-            return options;
-        } else {
-            return ext::nullopt;
+        auto options = std::make_shared<PBX::PropertyOption::vector>(*base);
+        auto usedMap = std::make_shared<PBX::PropertyOption::used_map>(*baseUsedMap);
+        for (PBX::PropertyOption::shared_ptr const &option : *current) {
+            PBX::PropertyOption::Insert(options.get(), usedMap.get(), option);
         }
+
+        *currentUsedMap = usedMap;
+        return options;
     }
 };
 
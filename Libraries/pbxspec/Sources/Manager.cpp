@@ -15,6 +15,11 @@
 #include <plist/Format/Any.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Statistic.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <functional>
 
 using pbxspec::Manager;
 using pbxspec::Context;
@@ -33,6 +38,9 @@ using pbxspec::PBX::ProductType;
 using pbxspec::PBX::Tool;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Statistic;
+
+static Statistic RegisterDomainsTime("pbxspec", "Register specification domains");
 
 Manager::
 Manager()
@@ -80,18 +88,49 @@ findSpecifications(std::vector<std::string> const &domains, char const *type) co
     return specifications;
 }
 
+/*
+ * The specification for an identifier in a domain's specifications.
+ */
+static Specification::shared_ptr const *
+FindIdentifier(std::map<char const *, std::unordered_map<std::string, Specification::shared_ptr>> const &types, char const *type, std::string const &identifier)
+{
+    auto const &it = types.find(type);
+    if (it == types.end()) {
+        return nullptr;
+    }
+
+    auto const &iit = it->second.find(identifier);
+    if (iit == it->second.end()) {
+        return nullptr;
+    }
+
+    return &iit->second;
+}
+
 template <typename T>
 typename T::shared_ptr Manager::
 findSpecification(std::vector<std::string> const &domains, std::string const &identifier, char const *type) const
 {
-    typename T::vector vector = findSpecifications <T> (domains, type);
-
-    auto I = std::find_if(vector.begin(), vector.end(), [&identifier](Specification::shared_ptr const &spec) -> bool {
-        return identifier == spec->identifier();
-    });
+    if (type == nullptr) {
+        return nullptr;
+    }
 
-    if (I != vector.end()) {
-        return *I;
+    /* Search in the same order as findSpecifications(), for the first match. */
+    for (std::string const &domain : domains) {
+        if (domain == AnyDomain()) {
+            for (auto const &entry : _identifiers) {
+                if (Specification::shared_ptr const *specification = FindIdentifier(entry.second, type, identifier)) {
+                    return std::static_pointer_cast<T>(*specification);
+                }
+            }
+        } else {
+            auto const &doit = _identifiers.find(domain);
+            if (doit != _identifiers.end()) {
+                if (Specification::shared_ptr const *specification = FindIdentifier(doit->second, type, identifier)) {
+                    return std::static_pointer_cast<T>(*specification);
+                }
+            }
+        }
     }
 
     return nullptr;
@@ -301,6 +340,7 @@ addSpecification(PBX::Specification::shared_ptr const &spec)
             spec->type(), spec->domain().c_str(), spec->identifier().c_str());
 #endif
     _specifications[spec->domain()][spec->type()].push_back(spec);
+    _identifiers[spec->domain()][spec->type()].insert({ spec->identifier(), spec });
 }
 
 bool Manager::
@@ -346,22 +386,33 @@ inheritSpecification(PBX::Specification::shared_ptr const &specification)
 void Manager::
 registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string, std::string>> const &domains)
 {
-    PBX::Specification::vector specifications;
+    Statistic::Timer timer(&RegisterDomainsTime);
 
+    /*
+     * Find the domains not yet registered. Unncessary and causes warnings.
+     */
+    std::vector<std::pair<std::string, std::string>> newDomains;
     for (auto const &domain : domains) {
-        /*
-         * Avoid double domain registration. Unncessary and causes warnings.
-         */
-        if (_domains.find(domain.first) != _domains.end()) {
-            continue;
+        if (_domains.find(domain.first) == _domains.end()) {
+            newDomains.push_back(domain);
         }
+    }
+
+    /*
+     * Find the specification files in each domain, each with the context to parse
+     * it in. Domains are separate directory trees, so search them in parallel.
+     */
+    std::vector<std::vector<std::pair<std::string, Context>>> domainFiles = std::vector<std::vector<std::pair<std::string, Context>>>(newDomains.size());
+    libutil::Parallel::For(newDomains.size(), [&](size_t index) {
+        std::pair<std::string, std::string> const &domain = newDomains[index];
+        std::vector<std::pair<std::string, Context>> *files = &domainFiles[index];
 
         Context context = {
             .domain = domain.first,
         };
 
         if (filesystem->isDirectory(domain.second)) {
-            filesystem->enumerateRecursive(domain.second, [&](std::string const &filename) -> bool {
+            filesystem->enumerateRecursive(domain.second, [&](std::string const &filename, bool directory) -> bool {
                 /* Support both *.xcspec and *.pbfilespec as a few of the latter remain in use. */
                 if (FSUtil::GetFileExtension(filename) != "xcspec" && FSUtil::GetFileExtension(filename) != "pbfilespec") {
                     return true;
@@ -371,30 +422,40 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
                 bool file = FSUtil::GetFileExtension(filename) == "pbfilespec";
                 context.defaultType = (file ? "FileType" : std::string());
 
-                if (!filesystem->isDirectory(filename)) {
-#if 0
-                    fprintf(stderr, "importing specification '%s'\n", filename.c_str());
-#endif
-
-                    ext::optional<PBX::Specification::vector> fileSpecifications = Specification::Open(filesystem, &context, filename);
-                    if (fileSpecifications) {
-                        specifications.insert(specifications.end(), fileSpecifications->begin(), fileSpecifications->end());
-                    } else {
-                        fprintf(stderr, "warning: failed to import specification '%s'\n", filename.c_str());
-                    }
+                if (!directory) {
+                    files->push_back({ filename, context });
                 }
                 return true;
             });
         } else if (filesystem->exists(domain.second)) {
+            files->push_back({ domain.second, context });
+        }
+    });
+
+    /* Keep the files in domain order, so registration order doesn't change. */
+    std::vector<std::pair<std::string, Context>> files;
+    for (std::vector<std::pair<std::string, Context>> const &domainFile : domainFiles) {
+        files.insert(files.end(), domainFile.begin(), domainFile.end());
+    }
+
+    /*
+     * Parse the specification files. Each file is parsed independently, and parsing
+     * is CPU bound, so parse them in parallel. Registration is still in file order.
+     */
+    std::vector<ext::optional<PBX::Specification::vector>> fileSpecifications = std::vector<ext::optional<PBX::Specification::vector>>(files.size());
+    libutil::Parallel::For(files.size(), [&](size_t index) {
 #if 0
-            fprintf(stderr, "importing specification '%s'\n", domain.second.c_str());
+        fprintf(stderr, "importing specification '%s'\n", files[index].first.c_str());
 #endif
-            ext::optional<PBX::Specification::vector> fileSpecifications = Specification::Open(filesystem, &context, domain.second);
-            if (fileSpecifications) {
-                specifications.insert(specifications.end(), fileSpecifications->begin(), fileSpecifications->end());
-            } else {
-                fprintf(stderr, "warning: failed to import specification '%s'\n", domain.second.c_str());
-            }
+        fileSpecifications[index] = Specification::Open(filesystem, &files[index].second, files[index].first);
+    });
+
+    PBX::Specification::vector specifications;
+    for (size_t index = 0; index < files.size(); ++index) {
+        if (fileSpecifications[index]) {
+            specifications.insert(specifications.end(), fileSpecifications[index]->begin(), fileSpecifications[index]->end());
+        } else {
+            fprintf(stderr, "warning: failed to import specification '%s'\n", files[index].first.c_str());
         }
     }
 
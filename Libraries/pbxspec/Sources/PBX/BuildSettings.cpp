@@ -58,16 +58,20 @@ parse(Context *context, plist::Dictionary const *dict, std::unordered_set<std::s
     }
 
     if (Os != nullptr) {
-        _options = PropertyOption::vector();
+        auto options = std::make_shared<PropertyOption::vector>();
+        auto optionsUsed = std::make_shared<PropertyOption::used_map>();
         for (size_t n = 0; n < Os->count(); n++) {
             if (auto O = Os->value <plist::Dictionary> (n)) {
                 PropertyOption::shared_ptr option;
                 option.reset(new PropertyOption);
                 if (option->parse(O)) {
-                    PropertyOption::Insert(&*_options, &_optionsUsed, option);
+                    PropertyOption::Insert(options.get(), optionsUsed.get(), option);
                 }
             }
         }
+
+        _options = options;
+        _optionsUsed = optionsUsed;
     }
 
     return true;
@@ -90,7 +94,7 @@ inherit(BuildSettings::shared_ptr const &b)
 
     auto base = this->base();
 
-    _options            = Inherit::Combine(_options, base->options(), &_optionsUsed, &base->_optionsUsed);
+    _options            = Inherit::Combine(_options, base->_options, &_optionsUsed, base->_optionsUsed);
 
     return true;
 }
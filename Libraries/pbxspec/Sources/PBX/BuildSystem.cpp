@@ -82,29 +82,37 @@ parse(Context *context, plist::Dictionary const *dict, std::unordered_set<std::s
     }
 
     if (Os != nullptr) {
-        _options = PropertyOption::vector();
+        auto options = std::make_shared<PropertyOption::vector>();
+        auto optionsUsed = std::make_shared<PropertyOption::used_map>();
         for (size_t n = 0; n < Os->count(); n++) {
             if (auto O = Os->value <plist::Dictionary> (n)) {
                 PropertyOption::shared_ptr option;
                 option.reset(new PropertyOption);
                 if (option->parse(O)) {
-                    PropertyOption::Insert(&*_options, &_optionsUsed, option);
+                    PropertyOption::Insert(options.get(), optionsUsed.get(), option);
                 }
             }
         }
+
+        _options = options;
+        _optionsUsed = optionsUsed;
     }
 
     if (Ps != nullptr) {
-        _properties = PropertyOption::vector();
+        auto properties = std::make_shared<PropertyOption::vector>();
+        auto propertiesUsed = std::make_shared<PropertyOption::used_map>();
         for (size_t n = 0; n < Ps->count(); n++) {
             if (auto P = Ps->value <plist::Dictionary> (n)) {
                 PropertyOption::shared_ptr property;
                 property.reset(new PropertyOption);
                 if (property->parse(P)) {
-                    PropertyOption::Insert(&*_properties, &_propertiesUsed, property);
+                    PropertyOption::Insert(properties.get(), propertiesUsed.get(), property);
                 }
             }
         }
+
+        _properties = properties;
+        _propertiesUsed = propertiesUsed;
     }
 
     if (DPs != nullptr) {
@@ -136,8 +144,8 @@ inherit(BuildSystem::shared_ptr const &b)
 
     auto base = this->base();
 
-    _options           = Inherit::Combine(_options, base->_options, &_optionsUsed, &base->_optionsUsed);
-    _properties        = Inherit::Combine(_properties, base->_properties, &_propertiesUsed, &base->_propertiesUsed);
+    _options           = Inherit::Combine(_options, base->_options, &_optionsUsed, base->_optionsUsed);
+    _properties        = Inherit::Combine(_properties, base->_properties, &_propertiesUsed, base->_propertiesUsed);
     _deletedProperties = Inherit::Combine(_deletedProperties, base->_deletedProperties);
 
     return true;
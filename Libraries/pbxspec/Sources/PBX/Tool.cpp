@@ -302,16 +302,20 @@ parse(Context *context, plist::Dictionary const *dict, std::unordered_set<std::s
     }
 
     if (OPs != nullptr) {
-        _options = PropertyOption::vector();
+        auto options = std::make_shared<PropertyOption::vector>();
+        auto optionsUsed = std::make_shared<PropertyOption::used_map>();
         for (size_t n = 0; n < OPs->count(); n++) {
             if (auto OP = OPs->value <plist::Dictionary> (n)) {
                 PropertyOption::shared_ptr option;
                 option.reset(new PropertyOption);
                 if (option->parse(OP)) {
-                    PropertyOption::Insert(&*_options, &_optionsUsed, option);
+                    PropertyOption::Insert(options.get(), optionsUsed.get(), option);
                 }
             }
         }
+
+        _options = options;
+        _optionsUsed = optionsUsed;
     }
 
     if (DPs != nullptr) {
@@ -377,7 +381,7 @@ inherit(Tool::shared_ptr const &b)
     _deeplyStatInputDirectories          = Inherit::Override(_deeplyStatInputDirectories, base->_deeplyStatInputDirectories);
     _isUnsafeToInterrupt                 = Inherit::Override(_isUnsafeToInterrupt, base->_isUnsafeToInterrupt);
     _messageLimit                        = Inherit::Override(_messageLimit, base->_messageLimit);
-    _options                             = Inherit::Combine(_options, base->_options, &_optionsUsed, &base->_optionsUsed);
+    _options                             = Inherit::Combine(_options, base->_options, &_optionsUsed, base->_optionsUsed);
 
     return true;
 }
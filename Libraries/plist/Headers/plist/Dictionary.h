@@ -14,15 +14,56 @@
 #include <plist/Object.h>
 
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
 #include <vector>
-#include <unordered_map>
 
 namespace plist {
 
 class Dictionary : public Object {
+public:
+    typedef std::pair<std::string, std::unique_ptr<Object>> Entry;
+
+    /*
+     * Iterates the keys of a dictionary, in insertion order.
+     */
+    class KeyIterator : public std::iterator<std::forward_iterator_tag, std::string const> {
+    private:
+        std::vector<Entry>::const_iterator _it;
+
+    public:
+        explicit KeyIterator(std::vector<Entry>::const_iterator it) :
+            _it(it)
+        {
+        }
+
+    public:
+        inline std::string const &operator*() const
+        { return _it->first; }
+        inline std::string const *operator->() const
+        { return &_it->first; }
+
+        inline KeyIterator &operator++()
+        { ++_it; return *this; }
+        inline KeyIterator operator++(int)
+        { KeyIterator result = *this; ++_it; return result; }
+
+        inline bool operator==(KeyIterator const &other) const
+        { return _it == other._it; }
+        inline bool operator!=(KeyIterator const &other) const
+        { return _it != other._it; }
+    };
+
 private:
-    std::vector<std::string>                                 _keys;
-    std::unordered_map<std::string, std::unique_ptr<Object>> _map;
+    /*
+     * Entries in insertion order, so each key is only stored once. Larger
+     * dictionaries also have an open addressing hash index into the entries;
+     * smaller ones are searched linearly, which is faster than hashing.
+     */
+    std::vector<Entry>    _entries;
+    std::vector<uint32_t> _index;
 
 public:
     Dictionary()
@@ -40,27 +81,36 @@ public:
 public:
     inline bool empty() const
     {
-        return _map.empty();
+        return _entries.empty();
     }
 
     inline size_t count() const
     {
-        return _map.size();
+        return _entries.size();
     }
 
     inline std::string const &key(size_t index) const
     {
-        return _keys[index];
+        return _entries[index].first;
+    }
+
+    /*
+     * The position of a key, or `count()` if the dictionary doesn't have it.
+     */
+    inline size_t index(std::string const &key) const
+    {
+        Entry const *entry = find(key);
+        return (entry != nullptr ? static_cast<size_t>(entry - _entries.data()) : _entries.size());
     }
 
     inline Object const *value(size_t index) const
     {
-        return (index < _keys.size()) ? value(_keys[index]) : nullptr;
+        return (index < _entries.size()) ? _entries[index].second.get() : nullptr;
     }
 
     inline Object *value(size_t index)
     {
-        return (index < _keys.size()) ? value(_keys[index]) : nullptr;
+        return (index < _entries.size()) ? _entries[index].second.get() : nullptr;
     }
 
     template <typename T>
@@ -77,14 +127,14 @@ public:
 
     inline Object const *value(std::string const &key) const
     {
-        auto it = _map.find(key);
-        return (it != _map.end() ? it->second.get() : nullptr);
+        Entry const *entry = find(key);
+        return (entry != nullptr ? entry->second.get() : nullptr);
     }
 
     inline Object *value(std::string const &key)
     {
-        auto it = _map.find(key);
-        return (it != _map.end() ? it->second.get() : nullptr);
+        Entry const *entry = find(key);
+        return (entry != nullptr ? entry->second.get() : nullptr);
     }
 
     template <typename T>
@@ -102,39 +152,36 @@ public:
 public:
     inline void clear()
     {
-        _keys.clear();
-        _map.clear();
+        _entries.clear();
+        _index.clear();
     }
 
-public:
-    inline void set(std::string const &key, std::unique_ptr<Object> obj)
+    inline void reserve(size_t count)
     {
-        remove(key);
-        _keys.push_back(key);
-        _map.insert(std::make_pair(key, std::move(obj)));
+        _entries.reserve(count);
     }
 
-    inline void remove(std::string const &key)
-    {
-        auto it = _map.find(key);
-
-        if (it != _map.end()) {
-            _map.erase(it);
-            _keys.erase(std::find(_keys.begin(), _keys.end(), key));
-        }
-    }
+public:
+    void set(std::string const &key, std::unique_ptr<Object> obj);
+    void remove(std::string const &key);
 
 public:
-    inline std::vector<std::string>::const_iterator begin() const
+    inline KeyIterator begin() const
     {
-        return _keys.begin();
+        return KeyIterator(_entries.begin());
     }
 
-    inline std::vector<std::string>::const_iterator end() const
+    inline KeyIterator end() const
     {
-        return _keys.end();
+        return KeyIterator(_entries.end());
     }
 
+private:
+    Entry const *find(std::string const &key) const;
+    void insertIndex(size_t index);
+    void removeIndex(size_t index);
+    void rebuildIndex();
+
 public:
     static std::unique_ptr<Dictionary> Coerce(Object const *obj);
 
@@ -174,8 +221,8 @@ public:
         if (count() != obj->count())
             return false;
 
-        for (auto const &it : _map) {
-            if (!value(it.first)->equals(obj->value(it.first)))
+        for (Entry const &entry : _entries) {
+            if (!entry.second->equals(obj->value(entry.first)))
                 return false;
         }
 
@@ -13,6 +13,7 @@
 #include <plist/Format/Format.h>
 #include <plist/Format/Type.h>
 #include <plist/Format/Encoding.h>
+#include <plist/Format/Handler.h>
 
 namespace plist {
 namespace Format {
@@ -36,6 +37,14 @@ public:
 
 public:
     static ASCII Create(bool strings, Encoding encoding);
+
+public:
+    /*
+     * Parse contents, passing each value to the handler instead of building
+     * an object tree.
+     */
+    static std::pair<bool, std::string>
+    Parse(std::vector<uint8_t> const &contents, ASCII const &format, Handler *handler);
 };
 
 }
@@ -0,0 +1,105 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_BinaryView_h
+#define __plist_Format_BinaryView_h
+
+#include <plist/Object.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Random-access view over the contents of a binary property list. Objects
+ * are decoded through the offset table only when they are asked for, so a
+ * lookup of a few keys does not deserialize the whole file. The view does
+ * not own the contents; they must outlive it.
+ */
+class BinaryView {
+public:
+    /*
+     * Index of an object in the offset table.
+     */
+    typedef uint64_t Reference;
+
+private:
+    uint8_t const *_contents;
+    size_t         _size;
+
+private:
+    uint8_t        _offsetIntByteSize;
+    uint8_t        _objectRefByteSize;
+    uint64_t       _objectsCount;
+    uint64_t       _topLevelObject;
+    uint64_t       _offsetTableOffset;
+
+private:
+    BinaryView(uint8_t const *contents, size_t size);
+
+public:
+    /*
+     * The top level object.
+     */
+    Reference root() const
+    { return _topLevelObject; }
+
+public:
+    /*
+     * The type of an object, or `ObjectType::None` if it can't be decoded.
+     */
+    ObjectType type(Reference reference) const;
+
+    /*
+     * The number of entries in an array or dictionary, or zero for any
+     * other object.
+     */
+    size_t count(Reference reference) const;
+
+public:
+    /*
+     * Finds the value for a key in a dictionary. Only the keys are decoded
+     * while searching.
+     */
+    bool value(Reference reference, std::string const &key, Reference *value) const;
+
+    /*
+     * Finds the value at an index in an array.
+     */
+    bool value(Reference reference, size_t index, Reference *value) const;
+
+public:
+    /*
+     * Decodes an object and everything it contains.
+     */
+    std::unique_ptr<Object> materialize(Reference reference) const;
+
+private:
+    bool offset(Reference reference, uint64_t *offset) const;
+    bool header(uint64_t offset, uint8_t *marker, uint64_t *length, uint64_t *start) const;
+    bool reference(uint64_t start, uint64_t index, Reference *reference) const;
+    bool string(uint64_t offset, std::string *value) const;
+    std::unique_ptr<Object> materialize(Reference reference, uint64_t depth) const;
+
+public:
+    /*
+     * Opens a view over binary property list contents. Returns null if
+     * the header, trailer or offset table is invalid.
+     */
+    static std::unique_ptr<BinaryView>
+    Open(uint8_t const *contents, size_t size);
+};
+
+}
+}
+
+#endif  // !__plist_Format_BinaryView_h
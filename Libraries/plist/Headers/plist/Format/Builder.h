@@ -0,0 +1,66 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_Builder_h
+#define __plist_Format_Builder_h
+
+#include <plist/Format/Handler.h>
+#include <plist/Object.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Builds an object tree from parser events.
+ */
+class Builder : public Handler {
+private:
+    std::unique_ptr<Object>              _root;
+    std::vector<std::unique_ptr<Object>> _containers;
+    std::vector<std::string>             _keys;
+
+public:
+    Builder();
+    ~Builder();
+
+public:
+    std::unique_ptr<Object> &root()
+    { return _root; }
+
+public:
+    virtual bool beginDictionary();
+    virtual bool key(std::string const &key);
+    virtual bool endDictionary();
+
+public:
+    virtual bool beginArray();
+    virtual bool endArray();
+
+public:
+    virtual bool string(std::string const &value);
+    virtual bool data(std::vector<uint8_t> const &value);
+    virtual bool integer(int64_t value);
+    virtual bool real(double value);
+    virtual bool boolean(bool value);
+    virtual bool null();
+
+private:
+    bool beginContainer(std::unique_ptr<Object> container);
+    bool endContainer(ObjectType type);
+    bool store(std::unique_ptr<Object> value);
+};
+
+}
+}
+
+#endif  // !__plist_Format_Builder_h
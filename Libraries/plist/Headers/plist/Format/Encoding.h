@@ -12,6 +12,7 @@
 
 #include <plist/Base.h>
 
+#include <utility>
 #include <vector>
 
 namespace plist {
@@ -38,6 +39,14 @@ public:
     static std::vector<uint8_t>
     Convert(std::vector<uint8_t> const &contents, Encoding from, Encoding to);
 
+    /*
+     * Convert contents like above, but without copying contents that are
+     * already in the target encoding. The result points into either the
+     * contents or the buffer, which must outlive its use.
+     */
+    static std::pair<uint8_t const *, size_t>
+    Convert(std::vector<uint8_t> const &contents, Encoding from, Encoding to, std::vector<uint8_t> *buffer);
+
 public:
     static std::vector<uint8_t>
     BOM(Encoding encoding);
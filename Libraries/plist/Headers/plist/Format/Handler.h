@@ -0,0 +1,53 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __plist_Format_Handler_h
+#define __plist_Format_Handler_h
+
+#include <plist/Base.h>
+
+#include <string>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Receives the contents of a property list as it is parsed, without building
+ * an object tree. Inside a dictionary, each value follows its key. Returning
+ * false from any event stops parsing with an error.
+ */
+class Handler {
+public:
+    virtual ~Handler()
+    {
+    }
+
+public:
+    virtual bool beginDictionary() = 0;
+    virtual bool key(std::string const &key) = 0;
+    virtual bool endDictionary() = 0;
+
+public:
+    virtual bool beginArray() = 0;
+    virtual bool endArray() = 0;
+
+public:
+    virtual bool string(std::string const &value) = 0;
+    virtual bool data(std::vector<uint8_t> const &value) = 0;
+    virtual bool integer(int64_t value) = 0;
+    virtual bool real(double value) = 0;
+    virtual bool boolean(bool value) = 0;
+    virtual bool null() = 0;
+};
+
+}
+}
+
+#endif  // !__plist_Format_Handler_h
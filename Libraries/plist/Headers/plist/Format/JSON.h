@@ -13,6 +13,7 @@
 #include <plist/Format/Format.h>
 #include <plist/Format/Type.h>
 #include <plist/Format/Encoding.h>
+#include <plist/Format/Handler.h>
 
 namespace plist {
 namespace Format {
@@ -23,6 +24,14 @@ private:
 
 public:
     static JSON Create();
+
+public:
+    /*
+     * Parse contents, passing each value to the handler instead of building
+     * an object tree.
+     */
+    static std::pair<bool, std::string>
+    Parse(std::vector<uint8_t> const &contents, JSON const &format, Handler *handler);
 };
 
 }
@@ -30,12 +30,18 @@ private:
     std::string                      _name;
     Dictionary const                *_dict;
     std::unordered_set<std::string> *_seen;
+    std::vector<bool>                _unpacked;
     std::vector<std::string>         _errors;
 
 public:
     /*
      * Create an unpack for a type with the specified name, unpacking the given
      * dictionary. The seen set is keys that have and will be unpacked from it.
+     *
+     * Keys unpacked are tracked by their position in the dictionary, and only
+     * added to the seen set when completing without checking, for the unpack
+     * of a subtype to check against. Keys asked for but not in the dictionary
+     * can't be unknown, so they aren't tracked at all.
      */
     Unpack(std::string const &name, Dictionary const *dict, std::unordered_set<std::string> *seen);
 
@@ -11,8 +11,7 @@
 #define __plist_Format_ASCIIParser_h
 
 #include <plist/Format/ASCIIPListLexer.h>
-#include <plist/Object.h>
-#include <plist/String.h>
+#include <plist/Format/Handler.h>
 
 #include <stack>
 #include <string>
@@ -37,35 +36,25 @@ private:
     };
 
 private:
-    std::unique_ptr<plist::Object> _root;
+    Handler                       *_handler;
     int                            _level;
 
 private:
     ValueState                     _state;
     std::stack<ValueState>         _stateStack;
 
-private:
-    std::unique_ptr<plist::Object> _container;
-    std::stack<std::unique_ptr<plist::Object>> _containerStack;
-
-private:
-    std::unique_ptr<plist::String> _key;
-    std::stack<std::unique_ptr<plist::String>> _keyStack;
-
 private:
     ContextState                _contextState;
     std::string                 _error;
 
 public:
-    ASCIIParser();
+    explicit ASCIIParser(Handler *handler);
     ~ASCIIParser();
 
 public:
     bool parse(ASCIIPListLexer *lexer, bool strings);
 
 public:
-    std::unique_ptr<plist::Object> &root()
-    { return _root; }
     std::string error() const
     { return _error; }
 
@@ -83,12 +72,11 @@ private:
     void decrementLevel();
 
 private:
-    bool push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr<plist::String> key);
+    bool push(ValueState state);
     bool pop();
 
 private:
-    bool beginContainer(std::unique_ptr<plist::Object> container);
-    bool storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object> value);
+    bool beginContainer(bool isArray);
     bool endContainer(bool isArray);
 
 private:
@@ -102,8 +90,8 @@ private:
     bool endDictionary();
 
 private:
-    bool storeKey(std::unique_ptr<plist::String> key);
-    bool storeValue(std::unique_ptr<plist::Object> value);
+    bool storeKey(std::string const &key);
+    bool storeValue();
 };
 
 }
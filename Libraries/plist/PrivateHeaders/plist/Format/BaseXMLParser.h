@@ -14,7 +14,7 @@
 
 #include <vector>
 #include <string>
-#include <unordered_map>
+#include <utility>
 
 #include <libxml/xmlreader.h>
 
@@ -22,10 +22,25 @@ namespace plist {
 namespace Format {
 
 class BaseXMLParser {
+protected:
+    typedef std::vector<std::pair<std::string, std::string>> Attributes;
+
 private:
     ::xmlTextReaderPtr _parser;
     size_t             _depth;
 
+private:
+    /*
+     * State of the built-in parser. Names, text and attributes are kept
+     * between elements to reuse their storage.
+     */
+    char const        *_begin;
+    char const        *_position;
+    bool               _failed;
+    std::string        _name;
+    std::string        _text;
+    Attributes         _attributes;
+
 private:
     size_t             _line;
     size_t             _column;
@@ -43,7 +58,23 @@ public:
     { return _error; }
 
 protected:
-    bool parse(std::vector<uint8_t> const &contents);
+    bool parse(uint8_t const *data, size_t size);
+
+private:
+    enum class Result {
+        Success,
+        Failure,
+        Unsupported,
+    };
+
+    /*
+     * Parse the subset of XML used by property lists, schemes and
+     * workspaces: no CDATA, processing instructions, internal DTD subset
+     * or entities beyond the predefined ones. Anything else is left to
+     * libxml2, so is reported as unsupported before any result.
+     */
+    Result parseSimple(char const *begin, char const *end);
+    bool parseReader(uint8_t const *data, size_t size);
 
 protected:
     inline size_t depth() const
@@ -54,7 +85,7 @@ protected:
     virtual void onEndParse(bool success);
 
 protected:
-    virtual void onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t depth);
+    virtual void onStartElement(std::string const &name, Attributes const &attrs, size_t depth);
     virtual void onEndElement(std::string const &name, size_t depth);
     virtual void onCharacterData(std::string const &cdata, size_t depth);
 
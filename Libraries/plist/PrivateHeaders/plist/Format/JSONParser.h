@@ -11,8 +11,7 @@
 #define __plist_Format_JSONParser_h
 
 #include <plist/Format/ASCIIPListLexer.h>
-#include <plist/Object.h>
-#include <plist/String.h>
+#include <plist/Format/Handler.h>
 
 #include <stack>
 #include <string>
@@ -37,38 +36,43 @@ private:
     };
 
 private:
-    std::unique_ptr<plist::Object> _root;
+    Handler                       *_handler;
     int                            _level;
 
 private:
     ValueState                     _state;
     std::stack<ValueState>         _stateStack;
 
-private:
-    std::unique_ptr<plist::Object> _container;
-    std::stack<std::unique_ptr<plist::Object>> _containerStack;
-
-private:
-    std::unique_ptr<plist::String> _key;
-    std::stack<std::unique_ptr<plist::String>> _keyStack;
-
 private:
     ContextState                _contextState;
     std::string                 _error;
 
+private:
+    char const                    *_pointer;
+    char const                    *_end;
+    std::string                    _value;
+
 public:
-    JSONParser();
+    explicit JSONParser(Handler *handler);
     ~JSONParser();
 
 public:
-    bool parse(ASCIIPListLexer *lexer);
+    bool parse(char const *data, size_t size);
 
 public:
-    std::unique_ptr<plist::Object> &root()
-    { return _root; }
     std::string error() const
     { return _error; }
 
+private:
+    /*
+     * Read the next token, with the same values as the ASCII lexer. The
+     * text of strings, unescaped, and of numbers is in the value.
+     */
+    int readToken();
+    int readString();
+    int readNumber();
+    int readKeyword(char const *keyword, int token);
+
 private:
     bool isAborted() const;
     void abort(std::string const &error);
@@ -83,12 +87,11 @@ private:
     void decrementLevel();
 
 private:
-    bool push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr<plist::String> key);
+    bool push(ValueState state);
     bool pop();
 
 private:
-    bool beginContainer(std::unique_ptr<plist::Object> container);
-    bool storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object> value);
+    bool beginContainer(bool isArray);
     bool endContainer(bool isArray);
 
 private:
@@ -102,8 +105,8 @@ private:
     bool endDictionary();
 
 private:
-    bool storeKey(std::unique_ptr<plist::String> key);
-    bool storeValue(std::unique_ptr<plist::Object> value);
+    bool storeKey(std::string const &key);
+    bool storeValue();
 };
 
 }
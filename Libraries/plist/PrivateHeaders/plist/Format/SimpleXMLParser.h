@@ -26,14 +26,14 @@ public:
     SimpleXMLParser();
 
 public:
-    Dictionary *parse(std::vector<uint8_t> const &contents);
+    Dictionary *parse(uint8_t const *data, size_t size);
 
 private:
     virtual void onBeginParse();
     virtual void onEndParse(bool success);
 
 private:
-    void onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t);
+    void onStartElement(std::string const &name, Attributes const &attrs, size_t);
     void onEndElement(std::string const &name, size_t);
 };
 
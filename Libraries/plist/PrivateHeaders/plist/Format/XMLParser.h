@@ -41,14 +41,14 @@ public:
     XMLParser();
 
 public:
-    Object *parse(std::vector<uint8_t> const &contents);
+    Object *parse(uint8_t const *data, size_t size);
 
 private:
     virtual void onBeginParse();
     virtual void onEndParse(bool success);
 
 private:
-    void onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t depth);
+    void onStartElement(std::string const &name, Attributes const &attrs, size_t depth);
     void onEndElement(std::string const &name, size_t depth);
     void onCharacterData(std::string const &cdata, size_t depth);
 
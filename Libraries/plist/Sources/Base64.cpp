@@ -9,30 +9,170 @@
 
 #include <plist/Base64.h>
 
-#include "rfc4648.h"
-
 using plist::Base64;
 
+static char const Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+namespace {
+
+/*
+ * Decoding looks up all four characters of a group at once: each table
+ * holds a character's six bits already shifted into place, so the group's
+ * three bytes are the bitwise or of four lookups. Characters that aren't
+ * part of the alphabet set a bit outside of those bytes.
+ */
+struct DecodeTables {
+    static uint32_t const Invalid = 1u << 24;
+
+    uint32_t table[4][256];
+
+    DecodeTables()
+    {
+        for (size_t i = 0; i < 4; i++) {
+            for (size_t c = 0; c < 256; c++) {
+                table[i][c] = Invalid;
+            }
+        }
+
+        for (uint32_t value = 0; value < 64; value++) {
+            for (size_t i = 0; i < 4; i++) {
+                table[i][static_cast<uint8_t>(Alphabet[value])] = value << (18 - 6 * i);
+            }
+        }
+
+        /* Also accept the URL and filename safe alphabet. */
+        for (size_t i = 0; i < 4; i++) {
+            table[i]['-'] = table[i]['+'];
+            table[i]['_'] = table[i]['/'];
+        }
+    }
+};
+
+/*
+ * Encoding looks up two characters at once for each twelve bits.
+ */
+struct EncodeTable {
+    char pairs[4096][2];
+
+    EncodeTable()
+    {
+        for (size_t i = 0; i < 4096; i++) {
+            pairs[i][0] = Alphabet[i >> 6];
+            pairs[i][1] = Alphabet[i & 0x3f];
+        }
+    }
+};
+
+}
+
+static inline bool
+IsSpace(uint8_t c)
+{
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r');
+}
+
 void Base64::
 Decode(std::string const &in, std::vector<uint8_t> &out)
 {
-    size_t outsize = rfc4648_get_decoded_size(RFC4648_TYPE_BASE64_SAFE, in.size());
-    out.resize(outsize);
-    rfc4648_decode(RFC4648_TYPE_BASE64_SAFE, &in[0], in.size(), reinterpret_cast<char *>(&out[0]), &outsize, true);
+    static DecodeTables const tables;
+    uint32_t const (&table)[4][256] = tables.table;
+
+    /* Decode straight into the output, trimmed once the length is known. */
+    out.resize(((in.size() + 3) / 4) * 3);
+
+    uint8_t const *p = reinterpret_cast<uint8_t const *>(in.data());
+    uint8_t const *end = p + in.size();
+    uint8_t *o = out.data();
+
+    while (true) {
+        /* Groups without whitespace or padding. */
+        while (end - p >= 4) {
+            uint32_t value = table[0][p[0]] | table[1][p[1]] | table[2][p[2]] | table[3][p[3]];
+            if (value & DecodeTables::Invalid) {
+                break;
+            }
+
+            o[0] = static_cast<uint8_t>(value >> 16);
+            o[1] = static_cast<uint8_t>(value >> 8);
+            o[2] = static_cast<uint8_t>(value);
+            o += 3;
+            p += 4;
+        }
+
+        /*
+         * A group split by whitespace, or the last group. Decoding stops at
+         * padding or any other character outside of the alphabet.
+         */
+        uint32_t value = 0;
+        size_t count = 0;
+        while (count < 4) {
+            while (p != end && IsSpace(*p)) {
+                p++;
+            }
+            if (p == end) {
+                break;
+            }
+
+            uint32_t bits = table[count][*p];
+            if (bits & DecodeTables::Invalid) {
+                break;
+            }
+
+            value |= bits;
+            count++;
+            p++;
+        }
+
+        if (count >= 2) {
+            *o++ = static_cast<uint8_t>(value >> 16);
+        }
+        if (count >= 3) {
+            *o++ = static_cast<uint8_t>(value >> 8);
+        }
+        if (count == 4) {
+            *o++ = static_cast<uint8_t>(value);
+        } else {
+            break;
+        }
+    }
+
+    out.resize(o - out.data());
 }
 
 std::string Base64::
 Encode(std::vector<uint8_t> const &in)
 {
-    if (in.empty()) {
-        return std::string();
-    }
+    static EncodeTable const table;
 
     std::string result;
+    result.resize(((in.size() + 2) / 3) * 4);
 
-    size_t outsize = rfc4648_get_encoded_size(RFC4648_TYPE_BASE64_SAFE, in.size());
-    result.resize(outsize);
-    rfc4648_encode(RFC4648_TYPE_BASE64_SAFE, &in[0], in.size(), &result[0], &outsize);
+    uint8_t const *p = in.data();
+    uint8_t const *end = p + in.size();
+    char *o = &result[0];
+
+    while (end - p >= 3) {
+        uint32_t value = (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+        o[0] = table.pairs[value >> 12][0];
+        o[1] = table.pairs[value >> 12][1];
+        o[2] = table.pairs[value & 0xfff][0];
+        o[3] = table.pairs[value & 0xfff][1];
+        o += 4;
+        p += 3;
+    }
+
+    if (end - p == 1) {
+        o[0] = Alphabet[p[0] >> 2];
+        o[1] = Alphabet[(p[0] & 0x03) << 4];
+        o[2] = '=';
+        o[3] = '=';
+    } else if (end - p == 2) {
+        o[0] = Alphabet[p[0] >> 2];
+        o[1] = Alphabet[((p[0] & 0x03) << 4) | (p[1] >> 4)];
+        o[2] = Alphabet[(p[1] & 0x0f) << 2];
+        o[3] = '=';
+    }
 
     return result;
 }
@@ -9,6 +9,8 @@
 
 #include <plist/Dictionary.h>
 
+#include <functional>
+
 using plist::Object;
 using plist::Dictionary;
 
@@ -18,13 +20,138 @@ New()
     return std::unique_ptr<Dictionary>(new Dictionary());
 }
 
+/*
+ * Dictionaries with at most this many entries are searched linearly.
+ */
+static size_t const IndexThreshold = 8;
+
+Dictionary::Entry const *Dictionary::
+find(std::string const &key) const
+{
+    if (_index.empty()) {
+        for (Entry const &entry : _entries) {
+            if (entry.first == key) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    /* Slots hold an entry's index plus one, so zero is an empty slot. */
+    size_t mask = _index.size() - 1;
+    for (size_t slot = std::hash<std::string>()(key) & mask; _index[slot] != 0; slot = (slot + 1) & mask) {
+        Entry const &entry = _entries[_index[slot] - 1];
+        if (entry.first == key) {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+void Dictionary::
+insertIndex(size_t index)
+{
+    size_t mask = _index.size() - 1;
+    size_t slot = std::hash<std::string>()(_entries[index].first) & mask;
+    while (_index[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    _index[slot] = static_cast<uint32_t>(index + 1);
+}
+
+void Dictionary::
+removeIndex(size_t index)
+{
+    size_t mask = _index.size() - 1;
+    size_t slot = std::hash<std::string>()(_entries[index].first) & mask;
+    while (_index[slot] != index + 1) {
+        slot = (slot + 1) & mask;
+    }
+
+    /*
+     * Move later slots in the probe sequence back into the hole, so lookups
+     * for them do not stop early at an empty slot.
+     */
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; _index[next] != 0; next = (next + 1) & mask) {
+        size_t home = std::hash<std::string>()(_entries[_index[next] - 1].first) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            _index[hole] = _index[next];
+            hole = next;
+        }
+    }
+    _index[hole] = 0;
+
+    /* Entries after the removed one move down by one. */
+    for (uint32_t &value : _index) {
+        if (value > index + 1) {
+            value--;
+        }
+    }
+}
+
+void Dictionary::
+rebuildIndex()
+{
+    _index.clear();
+    if (_entries.size() <= IndexThreshold) {
+        return;
+    }
+
+    /* Keep the index at most half full so probe sequences stay short. */
+    size_t size = IndexThreshold * 4;
+    while (size < _entries.size() * 2) {
+        size *= 2;
+    }
+
+    _index.resize(size, 0);
+    for (size_t n = 0; n < _entries.size(); n++) {
+        insertIndex(n);
+    }
+}
+
+void Dictionary::
+set(std::string const &key, std::unique_ptr<Object> obj)
+{
+    remove(key);
+
+    _entries.push_back(std::make_pair(key, std::move(obj)));
+    if (_entries.size() * 2 > _index.size()) {
+        rebuildIndex();
+    } else {
+        insertIndex(_entries.size() - 1);
+    }
+}
+
+void Dictionary::
+remove(std::string const &key)
+{
+    Entry const *entry = find(key);
+    if (entry == nullptr) {
+        return;
+    }
+
+    size_t index = entry - _entries.data();
+    if (!_index.empty()) {
+        removeIndex(index);
+    }
+    _entries.erase(_entries.begin() + index);
+
+    if (_entries.size() <= IndexThreshold) {
+        _index.clear();
+    }
+}
+
 std::unique_ptr<Object> Dictionary::
 _copy() const
 {
     auto result = Dictionary::New();
-    for (size_t n = 0; n < count(); n++) {
-        result->set(key(n), value(n)->copy());
+    result->_entries.reserve(_entries.size());
+    for (Entry const &entry : _entries) {
+        result->_entries.push_back(std::make_pair(entry.first, entry.second->copy()));
     }
+    result->rebuildIndex();
     return plist::static_unique_pointer_cast<Object>(std::move(result));
 }
 
@@ -35,7 +162,7 @@ merge(Dictionary const *dict, bool replace)
         return;
 
     for (auto const &key : *dict) {
-        if (replace || _map.find(key) == _map.end()) {
+        if (replace || find(key) == nullptr) {
             set(key, dict->value(key)->copy());
         }
     }
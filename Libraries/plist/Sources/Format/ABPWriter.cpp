@@ -48,8 +48,12 @@ __ABPWriteOffsetTable(ABPContext *context)
     /* Update offset in trailer. */
     context->trailer.offsetTableEndOffset = __ABPTell(context);
 
-    /* Highest offset is offset table offset */
-    highestOffset = context->trailer.offsetTableEndOffset;
+    /* Highest offset is the last object written. */
+    highestOffset = 0;
+    for (n = 0; n < context->trailer.objectsCount; n++) {
+        if (context->offsets[n] > highestOffset)
+            highestOffset = context->offsets[n];
+    }
 
     /* Estimate offset integer size. */
     if (highestOffset > UINT32_MAX) {
@@ -694,13 +698,13 @@ ABPWriteTopLevelObject(ABPContext *context, Object const *object)
     success = _ABPWritePreflightObject(context, object,
             kABPWriteObjectTopLevel);
     if (success) {
-        /* Estimate the object reference size. */
-        uint64_t nrefs = context->references.size();
-        if (nrefs > UINT32_MAX) {
+        /* Size object references to fit the highest reference. */
+        uint64_t highestRef = context->references.size() - 1;
+        if (highestRef > UINT32_MAX) {
             context->trailer.objectRefByteSize = sizeof(uint64_t);
-        } else if (nrefs > UINT16_MAX) {
+        } else if (highestRef > UINT16_MAX) {
             context->trailer.objectRefByteSize = sizeof(uint32_t);
-        } else if (nrefs > UINT8_MAX) {
+        } else if (highestRef > UINT8_MAX) {
             context->trailer.objectRefByteSize = sizeof(uint16_t);
         } else {
             context->trailer.objectRefByteSize = sizeof(uint8_t);
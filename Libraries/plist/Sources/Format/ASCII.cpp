@@ -9,6 +9,7 @@
 
 #include <plist/Format/ASCII.h>
 #include <plist/Format/ASCIIParser.h>
+#include <plist/Format/Builder.h>
 #include <plist/Format/ASCIIWriter.h>
 #include <plist/Objects.h>
 
@@ -16,6 +17,8 @@ using plist::Format::Type;
 using plist::Format::Encoding;
 using plist::Format::Format;
 using plist::Format::ASCII;
+using plist::Format::Builder;
+using plist::Format::Handler;
 using plist::Object;
 
 ASCII::
@@ -222,24 +225,13 @@ template<>
 std::pair<std::unique_ptr<Object>, std::string> Format<ASCII>::
 Deserialize(std::vector<uint8_t> const &contents, ASCII const &format)
 {
-    std::unique_ptr<Object> root = nullptr;
-    std::string             error;
-
-    std::vector<uint8_t> const data = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
-
-    /* Create lexer. */
-    ASCIIPListLexer lexer;
-    ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(data.data()), data.size(), kASCIIPListLexerStyleASCII);
-
-    /* Parse contents. */
-    ASCIIParser parser;
-    if (parser.parse(&lexer, format.strings())) {
-        root = std::move(parser.root());
-    } else {
-        error = parser.error();
+    Builder builder;
+    std::pair<bool, std::string> result = ASCII::Parse(contents, format, &builder);
+    if (!result.first) {
+        return std::make_pair(nullptr, result.second);
     }
 
-    return std::make_pair(std::move(root), error);
+    return std::make_pair(std::move(builder.root()), std::string());
 }
 
 template<>
@@ -267,3 +259,22 @@ Create(bool strings, Encoding encoding)
 {
     return ASCII(strings, encoding);
 }
+
+std::pair<bool, std::string> ASCII::
+Parse(std::vector<uint8_t> const &contents, ASCII const &format, Handler *handler)
+{
+    std::vector<uint8_t> buffer;
+    std::pair<uint8_t const *, size_t> data = Encodings::Convert(contents, format.encoding(), Encoding::UTF8, &buffer);
+
+    /* Create lexer. */
+    ASCIIPListLexer lexer;
+    ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(data.first), data.second, kASCIIPListLexerStyleASCII);
+
+    /* Parse contents. */
+    ASCIIParser parser = ASCIIParser(handler);
+    if (!parser.parse(&lexer, format.strings())) {
+        return std::make_pair(false, parser.error());
+    }
+
+    return std::make_pair(true, std::string());
+}
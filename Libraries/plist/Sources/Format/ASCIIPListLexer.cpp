@@ -68,6 +68,58 @@
 
 /** Helpers **/
 
+/*
+ * Character classes, so scanning loops test each character with a single
+ * table lookup instead of a chain of comparisons.
+ */
+enum {
+    kCharClassSpace          = 1 << 0, /* Whitespace other than newlines. */
+    kCharClassKeyword        = 1 << 1, /* Characters in unquoted strings. */
+    kCharClassDoubleQuoteEnd = 1 << 2, /* Characters a double-quoted string stops at. */
+    kCharClassSingleQuoteEnd = 1 << 3, /* Characters a single-quoted string stops at. */
+    kCharClassCommentEnd     = 1 << 4, /* Characters a long comment stops at. */
+};
+
+struct CharClasses {
+    uint8_t classes[256];
+
+    CharClasses()
+    {
+        memset(classes, 0, sizeof(classes));
+
+        for (char const *c = " \f\t\r"; *c != '\0'; c++) {
+            classes[(uint8_t)*c] |= kCharClassSpace;
+        }
+
+        for (int c = '0'; c <= '9'; c++) {
+            classes[c] |= kCharClassKeyword;
+        }
+        for (int c = 'a'; c <= 'z'; c++) {
+            classes[c] |= kCharClassKeyword;
+        }
+        for (int c = 'A'; c <= 'Z'; c++) {
+            classes[c] |= kCharClassKeyword;
+        }
+        /* '$' is encountered in pbxproj files. */
+        for (char const *c = "_.$-:/"; *c != '\0'; c++) {
+            classes[(uint8_t)*c] |= kCharClassKeyword;
+        }
+
+        classes[(uint8_t)'\0'] |= kCharClassDoubleQuoteEnd | kCharClassSingleQuoteEnd | kCharClassCommentEnd;
+        classes[(uint8_t)'\n'] |= kCharClassDoubleQuoteEnd | kCharClassSingleQuoteEnd | kCharClassCommentEnd;
+        classes[(uint8_t)'\"'] |= kCharClassDoubleQuoteEnd;
+        classes[(uint8_t)'\\'] |= kCharClassDoubleQuoteEnd;
+        classes[(uint8_t)'\''] |= kCharClassSingleQuoteEnd;
+        classes[(uint8_t)'*'] |= kCharClassCommentEnd;
+    }
+};
+
+static CharClasses const sCharClasses;
+
+static inline bool
+ischarclass(char ch, int charClass)
+{ return (sCharClasses.classes[(uint8_t)ch] & charClass) != 0; }
+
 static inline bool
 istokenseparator(char ch, ASCIIPListLexer *lexer)
 {
@@ -107,7 +159,7 @@ ASCIIPListLexerReadInlineComment(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 2;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\0' && *p != '\n' && *p != '\r'; p++)
+    for (b = p; p < lexer->endBuffer && *p != '\0' && *p != '\n' && *p != '\r'; p++)
         ;
     lexer->tokenLength = p - b;
     lexer->pointer = p;
@@ -121,11 +173,17 @@ ASCIIPListLexerReadLongComment(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 2;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\0'; p++) {
-        if (p[0] == '\n') {
+    for (b = p; p < lexer->endBuffer; p++) {
+        while (p < lexer->endBuffer && !ischarclass(*p, kCharClassCommentEnd)) {
+            p++;
+        }
+
+        if (p == lexer->endBuffer || p[0] == '\0') {
+            break;
+        } else if (p[0] == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
-        } else if (p[0] == '*' && p[1] == '/') {
+        } else if (p[0] == '*' && p + 1 < lexer->endBuffer && p[1] == '/') {
             lexer->tokenLength = p - b;
             lexer->pointer = p + 2;
             return kASCIIPListLexerTokenLongComment;
@@ -141,14 +199,20 @@ ASCIIPListLexerReadSingleQuotedString(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 1;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\'' && *p != '\0'; p++) {
-        if (*p == '\n') {
-            lexer->line++;
-            lexer->lineStart = p + 1;
+    for (b = p; p < lexer->endBuffer; p++) {
+        while (p < lexer->endBuffer && !ischarclass(*p, kCharClassSingleQuoteEnd)) {
+            p++;
+        }
+
+        if (p == lexer->endBuffer || *p != '\n') {
+            break;
         }
+
+        lexer->line++;
+        lexer->lineStart = p + 1;
     }
 
-    if (*p != '\'') {
+    if (p == lexer->endBuffer || *p != '\'') {
         return kASCIIPListLexerUnterminatedQuotedString;
     }
 
@@ -164,8 +228,14 @@ ASCIIPListLexerReadDoubleQuotedString(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 1;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\"' && *p != '\0'; p++) {
-        if (*p == '\n') {
+    for (b = p; p < lexer->endBuffer; p++) {
+        while (p < lexer->endBuffer && !ischarclass(*p, kCharClassDoubleQuoteEnd)) {
+            p++;
+        }
+
+        if (p == lexer->endBuffer || *p == '\"' || *p == '\0') {
+            break;
+        } else if (*p == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
         } else if (*p == '\\') {
@@ -173,7 +243,7 @@ ASCIIPListLexerReadDoubleQuotedString(ASCIIPListLexer *lexer)
         }
     }
 
-    if (*p != '\"') {
+    if (p >= lexer->endBuffer || *p != '\"') {
         return kASCIIPListLexerUnterminatedQuotedString;
     }
 
@@ -189,7 +259,7 @@ ASCIIPListLexerReadData(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 1;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '>' && *p != '\0'; p++) {
+    for (b = p; p < lexer->endBuffer && *p != '>' && *p != '\0'; p++) {
         if (*p == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
@@ -203,7 +273,7 @@ ASCIIPListLexerReadData(ASCIIPListLexer *lexer)
         }
     }
 
-    if (*p != '>')
+    if (p == lexer->endBuffer || *p != '>')
         return kASCIIPListLexerUnterminatedData;
 
     lexer->tokenLength = p - b;
@@ -313,15 +383,7 @@ ASCIIPListLexerReadKeyword(ASCIIPListLexer *lexer)
         }
     } else if (lexer->style == kASCIIPListLexerStyleASCII) {
         rc = kASCIIPListLexerTokenUnquotedString;
-        /*
-            * '$' is encountered in pbxproj files.
-            */
-        while (isalnum(*p) || *p == '_' || *p == '.' || *p == '$' ||
-                              *p == '-' || *p == ':' || *p == '/') {
-            if (*p & 0x80) {
-                rc = kASCIIPListLexerInvalidToken;
-                break;
-            }
+        while (p < lexer->endBuffer && ischarclass(*p, kCharClassKeyword)) {
             p++;
         }
     } else {
@@ -443,7 +505,8 @@ ASCIIPListLexerReadToken(ASCIIPListLexer *lexer)
                 return ASCIIPListLexerReadKeyword(lexer);
 
             case ' ': case '\f': case '\t': case '\r':
-                 p++;
+                 for (p++; p < lexer->endBuffer && ischarclass(*p, kCharClassSpace); p++)
+                     ;
                  break;
 
             case '\n':
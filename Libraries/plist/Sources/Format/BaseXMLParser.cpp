@@ -9,22 +9,634 @@
 
 #include <plist/Format/BaseXMLParser.h>
 
+#include <algorithm>
+#include <cctype>
 #include <cerrno>
 #include <cstdlib>
+#include <cstring>
+#include <strings.h>
 
 using plist::Format::BaseXMLParser;
 
 BaseXMLParser::BaseXMLParser() :
-    _parser (nullptr),
-    _depth  (0)
+    _parser   (nullptr),
+    _depth    (0),
+    _begin    (nullptr),
+    _position (nullptr),
+    _failed   (false)
 {
 }
 
 bool BaseXMLParser::
-parse(std::vector<uint8_t> const &contents)
+parse(uint8_t const *data, size_t size)
+{
+    char const *begin = reinterpret_cast<char const *>(data);
+    Result result = parseSimple(begin, begin + size);
+    if (result != Result::Unsupported) {
+        return (result == Result::Success);
+    }
+
+    return parseReader(data, size);
+}
+
+static inline bool
+IsSpace(char c)
+{
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+}
+
+/*
+ * Only ASCII names; others are left to libxml2.
+ */
+static inline bool
+IsNameStart(char c)
+{
+    return ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':');
+}
+
+static inline bool
+IsNameCharacter(char c)
+{
+    return (IsNameStart(c) || (c >= '0' && c <= '9') || c == '-' || c == '.');
+}
+
+static bool
+IsBlank(std::string const &text)
+{
+    for (char c : text) {
+        if (!IsSpace(c)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static char const *
+SkipSpace(char const *p, char const *end)
+{
+    while (p != end && IsSpace(*p)) {
+        p++;
+    }
+
+    return p;
+}
+
+/*
+ * Skip a name, or nothing if there isn't one.
+ */
+static char const *
+SkipName(char const *p, char const *end)
+{
+    if (p == end || !IsNameStart(*p)) {
+        return p;
+    }
+
+    do {
+        p++;
+    } while (p != end && IsNameCharacter(*p));
+
+    return p;
+}
+
+static bool
+StartsWith(char const *p, char const *end, char const *prefix)
+{
+    size_t length = ::strlen(prefix);
+    return (static_cast<size_t>(end - p) >= length && ::memcmp(p, prefix, length) == 0);
+}
+
+/*
+ * Find a string; the first character is found with memchr(), which the C
+ * library vectorizes.
+ */
+static char const *
+Find(char const *p, char const *end, char const *needle)
+{
+    size_t length = ::strlen(needle);
+    while (static_cast<size_t>(end - p) >= length) {
+        p = static_cast<char const *>(::memchr(p, needle[0], (end - p) - length + 1));
+        if (p == nullptr) {
+            return nullptr;
+        }
+        if (::memcmp(p, needle, length) == 0) {
+            return p;
+        }
+        p++;
+    }
+
+    return nullptr;
+}
+
+static inline bool
+IsCharacter(unsigned long c)
+{
+    /* Only characters allowed in XML. */
+    return (c == 0x9 || c == 0xA || c == 0xD || (c >= 0x20 && c <= 0xD7FF) || (c >= 0xE000 && c <= 0xFFFD) || (c >= 0x10000 && c <= 0x10FFFF));
+}
+
+/*
+ * If text is valid UTF-8 holding only characters allowed in XML. Carriage
+ * returns are also rejected, since libxml2 normalizes line endings.
+ */
+static bool
+IsValidText(char const *p, char const *end)
+{
+    uint8_t const *q = reinterpret_cast<uint8_t const *>(p);
+    uint8_t const *qend = reinterpret_cast<uint8_t const *>(end);
+
+    while (q != qend) {
+        uint8_t byte = *q;
+        if (byte < 0x80) {
+            if (byte < 0x20 && byte != '\t' && byte != '\n') {
+                return false;
+            }
+            q++;
+            continue;
+        }
+
+        size_t length;
+        unsigned long c;
+        unsigned long minimum;
+        if ((byte & 0xE0) == 0xC0) {
+            length = 2;
+            c = byte & 0x1F;
+            minimum = 0x80;
+        } else if ((byte & 0xF0) == 0xE0) {
+            length = 3;
+            c = byte & 0x0F;
+            minimum = 0x800;
+        } else if ((byte & 0xF8) == 0xF0) {
+            length = 4;
+            c = byte & 0x07;
+            minimum = 0x10000;
+        } else {
+            return false;
+        }
+
+        if (static_cast<size_t>(qend - q) < length) {
+            return false;
+        }
+
+        for (size_t n = 1; n < length; ++n) {
+            if ((q[n] & 0xC0) != 0x80) {
+                return false;
+            }
+            c = (c << 6) | (q[n] & 0x3F);
+        }
+
+        /* No overlong forms, and no surrogates, which aren't characters. */
+        if (c < minimum || !IsCharacter(c)) {
+            return false;
+        }
+
+        q += length;
+    }
+
+    return true;
+}
+
+static bool
+AppendCharacter(std::string *result, unsigned long c)
+{
+    if (!IsCharacter(c)) {
+        return false;
+    }
+
+    if (c < 0x80) {
+        result->push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+        result->push_back(static_cast<char>(0xC0 | (c >> 6)));
+        result->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else if (c < 0x10000) {
+        result->push_back(static_cast<char>(0xE0 | (c >> 12)));
+        result->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        result->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else {
+        result->push_back(static_cast<char>(0xF0 | (c >> 18)));
+        result->push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+        result->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        result->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    }
+
+    return true;
+}
+
+/*
+ * Append text with references to the predefined entities and characters
+ * replaced. Attribute values also have their whitespace normalized.
+ */
+static bool
+AppendDecoded(std::string *result, char const *p, char const *end, bool attribute)
+{
+    while (p != end) {
+        char const *amp = static_cast<char const *>(::memchr(p, '&', end - p));
+        char const *chunk = (amp != nullptr ? amp : end);
+
+        size_t offset = result->size();
+        result->append(p, chunk);
+        if (attribute) {
+            for (auto it = result->begin() + offset; it != result->end(); ++it) {
+                if (*it == '<') {
+                    return false;
+                } else if (IsSpace(*it)) {
+                    *it = ' ';
+                }
+            }
+        }
+
+        if (amp == nullptr) {
+            break;
+        }
+
+        char const *semicolon = static_cast<char const *>(::memchr(amp, ';', std::min<size_t>(end - amp, 12)));
+        if (semicolon == nullptr) {
+            return false;
+        }
+
+        std::string name = std::string(amp + 1, semicolon);
+        if (name == "lt") {
+            result->push_back('<');
+        } else if (name == "gt") {
+            result->push_back('>');
+        } else if (name == "amp") {
+            result->push_back('&');
+        } else if (name == "quot") {
+            result->push_back('"');
+        } else if (name == "apos") {
+            result->push_back('\'');
+        } else if (name.size() > 1 && name[0] == '#') {
+            bool hex = (name[1] == 'x');
+            char const *digits = name.c_str() + (hex ? 2 : 1);
+            if (*digits == '\0' || !(hex ? ::isxdigit(*digits) : ::isdigit(*digits))) {
+                return false;
+            }
+
+            char *digitsEnd = nullptr;
+            unsigned long c = ::strtoul(digits, &digitsEnd, hex ? 16 : 10);
+            if (*digitsEnd != '\0' || !AppendCharacter(result, c)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+
+        p = semicolon + 1;
+    }
+
+    return true;
+}
+
+/*
+ * Parse a pseudo-attribute of the declaration: whitespace, then the name
+ * and a quoted value. Nothing is skipped if it isn't there.
+ */
+static bool
+ParsePseudoAttribute(char const **p, char const *end, char const *name, std::string *value)
+{
+    char const *q = SkipSpace(*p, end);
+    if (q == *p || !StartsWith(q, end, name)) {
+        return false;
+    }
+
+    q = SkipSpace(q + ::strlen(name), end);
+    if (q == end || *q != '=') {
+        return false;
+    }
+
+    q = SkipSpace(q + 1, end);
+    if (q == end || (*q != '"' && *q != '\'')) {
+        return false;
+    }
+
+    char const *valueEnd = static_cast<char const *>(::memchr(q + 1, *q, end - (q + 1)));
+    if (valueEnd == nullptr) {
+        return false;
+    }
+
+    value->assign(q + 1, valueEnd);
+    *p = valueEnd + 1;
+    return true;
+}
+
+/*
+ * If the inside of a declaration is exactly what's expected: version 1.0,
+ * then optionally UTF-8 encoding and standalone, in that order.
+ */
+static bool
+IsSimpleDeclaration(char const *p, char const *end)
+{
+    std::string value;
+    if (!ParsePseudoAttribute(&p, end, "version", &value) || value != "1.0") {
+        return false;
+    }
+
+    if (ParsePseudoAttribute(&p, end, "encoding", &value) && ::strcasecmp(value.c_str(), "UTF-8") != 0) {
+        return false;
+    }
+
+    if (ParsePseudoAttribute(&p, end, "standalone", &value) && value != "yes" && value != "no") {
+        return false;
+    }
+
+    return (SkipSpace(p, end) == end);
+}
+
+static inline bool
+IsPublicIdentifierCharacter(char c)
+{
+    return ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || (c != '\0' && ::strchr(" \n-'()+,./:=?;!*#@$_%", c) != nullptr));
+}
+
+/*
+ * Skip a quoted public identifier or system literal, or return null if
+ * there isn't a valid one.
+ */
+static char const *
+SkipLiteral(char const *p, char const *end, bool publicIdentifier)
+{
+    if (p == end || (*p != '"' && *p != '\'')) {
+        return nullptr;
+    }
+
+    char const *value = p + 1;
+    char const *valueEnd = static_cast<char const *>(::memchr(value, *p, end - value));
+    if (valueEnd == nullptr) {
+        return nullptr;
+    }
+
+    if (publicIdentifier) {
+        if (!std::all_of(value, valueEnd, &IsPublicIdentifierCharacter)) {
+            return nullptr;
+        }
+    } else if (!IsValidText(value, valueEnd)) {
+        return nullptr;
+    }
+
+    return valueEnd + 1;
+}
+
+/*
+ * Skip the rest of a document type declaration after "<!DOCTYPE", or return
+ * null if it isn't a name with an optional external identifier. An internal
+ * subset could define entities, so it's left to libxml2.
+ */
+static char const *
+SkipDocumentType(char const *p, char const *end)
+{
+    char const *q = SkipSpace(p, end);
+    char const *nameEnd = SkipName(q, end);
+    if (q == p || nameEnd == q) {
+        return nullptr;
+    }
+
+    p = nameEnd;
+    q = SkipSpace(p, end);
+    if (q != p && (StartsWith(q, end, "PUBLIC") || StartsWith(q, end, "SYSTEM"))) {
+        bool publicIdentifier = StartsWith(q, end, "PUBLIC");
+
+        p = q + 6;
+        q = SkipSpace(p, end);
+        if (q == p || (p = SkipLiteral(q, end, publicIdentifier)) == nullptr) {
+            return nullptr;
+        }
+
+        if (publicIdentifier) {
+            q = SkipSpace(p, end);
+            if (q == p || (p = SkipLiteral(q, end, false)) == nullptr) {
+                return nullptr;
+            }
+        }
+
+        q = SkipSpace(p, end);
+    }
+
+    if (q == end || *q != '>') {
+        return nullptr;
+    }
+
+    return q + 1;
+}
+
+BaseXMLParser::Result BaseXMLParser::
+parseSimple(char const *begin, char const *end)
+{
+    _depth    = 0;
+    _begin    = begin;
+    _position = begin;
+    _failed   = false;
+
+    onBeginParse();
+
+    /* Only the start of each open element's name is kept. */
+    std::vector<char const *> open;
+    bool root = false;
+    bool documentType = false;
+
+    auto finish = [&](Result result) -> Result {
+        _depth = 0;
+        _begin = nullptr;
+        _position = nullptr;
+
+        onEndParse(result == Result::Success);
+        return result;
+    };
+
+    auto matches = [&](char const *name, char const *nameEnd) -> bool {
+        size_t length = nameEnd - name;
+        return (SkipName(open.back(), end) - open.back() == static_cast<ptrdiff_t>(length) && ::memcmp(open.back(), name, length) == 0);
+    };
+
+    char const *p = begin;
+
+    /* Byte order mark. */
+    if (StartsWith(p, end, "\xEF\xBB\xBF")) {
+        p += 3;
+    }
+
+    /* The declaration must be first, and anything but UTF-8 left to libxml2. */
+    if (StartsWith(p, end, "<?xml") && p + 5 != end && IsSpace(p[5])) {
+        char const *declarationEnd = Find(p, end, "?>");
+        if (declarationEnd == nullptr || !IsSimpleDeclaration(p + 5, declarationEnd)) {
+            return finish(Result::Unsupported);
+        }
+
+        p = declarationEnd + 2;
+    }
+
+    while (p != end) {
+        char const *lt = static_cast<char const *>(::memchr(p, '<', end - p));
+        char const *textEnd = (lt != nullptr ? lt : end);
+
+        if (textEnd != p) {
+            _position = p;
+
+            if (open.empty()) {
+                /* Only whitespace outside of the root element. */
+                if (SkipSpace(p, textEnd) != textEnd) {
+                    return finish(Result::Unsupported);
+                }
+            } else {
+                if (!IsValidText(p, textEnd) || Find(p, textEnd, "]]>") != nullptr) {
+                    return finish(Result::Unsupported);
+                }
+
+                _text.clear();
+                if (!AppendDecoded(&_text, p, textEnd, false)) {
+                    return finish(Result::Unsupported);
+                }
+
+                /* Like the reader, whitespace between elements isn't text. */
+                if (!IsBlank(_text)) {
+                    _depth = open.size();
+                    onCharacterData(_text, _depth);
+                    if (_failed) {
+                        return finish(Result::Failure);
+                    }
+                }
+            }
+        }
+
+        if (lt == nullptr) {
+            break;
+        }
+
+        p = lt;
+        _position = p;
+
+        if (StartsWith(p, end, "<!--")) {
+            /* Comments can't contain "--" other than at their end. */
+            char const *commentEnd = Find(p + 4, end, "--");
+            if (commentEnd == nullptr || !StartsWith(commentEnd, end, "-->") || !IsValidText(p + 4, commentEnd)) {
+                return finish(Result::Unsupported);
+            }
+
+            p = commentEnd + 3;
+        } else if (StartsWith(p, end, "<!DOCTYPE") && open.empty() && !root && !documentType) {
+            p = SkipDocumentType(p + 9, end);
+            if (p == nullptr) {
+                return finish(Result::Unsupported);
+            }
+
+            documentType = true;
+        } else if (StartsWith(p, end, "<!") || StartsWith(p, end, "<?")) {
+            return finish(Result::Unsupported);
+        } else if (StartsWith(p, end, "</")) {
+            char const *name = p + 2;
+            char const *nameEnd = SkipName(name, end);
+            p = SkipSpace(nameEnd, end);
+            if (p == end || *p != '>' || open.empty() || !matches(name, nameEnd)) {
+                return finish(Result::Unsupported);
+            }
+            p++;
+
+            open.pop_back();
+
+            _depth = open.size();
+            _name.assign(name, nameEnd);
+            onEndElement(_name, _depth);
+            if (_failed) {
+                return finish(Result::Failure);
+            }
+        } else {
+            /* A single root element. */
+            if (open.empty() && root) {
+                return finish(Result::Unsupported);
+            }
+
+            char const *name = p + 1;
+            char const *nameEnd = SkipName(name, end);
+            if (nameEnd == name) {
+                return finish(Result::Unsupported);
+            }
+            p = nameEnd;
+
+            _attributes.clear();
+
+            bool empty;
+            while (true) {
+                char const *separator = p;
+                p = SkipSpace(p, end);
+                if (p == end) {
+                    return finish(Result::Unsupported);
+                } else if (*p == '>') {
+                    empty = false;
+                    p++;
+                    break;
+                } else if (StartsWith(p, end, "/>")) {
+                    empty = true;
+                    p += 2;
+                    break;
+                } else if (p == separator) {
+                    return finish(Result::Unsupported);
+                }
+
+                char const *attribute = p;
+                char const *attributeEnd = SkipName(attribute, end);
+                p = SkipSpace(attributeEnd, end);
+                if (attributeEnd == attribute || p == end || *p != '=') {
+                    return finish(Result::Unsupported);
+                }
+
+                p = SkipSpace(p + 1, end);
+                if (p == end || (*p != '"' && *p != '\'')) {
+                    return finish(Result::Unsupported);
+                }
+
+                char const *value = p + 1;
+                char const *valueEnd = static_cast<char const *>(::memchr(value, *p, end - value));
+                if (valueEnd == nullptr) {
+                    return finish(Result::Unsupported);
+                }
+                p = valueEnd + 1;
+
+                std::string attributeName = std::string(attribute, attributeEnd);
+                for (std::pair<std::string, std::string> const &existing : _attributes) {
+                    if (existing.first == attributeName) {
+                        return finish(Result::Unsupported);
+                    }
+                }
+
+                std::string attributeValue;
+                if (!IsValidText(value, valueEnd) || !AppendDecoded(&attributeValue, value, valueEnd, true)) {
+                    return finish(Result::Unsupported);
+                }
+
+                _attributes.push_back({ std::move(attributeName), std::move(attributeValue) });
+            }
+
+            root = true;
+
+            _depth = open.size();
+            _name.assign(name, nameEnd);
+            onStartElement(_name, _attributes, _depth);
+            if (_failed) {
+                return finish(Result::Failure);
+            }
+
+            if (empty) {
+                onEndElement(_name, _depth);
+                if (_failed) {
+                    return finish(Result::Failure);
+                }
+            } else {
+                open.push_back(name);
+            }
+        }
+    }
+
+    if (!root || !open.empty()) {
+        return finish(Result::Unsupported);
+    }
+
+    return finish(Result::Success);
+}
+
+bool BaseXMLParser::
+parseReader(uint8_t const *data, size_t size)
 {
     _depth  = 0;
-    _parser = ::xmlReaderForMemory(reinterpret_cast<char const *>(contents.data()), contents.size(), nullptr, nullptr, XML_PARSE_NOENT | XML_PARSE_NONET);
+    _parser = ::xmlReaderForMemory(reinterpret_cast<char const *>(data), size, nullptr, nullptr, XML_PARSE_NOENT | XML_PARSE_NONET);
     if (_parser == nullptr) {
         return false;
     }
@@ -37,14 +649,14 @@ parse(std::vector<uint8_t> const &contents)
 
         int type = xmlTextReaderNodeType(_parser);
         if (type == 1 /* Start element. */) {
-            std::unordered_map<std::string, std::string> attrs;
+            _attributes.clear();
 
             ret = xmlTextReaderMoveToFirstAttribute(_parser);
             while (ret == 1) {
                 /* Store attribute. */
                 xmlChar const *name = xmlTextReaderConstName(_parser);
                 xmlChar const *value = xmlTextReaderConstValue(_parser);
-                attrs[std::string(reinterpret_cast<char const *>(name))] = std::string(reinterpret_cast<char const *>(value));
+                _attributes.push_back({ std::string(reinterpret_cast<char const *>(name)), std::string(reinterpret_cast<char const *>(value)) });
 
                 ret = xmlTextReaderMoveToNextAttribute(_parser);
             }
@@ -66,7 +678,7 @@ parse(std::vector<uint8_t> const &contents)
             }
 
             xmlChar const *name = xmlTextReaderConstName(_parser);
-            onStartElement(std::string(reinterpret_cast<char const *>(name)), attrs, _depth);
+            onStartElement(std::string(reinterpret_cast<char const *>(name)), _attributes, _depth);
 
             if (ret == 1) {
                 /* Empty element. */
@@ -109,7 +721,7 @@ onEndParse(bool success)
 }
 
 void BaseXMLParser::
-onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t depth)
+onStartElement(std::string const &name, Attributes const &attrs, size_t depth)
 {
 }
 
@@ -137,14 +749,29 @@ error(std::string format, ...)
     }
     va_end(ap);
 
-    _line = ::xmlTextReaderGetParserLineNumber(_parser);
-    _column = ::xmlTextReaderGetParserColumnNumber(_parser);
+    if (_parser != nullptr) {
+        _line = ::xmlTextReaderGetParserLineNumber(_parser);
+        _column = ::xmlTextReaderGetParserColumnNumber(_parser);
+    } else if (_begin != nullptr) {
+        _line = 1;
+        char const *lineBegin = _begin;
+        for (char const *p = _begin; p != _position; p++) {
+            if (*p == '\n') {
+                _line++;
+                lineBegin = p + 1;
+            }
+        }
+        _column = (_position - lineBegin) + 1;
+    }
     _error = std::string(buf);
+    _failed = true;
 
     if (buf != sErrorMessage) {
         ::free(buf);
     }
 
-    ::xmlFreeTextReader(_parser);
-    _parser = nullptr;
+    if (_parser != nullptr) {
+        ::xmlFreeTextReader(_parser);
+        _parser = nullptr;
+    }
 }
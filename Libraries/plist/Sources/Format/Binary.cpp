@@ -14,6 +14,7 @@
 
 #include <cerrno>
 #include <cstring>
+#include <unordered_map>
 
 using plist::Format::Type;
 using plist::Format::Format;
@@ -248,6 +249,7 @@ Create(void *opaque, ABPRecordType type, void *arg1, void *arg2, void *arg3)
             size_t    nrefs = *reinterpret_cast <size_t *> (arg2);
 
             auto dict = Dictionary::New();
+            dict->reserve(nrefs);
 
             for (size_t n = 0; n < nrefs; n++) {
                 auto keyObject = ::ABPReadObject(&self->context, refs[n * 2 + 0]);
@@ -337,6 +339,18 @@ struct BinaryWriteContext {
 
     std::vector<uint8_t>          contents;
     off_t                         offset;
+
+    /*
+     * The first object seen with each value, so equal values are only
+     * written once and then shared by reference.
+     */
+    std::unordered_map<std::string, Object const *> strings;
+    std::unordered_map<std::string, Object const *> datas;
+    std::unordered_map<int64_t, Object const *>     integers;
+    std::unordered_map<uint64_t, Object const *>    reals;
+    std::unordered_map<uint64_t, Object const *>    dates;
+    std::unordered_map<uint64_t, Object const *>    uids;
+    Object const                                   *booleans[2];
 };
 
 static off_t
@@ -371,20 +385,61 @@ WriteData(void *opaque, void const *buffer, size_t size)
 {
     auto self = reinterpret_cast <BinaryWriteContext *> (opaque);
 
-    ssize_t needed = (self->contents.size() - self->offset + size);
-    if (needed > 0) {
-        self->contents.resize(self->contents.size() + needed);
-    }
+    uint8_t const *bytes = static_cast<uint8_t const *>(buffer);
+    if (static_cast<size_t>(self->offset) == self->contents.size()) {
+        /* Appending, which is almost every write. */
+        self->contents.insert(self->contents.end(), bytes, bytes + size);
+    } else {
+        if (self->offset + size > self->contents.size()) {
+            self->contents.resize(self->offset + size);
+        }
 
-    /* Copy into read buffer. */
-    ::memcpy(self->contents.data() + self->offset, buffer, size);
+        /* Copy into write buffer. */
+        ::memcpy(self->contents.data() + self->offset, bytes, size);
+    }
 
     self->offset += size;
     return size;
 }
 
-bool Process(void *opaque, plist::Object const **object)
+template<typename K>
+static Object const *
+Unique(std::unordered_map<K, Object const *> *objects, K const &key, Object const *object)
 {
+    return objects->insert({ key, object }).first->second;
+}
+
+static bool
+Process(void *opaque, plist::Object const **object)
+{
+    auto self = reinterpret_cast <BinaryWriteContext *> (opaque);
+    Object const *value = *object;
+
+    if (String const *string = CastTo<String>(value)) {
+        *object = Unique(&self->strings, string->value(), value);
+    } else if (Integer const *integer = CastTo<Integer>(value)) {
+        *object = Unique(&self->integers, integer->value(), value);
+    } else if (Real const *real = CastTo<Real>(value)) {
+        /* Compare bit patterns, so zero and negative zero stay distinct. */
+        uint64_t bits;
+        double number = real->value();
+        ::memcpy(&bits, &number, sizeof(bits));
+        *object = Unique(&self->reals, bits, value);
+    } else if (Date const *date = CastTo<Date>(value)) {
+        *object = Unique(&self->dates, date->unixTimeValue(), value);
+    } else if (Data const *data = CastTo<Data>(value)) {
+        std::string bytes = std::string(data->value().begin(), data->value().end());
+        *object = Unique(&self->datas, bytes, value);
+    } else if (UID const *uid = CastTo<UID>(value)) {
+        *object = Unique(&self->uids, static_cast<uint64_t>(uid->value()), value);
+    } else if (Boolean const *boolean = CastTo<Boolean>(value)) {
+        Object const **unique = &self->booleans[boolean->value() ? 1 : 0];
+        if (*unique == nullptr) {
+            *unique = value;
+        }
+        *object = *unique;
+    }
+
     return true;
 }
 
@@ -402,9 +457,13 @@ Serialize(Object const *object, Binary const &format)
     writeContext.streamCallBacks.read    = nullptr;
 
     writeContext.processCallBacks.version = 0;
-    writeContext.processCallBacks.opaque = nullptr;
+    writeContext.processCallBacks.opaque = &writeContext;
     writeContext.processCallBacks.process = &Process;
 
+    writeContext.offset      = 0;
+    writeContext.booleans[0] = nullptr;
+    writeContext.booleans[1] = nullptr;
+
     bool success;
     success = ::ABPWriterInit(&writeContext.context, &writeContext.streamCallBacks, &writeContext.processCallBacks);
     if (!success) {
@@ -431,7 +490,7 @@ Serialize(Object const *object, Binary const &format)
         return std::make_pair(nullptr, "close failed");
     }
 
-    return std::make_pair(std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(writeContext.contents.begin(), writeContext.contents.end())), std::string());
+    return std::make_pair(std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(std::move(writeContext.contents))), std::string());
 }
 
 } }
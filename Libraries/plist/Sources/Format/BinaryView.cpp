@@ -0,0 +1,448 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Format/BinaryView.h>
+#include <plist/Format/Encoding.h>
+#include <plist/Format/abplist-format.h>
+#include <plist/Objects.h>
+
+#include <cstring>
+
+using plist::Format::BinaryView;
+using plist::Format::Encoding;
+using plist::Format::Encodings;
+using plist::Object;
+using plist::ObjectType;
+using plist::String;
+using plist::Integer;
+using plist::Real;
+using plist::Boolean;
+using plist::Null;
+using plist::Data;
+using plist::Date;
+using plist::UID;
+using plist::Array;
+using plist::Dictionary;
+
+/* Size of the trailer as stored, without padding. */
+static size_t const TrailerSize = 32;
+
+/* Reference time is 2001/1/1 */
+static double const ReferenceTimestamp = 978307200.0;
+
+static bool
+ReadWord(uint8_t const *contents, size_t size, uint64_t offset, size_t nbytes, uint64_t *result)
+{
+    if (nbytes > 8 || offset > size || size - offset < nbytes) {
+        return false;
+    }
+
+    uint64_t value = 0;
+    for (size_t n = 0; n < nbytes; n++) {
+        value = (value << 8) | contents[offset + n];
+    }
+
+    *result = value;
+    return true;
+}
+
+BinaryView::
+BinaryView(uint8_t const *contents, size_t size) :
+    _contents         (contents),
+    _size             (size),
+    _offsetIntByteSize(0),
+    _objectRefByteSize(0),
+    _objectsCount     (0),
+    _topLevelObject   (0),
+    _offsetTableOffset(0)
+{
+}
+
+bool BinaryView::
+offset(Reference reference, uint64_t *offset) const
+{
+    if (reference >= _objectsCount) {
+        return false;
+    }
+
+    uint64_t entry = _offsetTableOffset + reference * _offsetIntByteSize;
+    if (!ReadWord(_contents, _size, entry, _offsetIntByteSize, offset)) {
+        return false;
+    }
+
+    return (*offset < _offsetTableOffset);
+}
+
+bool BinaryView::
+header(uint64_t offset, uint8_t *marker, uint64_t *length, uint64_t *start) const
+{
+    if (offset >= _size) {
+        return false;
+    }
+
+    *marker = _contents[offset];
+    *length = (*marker & 0x0f);
+    *start = offset + 1;
+
+    /* Long lengths follow as an integer object. */
+    if (*length == 0x0f) {
+        if (*start >= _size || (_contents[*start] & 0xf0) != 0x10) {
+            return false;
+        }
+
+        size_t nbytes = 1 << (_contents[*start] & 0x0f);
+        if (!ReadWord(_contents, _size, *start + 1, nbytes, length)) {
+            return false;
+        }
+
+        *start += 1 + nbytes;
+    }
+
+    return true;
+}
+
+bool BinaryView::
+reference(uint64_t start, uint64_t index, Reference *reference) const
+{
+    return ReadWord(_contents, _size, start + index * _objectRefByteSize, _objectRefByteSize, reference);
+}
+
+bool BinaryView::
+string(uint64_t offset, std::string *value) const
+{
+    uint8_t marker;
+    uint64_t length;
+    uint64_t start;
+    if (!header(offset, &marker, &length, &start)) {
+        return false;
+    }
+
+    switch (marker & 0xf0) {
+        case 0x50:
+            if (length > _size - start) {
+                return false;
+            }
+
+            value->assign(reinterpret_cast<char const *>(_contents + start), length);
+            return true;
+        case 0x60: {
+            if (length > (_size - start) / 2) {
+                return false;
+            }
+
+            std::vector<uint8_t> buffer = std::vector<uint8_t>(_contents + start, _contents + start + length * 2);
+            buffer = Encodings::Convert(buffer, Encoding::UTF16BE, Encoding::UTF8);
+            value->assign(buffer.begin(), buffer.end());
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+ObjectType BinaryView::
+type(Reference reference) const
+{
+    uint64_t position;
+    if (!offset(reference, &position)) {
+        return ObjectType::None;
+    }
+
+    uint8_t marker = _contents[position];
+    switch (marker & 0xf0) {
+        case 0x00:
+            switch (marker) {
+                case 0x00: return ObjectType::Null;
+                case 0x08: return ObjectType::Boolean;
+                case 0x09: return ObjectType::Boolean;
+                default:   return ObjectType::None;
+            }
+        case 0x10: return ObjectType::Integer;
+        case 0x20: return ObjectType::Real;
+        case 0x30: return ObjectType::Date;
+        case 0x40: return ObjectType::Data;
+        case 0x50: return ObjectType::String;
+        case 0x60: return ObjectType::String;
+        case 0x80: return ObjectType::UID;
+        case 0xa0: return ObjectType::Array;
+        case 0xd0: return ObjectType::Dictionary;
+        default:   return ObjectType::None;
+    }
+}
+
+size_t BinaryView::
+count(Reference reference) const
+{
+    uint64_t position;
+    if (!offset(reference, &position)) {
+        return 0;
+    }
+
+    uint8_t marker;
+    uint64_t length;
+    uint64_t start;
+    if (!header(position, &marker, &length, &start)) {
+        return 0;
+    }
+
+    if ((marker & 0xf0) != 0xa0 && (marker & 0xf0) != 0xd0) {
+        return 0;
+    }
+
+    return static_cast<size_t>(length);
+}
+
+bool BinaryView::
+value(Reference reference, std::string const &key, Reference *value) const
+{
+    uint64_t position;
+    if (!offset(reference, &position)) {
+        return false;
+    }
+
+    uint8_t marker;
+    uint64_t length;
+    uint64_t start;
+    if (!header(position, &marker, &length, &start) || (marker & 0xf0) != 0xd0) {
+        return false;
+    }
+
+    std::string candidate;
+    for (uint64_t n = 0; n < length; n++) {
+        Reference keyReference;
+        uint64_t keyPosition;
+        if (!this->reference(start, n, &keyReference) || !offset(keyReference, &keyPosition)) {
+            return false;
+        }
+
+        if (!string(keyPosition, &candidate)) {
+            return false;
+        }
+
+        if (candidate == key) {
+            /* Values follow all of the keys. */
+            return this->reference(start, length + n, value);
+        }
+    }
+
+    return false;
+}
+
+bool BinaryView::
+value(Reference reference, size_t index, Reference *value) const
+{
+    uint64_t position;
+    if (!offset(reference, &position)) {
+        return false;
+    }
+
+    uint8_t marker;
+    uint64_t length;
+    uint64_t start;
+    if (!header(position, &marker, &length, &start) || (marker & 0xf0) != 0xa0) {
+        return false;
+    }
+
+    if (index >= length) {
+        return false;
+    }
+
+    return this->reference(start, index, value);
+}
+
+std::unique_ptr<Object> BinaryView::
+materialize(Reference reference) const
+{
+    return materialize(reference, 0);
+}
+
+std::unique_ptr<Object> BinaryView::
+materialize(Reference reference, uint64_t depth) const
+{
+    /* Any deeper than this, and a container must include itself. */
+    if (depth > _objectsCount) {
+        return nullptr;
+    }
+
+    uint64_t position;
+    if (!offset(reference, &position)) {
+        return nullptr;
+    }
+
+    uint8_t marker;
+    uint64_t length;
+    uint64_t start;
+    if (!header(position, &marker, &length, &start)) {
+        return nullptr;
+    }
+
+    switch (marker & 0xf0) {
+        case 0x00:
+            switch (marker) {
+                case 0x00: return Null::New();
+                case 0x08: return Boolean::New(false);
+                case 0x09: return Boolean::New(true);
+                default:   return nullptr;
+            }
+        case 0x10: {
+            uint64_t value;
+            if (!ReadWord(_contents, _size, position + 1, 1 << (marker & 0x0f), &value)) {
+                return nullptr;
+            }
+
+            return Integer::New(static_cast<int64_t>(value));
+        }
+        case 0x20: {
+            size_t nbytes = 1 << (marker & 0x0f);
+            uint64_t value;
+            if (!ReadWord(_contents, _size, position + 1, nbytes, &value)) {
+                return nullptr;
+            }
+
+            if (nbytes == 4) {
+                uint32_t bits = static_cast<uint32_t>(value);
+                float real;
+                ::memcpy(&real, &bits, sizeof(real));
+                return Real::New(real);
+            } else if (nbytes == 8) {
+                double real;
+                ::memcpy(&real, &value, sizeof(real));
+                return Real::New(real);
+            } else {
+                return nullptr;
+            }
+        }
+        case 0x30: {
+            uint64_t value;
+            if (!ReadWord(_contents, _size, position + 1, 8, &value)) {
+                return nullptr;
+            }
+
+            double at;
+            ::memcpy(&at, &value, sizeof(at));
+            return Date::New(static_cast<uint64_t>(at + ReferenceTimestamp));
+        }
+        case 0x40: {
+            if (length > _size - start) {
+                return nullptr;
+            }
+
+            return Data::New(std::vector<uint8_t>(_contents + start, _contents + start + length));
+        }
+        case 0x50:
+        case 0x60: {
+            std::string value;
+            if (!string(position, &value)) {
+                return nullptr;
+            }
+
+            return String::New(std::move(value));
+        }
+        case 0x80: {
+            uint64_t value;
+            size_t nbytes = (marker & 0x0f) + 1;
+            if (nbytes > 4 || !ReadWord(_contents, _size, position + 1, nbytes, &value)) {
+                return nullptr;
+            }
+
+            return UID::New(static_cast<uint32_t>(value));
+        }
+        case 0xa0: {
+            auto array = Array::New();
+
+            for (uint64_t n = 0; n < length; n++) {
+                Reference valueReference;
+                if (!this->reference(start, n, &valueReference)) {
+                    return nullptr;
+                }
+
+                auto value = materialize(valueReference, depth + 1);
+                if (value == nullptr) {
+                    return nullptr;
+                }
+
+                array->append(std::move(value));
+            }
+
+            return std::move(array);
+        }
+        case 0xd0: {
+            auto dict = Dictionary::New();
+            dict->reserve(length);
+
+            std::string key;
+            for (uint64_t n = 0; n < length; n++) {
+                Reference keyReference;
+                Reference valueReference;
+                uint64_t keyPosition;
+                if (!this->reference(start, n, &keyReference) || !this->reference(start, length + n, &valueReference)) {
+                    return nullptr;
+                }
+
+                if (!offset(keyReference, &keyPosition) || !string(keyPosition, &key)) {
+                    return nullptr;
+                }
+
+                auto value = materialize(valueReference, depth + 1);
+                if (value == nullptr) {
+                    return nullptr;
+                }
+
+                dict->set(key, std::move(value));
+            }
+
+            return std::move(dict);
+        }
+        default:
+            return nullptr;
+    }
+}
+
+std::unique_ptr<BinaryView> BinaryView::
+Open(uint8_t const *contents, size_t size)
+{
+    size_t magic = ABPLIST_MAGIC_LENGTH + sizeof(ABPLIST_VERSION) - 1;
+    if (size < magic + TrailerSize) {
+        return nullptr;
+    }
+
+    if (::memcmp(contents, ABPLIST_MAGIC ABPLIST_VERSION, magic) != 0) {
+        return nullptr;
+    }
+
+    std::unique_ptr<BinaryView> view = std::unique_ptr<BinaryView>(new BinaryView(contents, size));
+
+    /* The trailer starts with six bytes of padding. */
+    uint64_t trailer = size - TrailerSize + 6;
+    view->_offsetIntByteSize = contents[trailer + 0];
+    view->_objectRefByteSize = contents[trailer + 1];
+    if (!ReadWord(contents, size, trailer + 2, 8, &view->_objectsCount) ||
+        !ReadWord(contents, size, trailer + 10, 8, &view->_topLevelObject) ||
+        !ReadWord(contents, size, trailer + 18, 8, &view->_offsetTableOffset)) {
+        return nullptr;
+    }
+
+    if (view->_offsetIntByteSize < 1 || view->_offsetIntByteSize > 8 ||
+        view->_objectRefByteSize < 1 || view->_objectRefByteSize > 8) {
+        return nullptr;
+    }
+
+    /* The offset table must fit between the objects and the trailer. */
+    uint64_t table = size - TrailerSize;
+    if (view->_offsetTableOffset < magic || view->_offsetTableOffset > table ||
+        view->_objectsCount > (table - view->_offsetTableOffset) / view->_offsetIntByteSize) {
+        return nullptr;
+    }
+
+    if (view->_topLevelObject >= view->_objectsCount) {
+        return nullptr;
+    }
+
+    return view;
+}
@@ -0,0 +1,151 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <plist/Format/Builder.h>
+#include <plist/Objects.h>
+
+using plist::Format::Builder;
+using plist::Object;
+using plist::ObjectType;
+using plist::String;
+using plist::Data;
+using plist::Integer;
+using plist::Real;
+using plist::Boolean;
+using plist::Null;
+using plist::Array;
+using plist::Dictionary;
+
+Builder::
+Builder()
+{
+}
+
+Builder::
+~Builder()
+{
+}
+
+bool Builder::
+store(std::unique_ptr<Object> value)
+{
+    if (_containers.empty()) {
+        /* Only one root value. */
+        if (_root != nullptr) {
+            return false;
+        }
+
+        _root = std::move(value);
+        return true;
+    }
+
+    Object *container = _containers.back().get();
+    if (Dictionary *dict = CastTo<Dictionary>(container)) {
+        dict->set(_keys.back(), std::move(value));
+    } else if (Array *array = CastTo<Array>(container)) {
+        array->append(std::move(value));
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool Builder::
+beginContainer(std::unique_ptr<Object> container)
+{
+    _containers.push_back(std::move(container));
+    _keys.push_back(std::string());
+    return true;
+}
+
+bool Builder::
+endContainer(ObjectType type)
+{
+    if (_containers.empty() || _containers.back()->type() != type) {
+        return false;
+    }
+
+    std::unique_ptr<Object> container = std::move(_containers.back());
+    _containers.pop_back();
+    _keys.pop_back();
+
+    return store(std::move(container));
+}
+
+bool Builder::
+beginDictionary()
+{
+    return beginContainer(Dictionary::New());
+}
+
+bool Builder::
+key(std::string const &key)
+{
+    if (_containers.empty() || _containers.back()->type() != Dictionary::Type()) {
+        return false;
+    }
+
+    _keys.back() = key;
+    return true;
+}
+
+bool Builder::
+endDictionary()
+{
+    return endContainer(Dictionary::Type());
+}
+
+bool Builder::
+beginArray()
+{
+    return beginContainer(Array::New());
+}
+
+bool Builder::
+endArray()
+{
+    return endContainer(Array::Type());
+}
+
+bool Builder::
+string(std::string const &value)
+{
+    return store(String::New(value));
+}
+
+bool Builder::
+data(std::vector<uint8_t> const &value)
+{
+    return store(Data::New(value));
+}
+
+bool Builder::
+integer(int64_t value)
+{
+    return store(Integer::New(value));
+}
+
+bool Builder::
+real(double value)
+{
+    return store(Real::New(value));
+}
+
+bool Builder::
+boolean(bool value)
+{
+    return store(Boolean::New(value));
+}
+
+bool Builder::
+null()
+{
+    return store(Null::New());
+}
@@ -11,6 +11,8 @@
 #include <plist/Format/unicode.h>
 
 #include <cassert>
+#include <cstring>
+#include <iterator>
 
 #if !defined(__APPLE__)
 #include <endian.h>
@@ -19,37 +21,60 @@
 using plist::Format::Encoding;
 using plist::Format::Encodings;
 
+static uint8_t const UTF8BOM[] = { 0xEF, 0xBB, 0xBF };
+static uint8_t const UTF16BEBOM[] = { 0xFE, 0xFF };
+static uint8_t const UTF16LEBOM[] = { 0xFF, 0xFE };
+static uint8_t const UTF32BEBOM[] = { 0x00, 0x00, 0xFE, 0xFF };
+static uint8_t const UTF32LEBOM[] = { 0xFF, 0xFE, 0x00, 0x00 };
+
+template<size_t N>
+static bool
+StartsWith(std::vector<uint8_t> const &contents, uint8_t const (&prefix)[N])
+{
+    return (contents.size() >= N && ::memcmp(contents.data(), prefix, N) == 0);
+}
+
+/*
+ * Length of the BOM for an encoding at the start of contents, if any.
+ */
+static size_t
+BOMSize(std::vector<uint8_t> const &contents, Encoding encoding)
+{
+    switch (encoding) {
+        case Encoding::UTF8:
+            return StartsWith(contents, UTF8BOM) ? sizeof(UTF8BOM) : 0;
+        case Encoding::UTF16BE:
+            return StartsWith(contents, UTF16BEBOM) ? sizeof(UTF16BEBOM) : 0;
+        case Encoding::UTF16LE:
+            return StartsWith(contents, UTF16LEBOM) ? sizeof(UTF16LEBOM) : 0;
+        case Encoding::UTF32BE:
+            return StartsWith(contents, UTF32BEBOM) ? sizeof(UTF32BEBOM) : 0;
+        case Encoding::UTF32LE:
+            return StartsWith(contents, UTF32LEBOM) ? sizeof(UTF32LEBOM) : 0;
+    }
+
+    abort();
+}
+
 Encoding Encodings::
 Detect(std::vector<uint8_t> const &contents)
 {
     /*
      * Check for a UTF-32 BOM. First as bytes overlap with UTF-16 LE.
      */
-    if (contents.size() >= 4) {
-        std::vector<uint8_t> UTF32BE_BOM = Encodings::BOM(Encoding::UTF32BE);
-        if (std::equal(UTF32BE_BOM.begin(), UTF32BE_BOM.end(), contents.begin())) {
-            return Encoding::UTF32BE;
-        }
-
-        std::vector<uint8_t> UTF32LE_BOM = Encodings::BOM(Encoding::UTF32LE);
-        if (std::equal(UTF32LE_BOM.begin(), UTF32LE_BOM.end(), contents.begin())) {
-            return Encoding::UTF32LE;
-        }
+    if (StartsWith(contents, UTF32BEBOM)) {
+        return Encoding::UTF32BE;
+    } else if (StartsWith(contents, UTF32LEBOM)) {
+        return Encoding::UTF32LE;
     }
 
     /*
      * Check for a UTF-16 BOM.
      */
-    if (contents.size() >= 2) {
-        std::vector<uint8_t> UTF16BE_BOM = Encodings::BOM(Encoding::UTF16BE);
-        if (std::equal(UTF16BE_BOM.begin(), UTF16BE_BOM.end(), contents.begin())) {
-            return Encoding::UTF16BE;
-        }
-
-        std::vector<uint8_t> UTF16LE_BOM = Encodings::BOM(Encoding::UTF16LE);
-        if (std::equal(UTF16LE_BOM.begin(), UTF16LE_BOM.end(), contents.begin())) {
-            return Encoding::UTF16LE;
-        }
+    if (StartsWith(contents, UTF16BEBOM)) {
+        return Encoding::UTF16BE;
+    } else if (StartsWith(contents, UTF16LEBOM)) {
+        return Encoding::UTF16LE;
     }
 
     /* Any other encoding is assumed to be UTF-8. */
@@ -61,15 +86,15 @@ BOM(Encoding encoding)
 {
     switch (encoding) {
         case Encoding::UTF8:
-            return { 0xEF, 0xBB, 0xBF };
+            return std::vector<uint8_t>(std::begin(UTF8BOM), std::end(UTF8BOM));
         case Encoding::UTF16BE:
-            return { 0xFE, 0xFF };
+            return std::vector<uint8_t>(std::begin(UTF16BEBOM), std::end(UTF16BEBOM));
         case Encoding::UTF16LE:
-            return { 0xFF, 0xFE };
+            return std::vector<uint8_t>(std::begin(UTF16LEBOM), std::end(UTF16LEBOM));
         case Encoding::UTF32BE:
-            return { 0x00, 0x00, 0xFE, 0xFF };
+            return std::vector<uint8_t>(std::begin(UTF32BEBOM), std::end(UTF32BEBOM));
         case Encoding::UTF32LE:
-            return { 0xFF, 0xFE, 0x00, 0x00 };
+            return std::vector<uint8_t>(std::begin(UTF32LEBOM), std::end(UTF32LEBOM));
     }
 
     abort();
@@ -125,35 +150,214 @@ static void
 EndianSwapBuffer(std::vector<uint8_t> *buffer, Endian src, Endian dest)
 {
     if (src != dest) {
-        for (size_t i = 0; i < buffer->size(); i += sizeof(T)) {
-            T *value = reinterpret_cast<T *>(&(*buffer)[i]);
-            *value = EndianSwap<T>(*value);
+        /* Copied through a value to not need alignment; this vectorizes. */
+        uint8_t *data = buffer->data();
+        for (size_t i = 0; i + sizeof(T) <= buffer->size(); i += sizeof(T)) {
+            T value;
+            ::memcpy(&value, data + i, sizeof(T));
+            value = EndianSwap<T>(value);
+            ::memcpy(data + i, &value, sizeof(T));
         }
     }
 }
 
+static inline uint16_t
+LoadUTF16(uint8_t const *p, Endian endian)
+{
+    return (endian == Endian::Big ? (p[0] << 8) | p[1] : p[0] | (p[1] << 8));
+}
+
+static inline void
+StoreUTF16(uint8_t *p, uint16_t value, Endian endian)
+{
+    p[endian == Endian::Big ? 0 : 1] = static_cast<uint8_t>(value >> 8);
+    p[endian == Endian::Big ? 1 : 0] = static_cast<uint8_t>(value);
+}
+
+/*
+ * Convert UTF-16 to UTF-8. Most text in property lists and strings files
+ * is ASCII, so runs of it are checked a word at a time and narrowed
+ * directly; only the runs between go through the general conversion.
+ */
+static void
+UTF16ToUTF8(uint8_t const *input, size_t size, Endian endian, std::vector<uint8_t> *result)
+{
+    /* Bits that must be clear in each unit of an ASCII word, in memory order. */
+    static uint8_t const BigMask[8] = { 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80 };
+    static uint8_t const LittleMask[8] = { 0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF, 0x80, 0xFF };
+    uint64_t mask;
+    ::memcpy(&mask, endian == Endian::Big ? BigMask : LittleMask, sizeof(mask));
+    size_t low = (endian == Endian::Big ? 1 : 0);
+
+    size_t count = size / sizeof(uint16_t);
+    result->resize(count * 3);
+    uint8_t *o = result->data();
+
+    std::vector<uint16_t> units;
+    size_t i = 0;
+    while (i < count) {
+        while (count - i >= 4) {
+            uint64_t word;
+            ::memcpy(&word, input + i * 2, sizeof(word));
+            if ((word & mask) != 0) {
+                break;
+            }
+
+            o[0] = input[i * 2 + low];
+            o[1] = input[i * 2 + 2 + low];
+            o[2] = input[i * 2 + 4 + low];
+            o[3] = input[i * 2 + 6 + low];
+            o += 4;
+            i += 4;
+        }
+
+        if (i == count) {
+            break;
+        }
+
+        uint16_t unit = LoadUTF16(input + i * 2, endian);
+        if (unit < 0x80) {
+            *o++ = static_cast<uint8_t>(unit);
+            i++;
+            continue;
+        }
+
+        /* Surrogate pairs are never split, as neither half is ASCII. */
+        size_t j = i + 1;
+        while (j < count && LoadUTF16(input + j * 2, endian) >= 0x80) {
+            j++;
+        }
+
+        units.resize(j - i);
+        for (size_t k = i; k < j; k++) {
+            units[k - i] = LoadUTF16(input + k * 2, endian);
+        }
+
+        o += ::utf16_to_utf8(
+            reinterpret_cast<char *>(o), (result->data() + result->size()) - o,
+            units.data(), units.size(),
+            0, nullptr);
+        i = j;
+    }
+
+    result->resize(o - result->data());
+}
+
+/*
+ * Convert UTF-8 to UTF-16, widening runs of ASCII directly like above.
+ */
+static void
+UTF8ToUTF16(uint8_t const *input, size_t size, Endian endian, std::vector<uint8_t> *result)
+{
+    /* No byte produces more than one unit. */
+    result->resize(size * sizeof(uint16_t));
+    uint8_t *o = result->data();
+
+    std::vector<char> bytes;
+    std::vector<uint16_t> units;
+    size_t i = 0;
+    while (i < size) {
+        while (size - i >= 8) {
+            uint64_t word;
+            ::memcpy(&word, input + i, sizeof(word));
+            if ((word & UINT64_C(0x8080808080808080)) != 0) {
+                break;
+            }
+
+            for (size_t k = 0; k < 8; k++) {
+                StoreUTF16(o + k * 2, input[i + k], endian);
+            }
+            o += 16;
+            i += 8;
+        }
+
+        if (i == size) {
+            break;
+        }
+
+        if (input[i] < 0x80) {
+            StoreUTF16(o, input[i], endian);
+            o += 2;
+            i++;
+            continue;
+        }
+
+        /*
+         * Runs end before an ASCII byte, which also ends any sequence. The
+         * conversion looks at the byte after a truncated sequence, so give
+         * it one at the end of the input.
+         */
+        size_t j = i + 1;
+        while (j < size && input[j] >= 0x80) {
+            j++;
+        }
+
+        bytes.assign(input + i, input + j);
+        bytes.push_back('\0');
+
+        units.resize(j - i);
+        size_t length = ::utf8_to_utf16(
+            units.data(), units.size(),
+            bytes.data(), j - i,
+            0, nullptr);
+        for (size_t k = 0; k < length; k++) {
+            StoreUTF16(o + k * 2, units[k], endian);
+        }
+        o += length * 2;
+        i = j;
+    }
+
+    result->resize(o - result->data());
+}
+
+std::pair<uint8_t const *, size_t> Encodings::
+Convert(std::vector<uint8_t> const &contents, Encoding from, Encoding to, std::vector<uint8_t> *buffer)
+{
+    if (from != to) {
+        *buffer = Convert(contents, from, to);
+        return std::make_pair(buffer->data(), buffer->size());
+    }
+
+    /* Only need to skip any BOM at the start. */
+    size_t offset = BOMSize(contents, from);
+    return std::make_pair(contents.data() + offset, contents.size() - offset);
+}
+
 std::vector<uint8_t> Encodings::
 Convert(std::vector<uint8_t> const &contents, Encoding from, Encoding to)
 {
-    std::vector<uint8_t> input = contents;
+    /* Skip any BOM at the start. */
+    size_t offset = BOMSize(contents, from);
+    uint8_t const *input = contents.data() + offset;
+    size_t size = contents.size() - offset;
 
-    /* Remove any BOM at the start. */
-    std::vector<uint8_t> BOM = Encodings::BOM(from);
-    if (input.size() >= BOM.size() && std::equal(BOM.begin(), BOM.end(), contents.begin())) {
-        input.erase(input.begin(), input.begin() + BOM.size());
-    }
+    bool fromUTF16 = (from == Encoding::UTF16LE || from == Encoding::UTF16BE);
+    bool toUTF16 = (to == Encoding::UTF16LE || to == Encoding::UTF16BE);
+    bool fromUTF32 = (from == Encoding::UTF32LE || from == Encoding::UTF32BE);
+    bool toUTF32 = (to == Encoding::UTF32LE || to == Encoding::UTF32BE);
 
     /* No conversion needed, just byte swap if necessary. */
     if (from == to) {
-        return input;
-    } else if ((from == Encoding::UTF16LE && to == Encoding::UTF16BE) ||
-               (from == Encoding::UTF16BE && to == Encoding::UTF16LE)) {
-        EndianSwapBuffer<uint16_t>(&input, EncodingEndian(from), EncodingEndian(to));
-        return input;
-    } else if ((from == Encoding::UTF32LE && to == Encoding::UTF32BE) ||
-               (from == Encoding::UTF32BE && to == Encoding::UTF32LE)) {
-        EndianSwapBuffer<uint32_t>(&input, EncodingEndian(from), EncodingEndian(to));
-        return input;
+        return std::vector<uint8_t>(input, input + size);
+    } else if (fromUTF16 && toUTF16) {
+        std::vector<uint8_t> result = std::vector<uint8_t>(input, input + size);
+        EndianSwapBuffer<uint16_t>(&result, EncodingEndian(from), EncodingEndian(to));
+        return result;
+    } else if (fromUTF32 && toUTF32) {
+        std::vector<uint8_t> result = std::vector<uint8_t>(input, input + size);
+        EndianSwapBuffer<uint32_t>(&result, EncodingEndian(from), EncodingEndian(to));
+        return result;
+    }
+
+    /* Between UTF-8 and UTF-16 directly. */
+    if (from == Encoding::UTF8 && toUTF16) {
+        std::vector<uint8_t> result;
+        UTF8ToUTF16(input, size, EncodingEndian(to), &result);
+        return result;
+    } else if (fromUTF16 && to == Encoding::UTF8) {
+        std::vector<uint8_t> result;
+        UTF16ToUTF8(input, size, EncodingEndian(from), &result);
+        return result;
     }
 
     /*
@@ -161,29 +365,21 @@ Convert(std::vector<uint8_t> const &contents, Encoding from, Encoding to)
      */
     std::vector<uint8_t> intermediate;
     if (from == Encoding::UTF8) {
-        intermediate = input;
-    } else {
-        if (from == Encoding::UTF16LE || from == Encoding::UTF16BE) {
-            EndianSwapBuffer<uint16_t>(&input, EncodingEndian(from), HostEndian);
+        intermediate = std::vector<uint8_t>(input, input + size);
+    } else if (fromUTF16) {
+        UTF16ToUTF8(input, size, EncodingEndian(from), &intermediate);
+    } else if (fromUTF32) {
+        std::vector<uint8_t> swapped = std::vector<uint8_t>(input, input + size);
+        EndianSwapBuffer<uint32_t>(&swapped, EncodingEndian(from), HostEndian);
 
-            intermediate.resize(input.size() * sizeof(uint8_t) * 2);
-            size_t length = ::utf16_to_utf8(
-                reinterpret_cast<char *>(intermediate.data()), intermediate.size() / sizeof(char),
-                reinterpret_cast<uint16_t *>(input.data()), input.size() / sizeof(uint16_t),
-                0, nullptr);
-            intermediate.resize(length);
-        } else if (from == Encoding::UTF32LE || from == Encoding::UTF32BE) {
-            EndianSwapBuffer<uint32_t>(&input, EncodingEndian(from), HostEndian);
-
-            intermediate.resize(input.size() * sizeof(uint8_t));
-            size_t length = ::utf32_to_utf8(
-                reinterpret_cast<char *>(intermediate.data()), intermediate.size() / sizeof(char),
-                reinterpret_cast<uint32_t *>(input.data()), input.size() / sizeof(uint32_t),
-                0, nullptr);
-            intermediate.resize(length);
-        } else {
-            assert(false && "unknown encoding");
-        }
+        intermediate.resize(swapped.size() * sizeof(uint8_t));
+        size_t length = ::utf32_to_utf8(
+            reinterpret_cast<char *>(intermediate.data()), intermediate.size() / sizeof(char),
+            reinterpret_cast<uint32_t *>(swapped.data()), swapped.size() / sizeof(uint32_t),
+            0, nullptr);
+        intermediate.resize(length);
+    } else {
+        assert(false && "unknown encoding");
     }
 
     /*
@@ -194,16 +390,9 @@ Convert(std::vector<uint8_t> const &contents, Encoding from, Encoding to)
     } else {
         std::vector<uint8_t> result;
 
-        if (to == Encoding::UTF16LE || to == Encoding::UTF16BE) {
-            result.resize(contents.size() * sizeof(uint16_t) * 3);
-            size_t length = ::utf8_to_utf16(
-                reinterpret_cast<uint16_t *>(result.data()), result.size() / sizeof(uint16_t),
-                reinterpret_cast<char *>(intermediate.data()), intermediate.size() / sizeof(char),
-                0, nullptr);
-            result.resize(length * sizeof(uint16_t));
-
-            EndianSwapBuffer<uint16_t>(&result, HostEndian, EncodingEndian(to));
-        } else if (to == Encoding::UTF32LE || to == Encoding::UTF32BE) {
+        if (toUTF16) {
+            UTF8ToUTF16(intermediate.data(), intermediate.size(), EncodingEndian(to), &result);
+        } else if (toUTF32) {
             result.resize(intermediate.size() * sizeof(uint32_t));
             size_t length = ::utf8_to_utf32(
                 reinterpret_cast<uint32_t *>(result.data()), result.size() / sizeof(uint32_t),
@@ -9,10 +9,13 @@
 
 #include <plist/Format/JSON.h>
 #include <plist/Format/JSONParser.h>
+#include <plist/Format/Builder.h>
 #include <plist/Format/JSONWriter.h>
 
 using plist::Format::Encoding;
+using plist::Format::Builder;
 using plist::Format::Format;
+using plist::Format::Handler;
 using plist::Format::JSON;
 using plist::Format::JSONParser;
 using plist::Format::JSONWriter;
@@ -37,22 +40,13 @@ template<>
 std::pair<std::unique_ptr<Object>, std::string> Format<JSON>::
 Deserialize(std::vector<uint8_t> const &contents, JSON const &format)
 {
-    std::unique_ptr<Object> root = nullptr;
-    std::string             error;
-
-    /* Create lexer. */
-    ASCIIPListLexer lexer;
-    ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(contents.data()), contents.size(), kASCIIPListLexerStyleJSON);
-
-    /* Parse contents. */
-    JSONParser parser;
-    if (parser.parse(&lexer)) {
-        root = std::move(parser.root());
-    } else {
-        error = parser.error();
+    Builder builder;
+    std::pair<bool, std::string> result = JSON::Parse(contents, format, &builder);
+    if (!result.first) {
+        return std::make_pair(nullptr, result.second);
     }
 
-    return std::make_pair(std::move(root), error);
+    return std::make_pair(std::move(builder.root()), std::string());
 }
 
 template<>
@@ -78,3 +72,15 @@ Create()
 {
     return JSON();
 }
+
+std::pair<bool, std::string> JSON::
+Parse(std::vector<uint8_t> const &contents, JSON const &format, Handler *handler)
+{
+    /* Parse contents. */
+    JSONParser parser = JSONParser(handler);
+    if (!parser.parse(reinterpret_cast<char const *>(contents.data()), contents.size())) {
+        return std::make_pair(false, parser.error());
+    }
+
+    return std::make_pair(true, std::string());
+}
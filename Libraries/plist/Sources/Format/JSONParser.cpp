@@ -8,18 +8,11 @@
  */
 
 #include <plist/Format/JSONParser.h>
-#include <plist/Objects.h>
 
 #include <cstdlib>
+#include <cstring>
 
 using plist::Format::JSONParser;
-using plist::Object;
-using plist::String;
-using plist::Boolean;
-using plist::Real;
-using plist::Integer;
-using plist::Array;
-using plist::Dictionary;
 
 #if 0
 #define JSONDebug(...) do { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } while (0)
@@ -28,13 +21,13 @@ using plist::Dictionary;
 #endif
 
 JSONParser::
-JSONParser() :
-    _root(nullptr),
+JSONParser(Handler *handler) :
+    _handler(handler),
     _level(0),
     _state(ValueState::Init),
-    _container(nullptr),
-    _key(nullptr),
-    _contextState(ContextState::Parsing)
+    _contextState(ContextState::Parsing),
+    _pointer(nullptr),
+    _end(nullptr)
 {
 }
 
@@ -85,7 +78,7 @@ abort(std::string const &error)
 }
 
 bool JSONParser::
-push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr<plist::String> key)
+push(ValueState state)
 {
     if (isAborted()) {
         return false;
@@ -94,25 +87,10 @@ push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr
     /* If valid state, push, otherwise just set the new state. */
     if (_state != ValueState::Init) {
         /* Push the old state */
-        _containerStack.push(std::move(_container));
-        _keyStack.push(std::move(_key));
         _stateStack.push(_state);
     }
 
     _state = state;
-
-    if (container != nullptr) {
-        _container = std::move(container);
-    } else {
-        _container = nullptr;
-    }
-
-    if (key != nullptr) {
-        _key = std::move(key);
-    } else {
-        _key = nullptr;
-    }
-
     return true;
 }
 
@@ -126,9 +104,6 @@ pop()
             return false; /* Underflow! */
 
         /* Reset current state. */
-        _container = nullptr;
-        _key = nullptr;
-
         _state = ValueState::Init;
         return true;
     }
@@ -137,12 +112,6 @@ pop()
     _state = std::move(_stateStack.top());
     _stateStack.pop();
 
-    _container = std::move(_containerStack.top());
-    _containerStack.pop();
-
-    _key = std::move(_keyStack.top());
-    _keyStack.pop();
-
     return true;
 }
 
@@ -150,63 +119,20 @@ pop()
  * Generic container handling.
  */
 bool JSONParser::
-beginContainer(std::unique_ptr<plist::Object> object)
+beginContainer(bool isArray)
 {
-    ValueState state;
-
-    if (object->type() == Array::Type()) {
-        state = ValueState::Array;
-    } else {
-        state = ValueState::Dictionary;
-    }
-
-    if (!push(state, std::move(object), nullptr)) {
-        abort("Cannot push the current state.");
+    if (!storeValue()) {
         return false;
     }
 
-    return true;
-}
-
-bool JSONParser::
-storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object> value)
-{
-    if (_container == nullptr) {
-        if (_key != nullptr) {
-            abort("Storing key/value pair with no container.");
-            return false;
-        }
-
-        /* Make current value the root. */
-        if (_root != nullptr) {
-            abort("Double root.");
-            return false;
-        }
-
-        _root = std::move(value);
-        return true;
+    if (!(isArray ? _handler->beginArray() : _handler->beginDictionary())) {
+        abort("Handler rejected container.");
+        return false;
     }
 
-    if (key != nullptr) {
-        if (_container->type() != Dictionary::Type()) {
-            abort("Storing key/value with no dictionary container.");
-            return false;
-        }
-
-        plist::Dictionary *dict = static_cast<plist::Dictionary *>(_container.get());
-        dict->set(key->value(), std::move(value));
-
-        _state = ValueState::Dictionary;
-    } else {
-        if (_container->type() != Array::Type()) {
-            abort("Storing value with no array container.");
-            return false;
-        }
-
-        plist::Array *array = static_cast<plist::Array *>(_container.get());
-        array->append(std::move(value));
-
-        _state = ValueState::Array;
+    if (!push(isArray ? ValueState::Array : ValueState::Dictionary)) {
+        abort("Cannot push the current state.");
+        return false;
     }
 
     return true;
@@ -215,30 +141,14 @@ storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object>
 bool JSONParser::
 endContainer(bool isArray)
 {
-    std::unique_ptr<plist::String> key;
-    std::unique_ptr<plist::Object> value;
-    bool success;
-
     /* Check state is consistant. */
     if (_state != (isArray ? ValueState::Array : ValueState::Dictionary)) {
         abort("Closing array/dictionary in wrong state.");
         return false;
     }
 
-    if (_container == nullptr) {
-        abort("Closing non-opened container.");
-        return false;
-    }
-
-    value = std::move(_container);
-    if (value == nullptr) {
-        abort("Couldn't copy container.");
-        return false;
-    }
-
-    /* Is this the right type of container? */
-    if (value->type() != (isArray ? Array::Type() : Dictionary::Type())) {
-        abort("Closing wrong kind of container.");
+    if (!(isArray ? _handler->endArray() : _handler->endDictionary())) {
+        abort("Handler rejected container.");
         return false;
     }
 
@@ -247,26 +157,13 @@ endContainer(bool isArray)
         return false;
     }
 
-    /* Take ownership of the saved key. */
-    key = std::move(_key);
-    _key = nullptr;
-
-    success = storeKeyValue(std::move(key), std::move(value));
-
-    return success;
+    return true;
 }
 
 bool JSONParser::
 beginArray()
 {
-    std::unique_ptr<plist::Array> array = Array::New();
-    if (array == nullptr) {
-        abort("Cannot create an array.");
-        return false;
-    }
-
-    bool success = beginContainer(std::move(array));
-    return success;
+    return beginContainer(true);
 }
 
 bool JSONParser::
@@ -278,14 +175,7 @@ endArray()
 bool JSONParser::
 beginDictionary()
 {
-    std::unique_ptr<plist::Dictionary> dict = Dictionary::New();
-    if (dict == nullptr) {
-        abort("Cannot create a dictionary.");
-        return false;
-    }
-
-    bool success = beginContainer(std::move(dict));
-    return success;
+    return beginContainer(false);
 }
 
 bool JSONParser::
@@ -298,41 +188,38 @@ endDictionary()
  * Store the key of the current dictionary.
  */
 bool JSONParser::
-storeKey(std::unique_ptr<plist::String> key)
+storeKey(std::string const &key)
 {
-    if (key == nullptr) {
-        key = String::New();
-
-        if (key == nullptr) {
-            abort("Cannot create empty key.");
-            return false;
-        }
-    }
-
     if (_state != ValueState::Dictionary) {
         abort("Storing key in wrong state.");
         return false;
     }
 
-    _key = std::move(key);
+    if (!_handler->key(key)) {
+        abort("Handler rejected key.");
+        return false;
+    }
 
     _state = ValueState::DictionaryValue;
     return true;
 }
 
+/*
+ * Check a value can be stored here; the caller then passes it to the handler.
+ */
 bool JSONParser::
-storeValue(std::unique_ptr<plist::Object> value)
+storeValue()
 {
-    bool success;
-
-    success = storeKeyValue(std::move(_key), std::move(value));
-    _key = nullptr;
+    if (_state == ValueState::Dictionary) {
+        abort("Storing value with no key.");
+        return false;
+    }
 
     if (_state == ValueState::DictionaryValue) {
         _state = ValueState::Dictionary;
     }
 
-    return success;
+    return true;
 }
 
 bool JSONParser::
@@ -358,9 +245,291 @@ finish()
     return true;
 }
 
+static inline bool
+IsSpace(char c)
+{
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f');
+}
+
+static inline bool
+IsDigit(char c)
+{
+    return (c >= '0' && c <= '9');
+}
+
+static inline int
+HexValue(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    } else {
+        return -1;
+    }
+}
+
+static void
+AppendUTF8(std::string *result, uint32_t c)
+{
+    if (c < 0x80) {
+        result->push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+        result->push_back(static_cast<char>(0xC0 | (c >> 6)));
+        result->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else if (c < 0x10000) {
+        result->push_back(static_cast<char>(0xE0 | (c >> 12)));
+        result->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        result->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else {
+        result->push_back(static_cast<char>(0xF0 | (c >> 18)));
+        result->push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+        result->push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        result->push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    }
+}
+
+/*
+ * Read four hex digits of a unicode escape.
+ */
+static bool
+ReadUnicodeEscape(char const **pointer, char const *end, uint32_t *value)
+{
+    char const *p = *pointer;
+    if (end - p < 4) {
+        return false;
+    }
+
+    *value = 0;
+    for (size_t i = 0; i < 4; i++) {
+        int digit = HexValue(p[i]);
+        if (digit < 0) {
+            return false;
+        }
+        *value = (*value << 4) | digit;
+    }
+
+    *pointer = p + 4;
+    return true;
+}
+
+int JSONParser::
+readString()
+{
+    char const *begin = _pointer + 1;
+
+    /*
+     * Most strings have no escapes: find the end with memchr(), which the
+     * C library vectorizes, and copy the contents once.
+     */
+    char const *quote = static_cast<char const *>(::memchr(begin, '"', _end - begin));
+    if (quote == nullptr) {
+        return kASCIIPListLexerUnterminatedQuotedString;
+    }
+
+    char const *backslash = static_cast<char const *>(::memchr(begin, '\\', quote - begin));
+    if (backslash == nullptr) {
+        _value.assign(begin, quote);
+        _pointer = quote + 1;
+        return kASCIIPListLexerTokenQuotedString;
+    }
+
+    /* The quote found might be escaped; unescape up to the real end. */
+    _value.assign(begin, backslash);
+
+    char const *p = backslash;
+    while (true) {
+        if (_end - p < 2) {
+            return kASCIIPListLexerUnterminatedQuotedString;
+        }
+
+        char escape = p[1];
+        p += 2;
+
+        switch (escape) {
+            case 'b': _value.push_back('\b'); break;
+            case 'f': _value.push_back('\f'); break;
+            case 'n': _value.push_back('\n'); break;
+            case 'r': _value.push_back('\r'); break;
+            case 't': _value.push_back('\t'); break;
+            case 'u': {
+                uint32_t c;
+                if (!ReadUnicodeEscape(&p, _end, &c)) {
+                    return kASCIIPListLexerInvalidToken;
+                }
+
+                /* Characters outside of the BMP are escaped as surrogate pairs. */
+                if (c >= 0xD800 && c <= 0xDBFF) {
+                    char const *low = p + 2;
+                    uint32_t d;
+                    if (_end - p >= 2 && p[0] == '\\' && p[1] == 'u' && ReadUnicodeEscape(&low, _end, &d) && d >= 0xDC00 && d <= 0xDFFF) {
+                        c = 0x10000 + ((c - 0xD800) << 10) + (d - 0xDC00);
+                        p = low;
+                    } else {
+                        c = 0xFFFD;
+                    }
+                } else if (c >= 0xDC00 && c <= 0xDFFF) {
+                    c = 0xFFFD;
+                }
+
+                AppendUTF8(&_value, c);
+                break;
+            }
+            default:
+                /* Including quotes, backslashes and slashes. */
+                _value.push_back(escape);
+                break;
+        }
+
+        char const *next = p;
+        while (next != _end && *next != '"' && *next != '\\') {
+            next++;
+        }
+
+        _value.append(p, next);
+        if (next == _end) {
+            return kASCIIPListLexerUnterminatedQuotedString;
+        } else if (*next == '"') {
+            _pointer = next + 1;
+            return kASCIIPListLexerTokenQuotedString;
+        }
+
+        p = next;
+    }
+}
+
+int JSONParser::
+readNumber()
+{
+    bool integer = true;
+    char const *p = _pointer;
+
+    if (p != _end && *p == '-') {
+        p++;
+    }
+
+    /* Numbers cannot start with zero, unless they are zero. */
+    if (p == _end || !IsDigit(*p)) {
+        return kASCIIPListLexerInvalidToken;
+    } else if (*p == '0') {
+        p++;
+        if (p != _end && IsDigit(*p)) {
+            return kASCIIPListLexerInvalidToken;
+        }
+    } else {
+        while (p != _end && IsDigit(*p)) {
+            p++;
+        }
+    }
+
+    if (p != _end && *p == '.') {
+        integer = false;
+
+        p++;
+        if (p == _end || !IsDigit(*p)) {
+            return kASCIIPListLexerInvalidToken;
+        }
+        while (p != _end && IsDigit(*p)) {
+            p++;
+        }
+    }
+
+    if (p != _end && (*p == 'e' || *p == 'E')) {
+        integer = false;
+
+        p++;
+        if (p != _end && (*p == '+' || *p == '-')) {
+            p++;
+        }
+
+        if (p == _end || !IsDigit(*p)) {
+            return kASCIIPListLexerInvalidToken;
+        }
+        while (p != _end && IsDigit(*p)) {
+            p++;
+        }
+    }
+
+    if (p != _end && !IsSpace(*p) && *p != ',' && *p != '}' && *p != ']' && *p != ':') {
+        return kASCIIPListLexerInvalidToken;
+    }
+
+    _value.assign(_pointer, p);
+    _pointer = p;
+    return (integer ? kASCIIPListLexerTokenNumberInteger : kASCIIPListLexerTokenNumberReal);
+}
+
+int JSONParser::
+readKeyword(char const *keyword, int token)
+{
+    size_t length = ::strlen(keyword);
+    if (static_cast<size_t>(_end - _pointer) < length || ::memcmp(_pointer, keyword, length) != 0) {
+        return kASCIIPListLexerInvalidToken;
+    }
+
+    char const *p = _pointer + length;
+    if (p != _end && !IsSpace(*p) && *p != ',' && *p != '}' && *p != ']' && *p != ':') {
+        return kASCIIPListLexerInvalidToken;
+    }
+
+    _pointer = p;
+    return token;
+}
+
+int JSONParser::
+readToken()
+{
+    while (_pointer != _end && IsSpace(*_pointer)) {
+        _pointer++;
+    }
+
+    if (_pointer == _end) {
+        return kASCIIPListLexerEndOfFile;
+    }
+
+    switch (*_pointer) {
+        case '{':
+            _pointer++;
+            return kASCIIPListLexerTokenDictionaryStart;
+        case '}':
+            _pointer++;
+            return kASCIIPListLexerTokenDictionaryEnd;
+        case '[':
+            _pointer++;
+            return kASCIIPListLexerTokenArrayStart;
+        case ']':
+            _pointer++;
+            return kASCIIPListLexerTokenArrayEnd;
+        case ':':
+            _pointer++;
+            return kASCIIPListLexerTokenDictionaryKeyValSeparator;
+        case ',':
+            _pointer++;
+            return ',';
+        case '"':
+            return readString();
+        case 't':
+            return readKeyword("true", kASCIIPListLexerTokenBoolTrue);
+        case 'f':
+            return readKeyword("false", kASCIIPListLexerTokenBoolFalse);
+        case 'n':
+            return readKeyword("null", kASCIIPListLexerTokenNull);
+        default:
+            if (*_pointer == '-' || IsDigit(*_pointer)) {
+                return readNumber();
+            }
+            return kASCIIPListLexerInvalidToken;
+    }
+}
+
 bool JSONParser::
-parse(ASCIIPListLexer *lexer)
+parse(char const *data, size_t size)
 {
+    _pointer = data;
+    _end = data + size;
+
     enum class JSONParseState {
         Parse,
         KeyValueSeparator,
@@ -371,7 +540,7 @@ parse(ASCIIPListLexer *lexer)
     JSONParseState state = JSONParseState::Parse;
 
     for (;;) {
-        token = ASCIIPListLexerReadToken(lexer);
+        token = readToken();
         if (token < 0) {
             if (token == kASCIIPListLexerEndOfFile && isDone()) {
                 /* success */
@@ -453,10 +622,13 @@ parse(ASCIIPListLexer *lexer)
                         }
 
                         bool value = (token == kASCIIPListLexerTokenBoolTrue);
-                        std::unique_ptr<Boolean> boolean = Boolean::New(value);
 
                         JSONDebug("Storing boolean");
-                        if (!storeValue(std::move(boolean))) {
+                        if (!storeValue()) {
+                            return false;
+                        }
+                        if (!_handler->boolean(value)) {
+                            abort("Handler rejected boolean");
                             return false;
                         }
                     } else if (token == kASCIIPListLexerTokenNull) {
@@ -465,10 +637,12 @@ parse(ASCIIPListLexer *lexer)
                             return false;
                         }
 
-                        std::unique_ptr<Null> null = Null::New();
-
                         JSONDebug("Storing null");
-                        if (!storeValue(std::move(null))) {
+                        if (!storeValue()) {
+                            return false;
+                        }
+                        if (!_handler->null()) {
+                            abort("Handler rejected null");
                             return false;
                         }
                     } else if (token == kASCIIPListLexerTokenNumberInteger) {
@@ -478,16 +652,16 @@ parse(ASCIIPListLexer *lexer)
                         }
 
                         char *end = NULL;
-                        char *contents = ASCIIPListCopyUnquotedString(lexer, '?');
-                        long long value = ::strtoll(contents, &end, 0);
-                        bool success = (end != contents);
-                        free(contents);
+                        long long value = ::strtoll(_value.c_str(), &end, 10);
+                        bool success = (end != _value.c_str());
 
                         if (success) {
-                            std::unique_ptr<Integer> integer = Integer::New(value);
-
                             JSONDebug("Storing integer");
-                            if (!storeValue(std::move(integer))) {
+                            if (!storeValue()) {
+                                return false;
+                            }
+                            if (!_handler->integer(value)) {
+                                abort("Handler rejected integer");
                                 return false;
                             }
                         } else {
@@ -501,16 +675,16 @@ parse(ASCIIPListLexer *lexer)
                         }
 
                         char *end = NULL;
-                        char *contents = ASCIIPListCopyUnquotedString(lexer, '?');
-                        double value = ::strtod(contents, &end);
-                        bool success = (end != contents);
-                        free(contents);
+                        double value = ::strtod(_value.c_str(), &end);
+                        bool success = (end != _value.c_str());
 
                         if (success) {
-                            std::unique_ptr<Real> real = Real::New(value);
-
                             JSONDebug("Storing real");
-                            if (!storeValue(std::move(real))) {
+                            if (!storeValue()) {
+                                return false;
+                            }
+                            if (!_handler->real(value)) {
+                                abort("Handler rejected real");
                                 return false;
                             }
                         } else {
@@ -518,24 +692,21 @@ parse(ASCIIPListLexer *lexer)
                             return false;
                         }
                     } else if (token == kASCIIPListLexerTokenQuotedString) {
-                        char *contents = ASCIIPListCopyUnquotedString(lexer, '?');
-                        std::unique_ptr<String> string = String::New(std::string(contents));
-                        free(contents);
-
-                        if (string == NULL) {
-                            abort("OOM when copying string");
-                            return false;
-                        }
+                        std::string const &string = _value;
 
                         /* Container context */
                         if (isDictionary) {
-                            JSONDebug("Storing string %s as key", string->value().c_str());
-                            if (!storeKey(std::move(string))) {
+                            JSONDebug("Storing string %s as key", string.c_str());
+                            if (!storeKey(string)) {
                                 return false;
                             }
                         } else {
-                            JSONDebug("Storing string %s", string->value().c_str());
-                            if (!storeValue(std::move(string))) {
+                            JSONDebug("Storing string %s", string.c_str());
+                            if (!storeValue()) {
+                                return false;
+                            }
+                            if (!_handler->string(string)) {
+                                abort("Handler rejected string");
                                 return false;
                             }
                         }
@@ -22,12 +22,12 @@ SimpleXMLParser::SimpleXMLParser() :
 }
 
 Dictionary *SimpleXMLParser::
-parse(std::vector<uint8_t> const &contents)
+parse(uint8_t const *data, size_t size)
 {
     if (_root != nullptr)
         return nullptr;
 
-    if (!BaseXMLParser::parse(contents))
+    if (!BaseXMLParser::parse(data, size))
         return nullptr;
 
     return _root;
@@ -51,7 +51,7 @@ onEndParse(bool success)
 }
 
 void SimpleXMLParser::
-onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t)
+onStartElement(std::string const &name, Attributes const &attrs, size_t)
 {
     Dictionary *dict = Dictionary::New().release();
 
@@ -85,10 +85,11 @@ template<>
 std::pair<std::unique_ptr<Object>, std::string> Format<XML>::
 Deserialize(std::vector<uint8_t> const &contents, XML const &format)
 {
-    std::vector<uint8_t> const data = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
+    std::vector<uint8_t> buffer;
+    std::pair<uint8_t const *, size_t> data = Encodings::Convert(contents, format.encoding(), Encoding::UTF8, &buffer);
 
     XMLParser parser;
-    std::unique_ptr<Object> root = std::unique_ptr<Object>(parser.parse(data));
+    std::unique_ptr<Object> root = std::unique_ptr<Object>(parser.parse(data.first, data.second));
     if (root == nullptr) {
         return std::make_pair(nullptr, parser.error());
     }
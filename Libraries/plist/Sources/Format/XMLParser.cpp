@@ -21,12 +21,12 @@ XMLParser::XMLParser() :
 }
 
 Object *XMLParser::
-parse(std::vector<uint8_t> const &contents)
+parse(uint8_t const *data, size_t size)
 {
     if (_root != nullptr)
         return nullptr;
 
-    if (!BaseXMLParser::parse(contents))
+    if (!BaseXMLParser::parse(data, size))
         return nullptr;
 
     return _root;
@@ -66,7 +66,7 @@ onEndParse(bool success)
 }
 
 void XMLParser::
-onStartElement(std::string const &name, std::unordered_map<std::string, std::string> const &attrs, size_t depth)
+onStartElement(std::string const &name, Attributes const &attrs, size_t depth)
 {
     if (depth == 0) {
         if (name != "plist") {
@@ -91,7 +91,7 @@ utf8_to_utf16(uint16_t *dst, size_t dst_len, char const *src, size_t src_len,
             c = ((s[spos] & 0x0f) << 12) | ((s[spos+1] & 0x3f) << 6) |
                 (s[spos+2] & 0x3f);
             spos += 3;
-            if (c < 0x800 || (c & 0xdf00) == 0xd800) {
+            if (c < 0x800 || (c & 0xf800) == 0xd800) {
                 /* overlong encoding or encoded surrogate */
                 error++;
                 continue;
@@ -232,10 +232,10 @@ utf16_to_utf8(char *dst, size_t dst_len, uint16_t const *src, size_t src_len,
             CHECK_LENGTH(2);
             ADD_BYTE(0xc0 | (src[spos]>>6));
             ADD_BYTE(0x80 | (src[spos] & 0x3f));
-        } else if ((src[spos] & 0xdc00) == 0xd800) {
+        } else if ((src[spos] & 0xfc00) == 0xd800) {
             uint32_t c;
             /* first surrogate */
-            if (spos == src_len - 1 || (src[spos+1] & 0xdc00) != 0xdc00) {
+            if (spos == src_len - 1 || (src[spos+1] & 0xfc00) != 0xdc00) {
                 /* no second surrogate present */
                 error++;
                 continue;
@@ -247,7 +247,7 @@ utf16_to_utf8(char *dst, size_t dst_len, uint16_t const *src, size_t src_len,
             ADD_BYTE(0x80 | ((c>>12) & 0x3f));
             ADD_BYTE(0x80 | ((c>>6) & 0x3f));
             ADD_BYTE(0x80 | (c & 0x3f));
-        } else if ((src[spos] & 0xdc00) == 0xdc00) {
+        } else if ((src[spos] & 0xfc00) == 0xdc00) {
             /* second surrogate without preceding first surrogate */
             error++;
         } else {
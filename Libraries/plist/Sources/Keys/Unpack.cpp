@@ -15,28 +15,36 @@ using plist::Dictionary;
 
 Unpack::
 Unpack(std::string const &name, Dictionary const *dict, std::unordered_set<std::string> *seen) :
-    _name(name),
-    _dict(dict),
-    _seen(seen)
+    _name    (name),
+    _dict    (dict),
+    _seen    (seen),
+    _unpacked(dict->count(), false)
 {
 }
 
 Object const *Unpack::
 value(std::string const &key)
 {
-    _seen->insert(key);
-    return _dict->value(key);
+    size_t index = _dict->index(key);
+    if (index == _dict->count()) {
+        return nullptr;
+    }
+
+    _unpacked[index] = true;
+    return _dict->value(index);
 }
 
 bool Unpack::
 complete(bool check)
 {
-    if (check) {
-        for (size_t n = 0; n < _dict->count(); n++) {
-            std::string const &key = _dict->key(n);
-            if (_seen->find(key) == _seen->end()) {
-                _errors.push_back("unhandled " + _name + " key " + key);
+    for (size_t n = 0; n < _dict->count(); n++) {
+        if (check) {
+            /* Only keys not unpacked here could have been by a base type. */
+            if (!_unpacked[n] && _seen->find(_dict->key(n)) == _seen->end()) {
+                _errors.push_back("unhandled " + _name + " key " + _dict->key(n));
             }
+        } else if (_unpacked[n]) {
+            _seen->insert(_dict->key(n));
         }
     }
 
@@ -13,6 +13,7 @@
 
 using plist::Format::ASCII;
 using plist::Format::Encoding;
+using plist::Format::Handler;
 using plist::String;
 using plist::Boolean;
 using plist::Integer;
@@ -146,3 +147,64 @@ TEST(ASCII, CommentWithStarAndSlash)
     dictionary->set("key", String::New("value"));
     EXPECT_TRUE(deserialize.first->equals(dictionary.get()));
 }
+
+TEST(ASCII, UnterminatedAtEnd)
+{
+    /* Nothing after the contents, so the lexer must stop at the end. */
+    for (char const *string : { "\"unterminated", "'unterminated", "/* unterminated", "<0a0b" }) {
+        auto contents = Contents(std::string("{ key = ") + string);
+
+        auto deserialize = ASCII::Deserialize(contents, ASCII::Create(false, Encoding::UTF8));
+        EXPECT_EQ(deserialize.first, nullptr);
+    }
+}
+
+TEST(ASCII, MultipleLineStrings)
+{
+    auto contents = Contents("{\n  a = \"one\\\"\ntwo\";\n  b = 'three\nfour';\n  /* five\n six */ c = seven;\n}\n");
+
+    auto deserialize = ASCII::Deserialize(contents, ASCII::Create(false, Encoding::UTF8));
+    ASSERT_NE(deserialize.first, nullptr);
+
+    auto dictionary = Dictionary::New();
+    dictionary->set("a", String::New("one\"\ntwo"));
+    dictionary->set("b", String::New("three\nfour"));
+    dictionary->set("c", String::New("seven"));
+    EXPECT_TRUE(deserialize.first->equals(dictionary.get()));
+}
+
+/*
+ * Records parser events as text.
+ */
+class RecordingHandler : public Handler {
+public:
+    std::string events;
+
+public:
+    virtual bool beginDictionary() { events += "{"; return true; }
+    virtual bool key(std::string const &key) { events += key + "="; return true; }
+    virtual bool endDictionary() { events += "}"; return true; }
+    virtual bool beginArray() { events += "("; return true; }
+    virtual bool endArray() { events += ")"; return true; }
+    virtual bool string(std::string const &value) { events += value + ";"; return true; }
+    virtual bool data(std::vector<uint8_t> const &value) { events += "<" + std::to_string(value.size()) + ">;"; return true; }
+    virtual bool integer(int64_t value) { return false; }
+    virtual bool real(double value) { return false; }
+    virtual bool boolean(bool value) { return false; }
+    virtual bool null() { return false; }
+};
+
+TEST(ASCII, Parse)
+{
+    auto contents = Contents("{ a = b; c = ( d, <0102> ); e = { }; }");
+
+    RecordingHandler handler;
+    auto result = ASCII::Parse(contents, ASCII::Create(false, Encoding::UTF8), &handler);
+    EXPECT_TRUE(result.first);
+    EXPECT_EQ("{a=b;c=(d;<2>;)e={}}", handler.events);
+
+    RecordingHandler strings;
+    result = ASCII::Parse(Contents("a = b;"), ASCII::Create(true, Encoding::UTF8), &strings);
+    EXPECT_TRUE(result.first);
+    EXPECT_EQ("{a=b;}", strings.events);
+}
@@ -9,10 +9,14 @@
 
 #include <gtest/gtest.h>
 #include <plist/Format/Binary.h>
+#include <plist/Format/BinaryView.h>
 #include <plist/Objects.h>
 
 using plist::Format::Binary;
+using plist::Format::BinaryView;
 using plist::String;
+using plist::Integer;
+using plist::Array;
 using plist::Dictionary;
 
 TEST(Binary, UnicodeString)
@@ -42,3 +46,75 @@ TEST(Binary, UnicodeString)
     EXPECT_EQ(*serialize.first, contents);
 }
 
+TEST(Binary, UniqueValues)
+{
+    auto array = Array::New();
+    for (int n = 0; n < 3; n++) {
+        auto dict = Dictionary::New();
+        dict->set("key", String::New("value"));
+        dict->set("number", Integer::New(1));
+        array->append(std::move(dict));
+    }
+
+    auto serialize = Binary::Serialize(array.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+
+    /* One array, three dictionaries, and each distinct key and value once. */
+    std::vector<uint8_t> const &contents = *serialize.first;
+    uint8_t const *trailer = contents.data() + contents.size() - 32;
+    EXPECT_EQ(8, trailer[15]);
+
+    auto deserialize = Binary::Deserialize(contents, Binary::Create());
+    ASSERT_NE(deserialize.first, nullptr);
+    EXPECT_TRUE(deserialize.first->equals(array.get()));
+}
+
+TEST(Binary, View)
+{
+    auto inner = Dictionary::New();
+    inner->set("name", String::New("inner"));
+
+    auto array = Array::New();
+    array->append(Integer::New(1));
+    array->append(std::move(inner));
+
+    auto dict = Dictionary::New();
+    dict->set("first", String::New("value"));
+    dict->set("second", std::move(array));
+
+    auto serialize = Binary::Serialize(dict.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+
+    std::vector<uint8_t> const &contents = *serialize.first;
+    auto view = BinaryView::Open(contents.data(), contents.size());
+    ASSERT_NE(view, nullptr);
+    EXPECT_EQ(plist::ObjectType::Dictionary, view->type(view->root()));
+    EXPECT_EQ(2, view->count(view->root()));
+
+    BinaryView::Reference first;
+    ASSERT_TRUE(view->value(view->root(), "first", &first));
+    auto value = view->materialize(first);
+    ASSERT_NE(value, nullptr);
+    EXPECT_TRUE(value->equals(String::New("value").get()));
+
+    BinaryView::Reference second;
+    ASSERT_TRUE(view->value(view->root(), "second", &second));
+    EXPECT_EQ(plist::ObjectType::Array, view->type(second));
+
+    BinaryView::Reference element;
+    BinaryView::Reference name;
+    ASSERT_TRUE(view->value(second, static_cast<size_t>(1), &element));
+    ASSERT_TRUE(view->value(element, "name", &name));
+    EXPECT_TRUE(view->materialize(name)->equals(String::New("inner").get()));
+
+    BinaryView::Reference missing;
+    EXPECT_FALSE(view->value(view->root(), "missing", &missing));
+    EXPECT_FALSE(view->value(second, static_cast<size_t>(2), &missing));
+
+    auto root = view->materialize(view->root());
+    ASSERT_NE(root, nullptr);
+    EXPECT_TRUE(root->equals(dict.get()));
+
+    std::vector<uint8_t> truncated = std::vector<uint8_t>(contents.begin(), contents.begin() + 20);
+    EXPECT_EQ(nullptr, BinaryView::Open(truncated.data(), truncated.size()));
+}
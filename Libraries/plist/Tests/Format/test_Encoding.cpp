@@ -168,3 +168,34 @@ TEST(Encoding, ConvertStripBOM)
         EXPECT_FALSE(std::equal(BOM.begin(), BOM.end(), converted.begin()));
     }
 }
+
+TEST(Encoding, ConvertBuffer)
+{
+    for (auto const &source : AllContent) {
+        for (Encoding test : AllEncodings) {
+            std::vector<uint8_t> content = source.second;
+            std::vector<uint8_t> BOM = Encodings::BOM(source.first);
+            content.insert(content.begin(), BOM.begin(), BOM.end());
+
+            std::vector<uint8_t> buffer;
+            std::pair<uint8_t const *, size_t> converted = Encodings::Convert(content, source.first, test, &buffer);
+            EXPECT_EQ(std::vector<uint8_t>(converted.first, converted.first + converted.second), Encodings::Convert(content, source.first, test));
+
+            /* Contents already in the encoding are used without a copy. */
+            if (test == source.first) {
+                EXPECT_TRUE(buffer.empty());
+                EXPECT_EQ(content.data() + BOM.size(), converted.first);
+            }
+        }
+    }
+}
+
+TEST(Encoding, ConvertNonSurrogate)
+{
+    /* Code units near the surrogates: U+F8FF, U+FF01 and U+FFFD. */
+    std::vector<uint8_t> UTF8 = { 0x61, 0xEF, 0xA3, 0xBF, 0xEF, 0xBC, 0x81, 0xEF, 0xBF, 0xBD, 0x62 };
+    std::vector<uint8_t> UTF16BE = { 0x00, 0x61, 0xF8, 0xFF, 0xFF, 0x01, 0xFF, 0xFD, 0x00, 0x62 };
+
+    EXPECT_EQ(UTF16BE, Encodings::Convert(UTF8, Encoding::UTF8, Encoding::UTF16BE));
+    EXPECT_EQ(UTF8, Encodings::Convert(UTF16BE, Encoding::UTF16BE, Encoding::UTF8));
+}
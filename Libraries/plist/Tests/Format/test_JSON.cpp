@@ -138,3 +138,21 @@ TEST(JSON, Number)
     auto deserialize6 = JSON::Deserialize(contents6, JSON::Create());
     EXPECT_EQ(deserialize6.first, nullptr);
 }
+
+TEST(JSON, StringEscapes)
+{
+    auto contents = Contents("[ \"a\\\"b\\\\c\\/d\\n\", \"\\u00e9\\ud83d\\udca9\", \"\\\"\" ]");
+    auto deserialize = JSON::Deserialize(contents, JSON::Create());
+    ASSERT_NE(deserialize.first, nullptr);
+
+    auto array = plist::CastTo<plist::Array>(deserialize.first.get());
+    ASSERT_NE(array, nullptr);
+    ASSERT_EQ(3, array->count());
+    EXPECT_EQ("a\"b\\c/d\n", array->value<plist::String>(0)->value());
+    EXPECT_EQ("\xC3\xA9\xF0\x9F\x92\xA9", array->value<plist::String>(1)->value());
+    EXPECT_EQ("\"", array->value<plist::String>(2)->value());
+
+    /* Strings must be terminated, even after an escaped quote. */
+    auto unterminated = Contents("[ \"a\\\" ]");
+    EXPECT_EQ(JSON::Deserialize(unterminated, JSON::Create()).first, nullptr);
+}
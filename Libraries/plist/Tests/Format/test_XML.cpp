@@ -20,6 +20,7 @@ using plist::Real;
 using plist::UID;
 using plist::Dictionary;
 using plist::Array;
+using plist::Data;
 
 static std::vector<uint8_t>
 Contents(std::string const &string)
@@ -70,3 +71,78 @@ TEST(XML, UID)
     EXPECT_EQ(*serialize.first, contents);
 }
 
+
+TEST(XML, Text)
+{
+    auto contents = Contents(std::string(XMLHeader) + "<dict>\n\t<key>blank</key>\n\t<string>  </string>\n\t<key>entities</key>\n\t<string>x &amp; &lt;y&gt; &#65;&#x42; <!-- comment --> z</string>\n</dict>\n" + std::string(XMLFooter));
+
+    auto deserialize = XML::Deserialize(contents, XML::Create(Encoding::UTF8));
+    ASSERT_NE(deserialize.first, nullptr);
+
+    auto dictionary = Dictionary::New();
+    dictionary->set("blank", String::New(""));
+    dictionary->set("entities", String::New("x & <y> AB  z"));
+    EXPECT_TRUE(deserialize.first->equals(dictionary.get()));
+}
+
+TEST(XML, Invalid)
+{
+    auto mismatched = Contents(std::string(XMLHeader) + "<string>x</strin>\n" + std::string(XMLFooter));
+    EXPECT_EQ(XML::Deserialize(mismatched, XML::Create(Encoding::UTF8)).first, nullptr);
+
+    auto unexpected = Contents(std::string(XMLHeader) + "<dict>\n\t<key>a</key>\n\t<foo />\n</dict>\n" + std::string(XMLFooter));
+    EXPECT_EQ(XML::Deserialize(unexpected, XML::Create(Encoding::UTF8)).first, nullptr);
+}
+
+TEST(XML, Malformed)
+{
+    /* Rejected by libxml2, so rejected when parsed directly too. */
+    std::vector<std::string> invalid = {
+        std::string(XMLHeader) + "<string>a\xFF\xFE" "b</string>\n" + std::string(XMLFooter),
+        std::string(XMLHeader) + "<string>a\xC0\x80" "b</string>\n" + std::string(XMLFooter),
+        std::string(XMLHeader) + "<string>a\xED\xA0\x80" "b</string>\n" + std::string(XMLFooter),
+        std::string(XMLHeader) + "<string>a\x01" "b</string>\n" + std::string(XMLFooter),
+        std::string(XMLHeader) + "<string>a]]>b</string>\n" + std::string(XMLFooter),
+        std::string(XMLHeader) + "<string>a<!-- x -- y -->b</string>\n" + std::string(XMLFooter),
+        std::string(XMLHeader) + "<string>a<!-- \x01 -->b</string>\n" + std::string(XMLFooter),
+        std::string(XMLHeader) + "<pli)t>\n" + std::string(XMLFooter),
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<plist version=\"1.0\x01\">\n<string>a</string>\n" + std::string(XMLFooter),
+        "<?xml version=\"1.0\" e=coding=\"UTF-8\"?>\n<plist version=\"1.0\">\n<string>a</string>\n" + std::string(XMLFooter),
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!DOCTYPE \"list PUBLIC \"-//Apple//DTD PLIST 1.0//EN\" \"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n<plist version=\"1.0\">\n<string>a</string>\n" + std::string(XMLFooter),
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!DOCTYPE pli)t PUBLIC \"-//Apple//DTD PLIST 1.0//EN\" \"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n<plist version=\"1.0\">\n<string>a</string>\n" + std::string(XMLFooter),
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!DOCTYPE plist PUBLIC \"-//Apple//DTD PLIST 1.0//EN\">\n<plist version=\"1.0\">\n<string>a</string>\n" + std::string(XMLFooter),
+    };
+
+    for (std::string const &contents : invalid) {
+        EXPECT_EQ(XML::Deserialize(Contents(contents), XML::Create(Encoding::UTF8)).first, nullptr) << contents;
+    }
+}
+
+TEST(XML, Declaration)
+{
+    /* Other valid forms of the declaration and document type still parse. */
+    std::vector<std::string> valid = {
+        "<?xml version='1.0' encoding='utf-8' standalone='yes' ?>\n<!DOCTYPE plist SYSTEM \"PropertyList-1.0.dtd\">\n<plist version=\"1.0\">\n<string>a\xC3\xA9</string>\n" + std::string(XMLFooter),
+        "<?xml version=\"1.0\"?>\n<!-- comment -->\n<!DOCTYPE plist>\n<plist version=\"1.0\">\n<string>a\xC3\xA9</string>\n" + std::string(XMLFooter),
+        "<plist version=\"1.0\">\n<string>a\xC3\xA9</string>\n" + std::string(XMLFooter),
+    };
+
+    auto string = String::New("a\xC3\xA9");
+    for (std::string const &contents : valid) {
+        auto deserialize = XML::Deserialize(Contents(contents), XML::Create(Encoding::UTF8));
+        ASSERT_NE(deserialize.first, nullptr) << contents;
+        EXPECT_TRUE(deserialize.first->equals(string.get())) << contents;
+    }
+}
+
+TEST(XML, Data)
+{
+    auto contents = Contents(std::string(XMLHeader) + "<data>\n\tAAEC/+7d\n\tzA==\n\t</data>\n" + std::string(XMLFooter));
+
+    auto deserialize = XML::Deserialize(contents, XML::Create(Encoding::UTF8));
+    ASSERT_NE(deserialize.first, nullptr);
+
+    auto data = Data::New(std::vector<uint8_t>({ 0x00, 0x01, 0x02, 0xff, 0xee, 0xdd, 0xcc }));
+    EXPECT_TRUE(deserialize.first->equals(data.get()));
+    EXPECT_EQ("AAEC/+7dzA==", data->base64Value());
+}
@@ -0,0 +1,74 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Objects.h>
+
+using plist::Dictionary;
+using plist::Integer;
+
+TEST(Dictionary, Order)
+{
+    auto d = Dictionary::New();
+    d->set("b", Integer::New(1));
+    d->set("a", Integer::New(2));
+    d->set("c", Integer::New(3));
+    d->set("a", Integer::New(4));
+
+    std::vector<std::string> keys = std::vector<std::string>(d->begin(), d->end());
+    EXPECT_EQ(std::vector<std::string>({ "b", "c", "a" }), keys);
+    EXPECT_EQ(4, d->value<Integer>("a")->value());
+    EXPECT_EQ("c", d->key(1));
+}
+
+TEST(Dictionary, Large)
+{
+    auto d = Dictionary::New();
+    for (int n = 0; n < 100; n++) {
+        d->set(std::to_string(n), Integer::New(n));
+    }
+    EXPECT_EQ(100, d->count());
+
+    for (int n = 0; n < 100; n += 2) {
+        d->remove(std::to_string(n));
+    }
+    EXPECT_EQ(50, d->count());
+
+    for (int n = 0; n < 100; n++) {
+        Integer const *value = d->value<Integer>(std::to_string(n));
+        if (n % 2 == 0) {
+            EXPECT_EQ(nullptr, value);
+        } else {
+            ASSERT_NE(nullptr, value);
+            EXPECT_EQ(n, value->value());
+        }
+    }
+
+    auto copy = d->copy();
+    EXPECT_TRUE(copy->equals(d.get()));
+    EXPECT_EQ(nullptr, d->value("missing"));
+}
+
+TEST(Dictionary, RemoveAll)
+{
+    auto d = Dictionary::New();
+    for (int n = 0; n < 40; n++) {
+        d->set(std::to_string(n), Integer::New(n));
+    }
+
+    for (int n = 0; n < 40; n++) {
+        d->remove(std::to_string(n));
+        EXPECT_EQ(40 - n - 1, d->count());
+        if (n + 1 < 40) {
+            EXPECT_EQ(std::to_string(n + 1), d->key(0));
+            EXPECT_EQ(39, d->value<Integer>("39")->value());
+        }
+    }
+    EXPECT_TRUE(d->empty());
+}
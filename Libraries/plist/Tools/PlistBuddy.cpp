@@ -19,6 +19,7 @@
 #include <plist/Format/Any.h>
 #include <plist/Format/ASCII.h>
 #include <plist/Format/Binary.h>
+#include <plist/Format/BinaryView.h>
 #include <plist/Format/Encoding.h>
 #include <plist/Format/XML.h>
 #include <libutil/Options.h>
@@ -319,6 +320,53 @@ Print(plist::Object *object, std::queue<std::string> &keyPath, bool xml, Filesys
     return true;
 }
 
+/*
+ * Reads only the object at a key path from a binary property list. Returns
+ * null if the file isn't binary or the key path doesn't resolve, in which
+ * case the caller should fall back to reading the whole file.
+ */
+static std::unique_ptr<plist::Object>
+ReadBinaryPropertyListAtKeyPath(Filesystem const *filesystem, std::string const &path, std::queue<std::string> keyPath)
+{
+    std::unique_ptr<Filesystem::Mapping> contents = (path.empty() ? nullptr : filesystem->readMapped(path));
+    if (contents == nullptr) {
+        return nullptr;
+    }
+
+    std::unique_ptr<plist::Format::BinaryView> view = plist::Format::BinaryView::Open(contents->data(), contents->size());
+    if (view == nullptr) {
+        return nullptr;
+    }
+
+    plist::Format::BinaryView::Reference reference = view->root();
+    for (; !keyPath.empty(); keyPath.pop()) {
+        std::string const &currentKey = keyPath.front();
+
+        bool found = false;
+        switch (view->type(reference)) {
+            case plist::ObjectType::Dictionary:
+                found = view->value(reference, currentKey, &reference);
+                break;
+            case plist::ObjectType::Array: {
+                char *end = NULL;
+                long long index = std::strtoll(currentKey.c_str(), &end, 0);
+                if (end != currentKey.c_str() && index >= 0) {
+                    found = view->value(reference, static_cast<size_t>(index), &reference);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+
+        if (!found) {
+            return nullptr;
+        }
+    }
+
+    return view->materialize(reference);
+}
+
 static bool
 Set(plist::Object *object, std::queue<std::string> &keyPath, plist::ObjectType type, const std::string &valueString, bool overwrite = true)
 {
@@ -626,6 +674,28 @@ main(int argc, char **argv)
         }
     }
 
+    /*
+     * A single Print of a binary property list only needs the printed object.
+     */
+    if (options.command()) {
+        std::vector<std::string> tokens;
+        std::stringstream sstream(*options.command());
+        std::copy(std::istream_iterator<std::string>(sstream), std::istream_iterator<std::string>(), std::back_inserter(tokens));
+
+        if (!tokens.empty() && tokens[0] == "Print") {
+            std::queue<std::string> keyPath;
+            if (tokens.size() > 1) {
+                ParseCommandKeyPathString(tokens[1], &keyPath);
+            }
+
+            std::unique_ptr<plist::Object> object = ReadBinaryPropertyListAtKeyPath(&filesystem, options.input(), keyPath);
+            if (object != nullptr) {
+                std::queue<std::string> emptyKeyPath;
+                return (Print(object.get(), emptyKeyPath, options.xml()) ? 0 : 1);
+            }
+        }
+    }
+
     RootObjectContainer root;
     root.object = ReadPropertyList(&filesystem, options.input());
     if (!root.object) {
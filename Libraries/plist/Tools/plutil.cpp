@@ -26,10 +26,12 @@
 #include <libutil/DefaultFilesystem.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 #include <process/DefaultContext.h>
 #include <process/Context.h>
 
 #include <algorithm>
+#include <functional>
 #include <iterator>
 #include <iostream>
 
@@ -104,6 +106,7 @@ public:
 
 private:
     std::vector<std::string>   _inputs;
+    ext::optional<std::string> _filesFrom;
     ext::optional<std::string> _output;
     ext::optional<std::string> _extension;
     ext::optional<bool>        _separator;
@@ -135,6 +138,8 @@ public:
 public:
     std::vector<std::string> const &inputs() const
     { return _inputs; }
+    ext::optional<std::string> const &filesFrom() const
+    { return _filesFrom; }
     ext::optional<std::string> const &output() const
     { return _output; }
     ext::optional<std::string> const &extension() const
@@ -403,6 +408,8 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
 
         _convert = format;
         return result;
+    } else if (arg == "-files-from") {
+        return libutil::Options::Next<std::string>(&_filesFrom, args, it);
     } else if (arg == "-e") {
         return libutil::Options::Next<std::string>(&_extension, args, it);
     } else if (arg == "-o") {
@@ -429,6 +436,7 @@ Help(std::string const &error = std::string())
     }
 
     fprintf(stderr, "usage: plutil -<command> [options] <files>\n");
+    fprintf(stderr, "       plutil -<command> [options] -files-from <path>\n");
 
 #define INDENT "  "
     fprintf(stderr, "\ncommands:\n");
@@ -461,6 +469,16 @@ Help(std::string const &error = std::string())
     return (error.empty() ? 0 : -1);
 }
 
+/*
+ * What processing an input printed. Inputs are processed in parallel, so
+ * this is kept to print in the order of the inputs.
+ */
+struct Report {
+    bool                 success;
+    std::vector<uint8_t> output;
+    std::string          errors;
+};
+
 static std::pair<bool, std::vector<uint8_t>>
 Read(Filesystem const *filesystem, std::string const &path = "-")
 {
@@ -480,11 +498,11 @@ Read(Filesystem const *filesystem, std::string const &path = "-")
 }
 
 static bool
-Write(Filesystem *filesystem, std::vector<uint8_t> const &contents, std::string const &path = "-")
+Write(Filesystem *filesystem, Report *report, std::vector<uint8_t> const &contents, std::string const &path = "-")
 {
     if (path == "-") {
         /* - means write to stdout. */
-        std::copy(contents.begin(), contents.end(), std::ostream_iterator<char>(std::cout));
+        report->output.insert(report->output.end(), contents.begin(), contents.end());
     } else {
         /* Read from file. */
         if (!filesystem->write(contents, path)) {
@@ -496,30 +514,31 @@ Write(Filesystem *filesystem, std::vector<uint8_t> const &contents, std::string
 }
 
 static bool
-Lint(Options const &options, std::string const &file)
+Lint(Options const &options, Report *report, std::string const &file)
 {
     if (!options.silent()) {
         /* Already linted by virtue of getting this far. */
-        printf("%s: OK\n", file.c_str());
+        std::string line = file + ": OK\n";
+        report->output.insert(report->output.end(), line.begin(), line.end());
     }
 
     return true;
 }
 
 static bool
-Print(Filesystem *filesystem, Options const &options, std::unique_ptr<plist::Object> object, plist::Format::Any const &format)
+Print(Filesystem *filesystem, Options const &options, Report *report, std::unique_ptr<plist::Object> object, plist::Format::Any const &format)
 {
     /* Convert to ASCII. */
     plist::Format::ASCII out = plist::Format::ASCII::Create(false, plist::Format::Encoding::UTF8);
     auto serialize = plist::Format::ASCII::Serialize(object.get(), out);
     if (serialize.first == nullptr) {
-        fprintf(stderr, "error: %s\n", serialize.second.c_str());
+        report->errors += "error: " + serialize.second + "\n";
         return false;
     }
 
     /* Print. */
-    if (!Write(filesystem, *serialize.first)) {
-        fprintf(stderr, "error: unable to write\n");
+    if (!Write(filesystem, report, *serialize.first)) {
+        report->errors += "error: unable to write\n";
         return false;
     }
 
@@ -602,7 +621,7 @@ PerformAdjustment(plist::Object *object, plist::Object **rootObject, std::string
 }
 
 static bool
-Modify(Filesystem *filesystem, Options const &options, std::string const &file, std::unique_ptr<plist::Object> object, plist::Format::Any const &format)
+Modify(Filesystem *filesystem, Options const &options, Report *report, std::string const &file, std::unique_ptr<plist::Object> object, plist::Format::Any const &format)
 {
     plist::Object *writeObject = object.get();
 
@@ -632,7 +651,7 @@ Modify(Filesystem *filesystem, Options const &options, std::string const &file,
             }
 
             if (currentObject == nullptr) {
-                fprintf(stderr, "error: invalid key path\n");
+                report->errors += "error: invalid key path\n";
                 return false;
             }
 
@@ -677,17 +696,82 @@ Modify(Filesystem *filesystem, Options const &options, std::string const &file,
     }
 
     if (serialize.first == nullptr) {
-        fprintf(stderr, "error: %s\n", serialize.second.c_str());
+        report->errors += "error: " + serialize.second + "\n";
         return false;
     }
 
     /* Write to output. */
     std::string output = OutputPath(options, file);
-    if (!Write(filesystem, *serialize.first, output)) {
-        fprintf(stderr, "error: unable to write\n");
+    if (!Write(filesystem, report, *serialize.first, output)) {
+        report->errors += "error: unable to write\n";
+        return false;
+    }
+
+    return true;
+}
+
+static bool
+Process(Filesystem *filesystem, Options const &options, Report *report, std::string const &file)
+{
+    std::pair<bool, std::vector<uint8_t>> result = Read(filesystem, file);
+    if (!result.first) {
+        report->errors += "error: unable to read " + file + "\n";
+        return false;
+    }
+
+    auto format = plist::Format::Any::Identify(result.second);
+    if (format == nullptr) {
+        report->errors += "error: input " + file + " not a plist\n";
+        return false;
+    }
+
+    auto deserialize = plist::Format::Any::Deserialize(result.second, *format);
+    if (!deserialize.first) {
+        report->errors += "error: " + deserialize.second + "\n";
+        return false;
+    }
+
+    /* Perform the sepcific action. */
+    bool modify = (options.convert() || !options.adjustments().empty());
+    if (modify) {
+        return Modify(filesystem, options, report, file, std::move(deserialize.first), *format);
+    } else if (options.print()) {
+        return Print(filesystem, options, report, std::move(deserialize.first), *format);
+    } else {
+        return Lint(options, report, file);
+    }
+}
+
+/*
+ * Read a list of inputs, one path per line.
+ */
+static bool
+ReadFilesFrom(Filesystem const *filesystem, std::string const &path, std::vector<std::string> *inputs)
+{
+    std::pair<bool, std::vector<uint8_t>> result = Read(filesystem, path);
+    if (!result.first) {
         return false;
     }
 
+    std::string contents = std::string(result.second.begin(), result.second.end());
+    std::string::size_type start = 0;
+    while (start < contents.size()) {
+        std::string::size_type end = contents.find('\n', start);
+        if (end == std::string::npos) {
+            end = contents.size();
+        }
+
+        std::string line = contents.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            inputs->push_back(line);
+        }
+
+        start = end + 1;
+    }
+
     return true;
 }
 
@@ -718,43 +802,42 @@ main(int argc, char **argv)
     if (options.help()) {
         return Help();
     } else {
-        bool success = true;
+        std::vector<std::string> inputs = options.inputs();
+        if (options.filesFrom()) {
+            if (!ReadFilesFrom(&filesystem, *options.filesFrom(), &inputs)) {
+                fprintf(stderr, "error: unable to read %s\n", options.filesFrom()->c_str());
+                return 1;
+            }
+        }
 
-        if (options.inputs().empty()) {
+        if (inputs.empty()) {
             return Help("no input files");
         }
 
-        /* Actions applied to each input file separately. */
-        for (std::string const &file : options.inputs()) {
-            std::pair<bool, std::vector<uint8_t>> result = Read(&filesystem, file);
-            if (!result.first) {
-                fprintf(stderr, "error: unable to read %s\n", file.c_str());
-                success = false;
-                continue;
-            }
-
-            auto format = plist::Format::Any::Identify(result.second);
-            if (format == nullptr) {
-                fprintf(stderr, "error: input %s not a plist\n", file.c_str());
-                success = false;
-                continue;
-            }
+        /*
+         * Actions applied to each input file separately, so in parallel.
+         * Only one input can be written to a single output path or read
+         * from standard input, so those are processed in order.
+         */
+        bool ordered = (options.output() || std::find(inputs.begin(), inputs.end(), "-") != inputs.end());
 
-            auto deserialize = plist::Format::Any::Deserialize(result.second, *format);
-            if (!deserialize.first) {
-                fprintf(stderr, "error: %s\n", deserialize.second.c_str());
-                success = false;
-                continue;
+        std::vector<Report> reports = std::vector<Report>(inputs.size());
+        auto processInput = [&](size_t index) {
+            reports[index].success = Process(&filesystem, options, &reports[index], inputs[index]);
+        };
+        if (ordered) {
+            for (size_t index = 0; index < inputs.size(); ++index) {
+                processInput(index);
             }
+        } else {
+            libutil::Parallel::For(inputs.size(), processInput);
+        }
 
-            /* Perform the sepcific action. */
-            if (modify) {
-                success &= Modify(&filesystem, options, file, std::move(deserialize.first), *format);
-            } else if (options.print()) {
-                success &= Print(&filesystem, options, std::move(deserialize.first), *format);
-            } else if (options.lint() || true) {
-                success &= Lint(options, file);
-            }
+        bool success = true;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            fputs(reports[i].errors.c_str(), stderr);
+            fwrite(reports[i].output.data(), 1, reports[i].output.size(), stdout);
+            success &= reports[i].success;
         }
 
         return (success ? 0 : 1);
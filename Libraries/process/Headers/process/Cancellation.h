@@ -0,0 +1,56 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __process_Cancellation_h
+#define __process_Cancellation_h
+
+#include <atomic>
+
+namespace process {
+
+/*
+ * Asks work in progress to stop. Cancelling is safe from any thread and
+ * from signal handlers. Once cancelled, the descriptor stays readable, so
+ * anything waiting with `poll()` can wake up for it.
+ */
+class Cancellation {
+private:
+    std::atomic<bool> _cancelled;
+    int               _fds[2];
+
+public:
+    Cancellation();
+    ~Cancellation();
+
+public:
+    Cancellation(Cancellation const &) = delete;
+    Cancellation &operator=(Cancellation const &) = delete;
+
+public:
+    /*
+     * Cancel. Cancelling again does nothing.
+     */
+    void cancel();
+
+    /*
+     * If cancelled.
+     */
+    bool cancelled() const
+    { return _cancelled.load(); }
+
+    /*
+     * Readable once cancelled, or -1 if it couldn't be created.
+     */
+    int descriptor() const
+    { return _fds[0]; }
+};
+
+}
+
+#endif  // !__process_Cancellation_h
@@ -10,6 +10,7 @@
 #ifndef __process_Context_h
 #define __process_Context_h
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -52,6 +53,13 @@ public:
      */
     virtual ext::optional<std::string> environmentVariable(std::string const &variable) const = 0;
 
+    /*
+     * All environment variables, if they're shared with other contexts and
+     * don't change. Launchers can prepare shared environment variables once
+     * for all the processes they're launched with.
+     */
+    virtual std::shared_ptr<std::unordered_map<std::string, std::string> const> sharedEnvironmentVariables() const;
+
 public:
     /*
      * Active user ID.
@@ -12,20 +12,57 @@
 
 #include <process/Launcher.h>
 
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <sys/types.h>
+
 namespace libutil { class Filesystem; }
 
 namespace process {
 
 /*
- * Abstract process launcher.
+ * Launches processes on the host system. Not thread safe.
  */
 class DefaultLauncher : public Launcher {
+private:
+    struct Child {
+        pid_t       pid;
+        int         fd;
+        std::string output;
+        bool        group;
+        ext::optional<std::chrono::steady_clock::time_point> stopped;
+        bool        killed;
+    };
+
+    /*
+     * Shared environment variables prepared for exec.
+     */
+    struct Environment {
+        std::weak_ptr<std::unordered_map<std::string, std::string> const> variables;
+        std::vector<std::string>                                          entries;
+        std::vector<char const *>                                         pointers;
+    };
+
+private:
+    std::unordered_map<Handle, Child> _children;
+    std::unordered_map<std::unordered_map<std::string, std::string> const *, Environment> _environments;
+
 public:
     DefaultLauncher();
     ~DefaultLauncher();
 
 public:
     virtual ext::optional<int> launch(libutil::Filesystem *filesystem, Context const *context);
+
+public:
+    virtual ext::optional<Handle> start(libutil::Filesystem *filesystem, Context const *context);
+    virtual ext::optional<Result> wait();
+    virtual ext::optional<uint64_t> memory(Handle handle) const;
+
+private:
+    std::vector<char const *> const *environment(Context const *context);
+    static void stop(Child *child);
 };
 
 }
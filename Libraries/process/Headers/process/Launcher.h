@@ -12,6 +12,7 @@
 
 #include <process/Context.h>
 
+#include <list>
 #include <sstream>
 #include <ext/optional>
 
@@ -19,10 +20,69 @@ namespace libutil { class Filesystem; }
 
 namespace process {
 
+class Cancellation;
+
 /*
  * Abstract process launcher.
  */
 class Launcher {
+public:
+    /*
+     * Identifies a process started with `start()`.
+     */
+    using Handle = uint64_t;
+
+    /*
+     * A process started with `start()` that has exited.
+     */
+    class Result {
+    private:
+        Handle                  _handle;
+        ext::optional<int64_t>  _processIdentifier;
+        ext::optional<int>      _exitCode;
+        std::string             _output;
+        ext::optional<uint64_t> _peakMemory;
+
+    public:
+        Result(Handle handle, ext::optional<int64_t> const &processIdentifier, ext::optional<int> const &exitCode, std::string const &output, ext::optional<uint64_t> const &peakMemory);
+
+    public:
+        /*
+         * The process that exited.
+         */
+        Handle handle() const
+        { return _handle; }
+
+        /*
+         * The system identifier of the process, if it had one.
+         */
+        ext::optional<int64_t> const &processIdentifier() const
+        { return _processIdentifier; }
+
+        /*
+         * The exit code of the process, if it exited normally.
+         */
+        ext::optional<int> const &exitCode() const
+        { return _exitCode; }
+
+        /*
+         * The standard output and standard error of the process.
+         */
+        std::string const &output() const
+        { return _output; }
+
+        /*
+         * The most memory the process used at once, in bytes, if known.
+         */
+        ext::optional<uint64_t> const &peakMemory() const
+        { return _peakMemory; }
+    };
+
+private:
+    Handle              _nextHandle;
+    std::list<Result>   _results;
+    Cancellation const *_cancellation;
+
 protected:
     Launcher();
     ~Launcher();
@@ -34,6 +94,65 @@ public:
      */
     virtual ext::optional<int> launch(libutil::Filesystem *filesystem, Context const *context) = 0;
 
+public:
+    /*
+     * Start a process without waiting for it to exit. The output of the
+     * process is captured and returned from `wait()`, so output from many
+     * processes running at once does not interleave. By default, this runs
+     * the process to completion with `launch()`.
+     */
+    virtual ext::optional<Handle> start(libutil::Filesystem *filesystem, Context const *context);
+
+    /*
+     * Wait for any process from `start()` to exit. Returns nothing if there
+     * are no processes that have not yet been waited for.
+     */
+    virtual ext::optional<Result> wait();
+
+    /*
+     * How much memory a process from `start()` that has not been waited
+     * for, with the processes it started, is using now, in bytes, if known.
+     */
+    virtual ext::optional<uint64_t> memory(Handle handle) const;
+
+public:
+    /*
+     * Stop the processes launched or started while set, and what they start
+     * in turn, when cancelled. Waiting for them stops early, and they are
+     * returned from `wait()` once they exit. Set to nothing to stop.
+     */
+    void setCancellation(Cancellation const *cancellation)
+    { _cancellation = cancellation; }
+
+    Cancellation const *cancellation() const
+    { return _cancellation; }
+
+public:
+    /*
+     * Sets a cancellation for as long as it exists.
+     */
+    class CancellationScope {
+    private:
+        Launcher *_launcher;
+
+    public:
+        CancellationScope(Launcher *launcher, Cancellation const *cancellation) :
+            _launcher(launcher)
+        { _launcher->setCancellation(cancellation); }
+        ~CancellationScope()
+        { _launcher->setCancellation(nullptr); }
+
+    public:
+        CancellationScope(CancellationScope const &) = delete;
+        CancellationScope &operator=(CancellationScope const &) = delete;
+    };
+
+protected:
+    /*
+     * Create a unique handle for a started process.
+     */
+    Handle nextHandle();
+
 public:
     /*
      * Get the system instance.
@@ -0,0 +1,52 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <process/Cancellation.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using process::Cancellation;
+
+Cancellation::
+Cancellation() :
+    _cancelled(false)
+{
+    if (::pipe(_fds) != 0) {
+        _fds[0] = -1;
+        _fds[1] = -1;
+        return;
+    }
+
+    /* Not for the processes started while waiting. */
+    for (int fd : _fds) {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+}
+
+Cancellation::
+~Cancellation()
+{
+    for (int fd : _fds) {
+        if (fd != -1) {
+            ::close(fd);
+        }
+    }
+}
+
+void Cancellation::
+cancel()
+{
+    /* Only uses what's safe in a signal handler. */
+    if (!_cancelled.exchange(true) && _fds[1] != -1) {
+        char byte = 0;
+        ssize_t written = ::write(_fds[1], &byte, sizeof(byte));
+        (void)written;
+    }
+}
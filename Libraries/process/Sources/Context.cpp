@@ -47,6 +47,12 @@ executableSearchPaths() const
     return paths;
 }
 
+std::shared_ptr<std::unordered_map<std::string, std::string> const> Context::
+sharedEnvironmentVariables() const
+{
+    return nullptr;
+}
+
 ext::optional<std::string> Context::
 userHomeDirectory() const
 {
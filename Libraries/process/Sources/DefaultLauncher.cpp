@@ -8,12 +8,36 @@
  */
 
 #include <process/DefaultLauncher.h>
+#include <process/Cancellation.h>
 #include <libutil/Filesystem.h>
 
+#include <cerrno>
+#include <fstream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#if defined(__APPLE__)
+#include <libproc.h>
+#endif
+
+/*
+ * Spawning requires changing directory in the new process, which is not part
+ * of POSIX. It's available as an extension in newer C libraries.
+ */
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define HAVE_POSIX_SPAWN_CHDIR 1
+#elif defined(__APPLE__) && defined(__MAC_OS_X_VERSION_MIN_REQUIRED) && __MAC_OS_X_VERSION_MIN_REQUIRED >= 101500
+#define HAVE_POSIX_SPAWN_CHDIR 1
+#endif
+
 using process::DefaultLauncher;
+using process::Launcher;
 using libutil::Filesystem;
 
 DefaultLauncher::
@@ -27,60 +51,185 @@ DefaultLauncher::
 {
 }
 
-ext::optional<int> DefaultLauncher::
-launch(Filesystem *filesystem, Context const *context)
-{
+namespace {
+
+/*
+ * Input data for exec, extracted so no C++ is required after fork. Strings
+ * are used in place from the context, which outlives starting the process.
+ */
+class ExecData {
+public:
+    std::string const               &path;
+    std::string const               &directory;
+    std::vector<std::string>         environment;
+    std::vector<char const *>        execArgs;
+    std::vector<char const *>        ownExecEnv;
+    std::vector<char const *> const *execEnvPointer;
+    uid_t                            uid;
+    gid_t                            gid;
+    bool                             group;
+
+public:
     /*
-     * Extract input data for exec, so no C++ is required after fork.
+     * Uses the environment given if already prepared; otherwise, prepares
+     * one from the context. With `group`, the process starts a new process
+     * group, so it can be stopped along with what it starts.
      */
-    std::string path = context->executablePath();
-    if (!filesystem->isExecutable(path)) {
-        return ext::nullopt;
-    }
-    char const *cPath = path.c_str();
+    ExecData(process::Context const *context, std::vector<char const *> const *execEnv, bool group) :
+        path          (context->executablePath()),
+        directory     (context->currentDirectory()),
+        execEnvPointer(execEnv),
+        uid           (context->userID()),
+        gid           (context->groupID()),
+        group         (group)
+    {
+        /* Compute command-line arguments. */
+        execArgs.reserve(context->commandLineArguments().size() + 2);
+        execArgs.push_back(path.c_str());
+        for (std::string const &argument : context->commandLineArguments()) {
+            execArgs.push_back(argument.c_str());
+        }
+        execArgs.push_back(nullptr);
 
-    std::string directory = context->currentDirectory();
-    char const *cDirectory = directory.c_str();
+        /* Compute environment variables. */
+        if (execEnvPointer == nullptr) {
+            PrepareEnvironment(context->environmentVariables(), &environment, &ownExecEnv);
+            execEnvPointer = &ownExecEnv;
+        }
+    }
 
-    /* Compute command-line arguments. */
-    std::vector<char const *> execArgs;
-    execArgs.push_back(cPath);
+public:
+    /*
+     * Creates the "NAME=value" entries for exec, and the null terminated
+     * pointers to them.
+     */
+    static void
+    PrepareEnvironment(std::unordered_map<std::string, std::string> const &variables, std::vector<std::string> *entries, std::vector<char const *> *pointers)
+    {
+        entries->reserve(variables.size());
+        for (auto const &value : variables) {
+            std::string entry;
+            entry.reserve(value.first.size() + 1 + value.second.size());
+            entry += value.first;
+            entry += '=';
+            entry += value.second;
+            entries->push_back(std::move(entry));
+        }
 
-    std::vector<std::string> arguments = context->commandLineArguments();
-    for (std::string const &argument : arguments) {
-        execArgs.push_back(argument.c_str());
+        pointers->reserve(entries->size() + 1);
+        for (std::string const &entry : *entries) {
+            pointers->push_back(entry.c_str());
+        }
+        pointers->push_back(nullptr);
     }
 
-    execArgs.push_back(nullptr);
-    char *const *cExecArgs = const_cast<char *const *>(execArgs.data());
+public:
+    /*
+     * Start the process. If `output` is valid, it replaces standard output
+     * and standard error. Returns the process ID, or -1 on failure.
+     */
+    pid_t spawn(int output) const
+    {
+#if HAVE_POSIX_SPAWN_CHDIR
+        /*
+         * Spawning avoids copying the page tables of this process, which
+         * can be large. Changing user isn't possible, so fork for that.
+         */
+        if (uid == ::getuid() && gid == ::getgid()) {
+            return posixSpawn(output);
+        }
+#endif
 
-    /* Compute environment variables. */
-    std::vector<std::string> envValues;
-    for (auto const &value : context->environmentVariables()) {
-        envValues.push_back(value.first + "=" + value.second);
+        return fork(output);
     }
 
-    std::vector<char const *> execEnv;
-    for (auto const &value : envValues) {
-        execEnv.push_back(value.c_str());
+private:
+#if HAVE_POSIX_SPAWN_CHDIR
+    pid_t posixSpawn(int output) const
+    {
+        posix_spawn_file_actions_t actions;
+        if (::posix_spawn_file_actions_init(&actions) != 0) {
+            return -1;
+        }
+
+        posix_spawnattr_t attributes;
+        if (::posix_spawnattr_init(&attributes) != 0) {
+            ::posix_spawn_file_actions_destroy(&actions);
+            return -1;
+        }
+
+        /* Start with no signals blocked and default signal handlers. */
+        sigset_t mask;
+        sigemptyset(&mask);
+        ::posix_spawnattr_setsigmask(&attributes, &mask);
+
+        sigset_t defaults;
+        sigfillset(&defaults);
+        sigdelset(&defaults, SIGKILL);
+        sigdelset(&defaults, SIGSTOP);
+        ::posix_spawnattr_setsigdefault(&attributes, &defaults);
+
+        short flags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+        if (group) {
+            ::posix_spawnattr_setpgroup(&attributes, 0);
+            flags |= POSIX_SPAWN_SETPGROUP;
+        }
+        ::posix_spawnattr_setflags(&attributes, flags);
+
+        bool valid = (::posix_spawn_file_actions_addchdir_np(&actions, directory.c_str()) == 0);
+        if (valid && output != -1) {
+            valid = (::posix_spawn_file_actions_adddup2(&actions, output, STDOUT_FILENO) == 0 &&
+                     ::posix_spawn_file_actions_adddup2(&actions, output, STDERR_FILENO) == 0 &&
+                     ::posix_spawn_file_actions_addclose(&actions, output) == 0);
+        }
+
+        pid_t pid = -1;
+        if (valid) {
+            if (::posix_spawn(&pid, path.c_str(), &actions, &attributes, const_cast<char *const *>(execArgs.data()), const_cast<char *const *>(execEnvPointer->data())) != 0) {
+                pid = -1;
+            }
+        }
+
+        ::posix_spawnattr_destroy(&attributes);
+        ::posix_spawn_file_actions_destroy(&actions);
+        return pid;
     }
-    execEnv.push_back(nullptr);
-    char *const *cExecEnv = const_cast<char *const *>(execEnv.data());
+#endif
+
+    pid_t fork(int output) const
+    {
+        pid_t pid = ::fork();
+        if (pid != 0) {
+            /* Both set the group, so it's set before either goes on. */
+            if (pid > 0 && group) {
+                ::setpgid(pid, pid);
+            }
+
+            /* Fork failed, or existing process. */
+            return pid;
+        }
+
+        /* Fork succeeded, new process. */
+        if (group) {
+            ::setpgid(0, 0);
+        }
 
-    /* Compute user. */
-    uid_t uid = context->userID();
-    gid_t gid = context->groupID();
+        if (output != -1) {
+            if (::dup2(output, STDOUT_FILENO) == -1 || ::dup2(output, STDERR_FILENO) == -1) {
+                ::_exit(1);
+            }
+            ::close(output);
+        }
+
+        exec();
+    }
 
     /*
-     * Fork new process.
+     * Run in the forked process. Does not return.
      */
-    pid_t pid = fork();
-    if (pid < 0) {
-        /* Fork failed. */
-        return ext::nullopt;
-    } else if (pid == 0) {
-        /* Fork succeeded, new process. */
-        if (::chdir(cDirectory) == -1) {
+    [[noreturn]] void exec() const
+    {
+        if (::chdir(directory.c_str()) == -1) {
             ::perror("chdir");
             ::_exit(1);
         }
@@ -95,14 +244,326 @@ launch(Filesystem *filesystem, Context const *context)
             ::_exit(1);
         }
 
-        ::execve(cPath, cExecArgs, cExecEnv);
+        ::execve(path.c_str(), const_cast<char *const *>(execArgs.data()), const_cast<char *const *>(execEnvPointer->data()));
         ::_exit(-1);
+    }
+};
 
-        return ext::nullopt;
+}
+
+static int
+ExitCode(int status)
+{
+    if (WIFSIGNALED(status)) {
+        /* Follow the shell convention for processes killed by signals. */
+        return 128 + WTERMSIG(status);
     } else {
-        /* Fork succeeded, existing process. */
-        int status;
-        ::waitpid(pid, &status, 0);
         return WEXITSTATUS(status);
     }
 }
+
+static uint64_t
+PeakMemory(struct rusage const &usage)
+{
+#if defined(__APPLE__)
+    /* In bytes here, but kilobytes elsewhere. */
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+/*
+ * How long stopped processes have to exit before they're killed.
+ */
+static std::chrono::seconds const StopTimeout = std::chrono::seconds(2);
+
+/*
+ * How often to check if children holding their output open have exited.
+ */
+static int const ExitInterval = 50;
+
+/*
+ * Read what's left in a child's output without waiting for more, then
+ * close it. Anything the child started may still hold the other end.
+ */
+static void
+DrainOutput(std::string *output, int fd)
+{
+    while (true) {
+        char buffer[4096];
+        ssize_t size = ::read(fd, buffer, sizeof(buffer));
+        if (size > 0) {
+            output->append(buffer, size);
+        } else if (size == 0 || errno != EINTR) {
+            break;
+        }
+    }
+
+    ::close(fd);
+}
+
+void DefaultLauncher::
+stop(Child *child)
+{
+    /* Without a group of its own, only the process itself can be stopped. */
+    pid_t target = (child->group ? -child->pid : child->pid);
+
+    if (!child->stopped) {
+        ::kill(target, SIGTERM);
+        child->stopped = std::chrono::steady_clock::now();
+    } else if (!child->killed && std::chrono::steady_clock::now() - *child->stopped >= StopTimeout) {
+        ::kill(target, SIGKILL);
+        child->killed = true;
+    }
+}
+
+ext::optional<int> DefaultLauncher::
+launch(Filesystem *filesystem, Context const *context)
+{
+    if (!filesystem->isExecutable(context->executablePath())) {
+        return ext::nullopt;
+    }
+
+    Cancellation const *cancellation = this->cancellation();
+    ExecData data(context, environment(context), cancellation != nullptr);
+
+    pid_t pid = data.spawn(-1);
+    if (pid < 0) {
+        return ext::nullopt;
+    }
+
+    int status;
+    if (cancellation == nullptr) {
+        ::waitpid(pid, &status, 0);
+        return ExitCode(status);
+    }
+
+    /*
+     * Check for cancellation while waiting, and stop the process if so. The
+     * exit can't be waited for along with the cancellation, so check often.
+     */
+    Child child = Child { pid, -1, std::string(), true, ext::nullopt, false };
+    while (true) {
+        pid_t waited = ::waitpid(pid, &status, WNOHANG);
+        if (waited == pid) {
+            return ExitCode(status);
+        } else if (waited == -1 && errno != EINTR) {
+            return ext::nullopt;
+        }
+
+        if (cancellation->cancelled()) {
+            stop(&child);
+            ::usleep(10 * 1000);
+        } else {
+            struct pollfd pollfd = { cancellation->descriptor(), POLLIN, 0 };
+            ::poll(&pollfd, 1, 10);
+        }
+    }
+}
+
+ext::optional<Launcher::Handle> DefaultLauncher::
+start(Filesystem *filesystem, Context const *context)
+{
+    if (!filesystem->isExecutable(context->executablePath())) {
+        return ext::nullopt;
+    }
+
+    ExecData data(context, environment(context), cancellation() != nullptr);
+
+    /*
+     * Capture both standard output and standard error in one pipe, to
+     * keep the order of output between them.
+     */
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        return ext::nullopt;
+    }
+    ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    pid_t pid = data.spawn(fds[1]);
+    ::close(fds[1]);
+
+    if (pid < 0) {
+        ::close(fds[0]);
+        return ext::nullopt;
+    }
+
+    Handle handle = nextHandle();
+    _children.insert({ handle, Child { pid, fds[0], std::string(), data.group, ext::nullopt, false } });
+    return handle;
+}
+
+/*
+ * The resident memory of a process and the processes it started, in bytes.
+ */
+static ext::optional<uint64_t>
+ProcessMemory(pid_t pid)
+{
+#if defined(__linux__)
+    std::ifstream statm("/proc/" + std::to_string(pid) + "/statm");
+    uint64_t size;
+    uint64_t resident;
+    if (!(statm >> size >> resident)) {
+        return ext::nullopt;
+    }
+    uint64_t memory = resident * static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+
+    std::ifstream children("/proc/" + std::to_string(pid) + "/task/" + std::to_string(pid) + "/children");
+    pid_t child;
+    while (children >> child) {
+        memory += ProcessMemory(child).value_or(0);
+    }
+    return memory;
+#elif defined(__APPLE__)
+    struct proc_taskinfo info;
+    if (::proc_pidinfo(pid, PROC_PIDTASKINFO, 0, &info, sizeof(info)) != sizeof(info)) {
+        return ext::nullopt;
+    }
+    uint64_t memory = info.pti_resident_size;
+
+    std::vector<pid_t> children = std::vector<pid_t>(64);
+    int count = ::proc_listchildpids(pid, children.data(), static_cast<int>(children.size() * sizeof(pid_t)));
+    for (int i = 0; i < count && i < static_cast<int>(children.size()); ++i) {
+        memory += ProcessMemory(children[i]).value_or(0);
+    }
+    return memory;
+#else
+    return ext::nullopt;
+#endif
+}
+
+ext::optional<uint64_t> DefaultLauncher::
+memory(Handle handle) const
+{
+    auto it = _children.find(handle);
+    if (it == _children.end()) {
+        return ext::nullopt;
+    }
+
+    return ProcessMemory(it->second.pid);
+}
+
+std::vector<char const *> const *DefaultLauncher::
+environment(Context const *context)
+{
+    std::shared_ptr<std::unordered_map<std::string, std::string> const> variables = context->sharedEnvironmentVariables();
+    if (variables == nullptr) {
+        return nullptr;
+    }
+
+    auto it = _environments.find(variables.get());
+    if (it != _environments.end() && it->second.variables.lock() == variables) {
+        return &it->second.pointers;
+    }
+
+    /* Forget environments no longer used, since their addresses can be reused. */
+    for (auto jt = _environments.begin(); jt != _environments.end();) {
+        if (jt->second.variables.expired()) {
+            jt = _environments.erase(jt);
+        } else {
+            ++jt;
+        }
+    }
+
+    Environment &environment = _environments[variables.get()];
+    environment.variables = variables;
+    environment.entries.clear();
+    environment.pointers.clear();
+    ExecData::PrepareEnvironment(*variables, &environment.entries, &environment.pointers);
+    return &environment.pointers;
+}
+
+ext::optional<Launcher::Result> DefaultLauncher::
+wait()
+{
+    if (_children.empty()) {
+        return ext::nullopt;
+    }
+
+    while (true) {
+        /*
+         * Once cancelled, stop every child. They're returned as they exit.
+         */
+        bool cancelled = (cancellation() != nullptr && cancellation()->cancelled());
+        if (cancelled) {
+            for (auto &entry : _children) {
+                stop(&entry.second);
+            }
+        }
+
+        /*
+         * Reap a child if it has exited, even if its output is still open:
+         * a background process it started can hold the output open forever.
+         */
+        bool closed = false;
+        for (auto it = _children.begin(); it != _children.end(); ++it) {
+            int status;
+            struct rusage usage;
+            pid_t pid = ::wait4(it->second.pid, &status, WNOHANG, &usage);
+            if (pid == it->second.pid || (pid == -1 && errno != EINTR)) {
+                if (it->second.fd != -1) {
+                    DrainOutput(&it->second.output, it->second.fd);
+                }
+
+                ext::optional<int> exitCode = (pid == it->second.pid ? ext::optional<int>(ExitCode(status)) : ext::nullopt);
+                ext::optional<uint64_t> peakMemory = (pid == it->second.pid ? ext::optional<uint64_t>(PeakMemory(usage)) : ext::nullopt);
+                Result result = Result(it->first, static_cast<int64_t>(it->second.pid), exitCode, it->second.output, peakMemory);
+                _children.erase(it);
+                return result;
+            }
+
+            if (it->second.fd == -1) {
+                closed = true;
+            }
+        }
+
+        /*
+         * Wait for output. If a child closed its output but has not exited
+         * yet, check back on it shortly. Exits aren't seen by polling, so
+         * check for them regularly either way.
+         */
+        std::vector<struct pollfd> pollfds;
+        std::vector<Handle> handles;
+        for (auto const &entry : _children) {
+            if (entry.second.fd != -1) {
+                pollfds.push_back({ entry.second.fd, POLLIN, 0 });
+                handles.push_back(entry.first);
+            }
+        }
+
+        /*
+         * Wake up when cancelled. After, check back on stopped children,
+         * which are killed if they don't exit in time.
+         */
+        if (cancellation() != nullptr && !cancelled && cancellation()->descriptor() != -1) {
+            pollfds.push_back({ cancellation()->descriptor(), POLLIN, 0 });
+        }
+
+        int ready = ::poll(pollfds.data(), pollfds.size(), closed ? 10 : ExitInterval);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return ext::nullopt;
+        }
+
+        for (size_t i = 0; i < handles.size(); ++i) {
+            if (pollfds[i].revents == 0) {
+                continue;
+            }
+
+            Child &child = _children.find(handles[i])->second;
+
+            char buffer[4096];
+            ssize_t size = ::read(child.fd, buffer, sizeof(buffer));
+            if (size > 0) {
+                child.output.append(buffer, size);
+            } else if (size == 0 || (errno != EINTR && errno != EAGAIN)) {
+                ::close(child.fd);
+                child.fd = -1;
+            }
+        }
+    }
+}
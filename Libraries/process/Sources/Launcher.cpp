@@ -11,8 +11,20 @@
 
 using process::Launcher;
 
+Launcher::Result::
+Result(Handle handle, ext::optional<int64_t> const &processIdentifier, ext::optional<int> const &exitCode, std::string const &output, ext::optional<uint64_t> const &peakMemory) :
+    _handle           (handle),
+    _processIdentifier(processIdentifier),
+    _exitCode         (exitCode),
+    _output           (output),
+    _peakMemory       (peakMemory)
+{
+}
+
 Launcher::
-Launcher()
+Launcher() :
+    _nextHandle  (0),
+    _cancellation(nullptr)
 {
 }
 
@@ -21,6 +33,43 @@ Launcher::
 {
 }
 
+ext::optional<Launcher::Handle> Launcher::
+start(libutil::Filesystem *filesystem, Context const *context)
+{
+    ext::optional<int> exitCode = launch(filesystem, context);
+    if (!exitCode) {
+        return ext::nullopt;
+    }
+
+    Handle handle = nextHandle();
+    _results.push_back(Result(handle, ext::nullopt, exitCode, std::string(), ext::nullopt));
+    return handle;
+}
+
+ext::optional<Launcher::Result> Launcher::
+wait()
+{
+    if (_results.empty()) {
+        return ext::nullopt;
+    }
+
+    Result result = _results.front();
+    _results.pop_front();
+    return result;
+}
+
+ext::optional<uint64_t> Launcher::
+memory(Handle handle) const
+{
+    return ext::nullopt;
+}
+
+Launcher::Handle Launcher::
+nextHandle()
+{
+    return _nextHandle++;
+}
+
 #include <process/DefaultLauncher.h>
 
 using process::DefaultLauncher;
@@ -0,0 +1,101 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <process/DefaultLauncher.h>
+#include <process/MemoryContext.h>
+#include <libutil/DefaultFilesystem.h>
+
+#include <chrono>
+
+#include <unistd.h>
+
+using process::DefaultLauncher;
+using process::MemoryContext;
+using libutil::DefaultFilesystem;
+
+static MemoryContext
+ShellContext(std::string const &script)
+{
+    return MemoryContext(
+        "/bin/sh",
+        "/",
+        { "-c", script },
+        { },
+        ::getuid(),
+        ::getgid(),
+        "user",
+        "group");
+}
+
+TEST(DefaultLauncher, Output)
+{
+    DefaultFilesystem filesystem;
+    DefaultLauncher launcher;
+
+    MemoryContext success = ShellContext("echo out; echo err >&2");
+    MemoryContext failure = ShellContext("exit 3");
+    ASSERT_TRUE(launcher.start(&filesystem, &success));
+    ASSERT_TRUE(launcher.start(&filesystem, &failure));
+
+    size_t results = 0;
+    while (ext::optional<DefaultLauncher::Result> result = launcher.wait()) {
+        ASSERT_TRUE(result->exitCode());
+        if (*result->exitCode() == 0) {
+            EXPECT_EQ("out\nerr\n", result->output());
+        } else {
+            EXPECT_EQ(3, *result->exitCode());
+            EXPECT_EQ("", result->output());
+        }
+        results++;
+    }
+
+    EXPECT_EQ(2, results);
+}
+
+TEST(DefaultLauncher, BackgroundHoldsOutput)
+{
+    DefaultFilesystem filesystem;
+    DefaultLauncher launcher;
+
+    /* The background process keeps the output open after the shell exits. */
+    MemoryContext context = ShellContext("echo started; sleep 10 & exit 0");
+    ASSERT_TRUE(launcher.start(&filesystem, &context));
+
+    auto start = std::chrono::steady_clock::now();
+    ext::optional<DefaultLauncher::Result> result = launcher.wait();
+    auto duration = std::chrono::steady_clock::now() - start;
+
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result->exitCode());
+    EXPECT_EQ(0, *result->exitCode());
+    EXPECT_EQ("started\n", result->output());
+    EXPECT_LT(duration, std::chrono::seconds(5));
+
+    EXPECT_FALSE(launcher.wait());
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+TEST(DefaultLauncher, Memory)
+{
+    DefaultFilesystem filesystem;
+    DefaultLauncher launcher;
+
+    MemoryContext context = ShellContext("sleep 1");
+    ext::optional<DefaultLauncher::Handle> handle = launcher.start(&filesystem, &context);
+    ASSERT_TRUE(handle);
+
+    ext::optional<uint64_t> memory = launcher.memory(*handle);
+    ASSERT_TRUE(memory);
+    EXPECT_GT(*memory, 0);
+
+    ASSERT_TRUE(launcher.wait());
+    EXPECT_FALSE(launcher.memory(*handle));
+}
+#endif
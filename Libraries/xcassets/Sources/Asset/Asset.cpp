@@ -38,6 +38,10 @@
 #include <plist/Integer.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+
+#include <algorithm>
+#include <functional>
 
 using xcassets::Asset::Asset;
 using xcassets::FullyQualifiedName;
@@ -295,29 +299,41 @@ LoadContents(Filesystem const *filesystem, std::string const &path, std::unique_
 static bool
 LoadChildren(Filesystem const *filesystem, std::string const &path, FullyQualifiedName const &name, bool providesNamespace, std::vector<std::unique_ptr<Asset>> *children)
 {
-    bool error = false;
-
+    std::vector<std::string> fileNames;
     filesystem->enumerateDirectory(path, [&](std::string const &fileName) -> void {
-        std::string child = path + "/" + fileName;
+        fileNames.push_back(fileName);
+    });
 
-        if (filesystem->isDirectory(child)) {
-            std::vector<std::string> groups = name.groups();
-            if (providesNamespace) {
-                // TODO: Should fully qualified names include extensions?
-                groups.push_back(name.name());
-            }
+    std::vector<std::string> groups = name.groups();
+    if (providesNamespace) {
+        // TODO: Should fully qualified names include extensions?
+        groups.push_back(name.name());
+    }
 
-            std::unique_ptr<Asset> asset = Asset::Load(filesystem, child, groups);
-            if (asset == nullptr) {
-                fprintf(stderr, "error: failed to load asset: %s\n", child.c_str());
-                error = true;
-                return;
-            }
+    /*
+     * Load each child's subtree in parallel, but keep them in directory order.
+     */
+    std::vector<std::unique_ptr<Asset>> assets = std::vector<std::unique_ptr<Asset>>(fileNames.size());
+    std::vector<char> failed = std::vector<char>(fileNames.size(), false);
+    libutil::Parallel::For(fileNames.size(), [&](size_t index) {
+        std::string child = path + "/" + fileNames[index];
 
-            children->push_back(std::move(asset));
+        if (filesystem->isDirectory(child)) {
+            assets[index] = Asset::Load(filesystem, child, groups);
+            failed[index] = (assets[index] == nullptr);
         }
     });
 
+    bool error = false;
+    for (size_t i = 0; i < fileNames.size(); ++i) {
+        if (failed[i]) {
+            fprintf(stderr, "error: failed to load asset: %s\n", (path + "/" + fileNames[i]).c_str());
+            error = true;
+        } else if (assets[i] != nullptr) {
+            children->push_back(std::move(assets[i]));
+        }
+    }
+
     return error;
 }
 
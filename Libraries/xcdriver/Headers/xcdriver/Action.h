@@ -38,6 +38,7 @@ public:
         Build,
         ShowBuildSettings,
         List,
+        ProjectIndex,
         Version,
         Usage,
         Help,
@@ -47,6 +48,7 @@ public:
         Find,
         ExportArchive,
         Localizations,
+        Daemon,
     };
 
 public:
@@ -69,8 +71,12 @@ public:
     CreateOverrideLevels(process::Context const *processContext, libutil::Filesystem const *filesystem, pbxsetting::Environment const &environment, Options const &options, std::string const &workingDirectory);
 
 public:
+    /*
+     * Parameters for the build the options describe. Changed paths must
+     * already be read and resolved, since that can fail.
+     */
     static xcexecution::Parameters
-    CreateParameters(Options const &options, std::vector<pbxsetting::Level> const &overrideLevels);
+    CreateParameters(Options const &options, std::vector<pbxsetting::Level> const &overrideLevels, ext::optional<std::vector<std::string>> const &changedPaths = ext::nullopt);
 };
 
 }
@@ -0,0 +1,62 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcdriver_DaemonAction_h
+#define __xcdriver_DaemonAction_h
+
+#include <string>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+namespace process { class Context; }
+namespace process { class Launcher; }
+
+namespace xcdriver {
+
+class Options;
+
+/*
+ * Serves invocations of xcbuild on a socket, keeping the build environment
+ * and workspaces loaded between them. Each invocation runs in a process
+ * forked from the daemon once what it needs is loaded, with the client's
+ * arguments, environment, working directory and standard streams.
+ *
+ * Invocations run as the daemon's user, so only that user can connect.
+ */
+class DaemonAction {
+private:
+    DaemonAction();
+    ~DaemonAction();
+
+public:
+    /*
+     * The environment variable naming the socket of a daemon to use.
+     */
+    static char const *const SocketVariable;
+
+public:
+    /*
+     * Serve invocations until killed.
+     */
+    static int
+    Run(process::Context const *processContext, process::Launcher *processLauncher, libutil::Filesystem *filesystem, Options const &options);
+
+    /*
+     * Run this invocation in the daemon listening on a socket. Returns the
+     * exit code, or nothing if no daemon of this user is listening so the
+     * invocation should run here instead. Interrupts and terminations received while
+     * waiting are passed on to the invocation.
+     */
+    static ext::optional<int>
+    Forward(process::Context const *processContext, std::string const &socketPath);
+};
+
+}
+
+#endif // !__xcdriver_DaemonAction_h
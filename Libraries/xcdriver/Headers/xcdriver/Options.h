@@ -49,17 +49,34 @@ private:
     ext::optional<std::string> _formatter;
     ext::optional<std::string> _executor;
     ext::optional<bool>        _generate;
+    ext::optional<bool>        _batchDependencyInfo;
+    ext::optional<bool>        _incremental;
+    ext::optional<std::string> _actionCache;
+    ext::optional<std::string> _toolLauncher;
+    std::vector<std::string>   _ninjaPools;
+    ext::optional<std::string> _shard;
+    ext::optional<std::string> _trace;
+    ext::optional<bool>        _showBuildTimings;
+    ext::optional<int>         _targetEnvironmentCacheSize;
+    ext::optional<std::string> _daemon;
+    ext::optional<bool>        _prebuiltDependencies;
+    ext::optional<bool>        _changedPaths;
+    std::vector<std::string>   _changedPath;
+    ext::optional<std::string> _changedPathsFile;
 
 private:
     ext::optional<bool>        _parallelizeTargets;
     ext::optional<int>         _jobs;
+    ext::optional<std::string> _loadAverage;
     ext::optional<bool>        _dryRun;
     ext::optional<bool>        _hideShellScriptEnvironment;
 
 private:
     ext::optional<bool>        _list;
+    ext::optional<bool>        _projectIndex;
     ext::optional<bool>        _showSDKs;
     ext::optional<bool>        _showBuildSettings;
+    std::vector<std::string>   _showBuildSettingsNames;
 
 private:
     ext::optional<std::string> _xcconfig;
@@ -82,6 +99,8 @@ private:
     ext::optional<std::string> _xctestrun;
     std::vector<std::string>   _onlyTesting;
     std::vector<std::string>   _skipTesting;
+    ext::optional<int>         _parallelTestingWorkerCount;
+    ext::optional<std::string> _testHistory;
 
 private:
     ext::optional<bool>        _exportArchive;
@@ -158,12 +177,56 @@ public:
     /* Extension. */
     bool generate() const
     { return _generate.value_or(false); }
+    /* Extension. */
+    bool batchDependencyInfo() const
+    { return _batchDependencyInfo.value_or(false); }
+    /* Extension. */
+    bool incremental() const
+    { return _incremental.value_or(true); }
+    /* Extension. */
+    ext::optional<std::string> const &actionCache() const
+    { return _actionCache; }
+    /* Extension. */
+    ext::optional<std::string> const &toolLauncher() const
+    { return _toolLauncher; }
+    /* Extension. */
+    std::vector<std::string> const &ninjaPools() const
+    { return _ninjaPools; }
+    /* Extension. */
+    ext::optional<std::string> const &shard() const
+    { return _shard; }
+    /* Extension. */
+    ext::optional<std::string> const &trace() const
+    { return _trace; }
+    /* Extension. */
+    bool showBuildTimings() const
+    { return _showBuildTimings.value_or(false); }
+    /* Extension. */
+    ext::optional<int> targetEnvironmentCacheSize() const
+    { return _targetEnvironmentCacheSize; }
+    /* Extension. */
+    ext::optional<std::string> const &daemon() const
+    { return _daemon; }
+    /* Extension. */
+    bool prebuiltDependencies() const
+    { return _prebuiltDependencies.value_or(false); }
+    /* Extension. */
+    bool changedPaths() const
+    { return _changedPaths.value_or(false); }
+    /* Extension. */
+    std::vector<std::string> const &changedPath() const
+    { return _changedPath; }
+    /* Extension. */
+    ext::optional<std::string> const &changedPathsFile() const
+    { return _changedPathsFile; }
 
 public:
     bool parallelizeTargets() const
     { return _parallelizeTargets.value_or(false); }
     ext::optional<int> jobs() const
     { return _jobs; }
+    ext::optional<std::string> const &loadAverage() const
+    { return _loadAverage; }
     bool dryRun() const
     { return _dryRun.value_or(false); }
     bool hideShellScriptEnvironment() const
@@ -172,10 +235,14 @@ public:
 public:
     bool list() const
     { return _list.value_or(false); }
+    bool projectIndex() const
+    { return _projectIndex.value_or(false); }
     bool showSDKs() const
     { return _showSDKs.value_or(false); }
     bool showBuildSettings() const
     { return _showBuildSettings.value_or(false); }
+    std::vector<std::string> const &showBuildSettingsNames() const
+    { return _showBuildSettingsNames; }
 
 public:
     ext::optional<std::string> const &xcconfig() const
@@ -210,6 +277,11 @@ public:
     { return _onlyTesting; }
     std::vector<std::string> const &skipTesting() const
     { return _skipTesting; }
+    ext::optional<int> parallelTestingWorkerCount() const
+    { return _parallelTestingWorkerCount; }
+    /* Extension. */
+    ext::optional<std::string> const &testHistory() const
+    { return _testHistory; }
 
 public:
     bool exportArchive() const
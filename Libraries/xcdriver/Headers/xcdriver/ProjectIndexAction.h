@@ -0,0 +1,36 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcdriver_ProjectIndexAction_h
+#define __xcdriver_ProjectIndexAction_h
+
+namespace libutil { class Filesystem; }
+namespace process { class Context; }
+
+namespace xcdriver {
+
+class Options;
+
+/*
+ * Brings the project index up to date for a project or workspace, and
+ * prints where it is. Only projects changed since the last run are loaded.
+ */
+class ProjectIndexAction {
+private:
+    ProjectIndexAction();
+    ~ProjectIndexAction();
+
+public:
+    static int
+    Run(process::Context const *processContext, libutil::Filesystem *filesystem, Options const &options);
+};
+
+}
+
+#endif // !__xcdriver_ProjectIndexAction_h
@@ -24,7 +24,7 @@ private:
 
 public:
     static int
-    Run(process::Context const *processContext, libutil::Filesystem const *filesystem, Options const &options);
+    Run(process::Context const *processContext, libutil::Filesystem *filesystem, Options const &options);
 };
 
 }
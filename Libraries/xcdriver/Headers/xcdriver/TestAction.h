@@ -0,0 +1,44 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcdriver_TestAction_h
+#define __xcdriver_TestAction_h
+
+namespace libutil { class Filesystem; }
+namespace process { class Context; }
+namespace process { class Launcher; }
+namespace pbxbuild { namespace Build { class Environment; } }
+namespace xcexecution { class Parameters; }
+
+namespace xcdriver {
+
+class Options;
+
+/*
+ * Runs the tests in a scheme's test action, after they have been built.
+ */
+class TestAction {
+private:
+    TestAction();
+    ~TestAction();
+
+public:
+    static int
+    Run(
+        process::Context const *processContext,
+        process::Launcher *processLauncher,
+        libutil::Filesystem *filesystem,
+        Options const &options,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        xcexecution::Parameters const &parameters);
+};
+
+}
+
+#endif // !__xcdriver_TestAction_h
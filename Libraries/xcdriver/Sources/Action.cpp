@@ -40,6 +40,12 @@ CreateOverrideLevels(process::Context const *processContext, Filesystem const *f
     if (options.arch()) {
         settings.push_back(pbxsetting::Setting::Create("ARCHS", *options.arch()));
     }
+    if (options.derivedDataPath()) {
+        /* Settings passed in below can still move intermediates elsewhere. */
+        std::string path = FSUtil::ResolveRelativePath(*options.derivedDataPath(), workingDirectory);
+        settings.push_back(pbxsetting::Setting::Create("SYMROOT", path + "/Build/Products"));
+        settings.push_back(pbxsetting::Setting::Create("OBJROOT", path + "/Build/Intermediates"));
+    }
     levels.push_back(pbxsetting::Level(settings));
 
     levels.push_back(options.settings());
@@ -68,7 +74,7 @@ CreateOverrideLevels(process::Context const *processContext, Filesystem const *f
 }
 
 xcexecution::Parameters Action::
-CreateParameters(Options const &options, std::vector<pbxsetting::Level> const &overrideLevels)
+CreateParameters(Options const &options, std::vector<pbxsetting::Level> const &overrideLevels, ext::optional<std::vector<std::string>> const &changedPaths)
 {
     return xcexecution::Parameters(
         options.workspace(),
@@ -76,6 +82,8 @@ CreateParameters(Options const &options, std::vector<pbxsetting::Level> const &o
         options.scheme(),
         (!options.target().empty() ? ext::make_optional(options.target()) : ext::nullopt),
         options.allTargets(),
+        options.prebuiltDependencies(),
+        changedPaths,
         options.actions(),
         options.configuration(),
         overrideLevels);
@@ -113,6 +121,8 @@ Determine(Options const &options)
         return Help;
     } else if (options.license()) {
         return License;
+    } else if (options.daemon()) {
+        return Daemon;
     } else if (options.checkFirstLaunchStatus()) {
         return CheckFirstLaunch;
     } else if (options.showSDKs()) {
@@ -125,6 +135,8 @@ Determine(Options const &options)
         return Localizations;
     } else if (options.list()) {
         return List;
+    } else if (options.projectIndex()) {
+        return ProjectIndex;
     } else if (options.showBuildSettings()) {
         return ShowBuildSettings;
     } else {
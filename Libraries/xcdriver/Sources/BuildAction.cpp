@@ -10,20 +10,36 @@
 #include <xcdriver/BuildAction.h>
 #include <xcdriver/Action.h>
 #include <xcdriver/Options.h>
+#include <xcdriver/TestAction.h>
 #include <xcexecution/NinjaExecutor.h>
+#include <xcexecution/Resident.h>
 #include <xcexecution/SimpleExecutor.h>
+#include <xcexecution/Trace.h>
 #include <xcformatter/DefaultFormatter.h>
+#include <xcformatter/JSONFormatter.h>
 #include <xcformatter/NullFormatter.h>
 #include <builtin/Registry.h>
+#include <pbxbuild/Build/Context.h>
 #include <libutil/Base.h>
 #include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
+#include <process/Cancellation.h>
 #include <process/Context.h>
 
+#include <algorithm>
+#include <thread>
+
+#include <cstdlib>
+#include <csignal>
+#include <cstring>
+
 #include <unistd.h>
 
 using xcdriver::BuildAction;
 using xcdriver::Options;
 using libutil::Filesystem;
+using libutil::FSUtil;
 
 BuildAction::
 BuildAction()
@@ -36,9 +52,12 @@ BuildAction::
 }
 
 static std::shared_ptr<xcformatter::Formatter>
-CreateFormatter(ext::optional<std::string> const &formatter)
+CreateFormatter(ext::optional<std::string> const &formatter, bool json)
 {
-    if (!formatter || *formatter == "default") {
+    if (!formatter && json) {
+        auto formatter = xcformatter::JSONFormatter::Create();
+        return std::static_pointer_cast<xcformatter::Formatter>(formatter);
+    } else if (!formatter || *formatter == "default") {
         /* Only use color if attached to a terminal. */
         bool color = isatty(fileno(stdout));
 
@@ -47,24 +66,117 @@ CreateFormatter(ext::optional<std::string> const &formatter)
     } else if (*formatter == "null") {
         auto formatter = xcformatter::NullFormatter::Create();
         return std::static_pointer_cast<xcformatter::Formatter>(formatter);
+    } else if (*formatter == "json") {
+        auto formatter = xcformatter::JSONFormatter::Create();
+        return std::static_pointer_cast<xcformatter::Formatter>(formatter);
     }
 
     return nullptr;
 }
 
+/*
+ * Read changed paths from a file, one per line. Relative paths are
+ * resolved against the working directory.
+ */
+static bool
+ReadChangedPaths(Filesystem const *filesystem, std::string const &path, std::string const &workingDirectory, std::vector<std::string> *changedPaths)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return false;
+    }
+
+    std::string text = std::string(contents.begin(), contents.end());
+    for (std::string::size_type start = 0; start < text.size(); ) {
+        std::string::size_type end = text.find('\n', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+
+        std::string line = text.substr(start, end - start);
+        start = end + 1;
+
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            changedPaths->push_back(FSUtil::NormalizePath(FSUtil::ResolveRelativePath(line, workingDirectory)));
+        }
+    }
+
+    return true;
+}
+
+/*
+ * The build to cancel on an interrupt, if one is running.
+ */
+static process::Cancellation *InterruptCancellation = nullptr;
+
+static void
+InterruptHandler(int signal)
+{
+    if (InterruptCancellation != nullptr) {
+        InterruptCancellation->cancel();
+    }
+}
+
+/*
+ * Cancels a build on the first interrupt or termination, so the tools it's
+ * running are stopped and what finished is saved. The handler is reset once
+ * it runs, so a second interrupt exits right away.
+ */
+class InterruptScope {
+private:
+    struct sigaction _interrupt;
+    struct sigaction _terminate;
+
+public:
+    explicit InterruptScope(process::Cancellation *cancellation)
+    {
+        InterruptCancellation = cancellation;
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = &InterruptHandler;
+        action.sa_flags = SA_RESETHAND;
+        sigemptyset(&action.sa_mask);
+
+        ::sigaction(SIGINT, &action, &_interrupt);
+        ::sigaction(SIGTERM, &action, &_terminate);
+    }
+
+    ~InterruptScope()
+    {
+        ::sigaction(SIGINT, &_interrupt, nullptr);
+        ::sigaction(SIGTERM, &_terminate, nullptr);
+
+        InterruptCancellation = nullptr;
+    }
+};
+
 static std::unique_ptr<xcexecution::Executor>
 CreateExecutor(
     ext::optional<std::string> const &executor,
     std::shared_ptr<xcformatter::Formatter> const &formatter,
     bool dryRun,
-    bool generate)
+    bool generate,
+    bool batchDependencyInfo,
+    bool incremental,
+    ext::optional<std::string> const &actionCache,
+    ext::optional<std::string> const &toolLauncher,
+    std::vector<xcexecution::NinjaExecutor::Pool> const &ninjaPools,
+    ext::optional<xcexecution::SimpleExecutor::Shard> const &shard,
+    size_t jobs,
+    ext::optional<double> const &loadAverage,
+    bool parallelizeTargets,
+    std::shared_ptr<xcexecution::Trace> const &trace)
 {
     if (!executor || *executor == "simple") {
         auto registry = builtin::Registry::Default();
-        auto executor = xcexecution::SimpleExecutor::Create(formatter, dryRun, registry);
+        auto executor = xcexecution::SimpleExecutor::Create(formatter, dryRun, registry, jobs, parallelizeTargets, incremental, actionCache, toolLauncher, shard, trace, loadAverage);
         return libutil::static_unique_pointer_cast<xcexecution::Executor>(std::move(executor));
     } else if (*executor == "ninja") {
-        auto executor = xcexecution::NinjaExecutor::Create(formatter, dryRun, generate);
+        auto executor = xcexecution::NinjaExecutor::Create(formatter, dryRun, generate, batchDependencyInfo, actionCache, toolLauncher, ninjaPools, trace);
         return libutil::static_unique_pointer_cast<xcexecution::Executor>(std::move(executor));
     }
 
@@ -78,7 +190,7 @@ VerifySupportedOptions(Options const &options)
         fprintf(stderr, "warning: toolchain option not implemented\n");
     }
 
-    if (options.quiet() || options.verbose() || options.json() || options.hideShellScriptEnvironment()) {
+    if (options.quiet() || options.verbose() || options.hideShellScriptEnvironment()) {
         fprintf(stderr, "warning: output options not implemented\n");
     }
 
@@ -86,28 +198,20 @@ VerifySupportedOptions(Options const &options)
         fprintf(stderr, "warning: destination option not implemented\n");
     }
 
-    if (options.parallelizeTargets() || options.jobs()) {
-        fprintf(stderr, "warning: job control option not implemented\n");
-    }
-
     if (options.enableAddressSanitizer() || options.enableThreadSanitizer() || options.enableCodeCoverage()) {
         fprintf(stderr, "warning: build mode option not implemented\n");
     }
 
-    if (options.derivedDataPath()) {
-        fprintf(stderr, "warning: custom derived data path not implemented\n");
-    }
-
     if (options.resultBundlePath()) {
         fprintf(stderr, "warning: result bundle path not implemented\n");
     }
 
-    if (options.xctestrun() || !options.onlyTesting().empty() || !options.skipTesting().empty()) {
-        fprintf(stderr, "warning: testing options not implemented\n");
+    if (options.xctestrun()) {
+        fprintf(stderr, "warning: xctestrun option not implemented\n");
     }
 
     for (std::string const &action : options.actions()) {
-        if (action != "build") {
+        if (action != "build" && action != "build-for-testing" && action != "test" && action != "test-without-building") {
             fprintf(stderr, "warning: non-build action %s not implemented\n", action.c_str());
         }
     }
@@ -128,19 +232,168 @@ Run(process::Context const *processContext, process::Launcher *processLauncher,
         return -1;
     }
 
+    /*
+     * Testing runs the tests after the build; without building, it only
+     * runs the tests left from a previous build.
+     */
+    std::vector<std::string> const &actions = options.actions();
+    bool testing = std::any_of(actions.begin(), actions.end(), [](std::string const &action) {
+        return action == "test" || action == "test-without-building";
+    });
+    bool building = !(actions.size() == 1 && actions.front() == "test-without-building");
+
     /*
      * Create the formatter to format the build log.
      */
-    std::shared_ptr<xcformatter::Formatter> formatter = CreateFormatter(options.formatter());
+    std::shared_ptr<xcformatter::Formatter> formatter = CreateFormatter(options.formatter(), options.json());
     if (formatter == nullptr) {
         fprintf(stderr, "error: unknown formatter '%s'\n", options.formatter()->c_str());
         return -1;
     }
 
+    /*
+     * Run as many jobs in parallel as requested, or one per core by default.
+     */
+    size_t jobs = std::thread::hardware_concurrency();
+    if (options.jobs()) {
+        if (*options.jobs() <= 0) {
+            fprintf(stderr, "error: jobs must be a positive number\n");
+            return -1;
+        }
+
+        jobs = static_cast<size_t>(*options.jobs());
+    }
+
+    /*
+     * Like `make -l`, only limit tools by the load average when asked to:
+     * it lags behind, and counts the build's own tools.
+     */
+    ext::optional<double> loadAverage;
+    if (options.loadAverage()) {
+        char *end = nullptr;
+        loadAverage = std::strtod(options.loadAverage()->c_str(), &end);
+        if (options.loadAverage()->empty() || *end != '\0' || !(*loadAverage > 0)) {
+            fprintf(stderr, "error: load average must be a positive number\n");
+            return -1;
+        }
+    }
+
+    /* Work done in the driver itself is spread across as many threads. */
+    libutil::Parallel::SetConcurrency(jobs);
+
+    if (options.targetEnvironmentCacheSize()) {
+        if (*options.targetEnvironmentCacheSize() <= 0) {
+            fprintf(stderr, "error: target environment cache size must be a positive number\n");
+            return -1;
+        }
+
+        pbxbuild::Build::Context::TargetEnvironmentCache::SetDefaultCapacity(static_cast<size_t>(*options.targetEnvironmentCacheSize()));
+    }
+
+    /*
+     * Commands using the action cache run in other directories.
+     */
+    ext::optional<std::string> actionCache;
+    if (options.actionCache()) {
+        actionCache = FSUtil::ResolveRelativePath(*options.actionCache(), processContext->currentDirectory());
+    }
+
+    /*
+     * Find the tool launcher, if any, the same way a shell would.
+     */
+    ext::optional<std::string> toolLauncher;
+    if (options.toolLauncher()) {
+        if (options.toolLauncher()->find('/') != std::string::npos) {
+            toolLauncher = FSUtil::ResolveRelativePath(*options.toolLauncher(), processContext->currentDirectory());
+        } else {
+            toolLauncher = filesystem->findExecutable(*options.toolLauncher(), processContext->executableSearchPaths());
+        }
+
+        if (!toolLauncher || !filesystem->isExecutable(*toolLauncher)) {
+            fprintf(stderr, "error: unable to find tool launcher '%s'\n", options.toolLauncher()->c_str());
+            return -1;
+        }
+    }
+
+    /*
+     * Pools limiting concurrency of some tools in the Ninja executor.
+     */
+    std::vector<xcexecution::NinjaExecutor::Pool> ninjaPools;
+    for (std::string const &argument : options.ninjaPools()) {
+        ext::optional<xcexecution::NinjaExecutor::Pool> pool = xcexecution::NinjaExecutor::Pool::Parse(argument);
+        if (!pool) {
+            fprintf(stderr, "error: invalid ninja pool '%s', expected NAME=DEPTH:TOOL[,TOOL...]\n", argument.c_str());
+            return -1;
+        }
+
+        ninjaPools.push_back(*pool);
+    }
+
+    /*
+     * The part of the build to do on this machine, if split between several.
+     * Shards hand off outputs through the action cache.
+     *
+     * Building and testing are split differently, so a shard could be given
+     * tests from bundles another shard built. Sharded tests must run after
+     * a complete build-for-testing instead.
+     */
+    if (options.shard() && building && testing) {
+        fprintf(stderr, "error: shards can't build and test at once; use build-for-testing, then test-without-building with -shard\n");
+        return -1;
+    }
+
+    ext::optional<xcexecution::SimpleExecutor::Shard> shard;
+    if (options.shard() && building) {
+        shard = xcexecution::SimpleExecutor::Shard::Parse(*options.shard());
+        if (!shard) {
+            fprintf(stderr, "error: invalid shard '%s', expected INDEX/COUNT\n", options.shard()->c_str());
+            return -1;
+        }
+
+        if (options.executor() && *options.executor() != "simple") {
+            fprintf(stderr, "error: shards are only supported by the simple executor\n");
+            return -1;
+        }
+
+        if (!actionCache) {
+            fprintf(stderr, "error: shards need an action cache to share outputs\n");
+            return -1;
+        }
+    }
+
+    /*
+     * Record how long the build takes, if requested.
+     */
+    std::shared_ptr<xcexecution::Trace> trace;
+    ext::optional<std::string> tracePath;
+    if (options.trace()) {
+        trace = std::make_shared<xcexecution::Trace>();
+        tracePath = FSUtil::ResolveRelativePath(*options.trace(), processContext->currentDirectory());
+    }
+
+    /*
+     * Only build the targets affected by changed paths, if any are given.
+     */
+    ext::optional<std::vector<std::string>> changedPaths;
+    if (options.changedPaths() || !options.changedPath().empty() || options.changedPathsFile()) {
+        changedPaths = std::vector<std::string>();
+        for (std::string const &path : options.changedPath()) {
+            changedPaths->push_back(FSUtil::NormalizePath(FSUtil::ResolveRelativePath(path, processContext->currentDirectory())));
+        }
+
+        if (options.changedPathsFile()) {
+            std::string path = FSUtil::ResolveRelativePath(*options.changedPathsFile(), processContext->currentDirectory());
+            if (!ReadChangedPaths(filesystem, path, processContext->currentDirectory(), &*changedPaths)) {
+                fprintf(stderr, "error: unable to read changed paths from %s\n", path.c_str());
+                return -1;
+            }
+        }
+    }
+
     /*
      * Create the executor used to perform the build.
      */
-    std::unique_ptr<xcexecution::Executor> executor = CreateExecutor(options.executor(), formatter, options.dryRun(), options.generate());
+    std::unique_ptr<xcexecution::Executor> executor = CreateExecutor(options.executor(), formatter, options.dryRun(), options.generate(), options.batchDependencyInfo(), options.incremental(), actionCache, toolLauncher, ninjaPools, shard, jobs, loadAverage, options.parallelizeTargets(), trace);
     if (executor == nullptr) {
         fprintf(stderr, "error: unknown executor '%s'\n", options.executor()->c_str());
         return -1;
@@ -149,7 +402,11 @@ Run(process::Context const *processContext, process::Launcher *processLauncher,
     /*
      * Use the default build environment. We don't need anything custom here.
      */
-    ext::optional<pbxbuild::Build::Environment> buildEnvironment = pbxbuild::Build::Environment::Default(processContext, filesystem);
+    ext::optional<pbxbuild::Build::Environment> buildEnvironment;
+    {
+        xcexecution::Trace::Span span(trace.get(), "Load specifications", "environment");
+        buildEnvironment = xcexecution::Resident::BuildEnvironment(processContext, filesystem);
+    }
     if (!buildEnvironment) {
         fprintf(stderr, "error: couldn't create build environment\n");
         return -1;
@@ -167,15 +424,39 @@ Run(process::Context const *processContext, process::Launcher *processLauncher,
      * Create the build parameters. The executor uses this to load a workspace and create a
      * build context, but is not required to when the parameters haven't changed from a cache.
      */
-    xcexecution::Parameters parameters = Action::CreateParameters(options, overrideLevels);
+    xcexecution::Parameters parameters = Action::CreateParameters(options, overrideLevels, changedPaths);
 
     /*
      * Perform the build!
      */
-    bool success = executor->build(processContext, processLauncher, filesystem, *buildEnvironment, parameters);
+    bool success = true;
+    bool cancelled = false;
+    if (building) {
+        process::Cancellation cancellation;
+        InterruptScope interruptScope(&cancellation);
+        success = executor->build(processContext, processLauncher, filesystem, *buildEnvironment, parameters, &cancellation);
+        cancelled = cancellation.cancelled();
+    }
+
+    /* Write the trace even after a failure, to see what it spent time on. */
+    if (trace != nullptr && !trace->write(filesystem, *tracePath)) {
+        fprintf(stderr, "warning: failed to write trace to %s\n", tracePath->c_str());
+    }
+
+    if (cancelled) {
+        return 128 + SIGINT;
+    }
+
     if (!success) {
         return 1;
     }
 
+    /*
+     * Run the tests that were just built.
+     */
+    if (testing) {
+        return TestAction::Run(processContext, processLauncher, filesystem, options, *buildEnvironment, parameters);
+    }
+
     return 0;
 }
@@ -0,0 +1,604 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcdriver/DaemonAction.h>
+#include <xcdriver/Action.h>
+#include <xcdriver/Driver.h>
+#include <xcdriver/Options.h>
+#include <xcexecution/Parameters.h>
+#include <xcexecution/Resident.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/String.h>
+#include <plist/Format/Binary.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <process/Context.h>
+#include <process/MemoryContext.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iterator>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+extern char **environ;
+
+using xcdriver::DaemonAction;
+using xcdriver::Action;
+using xcdriver::Driver;
+using xcdriver::Options;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+char const *const DaemonAction::SocketVariable = "XCBUILD_DAEMON";
+
+DaemonAction::
+DaemonAction()
+{
+}
+
+DaemonAction::
+~DaemonAction()
+{
+}
+
+/*
+ * The client's standard input, output and error are passed to the daemon,
+ * so the invocation reads and writes them directly.
+ */
+static int const StreamCount = 3;
+
+/*
+ * Invocations are sent as a binary property list, which is far smaller
+ * than this. Anything larger is not from a client.
+ */
+static uint32_t const MaximumRequestSize = 64 * 1024 * 1024;
+
+static bool
+SocketAddress(std::string const &socketPath, struct sockaddr_un *address)
+{
+    ::memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+
+    if (socketPath.size() >= sizeof(address->sun_path)) {
+        return false;
+    }
+
+    ::memcpy(address->sun_path, socketPath.c_str(), socketPath.size() + 1);
+    return true;
+}
+
+static int
+CreateSocket()
+{
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+    /* Tools the invocations launch shouldn't hold on to connections. */
+    if (fd >= 0) {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+#if defined(SO_NOSIGPIPE)
+    /* Report a closed connection as an error rather than a signal. */
+    if (fd >= 0) {
+        int value = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &value, sizeof(value));
+    }
+#endif
+
+    return fd;
+}
+
+/*
+ * If the other end of a connection is a process of this user.
+ */
+static bool
+PeerIsUser(int fd)
+{
+#if defined(SO_PEERCRED)
+    struct ucred credentials;
+    socklen_t size = sizeof(credentials);
+    if (::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &size) != 0) {
+        return false;
+    }
+    return credentials.uid == ::geteuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    if (::getpeereid(fd, &uid, &gid) != 0) {
+        return false;
+    }
+    return uid == ::geteuid();
+#endif
+}
+
+static bool
+SendAll(int fd, void const *data, size_t size)
+{
+    int flags = 0;
+#if defined(MSG_NOSIGNAL)
+    flags |= MSG_NOSIGNAL;
+#endif
+
+    uint8_t const *bytes = static_cast<uint8_t const *>(data);
+    while (size > 0) {
+        ssize_t sent = ::send(fd, bytes, size, flags);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        bytes += sent;
+        size -= sent;
+    }
+
+    return true;
+}
+
+static bool
+ReceiveAll(int fd, void *data, size_t size)
+{
+    uint8_t *bytes = static_cast<uint8_t *>(data);
+    while (size > 0) {
+        ssize_t received = ::recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        } else if (received <= 0) {
+            return false;
+        }
+
+        bytes += received;
+        size -= received;
+    }
+
+    return true;
+}
+
+static bool
+SendStreams(int fd, int const (&streams)[StreamCount])
+{
+    char byte = 0;
+    struct iovec vector;
+    vector.iov_base = &byte;
+    vector.iov_len = sizeof(byte);
+
+    char control[CMSG_SPACE(sizeof(streams))];
+    ::memset(control, 0, sizeof(control));
+
+    struct msghdr message;
+    ::memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(streams));
+    ::memcpy(CMSG_DATA(header), streams, sizeof(streams));
+
+    while (true) {
+        ssize_t sent = ::sendmsg(fd, &message, 0);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        return (sent == sizeof(byte));
+    }
+}
+
+static bool
+ReceiveStreams(int fd, int (&streams)[StreamCount])
+{
+    char byte;
+    struct iovec vector;
+    vector.iov_base = &byte;
+    vector.iov_len = sizeof(byte);
+
+    char control[CMSG_SPACE(sizeof(streams))];
+    ::memset(control, 0, sizeof(control));
+
+    struct msghdr message;
+    ::memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = ::recvmsg(fd, &message, 0);
+    } while (received < 0 && errno == EINTR);
+
+    struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+    if (received != sizeof(byte) || header == nullptr || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS || header->cmsg_len != CMSG_LEN(sizeof(streams))) {
+        return false;
+    }
+
+    ::memcpy(streams, CMSG_DATA(header), sizeof(streams));
+    return true;
+}
+
+/*
+ * Signals sent to a client while it waits for its invocation, which are
+ * passed on to the invocation.
+ */
+static int const ForwardedSignals[] = { SIGINT, SIGTERM };
+
+static bool
+IsForwardedSignal(int32_t signal)
+{
+    return std::find(std::begin(ForwardedSignals), std::end(ForwardedSignals), signal) != std::end(ForwardedSignals);
+}
+
+/*
+ * The connection to pass signals on to, while waiting for an invocation.
+ */
+static int ForwardConnection = -1;
+static volatile sig_atomic_t ForwardedSignal = 0;
+
+static void
+ForwardHandler(int signal)
+{
+    int savedErrno = errno;
+
+    int32_t value = signal;
+    SendAll(ForwardConnection, &value, sizeof(value));
+    ForwardedSignal = signal;
+
+    errno = savedErrno;
+}
+
+/*
+ * In the invocation, raise the signals the client passes on, so it stops the
+ * same way it would if it ran in the client. Stops when the client is gone.
+ */
+static void
+ReceiveSignals(int connection)
+{
+    int32_t signal;
+    while (ReceiveAll(connection, &signal, sizeof(signal))) {
+        if (IsForwardedSignal(signal)) {
+            ::kill(::getpid(), signal);
+        }
+    }
+}
+
+static std::vector<uint8_t>
+SerializeInvocation(process::Context const *processContext)
+{
+    std::unique_ptr<plist::Dictionary> invocation = plist::Dictionary::New();
+    invocation->set("executablePath", plist::String::New(processContext->executablePath()));
+    invocation->set("currentDirectory", plist::String::New(processContext->currentDirectory()));
+
+    std::unique_ptr<plist::Array> arguments = plist::Array::New();
+    for (std::string const &argument : processContext->commandLineArguments()) {
+        arguments->append(plist::String::New(argument));
+    }
+    invocation->set("arguments", std::move(arguments));
+
+    std::unique_ptr<plist::Dictionary> environment = plist::Dictionary::New();
+    for (auto const &variable : processContext->environmentVariables()) {
+        environment->set(variable.first, plist::String::New(variable.second));
+    }
+    invocation->set("environment", std::move(environment));
+
+    auto serialized = plist::Format::Binary::Serialize(invocation.get(), plist::Format::Binary::Create());
+    if (serialized.first == nullptr) {
+        return std::vector<uint8_t>();
+    }
+
+    return *serialized.first;
+}
+
+/*
+ * The invocation runs as the daemon's user, which is checked to be the
+ * client's, so the user and group are the daemon's own.
+ */
+static std::unique_ptr<process::MemoryContext>
+DeserializeInvocation(process::Context const *processContext, std::vector<uint8_t> const &contents)
+{
+    auto deserialized = plist::Format::Binary::Deserialize(contents, plist::Format::Binary::Create());
+    plist::Dictionary const *invocation = plist::CastTo<plist::Dictionary>(deserialized.first.get());
+    if (invocation == nullptr) {
+        return nullptr;
+    }
+
+    auto executablePath = invocation->value<plist::String>("executablePath");
+    auto currentDirectory = invocation->value<plist::String>("currentDirectory");
+    auto arguments = invocation->value<plist::Array>("arguments");
+    auto environment = invocation->value<plist::Dictionary>("environment");
+    if (executablePath == nullptr || currentDirectory == nullptr || arguments == nullptr || environment == nullptr) {
+        return nullptr;
+    }
+
+    std::vector<std::string> commandLineArguments;
+    for (size_t n = 0; n < arguments->count(); n++) {
+        if (auto argument = arguments->value<plist::String>(n)) {
+            commandLineArguments.push_back(argument->value());
+        }
+    }
+
+    std::unordered_map<std::string, std::string> environmentVariables;
+    for (size_t n = 0; n < environment->count(); n++) {
+        if (auto value = environment->value<plist::String>(n)) {
+            environmentVariables.insert({ environment->key(n), value->value() });
+        }
+    }
+
+    /* The invocation runs in the daemon, so it shouldn't be forwarded again. */
+    environmentVariables.erase(DaemonAction::SocketVariable);
+
+    return std::unique_ptr<process::MemoryContext>(new process::MemoryContext(
+        executablePath->value(),
+        currentDirectory->value(),
+        commandLineArguments,
+        environmentVariables,
+        processContext->userID(),
+        processContext->groupID(),
+        processContext->userName(),
+        processContext->groupName()));
+}
+
+/*
+ * Load what an invocation will need in the daemon itself. The forked process
+ * starts with it loaded, and it stays loaded for later invocations.
+ */
+static void
+LoadInvocation(process::Context const *processContext, Filesystem const *filesystem)
+{
+    Options options;
+    if (!libutil::Options::Parse<Options>(&options, processContext->commandLineArguments()).first) {
+        return;
+    }
+
+    Action::Type action = Action::Determine(options);
+    if (action != Action::Build && action != Action::ShowBuildSettings && action != Action::List) {
+        return;
+    }
+
+    ext::optional<pbxbuild::Build::Environment> buildEnvironment = xcexecution::Resident::BuildEnvironment(processContext, filesystem);
+    if (!buildEnvironment) {
+        return;
+    }
+
+    std::vector<pbxsetting::Level> overrideLevels = Action::CreateOverrideLevels(processContext, filesystem, buildEnvironment->baseEnvironment(), options, processContext->currentDirectory());
+    xcexecution::Parameters parameters = Action::CreateParameters(options, overrideLevels);
+    (void)parameters.loadWorkspace(filesystem, processContext->userName(), *buildEnvironment, processContext->currentDirectory());
+}
+
+static void
+ReplaceEnvironment(std::unordered_map<std::string, std::string> const &variables)
+{
+    std::vector<std::string> names;
+    for (char **entry = environ; *entry != nullptr; ++entry) {
+        std::string variable = *entry;
+        names.push_back(variable.substr(0, variable.find('=')));
+    }
+
+    for (std::string const &name : names) {
+        ::unsetenv(name.c_str());
+    }
+
+    for (auto const &variable : variables) {
+        ::setenv(variable.first.c_str(), variable.second.c_str(), 1);
+    }
+}
+
+static void
+ServeInvocation(int connection, int listener, process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem)
+{
+    int streams[StreamCount];
+    if (!ReceiveStreams(connection, streams)) {
+        fprintf(stderr, "warning: ignoring invocation without standard streams\n");
+        return;
+    }
+
+    std::unique_ptr<process::MemoryContext> context;
+    uint32_t size;
+    if (ReceiveAll(connection, &size, sizeof(size)) && size <= MaximumRequestSize) {
+        std::vector<uint8_t> contents = std::vector<uint8_t>(size);
+        if (ReceiveAll(connection, contents.data(), contents.size())) {
+            context = DeserializeInvocation(processContext, contents);
+        }
+    }
+
+    /* Relative paths in the invocation are relative to its directory. */
+    if (context == nullptr) {
+        fprintf(stderr, "warning: ignoring invalid invocation\n");
+    } else if (::chdir(context->currentDirectory().c_str()) != 0) {
+        fprintf(stderr, "warning: ignoring invocation in %s: %s\n", context->currentDirectory().c_str(), strerror(errno));
+    } else {
+        LoadInvocation(context.get(), filesystem);
+
+        pid_t pid = ::fork();
+        if (pid == 0) {
+            ::close(listener);
+            ::signal(SIGCHLD, SIG_DFL);
+
+            for (int stream = 0; stream < StreamCount; ++stream) {
+                ::dup2(streams[stream], stream);
+                ::close(streams[stream]);
+            }
+            ReplaceEnvironment(context->environmentVariables());
+
+            std::thread(&ReceiveSignals, connection).detach();
+
+            int32_t exitCode = Driver::Run(context.get(), processLauncher, filesystem);
+
+            ::fflush(stdout);
+            ::fflush(stderr);
+            SendAll(connection, &exitCode, sizeof(exitCode));
+
+            /* Skip the daemon's own cleanup, which isn't this process's to do. */
+            ::_exit(0);
+        } else if (pid < 0) {
+            fprintf(stderr, "warning: unable to start invocation: %s\n", strerror(errno));
+        }
+    }
+
+    for (int stream : streams) {
+        ::close(stream);
+    }
+}
+
+int DaemonAction::
+Run(process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem, Options const &options)
+{
+    std::string socketPath = FSUtil::ResolveRelativePath(*options.daemon(), processContext->currentDirectory());
+
+    struct sockaddr_un address;
+    if (!SocketAddress(socketPath, &address)) {
+        fprintf(stderr, "error: socket path is too long: %s\n", socketPath.c_str());
+        return 1;
+    }
+
+    /*
+     * A socket that's there but not accepting connections is left from a
+     * daemon that exited; replace it. Don't replace a running daemon's.
+     */
+    int existing = CreateSocket();
+    if (existing >= 0) {
+        bool running = (::connect(existing, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) == 0);
+        ::close(existing);
+
+        if (running) {
+            fprintf(stderr, "error: a daemon is already listening on %s\n", socketPath.c_str());
+            return 1;
+        }
+    }
+    ::unlink(socketPath.c_str());
+
+    /*
+     * Invocations run as this user, including the project's scripts, so
+     * only this user can connect. The socket is created that way, so there's
+     * no time when it's open to anyone else.
+     */
+    int listener = CreateSocket();
+    mode_t mask = ::umask(0177);
+    bool bound = (listener >= 0 && ::bind(listener, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) == 0);
+    ::umask(mask);
+
+    if (!bound || ::listen(listener, SOMAXCONN) != 0) {
+        fprintf(stderr, "error: unable to listen on %s: %s\n", socketPath.c_str(), strerror(errno));
+        if (listener >= 0) {
+            ::close(listener);
+        }
+        return 1;
+    }
+
+    /* Invocations report their own results; nothing waits for them here. */
+    ::signal(SIGCHLD, SIG_IGN);
+
+    xcexecution::Resident::Enable();
+    fprintf(stderr, "note: listening for invocations on %s\n", socketPath.c_str());
+
+    while (true) {
+        int connection = ::accept(listener, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+
+            fprintf(stderr, "error: unable to accept invocation: %s\n", strerror(errno));
+            break;
+        }
+
+        ::fcntl(connection, F_SETFD, FD_CLOEXEC);
+
+        /* Check with the system, in case the socket was made reachable. */
+        if (!PeerIsUser(connection)) {
+            fprintf(stderr, "warning: ignoring invocation from another user\n");
+        } else {
+            ServeInvocation(connection, listener, processContext, processLauncher, filesystem);
+        }
+        ::close(connection);
+    }
+
+    ::close(listener);
+    return 1;
+}
+
+ext::optional<int> DaemonAction::
+Forward(process::Context const *processContext, std::string const &socketPath)
+{
+    struct sockaddr_un address;
+    if (socketPath.empty() || !SocketAddress(socketPath, &address)) {
+        return ext::nullopt;
+    }
+
+    int fd = CreateSocket();
+    if (fd < 0) {
+        return ext::nullopt;
+    }
+
+    /* The standard streams are only handed to a daemon of this user. */
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 || !PeerIsUser(fd)) {
+        ::close(fd);
+        return ext::nullopt;
+    }
+
+    /* Until the invocation is sent, nothing has run, so it can still run here. */
+    std::vector<uint8_t> invocation = SerializeInvocation(processContext);
+    uint32_t size = static_cast<uint32_t>(invocation.size());
+    int const streams[StreamCount] = { STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO };
+    if (invocation.empty() || !SendStreams(fd, streams) || !SendAll(fd, &size, sizeof(size)) || !SendAll(fd, invocation.data(), invocation.size())) {
+        ::close(fd);
+        return ext::nullopt;
+    }
+
+    /*
+     * Pass interrupts on while waiting, so they stop the invocation in the
+     * daemon like they would here.
+     */
+    ForwardConnection = fd;
+    ForwardedSignal = 0;
+
+    struct sigaction action;
+    ::memset(&action, 0, sizeof(action));
+    action.sa_handler = &ForwardHandler;
+    sigemptyset(&action.sa_mask);
+
+    struct sigaction previous[sizeof(ForwardedSignals) / sizeof(ForwardedSignals[0])];
+    for (size_t n = 0; n < sizeof(ForwardedSignals) / sizeof(ForwardedSignals[0]); ++n) {
+        ::sigaction(ForwardedSignals[n], &action, &previous[n]);
+    }
+
+    int32_t exitCode;
+    bool received = ReceiveAll(fd, &exitCode, sizeof(exitCode));
+
+    for (size_t n = 0; n < sizeof(ForwardedSignals) / sizeof(ForwardedSignals[0]); ++n) {
+        ::sigaction(ForwardedSignals[n], &previous[n], nullptr);
+    }
+    ForwardConnection = -1;
+    ::close(fd);
+
+    if (!received) {
+        /* A second interrupt stops the invocation without it finishing. */
+        if (ForwardedSignal != 0) {
+            return 128 + ForwardedSignal;
+        }
+
+        fprintf(stderr, "error: daemon at %s exited before finishing\n", socketPath.c_str());
+        return 1;
+    }
+
+    return static_cast<int>(exitCode);
+}
@@ -11,15 +11,19 @@
 #include <xcdriver/Action.h>
 #include <xcdriver/Options.h>
 #include <xcdriver/BuildAction.h>
+#include <xcdriver/DaemonAction.h>
 #include <xcdriver/FindAction.h>
 #include <xcdriver/HelpAction.h>
 #include <xcdriver/LicenseAction.h>
 #include <xcdriver/ListAction.h>
+#include <xcdriver/ProjectIndexAction.h>
 #include <xcdriver/ShowSDKsAction.h>
 #include <xcdriver/ShowBuildSettingsAction.h>
 #include <xcdriver/UsageAction.h>
 #include <xcdriver/VersionAction.h>
+#include <xcformatter/Output.h>
 #include <libutil/Filesystem.h>
+#include <libutil/Statistic.h>
 #include <process/Context.h>
 
 #include <string>
@@ -28,7 +32,20 @@
 using xcdriver::Driver;
 using xcdriver::Action;
 using xcdriver::Options;
+using xcdriver::BuildAction;
+using xcdriver::DaemonAction;
+using xcdriver::FindAction;
+using xcdriver::HelpAction;
+using xcdriver::LicenseAction;
+using xcdriver::ListAction;
+using xcdriver::ProjectIndexAction;
+using xcdriver::ShowSDKsAction;
+using xcdriver::ShowBuildSettingsAction;
+using xcdriver::UsageAction;
+using xcdriver::VersionAction;
+using xcformatter::Output;
 using libutil::Filesystem;
+using libutil::Statistic;
 
 Driver::
 Driver()
@@ -40,16 +57,9 @@ Driver::
 {
 }
 
-int Driver::
-Run(process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem)
+static int
+RunAction(process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem, Options const &options)
 {
-    Options options;
-    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
-    if (!result.first) {
-        fprintf(stderr, "error: %s\n", result.second.c_str());
-        return 1;
-    }
-
     Action::Type action = Action::Determine(options);
     switch (action) {
         case Action::Build:
@@ -58,6 +68,8 @@ Run(process::Context const *processContext, process::Launcher *processLauncher,
             return ShowBuildSettingsAction::Run(processContext, filesystem, options);
         case Action::List:
             return ListAction::Run(processContext, filesystem, options);
+        case Action::ProjectIndex:
+            return ProjectIndexAction::Run(processContext, filesystem, options);
         case Action::Version:
             return VersionAction::Run(processContext, filesystem, options);
         case Action::Usage:
@@ -79,7 +91,48 @@ Run(process::Context const *processContext, process::Launcher *processLauncher,
         case Action::Localizations:
             fprintf(stderr, "warning: localizations not implemented\n");
             break;
+        case Action::Daemon:
+            return DaemonAction::Run(processContext, processLauncher, filesystem, options);
     }
 
     return 0;
 }
+
+int Driver::
+Run(process::Context const *processContext, process::Launcher *processLauncher, Filesystem *filesystem)
+{
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext->commandLineArguments());
+    if (!result.first) {
+        fprintf(stderr, "error: %s\n", result.second.c_str());
+        return 1;
+    }
+
+    /*
+     * Run in the daemon if there is one, where what the build loads is
+     * already in memory. Without one listening, run here as usual.
+     */
+    if (Action::Determine(options) != Action::Daemon) {
+        if (ext::optional<std::string> socketPath = processContext->environmentVariable(DaemonAction::SocketVariable)) {
+            if (ext::optional<int> exitCode = DaemonAction::Forward(processContext, *socketPath)) {
+                return *exitCode;
+            }
+        }
+    }
+
+    if (options.showBuildTimings()) {
+        Statistic::Enable();
+    }
+
+    int exitCode = RunAction(processContext, processLauncher, filesystem, options);
+
+    /* Formatted output is batched; write it out before the summary. */
+    Output::Standard()->flush();
+
+    if (options.showBuildTimings()) {
+        fprintf(stderr, "%s", Statistic::Summary().c_str());
+        fprintf(stderr, "Peak memory: %.1f MB\n", static_cast<double>(Statistic::PeakResidentBytes()) / (1024.0 * 1024.0));
+    }
+
+    return exitCode;
+}
@@ -60,8 +60,8 @@ Run(process::Context const *processContext)
     fprintf(
         stdout,
         "    -formatter NAME                             "
-        "use the output formatter NAME. currently only 'default' is "
-        "supported\n");
+        "use the output formatter NAME: 'default', 'null', or 'json' "
+        "for one JSON event per line, the same as -json\n");
     fprintf(
         stdout,
         "    -executor NAME                              "
@@ -72,6 +72,83 @@ Run(process::Context const *processContext)
         "    -generate                                   "
         "specify that an execution engine based on generating another build "
         "language should regenerate\n");
+    fprintf(
+        stdout,
+        "    -batchDependencyInfo                        "
+        "convert dependency info into ninja's dependency log after the ninja "
+        "execution engine builds, rather than running a tool after each command\n");
+    fprintf(
+        stdout,
+        "    -incremental                                "
+        "skip commands with outputs newer than their inputs "
+        "in the simple execution engine\n");
+    fprintf(
+        stdout,
+        "    -actionCache DIRECTORY                      "
+        "restore outputs of commands that ran before with the same inputs "
+        "from a cache directory\n");
+    fprintf(
+        stdout,
+        "    -toolLauncher PATH                          "
+        "run external tools through a launcher, such as a remote "
+        "execution client\n");
+    fprintf(
+        stdout,
+        "    -ninjaPool NAME=DEPTH:TOOL[,TOOL...]        "
+        "run at most DEPTH commands of the tools with these identifiers "
+        "at once in the ninja execution engine\n");
+    fprintf(
+        stdout,
+        "    -shard INDEX/COUNT                          "
+        "build one of COUNT shards of the targets and their dependencies, "
+        "sharing outputs through the action cache, in the simple "
+        "execution engine; with test-without-building, run one of "
+        "COUNT shards of the tests\n");
+    fprintf(
+        stdout,
+        "    -trace PATH                                 "
+        "write how long each step of the build took to PATH, "
+        "in the Chrome trace event format\n");
+    fprintf(
+        stdout,
+        "    -showBuildTimings                           "
+        "print how long loading and planning the build took, how "
+        "often its caches were used, and its peak memory use\n");
+    fprintf(
+        stdout,
+        "    -targetEnvironmentCacheSize NUMBER          "
+        "keep the settings of at most NUMBER targets in memory at once, "
+        "creating others again as needed\n");
+    fprintf(
+        stdout,
+        "    -daemon SOCKET                              "
+        "serve builds on SOCKET, keeping what they load in memory between "
+        "builds; set XCBUILD_DAEMON=SOCKET to have xcbuild use it\n");
+    fprintf(
+        stdout,
+        "    -prebuiltDependencies                       "
+        "use the products of dependencies left from a previous build "
+        "instead of building them again\n");
+    fprintf(
+        stdout,
+        "    -changedPath PATH                           "
+        "only build the targets affected by changes to PATH, and those "
+        "that depend on them; can be repeated\n");
+    fprintf(
+        stdout,
+        "    -changedPathsFile PATH                      "
+        "read changed paths from PATH, one per line, such as from "
+        "`git diff --name-only`\n");
+    fprintf(
+        stdout,
+        "    -changedPaths                               "
+        "only build targets affected by the changed paths given, even "
+        "if none are\n");
+    fprintf(
+        stdout,
+        "    -testHistory PATH                           "
+        "read how long tests took from PATH to start the longest first, "
+        "and write how long they took this time\n");
     fprintf(
         stdout,
         "    -project NAME                               "
@@ -79,7 +156,8 @@ Run(process::Context const *processContext)
     fprintf(
         stdout,
         "    -target NAME                                "
-        "build the target NAME\n");
+        "build the target NAME; with a scheme, build only the scheme's "
+        "target or product NAME and what it depends on\n");
     fprintf(
         stdout,
         "    -alltargets                                 "
@@ -130,6 +208,10 @@ Run(process::Context const *processContext)
         stdout,
         "    -jobs NUMBER                                "
         "not yet implemented\n");
+    fprintf(
+        stdout,
+        "    -loadAverage NUMBER                         "
+        "don't start more tools while the load average is at least NUMBER\n");
     fprintf(
         stdout,
         "    -dry-run                                    "
@@ -138,6 +220,10 @@ Run(process::Context const *processContext)
         stdout,
         "    -hideShellScriptEnvironment                 "
         "not yet implemented\n");
+    fprintf(
+        stdout,
+        "    -parallel-testing-worker-count NUMBER       "
+        "run at most NUMBER test bundles or selected tests at once\n");
     fprintf(
         stdout,
         "    -showsdks                                   "
@@ -151,6 +237,11 @@ Run(process::Context const *processContext)
         "    -list                                       "
         "print the targets and configurations for a given project, or the "
         "schemes for a given workspace\n");
+    fprintf(
+        stdout,
+        "    -projectIndex                               "
+        "update the index of targets, files, and settings kept for editors, "
+        "and print its path\n");
     fprintf(
         stdout,
         "    -find-executable NAME                       "
@@ -175,7 +266,8 @@ Run(process::Context const *processContext)
     fprintf(
         stdout,
         "    -derivedDataPath PATH                       "
-        "not yet implemented\n");
+        "put build products and intermediates in PATH instead of the "
+        "default derived data directory\n");
     fprintf(
         stdout,
         "    -archivePath PATH                           "
@@ -10,14 +10,23 @@
 #include <xcdriver/ListAction.h>
 #include <xcdriver/Action.h>
 #include <xcdriver/Options.h>
+#include <xcexecution/Resident.h>
+#include <pbxproj/Summary.h>
+#include <xcworkspace/XC/Workspace.h>
 #include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Parallel.h>
 #include <process/Context.h>
 
+#include <algorithm>
+#include <unordered_set>
+
 #include <strings.h>
 
 using xcdriver::ListAction;
 using xcdriver::Options;
 using libutil::Filesystem;
+using libutil::FSUtil;
 
 ListAction::
 ListAction()
@@ -29,10 +38,223 @@ ListAction::
 {
 }
 
+namespace {
+
+/*
+ * A scheme to list. Schemes are only listed once per path.
+ */
+struct ListedScheme {
+    std::string name;
+    std::string path;
+};
+
+}
+
+static void
+PrintSchemes(std::vector<ListedScheme> schemes, char const *container)
+{
+    std::sort(schemes.begin(), schemes.end(), [](ListedScheme const &a, ListedScheme const &b) -> bool {
+        return ::strcasecmp(a.name.c_str(), b.name.c_str()) < 0;
+    });
+
+    auto I = std::unique(schemes.begin(), schemes.end(), [](ListedScheme const &a, ListedScheme const &b) -> bool {
+        return (a.path == b.path);
+    });
+    schemes.resize(std::distance(schemes.begin(), I));
+
+    if (schemes.empty()) {
+        printf("\n%4sThis %s contains no scheme.\n", "", container);
+    } else {
+        printf("%4sSchemes:\n", "");
+        for (ListedScheme const &scheme : schemes) {
+            printf("%8s%s\n", "", scheme.name.c_str());
+        }
+        printf("\n");
+    }
+}
+
+static void
+PrintProject(
+    std::string const &name,
+    std::vector<std::string> const &targets,
+    bool hasBuildConfigurationList,
+    std::vector<std::string> const &buildConfigurations,
+    std::string const &defaultConfigurationName,
+    std::vector<ListedScheme> const &schemes)
+{
+    printf("Information about project \"%s\":\n", name.c_str());
+
+    if (!targets.empty()) {
+        printf("%4sTargets:\n", "");
+        for (std::string const &target : targets) {
+            printf("%8s%s\n", "", target.c_str());
+        }
+    } else {
+        printf("%4sThis project contains no targets.\n", "");
+    }
+    printf("\n");
+
+    if (hasBuildConfigurationList) {
+        printf("%4sBuild Configurations:\n", "");
+        for (std::string const &config : buildConfigurations) {
+            printf("%8s%s\n", "", config.c_str());
+        }
+        printf("\n%4sIf no build configuration is specified and -scheme is not passed then \"%s\" is used.\n", "", defaultConfigurationName.c_str());
+    } else {
+        printf("%4sThis project contains no build configurations.\n", "");
+    }
+    printf("\n");
+
+    PrintSchemes(schemes, "project");
+}
+
+static void
+AddSchemes(std::vector<ListedScheme> *schemes, xcscheme::SchemeGroup::shared_ptr const &group)
+{
+    if (group == nullptr) {
+        return;
+    }
+
+    std::vector<std::string> names = group->schemeNames();
+    std::vector<std::string> paths = group->schemePaths();
+    for (size_t i = 0; i < names.size(); ++i) {
+        schemes->push_back({ names[i], paths[i] });
+    }
+}
+
+static void
+AddWorkspaceItem(xcworkspace::XC::Workspace::shared_ptr const &workspace, xcworkspace::XC::GroupItem::shared_ptr const &item, std::vector<std::string> *projectPaths)
+{
+    if (item->type() == xcworkspace::XC::GroupItem::Type::Group) {
+        for (xcworkspace::XC::GroupItem::shared_ptr const &child : std::static_pointer_cast<xcworkspace::XC::Group>(item)->items()) {
+            AddWorkspaceItem(workspace, child, projectPaths);
+        }
+    } else if (item->type() == xcworkspace::XC::GroupItem::Type::FileRef) {
+        projectPaths->push_back(std::static_pointer_cast<xcworkspace::XC::FileRef>(item)->resolve(workspace));
+    }
+}
+
+/*
+ * Find the schemes in projects and the projects nested in them, from
+ * their summaries. Fails if any project can't be summarized.
+ */
+static bool
+AddProjectSchemes(
+    Filesystem const *filesystem,
+    std::string const &userName,
+    std::vector<std::string> projectPaths,
+    std::unordered_set<std::string> *seen,
+    std::vector<ListedScheme> *schemes)
+{
+    while (!projectPaths.empty()) {
+        std::vector<std::string> paths;
+        for (std::string const &path : projectPaths) {
+            if (seen->insert(FSUtil::NormalizePath(path)).second) {
+                paths.push_back(path);
+            }
+        }
+        projectPaths.clear();
+
+        /* Each project and its schemes are independent, so read them in parallel. */
+        std::vector<ext::optional<pbxproj::Summary>> summaries = std::vector<ext::optional<pbxproj::Summary>>(paths.size());
+        std::vector<xcscheme::SchemeGroup::shared_ptr> groups = std::vector<xcscheme::SchemeGroup::shared_ptr>(paths.size());
+        libutil::Parallel::For(paths.size(), [&](size_t index) {
+            summaries[index] = pbxproj::Summary::Open(filesystem, paths[index]);
+            if (summaries[index]) {
+                std::string const &projectFile = summaries[index]->projectFile();
+                groups[index] = xcscheme::SchemeGroup::Open(filesystem, userName, FSUtil::GetDirectoryName(projectFile), projectFile, summaries[index]->name());
+            }
+        });
+
+        for (size_t index = 0; index < paths.size(); ++index) {
+            if (!summaries[index] || !summaries[index]->projectReferencesResolved()) {
+                return false;
+            }
+
+            AddSchemes(schemes, groups[index]);
+            projectPaths.insert(projectPaths.end(), summaries[index]->projectReferences().begin(), summaries[index]->projectReferences().end());
+        }
+    }
+
+    return true;
+}
+
+/*
+ * List from the project files' names alone, without loading the build
+ * environment or any project. Prints nothing and fails if something can
+ * only be found by loading them, such as a path from build settings.
+ */
+static bool
+RunSummary(process::Context const *processContext, Filesystem const *filesystem, Options const &options)
+{
+    std::vector<ListedScheme> schemes;
+    std::unordered_set<std::string> seen;
+
+    if (options.workspace()) {
+        xcworkspace::XC::Workspace::shared_ptr workspace = xcworkspace::XC::Workspace::Open(filesystem, FSUtil::ResolveRelativePath(*options.workspace(), processContext->currentDirectory()));
+        if (workspace == nullptr) {
+            return false;
+        }
+
+        AddSchemes(&schemes, xcscheme::SchemeGroup::Open(filesystem, processContext->userName(), workspace->basePath(), workspace->projectFile(), workspace->name()));
+
+        std::vector<std::string> projectPaths;
+        for (xcworkspace::XC::GroupItem::shared_ptr const &item : workspace->items()) {
+            AddWorkspaceItem(workspace, item, &projectPaths);
+        }
+
+        if (!AddProjectSchemes(filesystem, processContext->userName(), projectPaths, &seen, &schemes)) {
+            return false;
+        }
+
+        printf("Information about workspace \"%s\":\n", workspace->name().c_str());
+        PrintSchemes(schemes, "workspace");
+        return true;
+    }
+
+    std::string projectPath;
+    if (options.project()) {
+        projectPath = FSUtil::ResolveRelativePath(*options.project(), processContext->currentDirectory());
+    } else {
+        /* Anything but exactly one project is an error, reported when loading. */
+        size_t count = 0;
+        filesystem->enumerateDirectory(processContext->currentDirectory(), [&](std::string const &filename) {
+            if (FSUtil::GetFileExtension(filename) == "xcodeproj") {
+                projectPath = processContext->currentDirectory() + "/" + filename;
+                count++;
+            }
+        });
+
+        if (count != 1) {
+            return false;
+        }
+    }
+
+    ext::optional<pbxproj::Summary> summary = pbxproj::Summary::Open(filesystem, projectPath);
+    if (!summary || !summary->projectReferencesResolved()) {
+        return false;
+    }
+
+    seen.insert(FSUtil::NormalizePath(summary->projectFile()));
+    AddSchemes(&schemes, xcscheme::SchemeGroup::Open(filesystem, processContext->userName(), FSUtil::GetDirectoryName(summary->projectFile()), summary->projectFile(), summary->name()));
+
+    if (!AddProjectSchemes(filesystem, processContext->userName(), summary->projectReferences(), &seen, &schemes)) {
+        return false;
+    }
+
+    PrintProject(summary->name(), summary->targets(), summary->hasBuildConfigurationList(), summary->buildConfigurations(), summary->defaultConfigurationName(), schemes);
+    return true;
+}
+
 int ListAction::
 Run(process::Context const *processContext, Filesystem const *filesystem, Options const &options)
 {
-    ext::optional<pbxbuild::Build::Environment> buildEnvironment = pbxbuild::Build::Environment::Default(processContext, filesystem);
+    /* Editors list every project they open, so avoid loading what isn't listed. */
+    if (RunSummary(processContext, filesystem, options)) {
+        return 0;
+    }
+
+    ext::optional<pbxbuild::Build::Environment> buildEnvironment = xcexecution::Resident::BuildEnvironment(processContext, filesystem);
     if (!buildEnvironment) {
         fprintf(stderr, "error: couldn't create build environment\n");
         return -1;
@@ -47,69 +269,34 @@ Run(process::Context const *processContext, Filesystem const *filesystem, Option
     }
 
     /* Collect all schemes in the workspace. */
-    std::vector<xcscheme::XC::Scheme::shared_ptr> schemes;
+    std::vector<ListedScheme> schemes;
     for (xcscheme::SchemeGroup::shared_ptr const &schemeGroup : context->schemeGroups()) {
-        schemes.insert(schemes.end(), schemeGroup->schemes().begin(), schemeGroup->schemes().end());
+        for (xcscheme::XC::Scheme::shared_ptr const &scheme : schemeGroup->schemes()) {
+            schemes.push_back({ scheme->name(), scheme->path() });
+        }
     }
 
-    std::sort(schemes.begin(), schemes.end(), [](xcscheme::XC::Scheme::shared_ptr const &a, xcscheme::XC::Scheme::shared_ptr const &b) -> bool {
-        return ::strcasecmp(a->name().c_str(), b->name().c_str()) < 0;
-    });
-
-    auto I = std::unique(schemes.begin(), schemes.end(), [](xcscheme::XC::Scheme::shared_ptr const &a, xcscheme::XC::Scheme::shared_ptr const &b) -> bool {
-        return (a->path() == b->path());
-    });
-    schemes.resize(std::distance(schemes.begin(), I));
-
     if (context->workspace() != nullptr) {
-        xcworkspace::XC::Workspace::shared_ptr const &workspace = context->workspace();
-
-        printf("Information about workspace \"%s\":\n", workspace->name().c_str());
-
-        if (schemes.empty()) {
-            printf("\n%4sThis workspace contains no scheme.\n", "");
-        } else {
-            printf("%4sSchemes:\n", "");
-            for (auto const &scheme : schemes) {
-                printf("%8s%s\n", "", scheme->name().c_str());
-            }
-            printf("\n");
-        }
+        printf("Information about workspace \"%s\":\n", context->workspace()->name().c_str());
+        PrintSchemes(schemes, "workspace");
     } else if (context->project() != nullptr) {
         pbxproj::PBX::Project::shared_ptr const &project = context->project();
 
-        printf("Information about project \"%s\":\n", project->name().c_str());
-
-        if (!project->targets().empty()) {
-            printf("%4sTargets:\n", "");
-            for (auto const &target : project->targets()) {
-                printf("%8s%s\n", "", target->name().c_str());
-            }
-        } else {
-            printf("%4sThis project contains no targets.\n", "");
+        std::vector<std::string> targets;
+        for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
+            targets.push_back(target->name());
         }
-        printf("\n");
 
+        std::vector<std::string> buildConfigurations;
+        std::string defaultConfigurationName;
         if (project->buildConfigurationList()) {
-            printf("%4sBuild Configurations:\n", "");
-            for (auto const &config : project->buildConfigurationList()->buildConfigurations()) {
-                printf("%8s%s\n", "", config->name().c_str());
+            for (pbxproj::XC::BuildConfiguration::shared_ptr const &config : project->buildConfigurationList()->buildConfigurations()) {
+                buildConfigurations.push_back(config->name());
             }
-            printf("\n%4sIf no build configuration is specified and -scheme is not passed then \"%s\" is used.\n", "", project->buildConfigurationList()->defaultConfigurationName().c_str());
-        } else {
-            printf("%4sThis project contains no build configurations.\n", "");
+            defaultConfigurationName = project->buildConfigurationList()->defaultConfigurationName();
         }
-        printf("\n");
 
-        if (schemes.empty()) {
-            printf("\n%4sThis project contains no scheme.\n", "");
-        } else {
-            printf("%4sSchemes:\n", "");
-            for (auto const &scheme : schemes) {
-                printf("%8s%s\n", "", scheme->name().c_str());
-            }
-            printf("\n");
-        }
+        PrintProject(project->name(), targets, project->buildConfigurationList() != nullptr, buildConfigurations, defaultConfigurationName, schemes);
     }
 
     return 0;
@@ -9,6 +9,8 @@
 
 #include <xcdriver/Options.h>
 
+#include <algorithm>
+
 using xcdriver::Options;
 
 Options::
@@ -68,6 +70,8 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Current<bool>(&_parallelizeTargets, arg);
     } else if (arg == "-jobs") {
         return libutil::Options::Next<int>(&_jobs, args, it);
+    } else if (arg == "-loadAverage") {
+        return libutil::Options::Next<std::string>(&_loadAverage, args, it);
     } else if (arg == "-dryrun" || arg == "-n") {
         return libutil::Options::Current<bool>(&_dryRun, arg);
     } else if (arg == "-hideShellScriptEnvironment") {
@@ -76,8 +80,25 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Current<bool>(&_showSDKs, arg);
     } else if (arg == "-showBuildSettings") {
         return libutil::Options::Current<bool>(&_showBuildSettings, arg);
+    } else if (arg == "-settings") {
+        std::vector<std::string> values;
+        std::pair<bool, std::string> result = libutil::Options::AppendNext<std::string>(&values, args, it);
+        if (result.first) {
+            /* Names are separated by commas. */
+            std::string const &value = values.front();
+            for (size_t start = 0; start <= value.size();) {
+                size_t end = std::min(value.find(',', start), value.size());
+                if (end > start) {
+                    _showBuildSettingsNames.push_back(value.substr(start, end - start));
+                }
+                start = end + 1;
+            }
+        }
+        return result;
     } else if (arg == "-list") {
         return libutil::Options::Current<bool>(&_list, arg);
+    } else if (arg == "-projectIndex") {
+        return libutil::Options::Current<bool>(&_projectIndex, arg);
     } else if (arg == "-find" || arg == "-find-executable") {
         return libutil::Options::Next<std::string>(&_findExecutable, args, it);
     } else if (arg == "-find-library") {
@@ -110,6 +131,10 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         std::string value = arg.substr(arg.find(':') + 1);
         _skipTesting.push_back(value);
         return std::make_pair(true, std::string());
+    } else if (arg == "-parallel-testing-worker-count") {
+        return libutil::Options::Next<int>(&_parallelTestingWorkerCount, args, it);
+    } else if (arg == "-testHistory") {
+        return libutil::Options::Next<std::string>(&_testHistory, args, it);
     } else if (arg == "-exportPath") {
         return libutil::Options::Next<std::string>(&_exportPath, args, it);
     } else if (arg == "-skipUnavailableActions") {
@@ -130,6 +155,40 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Next<std::string>(&_formatter, args, it);
     } else if (arg == "-generate") {
         return libutil::Options::Current<bool>(&_generate, arg);
+    } else if (arg == "-batchDependencyInfo") {
+        return libutil::Options::Current<bool>(&_batchDependencyInfo, arg);
+    } else if (arg == "-incremental" || arg == "-noIncremental") {
+        /* Either can be given after the other; the last one wins. */
+        ext::optional<bool> given;
+        std::pair<bool, std::string> result = libutil::Options::Current<bool>(&given, arg);
+        if (result.first) {
+            _incremental = (arg == "-incremental");
+        }
+        return result;
+    } else if (arg == "-actionCache") {
+        return libutil::Options::Next<std::string>(&_actionCache, args, it);
+    } else if (arg == "-toolLauncher") {
+        return libutil::Options::Next<std::string>(&_toolLauncher, args, it);
+    } else if (arg == "-ninjaPool") {
+        return libutil::Options::AppendNext<std::string>(&_ninjaPools, args, it);
+    } else if (arg == "-shard") {
+        return libutil::Options::Next<std::string>(&_shard, args, it);
+    } else if (arg == "-trace") {
+        return libutil::Options::Next<std::string>(&_trace, args, it);
+    } else if (arg == "-showBuildTimings") {
+        return libutil::Options::Current<bool>(&_showBuildTimings, arg);
+    } else if (arg == "-targetEnvironmentCacheSize") {
+        return libutil::Options::Next<int>(&_targetEnvironmentCacheSize, args, it);
+    } else if (arg == "-daemon") {
+        return libutil::Options::Next<std::string>(&_daemon, args, it);
+    } else if (arg == "-prebuiltDependencies") {
+        return libutil::Options::Current<bool>(&_prebuiltDependencies, arg);
+    } else if (arg == "-changedPaths") {
+        return libutil::Options::Current<bool>(&_changedPaths, arg);
+    } else if (arg == "-changedPath") {
+        return libutil::Options::AppendNext<std::string>(&_changedPath, args, it);
+    } else if (arg == "-changedPathsFile") {
+        return libutil::Options::Next<std::string>(&_changedPathsFile, args, it);
     } else if (!arg.empty() && arg[0] != '-') {
         if (arg.find('=') != std::string::npos) {
             if (ext::optional<pbxsetting::Setting> setting = pbxsetting::Setting::Parse(arg)) {
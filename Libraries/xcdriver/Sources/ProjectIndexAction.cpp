@@ -0,0 +1,185 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcdriver/ProjectIndexAction.h>
+#include <xcdriver/Action.h>
+#include <xcdriver/Options.h>
+#include <xcexecution/ProjectIndex.h>
+#include <xcexecution/Resident.h>
+#include <xcworkspace/XC/Workspace.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <process/Context.h>
+
+#include <unordered_set>
+
+using xcdriver::ProjectIndexAction;
+using xcdriver::Options;
+using xcexecution::ProjectIndex;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+ProjectIndexAction::
+ProjectIndexAction()
+{
+}
+
+ProjectIndexAction::
+~ProjectIndexAction()
+{
+}
+
+static void
+AddWorkspaceItem(xcworkspace::XC::Workspace::shared_ptr const &workspace, xcworkspace::XC::GroupItem::shared_ptr const &item, std::vector<std::string> *projectPaths)
+{
+    if (item->type() == xcworkspace::XC::GroupItem::Type::Group) {
+        for (xcworkspace::XC::GroupItem::shared_ptr const &child : std::static_pointer_cast<xcworkspace::XC::Group>(item)->items()) {
+            AddWorkspaceItem(workspace, child, projectPaths);
+        }
+    } else if (item->type() == xcworkspace::XC::GroupItem::Type::FileRef) {
+        projectPaths->push_back(std::static_pointer_cast<xcworkspace::XC::FileRef>(item)->resolve(workspace));
+    }
+}
+
+/*
+ * The projects in the workspace, or the project, without loading any of
+ * them. Fails if the project can only be found by loading the workspace.
+ */
+static ext::optional<std::vector<std::string>>
+RootProjectPaths(process::Context const *processContext, Filesystem const *filesystem, Options const &options)
+{
+    std::vector<std::string> projectPaths;
+
+    if (options.workspace()) {
+        xcworkspace::XC::Workspace::shared_ptr workspace = xcworkspace::XC::Workspace::Open(filesystem, FSUtil::ResolveRelativePath(*options.workspace(), processContext->currentDirectory()));
+        if (workspace == nullptr) {
+            return ext::nullopt;
+        }
+
+        for (xcworkspace::XC::GroupItem::shared_ptr const &item : workspace->items()) {
+            AddWorkspaceItem(workspace, item, &projectPaths);
+        }
+    } else if (options.project()) {
+        projectPaths.push_back(FSUtil::ResolveRelativePath(*options.project(), processContext->currentDirectory()));
+    } else {
+        /* Anything but exactly one project is an error, reported when loading. */
+        filesystem->enumerateDirectory(processContext->currentDirectory(), [&](std::string const &filename) {
+            if (FSUtil::GetFileExtension(filename) == "xcodeproj") {
+                projectPaths.push_back(processContext->currentDirectory() + "/" + filename);
+            }
+        });
+
+        if (projectPaths.size() != 1) {
+            return ext::nullopt;
+        }
+    }
+
+    return projectPaths;
+}
+
+int ProjectIndexAction::
+Run(process::Context const *processContext, Filesystem *filesystem, Options const &options)
+{
+    ext::optional<pbxbuild::Build::Environment> buildEnvironment = xcexecution::Resident::BuildEnvironment(processContext, filesystem);
+    if (!buildEnvironment) {
+        fprintf(stderr, "error: couldn't create build environment\n");
+        return -1;
+    }
+
+    std::vector<pbxsetting::Level> overrideLevels = Action::CreateOverrideLevels(processContext, filesystem, buildEnvironment->baseEnvironment(), options, processContext->currentDirectory());
+    xcexecution::Parameters parameters = Action::CreateParameters(options, overrideLevels);
+
+    /* The index is kept with the intermediates, so it's per workspace. */
+    ext::optional<std::string> intermediatesDirectory = parameters.intermediatesDirectory(filesystem, *buildEnvironment);
+    if (!intermediatesDirectory) {
+        fprintf(stderr, "error: couldn't determine intermediates directory\n");
+        return -1;
+    }
+    std::string indexPath = *intermediatesDirectory + "/.project-index";
+
+    /*
+     * The workspace is only loaded once a project needs indexing; if none
+     * changed, the index is checked without loading anything.
+     */
+    ext::optional<pbxbuild::WorkspaceContext> workspaceContext;
+    auto loadWorkspace = [&]() -> bool {
+        if (!workspaceContext) {
+            workspaceContext = parameters.loadWorkspace(filesystem, processContext->userName(), *buildEnvironment, processContext->currentDirectory());
+        }
+        return static_cast<bool>(workspaceContext);
+    };
+
+    std::vector<std::string> projectPaths;
+    if (ext::optional<std::vector<std::string>> rootProjectPaths = RootProjectPaths(processContext, filesystem, options)) {
+        projectPaths = *rootProjectPaths;
+    } else {
+        if (!loadWorkspace()) {
+            return -1;
+        }
+
+        if (workspaceContext->project() != nullptr) {
+            projectPaths.push_back(workspaceContext->project()->projectFile());
+        }
+    }
+
+    std::unique_ptr<ProjectIndex> previous = ProjectIndex::Open(filesystem, indexPath);
+
+    /* Walk the projects and the projects nested in them. */
+    std::vector<ProjectIndex::Project> projects;
+    std::unordered_set<std::string> seen;
+    bool changed = false;
+
+    while (!projectPaths.empty()) {
+        std::string path = FSUtil::NormalizePath(projectPaths.back());
+        projectPaths.pop_back();
+        if (!seen.insert(path).second) {
+            continue;
+        }
+
+        ext::optional<ProjectIndex::Project> project;
+        if (previous != nullptr) {
+            project = previous->project(path);
+        }
+
+        if (!project || !project->upToDate(filesystem)) {
+            if (!loadWorkspace()) {
+                return -1;
+            }
+
+            project = ProjectIndex::Project::Create(filesystem, *buildEnvironment, *workspaceContext, workspaceContext->project(path));
+            if (!project) {
+                fprintf(stderr, "warning: unable to index project '%s'\n", path.c_str());
+                continue;
+            }
+
+            changed = true;
+        }
+
+        projectPaths.insert(projectPaths.end(), project->projectReferences().begin(), project->projectReferences().end());
+        projects.push_back(std::move(*project));
+    }
+
+    /* Projects no longer in the workspace are dropped too. */
+    if (previous == nullptr || previous->projectPaths().size() != projects.size()) {
+        changed = true;
+    }
+
+    /* Release the mapping before the index is replaced. */
+    previous.reset();
+
+    if (changed) {
+        if (!filesystem->createDirectory(*intermediatesDirectory) || !filesystem->writeIfChanged(ProjectIndex::Serialize(projects), indexPath)) {
+            fprintf(stderr, "error: failed to write project index to %s\n", indexPath.c_str());
+            return -1;
+        }
+    }
+
+    fprintf(stdout, "%s\n", indexPath.c_str());
+    return 0;
+}
@@ -10,12 +10,25 @@
 #include <xcdriver/ShowBuildSettingsAction.h>
 #include <xcdriver/Options.h>
 #include <xcdriver/Action.h>
+#include <xcexecution/Resident.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/Binary.h>
 #include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/md5.h>
 #include <process/Context.h>
 
+#include <iomanip>
+#include <set>
+#include <sstream>
+
 using xcdriver::ShowBuildSettingsAction;
 using xcdriver::Options;
 using libutil::Filesystem;
+using libutil::FSUtil;
 
 ShowBuildSettingsAction::
 ShowBuildSettingsAction()
@@ -27,14 +40,175 @@ ShowBuildSettingsAction::
 {
 }
 
+/*
+ * Where the settings shown for a set of parameters are cached. Like the
+ * Ninja file, this is found through the derived data directory, so it can
+ * be checked without loading the workspace. Settings also come from the
+ * environment variables, the user and the developer directory, so those
+ * are part of the key too. Queries for some settings by name are cached
+ * separately from all settings and from each other.
+ */
+static ext::optional<std::string>
+SettingsCachePath(process::Context const *processContext, Filesystem const *filesystem, pbxbuild::Build::Environment const &buildEnvironment, xcexecution::Parameters const &parameters, std::set<std::string> const &names)
+{
+    ext::optional<std::string> intermediatesDirectory = parameters.intermediatesDirectory(filesystem, buildEnvironment);
+    if (!intermediatesDirectory) {
+        return ext::nullopt;
+    }
+
+    md5_state_t state;
+    md5_init(&state);
+
+    std::string environmentKey = xcexecution::Resident::EnvironmentKey(processContext, filesystem);
+    md5_append(&state, reinterpret_cast<const md5_byte_t *>(environmentKey.data()), environmentKey.size() + 1);
+    for (std::string const &name : names) {
+        md5_append(&state, reinterpret_cast<const md5_byte_t *>(name.data()), name.size() + 1);
+    }
+
+    uint8_t digest[16];
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        ss << std::setw(2) << static_cast<int>(c);
+    }
+
+    return *intermediatesDirectory + "/" + ".build-settings-" + parameters.canonicalHash() + "-" + ss.str();
+}
+
+/*
+ * Files that don't exist are recorded with this time, so creating them is
+ * a change too.
+ */
+static int64_t const MissingModificationTime = -1;
+
+/*
+ * Reads the cached settings, if they were written for the same parameters
+ * and none of the files they were computed from have changed since.
+ */
+static ext::optional<std::string>
+ReadSettingsCache(Filesystem const *filesystem, std::string const &path)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return ext::nullopt;
+    }
+
+    auto result = plist::Format::Any::Deserialize(contents);
+    plist::Dictionary const *cache = plist::CastTo<plist::Dictionary>(result.first.get());
+    if (cache == nullptr) {
+        return ext::nullopt;
+    }
+
+    plist::Dictionary const *inputs = cache->value<plist::Dictionary>("Inputs");
+    plist::String const *settings = cache->value<plist::String>("Settings");
+    if (inputs == nullptr || settings == nullptr) {
+        return ext::nullopt;
+    }
+
+    for (size_t n = 0; n < inputs->count(); ++n) {
+        plist::Integer const *modificationTime = inputs->value<plist::Integer>(n);
+        ext::optional<uint64_t> currentModificationTime = filesystem->modificationTime(inputs->key(n));
+        int64_t current = (currentModificationTime ? static_cast<int64_t>(*currentModificationTime) : MissingModificationTime);
+        if (modificationTime == nullptr || modificationTime->value() != current) {
+            return ext::nullopt;
+        }
+    }
+
+    return settings->value();
+}
+
+static void
+WriteSettingsCache(Filesystem *filesystem, std::string const &path, std::set<std::string> const &inputs, std::string const &settings)
+{
+    auto cache = plist::Dictionary::New();
+
+    auto modificationTimes = plist::Dictionary::New();
+    for (std::string const &input : inputs) {
+        ext::optional<uint64_t> modificationTime = filesystem->modificationTime(input);
+        modificationTimes->set(input, plist::Integer::New(modificationTime ? static_cast<int64_t>(*modificationTime) : MissingModificationTime));
+    }
+    cache->set("Inputs", std::move(modificationTimes));
+    cache->set("Settings", plist::String::New(settings));
+
+    auto serialized = plist::Format::Binary::Serialize(cache.get(), plist::Format::Binary::Create());
+    if (serialized.first == nullptr) {
+        return;
+    }
+
+    /* The cache is only an optimization; failing to write it is fine. */
+    if (filesystem->createDirectory(FSUtil::GetDirectoryName(path))) {
+        filesystem->write(*serialized.first, path);
+    }
+}
+
+static void
+AddConfigInputs(std::set<std::string> *inputs, pbxsetting::XC::Config const &config)
+{
+    inputs->insert(config.path());
+
+    for (pbxsetting::XC::Config::Entry const &entry : config.contents()) {
+        if (entry.type() == pbxsetting::XC::Config::Entry::Type::Include && entry.config() != nullptr) {
+            AddConfigInputs(inputs, *entry.config());
+        }
+    }
+}
+
+static void
+AddConfigurationListInputs(std::set<std::string> *inputs, pbxbuild::WorkspaceContext const &workspaceContext, pbxproj::XC::ConfigurationList::shared_ptr const &configurationList)
+{
+    if (configurationList == nullptr) {
+        return;
+    }
+
+    for (pbxproj::XC::BuildConfiguration::shared_ptr const &buildConfiguration : configurationList->buildConfigurations()) {
+        if (ext::optional<pbxsetting::XC::Config> config = workspaceContext.config(buildConfiguration)) {
+            AddConfigInputs(inputs, *config);
+        }
+    }
+}
+
+/*
+ * The files that build settings are computed from, other than those named
+ * in the parameters themselves.
+ */
+static std::set<std::string>
+SettingsInputs(pbxbuild::WorkspaceContext const &workspaceContext)
+{
+    std::set<std::string> inputs;
+
+    if (workspaceContext.workspace() != nullptr) {
+        inputs.insert(workspaceContext.workspace()->dataFile());
+    }
+
+    for (auto const &entry : workspaceContext.projects()) {
+        pbxproj::PBX::Project::shared_ptr const &project = entry.second;
+        inputs.insert(project->dataFile());
+
+        AddConfigurationListInputs(&inputs, workspaceContext, project->buildConfigurationList());
+        for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
+            AddConfigurationListInputs(&inputs, workspaceContext, target->buildConfigurationList());
+        }
+    }
+
+    for (xcscheme::SchemeGroup::shared_ptr const &schemeGroup : workspaceContext.schemeGroups()) {
+        for (xcscheme::XC::Scheme::shared_ptr const &scheme : schemeGroup->schemes()) {
+            inputs.insert(scheme->path());
+        }
+    }
+
+    return inputs;
+}
+
 int ShowBuildSettingsAction::
-Run(process::Context const *processContext, Filesystem const *filesystem, Options const &options)
+Run(process::Context const *processContext, Filesystem *filesystem, Options const &options)
 {
     if (!Action::VerifyBuildActions(options.actions())) {
         return -1;
     }
 
-    ext::optional<pbxbuild::Build::Environment> buildEnvironment = pbxbuild::Build::Environment::Default(processContext, filesystem);
+    ext::optional<pbxbuild::Build::Environment> buildEnvironment = xcexecution::Resident::BuildEnvironment(processContext, filesystem);
     if (!buildEnvironment) {
         fprintf(stderr, "error: couldn't create build environment\n");
         return -1;
@@ -43,6 +217,19 @@ Run(process::Context const *processContext, Filesystem const *filesystem, Option
     std::vector<pbxsetting::Level> overrideLevels = Action::CreateOverrideLevels(processContext, filesystem, buildEnvironment->baseEnvironment(), options, processContext->currentDirectory());
     xcexecution::Parameters parameters = Action::CreateParameters(options, overrideLevels);
 
+    /*
+     * Settings are often requested repeatedly for the same parameters, such
+     * as by editors. Skip loading the workspace if nothing has changed.
+     */
+    std::set<std::string> names = std::set<std::string>(options.showBuildSettingsNames().begin(), options.showBuildSettingsNames().end());
+    ext::optional<std::string> cachePath = SettingsCachePath(processContext, filesystem, *buildEnvironment, parameters, names);
+    if (cachePath) {
+        if (ext::optional<std::string> settings = ReadSettingsCache(filesystem, *cachePath)) {
+            fputs(settings->c_str(), stdout);
+            return 0;
+        }
+    }
+
     ext::optional<pbxbuild::WorkspaceContext> workspaceContext = parameters.loadWorkspace(filesystem, processContext->userName(), *buildEnvironment, processContext->currentDirectory());
     if (!workspaceContext) {
         return -1;
@@ -53,7 +240,7 @@ Run(process::Context const *processContext, Filesystem const *filesystem, Option
         return -1;
     }
 
-    ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> graph = parameters.resolveDependencies(*buildEnvironment, *buildContext);
+    ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> graph = parameters.resolveDependencies(filesystem, *buildEnvironment, *buildContext);
     if (!graph) {
         return -1;
     }
@@ -64,22 +251,54 @@ Run(process::Context const *processContext, Filesystem const *filesystem, Option
         return -1;
     }
 
+    /*
+     * Specifications and SDKs are loaded from the developer directory, and
+     * reinstalling xcbuild can change how settings are computed.
+     */
+    std::set<std::string> inputs = SettingsInputs(*workspaceContext);
+    std::vector<std::string> environmentPaths = xcexecution::Resident::EnvironmentPaths(processContext, filesystem, *buildEnvironment);
+    inputs.insert(environmentPaths.begin(), environmentPaths.end());
+    inputs.insert(processContext->executablePath());
+    bool complete = true;
+
+    std::string settings;
     for (pbxproj::PBX::Target::shared_ptr const &target : *targets) {
         ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext->targetEnvironment(*buildEnvironment, target);
         if (!targetEnvironment) {
             fprintf(stderr, "error: couldn't create target environment\n");
+            complete = false;
             continue;
         }
 
+        /* Settings also come from the SDK. */
+        inputs.insert(targetEnvironment->sdk()->path());
+
+        /*
+         * Resolving every setting is most of the work, so when only some
+         * are asked for, resolve just those.
+         */
         pbxsetting::Environment const &environment = targetEnvironment->environment();
-        std::unordered_map<std::string, std::string> values = environment.computeValues(pbxsetting::Condition::Empty());
+        std::unordered_map<std::string, std::string> values;
+        if (names.empty()) {
+            values = environment.computeValues(pbxsetting::Condition::Empty());
+        } else {
+            values = environment.computeValues(pbxsetting::Condition::Empty(), [&](std::string const &name) {
+                return names.find(name) != names.end();
+            });
+        }
         std::map<std::string, std::string> orderedValues = std::map<std::string, std::string>(values.begin(), values.end());
 
-        printf("Build settings for action %s and target %s:\n", buildContext->action().c_str(), target->name().c_str());
+        settings += "Build settings for action " + buildContext->action() + " and target " + target->name() + ":\n";
         for (auto const &value : orderedValues) {
-            printf("    %s = %s\n", value.first.c_str(), value.second.c_str());
+            settings += "    " + value.first + " = " + value.second + "\n";
         }
-        printf("\n");
+        settings += "\n";
+    }
+
+    fputs(settings.c_str(), stdout);
+
+    if (cachePath && complete) {
+        WriteSettingsCache(filesystem, *cachePath, inputs, settings);
     }
 
     return 0;
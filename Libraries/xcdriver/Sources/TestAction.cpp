@@ -0,0 +1,272 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcdriver/TestAction.h>
+#include <xcdriver/Options.h>
+#include <xcexecution/Parameters.h>
+#include <xcexecution/SimpleExecutor.h>
+#include <xcexecution/TestRunner.h>
+#include <pbxbuild/Build/Context.h>
+#include <pbxbuild/Target/Environment.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <process/Context.h>
+
+#include <algorithm>
+#include <thread>
+
+using xcdriver::TestAction;
+using xcdriver::Options;
+using xcexecution::TestRunner;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+TestAction::
+TestAction()
+{
+}
+
+TestAction::
+~TestAction()
+{
+}
+
+namespace {
+
+/*
+ * A built test bundle from the scheme.
+ */
+struct Bundle {
+    std::string              name;
+    std::string              path;
+    std::vector<std::string> executablePaths;
+};
+
+}
+
+static pbxproj::PBX::Target::shared_ptr
+ResolveTestable(pbxbuild::Build::Context const &buildContext, xcscheme::XC::TestableReference::shared_ptr const &testable)
+{
+    xcscheme::XC::BuildableReference::shared_ptr const &reference = testable->buildableReference();
+    if (reference == nullptr) {
+        return nullptr;
+    }
+
+    pbxproj::PBX::Project::shared_ptr project = buildContext.workspaceContext().project(reference->resolve(buildContext.schemeGroup()));
+    if (project == nullptr) {
+        return nullptr;
+    }
+
+    pbxproj::PBX::Target::shared_ptr target = buildContext.resolveTargetIdentifier(project, reference->blueprintIdentifier());
+    if (target == nullptr) {
+        /* As when building, a regenerated project may only match by name. */
+        for (pbxproj::PBX::Target::shared_ptr const &projectTarget : project->targets()) {
+            if (reference->blueprintName() == projectTarget->name()) {
+                return projectTarget;
+            }
+        }
+    }
+
+    return target;
+}
+
+/*
+ * The jobs to run a bundle's tests. With `-only-testing`, each selected
+ * class or method is a job of its own, so they can run at the same time.
+ */
+static void
+AddJobs(std::vector<TestRunner::Job> *jobs, Bundle const &bundle, std::vector<std::string> const &onlyTesting)
+{
+    std::vector<std::string> selectors;
+    bool whole = onlyTesting.empty();
+
+    for (std::string const &identifier : onlyTesting) {
+        std::string::size_type slash = identifier.find('/');
+        if (identifier.substr(0, slash) != bundle.name) {
+            continue;
+        }
+
+        if (slash == std::string::npos) {
+            whole = true;
+        } else {
+            selectors.push_back(identifier.substr(slash + 1));
+        }
+    }
+
+    if (whole) {
+        jobs->push_back(TestRunner::Job(bundle.name, { "-XCTest", "All", bundle.path }));
+        return;
+    }
+
+    for (std::string const &selector : selectors) {
+        jobs->push_back(TestRunner::Job(bundle.name + "/" + selector, { "-XCTest", selector, bundle.path }));
+    }
+}
+
+int TestAction::
+Run(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    Options const &options,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    xcexecution::Parameters const &parameters)
+{
+    /*
+     * Run as many tests at once as requested, or one per core by default.
+     */
+    size_t workers = std::thread::hardware_concurrency();
+    if (options.parallelTestingWorkerCount()) {
+        if (*options.parallelTestingWorkerCount() <= 0) {
+            fprintf(stderr, "error: parallel testing worker count must be a positive number\n");
+            return -1;
+        }
+
+        workers = static_cast<size_t>(*options.parallelTestingWorkerCount());
+    }
+
+    ext::optional<xcexecution::SimpleExecutor::Shard> shard;
+    if (options.shard()) {
+        shard = xcexecution::SimpleExecutor::Shard::Parse(*options.shard());
+        if (!shard) {
+            fprintf(stderr, "error: invalid shard '%s', expected INDEX/COUNT\n", options.shard()->c_str());
+            return -1;
+        }
+    }
+
+    ext::optional<pbxbuild::WorkspaceContext> workspaceContext = parameters.loadWorkspace(filesystem, processContext->userName(), buildEnvironment, processContext->currentDirectory());
+    if (!workspaceContext) {
+        return -1;
+    }
+
+    ext::optional<pbxbuild::Build::Context> buildContext = parameters.createBuildContext(*workspaceContext);
+    if (!buildContext) {
+        return -1;
+    }
+
+    if (buildContext->scheme() == nullptr || buildContext->scheme()->testAction() == nullptr) {
+        fprintf(stderr, "error: testing requires a scheme with a test action\n");
+        return -1;
+    }
+
+    /*
+     * Find where each test bundle in the scheme was built.
+     */
+    std::vector<Bundle> bundles;
+    for (xcscheme::XC::TestableReference::shared_ptr const &testable : buildContext->scheme()->testAction()->testables()) {
+        if (testable->skipped()) {
+            continue;
+        }
+
+        pbxproj::PBX::Target::shared_ptr target = ResolveTestable(*buildContext, testable);
+        if (target == nullptr) {
+            fprintf(stderr, "warning: couldn't find target for testable in scheme\n");
+            continue;
+        }
+
+        if (std::find(options.skipTesting().begin(), options.skipTesting().end(), target->name()) != options.skipTesting().end()) {
+            continue;
+        }
+
+        if (!testable->skippedTests().empty()) {
+            fprintf(stderr, "warning: skipping individual tests in %s not implemented\n", target->name().c_str());
+        }
+
+        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext->targetEnvironment(buildEnvironment, target);
+        if (!targetEnvironment) {
+            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
+            return -1;
+        }
+
+        pbxsetting::Environment const &environment = targetEnvironment->environment();
+        std::string path = environment.resolve("BUILT_PRODUCTS_DIR") + "/" + environment.resolve("FULL_PRODUCT_NAME");
+        bundles.push_back({ target->name(), path, targetEnvironment->executablePaths() });
+    }
+
+    for (std::string const &identifier : options.skipTesting()) {
+        if (identifier.find('/') != std::string::npos) {
+            fprintf(stderr, "warning: skipping individual tests with -skip-testing:%s not implemented\n", identifier.c_str());
+        }
+    }
+
+    std::vector<TestRunner::Job> jobs;
+    for (Bundle const &bundle : bundles) {
+        AddJobs(&jobs, bundle, options.onlyTesting());
+    }
+
+    /*
+     * Durations from previous runs start the longest tests first, and
+     * balance the tests between shards.
+     */
+    ext::optional<std::string> historyPath;
+    TestRunner::History history;
+    if (options.testHistory()) {
+        historyPath = FSUtil::ResolveRelativePath(*options.testHistory(), processContext->currentDirectory());
+        history = TestRunner::History::Load(filesystem, *historyPath);
+    }
+
+    if (shard) {
+        std::vector<bool> selected = shard->select(TestRunner::Estimate(jobs, history));
+
+        std::vector<TestRunner::Job> shardJobs;
+        for (size_t i = 0; i < jobs.size(); i++) {
+            if (selected[i]) {
+                shardJobs.push_back(jobs[i]);
+            }
+        }
+        jobs = std::move(shardJobs);
+    }
+
+    if (jobs.empty()) {
+        fprintf(stderr, "warning: no tests to run\n");
+        return 0;
+    }
+
+    /*
+     * Find the test tool the same way the build finds its tools.
+     */
+    std::vector<std::string> executablePaths = (!bundles.empty() ? bundles.front().executablePaths : std::vector<std::string>());
+    std::vector<std::string> searchPaths = processContext->executableSearchPaths();
+    executablePaths.insert(executablePaths.end(), searchPaths.begin(), searchPaths.end());
+
+    ext::optional<std::string> xctest = filesystem->findExecutable("xctest", executablePaths);
+    if (!xctest) {
+        fprintf(stderr, "error: unable to find xctest\n");
+        return -1;
+    }
+
+    /*
+     * Print each job's output together as it finishes, so output from
+     * jobs running at the same time isn't interleaved.
+     */
+    std::vector<TestRunner::Result> results = TestRunner::Run(processLauncher, filesystem, processContext, *xctest, jobs, workers, &history, [](TestRunner::Result const &result) {
+        fputs(result.output().c_str(), stdout);
+        fprintf(stdout, "Test Suite '%s' %s (%.3f seconds)\n", result.name().c_str(), (result.success() ? "passed" : "failed"), result.duration() / 1000.0);
+        fflush(stdout);
+    });
+
+    if (historyPath && !history.save(filesystem, *historyPath)) {
+        fprintf(stderr, "warning: failed to write test history to %s\n", historyPath->c_str());
+    }
+
+    size_t failures = 0;
+    for (TestRunner::Result const &result : results) {
+        if (!result.success()) {
+            failures++;
+        }
+    }
+
+    if (failures != 0) {
+        fprintf(stdout, "** TEST FAILED ** (%zu of %zu failed)\n", failures, results.size());
+        return 1;
+    }
+
+    fprintf(stdout, "** TEST SUCCEEDED **\n");
+    return 0;
+}
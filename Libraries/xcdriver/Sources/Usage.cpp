@@ -22,7 +22,7 @@ Text(std::string const &name) {
         "[-configuration <configurationname>] "
         "[-arch <architecture>]... "
         "[-sdk [<sdkname>|<sdkpath>]] "
-        "[-showBuildSettings] [<buildsetting>=<value>]... "
+        "[-showBuildSettings [-settings <buildsetting>,...]] [<buildsetting>=<value>]... "
         "[-formatter [default]] "
         "[-executor [simple|ninja]] "
         "[-generate] "
@@ -34,7 +34,7 @@ Text(std::string const &name) {
         "[-configuration <configurationname>] "
         "[-arch <architecture>]... "
         "[-sdk [<sdkname>|<sdkpath>]] "
-        "[-showBuildSettings] "
+        "[-showBuildSettings [-settings <buildsetting>,...]] "
         "[<buildsetting>=<value>]... "
         "[-formatter [default]] "
         "[-executor [simple|ninja]] "
@@ -47,7 +47,7 @@ Text(std::string const &name) {
         "[-configuration <configurationname>] "
         "[-arch <architecture>]... "
         "[-sdk [<sdkname>|<sdkpath>]] "
-        "[-showBuildSettings] "
+        "[-showBuildSettings [-settings <buildsetting>,...]] "
         "[<buildsetting>=<value>]... "
         "[-formatter [default]] "
         "[-executor [simple|ninja]] "
@@ -61,6 +61,9 @@ Text(std::string const &name) {
     result << "       " << name << " -list "
         "[[-project <projectname>]|[-workspace <workspacename>]]" << std::endl;
 
+    result << "       " << name << " -projectIndex "
+        "[[-project <projectname>]|[-workspace <workspacename>]]" << std::endl;
+
     result << "       " << name << " -showsdks" << std::endl;
 
     result << "       " << name << " -exportArchive "
@@ -32,3 +32,12 @@ TEST(Action, VersionOverrides)
     EXPECT_EQ(Action::Determine(options), Action::Version);
 }
 
+
+TEST(Action, ProjectIndex)
+{
+    Options options;
+    auto result = libutil::Options::Parse<Options>(&options, { "-projectIndex", "-project", "App.xcodeproj" });
+    ASSERT_TRUE(result.first);
+
+    EXPECT_EQ(Action::Determine(options), Action::ProjectIndex);
+}
@@ -0,0 +1,265 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcdriver/DaemonAction.h>
+#include <xcdriver/Options.h>
+#include <libutil/DefaultFilesystem.h>
+#include <process/DefaultLauncher.h>
+#include <process/MemoryContext.h>
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using xcdriver::DaemonAction;
+using xcdriver::Options;
+using libutil::DefaultFilesystem;
+
+static process::MemoryContext
+CreateContext(std::string const &directory, std::vector<std::string> const &arguments, std::unordered_map<std::string, std::string> const &environment = { })
+{
+    return process::MemoryContext("xcbuild", directory, arguments, environment, ::getuid(), ::getgid(), "user", "group");
+}
+
+/*
+ * A socket at a path, bound but never listened on, as left behind by a
+ * daemon that exited.
+ */
+static bool
+CreateStaleSocket(std::string const &path)
+{
+    struct sockaddr_un address;
+    ::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    ::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool bound = (::bind(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) == 0);
+    ::close(fd);
+    return bound;
+}
+
+/*
+ * Read what a function writes to standard output and standard error.
+ */
+static std::string
+CaptureOutput(std::function<void()> const &function)
+{
+    FILE *file = ::tmpfile();
+
+    fflush(stdout);
+    fflush(stderr);
+    int savedOutput = ::dup(STDOUT_FILENO);
+    int savedError = ::dup(STDERR_FILENO);
+    ::dup2(::fileno(file), STDOUT_FILENO);
+    ::dup2(::fileno(file), STDERR_FILENO);
+
+    function();
+
+    fflush(stdout);
+    fflush(stderr);
+    ::dup2(savedOutput, STDOUT_FILENO);
+    ::dup2(savedError, STDERR_FILENO);
+    ::close(savedOutput);
+    ::close(savedError);
+
+    std::string output;
+    ::rewind(file);
+    for (int c; (c = ::fgetc(file)) != EOF;) {
+        output.push_back(static_cast<char>(c));
+    }
+    ::fclose(file);
+
+    return output;
+}
+
+namespace {
+
+/*
+ * A daemon serving from a child process.
+ */
+class DaemonActionTest : public ::testing::Test {
+protected:
+    std::string _directory;
+    std::string _socket;
+    pid_t       _daemon;
+
+protected:
+    DaemonActionTest() :
+        _daemon(-1)
+    {
+    }
+
+    virtual void SetUp()
+    {
+        char directory[] = "/tmp/xcdriver-daemon.XXXXXX";
+        ASSERT_NE(nullptr, ::mkdtemp(directory));
+        _directory = directory;
+        _socket = _directory + "/socket";
+    }
+
+    virtual void TearDown()
+    {
+        if (_daemon > 0) {
+            ::kill(_daemon, SIGTERM);
+            ::waitpid(_daemon, nullptr, 0);
+        }
+
+        ::unlink(_socket.c_str());
+        ::rmdir(_directory.c_str());
+    }
+
+    /*
+     * Start a daemon and wait until it accepts invocations.
+     */
+    bool startDaemon()
+    {
+        _daemon = ::fork();
+        if (_daemon == 0) {
+            int null = ::open("/dev/null", O_WRONLY);
+            ::dup2(null, STDERR_FILENO);
+            ::_exit(runDaemon());
+        } else if (_daemon < 0) {
+            return false;
+        }
+
+        for (int n = 0; n < 200; ++n) {
+            if (::access(_socket.c_str(), F_OK) == 0 && forward({ "-version" }).first) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(25));
+        }
+
+        return false;
+    }
+
+    int runDaemon()
+    {
+        Options options;
+        if (!libutil::Options::Parse<Options>(&options, { "-daemon", _socket }).first) {
+            return 1;
+        }
+
+        process::MemoryContext context = CreateContext(_directory, { "-daemon", _socket });
+        process::DefaultLauncher launcher;
+        DefaultFilesystem filesystem;
+        return DaemonAction::Run(&context, &launcher, &filesystem, options);
+    }
+
+    /*
+     * Forward an invocation to the daemon, returning its exit code and
+     * what it wrote to standard output and standard error.
+     */
+    std::pair<ext::optional<int>, std::string> forward(std::vector<std::string> const &arguments, std::unordered_map<std::string, std::string> const &environment = { })
+    {
+        process::MemoryContext context = CreateContext(_directory, arguments, environment);
+
+        ext::optional<int> exitCode;
+        std::string output = CaptureOutput([&] {
+            exitCode = DaemonAction::Forward(&context, _socket);
+        });
+
+        return std::make_pair(exitCode, output);
+    }
+};
+
+}
+
+TEST_F(DaemonActionTest, Forward)
+{
+    ASSERT_TRUE(startDaemon());
+
+    /* The invocation writes to the client's output. */
+    auto result = forward({ "-version" });
+    ASSERT_TRUE(result.first);
+    EXPECT_EQ(0, *result.first);
+    EXPECT_EQ("xcbuild version 0.1\nBuild version 1\n", result.second);
+
+    /* Later invocations are served by the same daemon. */
+    result = forward({ "-version" });
+    ASSERT_TRUE(result.first);
+    EXPECT_EQ(0, *result.first);
+}
+
+TEST_F(DaemonActionTest, ExitCode)
+{
+    ASSERT_TRUE(startDaemon());
+
+    auto result = forward({ "-unknown" });
+    ASSERT_TRUE(result.first);
+    EXPECT_EQ(1, *result.first);
+    EXPECT_EQ("error: unknown argument -unknown\n", result.second);
+
+    /* The invocation sees the client's environment, not the daemon's. */
+    result = forward({ "-projectIndex" }, { { "DEVELOPER_DIR", _directory + "/missing" } });
+    ASSERT_TRUE(result.first);
+    EXPECT_EQ(-1, *result.first);
+    EXPECT_NE(std::string::npos, result.second.find("error: couldn't create build environment\n"));
+}
+
+TEST_F(DaemonActionTest, Permissions)
+{
+    ASSERT_TRUE(startDaemon());
+
+    /* Only this user can connect to the socket. */
+    struct stat status;
+    ASSERT_EQ(0, ::stat(_socket.c_str(), &status));
+    EXPECT_EQ(static_cast<mode_t>(0600), status.st_mode & 0777);
+    EXPECT_EQ(::geteuid(), status.st_uid);
+}
+
+TEST_F(DaemonActionTest, NoDaemon)
+{
+    /* Without a daemon, invocations run in the client. */
+    EXPECT_FALSE(forward({ "-version" }).first);
+    EXPECT_FALSE(DaemonAction::Forward(nullptr, ""));
+
+    ASSERT_TRUE(CreateStaleSocket(_socket));
+    EXPECT_FALSE(forward({ "-version" }).first);
+}
+
+TEST_F(DaemonActionTest, StaleSocket)
+{
+    /* A socket left from a daemon that exited is replaced. */
+    ASSERT_TRUE(CreateStaleSocket(_socket));
+    ASSERT_TRUE(startDaemon());
+
+    auto result = forward({ "-version" });
+    ASSERT_TRUE(result.first);
+    EXPECT_EQ(0, *result.first);
+}
+
+TEST_F(DaemonActionTest, AlreadyRunning)
+{
+    ASSERT_TRUE(startDaemon());
+
+    /* A running daemon's socket isn't taken over. */
+    std::string output = CaptureOutput([&] {
+        EXPECT_EQ(1, runDaemon());
+    });
+    EXPECT_NE(std::string::npos, output.find("error: a daemon is already listening on " + _socket + "\n"));
+
+    auto result = forward({ "-version" });
+    ASSERT_TRUE(result.first);
+    EXPECT_EQ(0, *result.first);
+}
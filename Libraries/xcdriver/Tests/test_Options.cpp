@@ -39,3 +39,30 @@ TEST(Options, CaseSensitivity)
     auto result2 = libutil::Options::Parse<Options>(&invalid, { "-showbuildsettings" });
     EXPECT_FALSE(result2.first);
 }
+
+TEST(Options, ShowBuildSettingsNames)
+{
+    Options options;
+    auto result = libutil::Options::Parse<Options>(&options, { "-showBuildSettings", "-settings", "SDKROOT,BUILT_PRODUCTS_DIR", "-settings", "ARCHS" });
+    EXPECT_TRUE(result.first);
+    EXPECT_EQ(std::vector<std::string>({ "SDKROOT", "BUILT_PRODUCTS_DIR", "ARCHS" }), options.showBuildSettingsNames());
+
+    Options missing;
+    auto result2 = libutil::Options::Parse<Options>(&missing, { "-showBuildSettings", "-settings" });
+    EXPECT_FALSE(result2.first);
+}
+
+TEST(Options, Incremental)
+{
+    Options empty;
+    ASSERT_TRUE(libutil::Options::Parse<Options>(&empty, { }).first);
+    EXPECT_TRUE(empty.incremental());
+
+    Options disabled;
+    ASSERT_TRUE(libutil::Options::Parse<Options>(&disabled, { "-incremental", "-noIncremental" }).first);
+    EXPECT_FALSE(disabled.incremental());
+
+    Options enabled;
+    ASSERT_TRUE(libutil::Options::Parse<Options>(&enabled, { "-noIncremental", "-incremental" }).first);
+    EXPECT_TRUE(enabled.incremental());
+}
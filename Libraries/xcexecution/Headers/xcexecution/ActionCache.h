@@ -0,0 +1,72 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_ActionCache_h
+#define __xcexecution_ActionCache_h
+
+#include <string>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+
+namespace xcexecution {
+
+/*
+ * A local cache of the outputs of tool invocations, so an invocation that ran
+ * before with the same command and inputs, even in another checkout, can be
+ * restored instead of run again.
+ *
+ * The cache directory holds output contents by their hash, and for each key,
+ * a manifest of the outputs. The key covers the declared inputs; inputs the
+ * tool discovered while running, like included headers, are recorded in the
+ * manifest with their hash and must also match to restore.
+ */
+class ActionCache {
+private:
+    std::string _path;
+
+public:
+    explicit ActionCache(std::string const &path);
+    ~ActionCache();
+
+public:
+    /*
+     * The cache directory.
+     */
+    std::string const &path() const
+    { return _path; }
+
+public:
+    /*
+     * Restore the outputs stored for a key. Fails if nothing was stored, the
+     * outputs don't match, or a discovered input has changed. Relocatable
+     * outputs only need to match in number, and are restored to the paths
+     * given rather than the ones they were stored from.
+     */
+    bool restore(libutil::Filesystem *filesystem, std::string const &key, std::vector<std::string> const &outputs, bool relocatable = false) const;
+
+    /*
+     * Store the outputs for a key, along with the inputs discovered while
+     * creating them. Only regular file outputs can be stored.
+     */
+    bool store(libutil::Filesystem *filesystem, std::string const &key, std::vector<std::string> const &outputs, std::vector<std::string> const &discoveredInputs) const;
+
+public:
+    /*
+     * The key for a command with a set of inputs. Nothing if an input can't
+     * be read, since then the command can't be cached.
+     */
+    static ext::optional<std::string>
+    Key(libutil::Filesystem const *filesystem, std::string const &commandHash, std::vector<std::string> const &inputs);
+};
+
+}
+
+#endif // !__xcexecution_ActionCache_h
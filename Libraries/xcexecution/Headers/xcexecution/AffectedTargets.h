@@ -0,0 +1,86 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_AffectedTargets_h
+#define __xcexecution_AffectedTargets_h
+
+#include <pbxbuild/DirectedGraph.h>
+#include <pbxproj/PBX/Project.h>
+#include <pbxproj/PBX/Target.h>
+
+#include <string>
+#include <vector>
+
+namespace libutil { class Filesystem; }
+namespace pbxsetting { class Environment; }
+namespace pbxbuild { namespace Build { class Context; } }
+namespace pbxbuild { namespace Build { class Environment; } }
+namespace pbxbuild { namespace Target { class Environment; } }
+
+namespace xcexecution {
+
+/*
+ * Finds the targets affected by a set of changed paths, such as those from
+ * a version control diff, so a build can leave out the targets that can't
+ * have changed and use what an earlier build left for them.
+ */
+class AffectedTargets {
+private:
+    AffectedTargets();
+    ~AffectedTargets();
+
+public:
+    /*
+     * The paths a target is built from: the files in its build phases, and
+     * the inputs of its scripts, including those in their input file lists.
+     * A legacy target is built from its whole working directory. Paths can
+     * be folders, standing for everything in them.
+     */
+    static std::vector<std::string>
+    Inputs(
+        libutil::Filesystem const *filesystem,
+        pbxproj::PBX::Target::shared_ptr const &target,
+        pbxbuild::Target::Environment const &targetEnvironment);
+
+    /*
+     * Every file in a project's groups, including those not built by any
+     * target, such as headers.
+     */
+    static std::vector<std::string>
+    ProjectFiles(
+        pbxproj::PBX::Project::shared_ptr const &project,
+        pbxsetting::Environment const &environment);
+
+    /*
+     * If a path is one of the paths or inside one of them.
+     */
+    static bool
+    Contains(std::vector<std::string> const &paths, std::string const &path);
+
+public:
+    /*
+     * Narrow a target graph to the targets affected by the changed paths,
+     * which must be absolute, and the targets that depend on them. A target
+     * is affected if a changed path is one of its inputs. A changed file in
+     * a project's groups but in no target's inputs, like a header, affects
+     * every target in the project. A change to a loaded project, workspace,
+     * scheme or configuration file affects every target.
+     */
+    static pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>
+    Select(
+        libutil::Filesystem const *filesystem,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        pbxbuild::Build::Context const &buildContext,
+        pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+        std::vector<std::string> const &changedPaths);
+};
+
+}
+
+#endif // !__xcexecution_AffectedTargets_h
@@ -0,0 +1,110 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_BuildDatabase_h
+#define __xcexecution_BuildDatabase_h
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+
+namespace xcexecution {
+
+/*
+ * Records, for each output built, the command that built it, the inputs
+ * discovered while building it, how long it took and how much memory it
+ * used. Kept between builds to find invocations that need to run again
+ * because their command changed or an input they used, but didn't declare,
+ * was modified, to start the invocations that take longest first, and to
+ * not start more at once than fit in memory.
+ */
+class BuildDatabase {
+public:
+    class Entry {
+    private:
+        std::string              _commandHash;
+        std::vector<std::string> _inputs;
+        uint64_t                 _duration;
+        uint64_t                 _memory;
+
+    public:
+        Entry(std::string const &commandHash, std::vector<std::string> const &inputs, uint64_t duration, uint64_t memory);
+
+    public:
+        /*
+         * Fingerprint of the invocation that built the output; see
+         * `pbxbuild::Tool::Invocation::fingerprint()`.
+         */
+        std::string const &commandHash() const
+        { return _commandHash; }
+
+        /*
+         * Inputs discovered from dependency info when building the output.
+         */
+        std::vector<std::string> const &inputs() const
+        { return _inputs; }
+
+        /*
+         * How long building the output took, in milliseconds.
+         */
+        uint64_t duration() const
+        { return _duration; }
+
+        /*
+         * The most memory building the output used at once, in bytes, or
+         * zero if not known.
+         */
+        uint64_t memory() const
+        { return _memory; }
+    };
+
+private:
+    std::unordered_map<std::string, Entry> _entries;
+
+public:
+    BuildDatabase();
+    ~BuildDatabase();
+
+public:
+    /*
+     * The entry for an output, if it was built before.
+     */
+    Entry const *entry(std::string const &output) const;
+
+    /*
+     * Record how an output was built, replacing any previous entry.
+     */
+    void insert(std::string const &output, Entry const &entry);
+
+    /*
+     * Forget how an output was built, so it's built again.
+     */
+    void erase(std::string const &output);
+
+public:
+    /*
+     * Save the database to a path.
+     */
+    bool save(libutil::Filesystem *filesystem, std::string const &path) const;
+
+public:
+    /*
+     * Load a database from a path. Fails if the path can't be read or was
+     * written by a different version.
+     */
+    static ext::optional<BuildDatabase>
+    Load(libutil::Filesystem const *filesystem, std::string const &path);
+};
+
+}
+
+#endif // !__xcexecution_BuildDatabase_h
@@ -17,6 +17,7 @@
 namespace libutil { class Filesystem; }
 namespace process { class Context; }
 namespace process { class Launcher; }
+namespace process { class Cancellation; }
 
 namespace pbxbuild {
 namespace Build { class Context; }
@@ -27,6 +28,7 @@ namespace Target { class Environment; }
 namespace xcexecution {
 
 class Parameters;
+class Trace;
 
 /*
  * Abstract executor for builds. The executor is responsible for creating
@@ -38,23 +40,39 @@ protected:
     std::shared_ptr<xcformatter::Formatter> _formatter;
     bool                                    _dryRun;
     bool                                    _generate;
+    std::shared_ptr<Trace>                  _trace;
 
 protected:
-    Executor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate);
+    Executor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, std::shared_ptr<Trace> const &trace);
 
 public:
     virtual ~Executor();
 
+protected:
+    /*
+     * Start a new build session for clang modules by touching the build
+     * session file, if there is one. Modules validated before this are
+     * validated again once; after, clang trusts them for the rest of the
+     * build rather than checking their inputs in every compile.
+     */
+    bool startBuildSession(
+        libutil::Filesystem *filesystem,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        Parameters const &buildParameters) const;
+
 public:
     /*
-     * Abstract build method. Override to implement the build.
+     * Abstract build method. Override to implement the build. If given,
+     * cancelling stops the build: the tools running are stopped, and what
+     * finished is kept, so building again continues from there.
      */
     virtual bool build(
         process::Context const *processContext,
         process::Launcher *processLauncher,
         libutil::Filesystem *filesystem,
         pbxbuild::Build::Environment const &buildEnvironment,
-        Parameters const &buildParameters) = 0;
+        Parameters const &buildParameters,
+        process::Cancellation const *cancellation) = 0;
 };
 
 }
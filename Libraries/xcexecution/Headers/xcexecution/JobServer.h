@@ -0,0 +1,79 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_JobServer_h
+#define __xcexecution_JobServer_h
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace process { class Context; }
+
+namespace xcexecution {
+
+/*
+ * Shares job slots between the processes of a build, using the GNU make
+ * jobserver protocol. Each process has one implicit slot, and takes a token
+ * from the jobserver for each further job it runs at once. Under a parent
+ * make, or another build using the protocol, that parent's jobserver is
+ * used; otherwise, a new one with the build's job count is created. Either
+ * way, it's passed on to the tools run, so nested builds share it too.
+ */
+class JobServer {
+private:
+    int               _read;
+    int               _write;
+    std::vector<int>  _descriptors;
+    std::string       _makeflags;
+    std::vector<char> _tokens;
+
+private:
+    JobServer(int read, int write, std::vector<int> const &descriptors, std::string const &makeflags);
+
+public:
+    ~JobServer();
+
+public:
+    /*
+     * Take a token for another job, without waiting. Fails if none are
+     * free right now.
+     */
+    bool acquire();
+
+    /*
+     * Give back a token taken for a job that finished.
+     */
+    void release();
+
+    /*
+     * How many tokens are currently taken.
+     */
+    size_t acquired() const
+    { return _tokens.size(); }
+
+public:
+    /*
+     * The value of MAKEFLAGS that gives tools run this jobserver.
+     */
+    std::string const &makeflags() const
+    { return _makeflags; }
+
+public:
+    /*
+     * Use the jobserver named in the MAKEFLAGS of a process, if any and if
+     * it can be used. Otherwise, create one allowing `jobs` jobs at once.
+     */
+    static std::unique_ptr<JobServer>
+    Create(process::Context const *processContext, size_t jobs);
+};
+
+}
+
+#endif // !__xcexecution_JobServer_h
@@ -14,7 +14,8 @@
 #include <pbxbuild/Tool/Invocation.h>
 #include <pbxbuild/DirectedGraph.h>
 
-namespace ninja { class Writer; }
+namespace ninja { class Writer; struct Value; }
+namespace plist { class Array; }
 
 namespace xcexecution {
 
@@ -23,7 +24,59 @@ namespace xcexecution {
  */
 class NinjaExecutor : public Executor {
 public:
-    NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate);
+    /*
+     * A Ninja pool limiting how many invocations of some tools run at once,
+     * for steps like linking that need far more memory than compiling.
+     */
+    class Pool {
+    private:
+        std::string              _name;
+        int                      _depth;
+        std::vector<std::string> _tools;
+
+    public:
+        Pool(std::string const &name, int depth, std::vector<std::string> const &tools);
+
+    public:
+        /*
+         * The name of the pool in the Ninja file.
+         */
+        std::string const &name() const
+        { return _name; }
+
+        /*
+         * How many invocations in the pool can run at once.
+         */
+        int depth() const
+        { return _depth; }
+
+        /*
+         * Identifiers of the tools whose invocations run in the pool.
+         */
+        std::vector<std::string> const &tools() const
+        { return _tools; }
+
+    public:
+        /*
+         * The pool as an argument: `NAME=DEPTH:TOOL[,TOOL...]`.
+         */
+        std::string argument() const;
+
+        /*
+         * Parse a pool from an argument.
+         */
+        static ext::optional<Pool>
+        Parse(std::string const &argument);
+    };
+
+private:
+    bool                       _batchDependencyInfo;
+    ext::optional<std::string> _actionCache;
+    ext::optional<std::string> _toolLauncher;
+    std::vector<Pool>          _pools;
+
+public:
+    NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, bool batchDependencyInfo, ext::optional<std::string> const &actionCache, ext::optional<std::string> const &toolLauncher, std::vector<Pool> const &pools, std::shared_ptr<Trace> const &trace = nullptr);
     ~NinjaExecutor();
 
 public:
@@ -32,7 +85,8 @@ public:
         process::Launcher *processLauncher,
         libutil::Filesystem *filesystem,
         pbxbuild::Build::Environment const &buildEnvironment,
-        Parameters const &buildParameters);
+        Parameters const &buildParameters,
+        process::Cancellation const *cancellation);
 
 private:
     bool buildAction(
@@ -43,8 +97,11 @@ private:
         pbxbuild::Build::Context const &buildContext,
         pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
         std::string const &dependencyInfoToolPath,
+        ext::optional<std::string> const &builtinClientPath,
+        std::string const &builtinServerPath,
         std::string const &ninjaPath,
         std::string const &configurationHashPath,
+        std::string const &dependencyInfoBatchPath,
         std::string const &intermediatesDirectory);
     bool buildOutputDirectories(
         ninja::Writer *writer,
@@ -54,8 +111,11 @@ private:
         process::Context const *processContext,
         libutil::Filesystem *filesystem,
         std::string const &dependencyInfoToolPath,
+        ext::optional<std::string> const &builtinClientPath,
+        std::string const &builtinServerPath,
         pbxproj::PBX::Target::shared_ptr const &target,
         pbxbuild::Target::Environment const &targetEnvironment,
+        std::vector<pbxproj::PBX::Target::shared_ptr> const &dependencies,
         std::vector<pbxbuild::Tool::Invocation> const &invocations);
 
 private:
@@ -67,13 +127,66 @@ private:
         ninja::Writer *writer,
         pbxbuild::Tool::Invocation const &invocation,
         std::string const &executablePath,
+        ninja::Value const &command,
         std::string const &dependencyInfoToolPath,
+        ext::optional<std::string> const &actionCacheToolPath,
         std::string const &temporaryDirectory,
-        std::string const &after);
+        std::string const &after,
+        std::string const &alwaysOutOfDate,
+        plist::Array *dependencyInfoBatch);
+
+public:
+    /*
+     * If dependency info is converted for Ninja in a single pass after the
+     * build, rather than by running a tool after each invocation.
+     */
+    bool batchDependencyInfo() const
+    { return _batchDependencyInfo; }
+
+    /*
+     * The directory to cache invocation outputs in, if any. Invocations run
+     * through a tool that restores their outputs from the cache if it can.
+     */
+    ext::optional<std::string> const &actionCache() const
+    { return _actionCache; }
+
+    /*
+     * The program external tools are run through, if any.
+     */
+    ext::optional<std::string> const &toolLauncher() const
+    { return _toolLauncher; }
+
+    /*
+     * Pools limiting how many invocations of some tools run at once.
+     */
+    std::vector<Pool> const &pools() const
+    { return _pools; }
+
+public:
+    /*
+     * Identifies the configuration Ninja files are generated for: the build
+     * parameters and the executor options that change the Ninja files.
+     */
+    std::string configurationHash(Parameters const &buildParameters) const;
+
+public:
+    /*
+     * If the Ninja files must be generated before building: if asked to, or
+     * if they are missing or were generated for another configuration.
+     */
+    static bool
+    ShouldGenerate(libutil::Filesystem const *filesystem, bool generate, std::string const &configurationHash, std::string const &ninjaPath, std::string const &configurationHashPath);
+
+    /*
+     * If a target's Ninja file can be reused as it is: it exists, and was
+     * generated for the same target fingerprint.
+     */
+    static bool
+    TargetUpToDate(libutil::Filesystem const *filesystem, std::string const &targetPath, std::string const &fingerprintPath, std::string const &fingerprint);
 
 public:
     static std::unique_ptr<NinjaExecutor>
-    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate);
+    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, bool batchDependencyInfo, ext::optional<std::string> const &actionCache, ext::optional<std::string> const &toolLauncher, std::vector<Pool> const &pools = { }, std::shared_ptr<Trace> const &trace = nullptr);
 };
 
 }
@@ -10,6 +10,7 @@
 #ifndef __xcexecution_Parameters_h
 #define __xcexecution_Parameters_h
 
+#include <pbxsetting/Environment.h>
 #include <pbxsetting/Level.h>
 #include <pbxbuild/Build/Context.h>
 #include <pbxbuild/DirectedGraph.h>
@@ -35,6 +36,8 @@ private:
     ext::optional<std::string>     _scheme;
     ext::optional<std::vector<std::string>> _target;
     bool                           _allTargets;
+    bool                           _prebuiltDependencies;
+    ext::optional<std::vector<std::string>> _changedPaths;
     std::vector<std::string>       _actions;
     ext::optional<std::string>     _configuration;
     std::vector<pbxsetting::Level> _overrideLevels;
@@ -46,6 +49,8 @@ public:
         ext::optional<std::string> const &scheme,
         ext::optional<std::vector<std::string>> const &target,
         bool allTargets,
+        bool prebuiltDependencies,
+        ext::optional<std::vector<std::string>> const &changedPaths,
         std::vector<std::string> const &actions,
         ext::optional<std::string> const &configuration,
         std::vector<pbxsetting::Level> const &overrideLevels);
@@ -81,6 +86,20 @@ public:
     bool allTargets() const
     { return _allTargets; }
 
+    /*
+     * Use the products of dependencies already built instead of building
+     * them again.
+     */
+    bool prebuiltDependencies() const
+    { return _prebuiltDependencies; }
+
+    /*
+     * Only build the targets affected by these absolute paths, and those
+     * that depend on them. The other targets are left as built before.
+     */
+    ext::optional<std::vector<std::string>> const &changedPaths() const
+    { return _changedPaths; }
+
     /*
      * The specified actions to build.
      */
@@ -110,6 +129,31 @@ public:
      */
     std::string canonicalHash() const;
 
+public:
+    /*
+     * Where build-level intermediates go: OBJROOT for the workspace or
+     * project, with the build setting overrides applied. Nothing if there is
+     * no workspace or project. Doesn't load the workspace.
+     */
+    ext::optional<std::string> intermediatesDirectory(
+        libutil::Filesystem const *filesystem,
+        pbxbuild::Build::Environment const &buildEnvironment) const;
+
+    /*
+     * The file clang validates modules against once per build session:
+     * CLANG_MODULES_BUILD_SESSION_FILE, resolved like the intermediates
+     * directory. Nothing if there is no workspace or project, or if the
+     * setting is empty.
+     */
+    ext::optional<std::string> buildSessionFile(
+        libutil::Filesystem const *filesystem,
+        pbxbuild::Build::Environment const &buildEnvironment) const;
+
+private:
+    ext::optional<pbxsetting::Environment> buildLevelEnvironment(
+        libutil::Filesystem const *filesystem,
+        pbxbuild::Build::Environment const &buildEnvironment) const;
+
 public:
     /*
      * Loads the workspace from the build parameters.
@@ -127,10 +171,14 @@ public:
         pbxbuild::WorkspaceContext const &workspaceContext) const;
 
     /*
-     * Resolve inter-target dependencies.
+     * Resolve inter-target dependencies. Only the requested targets and what
+     * they depend on are included; with prebuilt dependencies, not even the
+     * dependencies whose products already exist. With changed paths, only
+     * the targets affected by them are included.
      */
     ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>>
     resolveDependencies(
+        libutil::Filesystem const *filesystem,
         pbxbuild::Build::Environment const &buildEnvironment,
         pbxbuild::Build::Context const &buildContext) const;
 };
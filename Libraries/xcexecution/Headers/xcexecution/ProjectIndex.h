@@ -0,0 +1,239 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_ProjectIndex_h
+#define __xcexecution_ProjectIndex_h
+
+#include <libutil/Filesystem.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <ext/optional>
+
+namespace pbxbuild { class WorkspaceContext; }
+namespace pbxbuild { namespace Build { class Environment; } }
+namespace pbxproj { namespace PBX { class Project; } }
+
+namespace xcexecution {
+
+/*
+ * What editors and other tools ask about projects: their targets, the files
+ * each target builds, their configurations, and the most asked for build
+ * settings. Kept next to the build outputs so it can be read without loading
+ * any project. Each project is stored with the files it was made from, and
+ * only made again when one of those changed.
+ *
+ * The index is read mapped. Finding a project is a binary search, and only
+ * the projects asked for are decoded.
+ */
+class ProjectIndex {
+public:
+    class BuildFile {
+    private:
+        std::string _path;
+        std::string _fileType;
+        std::string _phase;
+
+    public:
+        BuildFile(std::string const &path, std::string const &fileType, std::string const &phase);
+
+    public:
+        /*
+         * The resolved path of the file.
+         */
+        std::string const &path() const
+        { return _path; }
+
+        /*
+         * The identifier of the file's type, such as `sourcecode.c.objc`.
+         */
+        std::string const &fileType() const
+        { return _fileType; }
+
+        /*
+         * The build phase the file is in, such as `PBXSourcesBuildPhase`.
+         */
+        std::string const &phase() const
+        { return _phase; }
+    };
+
+    class Target {
+    private:
+        std::string                                      _name;
+        std::string                                      _productType;
+        std::vector<std::string>                         _configurations;
+        std::vector<BuildFile>                           _buildFiles;
+        std::vector<std::pair<std::string, std::string>> _settings;
+
+    public:
+        Target(
+            std::string const &name,
+            std::string const &productType,
+            std::vector<std::string> const &configurations,
+            std::vector<BuildFile> const &buildFiles,
+            std::vector<std::pair<std::string, std::string>> const &settings);
+
+    public:
+        std::string const &name() const
+        { return _name; }
+
+        /*
+         * The product type identifier, or empty for targets without one.
+         */
+        std::string const &productType() const
+        { return _productType; }
+
+        /*
+         * The names of the target's build configurations.
+         */
+        std::vector<std::string> const &configurations() const
+        { return _configurations; }
+
+        /*
+         * The files in the target's build phases, in order.
+         */
+        std::vector<BuildFile> const &buildFiles() const
+        { return _buildFiles; }
+
+        /*
+         * The values of `Settings()` in the project's default configuration,
+         * for those that could be resolved.
+         */
+        std::vector<std::pair<std::string, std::string>> const &settings() const
+        { return _settings; }
+    };
+
+    class Project {
+    private:
+        std::string                                   _path;
+        std::string                                   _name;
+        std::vector<std::string>                      _configurations;
+        std::string                                   _defaultConfiguration;
+        std::vector<std::string>                      _projectReferences;
+        std::vector<Target>                           _targets;
+        std::vector<std::pair<std::string, uint64_t>> _inputs;
+
+    public:
+        Project(
+            std::string const &path,
+            std::string const &name,
+            std::vector<std::string> const &configurations,
+            std::string const &defaultConfiguration,
+            std::vector<std::string> const &projectReferences,
+            std::vector<Target> const &targets,
+            std::vector<std::pair<std::string, uint64_t>> const &inputs);
+
+    public:
+        /*
+         * The path of the `.xcodeproj`.
+         */
+        std::string const &path() const
+        { return _path; }
+
+        std::string const &name() const
+        { return _name; }
+
+        /*
+         * The names of the project's build configurations, and the one used
+         * when none is given.
+         */
+        std::vector<std::string> const &configurations() const
+        { return _configurations; }
+        std::string const &defaultConfiguration() const
+        { return _defaultConfiguration; }
+
+        /*
+         * Paths of the projects nested in this one.
+         */
+        std::vector<std::string> const &projectReferences() const
+        { return _projectReferences; }
+
+        std::vector<Target> const &targets() const
+        { return _targets; }
+
+        /*
+         * The files the project's entry was made from, with their
+         * modification times then: the project file, its configuration
+         * files, and the SDKs its settings came from.
+         */
+        std::vector<std::pair<std::string, uint64_t>> const &inputs() const
+        { return _inputs; }
+
+    public:
+        /*
+         * If none of the inputs changed since the entry was made.
+         */
+        bool upToDate(libutil::Filesystem const *filesystem) const;
+
+    public:
+        /*
+         * Make the entry for a loaded project. Settings are resolved as when
+         * building in the project's default configuration.
+         */
+        static ext::optional<Project>
+        Create(
+            libutil::Filesystem const *filesystem,
+            pbxbuild::Build::Environment const &buildEnvironment,
+            pbxbuild::WorkspaceContext const &workspaceContext,
+            std::shared_ptr<pbxproj::PBX::Project> const &project);
+    };
+
+private:
+    std::unique_ptr<libutil::Filesystem::Mapping> _mapping;
+    uint32_t                                      _count;
+
+private:
+    explicit ProjectIndex(std::unique_ptr<libutil::Filesystem::Mapping> mapping, uint32_t count);
+
+public:
+    ~ProjectIndex();
+
+public:
+    /*
+     * The paths of the projects in the index, in order.
+     */
+    std::vector<std::string> projectPaths() const;
+
+    /*
+     * The entry for a project, if it's in the index.
+     */
+    ext::optional<Project> project(std::string const &path) const;
+
+public:
+    /*
+     * The build settings kept for each target.
+     */
+    static std::vector<std::string> const &Settings();
+
+public:
+    /*
+     * Serialize projects into an index. Projects are sorted by path; there
+     * should only be one for each path.
+     */
+    static std::vector<uint8_t> Serialize(std::vector<Project> projects);
+
+    /*
+     * Open an index without reading it all. Fails if it can't be read or was
+     * written by a different version.
+     */
+    static std::unique_ptr<ProjectIndex>
+    Open(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * Open an index from its contents, as `Open()`.
+     */
+    static std::unique_ptr<ProjectIndex>
+    Create(std::vector<uint8_t> contents);
+};
+
+}
+
+#endif // !__xcexecution_ProjectIndex_h
@@ -0,0 +1,87 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_Resident_h
+#define __xcexecution_Resident_h
+
+#include <pbxbuild/Build/Environment.h>
+#include <pbxbuild/WorkspaceContext.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+namespace process { class Context; }
+
+namespace xcexecution {
+
+/*
+ * Keeps what every build loads before it starts, the build environment and
+ * the workspace, loaded between builds in a long-running process such as the
+ * build daemon. Each is reused until a file or directory it was loaded from
+ * changes. Until enabled, everything is loaded fresh each time.
+ */
+class Resident {
+private:
+    Resident();
+    ~Resident();
+
+public:
+    /*
+     * Start keeping loaded state between builds.
+     */
+    static void
+    Enable();
+
+    /*
+     * If loaded state is kept between builds.
+     */
+    static bool
+    Enabled();
+
+public:
+    /*
+     * The default build environment for a process context. Reused for the
+     * same developer directory, user and environment variables.
+     */
+    static ext::optional<pbxbuild::Build::Environment>
+    BuildEnvironment(process::Context const *processContext, libutil::Filesystem const *filesystem);
+
+    /*
+     * What the default build environment depends on other than files: the
+     * developer directory, the user, and the environment variables.
+     */
+    static std::string
+    EnvironmentKey(process::Context const *processContext, libutil::Filesystem const *filesystem);
+
+    /*
+     * The paths that change when what the build environment is loaded from
+     * does, such as the specification, platform and SDK directories.
+     */
+    static std::vector<std::string>
+    EnvironmentPaths(process::Context const *processContext, libutil::Filesystem const *filesystem, pbxbuild::Build::Environment const &environment);
+
+    /*
+     * A workspace loaded by `load`, reused for the same key and base
+     * environment. A kept workspace has all of its projects loaded.
+     */
+    static ext::optional<pbxbuild::WorkspaceContext>
+    Workspace(
+        libutil::Filesystem const *filesystem,
+        std::string const &key,
+        pbxsetting::Environment const &baseEnvironment,
+        std::function<ext::optional<pbxbuild::WorkspaceContext>()> const &load);
+};
+
+}
+
+#endif // !__xcexecution_Resident_h
@@ -13,18 +13,91 @@
 #include <xcexecution/Executor.h>
 #include <builtin/Registry.h>
 
+#include <string>
+#include <unordered_set>
+
 namespace xcexecution {
 
+class BuildDatabase;
+
 /*
- * Simple executor that simply runs invocations in sequence. Advanced features
- * like incremental builds, dependency info, and such are not supported.
+ * Simple executor that runs invocations as soon as the invocations they
+ * depend on have finished, with at most `jobs` external tools running at
+ * once. With `parallelizeTargets`, targets without dependencies between them
+ * also build at the same time, sharing the same job limit. With
+ * `incremental`, invocations with outputs newer than all of their inputs,
+ * including those in dependency info, are skipped unless their command has
+ * changed since the last build, as recorded in a build database. With an
+ * `actionCache`, outputs of invocations that ran before with the same
+ * command and inputs are restored from the cache instead. With a
+ * `toolLauncher`, external tools run through that program, which can run
+ * them elsewhere, such as on a remote execution service. With a `shard`,
+ * only that shard's targets and the targets they depend on are built.
  */
 class SimpleExecutor : public Executor {
+public:
+    /*
+     * One of several machines splitting up a build. Targets are divided
+     * between shards by how long they took to build before, and each shard
+     * builds its own targets and the targets they depend on. With an action
+     * cache shared between the machines, dependencies built by one shard are
+     * restored by the others instead of built again, and a final build
+     * without a shard restores every target to assemble the products.
+     */
+    class Shard {
+    private:
+        size_t _index;
+        size_t _count;
+
+    public:
+        Shard(size_t index, size_t count);
+
+    public:
+        /*
+         * Which shard this is, counting from one.
+         */
+        size_t index() const
+        { return _index; }
+
+        /*
+         * How many shards the build is split into.
+         */
+        size_t count() const
+        { return _count; }
+
+    public:
+        /*
+         * Divide items between the shards, balancing their total cost, and
+         * return which of them are in this shard. The same costs always
+         * divide the same way, so every shard agrees on the division.
+         */
+        std::vector<bool> select(std::vector<uint64_t> const &costs) const;
+
+    public:
+        /*
+         * The shard as an argument: `INDEX/COUNT`.
+         */
+        std::string argument() const;
+
+        /*
+         * Parse a shard from an argument.
+         */
+        static ext::optional<Shard>
+        Parse(std::string const &argument);
+    };
+
 private:
-    builtin::Registry _builtins;
+    builtin::Registry          _builtins;
+    size_t                     _jobs;
+    bool                       _parallelizeTargets;
+    bool                       _incremental;
+    ext::optional<std::string> _actionCache;
+    ext::optional<std::string> _toolLauncher;
+    ext::optional<Shard>       _shard;
+    ext::optional<double>      _loadAverage;
 
 public:
-    SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins);
+    SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs, bool parallelizeTargets, bool incremental, ext::optional<std::string> const &actionCache, ext::optional<std::string> const &toolLauncher, ext::optional<Shard> const &shard = ext::nullopt, std::shared_ptr<Trace> const &trace = nullptr, ext::optional<double> const &loadAverage = ext::nullopt);
     ~SimpleExecutor();
 
 public:
@@ -33,11 +106,56 @@ public:
         process::Launcher *processLauncher,
         libutil::Filesystem *filesystem,
         pbxbuild::Build::Environment const &buildEnvironment,
-        Parameters const &buildParameters);
+        Parameters const &buildParameters,
+        process::Cancellation const *cancellation);
+
+public:
+    /*
+     * The maximum number of invocations run at the same time.
+     */
+    size_t jobs() const
+    { return _jobs; }
+
+    /*
+     * If independent targets are built at the same time.
+     */
+    bool parallelizeTargets() const
+    { return _parallelizeTargets; }
+
+    /*
+     * If up to date invocations are skipped.
+     */
+    bool incremental() const
+    { return _incremental; }
+
+    /*
+     * The directory to cache invocation outputs in, if any.
+     */
+    ext::optional<std::string> const &actionCache() const
+    { return _actionCache; }
+
+    /*
+     * The program external tools are run through, if any.
+     */
+    ext::optional<std::string> const &toolLauncher() const
+    { return _toolLauncher; }
+
+    /*
+     * The part of the build to do, if not all of it.
+     */
+    ext::optional<Shard> const &shard() const
+    { return _shard; }
+
+    /*
+     * The load average at which no more tools are started, if any.
+     */
+    ext::optional<double> const &loadAverage() const
+    { return _loadAverage; }
 
 public:
     bool writeAuxiliaryFiles(
         libutil::Filesystem *filesystem,
+        std::unordered_set<std::string> *directories,
         pbxproj::PBX::Target::shared_ptr const &target,
         pbxbuild::Target::Environment const &targetEnvironment,
         std::vector<pbxbuild::Tool::Invocation> const &invocations);
@@ -47,18 +165,13 @@ public:
         libutil::Filesystem *filesystem,
         std::vector<std::string> const &executablePaths,
         std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
-        bool createProductStructure);
-    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> buildTarget(
-        process::Context const *processContext,
-        process::Launcher *processLauncher,
-        libutil::Filesystem *filesystem,
-        pbxproj::PBX::Target::shared_ptr const &target,
-        pbxbuild::Target::Environment const &targetEnvironment,
-        std::vector<pbxbuild::Tool::Invocation> const &invocations);
+        bool createProductStructure,
+        BuildDatabase *database,
+        process::Cancellation const *cancellation = nullptr);
 
 public:
     static std::unique_ptr<SimpleExecutor>
-    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins);
+    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs, bool parallelizeTargets, bool incremental, ext::optional<std::string> const &actionCache, ext::optional<std::string> const &toolLauncher, ext::optional<Shard> const &shard = ext::nullopt, std::shared_ptr<Trace> const &trace = nullptr, ext::optional<double> const &loadAverage = ext::nullopt);
 };
 
 }
@@ -0,0 +1,59 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_TargetFingerprint_h
+#define __xcexecution_TargetFingerprint_h
+
+#include <pbxproj/PBX/Target.h>
+
+#include <string>
+#include <vector>
+
+namespace libutil { class Filesystem; }
+namespace pbxbuild { namespace Target { class Environment; } }
+
+namespace xcexecution {
+
+/*
+ * Identifies everything planning a target's invocations depends on, so
+ * executors can skip planning a target when nothing it's planned from has
+ * changed since the last build.
+ */
+class TargetFingerprint {
+private:
+    TargetFingerprint();
+    ~TargetFingerprint();
+
+public:
+    /*
+     * Identifies the executable planning the build. A new executable could
+     * plan targets differently.
+     */
+    static std::string
+    Generator(std::string const &executablePath);
+
+    /*
+     * Fingerprint a target: the generator, the target's build settings, its
+     * build phases and the files in them, and the names of the targets it
+     * depends on. Script file lists are read for the fingerprint; those
+     * that exist are added to `fileLists`.
+     */
+    static std::string
+    Create(
+        libutil::Filesystem const *filesystem,
+        std::string const &generator,
+        pbxproj::PBX::Target::shared_ptr const &target,
+        pbxbuild::Target::Environment const &targetEnvironment,
+        std::vector<pbxproj::PBX::Target::shared_ptr> const &dependencies,
+        std::vector<std::string> *fileLists);
+};
+
+}
+
+#endif // !__xcexecution_TargetFingerprint_h
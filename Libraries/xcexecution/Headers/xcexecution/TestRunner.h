@@ -0,0 +1,180 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_TestRunner_h
+#define __xcexecution_TestRunner_h
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+namespace process { class Context; }
+namespace process { class Launcher; }
+
+namespace xcexecution {
+
+/*
+ * Runs tests in several processes at once. Each job is one process, such
+ * as a test bundle or part of one. Jobs that took longest when they last
+ * ran are started first, and each process that finishes takes the next,
+ * so the last jobs to finish are the shortest.
+ */
+class TestRunner {
+public:
+    /*
+     * Tests run in one process.
+     */
+    class Job {
+    private:
+        std::string              _name;
+        std::vector<std::string> _arguments;
+
+    public:
+        Job(std::string const &name, std::vector<std::string> const &arguments);
+
+    public:
+        /*
+         * Identifies the job across runs, such as `Bundle/Class`.
+         */
+        std::string const &name() const
+        { return _name; }
+
+        /*
+         * The arguments to the test tool.
+         */
+        std::vector<std::string> const &arguments() const
+        { return _arguments; }
+    };
+
+    /*
+     * A job that has finished.
+     */
+    class Result {
+    private:
+        std::string        _name;
+        ext::optional<int> _exitCode;
+        std::string        _output;
+        uint64_t           _duration;
+
+    public:
+        Result(std::string const &name, ext::optional<int> const &exitCode, std::string const &output, uint64_t duration);
+
+    public:
+        /*
+         * The name of the job.
+         */
+        std::string const &name() const
+        { return _name; }
+
+        /*
+         * The exit code of the process, if it ran and exited normally.
+         */
+        ext::optional<int> const &exitCode() const
+        { return _exitCode; }
+
+        /*
+         * Standard output and standard error of the process.
+         */
+        std::string const &output() const
+        { return _output; }
+
+        /*
+         * How long the job ran, in milliseconds.
+         */
+        uint64_t duration() const
+        { return _duration; }
+
+        /*
+         * If all of the job's tests passed.
+         */
+        bool success() const
+        { return _exitCode && *_exitCode == 0; }
+    };
+
+    /*
+     * How long jobs took the last time they ran.
+     */
+    class History {
+    private:
+        std::unordered_map<std::string, uint64_t> _durations;
+
+    public:
+        History();
+
+    public:
+        /*
+         * The last duration of a job, in milliseconds, if it has run.
+         */
+        ext::optional<uint64_t> duration(std::string const &name) const;
+
+        /*
+         * Note how long a job took.
+         */
+        void record(std::string const &name, uint64_t duration);
+
+    public:
+        /*
+         * Write the history, one job per line.
+         */
+        std::string serialize() const;
+
+        /*
+         * Read a history. Lines that can't be read are skipped.
+         */
+        static History
+        Deserialize(std::string const &contents);
+
+    public:
+        /*
+         * Load the history from a file. A missing file is an empty history.
+         */
+        static History
+        Load(libutil::Filesystem const *filesystem, std::string const &path);
+
+        /*
+         * Save the history to a file.
+         */
+        bool save(libutil::Filesystem *filesystem, std::string const &path) const;
+    };
+
+private:
+    TestRunner();
+    ~TestRunner();
+
+public:
+    /*
+     * The expected duration of each job. Jobs that haven't run before are
+     * assumed to be as long as the longest that has, so they start early.
+     */
+    static std::vector<uint64_t>
+    Estimate(std::vector<Job> const &jobs, History const &history);
+
+    /*
+     * Run jobs with a test tool, up to a number of processes at once. The
+     * callback is called as each job finishes, and its duration recorded
+     * in the history. Results are in the same order as the jobs.
+     */
+    static std::vector<Result>
+    Run(
+        process::Launcher *processLauncher,
+        libutil::Filesystem *filesystem,
+        process::Context const *processContext,
+        std::string const &executable,
+        std::vector<Job> const &jobs,
+        size_t workers,
+        History *history,
+        std::function<void(Result const &)> const &finished);
+};
+
+}
+
+#endif // !__xcexecution_TestRunner_h
@@ -0,0 +1,107 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcexecution_Trace_h
+#define __xcexecution_Trace_h
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <cstdint>
+
+namespace libutil { class Filesystem; }
+
+namespace xcexecution {
+
+/*
+ * Records how long the steps of a build take, to be written out in the
+ * Chrome trace event format that `chrome://tracing` and Perfetto load.
+ * Steps of the build itself are shown on a track for the thread they ran
+ * on; tool invocations are shown on a track for the job that ran them.
+ * Steps can be recorded from multiple threads.
+ */
+class Trace {
+public:
+    using Arguments = std::vector<std::pair<std::string, std::string>>;
+
+    /*
+     * Records a step of the build from creation until destruction. Does
+     * nothing without a trace.
+     */
+    class Span {
+    private:
+        Trace      *_trace;
+        std::string _name;
+        std::string _category;
+        Arguments   _arguments;
+        uint64_t    _start;
+
+    public:
+        Span(Trace *trace, std::string const &name, std::string const &category, Arguments const &arguments = Arguments());
+        ~Span();
+
+    public:
+        Span(Span const &) = delete;
+        Span &operator=(Span const &) = delete;
+    };
+
+private:
+    struct Event {
+        std::string name;
+        std::string category;
+        uint64_t    start;
+        uint64_t    duration;
+        bool        invocation;
+        uint32_t    lane;
+        Arguments   arguments;
+    };
+
+private:
+    std::chrono::steady_clock::time_point          _start;
+    std::vector<Event>                             _events;
+    std::unordered_map<std::thread::id, uint32_t> _threads;
+    mutable std::mutex                             _mutex;
+
+public:
+    Trace();
+    ~Trace();
+
+public:
+    /*
+     * Microseconds since the trace was created.
+     */
+    uint64_t now() const;
+
+public:
+    /*
+     * Record a step of the build that ran on the current thread.
+     */
+    void step(std::string const &name, std::string const &category, uint64_t start, uint64_t end, Arguments const &arguments);
+
+    /*
+     * Record a tool invocation, run by one of the build's jobs. Jobs are
+     * numbered from zero, and run one invocation at a time.
+     */
+    void invocation(std::string const &name, uint32_t job, uint64_t start, uint64_t end, Arguments const &arguments);
+
+public:
+    /*
+     * Write the trace as JSON.
+     */
+    bool write(libutil::Filesystem *filesystem, std::string const &path) const;
+};
+
+}
+
+#endif // !__xcexecution_Trace_h
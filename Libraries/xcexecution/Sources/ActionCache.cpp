@@ -0,0 +1,262 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/ActionCache.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/md5.h>
+
+#include <cstdlib>
+#include <sstream>
+#include <iomanip>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+using xcexecution::ActionCache;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+/*
+ * A manifest is a header line, the number of discovered inputs, then each
+ * input's path and hash, then the number of outputs, then each output's
+ * path, hash, and if it's executable, all on separate lines.
+ */
+static char const ManifestHeader[] = "# xcbuild action 1";
+
+namespace {
+
+struct ManifestFile {
+    std::string path;
+    std::string hash;
+    bool        executable;
+};
+
+}
+
+ActionCache::
+ActionCache(std::string const &path) :
+    _path(path)
+{
+}
+
+ActionCache::
+~ActionCache()
+{
+}
+
+static std::string
+Hash(std::vector<uint8_t> const &contents)
+{
+    md5_state_t state;
+    md5_init(&state);
+    md5_append(&state, reinterpret_cast<const md5_byte_t *>(contents.data()), contents.size());
+    uint8_t digest[16];
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        ss << std::setw(2) << static_cast<int>(c);
+    }
+
+    return ss.str();
+}
+
+static ext::optional<std::string>
+FileHash(Filesystem const *filesystem, std::string const &path)
+{
+    if (filesystem->isDirectory(path)) {
+        return ext::nullopt;
+    }
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return ext::nullopt;
+    }
+
+    return Hash(contents);
+}
+
+static std::string
+ManifestPath(std::string const &cache, std::string const &key)
+{
+    return cache + "/actions/" + key;
+}
+
+static std::string
+ObjectPath(std::string const &cache, std::string const &hash)
+{
+    return cache + "/objects/" + hash;
+}
+
+static bool
+ReadFiles(std::istringstream *stream, bool executable, std::vector<ManifestFile> *files)
+{
+    std::string count;
+    if (!std::getline(*stream, count) || count.empty()) {
+        return false;
+    }
+
+    char *end = nullptr;
+    unsigned long fileCount = std::strtoul(count.c_str(), &end, 10);
+    if (*end != '\0') {
+        return false;
+    }
+
+    for (unsigned long i = 0; i < fileCount; ++i) {
+        ManifestFile file;
+        if (!std::getline(*stream, file.path) || !std::getline(*stream, file.hash)) {
+            return false;
+        }
+
+        file.executable = false;
+        if (executable) {
+            std::string value;
+            if (!std::getline(*stream, value)) {
+                return false;
+            }
+            file.executable = (value == "1");
+        }
+
+        files->push_back(file);
+    }
+
+    return true;
+}
+
+bool ActionCache::
+restore(Filesystem *filesystem, std::string const &key, std::vector<std::string> const &outputs, bool relocatable) const
+{
+    std::vector<uint8_t> manifest;
+    if (!filesystem->read(&manifest, ManifestPath(_path, key))) {
+        return false;
+    }
+
+    std::istringstream stream(std::string(manifest.begin(), manifest.end()));
+
+    std::string header;
+    std::vector<ManifestFile> inputFiles;
+    std::vector<ManifestFile> outputFiles;
+    if (!std::getline(stream, header) || header != ManifestHeader || !ReadFiles(&stream, false, &inputFiles) || !ReadFiles(&stream, true, &outputFiles)) {
+        return false;
+    }
+
+    if (outputFiles.size() != outputs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        if (relocatable) {
+            outputFiles[i].path = outputs[i];
+        } else if (outputFiles[i].path != outputs[i]) {
+            return false;
+        }
+    }
+
+    /*
+     * Discovered inputs aren't part of the key, so check them here.
+     */
+    for (ManifestFile const &input : inputFiles) {
+        ext::optional<std::string> hash = FileHash(filesystem, input.path);
+        if (!hash || *hash != input.hash) {
+            return false;
+        }
+    }
+
+    /*
+     * Read everything before writing, so a missing or damaged object does
+     * not leave only some of the outputs restored.
+     */
+    std::vector<std::vector<uint8_t>> contents = std::vector<std::vector<uint8_t>>(outputFiles.size());
+    for (size_t i = 0; i < outputFiles.size(); ++i) {
+        if (!filesystem->read(&contents[i], ObjectPath(_path, outputFiles[i].hash)) || Hash(contents[i]) != outputFiles[i].hash) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < outputFiles.size(); ++i) {
+        ManifestFile const &output = outputFiles[i];
+
+        if (!filesystem->createDirectory(FSUtil::GetDirectoryName(output.path)) || !filesystem->write(contents[i], output.path)) {
+            return false;
+        }
+
+        if (output.executable && !filesystem->isExecutable(output.path)) {
+            // FIXME: This should use the filesystem.
+            if (::chmod(output.path.c_str(), S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) != 0) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ActionCache::
+store(Filesystem *filesystem, std::string const &key, std::vector<std::string> const &outputs, std::vector<std::string> const &discoveredInputs) const
+{
+    std::string manifest = std::string(ManifestHeader) + "\n";
+
+    manifest += std::to_string(discoveredInputs.size()) + "\n";
+    for (std::string const &input : discoveredInputs) {
+        ext::optional<std::string> hash = FileHash(filesystem, input);
+        if (!hash) {
+            return false;
+        }
+
+        manifest += input + "\n";
+        manifest += *hash + "\n";
+    }
+
+    if (!filesystem->createDirectory(_path + "/objects") || !filesystem->createDirectory(_path + "/actions")) {
+        return false;
+    }
+
+    manifest += std::to_string(outputs.size()) + "\n";
+    for (std::string const &output : outputs) {
+        if (filesystem->isDirectory(output)) {
+            return false;
+        }
+
+        std::vector<uint8_t> contents;
+        if (!filesystem->read(&contents, output)) {
+            return false;
+        }
+
+        /* Objects are named by their contents, so existing ones are the same. */
+        std::string hash = Hash(contents);
+        std::string objectPath = ObjectPath(_path, hash);
+        if (!filesystem->exists(objectPath) && !filesystem->write(contents, objectPath)) {
+            return false;
+        }
+
+        manifest += output + "\n";
+        manifest += hash + "\n";
+        manifest += std::string(filesystem->isExecutable(output) ? "1" : "0") + "\n";
+    }
+
+    /* Written last, so the objects it lists are always there. */
+    return filesystem->write(std::vector<uint8_t>(manifest.begin(), manifest.end()), ManifestPath(_path, key));
+}
+
+ext::optional<std::string> ActionCache::
+Key(Filesystem const *filesystem, std::string const &commandHash, std::vector<std::string> const &inputs)
+{
+    std::string key = commandHash + "\n";
+    for (std::string const &input : inputs) {
+        ext::optional<std::string> hash = FileHash(filesystem, input);
+        if (!hash) {
+            return ext::nullopt;
+        }
+
+        key += input + "\n" + *hash + "\n";
+    }
+
+    return Hash(std::vector<uint8_t>(key.begin(), key.end()));
+}
@@ -0,0 +1,220 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/AffectedTargets.h>
+#include <pbxbuild/Build/Context.h>
+#include <pbxbuild/Target/Environment.h>
+#include <pbxbuild/Tool/ScriptResolver.h>
+#include <pbxbuild/WorkspaceContext.h>
+#include <pbxproj/PBX/BaseGroup.h>
+#include <pbxproj/PBX/LegacyTarget.h>
+#include <pbxproj/PBX/ShellScriptBuildPhase.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Statistic.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+using xcexecution::AffectedTargets;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::Statistic;
+
+static Statistic UnaffectedTargets("xcexecution", "Targets unaffected by changes");
+
+AffectedTargets::
+AffectedTargets()
+{
+}
+
+AffectedTargets::
+~AffectedTargets()
+{
+}
+
+static void
+AppendFiles(std::vector<std::string> *paths, pbxsetting::Environment const &environment, pbxproj::PBX::GroupItem::shared_ptr const &item)
+{
+    if (item == nullptr) {
+        return;
+    }
+
+    switch (item->type()) {
+        case pbxproj::PBX::GroupItem::Type::FileReference:
+            paths->push_back(FSUtil::NormalizePath(environment.expand(item->resolve())));
+            break;
+        case pbxproj::PBX::GroupItem::Type::Group:
+        case pbxproj::PBX::GroupItem::Type::VariantGroup:
+        case pbxproj::PBX::GroupItem::Type::VersionGroup: {
+            auto group = std::static_pointer_cast<pbxproj::PBX::BaseGroup>(item);
+            for (pbxproj::PBX::GroupItem::shared_ptr const &child : group->children()) {
+                AppendFiles(paths, environment, child);
+            }
+            break;
+        }
+        case pbxproj::PBX::GroupItem::Type::ReferenceProxy:
+            /* Built by another project; that target is a dependency. */
+            break;
+    }
+}
+
+std::vector<std::string> AffectedTargets::
+Inputs(
+    Filesystem const *filesystem,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    pbxbuild::Target::Environment const &targetEnvironment)
+{
+    pbxsetting::Environment const &environment = targetEnvironment.environment();
+    std::string const &workingDirectory = targetEnvironment.workingDirectory();
+
+    std::vector<std::string> inputs;
+
+    if (target->type() == pbxproj::PBX::Target::Type::Legacy) {
+        auto legacyTarget = std::static_pointer_cast<pbxproj::PBX::LegacyTarget>(target);
+        inputs.push_back(FSUtil::NormalizePath(FSUtil::ResolveRelativePath(environment.expand(pbxsetting::Value::Parse(legacyTarget->buildWorkingDirectory())), workingDirectory)));
+    }
+
+    for (pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase : target->buildPhases()) {
+        for (pbxproj::PBX::BuildFile::shared_ptr const &buildFile : buildPhase->files()) {
+            AppendFiles(&inputs, environment, buildFile->fileRef());
+        }
+
+        if (buildPhase->type() == pbxproj::PBX::BuildPhase::Type::ShellScript) {
+            auto shellScriptBuildPhase = std::static_pointer_cast<pbxproj::PBX::ShellScriptBuildPhase>(buildPhase);
+            for (pbxsetting::Value const &inputPath : shellScriptBuildPhase->inputPaths()) {
+                inputs.push_back(FSUtil::NormalizePath(FSUtil::ResolveRelativePath(environment.expand(inputPath), workingDirectory)));
+            }
+
+            for (pbxsetting::Value const &fileListPath : shellScriptBuildPhase->inputFileListPaths()) {
+                std::string path = FSUtil::NormalizePath(FSUtil::ResolveRelativePath(environment.expand(fileListPath), workingDirectory));
+                inputs.push_back(path);
+
+                if (ext::optional<std::vector<std::string>> paths = pbxbuild::Tool::ScriptResolver::FileListPaths(filesystem, environment, workingDirectory, path)) {
+                    for (std::string const &listedPath : *paths) {
+                        inputs.push_back(FSUtil::NormalizePath(listedPath));
+                    }
+                }
+            }
+        }
+    }
+
+    return inputs;
+}
+
+std::vector<std::string> AffectedTargets::
+ProjectFiles(
+    pbxproj::PBX::Project::shared_ptr const &project,
+    pbxsetting::Environment const &environment)
+{
+    std::vector<std::string> files;
+    AppendFiles(&files, environment, project->mainGroup());
+    return files;
+}
+
+bool AffectedTargets::
+Contains(std::vector<std::string> const &paths, std::string const &path)
+{
+    return std::any_of(paths.begin(), paths.end(), [&](std::string const &other) {
+        return path.compare(0, other.size(), other) == 0 && (path.size() == other.size() || path[other.size()] == '/');
+    });
+}
+
+pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> AffectedTargets::
+Select(
+    Filesystem const *filesystem,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    pbxbuild::Build::Context const &buildContext,
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    std::vector<std::string> const &changedPaths)
+{
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &targets = targetGraph.nodes();
+
+    std::vector<size_t> all;
+    for (size_t index = 0; index < targets.size(); ++index) {
+        all.push_back(index);
+    }
+
+    /*
+     * The files loaded to find the targets decide what they are.
+     */
+    std::vector<std::string> loadedFilePaths = buildContext.workspaceContext().loadedFilePaths();
+    for (std::string &path : loadedFilePaths) {
+        path = FSUtil::NormalizePath(path);
+    }
+    for (std::string const &changedPath : changedPaths) {
+        if (std::find(loadedFilePaths.begin(), loadedFilePaths.end(), changedPath) != loadedFilePaths.end()) {
+            return targetGraph.dependents(all);
+        }
+    }
+
+    std::vector<size_t> affected;
+    std::vector<bool> claimed = std::vector<bool>(changedPaths.size(), false);
+
+    for (size_t index = 0; index < targets.size(); ++index) {
+        pbxproj::PBX::Target::shared_ptr const &target = targets[index];
+
+        /* Without its settings, there's no telling what the target is built from. */
+        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
+        if (!targetEnvironment) {
+            affected.push_back(index);
+            continue;
+        }
+
+        std::vector<std::string> inputs = Inputs(filesystem, target, *targetEnvironment);
+
+        bool changed = false;
+        for (size_t i = 0; i < changedPaths.size(); ++i) {
+            if (Contains(inputs, changedPaths[i])) {
+                claimed[i] = true;
+                changed = true;
+            }
+        }
+
+        if (changed) {
+            affected.push_back(index);
+        }
+    }
+
+    /*
+     * A changed file no target builds, like a header, could be used by any
+     * target in the project it's in.
+     */
+    std::unordered_map<pbxproj::PBX::Project::shared_ptr, bool> projectsChanged;
+    for (size_t index = 0; index < targets.size(); ++index) {
+        pbxproj::PBX::Target::shared_ptr const &target = targets[index];
+        pbxproj::PBX::Project::shared_ptr project = target->project();
+        if (project == nullptr) {
+            continue;
+        }
+
+        auto it = projectsChanged.find(project);
+        if (it == projectsChanged.end()) {
+            bool changed = false;
+            if (ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target)) {
+                std::vector<std::string> files = ProjectFiles(project, targetEnvironment->environment());
+                for (size_t i = 0; i < changedPaths.size(); ++i) {
+                    if (!claimed[i] && Contains(files, changedPaths[i])) {
+                        changed = true;
+                    }
+                }
+            }
+            it = projectsChanged.insert({ project, changed }).first;
+        }
+
+        if (it->second) {
+            affected.push_back(index);
+        }
+    }
+
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> selected = targetGraph.dependents(affected);
+    for (size_t i = selected.nodes().size(); i < targets.size(); ++i) {
+        UnaffectedTargets.increment();
+    }
+    return selected;
+}
@@ -0,0 +1,154 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/BuildDatabase.h>
+#include <libutil/Filesystem.h>
+
+#include <cstdlib>
+#include <map>
+#include <sstream>
+
+using xcexecution::BuildDatabase;
+using libutil::Filesystem;
+
+/*
+ * The database is a header line, then for each output: the output path, the
+ * invocation fingerprint, the duration, the memory used, the number of inputs, and
+ * each input, all on separate lines.
+ */
+static char const DatabaseHeader[] = "# xcbuild database 4";
+
+static ext::optional<unsigned long long>
+ParseNumber(std::string const &value)
+{
+    char *end = nullptr;
+    unsigned long long number = std::strtoull(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0') {
+        return ext::nullopt;
+    }
+
+    return number;
+}
+
+BuildDatabase::Entry::
+Entry(std::string const &commandHash, std::vector<std::string> const &inputs, uint64_t duration, uint64_t memory) :
+    _commandHash(commandHash),
+    _inputs     (inputs),
+    _duration   (duration),
+    _memory     (memory)
+{
+}
+
+BuildDatabase::
+BuildDatabase()
+{
+}
+
+BuildDatabase::
+~BuildDatabase()
+{
+}
+
+BuildDatabase::Entry const *BuildDatabase::
+entry(std::string const &output) const
+{
+    auto it = _entries.find(output);
+    if (it == _entries.end()) {
+        return nullptr;
+    }
+
+    return &it->second;
+}
+
+void BuildDatabase::
+insert(std::string const &output, Entry const &entry)
+{
+    _entries.erase(output);
+    _entries.insert({ output, entry });
+}
+
+void BuildDatabase::
+erase(std::string const &output)
+{
+    _entries.erase(output);
+}
+
+bool BuildDatabase::
+save(Filesystem *filesystem, std::string const &path) const
+{
+    std::string contents = std::string(DatabaseHeader) + "\n";
+
+    /* Sort so unchanged databases save identically. */
+    std::map<std::string, Entry const *> entries;
+    for (auto const &entry : _entries) {
+        entries.insert({ entry.first, &entry.second });
+    }
+
+    for (auto const &entry : entries) {
+        contents += entry.first + "\n";
+        contents += entry.second->commandHash() + "\n";
+        contents += std::to_string(entry.second->duration()) + "\n";
+        contents += std::to_string(entry.second->memory()) + "\n";
+        contents += std::to_string(entry.second->inputs().size()) + "\n";
+        for (std::string const &input : entry.second->inputs()) {
+            contents += input + "\n";
+        }
+    }
+
+    return filesystem->write(std::vector<uint8_t>(contents.begin(), contents.end()), path);
+}
+
+ext::optional<BuildDatabase> BuildDatabase::
+Load(Filesystem const *filesystem, std::string const &path)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return ext::nullopt;
+    }
+
+    std::istringstream stream(std::string(contents.begin(), contents.end()));
+
+    std::string line;
+    if (!std::getline(stream, line) || line != DatabaseHeader) {
+        return ext::nullopt;
+    }
+
+    BuildDatabase database;
+
+    std::string output;
+    while (std::getline(stream, output)) {
+        std::string commandHash;
+        std::string duration;
+        std::string memory;
+        std::string count;
+        if (!std::getline(stream, commandHash) || !std::getline(stream, duration) || !std::getline(stream, memory) || !std::getline(stream, count)) {
+            return ext::nullopt;
+        }
+
+        ext::optional<unsigned long long> durationValue = ParseNumber(duration);
+        ext::optional<unsigned long long> memoryValue = ParseNumber(memory);
+        ext::optional<unsigned long long> inputCount = ParseNumber(count);
+        if (!durationValue || !memoryValue || !inputCount) {
+            return ext::nullopt;
+        }
+
+        std::vector<std::string> inputs;
+        for (unsigned long long i = 0; i < *inputCount; ++i) {
+            std::string input;
+            if (!std::getline(stream, input)) {
+                return ext::nullopt;
+            }
+            inputs.push_back(input);
+        }
+
+        database.insert(output, Entry(commandHash, inputs, static_cast<uint64_t>(*durationValue), static_cast<uint64_t>(*memoryValue)));
+    }
+
+    return database;
+}
@@ -8,14 +8,21 @@
  */
 
 #include <xcexecution/Executor.h>
+#include <xcexecution/Parameters.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
 
 using xcexecution::Executor;
+using xcexecution::Parameters;
+using libutil::Filesystem;
+using libutil::FSUtil;
 
 Executor::
-Executor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate) :
+Executor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, std::shared_ptr<Trace> const &trace) :
     _formatter(formatter),
     _dryRun   (dryRun),
-    _generate (generate)
+    _generate (generate),
+    _trace    (trace)
 {
 }
 
@@ -23,3 +30,23 @@ Executor::
 ~Executor()
 {
 }
+
+bool Executor::
+startBuildSession(
+    Filesystem *filesystem,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    Parameters const &buildParameters) const
+{
+    ext::optional<std::string> path = buildParameters.buildSessionFile(filesystem, buildEnvironment);
+    if (!path) {
+        return true;
+    }
+
+    /* Rewriting the file updates its modification time, which is the session. */
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(*path)) || !filesystem->write(std::vector<uint8_t>(), *path)) {
+        fprintf(stderr, "error: unable to write build session file %s\n", path->c_str());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,182 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/JobServer.h>
+#include <process/Context.h>
+
+#include <ext/optional>
+
+#include <cerrno>
+#include <cstdlib>
+#include <sstream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+using xcexecution::JobServer;
+
+JobServer::
+JobServer(int read, int write, std::vector<int> const &descriptors, std::string const &makeflags) :
+    _read       (read),
+    _write      (write),
+    _descriptors(descriptors),
+    _makeflags  (makeflags)
+{
+}
+
+JobServer::
+~JobServer()
+{
+    /* Tokens not given back would be lost to the whole build. */
+    while (!_tokens.empty()) {
+        release();
+    }
+
+    for (int descriptor : _descriptors) {
+        ::close(descriptor);
+    }
+}
+
+bool JobServer::
+acquire()
+{
+    /*
+     * Other processes read the same tokens, so one seen here can be gone
+     * before it's read. Reading from a descriptor of its own that doesn't
+     * block avoids waiting for the next one; where there isn't one, that
+     * wait is short, since tokens are given back as jobs finish.
+     */
+    struct pollfd descriptor = { _read, POLLIN, 0 };
+    if (::poll(&descriptor, 1, 0) != 1 || (descriptor.revents & POLLIN) == 0) {
+        return false;
+    }
+
+    char token;
+    if (::read(_read, &token, 1) != 1) {
+        return false;
+    }
+
+    _tokens.push_back(token);
+    return true;
+}
+
+void JobServer::
+release()
+{
+    if (_tokens.empty()) {
+        return;
+    }
+
+    /* Give back the same token; some jobservers use them to tell jobs apart. */
+    char token = _tokens.back();
+    _tokens.pop_back();
+
+    while (::write(_write, &token, 1) == -1 && errno == EINTR) {
+    }
+}
+
+/*
+ * A descriptor for the same pipe as `descriptor` that doesn't block on
+ * reads, without changing how reads from `descriptor` behave in the other
+ * processes sharing it. Only possible where a pipe can be opened again.
+ */
+static int
+OpenNonblocking(int descriptor)
+{
+#if defined(__linux__)
+    return ::open(("/proc/self/fd/" + std::to_string(descriptor)).c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+#else
+    (void)descriptor;
+    return -1;
+#endif
+}
+
+/*
+ * The jobserver named by MAKEFLAGS, as "R,W" descriptors or a "fifo:" path.
+ * The last one given is used, as make does.
+ */
+static std::string
+JobServerAuth(std::string const &makeflags)
+{
+    std::string auth;
+
+    std::istringstream words(makeflags);
+    std::string word;
+    while (words >> word) {
+        for (std::string const prefix : { "--jobserver-auth=", "--jobserver-fds=" }) {
+            if (word.compare(0, prefix.size(), prefix) == 0) {
+                auth = word.substr(prefix.size());
+            }
+        }
+    }
+
+    return auth;
+}
+
+std::unique_ptr<JobServer> JobServer::
+Create(process::Context const *processContext, size_t jobs)
+{
+    ext::optional<std::string> makeflags = processContext->environmentVariable("MAKEFLAGS");
+
+    std::string auth = (makeflags ? JobServerAuth(*makeflags) : std::string());
+    if (auth.compare(0, 5, "fifo:") == 0) {
+        int descriptor = ::open(auth.substr(5).c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (descriptor != -1) {
+            return std::unique_ptr<JobServer>(new JobServer(descriptor, descriptor, { descriptor }, *makeflags));
+        }
+    } else if (!auth.empty()) {
+        /* The descriptors can be gone, such as when run through a daemon. */
+        char *end;
+        int read = static_cast<int>(std::strtol(auth.c_str(), &end, 10));
+        int write = (*end == ',' ? static_cast<int>(std::strtol(end + 1, &end, 10)) : -1);
+        if (*end == '\0' && read >= 0 && write >= 0 && ::fcntl(read, F_GETFD) != -1 && ::fcntl(write, F_GETFD) != -1) {
+            int nonblocking = OpenNonblocking(read);
+            if (nonblocking != -1) {
+                return std::unique_ptr<JobServer>(new JobServer(nonblocking, write, { nonblocking }, *makeflags));
+            } else {
+                return std::unique_ptr<JobServer>(new JobServer(read, write, { }, *makeflags));
+            }
+        }
+    }
+
+    /*
+     * Create a jobserver with a token for each job past the first. Tools
+     * inherit the pipe, so it's not closed when they start.
+     */
+    int descriptors[2];
+    if (::pipe(descriptors) != 0) {
+        return nullptr;
+    }
+
+    for (size_t i = 1; i < jobs; ++i) {
+        char token = '+';
+        if (::write(descriptors[1], &token, 1) != 1) {
+            ::close(descriptors[0]);
+            ::close(descriptors[1]);
+            return nullptr;
+        }
+    }
+
+    std::string pipe = std::to_string(descriptors[0]) + "," + std::to_string(descriptors[1]);
+    std::string flags = "-j" + std::to_string(jobs) + " --jobserver-fds=" + pipe + " --jobserver-auth=" + pipe;
+    if (makeflags && !makeflags->empty()) {
+        flags = *makeflags + " " + flags;
+    }
+
+    std::vector<int> owned = { descriptors[0], descriptors[1] };
+    int read = descriptors[0];
+    int nonblocking = OpenNonblocking(descriptors[0]);
+    if (nonblocking != -1) {
+        owned.push_back(nonblocking);
+        read = nonblocking;
+    }
+
+    return std::unique_ptr<JobServer>(new JobServer(read, descriptors[1], owned, flags));
+}
@@ -10,34 +10,66 @@
 #include <xcexecution/NinjaExecutor.h>
 
 #include <xcexecution/Parameters.h>
+#include <xcexecution/TargetFingerprint.h>
+#include <xcexecution/Trace.h>
+#include <builtin/Registry.h>
+#include <builtin/Server.h>
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/PhaseInvocations.h>
+#include <ninja/DepsLog.h>
 #include <ninja/Writer.h>
 #include <ninja/Value.h>
+#include <dependency/DependencyInfoConverter.h>
+#include <plist/Array.h>
 #include <plist/Data.h>
+#include <plist/Dictionary.h>
+#include <plist/String.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/Binary.h>
+#include <libutil/CachedFilesystem.h>
 #include <libutil/Escape.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Hash.h>
+#include <libutil/Parallel.h>
+#include <libutil/Statistic.h>
 #include <process/Context.h>
 #include <process/MemoryContext.h>
 #include <process/Launcher.h>
-#include <libutil/md5.h>
+#include <process/Cancellation.h>
 
-#include <sstream>
-#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
+#include <unordered_set>
+
+#include <climits>
+#include <cstdlib>
 
 #include <sys/types.h>
-#include <sys/stat.h>
 
 using xcexecution::NinjaExecutor;
+using xcexecution::Trace;
 using xcexecution::Parameters;
+using xcexecution::TargetFingerprint;
+using libutil::CachedFilesystem;
 using libutil::Escape;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Hash;
+using libutil::Statistic;
+
+static Statistic BuildActionTime("xcexecution", "Generate Ninja files");
+static Statistic WriteTargetTime("xcexecution", "Write target Ninja file");
 
 NinjaExecutor::
-NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate) :
-    Executor(formatter, dryRun, generate)
+NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, bool batchDependencyInfo, ext::optional<std::string> const &actionCache, ext::optional<std::string> const &toolLauncher, std::vector<Pool> const &pools, std::shared_ptr<Trace> const &trace) :
+    Executor            (formatter, dryRun, generate, trace),
+    _batchDependencyInfo(batchDependencyInfo),
+    _actionCache        (actionCache),
+    _toolLauncher       (toolLauncher),
+    _pools              (pools)
 {
 }
 
@@ -46,18 +78,100 @@ NinjaExecutor::
 {
 }
 
+NinjaExecutor::Pool::
+Pool(std::string const &name, int depth, std::vector<std::string> const &tools) :
+    _name (name),
+    _depth(depth),
+    _tools(tools)
+{
+}
+
+std::string NinjaExecutor::Pool::
+argument() const
+{
+    std::string argument = _name + "=" + std::to_string(_depth) + ":";
+    for (std::string const &tool : _tools) {
+        if (&tool != &_tools[0]) {
+            argument += ",";
+        }
+        argument += tool;
+    }
+    return argument;
+}
+
+ext::optional<NinjaExecutor::Pool> NinjaExecutor::Pool::
+Parse(std::string const &argument)
+{
+    std::string::size_type equals = argument.find('=');
+    std::string::size_type colon = argument.find(':', equals);
+    if (equals == std::string::npos || colon == std::string::npos) {
+        return ext::nullopt;
+    }
+
+    /* Ninja reserves the console pool; names are also Ninja identifiers. */
+    std::string name = argument.substr(0, equals);
+    if (name.empty() || name == "console" || name.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-") != std::string::npos) {
+        return ext::nullopt;
+    }
+
+    std::string depthString = argument.substr(equals + 1, colon - equals - 1);
+    char *end = nullptr;
+    long depth = ::strtol(depthString.c_str(), &end, 10);
+    if (depthString.empty() || *end != '\0' || depth < 1 || depth > INT_MAX) {
+        return ext::nullopt;
+    }
+
+    std::vector<std::string> tools;
+    std::string::size_type start = colon + 1;
+    while (start <= argument.size()) {
+        std::string::size_type comma = std::min(argument.find(',', start), argument.size());
+        if (comma == start) {
+            return ext::nullopt;
+        }
+
+        tools.push_back(argument.substr(start, comma - start));
+        start = comma + 1;
+    }
+
+    return Pool(name, static_cast<int>(depth), tools);
+}
+
 static std::string
 TargetNinjaBegin(pbxproj::PBX::Target::shared_ptr const &target)
 {
     return "begin-target-" + target->name();
 }
 
+static std::string
+TargetNinjaBeginCompile(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return "begin-compile-target-" + target->name();
+}
+
 static std::string
 TargetNinjaWriteAuxiliaryFiles(pbxproj::PBX::Target::shared_ptr const &target)
 {
     return "write-auxiliary-files-" + target->name();
 }
 
+static std::string
+TargetNinjaWriteCompileAuxiliaryFiles(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return "write-compile-auxiliary-files-" + target->name();
+}
+
+static std::string
+TargetNinjaInterface(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return "interface-target-" + target->name();
+}
+
+static std::string
+TargetNinjaAlwaysOutOfDate(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return "always-out-of-date-target-" + target->name();
+}
+
 static std::string
 TargetNinjaFinish(pbxproj::PBX::Target::shared_ptr const &target)
 {
@@ -78,12 +192,39 @@ TargetNinjaPath(pbxproj::PBX::Target::shared_ptr const &target, pbxbuild::Target
     return temporaryDirectory + "/" + "build.ninja";
 }
 
+static std::string
+TargetNinjaFingerprintPath(pbxproj::PBX::Target::shared_ptr const &target, pbxbuild::Target::Environment const &targetEnvironment)
+{
+    /*
+     * Stored alongside the Ninja file generated for the target.
+     */
+    pbxsetting::Environment const &environment = targetEnvironment.environment();
+    std::string temporaryDirectory = environment.resolve("TARGET_TEMP_DIR");
+
+    return temporaryDirectory + "/" + ".ninja-fingerprint";
+}
+
+static std::string
+TargetNinjaDependencyInfoPath(pbxproj::PBX::Target::shared_ptr const &target, pbxbuild::Target::Environment const &targetEnvironment)
+{
+    pbxsetting::Environment const &environment = targetEnvironment.environment();
+    std::string temporaryDirectory = environment.resolve("TARGET_TEMP_DIR");
+
+    return temporaryDirectory + "/" + ".ninja-dependency-info";
+}
+
 static std::string
 NinjaRuleName()
 {
     return "invoke";
 }
 
+static std::string
+NinjaDependencyInfoRuleName()
+{
+    return "invoke-dependency-info";
+}
+
 static std::string
 NinjaDescription(std::string const &description)
 {
@@ -99,26 +240,16 @@ NinjaDescription(std::string const &description)
 static std::string
 NinjaHash(std::string const &input)
 {
-    md5_state_t state;
-    md5_init(&state);
-    md5_append(&state, reinterpret_cast<const md5_byte_t *>(input.data()), input.size());
-    uint8_t digest[16];
-    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
-
-    std::ostringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (uint8_t c : digest) {
-        ss << std::setw(2) << static_cast<int>(c);
-    }
-
-    return ss.str();
+    Hash hash;
+    hash.update(input);
+    return hash.hex();
 }
 
 static ext::optional<std::string>
 NinjaExecutablePath(
     process::Context const *processContext,
     Filesystem const *filesystem,
-    std::vector<std::string> const &executablePaths,
+    pbxbuild::Target::Environment const &targetEnvironment,
     pbxbuild::Tool::Invocation::Executable const &executable)
 {
     if (ext::optional<std::string> const &builtin = executable.builtin()) {
@@ -132,13 +263,23 @@ NinjaExecutablePath(
         if (FSUtil::IsAbsolutePath(*external)) {
             return *external;
         } else {
-            return filesystem->findExecutable(*external, executablePaths);
+            return targetEnvironment.executable(filesystem, *external);
         }
     } else {
         abort();
     }
 }
 
+static std::string
+NinjaBuiltinServerPath(std::string const &intermediatesDirectory)
+{
+    /*
+     * The server's socket is somewhere new for each build, so the Ninja file
+     * names a file in the build that holds the path to it.
+     */
+    return intermediatesDirectory + "/" + ".ninja-builtin-server";
+}
+
 static std::string
 NinjaInvocationPhonyOutput(pbxbuild::Tool::Invocation const &invocation)
 {
@@ -194,6 +335,10 @@ WriteNinjaRegenerate(
     std::string const &workingDirectory,
     std::string const &ninjaPath,
     std::string const &configurationHashPath,
+    bool batchDependencyInfo,
+    ext::optional<std::string> const &actionCache,
+    ext::optional<std::string> const &toolLauncher,
+    std::vector<NinjaExecutor::Pool> const &pools,
     std::vector<std::string> const &inputPaths)
 {
     /*
@@ -201,6 +346,21 @@ WriteNinjaRegenerate(
      * executing Ninja when Ninja itself calls this generate command.
      */
     std::vector<std::string> generateArguments = { "-generate", "-executor", "ninja" };
+    if (batchDependencyInfo) {
+        generateArguments.push_back("-batchDependencyInfo");
+    }
+    if (actionCache) {
+        generateArguments.push_back("-actionCache");
+        generateArguments.push_back(*actionCache);
+    }
+    if (toolLauncher) {
+        generateArguments.push_back("-toolLauncher");
+        generateArguments.push_back(*toolLauncher);
+    }
+    for (NinjaExecutor::Pool const &pool : pools) {
+        generateArguments.push_back("-ninjaPool");
+        generateArguments.push_back(pool.argument());
+    }
 
     /*
      * Add arguments necessary to recreate the same set of build parameters.
@@ -218,7 +378,8 @@ WriteNinjaRegenerate(
      * Escape executable and input parameters for Ninja.
      */
     for (std::string const &arg : generateArguments) {
-        exec += " " + Escape::Shell(arg);
+        exec += " ";
+        Escape::Shell(arg, &exec);
     }
     std::vector<ninja::Value> inputPathValues;
     inputPathValues.push_back(ninja::Value::String(configurationHashPath));
@@ -249,6 +410,92 @@ WriteNinjaRegenerate(
     });
 }
 
+/* Shared arguments shorter than this aren't worth a variable. */
+static size_t const MinimumSharedArgumentsSize = 128;
+
+namespace {
+
+/*
+ * Command lines in a target's Ninja file starting with the same arguments.
+ */
+struct SharedArguments {
+    /* A command line in the group. */
+    size_t reference;
+    /* How many leading arguments every command in the group shares. */
+    size_t count;
+    /* How many commands are in the group. */
+    size_t members;
+};
+
+}
+
+static std::string
+JoinArguments(std::vector<std::string>::const_iterator begin, std::vector<std::string>::const_iterator end)
+{
+    std::string result;
+    for (auto it = begin; it != end; ++it) {
+        if (it != begin) {
+            result += " ";
+        }
+        result += *it;
+    }
+    return result;
+}
+
+/*
+ * Groups command lines (as lists of shell-escaped arguments) by the
+ * arguments they start with. Compiler invocations in a target repeat the
+ * same long list of flags, with only the files at the end differing. Each
+ * command joins the group it shares the most with, if that's enough to be
+ * worth sharing; the shared count only shrinks as commands join. Returns
+ * the group for each command, or nothing for empty commands.
+ */
+static std::vector<ext::optional<size_t>>
+GroupSharedArguments(std::vector<std::vector<std::string>> const &commands, std::vector<SharedArguments> *groups)
+{
+    std::vector<ext::optional<size_t>> assignments = std::vector<ext::optional<size_t>>(commands.size());
+
+    for (size_t i = 0; i < commands.size(); ++i) {
+        std::vector<std::string> const &command = commands[i];
+        if (command.empty()) {
+            continue;
+        }
+
+        ext::optional<size_t> best;
+        size_t bestCount = 0;
+        size_t bestSize = 0;
+        for (size_t g = 0; g < groups->size(); ++g) {
+            SharedArguments const &group = (*groups)[g];
+            std::vector<std::string> const &reference = commands[group.reference];
+
+            size_t count = 0;
+            size_t size = 0;
+            while (count < group.count && count < command.size() && reference[count] == command[count]) {
+                size += command[count].size() + 1;
+                count++;
+            }
+
+            if (size > bestSize) {
+                best = g;
+                bestCount = count;
+                bestSize = size;
+            }
+        }
+
+        if (best && bestSize >= MinimumSharedArgumentsSize) {
+            SharedArguments *group = &(*groups)[*best];
+            group->count = bestCount;
+            group->members++;
+            assignments[i] = *best;
+        } else {
+            assignments[i] = groups->size();
+            groups->push_back({ i, command.size(), 1 });
+        }
+    }
+
+    return assignments;
+}
+
 static bool
 WriteNinja(Filesystem *filesystem, ninja::Writer const &writer, std::string const &path)
 {
@@ -256,17 +503,39 @@ WriteNinja(Filesystem *filesystem, ninja::Writer const &writer, std::string cons
         return false;
     }
 
-    std::string contents = writer.serialize();
-    std::vector<uint8_t> copy = std::vector<uint8_t>(contents.begin(), contents.end());
-    if (!filesystem->write(copy, path)) {
+    /* Ninja rebuilds everything depending on a file it sees change. */
+    if (!filesystem->writeIfChanged(writer.contents(), path)) {
         return false;
     }
 
     return true;
 }
 
-static bool
-ShouldGenerateNinja(Filesystem const *filesystem, bool generate, Parameters const &buildParameters, std::string const &ninjaPath, std::string const &configurationHashPath)
+std::string NinjaExecutor::
+configurationHash(Parameters const &buildParameters) const
+{
+    /*
+     * Options to the executor that change the Ninja file must also be part
+     * of the configuration, so changing them regenerates it.
+     */
+    std::string hash = buildParameters.canonicalHash();
+    if (_batchDependencyInfo) {
+        hash += " -batchDependencyInfo";
+    }
+    if (_actionCache) {
+        hash += " -actionCache " + *_actionCache;
+    }
+    if (_toolLauncher) {
+        hash += " -toolLauncher " + *_toolLauncher;
+    }
+    for (NinjaExecutor::Pool const &pool : _pools) {
+        hash += " -ninjaPool " + pool.argument();
+    }
+    return hash;
+}
+
+bool NinjaExecutor::
+ShouldGenerate(Filesystem const *filesystem, bool generate, std::string const &configurationHash, std::string const &ninjaPath, std::string const &configurationHashPath)
 {
     /*
      * If explicitly asked to generate, definitely need to regenerate.
@@ -299,7 +568,7 @@ ShouldGenerateNinja(Filesystem const *filesystem, bool generate, Parameters cons
         /* Can't be read, same as not existing. */
         return true;
     }
-    if (std::string(contents.begin(), contents.end()) != buildParameters.canonicalHash()) {
+    if (std::string(contents.begin(), contents.end()) != configurationHash) {
         return true;
     }
 
@@ -310,35 +579,172 @@ ShouldGenerateNinja(Filesystem const *filesystem, bool generate, Parameters cons
 }
 
 bool NinjaExecutor::
-build(
-    process::Context const *processContext,
-    process::Launcher *processLauncher,
-    Filesystem *filesystem,
-    pbxbuild::Build::Environment const &buildEnvironment,
-    Parameters const &buildParameters)
+TargetUpToDate(Filesystem const *filesystem, std::string const &targetPath, std::string const &fingerprintPath, std::string const &fingerprint)
+{
+    if (!filesystem->exists(targetPath)) {
+        return false;
+    }
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, fingerprintPath)) {
+        return false;
+    }
+
+    return std::string(contents.begin(), contents.end()) == fingerprint;
+}
+
+static bool
+ConvertTargetDependencyInfo(Filesystem *filesystem, std::string const &dependencyInfoBatchPath, ninja::DepsLog *depsLog)
+{
+    std::vector<uint8_t> batchContents;
+    if (!filesystem->read(&batchContents, dependencyInfoBatchPath)) {
+        fprintf(stderr, "warning: missing dependency info batch %s\n", dependencyInfoBatchPath.c_str());
+        return false;
+    }
+
+    auto result = plist::Format::Any::Deserialize(batchContents);
+    plist::Array const *batch = plist::CastTo<plist::Array>(result.first.get());
+    if (batch == nullptr) {
+        fprintf(stderr, "warning: invalid dependency info batch %s\n", dependencyInfoBatchPath.c_str());
+        return false;
+    }
+
+    bool changed = false;
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < batch->count(); ++i) {
+        plist::Dictionary const *entry = batch->value<plist::Dictionary>(i);
+        if (entry == nullptr) {
+            continue;
+        }
+
+        plist::String const *output = entry->value<plist::String>("Output");
+        plist::String const *directory = entry->value<plist::String>("Directory");
+        plist::Array const *inputs = entry->value<plist::Array>("Inputs");
+        if (output == nullptr || directory == nullptr || inputs == nullptr) {
+            continue;
+        }
+
+        /*
+         * Load each dependency info. If any is missing, the invocation has
+         * not run yet, so Ninja will run it regardless of dependencies.
+         */
+        bool complete = true;
+        std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> dependencyInfo;
+        for (size_t j = 0; complete && j < inputs->count(); ++j) {
+            plist::Dictionary const *input = inputs->value<plist::Dictionary>(j);
+            plist::String const *formatName = (input != nullptr ? input->value<plist::String>("Format") : nullptr);
+            plist::String const *path = (input != nullptr ? input->value<plist::String>("Path") : nullptr);
+
+            dependency::DependencyInfoFormat format;
+            if (formatName == nullptr || path == nullptr || !dependency::DependencyInfoFormats::Parse(formatName->value(), &format)) {
+                complete = false;
+                break;
+            }
+
+            std::string resolvedPath = FSUtil::ResolveRelativePath(path->value(), directory->value());
+            if (!filesystem->exists(resolvedPath)) {
+                complete = false;
+                break;
+            }
+
+            dependencyInfo.push_back({ format, resolvedPath });
+        }
+
+        if (!complete) {
+            continue;
+        }
+
+        /*
+         * Ninja only uses dependencies recorded after the output last changed.
+         */
+        std::string outputPath = FSUtil::NormalizePath(FSUtil::ResolveRelativePath(output->value(), directory->value()));
+        ext::optional<uint64_t> mtime = filesystem->modificationTime(outputPath);
+        if (!mtime) {
+            continue;
+        }
+
+        paths.clear();
+        bool valid = dependency::DependencyInfoConverter::Inputs(filesystem, directory->value(), dependencyInfo, [&](std::string const &input) {
+            paths.push_back(FSUtil::NormalizePath(input));
+        });
+        if (!valid) {
+            continue;
+        }
+
+        /* Only changed dependencies are added to the log. */
+        if (depsLog->record(outputPath, *mtime, paths)) {
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+static void
+ConvertDependencyInfoBatch(Filesystem *filesystem, std::string const &dependencyInfoBatchPath, std::string const &depsLogPath)
 {
+    std::vector<uint8_t> batchContents;
+    if (!filesystem->read(&batchContents, dependencyInfoBatchPath)) {
+        /* Nothing to convert. */
+        return;
+    }
+
     /*
-     * Load the derived data hash in order to output the Ninja file in the
-     * right derived data directory. This does not load the workspace context
-     * to avoid loading potentially very large projects for incremental builds.
+     * The batch lists the dependency info for each target.
      */
-    std::string workspacePath = filesystem->resolvePath(buildParameters.workspace().value_or(*buildParameters.project()));
-    pbxbuild::DerivedDataHash derivedDataHash = pbxbuild::DerivedDataHash::Create(workspacePath);
-    pbxsetting::Level derivedDataLevel = pbxsetting::Level(derivedDataHash.overrideSettings());
+    auto result = plist::Format::Any::Deserialize(batchContents);
+    plist::Array const *batch = plist::CastTo<plist::Array>(result.first.get());
+    if (batch == nullptr) {
+        fprintf(stderr, "warning: invalid dependency info batch %s\n", dependencyInfoBatchPath.c_str());
+        return;
+    }
 
     /*
-     * This environment contains only settings shared for the entire build.
+     * Add to Ninja's own dependency log, rather than writing a depfile for
+     * each invocation. Ninja has exited, so nothing else is writing to it.
      */
-    pbxsetting::Environment environment = pbxsetting::Environment(buildEnvironment.baseEnvironment());
-    environment.insertFront(derivedDataLevel, false);
+    ninja::DepsLog depsLog;
+    std::vector<uint8_t> depsLogContents;
+    if (filesystem->read(&depsLogContents, depsLogPath) && !depsLog.load(depsLogContents)) {
+        fprintf(stderr, "warning: unsupported ninja dependency log %s\n", depsLogPath.c_str());
+        return;
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < batch->count(); ++i) {
+        if (plist::String const *path = batch->value<plist::String>(i)) {
+            if (ConvertTargetDependencyInfo(filesystem, path->value(), &depsLog)) {
+                changed = true;
+            }
+        }
+    }
+
+    if (changed && !filesystem->write(depsLog.contents(), depsLogPath)) {
+        fprintf(stderr, "warning: failed to write ninja dependency log %s\n", depsLogPath.c_str());
+    }
+}
 
+bool NinjaExecutor::
+build(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    Parameters const &buildParameters,
+    process::Cancellation const *cancellation)
+{
     /*
-     * Determine where build-level outputs will go. Note we can't use CONFIGURATION_BUILD_DIR
-     * at this point because that includes the EFFECTIVE_PLATFORM_NAME, but we don't have a platform.
+     * Determine where build-level outputs will go, in order to output the Ninja
+     * file in the right derived data directory. This does not load the workspace
+     * context to avoid loading potentially very large projects for incremental
+     * builds. Note we can't use CONFIGURATION_BUILD_DIR at this point because
+     * that includes the EFFECTIVE_PLATFORM_NAME, but we don't have a platform.
      */
-    std::string intermediatesDirectory = environment.resolve("OBJROOT");
+    std::string intermediatesDirectory = *buildParameters.intermediatesDirectory(filesystem, buildEnvironment);
     std::string ninjaPath = intermediatesDirectory + "/" + "build.ninja";
     std::string configurationHashPath = intermediatesDirectory + "/" + ".ninja-configuration";
+    std::string configurationHash = this->configurationHash(buildParameters);
+    std::string dependencyInfoBatchPath = intermediatesDirectory + "/" + ".ninja-dependency-info";
 
     /*
      * Find the dependency info tool.
@@ -346,17 +752,37 @@ build(
     std::string executableRoot = FSUtil::GetDirectoryName(processContext->executablePath());
     std::string dependencyInfoToolPath = executableRoot + "/" + "dependency-info-tool";
 
+    /*
+     * Find the builtin client. If available, builtins run in a builtin server
+     * in this process while Ninja runs, rather than each in a new process.
+     */
+    ext::optional<std::string> builtinClientPath;
+    if (filesystem->isExecutable(executableRoot + "/" + "builtin-client")) {
+        builtinClientPath = executableRoot + "/" + "builtin-client";
+    }
+    std::string builtinServerPath = NinjaBuiltinServerPath(intermediatesDirectory);
+
     /*
      * If the Ninja file needs to be generated, generate it.
      */
-    if (ShouldGenerateNinja(filesystem, _generate, buildParameters, ninjaPath, configurationHashPath)) {
+    if (ShouldGenerate(filesystem, _generate, configurationHash, ninjaPath, configurationHashPath)) {
         fprintf(stderr, "Generating Ninja files...\n");
 
+        /*
+         * Nothing else writes files while generating, so the same paths
+         * needn't be checked again for every target that refers to them.
+         */
+        CachedFilesystem cachedFilesystem(filesystem);
+
         /*
          * Load the workspace. This can be quite slow, so only do it if it's needed to generate
          * the Ninja file. Similarly, only resolve dependencies in that case.
          */
-        ext::optional<pbxbuild::WorkspaceContext> workspaceContext = buildParameters.loadWorkspace(filesystem, processContext->userName(), buildEnvironment, processContext->currentDirectory());
+        ext::optional<pbxbuild::WorkspaceContext> workspaceContext;
+        {
+            Trace::Span span(_trace.get(), "Load workspace", "workspace");
+            workspaceContext = buildParameters.loadWorkspace(&cachedFilesystem, processContext->userName(), buildEnvironment, processContext->currentDirectory());
+        }
         if (!workspaceContext) {
             fprintf(stderr, "error: unable to load workspace\n");
             return false;
@@ -368,7 +794,11 @@ build(
             return false;
         }
 
-        ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> targetGraph = buildParameters.resolveDependencies(buildEnvironment, *buildContext);
+        ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> targetGraph;
+        {
+            Trace::Span span(_trace.get(), "Resolve dependencies", "workspace");
+            targetGraph = buildParameters.resolveDependencies(filesystem, buildEnvironment, *buildContext);
+        }
         if (!targetGraph) {
             fprintf(stderr, "error: unable to resolve dependencies\n");
             return false;
@@ -379,14 +809,17 @@ build(
          */
         bool result = buildAction(
             processContext,
-            filesystem,
+            &cachedFilesystem,
             buildParameters,
             buildEnvironment,
             *buildContext,
             *targetGraph,
             dependencyInfoToolPath,
+            builtinClientPath,
+            builtinServerPath,
             ninjaPath,
             configurationHashPath,
+            dependencyInfoBatchPath,
             intermediatesDirectory);
 
         if (!result) {
@@ -397,8 +830,7 @@ build(
         /*
          * Write out the configuration hash for the parameters in the Ninja.
          */
-        std::string hashContents = buildParameters.canonicalHash();
-        auto contents = std::vector<uint8_t>(hashContents.begin(), hashContents.end());
+        auto contents = std::vector<uint8_t>(configurationHash.begin(), configurationHash.end());
         if (!filesystem->write(contents, configurationHashPath)) {
             fprintf(stderr, "error: failed to generate ninja configuration hash\n");
             return false;
@@ -449,6 +881,10 @@ build(
 
         // TODO(grp): Pass number of jobs if specified.
 
+        if (!_dryRun && !startBuildSession(filesystem, buildEnvironment, buildParameters)) {
+            return false;
+        }
+
         /*
          * Run Ninja and return if it failed. Ninja itself does the build.
          */
@@ -462,7 +898,39 @@ build(
             processContext->userName(),
             processContext->groupName());
 
-        ext::optional<int> exitCode = processLauncher->launch(filesystem, &ninja);
+        /*
+         * Serve builtins while Ninja runs. If the server can't start, the
+         * builtin client falls back to running each builtin's executable.
+         */
+        builtin::Server server(builtin::Registry::Default(), builtinServerPath);
+        std::thread serverThread;
+        if (builtinClientPath && !_dryRun && server.listen()) {
+            serverThread = std::thread([&server, processContext, filesystem] {
+                server.serve(processContext, filesystem);
+            });
+        }
+
+        /* Ninja stops the tools it runs when it's stopped. */
+        ext::optional<int> exitCode;
+        if (cancellation == nullptr || !cancellation->cancelled()) {
+            Trace::Span span(_trace.get(), "Run Ninja", "build", { { "executable", *executable } });
+            process::Launcher::CancellationScope scope(processLauncher, cancellation);
+            exitCode = processLauncher->launch(filesystem, &ninja);
+        }
+
+        if (serverThread.joinable()) {
+            server.stop();
+            serverThread.join();
+        }
+
+        /*
+         * Convert dependency info for Ninja to use in the next build. Even if
+         * the build failed, the invocations that succeeded need to be tracked.
+         */
+        if (_batchDependencyInfo && !_dryRun) {
+            ConvertDependencyInfoBatch(filesystem, dependencyInfoBatchPath, intermediatesDirectory + "/" + ".ninja_deps");
+        }
+
         if (!exitCode || *exitCode != 0) {
             return false;
         }
@@ -480,10 +948,15 @@ buildAction(
     pbxbuild::Build::Context const &buildContext,
     pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
     std::string const &dependencyInfoToolPath,
+    ext::optional<std::string> const &builtinClientPath,
+    std::string const &builtinServerPath,
     std::string const &ninjaPath,
     std::string const &configurationHashPath,
+    std::string const &dependencyInfoBatchPath,
     std::string const &intermediatesDirectory)
 {
+    Statistic::Timer timer(&BuildActionTime);
+
     /*
      * Write out a Ninja file for the build as a whole. Note each target will have a separate
      * file, this is to coordinate the build between targets.
@@ -510,124 +983,148 @@ buildAction(
 
     /*
      * Since invocations are already resolved at this point, we can't use more specific
-     * rules at the Ninja level. Instead, add a single rule that just passes through from
-     * the build command that calls it.
+     * rules at the Ninja level. Instead, add a rule that just passes through from the
+     * build command that calls it, and one that also converts dependency info after.
      */
-    writer.rule(NinjaRuleName(), ninja::Value::Expression("cd $dir && env -i $env $exec && $depexec"));
+    writer.rule(NinjaRuleName(), ninja::Value::Expression("cd $dir && env -i $env $exec"));
+    writer.rule(NinjaDependencyInfoRuleName(), ninja::Value::Expression("cd $dir && env -i $env $exec && $depexec"));
 
     /*
-     * Go over each target and write out Ninja targets for the start and end of each.
-     * Don't bother topologically sorting the targets now, since Ninja will do that for us.
+     * Pools for tools that can't all run at once, like memory hungry linkers.
      */
-    for (pbxproj::PBX::Target::shared_ptr const &target : targetGraph.nodes()) {
+    for (Pool const &pool : _pools) {
+        writer.pool(pool.name(), pool.depth());
+    }
 
-        /*
-         * Beginning target depends on finishing the targets before that. This is implemented
-         * in three parts:
-         *
-         *  1. Each target has a "target begin" Ninja target depending on completing the build
-         *     of any dependent targets.
-         *  2. Each invocation's Ninja target depends on the "target begin" target to order
-         *     them necessarily after the target started building.
-         *  3. Each target also has a "target finish" Ninja target, which depends on all of
-         *     the invocations created for the target.
-         *
-         * The end result is that targets build in the right order. Note this does not preclude
-         * cross-target parallelization; if the target dependency graph doesn't have an edge,
-         * then they will be parallelized. Linear builds have edges from each target to all
-         * previous targets.
-         */
+    /*
+     * Dependency info to convert after the build for each target, if batching conversion.
+     */
+    std::unique_ptr<plist::Array> dependencyInfoBatches = plist::Array::New();
 
-        /*
-         * Resolve this target and generate its invocations.
-         */
-        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
-        if (!targetEnvironment) {
-            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
-            continue;
-        }
+    /*
+     * Changing how Ninja files are generated affects all targets.
+     */
+    std::string generator = TargetFingerprint::Generator(processContext->executablePath());
+    generator += " " + dependencyInfoToolPath;
+    generator += " " + builtinClientPath.value_or("") + " " + builtinServerPath;
+    if (_batchDependencyInfo) {
+        generator += " -batchDependencyInfo";
+    }
+    if (_actionCache) {
+        generator += " -actionCache " + *_actionCache;
+    }
+    if (_toolLauncher) {
+        generator += " -toolLauncher " + *_toolLauncher;
+    }
+    for (Pool const &pool : _pools) {
+        generator += " -ninjaPool " + pool.argument();
+    }
 
-        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
-        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
+    /*
+     * Resolve each target and write out its Ninja file, if it changed. Resolving targets is
+     * CPU bound and independent between targets, so resolve them in parallel.
+     */
+    std::vector<pbxproj::PBX::Target::shared_ptr> targets = std::vector<pbxproj::PBX::Target::shared_ptr>(targetGraph.nodes().begin(), targetGraph.nodes().end());
+    std::vector<std::string> targetPaths = std::vector<std::string>(targets.size());
+    std::vector<std::string> targetDependencyInfoPaths = std::vector<std::string>(targets.size());
+    std::vector<std::vector<std::string>> targetFileLists = std::vector<std::vector<std::string>>(targets.size());
 
-        /*
-         * As described above, the target's begin depends on all of the target dependencies.
-         */
-        std::vector<ninja::Value> dependenciesFinished;
-        for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(target)) {
-            std::string targetFinished = TargetNinjaFinish(dependency);
-            dependenciesFinished.push_back(ninja::Value::String(targetFinished));
+    std::atomic<bool> failed(false);
+
+    libutil::Parallel::For(targets.size(), [&](size_t index) {
+        if (failed) {
+            return;
         }
 
-        /*
-         * Add the phony target for beginning this target's build.
-         */
-        std::string targetBegin = TargetNinjaBegin(target);
-        writer.build({ ninja::Value::String(targetBegin) }, "phony", dependenciesFinished);
+        pbxproj::PBX::Target::shared_ptr const &target = targets[index];
 
         /*
-         * Add the phony target for the checkpoint after writing auxiliary files.
+         * Resolve this target.
          */
-        std::string targetWriteAuxiliaryFiles = TargetNinjaWriteAuxiliaryFiles(target);
-        std::vector<ninja::Value> auxiliaryFileOutputs = { ninja::Value::String(targetBegin) };
-        for (pbxbuild::Tool::Invocation const &invocation : phaseInvocations.invocations()) {
-            for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
-                auxiliaryFileOutputs.push_back(ninja::Value::String(auxiliaryFile.path()));
-            }
+        Trace::Arguments traceArguments = { { "target", target->name() } };
+
+        ext::optional<pbxbuild::Target::Environment> targetEnvironment;
+        {
+            Trace::Span span(_trace.get(), "Create target environment", "target", traceArguments);
+            targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
+        }
+        if (!targetEnvironment) {
+            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
+            return;
         }
-        writer.build({ ninja::Value::String(targetWriteAuxiliaryFiles) }, "phony", auxiliaryFileOutputs);
 
-        /*
-         * Write out the Ninja file to build this target.
-         */
-        if (!buildTargetInvocations(processContext, filesystem, dependencyInfoToolPath, target, *targetEnvironment, phaseInvocations.invocations())) {
-            fprintf(stderr, "error: failed to build target ninja\n");
-            return false;
+        /* Sort dependencies so the target's Ninja file is stable. */
+        std::vector<pbxproj::PBX::Target::shared_ptr> dependencies;
+        for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(target)) {
+            dependencies.push_back(dependency);
         }
+        std::sort(dependencies.begin(), dependencies.end(), [](pbxproj::PBX::Target::shared_ptr const &a, pbxproj::PBX::Target::shared_ptr const &b) {
+            return a->name() < b->name();
+        });
 
-        /*
-         * Load the Ninja file generated for this target.
-         */
         std::string targetPath = TargetNinjaPath(target, *targetEnvironment);
-        writer.subninja(ninja::Value::String(targetPath));
+        std::string fingerprintPath = TargetNinjaFingerprintPath(target, *targetEnvironment);
 
         /*
-         * As described above, the target's finish depends on all of the invocation outputs.
+         * Generating invocations is the slow part, so skip it if nothing the
+         * target's Ninja file is made from has changed.
          */
-        std::unordered_set<std::string> invocationOutputs;
-        for (pbxbuild::Tool::Invocation const &invocation : phaseInvocations.invocations()) {
-            if (!invocation.executable()) {
-                /* No outputs. */
-                continue;
+        std::string fingerprint = TargetFingerprint::Create(filesystem, generator, target, *targetEnvironment, dependencies, &targetFileLists[index]);
+        if (!TargetUpToDate(filesystem, targetPath, fingerprintPath, fingerprint)) {
+            /* Remove the old fingerprint in case generating fails. */
+            if (filesystem->exists(fingerprintPath)) {
+                filesystem->removeFile(fingerprintPath);
             }
 
-            std::vector<std::string> outputs = NinjaInvocationOutputs(invocation);
-            invocationOutputs.insert(outputs.begin(), outputs.end());
-        }
+            std::unique_ptr<pbxbuild::Phase::PhaseInvocations> phaseInvocations;
+            {
+                Trace::Span span(_trace.get(), "Resolve phases", "target", traceArguments);
+                pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
+                phaseInvocations = std::unique_ptr<pbxbuild::Phase::PhaseInvocations>(new pbxbuild::Phase::PhaseInvocations(pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target)));
+            }
 
-        /*
-         * Add phony rules for input dependencies that we don't know if they exist.
-         * This can come up, for example, for user-specified custom script inputs.
-         * However, avoid adding the phony invocation if a real output *does* include
-         * the phony input, to avoid Ninja complaining about duplicate rules.
-         */
-        for (pbxbuild::Tool::Invocation const &invocation : phaseInvocations.invocations()) {
-            for (std::string const &phonyInput : invocation.phonyInputs()) {
-                if (invocationOutputs.find(phonyInput) == invocationOutputs.end()) {
-                    writer.build({ ninja::Value::String(phonyInput) }, "phony", { });
-                }
+            /*
+             * Write out the Ninja file to build this target.
+             */
+            Trace::Span span(_trace.get(), "Write target Ninja file", "target", traceArguments);
+            Statistic::Timer timer(&WriteTargetTime);
+            if (!buildTargetInvocations(processContext, filesystem, dependencyInfoToolPath, builtinClientPath, builtinServerPath, target, *targetEnvironment, dependencies, phaseInvocations->invocations())) {
+                fprintf(stderr, "error: failed to build target ninja\n");
+                failed = true;
+                return;
+            }
+
+            auto contents = std::vector<uint8_t>(fingerprint.begin(), fingerprint.end());
+            if (!filesystem->write(contents, fingerprintPath)) {
+                fprintf(stderr, "error: failed to write target ninja fingerprint: %s\n", fingerprintPath.c_str());
+                failed = true;
+                return;
             }
         }
 
-        /*
-         * Add the phony target for ending this target's build.
-         */
-        std::string targetFinish = TargetNinjaFinish(target);
-        std::vector<ninja::Value> invocationOutputsValues;
-        for (std::string const &output : invocationOutputs) {
-            invocationOutputsValues.push_back(ninja::Value::String(output));
+        targetPaths[index] = targetPath;
+        targetDependencyInfoPaths[index] = TargetNinjaDependencyInfoPath(target, *targetEnvironment);
+    });
+
+    if (failed) {
+        return false;
+    }
+
+    /*
+     * Load the Ninja file for each target, in the same order as the targets. Don't bother
+     * topologically sorting the targets now, since Ninja will do that for us.
+     */
+    for (size_t index = 0; index < targets.size(); ++index) {
+        if (targetPaths[index].empty()) {
+            /* Couldn't resolve the target. */
+            continue;
+        }
+
+        writer.subninja(ninja::Value::String(targetPaths[index]));
+
+        if (_batchDependencyInfo) {
+            dependencyInfoBatches->append(plist::String::New(targetDependencyInfoPaths[index]));
         }
-        writer.build({ ninja::Value::String(targetFinish) }, "phony", { }, { }, invocationOutputsValues);
     }
 
     /*
@@ -635,6 +1132,11 @@ buildAction(
      */
     std::vector<std::string> inputPaths = buildContext.workspaceContext().loadedFilePaths();
 
+    /* The paths in script file lists are part of the targets' Ninja files. */
+    for (std::vector<std::string> const &fileLists : targetFileLists) {
+        inputPaths.insert(inputPaths.end(), fileLists.begin(), fileLists.end());
+    }
+
     /*
      * Add a Ninja rule to regenerate the build.ninja file itself.
      */
@@ -645,6 +1147,10 @@ buildAction(
         processContext->currentDirectory(),
         ninjaPath,
         configurationHashPath,
+        _batchDependencyInfo,
+        _actionCache,
+        _toolLauncher,
+        _pools,
         inputPaths);
 
     /*
@@ -655,6 +1161,17 @@ buildAction(
         return false;
     }
 
+    /*
+     * Write out where to find the dependency info to convert after building.
+     */
+    if (_batchDependencyInfo) {
+        auto serialized = plist::Format::Binary::Serialize(dependencyInfoBatches.get(), plist::Format::Binary::Create());
+        if (serialized.first == nullptr || !filesystem->write(*serialized.first, dependencyInfoBatchPath)) {
+            fprintf(stderr, "error: failed to write dependency info batch to %s\n", dependencyInfoBatchPath.c_str());
+            return false;
+        }
+    }
+
     /*
      * Note where the Ninja file is written.
      */
@@ -668,8 +1185,11 @@ buildTargetInvocations(
     process::Context const *processContext,
     Filesystem *filesystem,
     std::string const &dependencyInfoToolPath,
+    ext::optional<std::string> const &builtinClientPath,
+    std::string const &builtinServerPath,
     pbxproj::PBX::Target::shared_ptr const &target,
     pbxbuild::Target::Environment const &targetEnvironment,
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &dependencies,
     std::vector<pbxbuild::Tool::Invocation> const &invocations)
 {
     /*
@@ -680,40 +1200,293 @@ buildTargetInvocations(
     writer.comment("Target: " + target->name());
     writer.newline();
 
+    pbxsetting::Environment const &environment = targetEnvironment.environment();
+    std::string temporaryDirectory = environment.resolve("TARGET_TEMP_DIR");
+
+    /*
+     * Beginning target depends on finishing the targets before that. This is implemented
+     * in three parts:
+     *
+     *  1. Each target has a "target begin" Ninja target depending on completing the build
+     *     of any dependent targets.
+     *  2. Each invocation's Ninja target depends on the "target begin" target to order
+     *     them necessarily after the target started building.
+     *  3. Each target also has a "target finish" Ninja target, which depends on all of
+     *     the invocations created for the target.
+     *
+     * The end result is that targets build in the right order. Note this does not preclude
+     * cross-target parallelization; if the target dependency graph doesn't have an edge,
+     * then they will be parallelized. Linear builds have edges from each target to all
+     * previous targets.
+     *
+     * Compiling sources is the exception. It only needs the headers, module maps and
+     * Swift modules of the dependencies, so each target also has an "interface" Ninja
+     * target for those, and compiles begin once the dependencies' interfaces are ready.
+     * That way, compiles overlap with the dependencies linking.
+     *
+     * These are all in the target's own Ninja file, so it can be reused as-is when the
+     * target hasn't changed.
+     */
+
+    /*
+     * As described above, the target's begin depends on all of the target dependencies.
+     */
+    std::vector<ninja::Value> dependenciesFinished;
+    for (pbxproj::PBX::Target::shared_ptr const &dependency : dependencies) {
+        std::string targetFinished = TargetNinjaFinish(dependency);
+        dependenciesFinished.push_back(ninja::Value::String(targetFinished));
+    }
+
+    /*
+     * Add the phony target for beginning this target's build.
+     */
     std::string targetBegin = TargetNinjaBegin(target);
+    writer.build({ ninja::Value::String(targetBegin) }, "phony", dependenciesFinished);
+
+    /*
+     * Add the phony target for beginning this target's compiles, after the
+     * interfaces of the target dependencies.
+     */
+    std::vector<ninja::Value> dependenciesInterfaces;
+    for (pbxproj::PBX::Target::shared_ptr const &dependency : dependencies) {
+        dependenciesInterfaces.push_back(ninja::Value::String(TargetNinjaInterface(dependency)));
+    }
+
+    std::string targetBeginCompile = TargetNinjaBeginCompile(target);
+    writer.build({ ninja::Value::String(targetBeginCompile) }, "phony", dependenciesInterfaces);
+
+    /*
+     * Add the phony targets for the checkpoints after writing auxiliary files. Auxiliary
+     * files only hold what the target's invocations pass themselves, so they're written
+     * as soon as the target's compiles can begin.
+     */
+    std::vector<ninja::Value> auxiliaryFiles;
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
+            auxiliaryFiles.push_back(ninja::Value::String(auxiliaryFile.path()));
+        }
+    }
+
     std::string targetWriteAuxiliaryFiles = TargetNinjaWriteAuxiliaryFiles(target);
+    std::vector<ninja::Value> auxiliaryFileOutputs = { ninja::Value::String(targetBegin) };
+    auxiliaryFileOutputs.insert(auxiliaryFileOutputs.end(), auxiliaryFiles.begin(), auxiliaryFiles.end());
+    writer.build({ ninja::Value::String(targetWriteAuxiliaryFiles) }, "phony", auxiliaryFileOutputs);
 
-    pbxsetting::Environment const &environment = targetEnvironment.environment();
-    std::string temporaryDirectory = environment.resolve("TARGET_TEMP_DIR");
+    std::string targetWriteCompileAuxiliaryFiles = TargetNinjaWriteCompileAuxiliaryFiles(target);
+    std::vector<ninja::Value> compileAuxiliaryFileOutputs = { ninja::Value::String(targetBeginCompile) };
+    compileAuxiliaryFileOutputs.insert(compileAuxiliaryFileOutputs.end(), auxiliaryFiles.begin(), auxiliaryFiles.end());
+    writer.build({ ninja::Value::String(targetWriteCompileAuxiliaryFiles) }, "phony", compileAuxiliaryFileOutputs);
+
+    /*
+     * Dependency info to convert after the build, if batching conversion.
+     */
+    std::unique_ptr<plist::Array> dependencyInfoBatch = plist::Array::New();
+
+    /*
+     * The action cache tool is installed next to this executable.
+     */
+    ext::optional<std::string> actionCacheToolPath;
+    if (_actionCache) {
+        actionCacheToolPath = FSUtil::GetDirectoryName(processContext->executablePath()) + "/" + "action-cache-tool";
+    }
+
+    /*
+     * Build the command line for each invocation. Must escape for shell arguments as Ninja
+     * passes the command string directly to the shell, which would interpret spaces, etc.
+     */
+    std::vector<std::string> executablePaths = std::vector<std::string>(invocations.size());
+    std::vector<std::vector<std::string>> commands = std::vector<std::vector<std::string>>(invocations.size());
+    for (size_t i = 0; i < invocations.size(); ++i) {
+        pbxbuild::Tool::Invocation const &invocation = invocations[i];
+
+        // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
+        if (!invocation.executable()) {
+            continue;
+        }
+
+        /* Find invocation executable. */
+        ext::optional<std::string> executablePath = NinjaExecutablePath(processContext, filesystem, targetEnvironment, *invocation.executable());
+        if (!executablePath) {
+            fprintf(stderr, "unable to find executable: %s\n", invocation.executable()->builtin().value_or(invocation.executable()->external().value_or("<NONE>")).c_str());
+
+            return false;
+        }
+        executablePaths[i] = *executablePath;
+
+        std::vector<std::string> *command = &commands[i];
+        if (_toolLauncher && invocation.executable()->external()) {
+            /* The launcher runs the tool, taking the tool and its arguments. */
+            command->push_back(Escape::Shell(*_toolLauncher));
+        }
+
+        if (invocation.executable()->builtin() && builtinClientPath) {
+            /* Run builtins through the builtin server, if available. */
+            command->push_back(Escape::Shell(*builtinClientPath));
+            command->push_back(Escape::Shell(builtinServerPath));
+            command->push_back(Escape::Shell(*invocation.executable()->builtin()));
+        } else {
+            command->push_back(Escape::Shell(*executablePath));
+        }
+
+        for (std::string const &arg : invocation.arguments()) {
+            command->push_back(Escape::Shell(arg));
+        }
+    }
+
+    /*
+     * Write arguments shared between invocations once, as variables in this
+     * file. Each invocation's command then only spells out what's its own.
+     */
+    std::vector<SharedArguments> sharedArguments;
+    std::vector<ext::optional<size_t>> sharedAssignments = GroupSharedArguments(commands, &sharedArguments);
+    std::vector<ext::optional<std::string>> sharedNames = std::vector<ext::optional<std::string>>(sharedArguments.size());
+    for (size_t g = 0; g < sharedArguments.size(); ++g) {
+        SharedArguments const &group = sharedArguments[g];
+        if (group.members < 2) {
+            continue;
+        }
+
+        std::vector<std::string> const &reference = commands[group.reference];
+        sharedNames[g] = "shared_exec_" + std::to_string(g);
+        writer.binding({ *sharedNames[g], ninja::Value::String(JoinArguments(reference.begin(), reference.begin() + group.count)) });
+    }
+    writer.newline();
 
     /*
      * Add the build command for each invocation.
      */
-    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+    for (size_t i = 0; i < invocations.size(); ++i) {
+        pbxbuild::Tool::Invocation const &invocation = invocations[i];
+
         /* Write auxiliary files to run first. */
         for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
-            if (!buildAuxiliaryFile(&writer, auxiliaryFile, targetBegin)) {
+            if (!buildAuxiliaryFile(&writer, auxiliaryFile, targetBeginCompile)) {
                 return false;
             }
         }
 
-        // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
         if (invocation.executable()) {
-            /* Find invocation executable. */
-            ext::optional<std::string> executablePath = NinjaExecutablePath(processContext, filesystem, targetEnvironment.executablePaths(), *invocation.executable());
-            if (!executablePath) {
-                fprintf(stderr, "unable to find executable: %s\n", invocation.executable()->builtin().value_or(invocation.executable()->external().value_or("<NONE>")).c_str());
+            std::vector<std::string> const &command = commands[i];
+
+            ninja::Value exec = ninja::Value::String(JoinArguments(command.begin(), command.end()));
+            if (sharedAssignments[i] && sharedNames[*sharedAssignments[i]]) {
+                SharedArguments const &group = sharedArguments[*sharedAssignments[i]];
+                exec = ninja::Value::Expression("${" + *sharedNames[*sharedAssignments[i]] + "}");
+                if (group.count < command.size()) {
+                    exec = exec + ninja::Value::String(" " + JoinArguments(command.begin() + group.count, command.end()));
+                }
+            }
 
+            /* Write invocations to run after auxiliary files; compiles don't wait for the target to begin. */
+            bool compile = (invocation.stage() == pbxbuild::Tool::Invocation::Stage::Compile || invocation.stage() == pbxbuild::Tool::Invocation::Stage::CompileInterface);
+            std::string const &after = (compile ? targetWriteCompileAuxiliaryFiles : targetWriteAuxiliaryFiles);
+            if (!buildInvocation(&writer, invocation, executablePaths[i], exec, dependencyInfoToolPath, actionCacheToolPath, temporaryDirectory, after, TargetNinjaAlwaysOutOfDate(target), dependencyInfoBatch.get())) {
                 return false;
             }
+        }
+    }
 
-            /* Write invocations to run after auxiliary files. */
-            if (!buildInvocation(&writer, invocation, *executablePath, dependencyInfoToolPath, temporaryDirectory, targetWriteAuxiliaryFiles)) {
-                return false;
+    /*
+     * As described above, the target's finish depends on all of the invocation outputs.
+     */
+    std::unordered_set<std::string> invocationOutputs;
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        if (!invocation.executable()) {
+            /* No outputs. */
+            continue;
+        }
+
+        std::vector<std::string> outputs = NinjaInvocationOutputs(invocation);
+        invocationOutputs.insert(outputs.begin(), outputs.end());
+    }
+
+    /*
+     * Add phony rules for input dependencies that we don't know if they exist.
+     * This can come up, for example, for user-specified custom script inputs.
+     * However, avoid adding the phony invocation if a real output *does* include
+     * the phony input, to avoid Ninja complaining about duplicate rules.
+     */
+    std::unordered_set<std::string> phonyInputs;
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        for (std::string const &phonyInput : invocation.phonyInputs()) {
+            if (invocationOutputs.find(phonyInput) == invocationOutputs.end() && phonyInputs.insert(phonyInput).second) {
+                writer.build({ ninja::Value::String(phonyInput) }, "phony", { });
+            }
+        }
+    }
+
+    /*
+     * Add the phony target for invocations that run on every build. It's never created,
+     * so anything depending on it is always out of date.
+     */
+    if (std::any_of(invocations.begin(), invocations.end(), [](pbxbuild::Tool::Invocation const &invocation) { return invocation.alwaysOutOfDate() && !invocation.outputs().empty(); })) {
+        writer.build({ ninja::Value::String(TargetNinjaAlwaysOutOfDate(target)) }, "phony", { });
+    }
+
+    /*
+     * Add the phony target for ending this target's build. Debug symbols are left
+     * out: nothing reads them, so they're still built, but dependents don't wait.
+     */
+    std::string targetFinish = TargetNinjaFinish(target);
+    std::vector<ninja::Value> invocationOutputsValues;
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        if (!invocation.executable() || invocation.stage() == pbxbuild::Tool::Invocation::Stage::Debug) {
+            continue;
+        }
+
+        for (std::string const &output : NinjaInvocationOutputs(invocation)) {
+            invocationOutputsValues.push_back(ninja::Value::String(output));
+        }
+    }
+    writer.build({ ninja::Value::String(targetFinish) }, "phony", { }, { }, invocationOutputsValues);
+
+    /*
+     * Add the phony target for this target's interface: everything it creates, except
+     * compiling sources to link and what's made from linking or anything after it.
+     */
+    std::unordered_set<std::string> productOutputs;
+    std::vector<bool> product = std::vector<bool>(invocations.size(), false);
+    for (size_t i = 0; i < invocations.size(); ++i) {
+        pbxbuild::Tool::Invocation const &invocation = invocations[i];
+        if (invocation.executable() && (invocation.stage() == pbxbuild::Tool::Invocation::Stage::Compile || invocation.stage() == pbxbuild::Tool::Invocation::Stage::Link)) {
+            std::vector<std::string> outputs = NinjaInvocationOutputs(invocation);
+            productOutputs.insert(outputs.begin(), outputs.end());
+            product[i] = true;
+        }
+    }
+
+    for (bool changed = true; changed; ) {
+        changed = false;
+
+        for (size_t i = 0; i < invocations.size(); ++i) {
+            pbxbuild::Tool::Invocation const &invocation = invocations[i];
+            if (product[i] || !invocation.executable()) {
+                continue;
+            }
+
+            for (std::vector<std::string> const *inputs : { &invocation.inputs(), &invocation.inputDependencies(), &invocation.orderDependencies() }) {
+                if (std::any_of(inputs->begin(), inputs->end(), [&](std::string const &input) { return productOutputs.find(input) != productOutputs.end(); })) {
+                    std::vector<std::string> outputs = NinjaInvocationOutputs(invocation);
+                    productOutputs.insert(outputs.begin(), outputs.end());
+                    product[i] = true;
+                    changed = true;
+                    break;
+                }
             }
         }
     }
 
+    std::string targetInterface = TargetNinjaInterface(target);
+    std::vector<ninja::Value> interfaceOutputs = { ninja::Value::String(targetWriteCompileAuxiliaryFiles) };
+    for (size_t i = 0; i < invocations.size(); ++i) {
+        if (!product[i] && invocations[i].executable()) {
+            for (std::string const &output : NinjaInvocationOutputs(invocations[i])) {
+                interfaceOutputs.push_back(ninja::Value::String(output));
+            }
+        }
+    }
+    writer.build({ ninja::Value::String(targetInterface) }, "phony", { }, { }, interfaceOutputs);
+
     /*
      * Serialize the Ninja file into the build root.
      */
@@ -723,6 +1496,18 @@ buildTargetInvocations(
         return false;
     }
 
+    /*
+     * Write out the dependency info to convert after building.
+     */
+    if (_batchDependencyInfo) {
+        std::string dependencyInfoPath = TargetNinjaDependencyInfoPath(target, targetEnvironment);
+        auto serialized = plist::Format::Binary::Serialize(dependencyInfoBatch.get(), plist::Format::Binary::Create());
+        if (serialized.first == nullptr || !filesystem->write(*serialized.first, dependencyInfoPath)) {
+            fprintf(stderr, "error: unable to write target dependency info: %s\n", dependencyInfoPath.c_str());
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -737,10 +1522,13 @@ buildAuxiliaryFile(
     std::vector<ninja::Value> orderDependencies = { ninja::Value::String(after) };
 
     /*
-     * Build up the command to create the auxiliary file.
+     * Build up the command to create the auxiliary file. It's written next to where
+     * it goes, then only replaces the file if it's different; with `restat`, Ninja
+     * then knows invocations using the file don't need to run again.
      */
     std::string escapedPath = Escape::Shell(auxiliaryFile.path());
-    std::string exec = "echo -n > " + escapedPath;
+    std::string escapedTemporaryPath = Escape::Shell(auxiliaryFile.path() + ".ninja-tmp");
+    std::string exec = "echo -n > " + escapedTemporaryPath;
     for (pbxbuild::Tool::Invocation::AuxiliaryFile::Chunk const &chunk : auxiliaryFile.chunks()) {
         exec += " && ";
 
@@ -762,9 +1550,11 @@ buildAuxiliaryFile(
         }
 
         exec += " >> ";
-        exec += escapedPath;
+        exec += escapedTemporaryPath;
     }
 
+    exec += " && if cmp -s " + escapedTemporaryPath + " " + escapedPath + "; then rm " + escapedTemporaryPath + "; else mv " + escapedTemporaryPath + " " + escapedPath + "; fi";
+
     /* Mark the file as executable if necessary. */
     if (auxiliaryFile.executable()) {
         exec += " && ";
@@ -779,7 +1569,7 @@ buildAuxiliaryFile(
         { "description", ninja::Value::String(description) },
         { "dir", ninja::Value::String("/") },
         { "exec", ninja::Value::String(exec) },
-        { "depexec", ninja::Value::String("true") },
+        { "restat", ninja::Value::String("1") },
     };
     writer->build(outputs, NinjaRuleName(), inputs, bindings, { }, orderDependencies);
 
@@ -791,17 +1581,54 @@ buildInvocation(
     ninja::Writer *writer,
     pbxbuild::Tool::Invocation const &invocation,
     std::string const &executablePath,
+    ninja::Value const &command,
     std::string const &dependencyInfoToolPath,
+    ext::optional<std::string> const &actionCacheToolPath,
     std::string const &temporaryDirectory,
-    std::string const &after)
+    std::string const &after,
+    std::string const &alwaysOutOfDate,
+    plist::Array *dependencyInfoBatch)
 {
+    ninja::Value exec = command;
+
     /*
-     * Build the invocation arguments. Must escape for shell arguments as Ninja passes
-     * the command string directly to the shell, which would interpret spaces, etc as meaningful.
+     * Run through the action cache tool, which restores the outputs from the
+     * cache if it can. Like the simple executor, only invocations with both
+     * outputs and declared inputs are cached.
      */
-    std::string exec = Escape::Shell(executablePath);
-    for (std::string const &arg : invocation.arguments()) {
-        exec += " " + Escape::Shell(arg);
+    if (actionCacheToolPath && _actionCache && !invocation.outputs().empty() && (!invocation.inputs().empty() || !invocation.inputDependencies().empty()) && !invocation.alwaysOutOfDate()) {
+        std::vector<std::string> actionCacheArguments = { "--cache", *_actionCache };
+        if (ext::optional<std::string> const &command = invocation.actionCacheCommand()) {
+            actionCacheArguments.push_back("--command-key");
+            actionCacheArguments.push_back(*command);
+        }
+        for (std::vector<std::string> const *inputs : { &invocation.inputs(), &invocation.phonyInputs(), &invocation.inputDependencies() }) {
+            for (std::string const &input : *inputs) {
+                actionCacheArguments.push_back("--input");
+                actionCacheArguments.push_back(input);
+            }
+        }
+        for (std::string const &output : invocation.outputs()) {
+            actionCacheArguments.push_back("--output");
+            actionCacheArguments.push_back(output);
+        }
+        for (pbxbuild::Tool::Invocation::DependencyInfo const &info : invocation.dependencyInfo()) {
+            std::string formatName;
+            if (!dependency::DependencyInfoFormats::Name(info.format(), &formatName)) {
+                return false;
+            }
+
+            actionCacheArguments.push_back("--dependency-info");
+            actionCacheArguments.push_back(formatName + ":" + info.path());
+        }
+        actionCacheArguments.push_back("--");
+
+        std::string actionCacheExec = Escape::Shell(*actionCacheToolPath);
+        for (std::string const &arg : actionCacheArguments) {
+            actionCacheExec += " ";
+            Escape::Shell(arg, &actionCacheExec);
+        }
+        exec = ninja::Value::String(actionCacheExec + " ") + exec;
     }
 
     /*
@@ -814,7 +1641,9 @@ buildInvocation(
         if (it != invocation.environment().begin()) {
             environment += " ";
         }
-        environment += it->first + "=" + Escape::Shell(it->second);
+        environment += it->first;
+        environment += "=";
+        Escape::Shell(it->second, &environment);
     }
 
     /*
@@ -823,61 +1652,113 @@ buildInvocation(
     std::string executableDisplayName = invocation.executable()->builtin().value_or(executablePath);
     std::string description = NinjaDescription(_formatter->beginInvocation(invocation, executableDisplayName, false));
 
-    /*
-     * Add the dependency info converter & file.
-     */
-    std::string dependencyInfoFile;
-    std::string dependencyInfoExec;
-
-    if (!invocation.dependencyInfo().empty()) {
-        /* Determine the first output; Ninja expects that as the Makefile rule. */
-        std::string output = NinjaInvocationOutputs(invocation).front();
-
-        /* Find where the generated dependency info should go. */
-        dependencyInfoFile = temporaryDirectory + "/" + ".ninja-dependency-info-" + NinjaHash(output) + ".d";
-
-        /* Build the dependency info rewriter arguments. */
-        std::vector<std::string> dependencyInfoArguments = {
-            "--name", output,
-            "--output", dependencyInfoFile,
-        };
-
-        /* Add the input for each dependency info. */
-        for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
-            std::string formatName;
-            if (!dependency::DependencyInfoFormats::Name(dependencyInfo.format(), &formatName)) {
-                return false;
-            }
-
-            dependencyInfoArguments.push_back(formatName + ":" + dependencyInfo.path());
-        }
-
-        /* Create the command for converting the dependency info. */
-        dependencyInfoExec = Escape::Shell(dependencyInfoToolPath);
-        for (std::string const &arg : dependencyInfoArguments) {
-            dependencyInfoExec += " " + Escape::Shell(arg);
-        }
-    } else {
-        // TODO(grp): Avoid the need for an empty dependency info command if not used.
-        dependencyInfoExec = "true";
-    }
-
     /*
      * Build up the bindings for the invocation.
      */
+    std::string rule = NinjaRuleName();
     std::vector<ninja::Binding> bindings = {
         { "description", ninja::Value::String(description) },
         { "dir", ninja::Value::String(Escape::Shell(invocation.workingDirectory())) },
-        { "exec", ninja::Value::String(exec) },
+        { "exec", exec },
     };
     if (!environment.empty()) {
         bindings.push_back({ "env", ninja::Value::String(environment) });
     }
-    if (!dependencyInfoExec.empty()) {
-        bindings.push_back({ "depexec", ninja::Value::String(dependencyInfoExec) });
+
+    /*
+     * Builtin tools can leave outputs that wouldn't change untouched, such as headers
+     * copied again, as can some external tools. Check so invocations using them don't
+     * run again either.
+     */
+    if (invocation.executable()->builtin() || invocation.keepsUnchangedOutputs()) {
+        bindings.push_back({ "restat", ninja::Value::String("1") });
     }
-    if (!dependencyInfoFile.empty()) {
-        bindings.push_back({ "depfile", ninja::Value::String(dependencyInfoFile) });
+
+    /*
+     * Limit concurrency of the tool, if it's in a pool.
+     */
+    for (Pool const &pool : _pools) {
+        if (std::find(pool.tools().begin(), pool.tools().end(), invocation.toolIdentifier()) != pool.tools().end()) {
+            bindings.push_back({ "pool", ninja::Value::String(pool.name()) });
+            break;
+        }
+    }
+
+    /*
+     * Add the dependency info converter & file.
+     */
+    if (!invocation.dependencyInfo().empty()) {
+        std::vector<pbxbuild::Tool::Invocation::DependencyInfo> const &dependencyInfo = invocation.dependencyInfo();
+
+        /* Determine the first output; Ninja expects that as the Makefile rule. */
+        std::string output = NinjaInvocationOutputs(invocation).front();
+
+        if (_batchDependencyInfo && dependencyInfo.size() == 1 && dependencyInfo.front().format() == dependency::DependencyInfoFormat::Makefile) {
+            /*
+             * Ninja reads Makefile dependency info itself; the compiler output
+             * needs no conversion. Ninja records it in its dependency log.
+             */
+            bindings.push_back({ "depfile", ninja::Value::String(FSUtil::ResolveRelativePath(dependencyInfo.front().path(), invocation.workingDirectory())) });
+            bindings.push_back({ "deps", ninja::Value::String("gcc") });
+        } else {
+            /* Find where the generated dependency info should go. */
+            std::string dependencyInfoFile = temporaryDirectory + "/" + ".ninja-dependency-info-" + NinjaHash(output) + ".d";
+            bindings.push_back({ "depfile", ninja::Value::String(dependencyInfoFile) });
+
+            if (_batchDependencyInfo) {
+                /*
+                 * Convert all together after the build, straight into Ninja's
+                 * dependency log. The depfile is never written; Ninja treats
+                 * it as empty, then loads the converted dependencies.
+                 */
+                bindings.push_back({ "deps", ninja::Value::String("gcc") });
+
+                std::unique_ptr<plist::Array> inputs = plist::Array::New();
+                for (pbxbuild::Tool::Invocation::DependencyInfo const &info : dependencyInfo) {
+                    std::string formatName;
+                    if (!dependency::DependencyInfoFormats::Name(info.format(), &formatName)) {
+                        return false;
+                    }
+
+                    std::unique_ptr<plist::Dictionary> input = plist::Dictionary::New();
+                    input->set("Format", plist::String::New(formatName));
+                    input->set("Path", plist::String::New(info.path()));
+                    inputs->append(std::move(input));
+                }
+
+                std::unique_ptr<plist::Dictionary> entry = plist::Dictionary::New();
+                entry->set("Output", plist::String::New(output));
+                entry->set("Directory", plist::String::New(invocation.workingDirectory()));
+                entry->set("Inputs", std::move(inputs));
+                dependencyInfoBatch->append(std::move(entry));
+            } else {
+                /* Build the dependency info rewriter arguments. */
+                std::vector<std::string> dependencyInfoArguments = {
+                    "--name", output,
+                    "--output", dependencyInfoFile,
+                };
+
+                /* Add the input for each dependency info. */
+                for (pbxbuild::Tool::Invocation::DependencyInfo const &info : dependencyInfo) {
+                    std::string formatName;
+                    if (!dependency::DependencyInfoFormats::Name(info.format(), &formatName)) {
+                        return false;
+                    }
+
+                    dependencyInfoArguments.push_back(formatName + ":" + info.path());
+                }
+
+                /* Create the command for converting the dependency info. */
+                std::string dependencyInfoExec = Escape::Shell(dependencyInfoToolPath);
+                for (std::string const &arg : dependencyInfoArguments) {
+                    dependencyInfoExec += " ";
+                    Escape::Shell(arg, &dependencyInfoExec);
+                }
+
+                rule = NinjaDependencyInfoRuleName();
+                bindings.push_back({ "depexec", ninja::Value::String(dependencyInfoExec) });
+            }
+        }
     }
 
     /*
@@ -896,6 +1777,14 @@ buildInvocation(
         inputs.push_back(ninja::Value::String(input));
     }
 
+    /*
+     * Inputs that may not exist have phony rules; Ninja considers those out of date
+     * when they're missing, so the invocation runs until they exist.
+     */
+    for (std::string const &phonyInput : invocation.phonyInputs()) {
+        inputs.push_back(ninja::Value::String(phonyInput));
+    }
+
     /*
      * Build up input dependencies as literal Ninja values.
      */
@@ -904,6 +1793,14 @@ buildInvocation(
         inputDependencies.push_back(ninja::Value::String(inputDependency));
     }
 
+    /*
+     * Invocations without outputs are always out of date already, since their phony
+     * output is never created. Others depend on a target that's never created.
+     */
+    if (invocation.alwaysOutOfDate() && !invocation.outputs().empty()) {
+        inputDependencies.push_back(ninja::Value::String(alwaysOutOfDate));
+    }
+
     /*
      * Build up order dependencies as literal Ninja values.
      */
@@ -920,17 +1817,22 @@ buildInvocation(
     /*
      * Add the rule to build this invocation.
      */
-    writer->build(outputs, NinjaRuleName(), inputs, bindings, inputDependencies, orderDependencies);
+    writer->build(outputs, rule, inputs, bindings, inputDependencies, orderDependencies);
 
     return true;
 }
 
 std::unique_ptr<NinjaExecutor> NinjaExecutor::
-Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate)
+Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, bool batchDependencyInfo, ext::optional<std::string> const &actionCache, ext::optional<std::string> const &toolLauncher, std::vector<Pool> const &pools, std::shared_ptr<Trace> const &trace)
 {
     return std::unique_ptr<NinjaExecutor>(new NinjaExecutor(
         formatter,
         dryRun,
-        generate
+        generate,
+        batchDependencyInfo,
+        actionCache,
+        toolLauncher,
+        pools,
+        trace
     ));
 }
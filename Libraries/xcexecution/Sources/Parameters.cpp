@@ -8,18 +8,29 @@
  */
 
 #include <xcexecution/Parameters.h>
+#include <xcexecution/AffectedTargets.h>
+#include <xcexecution/Resident.h>
 
 #include <pbxbuild/Build/DependencyResolver.h>
+#include <pbxbuild/DerivedDataHash.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Statistic.h>
 #include <libutil/md5.h>
 
 #include <sstream>
+#include <unordered_map>
 #include <iomanip>
 
 using xcexecution::Parameters;
+using xcexecution::AffectedTargets;
+using xcexecution::Resident;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Statistic;
+
+static Statistic LoadWorkspaceTime("xcexecution", "Load workspace");
+static Statistic PrebuiltTargets("xcexecution", "Prebuilt targets reused");
 
 Parameters::
 Parameters(
@@ -28,6 +39,8 @@ Parameters(
     ext::optional<std::string> const &scheme,
     ext::optional<std::vector<std::string>> const &target,
     bool allTargets,
+    bool prebuiltDependencies,
+    ext::optional<std::vector<std::string>> const &changedPaths,
     std::vector<std::string> const &actions,
     ext::optional<std::string> const &configuration,
     std::vector<pbxsetting::Level> const &overrideLevels) :
@@ -36,6 +49,8 @@ Parameters(
     _scheme        (scheme),
     _target        (target),
     _allTargets    (allTargets),
+    _prebuiltDependencies(prebuiltDependencies),
+    _changedPaths  (changedPaths),
     _actions       (actions),
     _configuration (configuration),
     _overrideLevels(overrideLevels)
@@ -78,6 +93,19 @@ canonicalArguments() const
         arguments.push_back(*_configuration);
     }
 
+    if (_prebuiltDependencies) {
+        arguments.push_back("-prebuiltDependencies");
+    }
+
+    if (_changedPaths) {
+        /* Even with no paths, nothing is built rather than everything. */
+        arguments.push_back("-changedPaths");
+        for (std::string const &changedPath : *_changedPaths) {
+            arguments.push_back("-changedPath");
+            arguments.push_back(changedPath);
+        }
+    }
+
     for (std::string const &action : _actions) {
         arguments.push_back(action);
     }
@@ -151,25 +179,80 @@ OpenProject(Filesystem const *filesystem, ext::optional<std::string> const &proj
     }
 }
 
+ext::optional<pbxsetting::Environment> Parameters::
+buildLevelEnvironment(Filesystem const *filesystem, pbxbuild::Build::Environment const &buildEnvironment) const
+{
+    ext::optional<std::string> const &workspace = (_workspace ? _workspace : _project);
+    if (!workspace) {
+        return ext::nullopt;
+    }
+
+    std::string workspacePath = filesystem->resolvePath(*workspace);
+    pbxbuild::DerivedDataHash derivedDataHash = pbxbuild::DerivedDataHash::Create(workspacePath);
+
+    pbxsetting::Environment environment = pbxsetting::Environment(buildEnvironment.baseEnvironment());
+    environment.insertFront(pbxsetting::Level(derivedDataHash.overrideSettings()), false);
+    for (pbxsetting::Level const &level : _overrideLevels) {
+        environment.insertFront(level, false);
+    }
+
+    return environment;
+}
+
+ext::optional<std::string> Parameters::
+intermediatesDirectory(Filesystem const *filesystem, pbxbuild::Build::Environment const &buildEnvironment) const
+{
+    ext::optional<pbxsetting::Environment> environment = buildLevelEnvironment(filesystem, buildEnvironment);
+    if (!environment) {
+        return ext::nullopt;
+    }
+
+    return environment->resolve("OBJROOT");
+}
+
+ext::optional<std::string> Parameters::
+buildSessionFile(Filesystem const *filesystem, pbxbuild::Build::Environment const &buildEnvironment) const
+{
+    ext::optional<pbxsetting::Environment> environment = buildLevelEnvironment(filesystem, buildEnvironment);
+    if (!environment) {
+        return ext::nullopt;
+    }
+
+    std::string path = environment->resolve("CLANG_MODULES_BUILD_SESSION_FILE");
+    if (path.empty()) {
+        return ext::nullopt;
+    }
+
+    return path;
+}
+
 ext::optional<pbxbuild::WorkspaceContext> Parameters::
 loadWorkspace(Filesystem const *filesystem, std::string const &userName, pbxbuild::Build::Environment const &buildEnvironment, std::string const &workingDirectory) const
 {
-    if (_workspace) {
-        xcworkspace::XC::Workspace::shared_ptr workspace = xcworkspace::XC::Workspace::Open(filesystem, *_workspace);
-        if (workspace == nullptr) {
-            fprintf(stderr, "error: unable to open workspace '%s'\n", _workspace->c_str());
-            return ext::nullopt;
-        }
+    Statistic::Timer timer(&LoadWorkspaceTime);
+
+    /* Relative paths and the project found in a directory depend on the working directory. */
+    std::string key = (_workspace ? "workspace:" + *_workspace : "project:" + _project.value_or(std::string()));
+    key += '\0' + workingDirectory + '\0' + userName;
+
+    return Resident::Workspace(filesystem, key, buildEnvironment.baseEnvironment(), [&]() -> ext::optional<pbxbuild::WorkspaceContext> {
+        if (_workspace) {
+            xcworkspace::XC::Workspace::shared_ptr workspace = xcworkspace::XC::Workspace::Open(filesystem, *_workspace);
+            if (workspace == nullptr) {
+                fprintf(stderr, "error: unable to open workspace '%s'\n", _workspace->c_str());
+                return ext::nullopt;
+            }
 
-        return pbxbuild::WorkspaceContext::Workspace(filesystem, userName, buildEnvironment.baseEnvironment(), workspace);
-    } else {
-        pbxproj::PBX::Project::shared_ptr project = OpenProject(filesystem, _project, workingDirectory);
-        if (project == nullptr) {
-            return ext::nullopt;
-        }
+            return pbxbuild::WorkspaceContext::Workspace(filesystem, userName, buildEnvironment.baseEnvironment(), workspace);
+        } else {
+            pbxproj::PBX::Project::shared_ptr project = OpenProject(filesystem, _project, workingDirectory);
+            if (project == nullptr) {
+                return ext::nullopt;
+            }
 
-        return pbxbuild::WorkspaceContext::Project(filesystem, userName, buildEnvironment.baseEnvironment(), project);
-    }
+            return pbxbuild::WorkspaceContext::Project(filesystem, userName, buildEnvironment.baseEnvironment(), project);
+        }
+    });
 }
 
 ext::optional<pbxbuild::Build::Context> Parameters::
@@ -177,7 +260,7 @@ createBuildContext(pbxbuild::WorkspaceContext const &workspaceContext) const
 {
     std::vector<std::string> actions = (!_actions.empty() ? _actions : std::vector<std::string>({ "build" }));
     std::string action = actions.front(); // TODO(grp): Support multiple actions and skipUnavailableOptions.
-    if (action != "build") {
+    if (action != "build" && action != "build-for-testing" && action != "test" && action != "test-without-building") {
         fprintf(stderr, "error: action '%s' is not implemented\n", action.c_str());
         return ext::nullopt;
     }
@@ -186,13 +269,7 @@ createBuildContext(pbxbuild::WorkspaceContext const &workspaceContext) const
     xcscheme::XC::Scheme::shared_ptr scheme = nullptr;
     xcscheme::SchemeGroup::shared_ptr schemeGroup = nullptr;
     if (_scheme) {
-        for (xcscheme::SchemeGroup::shared_ptr const &schemeGroup_ : workspaceContext.schemeGroups()) {
-            if (xcscheme::XC::Scheme::shared_ptr scheme_ = schemeGroup_->scheme(*_scheme)) {
-                scheme = scheme_;
-                schemeGroup = schemeGroup_;
-            }
-        }
-
+        scheme = workspaceContext.scheme(*_scheme, &schemeGroup);
         if (scheme == nullptr || schemeGroup == nullptr) {
             fprintf(stderr, "error: unable to find scheme '%s'\n", _scheme->c_str());
             return ext::nullopt;
@@ -238,17 +315,56 @@ createBuildContext(pbxbuild::WorkspaceContext const &workspaceContext) const
 }
 
 ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> Parameters::
-resolveDependencies(pbxbuild::Build::Environment const &buildEnvironment, pbxbuild::Build::Context const &buildContext) const
+resolveDependencies(Filesystem const *filesystem, pbxbuild::Build::Environment const &buildEnvironment, pbxbuild::Build::Context const &buildContext) const
 {
-    pbxbuild::Build::DependencyResolver resolver = pbxbuild::Build::DependencyResolver(buildEnvironment);
+    /*
+     * A dependency is prebuilt if its product is where this build would put
+     * it. Whether it's up to date isn't checked: that would mean planning it.
+     */
+    std::unordered_map<pbxproj::PBX::Target::shared_ptr, bool> prebuiltTargets;
+    auto prebuilt = [&](pbxproj::PBX::Target::shared_ptr const &target) -> bool {
+        auto it = prebuiltTargets.find(target);
+        if (it != prebuiltTargets.end()) {
+            return it->second;
+        }
+
+        bool exists = false;
+        if (target->type() == pbxproj::PBX::Target::Type::Native) {
+            pbxproj::PBX::NativeTarget::shared_ptr nativeTarget = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target);
+            if (nativeTarget->productReference() != nullptr) {
+                if (ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target)) {
+                    pbxsetting::Environment const &environment = targetEnvironment->environment();
+                    exists = filesystem->exists(environment.resolve("BUILT_PRODUCTS_DIR") + "/" + environment.resolve("FULL_PRODUCT_NAME"));
+                }
+            }
+        }
 
+        if (exists) {
+            PrebuiltTargets.increment();
+        }
+
+        prebuiltTargets.insert({ target, exists });
+        return exists;
+    };
+
+    pbxbuild::Build::DependencyResolver resolver = pbxbuild::Build::DependencyResolver(
+        buildEnvironment,
+        (_prebuiltDependencies ? pbxbuild::Build::DependencyResolver::Prebuilt(prebuilt) : nullptr));
+
+    ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> targetGraph;
     if (buildContext.scheme() != nullptr) {
-        return resolver.resolveSchemeDependencies(buildContext);
+        targetGraph = resolver.resolveSchemeDependencies(buildContext, _target);
     } else if (buildContext.workspaceContext().project() != nullptr) {
-        return resolver.resolveLegacyDependencies(buildContext, _allTargets, _target);
+        targetGraph = resolver.resolveLegacyDependencies(buildContext, _allTargets, _target);
     } else {
         fprintf(stderr, "error: scheme is required for workspace\n");
         return ext::nullopt;
     }
+
+    if (targetGraph && _changedPaths) {
+        targetGraph = AffectedTargets::Select(filesystem, buildEnvironment, buildContext, *targetGraph, *_changedPaths);
+    }
+
+    return targetGraph;
 }
 
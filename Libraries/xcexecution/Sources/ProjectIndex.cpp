@@ -0,0 +1,610 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/ProjectIndex.h>
+#include <pbxbuild/Build/Context.h>
+#include <pbxbuild/Build/Environment.h>
+#include <pbxbuild/Phase/Environment.h>
+#include <pbxbuild/Phase/File.h>
+#include <pbxbuild/Target/Environment.h>
+#include <pbxbuild/WorkspaceContext.h>
+#include <libutil/FSUtil.h>
+
+#include <algorithm>
+#include <set>
+
+#include <cstring>
+
+using xcexecution::ProjectIndex;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+/*
+ * An index is this header, the number of projects, then a directory with
+ * an entry for each project sorted by path, then the paths and records the
+ * entries point to. Each entry is the offset and size of the path, then of
+ * the record, as little endian 32 bit numbers. Within records, numbers are
+ * variable length, strings are a length then their bytes, and lists are a
+ * count then their items.
+ */
+static char const IndexHeader[] = "xcbuild index 1\n";
+
+static size_t const IndexHeaderSize = sizeof(IndexHeader) - 1;
+static size_t const IndexEntrySize  = 4 * sizeof(uint32_t);
+
+namespace {
+
+class IndexWriter {
+private:
+    std::vector<uint8_t> _data;
+
+public:
+    void number(uint64_t value)
+    {
+        while (value >= 0x80) {
+            _data.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        _data.push_back(static_cast<uint8_t>(value));
+    }
+
+    void string(std::string const &value)
+    {
+        number(value.size());
+        _data.insert(_data.end(), value.begin(), value.end());
+    }
+
+    void strings(std::vector<std::string> const &values)
+    {
+        number(values.size());
+        for (std::string const &value : values) {
+            string(value);
+        }
+    }
+
+public:
+    std::vector<uint8_t> const &data() const
+    { return _data; }
+};
+
+class IndexReader {
+private:
+    uint8_t const *_data;
+    uint8_t const *_end;
+    bool           _valid;
+
+public:
+    IndexReader(uint8_t const *data, size_t size) :
+        _data (data),
+        _end  (data + size),
+        _valid(true)
+    {
+    }
+
+public:
+    bool finished() const
+    { return _valid && _data == _end; }
+
+public:
+    uint64_t number()
+    {
+        uint64_t value = 0;
+        for (unsigned int shift = 0; _valid; shift += 7) {
+            if (_data == _end || shift >= 64) {
+                _valid = false;
+                break;
+            }
+
+            uint8_t byte = *_data++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        return 0;
+    }
+
+    /*
+     * A count of items each taking at least a byte, so a corrupt count
+     * fails before anything is allocated for it.
+     */
+    size_t count()
+    {
+        uint64_t value = number();
+        if (value > static_cast<uint64_t>(_end - _data)) {
+            _valid = false;
+            return 0;
+        }
+        return static_cast<size_t>(value);
+    }
+
+    std::string string()
+    {
+        size_t size = count();
+        if (!_valid) {
+            return std::string();
+        }
+
+        std::string value = std::string(reinterpret_cast<char const *>(_data), size);
+        _data += size;
+        return value;
+    }
+
+    std::vector<std::string> strings()
+    {
+        std::vector<std::string> values = std::vector<std::string>(count());
+        for (std::string &value : values) {
+            value = string();
+        }
+        return values;
+    }
+};
+
+}
+
+static void
+AppendWord(std::vector<uint8_t> *data, uint32_t value)
+{
+    for (size_t i = 0; i < sizeof(uint32_t); ++i) {
+        data->push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+static void
+StoreWord(std::vector<uint8_t> *data, size_t offset, uint32_t value)
+{
+    for (size_t i = 0; i < sizeof(uint32_t); ++i) {
+        (*data)[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+static uint32_t
+LoadWord(uint8_t const *data)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i < sizeof(uint32_t); ++i) {
+        value |= static_cast<uint32_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+ProjectIndex::BuildFile::
+BuildFile(std::string const &path, std::string const &fileType, std::string const &phase) :
+    _path    (path),
+    _fileType(fileType),
+    _phase   (phase)
+{
+}
+
+ProjectIndex::Target::
+Target(
+    std::string const &name,
+    std::string const &productType,
+    std::vector<std::string> const &configurations,
+    std::vector<BuildFile> const &buildFiles,
+    std::vector<std::pair<std::string, std::string>> const &settings) :
+    _name          (name),
+    _productType   (productType),
+    _configurations(configurations),
+    _buildFiles    (buildFiles),
+    _settings      (settings)
+{
+}
+
+ProjectIndex::Project::
+Project(
+    std::string const &path,
+    std::string const &name,
+    std::vector<std::string> const &configurations,
+    std::string const &defaultConfiguration,
+    std::vector<std::string> const &projectReferences,
+    std::vector<Target> const &targets,
+    std::vector<std::pair<std::string, uint64_t>> const &inputs) :
+    _path                (path),
+    _name                (name),
+    _configurations      (configurations),
+    _defaultConfiguration(defaultConfiguration),
+    _projectReferences   (projectReferences),
+    _targets             (targets),
+    _inputs              (inputs)
+{
+}
+
+bool ProjectIndex::Project::
+upToDate(Filesystem const *filesystem) const
+{
+    for (std::pair<std::string, uint64_t> const &input : _inputs) {
+        /* Missing inputs are recorded as zero, so creating them is a change. */
+        if (filesystem->modificationTime(input.first).value_or(0) != input.second) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static std::vector<std::string>
+ConfigurationNames(pbxproj::XC::ConfigurationList::shared_ptr const &configurationList)
+{
+    std::vector<std::string> names;
+    if (configurationList != nullptr) {
+        for (pbxproj::XC::BuildConfiguration::shared_ptr const &buildConfiguration : configurationList->buildConfigurations()) {
+            names.push_back(buildConfiguration->name());
+        }
+    }
+    return names;
+}
+
+static void
+AddConfigInputs(std::set<std::string> *inputs, pbxsetting::XC::Config const &config)
+{
+    inputs->insert(config.path());
+
+    for (pbxsetting::XC::Config::Entry const &entry : config.contents()) {
+        if (entry.type() == pbxsetting::XC::Config::Entry::Type::Include && entry.config() != nullptr) {
+            AddConfigInputs(inputs, *entry.config());
+        }
+    }
+}
+
+static void
+AddConfigurationListInputs(std::set<std::string> *inputs, pbxbuild::WorkspaceContext const &workspaceContext, pbxproj::XC::ConfigurationList::shared_ptr const &configurationList)
+{
+    if (configurationList == nullptr) {
+        return;
+    }
+
+    for (pbxproj::XC::BuildConfiguration::shared_ptr const &buildConfiguration : configurationList->buildConfigurations()) {
+        if (ext::optional<pbxsetting::XC::Config> config = workspaceContext.config(buildConfiguration)) {
+            AddConfigInputs(inputs, *config);
+        }
+    }
+}
+
+ext::optional<ProjectIndex::Project> ProjectIndex::Project::
+Create(
+    Filesystem const *filesystem,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    pbxbuild::WorkspaceContext const &workspaceContext,
+    pbxproj::PBX::Project::shared_ptr const &project)
+{
+    if (project == nullptr) {
+        return ext::nullopt;
+    }
+
+    std::set<std::string> inputs;
+    inputs.insert(project->dataFile());
+    AddConfigurationListInputs(&inputs, workspaceContext, project->buildConfigurationList());
+
+    std::string defaultConfiguration;
+    if (project->buildConfigurationList() != nullptr) {
+        defaultConfiguration = project->buildConfigurationList()->defaultConfigurationName();
+    }
+
+    /* Nested projects are found as when loading the workspace. */
+    pbxsetting::Environment projectEnvironment = pbxsetting::Environment(buildEnvironment.baseEnvironment());
+    projectEnvironment.insertFront(project->settings(), false);
+
+    std::vector<std::string> projectReferences;
+    for (pbxproj::PBX::Project::ProjectReference const &projectReference : project->projectReferences()) {
+        projectReferences.push_back(FSUtil::NormalizePath(projectEnvironment.expand(projectReference.projectReference()->resolve())));
+    }
+
+    pbxbuild::Build::Context buildContext = pbxbuild::Build::Context(
+        workspaceContext,
+        nullptr,
+        nullptr,
+        "build",
+        defaultConfiguration,
+        true,
+        { });
+
+    std::vector<Target> targets;
+    for (pbxproj::PBX::Target::shared_ptr const &target : project->targets()) {
+        AddConfigurationListInputs(&inputs, workspaceContext, target->buildConfigurationList());
+
+        std::string productType;
+        if (target->type() == pbxproj::PBX::Target::Type::Native) {
+            productType = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target)->productType();
+        }
+
+        /*
+         * Without a configuration or a known SDK, there is nothing to
+         * resolve settings or paths with; still note the target.
+         */
+        std::vector<BuildFile> buildFiles;
+        std::vector<std::pair<std::string, std::string>> settings;
+        ext::optional<pbxbuild::Target::Environment> targetEnvironment;
+        if (!defaultConfiguration.empty()) {
+            targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
+        }
+
+        if (targetEnvironment) {
+            /* Settings also come from the SDK. */
+            inputs.insert(targetEnvironment->sdk()->path());
+
+            pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
+            for (pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase : target->buildPhases()) {
+                for (pbxbuild::Phase::File const &file : pbxbuild::Phase::File::ResolveBuildFiles(filesystem, phaseEnvironment, buildPhase->files())) {
+                    std::string fileType = (file.fileType() != nullptr ? file.fileType()->identifier() : std::string());
+                    buildFiles.push_back(BuildFile(file.path(), fileType, buildPhase->isa()));
+                }
+            }
+
+            pbxsetting::Environment const &environment = targetEnvironment->environment();
+            for (std::string const &name : Settings()) {
+                std::string value = environment.resolve(name);
+                if (!value.empty()) {
+                    settings.push_back({ name, value });
+                }
+            }
+        }
+
+        targets.push_back(Target(target->name(), productType, ConfigurationNames(target->buildConfigurationList()), buildFiles, settings));
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> inputTimes;
+    for (std::string const &input : inputs) {
+        inputTimes.push_back({ input, filesystem->modificationTime(input).value_or(0) });
+    }
+
+    return Project(
+        FSUtil::NormalizePath(project->projectFile()),
+        project->name(),
+        ConfigurationNames(project->buildConfigurationList()),
+        defaultConfiguration,
+        projectReferences,
+        targets,
+        inputTimes);
+}
+
+ProjectIndex::
+ProjectIndex(std::unique_ptr<Filesystem::Mapping> mapping, uint32_t count) :
+    _mapping(std::move(mapping)),
+    _count  (count)
+{
+}
+
+ProjectIndex::
+~ProjectIndex()
+{
+}
+
+static std::string
+EntryString(Filesystem::Mapping const &mapping, uint32_t index, size_t field)
+{
+    uint8_t const *entry = mapping.data() + IndexHeaderSize + sizeof(uint32_t) + index * IndexEntrySize;
+    uint32_t offset = LoadWord(entry + field * 2 * sizeof(uint32_t));
+    uint32_t size   = LoadWord(entry + field * 2 * sizeof(uint32_t) + sizeof(uint32_t));
+    return std::string(reinterpret_cast<char const *>(mapping.data() + offset), size);
+}
+
+std::vector<std::string> ProjectIndex::
+projectPaths() const
+{
+    std::vector<std::string> paths;
+    for (uint32_t index = 0; index < _count; ++index) {
+        paths.push_back(EntryString(*_mapping, index, 0));
+    }
+    return paths;
+}
+
+static ext::optional<ProjectIndex::Project>
+DecodeProject(std::string const &path, std::string const &record)
+{
+    IndexReader reader = IndexReader(reinterpret_cast<uint8_t const *>(record.data()), record.size());
+
+    std::string name = reader.string();
+    std::vector<std::string> configurations = reader.strings();
+    std::string defaultConfiguration = reader.string();
+    std::vector<std::string> projectReferences = reader.strings();
+
+    std::vector<std::pair<std::string, uint64_t>> inputs = std::vector<std::pair<std::string, uint64_t>>(reader.count());
+    for (std::pair<std::string, uint64_t> &input : inputs) {
+        input.first = reader.string();
+        input.second = reader.number();
+    }
+
+    std::vector<ProjectIndex::Target> targets;
+    for (size_t count = reader.count(), i = 0; i < count; ++i) {
+        std::string targetName = reader.string();
+        std::string productType = reader.string();
+        std::vector<std::string> targetConfigurations = reader.strings();
+
+        std::vector<ProjectIndex::BuildFile> buildFiles;
+        for (size_t fileCount = reader.count(), j = 0; j < fileCount; ++j) {
+            std::string filePath = reader.string();
+            std::string fileType = reader.string();
+            std::string phase = reader.string();
+            buildFiles.push_back(ProjectIndex::BuildFile(filePath, fileType, phase));
+        }
+
+        std::vector<std::pair<std::string, std::string>> settings = std::vector<std::pair<std::string, std::string>>(reader.count());
+        for (std::pair<std::string, std::string> &setting : settings) {
+            setting.first = reader.string();
+            setting.second = reader.string();
+        }
+
+        targets.push_back(ProjectIndex::Target(targetName, productType, targetConfigurations, buildFiles, settings));
+    }
+
+    if (!reader.finished()) {
+        return ext::nullopt;
+    }
+
+    return ProjectIndex::Project(path, name, configurations, defaultConfiguration, projectReferences, targets, inputs);
+}
+
+ext::optional<ProjectIndex::Project> ProjectIndex::
+project(std::string const &path) const
+{
+    uint32_t low = 0;
+    uint32_t high = _count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        int comparison = EntryString(*_mapping, middle, 0).compare(path);
+        if (comparison == 0) {
+            return DecodeProject(path, EntryString(*_mapping, middle, 1));
+        } else if (comparison < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return ext::nullopt;
+}
+
+std::vector<std::string> const &ProjectIndex::
+Settings()
+{
+    static std::vector<std::string> const settings = {
+        "PRODUCT_NAME",
+        "PRODUCT_BUNDLE_IDENTIFIER",
+        "FULL_PRODUCT_NAME",
+        "BUILT_PRODUCTS_DIR",
+        "SDKROOT",
+        "ARCHS",
+        "INFOPLIST_FILE",
+        "HEADER_SEARCH_PATHS",
+        "USER_HEADER_SEARCH_PATHS",
+        "FRAMEWORK_SEARCH_PATHS",
+        "GCC_PREPROCESSOR_DEFINITIONS",
+        "OTHER_CFLAGS",
+        "OTHER_CPLUSPLUSFLAGS",
+        "CLANG_CXX_LANGUAGE_STANDARD",
+        "SWIFT_VERSION",
+    };
+    return settings;
+}
+
+static std::vector<uint8_t>
+EncodeProject(ProjectIndex::Project const &project)
+{
+    IndexWriter writer;
+
+    writer.string(project.name());
+    writer.strings(project.configurations());
+    writer.string(project.defaultConfiguration());
+    writer.strings(project.projectReferences());
+
+    writer.number(project.inputs().size());
+    for (std::pair<std::string, uint64_t> const &input : project.inputs()) {
+        writer.string(input.first);
+        writer.number(input.second);
+    }
+
+    writer.number(project.targets().size());
+    for (ProjectIndex::Target const &target : project.targets()) {
+        writer.string(target.name());
+        writer.string(target.productType());
+        writer.strings(target.configurations());
+
+        writer.number(target.buildFiles().size());
+        for (ProjectIndex::BuildFile const &buildFile : target.buildFiles()) {
+            writer.string(buildFile.path());
+            writer.string(buildFile.fileType());
+            writer.string(buildFile.phase());
+        }
+
+        writer.number(target.settings().size());
+        for (std::pair<std::string, std::string> const &setting : target.settings()) {
+            writer.string(setting.first);
+            writer.string(setting.second);
+        }
+    }
+
+    return writer.data();
+}
+
+std::vector<uint8_t> ProjectIndex::
+Serialize(std::vector<Project> projects)
+{
+    std::sort(projects.begin(), projects.end(), [](Project const &a, Project const &b) -> bool {
+        return a.path() < b.path();
+    });
+
+    std::vector<uint8_t> data = std::vector<uint8_t>(IndexHeader, IndexHeader + IndexHeaderSize);
+    AppendWord(&data, static_cast<uint32_t>(projects.size()));
+
+    /* Fill in the directory once the offsets are known. */
+    size_t directory = data.size();
+    data.resize(data.size() + projects.size() * IndexEntrySize);
+
+    for (size_t index = 0; index < projects.size(); ++index) {
+        size_t entry = directory + index * IndexEntrySize;
+        std::string const &path = projects[index].path();
+
+        StoreWord(&data, entry, static_cast<uint32_t>(data.size()));
+        StoreWord(&data, entry + sizeof(uint32_t), static_cast<uint32_t>(path.size()));
+        data.insert(data.end(), path.begin(), path.end());
+
+        std::vector<uint8_t> record = EncodeProject(projects[index]);
+        StoreWord(&data, entry + 2 * sizeof(uint32_t), static_cast<uint32_t>(data.size()));
+        StoreWord(&data, entry + 3 * sizeof(uint32_t), static_cast<uint32_t>(record.size()));
+        data.insert(data.end(), record.begin(), record.end());
+    }
+
+    return data;
+}
+
+/*
+ * The number of projects in an index, if it was written by this version
+ * and every entry points inside it, so lookups need not check.
+ */
+static ext::optional<uint32_t>
+MappingCount(Filesystem::Mapping const *mapping)
+{
+    if (mapping == nullptr || mapping->size() < IndexHeaderSize + sizeof(uint32_t) || ::memcmp(mapping->data(), IndexHeader, IndexHeaderSize) != 0) {
+        return ext::nullopt;
+    }
+
+    uint64_t count = LoadWord(mapping->data() + IndexHeaderSize);
+    uint64_t directory = IndexHeaderSize + sizeof(uint32_t);
+    if (count > (mapping->size() - directory) / IndexEntrySize) {
+        return ext::nullopt;
+    }
+
+    for (uint64_t index = 0; index < count; ++index) {
+        uint8_t const *entry = mapping->data() + directory + index * IndexEntrySize;
+        for (size_t field = 0; field < 2; ++field) {
+            uint64_t offset = LoadWord(entry + field * 2 * sizeof(uint32_t));
+            uint64_t size   = LoadWord(entry + field * 2 * sizeof(uint32_t) + sizeof(uint32_t));
+            if (offset + size > mapping->size()) {
+                return ext::nullopt;
+            }
+        }
+    }
+
+    return static_cast<uint32_t>(count);
+}
+
+std::unique_ptr<ProjectIndex> ProjectIndex::
+Open(Filesystem const *filesystem, std::string const &path)
+{
+    std::unique_ptr<Filesystem::Mapping> mapping = filesystem->readMapped(path);
+    ext::optional<uint32_t> count = MappingCount(mapping.get());
+    if (!count) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<ProjectIndex>(new ProjectIndex(std::move(mapping), *count));
+}
+
+std::unique_ptr<ProjectIndex> ProjectIndex::
+Create(std::vector<uint8_t> contents)
+{
+    std::unique_ptr<Filesystem::Mapping> mapping = std::unique_ptr<Filesystem::Mapping>(new Filesystem::Mapping(std::move(contents)));
+    ext::optional<uint32_t> count = MappingCount(mapping.get());
+    if (!count) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<ProjectIndex>(new ProjectIndex(std::move(mapping), *count));
+}
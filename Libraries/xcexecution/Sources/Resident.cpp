@@ -0,0 +1,313 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/Resident.h>
+
+#include <pbxspec/Manager.h>
+#include <xcsdk/Configuration.h>
+#include <xcsdk/Environment.h>
+#include <xcsdk/SDK/Manager.h>
+#include <pbxsetting/XC/Config.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Statistic.h>
+#include <process/Context.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+using xcexecution::Resident;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::Statistic;
+
+static Statistic EnvironmentLookups("xcexecution", "Resident environment lookups");
+static Statistic EnvironmentHits("xcexecution", "Resident environment hits", &EnvironmentLookups);
+static Statistic WorkspaceLookups("xcexecution", "Resident workspace lookups");
+static Statistic WorkspaceHits("xcexecution", "Resident workspace hits", &WorkspaceLookups);
+
+namespace {
+
+/*
+ * Modification times of the paths some state was loaded from. Paths that
+ * didn't exist are recorded too, so creating them is a change.
+ */
+class Inputs {
+private:
+    std::vector<std::pair<std::string, ext::optional<uint64_t>>> _paths;
+
+public:
+    void add(Filesystem const *filesystem, std::string const &path)
+    {
+        _paths.push_back({ path, filesystem->modificationTime(path) });
+    }
+
+    bool unchanged(Filesystem const *filesystem) const
+    {
+        return std::all_of(_paths.begin(), _paths.end(), [&](std::pair<std::string, ext::optional<uint64_t>> const &entry) {
+            return filesystem->modificationTime(entry.first) == entry.second;
+        });
+    }
+};
+
+struct EnvironmentEntry {
+    std::string                    key;
+    pbxbuild::Build::Environment   environment;
+    Inputs                         inputs;
+};
+
+struct WorkspaceEntry {
+    pbxbuild::WorkspaceContext     workspaceContext;
+    Inputs                         inputs;
+};
+
+}
+
+static std::atomic<bool> ResidentEnabled(false);
+
+/*
+ * Only the most recent build environment is kept; the environments of
+ * different developer directories or users rarely alternate. Workspaces
+ * are kept for the base environment they were loaded with.
+ */
+static std::mutex                                       ResidentMutex;
+static ext::optional<EnvironmentEntry>                  ResidentEnvironment;
+static std::unordered_map<std::string, WorkspaceEntry>  ResidentWorkspaces;
+
+Resident::
+Resident()
+{
+}
+
+Resident::
+~Resident()
+{
+}
+
+void Resident::
+Enable()
+{
+    ResidentEnabled.store(true);
+}
+
+bool Resident::
+Enabled()
+{
+    return ResidentEnabled.load();
+}
+
+static std::string
+DeveloperEnvironmentKey(process::Context const *processContext, std::string const &developerRoot)
+{
+    std::string key = developerRoot;
+    key += '\0' + processContext->userName() + '\0' + processContext->groupName();
+    key += '\0' + std::to_string(processContext->userID()) + '\0' + std::to_string(processContext->groupID());
+
+    /* The default settings include every environment variable. */
+    std::map<std::string, std::string> variables = std::map<std::string, std::string>(
+        processContext->environmentVariables().begin(),
+        processContext->environmentVariables().end());
+    for (auto const &variable : variables) {
+        key += '\0' + variable.first + '=' + variable.second;
+    }
+
+    return key;
+}
+
+static std::vector<std::string>
+DeveloperEnvironmentPaths(process::Context const *processContext, std::string const &developerRoot, pbxbuild::Build::Environment const &environment)
+{
+    std::vector<std::string> paths;
+
+    /* Directories change when installing or removing what's inside. */
+    paths.push_back(developerRoot);
+    for (std::pair<std::string, std::string> const &domain : pbxspec::Manager::DefaultDomains(developerRoot)) {
+        paths.push_back(domain.second);
+    }
+    for (std::pair<std::string, std::string> const &domain : pbxspec::Manager::PlatformDependentDomains(developerRoot)) {
+        paths.push_back(domain.second);
+    }
+    for (std::string const &path : pbxspec::Manager::DeveloperBuildRules(developerRoot)) {
+        paths.push_back(path);
+    }
+
+    for (std::string const &path : xcsdk::Configuration::DefaultPaths(processContext)) {
+        paths.push_back(path);
+    }
+
+    std::shared_ptr<xcsdk::SDK::Manager> const &sdkManager = environment.sdkManager();
+    paths.push_back(sdkManager->path() + "/Platforms");
+    paths.push_back(sdkManager->path() + "/Toolchains");
+    for (xcsdk::SDK::Platform::shared_ptr const &platform : sdkManager->platforms()) {
+        paths.push_back(platform->path());
+        paths.push_back(platform->path() + "/Developer/SDKs");
+    }
+    for (xcsdk::SDK::Toolchain::shared_ptr const &toolchain : sdkManager->toolchains()) {
+        paths.push_back(toolchain->path());
+    }
+
+    return paths;
+}
+
+std::string Resident::
+EnvironmentKey(process::Context const *processContext, Filesystem const *filesystem)
+{
+    ext::optional<std::string> developerRoot = xcsdk::Environment::DeveloperRoot(processContext, filesystem);
+    return DeveloperEnvironmentKey(processContext, developerRoot.value_or(std::string()));
+}
+
+std::vector<std::string> Resident::
+EnvironmentPaths(process::Context const *processContext, Filesystem const *filesystem, pbxbuild::Build::Environment const &environment)
+{
+    ext::optional<std::string> developerRoot = xcsdk::Environment::DeveloperRoot(processContext, filesystem);
+    if (!developerRoot) {
+        return std::vector<std::string>();
+    }
+
+    return DeveloperEnvironmentPaths(processContext, *developerRoot, environment);
+}
+
+ext::optional<pbxbuild::Build::Environment> Resident::
+BuildEnvironment(process::Context const *processContext, Filesystem const *filesystem)
+{
+    if (!Enabled()) {
+        return pbxbuild::Build::Environment::Default(processContext, filesystem);
+    }
+
+    ext::optional<std::string> developerRoot = xcsdk::Environment::DeveloperRoot(processContext, filesystem);
+    if (!developerRoot) {
+        /* Let the build environment report the error. */
+        return pbxbuild::Build::Environment::Default(processContext, filesystem);
+    }
+
+    std::string key = DeveloperEnvironmentKey(processContext, *developerRoot);
+
+    std::lock_guard<std::mutex> lock(ResidentMutex);
+    EnvironmentLookups.increment();
+
+    if (ResidentEnvironment && ResidentEnvironment->key == key && ResidentEnvironment->inputs.unchanged(filesystem)) {
+        EnvironmentHits.increment();
+        return ResidentEnvironment->environment;
+    }
+
+    ext::optional<pbxbuild::Build::Environment> environment = pbxbuild::Build::Environment::Default(processContext, filesystem);
+    if (!environment) {
+        return ext::nullopt;
+    }
+
+    /* Workspaces loaded with the previous environment won't be used again. */
+    ResidentWorkspaces.clear();
+
+    Inputs inputs;
+    for (std::string const &path : DeveloperEnvironmentPaths(processContext, *developerRoot, *environment)) {
+        inputs.add(filesystem, path);
+    }
+    ResidentEnvironment = EnvironmentEntry({ key, *environment, inputs });
+    return environment;
+}
+
+static void
+AddConfigInputs(Inputs *inputs, std::set<std::string> *seen, Filesystem const *filesystem, pbxsetting::XC::Config const &config)
+{
+    if (!seen->insert(config.path()).second) {
+        return;
+    }
+
+    inputs->add(filesystem, config.path());
+    for (pbxsetting::XC::Config::Entry const &entry : config.contents()) {
+        if (entry.type() == pbxsetting::XC::Config::Entry::Type::Include && entry.config() != nullptr) {
+            AddConfigInputs(inputs, seen, filesystem, *entry.config());
+        }
+    }
+}
+
+static Inputs
+WorkspaceInputs(Filesystem const *filesystem, pbxbuild::WorkspaceContext const &workspaceContext)
+{
+    Inputs inputs;
+
+    /* Adding or removing a scheme changes the directory it's in. */
+    std::set<std::string> schemeDirectories;
+    for (std::string const &path : workspaceContext.loadedFilePaths()) {
+        inputs.add(filesystem, path);
+
+        if (FSUtil::GetFileExtension(path) == "xcscheme" && schemeDirectories.insert(FSUtil::GetDirectoryName(path)).second) {
+            inputs.add(filesystem, FSUtil::GetDirectoryName(path));
+        }
+    }
+
+    /* Included configuration files aren't loaded files of the workspace itself. */
+    std::set<std::string> seen;
+    auto addConfigurationList = [&](pbxproj::XC::ConfigurationList::shared_ptr const &configurationList) {
+        if (configurationList == nullptr) {
+            return;
+        }
+
+        for (pbxproj::XC::BuildConfiguration::shared_ptr const &buildConfiguration : configurationList->buildConfigurations()) {
+            if (ext::optional<pbxsetting::XC::Config> config = workspaceContext.config(buildConfiguration)) {
+                AddConfigInputs(&inputs, &seen, filesystem, *config);
+            }
+        }
+    };
+
+    for (auto const &entry : workspaceContext.projects()) {
+        addConfigurationList(entry.second->buildConfigurationList());
+        for (pbxproj::PBX::Target::shared_ptr const &target : entry.second->targets()) {
+            addConfigurationList(target->buildConfigurationList());
+        }
+    }
+
+    return inputs;
+}
+
+ext::optional<pbxbuild::WorkspaceContext> Resident::
+Workspace(
+    Filesystem const *filesystem,
+    std::string const &key,
+    pbxsetting::Environment const &baseEnvironment,
+    std::function<ext::optional<pbxbuild::WorkspaceContext>()> const &load)
+{
+    if (!Enabled()) {
+        return load();
+    }
+
+    std::string fullKey = baseEnvironment.fingerprint() + '\0' + key;
+
+    std::lock_guard<std::mutex> lock(ResidentMutex);
+    WorkspaceLookups.increment();
+
+    auto it = ResidentWorkspaces.find(fullKey);
+    if (it != ResidentWorkspaces.end()) {
+        if (it->second.inputs.unchanged(filesystem)) {
+            WorkspaceHits.increment();
+            return it->second.workspaceContext;
+        }
+
+        ResidentWorkspaces.erase(it);
+    }
+
+    ext::optional<pbxbuild::WorkspaceContext> workspaceContext = load();
+    if (!workspaceContext) {
+        return ext::nullopt;
+    }
+
+    /*
+     * Projects are otherwise loaded as the build needs them; load them all
+     * now, so later builds find them loaded too.
+     */
+    (void)workspaceContext->projects();
+
+    Inputs inputs = WorkspaceInputs(filesystem, *workspaceContext);
+    ResidentWorkspaces.insert({ fullKey, WorkspaceEntry({ *workspaceContext, inputs }) });
+    return workspaceContext;
+}
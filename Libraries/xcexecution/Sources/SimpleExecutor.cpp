@@ -9,27 +9,63 @@
 
 #include <xcexecution/SimpleExecutor.h>
 
+#include <xcexecution/ActionCache.h>
+#include <xcexecution/BuildDatabase.h>
+#include <xcexecution/JobServer.h>
 #include <xcexecution/Parameters.h>
+#include <xcexecution/TargetFingerprint.h>
+#include <xcexecution/Trace.h>
 #include <builtin/Driver.h>
+#include <dependency/DependencyInfo.h>
+#include <dependency/DependencyInfoConverter.h>
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/PhaseInvocations.h>
+#include <pbxbuild/Tool/InvocationPlan.h>
+#include <xcformatter/Output.h>
+#include <libutil/CachedFilesystem.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <process/Cancellation.h>
 #include <process/Context.h>
 #include <process/MemoryContext.h>
 #include <process/Launcher.h>
 
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <set>
+
+#include <cstdlib>
+#include <fstream>
+
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
 using xcexecution::SimpleExecutor;
+using xcexecution::ActionCache;
+using xcexecution::BuildDatabase;
+using xcexecution::JobServer;
+using xcexecution::TargetFingerprint;
+using xcexecution::Trace;
+using libutil::CachedFilesystem;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
 SimpleExecutor::
-SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins) :
-    Executor (formatter, dryRun, false),
-    _builtins(builtins)
+SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs, bool parallelizeTargets, bool incremental, ext::optional<std::string> const &actionCache, ext::optional<std::string> const &toolLauncher, ext::optional<Shard> const &shard, std::shared_ptr<Trace> const &trace, ext::optional<double> const &loadAverage) :
+    Executor           (formatter, dryRun, false, trace),
+    _builtins          (builtins),
+    _jobs              (std::max<size_t>(jobs, 1)),
+    _parallelizeTargets(parallelizeTargets),
+    _incremental       (incremental),
+    _actionCache       (actionCache),
+    _toolLauncher      (toolLauncher),
+    _shard             (shard),
+    _loadAverage       (loadAverage)
 {
 }
 
@@ -38,67 +74,72 @@ SimpleExecutor::
 {
 }
 
-bool SimpleExecutor::
-build(
-    process::Context const *processContext,
-    process::Launcher *processLauncher,
-    Filesystem *filesystem,
-    pbxbuild::Build::Environment const &buildEnvironment,
-    Parameters const &buildParameters)
+SimpleExecutor::Shard::
+Shard(size_t index, size_t count) :
+    _index(index),
+    _count(count)
 {
-    ext::optional<pbxbuild::WorkspaceContext> workspaceContext = buildParameters.loadWorkspace(filesystem, processContext->userName(), buildEnvironment, processContext->currentDirectory());
-    if (!workspaceContext) {
-        return false;
-    }
-
-    ext::optional<pbxbuild::Build::Context> buildContext = buildParameters.createBuildContext(*workspaceContext);
-    if (!buildContext) {
-        return false;
-    }
-
-    xcformatter::Formatter::Print(_formatter->begin(*buildContext));
+}
 
-    ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> targetGraph = buildParameters.resolveDependencies(buildEnvironment, *buildContext);
-    if (!targetGraph) {
-        return false;
+std::vector<bool> SimpleExecutor::Shard::
+select(std::vector<uint64_t> const &costs) const
+{
+    /*
+     * Give the most costly remaining item to the shard with the least total
+     * cost so far. Ties go to the earlier item and the earlier shard.
+     */
+    std::vector<size_t> order = std::vector<size_t>(costs.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
     }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return costs[a] > costs[b];
+    });
 
-    ext::optional<std::vector<pbxproj::PBX::Target::shared_ptr>> orderedTargets = targetGraph->ordered();
-    if (!orderedTargets) {
-        fprintf(stderr, "error: cycle detected in target dependencies\n");
-        return false;
+    std::vector<uint64_t> totals = std::vector<uint64_t>(_count, 0);
+    std::vector<bool> selected = std::vector<bool>(costs.size(), false);
+    for (size_t item : order) {
+        size_t shard = std::min_element(totals.begin(), totals.end()) - totals.begin();
+        totals[shard] += costs[item];
+        selected[item] = (shard + 1 == _index);
     }
 
-    for (pbxproj::PBX::Target::shared_ptr const &target : *orderedTargets) {
-        xcformatter::Formatter::Print(_formatter->beginTarget(*buildContext, target));
+    return selected;
+}
 
-        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext->targetEnvironment(buildEnvironment, target);
-        if (!targetEnvironment) {
-            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
-            xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
-            continue;
-        }
+std::string SimpleExecutor::Shard::
+argument() const
+{
+    return std::to_string(_index) + "/" + std::to_string(_count);
+}
 
-        xcformatter::Formatter::Print(_formatter->beginCheckDependencies(target));
-        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, *buildContext, target, *targetEnvironment);
-        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
-        xcformatter::Formatter::Print(_formatter->finishCheckDependencies(target));
+ext::optional<SimpleExecutor::Shard> SimpleExecutor::Shard::
+Parse(std::string const &argument)
+{
+    std::string::size_type slash = argument.find('/');
+    if (slash == std::string::npos) {
+        return ext::nullopt;
+    }
 
-        auto result = buildTarget(processContext, processLauncher, filesystem, target, *targetEnvironment, phaseInvocations.invocations());
-        if (!result.first) {
-            xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
-            xcformatter::Formatter::Print(_formatter->failure(*buildContext, result.second));
-            return false;
-        }
+    std::string indexString = argument.substr(0, slash);
+    std::string countString = argument.substr(slash + 1);
+    if (indexString.empty() || countString.empty() ||
+        indexString.find_first_not_of("0123456789") != std::string::npos ||
+        countString.find_first_not_of("0123456789") != std::string::npos ||
+        indexString.size() > 9 || countString.size() > 9) {
+        return ext::nullopt;
+    }
 
-        xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
+    size_t index = static_cast<size_t>(std::strtoul(indexString.c_str(), nullptr, 10));
+    size_t count = static_cast<size_t>(std::strtoul(countString.c_str(), nullptr, 10));
+    if (index < 1 || index > count) {
+        return ext::nullopt;
     }
 
-    xcformatter::Formatter::Print(_formatter->success(*buildContext));
-    return true;
+    return Shard(index, count);
 }
 
-static ext::optional<std::vector<pbxbuild::Tool::Invocation>>
+static ext::optional<std::vector<pbxbuild::Tool::Invocation const *>>
 SortInvocations(std::vector<pbxbuild::Tool::Invocation> const &invocations)
 {
     std::unordered_map<std::string, pbxbuild::Tool::Invocation const *> outputToInvocation;
@@ -133,38 +174,66 @@ SortInvocations(std::vector<pbxbuild::Tool::Invocation> const &invocations)
         }
     }
 
-    std::vector<pbxbuild::Tool::Invocation> result;
+    return graph.ordered();
+}
 
-    ext::optional<std::vector<pbxbuild::Tool::Invocation const *>> orderedInvocations = graph.ordered();
-    if (!orderedInvocations) {
-        return ext::nullopt;
+/*
+ * Create a directory, unless it's already known to exist. Many outputs are
+ * written into the same few directories, so remember each one created or
+ * found, along with its parents, for the rest of the build.
+ */
+static bool
+CreateDirectory(Filesystem *filesystem, std::unordered_set<std::string> *directories, std::string const &directory)
+{
+    if (directories->find(directory) != directories->end()) {
+        return true;
+    }
+
+    if (!filesystem->createDirectory(directory)) {
+        return false;
     }
 
-    for (pbxbuild::Tool::Invocation const *invocation : *orderedInvocations) {
-        result.push_back(*invocation);
+    for (std::string current = directory; !current.empty() && directories->insert(current).second; ) {
+        std::string parent = FSUtil::GetDirectoryName(current);
+        if (parent == current) {
+            break;
+        }
+        current = parent;
     }
-    return result;
+
+    return true;
 }
 
 bool SimpleExecutor::
 writeAuxiliaryFiles(
     Filesystem *filesystem,
+    std::unordered_set<std::string> *directories,
     pbxproj::PBX::Target::shared_ptr const &target,
     pbxbuild::Target::Environment const &targetEnvironment,
     std::vector<pbxbuild::Tool::Invocation> const &invocations)
 {
+    Trace::Span span(_trace.get(), "Write auxiliary files", "target", { { "target", target->name() } });
+
+    /* Files are written together at the end, so the writes can overlap. */
+    std::vector<std::vector<uint8_t>> contents;
+    std::vector<std::string> paths;
+
     xcformatter::Formatter::Print(_formatter->beginWriteAuxiliaryFiles(target));
     for (pbxbuild::Tool::Invocation const &invocation : invocations) {
         for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
             std::string directory = FSUtil::GetDirectoryName(auxiliaryFile.path());
-            if (!filesystem->isDirectory(directory)) {
-                xcformatter::Formatter::Print(_formatter->createAuxiliaryDirectory(directory));
+            if (directories->find(directory) == directories->end()) {
+                if (!filesystem->isDirectory(directory)) {
+                    xcformatter::Formatter::Print(_formatter->createAuxiliaryDirectory(directory));
 
-                if (!_dryRun) {
-                    if (!filesystem->createDirectory(directory)) {
-                        return false;
+                    if (!_dryRun) {
+                        if (!CreateDirectory(filesystem, directories, directory)) {
+                            return false;
+                        }
                     }
                 }
+
+                directories->insert(directory);
             }
 
             xcformatter::Formatter::Print(_formatter->writeAuxiliaryFile(auxiliaryFile.path()));
@@ -190,11 +259,20 @@ writeAuxiliaryFiles(
                     }
                 }
 
-                if (!filesystem->write(data, auxiliaryFile.path())) {
-                    return false;
-                }
+                contents.push_back(std::move(data));
+                paths.push_back(auxiliaryFile.path());
             }
+        }
+    }
 
+    /* Rewriting unchanged contents would make everything using it out of date. */
+    std::vector<bool> written = filesystem->writeIfChangedBatch(contents, paths);
+    if (std::find(written.begin(), written.end(), false) != written.end()) {
+        return false;
+    }
+
+    for (pbxbuild::Tool::Invocation const &invocation : invocations) {
+        for (pbxbuild::Tool::Invocation::AuxiliaryFile const &auxiliaryFile : invocation.auxiliaryFiles()) {
             if (auxiliaryFile.executable() && !filesystem->isExecutable(auxiliaryFile.path())) {
                 xcformatter::Formatter::Print(_formatter->setAuxiliaryExecutable(auxiliaryFile.path()));
 
@@ -212,143 +290,1554 @@ writeAuxiliaryFiles(
     return true;
 }
 
-std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
-performInvocations(
-    process::Context const *processContext,
-    process::Launcher *processLauncher,
-    Filesystem *filesystem,
-    std::vector<std::string> const &executablePaths,
-    std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
-    bool createProductStructure)
+/*
+ * For each invocation, find the invocations that depend on it and count how
+ * many invocations it depends on. Indexes are into the invocations list.
+ */
+static void
+InvocationDependents(
+    std::vector<pbxbuild::Tool::Invocation const *> const &invocations,
+    std::vector<std::vector<size_t>> *dependents,
+    std::vector<size_t> *dependencyCount)
 {
-    for (pbxbuild::Tool::Invocation const &invocation : orderedInvocations) {
-        // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
-        if (!invocation.executable()) {
-            continue;
+    std::unordered_map<std::string, size_t> outputToInvocation;
+    for (size_t i = 0; i < invocations.size(); ++i) {
+        for (std::string const &output : invocations[i]->outputs()) {
+            outputToInvocation.insert({ output, i });
+        }
+    }
+
+    dependents->assign(invocations.size(), std::vector<size_t>());
+    dependencyCount->assign(invocations.size(), 0);
+
+    for (size_t i = 0; i < invocations.size(); ++i) {
+        pbxbuild::Tool::Invocation const &invocation = *invocations[i];
+
+        std::unordered_set<size_t> dependencies;
+        for (std::vector<std::string> const *paths : { &invocation.inputs(), &invocation.phonyInputs(), &invocation.inputDependencies() }) {
+            for (std::string const &path : *paths) {
+                auto it = outputToInvocation.find(path);
+                if (it != outputToInvocation.end() && it->second != i) {
+                    dependencies.insert(it->second);
+                }
+            }
         }
-        pbxbuild::Tool::Invocation::Executable const &executable = *invocation.executable();
 
-        if (invocation.createsProductStructure() != createProductStructure) {
-            continue;
+        for (size_t dependency : dependencies) {
+            (*dependents)[dependency].push_back(i);
         }
+        (*dependencyCount)[i] = dependencies.size();
+    }
+}
 
-        if (!_dryRun) {
-            bool success = true;
+/*
+ * Load the inputs an invocation found while running from its dependency info.
+ */
+static ext::optional<std::vector<std::string>>
+DiscoveredInputs(Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation)
+{
+    std::vector<std::string> inputs;
 
-            for (std::string const &output : invocation.outputs()) {
-                std::string directory = FSUtil::GetDirectoryName(output);
+    for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+        std::string path = FSUtil::ResolveRelativePath(dependencyInfo.path(), invocation.workingDirectory());
 
-                if (!filesystem->createDirectory(directory)) {
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
-                }
+        ext::optional<std::vector<dependency::DependencyInfo>> info = dependency::DependencyInfoConverter::Load(filesystem, dependencyInfo.format(), path);
+        if (!info) {
+            return ext::nullopt;
+        }
+
+        for (dependency::DependencyInfo const &entry : *info) {
+            for (std::string const &input : entry.inputs()) {
+                inputs.push_back(FSUtil::ResolveRelativePath(input, invocation.workingDirectory()));
             }
+        }
+    }
 
-            if (ext::optional<std::string> const &builtin = executable.builtin()) {
-                /* Builtin tool, find and run in-process. */
-                if (std::shared_ptr<builtin::Driver> driver = _builtins.driver(*builtin)) {
-                    xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, *builtin, createProductStructure));
-
-                    process::MemoryContext context = process::MemoryContext(
-                        *builtin,
-                        invocation.workingDirectory(),
-                        invocation.arguments(),
-                        invocation.environment(),
-                        processContext->userID(),
-                        processContext->groupID(),
-                        processContext->userName(),
-                        processContext->groupName());
-                    int exitCode = driver->run(&context, filesystem);
-                    success = (exitCode == 0);
-
-                    xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, *builtin, createProductStructure));
-                } else {
-                    /* Failed to find builtin tool. */
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
-                }
-            } else if (ext::optional<std::string> const &external = executable.external()) {
-                /* External tool, find on the filesystem. */
-                ext::optional<std::string> path;
-                if (FSUtil::IsAbsolutePath(*external)) {
-                    if (filesystem->isExecutable(*external)) {
-                        path = external;
-                    }
-                } else {
-                    path = filesystem->findExecutable(*external, executablePaths);
-                }
+    return inputs;
+}
 
-                if (path) {
-                    xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, *path, createProductStructure));
-
-                    process::MemoryContext context = process::MemoryContext(
-                        *path,
-                        invocation.workingDirectory(),
-                        invocation.arguments(),
-                        invocation.environment(),
-                        processContext->userID(),
-                        processContext->groupID(),
-                        processContext->userName(),
-                        processContext->groupName());
-                    ext::optional<int> exitCode = processLauncher->launch(filesystem, &context);
-                    success = (exitCode && *exitCode == 0);
-
-                    xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, *path, createProductStructure));
-                } else {
-                    /* Failed to find executable. */
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
-                }
-            } else {
-                abort();
+/*
+ * If an invocation's outputs are all newer than its inputs, including those
+ * discovered when it last ran. Invocations without any outputs or inputs to
+ * compare are never up to date, nor are those that always run or that have
+ * inputs missing. With a database, the outputs must also have been built by
+ * the same command, and the discovered inputs come from there.
+ */
+static bool
+InvocationUpToDate(Filesystem const *filesystem, xcexecution::BuildDatabase const *database, pbxbuild::Tool::Invocation const &invocation)
+{
+    if (invocation.outputs().empty() || invocation.alwaysOutOfDate()) {
+        return false;
+    }
+
+    ext::optional<uint64_t> oldestOutput;
+    for (std::string const &output : invocation.outputs()) {
+        ext::optional<uint64_t> time = filesystem->modificationTime(output);
+        if (!time) {
+            return false;
+        }
+
+        if (!oldestOutput || *time < *oldestOutput) {
+            oldestOutput = time;
+        }
+    }
+
+    std::vector<std::string> inputs;
+    inputs.insert(inputs.end(), invocation.inputs().begin(), invocation.inputs().end());
+    inputs.insert(inputs.end(), invocation.phonyInputs().begin(), invocation.phonyInputs().end());
+    inputs.insert(inputs.end(), invocation.inputDependencies().begin(), invocation.inputDependencies().end());
+
+    if (database != nullptr) {
+        std::string commandHash = invocation.fingerprint();
+
+        for (std::string const &output : invocation.outputs()) {
+            xcexecution::BuildDatabase::Entry const *entry = database->entry(output);
+            if (entry == nullptr || entry->commandHash() != commandHash) {
+                return false;
             }
 
-            if (!success) {
-                return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+            inputs.insert(inputs.end(), entry->inputs().begin(), entry->inputs().end());
+        }
+    } else {
+        /* Dependency info is written by the tool; without it, the inputs aren't known. */
+        ext::optional<std::vector<std::string>> discoveredInputs = DiscoveredInputs(filesystem, invocation);
+        if (!discoveredInputs) {
+            return false;
+        }
+
+        inputs.insert(inputs.end(), discoveredInputs->begin(), discoveredInputs->end());
+    }
+
+    if (inputs.empty()) {
+        return false;
+    }
+
+    for (std::string const &input : inputs) {
+        ext::optional<uint64_t> time = filesystem->modificationTime(input);
+        if (!time || *time > *oldestOutput) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * The action cache key for an invocation. Nothing if the invocation can't be
+ * cached: if it has no outputs, no declared inputs to tell apart builds, or
+ * always runs. Inputs that may not exist are part of the key when they do.
+ */
+static ext::optional<std::string>
+ActionCacheKey(Filesystem const *filesystem, pbxbuild::Tool::Invocation const &invocation)
+{
+    std::vector<std::string> inputs;
+    inputs.insert(inputs.end(), invocation.inputs().begin(), invocation.inputs().end());
+    inputs.insert(inputs.end(), invocation.inputDependencies().begin(), invocation.inputDependencies().end());
+
+    if (invocation.outputs().empty() || inputs.empty() || invocation.alwaysOutOfDate()) {
+        return ext::nullopt;
+    }
+
+    inputs.insert(inputs.end(), invocation.phonyInputs().begin(), invocation.phonyInputs().end());
+
+    if (ext::optional<std::string> const &command = invocation.actionCacheCommand()) {
+        return xcexecution::ActionCache::Key(filesystem, *command, inputs);
+    }
+
+    return xcexecution::ActionCache::Key(filesystem, invocation.commandFingerprint(), inputs);
+}
+
+/*
+ * The files an invocation creates: its outputs and any dependency info.
+ */
+static std::vector<std::string>
+ActionCacheOutputs(pbxbuild::Tool::Invocation const &invocation)
+{
+    std::vector<std::string> outputs = invocation.outputs();
+    for (pbxbuild::Tool::Invocation::DependencyInfo const &dependencyInfo : invocation.dependencyInfo()) {
+        outputs.push_back(FSUtil::ResolveRelativePath(dependencyInfo.path(), invocation.workingDirectory()));
+    }
+    return outputs;
+}
+
+/*
+ * For each invocation, the longest time until the end of a chain of
+ * invocations that depend on it, including its own. Times come from the
+ * database of previous builds; invocations that haven't been built before
+ * count as taking a millisecond, which makes the priority the path length
+ * when there's no history.
+ */
+static void
+InvocationPriorities(
+    std::vector<pbxbuild::Tool::Invocation const *> const &invocations,
+    std::vector<std::vector<size_t>> const &dependents,
+    std::vector<size_t> const &dependencyCount,
+    xcexecution::BuildDatabase const *database,
+    std::vector<uint64_t> *priority)
+{
+    /*
+     * Visit dependents before the invocations they depend on, so their
+     * priority is known. Invocations in a cycle are left at zero.
+     */
+    std::vector<size_t> remaining = dependencyCount;
+    std::vector<size_t> order;
+    for (size_t i = 0; i < invocations.size(); ++i) {
+        if (remaining[i] == 0) {
+            order.push_back(i);
+        }
+    }
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (size_t dependent : dependents[order[i]]) {
+            if (--remaining[dependent] == 0) {
+                order.push_back(dependent);
             }
         }
     }
 
-    return std::make_pair(true, std::vector<pbxbuild::Tool::Invocation>());
+    priority->assign(invocations.size(), 0);
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        pbxbuild::Tool::Invocation const &invocation = *invocations[*it];
+
+        uint64_t duration = 1;
+        if (database != nullptr && !invocation.outputs().empty()) {
+            if (xcexecution::BuildDatabase::Entry const *entry = database->entry(invocation.outputs().front())) {
+                duration = std::max<uint64_t>(entry->duration(), 1);
+            }
+        }
+
+        uint64_t longest = 0;
+        for (size_t dependent : dependents[*it]) {
+            longest = std::max(longest, (*priority)[dependent]);
+        }
+
+        (*priority)[*it] = duration + longest;
+    }
 }
 
-std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
-buildTarget(
-    process::Context const *processContext,
-    process::Launcher *processLauncher,
-    Filesystem *filesystem,
-    pbxproj::PBX::Target::shared_ptr const &target,
-    pbxbuild::Target::Environment const &targetEnvironment,
-    std::vector<pbxbuild::Tool::Invocation> const &invocations)
+/*
+ * The most memory an invocation used at once when it last ran, or zero if
+ * that isn't known.
+ */
+static uint64_t
+InvocationMemory(BuildDatabase const *database, pbxbuild::Tool::Invocation const &invocation)
+{
+    if (database != nullptr && !invocation.outputs().empty()) {
+        if (xcexecution::BuildDatabase::Entry const *entry = database->entry(invocation.outputs().front())) {
+            return entry->memory();
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * How much memory can be used without the system swapping, in bytes, if
+ * that can be found.
+ */
+static ext::optional<uint64_t>
+AvailableMemory()
+{
+#if defined(__linux__)
+    std::ifstream meminfo("/proc/meminfo");
+    std::string name;
+    uint64_t kilobytes;
+    std::string unit;
+    while (meminfo >> name >> kilobytes >> unit) {
+        if (name == "MemAvailable:") {
+            return kilobytes * 1024;
+        }
+    }
+    return ext::nullopt;
+#elif defined(__APPLE__)
+    vm_statistics64_data_t statistics;
+    mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+    if (host_statistics64(mach_host_self(), HOST_VM_INFO64, reinterpret_cast<host_info64_t>(&statistics), &count) != KERN_SUCCESS) {
+        return ext::nullopt;
+    }
+
+    /* Inactive and purgeable memory is given up before swapping. */
+    uint64_t pages = static_cast<uint64_t>(statistics.free_count) + statistics.inactive_count + statistics.purgeable_count;
+    return pages * static_cast<uint64_t>(vm_page_size);
+#else
+    return ext::nullopt;
+#endif
+}
+
+namespace {
+
+/*
+ * The context to start an external tool in. Refers to the arguments and
+ * the shared environment of the invocation instead of copying them, so
+ * launchers can prepare the environment once for every tool using it.
+ */
+class InvocationContext : public process::Context {
+private:
+    std::string const                                                  &_executablePath;
+    std::string const                                                  &_currentDirectory;
+    std::vector<std::string> const                                     &_commandLineArguments;
+    std::shared_ptr<std::unordered_map<std::string, std::string> const> _environmentVariables;
+    process::Context const                                             *_processContext;
+
+public:
+    InvocationContext(
+        std::string const &executablePath,
+        std::string const &currentDirectory,
+        std::vector<std::string> const &commandLineArguments,
+        std::shared_ptr<std::unordered_map<std::string, std::string> const> const &environmentVariables,
+        process::Context const *processContext) :
+        _executablePath      (executablePath),
+        _currentDirectory    (currentDirectory),
+        _commandLineArguments(commandLineArguments),
+        _environmentVariables(environmentVariables),
+        _processContext      (processContext)
+    {
+    }
+
+public:
+    virtual std::string const &executablePath() const
+    { return _executablePath; }
+    virtual std::string const &currentDirectory() const
+    { return _currentDirectory; }
+
+public:
+    virtual std::vector<std::string> const &commandLineArguments() const
+    { return _commandLineArguments; }
+    virtual std::unordered_map<std::string, std::string> const &environmentVariables() const
+    { return *_environmentVariables; }
+    virtual std::shared_ptr<std::unordered_map<std::string, std::string> const> sharedEnvironmentVariables() const
+    { return _environmentVariables; }
+
+    virtual ext::optional<std::string> environmentVariable(std::string const &variable) const
+    {
+        auto it = _environmentVariables->find(variable);
+        return (it != _environmentVariables->end() ? ext::optional<std::string>(it->second) : ext::nullopt);
+    }
+
+public:
+    virtual int32_t userID() const
+    { return _processContext->userID(); }
+    virtual int32_t groupID() const
+    { return _processContext->groupID(); }
+    virtual std::string const &userName() const
+    { return _processContext->userName(); }
+    virtual std::string const &groupName() const
+    { return _processContext->groupName(); }
+};
+
+}
+
+/*
+ * The argument, before the count, setting how many threads a tool uses,
+ * for tools that take one. Creating debug symbols is slow, and is often
+ * the last thing running, so it uses whatever job slots are idle.
+ */
+static ext::optional<std::string>
+ThreadsArgument(pbxbuild::Tool::Invocation const &invocation)
+{
+    if (invocation.toolIdentifier() == "com.apple.tools.dsymutil") {
+        return std::string("--num-threads=");
+    }
+
+    return ext::nullopt;
+}
+
+static uint64_t
+Milliseconds(std::chrono::steady_clock::time_point start)
 {
-    if (!writeAuxiliaryFiles(filesystem, target, targetEnvironment, invocations)) {
-        return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+namespace {
+
+/*
+ * Runs batches of invocations. Within a batch, an invocation starts once the
+ * invocations producing its inputs have finished. All batches share a single
+ * limit on the number of external tools running at once, and the jobserver
+ * of the build.
+ *
+ * External tools are started without waiting, and their output is printed
+ * once they finish. Builtin tools run in-process one at a time. Everything,
+ * including batch completion callbacks, runs on the thread calling `run()`.
+ * Callbacks can add more batches. With more than one job, ready invocations
+ * start in order of the longest path of invocations still to run after them.
+ */
+class Scheduler {
+public:
+    using Completion = std::function<void(bool success)>;
+    using FindExecutable = std::function<ext::optional<std::string>(Filesystem const *filesystem, std::string const &name)>;
+
+private:
+    /*
+     * Orders ready invocations by priority, highest first, then by index.
+     */
+    struct ReadyOrder {
+        std::vector<uint64_t> const *priority;
+
+        bool operator()(size_t a, size_t b) const
+        {
+            if ((*priority)[a] != (*priority)[b]) {
+                return (*priority)[a] > (*priority)[b];
+            }
+            return a < b;
+        }
+    };
+
+    struct Batch {
+        std::vector<pbxbuild::Tool::Invocation const *> invocations;
+        FindExecutable                                  findExecutable;
+        bool                                            createProductStructure;
+        std::vector<std::vector<size_t>>                dependents;
+        std::vector<size_t>                             dependencyCount;
+        std::vector<uint64_t>                           priority;
+        std::set<size_t, ReadyOrder>                    ready;
+        size_t                                          remaining;
+        Completion                                      completion;
+    };
+
+    struct Running {
+        Batch                                  *batch;
+        size_t                                  index;
+        std::string                             path;
+        ext::optional<std::string>              cacheKey;
+        std::chrono::steady_clock::time_point   start;
+        uint32_t                                job;
+        uint64_t                                traceStart;
+        uint64_t                                memory;
+        size_t                                  slots;
+        std::string                             output;
+    };
+
+private:
+    std::shared_ptr<xcformatter::Formatter> _formatter;
+    builtin::Registry                      *_builtins;
+    bool                                    _dryRun;
+    size_t                                  _jobs;
+    ext::optional<double>                   _loadAverage;
+    bool                                    _incremental;
+    xcexecution::BuildDatabase             *_database;
+    xcexecution::ActionCache const         *_actionCache;
+    ext::optional<std::string>              _toolLauncher;
+    Trace                                  *_trace;
+
+private:
+    process::Context const      *_processContext;
+    process::Launcher            *_processLauncher;
+    process::Cancellation const  *_cancellation;
+
+private:
+    /*
+     * Checking whether invocations are up to date looks at the same inputs
+     * many times, so cache what's found. Tools can write anywhere without
+     * going through the filesystem, so forget it all after running one.
+     */
+    CachedFilesystem        _cachedFilesystem;
+    Filesystem             *_filesystem;
+
+    /*
+     * Directories created or found so far, shared with the rest of the build.
+     */
+    std::unordered_set<std::string> *_directories;
+
+private:
+    std::list<std::unique_ptr<Batch>>                        _batches;
+    std::unordered_map<process::Launcher::Handle, Running>   _running;
+
+private:
+    /*
+     * Limits the tools running at once across every process of the build,
+     * including builds run by those tools. Running a tool alongside others
+     * takes a token. When there isn't one, or the system is too busy or
+     * short on memory for another tool, starting tools waits for one to
+     * finish.
+     */
+    std::unique_ptr<JobServer>                               _jobServer;
+    bool                                                     _waiting;
+
+    /*
+     * Job slots taken by the running tools. Most take one; tools that run
+     * several threads take one for each.
+     */
+    size_t                                                   _slots;
+
+private:
+    /*
+     * The environment each shared invocation environment is run with, kept
+     * so it stays shared. Holds on to the invocation environment, so its
+     * address isn't reused while it's a key.
+     */
+    using EnvironmentVariables = std::shared_ptr<std::unordered_map<std::string, std::string> const>;
+    std::unordered_map<std::unordered_map<std::string, std::string> const *, std::pair<EnvironmentVariables, EnvironmentVariables>> _environments;
+
+private:
+    bool                                                     _failed;
+    bool                                                     _cancelled;
+    std::vector<pbxbuild::Tool::Invocation>                  _failingInvocations;
+    Completion                                               _failingCompletion;
+
+public:
+    Scheduler(
+        std::shared_ptr<xcformatter::Formatter> const &formatter,
+        builtin::Registry *builtins,
+        bool dryRun,
+        size_t jobs,
+        ext::optional<double> const &loadAverage,
+        bool incremental,
+        xcexecution::BuildDatabase *database,
+        xcexecution::ActionCache const *actionCache,
+        ext::optional<std::string> const &toolLauncher,
+        Trace *trace,
+        process::Context const *processContext,
+        process::Launcher *processLauncher,
+        process::Cancellation const *cancellation,
+        Filesystem *filesystem,
+        std::unordered_set<std::string> *directories) :
+        _formatter      (formatter),
+        _builtins       (builtins),
+        _dryRun         (dryRun),
+        _jobs           (jobs),
+        _loadAverage    (loadAverage),
+        _incremental    (incremental),
+        _database       (database),
+        _actionCache    (actionCache),
+        _toolLauncher   (toolLauncher),
+        _trace          (trace),
+        _processContext (processContext),
+        _processLauncher(processLauncher),
+        _cancellation   (cancellation),
+        _cachedFilesystem(filesystem),
+        _filesystem     (&_cachedFilesystem),
+        _directories    (directories),
+        _jobServer      (!dryRun ? JobServer::Create(processContext, jobs) : nullptr),
+        _waiting        (false),
+        _slots          (0),
+        _failed         (false),
+        _cancelled      (false)
+    {
     }
 
-    ext::optional<std::vector<pbxbuild::Tool::Invocation>> orderedInvocations = SortInvocations(invocations);
-    if (!orderedInvocations) {
-        fprintf(stderr, "error: cycle detected building invocation graph\n");
-        return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
+public:
+    /*
+     * Add a batch of ordered invocations. Only invocations matching
+     * `createProductStructure` are run. External tools not given as an
+     * absolute path are found with `findExecutable`. The completion is
+     * called when all invocations in the batch have finished, or on
+     * failure. The invocations must outlive the batch.
+     */
+    void add(
+        std::vector<pbxbuild::Tool::Invocation const *> const &invocations,
+        FindExecutable const &findExecutable,
+        bool createProductStructure,
+        Completion const &completion)
+    {
+        std::unique_ptr<Batch> batch = std::unique_ptr<Batch>(new Batch());
+        batch->invocations = invocations;
+        batch->findExecutable = findExecutable;
+        batch->createProductStructure = createProductStructure;
+        batch->remaining = invocations.size();
+        batch->completion = completion;
+
+        InvocationDependents(invocations, &batch->dependents, &batch->dependencyCount);
+
+        /*
+         * Ready invocations on the longest remaining path run first, so the
+         * slowest chains of invocations aren't started late. With a single
+         * job the order doesn't change how long the build takes, so instead
+         * run lowest index first: since the invocations are ordered, that is
+         * the order given.
+         */
+        batch->priority.assign(invocations.size(), 0);
+        if (_jobs > 1) {
+            InvocationPriorities(invocations, batch->dependents, batch->dependencyCount, _database, &batch->priority);
+        }
+        batch->ready = std::set<size_t, ReadyOrder>(ReadyOrder { &batch->priority });
+
+        for (size_t i = 0; i < invocations.size(); ++i) {
+            if (batch->dependencyCount[i] == 0) {
+                batch->ready.insert(i);
+            }
+        }
+
+        _batches.push_back(std::move(batch));
     }
 
-    xcformatter::Formatter::Print(_formatter->beginCreateProductStructure(target));
-    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> structureResult = performInvocations(processContext, processLauncher, filesystem, targetEnvironment.executablePaths(), *orderedInvocations, true);
-    xcformatter::Formatter::Print(_formatter->finishCreateProductStructure(target));
-    if (!structureResult.first) {
-        return structureResult;
+    /*
+     * Stop starting new invocations. Used for failures outside of any
+     * invocation, so there are no failing invocations to report.
+     */
+    void fail()
+    {
+        _failed = true;
     }
 
-    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> invocationsResult = performInvocations(processContext, processLauncher, filesystem, targetEnvironment.executablePaths(), *orderedInvocations, false);
-    if (!invocationsResult.first) {
-        return invocationsResult;
+public:
+    /*
+     * Run until all batches have finished or there was a failure. After a
+     * failure, invocations already running are still waited for. After the
+     * build is cancelled, they're stopped first.
+     */
+    bool run()
+    {
+        process::Launcher::CancellationScope scope(_processLauncher, _cancellation);
+
+        while (true) {
+            if (!_cancelled && cancelled()) {
+                _cancelled = true;
+                _failed = true;
+            }
+
+            startReady();
+            releaseTokens();
+            if (_running.empty()) {
+                break;
+            }
+
+            ext::optional<process::Launcher::Result> result = _processLauncher->wait();
+            if (!result) {
+                /* Lost track of the running tools; they can't be waited for. */
+                fprintf(stderr, "error: failed to wait for running tools\n");
+                Running const &running = _running.begin()->second;
+                failure(running.batch, running.index);
+                break;
+            }
+
+            auto it = _running.find(result->handle());
+            if (it == _running.end()) {
+                continue;
+            }
+
+            Batch *batch = it->second.batch;
+            size_t index = it->second.index;
+            ext::optional<std::string> cacheKey = it->second.cacheKey;
+            uint64_t duration = Milliseconds(it->second.start);
+            pbxbuild::Tool::Invocation const &invocation = *batch->invocations[index];
+            _cachedFilesystem.invalidate();
+
+            /*
+             * Write out everything about the invocation together. Tools
+             * stopped by cancelling didn't fail, so aren't shown.
+             */
+            bool success = (result->exitCode() && *result->exitCode() == 0);
+            if (success || !_cancelled) {
+                std::string &output = it->second.output;
+                output += _formatter->resultInvocation(invocation, result->output(), success, duration);
+                output += _formatter->finishInvocation(invocation, it->second.path, batch->createProductStructure);
+                xcformatter::Formatter::Print(output);
+            }
+
+            trace(invocation, it->second.path, it->second.job, it->second.traceStart, result->processIdentifier(), result->exitCode());
+            _slots -= it->second.slots;
+            _running.erase(it);
+
+            if (success) {
+                record(invocation, true, duration, result->peakMemory());
+                cache(invocation, cacheKey);
+                complete(batch, index);
+            } else if (_cancelled) {
+                /* Outputs of stopped tools are forgotten, so they run again. */
+                record(invocation, false, ext::nullopt, ext::nullopt);
+            } else {
+                record(invocation, false, ext::nullopt, ext::nullopt);
+                failure(batch, index);
+            }
+        }
+
+        if (_failed) {
+            if (_failingCompletion) {
+                _failingCompletion(false);
+            }
+            return false;
+        }
+
+        return true;
+    }
+
+    /*
+     * If the build was cancelled. Checked before starting anything new.
+     */
+    bool cancelled() const
+    {
+        return _cancelled || (_cancellation != nullptr && _cancellation->cancelled());
+    }
+
+    /*
+     * The invocations that caused the failure, if any.
+     */
+    std::vector<pbxbuild::Tool::Invocation> const &failingInvocations() const
+    {
+        return _failingInvocations;
+    }
+
+private:
+    /*
+     * Note how an invocation's outputs were built in the database. Outputs
+     * of failed invocations are forgotten, since they could be incomplete.
+     * Without a duration or memory used, such as when restored from a cache,
+     * any from before is kept.
+     */
+    void record(pbxbuild::Tool::Invocation const &invocation, bool success, ext::optional<uint64_t> duration, ext::optional<uint64_t> memory)
+    {
+        if (_database == nullptr) {
+            return;
+        }
+
+        ext::optional<std::vector<std::string>> discoveredInputs;
+        if (success) {
+            discoveredInputs = DiscoveredInputs(_filesystem, invocation);
+        }
+
+        std::string commandHash = invocation.fingerprint();
+        for (std::string const &output : invocation.outputs()) {
+            if (discoveredInputs) {
+                xcexecution::BuildDatabase::Entry const *entry = _database->entry(output);
+                uint64_t outputDuration = (duration ? *duration : entry != nullptr ? entry->duration() : 0);
+                uint64_t outputMemory = (memory ? *memory : entry != nullptr ? entry->memory() : 0);
+
+                _database->insert(output, xcexecution::BuildDatabase::Entry(commandHash, *discoveredInputs, outputDuration, outputMemory));
+            } else {
+                _database->erase(output);
+            }
+        }
+    }
+
+    /*
+     * Store a successful invocation's outputs in the action cache.
+     */
+    void cache(pbxbuild::Tool::Invocation const &invocation, ext::optional<std::string> const &cacheKey)
+    {
+        if (_actionCache == nullptr || !cacheKey) {
+            return;
+        }
+
+        /* Not being able to cache only makes later builds slower. */
+        if (ext::optional<std::vector<std::string>> discoveredInputs = DiscoveredInputs(_filesystem, invocation)) {
+            _actionCache->store(_filesystem, *cacheKey, ActionCacheOutputs(invocation), *discoveredInputs);
+        }
+    }
+
+    /*
+     * The lowest numbered job not running an invocation, for the trace.
+     */
+    uint32_t job() const
+    {
+        std::set<uint32_t> running;
+        for (auto const &entry : _running) {
+            running.insert(entry.second.job);
+        }
+
+        uint32_t job = 0;
+        while (running.find(job) != running.end()) {
+            job++;
+        }
+        return job;
+    }
+
+    /*
+     * Record a finished invocation in the trace, if any.
+     */
+    void trace(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, uint32_t job, uint64_t start, ext::optional<int64_t> const &processIdentifier, ext::optional<int> const &exitCode)
+    {
+        if (_trace == nullptr) {
+            return;
+        }
+
+        Trace::Arguments arguments = {
+            { "tool", invocation.toolIdentifier() },
+            { "executable", executable },
+        };
+        if (processIdentifier) {
+            arguments.push_back({ "pid", std::to_string(*processIdentifier) });
+        }
+        arguments.push_back({ "exit status", exitCode ? std::to_string(*exitCode) : "none" });
+
+        std::string name = (!invocation.logMessage().empty() ? invocation.logMessage() : FSUtil::GetBaseName(executable));
+        _trace->invocation(name, job, start, _trace->now(), arguments);
+    }
+
+    /*
+     * If another tool can start now. Nothing stops the first tool running.
+     *
+     * With a load average limit, as with `make -l`, tools wait while the
+     * system is at least that busy. A tool also waits if what it used when
+     * it last ran wouldn't fit in the memory available, after the running
+     * tools grow to what they used when they last ran. What they use now
+     * is already taken out of the memory available.
+     */
+    bool admit(pbxbuild::Tool::Invocation const &invocation)
+    {
+        if (_running.empty()) {
+            return true;
+        }
+
+        double load;
+        if (_loadAverage && ::getloadavg(&load, 1) == 1 && load >= *_loadAverage) {
+            return false;
+        }
+
+        if (uint64_t memory = InvocationMemory(_database, invocation)) {
+            for (auto const &entry : _running) {
+                /* Without knowing what it uses now, expect all of it. */
+                uint64_t used = _processLauncher->memory(entry.first).value_or(0);
+                if (entry.second.memory > used) {
+                    memory += entry.second.memory - used;
+                }
+            }
+
+            ext::optional<uint64_t> available = AvailableMemory();
+            if (available && memory > *available) {
+                return false;
+            }
+        }
+
+        if (_jobServer == nullptr || _slots < _jobServer->acquired() + 1) {
+            return true;
+        }
+
+        return _jobServer->acquire();
+    }
+
+    /*
+     * How many threads an admitted tool can use: its own slot, and any
+     * slots that are free now, both here and in the jobserver, and that
+     * no other ready invocation could use. Only tools that take a thread
+     * count use more than one.
+     */
+    size_t threads(pbxbuild::Tool::Invocation const &invocation)
+    {
+        if (!ThreadsArgument(invocation)) {
+            return 1;
+        }
+
+        size_t ready = 0;
+        for (std::unique_ptr<Batch> const &batch : _batches) {
+            ready += batch->ready.size();
+        }
+
+        size_t threads = 1;
+        while (_slots + ready + threads < _jobs) {
+            if (_jobServer != nullptr && _slots + threads >= _jobServer->acquired() + 1 && !_jobServer->acquire()) {
+                break;
+            }
+            threads++;
+        }
+        return threads;
+    }
+
+    /*
+     * The environment to run an invocation's tool with.
+     */
+    EnvironmentVariables const &environment(pbxbuild::Tool::Invocation const &invocation)
+    {
+        EnvironmentVariables const &invocationEnvironment = invocation.sharedEnvironment();
+        if (_jobServer == nullptr) {
+            return invocationEnvironment;
+        }
+
+        auto it = _environments.find(invocationEnvironment.get());
+        if (it == _environments.end()) {
+            /* Builds run by the tool share the jobserver. */
+            std::unordered_map<std::string, std::string> variables = *invocationEnvironment;
+            variables.insert({ "MAKEFLAGS", _jobServer->makeflags() });
+
+            EnvironmentVariables environment = std::make_shared<std::unordered_map<std::string, std::string> const>(std::move(variables));
+            it = _environments.insert({ invocationEnvironment.get(), { invocationEnvironment, environment } }).first;
+        }
+
+        return it->second.second;
+    }
+
+    /*
+     * Give back tokens no longer needed for the tools running.
+     */
+    void releaseTokens()
+    {
+        while (_jobServer != nullptr && _jobServer->acquired() > 0 && _jobServer->acquired() >= _slots) {
+            _jobServer->release();
+        }
+    }
+
+    void complete(Batch *batch, size_t index)
+    {
+        for (size_t dependent : batch->dependents[index]) {
+            if (--batch->dependencyCount[dependent] == 0) {
+                batch->ready.insert(dependent);
+            }
+        }
+
+        batch->remaining--;
+    }
+
+    void failure(Batch *batch, size_t index)
+    {
+        if (!_failed) {
+            _failed = true;
+            _failingInvocations = { *batch->invocations[index] };
+            _failingCompletion = batch->completion;
+        }
+    }
+
+    void startReady()
+    {
+        _waiting = false;
+
+        bool progress = true;
+        while (progress && !_failed) {
+            progress = false;
+
+            for (auto it = _batches.begin(); it != _batches.end() && !_failed;) {
+                Batch *batch = it->get();
+
+                if (batch->remaining == 0) {
+                    /* The callback can add batches; the list keeps this iterator valid. */
+                    Completion completion = batch->completion;
+                    it = _batches.erase(it);
+                    if (completion) {
+                        completion(true);
+                    }
+
+                    progress = true;
+                    continue;
+                }
+
+                ++it;
+            }
+
+            /*
+             * Start the highest priority ready invocation of any batch. For
+             * the same priority, earlier batches go first.
+             */
+            while (!_failed && !_waiting && _slots < _jobs) {
+                Batch *next = nullptr;
+                for (std::unique_ptr<Batch> const &batch : _batches) {
+                    if (!batch->ready.empty() && (next == nullptr || batch->priority[*batch->ready.begin()] > next->priority[*next->ready.begin()])) {
+                        next = batch.get();
+                    }
+                }
+
+                if (next == nullptr) {
+                    break;
+                }
+
+                size_t index = *next->ready.begin();
+                next->ready.erase(next->ready.begin());
+                start(next, index);
+                progress = true;
+            }
+        }
+    }
+
+    void start(Batch *batch, size_t index)
+    {
+        pbxbuild::Tool::Invocation const &invocation = *batch->invocations[index];
+        bool createProductStructure = batch->createProductStructure;
+
+        // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
+        if (!invocation.executable() || invocation.createsProductStructure() != createProductStructure || _dryRun) {
+            complete(batch, index);
+            return;
+        }
+        pbxbuild::Tool::Invocation::Executable const &executable = *invocation.executable();
+
+        /* Try again once a tool finishes. */
+        if (executable.external() && !admit(invocation)) {
+            batch->ready.insert(index);
+            _waiting = true;
+            return;
+        }
+
+        if (_incremental && InvocationUpToDate(_filesystem, _database, invocation)) {
+            xcformatter::Formatter::Print(_formatter->skipInvocation(invocation, false));
+            complete(batch, index);
+            return;
+        }
+
+        ext::optional<std::string> cacheKey;
+        if (_actionCache != nullptr) {
+            cacheKey = ActionCacheKey(_filesystem, invocation);
+            if (cacheKey && _actionCache->restore(_filesystem, *cacheKey, ActionCacheOutputs(invocation), static_cast<bool>(invocation.actionCacheCommand()))) {
+                xcformatter::Formatter::Print(_formatter->skipInvocation(invocation, true));
+                record(invocation, true, ext::nullopt, ext::nullopt);
+                complete(batch, index);
+                return;
+            }
+        }
+
+        for (std::string const &output : invocation.outputs()) {
+            std::string directory = FSUtil::GetDirectoryName(output);
+
+            if (!CreateDirectory(_filesystem, _directories, directory)) {
+                failure(batch, index);
+                return;
+            }
+        }
+
+        if (ext::optional<std::string> const &builtin = executable.builtin()) {
+            /* Builtin tool, find and run in-process. */
+            if (std::shared_ptr<builtin::Driver> driver = _builtins->driver(*builtin)) {
+                xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, *builtin, createProductStructure));
+                uint64_t traceStart = (_trace != nullptr ? _trace->now() : 0);
+
+                process::MemoryContext context = process::MemoryContext(
+                    *builtin,
+                    invocation.workingDirectory(),
+                    invocation.arguments(),
+                    invocation.environment(),
+                    _processContext->userID(),
+                    _processContext->groupID(),
+                    _processContext->userName(),
+                    _processContext->groupName());
+                /* Builtins write to the same streams directly. */
+                xcformatter::Output::Standard()->flush();
+
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                int exitCode = driver->run(&context, _filesystem);
+                uint64_t duration = Milliseconds(start);
+                _cachedFilesystem.invalidate();
+
+                xcformatter::Formatter::Print(_formatter->resultInvocation(invocation, std::string(), exitCode == 0, duration));
+                xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, *builtin, createProductStructure));
+                trace(invocation, *builtin, job(), traceStart, ext::nullopt, exitCode);
+
+                if (exitCode == 0) {
+                    record(invocation, true, duration, ext::nullopt);
+                    cache(invocation, cacheKey);
+                    complete(batch, index);
+                } else {
+                    record(invocation, false, ext::nullopt, ext::nullopt);
+                    failure(batch, index);
+                }
+            } else {
+                /* Failed to find builtin tool. */
+                failure(batch, index);
+            }
+        } else if (ext::optional<std::string> const &external = executable.external()) {
+            /* External tool, find on the filesystem. */
+            ext::optional<std::string> path;
+            if (FSUtil::IsAbsolutePath(*external)) {
+                if (_filesystem->isExecutable(*external)) {
+                    path = external;
+                }
+            } else {
+                path = batch->findExecutable(_filesystem, *external);
+            }
+
+            if (path) {
+                /*
+                 * With other invocations running, hold the output until this
+                 * one finishes, so the output of each stays together.
+                 */
+                std::string output = _formatter->beginInvocation(invocation, *path, createProductStructure);
+                if (_jobs <= 1) {
+                    xcformatter::Formatter::Print(output);
+                    output.clear();
+                }
+
+                /*
+                 * Tools that take a thread count use the slots they took, not
+                 * every core. The count doesn't change what they create, so it
+                 * isn't part of the invocation.
+                 */
+                size_t slots = threads(invocation);
+                ext::optional<std::string> threadsArgument = ThreadsArgument(invocation);
+                std::vector<std::string> threadArguments;
+                if (threadsArgument) {
+                    threadArguments = invocation.arguments();
+                    threadArguments.push_back(*threadsArgument + std::to_string(slots));
+                }
+                std::vector<std::string> const &arguments = (threadsArgument ? threadArguments : invocation.arguments());
+
+                /* The launcher runs the tool, taking the tool and its arguments. */
+                std::vector<std::string> launcherArguments;
+                if (_toolLauncher) {
+                    launcherArguments.reserve(arguments.size() + 1);
+                    launcherArguments.push_back(*path);
+                    launcherArguments.insert(launcherArguments.end(), arguments.begin(), arguments.end());
+                }
+
+                InvocationContext context = InvocationContext(
+                    (_toolLauncher ? *_toolLauncher : *path),
+                    invocation.workingDirectory(),
+                    (_toolLauncher ? launcherArguments : arguments),
+                    environment(invocation),
+                    _processContext);
+
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                uint64_t traceStart = (_trace != nullptr ? _trace->now() : 0);
+                if (ext::optional<process::Launcher::Handle> handle = _processLauncher->start(_filesystem, &context)) {
+                    _running.insert({ *handle, Running { batch, index, *path, cacheKey, start, job(), traceStart, InvocationMemory(_database, invocation), slots, std::move(output) } });
+                    _slots += slots;
+                } else {
+                    /* Failed to launch. */
+                    output += _formatter->resultInvocation(invocation, std::string(), false, 0);
+                    output += _formatter->finishInvocation(invocation, *path, createProductStructure);
+                    xcformatter::Formatter::Print(output);
+                    failure(batch, index);
+                }
+            } else {
+                /* Failed to find executable. */
+                failure(batch, index);
+            }
+        } else {
+            abort();
+        }
+    }
+};
+
+}
+
+/*
+ * Remove the invocations creating debug symbols that nothing else in the
+ * target reads, and return them. They run after the rest of the target,
+ * without holding up its dependents.
+ */
+static std::vector<pbxbuild::Tool::Invocation const *>
+SplitDebugInvocations(std::vector<pbxbuild::Tool::Invocation const *> *invocations)
+{
+    std::unordered_set<std::string> read;
+    for (pbxbuild::Tool::Invocation const *invocation : *invocations) {
+        if (invocation->stage() != pbxbuild::Tool::Invocation::Stage::Debug) {
+            for (std::vector<std::string> const *inputs : { &invocation->inputs(), &invocation->inputDependencies(), &invocation->orderDependencies() }) {
+                read.insert(inputs->begin(), inputs->end());
+            }
+        }
+    }
+
+    std::vector<pbxbuild::Tool::Invocation const *> debug;
+    auto end = std::stable_partition(invocations->begin(), invocations->end(), [&](pbxbuild::Tool::Invocation const *invocation) {
+        return invocation->stage() != pbxbuild::Tool::Invocation::Stage::Debug || std::any_of(invocation->outputs().begin(), invocation->outputs().end(), [&](std::string const &output) {
+            return read.find(output) != read.end();
+        });
+    });
+    debug.insert(debug.end(), end, invocations->end());
+    invocations->erase(end, invocations->end());
+    return debug;
+}
+
+/*
+ * Where a target's plan is saved between builds.
+ */
+static std::string
+TargetPlanPath(pbxbuild::Target::Environment const &targetEnvironment)
+{
+    return targetEnvironment.environment().resolve("TARGET_TEMP_DIR") + "/" + ".xcbuild-plan";
+}
+
+/*
+ * The fingerprint a target's saved plan must match to be reused.
+ */
+static std::string
+TargetPlanFingerprint(
+    Filesystem const *filesystem,
+    std::string const &generator,
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    pbxbuild::Target::Environment const &targetEnvironment)
+{
+    /* Sort dependencies so the fingerprint is stable. */
+    std::vector<pbxproj::PBX::Target::shared_ptr> dependencies = targetGraph.adjacent(target);
+    std::sort(dependencies.begin(), dependencies.end(), [](pbxproj::PBX::Target::shared_ptr const &a, pbxproj::PBX::Target::shared_ptr const &b) {
+        return a->name() < b->name();
+    });
+
+    std::vector<std::string> fileLists;
+    return TargetFingerprint::Create(filesystem, generator, target, targetEnvironment, dependencies, &fileLists);
+}
+
+/*
+ * How long a target took to build last time, from its saved plan and the
+ * build database. Targets without a plan count as the shortest possible,
+ * so they're still spread out between shards.
+ */
+static uint64_t
+TargetCost(
+    Filesystem const *filesystem,
+    BuildDatabase const *database,
+    std::string const &generator,
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    pbxbuild::Target::Environment const &targetEnvironment)
+{
+    uint64_t cost = 1;
+    if (database == nullptr) {
+        return cost;
+    }
+
+    std::string fingerprint = TargetPlanFingerprint(filesystem, generator, targetGraph, target, targetEnvironment);
+    ext::optional<std::vector<pbxbuild::Tool::Invocation>> plan = pbxbuild::Tool::InvocationPlan::Load(filesystem, TargetPlanPath(targetEnvironment), fingerprint);
+    if (!plan) {
+        return cost;
+    }
+
+    /* Each output records how long the whole invocation took. */
+    for (pbxbuild::Tool::Invocation const &invocation : *plan) {
+        uint64_t duration = 0;
+        for (std::string const &output : invocation.outputs()) {
+            if (BuildDatabase::Entry const *entry = database->entry(output)) {
+                duration = std::max(duration, entry->duration());
+            }
+        }
+        cost += duration;
+    }
+
+    return cost;
+}
+
+bool SimpleExecutor::
+build(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    Parameters const &buildParameters,
+    process::Cancellation const *cancellation)
+{
+    ext::optional<pbxbuild::WorkspaceContext> workspaceContext;
+    {
+        Trace::Span span(_trace.get(), "Load workspace", "workspace");
+        workspaceContext = buildParameters.loadWorkspace(filesystem, processContext->userName(), buildEnvironment, processContext->currentDirectory());
+    }
+    if (!workspaceContext) {
+        return false;
+    }
+
+    ext::optional<pbxbuild::Build::Context> buildContext = buildParameters.createBuildContext(*workspaceContext);
+    if (!buildContext) {
+        return false;
+    }
+
+    xcformatter::Formatter::Print(_formatter->begin(*buildContext));
+
+    ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> targetGraph;
+    {
+        Trace::Span span(_trace.get(), "Resolve dependencies", "workspace");
+        targetGraph = buildParameters.resolveDependencies(filesystem, buildEnvironment, *buildContext);
+    }
+    if (!targetGraph) {
+        return false;
+    }
+
+    ext::optional<std::vector<pbxproj::PBX::Target::shared_ptr>> orderedTargets = targetGraph->ordered();
+    if (!orderedTargets) {
+        fprintf(stderr, "error: cycle detected in target dependencies\n");
+        return false;
+    }
+
+    /*
+     * The database of previous builds lives with the other build-level
+     * intermediates. Start from scratch if it's missing or unreadable.
+     */
+    std::string intermediatesDirectory = *buildParameters.intermediatesDirectory(filesystem, buildEnvironment);
+    std::string databasePath = intermediatesDirectory + "/" + ".xcbuild-database";
+
+    std::unique_ptr<BuildDatabase> database;
+    if (_incremental) {
+        ext::optional<BuildDatabase> loaded = BuildDatabase::Load(filesystem, databasePath);
+        database = std::unique_ptr<BuildDatabase>(new BuildDatabase(loaded ? std::move(*loaded) : BuildDatabase()));
+    }
+
+    /*
+     * Changing the executable could change how targets are planned.
+     */
+    std::string generator = TargetFingerprint::Generator(processContext->executablePath());
+
+    /*
+     * A shard builds its share of the targets, and the targets those depend
+     * on. Targets are ordered after their dependencies, so going backwards
+     * finds all of them.
+     */
+    if (_shard) {
+        Trace::Span span(_trace.get(), "Divide targets", "workspace");
+
+        std::vector<uint64_t> costs = std::vector<uint64_t>(orderedTargets->size(), 1);
+        for (size_t i = 0; i < orderedTargets->size(); ++i) {
+            pbxproj::PBX::Target::shared_ptr const &target = (*orderedTargets)[i];
+            ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext->targetEnvironment(buildEnvironment, target);
+            if (targetEnvironment) {
+                costs[i] = TargetCost(filesystem, database.get(), generator, *targetGraph, target, *targetEnvironment);
+            }
+        }
+
+        std::vector<bool> selected = _shard->select(costs);
+        std::unordered_set<pbxproj::PBX::Target::shared_ptr> needed;
+        std::vector<pbxproj::PBX::Target::shared_ptr> shardTargets;
+        for (size_t i = orderedTargets->size(); i-- > 0; ) {
+            pbxproj::PBX::Target::shared_ptr const &target = (*orderedTargets)[i];
+            if (!selected[i] && needed.find(target) == needed.end()) {
+                continue;
+            }
+
+            shardTargets.push_back(target);
+            for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph->adjacent(target)) {
+                needed.insert(dependency);
+            }
+        }
+
+        std::reverse(shardTargets.begin(), shardTargets.end());
+        orderedTargets = std::move(shardTargets);
+    }
+
+    /*
+     * Each target waits for the targets it depends on. Without parallel
+     * targets, each target instead waits for the one ordered before it.
+     */
+    std::vector<std::vector<size_t>> targetDependents = std::vector<std::vector<size_t>>(orderedTargets->size());
+    std::vector<size_t> targetDependencyCount = std::vector<size_t>(orderedTargets->size(), 0);
+    if (_parallelizeTargets) {
+        std::unordered_map<pbxproj::PBX::Target::shared_ptr, size_t> targetIndexes;
+        for (size_t i = 0; i < orderedTargets->size(); ++i) {
+            targetIndexes.insert({ (*orderedTargets)[i], i });
+        }
+
+        for (size_t i = 0; i < orderedTargets->size(); ++i) {
+            for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph->adjacent((*orderedTargets)[i])) {
+                auto it = targetIndexes.find(dependency);
+                if (it != targetIndexes.end() && it->second != i) {
+                    targetDependents[it->second].push_back(i);
+                    targetDependencyCount[i]++;
+                }
+            }
+        }
+    } else {
+        for (size_t i = 1; i < orderedTargets->size(); ++i) {
+            targetDependents[i - 1].push_back(i);
+            targetDependencyCount[i] = 1;
+        }
+    }
+
+    std::unique_ptr<ActionCache> actionCache;
+    if (_actionCache) {
+        actionCache = std::unique_ptr<ActionCache>(new ActionCache(*_actionCache));
+    }
+
+    if (!_dryRun && !startBuildSession(filesystem, buildEnvironment, buildParameters)) {
+        return false;
+    }
+
+    std::unordered_set<std::string> directories;
+    Scheduler scheduler(_formatter, &_builtins, _dryRun, _jobs, _loadAverage, _incremental, database.get(), actionCache.get(), _toolLauncher, _trace.get(), processContext, processLauncher, cancellation, filesystem, &directories);
+    std::vector<std::unique_ptr<pbxbuild::Phase::PhaseInvocations>> targetInvocations = std::vector<std::unique_ptr<pbxbuild::Phase::PhaseInvocations>>(orderedTargets->size());
+
+    std::function<void(size_t)> startTarget;
+    std::function<void(size_t)> startDependents = [&](size_t index) {
+        for (size_t dependent : targetDependents[index]) {
+            if (--targetDependencyCount[dependent] == 0) {
+                startTarget(dependent);
+            }
+        }
+    };
+    std::function<void(size_t)> finishTarget = [&](size_t index) {
+        pbxproj::PBX::Target::shared_ptr const &target = (*orderedTargets)[index];
+        xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
+        targetInvocations[index].reset();
+    };
+
+    startTarget = [&](size_t index) {
+        /* Planning a target can take a while; don't start one once cancelled. */
+        if (scheduler.cancelled()) {
+            scheduler.fail();
+            return;
+        }
+
+        pbxproj::PBX::Target::shared_ptr const &target = (*orderedTargets)[index];
+        xcformatter::Formatter::Print(_formatter->beginTarget(*buildContext, target));
+
+        Trace::Arguments traceArguments = { { "target", target->name() } };
+
+        ext::optional<pbxbuild::Target::Environment> targetEnvironment;
+        {
+            Trace::Span span(_trace.get(), "Create target environment", "target", traceArguments);
+            targetEnvironment = buildContext->targetEnvironment(buildEnvironment, target);
+        }
+        if (!targetEnvironment) {
+            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
+            finishTarget(index);
+            startDependents(index);
+            return;
+        }
+
+        xcformatter::Formatter::Print(_formatter->beginCheckDependencies(target));
+
+        /*
+         * Planning is the slow part of starting a target, so when building
+         * incrementally, reuse the plan from the last build if nothing the
+         * target is planned from has changed.
+         */
+        std::string planPath = TargetPlanPath(*targetEnvironment);
+        std::string planFingerprint;
+        if (_incremental) {
+            Trace::Span span(_trace.get(), "Load plan", "target", traceArguments);
+            planFingerprint = TargetPlanFingerprint(filesystem, generator, *targetGraph, target, *targetEnvironment);
+
+            ext::optional<std::vector<pbxbuild::Tool::Invocation>> plan = pbxbuild::Tool::InvocationPlan::Load(filesystem, planPath, planFingerprint);
+            if (plan) {
+                targetInvocations[index] = std::unique_ptr<pbxbuild::Phase::PhaseInvocations>(new pbxbuild::Phase::PhaseInvocations(std::move(*plan)));
+            }
+        }
+
+        if (targetInvocations[index] == nullptr) {
+            {
+                Trace::Span span(_trace.get(), "Resolve phases", "target", traceArguments);
+                pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, *buildContext, target, *targetEnvironment);
+                targetInvocations[index] = std::unique_ptr<pbxbuild::Phase::PhaseInvocations>(new pbxbuild::Phase::PhaseInvocations(pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target)));
+            }
+
+            if (_incremental && !_dryRun) {
+                /* A plan that can't be saved is planned again next time. */
+                if (CreateDirectory(filesystem, &directories, FSUtil::GetDirectoryName(planPath))) {
+                    pbxbuild::Tool::InvocationPlan::Save(filesystem, planPath, planFingerprint, targetInvocations[index]->invocations());
+                }
+            }
+        }
+        pbxbuild::Phase::PhaseInvocations const &phaseInvocations = *targetInvocations[index];
+        xcformatter::Formatter::Print(_formatter->finishCheckDependencies(target));
+
+        if (!writeAuxiliaryFiles(filesystem, &directories, target, *targetEnvironment, phaseInvocations.invocations())) {
+            xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
+            scheduler.fail();
+            return;
+        }
+
+        /* Batches point into the invocations, which live until the target finishes. */
+        ext::optional<std::vector<pbxbuild::Tool::Invocation const *>> orderedInvocations = SortInvocations(phaseInvocations.invocations());
+        if (!orderedInvocations) {
+            fprintf(stderr, "error: cycle detected building invocation graph\n");
+            xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
+            scheduler.fail();
+            return;
+        }
+
+        std::vector<pbxbuild::Tool::Invocation const *> invocations = std::move(*orderedInvocations);
+        std::vector<pbxbuild::Tool::Invocation const *> debugInvocations = SplitDebugInvocations(&invocations);
+
+        /*
+         * Tools are found through the target environment, which remembers
+         * each tool found so the search paths aren't probed per invocation.
+         */
+        std::shared_ptr<pbxbuild::Target::Environment> sharedTargetEnvironment = std::make_shared<pbxbuild::Target::Environment>(*targetEnvironment);
+        Scheduler::FindExecutable findExecutable = [sharedTargetEnvironment](Filesystem const *filesystem, std::string const &name) {
+            return sharedTargetEnvironment->executable(filesystem, name);
+        };
+
+        /*
+         * Create the product structure first, then run the remaining invocations.
+         */
+        xcformatter::Formatter::Print(_formatter->beginCreateProductStructure(target));
+        scheduler.add(invocations, findExecutable, true, [this, &scheduler, &startDependents, &finishTarget, &buildContext, target, index, invocations, debugInvocations, findExecutable](bool success) {
+            xcformatter::Formatter::Print(_formatter->finishCreateProductStructure(target));
+            if (!success) {
+                xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
+                return;
+            }
+
+            scheduler.add(invocations, findExecutable, false, [this, &scheduler, &startDependents, &finishTarget, &buildContext, target, index, debugInvocations, findExecutable](bool success) {
+                if (!success) {
+                    xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
+                    return;
+                }
+
+                if (debugInvocations.empty()) {
+                    finishTarget(index);
+                    startDependents(index);
+                    return;
+                }
+
+                /*
+                 * Dependents start now; debug symbols are created alongside
+                 * them, and the target finishes once they're done.
+                 */
+                startDependents(index);
+                scheduler.add(debugInvocations, findExecutable, false, [this, &finishTarget, &buildContext, target, index](bool success) {
+                    if (!success) {
+                        xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
+                        return;
+                    }
+
+                    finishTarget(index);
+                });
+            });
+        });
+    };
+
+    for (size_t i = 0; i < orderedTargets->size(); ++i) {
+        if (targetDependencyCount[i] == 0) {
+            startTarget(i);
+        }
+    }
+
+    bool success = scheduler.run();
+
+    /*
+     * Save what was built even after a failure, so it isn't built again.
+     */
+    if (database != nullptr && !_dryRun) {
+        if (!filesystem->createDirectory(intermediatesDirectory) || !database->save(filesystem, databasePath)) {
+            fprintf(stderr, "warning: failed to save build database to %s\n", databasePath.c_str());
+        }
+    }
+
+    if (!success) {
+        if (scheduler.cancelled()) {
+            xcformatter::Formatter::Print(_formatter->cancelled(*buildContext));
+        } else {
+            xcformatter::Formatter::Print(_formatter->failure(*buildContext, scheduler.failingInvocations()));
+        }
+        return false;
+    }
+
+    xcformatter::Formatter::Print(_formatter->success(*buildContext));
+    return true;
+}
+
+std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
+performInvocations(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    std::vector<std::string> const &executablePaths,
+    std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
+    bool createProductStructure,
+    BuildDatabase *database,
+    process::Cancellation const *cancellation)
+{
+    std::unique_ptr<ActionCache> actionCache;
+    if (_actionCache) {
+        actionCache = std::unique_ptr<ActionCache>(new ActionCache(*_actionCache));
+    }
+
+    std::vector<pbxbuild::Tool::Invocation const *> invocations;
+    invocations.reserve(orderedInvocations.size());
+    for (pbxbuild::Tool::Invocation const &invocation : orderedInvocations) {
+        invocations.push_back(&invocation);
+    }
+
+    Scheduler::FindExecutable findExecutable = [&executablePaths](Filesystem const *filesystem, std::string const &name) {
+        return filesystem->findExecutable(name, executablePaths);
+    };
+
+    std::unordered_set<std::string> directories;
+    Scheduler scheduler(_formatter, &_builtins, _dryRun, _jobs, _loadAverage, _incremental, database, actionCache.get(), _toolLauncher, _trace.get(), processContext, processLauncher, cancellation, filesystem, &directories);
+    scheduler.add(invocations, findExecutable, createProductStructure, nullptr);
+
+    if (!scheduler.run()) {
+        return std::make_pair(false, scheduler.failingInvocations());
     }
 
     return std::make_pair(true, std::vector<pbxbuild::Tool::Invocation>());
 }
 
 std::unique_ptr<SimpleExecutor> SimpleExecutor::
-Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins)
+Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs, bool parallelizeTargets, bool incremental, ext::optional<std::string> const &actionCache, ext::optional<std::string> const &toolLauncher, ext::optional<Shard> const &shard, std::shared_ptr<Trace> const &trace, ext::optional<double> const &loadAverage)
 {
     return std::unique_ptr<SimpleExecutor>(new SimpleExecutor(
         formatter,
         dryRun,
-        builtins
+        builtins,
+        jobs,
+        parallelizeTargets,
+        incremental,
+        actionCache,
+        toolLauncher,
+        shard,
+        trace,
+        loadAverage
     ));
 }
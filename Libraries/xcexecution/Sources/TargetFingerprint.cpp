@@ -0,0 +1,229 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/TargetFingerprint.h>
+#include <pbxbuild/Target/Environment.h>
+#include <pbxproj/PBX/BaseGroup.h>
+#include <pbxproj/PBX/BuildRule.h>
+#include <pbxproj/PBX/CopyFilesBuildPhase.h>
+#include <pbxproj/PBX/FileReference.h>
+#include <pbxproj/PBX/LegacyTarget.h>
+#include <pbxproj/PBX/NativeTarget.h>
+#include <pbxproj/PBX/ReferenceProxy.h>
+#include <pbxproj/PBX/ShellScriptBuildPhase.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/Hash.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+using xcexecution::TargetFingerprint;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::Hash;
+
+TargetFingerprint::
+TargetFingerprint()
+{
+}
+
+TargetFingerprint::
+~TargetFingerprint()
+{
+}
+
+std::string TargetFingerprint::
+Generator(std::string const &executablePath)
+{
+    /*
+     * A new generator could plan targets differently.
+     */
+    std::string fingerprint = executablePath;
+
+    struct stat st;
+    if (::stat(executablePath.c_str(), &st) == 0) {
+        fingerprint += " " + std::to_string(static_cast<long long>(st.st_mtime));
+    }
+
+    return fingerprint;
+}
+
+static void
+AppendFingerprint(std::string *fingerprint, std::string const &value)
+{
+    /* Include trailing NUL terminator to separate values. */
+    fingerprint->append(value);
+    fingerprint->push_back('\0');
+}
+
+static void
+AppendFingerprint(std::string *fingerprint, pbxsetting::Environment const &environment, pbxproj::PBX::GroupItem::shared_ptr const &item)
+{
+    if (item == nullptr) {
+        AppendFingerprint(fingerprint, "<none>");
+        return;
+    }
+
+    AppendFingerprint(fingerprint, std::to_string(static_cast<int>(item->type())));
+    AppendFingerprint(fingerprint, item->name());
+    AppendFingerprint(fingerprint, environment.expand(item->resolve()));
+
+    switch (item->type()) {
+        case pbxproj::PBX::GroupItem::Type::FileReference: {
+            auto fileReference = std::static_pointer_cast<pbxproj::PBX::FileReference>(item);
+            AppendFingerprint(fingerprint, fileReference->lastKnownFileType());
+            AppendFingerprint(fingerprint, fileReference->explicitFileType());
+            break;
+        }
+        case pbxproj::PBX::GroupItem::Type::ReferenceProxy: {
+            auto referenceProxy = std::static_pointer_cast<pbxproj::PBX::ReferenceProxy>(item);
+            AppendFingerprint(fingerprint, referenceProxy->fileType());
+            break;
+        }
+        case pbxproj::PBX::GroupItem::Type::Group:
+        case pbxproj::PBX::GroupItem::Type::VariantGroup:
+        case pbxproj::PBX::GroupItem::Type::VersionGroup: {
+            auto group = std::static_pointer_cast<pbxproj::PBX::BaseGroup>(item);
+            for (pbxproj::PBX::GroupItem::shared_ptr const &child : group->children()) {
+                AppendFingerprint(fingerprint, environment, child);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+std::string TargetFingerprint::
+Create(
+    Filesystem const *filesystem,
+    std::string const &generator,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    pbxbuild::Target::Environment const &targetEnvironment,
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &dependencies,
+    std::vector<std::string> *fileLists)
+{
+    pbxsetting::Environment const &environment = targetEnvironment.environment();
+
+    std::string fingerprint;
+    AppendFingerprint(&fingerprint, generator);
+    AppendFingerprint(&fingerprint, target->blueprintIdentifier());
+    AppendFingerprint(&fingerprint, target->name());
+
+    /*
+     * Build settings. The levels decide every value, so there's no need to
+     * resolve them all when the target is up to date.
+     */
+    AppendFingerprint(&fingerprint, environment.fingerprint());
+
+    AppendFingerprint(&fingerprint, "<variants>");
+    for (std::string const &variant : targetEnvironment.variants()) {
+        AppendFingerprint(&fingerprint, variant);
+    }
+
+    AppendFingerprint(&fingerprint, "<architectures>");
+    for (std::string const &architecture : targetEnvironment.architectures()) {
+        AppendFingerprint(&fingerprint, architecture);
+    }
+
+    /*
+     * Target type specific properties.
+     */
+    if (target->type() == pbxproj::PBX::Target::Type::Native) {
+        auto nativeTarget = std::static_pointer_cast<pbxproj::PBX::NativeTarget>(target);
+        AppendFingerprint(&fingerprint, nativeTarget->productType());
+        for (pbxproj::PBX::BuildRule::shared_ptr const &buildRule : nativeTarget->buildRules()) {
+            AppendFingerprint(&fingerprint, "<rule>");
+            AppendFingerprint(&fingerprint, buildRule->compilerSpec());
+            AppendFingerprint(&fingerprint, buildRule->filePatterns());
+            AppendFingerprint(&fingerprint, buildRule->fileType());
+            AppendFingerprint(&fingerprint, buildRule->script());
+            for (std::string const &outputFile : buildRule->outputFiles()) {
+                AppendFingerprint(&fingerprint, outputFile);
+            }
+        }
+    } else if (target->type() == pbxproj::PBX::Target::Type::Legacy) {
+        auto legacyTarget = std::static_pointer_cast<pbxproj::PBX::LegacyTarget>(target);
+        AppendFingerprint(&fingerprint, legacyTarget->buildToolPath());
+        AppendFingerprint(&fingerprint, environment.expand(legacyTarget->buildArgumentsString()));
+        AppendFingerprint(&fingerprint, legacyTarget->buildWorkingDirectory());
+        AppendFingerprint(&fingerprint, legacyTarget->passBuildSettingsInEnvironment() ? "YES" : "NO");
+    }
+
+    /*
+     * Build phases and their files.
+     */
+    for (pbxproj::PBX::BuildPhase::shared_ptr const &buildPhase : target->buildPhases()) {
+        AppendFingerprint(&fingerprint, "<phase>");
+        AppendFingerprint(&fingerprint, std::to_string(static_cast<int>(buildPhase->type())));
+        AppendFingerprint(&fingerprint, buildPhase->name());
+        AppendFingerprint(&fingerprint, std::to_string(buildPhase->buildActionMask()));
+        AppendFingerprint(&fingerprint, buildPhase->runOnlyForDeploymentPostprocessing() ? "YES" : "NO");
+
+        if (buildPhase->type() == pbxproj::PBX::BuildPhase::Type::ShellScript) {
+            auto shellScriptBuildPhase = std::static_pointer_cast<pbxproj::PBX::ShellScriptBuildPhase>(buildPhase);
+            AppendFingerprint(&fingerprint, shellScriptBuildPhase->shellPath());
+            AppendFingerprint(&fingerprint, shellScriptBuildPhase->shellScript());
+            AppendFingerprint(&fingerprint, shellScriptBuildPhase->showEnvVarsInLog() ? "YES" : "NO");
+            for (pbxsetting::Value const &inputPath : shellScriptBuildPhase->inputPaths()) {
+                AppendFingerprint(&fingerprint, environment.expand(inputPath));
+            }
+            AppendFingerprint(&fingerprint, "<outputs>");
+            for (pbxsetting::Value const &outputPath : shellScriptBuildPhase->outputPaths()) {
+                AppendFingerprint(&fingerprint, environment.expand(outputPath));
+            }
+            AppendFingerprint(&fingerprint, shellScriptBuildPhase->alwaysOutOfDate() ? "YES" : "NO");
+
+            for (std::vector<pbxsetting::Value> const *fileListPaths : { &shellScriptBuildPhase->inputFileListPaths(), &shellScriptBuildPhase->outputFileListPaths() }) {
+                AppendFingerprint(&fingerprint, "<file-lists>");
+                for (pbxsetting::Value const &fileListPath : *fileListPaths) {
+                    std::string path = FSUtil::ResolveRelativePath(environment.expand(fileListPath), targetEnvironment.workingDirectory());
+                    AppendFingerprint(&fingerprint, path);
+
+                    std::vector<uint8_t> contents;
+                    if (filesystem->read(&contents, path)) {
+                        AppendFingerprint(&fingerprint, std::string(contents.begin(), contents.end()));
+                        fileLists->push_back(path);
+                    } else {
+                        AppendFingerprint(&fingerprint, "<missing>");
+                    }
+                }
+            }
+        } else if (buildPhase->type() == pbxproj::PBX::BuildPhase::Type::CopyFiles) {
+            auto copyFilesBuildPhase = std::static_pointer_cast<pbxproj::PBX::CopyFilesBuildPhase>(buildPhase);
+            AppendFingerprint(&fingerprint, environment.expand(copyFilesBuildPhase->dstPath()));
+            AppendFingerprint(&fingerprint, std::to_string(static_cast<int>(copyFilesBuildPhase->dstSubfolderSpec())));
+        }
+
+        for (pbxproj::PBX::BuildFile::shared_ptr const &buildFile : buildPhase->files()) {
+            AppendFingerprint(&fingerprint, "<file>");
+            AppendFingerprint(&fingerprint, environment, buildFile->fileRef());
+            for (std::string const &compilerFlag : buildFile->compilerFlags()) {
+                AppendFingerprint(&fingerprint, compilerFlag);
+            }
+            AppendFingerprint(&fingerprint, "<attributes>");
+            for (std::string const &attribute : buildFile->attributes()) {
+                AppendFingerprint(&fingerprint, attribute);
+            }
+        }
+    }
+
+    /*
+     * The target's dependencies, which the target's start waits for.
+     */
+    AppendFingerprint(&fingerprint, "<dependencies>");
+    for (pbxproj::PBX::Target::shared_ptr const &dependency : dependencies) {
+        AppendFingerprint(&fingerprint, dependency->name());
+    }
+
+    Hash hash;
+    hash.update(fingerprint);
+    return hash.hex();
+}
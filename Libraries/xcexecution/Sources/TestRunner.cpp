@@ -0,0 +1,232 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/TestRunner.h>
+#include <libutil/Filesystem.h>
+#include <process/Context.h>
+#include <process/MemoryContext.h>
+#include <process/Launcher.h>
+
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <sstream>
+
+using xcexecution::TestRunner;
+using libutil::Filesystem;
+
+TestRunner::Job::
+Job(std::string const &name, std::vector<std::string> const &arguments) :
+    _name     (name),
+    _arguments(arguments)
+{
+}
+
+TestRunner::Result::
+Result(std::string const &name, ext::optional<int> const &exitCode, std::string const &output, uint64_t duration) :
+    _name    (name),
+    _exitCode(exitCode),
+    _output  (output),
+    _duration(duration)
+{
+}
+
+TestRunner::History::
+History()
+{
+}
+
+ext::optional<uint64_t> TestRunner::History::
+duration(std::string const &name) const
+{
+    auto it = _durations.find(name);
+    if (it == _durations.end()) {
+        return ext::nullopt;
+    }
+
+    return it->second;
+}
+
+void TestRunner::History::
+record(std::string const &name, uint64_t duration)
+{
+    _durations[name] = duration;
+}
+
+std::string TestRunner::History::
+serialize() const
+{
+    /* Sorted, so the file only changes when a duration does. */
+    std::vector<std::pair<std::string, uint64_t>> durations = std::vector<std::pair<std::string, uint64_t>>(_durations.begin(), _durations.end());
+    std::sort(durations.begin(), durations.end());
+
+    std::string contents;
+    for (std::pair<std::string, uint64_t> const &entry : durations) {
+        contents += std::to_string(entry.second) + " " + entry.first + "\n";
+    }
+    return contents;
+}
+
+TestRunner::History TestRunner::History::
+Deserialize(std::string const &contents)
+{
+    History history;
+
+    std::istringstream stream = std::istringstream(contents);
+    std::string line;
+    while (std::getline(stream, line)) {
+        std::string::size_type space = line.find(' ');
+        if (space == std::string::npos || space == 0 || space + 1 == line.size()) {
+            continue;
+        }
+
+        std::string number = line.substr(0, space);
+        if (number.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+
+        history.record(line.substr(space + 1), std::stoull(number));
+    }
+
+    return history;
+}
+
+TestRunner::History TestRunner::History::
+Load(Filesystem const *filesystem, std::string const &path)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->isReadable(path) || !filesystem->read(&contents, path)) {
+        return History();
+    }
+
+    return Deserialize(std::string(contents.begin(), contents.end()));
+}
+
+bool TestRunner::History::
+save(Filesystem *filesystem, std::string const &path) const
+{
+    std::string contents = serialize();
+    return filesystem->writeIfChanged(std::vector<uint8_t>(contents.begin(), contents.end()), path);
+}
+
+std::vector<uint64_t> TestRunner::
+Estimate(std::vector<Job> const &jobs, History const &history)
+{
+    uint64_t longest = 1;
+    for (Job const &job : jobs) {
+        if (ext::optional<uint64_t> duration = history.duration(job.name())) {
+            longest = std::max(longest, *duration);
+        }
+    }
+
+    std::vector<uint64_t> estimates;
+    estimates.reserve(jobs.size());
+    for (Job const &job : jobs) {
+        estimates.push_back(history.duration(job.name()).value_or(longest));
+    }
+    return estimates;
+}
+
+std::vector<TestRunner::Result> TestRunner::
+Run(
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    process::Context const *processContext,
+    std::string const &executable,
+    std::vector<Job> const &jobs,
+    size_t workers,
+    History *history,
+    std::function<void(Result const &)> const &finished)
+{
+    workers = std::max<size_t>(1, workers);
+
+    /* Longest first. Equal jobs keep their order, so runs are repeatable. */
+    std::vector<uint64_t> estimates = Estimate(jobs, *history);
+    std::vector<size_t> order = std::vector<size_t>(jobs.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return estimates[a] > estimates[b];
+    });
+
+    struct Running {
+        size_t                                index;
+        std::chrono::steady_clock::time_point start;
+    };
+    std::unordered_map<process::Launcher::Handle, Running> running;
+
+    /* Contexts must outlive their processes starting; keep them all. */
+    std::list<process::MemoryContext> contexts;
+
+    std::vector<ext::optional<Result>> results = std::vector<ext::optional<Result>>(jobs.size());
+    auto complete = [&](size_t index, Result const &result) {
+        history->record(result.name(), result.duration());
+        results[index] = result;
+        if (finished) {
+            finished(result);
+        }
+    };
+
+    size_t next = 0;
+    while (next < order.size() || !running.empty()) {
+        /*
+         * Fill every free worker with the longest job left.
+         */
+        while (next < order.size() && running.size() < workers) {
+            size_t index = order[next++];
+            Job const &job = jobs[index];
+
+            contexts.emplace_back(processContext);
+            process::MemoryContext &context = contexts.back();
+            context.executablePath() = executable;
+            context.commandLineArguments() = job.arguments();
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            ext::optional<process::Launcher::Handle> handle = processLauncher->start(filesystem, &context);
+            if (!handle) {
+                complete(index, Result(job.name(), ext::nullopt, "error: unable to launch " + executable + "\n", 0));
+                continue;
+            }
+
+            running.insert({ *handle, Running { index, start } });
+        }
+
+        if (running.empty()) {
+            continue;
+        }
+
+        ext::optional<process::Launcher::Result> exited = processLauncher->wait();
+        if (!exited) {
+            break;
+        }
+
+        auto it = running.find(exited->handle());
+        if (it == running.end()) {
+            continue;
+        }
+
+        size_t index = it->second.index;
+        uint64_t duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - it->second.start).count();
+        running.erase(it);
+
+        complete(index, Result(jobs[index].name(), exited->exitCode(), exited->output(), duration));
+    }
+
+    std::vector<Result> ordered;
+    ordered.reserve(results.size());
+    for (size_t i = 0; i < results.size(); i++) {
+        if (results[i]) {
+            ordered.push_back(*results[i]);
+        } else {
+            ordered.push_back(Result(jobs[i].name(), ext::nullopt, std::string(), 0));
+        }
+    }
+    return ordered;
+}
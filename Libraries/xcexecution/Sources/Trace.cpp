@@ -0,0 +1,144 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/Trace.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/JSON.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+
+#include <set>
+
+using xcexecution::Trace;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+/* Trace processes, which group the tracks in the trace viewer. */
+static int64_t const BuildProcess = 1;
+static int64_t const ToolsProcess = 2;
+
+Trace::Span::
+Span(Trace *trace, std::string const &name, std::string const &category, Arguments const &arguments) :
+    _trace    (trace),
+    _name     (name),
+    _category (category),
+    _arguments(arguments),
+    _start    (trace != nullptr ? trace->now() : 0)
+{
+}
+
+Trace::Span::
+~Span()
+{
+    if (_trace != nullptr) {
+        _trace->step(_name, _category, _start, _trace->now(), _arguments);
+    }
+}
+
+Trace::
+Trace() :
+    _start(std::chrono::steady_clock::now())
+{
+}
+
+Trace::
+~Trace()
+{
+}
+
+uint64_t Trace::
+now() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+void Trace::
+step(std::string const &name, std::string const &category, uint64_t start, uint64_t end, Arguments const &arguments)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    /* Number threads in the order they first record a step. */
+    uint32_t lane = _threads.insert({ std::this_thread::get_id(), static_cast<uint32_t>(_threads.size()) }).first->second;
+    _events.push_back(Event { name, category, start, end - start, false, lane, arguments });
+}
+
+void Trace::
+invocation(std::string const &name, uint32_t job, uint64_t start, uint64_t end, Arguments const &arguments)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _events.push_back(Event { name, "invocation", start, end - start, true, job, arguments });
+}
+
+static std::unique_ptr<plist::Dictionary>
+MetadataEvent(std::string const &name, int64_t process, ext::optional<int64_t> const &thread, std::string const &value)
+{
+    auto arguments = plist::Dictionary::New();
+    arguments->set("name", plist::String::New(value));
+
+    auto event = plist::Dictionary::New();
+    event->set("name", plist::String::New(name));
+    event->set("ph", plist::String::New("M"));
+    event->set("pid", plist::Integer::New(process));
+    if (thread) {
+        event->set("tid", plist::Integer::New(*thread));
+    }
+    event->set("args", std::move(arguments));
+    return event;
+}
+
+bool Trace::
+write(Filesystem *filesystem, std::string const &path) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto events = plist::Array::New();
+    events->append(MetadataEvent("process_name", BuildProcess, ext::nullopt, "xcbuild"));
+    events->append(MetadataEvent("process_name", ToolsProcess, ext::nullopt, "Tools"));
+
+    std::set<uint32_t> jobs;
+    for (Event const &event : _events) {
+        auto arguments = plist::Dictionary::New();
+        for (std::pair<std::string, std::string> const &argument : event.arguments) {
+            arguments->set(argument.first, plist::String::New(argument.second));
+        }
+
+        auto entry = plist::Dictionary::New();
+        entry->set("name", plist::String::New(event.name));
+        entry->set("cat", plist::String::New(event.category));
+        entry->set("ph", plist::String::New("X"));
+        entry->set("ts", plist::Integer::New(static_cast<int64_t>(event.start)));
+        entry->set("dur", plist::Integer::New(static_cast<int64_t>(event.duration)));
+        entry->set("pid", plist::Integer::New(event.invocation ? ToolsProcess : BuildProcess));
+        entry->set("tid", plist::Integer::New(event.lane));
+        entry->set("args", std::move(arguments));
+        events->append(std::move(entry));
+
+        if (event.invocation) {
+            jobs.insert(event.lane);
+        }
+    }
+
+    for (uint32_t job : jobs) {
+        events->append(MetadataEvent("thread_name", ToolsProcess, static_cast<int64_t>(job), "Job " + std::to_string(job + 1)));
+    }
+
+    auto trace = plist::Dictionary::New();
+    trace->set("traceEvents", std::move(events));
+    trace->set("displayTimeUnit", plist::String::New("ms"));
+
+    auto serialized = plist::Format::JSON::Serialize(trace.get(), plist::Format::JSON::Create());
+    if (serialized.first == nullptr) {
+        return false;
+    }
+
+    return filesystem->createDirectory(FSUtil::GetDirectoryName(path)) && filesystem->write(*serialized.first, path);
+}
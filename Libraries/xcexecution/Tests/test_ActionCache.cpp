@@ -0,0 +1,74 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/ActionCache.h>
+#include <libutil/MemoryFilesystem.h>
+
+using xcexecution::ActionCache;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+TEST(ActionCache, Key)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("input", Contents("one")),
+        MemoryFilesystem::Entry::Directory("directory", { }),
+    });
+
+    ext::optional<std::string> key = ActionCache::Key(&filesystem, "command", { "/input" });
+    ASSERT_TRUE(key);
+    EXPECT_EQ(*key, ActionCache::Key(&filesystem, "command", { "/input" }));
+
+    /* Depends on the command and input contents. */
+    EXPECT_NE(*key, ActionCache::Key(&filesystem, "other", { "/input" }));
+    ASSERT_TRUE(filesystem.write(Contents("two"), "/input"));
+    EXPECT_NE(*key, ActionCache::Key(&filesystem, "command", { "/input" }));
+
+    /* Inputs that can't be hashed can't be cached. */
+    EXPECT_FALSE(ActionCache::Key(&filesystem, "command", { "/missing" }));
+    EXPECT_FALSE(ActionCache::Key(&filesystem, "command", { "/directory" }));
+}
+
+TEST(ActionCache, StoreRestore)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("header", Contents("header")),
+        MemoryFilesystem::Entry::File("output", Contents("output")),
+    });
+
+    ActionCache cache = ActionCache("/cache");
+    EXPECT_FALSE(cache.restore(&filesystem, "key", { "/output" }));
+    ASSERT_TRUE(cache.store(&filesystem, "key", { "/output" }, { "/header" }));
+
+    /* Restores into a clean tree. */
+    ASSERT_TRUE(filesystem.removeFile("/output"));
+    ASSERT_TRUE(cache.restore(&filesystem, "key", { "/output" }));
+    std::vector<uint8_t> contents;
+    ASSERT_TRUE(filesystem.read(&contents, "/output"));
+    EXPECT_EQ(Contents("output"), contents);
+
+    /* Only for the same outputs. */
+    EXPECT_FALSE(cache.restore(&filesystem, "key", { "/output", "/other" }));
+    EXPECT_FALSE(cache.restore(&filesystem, "key", { "/other" }));
+
+    /* Unless they're relocatable. */
+    ASSERT_TRUE(cache.restore(&filesystem, "key", { "/other" }, true));
+    ASSERT_TRUE(filesystem.read(&contents, "/other"));
+    EXPECT_EQ(Contents("output"), contents);
+
+    /* Not after a discovered input changed. */
+    ASSERT_TRUE(filesystem.write(Contents("changed"), "/header"));
+    EXPECT_FALSE(cache.restore(&filesystem, "key", { "/output" }));
+}
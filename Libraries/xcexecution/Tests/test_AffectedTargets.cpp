@@ -0,0 +1,32 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/AffectedTargets.h>
+
+using xcexecution::AffectedTargets;
+
+TEST(AffectedTargets, Contains)
+{
+    std::vector<std::string> inputs = {
+        "/project/Sources/main.m",
+        "/project/Resources",
+    };
+
+    EXPECT_TRUE(AffectedTargets::Contains(inputs, "/project/Sources/main.m"));
+    EXPECT_FALSE(AffectedTargets::Contains(inputs, "/project/Sources/main.mm"));
+    EXPECT_FALSE(AffectedTargets::Contains(inputs, "/project/Sources"));
+
+    /* Folders contain what's in them. */
+    EXPECT_TRUE(AffectedTargets::Contains(inputs, "/project/Resources"));
+    EXPECT_TRUE(AffectedTargets::Contains(inputs, "/project/Resources/en.lproj/Main.strings"));
+    EXPECT_FALSE(AffectedTargets::Contains(inputs, "/project/ResourcesOld/image.png"));
+
+    EXPECT_FALSE(AffectedTargets::Contains({ }, "/project/Sources/main.m"));
+}
@@ -0,0 +1,54 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/BuildDatabase.h>
+#include <libutil/MemoryFilesystem.h>
+
+using xcexecution::BuildDatabase;
+using libutil::MemoryFilesystem;
+
+TEST(BuildDatabase, SaveLoad)
+{
+    auto filesystem = MemoryFilesystem({ });
+
+    BuildDatabase database;
+    database.insert("/out/a.o", BuildDatabase::Entry("hash1", { "/src/a.c", "/src/a.h" }, 1500, 64 * 1024 * 1024));
+    database.insert("/out/b.o", BuildDatabase::Entry("hash2", { }, 0, 0));
+    database.insert("/out/c.o", BuildDatabase::Entry("hash3", { }, 0, 0));
+    database.erase("/out/c.o");
+    ASSERT_TRUE(database.save(&filesystem, "/database"));
+
+    ext::optional<BuildDatabase> loaded = BuildDatabase::Load(&filesystem, "/database");
+    ASSERT_TRUE(loaded);
+
+    BuildDatabase::Entry const *a = loaded->entry("/out/a.o");
+    ASSERT_NE(nullptr, a);
+    EXPECT_EQ("hash1", a->commandHash());
+    EXPECT_EQ(std::vector<std::string>({ "/src/a.c", "/src/a.h" }), a->inputs());
+    EXPECT_EQ(1500, a->duration());
+    EXPECT_EQ(64 * 1024 * 1024, a->memory());
+
+    BuildDatabase::Entry const *b = loaded->entry("/out/b.o");
+    ASSERT_NE(nullptr, b);
+    EXPECT_EQ("hash2", b->commandHash());
+    EXPECT_TRUE(b->inputs().empty());
+
+    EXPECT_EQ(nullptr, loaded->entry("/out/c.o"));
+}
+
+TEST(BuildDatabase, LoadInvalid)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("other", std::vector<uint8_t>({ 'x', '\n' })),
+    });
+
+    EXPECT_FALSE(BuildDatabase::Load(&filesystem, "/missing"));
+    EXPECT_FALSE(BuildDatabase::Load(&filesystem, "/other"));
+}
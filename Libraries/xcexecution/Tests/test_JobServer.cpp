@@ -0,0 +1,71 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/JobServer.h>
+#include <process/MemoryContext.h>
+
+using xcexecution::JobServer;
+
+static process::MemoryContext
+Context(std::unordered_map<std::string, std::string> const &environmentVariables)
+{
+    return process::MemoryContext("/usr/bin/xcbuild", "/", { }, environmentVariables, 0, 0, "user", "group");
+}
+
+TEST(JobServer, Create)
+{
+    process::MemoryContext context = Context({ });
+    std::unique_ptr<JobServer> server = JobServer::Create(&context, 3);
+    ASSERT_NE(nullptr, server);
+    EXPECT_NE(std::string::npos, server->makeflags().find("-j3 "));
+    EXPECT_NE(std::string::npos, server->makeflags().find("--jobserver-auth="));
+
+    /* There is a token for each job past the first. */
+    EXPECT_TRUE(server->acquire());
+    EXPECT_TRUE(server->acquire());
+    EXPECT_FALSE(server->acquire());
+    EXPECT_EQ(2, server->acquired());
+
+    server->release();
+    EXPECT_TRUE(server->acquire());
+}
+
+TEST(JobServer, Shared)
+{
+    process::MemoryContext context = Context({ });
+    std::unique_ptr<JobServer> server = JobServer::Create(&context, 2);
+    ASSERT_NE(nullptr, server);
+
+    /* Tokens taken through a nested jobserver aren't free in the other. */
+    process::MemoryContext nestedContext = Context({ { "MAKEFLAGS", server->makeflags() } });
+    {
+        std::unique_ptr<JobServer> nested = JobServer::Create(&nestedContext, 8);
+        ASSERT_NE(nullptr, nested);
+        EXPECT_EQ(server->makeflags(), nested->makeflags());
+
+        EXPECT_TRUE(nested->acquire());
+        EXPECT_FALSE(nested->acquire());
+        EXPECT_FALSE(server->acquire());
+    }
+
+    /* Tokens are given back when done. */
+    EXPECT_TRUE(server->acquire());
+}
+
+TEST(JobServer, Unavailable)
+{
+    /* Descriptors that aren't open aren't used. */
+    process::MemoryContext context = Context({ { "MAKEFLAGS", "-j4 --jobserver-auth=1000,1001" } });
+    std::unique_ptr<JobServer> server = JobServer::Create(&context, 2);
+    ASSERT_NE(nullptr, server);
+    EXPECT_NE(std::string::npos, server->makeflags().find("-j2 "));
+    EXPECT_TRUE(server->acquire());
+    EXPECT_FALSE(server->acquire());
+}
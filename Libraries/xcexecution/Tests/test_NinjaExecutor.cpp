@@ -0,0 +1,126 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/NinjaExecutor.h>
+#include <xcexecution/Parameters.h>
+#include <xcexecution/TargetFingerprint.h>
+#include <libutil/MemoryFilesystem.h>
+
+#include <sys/time.h>
+#include <unistd.h>
+
+using xcexecution::NinjaExecutor;
+using xcexecution::Parameters;
+using xcexecution::TargetFingerprint;
+using libutil::MemoryFilesystem;
+
+TEST(NinjaExecutor, ParsePool)
+{
+    ext::optional<NinjaExecutor::Pool> pool = NinjaExecutor::Pool::Parse("link_pool=4:com.apple.pbx.linkers.ld,com.apple.pbx.linkers.libtool");
+    ASSERT_NE(ext::nullopt, pool);
+    EXPECT_EQ("link_pool", pool->name());
+    EXPECT_EQ(4, pool->depth());
+    EXPECT_EQ(std::vector<std::string>({ "com.apple.pbx.linkers.ld", "com.apple.pbx.linkers.libtool" }), pool->tools());
+    EXPECT_EQ("link_pool=4:com.apple.pbx.linkers.ld,com.apple.pbx.linkers.libtool", pool->argument());
+}
+
+TEST(NinjaExecutor, ParseInvalidPool)
+{
+    EXPECT_EQ(ext::nullopt, NinjaExecutor::Pool::Parse("link_pool"));
+    EXPECT_EQ(ext::nullopt, NinjaExecutor::Pool::Parse("link_pool=4"));
+    EXPECT_EQ(ext::nullopt, NinjaExecutor::Pool::Parse("link_pool=0:tool"));
+    EXPECT_EQ(ext::nullopt, NinjaExecutor::Pool::Parse("link_pool=four:tool"));
+    EXPECT_EQ(ext::nullopt, NinjaExecutor::Pool::Parse("link_pool=4:"));
+    EXPECT_EQ(ext::nullopt, NinjaExecutor::Pool::Parse("link_pool=4:tool,"));
+    EXPECT_EQ(ext::nullopt, NinjaExecutor::Pool::Parse("console=1:tool"));
+    EXPECT_EQ(ext::nullopt, NinjaExecutor::Pool::Parse("link pool=1:tool"));
+}
+
+static Parameters
+CreateParameters(std::string const &configuration)
+{
+    return Parameters(ext::nullopt, std::string("/src/App.xcodeproj"), ext::nullopt, std::vector<std::string>({ "App" }), false, false, ext::nullopt, { "build" }, configuration, { });
+}
+
+TEST(NinjaExecutor, ConfigurationHash)
+{
+    std::string hash = NinjaExecutor(nullptr, false, false, false, ext::nullopt, ext::nullopt, { }).configurationHash(CreateParameters("Debug"));
+    EXPECT_EQ(hash, NinjaExecutor(nullptr, false, false, false, ext::nullopt, ext::nullopt, { }).configurationHash(CreateParameters("Debug")));
+
+    /* Other parameters, and options that change the Ninja files, regenerate them. */
+    EXPECT_NE(hash, NinjaExecutor(nullptr, false, false, false, ext::nullopt, ext::nullopt, { }).configurationHash(CreateParameters("Release")));
+    EXPECT_NE(hash, NinjaExecutor(nullptr, false, false, true, ext::nullopt, ext::nullopt, { }).configurationHash(CreateParameters("Debug")));
+    EXPECT_NE(hash, NinjaExecutor(nullptr, false, false, false, std::string("/cache"), ext::nullopt, { }).configurationHash(CreateParameters("Debug")));
+    EXPECT_NE(hash, NinjaExecutor(nullptr, false, false, false, ext::nullopt, std::string("ccache"), { }).configurationHash(CreateParameters("Debug")));
+    EXPECT_NE(hash, NinjaExecutor(nullptr, false, false, false, ext::nullopt, ext::nullopt, { NinjaExecutor::Pool("link_pool", 2, { "com.apple.pbx.linkers.ld" }) }).configurationHash(CreateParameters("Debug")));
+
+    /* Dry runs and forced generation don't change what's generated. */
+    EXPECT_EQ(hash, NinjaExecutor(nullptr, true, true, false, ext::nullopt, ext::nullopt, { }).configurationHash(CreateParameters("Debug")));
+}
+
+TEST(NinjaExecutor, ShouldGenerate)
+{
+    auto filesystem = MemoryFilesystem({ });
+    EXPECT_TRUE(NinjaExecutor::ShouldGenerate(&filesystem, false, "hash", "/build.ninja", "/.ninja-configuration"));
+
+    /* Without the configuration, the Ninja files can't be trusted. */
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>({ 'x' }), "/build.ninja"));
+    EXPECT_TRUE(NinjaExecutor::ShouldGenerate(&filesystem, false, "hash", "/build.ninja", "/.ninja-configuration"));
+
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>({ 'h', 'a', 's', 'h' }), "/.ninja-configuration"));
+    EXPECT_FALSE(NinjaExecutor::ShouldGenerate(&filesystem, false, "hash", "/build.ninja", "/.ninja-configuration"));
+    EXPECT_TRUE(NinjaExecutor::ShouldGenerate(&filesystem, false, "other", "/build.ninja", "/.ninja-configuration"));
+
+    /* Asked to generate, as the regeneration rule does, they're always generated. */
+    EXPECT_TRUE(NinjaExecutor::ShouldGenerate(&filesystem, true, "hash", "/build.ninja", "/.ninja-configuration"));
+
+    ASSERT_TRUE(filesystem.removeFile("/build.ninja"));
+    EXPECT_TRUE(NinjaExecutor::ShouldGenerate(&filesystem, false, "hash", "/build.ninja", "/.ninja-configuration"));
+}
+
+TEST(NinjaExecutor, TargetUpToDate)
+{
+    auto filesystem = MemoryFilesystem({ });
+    EXPECT_FALSE(NinjaExecutor::TargetUpToDate(&filesystem, "/App.ninja", "/.ninja-fingerprint", "fingerprint"));
+
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>({ 'x' }), "/App.ninja"));
+    EXPECT_FALSE(NinjaExecutor::TargetUpToDate(&filesystem, "/App.ninja", "/.ninja-fingerprint", "fingerprint"));
+
+    std::string fingerprint = "fingerprint";
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>(fingerprint.begin(), fingerprint.end()), "/.ninja-fingerprint"));
+    EXPECT_TRUE(NinjaExecutor::TargetUpToDate(&filesystem, "/App.ninja", "/.ninja-fingerprint", "fingerprint"));
+
+    /* A changed target is generated again. */
+    EXPECT_FALSE(NinjaExecutor::TargetUpToDate(&filesystem, "/App.ninja", "/.ninja-fingerprint", "changed"));
+
+    /* So is a target whose Ninja file is gone. */
+    ASSERT_TRUE(filesystem.removeFile("/App.ninja"));
+    EXPECT_FALSE(NinjaExecutor::TargetUpToDate(&filesystem, "/App.ninja", "/.ninja-fingerprint", "fingerprint"));
+}
+
+TEST(NinjaExecutor, Generator)
+{
+    char path[] = "/tmp/xcexecution-generator.XXXXXX";
+    int fd = ::mkstemp(path);
+    ASSERT_GE(fd, 0);
+    ::close(fd);
+
+    struct timeval times[2] = { { 1000000000, 0 }, { 1000000000, 0 } };
+    ASSERT_EQ(0, ::utimes(path, times));
+    std::string generator = TargetFingerprint::Generator(path);
+    EXPECT_EQ(generator, TargetFingerprint::Generator(path));
+
+    /* A rebuilt executable could plan targets differently. */
+    times[1].tv_sec += 1;
+    ASSERT_EQ(0, ::utimes(path, times));
+    EXPECT_NE(generator, TargetFingerprint::Generator(path));
+
+    ::unlink(path);
+}
@@ -0,0 +1,103 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/ProjectIndex.h>
+#include <libutil/MemoryFilesystem.h>
+
+using xcexecution::ProjectIndex;
+using libutil::MemoryFilesystem;
+
+static ProjectIndex::Project
+CreateProject(std::string const &path, std::vector<std::pair<std::string, uint64_t>> const &inputs)
+{
+    ProjectIndex::Target target = ProjectIndex::Target(
+        "App",
+        "com.apple.product-type.application",
+        { "Debug", "Release" },
+        {
+            ProjectIndex::BuildFile("/src/main.m", "sourcecode.c.objc", "PBXSourcesBuildPhase"),
+            ProjectIndex::BuildFile("/src/Info.plist", "", "PBXResourcesBuildPhase"),
+        },
+        { { "PRODUCT_NAME", "App" }, { "SDKROOT", "/sdk" } });
+
+    return ProjectIndex::Project(path, "App", { "Debug", "Release" }, "Release", { "/src/Library.xcodeproj" }, { target }, inputs);
+}
+
+TEST(ProjectIndex, RoundTrip)
+{
+    auto filesystem = MemoryFilesystem({ });
+
+    std::vector<uint8_t> contents = ProjectIndex::Serialize({
+        CreateProject("/src/b.xcodeproj", { { "/src/b.xcodeproj/project.pbxproj", 7 } }),
+        CreateProject("/src/a.xcodeproj", { }),
+    });
+    ASSERT_TRUE(filesystem.write(contents, "/index"));
+
+    std::unique_ptr<ProjectIndex> index = ProjectIndex::Open(&filesystem, "/index");
+    ASSERT_NE(nullptr, index);
+    EXPECT_EQ(std::vector<std::string>({ "/src/a.xcodeproj", "/src/b.xcodeproj" }), index->projectPaths());
+    EXPECT_FALSE(index->project("/src/c.xcodeproj"));
+
+    ext::optional<ProjectIndex::Project> project = index->project("/src/b.xcodeproj");
+    ASSERT_TRUE(project);
+    EXPECT_EQ("/src/b.xcodeproj", project->path());
+    EXPECT_EQ("App", project->name());
+    EXPECT_EQ(std::vector<std::string>({ "Debug", "Release" }), project->configurations());
+    EXPECT_EQ("Release", project->defaultConfiguration());
+    EXPECT_EQ(std::vector<std::string>({ "/src/Library.xcodeproj" }), project->projectReferences());
+    EXPECT_EQ((std::vector<std::pair<std::string, uint64_t>>({ { "/src/b.xcodeproj/project.pbxproj", 7 } })), project->inputs());
+
+    ASSERT_EQ(1, project->targets().size());
+    ProjectIndex::Target const &target = project->targets().front();
+    EXPECT_EQ("App", target.name());
+    EXPECT_EQ("com.apple.product-type.application", target.productType());
+    EXPECT_EQ(std::vector<std::string>({ "Debug", "Release" }), target.configurations());
+    ASSERT_EQ(2, target.buildFiles().size());
+    EXPECT_EQ("/src/main.m", target.buildFiles()[0].path());
+    EXPECT_EQ("sourcecode.c.objc", target.buildFiles()[0].fileType());
+    EXPECT_EQ("PBXSourcesBuildPhase", target.buildFiles()[0].phase());
+    EXPECT_EQ("", target.buildFiles()[1].fileType());
+    EXPECT_EQ((std::vector<std::pair<std::string, std::string>>({ { "PRODUCT_NAME", "App" }, { "SDKROOT", "/sdk" } })), target.settings());
+}
+
+TEST(ProjectIndex, UpToDate)
+{
+    auto filesystem = MemoryFilesystem({ });
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>({ 'a' }), "/project.pbxproj"));
+
+    uint64_t time = *filesystem.modificationTime("/project.pbxproj");
+    EXPECT_TRUE(CreateProject("/a.xcodeproj", { { "/project.pbxproj", time } }).upToDate(&filesystem));
+
+    /* A missing input is recorded as zero. */
+    ProjectIndex::Project missing = CreateProject("/a.xcodeproj", { { "/project.pbxproj", time }, { "/missing.xcconfig", 0 } });
+    EXPECT_TRUE(missing.upToDate(&filesystem));
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>({ 'b' }), "/missing.xcconfig"));
+    EXPECT_FALSE(missing.upToDate(&filesystem));
+
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>({ 'b' }), "/project.pbxproj"));
+    EXPECT_FALSE(CreateProject("/a.xcodeproj", { { "/project.pbxproj", time } }).upToDate(&filesystem));
+}
+
+TEST(ProjectIndex, OpenInvalid)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("other", std::vector<uint8_t>({ 'x', '\n' })),
+    });
+
+    EXPECT_EQ(nullptr, ProjectIndex::Open(&filesystem, "/missing"));
+    EXPECT_EQ(nullptr, ProjectIndex::Open(&filesystem, "/other"));
+
+    /* An entry pointing past the end is rejected when opening. */
+    std::vector<uint8_t> contents = ProjectIndex::Serialize({ CreateProject("/a.xcodeproj", { }) });
+    contents.resize(contents.size() - 1);
+    EXPECT_EQ(nullptr, ProjectIndex::Create(contents));
+
+    EXPECT_NE(nullptr, ProjectIndex::Create(ProjectIndex::Serialize({ })));
+}
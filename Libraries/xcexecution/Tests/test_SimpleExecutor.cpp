@@ -9,15 +9,20 @@
 
 #include <gtest/gtest.h>
 #include <xcexecution/SimpleExecutor.h>
+#include <xcexecution/BuildDatabase.h>
 #include <xcformatter/NullFormatter.h>
 #include <pbxbuild/Tool/Invocation.h>
 #include <builtin/Driver.h>
 #include <builtin/Registry.h>
+#include <process/Cancellation.h>
 #include <process/MemoryContext.h>
 #include <process/MemoryLauncher.h>
 #include <libutil/MemoryFilesystem.h>
 
+#include <atomic>
+
 using xcexecution::SimpleExecutor;
+using xcexecution::BuildDatabase;
 using libutil::Filesystem;
 using libutil::MemoryFilesystem;
 
@@ -95,7 +100,7 @@ TEST(SimpleExecutor, PropagateToolResult)
     /* Create test executor. */
     auto formatter = xcformatter::NullFormatter::Create();
     std::vector<std::string> const executablePaths = { "/" };
-    SimpleExecutor executor = SimpleExecutor(formatter, false, registry);
+    SimpleExecutor executor = SimpleExecutor(formatter, false, registry, 1, false, false, ext::nullopt, ext::nullopt);
 
     /* Succeed if all tools succeed. */
     auto success = executor.performInvocations(
@@ -107,7 +112,8 @@ TEST(SimpleExecutor, PropagateToolResult)
             builtinSuccess,
             externalSuccess,
         },
-        false);
+        false,
+        nullptr);
     ASSERT_TRUE(success.first);
     EXPECT_EQ(success.second.size(), 0);
 
@@ -122,7 +128,8 @@ TEST(SimpleExecutor, PropagateToolResult)
             builtinSuccess,
             externalSuccess,
         },
-        false);
+        false,
+        nullptr);
     ASSERT_FALSE(fail1.first);
     EXPECT_EQ(fail1.second.size(), 1);
 
@@ -138,8 +145,476 @@ TEST(SimpleExecutor, PropagateToolResult)
             externalSuccess,
             externalFail,
         },
-        false);
+        false,
+        nullptr);
     ASSERT_FALSE(fail2.first);
     EXPECT_EQ(fail2.second.size(), 1);
 }
 
+
+TEST(SimpleExecutor, ParallelRespectsDependencies)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+    });
+
+    std::atomic<int> ran(0);
+    std::atomic<bool> ordered(true);
+    auto launcher = process::MemoryLauncher({
+        { "/tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            int dependencies = std::stoi(context->commandLineArguments().front());
+            if (ran.load() < dependencies) {
+                ordered = false;
+            }
+
+            ran++;
+            return 0;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    /* Two independent invocations, then one that depends on both. */
+    auto first = pbxbuild::Tool::Invocation();
+    first.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    first.arguments() = { "0" };
+    first.outputs() = { "/first" };
+    auto second = pbxbuild::Tool::Invocation();
+    second.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    second.arguments() = { "0" };
+    second.outputs() = { "/second" };
+    auto last = pbxbuild::Tool::Invocation();
+    last.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    last.arguments() = { "2" };
+    last.inputs() = { "/first", "/second" };
+
+    /* Create test executor. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), 4, false, false, ext::nullopt, ext::nullopt);
+
+    auto result = executor.performInvocations(
+        &context,
+        &launcher,
+        &filesystem,
+        executablePaths,
+        {
+            first,
+            second,
+            last,
+        },
+        false,
+        nullptr);
+    ASSERT_TRUE(result.first);
+    EXPECT_EQ(3, ran.load());
+    EXPECT_TRUE(ordered.load());
+}
+
+TEST(SimpleExecutor, IncrementalSkipsUpToDate)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("input", std::vector<uint8_t>()),
+    });
+
+    int ran = 0;
+    auto launcher = process::MemoryLauncher({
+        { "/tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            ran++;
+            return filesystem->write(std::vector<uint8_t>(), "/output") ? 0 : 1;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    invocation.inputs() = { "/input" };
+    invocation.outputs() = { "/output" };
+
+    /* Create test executor. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), 1, false, true, ext::nullopt, ext::nullopt);
+
+    /* Runs when the output is missing. */
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, nullptr).first);
+    EXPECT_EQ(1, ran);
+
+    /* Skipped when the output is newer than the input. */
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, nullptr).first);
+    EXPECT_EQ(1, ran);
+
+    /* Runs again once the input changes. */
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>(), "/input"));
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, nullptr).first);
+    EXPECT_EQ(2, ran);
+}
+
+TEST(SimpleExecutor, IncrementalCommandChanged)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("input", std::vector<uint8_t>()),
+    });
+
+    int ran = 0;
+    auto launcher = process::MemoryLauncher({
+        { "/tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            ran++;
+            return filesystem->write(std::vector<uint8_t>(), "/output") ? 0 : 1;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    invocation.arguments() = { "-O0" };
+    invocation.inputs() = { "/input" };
+    invocation.outputs() = { "/output" };
+
+    /* Create test executor. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), 1, false, true, ext::nullopt, ext::nullopt);
+    BuildDatabase database;
+
+    /* Skipped after building once with the same command. */
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, &database).first);
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, &database).first);
+    EXPECT_EQ(1, ran);
+
+    /* Runs again when the command changes, even though the output is newer. */
+    invocation.arguments() = { "-O2" };
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, &database).first);
+    EXPECT_EQ(2, ran);
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, &database).first);
+    EXPECT_EQ(2, ran);
+}
+
+TEST(SimpleExecutor, CancelKeepsFinished)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("input", std::vector<uint8_t>()),
+    });
+
+    process::Cancellation cancellation;
+    std::vector<std::string> ran;
+    auto launcher = process::MemoryLauncher({
+        { "/tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            std::string const &output = context->commandLineArguments().front();
+            ran.push_back(output);
+            if (output == "/first") {
+                cancellation.cancel();
+            }
+            return filesystem->write(std::vector<uint8_t>(), output) ? 0 : 1;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    auto first = pbxbuild::Tool::Invocation();
+    first.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    first.arguments() = { "/first" };
+    first.inputs() = { "/input" };
+    first.outputs() = { "/first" };
+
+    auto second = pbxbuild::Tool::Invocation();
+    second.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    second.arguments() = { "/second" };
+    second.inputs() = { "/first" };
+    second.outputs() = { "/second" };
+
+    /* Create test executor. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), 1, false, true, ext::nullopt, ext::nullopt);
+    BuildDatabase database;
+
+    /* Cancelling stops the build, but isn't a failing invocation. */
+    auto cancelled = executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { first, second }, false, &database, &cancellation);
+    EXPECT_FALSE(cancelled.first);
+    EXPECT_TRUE(cancelled.second.empty());
+    EXPECT_EQ(std::vector<std::string>({ "/first" }), ran);
+
+    /* Building again continues from where it stopped. */
+    ran.clear();
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { first, second }, false, &database).first);
+    EXPECT_EQ(std::vector<std::string>({ "/second" }), ran);
+}
+
+TEST(SimpleExecutor, IncrementalAlwaysOutOfDate)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("script", std::vector<uint8_t>()),
+    });
+
+    int ran = 0;
+    auto launcher = process::MemoryLauncher({
+        { "/tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            ran++;
+            return filesystem->write(std::vector<uint8_t>(), "/output") ? 0 : 1;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    invocation.inputs() = { "/script" };
+    invocation.phonyInputs() = { "/declared" };
+    invocation.outputs() = { "/output" };
+
+    /* Create test executor. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), 1, false, true, ext::nullopt, ext::nullopt);
+
+    /* Runs while a declared input is missing. */
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, nullptr).first);
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, nullptr).first);
+    EXPECT_EQ(2, ran);
+
+    /* Skipped once it exists and is older than the output. */
+    ASSERT_TRUE(filesystem.write(std::vector<uint8_t>(), "/declared"));
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, nullptr).first);
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, nullptr).first);
+    EXPECT_EQ(3, ran);
+
+    /* Always runs when marked to. */
+    invocation.alwaysOutOfDate() = true;
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, nullptr).first);
+    EXPECT_EQ(4, ran);
+}
+
+TEST(SimpleExecutor, ToolLauncher)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("launcher", std::vector<uint8_t>()),
+    });
+
+    std::vector<std::string> launched;
+    auto launcher = process::MemoryLauncher({
+        { "/tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            return 1;
+        } },
+        { "/launcher", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            launched = context->commandLineArguments();
+            return 0;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+    invocation.arguments() = { "-c", "file.c" };
+
+    /* Create test executor. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), 1, false, false, ext::nullopt, std::string("/launcher"));
+
+    /* The launcher runs instead, with the tool as its first argument. */
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, nullptr).first);
+    EXPECT_EQ(std::vector<std::string>({ "/tool", "-c", "file.c" }), launched);
+}
+
+TEST(SimpleExecutor, CriticalPathFirst)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("tool", std::vector<uint8_t>()),
+    });
+
+    std::vector<std::string> started;
+    auto launcher = process::MemoryLauncher({
+        { "/tool", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            started.push_back(context->commandLineArguments().front());
+            return 0;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    /* Two independent invocations, then a chain that's longer. */
+    std::vector<pbxbuild::Tool::Invocation> invocations;
+    for (char const *name : { "short1", "short2", "chain1", "chain2" }) {
+        auto invocation = pbxbuild::Tool::Invocation();
+        invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("tool");
+        invocation.arguments() = { name };
+        invocation.outputs() = { std::string("/") + name };
+        invocations.push_back(invocation);
+    }
+    invocations[3].inputs() = { "/chain1" };
+
+    /* Create test executor. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), 2, false, false, ext::nullopt, ext::nullopt);
+
+    /* The start of the chain runs first, even though it's later. */
+    ASSERT_TRUE(executor.performInvocations(&context, &launcher, &filesystem, executablePaths, invocations, false, nullptr).first);
+    ASSERT_EQ(4, started.size());
+    EXPECT_EQ("chain1", started[0]);
+    EXPECT_EQ("short1", started[1]);
+}
+
+TEST(SimpleExecutor, DebugSymbolsUseIdleSlots)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("dsymutil", std::vector<uint8_t>()),
+    });
+
+    std::vector<std::string> launched;
+    auto launcher = process::MemoryLauncher({
+        { "/dsymutil", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            launched = context->commandLineArguments();
+            return 0;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.toolIdentifier() = "com.apple.tools.dsymutil";
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("dsymutil");
+    invocation.arguments() = { "binary", "-o", "binary.dSYM" };
+    invocation.stage() = pbxbuild::Tool::Invocation::Stage::Debug;
+
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { "/" };
+
+    /* Alone, it gets a thread for every job. */
+    SimpleExecutor parallel = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), 4, false, false, ext::nullopt, ext::nullopt);
+    ASSERT_TRUE(parallel.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, nullptr).first);
+    EXPECT_EQ(std::vector<std::string>({ "binary", "-o", "binary.dSYM", "--num-threads=4" }), launched);
+
+    /* With one job, it gets one thread rather than every core. */
+    SimpleExecutor serial = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), 1, false, false, ext::nullopt, ext::nullopt);
+    ASSERT_TRUE(serial.performInvocations(&context, &launcher, &filesystem, executablePaths, { invocation }, false, nullptr).first);
+    EXPECT_EQ(std::vector<std::string>({ "binary", "-o", "binary.dSYM", "--num-threads=1" }), launched);
+}
+
+TEST(SimpleExecutor, ParseShard)
+{
+    ext::optional<SimpleExecutor::Shard> shard = SimpleExecutor::Shard::Parse("2/3");
+    ASSERT_NE(ext::nullopt, shard);
+    EXPECT_EQ(2u, shard->index());
+    EXPECT_EQ(3u, shard->count());
+    EXPECT_EQ("2/3", shard->argument());
+
+    EXPECT_EQ(ext::nullopt, SimpleExecutor::Shard::Parse("2"));
+    EXPECT_EQ(ext::nullopt, SimpleExecutor::Shard::Parse("0/3"));
+    EXPECT_EQ(ext::nullopt, SimpleExecutor::Shard::Parse("4/3"));
+    EXPECT_EQ(ext::nullopt, SimpleExecutor::Shard::Parse("1/"));
+    EXPECT_EQ(ext::nullopt, SimpleExecutor::Shard::Parse("-1/3"));
+    EXPECT_EQ(ext::nullopt, SimpleExecutor::Shard::Parse("one/3"));
+}
+
+TEST(SimpleExecutor, ShardSelect)
+{
+    std::vector<uint64_t> costs = { 10, 1, 7, 3, 3, 1 };
+
+    /* Every item is in exactly one shard. */
+    std::vector<uint64_t> totals;
+    std::vector<size_t> owners = std::vector<size_t>(costs.size(), 0);
+    for (size_t index = 1; index <= 3; ++index) {
+        std::vector<bool> selected = SimpleExecutor::Shard(index, 3).select(costs);
+        ASSERT_EQ(costs.size(), selected.size());
+
+        uint64_t total = 0;
+        for (size_t i = 0; i < costs.size(); ++i) {
+            if (selected[i]) {
+                owners[i]++;
+                total += costs[i];
+            }
+        }
+        totals.push_back(total);
+    }
+    EXPECT_EQ(std::vector<size_t>(costs.size(), 1), owners);
+
+    /* Costs are balanced: the largest item alone, the rest split evenly. */
+    EXPECT_EQ(std::vector<uint64_t>({ 10, 8, 7 }), totals);
+
+    /* The same costs always divide the same way. */
+    EXPECT_EQ(SimpleExecutor::Shard(2, 3).select(costs), SimpleExecutor::Shard(2, 3).select(costs));
+
+    /* One shard has everything. */
+    EXPECT_EQ(std::vector<bool>(costs.size(), true), SimpleExecutor::Shard(1, 1).select(costs));
+}
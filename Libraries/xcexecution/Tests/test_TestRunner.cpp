@@ -0,0 +1,112 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/TestRunner.h>
+#include <process/MemoryContext.h>
+#include <process/MemoryLauncher.h>
+#include <libutil/MemoryFilesystem.h>
+
+using xcexecution::TestRunner;
+using libutil::Filesystem;
+using libutil::MemoryFilesystem;
+
+TEST(TestRunner, History)
+{
+    TestRunner::History history;
+    history.record("B/Class", 20);
+    history.record("A", 1500);
+
+    /* Sorted by name, so the file is stable. */
+    EXPECT_EQ("1500 A\n20 B/Class\n", history.serialize());
+
+    TestRunner::History read = TestRunner::History::Deserialize("1500 A\n20 B/Class\nbad line\n7\n");
+    EXPECT_EQ(1500, *read.duration("A"));
+    EXPECT_EQ(20, *read.duration("B/Class"));
+    EXPECT_EQ(ext::nullopt, read.duration("line"));
+    EXPECT_EQ(history.serialize(), read.serialize());
+}
+
+TEST(TestRunner, Estimate)
+{
+    TestRunner::History history;
+    history.record("Fast", 10);
+    history.record("Slow", 300);
+
+    std::vector<TestRunner::Job> jobs = {
+        TestRunner::Job("Fast", { }),
+        TestRunner::Job("New", { }),
+        TestRunner::Job("Slow", { }),
+    };
+
+    /* New jobs are assumed as slow as the slowest. */
+    EXPECT_EQ(std::vector<uint64_t>({ 10, 300, 300 }), TestRunner::Estimate(jobs, history));
+
+    /* With no history, all are equal. */
+    EXPECT_EQ(std::vector<uint64_t>({ 1, 1, 1 }), TestRunner::Estimate(jobs, TestRunner::History()));
+}
+
+TEST(TestRunner, Run)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("xctest", std::vector<uint8_t>()),
+    });
+
+    std::vector<std::string> started;
+    auto launcher = process::MemoryLauncher({
+        { "/xctest", [&](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            started.push_back(context->commandLineArguments().back());
+            return (context->commandLineArguments().back() == "Failing" ? 1 : 0);
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        "/",
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>(),
+        0,
+        0,
+        "user",
+        "group");
+
+    std::vector<TestRunner::Job> jobs = {
+        TestRunner::Job("Passing", { "Passing" }),
+        TestRunner::Job("Failing", { "Failing" }),
+        TestRunner::Job("Slow", { "Slow" }),
+    };
+
+    TestRunner::History history;
+    history.record("Passing", 5);
+    history.record("Failing", 10);
+    history.record("Slow", 100);
+
+    size_t finished = 0;
+    std::vector<TestRunner::Result> results = TestRunner::Run(&launcher, &filesystem, &context, "/xctest", jobs, 2, &history, [&](TestRunner::Result const &result) {
+        finished++;
+    });
+
+    /* Longest first, but results are in job order. */
+    EXPECT_EQ(std::vector<std::string>({ "Slow", "Failing", "Passing" }), started);
+    ASSERT_EQ(3, results.size());
+    EXPECT_EQ(3, finished);
+    EXPECT_EQ("Passing", results[0].name());
+    EXPECT_TRUE(results[0].success());
+    EXPECT_FALSE(results[1].success());
+    EXPECT_TRUE(results[2].success());
+
+    /* Durations are recorded for the next run. */
+    EXPECT_EQ(results[2].duration(), *history.duration("Slow"));
+
+    /* A missing tool fails every job. */
+    results = TestRunner::Run(&launcher, &filesystem, &context, "/missing", jobs, 2, &history, nullptr);
+    for (TestRunner::Result const &result : results) {
+        EXPECT_FALSE(result.success());
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcexecution/Trace.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/JSON.h>
+#include <libutil/MemoryFilesystem.h>
+
+using xcexecution::Trace;
+using libutil::MemoryFilesystem;
+
+TEST(Trace, Write)
+{
+    auto filesystem = MemoryFilesystem({ });
+
+    Trace trace;
+    {
+        Trace::Span span(&trace, "Load workspace", "workspace");
+    }
+    trace.invocation("CompileC a.o", 1, 10, 25, { { "pid", "123" }, { "exit status", "0" } });
+    ASSERT_TRUE(trace.write(&filesystem, "/out/trace.json"));
+
+    std::vector<uint8_t> contents;
+    ASSERT_TRUE(filesystem.read(&contents, "/out/trace.json"));
+    auto deserialized = plist::Format::JSON::Deserialize(contents, plist::Format::JSON::Create());
+    plist::Dictionary const *root = plist::CastTo<plist::Dictionary>(deserialized.first.get());
+    ASSERT_NE(nullptr, root);
+
+    plist::Array const *events = root->value<plist::Array>("traceEvents");
+    ASSERT_NE(nullptr, events);
+
+    plist::Dictionary const *step = nullptr;
+    plist::Dictionary const *invocation = nullptr;
+    for (size_t i = 0; i < events->count(); ++i) {
+        plist::Dictionary const *event = events->value<plist::Dictionary>(i);
+        ASSERT_NE(nullptr, event);
+
+        plist::String const *name = event->value<plist::String>("name");
+        if (name->value() == "Load workspace") {
+            step = event;
+        } else if (name->value() == "CompileC a.o") {
+            invocation = event;
+        }
+    }
+
+    ASSERT_NE(nullptr, step);
+    EXPECT_EQ("X", step->value<plist::String>("ph")->value());
+    EXPECT_EQ("workspace", step->value<plist::String>("cat")->value());
+    EXPECT_EQ(1, step->value<plist::Integer>("pid")->value());
+
+    ASSERT_NE(nullptr, invocation);
+    EXPECT_EQ(10, invocation->value<plist::Integer>("ts")->value());
+    EXPECT_EQ(15, invocation->value<plist::Integer>("dur")->value());
+    EXPECT_EQ(2, invocation->value<plist::Integer>("pid")->value());
+    EXPECT_EQ(1, invocation->value<plist::Integer>("tid")->value());
+    EXPECT_EQ("123", invocation->value<plist::Dictionary>("args")->value<plist::String>("pid")->value());
+}
+
+TEST(Trace, NoTrace)
+{
+    /* Spans without a trace do nothing. */
+    Trace::Span span(nullptr, "Load workspace", "workspace");
+}
@@ -0,0 +1,287 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcexecution/ActionCache.h>
+#include <pbxbuild/Tool/Invocation.h>
+#include <dependency/DependencyInfo.h>
+#include <dependency/DependencyInfoConverter.h>
+#include <libutil/Options.h>
+#include <libutil/DefaultFilesystem.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <process/DefaultContext.h>
+#include <process/DefaultLauncher.h>
+#include <process/MemoryContext.h>
+
+using xcexecution::ActionCache;
+using libutil::DefaultFilesystem;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+class Options {
+private:
+    ext::optional<bool>        _help;
+    ext::optional<bool>        _version;
+
+private:
+    ext::optional<std::string> _cache;
+    ext::optional<std::string> _commandKey;
+    std::vector<std::string>   _inputs;
+    std::vector<std::string>   _outputs;
+    std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> _dependencyInfo;
+    std::vector<std::string>   _command;
+
+public:
+    Options();
+    ~Options();
+
+public:
+    bool help() const
+    { return _help.value_or(false); }
+    bool version() const
+    { return _version.value_or(false); }
+
+public:
+    ext::optional<std::string> const &cache() const
+    { return _cache; }
+    ext::optional<std::string> const &commandKey() const
+    { return _commandKey; }
+    std::vector<std::string> const &inputs() const
+    { return _inputs; }
+    std::vector<std::string> const &outputs() const
+    { return _outputs; }
+    std::vector<std::pair<dependency::DependencyInfoFormat, std::string>> const &dependencyInfo() const
+    { return _dependencyInfo; }
+    std::vector<std::string> const &command() const
+    { return _command; }
+
+private:
+    friend class libutil::Options;
+    std::pair<bool, std::string>
+    parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it);
+};
+
+Options::
+Options()
+{
+}
+
+Options::
+~Options()
+{
+}
+
+std::pair<bool, std::string> Options::
+parseArgument(std::vector<std::string> const &args, std::vector<std::string>::const_iterator *it)
+{
+    std::string const &arg = **it;
+
+    if (arg == "-h" || arg == "--help") {
+        return libutil::Options::Current<bool>(&_help, arg);
+    } else if (arg == "-v" || arg == "--version") {
+        return libutil::Options::Current<bool>(&_version, arg);
+    } else if (arg == "--cache") {
+        return libutil::Options::Next<std::string>(&_cache, args, it);
+    } else if (arg == "--command-key") {
+        return libutil::Options::Next<std::string>(&_commandKey, args, it);
+    } else if (arg == "--input") {
+        return libutil::Options::AppendNext<std::string>(&_inputs, args, it);
+    } else if (arg == "--output") {
+        return libutil::Options::AppendNext<std::string>(&_outputs, args, it);
+    } else if (arg == "--dependency-info") {
+        ext::optional<std::string> value;
+        std::pair<bool, std::string> result = libutil::Options::Next<std::string>(&value, args, it);
+        if (!result.first) {
+            return result;
+        }
+
+        std::string::size_type offset = value->find(':');
+        if (offset == std::string::npos || offset == 0 || offset == value->size() - 1) {
+            return std::make_pair(false, "unknown dependency info " + *value + " (use format:/path/to/input)");
+        }
+
+        dependency::DependencyInfoFormat format;
+        if (!dependency::DependencyInfoFormats::Parse(value->substr(0, offset), &format)) {
+            return std::make_pair(false, "unknown format " + value->substr(0, offset));
+        }
+
+        _dependencyInfo.push_back({ format, value->substr(offset + 1) });
+        return std::make_pair(true, std::string());
+    } else if (arg == "--") {
+        /* Everything else is the command. */
+        _command = std::vector<std::string>(*it + 1, args.end());
+        *it = args.end() - 1;
+        return std::make_pair(true, std::string());
+    } else {
+        return std::make_pair(false, "unknown argument " + arg);
+    }
+}
+
+static int
+Help(std::string const &error = std::string())
+{
+    if (!error.empty()) {
+        fprintf(stderr, "error: %s\n", error.c_str());
+        fprintf(stderr, "\n");
+    }
+
+    fprintf(stderr, "Usage: action-cache-tool [options] -- command [arguments...]\n\n");
+    fprintf(stderr, "Restores the outputs of a command from a cache, or runs it and caches them.\n\n");
+
+#define INDENT "  "
+    fprintf(stderr, "Information:\n");
+    fprintf(stderr, INDENT "-h, --help\n");
+    fprintf(stderr, INDENT "-v, --version\n");
+    fprintf(stderr, "\n");
+
+    fprintf(stderr, "Cache Options:\n");
+    fprintf(stderr, INDENT "--cache <directory>\n");
+    fprintf(stderr, INDENT "--command-key <key>\n");
+    fprintf(stderr, INDENT "--input <path>\n");
+    fprintf(stderr, INDENT "--output <path>\n");
+    fprintf(stderr, INDENT "--dependency-info <format>:<path>\n");
+    fprintf(stderr, "\n");
+#undef INDENT
+
+    return (error.empty() ? 0 : -1);
+}
+
+static int
+Version()
+{
+    printf("action-cache-tool version 1\n");
+    return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    DefaultFilesystem filesystem = DefaultFilesystem();
+    process::DefaultContext processContext = process::DefaultContext();
+
+    /*
+     * Parse out the options, or print help & exit.
+     */
+    Options options;
+    std::pair<bool, std::string> result = libutil::Options::Parse<Options>(&options, processContext.commandLineArguments());
+    if (!result.first) {
+        return Help(result.second);
+    }
+
+    /*
+     * Handle the basic options.
+     */
+    if (options.help()) {
+        return Help();
+    } else if (options.version()) {
+        return Version();
+    }
+
+    /*
+     * Diagnose missing options.
+     */
+    if (!options.cache() || options.command().empty()) {
+        return Help("missing option(s)");
+    }
+
+    /*
+     * Find the command to run.
+     */
+    std::string executable = options.command().front();
+    if (!FSUtil::IsAbsolutePath(executable)) {
+        ext::optional<std::string> path = filesystem.findExecutable(executable, processContext.executableSearchPaths());
+        if (!path) {
+            fprintf(stderr, "error: unable to find executable %s\n", executable.c_str());
+            return 1;
+        }
+        executable = *path;
+    }
+
+    process::MemoryContext context = process::MemoryContext(&processContext);
+    context.executablePath() = executable;
+    context.commandLineArguments() = std::vector<std::string>(options.command().begin() + 1, options.command().end());
+
+    /*
+     * The key covers the same parts of the command as for the simple executor.
+     */
+    pbxbuild::Tool::Invocation invocation;
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External(executable);
+    invocation.arguments() = context.commandLineArguments();
+    invocation.sharedEnvironment() = std::make_shared<std::unordered_map<std::string, std::string> const>(context.environmentVariables());
+    invocation.workingDirectory() = context.currentDirectory();
+
+    std::vector<std::string> outputs;
+    for (std::string const &output : options.outputs()) {
+        outputs.push_back(FSUtil::ResolveRelativePath(output, context.currentDirectory()));
+    }
+    for (std::pair<dependency::DependencyInfoFormat, std::string> const &dependencyInfo : options.dependencyInfo()) {
+        outputs.push_back(FSUtil::ResolveRelativePath(dependencyInfo.second, context.currentDirectory()));
+    }
+
+    std::vector<std::string> inputs;
+    for (std::string const &input : options.inputs()) {
+        inputs.push_back(FSUtil::ResolveRelativePath(input, context.currentDirectory()));
+    }
+
+    /*
+     * A command key stands in for the command, and lets outputs stored by
+     * other commands with the same key be restored to these output paths.
+     */
+    ActionCache cache = ActionCache(*options.cache());
+    ext::optional<std::string> key;
+    if (!outputs.empty() && !inputs.empty()) {
+        key = ActionCache::Key(&filesystem, options.commandKey() ? *options.commandKey() : invocation.commandFingerprint(), inputs);
+    }
+
+    if (key && cache.restore(&filesystem, *key, outputs, static_cast<bool>(options.commandKey()))) {
+        return 0;
+    }
+
+    /*
+     * Not cached, so run the command.
+     */
+    process::DefaultLauncher launcher = process::DefaultLauncher();
+    ext::optional<int> exitCode = launcher.launch(&filesystem, &context);
+    if (!exitCode) {
+        fprintf(stderr, "error: unable to run %s\n", executable.c_str());
+        return 1;
+    } else if (*exitCode != 0) {
+        return *exitCode;
+    }
+
+    if (key) {
+        /*
+         * Find the inputs the command used but didn't declare. If they can't
+         * be found, the command can't be cached safely.
+         */
+        std::vector<std::string> discoveredInputs;
+        bool discovered = true;
+        for (std::pair<dependency::DependencyInfoFormat, std::string> const &dependencyInfo : options.dependencyInfo()) {
+            std::string path = FSUtil::ResolveRelativePath(dependencyInfo.second, context.currentDirectory());
+            ext::optional<std::vector<dependency::DependencyInfo>> info = dependency::DependencyInfoConverter::Load(&filesystem, dependencyInfo.first, path);
+            if (!info) {
+                discovered = false;
+                break;
+            }
+
+            for (dependency::DependencyInfo const &entry : *info) {
+                for (std::string const &input : entry.inputs()) {
+                    discoveredInputs.push_back(FSUtil::ResolveRelativePath(input, context.currentDirectory()));
+                }
+            }
+        }
+
+        /* Not being able to cache only makes later builds slower. */
+        if (discovered) {
+            cache.store(&filesystem, *key, outputs, discoveredInputs);
+        }
+    }
+
+    return 0;
+}
@@ -29,6 +29,7 @@ public:
     virtual std::string begin(pbxbuild::Build::Context const &buildContext);
     virtual std::string success(pbxbuild::Build::Context const &buildContext);
     virtual std::string failure(pbxbuild::Build::Context const &buildContext, std::vector<pbxbuild::Tool::Invocation> const &failingInvocations);
+    virtual std::string cancelled(pbxbuild::Build::Context const &buildContext);
 
 public:
     virtual std::string beginTarget(pbxbuild::Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target);
@@ -53,6 +54,10 @@ public:
     virtual std::string beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple);
     virtual std::string finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple);
 
+public:
+    virtual std::string resultInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &output, bool success, uint64_t duration);
+    virtual std::string skipInvocation(pbxbuild::Tool::Invocation const &invocation, bool cached);
+
 public:
     /*
      * Creates a default formatter. If color is true, terminal escapes
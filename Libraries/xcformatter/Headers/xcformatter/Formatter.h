@@ -33,6 +33,7 @@ public:
     virtual std::string begin(pbxbuild::Build::Context const &buildContext) = 0;
     virtual std::string success(pbxbuild::Build::Context const &buildContext) = 0;
     virtual std::string failure(pbxbuild::Build::Context const &buildContext, std::vector<pbxbuild::Tool::Invocation> const &failingInvocations) = 0;
+    virtual std::string cancelled(pbxbuild::Build::Context const &buildContext) = 0;
 
 public:
     virtual std::string beginTarget(pbxbuild::Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target) = 0;
@@ -57,10 +58,24 @@ public:
     virtual std::string beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple) = 0;
     virtual std::string finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple) = 0;
 
+public:
+    /*
+     * An invocation that ran, with the output it wrote, if it succeeded, and
+     * how long it took in milliseconds. Comes before `finishInvocation`.
+     */
+    virtual std::string resultInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &output, bool success, uint64_t duration) = 0;
+
+    /*
+     * An invocation that didn't need to run: it was up to date, or its
+     * outputs were restored from the action cache.
+     */
+    virtual std::string skipInvocation(pbxbuild::Tool::Invocation const &invocation, bool cached) = 0;
+
 public:
     /*
      * Utility function to print a formatted string to standard output. This
-     * is less for use by formatters than by the clients of formatters.
+     * is less for use by formatters than by the clients of formatters. The
+     * output is batched; see `Output::Standard()`.
      */
     static void Print(std::string const &output);
 };
@@ -0,0 +1,71 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcformatter_JSONFormatter_h
+#define __xcformatter_JSONFormatter_h
+
+#include <xcformatter/Formatter.h>
+
+#include <chrono>
+
+namespace xcformatter {
+
+/*
+ * Formats output as a stream of JSON objects, one event per line. Every
+ * event has an "event" name and a "time" in milliseconds since the build
+ * began. Invocations are identified by a hash of their command.
+ */
+class JSONFormatter : public Formatter {
+private:
+    std::chrono::steady_clock::time_point _start;
+
+public:
+    JSONFormatter();
+    ~JSONFormatter();
+
+public:
+    virtual std::string begin(pbxbuild::Build::Context const &buildContext);
+    virtual std::string success(pbxbuild::Build::Context const &buildContext);
+    virtual std::string failure(pbxbuild::Build::Context const &buildContext, std::vector<pbxbuild::Tool::Invocation> const &failingInvocations);
+    virtual std::string cancelled(pbxbuild::Build::Context const &buildContext);
+
+public:
+    virtual std::string beginTarget(pbxbuild::Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target);
+    virtual std::string finishTarget(pbxbuild::Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target);
+
+public:
+    virtual std::string beginCheckDependencies(pbxproj::PBX::Target::shared_ptr const &target);
+    virtual std::string finishCheckDependencies(pbxproj::PBX::Target::shared_ptr const &target);
+
+public:
+    virtual std::string beginWriteAuxiliaryFiles(pbxproj::PBX::Target::shared_ptr const &target);
+    virtual std::string createAuxiliaryDirectory(std::string const &directory);
+    virtual std::string writeAuxiliaryFile(std::string const &file);
+    virtual std::string setAuxiliaryExecutable(std::string const &file);
+    virtual std::string finishWriteAuxiliaryFiles(pbxproj::PBX::Target::shared_ptr const &target);
+
+public:
+    virtual std::string beginCreateProductStructure(pbxproj::PBX::Target::shared_ptr const &target);
+    virtual std::string finishCreateProductStructure(pbxproj::PBX::Target::shared_ptr const &target);
+
+public:
+    virtual std::string beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple);
+    virtual std::string finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple);
+
+public:
+    virtual std::string resultInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &output, bool success, uint64_t duration);
+    virtual std::string skipInvocation(pbxbuild::Tool::Invocation const &invocation, bool cached);
+
+public:
+    static std::shared_ptr<JSONFormatter> Create();
+};
+
+}
+
+#endif // !__xcformatter_JSONFormatter_h
@@ -0,0 +1,60 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcformatter_Output_h
+#define __xcformatter_Output_h
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+namespace xcformatter {
+
+/*
+ * Collects formatted output and writes it to a stream in batches. Each
+ * write is kept together, even when writing from multiple threads, so the
+ * output of an invocation written at once is never interleaved with other
+ * output. When the stream is a terminal, writes are shown immediately.
+ */
+class Output {
+private:
+    FILE       *_stream;
+    bool        _interactive;
+    size_t      _batchSize;
+
+private:
+    std::mutex  _mutex;
+    std::string _buffer;
+
+public:
+    Output(FILE *stream, size_t batchSize);
+    ~Output();
+
+public:
+    /*
+     * Add text to the output. Empty text is ignored.
+     */
+    void write(std::string const &text);
+
+    /*
+     * Write out everything added so far. Needed before anything else writes
+     * to the same stream.
+     */
+    void flush();
+
+public:
+    /*
+     * Output to standard output, shared by all formatters.
+     */
+    static Output *Standard();
+};
+
+}
+
+#endif // !__xcformatter_Output_h
@@ -111,6 +111,18 @@ failure(pbxbuild::Build::Context const &buildContext, std::vector<pbxbuild::Tool
     return result;
 }
 
+std::string DefaultFormatter::
+cancelled(pbxbuild::Build::Context const &buildContext)
+{
+    std::string result;
+
+    result += ANSI_STYLE_BOLD + ANSI_COLOR_RED;
+    result += "** " + FormatAction(buildContext.action()) + " CANCELLED **";
+    result += ANSI_STYLE_NO_BOLD + ANSI_COLOR_RESET + "\n";
+
+    return result;
+}
+
 std::string DefaultFormatter::
 beginTarget(pbxbuild::Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target)
 {
@@ -263,6 +275,18 @@ finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const
     }
 }
 
+std::string DefaultFormatter::
+resultInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &output, bool success, uint64_t duration)
+{
+    return output;
+}
+
+std::string DefaultFormatter::
+skipInvocation(pbxbuild::Tool::Invocation const &invocation, bool cached)
+{
+    return std::string();
+}
+
 std::shared_ptr<DefaultFormatter> DefaultFormatter::
 Create(bool color)
 {
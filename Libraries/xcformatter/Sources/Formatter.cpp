@@ -8,8 +8,10 @@
  */
 
 #include <xcformatter/Formatter.h>
+#include <xcformatter/Output.h>
 
 using xcformatter::Formatter;
+using xcformatter::Output;
 
 Formatter::
 Formatter()
@@ -24,6 +26,6 @@ Formatter::
 void Formatter::
 Print(std::string const &output)
 {
-    fputs(output.c_str(), stdout);
+    Output::Standard()->write(output);
 }
 
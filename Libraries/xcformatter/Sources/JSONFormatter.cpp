@@ -0,0 +1,303 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcformatter/JSONFormatter.h>
+#include <pbxbuild/Tool/Invocation.h>
+#include <pbxbuild/Build/Context.h>
+
+using xcformatter::JSONFormatter;
+
+namespace {
+
+/*
+ * A single event, written as one line of JSON.
+ */
+class Event {
+private:
+    std::string _line;
+
+public:
+    Event(std::string const &name, std::chrono::steady_clock::time_point const &start)
+    {
+        uint64_t time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+        _line += "{";
+        add("event", name);
+        add("time", time);
+    }
+
+public:
+    Event &add(char const *key, std::string const &value)
+    {
+        appendKey(key);
+        appendString(value);
+        return *this;
+    }
+
+    Event &add(char const *key, uint64_t value)
+    {
+        appendKey(key);
+        _line += std::to_string(value);
+        return *this;
+    }
+
+    Event &add(char const *key, bool value)
+    {
+        appendKey(key);
+        _line += (value ? "true" : "false");
+        return *this;
+    }
+
+    Event &add(char const *key, std::vector<std::string> const &values)
+    {
+        appendKey(key);
+        _line += "[";
+        for (auto it = values.begin(); it != values.end(); ++it) {
+            if (it != values.begin()) {
+                _line += ",";
+            }
+            appendString(*it);
+        }
+        _line += "]";
+        return *this;
+    }
+
+public:
+    std::string line() const
+    {
+        return _line + "}\n";
+    }
+
+private:
+    void appendKey(char const *key)
+    {
+        if (_line.size() > 1) {
+            _line += ",";
+        }
+        appendString(key);
+        _line += ":";
+    }
+
+    void appendString(std::string const &value)
+    {
+        static char const hex[] = "0123456789abcdef";
+
+        _line += "\"";
+        for (char c : value) {
+            switch (c) {
+                case '"':  _line += "\\\""; break;
+                case '\\': _line += "\\\\"; break;
+                case '\n': _line += "\\n"; break;
+                case '\r': _line += "\\r"; break;
+                case '\t': _line += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        _line += "\\u00";
+                        _line += hex[(c >> 4) & 0xF];
+                        _line += hex[c & 0xF];
+                    } else {
+                        _line += c;
+                    }
+                    break;
+            }
+        }
+        _line += "\"";
+    }
+};
+
+}
+
+JSONFormatter::
+JSONFormatter() :
+    Formatter(),
+    _start   (std::chrono::steady_clock::now())
+{
+}
+
+JSONFormatter::
+~JSONFormatter()
+{
+}
+
+static Event
+TargetEvent(std::string const &name, std::chrono::steady_clock::time_point const &start, pbxproj::PBX::Target::shared_ptr const &target)
+{
+    Event event = Event(name, start);
+    event.add("target", target->name());
+    event.add("project", target->project()->name());
+    return event;
+}
+
+static Event
+InvocationEvent(std::string const &name, std::chrono::steady_clock::time_point const &start, pbxbuild::Tool::Invocation const &invocation)
+{
+    Event event = Event(name, start);
+    event.add("command", invocation.commandFingerprint());
+    event.add("message", invocation.logMessage());
+    return event;
+}
+
+std::string JSONFormatter::
+begin(pbxbuild::Build::Context const &buildContext)
+{
+    _start = std::chrono::steady_clock::now();
+
+    Event event = Event("buildBegin", _start);
+    event.add("action", buildContext.action());
+    if (buildContext.scheme() != nullptr) {
+        event.add("scheme", buildContext.scheme()->name());
+    }
+    event.add("configuration", buildContext.configuration());
+    return event.line();
+}
+
+std::string JSONFormatter::
+success(pbxbuild::Build::Context const &buildContext)
+{
+    return Event("buildFinish", _start)
+        .add("success", true)
+        .line();
+}
+
+std::string JSONFormatter::
+failure(pbxbuild::Build::Context const &buildContext, std::vector<pbxbuild::Tool::Invocation> const &failingInvocations)
+{
+    std::vector<std::string> failures;
+    for (pbxbuild::Tool::Invocation const &invocation : failingInvocations) {
+        failures.push_back(invocation.logMessage());
+    }
+
+    return Event("buildFinish", _start)
+        .add("success", false)
+        .add("failures", failures)
+        .line();
+}
+
+std::string JSONFormatter::
+cancelled(pbxbuild::Build::Context const &buildContext)
+{
+    return Event("buildFinish", _start)
+        .add("success", false)
+        .add("cancelled", true)
+        .line();
+}
+
+std::string JSONFormatter::
+beginTarget(pbxbuild::Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return TargetEvent("targetBegin", _start, target).line();
+}
+
+std::string JSONFormatter::
+finishTarget(pbxbuild::Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return TargetEvent("targetFinish", _start, target).line();
+}
+
+std::string JSONFormatter::
+beginCheckDependencies(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return TargetEvent("checkDependenciesBegin", _start, target).line();
+}
+
+std::string JSONFormatter::
+finishCheckDependencies(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return TargetEvent("checkDependenciesFinish", _start, target).line();
+}
+
+std::string JSONFormatter::
+beginWriteAuxiliaryFiles(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return TargetEvent("writeAuxiliaryFilesBegin", _start, target).line();
+}
+
+std::string JSONFormatter::
+createAuxiliaryDirectory(std::string const &directory)
+{
+    return Event("createAuxiliaryDirectory", _start)
+        .add("path", directory)
+        .line();
+}
+
+std::string JSONFormatter::
+writeAuxiliaryFile(std::string const &file)
+{
+    return Event("writeAuxiliaryFile", _start)
+        .add("path", file)
+        .line();
+}
+
+std::string JSONFormatter::
+setAuxiliaryExecutable(std::string const &file)
+{
+    return Event("setAuxiliaryExecutable", _start)
+        .add("path", file)
+        .line();
+}
+
+std::string JSONFormatter::
+finishWriteAuxiliaryFiles(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return TargetEvent("writeAuxiliaryFilesFinish", _start, target).line();
+}
+
+std::string JSONFormatter::
+beginCreateProductStructure(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return TargetEvent("createProductStructureBegin", _start, target).line();
+}
+
+std::string JSONFormatter::
+finishCreateProductStructure(pbxproj::PBX::Target::shared_ptr const &target)
+{
+    return TargetEvent("createProductStructureFinish", _start, target).line();
+}
+
+std::string JSONFormatter::
+beginInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple)
+{
+    return InvocationEvent("invocationBegin", _start, invocation)
+        .add("executable", executable)
+        .add("arguments", invocation.arguments())
+        .add("workingDirectory", invocation.workingDirectory())
+        .line();
+}
+
+std::string JSONFormatter::
+finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &executable, bool simple)
+{
+    /* Reported with the result. */
+    return std::string();
+}
+
+std::string JSONFormatter::
+resultInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &output, bool success, uint64_t duration)
+{
+    return InvocationEvent("invocationFinish", _start, invocation)
+        .add("success", success)
+        .add("duration", duration)
+        .add("outputSize", static_cast<uint64_t>(output.size()))
+        .add("output", output)
+        .line();
+}
+
+std::string JSONFormatter::
+skipInvocation(pbxbuild::Tool::Invocation const &invocation, bool cached)
+{
+    return InvocationEvent("invocationSkip", _start, invocation)
+        .add("cached", cached)
+        .line();
+}
+
+std::shared_ptr<JSONFormatter> JSONFormatter::
+Create()
+{
+    return std::make_shared<JSONFormatter>();
+}
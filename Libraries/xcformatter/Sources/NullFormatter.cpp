@@ -44,6 +44,12 @@ failure(pbxbuild::Build::Context const &buildContext, std::vector<pbxbuild::Tool
     return std::string();
 }
 
+std::string NullFormatter::
+cancelled(pbxbuild::Build::Context const &buildContext)
+{
+    return std::string();
+}
+
 std::string NullFormatter::
 beginTarget(pbxbuild::Build::Context const &buildContext, pbxproj::PBX::Target::shared_ptr const &target)
 {
@@ -122,6 +128,18 @@ finishInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const
     return std::string();
 }
 
+std::string NullFormatter::
+resultInvocation(pbxbuild::Tool::Invocation const &invocation, std::string const &output, bool success, uint64_t duration)
+{
+    return output;
+}
+
+std::string NullFormatter::
+skipInvocation(pbxbuild::Tool::Invocation const &invocation, bool cached)
+{
+    return std::string();
+}
+
 std::shared_ptr<NullFormatter> NullFormatter::
 Create()
 {
@@ -0,0 +1,67 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcformatter/Output.h>
+
+#include <unistd.h>
+
+using xcformatter::Output;
+
+Output::
+Output(FILE *stream, size_t batchSize) :
+    _stream     (stream),
+    _interactive(::isatty(::fileno(stream)) != 0),
+    _batchSize  (batchSize)
+{
+}
+
+Output::
+~Output()
+{
+    flush();
+}
+
+static void
+WriteBuffer(FILE *stream, std::string *buffer)
+{
+    if (!buffer->empty()) {
+        fwrite(buffer->data(), 1, buffer->size(), stream);
+        fflush(stream);
+        buffer->clear();
+    }
+}
+
+void Output::
+write(std::string const &text)
+{
+    if (text.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _buffer += text;
+
+    if (_interactive || _buffer.size() >= _batchSize) {
+        WriteBuffer(_stream, &_buffer);
+    }
+}
+
+void Output::
+flush()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    WriteBuffer(_stream, &_buffer);
+}
+
+Output *Output::
+Standard()
+{
+    static Output output(stdout, 64 * 1024);
+    return &output;
+}
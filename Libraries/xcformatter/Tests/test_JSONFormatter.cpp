@@ -0,0 +1,143 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcformatter/JSONFormatter.h>
+#include <pbxbuild/Tool/Invocation.h>
+#include <plist/Array.h>
+#include <plist/Boolean.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/JSON.h>
+
+using xcformatter::JSONFormatter;
+
+static pbxbuild::Tool::Invocation
+CreateInvocation()
+{
+    pbxbuild::Tool::Invocation invocation;
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External("/usr/bin/clang");
+    invocation.arguments() = { "-c", "a \"quoted\".c" };
+    invocation.workingDirectory() = "/src";
+    invocation.logMessage() = "CompileC a.o a.c";
+    return invocation;
+}
+
+/*
+ * Parse an event, which must be a single line holding a JSON object.
+ */
+static std::unique_ptr<plist::Dictionary>
+ParseEvent(std::string const &line)
+{
+    EXPECT_FALSE(line.empty());
+    EXPECT_EQ('\n', line.back());
+    EXPECT_EQ(line.size() - 1, line.find('\n'));
+
+    auto result = plist::Format::JSON::Deserialize(std::vector<uint8_t>(line.begin(), line.end()), plist::Format::JSON::Create());
+    EXPECT_NE(nullptr, result.first) << result.second;
+    if (plist::CastTo<plist::Dictionary>(result.first.get()) == nullptr) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<plist::Dictionary>(static_cast<plist::Dictionary *>(result.first.release()));
+}
+
+static std::string
+StringValue(plist::Dictionary const *event, std::string const &key)
+{
+    plist::String const *string = event->value<plist::String>(key);
+    return (string != nullptr ? string->value() : "<missing>");
+}
+
+TEST(JSONFormatter, BeginInvocation)
+{
+    std::shared_ptr<JSONFormatter> formatter = JSONFormatter::Create();
+    pbxbuild::Tool::Invocation invocation = CreateInvocation();
+
+    std::unique_ptr<plist::Dictionary> event = ParseEvent(formatter->beginInvocation(invocation, "clang", false));
+    ASSERT_NE(nullptr, event);
+    EXPECT_EQ("invocationBegin", StringValue(event.get(), "event"));
+    EXPECT_NE(nullptr, event->value<plist::Integer>("time"));
+    EXPECT_EQ(invocation.commandFingerprint(), StringValue(event.get(), "command"));
+    EXPECT_EQ("CompileC a.o a.c", StringValue(event.get(), "message"));
+    EXPECT_EQ("clang", StringValue(event.get(), "executable"));
+    EXPECT_EQ("/src", StringValue(event.get(), "workingDirectory"));
+
+    plist::Array const *arguments = event->value<plist::Array>("arguments");
+    ASSERT_NE(nullptr, arguments);
+    ASSERT_EQ(2, arguments->count());
+    EXPECT_EQ("-c", arguments->value<plist::String>(0)->value());
+    EXPECT_EQ("a \"quoted\".c", arguments->value<plist::String>(1)->value());
+
+    /* The finish is reported with the result. */
+    EXPECT_EQ("", formatter->finishInvocation(invocation, "clang", false));
+}
+
+TEST(JSONFormatter, ResultInvocation)
+{
+    std::shared_ptr<JSONFormatter> formatter = JSONFormatter::Create();
+    pbxbuild::Tool::Invocation invocation = CreateInvocation();
+
+    /* Output with characters JSON must escape stays on one line. */
+    std::string output = "a.c:1: error: \"x\"\n\tline\\two\r\x01\n";
+    std::unique_ptr<plist::Dictionary> event = ParseEvent(formatter->resultInvocation(invocation, output, false, 42));
+    ASSERT_NE(nullptr, event);
+    EXPECT_EQ("invocationFinish", StringValue(event.get(), "event"));
+    EXPECT_EQ(invocation.commandFingerprint(), StringValue(event.get(), "command"));
+    EXPECT_EQ(output, StringValue(event.get(), "output"));
+    EXPECT_EQ(output.size(), event->value<plist::Integer>("outputSize")->value());
+    EXPECT_EQ(42, event->value<plist::Integer>("duration")->value());
+    EXPECT_FALSE(event->value<plist::Boolean>("success")->value());
+
+    event = ParseEvent(formatter->resultInvocation(invocation, "", true, 0));
+    ASSERT_NE(nullptr, event);
+    EXPECT_TRUE(event->value<plist::Boolean>("success")->value());
+    EXPECT_EQ("", StringValue(event.get(), "output"));
+    EXPECT_EQ(0, event->value<plist::Integer>("outputSize")->value());
+}
+
+TEST(JSONFormatter, SkipInvocation)
+{
+    std::shared_ptr<JSONFormatter> formatter = JSONFormatter::Create();
+    pbxbuild::Tool::Invocation invocation = CreateInvocation();
+
+    std::unique_ptr<plist::Dictionary> event = ParseEvent(formatter->skipInvocation(invocation, true));
+    ASSERT_NE(nullptr, event);
+    EXPECT_EQ("invocationSkip", StringValue(event.get(), "event"));
+    EXPECT_EQ(invocation.commandFingerprint(), StringValue(event.get(), "command"));
+    EXPECT_TRUE(event->value<plist::Boolean>("cached")->value());
+
+    event = ParseEvent(formatter->skipInvocation(invocation, false));
+    ASSERT_NE(nullptr, event);
+    EXPECT_FALSE(event->value<plist::Boolean>("cached")->value());
+}
+
+TEST(JSONFormatter, AuxiliaryFiles)
+{
+    std::shared_ptr<JSONFormatter> formatter = JSONFormatter::Create();
+
+    std::unique_ptr<plist::Dictionary> directory = ParseEvent(formatter->createAuxiliaryDirectory("/build/dir"));
+    ASSERT_NE(nullptr, directory);
+    EXPECT_EQ("createAuxiliaryDirectory", StringValue(directory.get(), "event"));
+    EXPECT_EQ("/build/dir", StringValue(directory.get(), "path"));
+
+    std::unique_ptr<plist::Dictionary> file = ParseEvent(formatter->writeAuxiliaryFile("/build/dir/a.sh"));
+    ASSERT_NE(nullptr, file);
+    EXPECT_EQ("writeAuxiliaryFile", StringValue(file.get(), "event"));
+    EXPECT_EQ("/build/dir/a.sh", StringValue(file.get(), "path"));
+
+    std::unique_ptr<plist::Dictionary> executable = ParseEvent(formatter->setAuxiliaryExecutable("/build/dir/a.sh"));
+    ASSERT_NE(nullptr, executable);
+    EXPECT_EQ("setAuxiliaryExecutable", StringValue(executable.get(), "event"));
+    EXPECT_EQ("/build/dir/a.sh", StringValue(executable.get(), "path"));
+
+    /* Times count up from when the formatter started. */
+    EXPECT_LE(directory->value<plist::Integer>("time")->value(), executable->value<plist::Integer>("time")->value());
+}
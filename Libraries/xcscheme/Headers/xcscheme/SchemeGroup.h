@@ -13,7 +13,9 @@
 #include <xcscheme/XC/Scheme.h>
 
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <ext/optional>
 
 namespace libutil { class Filesystem; }
@@ -30,8 +32,27 @@ private:
     std::string                      _name;
 
 private:
-    xcscheme::XC::Scheme::vector     _schemes;
-    xcscheme::XC::Scheme::shared_ptr _defaultScheme;
+    /*
+     * A scheme file in the group. Each is only parsed once it's needed.
+     */
+    struct Entry {
+        std::string                      name;
+        std::string                      owner;
+        std::string                      path;
+        bool                             loaded;
+        xcscheme::XC::Scheme::shared_ptr scheme;
+    };
+
+private:
+    libutil::Filesystem const       *_filesystem;
+    mutable std::vector<Entry>       _entries;
+    mutable std::mutex               _mutex;
+
+private:
+    mutable bool                             _schemesLoaded;
+    mutable xcscheme::XC::Scheme::vector     _schemes;
+    mutable bool                             _defaultSchemeLoaded;
+    mutable xcscheme::XC::Scheme::shared_ptr _defaultScheme;
 
 public:
     SchemeGroup();
@@ -45,17 +66,37 @@ public:
     { return _name; }
 
 public:
-    inline xcscheme::XC::Scheme::vector const &schemes() const
-    { return _schemes; }
-    inline xcscheme::XC::Scheme::shared_ptr const &defaultScheme() const
-    { return _defaultScheme; }
+    /*
+     * All schemes in the group. Parses every scheme file not yet parsed.
+     */
+    xcscheme::XC::Scheme::vector const &schemes() const;
+
+    /*
+     * The scheme named after the group, or else the first scheme.
+     */
+    xcscheme::XC::Scheme::shared_ptr const &defaultScheme() const;
+
+    /*
+     * The paths of the scheme files in the group, parsed or not.
+     */
+    std::vector<std::string> schemePaths() const;
+
+    /*
+     * The names of the schemes in the group, in the same order as their
+     * paths. Found from the file names, so nothing is parsed.
+     */
+    std::vector<std::string> schemeNames() const;
 
 public:
     /*
-     * Find a scheme inside the group.
+     * Find a scheme inside the group. Only the files for schemes with that
+     * name are parsed.
      */
     xcscheme::XC::Scheme::shared_ptr scheme(std::string const &name) const;
 
+private:
+    xcscheme::XC::Scheme::shared_ptr const &load(Entry *entry) const;
+
 public:
     static SchemeGroup::shared_ptr Open(
         libutil::Filesystem const *filesystem,
@@ -18,16 +18,103 @@ using libutil::Filesystem;
 using libutil::FSUtil;
 
 SchemeGroup::
-SchemeGroup()
+SchemeGroup() :
+    _filesystem         (nullptr),
+    _schemesLoaded      (false),
+    _defaultSchemeLoaded(false)
 {
 }
 
+Scheme::shared_ptr const &SchemeGroup::
+load(Entry *entry) const
+{
+    if (!entry->loaded) {
+        entry->loaded = true;
+        entry->scheme = Scheme::Open(_filesystem, entry->name, entry->owner, entry->path);
+        if (!entry->scheme) {
+            fprintf(stderr, "warning: failed parsing %s scheme '%s'\n", entry->owner.empty() ? "shared" : "user", entry->name.c_str());
+        }
+    }
+
+    return entry->scheme;
+}
+
+Scheme::vector const &SchemeGroup::
+schemes() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_schemesLoaded) {
+        _schemesLoaded = true;
+
+        for (Entry &entry : _entries) {
+            if (Scheme::shared_ptr const &scheme = load(&entry)) {
+                _schemes.push_back(scheme);
+            }
+        }
+    }
+
+    return _schemes;
+}
+
+Scheme::shared_ptr const &SchemeGroup::
+defaultScheme() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_defaultSchemeLoaded) {
+        _defaultSchemeLoaded = true;
+
+        for (Entry &entry : _entries) {
+            if (entry.name == _name && load(&entry)) {
+                _defaultScheme = entry.scheme;
+                return _defaultScheme;
+            }
+        }
+
+        for (Entry &entry : _entries) {
+            if (load(&entry)) {
+                _defaultScheme = entry.scheme;
+                return _defaultScheme;
+            }
+        }
+    }
+
+    return _defaultScheme;
+}
+
+std::vector<std::string> SchemeGroup::
+schemePaths() const
+{
+    std::vector<std::string> paths;
+    paths.reserve(_entries.size());
+    for (Entry const &entry : _entries) {
+        paths.push_back(entry.path);
+    }
+    return paths;
+}
+
+std::vector<std::string> SchemeGroup::
+schemeNames() const
+{
+    std::vector<std::string> names;
+    names.reserve(_entries.size());
+    for (Entry const &entry : _entries) {
+        names.push_back(entry.name);
+    }
+    return names;
+}
+
 Scheme::shared_ptr SchemeGroup::
 scheme(std::string const &name) const
 {
-    for (Scheme::shared_ptr const &scheme : _schemes) {
-        if (scheme->name() == name) {
-            return scheme;
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (Entry &entry : _entries) {
+        if (entry.name == name) {
+            if (Scheme::shared_ptr const &scheme = load(&entry)) {
+                return scheme;
+            }
         }
     }
 
@@ -51,54 +138,29 @@ Open(Filesystem const *filesystem, ext::optional<std::string> const &userName, s
     }
 
     SchemeGroup::shared_ptr group = std::make_shared <SchemeGroup> ();
+    group->_filesystem = filesystem;
     group->_basePath = basePath;
     group->_path = path;
     group->_name = name;
 
-    std::string schemePath;
-
-    schemePath = path + "/xcshareddata/xcschemes";
-    filesystem->enumerateDirectory(schemePath, [&](std::string const &filename) -> void {
-        if (FSUtil::GetFileExtension(filename) != "xcscheme") {
-            return;
-        }
-
-        std::string name = filename.substr(0, filename.find('.'));
-        auto scheme = Scheme::Open(filesystem, name, std::string(), schemePath + "/" + filename);
-        if (!scheme) {
-            fprintf(stderr, "warning: failed parsing shared scheme '%s'\n", name.c_str());
-        } else {
-            group->_schemes.push_back(scheme);
-        }
-
-        if (!group->_defaultScheme && name == group->name()) {
-            group->_defaultScheme = scheme;
-        }
-    });
-
-    if (userName) {
-        schemePath = path + "/xcuserdata/" + *userName + ".xcuserdatad/xcschemes";
+    /*
+     * Only find the scheme files here; schemes are parsed when needed, so
+     * using one scheme doesn't parse every other scheme in the group.
+     */
+    auto addSchemes = [&](std::string const &schemePath, std::string const &owner) {
         filesystem->enumerateDirectory(schemePath, [&](std::string const &filename) -> void {
             if (FSUtil::GetFileExtension(filename) != "xcscheme") {
                 return;
             }
 
             std::string name = filename.substr(0, filename.find('.'));
-            auto scheme = Scheme::Open(filesystem, name, *userName, schemePath + "/" + filename);
-            if (!scheme) {
-                fprintf(stderr, "warning: failed parsing user scheme '%s'\n", name.c_str());
-            } else {
-                group->_schemes.push_back(scheme);
-            }
-
-            if (!group->_defaultScheme && name == group->name()) {
-                group->_defaultScheme = scheme;
-            }
+            group->_entries.push_back({ name, owner, schemePath + "/" + filename, false, nullptr });
         });
-    }
+    };
 
-    if (!group->_schemes.empty() && !group->_defaultScheme) {
-        group->_defaultScheme = group->_schemes[0];
+    addSchemes(path + "/xcshareddata/xcschemes", std::string());
+    if (userName) {
+        addSchemes(path + "/xcuserdata/" + *userName + ".xcuserdatad/xcschemes", *userName);
     }
 
     return group;
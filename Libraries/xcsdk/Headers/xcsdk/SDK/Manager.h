@@ -23,6 +23,8 @@ namespace xcsdk { class Configuration; }
 
 namespace xcsdk { namespace SDK {
 
+class Registry;
+
 /*
  * Represents the contents of a developer root, containing toolchains,
  * platforms, and SDKs. There is usually only one developer root.
@@ -100,9 +102,10 @@ public:
 
 public:
     /*
-     * Load from a developer root. Returns nullptr on error.
+     * Load from a developer root. Returns nullptr on error. If a registry
+     * is passed, unchanged contents are loaded from it rather than read.
      */
-    static std::shared_ptr<Manager> Open(libutil::Filesystem const *filesystem, std::string const &path, ext::optional<Configuration> const &configuration);
+    static std::shared_ptr<Manager> Open(libutil::Filesystem const *filesystem, std::string const &path, ext::optional<Configuration> const &configuration, Registry *registry = nullptr);
 };
 
 } }
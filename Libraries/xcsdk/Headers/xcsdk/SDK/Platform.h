@@ -23,6 +23,8 @@ namespace plist { class Dictionary; }
 
 namespace xcsdk { namespace SDK {
 
+class Registry;
+
 class Platform {
 public:
     typedef std::shared_ptr <Platform> shared_ptr;
@@ -128,7 +130,7 @@ public:
     std::vector<std::string> executablePaths() const;
 
 public:
-    static Platform::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path);
+    static Platform::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path, Registry *registry = nullptr);
 
 private:
     bool parse(plist::Dictionary const *dict);
@@ -19,6 +19,8 @@ namespace plist { class Dictionary; }
 
 namespace xcsdk { namespace SDK {
 
+class Registry;
+
 class PlatformVersion {
 public:
     typedef std::shared_ptr <PlatformVersion> shared_ptr;
@@ -49,7 +51,7 @@ public:
     { return _bundleVersion; }
 
 public:
-    static PlatformVersion::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path);
+    static PlatformVersion::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path, Registry *registry = nullptr);
 
 private:
     bool parse(plist::Dictionary const *dict);
@@ -19,6 +19,8 @@ namespace plist { class Dictionary; }
 
 namespace xcsdk { namespace SDK {
 
+class Registry;
+
 class Product {
 public:
     typedef std::shared_ptr <Product> shared_ptr;
@@ -46,7 +48,7 @@ public:
     { return _productCopyright; }
 
 public:
-    static Product::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path);
+    static Product::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path, Registry *registry = nullptr);
 
 private:
     bool parse(plist::Dictionary const *dict);
@@ -0,0 +1,105 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef __xcsdk_SDK_Registry_h
+#define __xcsdk_SDK_Registry_h
+
+#include <plist/Dictionary.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+namespace process { class Context; }
+
+namespace xcsdk { namespace SDK {
+
+/*
+ * The directory listings and property lists read to find the toolchains,
+ * platforms, and SDKs in a developer root. Can be saved and loaded, so
+ * later tools skip reading and parsing them again. Each entry is checked
+ * against the modification time of its path before it is used. Paths can
+ * be looked up from multiple threads, but each by only one at a time.
+ */
+class Registry {
+private:
+    struct Directory {
+        uint64_t                           modificationTime;
+        std::vector<std::string>           entries;
+        bool                               used;
+    };
+
+    struct File {
+        uint64_t                           modificationTime;
+        std::string                        realPath;
+        std::unique_ptr<plist::Dictionary> contents;
+        bool                               used;
+    };
+
+private:
+    std::unordered_map<std::string, Directory> _directories;
+    std::unordered_map<std::string, File>      _files;
+    bool                                       _changed;
+    mutable std::mutex                         _mutex;
+
+public:
+    Registry();
+    ~Registry();
+
+public:
+    /*
+     * If anything was read from the filesystem rather than the registry,
+     * or if entries loaded weren't used. If not, there's no need to save.
+     */
+    bool changed() const;
+
+    /*
+     * The directories and files used since the registry was loaded.
+     */
+    std::vector<std::string> paths() const;
+
+public:
+    /*
+     * Call a function with the name of each entry in a directory.
+     */
+    bool enumerateDirectory(libutil::Filesystem const *filesystem, std::string const &path, std::function<void(std::string const &)> const &cb);
+
+    /*
+     * The dictionary in a property list, and the path it resolves to. The
+     * dictionary is owned by the registry. Returns nullptr on error.
+     */
+    plist::Dictionary const *propertyList(libutil::Filesystem const *filesystem, std::string const &path, std::string *realPath);
+
+public:
+    /*
+     * Load a saved registry. Missing or invalid registries load as empty.
+     */
+    void load(libutil::Filesystem const *filesystem, std::string const &path);
+
+    /*
+     * Save the entries used since the registry was loaded.
+     */
+    bool save(libutil::Filesystem *filesystem, std::string const &path) const;
+
+public:
+    /*
+     * The default path to save the registry at.
+     */
+    static ext::optional<std::string>
+    DefaultPath(process::Context const *processContext);
+};
+
+} }
+
+#endif  // !__xcsdk_SDK_Registry_h
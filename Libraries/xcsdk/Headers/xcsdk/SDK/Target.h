@@ -26,6 +26,7 @@ namespace xcsdk { namespace SDK {
 
 class Manager;
 class Platform;
+class Registry;
 
 class Target {
 public:
@@ -132,7 +133,7 @@ public:
     std::vector<std::string> executablePaths() const;
 
 public:
-    static Target::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared_ptr<Platform>, std::string const &path);
+    static Target::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared_ptr<Platform>, std::string const &path, Registry *registry = nullptr);
 
 private:
     bool parse(plist::Dictionary const *dict);
@@ -23,6 +23,7 @@ namespace plist { class Dictionary; }
 namespace xcsdk { namespace SDK {
 
 class Manager;
+class Registry;
 
 class Toolchain {
 public:
@@ -100,7 +101,7 @@ public:
     std::vector<std::string> executablePaths() const;
 
 public:
-    static Toolchain::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path);
+    static Toolchain::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path, Registry *registry = nullptr);
 
 public:
     static std::string DefaultIdentifier(void);
@@ -9,20 +9,28 @@
 
 #include <xcsdk/SDK/Manager.h>
 #include <xcsdk/Configuration.h>
+#include <xcsdk/SDK/Registry.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Statistic.h>
+#include <libutil/Parallel.h>
 #include <pbxsetting/Setting.h>
 #include <pbxsetting/Type.h>
 
 #include <algorithm>
+#include <functional>
 
 using xcsdk::Configuration;
 using xcsdk::SDK::Manager;
 using xcsdk::SDK::Platform;
+using xcsdk::SDK::Registry;
 using xcsdk::SDK::Target;
 using xcsdk::SDK::Toolchain;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Statistic;
+
+static Statistic OpenTime("xcsdk", "Open SDK manager");
 
 Manager::
 Manager()
@@ -150,13 +158,20 @@ executablePaths(Platform::shared_ptr const &platform, Target::shared_ptr const &
 }
 
 std::shared_ptr<Manager> Manager::
-Open(Filesystem const *filesystem, std::string const &path, ext::optional<Configuration> const &configuration)
+Open(Filesystem const *filesystem, std::string const &path, ext::optional<Configuration> const &configuration, Registry *registry)
 {
+    Statistic::Timer timer(&OpenTime);
+
     if (path.empty()) {
         fprintf(stderr, "error: empty path for sdk manager\n");
         return nullptr;
     }
 
+    Registry uncached;
+    if (registry == nullptr) {
+        registry = &uncached;
+    }
+
     auto manager = std::make_shared <Manager> ();
     manager->_path = path;
 
@@ -166,19 +181,25 @@ Open(Filesystem const *filesystem, std::string const &path, ext::optional<Config
         toolchainsPaths.insert(toolchainsPaths.end(), extraToolchainsPaths.begin(), extraToolchainsPaths.end());
     }
 
-    std::vector<std::shared_ptr<Toolchain>> toolchains;
+    std::vector<std::string> toolchainPaths;
     for (std::string const &toolchainsPath : toolchainsPaths) {
-        filesystem->enumerateDirectory(toolchainsPath, [&](std::string const &filename) -> void {
+        registry->enumerateDirectory(filesystem, toolchainsPath, [&](std::string const &filename) -> void {
             if (FSUtil::GetFileExtension(filename) != "xctoolchain") {
                 return;
             }
 
-            auto toolchain = SDK::Toolchain::Open(filesystem, toolchainsPath + "/" + filename);
-            if (toolchain != nullptr) {
-                toolchains.push_back(toolchain);
-            }
+            toolchainPaths.push_back(toolchainsPath + "/" + filename);
         });
     }
+
+    /*
+     * Open toolchains in parallel, but keep them in the order found.
+     */
+    std::vector<std::shared_ptr<Toolchain>> toolchains = std::vector<std::shared_ptr<Toolchain>>(toolchainPaths.size());
+    libutil::Parallel::For(toolchainPaths.size(), [&](size_t index) {
+        toolchains[index] = SDK::Toolchain::Open(filesystem, toolchainPaths[index], registry);
+    });
+    toolchains.erase(std::remove(toolchains.begin(), toolchains.end(), nullptr), toolchains.end());
     manager->_toolchains = toolchains;
 
     std::vector<std::string> platformsPaths = { path + "/" + "Platforms" };
@@ -187,19 +208,26 @@ Open(Filesystem const *filesystem, std::string const &path, ext::optional<Config
         platformsPaths.insert(platformsPaths.end(), extraPlatformsPaths.begin(), extraPlatformsPaths.end());
     }
 
-    std::vector<std::shared_ptr<Platform>> platforms;
+    std::vector<std::string> platformPaths;
     for (std::string const &platformsPath : platformsPaths) {
-        filesystem->enumerateDirectory(platformsPath, [&](std::string const &filename) -> void {
+        registry->enumerateDirectory(filesystem, platformsPath, [&](std::string const &filename) -> void {
             if (FSUtil::GetFileExtension(filename) != "platform") {
                 return;
             }
 
-            auto platform = SDK::Platform::Open(filesystem, manager, platformsPath + "/" + filename);
-            if (platform != nullptr) {
-                platforms.push_back(platform);
-            }
+            platformPaths.push_back(platformsPath + "/" + filename);
         });
     }
+
+    /*
+     * Open platforms, each with their SDKs, in parallel. Platforms use the
+     * toolchains opened above, which aren't changed while they're opened.
+     */
+    std::vector<std::shared_ptr<Platform>> platforms = std::vector<std::shared_ptr<Platform>>(platformPaths.size());
+    libutil::Parallel::For(platformPaths.size(), [&](size_t index) {
+        platforms[index] = SDK::Platform::Open(filesystem, manager, platformPaths[index], registry);
+    });
+    platforms.erase(std::remove(platforms.begin(), platforms.end(), nullptr), platforms.end());
     std::sort(platforms.begin(), platforms.end(), [](Platform::shared_ptr const &a, Platform::shared_ptr const &b) -> bool {
         return (a->description() < b->description());
     });
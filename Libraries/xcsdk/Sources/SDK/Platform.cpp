@@ -8,6 +8,7 @@
  */
 
 #include <xcsdk/SDK/Platform.h>
+#include <xcsdk/SDK/Registry.h>
 #include <xcsdk/SDK/Manager.h>
 #include <pbxsetting/Type.h>
 #include <libutil/Filesystem.h>
@@ -16,12 +17,12 @@
 #include <plist/Boolean.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
-#include <plist/Format/Any.h>
 #include <plist/Keys/Unpack.h>
 
 #include <algorithm>
 
 using xcsdk::SDK::Platform;
+using xcsdk::SDK::Registry;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
@@ -291,39 +292,22 @@ parse(plist::Dictionary const *dict)
 }
 
 Platform::shared_ptr Platform::
-Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path)
+Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path, Registry *registry)
 {
     if (path.empty()) {
         return nullptr;
     }
 
-    /*
-     * Load platform info.
-     */
-    std::string settingsFileName = path + "/Info.plist";
-    if (!filesystem->isReadable(settingsFileName)) {
-        return nullptr;
-    }
-
-    std::string realPath = filesystem->resolvePath(settingsFileName);
-    if (realPath.empty()) {
-        return nullptr;
-    }
-
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, settingsFileName)) {
-        return nullptr;
+    Registry uncached;
+    if (registry == nullptr) {
+        registry = &uncached;
     }
 
     /*
-     * Parse platform info property list.
+     * Load platform info.
      */
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
-        return nullptr;
-    }
-
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    std::string realPath;
+    plist::Dictionary const *plist = registry->propertyList(filesystem, path + "/Info.plist", &realPath);
     if (plist == nullptr) {
         return nullptr;
     }
@@ -345,18 +329,18 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string
     /*
      * Load platform version information.
      */
-    platform->_platformVersion = PlatformVersion::Open(filesystem, platform->_path);
+    platform->_platformVersion = PlatformVersion::Open(filesystem, platform->_path, registry);
 
     /*
      * Load all the SDKs inside the platform.
      */
     std::string sdksPath = platform->_path + "/Developer/SDKs";
-    filesystem->enumerateDirectory(sdksPath, [&](std::string const &filename) -> void {
+    registry->enumerateDirectory(filesystem, sdksPath, [&](std::string const &filename) -> void {
         if (FSUtil::GetFileExtension(filename) != "sdk") {
             return;
         }
 
-        if (auto target = Target::Open(filesystem, manager, platform, sdksPath + "/" + filename)) {
+        if (auto target = Target::Open(filesystem, manager, platform, sdksPath + "/" + filename, registry)) {
             platform->_targets.push_back(target);
         }
     });
@@ -8,13 +8,14 @@
  */
 
 #include <xcsdk/SDK/PlatformVersion.h>
+#include <xcsdk/SDK/Registry.h>
 #include <libutil/Filesystem.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
-#include <plist/Format/Any.h>
 #include <plist/Keys/Unpack.h>
 
 using xcsdk::SDK::PlatformVersion;
+using xcsdk::SDK::Registry;
 using libutil::Filesystem;
 
 PlatformVersion::
@@ -67,39 +68,22 @@ parse(plist::Dictionary const *dict)
 }
 
 PlatformVersion::shared_ptr PlatformVersion::
-Open(Filesystem const *filesystem, std::string const &path)
+Open(Filesystem const *filesystem, std::string const &path, Registry *registry)
 {
     if (path.empty()) {
         return nullptr;
     }
 
-    /*
-     * Read version info.
-     */
-    std::string versionFileName = path + "/version.plist";
-    if (!filesystem->isReadable(versionFileName)) {
-        return nullptr;
-    }
-
-    std::string realPath = filesystem->resolvePath(versionFileName);
-    if (realPath.empty()) {
-        return nullptr;
-    }
-
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, versionFileName)) {
-        return nullptr;
+    Registry uncached;
+    if (registry == nullptr) {
+        registry = &uncached;
     }
 
     /*
-     * Parse property list.
+     * Read version info.
      */
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
-        return nullptr;
-    }
-
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    std::string realPath;
+    plist::Dictionary const *plist = registry->propertyList(filesystem, path + "/version.plist", &realPath);
     if (plist == nullptr) {
         return nullptr;
     }
@@ -8,13 +8,14 @@
  */
 
 #include <xcsdk/SDK/Product.h>
+#include <xcsdk/SDK/Registry.h>
 #include <libutil/Filesystem.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
-#include <plist/Format/Any.h>
 #include <plist/Keys/Unpack.h>
 
 using xcsdk::SDK::Product;
+using xcsdk::SDK::Registry;
 using libutil::Filesystem;
 
 Product::
@@ -62,39 +63,22 @@ parse(plist::Dictionary const *dict)
 }
 
 Product::shared_ptr Product::
-Open(Filesystem const *filesystem, std::string const &path)
+Open(Filesystem const *filesystem, std::string const &path, Registry *registry)
 {
     if (path.empty()) {
         return nullptr;
     }
 
-    /*
-     * Load information.
-     */
-    std::string settingsFileName = path + "/System/Library/CoreServices/SystemVersion.plist";
-    if (!filesystem->isReadable(settingsFileName)) {
-        return nullptr;
-    }
-
-    std::string realPath = filesystem->resolvePath(settingsFileName);
-    if (realPath.empty()) {
-        return nullptr;
-    }
-
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, settingsFileName)) {
-        return nullptr;
+    Registry uncached;
+    if (registry == nullptr) {
+        registry = &uncached;
     }
 
     /*
-     * Parse property list.
+     * Load information.
      */
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
-        return nullptr;
-    }
-
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    std::string realPath;
+    plist::Dictionary const *plist = registry->propertyList(filesystem, path + "/System/Library/CoreServices/SystemVersion.plist", &realPath);
     if (plist == nullptr) {
         return nullptr;
     }
@@ -0,0 +1,301 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <xcsdk/SDK/Registry.h>
+#include <plist/Array.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/Binary.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <process/Context.h>
+
+using xcsdk::SDK::Registry;
+using libutil::Filesystem;
+using libutil::FSUtil;
+
+/* Saved registries with another version are ignored. */
+static int64_t const Version = 1;
+
+Registry::
+Registry() :
+    _changed(false)
+{
+}
+
+Registry::
+~Registry()
+{
+}
+
+bool Registry::
+changed() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_changed) {
+        return true;
+    }
+
+    for (auto const &entry : _directories) {
+        if (!entry.second.used) {
+            return true;
+        }
+    }
+
+    for (auto const &entry : _files) {
+        if (!entry.second.used) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<std::string> Registry::
+paths() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::vector<std::string> paths;
+
+    for (auto const &entry : _directories) {
+        if (entry.second.used) {
+            paths.push_back(entry.first);
+        }
+    }
+
+    for (auto const &entry : _files) {
+        if (entry.second.used) {
+            paths.push_back(entry.first);
+        }
+    }
+
+    return paths;
+}
+
+bool Registry::
+enumerateDirectory(Filesystem const *filesystem, std::string const &path, std::function<void(std::string const &)> const &cb)
+{
+    ext::optional<uint64_t> modificationTime = filesystem->modificationTime(path);
+    if (!modificationTime) {
+        return false;
+    }
+
+    /*
+     * Adding or removing an entry changes the directory, so an unchanged
+     * directory has the same entries.
+     */
+    Directory directory;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _directories.find(path);
+        if (it != _directories.end() && it->second.modificationTime == *modificationTime) {
+            it->second.used = true;
+            directory.entries = it->second.entries;
+            found = true;
+        }
+    }
+
+    if (!found) {
+        directory.modificationTime = *modificationTime;
+        directory.used = true;
+
+        bool enumerated = filesystem->enumerateDirectory(path, [&](std::string const &filename) {
+            directory.entries.push_back(filename);
+        });
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _changed = true;
+        if (!enumerated) {
+            _directories.erase(path);
+            return false;
+        }
+
+        _directories[path] = directory;
+    }
+
+    for (std::string const &filename : directory.entries) {
+        cb(filename);
+    }
+
+    return true;
+}
+
+plist::Dictionary const *Registry::
+propertyList(Filesystem const *filesystem, std::string const &path, std::string *realPath)
+{
+    ext::optional<uint64_t> modificationTime = filesystem->modificationTime(path);
+    if (!modificationTime) {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _files.find(path);
+        if (it != _files.end() && it->second.modificationTime == *modificationTime) {
+            it->second.used = true;
+            *realPath = it->second.realPath;
+            return it->second.contents.get();
+        }
+    }
+
+    /*
+     * Read and parse without holding the lock, so other files can be
+     * loaded at the same time.
+     */
+    File file;
+    file.modificationTime = *modificationTime;
+    file.used = true;
+
+    std::vector<uint8_t> contents;
+    if (filesystem->isReadable(path)) {
+        file.realPath = filesystem->resolvePath(path);
+        if (!file.realPath.empty() && filesystem->read(&contents, path)) {
+            auto result = plist::Format::Any::Deserialize(contents);
+            if (plist::CastTo<plist::Dictionary>(result.first.get()) != nullptr) {
+                file.contents = plist::static_unique_pointer_cast<plist::Dictionary>(std::move(result.first));
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _changed = true;
+    if (file.contents == nullptr) {
+        _files.erase(path);
+        return nullptr;
+    }
+
+    File &entry = _files[path];
+    entry = std::move(file);
+    *realPath = entry.realPath;
+    return entry.contents.get();
+}
+
+void Registry::
+load(Filesystem const *filesystem, std::string const &path)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return;
+    }
+
+    auto result = plist::Format::Any::Deserialize(contents);
+    plist::Dictionary const *registry = plist::CastTo<plist::Dictionary>(result.first.get());
+    if (registry == nullptr) {
+        return;
+    }
+
+    plist::Integer const *version = registry->value<plist::Integer>("Version");
+    plist::Dictionary const *directories = registry->value<plist::Dictionary>("Directories");
+    plist::Dictionary const *files = registry->value<plist::Dictionary>("Files");
+    if (version == nullptr || version->value() != Version || directories == nullptr || files == nullptr) {
+        return;
+    }
+
+    for (size_t n = 0; n < directories->count(); ++n) {
+        plist::Dictionary const *entry = directories->value<plist::Dictionary>(n);
+        plist::Integer const *modificationTime = (entry != nullptr ? entry->value<plist::Integer>("ModificationTime") : nullptr);
+        plist::Array const *entries = (entry != nullptr ? entry->value<plist::Array>("Entries") : nullptr);
+        if (modificationTime == nullptr || entries == nullptr) {
+            continue;
+        }
+
+        Directory directory;
+        directory.modificationTime = static_cast<uint64_t>(modificationTime->value());
+        directory.used = false;
+        for (size_t i = 0; i < entries->count(); ++i) {
+            if (plist::String const *filename = entries->value<plist::String>(i)) {
+                directory.entries.push_back(filename->value());
+            }
+        }
+
+        _directories[directories->key(n)] = std::move(directory);
+    }
+
+    for (size_t n = 0; n < files->count(); ++n) {
+        plist::Dictionary const *entry = files->value<plist::Dictionary>(n);
+        plist::Integer const *modificationTime = (entry != nullptr ? entry->value<plist::Integer>("ModificationTime") : nullptr);
+        plist::String const *realPath = (entry != nullptr ? entry->value<plist::String>("RealPath") : nullptr);
+        plist::Dictionary const *fileContents = (entry != nullptr ? entry->value<plist::Dictionary>("Contents") : nullptr);
+        if (modificationTime == nullptr || realPath == nullptr || fileContents == nullptr) {
+            continue;
+        }
+
+        File file;
+        file.modificationTime = static_cast<uint64_t>(modificationTime->value());
+        file.realPath = realPath->value();
+        file.contents = fileContents->copy();
+        file.used = false;
+        _files[files->key(n)] = std::move(file);
+    }
+}
+
+bool Registry::
+save(Filesystem *filesystem, std::string const &path) const
+{
+    auto directories = plist::Dictionary::New();
+    for (auto const &entry : _directories) {
+        if (!entry.second.used) {
+            continue;
+        }
+
+        auto entries = plist::Array::New();
+        for (std::string const &filename : entry.second.entries) {
+            entries->append(plist::String::New(filename));
+        }
+
+        auto directory = plist::Dictionary::New();
+        directory->set("ModificationTime", plist::Integer::New(static_cast<int64_t>(entry.second.modificationTime)));
+        directory->set("Entries", std::move(entries));
+        directories->set(entry.first, std::move(directory));
+    }
+
+    auto files = plist::Dictionary::New();
+    for (auto const &entry : _files) {
+        if (!entry.second.used) {
+            continue;
+        }
+
+        auto file = plist::Dictionary::New();
+        file->set("ModificationTime", plist::Integer::New(static_cast<int64_t>(entry.second.modificationTime)));
+        file->set("RealPath", plist::String::New(entry.second.realPath));
+        file->set("Contents", entry.second.contents->copy());
+        files->set(entry.first, std::move(file));
+    }
+
+    auto registry = plist::Dictionary::New();
+    registry->set("Version", plist::Integer::New(Version));
+    registry->set("Directories", std::move(directories));
+    registry->set("Files", std::move(files));
+
+    auto serialized = plist::Format::Binary::Serialize(registry.get(), plist::Format::Binary::Create());
+    if (serialized.first == nullptr) {
+        return false;
+    }
+
+    /* Other tools may be loading the registry at the same time. */
+    return filesystem->createDirectory(FSUtil::GetDirectoryName(path)) && filesystem->writeAtomic(*serialized.first, path);
+}
+
+ext::optional<std::string> Registry::
+DefaultPath(process::Context const *processContext)
+{
+    if (ext::optional<std::string> environmentPath = processContext->environmentVariable("XCSDK_REGISTRY_PATH")) {
+        return environmentPath;
+    }
+
+    if (ext::optional<std::string> homePath = processContext->userHomeDirectory()) {
+        return *homePath + "/.xcsdk/xcsdk_registry.plist";
+    }
+
+    return ext::nullopt;
+}
@@ -8,18 +8,19 @@
  */
 
 #include <xcsdk/SDK/Target.h>
+#include <xcsdk/SDK/Registry.h>
 #include <xcsdk/SDK/Manager.h>
 #include <pbxsetting/Type.h>
 #include <plist/Array.h>
 #include <plist/Boolean.h>
 #include <plist/Dictionary.h>
 #include <plist/String.h>
-#include <plist/Format/Any.h>
 #include <plist/Keys/Unpack.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 
 using xcsdk::SDK::Target;
+using xcsdk::SDK::Registry;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
@@ -199,44 +200,27 @@ parse(plist::Dictionary const *dict)
 }
 
 Target::shared_ptr Target::
-Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared_ptr<Platform> platform, std::string const &path)
+Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared_ptr<Platform> platform, std::string const &path, Registry *registry)
 {
     if (path.empty()) {
         return nullptr;
     }
 
-    /*
-     * Load target settings.
-     */
-    std::string settingsFileName = path + "/SDKSettings.plist";
-    if (!filesystem->isReadable(settingsFileName.c_str())) {
-        settingsFileName = path + "/Info.plist";
-        if (!filesystem->isReadable(settingsFileName.c_str())) {
-            return nullptr;
-        }
-    }
-
-    std::string realPath = filesystem->resolvePath(settingsFileName);
-    if (realPath.empty()) {
-        return nullptr;
-    }
-
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, settingsFileName)) {
-        return nullptr;
+    Registry uncached;
+    if (registry == nullptr) {
+        registry = &uncached;
     }
 
     /*
-     * Parse settings property list.
+     * Load target settings.
      */
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
-        return nullptr;
-    }
-
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    std::string realPath;
+    plist::Dictionary const *plist = registry->propertyList(filesystem, path + "/SDKSettings.plist", &realPath);
     if (plist == nullptr) {
-        return nullptr;
+        plist = registry->propertyList(filesystem, path + "/Info.plist", &realPath);
+        if (plist == nullptr) {
+            return nullptr;
+        }
     }
 
     /*
@@ -258,7 +242,7 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared
     /*
      * Parse product information.
      */
-    target->_product = Product::Open(filesystem, target->_path);
+    target->_product = Product::Open(filesystem, target->_path, registry);
 
     return target;
 }
@@ -8,6 +8,7 @@
  */
 
 #include <xcsdk/SDK/Toolchain.h>
+#include <xcsdk/SDK/Registry.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 #include <plist/Array.h>
@@ -16,9 +17,9 @@
 #include <plist/Integer.h>
 #include <plist/String.h>
 #include <plist/Keys/Unpack.h>
-#include <plist/Format/Any.h>
 
 using xcsdk::SDK::Toolchain;
+using xcsdk::SDK::Registry;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
@@ -128,44 +129,27 @@ parse(plist::Dictionary const *dict)
 }
 
 Toolchain::shared_ptr Toolchain::
-Open(Filesystem const *filesystem, std::string const &path)
+Open(Filesystem const *filesystem, std::string const &path, Registry *registry)
 {
     if (path.empty()) {
         return nullptr;
     }
 
-    /*
-     * Read toolchain info.
-     */
-    std::string settingsFileName = path + "/ToolchainInfo.plist";
-    if (!filesystem->isReadable(settingsFileName)) {
-        settingsFileName = path + "/Info.plist";
-        if (!filesystem->isReadable(settingsFileName)) {
-            return nullptr;
-        }
-    }
-
-    std::string realPath = filesystem->resolvePath(settingsFileName);
-    if (realPath.empty()) {
-        return nullptr;
-    }
-
-    std::vector<uint8_t> contents;
-    if (!filesystem->read(&contents, settingsFileName)) {
-        return nullptr;
+    Registry uncached;
+    if (registry == nullptr) {
+        registry = &uncached;
     }
 
     /*
-     * Parse property list.
+     * Read toolchain info.
      */
-    auto result = plist::Format::Any::Deserialize(contents);
-    if (result.first == nullptr) {
-        return nullptr;
-    }
-
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
+    std::string realPath;
+    plist::Dictionary const *plist = registry->propertyList(filesystem, path + "/ToolchainInfo.plist", &realPath);
     if (plist == nullptr) {
-        return nullptr;
+        plist = registry->propertyList(filesystem, path + "/Info.plist", &realPath);
+        if (plist == nullptr) {
+            return nullptr;
+        }
     }
 
     /*
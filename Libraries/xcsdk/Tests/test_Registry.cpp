@@ -0,0 +1,83 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree. An additional grant
+ of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <gtest/gtest.h>
+#include <xcsdk/Configuration.h>
+#include <xcsdk/SDK/Manager.h>
+#include <xcsdk/SDK/Platform.h>
+#include <xcsdk/SDK/Registry.h>
+#include <libutil/MemoryFilesystem.h>
+
+using xcsdk::SDK::Manager;
+using xcsdk::SDK::Registry;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static std::string
+PlatformName(MemoryFilesystem const *filesystem, Registry *registry)
+{
+    auto manager = Manager::Open(filesystem, "/", ext::nullopt, registry);
+    if (manager == nullptr || manager->platforms().size() != 1) {
+        return std::string();
+    }
+
+    return manager->platforms().front()->name();
+}
+
+TEST(Registry, SaveAndLoad)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Platforms", {
+            MemoryFilesystem::Entry::Directory("Test.platform", {
+                MemoryFilesystem::Entry::File("Info.plist", Contents("{ Identifier = test; Name = First; }")),
+            }),
+        }),
+    });
+
+    Registry first;
+    EXPECT_EQ("First", PlatformName(&filesystem, &first));
+    EXPECT_TRUE(first.changed());
+    ASSERT_TRUE(first.save(&filesystem, "/Cache/registry.plist"));
+
+    /* Loaded entries are used while the files keep their times. */
+    MemoryFilesystem::Entry *info = filesystem.root().child("Platforms")->child("Test.platform")->child("Info.plist");
+    uint64_t modificationTime = info->modificationTime();
+    info->setContents(Contents("{ Identifier = test; Name = Second; }"));
+
+    Registry second;
+    second.load(&filesystem, "/Cache/registry.plist");
+    EXPECT_EQ("First", PlatformName(&filesystem, &second));
+    EXPECT_FALSE(second.changed());
+
+    /* Changed files are read again. */
+    info->modificationTime() = modificationTime + 100;
+
+    Registry third;
+    third.load(&filesystem, "/Cache/registry.plist");
+    EXPECT_EQ("Second", PlatformName(&filesystem, &third));
+    EXPECT_TRUE(third.changed());
+}
+
+TEST(Registry, Uncached)
+{
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Platforms", { }),
+    });
+
+    /* A missing or invalid registry loads as empty. */
+    Registry registry;
+    registry.load(&filesystem, "/missing.plist");
+    EXPECT_EQ("", PlatformName(&filesystem, &registry));
+    EXPECT_TRUE(registry.changed());
+}
@@ -10,10 +10,12 @@
 #include <xcsdk/Configuration.h>
 #include <xcsdk/Environment.h>
 #include <xcsdk/SDK/Manager.h>
+#include <xcsdk/SDK/Registry.h>
 #include <xcsdk/SDK/Toolchain.h>
 #include <libutil/DefaultFilesystem.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/Hash.h>
 #include <libutil/Options.h>
 #include <process/Context.h>
 #include <process/DefaultContext.h>
@@ -21,10 +23,16 @@
 #include <process/Launcher.h>
 #include <process/DefaultLauncher.h>
 #include <pbxsetting/Type.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/Binary.h>
 
 using libutil::DefaultFilesystem;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::Hash;
 
 class Options {
 private:
@@ -208,8 +216,8 @@ Help(std::string const &error = std::string())
     fprintf(stderr, "Options:\n");
     fprintf(stderr, INDENT "-v, --verbose\n");
     fprintf(stderr, INDENT "-l, --log\n");
-    fprintf(stderr, INDENT "-n, --no-cache (not implemented)\n");
-    fprintf(stderr, INDENT "-k, --kill-cache (not implemented)\n");
+    fprintf(stderr, INDENT "-n, --no-cache\n");
+    fprintf(stderr, INDENT "-k, --kill-cache\n");
 #undef INDENT
 
     return (error.empty() ? 0 : -1);
@@ -222,6 +230,172 @@ Version()
     return 0;
 }
 
+/*
+ * What is looked up: a tool, or one of the SDK values.
+ */
+static std::string
+LookupQuery(Options const &options)
+{
+    if (options.showSDKPath()) {
+        return "--show-sdk-path";
+    } else if (options.showSDKVersion()) {
+        return "--show-sdk-version";
+    } else if (options.showSDKBuildVersion()) {
+        return "--show-sdk-build-version";
+    } else if (options.showSDKPlatformPath()) {
+        return "--show-sdk-platform-path";
+    } else if (options.showSDKPlatformVersion()) {
+        return "--show-sdk-platform-version";
+    } else {
+        return "tool " + options.tool().value_or("");
+    }
+}
+
+/*
+ * Each lookup is cached in its own small file, named by what it depends
+ * on, so a repeated lookup reads only that file.
+ */
+static std::string
+LookupCachePath(std::string const &directory, std::vector<std::string> const &key)
+{
+    Hash hash;
+    for (std::string const &component : key) {
+        hash.update(component);
+        hash.update("", 1);
+    }
+    return directory + "/" + hash.hex() + ".plist";
+}
+
+/*
+ * Reads a cached lookup, if none of the directories and files it was found
+ * from have changed since. Paths that didn't exist are stored as -1.
+ */
+static bool
+ReadLookupCache(Filesystem const *filesystem, std::string const &path, std::string *value, ext::optional<std::string> *sdkroot)
+{
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        return false;
+    }
+
+    auto result = plist::Format::Any::Deserialize(contents);
+    plist::Dictionary const *cache = plist::CastTo<plist::Dictionary>(result.first.get());
+    if (cache == nullptr) {
+        return false;
+    }
+
+    plist::Dictionary const *inputs = cache->value<plist::Dictionary>("Inputs");
+    plist::String const *cachedValue = cache->value<plist::String>("Value");
+    if (inputs == nullptr || cachedValue == nullptr) {
+        return false;
+    }
+
+    for (size_t n = 0; n < inputs->count(); ++n) {
+        plist::Integer const *modificationTime = inputs->value<plist::Integer>(n);
+        ext::optional<uint64_t> currentModificationTime = filesystem->modificationTime(inputs->key(n));
+        int64_t current = (currentModificationTime ? static_cast<int64_t>(*currentModificationTime) : -1);
+        if (modificationTime == nullptr || modificationTime->value() != current) {
+            return false;
+        }
+    }
+
+    *value = cachedValue->value();
+    if (plist::String const *cachedSDKROOT = cache->value<plist::String>("SDKROOT")) {
+        *sdkroot = cachedSDKROOT->value();
+    }
+    return true;
+}
+
+static void
+WriteLookupCache(Filesystem *filesystem, std::string const &path, std::vector<std::string> const &inputs, std::string const &value, ext::optional<std::string> const &sdkroot)
+{
+    auto modificationTimes = plist::Dictionary::New();
+    for (std::string const &input : inputs) {
+        ext::optional<uint64_t> modificationTime = filesystem->modificationTime(input);
+        modificationTimes->set(input, plist::Integer::New(modificationTime ? static_cast<int64_t>(*modificationTime) : -1));
+    }
+
+    auto cache = plist::Dictionary::New();
+    cache->set("Inputs", std::move(modificationTimes));
+    cache->set("Value", plist::String::New(value));
+    if (sdkroot) {
+        cache->set("SDKROOT", plist::String::New(*sdkroot));
+    }
+
+    auto serialized = plist::Format::Binary::Serialize(cache.get(), plist::Format::Binary::Create());
+    if (serialized.first == nullptr) {
+        return;
+    }
+
+    /* The cache is only an optimization; failing to write it is fine. */
+    if (filesystem->createDirectory(FSUtil::GetDirectoryName(path))) {
+        filesystem->writeAtomic(*serialized.first, path);
+    }
+}
+
+/*
+ * Print the SDK value or tool path looked up, or run the tool.
+ */
+static int
+Perform(
+    Filesystem *filesystem,
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Options const &options,
+    bool log,
+    bool verbose,
+    std::string const &value,
+    ext::optional<std::string> const &sdkroot)
+{
+    if (!options.tool() || options.find()) {
+        /*
+         * Print an SDK value, or just find the tool; i.e. print its path.
+         */
+        printf("%s\n", value.c_str());
+        return 0;
+    }
+
+    /* Run is the default. */
+    std::string const &executable = value;
+
+    std::unordered_map<std::string, std::string> environment = processContext->environmentVariables();
+
+    if (sdkroot) {
+        /*
+         * Update effective environment to include the target path.
+         */
+        environment["SDKROOT"] = *sdkroot;
+        if (log) {
+            printf("env SDKROOT=%s %s\n", sdkroot->c_str(), executable.c_str());
+        }
+    }
+
+    /*
+     * Execute the process!
+     */
+    if (verbose) {
+        printf("verbose: executing tool: %s\n", executable.c_str());
+    }
+
+    process::MemoryContext context = process::MemoryContext(
+        executable,
+        processContext->currentDirectory(),
+        options.args(),
+        environment,
+        processContext->userID(),
+        processContext->groupID(),
+        processContext->userName(),
+        processContext->groupName());
+
+    ext::optional<int> exitCode = processLauncher->launch(filesystem, &context);
+    if (!exitCode) {
+        fprintf(stderr, "error: unable to execute tool '%s'\n", options.tool()->c_str());
+        return -1;
+    }
+
+    return *exitCode;
+}
+
 static int Run(Filesystem *filesystem, process::Context const *processContext, process::Launcher *processLauncher)
 {
     /*
@@ -259,13 +433,6 @@ static int Run(Filesystem *filesystem, process::Context const *processContext, p
     bool log = options.log() || (bool)processContext->environmentVariable("xcrun_log");
     bool nocache = options.noCache() || (bool)processContext->environmentVariable("xcrun_nocache");
 
-    /*
-     * Warn about unhandled arguments.
-     */
-    if (nocache || options.killCache()) {
-        fprintf(stderr, "warning: cache options not implemented\n");
-    }
-
     /*
      * Load the SDK manager from the developer root.
      */
@@ -274,22 +441,86 @@ static int Run(Filesystem *filesystem, process::Context const *processContext, p
         fprintf(stderr, "error: unable to find developer root\n");
         return -1;
     }
-    auto configuration = xcsdk::Configuration::Load(filesystem, xcsdk::Configuration::DefaultPaths(processContext));
-    auto manager = xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration);
+
+    bool showSDKValue = options.showSDKPath() ||
+        options.showSDKVersion() ||
+        options.showSDKBuildVersion() ||
+        options.showSDKPlatformPath() ||
+        options.showSDKPlatformVersion();
+
+    if (!showSDKValue && !options.tool()) {
+        return Help("no tool provided");
+    }
+
+    /*
+     * Scripts run xcrun many times per build; skip re-reading unchanged SDKs.
+     */
+    xcsdk::SDK::Registry registry;
+    ext::optional<std::string> registryPath = xcsdk::SDK::Registry::DefaultPath(processContext);
+    ext::optional<std::string> lookupCacheDirectory;
+    if (registryPath) {
+        lookupCacheDirectory = FSUtil::GetDirectoryName(*registryPath) + "/" + "xcrun";
+    }
+
+    if (options.killCache()) {
+        if (registryPath) {
+            filesystem->removeFile(*registryPath);
+        }
+        if (lookupCacheDirectory) {
+            std::vector<std::string> lookups;
+            filesystem->enumerateDirectory(*lookupCacheDirectory, [&](std::string const &filename) {
+                lookups.push_back(*lookupCacheDirectory + "/" + filename);
+            });
+            for (std::string const &lookup : lookups) {
+                filesystem->removeFile(lookup);
+            }
+        }
+    }
+
+    /*
+     * The same lookups are repeated with the same inputs. Verbose output
+     * describes the full lookup, so it always does one.
+     */
+    ext::optional<std::string> lookupCachePath;
+    if (lookupCacheDirectory && !nocache && !verbose) {
+        std::vector<std::string> key = {
+            *developerRoot,
+            SDK.value_or(""),
+            toolchainsInput.value_or(""),
+            LookupQuery(options),
+        };
+        std::vector<std::string> const &defaultExecutablePaths = processContext->executableSearchPaths();
+        key.insert(key.end(), defaultExecutablePaths.begin(), defaultExecutablePaths.end());
+        lookupCachePath = LookupCachePath(*lookupCacheDirectory, key);
+
+        std::string value;
+        ext::optional<std::string> sdkroot;
+        if (ReadLookupCache(filesystem, *lookupCachePath, &value, &sdkroot)) {
+            return Perform(filesystem, processContext, processLauncher, options, log, false, value, sdkroot);
+        }
+    }
+
+    if (registryPath && !nocache) {
+        registry.load(filesystem, *registryPath);
+    }
+
+    std::vector<std::string> configurationPaths = xcsdk::Configuration::DefaultPaths(processContext);
+    auto configuration = xcsdk::Configuration::Load(filesystem, configurationPaths);
+    auto manager = xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration, &registry);
     if (manager == nullptr) {
         fprintf(stderr, "error: unable to load manager from '%s'\n", developerRoot->c_str());
         return -1;
     }
+
+    /* The registry is only an optimization; failing to save it is fine. */
+    if (registryPath && !nocache && registry.changed()) {
+        registry.save(filesystem, *registryPath);
+    }
+
     if (verbose) {
         fprintf(stderr, "verbose: using developer root '%s'\n", manager->path().c_str());
     }
 
-    bool showSDKValue = options.showSDKPath() ||
-        options.showSDKVersion() ||
-        options.showSDKBuildVersion() ||
-        options.showSDKPlatformPath() ||
-        options.showSDKPlatformVersion();
-
     /*
      * Determine the SDK to use.
      */
@@ -318,45 +549,50 @@ static int Run(Filesystem *filesystem, process::Context const *processContext, p
         }
     }
 
+    /*
+     * Lookups depend on the SDKs and configuration found, and on the
+     * search paths for tools.
+     */
+    std::vector<std::string> lookupInputs = registry.paths();
+    lookupInputs.insert(lookupInputs.end(), configurationPaths.begin(), configurationPaths.end());
+
+    std::string value;
+    ext::optional<std::string> sdkroot;
+
     /*
      * Perform SDK-specific actions.
      */
     if (showSDKValue) {
         if (options.showSDKPath()) {
-            printf("%s\n", target->path().c_str());
+            value = target->path();
         } else if (options.showSDKVersion()) {
-            printf("%s\n", target->version().value_or("").c_str());
+            value = target->version().value_or("");
         } else if (options.showSDKBuildVersion()) {
             if (auto product = target->product()) {
-                printf("%s\n", product->buildVersion().value_or("").c_str());
+                value = product->buildVersion().value_or("");
             } else {
                 fprintf(stderr, "error: sdk has no build version\n");
                 return -1;
             }
         } else if (options.showSDKPlatformPath()) {
             if (auto platform = target->platform()) {
-                printf("%s\n", platform->path().c_str());
+                value = platform->path();
             } else {
                 fprintf(stderr, "error: sdk has no platform\n");
                 return -1;
             }
         } else if (options.showSDKPlatformVersion()) {
             if (auto platform = target->platform()) {
-                printf("%s\n", platform->version().value_or("").c_str());
+                value = platform->version().value_or("");
             } else {
                 fprintf(stderr, "error: sdk has no platform\n");
                 return -1;
             }
         }
-
-        return 0;
     } else {
         /*
          * Perform toolchain-specific actions.
          */
-        if (!options.tool()) {
-            return Help("no tool provided");
-        }
 
         /*
          * Determine the toolchains to use. Default to the SDK's toolchains.
@@ -401,6 +637,9 @@ static int Run(Filesystem *filesystem, process::Context const *processContext, p
         std::vector<std::string> defaultExecutablePaths = processContext->executableSearchPaths();
         executablePaths.insert(executablePaths.end(), defaultExecutablePaths.begin(), defaultExecutablePaths.end());
 
+        /* Adding a tool to any search path changes which one is found. */
+        lookupInputs.insert(lookupInputs.end(), executablePaths.begin(), executablePaths.end());
+
         /*
          * Find the tool to execute.
          */
@@ -413,53 +652,17 @@ static int Run(Filesystem *filesystem, process::Context const *processContext, p
             fprintf(stderr, "verbose: resolved tool '%s' to: %s\n", options.tool()->c_str(), executable->c_str());
         }
 
-        if (options.find()) {
-            /*
-             * Just find the tool; i.e. print its path.
-             */
-            printf("%s\n", executable->c_str());
-            return 0;
-        } else {
-            /* Run is the default. */
-
-            std::unordered_map<std::string, std::string> environment = processContext->environmentVariables();
-
-            if (target != nullptr) {
-                /*
-                 * Update effective environment to include the target path.
-                 */
-                environment["SDKROOT"] = target->path();
-                if (log) {
-                    printf("env SDKROOT=%s %s\n", target->path().c_str(), executable->c_str());
-                }
-            }
-
-            /*
-             * Execute the process!
-             */
-            if (verbose) {
-                printf("verbose: executing tool: %s\n", executable->c_str());
-            }
-
-            process::MemoryContext context = process::MemoryContext(
-                *executable,
-                processContext->currentDirectory(),
-                options.args(),
-                environment,
-                processContext->userID(),
-                processContext->groupID(),
-                processContext->userName(),
-                processContext->groupName());
-
-            ext::optional<int> exitCode = processLauncher->launch(filesystem, &context);
-            if (!exitCode) {
-                fprintf(stderr, "error: unable to execute tool '%s'\n", options.tool()->c_str());
-                return -1;
-            }
-
-            return *exitCode;
+        value = *executable;
+        if (target != nullptr) {
+            sdkroot = target->path();
         }
     }
+
+    if (lookupCachePath) {
+        WriteLookupCache(filesystem, *lookupCachePath, lookupInputs, value, sdkroot);
+    }
+
+    return Perform(filesystem, processContext, processLauncher, options, log, verbose, value, sdkroot);
 }
 
 int